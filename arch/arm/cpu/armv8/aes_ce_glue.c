@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * aes_ce_glue.c - AES using ARMv8 Crypto Extensions
+ */
+
+#include <linux/types.h>
+#include <uboot_aes.h>
+
+#if defined(CONFIG_MBEDTLS_LIB_ARMV8_CE) && defined(CONFIG_MBEDTLS_LIB_TLS)
+/* the round keys are private members of mbedtls_aes_context */
+#define MBEDTLS_ALLOW_PRIVATE_ACCESS
+#include <mbedtls/aes.h>
+#endif
+
+extern void aes_armv8_ce_invert_key(u8 *dec_key, u8 const *enc_key,
+				    u32 rounds);
+extern void aes_armv8_ce_cbc_decrypt(u8 const *dec_key, u32 rounds,
+				     u8 const *iv, u8 const *src, u8 *dst,
+				     u32 blocks);
+extern void aes_armv8_ce_ecb_encrypt(u8 const *enc_key, u32 rounds,
+				     u8 const *src, u8 *dst, u32 blocks);
+extern void aes_armv8_ce_ecb_decrypt(u8 const *dec_key, u32 rounds,
+				     u8 const *src, u8 *dst, u32 blocks);
+
+void aes_cbc_decrypt_blocks(u32 key_len, u8 *key_exp, u8 *iv, u8 *src,
+			    u8 *dst, u32 num_aes_blocks)
+{
+	u8 dec_key[AES256_EXPAND_KEY_LENGTH];
+	u32 rounds = key_len / 4 + 6;
+
+	if (!num_aes_blocks)
+		return;
+
+	aes_armv8_ce_invert_key(dec_key, key_exp, rounds);
+	aes_armv8_ce_cbc_decrypt(dec_key, rounds, iv, src, dst,
+				 num_aes_blocks);
+}
+
+#if defined(MBEDTLS_AES_ENCRYPT_ALT)
+/*
+ * MbedTLS expands the keys itself, in the same byte order as the instructions
+ * use, and keeps the inverse key schedule for decryption, so only the block
+ * operations need replacing
+ */
+int mbedtls_internal_aes_encrypt(mbedtls_aes_context *ctx,
+				 const unsigned char input[16],
+				 unsigned char output[16])
+{
+	aes_armv8_ce_ecb_encrypt((u8 *)(ctx->buf + ctx->rk_offset), ctx->nr,
+				 input, output, 1);
+
+	return 0;
+}
+
+int mbedtls_internal_aes_decrypt(mbedtls_aes_context *ctx,
+				 const unsigned char input[16],
+				 unsigned char output[16])
+{
+	aes_armv8_ce_ecb_decrypt((u8 *)(ctx->buf + ctx->rk_offset), ctx->nr,
+				 input, output, 1);
+
+	return 0;
+}
+#endif
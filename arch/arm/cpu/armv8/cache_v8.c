@@ -111,6 +111,8 @@ u64 get_tcr(u64 *pips, u64 *pva_bits)
 }
 
 #define MAX_PTE_ENTRIES 512
+/* Entries in a group which may share a TLB entry (PTE_BLOCK_CONT) */
+#define PTE_CONT_ENTRIES 16
 
 static int pte_type(u64 *pte)
 {
@@ -124,44 +126,6 @@ static int level2shift(int level)
 	return (12 + 9 * (3 - level));
 }
 
-static u64 *find_pte(u64 addr, int level)
-{
-	int start_level = 0;
-	u64 *pte;
-	u64 idx;
-	u64 va_bits;
-	int i;
-
-	debug("addr=%llx level=%d\n", addr, level);
-
-	get_tcr(NULL, &va_bits);
-	if (va_bits < 39)
-		start_level = 1;
-
-	if (level < start_level)
-		return NULL;
-
-	/* Walk through all page table levels to find our PTE */
-	pte = (u64*)gd->arch.tlb_addr;
-	for (i = start_level; i < 4; i++) {
-		idx = (addr >> level2shift(i)) & 0x1FF;
-		pte += idx;
-		debug("idx=%llx PTE %p at level %d: %llx\n", idx, pte, i, *pte);
-
-		/* Found it */
-		if (i == level)
-			return pte;
-		/* PTE is no table (either invalid or block), can't traverse */
-		if (pte_type(pte) != PTE_TYPE_TABLE)
-			return NULL;
-		/* Off to the next level */
-		pte = (u64*)(*pte & 0x0000fffffffff000ULL);
-	}
-
-	/* Should never reach here */
-	return NULL;
-}
-
 #ifdef CONFIG_CMO_BY_VA_ONLY
 static void __cmo_on_leaves(void (*cmo_fn)(unsigned long, unsigned long),
 			    u64 pte, int level, u64 base)
@@ -267,15 +231,36 @@ static void set_pte_table(u64 *pte, u64 *table)
 	*pte = PTE_TYPE_TABLE | (ulong)table;
 }
 
+/*
+ * Drops the contiguous hint from the group of entries holding *pte. This must
+ * be done before any entry in the group is changed, since the hint promises
+ * that they all map adjacent memory with the same attributes.
+ */
+static void clear_cont(u64 *pte)
+{
+	u64 *first;
+	int i;
+
+	if (!(*pte & PTE_BLOCK_CONT))
+		return;
+
+	/* Tables are page aligned, so the group is aligned to its size */
+	first = (u64 *)((ulong)pte & ~(PTE_CONT_ENTRIES * sizeof(u64) - 1));
+	for (i = 0; i < PTE_CONT_ENTRIES; i++)
+		first[i] &= ~PTE_BLOCK_CONT;
+}
+
 /* Splits a block PTE into table with subpages spanning the old block */
 static void split_block(u64 *pte, int level)
 {
-	u64 old_pte = *pte;
+	u64 old_pte;
 	u64 *new_table;
 	u64 i = 0;
 	/* level describes the parent level, we need the child ones */
 	int levelshift = level2shift(level + 1);
 
+	clear_cont(pte);
+	old_pte = *pte;
 	if (pte_type(pte) != PTE_TYPE_BLOCK)
 		panic("PTE %p (%llx) is not a block. Some driver code wants to "
 		      "modify dcache settings for an range not covered in "
@@ -308,6 +293,7 @@ static void map_range(u64 virt, u64 phys, u64 size, int level,
 	for (i = idx; size; i++) {
 		u64 next_size, *next_table;
 
+		clear_cont(&table[i]);
 		if (level >= 1 &&
 		    size >= map_size && !(virt & (map_size - 1))) {
 			if (level == 3)
@@ -339,6 +325,47 @@ static void map_range(u64 virt, u64 phys, u64 size, int level,
 	}
 }
 
+/*
+ * Sets the contiguous hint on each aligned group of PTE_CONT_ENTRIES leaf
+ * entries which map adjacent memory with the same attributes, so that the
+ * TLB can cover the whole group with a single entry.
+ */
+static void mark_cont(u64 *table, int level)
+{
+	u64 map_size = BIT_ULL(level2shift(level));
+	int i, j;
+
+	for (i = 0; i < MAX_PTE_ENTRIES; i++) {
+		if (level < 3 && pte_type(&table[i]) == PTE_TYPE_TABLE)
+			mark_cont((u64 *)(table[i] & GENMASK_ULL(47, PAGE_SHIFT)),
+				  level + 1);
+	}
+
+	/* Level 0 entries are always tables */
+	if (level < 1)
+		return;
+
+	for (i = 0; i < MAX_PTE_ENTRIES; i += PTE_CONT_ENTRIES) {
+		u64 first = table[i];
+		u64 phys = first & GENMASK_ULL(47, PAGE_SHIFT);
+
+		if (pte_type(&first) == PTE_TYPE_FAULT ||
+		    (level < 3 && pte_type(&first) == PTE_TYPE_TABLE) ||
+		    (phys & (map_size * PTE_CONT_ENTRIES - 1)))
+			continue;
+
+		for (j = 1; j < PTE_CONT_ENTRIES; j++) {
+			if (table[i + j] != first + j * map_size)
+				break;
+		}
+		if (j < PTE_CONT_ENTRIES)
+			continue;
+
+		for (j = 0; j < PTE_CONT_ENTRIES; j++)
+			table[i + j] |= PTE_BLOCK_CONT;
+	}
+}
+
 void mmu_map_region(phys_addr_t addr, u64 size, bool emergency)
 {
 	u64 va_bits;
@@ -692,6 +719,8 @@ __weak u64 get_page_table_size(void)
 
 void setup_pgtables(void)
 {
+	u64 *root;
+	u64 va_bits;
 	int i;
 
 	if (!gd->arch.tlb_fillptr || !gd->arch.tlb_addr)
@@ -702,11 +731,15 @@ void setup_pgtables(void)
 	 * If the starting level is 0 (va_bits >= 39), then this is our
 	 * Lv0 page table, otherwise it's the entry Lv1 page table.
 	 */
-	create_table();
+	root = create_table();
 
 	/* Now add all MMU table entries one after another to the table */
 	for (i = 0; mem_map[i].size || mem_map[i].attrs; i++)
 		add_map(&mem_map[i]);
+
+	/* Finally let the TLB cover runs of identical blocks at once */
+	get_tcr(NULL, &va_bits);
+	mark_cont(root, va_bits < 39 ? 1 : 0);
 }
 
 static void setup_all_pgtables(void)
@@ -791,10 +824,20 @@ void invalidate_dcache_range(unsigned long start, unsigned long stop)
 }
 
 /*
- * Flush range(clean & invalidate) from all levels of D-cache/unified cache
+ * Flush range(clean & invalidate) from all levels of D-cache/unified cache.
+ * Large ranges are quicker to handle by flushing everything by set/way. Below
+ * EL2 a hypervisor may trap or ignore set/way operations, so it is not done.
  */
 void flush_dcache_range(unsigned long start, unsigned long stop)
 {
+#ifdef CONFIG_ARMV8_DCACHE_FLUSH_ALL_SIZE
+	if (CONFIG_ARMV8_DCACHE_FLUSH_ALL_SIZE &&
+	    stop - start >= CONFIG_ARMV8_DCACHE_FLUSH_ALL_SIZE &&
+	    current_el() >= 2) {
+		flush_dcache_all();
+		return;
+	}
+#endif
 	__asm_flush_dcache_range(start, stop);
 }
 #else
@@ -860,54 +903,74 @@ u64 *__weak arch_get_page_table(void) {
 	return NULL;
 }
 
-static bool is_aligned(u64 addr, u64 size, u64 align)
+/*
+ * Updates the attribute bits in @mask for [virt, virt + size), splitting
+ * blocks only where the range does not cover them
+ */
+static void change_range(u64 virt, u64 size, int level, u64 *table,
+			 u64 attrs, u64 mask)
 {
-	return !(addr & (align - 1)) && !(size & (align - 1));
-}
+	u64 map_size = BIT_ULL(level2shift(level));
+	int i, idx;
 
-/* Use flag to indicate if attrs has more than d-cache attributes */
-static u64 set_one_region(u64 start, u64 size, u64 attrs, bool flag, int level)
-{
-	int levelshift = level2shift(level);
-	u64 levelsize = 1ULL << levelshift;
-	u64 *pte = find_pte(start, level);
-
-	/* Can we can just modify the current level block PTE? */
-	if (is_aligned(start, size, levelsize)) {
-		if (flag) {
-			*pte &= ~PMD_ATTRMASK;
-			*pte |= attrs & PMD_ATTRMASK;
+	idx = (virt >> level2shift(level)) & (MAX_PTE_ENTRIES - 1);
+	for (i = idx; size; i++) {
+		u64 next_size, *next_table;
+
+		next_size = min(map_size - (virt & (map_size - 1)), size);
+		clear_cont(&table[i]);
+
+		/* Level 3 entries have the table type but are pages */
+		if (level >= 1 && (next_size == map_size || level == 3) &&
+		    (level == 3 || pte_type(&table[i]) != PTE_TYPE_TABLE)) {
+			table[i] &= ~mask;
+			table[i] |= attrs & mask;
+			debug("Set attrs=%llx pte=%p level=%d\n", attrs,
+			      &table[i], level);
 		} else {
-			*pte &= ~PMD_ATTRINDX_MASK;
-			*pte |= attrs & PMD_ATTRINDX_MASK;
+			if (pte_type(&table[i]) != PTE_TYPE_TABLE)
+				split_block(&table[i], level);
+
+			next_table = (u64 *)(table[i] &
+					     GENMASK_ULL(47, PAGE_SHIFT));
+			change_range(virt, next_size, level + 1, next_table,
+				     attrs, mask);
 		}
-		debug("Set attrs=%llx pte=%p level=%d\n", attrs, pte, level);
 
-		return levelsize;
+		virt += next_size;
+		size -= next_size;
 	}
+}
 
-	/* Unaligned or doesn't fit, maybe split block into table */
-	debug("addr=%llx level=%d pte=%p (%llx)\n", start, level, pte, *pte);
+static void change_region(u64 start, u64 size, u64 attrs, u64 mask)
+{
+	u64 va_bits;
+	int level = 0;
 
-	/* Maybe we need to split the block into a table */
-	if (pte_type(pte) == PTE_TYPE_BLOCK)
-		split_block(pte, level);
+	get_tcr(NULL, &va_bits);
+	if (va_bits < 39)
+		level = 1;
 
-	/* And then double-check it became a table or already is one */
-	if (pte_type(pte) != PTE_TYPE_TABLE)
-		panic("PTE %p (%llx) for addr=%llx should be a table",
-		      pte, *pte, start);
+	change_range(start, size, level, (u64 *)gd->arch.tlb_addr, attrs,
+		     mask);
+}
 
-	/* Roll on to the next page table level */
-	return 0;
+/* Writes back the page tables in use, rather than the whole allocation */
+static void flush_pgtables(void)
+{
+	ulong end = gd->arch.tlb_addr + gd->arch.tlb_size;
+
+	if (gd->arch.tlb_fillptr > gd->arch.tlb_addr &&
+	    gd->arch.tlb_fillptr < end)
+		end = gd->arch.tlb_fillptr;
+
+	flush_dcache_range(gd->arch.tlb_addr, end);
 }
 
 void mmu_set_region_dcache_behaviour(phys_addr_t start, size_t size,
 				     enum dcache_option option)
 {
 	u64 attrs = PMD_ATTRINDX(option >> 2);
-	u64 real_start = start;
-	u64 real_size = size;
 
 	debug("start=%lx size=%lx\n", (ulong)start, (ulong)size);
 
@@ -921,26 +984,8 @@ void mmu_set_region_dcache_behaviour(phys_addr_t start, size_t size,
 	 */
 	__asm_switch_ttbr(gd->arch.tlb_emerg);
 
-	/*
-	 * Loop through the address range until we find a page granule that fits
-	 * our alignment constraints, then set it to the new cache attributes
-	 */
-	while (size > 0) {
-		int level;
-		u64 r;
-
-		for (level = 1; level < 4; level++) {
-			/* Set d-cache attributes only */
-			r = set_one_region(start, size, attrs, false, level);
-			if (r) {
-				/* PTE successfully replaced */
-				size -= r;
-				start += r;
-				break;
-			}
-		}
-
-	}
+	/* Set d-cache attributes only, in a single walk of the tables */
+	change_region(start, size, attrs, PMD_ATTRINDX_MASK);
 
 	/* We're done modifying page tables, switch back to our primary ones */
 	__asm_switch_ttbr(gd->arch.tlb_addr);
@@ -949,7 +994,7 @@ void mmu_set_region_dcache_behaviour(phys_addr_t start, size_t size,
 	 * Make sure there's nothing stale in dcache for a region that might
 	 * have caches off now
 	 */
-	flush_dcache_range(real_start, real_start + real_size);
+	flush_dcache_range(start, start + size);
 }
 
 /*
@@ -959,53 +1004,25 @@ void mmu_set_region_dcache_behaviour(phys_addr_t start, size_t size,
  */
 void mmu_change_region_attr(phys_addr_t addr, size_t siz, u64 attrs)
 {
-	int level;
-	u64 r, size, start;
-
-	start = addr;
-	size = siz;
 	/*
-	 * Loop through the address range until we find a page granule that fits
-	 * our alignment constraints, then set it to "invalid".
+	 * Splitting blocks and dropping contiguous hints changes entries
+	 * outside the region, so do that from the emergency tables, leaving
+	 * only the region itself to go through break-before-make
 	 */
-	while (size > 0) {
-		for (level = 1; level < 4; level++) {
-			/* Set PTE to fault */
-			r = set_one_region(start, size, PTE_TYPE_FAULT, true,
-					   level);
-			if (r) {
-				/* PTE successfully invalidated */
-				size -= r;
-				start += r;
-				break;
-			}
-		}
+	if (gd->arch.tlb_emerg) {
+		__asm_switch_ttbr(gd->arch.tlb_emerg);
+		change_region(addr, siz, 0, 0);
+		__asm_switch_ttbr(gd->arch.tlb_addr);
 	}
 
-	flush_dcache_range(gd->arch.tlb_addr,
-			   gd->arch.tlb_addr + gd->arch.tlb_size);
+	/* Set the PTEs to fault */
+	change_region(addr, siz, PTE_TYPE_FAULT, PMD_ATTRMASK);
+	flush_pgtables();
 	__asm_invalidate_tlb_all();
 
-	/*
-	 * Loop through the address range until we find a page granule that fits
-	 * our alignment constraints, then set it to the new cache attributes
-	 */
-	start = addr;
-	size = siz;
-	while (size > 0) {
-		for (level = 1; level < 4; level++) {
-			/* Set PTE to new attributes */
-			r = set_one_region(start, size, attrs, true, level);
-			if (r) {
-				/* PTE successfully updated */
-				size -= r;
-				start += r;
-				break;
-			}
-		}
-	}
-	flush_dcache_range(gd->arch.tlb_addr,
-			   gd->arch.tlb_addr + gd->arch.tlb_size);
+	/* Set the PTEs to the new attributes */
+	change_region(addr, siz, attrs, PMD_ATTRMASK);
+	flush_pgtables();
 	__asm_invalidate_tlb_all();
 }
 
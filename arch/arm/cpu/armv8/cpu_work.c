@@ -0,0 +1,544 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Run jobs on the secondary CPUs
+ *
+ * The secondary CPUs are started with PSCI CPU_ON at cpu_work_secondary_entry,
+ * which turns the MMU on with the translation tables of the boot CPU. Each
+ * one then waits for jobs on its own queue until cpu_work_stop() asks it to
+ * switch itself off with PSCI CPU_OFF.
+ */
+
+#define LOG_CATEGORY LOGC_ARCH
+
+#include <cpu_func.h>
+#include <dm.h>
+#include <log.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <time.h>
+#include <asm/global_data.h>
+#include <asm/system.h>
+#include <dm/ofnode.h>
+#include <linux/psci.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Number of secondary CPUs which can be used */
+#define CPU_WORK_MAX_SECONDARY	(CONFIG_ARMV8_CPU_WORK_MAX_CPUS - 1)
+
+/* Number of jobs which can be queued on each CPU, must be a power of two */
+#define CPU_WORK_QUEUE_LEN	8
+
+/* Time allowed for a secondary CPU to power off after its last job */
+#define CPU_WORK_OFF_TIMEOUT_MS	100
+
+/* Time allowed for a secondary CPU to complete its current job */
+#define CPU_WORK_JOB_TIMEOUT_MS	10000
+
+/**
+ * struct cpu_work_boot - state loaded by cpu_work_secondary_entry
+ *
+ * This is read with the MMU and caches off, so it must be flushed to memory
+ * before the CPU is started. The offsets are used by cpu_work_entry.S.
+ *
+ * @vbar:	exception vector base
+ * @mair:	memory attribute indirection register
+ * @tcr:	translation control register
+ * @ttbr0:	translation table base
+ * @sctlr:	system control register, turning the MMU and caches on
+ * @sp:		initial stack pointer
+ * @gd:		global data pointer, loaded into x18
+ * @entry:	C function to jump to
+ * @arg:	argument passed to @entry
+ */
+struct cpu_work_boot {
+	u64 vbar;
+	u64 mair;
+	u64 tcr;
+	u64 ttbr0;
+	u64 sctlr;
+	u64 sp;
+	u64 gd;
+	u64 entry;
+	u64 arg;
+};
+
+/**
+ * struct cpu_work_job - a job queued on a CPU
+ *
+ * @fn:		function to call
+ * @arg:	argument to pass to @fn
+ */
+struct cpu_work_job {
+	void (*fn)(void *arg);
+	void *arg;
+};
+
+/**
+ * struct cpu_work_cpu - a secondary CPU running jobs
+ *
+ * The queue is written only by the boot CPU, which advances @head, and read
+ * only by the secondary CPU, which advances @tail once a job has completed.
+ *
+ * @boot:	state loaded when the CPU starts
+ * @queue:	queued jobs
+ * @head:	number of jobs queued so far
+ * @tail:	number of jobs completed so far
+ * @stop:	set to ask the CPU to power off once its queue is empty
+ * @lost:	set if the CPU did not power off when asked to; it may still be
+ *		using this slot, so neither is used again
+ * @mpidr:	affinity of the CPU
+ * @stack:	stack of the CPU
+ */
+struct cpu_work_cpu {
+	struct cpu_work_boot boot;
+	struct cpu_work_job queue[CPU_WORK_QUEUE_LEN];
+	u32 head;
+	u32 tail;
+	u32 stop;
+	u32 lost;
+	u64 mpidr;
+	void *stack;
+} __aligned(ARCH_DMA_MINALIGN);
+
+/**
+ * struct cpu_work_share - the part of a cpu_work_run() taken by one CPU
+ *
+ * @work:	jobs being run
+ * @index:	index of the CPU, passed to the job function
+ */
+struct cpu_work_share {
+	struct cpu_work *work;
+	uint index;
+};
+
+/**
+ * struct cpu_work - a set of jobs being run by cpu_work_run()
+ *
+ * This is allocated, since a secondary CPU which times out may still write to
+ * it later. It is then leaked.
+ *
+ * @fn:		function to run for each job
+ * @priv:	private data for @fn
+ * @njobs:	number of jobs
+ * @next:	next job to hand out
+ * @ret:	error returned by a failing job, 0 if none
+ * @share:	share of the jobs queued on each secondary CPU
+ */
+struct cpu_work {
+	cpu_work_fn fn;
+	void *priv;
+	uint njobs;
+	u32 next;
+	int ret;
+	struct cpu_work_share share[CPU_WORK_MAX_SECONDARY];
+};
+
+static struct cpu_work_cpu cpu_work_cpu[CPU_WORK_MAX_SECONDARY];
+/* CPUs which are running, in the first cpu_work_started entries */
+static struct cpu_work_cpu *cpu_work_list[CPU_WORK_MAX_SECONDARY];
+static int cpu_work_started;
+/* CPUs which did not power off and are not used again */
+static int cpu_work_lost;
+
+void cpu_work_secondary_entry(void);
+
+/* Atomically increment *@p, returning the old value */
+static u32 cpu_work_inc(u32 *p)
+{
+	u32 old, val, fail;
+
+	asm volatile("1:	ldaxr	%w0, %3\n"
+		     "	add	%w1, %w0, #1\n"
+		     "	stlxr	%w2, %w1, %3\n"
+		     "	cbnz	%w2, 1b\n"
+		     : "=&r" (old), "=&r" (val), "=&r" (fail), "+Q" (*p)
+		     : : "memory");
+
+	return old;
+}
+
+static u32 cpu_work_read(u32 *p)
+{
+	u32 val;
+
+	asm volatile("ldar	%w0, %1" : "=r" (val) : "Q" (*p) : "memory");
+
+	return val;
+}
+
+static void cpu_work_write(u32 *p, u32 val)
+{
+	asm volatile("stlr	%w1, %0" : "=Q" (*p) : "r" (val) : "memory");
+}
+
+static void __noreturn cpu_work_secondary(struct cpu_work_cpu *cpu)
+{
+	u32 tail = cpu->tail;
+
+	while (1) {
+		struct cpu_work_job *job;
+
+		if (cpu_work_read(&cpu->head) == tail) {
+			if (cpu_work_read(&cpu->stop))
+				break;
+			wfe();
+			continue;
+		}
+
+		job = &cpu->queue[tail % CPU_WORK_QUEUE_LEN];
+		job->fn(job->arg);
+		cpu_work_write(&cpu->tail, ++tail);
+		sev();
+	}
+
+	invoke_psci_fn(PSCI_0_2_FN_CPU_OFF, 0, 0, 0);
+	while (1)
+		wfi();
+}
+
+static void cpu_work_save_regs(struct cpu_work_boot *boot)
+{
+	if (current_el() == 2) {
+		asm volatile("mrs %0, vbar_el2" : "=r" (boot->vbar));
+		asm volatile("mrs %0, mair_el2" : "=r" (boot->mair));
+		asm volatile("mrs %0, tcr_el2" : "=r" (boot->tcr));
+		asm volatile("mrs %0, ttbr0_el2" : "=r" (boot->ttbr0));
+	} else {
+		asm volatile("mrs %0, vbar_el1" : "=r" (boot->vbar));
+		asm volatile("mrs %0, mair_el1" : "=r" (boot->mair));
+		asm volatile("mrs %0, tcr_el1" : "=r" (boot->tcr));
+		asm volatile("mrs %0, ttbr0_el1" : "=r" (boot->ttbr0));
+	}
+	boot->sctlr = get_sctlr();
+	boot->gd = (ulong)gd;
+}
+
+/* Fill @mpidr with the affinity of up to @max CPUs other than this one */
+static int cpu_work_find_cpus(u64 *mpidr, int max)
+{
+	u64 self = read_mpidr() & 0xff00ffffffUL;
+	ofnode cpus, node;
+	int count = 0;
+
+	cpus = ofnode_path("/cpus");
+	if (!ofnode_valid(cpus))
+		return 0;
+
+	ofnode_for_each_subnode(node, cpus) {
+		const char *type, *method;
+		fdt_addr_t reg;
+
+		type = ofnode_read_string(node, "device_type");
+		method = ofnode_read_string(node, "enable-method");
+		if (!type || strcmp(type, "cpu") || !method ||
+		    strcmp(method, "psci") || !ofnode_is_enabled(node))
+			continue;
+
+		reg = ofnode_get_addr_size_index_notrans(node, 0, NULL);
+		if (reg == FDT_ADDR_T_NONE || reg == self)
+			continue;
+		if (count == max)
+			break;
+		if (mpidr)
+			mpidr[count] = reg;
+		count++;
+	}
+
+	return count;
+}
+
+static bool cpu_work_psci_ok(void)
+{
+	struct udevice *dev;
+	long ver;
+
+	/* Make sure the PSCI conduit is known */
+	if (uclass_get_device_by_driver(UCLASS_FIRMWARE, DM_DRIVER_GET(psci),
+					&dev))
+		return false;
+
+	/* CPU_ON and AFFINITY_INFO need PSCI 0.2 function IDs */
+	ver = invoke_psci_fn(PSCI_0_2_FN_PSCI_VERSION, 0, 0, 0);
+	if (ver < 0 || (!PSCI_VERSION_MAJOR(ver) && PSCI_VERSION_MINOR(ver) < 2))
+		return false;
+
+	return true;
+}
+
+static bool cpu_work_is_lost(u64 mpidr)
+{
+	int i;
+
+	for (i = 0; i < CPU_WORK_MAX_SECONDARY; i++) {
+		if (cpu_work_cpu[i].lost && cpu_work_cpu[i].mpidr == mpidr)
+			return true;
+	}
+
+	return false;
+}
+
+/* Start all available secondary CPUs, returning the number running */
+static int cpu_work_start(void)
+{
+	u64 mpidr[CPU_WORK_MAX_SECONDARY];
+	int count, slot, i;
+
+	if (cpu_work_started || !cpu_work_psci_ok())
+		return cpu_work_started;
+
+	count = cpu_work_find_cpus(mpidr, CPU_WORK_MAX_SECONDARY);
+
+	/* The entry code runs with the caches off until it enables the MMU */
+	flush_dcache_range(ALIGN_DOWN((ulong)cpu_work_secondary_entry,
+				      ARCH_DMA_MINALIGN),
+			   ALIGN((ulong)cpu_work_secondary_entry + 0x100,
+				 ARCH_DMA_MINALIGN));
+
+	for (i = 0, slot = 0; i < count; i++) {
+		struct cpu_work_cpu *cpu;
+		long ret;
+
+		if (cpu_work_is_lost(mpidr[i]))
+			continue;
+		while (slot < CPU_WORK_MAX_SECONDARY && cpu_work_cpu[slot].lost)
+			slot++;
+		if (slot == CPU_WORK_MAX_SECONDARY)
+			break;
+		cpu = &cpu_work_cpu[slot];
+
+		memset(cpu, '\0', sizeof(*cpu));
+		cpu->stack = malloc(CONFIG_ARMV8_CPU_WORK_STACK_SIZE);
+		if (!cpu->stack)
+			break;
+		cpu->mpidr = mpidr[i];
+		cpu_work_save_regs(&cpu->boot);
+		cpu->boot.sp = ALIGN_DOWN((ulong)cpu->stack +
+					  CONFIG_ARMV8_CPU_WORK_STACK_SIZE, 16);
+		cpu->boot.entry = (ulong)cpu_work_secondary;
+		cpu->boot.arg = (ulong)cpu;
+		flush_dcache_range((ulong)cpu, (ulong)(cpu + 1));
+
+		ret = invoke_psci_fn(PSCI_0_2_FN64_CPU_ON, cpu->mpidr,
+				     (ulong)cpu_work_secondary_entry,
+				     (ulong)&cpu->boot);
+		if (ret) {
+			log_debug("Cannot start CPU %llx (err=%ld)\n",
+				  cpu->mpidr, ret);
+			free(cpu->stack);
+			continue;
+		}
+		slot++;
+		cpu_work_list[cpu_work_started++] = cpu;
+	}
+	log_debug("Started %d secondary CPUs\n", cpu_work_started);
+
+	return cpu_work_started;
+}
+
+/* Stop using a CPU which is stuck in a job, asking it to power off after it */
+static void cpu_work_drop(struct cpu_work_cpu *cpu)
+{
+	int i;
+
+	log_warning("CPU %llx is not completing its jobs\n", cpu->mpidr);
+	cpu_work_write(&cpu->stop, 1);
+	sev();
+	cpu->lost = 1;
+	cpu_work_lost++;
+
+	for (i = 0; cpu_work_list[i] != cpu; i++)
+		;
+	cpu_work_started--;
+	memmove(&cpu_work_list[i], &cpu_work_list[i + 1],
+		(cpu_work_started - i) * sizeof(cpu_work_list[0]));
+}
+
+/*
+ * Wait until no more than @pending jobs are queued on @cpu. The timeout
+ * restarts each time a job completes, so that a long queue is not a problem.
+ * A CPU which times out is dropped; the caller must not use it again.
+ */
+static int cpu_work_wait(struct cpu_work_cpu *cpu, u32 pending)
+{
+	u32 tail = cpu_work_read(&cpu->tail);
+	ulong start = get_timer(0);
+
+	while (cpu->head - tail > pending) {
+		u32 now = cpu_work_read(&cpu->tail);
+
+		if (now != tail) {
+			tail = now;
+			start = get_timer(0);
+		} else if (get_timer(start) > CPU_WORK_JOB_TIMEOUT_MS) {
+			cpu_work_drop(cpu);
+			return -ETIMEDOUT;
+		}
+	}
+
+	return 0;
+}
+
+static int cpu_work_queue_on(struct cpu_work_cpu *cpu,
+			     void (*fn)(void *arg), void *arg)
+{
+	struct cpu_work_job *job;
+	int ret;
+
+	/* Wait for a free slot */
+	ret = cpu_work_wait(cpu, CPU_WORK_QUEUE_LEN - 1);
+	if (ret)
+		return ret;
+
+	job = &cpu->queue[cpu->head % CPU_WORK_QUEUE_LEN];
+	job->fn = fn;
+	job->arg = arg;
+	cpu_work_write(&cpu->head, cpu->head + 1);
+	sev();
+
+	return 0;
+}
+
+int cpu_work_cpus(void)
+{
+	if (cpu_work_started)
+		return 1 + cpu_work_started;
+	if (!cpu_work_psci_ok())
+		return 1;
+
+	return 1 + max(cpu_work_find_cpus(NULL, CPU_WORK_MAX_SECONDARY) -
+		       cpu_work_lost, 0);
+}
+
+void cpu_work_queue(void (*fn)(void *arg), void *arg)
+{
+	struct cpu_work_cpu *best = NULL;
+	u32 best_pending = CPU_WORK_QUEUE_LEN;
+	int i;
+
+	cpu_work_start();
+	for (i = 0; i < cpu_work_started; i++) {
+		struct cpu_work_cpu *cpu = cpu_work_list[i];
+		u32 pending = cpu->head - cpu_work_read(&cpu->tail);
+
+		if (pending < best_pending) {
+			best = cpu;
+			best_pending = pending;
+		}
+	}
+
+	/* Run the job here if every queue is full or there are no CPUs */
+	if (!best || cpu_work_queue_on(best, fn, arg))
+		fn(arg);
+}
+
+int cpu_work_barrier(void)
+{
+	int i, ret = 0;
+
+	for (i = 0; i < cpu_work_started;) {
+		/* a CPU which is dropped leaves the next one at @i */
+		if (cpu_work_wait(cpu_work_list[i], 0))
+			ret = -ETIMEDOUT;
+		else
+			i++;
+	}
+
+	return ret;
+}
+
+/* Wait for a secondary CPU to be reported as off by the PSCI firmware */
+static int cpu_work_wait_off(struct cpu_work_cpu *cpu)
+{
+	ulong start = get_timer(0);
+
+	while (invoke_psci_fn(PSCI_0_2_FN64_AFFINITY_INFO, cpu->mpidr, 0, 0) !=
+	       PSCI_0_2_AFFINITY_LEVEL_OFF) {
+		if (get_timer(start) > CPU_WORK_OFF_TIMEOUT_MS) {
+			log_warning("CPU %llx did not power off\n",
+				    cpu->mpidr);
+			return -ETIMEDOUT;
+		}
+	}
+
+	return 0;
+}
+
+void cpu_work_stop(void)
+{
+	int i;
+
+	if (!cpu_work_started)
+		return;
+
+	cpu_work_barrier();
+	for (i = 0; i < cpu_work_started; i++)
+		cpu_work_write(&cpu_work_list[i]->stop, 1);
+	sev();
+
+	for (i = 0; i < cpu_work_started; i++) {
+		struct cpu_work_cpu *cpu = cpu_work_list[i];
+
+		/* Leak the stack and slot of a CPU which may still be running */
+		if (cpu_work_wait_off(cpu)) {
+			cpu->lost = 1;
+			cpu_work_lost++;
+		} else {
+			free(cpu->stack);
+		}
+	}
+	cpu_work_started = 0;
+}
+
+static void cpu_work_jobs(struct cpu_work *work, uint index)
+{
+	uint job;
+	int ret;
+
+	while ((job = cpu_work_inc(&work->next)) < work->njobs) {
+		ret = work->fn(work->priv, index, job);
+		if (ret)
+			work->ret = ret;
+	}
+}
+
+static void cpu_work_share(void *arg)
+{
+	struct cpu_work_share *share = arg;
+
+	cpu_work_jobs(share->work, share->index);
+}
+
+int cpu_work_run(cpu_work_fn fn, void *priv, uint njobs, uint ncpus)
+{
+	struct cpu_work *work;
+	int nsec, i, ret;
+
+	work = calloc(1, sizeof(*work));
+	if (!work)
+		return log_msg_ret("cpu", -ENOMEM);
+	work->fn = fn;
+	work->priv = priv;
+	work->njobs = njobs;
+
+	nsec = min3(ncpus, njobs, (uint)cpu_work_start() + 1) - 1;
+	for (i = 0; i < nsec; i++) {
+		struct cpu_work_share *share = &work->share[i];
+
+		share->work = work;
+		share->index = i + 1;
+		/* the other CPUs take the jobs of one which is dropped */
+		if (cpu_work_queue_on(cpu_work_list[i], cpu_work_share, share))
+			break;
+	}
+	log_debug("Running %u jobs on %d CPUs\n", njobs, i + 1);
+
+	cpu_work_jobs(work, 0);
+	ret = cpu_work_barrier();
+	if (ret)
+		return log_msg_ret("cpw", ret);
+	ret = work->ret;
+	free(work);
+
+	return ret;
+}
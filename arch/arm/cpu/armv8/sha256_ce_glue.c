@@ -18,3 +18,14 @@ void sha256_process(sha256_context *ctx, const unsigned char *data,
 
 	sha256_armv8_ce_process(ctx->state, data, blocks);
 }
+
+#if defined(MBEDTLS_SHA256_PROCESS_ALT)
+/* MbedTLS hashes one block at a time through this */
+int mbedtls_internal_sha256_process(mbedtls_sha256_context *ctx,
+				    const unsigned char data[64])
+{
+	sha256_armv8_ce_process(ctx->state, data, 1);
+
+	return 0;
+}
+#endif
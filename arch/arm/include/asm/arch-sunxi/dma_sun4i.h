@@ -59,9 +59,20 @@ enum ddma_drq_type {
 
 #define SUNXI_DMA_CTL_SRC_DRQ(a)		((a) & 0x1f)
 #define SUNXI_DMA_CTL_MODE_IO			(1 << 5)
+#define SUNXI_DMA_CTL_SRC_BURST_4		(1 << 7)
 #define SUNXI_DMA_CTL_SRC_DATA_WIDTH_32		(2 << 9)
 #define SUNXI_DMA_CTL_DST_DRQ(a)		(((a) & 0x1f) << 16)
+#define SUNXI_DMA_CTL_DST_BURST_4		(1 << 23)
 #define SUNXI_DMA_CTL_DST_DATA_WIDTH_32		(2 << 25)
+#define SUNXI_DMA_CTL_BUSY			(1 << 30)
 #define SUNXI_DMA_CTL_TRIGGER			(1 << 31)
 
+/* Block size and wait cycles of the dedicated DMA, each stored minus one */
+#define SUNXI_DDMA_PARA(dst_blk, dst_wait, src_blk, src_wait)	\
+	((((dst_blk) - 1) << 24) | (((dst_wait) - 1) << 16) |	\
+	 (((src_blk) - 1) << 8) | ((src_wait) - 1))
+
+#define SUNXI_DMA_IRQ_DDMA_HALF(n)		(1 << (16 + 2 * (n)))
+#define SUNXI_DMA_IRQ_DDMA_END(n)		(1 << (17 + 2 * (n)))
+
 #endif /* _SUNXI_DMA_SUN4I_H */
@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Slave transfers with the sun6i DMA controller, as used from the A31 on
+ */
+
+#ifndef _SUNXI_DMA_SUN6I_H
+#define _SUNXI_DMA_SUN6I_H
+
+#include <linux/types.h>
+
+/**
+ * struct sun6i_dma_slave - device side of a slave transfer
+ *
+ * This is passed as the metadata to dma_send() and dma_receive(). The DRQ
+ * port of the device comes from its 'dmas' property.
+ *
+ * @addr: Physical address of the FIFO register of the device
+ * @width: Width of each access to the FIFO, in bytes: 1, 2, 4 or 8
+ * @burst: Number of accesses in each burst: 1, 4, 8 or 16
+ */
+struct sun6i_dma_slave {
+	ulong addr;
+	u8 width;
+	u8 burst;
+};
+
+#endif /* _SUNXI_DMA_SUN6I_H */
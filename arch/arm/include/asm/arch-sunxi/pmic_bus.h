@@ -9,6 +9,20 @@
 #define _SUNXI_PMIC_BUS_H
 
 #include <linux/types.h>
+#include <power/pmic.h>
+
+#define PMIC_BUS_BATCH_MAX	32
+
+/**
+ * struct pmic_bus_batch - register writes held back to send together
+ *
+ * @count: Number of entries in @regs
+ * @regs: Register writes, in the order they were made
+ */
+struct pmic_bus_batch {
+	int count;
+	struct pmic_reg_val regs[PMIC_BUS_BATCH_MAX];
+};
 
 int pmic_bus_init(void);
 int pmic_bus_read(u8 reg, u8 *data);
@@ -16,4 +30,25 @@ int pmic_bus_write(u8 reg, u8 data);
 int pmic_bus_setbits(u8 reg, u8 bits);
 int pmic_bus_clrbits(u8 reg, u8 bits);
 
+/**
+ * pmic_bus_batch_start() - Start holding back register writes
+ *
+ * Until pmic_bus_batch_end() is called, pmic_bus_write() only records the
+ * write in @batch, and pmic_bus_read() returns the last value recorded for a
+ * register, if any. This lets a string of regulator settings go out in a few
+ * bus transactions. It only has an effect with the driver-model AXP driver;
+ * otherwise writes go out straight away.
+ *
+ * @batch: Place to record the writes, which must stay valid until
+ *	pmic_bus_batch_end() is called
+ */
+void pmic_bus_batch_start(struct pmic_bus_batch *batch);
+
+/**
+ * pmic_bus_batch_end() - Send the held-back writes and stop holding them back
+ *
+ * Return: 0 if OK, or -ve error if any write failed
+ */
+int pmic_bus_batch_end(void);
+
 #endif
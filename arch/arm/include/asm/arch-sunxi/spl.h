@@ -31,4 +31,7 @@
 uint32_t sunxi_get_boot_device(void);
 uint32_t sunxi_get_spl_size(void);
 
+int sunxi_spi0_flash_read(u32 addr, void *buf, u32 len);
+int sunxi_spi0_flash_write(u32 addr, const void *buf, u32 len);
+
 #endif
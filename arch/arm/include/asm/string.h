@@ -24,7 +24,16 @@ extern void * memcpy(void *, const void *, __kernel_size_t);
 #endif
 extern void * memmove(void *, const void *, __kernel_size_t);
 
+#if CONFIG_IS_ENABLED(USE_ARCH_STRING)
+#define __HAVE_ARCH_MEMCHR
+#define __HAVE_ARCH_MEMCMP
+#define __HAVE_ARCH_STRCMP
+#define __HAVE_ARCH_STRLEN
+#define __HAVE_ARCH_STRNCMP
+#define __HAVE_ARCH_STRNLEN
+#else
 #undef __HAVE_ARCH_MEMCHR
+#endif
 extern void * memchr(const void *, int, __kernel_size_t);
 
 #undef __HAVE_ARCH_MEMZERO
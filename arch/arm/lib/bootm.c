@@ -11,6 +11,7 @@
  * Copyright (C) 2001  Erik Mouw (J.A.K.Mouw@its.tudelft.nl)
  */
 
+#include <blk.h>
 #include <bootm.h>
 #include <bootstage.h>
 #include <command.h>
@@ -65,10 +66,13 @@ static void announce_and_cleanup(int fake)
 	udc_disconnect();
 #endif
 
+	blkcache_flush(-1, 0);
+	cpu_work_stop();
 	board_quiesce_devices();
 
 	printf("\nStarting kernel ...%s\n\n", fake ?
 		"(fake run for tracing)" : "");
+	flush();
 	/*
 	 * Call remove function of all devices with a removal flag set.
 	 * This may be useful for last-stage operations, like cancelling
@@ -4,6 +4,7 @@
  * Wolfgang Denk, DENX Software Engineering, wd@denx.de.
  */
 
+#include <errno.h>
 #include <image.h>
 #include <mapmem.h>
 #include <asm/global_data.h>
@@ -28,21 +29,15 @@ struct Image_header {
 	uint32_t	res5;
 };
 
-int booti_setup(ulong image, ulong *relocated_addr, ulong *size,
-		bool force_reloc)
+int booti_get_dest(const void *hdr, ulong load, ulong *dest, ulong *size,
+		   bool force_reloc)
 {
-	struct Image_header *ih;
+	const struct Image_header *ih = hdr;
 	uint64_t dst;
 	uint64_t image_size, text_offset;
 
-	*relocated_addr = image;
-
-	ih = (struct Image_header *)map_sysmem(image, 0);
-
-	if (ih->magic != le32_to_cpu(LINUX_ARM64_IMAGE_MAGIC)) {
-		puts("Bad Linux ARM64 Image magic!\n");
-		return 1;
-	}
+	if (ih->magic != le32_to_cpu(LINUX_ARM64_IMAGE_MAGIC))
+		return -ENOEXEC;
 
 	/*
 	 * Prior to Linux commit a2c1d73b94ed, the text_offset field
@@ -50,7 +45,6 @@ int booti_setup(ulong image, ulong *relocated_addr, ulong *size,
 	 * field is zero, and we can assume a fixed value of 0x80000.
 	 */
 	if (ih->image_size == 0) {
-		puts("Image lacks image_size field, assuming 16MiB\n");
 		image_size = 16 << 20;
 		text_offset = 0x80000;
 	} else {
@@ -67,13 +61,30 @@ int booti_setup(ulong image, ulong *relocated_addr, ulong *size,
 	 * since memory below it is not accessible via the linear mapping.
 	 */
 	if (!force_reloc && (le64_to_cpu(ih->flags) & BIT(3)))
-		dst = image - text_offset;
+		dst = load - text_offset;
 	else
 		dst = gd->bd->bi_dram[0].start;
 
-	*relocated_addr = ALIGN(dst, SZ_2M) + text_offset;
+	*dest = ALIGN(dst, SZ_2M) + text_offset;
+
+	return 0;
+}
+
+int booti_setup(ulong image, ulong *relocated_addr, ulong *size,
+		bool force_reloc)
+{
+	struct Image_header *ih;
+	int ret;
+
+	*relocated_addr = image;
 
+	ih = (struct Image_header *)map_sysmem(image, 0);
+	ret = booti_get_dest(ih, image, relocated_addr, size, force_reloc);
+	if (ret)
+		puts("Bad Linux ARM64 Image magic!\n");
+	else if (ih->image_size == 0)
+		puts("Image lacks image_size field, assuming 16MiB\n");
 	unmap_sysmem(ih);
 
-	return 0;
+	return ret ? 1 : 0;
 }
@@ -12,15 +12,21 @@
  * (C) Copyright 2020 Jernej Skrabec <jernej.skrabec@siol.net>
  *
  */
+#include <bootstage.h>
 #include <init.h>
 #include <log.h>
+#include <spl.h>
 #include <asm/io.h>
 #include <asm/arch/clock.h>
 #include <asm/arch/dram.h>
 #include <asm/arch/cpu.h>
 #include <asm/arch/prcm.h>
+#include <asm/arch/spl.h>
 #include <linux/bitops.h>
 #include <linux/delay.h>
+#include <linux/kernel.h>
+#include <u-boot/crc.h>
+#include <vsprintf.h>
 
 enum {
 	MBUS_QOS_LOWEST = 0,
@@ -88,6 +94,20 @@ static void mctl_set_master_priority(void)
 	MBUS_CONF(39, false,    HIGH, 2, 8192, 5500, 5000);
 	MBUS_CONF(40, false,    HIGH, 2,  100,   64,   32);
 
+	/*
+	 * The ports match the ones in the H6 table: 0 is the CPU, 4 the
+	 * video engine and 16 the display engine.
+	 */
+	if (IS_ENABLED(CONFIG_DRAM_SUN50I_H616_QOS_CPU)) {
+		MBUS_CONF( 0,  true, HIGHEST, 0,  512,  256,  200);
+		MBUS_CONF( 4, false,     LOW, 2, 4096, 2800, 2400);
+		MBUS_CONF(16, false,    HIGH, 6, 4096, 1400, 1200);
+	} else if (IS_ENABLED(CONFIG_DRAM_SUN50I_H616_QOS_MEDIA)) {
+		MBUS_CONF( 0, false,    HIGH, 0,  256,  128,  100);
+		MBUS_CONF( 4,  true, HIGHEST, 2, 8192, 6500, 6000);
+		MBUS_CONF(16,  true, HIGHEST, 6, 8192, 4000, 3600);
+	}
+
 	dmb();
 }
 
@@ -147,10 +167,26 @@ static void mctl_set_addrmap(const struct dram_config *config)
 	u8 cols = config->cols;
 	u8 rows = config->rows;
 	u8 ranks = config->ranks;
+	u8 bank_base, row_base;
 
 	if (!config->bus_full_width)
 		cols -= 1;
 
+	/*
+	 * Normally the banks sit right above the columns and the rows above
+	 * the banks. For size detection the rows are moved right above the
+	 * columns and the banks above the rows instead, so that with the
+	 * maximum column count all row address bits still fall into the
+	 * first 2 GiB, where they can be probed for aliasing.
+	 */
+	if (config->probe_map) {
+		bank_base = rows + cols - 2;
+		row_base = cols - 6;
+	} else {
+		bank_base = cols - 2;
+		row_base = cols - 3;
+	}
+
 	/* Ranks */
 	if (ranks == 2)
 		mctl_ctl->addrmap[0] = rows + cols - 3;
@@ -158,7 +194,7 @@ static void mctl_set_addrmap(const struct dram_config *config)
 		mctl_ctl->addrmap[0] = 0x1F;
 
 	/* Banks, hardcoded to 8 banks now */
-	mctl_ctl->addrmap[1] = (cols - 2) | (cols - 2) << 8 | (cols - 2) << 16;
+	mctl_ctl->addrmap[1] = bank_base | bank_base << 8 | bank_base << 16;
 
 	/* Columns */
 	mctl_ctl->addrmap[2] = 0;
@@ -192,31 +228,31 @@ static void mctl_set_addrmap(const struct dram_config *config)
 	}
 
 	/* Rows */
-	mctl_ctl->addrmap[5] = (cols - 3) | ((cols - 3) << 8) | ((cols - 3) << 16) | ((cols - 3) << 24);
+	mctl_ctl->addrmap[5] = row_base | (row_base << 8) | (row_base << 16) | (row_base << 24);
 	switch (rows) {
 	case 13:
-		mctl_ctl->addrmap[6] = (cols - 3) | 0x0F0F0F00;
+		mctl_ctl->addrmap[6] = row_base | 0x0F0F0F00;
 		mctl_ctl->addrmap[7] = 0x0F0F;
 		break;
 	case 14:
-		mctl_ctl->addrmap[6] = (cols - 3) | ((cols - 3) << 8) | 0x0F0F0000;
+		mctl_ctl->addrmap[6] = row_base | (row_base << 8) | 0x0F0F0000;
 		mctl_ctl->addrmap[7] = 0x0F0F;
 		break;
 	case 15:
-		mctl_ctl->addrmap[6] = (cols - 3) | ((cols - 3) << 8) | ((cols - 3) << 16) | 0x0F000000;
+		mctl_ctl->addrmap[6] = row_base | (row_base << 8) | (row_base << 16) | 0x0F000000;
 		mctl_ctl->addrmap[7] = 0x0F0F;
 		break;
 	case 16:
-		mctl_ctl->addrmap[6] = (cols - 3) | ((cols - 3) << 8) | ((cols - 3) << 16) | ((cols - 3) << 24);
+		mctl_ctl->addrmap[6] = row_base | (row_base << 8) | (row_base << 16) | (row_base << 24);
 		mctl_ctl->addrmap[7] = 0x0F0F;
 		break;
 	case 17:
-		mctl_ctl->addrmap[6] = (cols - 3) | ((cols - 3) << 8) | ((cols - 3) << 16) | ((cols - 3) << 24);
-		mctl_ctl->addrmap[7] = (cols - 3) | 0x0F00;
+		mctl_ctl->addrmap[6] = row_base | (row_base << 8) | (row_base << 16) | (row_base << 24);
+		mctl_ctl->addrmap[7] = row_base | 0x0F00;
 		break;
 	case 18:
-		mctl_ctl->addrmap[6] = (cols - 3) | ((cols - 3) << 8) | ((cols - 3) << 16) | ((cols - 3) << 24);
-		mctl_ctl->addrmap[7] = (cols - 3) | ((cols - 3) << 8);
+		mctl_ctl->addrmap[6] = row_base | (row_base << 8) | (row_base << 16) | (row_base << 24);
+		mctl_ctl->addrmap[7] = row_base | (row_base << 8);
 		break;
 	default:
 		panic("Unsupported DRAM configuration: row number invalid\n");
@@ -531,6 +567,62 @@ static bool mctl_phy_read_training(const struct dram_para *para,
 	return result;
 }
 
+/*
+ * Narrowest eye found by training over the 9 bits (8 DQ and DM) of a byte
+ * lane, from the registers holding the right and left edges.
+ */
+static u32 mctl_phy_lane_margin(ulong right, ulong left)
+{
+	u32 *ptr1 = (u32 *)right, *ptr2 = (u32 *)left;
+	u32 val1, val2, margin = U32_MAX;
+	int i;
+
+	for (i = 0; i < 9; i++) {
+		val1 = readl(&ptr1[i]);
+		val2 = readl(&ptr2[i]);
+		margin = min(margin, val1 > val2 ? val1 - val2 : 0);
+	}
+
+	return margin;
+}
+
+/*
+ * Smallest read and write eye margin left by the last training, in the
+ * units of the PHY delay lines. The registers checked are the same that
+ * mctl_phy_read_training() and mctl_phy_write_training() use to decide
+ * whether training passed, which requires an eye wider than 6.
+ */
+static u32 mctl_phy_train_margin(const struct dram_para *para,
+				 const struct dram_config *config)
+{
+	ulong phy = SUNXI_DRAM_PHY0_BASE;
+	u32 margin = U32_MAX;
+
+	if (para->tpr10 & TPR10_READ_TRAINING) {
+		margin = min(margin, mctl_phy_lane_margin(phy + 0x898, phy + 0x850));
+		margin = min(margin, mctl_phy_lane_margin(phy + 0x8bc, phy + 0x874));
+		if (config->bus_full_width) {
+			margin = min(margin,
+				     mctl_phy_lane_margin(phy + 0xa98, phy + 0xa50));
+			margin = min(margin,
+				     mctl_phy_lane_margin(phy + 0xabc, phy + 0xa74));
+		}
+	}
+
+	if (para->tpr10 & TPR10_WRITE_TRAINING) {
+		margin = min(margin, mctl_phy_lane_margin(phy + 0x938, phy + 0x8f0));
+		margin = min(margin, mctl_phy_lane_margin(phy + 0x95c, phy + 0x914));
+		if (config->bus_full_width) {
+			margin = min(margin,
+				     mctl_phy_lane_margin(phy + 0xb38, phy + 0xaf0));
+			margin = min(margin,
+				     mctl_phy_lane_margin(phy + 0xb5c, phy + 0xb14));
+		}
+	}
+
+	return margin;
+}
+
 static bool mctl_phy_write_training(const struct dram_config *config)
 {
 	u32 val1, val2, *ptr1, *ptr2;
@@ -1321,9 +1413,15 @@ static bool mctl_core_init(const struct dram_para *para,
 static void mctl_auto_detect_rank_width(const struct dram_para *para,
 					struct dram_config *config)
 {
-	/* this is minimum size that it's supported */
-	config->cols = 8;
-	config->rows = 13;
+	if (config->probe_map) {
+		/* maximum size, probed by mctl_probe_dram_size() */
+		config->cols = 11;
+		config->rows = 18;
+	} else {
+		/* this is minimum size that it's supported */
+		config->cols = 8;
+		config->rows = 13;
+	}
 
 	/*
 	 * Strategy here is to test most demanding combination first and least
@@ -1392,6 +1490,49 @@ static void mctl_auto_detect_dram_size(const struct dram_para *para,
 	debug("detected %u rows\n", config->rows);
 }
 
+/*
+ * Detect the columns and rows on the controller brought up by
+ * mctl_auto_detect_rank_width() with the size detection address map, so
+ * no further initialisation is needed until the final one.
+ */
+static void mctl_probe_dram_size(struct dram_config *config)
+{
+	unsigned int shift = config->bus_full_width + 1;
+
+	for (config->cols = 8; config->cols < 11; config->cols++) {
+		if (mctl_mem_matches(1ULL << (config->cols + shift)))
+			break;
+	}
+	debug("detected %u columns\n", config->cols);
+
+	/* the rows start right above the 11 mapped column bits */
+	shift += 11;
+	for (config->rows = 13; config->rows < 18; config->rows++) {
+		if (mctl_mem_matches(1ULL << (config->rows + shift)))
+			break;
+	}
+	debug("detected %u rows\n", config->rows);
+
+	config->probe_map = 0;
+}
+
+static void mctl_auto_detect(const struct dram_para *para,
+			     struct dram_config *config)
+{
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DRAM_DETECT, "dram_detect");
+
+	if (IS_ENABLED(CONFIG_DRAM_SUN50I_H616_FAST_DETECT)) {
+		config->probe_map = 1;
+		mctl_auto_detect_rank_width(para, config);
+		mctl_probe_dram_size(config);
+	} else {
+		mctl_auto_detect_rank_width(para, config);
+		mctl_auto_detect_dram_size(para, config);
+	}
+
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DRAM_DETECT);
+}
+
 static unsigned long mctl_calc_size(const struct dram_config *config)
 {
 	u8 width = config->bus_full_width ? 4 : 2;
@@ -1400,6 +1541,175 @@ static unsigned long mctl_calc_size(const struct dram_config *config)
 	return (1ULL << (config->cols + config->rows + 3)) * width * config->ranks;
 }
 
+#if IS_ENABLED(CONFIG_DRAM_SUN50I_H616_CLK_SEARCH)
+#define DRAM_CLK_LIST		CONFIG_DRAM_SUN50I_H616_CLK_LIST
+#define DRAM_CLK_MARGIN		CONFIG_DRAM_SUN50I_H616_CLK_MARGIN
+#else
+#define DRAM_CLK_LIST		""
+#define DRAM_CLK_MARGIN		0
+#endif
+
+/* Get the next clock from the candidate list, or 0 at its end */
+static unsigned int mctl_next_clk(const char **listp)
+{
+	unsigned int clk;
+
+	clk = simple_strtoul(*listp, (char **)listp, 10);
+	while (**listp == ' ')
+		(*listp)++;
+
+	return clk;
+}
+
+/* Whether @clk may be used, either the default or one of the candidates */
+static bool mctl_clk_valid(unsigned int clk)
+{
+	const char *p = DRAM_CLK_LIST;
+	unsigned int cand;
+
+	if (clk == CONFIG_DRAM_CLK)
+		return true;
+
+	while ((cand = mctl_next_clk(&p))) {
+		if (cand == clk)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Train the detected configuration at each of the candidate clocks, in the
+ * order given, and keep the first one leaving enough eye margin. The
+ * default clock is used when none does.
+ */
+static void mctl_select_clk(struct dram_para *para,
+			    const struct dram_config *config)
+{
+	const char *p = DRAM_CLK_LIST;
+	u32 margin;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DRAM_CLK, "dram_clk_search");
+
+	while ((para->clk = mctl_next_clk(&p))) {
+		if (!mctl_core_init(para, config)) {
+			debug("DRAM training failed at %u MHz\n", para->clk);
+			continue;
+		}
+		margin = mctl_phy_train_margin(para, config);
+		debug("DRAM eye margin at %u MHz: %u\n", para->clk, margin);
+		if (margin >= DRAM_CLK_MARGIN)
+			goto done;
+	}
+
+	debug("no DRAM clock with enough margin, using %u MHz\n",
+	      CONFIG_DRAM_CLK);
+	para->clk = CONFIG_DRAM_CLK;
+done:
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DRAM_CLK);
+}
+
+#if IS_ENABLED(CONFIG_DRAM_SUN50I_H616_CACHE_CONFIG)
+#define DRAM_RECORD_MAGIC	0x4d415244	/* "DRAM" */
+
+/*
+ * Detected configuration as kept in SPI flash. @para_crc ties the record
+ * to the DRAM parameters it has been detected with, @clk is the clock
+ * selected for it.
+ */
+struct dram_record {
+	u32 magic;
+	u32 para_crc;
+	struct dram_config config;
+	u32 clk;
+	u32 crc;
+};
+
+/* The record is only kept in the flash which the SPL is booted from */
+static bool mctl_config_in_flash(void)
+{
+	return sunxi_get_boot_device() == BOOT_DEVICE_SPI;
+}
+
+static bool mctl_load_config(const struct dram_para *para,
+			     struct dram_config *config, u32 *clk)
+{
+	struct dram_record rec;
+
+	if (!mctl_config_in_flash() ||
+	    sunxi_spi0_flash_read(CONFIG_DRAM_SUN50I_H616_CACHE_OFFSET, &rec,
+				  sizeof(rec)))
+		return false;
+	if (rec.magic != DRAM_RECORD_MAGIC ||
+	    rec.crc != crc32(0, (u8 *)&rec, offsetof(struct dram_record, crc)) ||
+	    rec.para_crc != crc32(0, (u8 *)para, sizeof(*para)))
+		return false;
+
+	if (rec.config.cols < 8 || rec.config.cols > 11 ||
+	    rec.config.rows < 13 || rec.config.rows > 18 ||
+	    rec.config.ranks < 1 || rec.config.ranks > 2 ||
+	    rec.config.bus_full_width > 1 || rec.config.probe_map ||
+	    !mctl_clk_valid(rec.clk))
+		return false;
+
+	*config = rec.config;
+	*clk = rec.clk;
+
+	return true;
+}
+
+static void mctl_save_config(const struct dram_para *para,
+			     const struct dram_config *config, u32 clk)
+{
+	struct dram_record rec;
+
+	if (!mctl_config_in_flash())
+		return;
+
+	memset(&rec, 0, sizeof(rec));
+	rec.magic = DRAM_RECORD_MAGIC;
+	rec.para_crc = crc32(0, (u8 *)para, sizeof(*para));
+	rec.config = *config;
+	rec.clk = clk;
+	rec.crc = crc32(0, (u8 *)&rec, offsetof(struct dram_record, crc));
+
+	if (sunxi_spi0_flash_write(CONFIG_DRAM_SUN50I_H616_CACHE_OFFSET, &rec,
+				   sizeof(rec)))
+		debug("failed to store DRAM configuration\n");
+}
+#else
+static bool mctl_load_config(const struct dram_para *para,
+			     struct dram_config *config, u32 *clk)
+{
+	return false;
+}
+
+static void mctl_save_config(const struct dram_para *para,
+			     const struct dram_config *config, u32 clk)
+{
+}
+#endif
+
+/*
+ * A stored geometry larger than what the chips provide makes the topmost
+ * column or row address bit alias with the start of DRAM.
+ */
+static bool mctl_check_config(const struct dram_config *config)
+{
+	unsigned int shift = config->bus_full_width + 1;
+
+	if (config->cols > 8 &&
+	    mctl_mem_matches(1ULL << (config->cols - 1 + shift)))
+		return false;
+
+	shift = config->bus_full_width + 4 + config->cols;
+	if (config->rows > 13 &&
+	    mctl_mem_matches(1ULL << (config->rows - 1 + shift)))
+		return false;
+
+	return true;
+}
+
 static const struct dram_para para = {
 	.clk = CONFIG_DRAM_CLK,
 #ifdef CONFIG_SUNXI_DRAM_H616_DDR3_1333
@@ -1425,16 +1735,37 @@ unsigned long sunxi_dram_init(void)
 {
 	struct sunxi_prcm_reg *const prcm =
 		(struct sunxi_prcm_reg *)SUNXI_PRCM_BASE;
-	struct dram_config config;
+	/* in .data, as the record is made before the BSS is available */
+	static char clk_name[24] = "dram_clk";
+	struct dram_config config = { };
+	struct dram_para cur = para;
 	unsigned long size;
 
 	setbits_le32(&prcm->res_cal_ctrl, BIT(8));
 	clrbits_le32(&prcm->ohms240, 0x3f);
 
-	mctl_auto_detect_rank_width(&para, &config);
-	mctl_auto_detect_dram_size(&para, &config);
+	if (mctl_load_config(&para, &config, &cur.clk)) {
+		debug("using stored DRAM configuration\n");
+		if (mctl_core_init(&cur, &config) &&
+		    mctl_check_config(&config))
+			goto done;
+		debug("stored DRAM configuration failed, detecting\n");
+		cur.clk = para.clk;
+	}
+
+	mctl_auto_detect(&cur, &config);
+
+	if (IS_ENABLED(CONFIG_DRAM_SUN50I_H616_CLK_SEARCH))
+		mctl_select_clk(&cur, &config);
+
+	mctl_core_init(&cur, &config);
+
+	mctl_save_config(&para, &config, cur.clk);
 
-	mctl_core_init(&para, &config);
+done:
+	debug("DRAM clock %u MHz\n", cur.clk);
+	snprintf(clk_name, sizeof(clk_name), "dram_clk_%u", cur.clk);
+	bootstage_mark_name(BOOTSTAGE_ID_ALLOC, clk_name);
 
 	size = mctl_calc_size(&config);
 
@@ -28,6 +28,8 @@
 
 #if CONFIG_IS_ENABLED(PMIC_AXP)
 static struct udevice *pmic;
+/* This is used in SPL before BSS is ready */
+static struct pmic_bus_batch *pmic_batch __section(".data");
 #else
 static int pmic_i2c_address(void)
 {
@@ -78,9 +80,81 @@ int pmic_bus_init(void)
 	return ret;
 }
 
+#if CONFIG_IS_ENABLED(PMIC_AXP)
+void pmic_bus_batch_start(struct pmic_bus_batch *batch)
+{
+	batch->count = 0;
+	pmic_batch = batch;
+}
+
+static int pmic_bus_batch_flush(struct pmic_bus_batch *batch)
+{
+	int ret;
+
+	ret = pmic_write_regs(pmic, batch->regs, batch->count);
+	batch->count = 0;
+
+	return ret;
+}
+
+int pmic_bus_batch_end(void)
+{
+	struct pmic_bus_batch *batch = pmic_batch;
+
+	if (!batch)
+		return 0;
+	pmic_batch = NULL;
+
+	return pmic_bus_batch_flush(batch);
+}
+
+static int pmic_bus_batch_add(struct pmic_bus_batch *batch, u8 reg, u8 data)
+{
+	int ret;
+
+	if (batch->count == PMIC_BUS_BATCH_MAX) {
+		ret = pmic_bus_batch_flush(batch);
+		if (ret)
+			return ret;
+	}
+	batch->regs[batch->count].reg = reg;
+	batch->regs[batch->count].val = data;
+	batch->count++;
+
+	return 0;
+}
+
+/* Find the last value written to a register in the batch */
+static bool pmic_bus_batch_get(struct pmic_bus_batch *batch, u8 reg, u8 *data)
+{
+	int i;
+
+	for (i = batch->count - 1; i >= 0; i--) {
+		if (batch->regs[i].reg == reg) {
+			*data = batch->regs[i].val;
+			return true;
+		}
+	}
+
+	return false;
+}
+#else
+void pmic_bus_batch_start(struct pmic_bus_batch *batch)
+{
+}
+
+int pmic_bus_batch_end(void)
+{
+	return 0;
+}
+#endif
+
 int pmic_bus_read(u8 reg, u8 *data)
 {
 #if CONFIG_IS_ENABLED(PMIC_AXP)
+	if (pmic_batch && pmic_bus_batch_get(pmic_batch, reg, data))
+		return 0;
+
 	return pmic_read(pmic, reg, data, 1);
 #else
 	if (IS_ENABLED(CONFIG_SYS_I2C_SUN6I_P2WI))
@@ -95,6 +169,9 @@ int pmic_bus_read(u8 reg, u8 *data)
 int pmic_bus_write(u8 reg, u8 data)
 {
 #if CONFIG_IS_ENABLED(PMIC_AXP)
+	if (pmic_batch)
+		return pmic_bus_batch_add(pmic_batch, reg, data);
+
 	return pmic_write(pmic, reg, &data, 1);
 #else
 	if (IS_ENABLED(CONFIG_SYS_I2C_SUN6I_P2WI))
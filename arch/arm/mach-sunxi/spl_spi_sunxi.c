@@ -3,21 +3,20 @@
  * Copyright (C) 2016 Siarhei Siamashka <siarhei.siamashka@gmail.com>
  */
 
+#include <errno.h>
 #include <image.h>
 #include <log.h>
 #include <spl.h>
+#include <time.h>
 #include <asm/arch/spl.h>
 #include <asm/gpio.h>
 #include <asm/io.h>
 #include <linux/bitops.h>
 #include <linux/delay.h>
 #include <linux/libfdt.h>
+#include <linux/sizes.h>
 #include <sunxi_gpio.h>
 
-#ifdef CONFIG_SPL_OS_BOOT
-#error CONFIG_SPL_OS_BOOT is not supported yet
-#endif
-
 /*
  * This is a very simple U-Boot image loading implementation, trying to
  * replicate what the boot ROM is doing when loading the SPL. Because we
@@ -35,6 +34,12 @@
  *
  * The pin mixing part is SoC specific and only A10/A13/A20/H3/A64 are
  * supported at the moment.
+ *
+ * Optionally, a faster read command (Fast Read, Dual or Quad Output Fast
+ * Read) and a higher SPI clock can be selected in Kconfig. With
+ * CONFIG_SPL_SPI_SUNXI_SFDP the flash's SFDP table is checked first and
+ * the loader falls back to the plain Read Data Bytes command if the flash
+ * does not advertise the selected read mode.
  */
 
 /*****************************************************************************/
@@ -62,6 +67,7 @@
 #define SUN6I_SPI0_CCTL             0x24
 #define SUN6I_SPI0_GCR              0x04
 #define SUN6I_SPI0_TCR              0x08
+#define SUN6I_SPI0_FCR              0x18
 #define SUN6I_SPI0_FIFO_STA         0x1C
 #define SUN6I_SPI0_MBC              0x30
 #define SUN6I_SPI0_MTC              0x34
@@ -72,8 +78,13 @@
 #define SUN6I_CTL_ENABLE            BIT(0)
 #define SUN6I_CTL_MASTER            BIT(1)
 #define SUN6I_CTL_SRST              BIT(31)
+#define SUN6I_TCR_SS_OWNER          BIT(6)
+#define SUN6I_TCR_SS_LEVEL          BIT(7)
 #define SUN6I_TCR_SDM               BIT(13)
 #define SUN6I_TCR_XCH               BIT(31)
+#define SUN6I_FCR_RF_RST            BIT(15)
+#define SUN6I_BCC_DRM               BIT(28)
+#define SUN6I_BCC_QUAD_EN           BIT(29)
 
 /*****************************************************************************/
 
@@ -97,12 +108,33 @@
 #define AHB_RESET_SPI0_SHIFT        20
 #define AHB_GATE_OFFSET_SPI0        20
 
+#define SPI0_CLK_DIV_BY_1           0x0000 /* SUN6I only: 2^0 */
 #define SPI0_CLK_DIV_BY_2           0x1000
 #define SPI0_CLK_DIV_BY_4           0x1001
 #define SPI0_CLK_DIV_BY_32          0x100f
 
 /*****************************************************************************/
 
+#define SPI_CMD_READ                0x03
+#define SPI_CMD_FAST_READ           0x0b
+#define SPI_CMD_READ_SFDP           0x5a
+#define SPI_CMD_DUAL_OUTPUT_READ    0x3b
+#define SPI_CMD_QUAD_OUTPUT_READ    0x6b
+#define SPI_CMD_READ_ID             0x9f
+#define SPI_CMD_WRITE_ENABLE        0x06
+#define SPI_CMD_READ_STATUS         0x05
+#define SPI_CMD_PAGE_PROGRAM        0x02
+#define SPI_CMD_ERASE_4K            0x20
+
+#define SPI_STATUS_WIP              BIT(0)
+#define SPI_PAGE_SIZE               256
+
+#define SFDP_SIGNATURE              0x50444653 /* "SFDP" */
+#define SFDP_BFPT_DWORD1_112        BIT(16)
+#define SFDP_BFPT_DWORD1_114        BIT(22)
+
+/*****************************************************************************/
+
 /*
  * Allwinner A10/A20 SoCs were using pins PC0,PC1,PC2,PC23 for booting
  * from SPI Flash, everything else is using pins PC0,PC1,PC2,PC3.
@@ -128,6 +160,13 @@ static void spi0_pinmux_setup(unsigned int pin_function)
 	    IS_ENABLED(CONFIG_MACH_SUN8I_R528))
 		sunxi_gpio_set_cfgpin(SUNXI_GPC(4), pin_function);
 
+	/* The H616 has WP/IO2 on PC15 and HOLD/IO3 on PC16 */
+	if (IS_ENABLED(CONFIG_SPL_SPI_SUNXI_QUAD_READ) &&
+	    IS_ENABLED(CONFIG_MACH_SUN50I_H616)) {
+		sunxi_gpio_set_cfgpin(SUNXI_GPC(15), pin_function);
+		sunxi_gpio_set_cfgpin(SUNXI_GPC(16), pin_function);
+	}
+
 	/* Older generations use PC23 for CS, newer ones use PC3. */
 	if (IS_ENABLED(CONFIG_MACH_SUN4I) || IS_ENABLED(CONFIG_MACH_SUN7I) ||
 	    IS_ENABLED(CONFIG_MACH_SUN8I_R40))
@@ -163,7 +202,24 @@ static uintptr_t spi0_base_address(void)
 }
 
 /*
- * Setup 6 MHz from OSC24M (because the BROM is doing the same).
+ * The divider applied to OSC24M. 6 MHz is what the BROM is using, and
+ * always safe. Only the sun6i variant can bypass the internal divider.
+ */
+static u32 spi0_clk_div(void)
+{
+	if (IS_ENABLED(CONFIG_SPL_SPI_SUNXI_CLK_24MHZ) && is_sun6i_gen_spi())
+		return SPI0_CLK_DIV_BY_1;
+
+	if (IS_ENABLED(CONFIG_SPL_SPI_SUNXI_CLK_12MHZ) ||
+	    IS_ENABLED(CONFIG_SPL_SPI_SUNXI_CLK_24MHZ))
+		return SPI0_CLK_DIV_BY_2;
+
+	return SPI0_CLK_DIV_BY_4;
+}
+
+/*
+ * Setup the SPI clock from OSC24M, 6 MHz by default (because the BROM is
+ * doing the same).
  */
 static void spi0_enable_clock(void)
 {
@@ -188,8 +244,8 @@ static void spi0_enable_clock(void)
 	} else {
 		/* New SoCs do not have a clock divider inside */
 		if (!IS_ENABLED(CONFIG_SUNXI_GEN_NCAT2)) {
-			/* Divide by 4 */
-			writel(SPI0_CLK_DIV_BY_4,
+			/* Divide by 4 (or less, see above) */
+			writel(spi0_clk_div(),
 			       base + (is_sun6i_gen_spi() ? SUN6I_SPI0_CCTL :
 			       SUN4I_SPI0_CCTL));
 		}
@@ -209,9 +265,11 @@ static void spi0_enable_clock(void)
 		/*
 		 * For new SoCs we should configure sample mode depending on
 		 * input clock. As 24MHz from OSC24M is used, we could use
-		 * normal sample mode by setting SDM bit in the TCR register
+		 * normal sample mode by setting SDM bit in the TCR register.
+		 * The same applies when the internal divider is bypassed.
 		 */
-		if (IS_ENABLED(CONFIG_SUNXI_GEN_NCAT2))
+		if (IS_ENABLED(CONFIG_SUNXI_GEN_NCAT2) ||
+		    spi0_clk_div() == SPI0_CLK_DIV_BY_1)
 			setbits_le32(base + SUN6I_SPI0_TCR, SUN6I_TCR_SDM);
 	} else {
 		/* Enable SPI in the master mode and reset FIFO */
@@ -281,9 +339,31 @@ static void spi0_deinit(void)
 
 /*****************************************************************************/
 
-#define SPI_READ_MAX_SIZE 60 /* FIFO size, minus 4 bytes of the header */
+#define SPI_FIFO_SIZE 64
+#define SPI_HDR_MAX_SIZE 5 /* opcode, 3 address bytes, 1 dummy byte */
 
-static void sunxi_spi0_read_data(u8 *buf, u32 addr, u32 bufsize,
+/* How U-Boot proper gets read, see spi0_select_read_mode() */
+static u8 spi0_read_opcode = SPI_CMD_READ;
+static u8 spi0_read_dummy;
+static u32 spi0_read_bcc_mode;
+
+static u32 spi0_setup_header(u8 *hdr, u8 opcode, u32 addr, u32 dummy)
+{
+	hdr[0] = opcode;
+	hdr[1] = (u8)(addr >> 16);
+	hdr[2] = (u8)(addr >> 8);
+	hdr[3] = (u8)(addr);
+	hdr[4] = 0;
+
+	return 4 + dummy;
+}
+
+/*
+ * Single I/O read: the command header and the data are clocked in one
+ * burst, so the RX FIFO also collects one byte per header byte.
+ */
+static void sunxi_spi0_read_data(u8 *buf, const u8 *hdr, u32 hdr_len,
+				 u32 bufsize,
 				 ulong spi_ctl_reg,
 				 ulong spi_ctl_xch_bitmask,
 				 ulong spi_fifo_reg,
@@ -293,26 +373,27 @@ static void sunxi_spi0_read_data(u8 *buf, u32 addr, u32 bufsize,
 				 ulong spi_tc_reg,
 				 ulong spi_bcc_reg)
 {
-	writel(4 + bufsize, spi_bc_reg); /* Burst counter (total bytes) */
-	writel(4, spi_tc_reg);           /* Transfer counter (bytes to send) */
+	u32 i;
+
+	writel(hdr_len + bufsize, spi_bc_reg); /* Burst counter (total bytes) */
+	writel(hdr_len, spi_tc_reg);     /* Transfer counter (bytes to send) */
 	if (spi_bcc_reg)
-		writel(4, spi_bcc_reg);  /* SUN6I also needs this */
+		writel(hdr_len, spi_bcc_reg);  /* SUN6I also needs this */
 
-	/* Send the Read Data Bytes (03h) command header */
-	writeb(0x03, spi_tx_reg);
-	writeb((u8)(addr >> 16), spi_tx_reg);
-	writeb((u8)(addr >> 8), spi_tx_reg);
-	writeb((u8)(addr), spi_tx_reg);
+	/* Send the command header */
+	for (i = 0; i < hdr_len; i++)
+		writeb(hdr[i], spi_tx_reg);
 
 	/* Start the data transfer */
 	setbits_le32(spi_ctl_reg, spi_ctl_xch_bitmask);
 
 	/* Wait until everything is received in the RX FIFO */
-	while ((readl(spi_fifo_reg) & 0x7F) < 4 + bufsize)
+	while ((readl(spi_fifo_reg) & 0x7F) < hdr_len + bufsize)
 		;
 
-	/* Skip 4 bytes */
-	readl(spi_rx_reg);
+	/* Skip the header bytes */
+	for (i = 0; i < hdr_len; i++)
+		readb(spi_rx_reg);
 
 	/* Read the data */
 	while (bufsize-- > 0)
@@ -322,38 +403,98 @@ static void sunxi_spi0_read_data(u8 *buf, u32 addr, u32 bufsize,
 	udelay(1);
 }
 
-static void spi0_read_data(void *buf, u32 addr, u32 len)
+/*
+ * Dual/Quad output read on the SUN6I variant: a single I/O command phase
+ * followed by a receive-only data phase using the given BCC mode bits,
+ * with the chip select held low by software in between.
+ */
+static void sun6i_spi0_read_data_multi(u8 *buf, const u8 *hdr, u32 hdr_len,
+				       u32 bufsize, u32 bcc_mode)
+{
+	uintptr_t base = spi0_base_address();
+	u32 i;
+
+	/* Take over the chip select and assert it */
+	clrsetbits_le32(base + SUN6I_SPI0_TCR, SUN6I_TCR_SS_LEVEL,
+			SUN6I_TCR_SS_OWNER);
+
+	writel(hdr_len, base + SUN6I_SPI0_MBC);
+	writel(hdr_len, base + SUN6I_SPI0_MTC);
+	writel(hdr_len, base + SUN6I_SPI0_BCC);
+	for (i = 0; i < hdr_len; i++)
+		writeb(hdr[i], base + SUN6I_SPI0_TXD);
+	setbits_le32(base + SUN6I_SPI0_TCR, SUN6I_TCR_XCH);
+	while (readl(base + SUN6I_SPI0_TCR) & SUN6I_TCR_XCH)
+		;
+	setbits_le32(base + SUN6I_SPI0_FCR, SUN6I_FCR_RF_RST);
+
+	writel(bufsize, base + SUN6I_SPI0_MBC);
+	writel(0, base + SUN6I_SPI0_MTC);
+	writel(bcc_mode, base + SUN6I_SPI0_BCC);
+	setbits_le32(base + SUN6I_SPI0_TCR, SUN6I_TCR_XCH);
+	while ((readl(base + SUN6I_SPI0_FIFO_STA) & 0x7F) < bufsize)
+		;
+	while (bufsize-- > 0)
+		*buf++ = readb(base + SUN6I_SPI0_RXD);
+
+	/* Deassert the chip select, tSHSL is up to 100 ns */
+	setbits_le32(base + SUN6I_SPI0_TCR, SUN6I_TCR_SS_LEVEL);
+	udelay(1);
+	clrbits_le32(base + SUN6I_SPI0_TCR, SUN6I_TCR_SS_OWNER);
+}
+
+/*
+ * Single I/O transfer of at most SPI_FIFO_SIZE bytes in total: @tx_len
+ * bytes are sent, then @rx_len bytes are received.
+ */
+static void spi0_xfer(const u8 *tx, u32 tx_len, u8 *rx, u32 rx_len)
 {
-	u8 *buf8 = buf;
-	u32 chunk_len;
 	uintptr_t base = spi0_base_address();
 
+	if (is_sun6i_gen_spi())
+		sunxi_spi0_read_data(rx, tx, tx_len, rx_len,
+				     base + SUN6I_SPI0_TCR,
+				     SUN6I_TCR_XCH,
+				     base + SUN6I_SPI0_FIFO_STA,
+				     base + SUN6I_SPI0_TXD,
+				     base + SUN6I_SPI0_RXD,
+				     base + SUN6I_SPI0_MBC,
+				     base + SUN6I_SPI0_MTC,
+				     base + SUN6I_SPI0_BCC);
+	else
+		sunxi_spi0_read_data(rx, tx, tx_len, rx_len,
+				     base + SUN4I_SPI0_CTL,
+				     SUN4I_CTL_XCH,
+				     base + SUN4I_SPI0_FIFO_STA,
+				     base + SUN4I_SPI0_TX,
+				     base + SUN4I_SPI0_RX,
+				     base + SUN4I_SPI0_BC,
+				     base + SUN4I_SPI0_TC,
+				     0);
+}
+
+static void spi0_read_cmd(void *buf, u8 opcode, u32 dummy, u32 bcc_mode,
+			  u32 addr, u32 len)
+{
+	u8 *buf8 = buf;
+	u8 hdr[SPI_HDR_MAX_SIZE];
+	u32 chunk_len, hdr_len, max_len;
+
+	hdr_len = spi0_setup_header(hdr, opcode, addr, dummy);
+	/* The header only shares the FIFO with single I/O data */
+	max_len = bcc_mode ? SPI_FIFO_SIZE : SPI_FIFO_SIZE - hdr_len;
+
 	while (len > 0) {
 		chunk_len = len;
-		if (chunk_len > SPI_READ_MAX_SIZE)
-			chunk_len = SPI_READ_MAX_SIZE;
-
-		if (is_sun6i_gen_spi()) {
-			sunxi_spi0_read_data(buf8, addr, chunk_len,
-					     base + SUN6I_SPI0_TCR,
-					     SUN6I_TCR_XCH,
-					     base + SUN6I_SPI0_FIFO_STA,
-					     base + SUN6I_SPI0_TXD,
-					     base + SUN6I_SPI0_RXD,
-					     base + SUN6I_SPI0_MBC,
-					     base + SUN6I_SPI0_MTC,
-					     base + SUN6I_SPI0_BCC);
-		} else {
-			sunxi_spi0_read_data(buf8, addr, chunk_len,
-					     base + SUN4I_SPI0_CTL,
-					     SUN4I_CTL_XCH,
-					     base + SUN4I_SPI0_FIFO_STA,
-					     base + SUN4I_SPI0_TX,
-					     base + SUN4I_SPI0_RX,
-					     base + SUN4I_SPI0_BC,
-					     base + SUN4I_SPI0_TC,
-					     0);
-		}
+		if (chunk_len > max_len)
+			chunk_len = max_len;
+
+		spi0_setup_header(hdr, opcode, addr, dummy);
+		if (bcc_mode)
+			sun6i_spi0_read_data_multi(buf8, hdr, hdr_len,
+						   chunk_len, bcc_mode);
+		else
+			spi0_xfer(hdr, hdr_len, buf8, chunk_len);
 
 		len  -= chunk_len;
 		buf8 += chunk_len;
@@ -361,6 +502,72 @@ static void spi0_read_data(void *buf, u32 addr, u32 len)
 	}
 }
 
+static void spi0_read_data(void *buf, u32 addr, u32 len)
+{
+	spi0_read_cmd(buf, spi0_read_opcode, spi0_read_dummy,
+		      spi0_read_bcc_mode, addr, len);
+}
+
+/*
+ * Check the Basic Flash Parameter Table for the 1-1-2 or 1-1-4 fast read
+ * that was picked in Kconfig. Only a command using the usual 8 dummy
+ * clocks is accepted, since the dummy phase is sent as one single I/O byte.
+ */
+static bool spi0_sfdp_supports(u32 dword1_bit, unsigned int param_dword,
+			       unsigned int shift, u8 opcode)
+{
+	u32 hdr[4], param[4], ptr;
+	u16 inst;
+
+	spi0_read_cmd(hdr, SPI_CMD_READ_SFDP, 1, 0, 0, sizeof(hdr));
+	if (le32_to_cpu(hdr[0]) != SFDP_SIGNATURE)
+		return false;
+
+	/* The first parameter header always describes the BFPT */
+	ptr = le32_to_cpu(hdr[3]) & 0xffffff;
+	spi0_read_cmd(param, SPI_CMD_READ_SFDP, 1, 0, ptr, sizeof(param));
+	if (!(le32_to_cpu(param[0]) & dword1_bit))
+		return false;
+
+	inst = le32_to_cpu(param[param_dword]) >> shift;
+	/* Opcode in bits 15:8, mode clocks in 7:5, wait states in 4:0 */
+	return (inst >> 8) == opcode &&
+	       ((inst >> 5) & 0x7) + (inst & 0x1f) == 8;
+}
+
+static void spi0_select_read_mode(void)
+{
+	u8 opcode = SPI_CMD_READ;
+	u32 bcc_mode = 0;
+	bool ok = true;
+
+	if (IS_ENABLED(CONFIG_SPL_SPI_SUNXI_FAST_READ)) {
+		opcode = SPI_CMD_FAST_READ;
+	} else if (IS_ENABLED(CONFIG_SPL_SPI_SUNXI_DUAL_READ)) {
+		opcode = SPI_CMD_DUAL_OUTPUT_READ;
+		bcc_mode = SUN6I_BCC_DRM;
+		if (IS_ENABLED(CONFIG_SPL_SPI_SUNXI_SFDP))
+			ok = spi0_sfdp_supports(SFDP_BFPT_DWORD1_112, 3, 0,
+						opcode);
+	} else if (IS_ENABLED(CONFIG_SPL_SPI_SUNXI_QUAD_READ)) {
+		opcode = SPI_CMD_QUAD_OUTPUT_READ;
+		bcc_mode = SUN6I_BCC_QUAD_EN;
+		if (IS_ENABLED(CONFIG_SPL_SPI_SUNXI_SFDP))
+			ok = spi0_sfdp_supports(SFDP_BFPT_DWORD1_114, 2, 16,
+						opcode);
+	}
+
+	if (!ok) {
+		debug("SPI flash: read mode %02x not in SFDP, using 03h\n",
+		      opcode);
+		return;
+	}
+
+	spi0_read_opcode = opcode;
+	spi0_read_dummy = opcode == SPI_CMD_READ ? 0 : 1;
+	spi0_read_bcc_mode = bcc_mode;
+}
+
 static ulong spi_load_read(struct spl_load_info *load, ulong sector,
 			   ulong count, void *buf)
 {
@@ -369,20 +576,114 @@ static ulong spi_load_read(struct spl_load_info *load, ulong sector,
 	return count;
 }
 
+/*
+ * Raw access to the boot flash for other SPL code, e.g. to keep data that
+ * has to be available before DRAM is up. Each call sets up and releases
+ * the controller on its own, and fails with -ENODEV at once if no flash
+ * answers with a JEDEC ID.
+ */
+static bool spi0_flash_present(void)
+{
+	u8 opcode = SPI_CMD_READ_ID, id[3];
+
+	spi0_xfer(&opcode, 1, id, sizeof(id));
+
+	/* the bus reads as all zeroes or all ones without a flash */
+	return (id[0] | id[1] | id[2]) && (id[0] & id[1] & id[2]) != 0xff;
+}
+
+int sunxi_spi0_flash_read(u32 addr, void *buf, u32 len)
+{
+	int ret = -ENODEV;
+
+	spi0_init();
+	if (spi0_flash_present()) {
+		spi0_read_cmd(buf, SPI_CMD_READ, 0, 0, addr, len);
+		ret = 0;
+	}
+	spi0_deinit();
+
+	return ret;
+}
+
+#if IS_ENABLED(CONFIG_SPL_SPI_SUNXI_WRITE)
+static int spi0_write_cmd(const u8 *cmd, u32 len)
+{
+	u8 opcode = SPI_CMD_WRITE_ENABLE, status;
+	ulong start;
+
+	spi0_xfer(&opcode, 1, NULL, 0);
+	spi0_xfer(cmd, len, NULL, 0);
+
+	/* A 4K sector erase takes up to 400 ms on common parts */
+	opcode = SPI_CMD_READ_STATUS;
+	start = get_timer(0);
+	do {
+		spi0_xfer(&opcode, 1, &status, 1);
+		if (!(status & SPI_STATUS_WIP))
+			return 0;
+	} while (get_timer(start) < 1000);
+
+	return -ETIMEDOUT;
+}
+
+/*
+ * Erase the 4K sectors covering [addr, addr + len) and program @buf there.
+ * Anything else in those sectors is lost.
+ */
+int sunxi_spi0_flash_write(u32 addr, const void *buf, u32 len)
+{
+	u8 cmd[SPI_FIFO_SIZE];
+	const u8 *buf8 = buf;
+	u32 sector, chunk_len, end = addr + len;
+	int ret = 0;
+
+	spi0_init();
+	if (!spi0_flash_present()) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	for (sector = ALIGN_DOWN(addr, SZ_4K); sector < end; sector += SZ_4K) {
+		spi0_setup_header(cmd, SPI_CMD_ERASE_4K, sector, 0);
+		ret = spi0_write_cmd(cmd, 4);
+		if (ret)
+			goto out;
+	}
+
+	while (len > 0) {
+		/* The data shares the FIFO with the header, within one page */
+		chunk_len = min_t(u32, len, SPI_FIFO_SIZE - 4);
+		chunk_len = min_t(u32, chunk_len,
+				  SPI_PAGE_SIZE - (addr & (SPI_PAGE_SIZE - 1)));
+
+		spi0_setup_header(cmd, SPI_CMD_PAGE_PROGRAM, addr, 0);
+		memcpy(cmd + 4, buf8, chunk_len);
+		ret = spi0_write_cmd(cmd, 4 + chunk_len);
+		if (ret)
+			goto out;
+
+		len  -= chunk_len;
+		buf8 += chunk_len;
+		addr += chunk_len;
+	}
+
+out:
+	spi0_deinit();
+
+	return ret;
+}
+#endif
+
 /*****************************************************************************/
 
-static int spl_spi_load_image(struct spl_image_info *spl_image,
-			      struct spl_boot_device *bootdev)
+static int spl_spi_load_at(struct spl_image_info *spl_image,
+			   struct spl_boot_device *bootdev, u32 load_offset)
 {
 	int ret = 0;
 	struct legacy_img_hdr *header;
-	uint32_t load_offset = sunxi_get_spl_size();
 
 	header = (struct legacy_img_hdr *)CONFIG_TEXT_BASE;
-	load_offset = max_t(uint32_t, load_offset, CONFIG_SYS_SPI_U_BOOT_OFFS);
-
-	spi0_init();
-
 	spi0_read_data((void *)header, load_offset, 0x40);
 
         if (IS_ENABLED(CONFIG_SPL_LOAD_FIT) &&
@@ -391,6 +692,12 @@ static int spl_spi_load_image(struct spl_image_info *spl_image,
 
 		debug("Found FIT image\n");
 		spl_load_init(&load, spi_load_read, NULL, 1);
+		/*
+		 * The data is read by PIO through the CPU anyway, so keep
+		 * each chunk small enough to still be in the L1 cache when
+		 * it is hashed or inflated.
+		 */
+		spl_set_chunk_size(&load, SZ_16K);
 		ret = spl_load_simple_fit(spl_image, &load,
 					  load_offset, header);
 	} else {
@@ -402,6 +709,36 @@ static int spl_spi_load_image(struct spl_image_info *spl_image,
 			       load_offset, spl_image->size);
 	}
 
+	return ret;
+}
+
+static int spl_spi_load_image(struct spl_image_info *spl_image,
+			      struct spl_boot_device *bootdev)
+{
+	uint32_t load_offset = sunxi_get_spl_size();
+	int ret;
+
+	load_offset = max_t(uint32_t, load_offset, CONFIG_SYS_SPI_U_BOOT_OFFS);
+
+	spi0_init();
+	spi0_select_read_mode();
+
+#if CONFIG_IS_ENABLED(OS_BOOT)
+	if (!spl_start_uboot()) {
+		ret = spl_spi_load_at(spl_image, bootdev,
+				      CONFIG_SPL_SPI_SUNXI_KERNEL_OFFS);
+		/* with TF-A, Linux is started as its BL3-3 */
+		if (!ret && (spl_image->os == IH_OS_LINUX ||
+			     (CONFIG_IS_ENABLED(ATF) &&
+			      spl_image->os == IH_OS_ARM_TRUSTED_FIRMWARE))) {
+			spi0_deinit();
+			return 0;
+		}
+		puts("Expected image is not found. Trying to start U-Boot\n");
+	}
+#endif
+
+	ret = spl_spi_load_at(spl_image, bootdev, load_offset);
 	spi0_deinit();
 
 	return ret;
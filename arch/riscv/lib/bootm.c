@@ -6,6 +6,7 @@
  * Rick Chen, Andes Technology Corporation <rick@andestech.com>
  */
 
+#include <blk.h>
 #include <bootstage.h>
 #include <bootm.h>
 #include <command.h>
@@ -38,6 +39,7 @@ static void announce_and_cleanup(int fake)
 {
 	printf("\nStarting kernel ...%s\n\n", fake ?
 		"(fake run for tracing)" : "");
+	flush();
 	bootstage_mark_name(BOOTSTAGE_ID_BOOTM_HANDOFF, "start_kernel");
 #ifdef CONFIG_BOOTSTAGE_FDT
 	bootstage_fdt_add_report();
@@ -50,6 +52,7 @@ static void announce_and_cleanup(int fake)
 	udc_disconnect();
 #endif
 
+	blkcache_flush(-1, 0);
 	board_quiesce_devices();
 
 	/*
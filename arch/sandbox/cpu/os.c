@@ -271,6 +271,21 @@ out:
 	return ret;
 }
 
+int os_map_fd(int fd, int os_flags, int size, void **bufp)
+{
+	int prot = PROT_READ;
+	void *ptr;
+
+	if ((os_flags & OS_O_MASK) != OS_O_RDONLY)
+		prot |= PROT_WRITE;
+	ptr = mmap(0, size, prot, MAP_SHARED, fd, 0);
+	if (ptr == MAP_FAILED)
+		return -EPERM;
+	*bufp = ptr;
+
+	return 0;
+}
+
 int os_unmap(void *buf, int size)
 {
 	if (munmap(buf, size)) {
@@ -35,6 +35,7 @@ DECLARE_GLOBAL_DATA_PTR;
 void bootm_announce_and_cleanup(void)
 {
 	printf("\nStarting kernel ...\n\n");
+	flush();
 
 #ifdef CONFIG_SYS_COREBOOT
 	timestamp_add_now(TS_START_KERNEL);
@@ -11,6 +11,7 @@
  */
 
 #include <clock_legacy.h>
+#include <cpu_func.h>
 #include <dm.h>
 #include <env.h>
 #include <hang.h>
@@ -19,6 +20,7 @@
 #include <init.h>
 #include <log.h>
 #include <mmc.h>
+#include <serial.h>
 #include <axp_pmic.h>
 #include <generic-phy.h>
 #include <phy-sun4i-usb.h>
@@ -307,6 +309,8 @@ static void nand_clock_setup(void)
 		(struct sunxi_ccm_reg *)SUNXI_CCM_BASE;
 
 	setbits_le32(&ccm->ahb_gate0, (CLK_GATE_OPEN << AHB_GATE_OFFSET_NAND0));
+	if (IS_ENABLED(CONFIG_NAND_SUNXI_DMA))
+		setbits_le32(&ccm->ahb_gate0, (1 << AHB_GATE_OFFSET_DMA));
 #if defined CONFIG_MACH_SUN6I || defined CONFIG_MACH_SUN8I || \
     defined CONFIG_MACH_SUN9I || defined CONFIG_MACH_SUN50I
 	setbits_le32(&ccm->ahb_reset0_cfg, (1 << AHB_GATE_OFFSET_NAND0));
@@ -547,8 +551,69 @@ static void sunxi_spl_store_dram_size(phys_addr_t dram_size)
 	spl->dram_size = dram_size >> 20;
 }
 
+static void sunxi_spl_set_cpu_clk(int power_failed)
+{
+	/*
+	 * Only clock up the CPU to full speed if we are reasonably
+	 * assured it's being powered with suitable core voltage
+	 */
+	if (!power_failed)
+		clock_set_pll1(get_board_sys_clk());
+	else
+		printf("Failed to set core voltage! Can't set CPU frequency\n");
+}
+
+/*
+ * Turn on the MMU once DRAM is up, so that loading, hashing and copying the
+ * next images runs with the caches on. The page tables go at the top of DRAM,
+ * which U-Boot proper only uses after relocation.
+ */
+static void sunxi_spl_enable_caches(void)
+{
+	gd->ram_top = board_get_usable_ram_top(gd->ram_size);
+	gd->relocaddr = gd->ram_top;
+	arch_reserve_mmu();
+	enable_caches();
+}
+
+void spl_board_prepare_for_boot(void)
+{
+	if (IS_ENABLED(CONFIG_SPL_SUNXI_CACHE))
+		cleanup_before_linux();
+}
+
+#ifdef CONFIG_SPL_OS_BOOT
+/*
+ * Falcon mode: start the OS directly, unless 'c' is pressed on the console
+ * or the U-Boot button is held down
+ */
+int spl_start_uboot(void)
+{
+	static int result = -1;
+	int pin;
+
+	/* each boot device asks, but the key can only be read once */
+	if (result != -1)
+		return result;
+
+	result = serial_tstc() && serial_getc() == 'c';
+	pin = sunxi_name_to_gpio(CONFIG_SPL_SUNXI_UBOOT_GPIO);
+	if (!result && pin >= 0) {
+		sunxi_gpio_set_cfgpin(pin, SUNXI_GPIO_INPUT);
+		sunxi_gpio_set_pull(pin, SUNXI_GPIO_PULL_UP);
+		udelay(10);
+		result = !gpio_get_value(pin);
+	}
+	if (result)
+		puts("Starting U-Boot\n");
+
+	return result;
+}
+#endif
+
 void sunxi_board_init(void)
 {
+	struct pmic_bus_batch __maybe_unused batch;
 	int power_failed = 0;
 
 #ifdef CONFIG_LED_STATUS
@@ -576,6 +641,8 @@ void sunxi_board_init(void)
 		}
 	}
 
+	/* send the regulator settings in a few transfers, in the same order */
+	pmic_bus_batch_start(&batch);
 #ifdef CONFIG_AXP_DCDC1_VOLT
 	power_failed |= axp_set_dcdc1(CONFIG_AXP_DCDC1_VOLT);
 #endif
@@ -626,7 +693,16 @@ void sunxi_board_init(void)
 #if defined CONFIG_AXP809_POWER || defined CONFIG_AXP818_POWER
 	power_failed |= axp_set_sw(IS_ENABLED(CONFIG_AXP_SW_ON));
 #endif
+	power_failed |= pmic_bus_batch_end();
 #endif	/* CONFIG_AXPxxx_POWER */
+	/*
+	 * Clock up the CPU before DRAM init, so that training runs at full
+	 * speed too. The sun9i DRAM driver uses CPU-cycle delays, so it
+	 * must still run on the safe clock.
+	 */
+	if (!IS_ENABLED(CONFIG_MACH_SUN9I))
+		sunxi_spl_set_cpu_clk(power_failed);
+
 	printf("DRAM:");
 	gd->ram_size = sunxi_dram_init();
 	printf(" %d MiB\n", (int)(gd->ram_size >> 20));
@@ -635,14 +711,11 @@ void sunxi_board_init(void)
 
 	sunxi_spl_store_dram_size(gd->ram_size);
 
-	/*
-	 * Only clock up the CPU to full speed if we are reasonably
-	 * assured it's being powered with suitable core voltage
-	 */
-	if (!power_failed)
-		clock_set_pll1(get_board_sys_clk());
-	else
-		printf("Failed to set core voltage! Can't set CPU frequency\n");
+	if (IS_ENABLED(CONFIG_MACH_SUN9I))
+		sunxi_spl_set_cpu_clk(power_failed);
+
+	if (IS_ENABLED(CONFIG_SPL_SUNXI_CACHE))
+		sunxi_spl_enable_caches();
 }
 #endif /* CONFIG_XPL_BUILD */
 
@@ -882,6 +955,25 @@ static void bluetooth_dt_fixup(void *blob)
 #define PINEPHONE_LIS3MDL_I2C_ADDR	0x1e
 #define PINEPHONE_LIS3MDL_I2C_BUS	1 /* I2C1 */
 
+/* Let the OS know how SPL set up the DRAM controller's master priorities */
+static int sunxi_mbus_qos_fixup(void *blob)
+{
+	const char *profile = "default";
+	int node;
+
+	if (IS_ENABLED(CONFIG_DRAM_SUN50I_H616_QOS_CPU))
+		profile = "cpu-latency";
+	else if (IS_ENABLED(CONFIG_DRAM_SUN50I_H616_QOS_MEDIA))
+		profile = "media-bandwidth";
+
+	node = fdt_find_or_add_subnode(blob, 0, "chosen");
+	if (node < 0)
+		return node;
+
+	return fdt_setprop_string(blob, node, "u-boot,mbus-qos-profile",
+				  profile);
+}
+
 static void board_dt_fixup(void *blob)
 {
 	struct udevice *bus, *dev;
@@ -915,6 +1007,12 @@ int ft_board_setup(void *blob, struct bd_info *bd)
 	bluetooth_dt_fixup(blob);
 	board_dt_fixup(blob);
 
+	if (IS_ENABLED(CONFIG_DRAM_SUN50I_H616)) {
+		r = sunxi_mbus_qos_fixup(blob);
+		if (r)
+			return r;
+	}
+
 #ifdef CONFIG_VIDEO_DT_SIMPLEFB
 	r = sunxi_simplefb_setup(blob);
 	if (r)
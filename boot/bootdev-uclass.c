@@ -748,6 +748,11 @@ int bootdev_setup_iter(struct bootflow_iter *iter, const char *label,
 	} else {
 		bool ok;
 
+		/* let slow hunters get going while the fast bootdevs are used */
+		if (IS_ENABLED(CONFIG_BOOTDEV_HUNT_ASYNC) &&
+		    (iter->flags & BOOTFLOWIF_HUNT))
+			bootdev_hunt_start(show);
+
 		/* This either returns a non-empty list or NULL */
 		iter->labels = bootstd_get_bootdev_order(bootstd, &ok);
 		if (!ok)
@@ -840,6 +845,30 @@ int bootdev_hunt(const char *spec, bool show)
 	return result;
 }
 
+void bootdev_hunt_start(bool show)
+{
+	struct bootdev_hunter *start;
+	struct bootstd_priv *std;
+	int n_ent, i;
+
+	if (bootstd_get_priv(&std))
+		return;
+	start = ll_entry_start(struct bootdev_hunter, bootdev_hunter);
+	n_ent = ll_entry_count(struct bootdev_hunter, bootdev_hunter);
+	for (i = 0; i < n_ent; i++) {
+		struct bootdev_hunter *info = start + i;
+		int ret;
+
+		if (!info->start || (std->hunters_used & BIT(i)))
+			continue;
+		if (show)
+			printf("Starting hunter: %s\n",
+			       uclass_get_name(info->uclass));
+		ret = info->start(info, show);
+		log_debug("  - start result %d\n", ret);
+	}
+}
+
 int bootdev_unhunt(enum uclass_id id)
 {
 	struct bootdev_hunter *start;
@@ -359,6 +359,13 @@ static int bootflow_check(struct bootflow_iter *iter, struct bootflow *bflow)
 
 	/* If we got a valid bootflow, return it */
 	if (!ret) {
+		/* ...unless it was already tried, before the scan started */
+		if (IS_ENABLED(CONFIG_BOOTFLOW_CACHE) &&
+		    dev == iter->cache_dev && iter->part == iter->cache_part &&
+		    iter->method == iter->cache_method) {
+			bootflow_free(bflow);
+			return log_msg_ret("cache", -EALREADY);
+		}
 		log_debug("Bootdev '%s' part %d method '%s': Found bootflow\n",
 			  dev->name, iter->part, iter->method->name);
 		return 0;
@@ -379,27 +386,19 @@ static int bootflow_check(struct bootflow_iter *iter, struct bootflow *bflow)
 	return log_msg_ret("check", ret);
 }
 
-int bootflow_scan_first(struct udevice *dev, const char *label,
-			struct bootflow_iter *iter, int flags,
-			struct bootflow *bflow)
+/**
+ * bootflow_scan_start() - Find the first bootflow, once the bootmeths are set up
+ *
+ * @iter: Iterator, with the bootmeth ordering set up
+ * @label: Label to scan, or NULL for all bootdevs
+ * @bflow: Bootflow to update on success
+ * Return: 0 if OK, -ve on error
+ */
+static int bootflow_scan_start(struct bootflow_iter *iter, const char *label,
+			       struct bootflow *bflow)
 {
 	int ret;
 
-	if (dev || label)
-		flags |= BOOTFLOWIF_SKIP_GLOBAL;
-	bootflow_iter_init(iter, flags);
-
-	/*
-	 * Set up the ordering of bootmeths. This sets iter->doing_global and
-	 * iter->first_glob_method if we are starting with the global bootmeths
-	 */
-	ret = bootmeth_setup_iter_order(iter, !(flags & BOOTFLOWIF_SKIP_GLOBAL));
-	if (ret)
-		return log_msg_ret("obmeth", -ENODEV);
-
-	/* Find the first bootmeth (there must be at least one!) */
-	iter->method = iter->method_order[iter->cur_method];
-
 	if (!IS_ENABLED(CONFIG_BOOTMETH_GLOBAL) || !iter->doing_global) {
 		struct udevice *dev = NULL;
 		int method_flags;
@@ -427,10 +426,50 @@ int bootflow_scan_first(struct udevice *dev, const char *label,
 	return 0;
 }
 
+int bootflow_scan_first(struct udevice *dev, const char *label,
+			struct bootflow_iter *iter, int flags,
+			struct bootflow *bflow)
+{
+	int ret;
+
+	if (dev || label)
+		flags |= BOOTFLOWIF_SKIP_GLOBAL;
+	bootflow_iter_init(iter, flags);
+
+	/*
+	 * Set up the ordering of bootmeths. This sets iter->doing_global and
+	 * iter->first_glob_method if we are starting with the global bootmeths
+	 */
+	ret = bootmeth_setup_iter_order(iter, !(flags & BOOTFLOWIF_SKIP_GLOBAL));
+	if (ret)
+		return log_msg_ret("obmeth", -ENODEV);
+
+	/* Find the first bootmeth (there must be at least one!) */
+	iter->method = iter->method_order[iter->cur_method];
+
+	/* try what was booted last time, before hunting and scanning */
+	if (IS_ENABLED(CONFIG_BOOTFLOW_CACHE) && !dev && !label &&
+	    !(flags & BOOTFLOWIF_ALL) && !bootflow_cache_find(iter, bflow)) {
+		if (flags & BOOTFLOWIF_SHOW)
+			printf("Trying last bootflow '%s'\n", bflow->name);
+		iter->flags |= BOOTFLOWIF_CACHED;
+
+		return 0;
+	}
+
+	return bootflow_scan_start(iter, label, bflow);
+}
+
 int bootflow_scan_next(struct bootflow_iter *iter, struct bootflow *bflow)
 {
 	int ret;
 
+	if (IS_ENABLED(CONFIG_BOOTFLOW_CACHE) &&
+	    (iter->flags & BOOTFLOWIF_CACHED)) {
+		iter->flags &= ~BOOTFLOWIF_CACHED;
+		return bootflow_scan_start(iter, NULL, bflow);
+	}
+
 	do {
 		ret = iter_incr(iter);
 		log_debug("iter_incr: ret=%d\n", ret);
@@ -532,7 +571,11 @@ int bootflow_run_boot(struct bootflow_iter *iter, struct bootflow *bflow)
 	if (IS_ENABLED(CONFIG_OF_HAS_PRIOR_STAGE) &&
 	    (bflow->flags & BOOTFLOWF_USE_PRIOR_FDT))
 		printf("Using prior-stage device tree\n");
+	if (IS_ENABLED(CONFIG_BOOTFLOW_CACHE))
+		bootflow_cache_save(bflow);
 	ret = bootflow_boot(bflow);
+	if (IS_ENABLED(CONFIG_BOOTFLOW_CACHE))
+		bootflow_cache_drop(bflow);
 	if (!IS_ENABLED(CONFIG_BOOTSTD_FULL)) {
 		printf("Boot failed (err=%d)\n", ret);
 		return ret;
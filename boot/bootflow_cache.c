@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Recording the bootflow which was booted, so it can be tried first next time
+ *
+ * The record is kept in the 'bootflow_last' environment variable, as:
+ *
+ *	<bootdev> <partition> <bootmeth> <hunter> <size> <filename>
+ *
+ * where <hunter> is the uclass of the hunter which binds the bootdev, or '-'
+ * if there is none.
+ *
+ * The variable is only set here. Whether it persists is up to the user, who
+ * can save the environment (e.g. from a boot script) as with any other
+ * variable.
+ */
+
+#define LOG_CATEGORY UCLASS_BOOTSTD
+
+#include <bootdev.h>
+#include <bootflow.h>
+#include <dm.h>
+#include <env.h>
+#include <log.h>
+#include <malloc.h>
+#include <vsprintf.h>
+#include <linux/string.h>
+
+#define BOOTFLOW_CACHE_VAR	"bootflow_last"
+
+enum {
+	BFC_DEV,
+	BFC_PART,
+	BFC_METHOD,
+	BFC_HUNTER,
+	BFC_SIZE,
+	BFC_FNAME,
+
+	BFC_COUNT,
+	BFC_MAX_LEN	= 256,
+};
+
+/* Get the name of the uclass whose hunter binds @dev, or "-" if none */
+static const char *bootflow_cache_hunter(struct udevice *dev)
+{
+	struct bootdev_hunter *start;
+	struct udevice *parent;
+	int n_ent, i;
+
+	start = ll_entry_start(struct bootdev_hunter, bootdev_hunter);
+	n_ent = ll_entry_count(struct bootdev_hunter, bootdev_hunter);
+	for (parent = dev_get_parent(dev); parent;
+	     parent = dev_get_parent(parent)) {
+		for (i = 0; i < n_ent; i++) {
+			if (start[i].uclass == device_get_uclass_id(parent))
+				return uclass_get_name(start[i].uclass);
+		}
+	}
+
+	return "-";
+}
+
+static int bootflow_cache_record(const struct bootflow *bflow, char *buf,
+				 int size)
+{
+	int len;
+
+	/* global bootmeths do not have a bootdev to go back to */
+	if (!bflow->dev || !bflow->fname || strchr(bflow->fname, ' '))
+		return -EINVAL;
+
+	len = snprintf(buf, size, "%s %x %s %s %x %s", bflow->dev->name,
+		       bflow->part, bflow->method->name,
+		       bootflow_cache_hunter(bflow->dev), bflow->size,
+		       bflow->fname);
+	if (len >= size)
+		return -E2BIG;
+
+	return 0;
+}
+
+static int bootflow_cache_set(const char *val)
+{
+	int ret;
+
+	ret = env_set(BOOTFLOW_CACHE_VAR, val);
+	if (ret)
+		return log_msg_ret("bfc", ret);
+
+	return 0;
+}
+
+int bootflow_cache_save(const struct bootflow *bflow)
+{
+	char buf[BFC_MAX_LEN];
+	int ret;
+
+	ret = bootflow_cache_record(bflow, buf, sizeof(buf));
+	if (ret)
+		return log_msg_ret("bfs", ret);
+
+	return bootflow_cache_set(buf);
+}
+
+int bootflow_cache_drop(const struct bootflow *bflow)
+{
+	char buf[BFC_MAX_LEN];
+	const char *old;
+
+	old = env_get(BOOTFLOW_CACHE_VAR);
+	if (!old || bootflow_cache_record(bflow, buf, sizeof(buf)) ||
+	    strcmp(old, buf))
+		return 0;
+
+	return bootflow_cache_set(NULL);
+}
+
+/* Look up the recorded bootdev, hunting for it if needed */
+static int bootflow_cache_get_dev(struct bootflow_iter *iter, char *const *tok,
+				  struct udevice **devp)
+{
+	int ret;
+
+	ret = uclass_get_device_by_name(UCLASS_BOOTDEV, tok[BFC_DEV], devp);
+	if (ret == -ENODEV && (iter->flags & BOOTFLOWIF_HUNT) &&
+	    strcmp(tok[BFC_HUNTER], "-")) {
+		ret = bootdev_hunt(tok[BFC_HUNTER],
+				   iter->flags & BOOTFLOWIF_SHOW);
+		if (ret)
+			return log_msg_ret("hunt", ret);
+		ret = uclass_get_device_by_name(UCLASS_BOOTDEV, tok[BFC_DEV],
+						devp);
+	}
+	if (ret)
+		return log_msg_ret("dev", -ENOENT);
+
+	return 0;
+}
+
+int bootflow_cache_find(struct bootflow_iter *iter, struct bootflow *bflow)
+{
+	char *tok[BFC_COUNT], *str, *p;
+	struct bootflow_iter citer;
+	struct udevice *dev, *meth;
+	const char *rec;
+	int ret, i;
+
+	rec = env_get(BOOTFLOW_CACHE_VAR);
+	if (!rec)
+		return -ENOENT;
+	str = strdup(rec);
+	if (!str)
+		return log_msg_ret("bfc", -ENOMEM);
+	for (p = str, i = 0; i < BFC_COUNT; i++) {
+		tok[i] = strsep(&p, " ");
+		if (!tok[i]) {
+			ret = log_msg_ret("rec", -ENOENT);
+			goto err;
+		}
+	}
+
+	/* the bootmeth must still be enabled and in the ordering */
+	for (i = 0; i < iter->num_methods; i++) {
+		if (!strcmp(iter->method_order[i]->name, tok[BFC_METHOD]))
+			break;
+	}
+	if (i == iter->num_methods) {
+		ret = log_msg_ret("meth", -ENOENT);
+		goto err;
+	}
+	meth = iter->method_order[i];
+
+	ret = bootflow_cache_get_dev(iter, tok, &dev);
+	if (ret)
+		goto err;
+
+	/* scan just this partition, without the checks for bootable ones */
+	bootflow_iter_init(&citer, iter->flags & ~BOOTFLOWIF_SHOW);
+	citer.dev = dev;
+	citer.part = hextoul(tok[BFC_PART], NULL);
+	citer.method = meth;
+	citer.first_bootable = -1;
+	ret = bootdev_get_bootflow(dev, &citer, bflow);
+	if (!ret && (bflow->size != hextoul(tok[BFC_SIZE], NULL) ||
+		     !bflow->fname || strcmp(bflow->fname, tok[BFC_FNAME])))
+		ret = -ESTALE;
+	if (ret) {
+		log_debug("Last bootflow '%s' not usable (err=%d)\n", rec, ret);
+		bootflow_free(bflow);
+		goto err;
+	}
+
+	iter->cache_dev = dev;
+	iter->cache_part = citer.part;
+	iter->cache_method = meth;
+	free(str);
+
+	return 0;
+
+err:
+	free(str);
+
+	return ret;
+}
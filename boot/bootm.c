@@ -606,7 +606,7 @@ static int bootm_load_os(struct bootm_headers *images, int boot_progress)
 	ulong blob_end = os.end;
 	ulong image_start = os.image_start;
 	ulong image_len = os.image_len;
-	ulong flush_start = ALIGN_DOWN(load, ARCH_DMA_MINALIGN);
+	ulong flush_start;
 	bool no_overlap;
 	void *load_buf, *image_buf;
 	int err;
@@ -630,8 +630,32 @@ static int bootm_load_os(struct bootm_headers *images, int boot_progress)
 		      req_size, load, image_len);
 	}
 
-	load_buf = map_sysmem(load, 0);
 	image_buf = map_sysmem(os.image_start, image_len);
+
+	/*
+	 * An uncompressed arm64 Image may have to run from somewhere other
+	 * than its load address. Work that out from the header now, so that
+	 * it is copied once, straight to where booti_setup() wants it. This
+	 * is only possible if the destination leaves the image blob intact.
+	 */
+	if (IS_ENABLED(CONFIG_ARM64) && IS_ENABLED(CONFIG_CMD_BOOTI) &&
+	    os.arch == IH_ARCH_ARM64 && os.os == IH_OS_LINUX &&
+	    os.comp == IH_COMP_NONE) {
+		ulong dest, size;
+
+		if (!booti_get_dest(image_buf, load, &dest, &size, false) &&
+		    dest != load &&
+		    (dest >= blob_end ||
+		     dest + max(size, image_len) <= blob_start)) {
+			debug("   placing Image at 0x%lx instead of 0x%lx\n",
+			      dest, load);
+			load = dest;
+			images->os.load = dest;
+		}
+	}
+
+	flush_start = ALIGN_DOWN(load, ARCH_DMA_MINALIGN);
+	load_buf = map_sysmem(load, 0);
 	err = image_decomp(os.comp, load, os.image_start, os.type,
 			   load_buf, image_buf, image_len,
 			   CONFIG_SYS_BOOTM_LEN, &load_end);
@@ -644,7 +668,9 @@ static int bootm_load_os(struct bootm_headers *images, int boot_progress)
 	/* We need the decompressed image size in the next steps */
 	images->os.image_len = load_end - load;
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DCACHE, "dcache_flush");
 	flush_cache(flush_start, ALIGN(load_end, ARCH_DMA_MINALIGN) - flush_start);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DCACHE);
 
 	debug("   kernel loaded at 0x%08lx, end = 0x%08lx\n", load, load_end);
 	bootstage_mark(BOOTSTAGE_ID_KERNEL_LOADED);
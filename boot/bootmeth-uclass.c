@@ -14,6 +14,7 @@
 #include <dm.h>
 #include <env_internal.h>
 #include <fs.h>
+#include <image.h>
 #include <malloc.h>
 #include <mapmem.h>
 #include <dm/uclass-internal.h>
@@ -398,6 +399,21 @@ int bootmeth_alloc_other(struct bootflow *bflow, const char *fname,
 	return 0;
 }
 
+/* Check whether a file starts with the magic number of a compressed image */
+static bool bootmeth_file_is_comp(struct bootflow *bflow,
+				  struct blk_desc *desc, const char *file_path)
+{
+	loff_t actual;
+	u8 magic[2];
+
+	if (bootmeth_setup_fs(bflow, desc) ||
+	    fs_read(file_path, map_to_sysmem(magic), 0, sizeof(magic),
+		    &actual) || actual != sizeof(magic))
+		return false;
+
+	return image_decomp_type(magic, sizeof(magic)) > IH_COMP_NONE;
+}
+
 int bootmeth_common_read_file(struct udevice *dev, struct bootflow *bflow,
 			      const char *file_path, ulong addr,
 			      enum bootflow_img_t type, ulong *sizep)
@@ -405,6 +421,7 @@ int bootmeth_common_read_file(struct udevice *dev, struct bootflow *bflow,
 	struct blk_desc *desc = NULL;
 	loff_t len_read;
 	loff_t size;
+	bool decomp;
 	int ret;
 
 	if (bflow->blk)
@@ -420,16 +437,24 @@ int bootmeth_common_read_file(struct udevice *dev, struct bootflow *bflow,
 	if (size > *sizep)
 		return log_msg_ret("spc", -ENOSPC);
 
+	/* a compressed kernel is decompressed as it is read */
+	decomp = IS_ENABLED(CONFIG_FS_LOAD_DECOMP) &&
+		 type == (enum bootflow_img_t)IH_TYPE_KERNEL &&
+		 bootmeth_file_is_comp(bflow, desc, file_path);
+
 	ret = bootmeth_setup_fs(bflow, desc);
 	if (ret)
 		return log_msg_ret("fs", ret);
 
-	ret = fs_read(file_path, addr, 0, 0, &len_read);
+	if (decomp)
+		ret = fs_read_decomp(file_path, addr, *sizep, &len_read);
+	else
+		ret = fs_read(file_path, addr, 0, 0, &len_read);
 	if (ret)
 		return ret;
 	*sizep = len_read;
 
-	if (!bootflow_img_add(bflow, bflow->fname, type, addr, size))
+	if (!bootflow_img_add(bflow, bflow->fname, type, addr, len_read))
 		return log_msg_ret("bci", -ENOMEM);
 
 	return 0;
@@ -388,6 +388,123 @@ static int read_slotted_partition(struct blk_desc *desc, const char *const name,
 	return 0;
 }
 
+__weak bool android_vendor_ramdisk_wanted(const struct andr_vendor_ramdisk_table_entry_v4 *entry,
+					  bool recovery)
+{
+	return entry->ramdisk_type != VENDOR_RAMDISK_TYPE_RECOVERY || recovery;
+}
+
+/* Read @size bytes at byte offset @offset in @part to the same offset at @buf */
+static int read_part_range(struct blk_desc *desc, struct disk_partition *part,
+			   void *buf, ulong offset, ulong size)
+{
+	ulong start = offset / desc->blksz;
+	ulong num_blks = DIV_ROUND_UP(offset + size, desc->blksz) - start;
+
+	if (start + num_blks > part->size)
+		return log_msg_ret("range", -EINVAL);
+	if (blk_dread(desc, part->start + start, num_blks,
+		      buf + start * desc->blksz) != num_blks)
+		return log_msg_ret("part read", -EIO);
+
+	return 0;
+}
+
+/**
+ * read_vendor_boot() - Read the parts of a vendor_boot partition which are used
+ *
+ * For a v4 image, only the vendor ramdisks selected by
+ * android_vendor_ramdisk_wanted() are read. The rest of the vendor ramdisk
+ * section is filled with zeroes, which Linux skips when unpacking the ramdisk. Everything is placed
+ * at its usual offset, so the image can be parsed as normal. Older images are
+ * read in full.
+ *
+ * @desc: Block device to read
+ * @priv: Private data, giving the slot, boot mode and image size
+ * @addr: Address where the image is loaded into
+ * Return: 0 if OK, negative errno on failure.
+ */
+static int read_vendor_boot(struct blk_desc *desc, struct android_priv *priv,
+			    ulong addr)
+{
+	const struct andr_vendor_ramdisk_table_entry_v4 *entry;
+	bool recovery = priv->boot_mode == ANDROID_BOOT_MODE_RECOVERY;
+	ulong rd_off, table_off, end, page;
+	struct andr_vnd_boot_img_hdr *hdr;
+	struct disk_partition partition;
+	char partname[PART_NAME_LEN];
+	void *buf;
+	int ret;
+	u32 i;
+
+	if (priv->slot)
+		sprintf(partname, VENDOR_BOOT_PART_NAME "_%s", priv->slot);
+	else
+		sprintf(partname, VENDOR_BOOT_PART_NAME);
+	ret = part_get_info_by_name(desc, partname, &partition);
+	if (ret < 0)
+		return log_msg_ret("part", ret);
+
+	buf = map_sysmem(addr, priv->vendor_boot_img_size);
+	hdr = buf;
+	ret = read_part_range(desc, &partition, buf, 0, sizeof(*hdr));
+	if (ret)
+		return ret;
+	if (hdr->header_version < 4)
+		return read_part_range(desc, &partition, buf, 0,
+				       priv->vendor_boot_img_size);
+	page = hdr->page_size;
+	if (!page || hdr->vendor_ramdisk_table_entry_size < sizeof(*entry))
+		return log_msg_ret("hdr", -EINVAL);
+
+	/* the dtb, vendor ramdisk table and bootconfig follow the ramdisks */
+	rd_off = page;
+	table_off = rd_off + ALIGN(hdr->vendor_ramdisk_size, page) +
+		ALIGN(hdr->dtb_size, page);
+	end = table_off + ALIGN(hdr->vendor_ramdisk_table_size, page) +
+		hdr->bootconfig_size;
+	if (end > priv->vendor_boot_img_size)
+		return log_msg_ret("size", -EINVAL);
+	ret = read_part_range(desc, &partition, buf,
+			      rd_off + ALIGN(hdr->vendor_ramdisk_size, page),
+			      end - rd_off - ALIGN(hdr->vendor_ramdisk_size, page));
+	if (ret)
+		return ret;
+
+	if ((u64)hdr->vendor_ramdisk_table_entry_num *
+	    hdr->vendor_ramdisk_table_entry_size > hdr->vendor_ramdisk_table_size)
+		return log_msg_ret("table", -EINVAL);
+
+	/* anything not read is left as zeroes */
+	memset(buf + rd_off, '\0', hdr->vendor_ramdisk_size);
+	for (i = 0; i < hdr->vendor_ramdisk_table_entry_num; i++) {
+		entry = buf + table_off + i * hdr->vendor_ramdisk_table_entry_size;
+		if ((u64)entry->ramdisk_offset + entry->ramdisk_size >
+		    hdr->vendor_ramdisk_size)
+			return log_msg_ret("entry", -EINVAL);
+		if (!android_vendor_ramdisk_wanted(entry, recovery))
+			continue;
+		ret = read_part_range(desc, &partition, buf,
+				      rd_off + entry->ramdisk_offset,
+				      entry->ramdisk_size);
+		if (ret)
+			return ret;
+	}
+
+	/* reads are rounded to whole blocks, so clear unwanted ramdisks after */
+	for (i = 0; i < hdr->vendor_ramdisk_table_entry_num; i++) {
+		entry = buf + table_off + i * hdr->vendor_ramdisk_table_entry_size;
+		if (android_vendor_ramdisk_wanted(entry, recovery))
+			continue;
+		log_debug("Skipping vendor ramdisk '%.*s'\n",
+			  ANDR_VENDOR_RAMDISK_NAME_SIZE, entry->ramdisk_name);
+		memset(buf + rd_off + entry->ramdisk_offset, '\0',
+		       entry->ramdisk_size);
+	}
+
+	return 0;
+}
+
 #if CONFIG_IS_ENABLED(AVB_VERIFY)
 static int avb_append_commandline_arg(struct bootflow *bflow, char *arg)
 {
@@ -532,8 +649,7 @@ static int boot_android_normal(struct bootflow *bflow)
 		return log_msg_ret("read boot", ret);
 
 	if (priv->header_version >= 3) {
-		ret = read_slotted_partition(desc, "vendor_boot", priv->slot,
-					     priv->vendor_boot_img_size, vloadaddr);
+		ret = read_vendor_boot(desc, priv, vloadaddr);
 		if (ret < 0)
 			return log_msg_ret("read vendor_boot", ret);
 		set_avendor_bootimg_addr(vloadaddr);
@@ -111,6 +111,7 @@ int expo_set_display(struct expo *exp, struct udevice *dev)
 
 	exp->display = dev;
 	exp->cons = cons;
+	exp->drawn_scene_id = 0;
 
 	return 0;
 }
@@ -142,6 +143,7 @@ int expo_calc_dims(struct expo *exp)
 void expo_set_text_mode(struct expo *exp, bool text_mode)
 {
 	exp->text_mode = text_mode;
+	exp->drawn_scene_id = 0;
 }
 
 struct scene *expo_lookup_scene_id(struct expo *exp, uint scene_id)
@@ -196,6 +198,23 @@ int expo_render(struct expo *exp)
 
 	back = CONFIG_IS_ENABLED(SYS_WHITE_ON_BLACK) ? VID_BLACK : VID_WHITE;
 	colour = video_index_to_colour(vid_priv, back);
+
+	if (exp->scene_id && exp->scene_id == exp->drawn_scene_id &&
+	    !exp->text_mode) {
+		scn = expo_lookup_scene_id(exp, exp->scene_id);
+		if (!scn)
+			return log_msg_ret("scn", -ENOENT);
+
+		ret = scene_render_update(scn, colour);
+		if (!ret) {
+			video_sync(dev, true);
+			return 0;
+		}
+		if (ret != -E2BIG)
+			return log_msg_ret("upd", ret);
+	}
+
+	exp->drawn_scene_id = 0;
 	ret = video_fill(dev, colour);
 	if (ret)
 		return log_msg_ret("fill", ret);
@@ -208,6 +227,8 @@ int expo_render(struct expo *exp)
 		ret = scene_render(scn);
 		if (ret)
 			return log_msg_ret("ren", ret);
+		if (!exp->text_mode)
+			exp->drawn_scene_id = exp->scene_id;
 	}
 
 	video_sync(dev, true);
@@ -215,6 +236,13 @@ int expo_render(struct expo *exp)
 	return scn ? 0 : -ECHILD;
 }
 
+int expo_redraw(struct expo *exp)
+{
+	exp->drawn_scene_id = 0;
+
+	return expo_render(exp);
+}
+
 int expo_send_key(struct expo *exp, int key)
 {
 	struct scene *scn = NULL;
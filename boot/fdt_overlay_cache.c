@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Cache of device trees with overlays applied
+ *
+ * Applying overlays to a large base tree is slow, and normally gives the
+ * same result on every boot. The merged tree is stored in a file together
+ * with the SHA-256 of the base tree and the overlays, in order. When the
+ * digest matches on a later boot, the merged tree is loaded instead of
+ * applying the overlays again.
+ *
+ * The location is given by the 'fdtoverlay_cache' environment variable as
+ * "<interface> <dev[:part]> <file>", for example "mmc 0:1 /dtb.cache".
+ */
+
+#define LOG_CATEGORY	LOGC_BOOT
+
+#include <env.h>
+#include <errno.h>
+#include <fdt_support.h>
+#include <fs.h>
+#include <log.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <linux/libfdt.h>
+#include <linux/string.h>
+
+#define FDT_OVERLAY_CACHE_MAGIC		"FDTOVLC1"
+
+/**
+ * struct fdt_overlay_cache_hdr - header of the cache file
+ *
+ * The merged tree follows the header.
+ *
+ * @magic: FDT_OVERLAY_CACHE_MAGIC
+ * @digest: SHA-256 of the base tree followed by the overlays
+ * @size: Size of the merged tree in bytes
+ * @reserved: Zero
+ */
+struct fdt_overlay_cache_hdr {
+	char magic[8];
+	u8 digest[SHA256_SUM_LEN];
+	__le32 size;
+	__le32 reserved;
+};
+
+void fdt_overlay_cache_start(struct fdt_overlay_cache *cache,
+			     const void *base)
+{
+	sha256_starts(&cache->ctx);
+	sha256_update(&cache->ctx, base, fdt_totalsize(base));
+	cache->count = 0;
+	cache->done = false;
+}
+
+void fdt_overlay_cache_add(struct fdt_overlay_cache *cache,
+			   const void *overlay)
+{
+	sha256_update(&cache->ctx, overlay, fdt_totalsize(overlay));
+	cache->count++;
+}
+
+/**
+ * fdt_overlay_cache_file() - select the device holding the cache file
+ *
+ * @buf: Buffer for a copy of the environment variable
+ * @size: Size of @buf
+ * Return: file name, or NULL if no cache is set up or the device is not
+ * available
+ */
+static const char *fdt_overlay_cache_file(char *buf, int size)
+{
+	const char *var = env_get("fdtoverlay_cache");
+	char *ifname, *devpart, *fname, *p = buf;
+
+	if (!var)
+		return NULL;
+	strlcpy(buf, var, size);
+	ifname = strsep(&p, " ");
+	devpart = strsep(&p, " ");
+	fname = strsep(&p, " ");
+	if (!ifname || !devpart || !fname || !*fname) {
+		log_warning("Invalid fdtoverlay_cache '%s'\n", var);
+		return NULL;
+	}
+	if (fs_set_blk_dev(ifname, devpart, FS_TYPE_ANY)) {
+		log_debug("Cannot access %s %s\n", ifname, devpart);
+		return NULL;
+	}
+
+	return fname;
+}
+
+/**
+ * fdt_overlay_cache_digest() - finish the digest of the inputs
+ *
+ * @cache: Cache context
+ * Return: digest
+ */
+static const u8 *fdt_overlay_cache_digest(struct fdt_overlay_cache *cache)
+{
+	if (!cache->done) {
+		sha256_finish(&cache->ctx, cache->digest);
+		cache->done = true;
+	}
+
+	return cache->digest;
+}
+
+int fdt_overlay_cache_load(struct fdt_overlay_cache *cache, void *base,
+			   ulong size)
+{
+	struct fdt_overlay_cache_hdr hdr;
+	const char *fname;
+	char buf[128];
+	loff_t actual;
+	u32 len;
+	int ret;
+
+	if (!cache->count)
+		return -ENOENT;
+	fname = fdt_overlay_cache_file(buf, sizeof(buf));
+	if (!fname)
+		return -ENOENT;
+
+	ret = fs_read(fname, map_to_sysmem(&hdr), 0, sizeof(hdr), &actual);
+	if (ret || actual != sizeof(hdr))
+		return -ENOENT;
+	len = le32_to_cpu(hdr.size);
+	if (memcmp(hdr.magic, FDT_OVERLAY_CACHE_MAGIC, sizeof(hdr.magic)) ||
+	    memcmp(hdr.digest, fdt_overlay_cache_digest(cache),
+		   SHA256_SUM_LEN)) {
+		log_debug("Overlay cache %s is stale\n", fname);
+		return -ENOENT;
+	}
+	if (len > size) {
+		log_debug("Merged tree too large (%x > %lx)\n", len, size);
+		return -ENOENT;
+	}
+
+	/* fs_read() closes the device, so select it again */
+	fname = fdt_overlay_cache_file(buf, sizeof(buf));
+	if (!fname)
+		return -ENOENT;
+	ret = fs_read(fname, map_to_sysmem(base), sizeof(hdr), len, &actual);
+	if (ret || actual != len || fdt_check_header(base) ||
+	    fdt_totalsize(base) > len) {
+		/* The base tree was overwritten, so this cannot fall back */
+		log_err("Failed to read overlay cache %s\n", fname);
+		return -EIO;
+	}
+	log_info("Using overlay cache %s\n", fname);
+
+	return 0;
+}
+
+int fdt_overlay_cache_store(struct fdt_overlay_cache *cache,
+			    const void *merged)
+{
+	struct fdt_overlay_cache_hdr *hdr;
+	u32 len = fdt_totalsize(merged);
+	const char *fname;
+	char buf[128];
+	loff_t actual;
+	int ret;
+
+	if (!cache->count)
+		return 0;
+	fname = fdt_overlay_cache_file(buf, sizeof(buf));
+	if (!fname)
+		return 0;
+
+	hdr = malloc(sizeof(*hdr) + len);
+	if (!hdr)
+		return -ENOMEM;
+	memcpy(hdr->magic, FDT_OVERLAY_CACHE_MAGIC, sizeof(hdr->magic));
+	memcpy(hdr->digest, fdt_overlay_cache_digest(cache), SHA256_SUM_LEN);
+	hdr->size = cpu_to_le32(len);
+	hdr->reserved = 0;
+	memcpy(hdr + 1, merged, len);
+
+	ret = fs_write(fname, map_to_sysmem(hdr), 0, sizeof(*hdr) + len,
+		       &actual);
+	free(hdr);
+	if (ret) {
+		log_warning("Failed to write overlay cache %s: %d\n", fname,
+			    ret);
+		return ret;
+	}
+
+	return 0;
+}
@@ -40,6 +40,10 @@ static int fdt_simplefb_configure_node(void *blob, int off)
 		fb_base = ho->fb;
 	} else {
 		ret = uclass_first_device_err(UCLASS_VIDEO, &dev);
+		if (ret)
+			return ret;
+		/* the OS expects the display to start at the base */
+		ret = video_pan_disable(dev);
 		if (ret)
 			return ret;
 		uc_priv = dev_get_uclass_priv(dev);
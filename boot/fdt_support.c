@@ -13,6 +13,7 @@
 #include <mapmem.h>
 #include <net.h>
 #include <rng.h>
+#include <sort.h>
 #include <stdio_dev.h>
 #include <dm/device_compat.h>
 #include <dm/ofnode.h>
@@ -610,6 +611,328 @@ int fdt_fixup_memory(void *blob, u64 start, u64 size)
 	return fdt_fixup_memory_banks(blob, &start, &size, 1);
 }
 
+/**
+ * struct fdt_batch_prop - a property change held in a batch
+ *
+ * @node: Offset of the node holding the property
+ * @seq: Position in the batch, to keep changes to a node in order
+ * @name: Property name, stored after this struct
+ * @val: Property value, stored after @name
+ * @len: Length of @val in bytes
+ * @nameoff: Offset of @name in the strings block of the new tree
+ * @done: true once written to the new tree
+ */
+struct fdt_batch_prop {
+	int node;
+	int seq;
+	const char *name;
+	void *val;
+	int len;
+	int nameoff;
+	bool done;
+};
+
+void fdt_batch_init(struct fdt_batch *batch)
+{
+	memset(batch, '\0', sizeof(*batch));
+}
+
+static void fdt_batch_free(struct fdt_batch *batch)
+{
+	int i;
+
+	for (i = 0; i < batch->count; i++)
+		free((void *)batch->props[i].name);
+	free(batch->props);
+	fdt_batch_init(batch);
+}
+
+int fdt_batch_setprop(struct fdt_batch *batch, int nodeoffset,
+		      const char *name, const void *val, int len)
+{
+	struct fdt_batch_prop *prop;
+	int namelen = strlen(name) + 1;
+	char *buf;
+	int i;
+
+	buf = malloc(namelen + len);
+	if (!buf)
+		return -FDT_ERR_NOSPACE;
+	memcpy(buf, name, namelen);
+	memcpy(buf + namelen, val, len);
+
+	for (i = 0; i < batch->count; i++) {
+		prop = &batch->props[i];
+		if (prop->node == nodeoffset && !strcmp(prop->name, name)) {
+			free((void *)prop->name);
+			goto set;
+		}
+	}
+	if (batch->count == batch->size) {
+		int size = batch->size ? batch->size * 2 : 8;
+
+		prop = realloc(batch->props, size * sizeof(*prop));
+		if (!prop) {
+			free(buf);
+			return -FDT_ERR_NOSPACE;
+		}
+		batch->props = prop;
+		batch->size = size;
+	}
+	prop = &batch->props[batch->count];
+	prop->node = nodeoffset;
+	prop->seq = batch->count++;
+set:
+	prop->name = buf;
+	prop->val = buf + namelen;
+	prop->len = len;
+	prop->done = false;
+
+	return 0;
+}
+
+static int fdt_batch_cmp(const void *a, const void *b)
+{
+	const struct fdt_batch_prop *pa = a, *pb = b;
+
+	if (pa->node != pb->node)
+		return pa->node < pb->node ? -1 : 1;
+
+	return pa->seq - pb->seq;
+}
+
+/**
+ * fdt_batch_find_string() - find a name in the strings block
+ *
+ * @fdt: Tree to search
+ * @name: Name to find
+ * Return: offset of @name in the strings block, or -1 if not there
+ */
+static int fdt_batch_find_string(const void *fdt, const char *name)
+{
+	const char *strtab = fdt + fdt_off_dt_strings(fdt);
+	int size = fdt_size_dt_strings(fdt);
+	int len = strlen(name) + 1;
+	const char *p;
+
+	/* Like libfdt, allow a match at the end of a longer string */
+	for (p = strtab; p + len <= strtab + size; p++) {
+		if (!memcmp(p, name, len))
+			return p - strtab;
+	}
+
+	return -1;
+}
+
+/**
+ * fdt_batch_put_prop() - write a property to the new structure block
+ *
+ * @wp: Write pointer, updated
+ * @end: End of the space for the structure block
+ * @nameoff: Offset of the property name in the strings block
+ * @val: Property value
+ * @len: Length of @val in bytes
+ * Return: 0 if OK, -FDT_ERR_NOSPACE if there is no room
+ */
+static int fdt_batch_put_prop(char **wp, const char *end, int nameoff,
+			      const void *val, int len)
+{
+	struct fdt_property *prop = (struct fdt_property *)*wp;
+	int size = sizeof(*prop) + ALIGN(len, FDT_TAGSIZE);
+
+	if (*wp + size > end)
+		return -FDT_ERR_NOSPACE;
+	prop->tag = cpu_to_fdt32(FDT_PROP);
+	prop->len = cpu_to_fdt32(len);
+	prop->nameoff = cpu_to_fdt32(nameoff);
+	memcpy(prop->data, val, len);
+	memset(prop->data + len, '\0', ALIGN(len, FDT_TAGSIZE) - len);
+	*wp += size;
+
+	return 0;
+}
+
+/**
+ * fdt_batch_rewrite() - copy a tree once, making the changes in a batch
+ *
+ * The new tree is built in a separate buffer and only copied over @fdt
+ * once complete, so @fdt is unchanged on error. NOP tags are dropped.
+ *
+ * @fdt: Tree to change
+ * @batch: Changes, sorted by fdt_batch_cmp()
+ * Return: 0 if OK, -FDT_ERR_... on error
+ */
+static int fdt_batch_rewrite(void *fdt, struct fdt_batch *batch)
+{
+	int off_struct = fdt_off_dt_struct(fdt);
+	int off_strings = fdt_off_dt_strings(fdt);
+	int size_strings = fdt_size_dt_strings(fdt);
+	int bufsize = fdt_totalsize(fdt);
+	int pending = -1, first = 0, last = 0, cur = 0;
+	int offset, next, extra = 0, ret = 0, i;
+	char *out, *wp, *end;
+	uint32_t tag;
+
+	if (fdt_version(fdt) < 17 ||
+	    fdt_off_mem_rsvmap(fdt) > off_struct ||
+	    off_struct + fdt_size_dt_struct(fdt) > off_strings)
+		return -FDT_ERR_BADLAYOUT;
+
+	/* Names not in the strings block are appended to it */
+	for (i = 0; i < batch->count; i++) {
+		struct fdt_batch_prop *prop = &batch->props[i];
+
+		prop->nameoff = fdt_batch_find_string(fdt, prop->name);
+		if (prop->nameoff < 0) {
+			prop->nameoff = size_strings + extra;
+			extra += strlen(prop->name) + 1;
+		}
+	}
+
+	out = malloc(bufsize);
+	if (!out)
+		return -FDT_ERR_NOSPACE;
+	memcpy(out, fdt, off_struct);
+	wp = out + off_struct;
+	end = out + bufsize - size_strings - extra;
+
+	for (offset = 0; !ret; offset = next) {
+		const struct fdt_property *prop;
+		int len;
+
+		tag = fdt_next_tag(fdt, offset, &next);
+		if (tag == FDT_BEGIN_NODE || tag == FDT_END_NODE) {
+			/* Additions go after the existing properties */
+			for (i = first; pending >= 0 && i < last; i++) {
+				struct fdt_batch_prop *bp = &batch->props[i];
+
+				if (bp->done)
+					continue;
+				ret = fdt_batch_put_prop(&wp, end, bp->nameoff,
+							 bp->val, bp->len);
+				if (ret)
+					break;
+				bp->done = true;
+			}
+			pending = -1;
+			if (ret)
+				break;
+		}
+
+		switch (tag) {
+		case FDT_BEGIN_NODE:
+			while (cur < batch->count &&
+			       batch->props[cur].node < offset)
+				cur++;
+			first = cur;
+			while (cur < batch->count &&
+			       batch->props[cur].node == offset)
+				cur++;
+			last = cur;
+			pending = offset;
+			break;
+		case FDT_PROP:
+			prop = fdt_get_property_by_offset(fdt, offset, NULL);
+			if (!prop) {
+				ret = -FDT_ERR_BADSTRUCTURE;
+				continue;
+			}
+			for (i = first; pending >= 0 && i < last; i++) {
+				struct fdt_batch_prop *bp = &batch->props[i];
+				const char *name;
+
+				name = fdt_string(fdt,
+						  fdt32_to_cpu(prop->nameoff));
+				if (!bp->done && name &&
+				    !strcmp(name, bp->name))
+					break;
+			}
+			if (pending >= 0 && i < last) {
+				struct fdt_batch_prop *bp = &batch->props[i];
+
+				ret = fdt_batch_put_prop(&wp, end,
+						fdt32_to_cpu(prop->nameoff),
+						bp->val, bp->len);
+				bp->done = true;
+				continue;
+			}
+			break;
+		case FDT_NOP:
+			continue;
+		case FDT_END_NODE:
+		case FDT_END:
+			break;
+		default:
+			ret = next < 0 ? next : -FDT_ERR_BADSTRUCTURE;
+			continue;
+		}
+
+		len = next - offset;
+		if (wp + len > end) {
+			ret = -FDT_ERR_NOSPACE;
+			continue;
+		}
+		memcpy(wp, fdt_offset_ptr(fdt, offset, len), len);
+		wp += len;
+		if (tag == FDT_END)
+			break;
+	}
+
+	/* A change for an offset which is not a node was not written */
+	for (i = 0; !ret && i < batch->count; i++) {
+		if (!batch->props[i].done)
+			ret = -FDT_ERR_BADOFFSET;
+	}
+	if (!ret) {
+		struct fdt_header *hdr = (struct fdt_header *)out;
+		char *strtab = wp;
+
+		memcpy(strtab, fdt + off_strings, size_strings);
+		for (i = 0; i < batch->count; i++) {
+			struct fdt_batch_prop *bp = &batch->props[i];
+
+			if (bp->nameoff >= size_strings)
+				strcpy(strtab + bp->nameoff, bp->name);
+		}
+		fdt_set_size_dt_struct(hdr, wp - out - off_struct);
+		fdt_set_off_dt_strings(hdr, wp - out);
+		fdt_set_size_dt_strings(hdr, size_strings + extra);
+		memcpy(fdt, out, wp - out + size_strings + extra);
+	}
+	free(out);
+
+	return ret;
+}
+
+int fdt_batch_apply(void *fdt, struct fdt_batch *batch)
+{
+	int ret, i;
+
+	if (!batch->count)
+		return 0;
+
+	qsort(batch->props, batch->count, sizeof(batch->props[0]),
+	      fdt_batch_cmp);
+	ret = fdt_batch_rewrite(fdt, batch);
+	if (ret) {
+		/*
+		 * Nodes after a changed property move, so go from the end
+		 * of the tree to keep the recorded offsets valid
+		 */
+		log_debug("Rewrite failed (%s), changing one at a time\n",
+			  fdt_strerror(ret));
+		for (ret = 0, i = batch->count - 1; !ret && i >= 0; i--) {
+			struct fdt_batch_prop *bp = &batch->props[i];
+
+			ret = fdt_setprop(fdt, bp->node, bp->name, bp->val,
+					  bp->len);
+		}
+	}
+	fdt_batch_free(batch);
+
+	return ret;
+}
+
 void fdt_fixup_ethernet(void *fdt)
 {
 	int i = 0, j, prop;
@@ -617,30 +940,22 @@ void fdt_fixup_ethernet(void *fdt)
 	char mac[16];
 	const char *path;
 	unsigned char mac_addr[ARP_HLEN];
-	int offset;
+	struct fdt_batch batch;
+	int aliases, nodeoff, ret;
 #ifdef FDT_SEQ_MACADDR_FROM_ENV
-	int nodeoff;
 	const struct fdt_property *fdt_prop;
 #endif
 
-	if (fdt_path_offset(fdt, "/aliases") < 0)
+	aliases = fdt_path_offset(fdt, "/aliases");
+	if (aliases < 0)
 		return;
 
-	/* Cycle through all aliases */
-	for (prop = 0; ; prop++) {
+	/* The tree is only changed at the end, so offsets stay valid */
+	fdt_batch_init(&batch);
+	fdt_for_each_property_offset(prop, fdt, aliases) {
 		const char *name;
 
-		/* FDT might have been edited, recompute the offset */
-		offset = fdt_first_property_offset(fdt,
-			fdt_path_offset(fdt, "/aliases"));
-		/* Select property number 'prop' */
-		for (j = 0; j < prop; j++)
-			offset = fdt_next_property_offset(fdt, offset);
-
-		if (offset < 0)
-			break;
-
-		path = fdt_getprop_by_offset(fdt, offset, &name, NULL);
+		path = fdt_getprop_by_offset(fdt, prop, &name, NULL);
 		if (!strncmp(name, "ethernet", 8)) {
 			/* Treat plain "ethernet" same as "ethernet0". */
 			if (!strcmp(name, "ethernet")
@@ -661,8 +976,8 @@ void fdt_fixup_ethernet(void *fdt)
 			} else {
 				continue;
 			}
-#ifdef FDT_SEQ_MACADDR_FROM_ENV
 			nodeoff = fdt_path_offset(fdt, path);
+#ifdef FDT_SEQ_MACADDR_FROM_ENV
 			fdt_prop = fdt_get_property(fdt, nodeoff, "status",
 						    NULL);
 			if (fdt_prop && !strcmp(fdt_prop->data, "disabled"))
@@ -680,12 +995,32 @@ void fdt_fixup_ethernet(void *fdt)
 					tmp = (*end) ? end + 1 : end;
 			}
 
-			do_fixup_by_path(fdt, path, "mac-address",
-					 &mac_addr, 6, 0);
-			do_fixup_by_path(fdt, path, "local-mac-address",
-					 &mac_addr, 6, 1);
+			if (nodeoff < 0) {
+				printf("Unable to update property %s:%s, err=%s\n",
+				       path, "local-mac-address",
+				       fdt_strerror(nodeoff));
+				continue;
+			}
+			ret = 0;
+			if (fdt_get_property(fdt, nodeoff, "mac-address", NULL))
+				ret = fdt_batch_setprop(&batch, nodeoff,
+							"mac-address",
+							mac_addr, 6);
+			if (!ret)
+				ret = fdt_batch_setprop(&batch, nodeoff,
+							"local-mac-address",
+							mac_addr, 6);
+			if (ret)
+				printf("Unable to update property %s:%s, err=%s\n",
+				       path, "local-mac-address",
+				       fdt_strerror(ret));
 		}
 	}
+
+	ret = fdt_batch_apply(fdt, &batch);
+	if (ret)
+		printf("Unable to update MAC addresses, err=%s\n",
+		       fdt_strerror(ret));
 }
 
 int fdt_record_loadable(void *blob, u32 index, const char *name,
@@ -12,6 +12,7 @@
 #include <bootstage.h>
 #include <cpu_func.h>
 #include <display_options.h>
+#include <dma.h>
 #include <env.h>
 #include <fpga.h>
 #include <image.h>
@@ -166,6 +167,10 @@ void memmove_wd(void *to, void *from, size_t len, ulong chunksz)
 	if (to == from)
 		return;
 
+	/* a DMA copy does not keep the CPU busy, so needs no chunks */
+	if (!dma_memcpy_offload(to, from, len))
+		return;
+
 	if (IS_ENABLED(CONFIG_HW_WATCHDOG) || IS_ENABLED(CONFIG_WATCHDOG)) {
 		if (to > from) {
 			from += len;
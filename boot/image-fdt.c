@@ -18,8 +18,10 @@
 #include <log.h>
 #include <malloc.h>
 #include <asm/global_data.h>
+#include <bootstage.h>
 #include <linux/libfdt.h>
 #include <mapmem.h>
+#include <time.h>
 #include <asm/io.h>
 #include <dm/ofnode.h>
 #include <tee/optee.h>
@@ -566,12 +568,31 @@ __weak int arch_fixup_fdt(void *blob)
 	return 0;
 }
 
+/**
+ * fdt_fixup_done() - record the time taken by one source of fixups
+ *
+ * @name: Name of the bootstage record
+ * @start: timer_get_us() when the fixup started, updated to now
+ */
+static void fdt_fixup_done(const char *name, u64 *start)
+{
+	if (IS_ENABLED(CONFIG_BOOTSTAGE_FDT_FIXUPS)) {
+		u64 now = timer_get_us();
+
+		bootstage_add_accum(name, now - *start);
+		*start = now;
+	}
+}
+
 int image_setup_libfdt(struct bootm_headers *images, void *blob, bool lmb)
 {
 	ulong *initrd_start = &images->initrd_start;
 	ulong *initrd_end = &images->initrd_end;
 	int ret, fdt_ret, of_size;
+	u64 start = 0;
 
+	if (IS_ENABLED(CONFIG_BOOTSTAGE_FDT_FIXUPS))
+		start = timer_get_us();
 	if (IS_ENABLED(CONFIG_OF_ENV_SETUP)) {
 		const char *fdt_fixup;
 
@@ -583,6 +604,7 @@ int image_setup_libfdt(struct bootm_headers *images, void *blob, bool lmb)
 				printf("WARNING: fdt_fixup command returned %d\n",
 				       ret);
 		}
+		fdt_fixup_done("ft_env", &start);
 	}
 
 	ret = -EPERM;
@@ -595,10 +617,12 @@ int image_setup_libfdt(struct bootm_headers *images, void *blob, bool lmb)
 		printf("ERROR: /chosen node create failed\n");
 		goto err;
 	}
+	fdt_fixup_done("ft_chosen", &start);
 	if (arch_fixup_fdt(blob) < 0) {
 		printf("ERROR: arch-specific fdt fixup failed\n");
 		goto err;
 	}
+	fdt_fixup_done("ft_arch", &start);
 
 	fdt_ret = optee_copy_fdt_nodes(blob);
 	if (fdt_ret) {
@@ -606,6 +630,7 @@ int image_setup_libfdt(struct bootm_headers *images, void *blob, bool lmb)
 		       fdt_strerror(fdt_ret));
 		goto err;
 	}
+	fdt_fixup_done("ft_optee", &start);
 
 	/* Store name of configuration node as u-boot,bootconf in /chosen node */
 	if (images->fit_uname_cfg)
@@ -619,6 +644,7 @@ int image_setup_libfdt(struct bootm_headers *images, void *blob, bool lmb)
 	/* Append PStore configuration */
 	fdt_fixup_pstore(blob);
 #endif
+	fdt_fixup_done("ft_ethernet", &start);
 	if (IS_ENABLED(CONFIG_OF_BOARD_SETUP)) {
 		const char *skip_board_fixup;
 
@@ -633,6 +659,7 @@ int image_setup_libfdt(struct bootm_headers *images, void *blob, bool lmb)
 				goto err;
 			}
 		}
+		fdt_fixup_done("ft_board", &start);
 	}
 	if (IS_ENABLED(CONFIG_OF_SYSTEM_SETUP)) {
 		fdt_ret = ft_system_setup(blob, gd->bd);
@@ -641,10 +668,12 @@ int image_setup_libfdt(struct bootm_headers *images, void *blob, bool lmb)
 			       fdt_strerror(fdt_ret));
 			goto err;
 		}
+		fdt_fixup_done("ft_system", &start);
 	}
 
 	if (fdt_initrd(blob, *initrd_start, *initrd_end))
 		goto err;
+	fdt_fixup_done("ft_initrd", &start);
 
 	if (!ft_verify_fdt(blob))
 		goto err;
@@ -663,6 +692,7 @@ int image_setup_libfdt(struct bootm_headers *images, void *blob, bool lmb)
 				goto err;
 			}
 		}
+		fdt_fixup_done("ft_event", &start);
 	}
 
 	/* Delete the old LMB reservation */
@@ -7,6 +7,7 @@
 #include "mkimage.h"
 #include <time.h>
 #else
+#include <fdtdec.h>
 #include <log.h>
 #include <malloc.h>
 #include <asm/global_data.h>
@@ -18,6 +19,26 @@ DECLARE_GLOBAL_DATA_PTR;
 #include <u-boot/hash-checksum.h>
 
 #define IMAGE_MAX_HASHED_NODES		100
+#define FIT_SIG_CACHE_SIZE		4
+
+/**
+ * fit_key_node() - find the node holding the public keys
+ *
+ * In U-Boot this uses the node index of OF_LIBFDT_INDEX, if enabled, since
+ * the node is usually the last child of the root of the control FDT and is
+ * looked up for every image and configuration that is checked.
+ *
+ * @key_blob: FDT containing the public keys
+ * Return: node offset, or -ve FDT_ERR_... on error
+ */
+static int fit_key_node(const void *key_blob)
+{
+#ifdef USE_HOSTCC
+	return fdt_subnode_offset(key_blob, 0, FIT_SIG_NODENAME);
+#else
+	return fdtdec_path_offset(key_blob, "/" FIT_SIG_NODENAME);
+#endif
+}
 
 /**
  * fit_region_make_list() - Make a list of image regions
@@ -193,7 +214,7 @@ int fit_image_verify_required_sigs(const void *fit, int image_noffset,
 
 	/* Work out what we need to verify */
 	*no_sigsp = 1;
-	key_node = fdt_subnode_offset(key_blob, 0, FIT_SIG_NODENAME);
+	key_node = fit_key_node(key_blob);
 	if (key_node < 0) {
 		debug("%s: No signature node found: %s\n", __func__,
 		      fdt_strerror(key_node));
@@ -224,6 +245,107 @@ int fit_image_verify_required_sigs(const void *fit, int image_noffset,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(FIT_SIGNATURE_CACHE) && !defined(USE_HOSTCC)
+/**
+ * struct fit_sig_cache_ent - a configuration signature which has verified
+ *
+ * @fit: FIT holding the signature
+ * @size: Total size of the FIT
+ * @noffset: Offset of the signature node
+ * @key_blob: Blob holding the key which was used
+ * @required_keynode: Offset of that key in @key_blob, or -1 for any key
+ * @digest: Hash of the signed regions, the FIT header and the signature
+ */
+struct fit_sig_cache_ent {
+	const void *fit;
+	uint size;
+	int noffset;
+	const void *key_blob;
+	int required_keynode;
+	uint8_t digest[FIT_MAX_HASH_LEN];
+};
+
+static struct fit_sig_cache_ent fit_sig_cache[FIT_SIG_CACHE_SIZE];
+static uint fit_sig_cache_next;
+
+static int fit_sig_cache_digest(const struct image_sign_info *info,
+				const struct image_region region[], int count,
+				const uint8_t *sig, int sig_len,
+				uint8_t *digest)
+{
+	struct image_region guard[count + 2];
+
+	memcpy(guard, region, count * sizeof(*region));
+	guard[count].data = info->fit;
+	guard[count].size = sizeof(struct fdt_header);
+	guard[count + 1].data = sig;
+	guard[count + 1].size = sig_len;
+
+	return info->checksum->calculate(info->checksum->name, guard,
+					 count + 2, digest);
+}
+
+/**
+ * fit_sig_verify() - Verify a configuration signature, unless already done
+ *
+ * @info: Signature information, from fit_image_setup_verify()
+ * @region: Signed regions
+ * @count: Number of regions
+ * @sig: Signature value
+ * @sig_len: Length of @sig in bytes
+ * Return: 0 if the signature verified, now or earlier, else -ve error
+ */
+static int fit_sig_verify(struct image_sign_info *info,
+			  const struct image_region region[], int count,
+			  uint8_t *sig, int sig_len)
+{
+	uint8_t digest[FIT_MAX_HASH_LEN];
+	struct fit_sig_cache_ent *ent;
+	uint size = fdt_totalsize(info->fit);
+	bool usable;
+	int i, ret;
+
+	/* the BSS is not available before relocation */
+	usable = (gd->flags & GD_FLG_RELOC) &&
+		 info->checksum->checksum_len <= FIT_MAX_HASH_LEN &&
+		 !fit_sig_cache_digest(info, region, count, sig, sig_len,
+				       digest);
+	for (i = 0; usable && i < FIT_SIG_CACHE_SIZE; i++) {
+		ent = &fit_sig_cache[i];
+		if (ent->fit == info->fit && ent->size == size &&
+		    ent->noffset == info->node_offset &&
+		    ent->key_blob == info->fdt_blob &&
+		    ent->required_keynode == info->required_keynode &&
+		    !memcmp(ent->digest, digest,
+			    info->checksum->checksum_len)) {
+			log_debug("Signature already verified\n");
+			return 0;
+		}
+	}
+
+	ret = info->crypto->verify(info, region, count, sig, sig_len);
+	if (ret || !usable)
+		return ret;
+
+	ent = &fit_sig_cache[fit_sig_cache_next++ % FIT_SIG_CACHE_SIZE];
+	ent->fit = info->fit;
+	ent->size = size;
+	ent->noffset = info->node_offset;
+	ent->key_blob = info->fdt_blob;
+	ent->required_keynode = info->required_keynode;
+	memcpy(ent->digest, digest, info->checksum->checksum_len);
+
+	return 0;
+}
+#else
+static int fit_sig_verify(struct image_sign_info *info,
+			  const struct image_region region[], int count,
+			  uint8_t *sig, int sig_len)
+{
+	return info->crypto->verify(info, region, count, sig, sig_len);
+}
+#endif
+
 /**
  * fit_config_check_sig() - Check the signature of a config
  *
@@ -375,8 +497,7 @@ static int fit_config_check_sig(const void *fit, int noffset, int conf_noffset,
 	struct image_region region[count];
 
 	fit_region_make_list(fit, fdt_regions, count, region);
-	if (info.crypto->verify(&info, region, count, fit_value,
-				fit_value_len)) {
+	if (fit_sig_verify(&info, region, count, fit_value, fit_value_len)) {
 		*err_msgp = "Verification failed";
 		return -1;
 	}
@@ -487,7 +608,7 @@ static int fit_config_verify_required_keys(const void *fit, int conf_noffset,
 	}
 
 	/* Work out what we need to verify */
-	key_node = fdt_subnode_offset(key_blob, 0, FIT_SIG_NODENAME);
+	key_node = fit_key_node(key_blob);
 	if (key_node < 0) {
 		debug("%s: No signature node found: %s\n", __func__,
 		      fdt_strerror(key_node));
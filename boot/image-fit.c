@@ -19,12 +19,14 @@
 #else
 #include <linux/compiler.h>
 #include <linux/sizes.h>
+#include <env.h>
 #include <errno.h>
 #include <log.h>
 #include <mapmem.h>
 #include <asm/io.h>
 #include <malloc.h>
 #include <memalign.h>
+#include <fdtdec.h>
 #include <asm/global_data.h>
 #ifdef CONFIG_DM_HASH
 #include <dm.h>
@@ -42,6 +44,53 @@ DECLARE_GLOBAL_DATA_PTR;
 /*****************************************************************************/
 /* New uImage format routines */
 /*****************************************************************************/
+
+/**
+ * fit_path_offset() - find a node of a FIT by its full path
+ *
+ * In U-Boot this uses the node index of OF_LIBFDT_INDEX, if enabled.
+ *
+ * @fit: Pointer to the FIT
+ * @path: Path of the node
+ * Return: node offset, or -ve FDT_ERR_... on error
+ */
+static int fit_path_offset(const void *fit, const char *path)
+{
+#ifdef USE_HOSTCC
+	return fdt_path_offset(fit, path);
+#else
+	return fdtdec_path_offset(fit, path);
+#endif
+}
+
+/**
+ * fit_subnode_offset() - find a child of a FIT node by name
+ *
+ * This gives the same result as fdt_subnode_offset(), but looks up the full
+ * path in the node index if there is one. FITs with many configurations
+ * repeat such lookups for every configuration.
+ *
+ * @fit: Pointer to the FIT
+ * @parent: Offset of the parent node
+ * @parent_path: Full path of the parent node
+ * @name: Name of the child
+ * Return: node offset, or -ve FDT_ERR_... on error
+ */
+static int fit_subnode_offset(const void *fit, int parent,
+			      const char *parent_path, const char *name)
+{
+#if !defined(USE_HOSTCC) && CONFIG_IS_ENABLED(OF_LIBFDT_INDEX)
+	char path[128];
+
+	/* The path must name exactly this child */
+	if (*name && !strchr(name, '/') &&
+	    snprintf(path, sizeof(path), "%s/%s", parent_path, name) <
+	    sizeof(path))
+		return fdtdec_path_offset(fit, path);
+#endif
+
+	return fdt_subnode_offset(fit, parent, name);
+}
 #ifndef USE_HOSTCC
 static int fit_parse_spec(const char *spec, char sepc, ulong addr_curr,
 		ulong *addr, const char **name)
@@ -655,14 +704,15 @@ int fit_image_get_node(const void *fit, const char *image_uname)
 {
 	int noffset, images_noffset;
 
-	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	images_noffset = fit_path_offset(fit, FIT_IMAGES_PATH);
 	if (images_noffset < 0) {
 		debug("Can't find images parent node '%s' (%s)\n",
 		      FIT_IMAGES_PATH, fdt_strerror(images_noffset));
 		return images_noffset;
 	}
 
-	noffset = fdt_subnode_offset(fit, images_noffset, image_uname);
+	noffset = fit_subnode_offset(fit, images_noffset, FIT_IMAGES_PATH,
+				     image_uname);
 	if (noffset < 0) {
 		debug("Can't get node offset for image unit name: '%s' (%s)\n",
 		      image_uname, fdt_strerror(noffset));
@@ -1030,6 +1080,113 @@ int fit_image_get_data_size_unciphered(const void *fit, int noffset,
 	return 0;
 }
 
+ulong fit_get_data_align(const void *fit)
+{
+	const fdt32_t *val;
+	int images;
+	ulong align;
+
+	images = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	val = images < 0 ? NULL : fdt_getprop(fit, images, FIT_DATA_ALIGN_PROP,
+					      NULL);
+	if (!val)
+		return 4;
+	align = fdt32_to_cpu(*val);
+	if (align < 4 || (align & (align - 1)))
+		return 4;
+
+	return align;
+}
+
+#if CONFIG_IS_ENABLED(FIT_EXTERNAL_READ) && !defined(USE_HOSTCC)
+enum {
+	FIT_EXT_EXTENTS	= 16,
+};
+
+/**
+ * struct fit_ext_state - external data source of a FIT
+ *
+ * @fit: FIT header in memory
+ * @crc: CRC32 of the FIT header when the source was set
+ * @src: Source of the external data
+ * @count: Number of entries in @pos and @size
+ * @pos: Position of each extent read so far
+ * @size: Size of each extent read so far
+ */
+static struct fit_ext_state {
+	const void *fit;
+	u32 crc;
+	struct fit_ext_source *src;
+	int count;
+	ulong pos[FIT_EXT_EXTENTS];
+	ulong size[FIT_EXT_EXTENTS];
+} fit_ext;
+
+void fit_ext_set_source(const void *fit, struct fit_ext_source *src)
+{
+	fit_ext.fit = src ? fit : NULL;
+	fit_ext.crc = src ? crc32(0, fit, fdt_totalsize(fit)) : 0;
+	fit_ext.src = src;
+	fit_ext.count = 0;
+}
+
+/**
+ * fit_ext_read() - make sure that external data is in memory
+ *
+ * @fit: FIT header in memory
+ * @pos: Position of the data from the start of the FIT
+ * @size: Size of the data
+ * Return: 0 if OK, -ve on error
+ */
+static int fit_ext_read(const void *fit, ulong pos, ulong size)
+{
+	ulong align, start;
+	int ret, i;
+
+	if (fit != fit_ext.fit || pos + size <= fdt_totalsize(fit))
+		return 0;
+	if (crc32(0, fit, fdt_totalsize(fit)) != fit_ext.crc) {
+		/* Something else was put here, so assume it is all there */
+		fit_ext_set_source(NULL, NULL);
+		return 0;
+	}
+	for (i = 0; i < fit_ext.count; i++) {
+		if (pos >= fit_ext.pos[i] &&
+		    pos + size <= fit_ext.pos[i] + fit_ext.size[i])
+			return 0;
+	}
+
+	/*
+	 * Read whole aligned blocks if the FIT is laid out for that, so that
+	 * the source can read them straight into place
+	 */
+	align = fit_get_data_align(fit);
+	start = ALIGN_DOWN(pos, align);
+	if (start >= fdt_totalsize(fit)) {
+		size = ALIGN(pos + size, align) - start;
+		pos = start;
+	}
+
+	log_debug("Reading %lx bytes at %lx\n", size, pos);
+	ret = fit_ext.src->read(fit_ext.src, pos, size, (void *)fit + pos);
+	if (ret) {
+		log_err("Failed to read FIT external data (err=%d)\n", ret);
+		return ret;
+	}
+	if (fit_ext.count < FIT_EXT_EXTENTS) {
+		fit_ext.pos[fit_ext.count] = pos;
+		fit_ext.size[fit_ext.count++] = size;
+	}
+
+	return 0;
+}
+#else
+static int fit_ext_read(const void *fit, ulong pos, ulong size)
+{
+	return 0;
+}
+#endif
+
 /**
  * fit_image_get_data - get data and its size including
  *				 both embedded and external data
@@ -1069,6 +1226,8 @@ int fit_image_get_data(const void *fit, int noffset, const void **data,
 	if (external_data) {
 		debug("External Data\n");
 		ret = fit_image_get_data_size(fit, noffset, &len);
+		if (!ret)
+			ret = fit_ext_read(fit, offset, len);
 		if (!ret) {
 			*data = fit + offset;
 			*size = len;
@@ -1496,11 +1655,40 @@ int fit_all_image_verify(const void *fit)
 	return 1;
 }
 
+/*
+ * Return where the data of an image can be deciphered to directly: its load
+ * address, if the data is used there as it is and overlaps neither the FIT
+ * nor the ciphered data at @buf, which may be stored outside the FIT. The
+ * data can be deciphered in place, so a load address of exactly @buf is
+ * fine. Otherwise return NULL, for the data to be deciphered to a new buffer.
+ */
+static void *fit_image_uncipher_dest(const void *fit, int noffset, ulong addr,
+				     enum fit_load_op load_op, const void *buf,
+				     size_t size)
+{
+	ulong load, data;
+	u8 comp;
+
+	if (tools_build() || load_op == FIT_LOAD_IGNORED ||
+	    fit_image_get_load(fit, noffset, &load))
+		return NULL;
+	if (load_op == FIT_LOAD_OPTIONAL_NON_ZERO && !load)
+		return NULL;
+	if (!fit_image_get_comp(fit, noffset, &comp) && comp != IH_COMP_NONE)
+		return NULL;
+	if (load < addr + fit_get_size(fit) && load + size > addr)
+		return NULL;
+	data = map_to_sysmem(buf);
+	if (load != data && load < data + size && load + size > data)
+		return NULL;
+
+	return map_sysmem(load, size);
+}
+
 static int fit_image_uncipher(const void *fit, int image_noffset,
-			      void **data, size_t *size)
+			      void *dst, void **data, size_t *size)
 {
 	int cipher_noffset, ret;
-	void *dst;
 	size_t size_dst;
 
 	cipher_noffset = fdt_subnode_offset(fit, image_noffset,
@@ -1707,8 +1895,18 @@ int fit_check_format(const void *fit, ulong size)
 		}
 	}
 
+#ifndef USE_HOSTCC
+	/*
+	 * A different FIT loaded to the same address may keep the size of
+	 * the last one, which the node index cannot tell apart. Do not let a
+	 * signed FIT rely on that.
+	 */
+	if (CONFIG_IS_ENABLED(FIT_SIGNATURE))
+		fdtdec_index_invalidate(fit);
+#endif
+
 	/* mandatory subimages parent '/images' node */
-	if (fdt_path_offset(fit, FIT_IMAGES_PATH) < 0) {
+	if (fit_path_offset(fit, FIT_IMAGES_PATH) < 0) {
 		log_debug("Wrong FIT format: no images parent node\n");
 		return -ENOENT;
 	}
@@ -1725,8 +1923,8 @@ int fit_conf_find_compat(const void *fit, const void *fdt)
 	int best_match_offset = 0;
 	int best_match_pos = 0;
 
-	confs_noffset = fdt_path_offset(fit, FIT_CONFS_PATH);
-	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	confs_noffset = fit_path_offset(fit, FIT_CONFS_PATH);
+	images_noffset = fit_path_offset(fit, FIT_IMAGES_PATH);
 	if (confs_noffset < 0 || images_noffset < 0) {
 		debug("Can't find configurations or images nodes.\n");
 		return -EINVAL;
@@ -1765,7 +1963,8 @@ int fit_conf_find_compat(const void *fit, const void *fdt)
 				debug("No fdt property found.\n");
 				continue;
 			}
-			kfdt_noffset = fdt_subnode_offset(fit, images_noffset,
+			kfdt_noffset = fit_subnode_offset(fit, images_noffset,
+							  FIT_IMAGES_PATH,
 							  kfdt_name);
 			if (kfdt_noffset < 0) {
 				debug("No image node named \"%s\" found.\n",
@@ -1824,7 +2023,7 @@ int fit_conf_get_node(const void *fit, const char *conf_uname)
 	const char *s;
 	char *conf_uname_copy = NULL;
 
-	confs_noffset = fdt_path_offset(fit, FIT_CONFS_PATH);
+	confs_noffset = fit_path_offset(fit, FIT_CONFS_PATH);
 	if (confs_noffset < 0) {
 		debug("Can't find configurations parent node '%s' (%s)\n",
 		      FIT_CONFS_PATH, fdt_strerror(confs_noffset));
@@ -1865,7 +2064,8 @@ int fit_conf_get_node(const void *fit, const char *conf_uname)
 		conf_uname = conf_uname_copy;
 	}
 
-	noffset = fdt_subnode_offset(fit, confs_noffset, conf_uname);
+	noffset = fit_subnode_offset(fit, confs_noffset, FIT_CONFS_PATH,
+				     conf_uname);
 	if (noffset < 0) {
 		debug("Can't get node offset for configuration unit name: '%s' (%s)\n",
 		      conf_uname, fdt_strerror(noffset));
@@ -2215,7 +2415,10 @@ int fit_image_load(struct bootm_headers *images, ulong addr,
 	/* Decrypt data before uncompress/move */
 	if (IS_ENABLED(CONFIG_FIT_CIPHER) && IMAGE_ENABLE_DECRYPT) {
 		puts("   Decrypting Data ... ");
-		if (fit_image_uncipher(fit, noffset, &buf, &size)) {
+		void *dst = fit_image_uncipher_dest(fit, noffset, addr,
+						    load_op, buf, size);
+
+		if (fit_image_uncipher(fit, noffset, dst, &buf, &size)) {
 			puts("Error\n");
 			return -EACCES;
 		}
@@ -2343,6 +2546,123 @@ int boot_get_setup_fit(struct bootm_headers *images, uint8_t arch,
 }
 
 #ifndef USE_HOSTCC
+#ifdef CONFIG_OF_LIBFDT_OVERLAY
+/**
+ * fit_fdt_overlays() - go through the overlays of a FIT configuration
+ *
+ * With @cache, each overlay is only loaded and added to the cache digest.
+ * Otherwise each overlay is applied to the tree at @loadp.
+ *
+ * @images: Boot images
+ * @addr: Address of the FIT
+ * @arch: Expected architecture
+ * @fit: Pointer to the FIT
+ * @cfg_noffset: Offset of the configuration node
+ * @count: Number of FDTs in the configuration
+ * @next_config: Extra configurations, separated by nul characters, or NULL
+ * @cfg_end: End of the last extra configuration
+ * @cache: Cache digest to add the overlays to, or NULL to apply them
+ * @ovsizep: Returns the total size of the overlays, with @cache
+ * @loadp: Address of the base tree, updated, without @cache
+ * @lenp: Length of the base tree, updated, without @cache
+ * Return: 0 if OK, -ve on error
+ */
+static int fit_fdt_overlays(struct bootm_headers *images, ulong addr, int arch,
+			    const void *fit, int cfg_noffset, int count,
+			    char *next_config, const char *cfg_end,
+			    struct fdt_overlay_cache *cache, ulong *ovsizep,
+			    ulong *loadp, ulong *lenp)
+{
+	ulong ovload, ovlen, ovcopylen;
+	const char *uconfig;
+	const char *uname;
+	void *base, *ov, *ovcopy;
+	int i, err, noffset, ov_noffset;
+
+	/* apply extra configs in FIT first, followed by args */
+	for (i = 1; ; i++) {
+		if (i < count) {
+			noffset = fit_conf_get_prop_node_index(fit, cfg_noffset,
+							       FIT_FDT_PROP, i);
+			uname = fit_get_name(fit, noffset, NULL);
+			uconfig = NULL;
+		} else {
+			if (!next_config)
+				break;
+			uconfig = next_config;
+			next_config += strlen(next_config) + 1;
+			if (next_config > cfg_end)
+				next_config = NULL;
+			uname = NULL;
+
+			/*
+			 * fit_image_load() would load the first FDT from the
+			 * extra config only when uconfig is specified.
+			 * Check if the extra config contains multiple FDTs and
+			 * if so, load them.
+			 */
+			cfg_noffset = fit_conf_get_node(fit, uconfig);
+
+			i = 0;
+			count = fit_conf_get_prop_node_count(fit, cfg_noffset,
+							     FIT_FDT_PROP);
+		}
+
+		debug("%d: using uname=%s uconfig=%s\n", i, uname, uconfig);
+
+		ov_noffset = fit_image_load(images,
+			addr, &uname, &uconfig,
+			arch, IH_TYPE_FLATDT,
+			BOOTSTAGE_ID_FIT_FDT_START,
+			FIT_LOAD_IGNORED, &ovload, &ovlen);
+		if (ov_noffset < 0) {
+			printf("load of %s failed\n", uname);
+			continue;
+		}
+		debug("%s loaded at 0x%08lx len=0x%08lx\n",
+				uname, ovload, ovlen);
+		ov = map_sysmem(ovload, ovlen);
+		if (cache) {
+			fdt_overlay_cache_add(cache, ov);
+			*ovsizep += ovlen;
+			continue;
+		}
+
+		ovcopylen = ALIGN(fdt_totalsize(ov), SZ_4K);
+		ovcopy = malloc(ovcopylen);
+		if (!ovcopy) {
+			printf("failed to duplicate DTO before application\n");
+			return -ENOMEM;
+		}
+
+		err = fdt_open_into(ov, ovcopy, ovcopylen);
+		if (err < 0) {
+			printf("failed on fdt_open_into for DTO\n");
+			free(ovcopy);
+			return err;
+		}
+
+		base = map_sysmem(*loadp, *lenp + ovlen);
+		err = fdt_open_into(base, base, *lenp + ovlen);
+		if (err < 0) {
+			printf("failed on fdt_open_into\n");
+			free(ovcopy);
+			return err;
+		}
+
+		/* the verbose method prints out messages on error */
+		err = fdt_overlay_apply_verbose(base, ovcopy);
+		free(ovcopy);
+		if (err < 0)
+			return err;
+		fdt_pack(base);
+		*lenp = fdt_totalsize(base);
+	}
+
+	return 0;
+}
+#endif
+
 int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
 		     const char **fit_unamep, const char **fit_uname_configp,
 		     int arch, ulong *datap, ulong *lenp)
@@ -2353,11 +2673,11 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
 	const char *fit_uname_config = NULL;
 	char *fit_uname_config_copy = NULL;
 	char *next_config = NULL;
+	const char *cfg_end = NULL;
 	ulong load, len;
 #ifdef CONFIG_OF_LIBFDT_OVERLAY
-	ulong ovload, ovlen, ovcopylen;
-	const char *uconfig;
-	const char *uname;
+	struct fdt_overlay_cache cache;
+	bool use_cache = false;
 	/*
 	 * of_flat_tree is storing the void * returned by map_sysmem, then its
 	 * address is passed to boot_relocate_fdt which expects a char ** and it
@@ -2366,13 +2686,14 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
 	 * Instead, let's be lazy and use void *.
 	 */
 	char *of_flat_tree;
-	void *base, *ov, *ovcopy = NULL;
-	int i, err, noffset, ov_noffset;
+	int err;
 #endif
 
 	fit_uname = fit_unamep ? *fit_unamep : NULL;
 
 	if (fit_uname_configp && *fit_uname_configp) {
+		char *p;
+
 		fit_uname_config_copy = strdup(*fit_uname_configp);
 		if (!fit_uname_config_copy)
 			return -ENOMEM;
@@ -2382,6 +2703,13 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
 			*next_config++ = '\0';
 		if (next_config - 1 > fit_uname_config_copy)
 			fit_uname_config = fit_uname_config_copy;
+
+		/* Split the extra configs so they can be gone through twice */
+		if (next_config) {
+			cfg_end = next_config + strlen(next_config);
+			for (p = next_config; (p = strchr(p, '#'));)
+				*p++ = '\0';
+		}
 	}
 
 	fdt_noffset = fit_image_load(images,
@@ -2422,82 +2750,39 @@ int boot_get_fdt_fit(struct bootm_headers *images, ulong addr,
 
 	load = (ulong)of_flat_tree;
 
-	/* apply extra configs in FIT first, followed by args */
-	for (i = 1; ; i++) {
-		if (i < count) {
-			noffset = fit_conf_get_prop_node_index(fit, cfg_noffset,
-							       FIT_FDT_PROP, i);
-			uname = fit_get_name(fit, noffset, NULL);
-			uconfig = NULL;
-		} else {
-			if (!next_config)
-				break;
-			uconfig = next_config;
-			next_config = strchr(next_config, '#');
-			if (next_config)
-				*next_config++ = '\0';
-			uname = NULL;
-
-			/*
-			 * fit_image_load() would load the first FDT from the
-			 * extra config only when uconfig is specified.
-			 * Check if the extra config contains multiple FDTs and
-			 * if so, load them.
-			 */
-			cfg_noffset = fit_conf_get_node(fit, uconfig);
-
-			i = 0;
-			count = fit_conf_get_prop_node_count(fit, cfg_noffset,
-							     FIT_FDT_PROP);
-		}
-
-		debug("%d: using uname=%s uconfig=%s\n", i, uname, uconfig);
-
-		ov_noffset = fit_image_load(images,
-			addr, &uname, &uconfig,
-			arch, IH_TYPE_FLATDT,
-			BOOTSTAGE_ID_FIT_FDT_START,
-			FIT_LOAD_IGNORED, &ovload, &ovlen);
-		if (ov_noffset < 0) {
-			printf("load of %s failed\n", uname);
-			continue;
-		}
-		debug("%s loaded at 0x%08lx len=0x%08lx\n",
-				uname, ovload, ovlen);
-		ov = map_sysmem(ovload, ovlen);
-
-		ovcopylen = ALIGN(fdt_totalsize(ov), SZ_4K);
-		ovcopy = malloc(ovcopylen);
-		if (!ovcopy) {
-			printf("failed to duplicate DTO before application\n");
-			fdt_noffset = -ENOMEM;
-			goto out;
-		}
-
-		err = fdt_open_into(ov, ovcopy, ovcopylen);
-		if (err < 0) {
-			printf("failed on fdt_open_into for DTO\n");
-			fdt_noffset = err;
-			goto out;
-		}
-
-		base = map_sysmem(load, len + ovlen);
-		err = fdt_open_into(base, base, len + ovlen);
-		if (err < 0) {
-			printf("failed on fdt_open_into\n");
-			fdt_noffset = err;
-			goto out;
+	if (CONFIG_IS_ENABLED(OF_LIBFDT_OVERLAY_CACHE) &&
+	    env_get("fdtoverlay_cache")) {
+		ulong ovsize = 0;
+
+		/* The merged tree fits where the overlays would be applied */
+		fdt_overlay_cache_start(&cache, of_flat_tree);
+		err = fit_fdt_overlays(images, addr, arch, fit, cfg_noffset,
+				       count, next_config, cfg_end, &cache,
+				       &ovsize, NULL, NULL);
+		if (!err) {
+			err = fdt_overlay_cache_load(&cache,
+					map_sysmem(load, len + ovsize),
+					len + ovsize);
+			if (!err) {
+				len = fdt_totalsize(of_flat_tree);
+				goto out;
+			}
+			if (err != -ENOENT) {
+				fdt_noffset = err;
+				goto out;
+			}
+			use_cache = true;
 		}
+	}
 
-		/* the verbose method prints out messages on error */
-		err = fdt_overlay_apply_verbose(base, ovcopy);
-		if (err < 0) {
-			fdt_noffset = err;
-			goto out;
-		}
-		fdt_pack(base);
-		len = fdt_totalsize(base);
+	err = fit_fdt_overlays(images, addr, arch, fit, cfg_noffset, count,
+			       next_config, cfg_end, NULL, NULL, &load, &len);
+	if (err) {
+		fdt_noffset = err;
+		goto out;
 	}
+	if (use_cache)
+		fdt_overlay_cache_store(&cache, map_sysmem(load, len));
 #else
 	printf("config with overlays but CONFIG_OF_LIBFDT_OVERLAY not set\n");
 	fdt_noffset = -EBADF;
@@ -2513,9 +2798,6 @@ out:
 	if (fit_uname_configp)
 		*fit_uname_configp = fit_uname_config;
 
-#ifdef CONFIG_OF_LIBFDT_OVERLAY
-	free(ovcopy);
-#endif
 	free(fit_uname_config_copy);
 	return fdt_noffset;
 }
@@ -52,6 +52,7 @@ DECLARE_GLOBAL_DATA_PTR;
 #endif /* !USE_HOSTCC*/
 
 #include <abuf.h>
+#include <bootstage.h>
 #include <bzlib.h>
 #include <display_options.h>
 #include <gzip.h>
@@ -451,9 +452,13 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 		 uint unc_len, ulong *load_end)
 {
 	int ret = -ENOSYS;
+	char span[20];
 
 	*load_end = load;
 	print_decomp_msg(comp, type, load == image_start, load);
+	snprintf(span, sizeof(span), "decomp_%s",
+		 genimg_get_comp_short_name(comp));
+	bootstage_span_begin(span);
 
 	/*
 	 * Load the image to the right place, decompressing if needed. After
@@ -527,6 +532,7 @@ int image_decomp(int comp, ulong load, ulong image_start, int type,
 		}
 		break;
 	}
+	bootstage_span_end();
 	if (ret == -ENOSYS) {
 		printf("Unimplemented compression type %d\n", comp);
 		return ret;
@@ -35,6 +35,132 @@
 
 #define MAX_TFTP_PATH_LEN 512
 
+/**
+ * struct pxe_cache_ent - a config file read over the network
+ *
+ * @sibling: Node in pxe_cache_list
+ * @path: Full path of the file
+ * @buf: Contents of the file, or NULL if it was not found
+ * @size: Size of the file in bytes
+ */
+struct pxe_cache_ent {
+	struct list_head sibling;
+	char *path;
+	void *buf;
+	ulong size;
+};
+
+/**
+ * struct pxe_cache_key - network setup which the cached files came from
+ *
+ * @mac: Ethernet address of the current device
+ * @ip: Our IP address
+ * @server: Address of the TFTP server
+ */
+struct pxe_cache_key {
+	u8 mac[ARP_HLEN];
+	struct in_addr ip;
+	struct in_addr server;
+};
+
+static LIST_HEAD(pxe_cache_list);
+static struct pxe_cache_key pxe_cache_key;
+
+/*
+ * Files which were not found are only remembered once the server has sent
+ * us something, so that a retry after a network failure is not cut short
+ */
+static bool pxe_cache_server_ok;
+
+static void pxe_cache_flush(void)
+{
+	struct pxe_cache_ent *ent, *next;
+
+	list_for_each_entry_safe(ent, next, &pxe_cache_list, sibling) {
+		list_del(&ent->sibling);
+		free(ent->path);
+		free(ent->buf);
+		free(ent);
+	}
+	pxe_cache_server_ok = false;
+}
+
+/* Drop the cache if the network setup has changed since it was filled */
+static void pxe_cache_check(void)
+{
+	struct pxe_cache_key key;
+
+	memset(&key, '\0', sizeof(key));
+	if (eth_get_ethaddr())
+		memcpy(key.mac, eth_get_ethaddr(), ARP_HLEN);
+	key.ip = net_ip;
+	key.server = net_server_ip;
+	if (memcmp(&key, &pxe_cache_key, sizeof(key))) {
+		pxe_cache_flush();
+		pxe_cache_key = key;
+	}
+}
+
+/**
+ * pxe_cache_find() - look up a config file in the cache
+ *
+ * @path: Full path of the file
+ * @file_addr: Address to copy the file to
+ * @sizep: Returns the file size in bytes
+ * Return: 1 if the file was copied to @file_addr, -ENOENT if it is known not
+ *	to exist, 0 if it is not in the cache
+ */
+static int pxe_cache_find(const char *path, ulong file_addr, ulong *sizep)
+{
+	struct pxe_cache_ent *ent;
+	void *ptr;
+
+	list_for_each_entry(ent, &pxe_cache_list, sibling) {
+		if (strcmp(ent->path, path))
+			continue;
+		if (!ent->buf)
+			return pxe_cache_server_ok ? -ENOENT : 0;
+		ptr = map_sysmem(file_addr, ent->size);
+		memcpy(ptr, ent->buf, ent->size);
+		unmap_sysmem(ptr);
+		*sizep = ent->size;
+
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Record the result of reading @path; @file_addr is ignored if @size < 0 */
+static void pxe_cache_add(const char *path, ulong file_addr, long size)
+{
+	struct pxe_cache_ent *ent;
+	void *ptr;
+
+	ent = calloc(1, sizeof(*ent));
+	if (!ent)
+		return;
+	ent->path = strdup(path);
+	if (size >= 0) {
+		ent->buf = malloc(size ? size : 1);
+		if (ent->buf) {
+			ptr = map_sysmem(file_addr, size);
+			memcpy(ent->buf, ptr, size);
+			unmap_sysmem(ptr);
+		}
+	}
+	if (!ent->path || (size >= 0 && !ent->buf)) {
+		free(ent->path);
+		free(ent->buf);
+		free(ent);
+		return;
+	}
+	ent->size = size >= 0 ? size : 0;
+	list_add_tail(&ent->sibling, &pxe_cache_list);
+	if (size >= 0)
+		pxe_cache_server_ok = true;
+}
+
 int pxe_get_file_size(ulong *sizep)
 {
 	const char *val;
@@ -104,6 +230,7 @@ static int get_relfile(struct pxe_context *ctx, const char *file_path,
 	size_t path_len;
 	char relfile[MAX_TFTP_PATH_LEN + 1];
 	char addr_buf[18];
+	bool cache;
 	ulong size;
 	int ret;
 
@@ -122,13 +249,31 @@ static int get_relfile(struct pxe_context *ctx, const char *file_path,
 
 	strcat(relfile, file_path);
 
+	cache = IS_ENABLED(CONFIG_PXE_CACHE) && ctx->cache && !ctx->use_ipv6 &&
+		type == BFI_EXTLINUX_CFG;
+	if (cache) {
+		pxe_cache_check();
+		ret = pxe_cache_find(relfile, file_addr, &size);
+		if (ret < 0)
+			return log_msg_ret("cac", ret);
+		if (ret) {
+			printf("Retrieving file: %s (cached)\n", relfile);
+			ctx->pxe_file_size = size;
+			env_set_hex("filesize", size);
+			goto done;
+		}
+	}
+
 	printf("Retrieving file: %s\n", relfile);
 
 	sprintf(addr_buf, "%lx", file_addr);
 
 	ret = ctx->getfile(ctx, relfile, addr_buf, type, &size);
+	if (cache)
+		pxe_cache_add(relfile, file_addr, ret < 0 ? -1 : size);
 	if (ret < 0)
 		return log_msg_ret("get", ret);
+done:
 	if (filesizep)
 		*filesizep = size;
 
@@ -340,40 +485,30 @@ static void label_boot_kaslrseed(void)
 	return;
 }
 
+#ifdef CONFIG_OF_LIBFDT_OVERLAY
 /**
- * label_boot_fdtoverlay() - Loads fdt overlays specified in 'fdtoverlays'
- * or 'devicetree-overlay'
+ * label_boot_fdtoverlay_files() - Go through the files in 'fdtoverlays'
+ *
+ * Each overlay file is loaded to fdtoverlay_addr_r. With @cache it is only
+ * added to the cache digest, otherwise it is applied to @working_fdt.
  *
  * @ctx: PXE context
  * @label: Label to process
+ * @working_fdt: Main fdt
+ * @fdtoverlay_addr: Address the overlays are loaded to
+ * @cache: Cache digest to add the overlays to, or NULL to apply them
+ * @sizep: Returns the space needed to apply the overlays, with @cache
  */
-#ifdef CONFIG_OF_LIBFDT_OVERLAY
-static void label_boot_fdtoverlay(struct pxe_context *ctx,
-				  struct pxe_label *label)
+static void label_boot_fdtoverlay_files(struct pxe_context *ctx,
+					struct pxe_label *label,
+					struct fdt_header *working_fdt,
+					ulong fdtoverlay_addr,
+					struct fdt_overlay_cache *cache,
+					ulong *sizep)
 {
 	char *fdtoverlay = label->fdtoverlays;
-	struct fdt_header *working_fdt;
-	char *fdtoverlay_addr_env;
-	ulong fdtoverlay_addr;
-	ulong fdt_addr;
 	int err;
 
-	/* Get the main fdt and map it */
-	fdt_addr = hextoul(env_get("fdt_addr_r"), NULL);
-	working_fdt = map_sysmem(fdt_addr, 0);
-	err = fdt_check_header(working_fdt);
-	if (err)
-		return;
-
-	/* Get the specific overlay loading address */
-	fdtoverlay_addr_env = env_get("fdtoverlay_addr_r");
-	if (!fdtoverlay_addr_env) {
-		printf("Invalid fdtoverlay_addr_r for loading overlays\n");
-		return;
-	}
-
-	fdtoverlay_addr = hextoul(fdtoverlay_addr_env, NULL);
-
 	/* Cycle over the overlay files and apply them in order */
 	do {
 		struct fdt_header *blob;
@@ -407,10 +542,18 @@ static void label_boot_fdtoverlay(struct pxe_context *ctx,
 			goto skip_overlay;
 		}
 
+		blob = map_sysmem(fdtoverlay_addr, 0);
+		if (cache) {
+			if (!fdt_check_header(blob)) {
+				fdt_overlay_cache_add(cache, blob);
+				*sizep += fdt_totalsize(blob) + 8192;
+			}
+			goto skip_overlay;
+		}
+
 		/* Resize main fdt */
 		fdt_shrink_to_minimum(working_fdt, 8192);
 
-		blob = map_sysmem(fdtoverlay_addr, 0);
 		err = fdt_check_header(blob);
 		if (err) {
 			printf("Invalid overlay %s, skipping\n",
@@ -430,6 +573,63 @@ skip_overlay:
 			free(overlayfile);
 	} while ((fdtoverlay = strstr(fdtoverlay, " ")));
 }
+
+/**
+ * label_boot_fdtoverlay() - Loads fdt overlays specified in 'fdtoverlays'
+ * or 'devicetree-overlay'
+ *
+ * If fdtoverlay_cache is set and holds the result of applying the same
+ * overlays to the same main fdt, that result is used instead.
+ *
+ * @ctx: PXE context
+ * @label: Label to process
+ */
+static void label_boot_fdtoverlay(struct pxe_context *ctx,
+				  struct pxe_label *label)
+{
+	struct fdt_overlay_cache cache;
+	struct fdt_header *working_fdt;
+	char *fdtoverlay_addr_env;
+	ulong fdtoverlay_addr;
+	bool use_cache = false;
+	ulong fdt_addr;
+	int err;
+
+	/* Get the main fdt and map it */
+	fdt_addr = hextoul(env_get("fdt_addr_r"), NULL);
+	working_fdt = map_sysmem(fdt_addr, 0);
+	err = fdt_check_header(working_fdt);
+	if (err)
+		return;
+
+	/* Get the specific overlay loading address */
+	fdtoverlay_addr_env = env_get("fdtoverlay_addr_r");
+	if (!fdtoverlay_addr_env) {
+		printf("Invalid fdtoverlay_addr_r for loading overlays\n");
+		return;
+	}
+
+	fdtoverlay_addr = hextoul(fdtoverlay_addr_env, NULL);
+
+	if (CONFIG_IS_ENABLED(OF_LIBFDT_OVERLAY_CACHE) &&
+	    env_get("fdtoverlay_cache")) {
+		ulong size = fdt_totalsize(working_fdt);
+
+		fdt_overlay_cache_start(&cache, working_fdt);
+		label_boot_fdtoverlay_files(ctx, label, working_fdt,
+					    fdtoverlay_addr, &cache, &size);
+		err = fdt_overlay_cache_load(&cache, working_fdt, size);
+		/* On other errors the main fdt is no longer usable */
+		if (err != -ENOENT)
+			return;
+		use_cache = true;
+	}
+
+	label_boot_fdtoverlay_files(ctx, label, working_fdt, fdtoverlay_addr,
+				    NULL, NULL);
+	if (use_cache)
+		fdt_overlay_cache_store(&cache, working_fdt);
+}
 #endif
 
 /**
@@ -582,6 +582,122 @@ int scene_render_deps(struct scene *scn, uint id)
 	return 0;
 }
 
+enum {
+	/* space cleared around each object, for glyphs which stick out */
+	SCENE_DRAWN_MARGIN	= 2,
+
+	/* maximum number of regions which are drawn again in an update */
+	SCENE_MAX_DIRTY		= 32,
+};
+
+static u32 scene_hash(u32 hash, const void *data, int size)
+{
+	const u8 *ptr = data;
+
+	while (size--)
+		hash = (hash ^ *ptr++) * 16777619U;
+
+	return hash;
+}
+
+static u32 scene_hash_str(u32 hash, const char *str)
+{
+	return str ? scene_hash(hash, str, strlen(str) + 1) : hash;
+}
+
+/**
+ * scene_obj_get_drawn() - Work out what an object draws in its current state
+ *
+ * @obj: Object to check
+ * @drawn: Returns the region the object covers, with a width of 0 if it is
+ *	not drawn
+ * Return: hash of the state of the object which affects what is drawn
+ */
+static u32 scene_obj_get_drawn(struct scene_obj *obj, struct scene_dim *drawn)
+{
+	struct scene *scn = obj->scene;
+	struct expo *exp = scn->expo;
+	struct vidconsole_bbox bbox, label_bbox;
+	int inset = exp->theme.menu_inset + SCENE_DRAWN_MARGIN;
+	bool point = scn->highlight_id == obj->id;
+	int x0, y0, x1, y1;
+	u32 hash;
+
+	memset(drawn, '\0', sizeof(*drawn));
+	if (obj->flags & SCENEOF_HIDE)
+		return 0;
+
+	hash = scene_hash(2166136261U, &obj->dim, sizeof(obj->dim));
+	hash = scene_hash(hash, &obj->flags, sizeof(obj->flags));
+	hash = scene_hash(hash, &point, sizeof(point));
+	x0 = obj->dim.x;
+	y0 = obj->dim.y;
+	x1 = obj->dim.x + obj->dim.w;
+	y1 = obj->dim.y + obj->dim.h;
+
+	switch (obj->type) {
+	case SCENEOBJT_NONE:
+		break;
+	case SCENEOBJT_IMAGE: {
+		struct scene_obj_img *img = (struct scene_obj_img *)obj;
+
+		hash = scene_hash(hash, &img->data, sizeof(img->data));
+		break;
+	}
+	case SCENEOBJT_TEXT: {
+		struct scene_obj_txt *txt = (struct scene_obj_txt *)obj;
+
+		hash = scene_hash_str(hash, expo_get_str(exp, txt->str_id));
+		hash = scene_hash_str(hash, txt->font_name);
+		hash = scene_hash(hash, &txt->font_size, sizeof(txt->font_size));
+		break;
+	}
+	case SCENEOBJT_MENU:
+	case SCENEOBJT_TEXTLINE:
+		hash = scene_hash(hash, &exp->popup, sizeof(exp->popup));
+		if ((obj->flags & SCENEOF_OPEN) &&
+		    !scene_obj_calc_bbox(obj, &bbox, &label_bbox)) {
+			x0 = min(x0, label_bbox.x0);
+			y0 = min(y0, label_bbox.y0);
+			x1 = max(x1, label_bbox.x1);
+			y1 = max(y1, label_bbox.y1);
+		}
+		if (obj->type == SCENEOBJT_TEXTLINE) {
+			struct scene_obj_textline *tline;
+
+			/* the cursor is drawn while the text is edited */
+			tline = (struct scene_obj_textline *)obj;
+			hash = scene_hash_str(hash, abuf_data(&tline->buf));
+			hash = scene_hash(hash, &scn->cls.num,
+					  sizeof(scn->cls.num));
+		}
+		break;
+	}
+
+	drawn->x = x0 - inset;
+	drawn->y = y0 - inset;
+	drawn->w = x1 - x0 + inset * 2;
+	drawn->h = y1 - y0 + inset * 2;
+
+	return hash;
+}
+
+static bool scene_dim_overlap(const struct scene_dim *a,
+			      const struct scene_dim *b)
+{
+	return a->w && b->w && a->x < b->x + b->w && b->x < a->x + a->w &&
+		a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+/* Record what each object looks like, so that changes can be found */
+static void scene_record_drawn(struct scene *scn)
+{
+	struct scene_obj *obj;
+
+	list_for_each_entry(obj, &scn->obj_head, sibling)
+		obj->drawn_hash = scene_obj_get_drawn(obj, &obj->drawn);
+}
+
 int scene_render(struct scene *scn)
 {
 	struct expo *exp = scn->expo;
@@ -602,6 +718,79 @@ int scene_render(struct scene *scn)
 		if (ret && ret != -ENOTSUPP)
 			return log_msg_ret("dep", ret);
 	}
+	if (!exp->text_mode)
+		scene_record_drawn(scn);
+
+	return 0;
+}
+
+int scene_render_update(struct scene *scn, u32 colour)
+{
+	struct scene_dim dirty[SCENE_MAX_DIRTY], now;
+	struct udevice *dev = scn->expo->display;
+	struct video_priv *vid_priv = dev_get_uclass_priv(dev);
+	struct scene_obj *obj;
+	int count, i, ret;
+	u32 hash;
+
+	/* find what has changed, clearing where it was and where it will be */
+	count = 0;
+	list_for_each_entry(obj, &scn->obj_head, sibling) {
+		hash = scene_obj_get_drawn(obj, &now);
+		if (hash == obj->drawn_hash &&
+		    !memcmp(&now, &obj->drawn, sizeof(now)))
+			continue;
+		if (count + 2 > SCENE_MAX_DIRTY)
+			return -E2BIG;
+		if (obj->drawn.w)
+			dirty[count++] = obj->drawn;
+		if (now.w)
+			dirty[count++] = now;
+	}
+	if (!count)
+		return 0;
+
+	for (i = 0; i < count; i++) {
+		struct scene_dim *dim = &dirty[i];
+
+		ret = video_fill_part(dev, max(dim->x, 0), max(dim->y, 0),
+				      min(dim->x + dim->w, (int)vid_priv->xsize),
+				      min(dim->y + dim->h, (int)vid_priv->ysize),
+				      colour);
+		if (ret)
+			return log_msg_ret("fil", ret);
+	}
+
+	/*
+	 * Draw everything which overlaps, in order. Anything drawn covers the
+	 * objects after it, so those must be drawn again too.
+	 */
+	list_for_each_entry(obj, &scn->obj_head, sibling) {
+		scene_obj_get_drawn(obj, &now);
+		for (i = 0; i < count; i++) {
+			if (scene_dim_overlap(&now, &dirty[i]))
+				break;
+		}
+		if (i == count)
+			continue;
+		if (!memcmp(&now, &dirty[i], sizeof(now))) {
+			/* already in the list */
+		} else if (count < SCENE_MAX_DIRTY) {
+			dirty[count++] = now;
+		} else {
+			return -E2BIG;
+		}
+		ret = scene_obj_render(obj, false);
+		if (ret && ret != -ENOTSUPP)
+			return log_msg_ret("ren", ret);
+	}
+
+	if (scn->highlight_id) {
+		ret = scene_render_deps(scn, scn->highlight_id);
+		if (ret && ret != -ENOTSUPP)
+			return log_msg_ret("dep", ret);
+	}
+	scene_record_drawn(scn);
 
 	return 0;
 }
@@ -183,6 +183,20 @@ void scene_destroy(struct scene *scn);
  */
 int scene_render(struct scene *scn);
 
+/**
+ * scene_render_update() - Render the objects in a scene which have changed
+ *
+ * This is called from expo_render() when the scene is already drawn. The
+ * regions covered by each changed object, before and after, are cleared and
+ * everything which overlaps them is drawn again, in order.
+ *
+ * @scn: Scene to render
+ * @colour: Background colour of the display
+ * Returns: 0 if OK, -E2BIG if too much has changed, so the whole scene must be
+ * rendered, other -ve on error
+ */
+int scene_render_update(struct scene *scn, u32 colour);
+
 /**
  * scene_send_key() - set a keypress to a scene
  *
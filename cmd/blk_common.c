@@ -13,6 +13,25 @@
 #include <mapmem.h>
 #include <vsprintf.h>
 
+/* Show or reset the transfer statistics of the current device */
+static int blk_common_stats(enum uclass_id uclass_id, int devnum, bool reset)
+{
+	struct blk_desc *desc;
+
+	if (!CONFIG_IS_ENABLED(BLK_STATS)) {
+		printf("Statistics are not enabled\n");
+		return CMD_RET_FAILURE;
+	}
+	if (blk_get_desc(uclass_id, devnum, &desc))
+		return CMD_RET_FAILURE;
+	if (reset)
+		blk_stats_reset(desc->bdev);
+	else
+		blk_stats_show(desc->bdev);
+
+	return CMD_RET_SUCCESS;
+}
+
 int blk_common_cmd(int argc, char *const argv[], enum uclass_id uclass_id,
 		   int *cur_devnump)
 {
@@ -37,6 +56,8 @@ int blk_common_cmd(int argc, char *const argv[], enum uclass_id uclass_id,
 				printf("\nno %s partition table available\n",
 				       if_name);
 			return CMD_RET_SUCCESS;
+		} else if (strcmp(argv[1], "stats") == 0) {
+			return blk_common_stats(uclass_id, *cur_devnump, false);
 		}
 		return CMD_RET_USAGE;
 	case 3:
@@ -59,6 +80,9 @@ int blk_common_cmd(int argc, char *const argv[], enum uclass_id uclass_id,
 				return CMD_RET_FAILURE;
 			}
 			return CMD_RET_SUCCESS;
+		} else if (strcmp(argv[1], "stats") == 0 &&
+			   strcmp(argv[2], "reset") == 0) {
+			return blk_common_stats(uclass_id, *cur_devnump, true);
 		}
 		return CMD_RET_USAGE;
 
@@ -13,16 +13,29 @@
 static int blkc_show(struct cmd_tbl *cmdtp, int flag,
 		     int argc, char *const argv[])
 {
+	struct block_cache_dev_stats dstats;
 	struct block_cache_stats stats;
+	int i;
+
 	blkcache_stats(&stats);
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
 	       "entries: %u\n"
 	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
+	       "max cache entries: %u\n"
+	       "ways: %u\n"
+	       "dirty entries: %u\n"
+	       "writebacks: %u\n",
 	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       stats.max_blocks_per_entry, stats.max_entries,
+	       stats.ways, stats.dirty, stats.writebacks);
+
+	for (i = 0; !blkcache_dev_stats(i, &dstats); i++)
+		printf("%s %d: hits %u misses %u writes %u\n",
+		       blk_get_uclass_name(dstats.iftype), dstats.devnum,
+		       dstats.hits, dstats.misses, dstats.writes);
+
 	return 0;
 }
 
@@ -71,5 +84,5 @@ U_BOOT_CMD(
 	"block cache diagnostics and control",
 	"show - show and reset statistics\n"
 	"blkcache configure <blocks> <entries> "
-	"- set max blocks per entry and max cache entries\n"
+	"- set blocks per cache line and number of cache lines\n"
 );
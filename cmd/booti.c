@@ -67,6 +67,16 @@ static int booti_start(struct bootm_info *bmi)
 				 decomp_len, &dest_end);
 		if (ret)
 			return ret;
+		/*
+		 * Copy the Image straight to where it will run from rather
+		 * than back to the load address and on again from there
+		 */
+		if (IS_ENABLED(CONFIG_ARM64)) {
+			ulong size;
+
+			booti_get_dest(map_sysmem(dest, 0), ld, &ld, &size,
+				       false);
+		}
 		/* dest_end contains the uncompressed Image size */
 		memmove((void *) ld, (void *)dest, dest_end);
 	}
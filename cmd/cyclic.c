@@ -70,6 +70,9 @@ static int do_cyclic_list(struct cmd_tbl *cmdtp, int flag, int argc,
 		printf("function: %s, cpu-time: %lld us, frequency: %lld.%02d times/s\n",
 		       cyclic->name, cyclic->cpu_time_us,
 		       lldiv(freq, 100), do_div(freq, 100));
+		printf("    max cpu-time: %lld us, max latency: %lld us, overruns: %lld\n",
+		       cyclic->max_cpu_us, cyclic->max_late_us,
+		       cyclic->overrun_cnt);
 	}
 
 	return 0;
@@ -10,6 +10,16 @@
 #include <dm/root.h>
 #include <dm/util.h>
 
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+static int do_dm_bind(struct cmd_tbl *cmdtp, int flag, int argc,
+		      char *const argv[])
+{
+	printf("%d devices bound\n", dm_lazy_bind_all());
+
+	return 0;
+}
+#endif
+
 static int do_dm_dump_driver_compat(struct cmd_tbl *cmdtp, int flag, int argc,
 				    char * const argv[])
 {
@@ -77,6 +87,8 @@ static int do_dm_dump_tree(struct cmd_tbl *cmdtp, int flag, int argc,
 	if (argc > 1)
 		device = argv[1];
 
+	/* Show all devices, not only those bound on demand so far */
+	dm_lazy_bind_all();
 	dm_dump_tree(device, extended, sort);
 
 	return 0;
@@ -103,6 +115,15 @@ static int do_dm_dump_uclass(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+#define DM_BIND_HELP	"bind          Bind all devices found in the device tree\n" \
+			"dm "
+#define DM_BIND		U_BOOT_SUBCMD_MKENT(bind, 1, 1, do_dm_bind),
+#else
+#define DM_BIND_HELP
+#define DM_BIND
+#endif
+
 #if CONFIG_IS_ENABLED(DM_STATS)
 #define DM_MEM_HELP	"dm mem           Provide a summary of memory usage\n"
 #define DM_MEM		U_BOOT_SUBCMD_MKENT(mem, 1, 1, do_dm_dump_mem),
@@ -112,6 +133,7 @@ static int do_dm_dump_uclass(struct cmd_tbl *cmdtp, int flag, int argc,
 #endif
 
 U_BOOT_LONGHELP(dm,
+	DM_BIND_HELP
 	"compat        Dump list of drivers with compatibility strings\n"
 	"dm devres        Dump list of device resources for each device\n"
 	"dm drivers       Dump list of drivers with uclass and instances\n"
@@ -121,6 +143,7 @@ U_BOOT_LONGHELP(dm,
 	"dm uclass [-e][name]     Dump list of instances for each uclass");
 
 U_BOOT_CMD_WITH_SUBCMDS(dm, "Driver model low level access", dm_help_text,
+	DM_BIND
 	U_BOOT_SUBCMD_MKENT(compat, 1, 1, do_dm_dump_driver_compat),
 	U_BOOT_SUBCMD_MKENT(devres, 1, 1, do_dm_dump_devres),
 	U_BOOT_SUBCMD_MKENT(drivers, 1, 1, do_dm_dump_drivers),
@@ -1573,6 +1573,70 @@ static int do_efi_query_info(struct cmd_tbl *cmdtp, int flag,
 	return CMD_RET_SUCCESS;
 }
 
+#if CONFIG_IS_ENABLED(EFI_STATS)
+/**
+ * do_efi_stats() - show statistics on UEFI service calls
+ *
+ * @cmdtp:	Command table
+ * @flag:	Command flag
+ * @argc:	Number of arguments
+ * @argv:	Argument array
+ * Return:	CMD_RET_SUCCESS on success,
+ *		CMD_RET_USAGE on failure
+ *
+ * Implement efidebug "stats" sub-command.
+ */
+static int do_efi_stats(struct cmd_tbl *cmdtp, int flag,
+			int argc, char * const argv[])
+{
+	if (argc > 2)
+		return CMD_RET_USAGE;
+
+	if (argc == 2) {
+		if (strcmp(argv[1], "-r"))
+			return CMD_RET_USAGE;
+		efi_stats_reset();
+		return CMD_RET_SUCCESS;
+	}
+
+	efi_stats_show();
+
+	return CMD_RET_SUCCESS;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(NETDEVICES)
+/**
+ * do_efi_net() - show statistics of the simple network protocol
+ *
+ * @cmdtp:	Command table
+ * @flag:	Command flag
+ * @argc:	Number of arguments
+ * @argv:	Argument array
+ * Return:	CMD_RET_SUCCESS on success,
+ *		CMD_RET_USAGE on failure
+ *
+ * Implement efidebug "net" sub-command.
+ */
+static int do_efi_net(struct cmd_tbl *cmdtp, int flag,
+		      int argc, char * const argv[])
+{
+	if (argc > 2)
+		return CMD_RET_USAGE;
+
+	if (argc == 2) {
+		if (strcmp(argv[1], "-r"))
+			return CMD_RET_USAGE;
+		efi_net_reset_stats();
+		return CMD_RET_SUCCESS;
+	}
+
+	efi_net_show_stats();
+
+	return CMD_RET_SUCCESS;
+}
+#endif
+
 static struct cmd_tbl cmd_efidebug_sub[] = {
 	U_BOOT_CMD_MKENT(boot, CONFIG_SYS_MAXARGS, 1, do_efi_boot_opt, "", ""),
 #ifdef CONFIG_EFI_HAVE_CAPSULE_SUPPORT
@@ -1595,6 +1659,13 @@ static struct cmd_tbl cmd_efidebug_sub[] = {
 			 "", ""),
 	U_BOOT_CMD_MKENT(query, CONFIG_SYS_MAXARGS, 1, do_efi_query_info,
 			 "", ""),
+#if CONFIG_IS_ENABLED(EFI_STATS)
+	U_BOOT_CMD_MKENT(stats, CONFIG_SYS_MAXARGS, 1, do_efi_stats,
+			 "", ""),
+#endif
+#if CONFIG_IS_ENABLED(NETDEVICES)
+	U_BOOT_CMD_MKENT(net, CONFIG_SYS_MAXARGS, 1, do_efi_net, "", ""),
+#endif
 };
 
 /**
@@ -1690,7 +1761,16 @@ U_BOOT_LONGHELP(efidebug,
 	"  - run simple bootmgr for test\n"
 #endif
 	"efidebug query [-nv][-bs][-rt][-at]\n"
-	"  - show size of UEFI variables store\n");
+	"  - show size of UEFI variables store\n"
+#if CONFIG_IS_ENABLED(EFI_STATS)
+	"efidebug stats [-r]\n"
+	"  - show (or with -r reset) UEFI service call statistics\n"
+#endif
+#if CONFIG_IS_ENABLED(NETDEVICES)
+	"efidebug net [-r]\n"
+	"  - show (or with -r reset) simple network protocol traffic\n"
+#endif
+	);
 
 U_BOOT_CMD(
 	efidebug, CONFIG_SYS_MAXARGS, 0, do_efidebug,
@@ -17,8 +17,26 @@ static int do_event_list(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(EVENT_STATS)
+static int do_event_stats(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	event_show_stats();
+
+	return 0;
+}
+#endif
+
 U_BOOT_LONGHELP(event,
-	"list - list event spies");
+	"list - list event spies"
+#if CONFIG_IS_ENABLED(EVENT_STATS)
+	"\nevent stats - show how often each event was sent and time taken"
+#endif
+	);
 
 U_BOOT_CMD_WITH_SUBCMDS(event, "Events", event_help_text,
-	U_BOOT_SUBCMD_MKENT(list, 1, 1, do_event_list));
+	U_BOOT_SUBCMD_MKENT(list, 1, 1, do_event_list),
+#if CONFIG_IS_ENABLED(EVENT_STATS)
+	U_BOOT_SUBCMD_MKENT(stats, 1, 1, do_event_stats),
+#endif
+);
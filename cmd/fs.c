@@ -6,7 +6,12 @@
  */
 
 #include <command.h>
+#include <env.h>
 #include <fs.h>
+#include <image.h>
+#include <log.h>
+#include <mapmem.h>
+#include <linux/libfdt.h>
 
 static int do_size_wrapper(struct cmd_tbl *cmdtp, int flag, int argc,
 			   char *const argv[])
@@ -28,9 +33,10 @@ static int do_load_wrapper(struct cmd_tbl *cmdtp, int flag, int argc,
 	return do_load(cmdtp, flag, argc, argv, FS_TYPE_ANY);
 }
 
-U_BOOT_CMD(
-	load,	7,	0,	do_load_wrapper,
-	"load binary file from a filesystem",
+U_BOOT_LONGHELP(load,
+#if IS_ENABLED(CONFIG_FS_LOAD_DECOMP)
+	"[-z] "
+#endif
 	"<interface> [<dev[:part]> [<addr> [<filename> [bytes [pos]]]]]\n"
 	"    - Load binary file 'filename' from partition 'part' on device\n"
 	"       type 'interface' instance 'dev' to address 'addr' in memory.\n"
@@ -38,7 +44,117 @@ U_BOOT_CMD(
 	"      If 'bytes' is 0 or omitted, the file is read until the end.\n"
 	"      'pos' gives the file byte position to start reading from.\n"
 	"      If 'pos' is 0 or omitted, the file is read from the start."
+#if IS_ENABLED(CONFIG_FS_LOAD_DECOMP)
+	"\n"
+	"    -z: decompress a gzip, zstd or LZ4 file while reading it.\n"
+	"      'bytes' then limits the size of the decompressed data and\n"
+	"      'pos' must be 0."
+#endif
+	);
+
+U_BOOT_CMD(
+	load,	8,	0,	do_load_wrapper,
+	"load binary file from a filesystem", load_help_text
+);
+
+#if IS_ENABLED(CONFIG_FIT_EXTERNAL_READ)
+/**
+ * struct fitload_source - file holding the FIT loaded by fitload
+ *
+ * @src: Source of the external data
+ * @ifname: Interface name
+ * @dev_part: Device and partition
+ * @fname: File name
+ */
+static struct fitload_source {
+	struct fit_ext_source src;
+	char ifname[16];
+	char dev_part[32];
+	char fname[256];
+} fitload_src;
+
+static int fitload_read(struct fit_ext_source *src, ulong pos, ulong size,
+			void *buf)
+{
+	struct fitload_source *fsrc = container_of(src, struct fitload_source,
+						   src);
+	loff_t actual;
+	int ret;
+
+	/* fs_read() closes the device, so select it again */
+	if (fs_set_blk_dev(fsrc->ifname, fsrc->dev_part, FS_TYPE_ANY))
+		return -ENODEV;
+	ret = fs_read(fsrc->fname, map_to_sysmem(buf), pos, size, &actual);
+	if (ret)
+		return ret;
+	if (actual != size)
+		return -EIO;
+
+	return 0;
+}
+
+static int do_fitload(struct cmd_tbl *cmdtp, int flag, int argc,
+		      char *const argv[])
+{
+	struct fitload_source *fsrc = &fitload_src;
+	struct fdt_header *fit;
+	ulong addr;
+	char *ep;
+	u32 size;
+
+	if (argc != 5)
+		return CMD_RET_USAGE;
+	addr = hextoul(argv[3], &ep);
+	if (ep == argv[3] || *ep != '\0')
+		return CMD_RET_USAGE;
+	if (strlen(argv[1]) >= sizeof(fsrc->ifname) ||
+	    strlen(argv[2]) >= sizeof(fsrc->dev_part) ||
+	    strlen(argv[4]) >= sizeof(fsrc->fname)) {
+		log_err("Argument too long\n");
+		return CMD_RET_FAILURE;
+	}
+
+	/* Drop any earlier source before overwriting its FIT */
+	fit_ext_set_source(NULL, NULL);
+	strcpy(fsrc->ifname, argv[1]);
+	strcpy(fsrc->dev_part, argv[2]);
+	strcpy(fsrc->fname, argv[4]);
+	fsrc->src.read = fitload_read;
+
+	/* Read the FDT header to find the size of the FIT header */
+	fit = map_sysmem(addr, 0);
+	if (fitload_read(&fsrc->src, 0, sizeof(*fit), fit) ||
+	    fdt_magic(fit) != FDT_MAGIC) {
+		log_err("Failed to load FIT header from '%s'\n", fsrc->fname);
+		return CMD_RET_FAILURE;
+	}
+	size = fdt_totalsize(fit);
+	if (fitload_read(&fsrc->src, 0, size, fit)) {
+		log_err("Failed to load '%s'\n", fsrc->fname);
+		return CMD_RET_FAILURE;
+	}
+	if (fit_check_format(fit, IMAGE_SIZE_INVAL)) {
+		log_err("'%s' is not a FIT\n", fsrc->fname);
+		return CMD_RET_FAILURE;
+	}
+	fit_ext_set_source(fit, &fsrc->src);
+	printf("%u bytes of FIT header read\n", size);
+
+	env_set_hex("fileaddr", addr);
+	env_set_hex("filesize", size);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	fitload,	5,	0,	do_fitload,
+	"load the header of a FIT from a filesystem",
+	"<interface> <dev[:part]> <addr> <filename>\n"
+	"    - Load the header of FIT 'filename' from partition 'part' on\n"
+	"      device type 'interface' instance 'dev' to address 'addr'.\n"
+	"      External data of the FIT is read from the file when used."
 );
+#endif
 
 static int do_save_wrapper(struct cmd_tbl *cmdtp, int flag, int argc,
 			   char *const argv[])
@@ -11,13 +11,58 @@
 
 #include <command.h>
 #include <hash.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <vsprintf.h>
 #include <linux/ctype.h>
 
-#if IS_ENABLED(CONFIG_HASH_VERIFY)
-#define HARGS 6
-#else
-#define HARGS 5
-#endif
+/* Hash each of several address/count pairs, in parallel where possible */
+static int do_hash_multi(const char *algo_name, int argc, char *const argv[])
+{
+	struct hash_region regions[(CONFIG_SYS_MAXARGS - 3) / 2];
+	int count = argc / 2;
+	struct hash_algo *algo;
+	u8 *output;
+	int i, j, ret;
+
+	if (!count || argc % 2)
+		return CMD_RET_USAGE;
+	if (hash_lookup_algo(algo_name, &algo)) {
+		printf("Unknown hash algorithm '%s'\n", algo_name);
+		return CMD_RET_USAGE;
+	}
+
+	output = malloc(count * HASH_MAX_DIGEST_SIZE);
+	if (!output)
+		return CMD_RET_FAILURE;
+	for (i = 0; i < count; i++) {
+		ulong len = hextoul(argv[2 * i + 1], NULL);
+
+		regions[i].data = map_sysmem(hextoul(argv[2 * i], NULL), len);
+		regions[i].len = len;
+		regions[i].output = output + i * HASH_MAX_DIGEST_SIZE;
+	}
+
+	ret = hash_block_multi(algo_name, regions, count);
+	for (i = 0; !ret && i < count; i++) {
+		ulong addr = map_to_sysmem(regions[i].data);
+
+		printf("%s for %08lx ... %08lx ==> ", algo->name, addr,
+		       addr + regions[i].len - 1);
+		for (j = 0; j < algo->digest_size; j++)
+			printf("%02x", regions[i].output[j]);
+		printf("\n");
+	}
+	for (i = 0; i < count; i++)
+		unmap_sysmem(regions[i].data);
+	free(output);
+	if (ret) {
+		printf("Cannot hash (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
 
 static int do_hash(struct cmd_tbl *cmdtp, int flag, int argc,
 		   char *const argv[])
@@ -28,6 +73,12 @@ static int do_hash(struct cmd_tbl *cmdtp, int flag, int argc,
 	if (argc < 4)
 		return CMD_RET_USAGE;
 
+	if (!strcmp(argv[1], "-m")) {
+		for (s = argv[2]; *s; s++)
+			*s = tolower(*s);
+		return do_hash_multi(argv[2], argc - 3, argv + 3);
+	}
+
 #if IS_ENABLED(CONFIG_HASH_VERIFY)
 	if (!strcmp(argv[1], "-v")) {
 		flags |= HASH_FLAG_VERIFY;
@@ -44,10 +95,13 @@ static int do_hash(struct cmd_tbl *cmdtp, int flag, int argc,
 }
 
 U_BOOT_CMD(
-	hash,	HARGS,	1,	do_hash,
+	hash,	CONFIG_SYS_MAXARGS,	1,	do_hash,
 	"compute hash message digest",
 	"algorithm address count [[*]hash_dest]\n"
-		"    - compute message digest [save to env var / *address]"
+		"    - compute message digest [save to env var / *address]\n"
+	"hash -m algorithm address count [address count ...]\n"
+		"    - compute the message digests of several areas, in\n"
+		"      parallel on several CPUs where possible"
 #if IS_ENABLED(CONFIG_HASH_VERIFY)
 	"\nhash -v algorithm address count [*]hash\n"
 		"    - verify message digest of memory area to immediate value, \n"
@@ -225,6 +225,23 @@ static int do_host_dev(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+static int do_host_timing(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	struct udevice *dev;
+
+	if (argc < 3)
+		return CMD_RET_USAGE;
+
+	dev = parse_host_label(argv[1]);
+	if (!dev)
+		return CMD_RET_FAILURE;
+	host_set_timing(dev, dectoul(argv[2], NULL),
+			argc > 3 ? dectoul(argv[3], NULL) : 0);
+
+	return 0;
+}
+
 static struct cmd_tbl cmd_host_sub[] = {
 	U_BOOT_CMD_MKENT(load, 7, 0, do_host_load, "", ""),
 	U_BOOT_CMD_MKENT(ls, 3, 0, do_host_ls, "", ""),
@@ -234,6 +251,7 @@ static struct cmd_tbl cmd_host_sub[] = {
 	U_BOOT_CMD_MKENT(unbind, 4, 0, do_host_unbind, "", ""),
 	U_BOOT_CMD_MKENT(info, 3, 0, do_host_info, "", ""),
 	U_BOOT_CMD_MKENT(dev, 0, 1, do_host_dev, "", ""),
+	U_BOOT_CMD_MKENT(timing, 4, 0, do_host_timing, "", ""),
 };
 
 static int do_host(struct cmd_tbl *cmdtp, int flag, int argc,
@@ -268,6 +286,8 @@ U_BOOT_CMD(
 	"host unbind <label>     - unbind file from \"host\" device\n"
 	"host info [<label>]     - show device binding & info\n"
 	"host dev [<label>]      - set or retrieve the current host device\n"
+	"host timing <label> <latency_us> [<MB/s>] - slow transfers down to\n"
+	"     model a real device\n"
 	"host commands use the \"hostfs\" device. The \"host\" device is used\n"
 	"with standard IO commands such as fatls or ext2load"
 );
@@ -279,10 +279,8 @@ static int do_log_filter_remove(struct cmd_tbl *cmdtp, int flag, int argc,
 		}
 
 		list_for_each_entry_safe(filt, tmp_filt, &ldev->filter_head,
-					 sibling_node) {
-			list_del(&filt->sibling_node);
-			free(filt);
-		}
+					 sibling_node)
+			log_remove_filter(drv_name, filt->filter_num);
 	} else {
 		if (gs.index + 1 != argc)
 			return CMD_RET_USAGE;
@@ -375,6 +373,24 @@ static int do_log_rec(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+static int do_log_dump(struct cmd_tbl *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+	bool clear = false;
+
+	if (argc > 1) {
+		if (strcmp(argv[1], "-c"))
+			return CMD_RET_USAGE;
+		clear = true;
+	}
+	if (log_ringbuf_dump(clear)) {
+		printf("No log ring buffer\n");
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+
 U_BOOT_LONGHELP(log,
 	"level [<level>] - get/set log level\n"
 	"categories - list log categories\n"
@@ -405,7 +421,9 @@ U_BOOT_LONGHELP(log,
 	"\tc=category, l=level, F=file, L=line number, f=function, m=msg\n"
 	"\tor 'default', or 'all' for all\n"
 	"log rec <category> <level> <file> <line> <func> <message> - "
-		"output a log record");
+		"output a log record\n"
+	"log dump [-c] - show messages held in the log ring buffer\n"
+	"\t-c - Clear the buffer afterwards");
 
 U_BOOT_CMD_WITH_SUBCMDS(log, "log system", log_help_text,
 	U_BOOT_SUBCMD_MKENT(level, 2, 1, do_log_level),
@@ -417,4 +435,5 @@ U_BOOT_CMD_WITH_SUBCMDS(log, "log system", log_help_text,
 	U_BOOT_SUBCMD_MKENT(filter-remove, 4, 1, do_log_filter_remove),
 	U_BOOT_SUBCMD_MKENT(format, 2, 1, do_log_format),
 	U_BOOT_SUBCMD_MKENT(rec, 7, 1, do_log_rec),
+	U_BOOT_SUBCMD_MKENT(dump, 2, 1, do_log_dump),
 );
@@ -15,22 +15,29 @@
 #include <cli.h>
 #include <command.h>
 #include <console.h>
+#include <cpu_func.h>
 #include <display_options.h>
+#include <dma.h>
 #ifdef CONFIG_MTD_NOR_FLASH
 #include <flash.h>
 #endif
 #include <hash.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <rand.h>
 #include <time.h>
 #include <watchdog.h>
+#include <asm/cache.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
 #include <linux/bitops.h>
 #include <linux/compiler.h>
 #include <linux/ctype.h>
 #include <linux/delay.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
+#include <u-boot/crc.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -359,7 +366,8 @@ static int do_mem_cp(struct cmd_tbl *cmdtp, int flag, int argc,
 	}
 #endif
 
-	memmove(dst, src, count * size);
+	if (dma_memcpy_offload(dst, src, count * size))
+		memmove(dst, src, count * size);
 
 	unmap_sysmem(src);
 	unmap_sysmem(dst);
@@ -1058,6 +1066,288 @@ static ulong mem_test_quick(vu_long *buf, ulong start_addr, ulong end_addr,
 	return errs;
 }
 
+/*
+ * The parallel test works a line of MTEST_LINE_WORDS words at a time, with
+ * the range split into MTEST_JOB_SIZE pieces which are shared out among the
+ * CPUs. The cache is cleaned and invalidated after each piece is written, so
+ * that the following reads come from the memory itself.
+ */
+#define MTEST_LINE_WORDS	8
+#define MTEST_LINE_SIZE		(MTEST_LINE_WORDS * sizeof(ulong))
+#define MTEST_ALIGN		max_t(ulong, MTEST_LINE_SIZE, ARCH_DMA_MINALIGN)
+#define MTEST_JOB_SIZE		SZ_16M
+
+/**
+ * struct mtest_pat - values written by a test pattern
+ *
+ * The value of each word is @base, XORed with its address if @addr is set and
+ * with @alt if it is an odd word.
+ *
+ * @base: Base value
+ * @alt: Value XORed into odd words
+ * @addr: true to XOR the address of the word into the value
+ */
+struct mtest_pat {
+	ulong base;
+	ulong alt;
+	bool addr;
+};
+
+/**
+ * struct mtest_job - a piece of the range, tested by one CPU at a time
+ *
+ * @buf: Start of the piece
+ * @addr: Address of @buf, as shown to the user
+ * @size: Size of the piece in bytes, a multiple of MTEST_ALIGN
+ * @errs: Number of mismatches found in the piece by the current step
+ * @fail_addr: Address of the first mismatch
+ * @fail_expect: Value expected at @fail_addr
+ * @fail_found: Value read from @fail_addr
+ */
+struct mtest_job {
+	ulong *buf;
+	ulong addr;
+	ulong size;
+	ulong errs;
+	ulong fail_addr;
+	ulong fail_expect;
+	ulong fail_found;
+};
+
+/**
+ * struct mtest_ctx - state of the parallel memory test
+ *
+ * @jobs: Pieces of the range
+ * @njobs: Number of pieces
+ * @size: Total size of the range in bytes
+ * @check: Pattern to check each line against in the current step, or NULL
+ * @fill: Pattern to then write to each line in the current step, or NULL
+ * @down: true to go through the lines from the top down
+ */
+struct mtest_ctx {
+	struct mtest_job *jobs;
+	uint njobs;
+	ulong size;
+	const struct mtest_pat *check;
+	const struct mtest_pat *fill;
+	bool down;
+};
+
+#ifdef CONFIG_ARM64
+/* Use non-temporal pairs, so the test streams through the cache */
+static inline void mtest_store_line(ulong *p, const ulong *v)
+{
+	asm volatile("stnp %1, %2, [%0]\n\t"
+		     "stnp %3, %4, [%0, #16]\n\t"
+		     "stnp %5, %6, [%0, #32]\n\t"
+		     "stnp %7, %8, [%0, #48]"
+		     : : "r" (p), "r" (v[0]), "r" (v[1]), "r" (v[2]),
+		       "r" (v[3]), "r" (v[4]), "r" (v[5]), "r" (v[6]),
+		       "r" (v[7])
+		     : "memory");
+}
+
+static inline void mtest_load_line(const ulong *p, ulong *v)
+{
+	asm volatile("ldnp %0, %1, [%8]\n\t"
+		     "ldnp %2, %3, [%8, #16]\n\t"
+		     "ldnp %4, %5, [%8, #32]\n\t"
+		     "ldnp %6, %7, [%8, #48]"
+		     : "=&r" (v[0]), "=&r" (v[1]), "=&r" (v[2]),
+		       "=&r" (v[3]), "=&r" (v[4]), "=&r" (v[5]),
+		       "=&r" (v[6]), "=&r" (v[7])
+		     : "r" (p)
+		     : "memory");
+}
+#else
+static inline void mtest_store_line(ulong *p, const ulong *v)
+{
+	int i;
+
+	for (i = 0; i < MTEST_LINE_WORDS; i++)
+		((vu_long *)p)[i] = v[i];
+}
+
+static inline void mtest_load_line(const ulong *p, ulong *v)
+{
+	int i;
+
+	for (i = 0; i < MTEST_LINE_WORDS; i++)
+		v[i] = ((const vu_long *)p)[i];
+}
+#endif
+
+static inline void mtest_line_values(const struct mtest_pat *pat, ulong addr,
+				     ulong *v)
+{
+	int i;
+
+	for (i = 0; i < MTEST_LINE_WORDS; i++, addr += sizeof(ulong))
+		v[i] = pat->base ^ (pat->addr ? addr : 0) ^ (i & 1 ? pat->alt : 0);
+}
+
+static void mtest_check_line(struct mtest_job *mj, const ulong *p, ulong addr,
+			     const struct mtest_pat *pat)
+{
+	ulong found[MTEST_LINE_WORDS], expect[MTEST_LINE_WORDS];
+	int i;
+
+	mtest_load_line(p, found);
+	mtest_line_values(pat, addr, expect);
+	for (i = 0; i < MTEST_LINE_WORDS; i++) {
+		if (found[i] == expect[i])
+			continue;
+		if (!mj->errs++) {
+			mj->fail_addr = addr + i * sizeof(ulong);
+			mj->fail_expect = expect[i];
+			mj->fail_found = found[i];
+		}
+	}
+}
+
+/* Run the current step on one piece; this runs on any of the CPUs */
+static int mtest_run_job(void *priv, uint cpu, uint job)
+{
+	struct mtest_ctx *ctx = priv;
+	struct mtest_job *mj = &ctx->jobs[job];
+	ulong nlines = mj->size / MTEST_LINE_SIZE;
+	ulong v[MTEST_LINE_WORDS];
+	ulong i, line, addr;
+	ulong *p;
+
+	for (i = 0; i < nlines; i++) {
+		line = ctx->down ? nlines - 1 - i : i;
+		p = mj->buf + line * MTEST_LINE_WORDS;
+		addr = mj->addr + line * MTEST_LINE_SIZE;
+		if (ctx->check)
+			mtest_check_line(mj, p, addr, ctx->check);
+		if (ctx->fill) {
+			mtest_line_values(ctx->fill, addr, v);
+			mtest_store_line(p, v);
+		}
+	}
+	if (ctx->fill)
+		flush_dcache_range((ulong)mj->buf, (ulong)mj->buf + mj->size);
+
+	return 0;
+}
+
+static ulong mtest_step(struct mtest_ctx *ctx, const struct mtest_pat *check,
+			const struct mtest_pat *fill, bool down)
+{
+	const int plen = 2 * sizeof(ulong);
+	struct mtest_job *mj;
+	ulong errs = 0;
+	uint i;
+
+	ctx->check = check;
+	ctx->fill = fill;
+	ctx->down = down;
+	for (i = 0; i < ctx->njobs; i++)
+		ctx->jobs[i].errs = 0;
+
+	cpu_work_run(mtest_run_job, ctx, ctx->njobs, cpu_work_cpus());
+	schedule();
+
+	for (i = 0, mj = ctx->jobs; i < ctx->njobs; i++, mj++) {
+		if (!mj->errs)
+			continue;
+		printf("Mem error @ 0x%0*lX: found %0*lX, expected %0*lX, bits %0*lX (%lu errors in piece)\n",
+		       plen, mj->fail_addr, plen, mj->fail_found, plen,
+		       mj->fail_expect, plen, mj->fail_found ^ mj->fail_expect,
+		       mj->errs);
+		errs += mj->errs;
+	}
+
+	return errs;
+}
+
+/*
+ * Write @pat and read it back. With @inv, then also make a moving-inversions
+ * sweep up through memory, checking @pat and writing @inv, and one down,
+ * checking @inv and writing @pat, before reading @pat back.
+ */
+static ulong mtest_pass(struct mtest_ctx *ctx, const char *name,
+			const struct mtest_pat *pat,
+			const struct mtest_pat *inv)
+{
+	ulong start_us = timer_get_us();
+	uint sweeps = 2;
+	ulong errs, us;
+
+	errs = mtest_step(ctx, NULL, pat, false);
+	if (inv) {
+		errs += mtest_step(ctx, pat, inv, false);
+		errs += mtest_step(ctx, inv, pat, true);
+		sweeps += 4;
+	}
+	errs += mtest_step(ctx, pat, NULL, false);
+
+	us = max(timer_get_us() - start_us, 1UL);
+	printf("  %-20s %6llu MB/s\n", name,
+	       div_u64((u64)ctx->size * sweeps, us));
+
+	return errs;
+}
+
+/*
+ * Run a walking bit, an address-in-address and a moving inversions pass over
+ * the range, on all the CPUs which can run jobs. The walking bit moves on
+ * with each iteration, alternating between walking ones and walking zeros.
+ */
+static ulong mem_test_parallel(vu_long *buf, ulong start_addr, ulong end_addr,
+			       ulong pattern, int iteration)
+{
+	struct mtest_pat walk = { .alt = ~0UL };
+	struct mtest_pat addr = { .addr = true };
+	struct mtest_pat naddr = { .base = ~0UL, .addr = true };
+	struct mtest_pat pat = { .base = pattern };
+	struct mtest_pat inv = { .base = ~pattern };
+	struct mtest_ctx ctx;
+	ulong start, end, errs;
+	int bit = iteration % BITS_PER_LONG;
+	char name[20];
+	uint i;
+
+	start = ALIGN(start_addr, MTEST_ALIGN);
+	end = ALIGN_DOWN(end_addr, MTEST_ALIGN);
+	if (end <= start) {
+		printf("\nRange too small\n");
+		return -1UL;
+	}
+
+	ctx.size = end - start;
+	ctx.njobs = DIV_ROUND_UP(ctx.size, MTEST_JOB_SIZE);
+	ctx.jobs = calloc(ctx.njobs, sizeof(*ctx.jobs));
+	if (!ctx.jobs) {
+		printf("\nOut of memory\n");
+		return -1UL;
+	}
+	for (i = 0; i < ctx.njobs; i++) {
+		struct mtest_job *mj = &ctx.jobs[i];
+
+		mj->addr = start + (ulong)i * MTEST_JOB_SIZE;
+		mj->buf = (ulong *)buf + (mj->addr - start_addr) / sizeof(ulong);
+		mj->size = min_t(ulong, end - mj->addr, MTEST_JOB_SIZE);
+	}
+
+	walk.base = 1UL << bit;
+	if ((iteration / BITS_PER_LONG) & 1)
+		walk.base = ~walk.base;
+	snprintf(name, sizeof(name), "walking %s %d",
+		 walk.base & (1UL << bit) ? "one" : "zero", bit);
+
+	puts("\n");
+	errs = mtest_pass(&ctx, name, &walk, NULL);
+	if (!ctrlc())
+		errs += mtest_pass(&ctx, "address", &addr, &naddr);
+	if (!ctrlc())
+		errs += mtest_pass(&ctx, "moving inversions", &pat, &inv);
+	free(ctx.jobs);
+
+	return errs;
+}
+
 /*
  * Perform a memory test. A more complete alternative test can be
  * configured using CONFIG_SYS_ALT_MEMTEST. The complete test loops until
@@ -1114,7 +1404,10 @@ static int do_mem_mtest(struct cmd_tbl *cmdtp, int flag, int argc,
 
 		printf("Iteration: %6d\r", iteration + 1);
 		debug("\n");
-		if (IS_ENABLED(CONFIG_SYS_ALT_MEMTEST)) {
+		if (IS_ENABLED(CONFIG_SYS_MEMTEST_PARALLEL)) {
+			errs = mem_test_parallel(buf, start, end, pattern,
+						 iteration);
+		} else if (IS_ENABLED(CONFIG_SYS_ALT_MEMTEST)) {
 			errs = mem_test_alt(buf, start, end, dummy);
 			if (errs == -1UL)
 				break;
@@ -1241,6 +1534,69 @@ mod_mem(struct cmd_tbl *cmdtp, int incrflag, int flag, int argc,
 
 #ifdef CONFIG_CMD_CRC32
 
+#ifdef CONFIG_CMD_CRC32_BENCH
+static uint32_t crc32c_bench_table[256];
+
+static uint32_t crc32c_table_wrap(uint32_t crc, const unsigned char *buf,
+				  uint len)
+{
+	return crc32c_cal_table(crc, (const char *)buf, len,
+				crc32c_bench_table);
+}
+
+static uint32_t crc32c_hw_wrap(uint32_t crc, const unsigned char *buf,
+			       uint len)
+{
+	return crc32c_cal_hw(crc, (const char *)buf, len);
+}
+
+static void crc32_bench_one(const char *name,
+			    uint32_t (*fn)(uint32_t crc,
+					   const unsigned char *buf, uint len),
+			    const void *buf, ulong len)
+{
+	ulong start, us;
+	uint32_t crc;
+
+	start = timer_get_us();
+	crc = fn(~0U, buf, len);
+	us = max(timer_get_us() - start, 1UL);
+
+	printf("%-14s %08x %8lu us %6lu MB/s\n", name, ~crc, us, len / us);
+}
+
+static int do_crc32_bench(int argc, char *const argv[])
+{
+	ulong addr, len;
+	const void *buf;
+
+	if (argc != 3)
+		return CMD_RET_USAGE;
+
+	addr = hextoul(argv[1], NULL);
+	len = hextoul(argv[2], NULL);
+	buf = map_sysmem(addr, len);
+
+	if (!IS_ENABLED(CONFIG_ARM64_CRC32) ||
+	    IS_ENABLED(CONFIG_ARM64_CRC32_DETECT))
+		crc32_bench_one("crc32 table", crc32_no_comp_table, buf, len);
+	if (IS_ENABLED(CONFIG_ARM64_CRC32) && crc32_hw_available())
+		crc32_bench_one("crc32 arm64", crc32_no_comp_hw, buf, len);
+
+	if (IS_ENABLED(CONFIG_CRC32C)) {
+		crc32c_init(crc32c_bench_table, 0x82f63b78);
+		crc32_bench_one("crc32c table", crc32c_table_wrap, buf, len);
+		if (IS_ENABLED(CONFIG_ARM64_CRC32) && crc32_hw_available())
+			crc32_bench_one("crc32c arm64", crc32c_hw_wrap, buf,
+					len);
+	}
+
+	unmap_sysmem(buf);
+
+	return 0;
+}
+#endif
+
 static int do_mem_crc(struct cmd_tbl *cmdtp, int flag, int argc,
 		      char *const argv[])
 {
@@ -1260,12 +1616,97 @@ static int do_mem_crc(struct cmd_tbl *cmdtp, int flag, int argc,
 		ac--;
 	}
 #endif
+#ifdef CONFIG_CMD_CRC32_BENCH
+	if (strcmp(*av, "-b") == 0)
+		return do_crc32_bench(ac, av);
+#endif
 
 	return hash_command("crc32", flags, cmdtp, flag, ac, av);
 }
 
 #endif
 
+#ifdef CONFIG_CMD_MEMBENCH
+/*
+ * Word-at-a-time copies matching the generic lib/string.c routines, kept
+ * here so they can be timed even when the assembly versions are enabled
+ */
+static noinline void membench_copy_word(void *dest, const void *src,
+					ulong count)
+{
+	ulong *dl = dest;
+	const ulong *sl = src;
+
+	for (; count >= sizeof(ulong); count -= sizeof(ulong))
+		*dl++ = *sl++;
+}
+
+static noinline void membench_set_word(void *dest, int c, ulong count)
+{
+	ulong *dl = dest;
+	ulong cl = (c & 0xff) * (~0UL / 0xff);
+
+	for (; count >= sizeof(ulong); count -= sizeof(ulong))
+		*dl++ = cl;
+}
+
+static void membench_show(const char *name, ulong start, ulong len)
+{
+	ulong us = max(timer_get_us() - start, 1UL);
+
+	printf("%-14s %8lu us %6lu MB/s\n", name, us, len / us);
+}
+
+static int do_membench(struct cmd_tbl *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+	ulong dst_addr, src_addr, len, start;
+	void *dst;
+	const void *src;
+	int ret = 0;
+
+	if (argc != 4)
+		return CMD_RET_USAGE;
+
+	dst_addr = hextoul(argv[1], NULL);
+	src_addr = hextoul(argv[2], NULL);
+	len = hextoul(argv[3], NULL) & ~(sizeof(ulong) - 1);
+	if (!len)
+		return CMD_RET_USAGE;
+	dst = map_sysmem(dst_addr, len);
+	src = map_sysmem(src_addr, len);
+
+	start = timer_get_us();
+	membench_copy_word(dst, src, len);
+	membench_show("memcpy word", start, len);
+
+	start = timer_get_us();
+	memcpy(dst, src, len);
+	membench_show("memcpy", start, len);
+	if (memcmp(dst, src, len)) {
+		puts("memcpy: data mismatch\n");
+		ret = CMD_RET_FAILURE;
+	}
+
+	start = timer_get_us();
+	membench_set_word(dst, 0, len);
+	membench_show("memset word", start, len);
+
+	start = timer_get_us();
+	memset(dst, 0, len);
+	membench_show("memset 0", start, len);
+
+	start = timer_get_us();
+	memset(dst, 0xa5, len);
+	membench_show("memset 0xa5", start, len);
+
+	unmap_sysmem(src);
+	unmap_sysmem(dst);
+
+	return ret;
+}
+#endif
+
 #ifdef CONFIG_CMD_RANDOM
 static int do_random(struct cmd_tbl *cmdtp, int flag, int argc,
 		     char *const argv[])
@@ -1364,6 +1805,9 @@ U_BOOT_CMD(
 	crc32,	4,	1,	do_mem_crc,
 	"checksum calculation",
 	"address count [addr]\n    - compute CRC32 checksum [save at addr]"
+#ifdef CONFIG_CMD_CRC32_BENCH
+	"\n-b address count\n    - time each CRC32 implementation"
+#endif
 );
 
 #else	/* CONFIG_CRC32_VERIFY */
@@ -1373,6 +1817,9 @@ U_BOOT_CMD(
 	"checksum calculation",
 	"address count [addr]\n    - compute CRC32 checksum [save at addr]\n"
 	"-v address count crc\n    - verify crc of memory area"
+#ifdef CONFIG_CMD_CRC32_BENCH
+	"\n-b address count\n    - time each CRC32 implementation"
+#endif
 );
 
 #endif	/* CONFIG_CRC32_VERIFY */
@@ -1422,6 +1869,17 @@ U_BOOT_CMD(
 );
 #endif /* CONFIG_CMD_MX_CYCLIC */
 
+#ifdef CONFIG_CMD_MEMBENCH
+U_BOOT_CMD(
+	membench,	4,	0,	do_membench,
+	"time memcpy() and memset() on a memory area",
+	"<dst> <src> <len>\n"
+	"   - Copy 'len' bytes from 'src' to 'dst' and fill 'dst', once with\n"
+	"     the built-in routines and once a word at a time, and report\n"
+	"     the throughput of each in MB/s\n"
+);
+#endif
+
 #ifdef CONFIG_CMD_RANDOM
 U_BOOT_CMD(
 	random,	4,	0,	do_random,
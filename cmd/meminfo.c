@@ -55,6 +55,11 @@ static int do_meminfo(struct cmd_tbl *cmdtp, int flag, int argc,
 	puts("DRAM:  ");
 	print_size(gd->ram_size, "\n");
 
+	if (IS_ENABLED(CONFIG_SYS_MALLOC_ARENA)) {
+		puts("\nmalloc():\n");
+		malloc_stats();
+	}
+
 	if (!IS_ENABLED(CONFIG_CMD_MEMINFO_MAP))
 		return 0;
 
@@ -8,6 +8,7 @@
 #include <command.h>
 #include <console.h>
 #include <display_options.h>
+#include <fat.h>
 #include <mapmem.h>
 #include <memalign.h>
 #include <mmc.h>
@@ -158,6 +159,11 @@ static struct mmc *__init_mmc_device(int dev, bool force_init,
 	struct blk_desc *bd = mmc_get_blk_desc(mmc);
 	blkcache_invalidate(bd->uclass_id, bd->devnum);
 #endif
+	/* the card may have been changed */
+	if (force_init) {
+		part_cache_invalidate(mmc_get_blk_desc(mmc), 0, 0);
+		fat_cache_invalidate_blk(mmc_get_blk_desc(mmc), 0, 0);
+	}
 
 	return mmc;
 }
@@ -189,6 +195,37 @@ static int do_mmcinfo(struct cmd_tbl *cmdtp, int flag, int argc,
 	return CMD_RET_SUCCESS;
 }
 
+#if CONFIG_IS_ENABLED(BLK_STATS)
+static int do_mmc_stats(struct cmd_tbl *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	struct blk_desc *desc;
+	struct mmc *mmc;
+
+	if (argc > 1 && strcmp(argv[1], "reset"))
+		return CMD_RET_USAGE;
+
+	mmc = init_mmc_device(curr_device, false);
+	if (!mmc)
+		return CMD_RET_FAILURE;
+	desc = mmc_get_blk_desc(mmc);
+
+	if (argc > 1) {
+		memset(&mmc->stats, '\0', sizeof(mmc->stats));
+		if (desc)
+			blk_stats_reset(desc->bdev);
+		return CMD_RET_SUCCESS;
+	}
+
+	printf("Commands: %lu, %lu failed, %lu retried\n", mmc->stats.cmds,
+	       mmc->stats.cmd_errors, mmc->stats.retries);
+	if (desc)
+		blk_stats_show(desc->bdev);
+
+	return CMD_RET_SUCCESS;
+}
+#endif
+
 #if CONFIG_IS_ENABLED(CMD_MMC_RPMB)
 static int confirm_key_prog(void)
 {
@@ -429,6 +466,7 @@ static int do_mmc_sparse_write(struct cmd_tbl *cmdtp, int flag,
 	sparse.size = dev_desc->lba - blk;
 	sparse.write = mmc_sparse_write;
 	sparse.reserve = mmc_sparse_reserve;
+	sparse.erase = NULL;
 	sparse.mssg = NULL;
 	sprintf(dest, "0x" LBAF, sparse.start * sparse.blksz);
 
@@ -1242,6 +1280,9 @@ static struct cmd_tbl cmd_mmc[] = {
 	U_BOOT_CMD_MKENT(part, 1, 1, do_mmc_part, "", ""),
 	U_BOOT_CMD_MKENT(dev, 4, 0, do_mmc_dev, "", ""),
 	U_BOOT_CMD_MKENT(list, 1, 1, do_mmc_list, "", ""),
+#if CONFIG_IS_ENABLED(BLK_STATS)
+	U_BOOT_CMD_MKENT(stats, 2, 1, do_mmc_stats, "", ""),
+#endif
 #if CONFIG_IS_ENABLED(MMC_HW_PARTITIONING)
 	U_BOOT_CMD_MKENT(hwpartition, 28, 0, do_mmc_hwpartition, "", ""),
 #endif
@@ -1309,6 +1350,9 @@ U_BOOT_CMD(
 	"    [MMC_LEGACY, MMC_HS, SD_HS, MMC_HS_52, MMC_DDR_52, UHS_SDR12, UHS_SDR25,\n"
 	"    UHS_SDR50, UHS_DDR50, UHS_SDR104, MMC_HS_200, MMC_HS_400, MMC_HS_400_ES]\n"
 	"mmc list - lists available devices\n"
+#if CONFIG_IS_ENABLED(BLK_STATS)
+	"mmc stats [reset] - show or clear transfer statistics of the current device\n"
+#endif
 	"mmc wp [PART] - power on write protect boot partitions\n"
 	"  arguments:\n"
 	"   PART - [0|1]\n"
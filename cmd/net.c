@@ -80,6 +80,26 @@ U_BOOT_CMD(
 );
 #endif
 
+#ifdef CONFIG_CMD_MTFTPBOOT
+static int do_mtftpb(struct cmd_tbl *cmdtp, int flag, int argc,
+		     char *const argv[])
+{
+	int ret;
+
+	bootstage_mark_name(BOOTSTAGE_KERNELREAD_START, "tftp_start");
+	ret = netboot_common(MTFTPGET, cmdtp, argc, argv);
+	bootstage_mark_name(BOOTSTAGE_KERNELREAD_STOP, "tftp_done");
+	return ret;
+}
+
+U_BOOT_CMD(
+	mtftpboot,	3,	1,	do_mtftpb,
+	"load file via network using TFTP multicast (RFC 2090)",
+	"[loadAddress] [[hostIPaddr:]bootfilename]\n"
+	"Falls back to unicast TFTP for the blocks missed from the group."
+);
+#endif
+
 #ifdef CONFIG_CMD_TFTPSRV
 static int do_tftpsrv(struct cmd_tbl *cmdtp, int flag, int argc,
 		      char *const argv[])
@@ -952,6 +952,11 @@ static int print_env_info(void)
 	value = gd->flags & GD_FLG_ENV_DEFAULT ? "true" : "false";
 	printf("env_use_default = %s\n", value);
 
+	/* print hash table usage */
+	printf("env_entries = %u/%u\n", env_htab.filled, env_htab.size);
+	printf("env_lookups = %lu (%lu probes, %lu compares)\n",
+	       env_htab.lookups, env_htab.probes, env_htab.compares);
+
 	return CMD_RET_SUCCESS;
 }
 
@@ -140,6 +140,7 @@ int pxe_get(ulong pxefile_addr_r, char **bootdirp, ulong *sizep, bool use_ipv6)
 	if (pxe_setup_ctx(&ctx, cmdtp, do_get_tftp, NULL, false,
 			  env_get("bootfile"), use_ipv6, false))
 		return -ENOMEM;
+	ctx.cache = true;
 
 	if (IS_ENABLED(CONFIG_BOOTP_PXE_DHCP_OPTION) &&
 	    pxelinux_configfile && !use_ipv6) {
@@ -292,6 +293,7 @@ do_pxe_boot(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 		printf("Out of memory\n");
 		return CMD_RET_FAILURE;
 	}
+	ctx.cache = true;
 	ret = pxe_process(&ctx, pxefile_addr_r, false);
 	pxe_destroy_ctx(&ctx);
 	if (ret)
@@ -19,6 +19,7 @@
 #include <asm/cache.h>
 #include <jffs2/jffs2.h>
 #include <linux/mtd/mtd.h>
+#include <linux/sizes.h>
 
 #include <asm/io.h>
 #include <dm/device-internal.h>
@@ -164,8 +165,53 @@ static int do_spi_flash_probe(int argc, char *const argv[])
 }
 
 /**
- * Write a block of data to SPI flash, first checking if it is different from
- * what is already there.
+ * Write an area of SPI flash which has just been erased. Pages which are all
+ * 0xff already hold that data, so they are not programmed.
+ *
+ * @param flash		flash context pointer
+ * @param offset	flash offset to write
+ * @param len		number of bytes to write
+ * @param buf		buffer to write from
+ * Return: 0 if OK, else -ve error code
+ */
+static int spi_flash_write_erased(struct spi_flash *flash, u32 offset,
+				  size_t len, const char *buf)
+{
+	size_t pos, todo, start = 0;
+	bool pending = false;
+	int ret;
+
+	for (pos = 0; pos < len; pos += todo) {
+		todo = min_t(size_t, len - pos,
+			     flash->page_size - (offset + pos) % flash->page_size);
+		if (!memchr_inv(buf + pos, 0xff, todo)) {
+			if (pending) {
+				ret = spi_flash_write(flash, offset + start,
+						      pos - start, buf + start);
+				if (ret)
+					return ret;
+				pending = false;
+			}
+		} else if (!pending) {
+			start = pos;
+			pending = true;
+		}
+	}
+	if (pending)
+		return spi_flash_write(flash, offset + start, len - start,
+				       buf + start);
+
+	return 0;
+}
+
+/**
+ * Write a block of data to SPI flash, first checking which sectors differ
+ * from what is already there.
+ *
+ * The sectors covering the block are read in one go. Each run of sectors which
+ * need to change is then erased with a single call, so that the flash can use
+ * a larger erase command where the run covers one. The data of partial sectors
+ * is preserved.
  *
  * If the data being written is the same, then *skipped is incremented by len.
  *
@@ -173,40 +219,56 @@ static int do_spi_flash_probe(int argc, char *const argv[])
  * @param offset	flash offset to write
  * @param len		number of bytes to write
  * @param buf		buffer to write from
- * @param cmp_buf	read buffer to use to compare data
+ * @param cmp_buf	read buffer to use to compare data, big enough for all
+ *			the sectors covering the block
  * @param skipped	Count of skipped data (incremented by this function)
  * Return: NULL if OK, else a string containing the stage which failed
  */
 static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
 		size_t len, const char *buf, char *cmp_buf, size_t *skipped)
 {
-	char *ptr = (char *)buf;
-	u32 start_offset = offset % flash->sector_size;
-	u32 read_offset = offset - start_offset;
+	u32 sector_size = flash->sector_size;
+	u32 read_offset = offset - offset % sector_size;
+	u32 start_offset = offset - read_offset;
+	u32 read_len = roundup(start_offset + len, sector_size);
+	u32 sect, lo, hi, run = 0;
+	bool dirty;
 
 	debug("offset=%#x+%#x, sector_size=%#x, len=%#zx\n",
-	      read_offset, start_offset, flash->sector_size, len);
-	/* Read the entire sector so to allow for rewriting */
-	if (spi_flash_read(flash, read_offset, flash->sector_size, cmp_buf))
+	      read_offset, start_offset, sector_size, len);
+	/* Read all the sectors so to allow for rewriting */
+	if (spi_flash_read(flash, read_offset, read_len, cmp_buf))
 		return "read";
-	/* Compare only what is meaningful (len) */
-	if (memcmp(cmp_buf + start_offset, buf, len) == 0) {
-		debug("Skip region %x+%x size %zx: no change\n",
-		      start_offset, read_offset, len);
-		*skipped += len;
-		return NULL;
-	}
-	/* Erase the entire sector */
-	if (spi_flash_erase(flash, offset, flash->sector_size))
-		return "erase";
-	/* If it's a partial sector, copy the data into the temp-buffer */
-	if (len != flash->sector_size) {
-		memcpy(cmp_buf + start_offset, buf, len);
-		ptr = cmp_buf;
-	}
-	/* Write one complete sector */
-	if (spi_flash_write(flash, offset, flash->sector_size, ptr))
-		return "write";
+
+	for (sect = 0; sect <= read_len; sect += sector_size) {
+		dirty = false;
+		if (sect < read_len) {
+			/* Compare only what is meaningful */
+			lo = max(sect, start_offset);
+			hi = min_t(u32, sect + sector_size, start_offset + len);
+			dirty = memcmp(cmp_buf + lo, buf + lo - start_offset,
+				       hi - lo);
+			if (dirty)
+				memcpy(cmp_buf + lo, buf + lo - start_offset,
+				       hi - lo);
+			else
+				*skipped += hi - lo;
+		}
+		if (dirty) {
+			run += sector_size;
+			continue;
+		}
+		if (!run)
+			continue;
+
+		/* Erase and write the run of sectors which changed */
+		if (spi_flash_erase(flash, read_offset + sect - run, run))
+			return "erase";
+		if (spi_flash_write_erased(flash, read_offset + sect - run, run,
+					   cmp_buf + sect - run))
+			return "write";
+		run = 0;
+	}
 
 	return NULL;
 }
@@ -232,18 +294,22 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 	const ulong start_time = get_timer(0);
 	size_t scale = 1;
 	const char *start_buf = buf;
+	u32 block_size;
 	ulong delta;
 
 	if (end - buf >= 200)
 		scale = (end - buf) / 100;
-	cmp_buf = memalign(ARCH_DMA_MINALIGN, flash->sector_size);
+	/* handle several sectors at a time, if they are small */
+	block_size = flash->sector_size;
+	if (!(SZ_64K % block_size))
+		block_size = SZ_64K;
+	cmp_buf = memalign(ARCH_DMA_MINALIGN, block_size);
 	if (cmp_buf) {
 		ulong last_update = get_timer(0);
 
 		for (; buf < end && !err_oper; buf += todo, offset += todo) {
-			todo = min_t(size_t, end - buf, flash->sector_size);
 			todo = min_t(size_t, end - buf,
-				     flash->sector_size - (offset % flash->sector_size));
+				     block_size - (offset % block_size));
 			if (get_timer(last_update) > 100) {
 				printf("   \rUpdating, %zu%% %lu B/s",
 				       100 - (end - buf) / scale,
@@ -585,6 +651,99 @@ static int do_spi_flash_test(int argc, char *const argv[])
 	return 0;
 }
 
+#ifdef CONFIG_CMD_SF_BENCH
+static int spi_flash_bench_mode(ulong offset, ulong len, u8 *buf,
+				const u8 *ref)
+{
+	enum spi_nor_protocol proto = flash->read_proto;
+	u64 speed;
+	ulong us;
+	int ret;
+
+	printf("%u-%u-%u%s\t", spi_nor_get_protocol_inst_nbits(proto),
+	       spi_nor_get_protocol_addr_nbits(proto),
+	       spi_nor_get_protocol_data_nbits(proto),
+	       spi_nor_protocol_is_dtr(proto) ? "D" : "");
+
+	us = timer_get_us();
+	ret = spi_flash_read(flash, offset, len, buf);
+	us = timer_get_us() - us;
+	if (ret) {
+		printf("read failed (err = %d)\n", ret);
+		return ret;
+	}
+
+	speed = (u64)len * 1000000;
+	do_div(speed, max(us, 1UL) * 1024);
+	printf("%lu us, %llu KiB/s%s\n", us, speed,
+	       ref && memcmp(buf, ref, len) ? ", data mismatch" : "");
+
+	return 0;
+}
+
+static int do_spi_flash_bench(int argc, char *const argv[])
+{
+	u8 opcode = flash->read_opcode, dummy = flash->read_dummy;
+	enum spi_nor_protocol proto = flash->read_proto;
+	unsigned long offset, len;
+	u8 *buf, *ref;
+	char *endp;
+	int cap;
+
+	if (argc < 3)
+		return CMD_RET_USAGE;
+	offset = hextoul(argv[1], &endp);
+	if (*argv[1] == 0 || *endp != 0)
+		return CMD_RET_USAGE;
+	len = hextoul(argv[2], &endp);
+	if (*argv[2] == 0 || *endp != 0 || !len)
+		return CMD_RET_USAGE;
+	if (offset + len > flash->size) {
+		printf("Read out of flash bounds\n");
+		return CMD_RET_FAILURE;
+	}
+
+	ref = memalign(ARCH_DMA_MINALIGN, len);
+	buf = memalign(ARCH_DMA_MINALIGN, len);
+	if (!ref || !buf) {
+		printf("Cannot allocate memory (%lu bytes)\n", len);
+		free(ref);
+		free(buf);
+		return CMD_RET_FAILURE;
+	}
+
+	printf("Probed mode: ");
+	if (spi_flash_bench_mode(offset, len, ref, NULL))
+		goto out;
+
+	for (cap = fls(flash->read_hwcaps) - 1; cap >= 0; cap--) {
+		if (spi_nor_set_read_mode(flash, BIT(cap)))
+			continue;
+
+		if (flash->read_opcode == opcode && flash->read_proto == proto)
+			continue;
+
+		/* Would need the flash switched to another mode first */
+		if (spi_nor_get_protocol_inst_nbits(flash->read_proto) !=
+		    spi_nor_get_protocol_inst_nbits(proto) ||
+		    spi_nor_protocol_is_dtr(flash->read_proto) !=
+		    spi_nor_protocol_is_dtr(proto))
+			continue;
+
+		spi_flash_bench_mode(offset, len, buf, ref);
+	}
+
+out:
+	flash->read_opcode = opcode;
+	flash->read_proto = proto;
+	flash->read_dummy = dummy;
+	free(buf);
+	free(ref);
+
+	return 0;
+}
+#endif
+
 static int do_spi_flash(struct cmd_tbl *cmdtp, int flag, int argc,
 			char *const argv[])
 {
@@ -617,6 +776,10 @@ static int do_spi_flash(struct cmd_tbl *cmdtp, int flag, int argc,
 		ret = do_spi_protect(argc, argv);
 	else if (IS_ENABLED(CONFIG_CMD_SF_TEST) && !strcmp(cmd, "test"))
 		ret = do_spi_flash_test(argc, argv);
+#ifdef CONFIG_CMD_SF_BENCH
+	else if (!strcmp(cmd, "bench"))
+		ret = do_spi_flash_bench(argc, argv);
+#endif
 	else
 		ret = CMD_RET_USAGE;
 
@@ -644,6 +807,10 @@ U_BOOT_LONGHELP(sf,
 #endif
 #ifdef CONFIG_CMD_SF_TEST
 	"\nsf test offset len		- run a very basic destructive test"
+#endif
+#ifdef CONFIG_CMD_SF_BENCH
+	"\nsf bench offset len		- measure the read throughput of each\n"
+	"					  supported read mode"
 #endif
 	);
 
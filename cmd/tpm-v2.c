@@ -482,6 +482,33 @@ static int do_tpm_pcr_setauthvalue(struct cmd_tbl *cmdtp, int flag,
 							key, key_sz));
 }
 
+static int do_tpm2_stats(struct cmd_tbl *cmdtp, int flag, int argc,
+			 char *const argv[])
+{
+	struct tpm_chip_priv *priv;
+	struct udevice *dev;
+	int ret;
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset")))
+		return CMD_RET_USAGE;
+
+	ret = get_tpm(&dev);
+	if (ret)
+		return ret;
+
+	priv = dev_get_uclass_priv(dev);
+	if (argc == 2) {
+		priv->xfer_count = 0;
+		priv->xfer_us = 0;
+		return 0;
+	}
+	printf("Commands: %u\n", priv->xfer_count);
+	printf("Time:     %lu.%03lu ms\n", priv->xfer_us / 1000,
+	       priv->xfer_us % 1000);
+
+	return 0;
+}
+
 static struct cmd_tbl tpm2_commands[] = {
 	U_BOOT_CMD_MKENT(device, 0, 1, do_tpm_device, "", ""),
 	U_BOOT_CMD_MKENT(info, 0, 1, do_tpm_info, "", ""),
@@ -502,6 +529,7 @@ static struct cmd_tbl tpm2_commands[] = {
 	U_BOOT_CMD_MKENT(pcr_setauthvalue, 0, 1,
 			 do_tpm_pcr_setauthvalue, "", ""),
 	U_BOOT_CMD_MKENT(pcr_allocate, 0, 1, do_tpm2_pcrallocate, "", ""),
+	U_BOOT_CMD_MKENT(stats, 0, 1, do_tpm2_stats, "", ""),
 };
 
 struct cmd_tbl *get_tpm2_commands(unsigned int *size)
@@ -595,4 +623,7 @@ U_BOOT_CMD(tpm2, CONFIG_SYS_MAXARGS, 1, do_tpm, "Issue a TPMv2.x command",
 "        * off - Clear all available PCRs associated with the specified\n"
 "                algorithm (bank)\n"
 "    <password>: optional password\n"
+"stats [reset]\n"
+"    Show the number of commands sent to the TPM and the time they took,\n"
+"    or reset the counts\n"
 );
@@ -417,6 +417,9 @@ static int abortboot(int bootdelay)
 {
 	int abort = 0;
 
+	if (IS_ENABLED(CONFIG_AUTOBOOT_PRELOAD) && bootdelay > 0)
+		autoboot_preload_start();
+
 	if (bootdelay >= 0) {
 		if (autoboot_keyed())
 			abort = abortboot_key_sequence(bootdelay);
@@ -424,6 +427,11 @@ static int abortboot(int bootdelay)
 			abort = abortboot_single_key(bootdelay);
 	}
 
+	if (abort)
+		autoboot_preload_discard();
+	else
+		autoboot_preload_stop();
+
 	if (IS_ENABLED(CONFIG_SILENT_CONSOLE) && abort)
 		gd->flags &= ~GD_FLG_SILENT;
 
@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Reading the boot files while the autoboot countdown runs
+ *
+ * The countdown spends bootdelay seconds polling for a key. The files listed
+ * in the 'bootpreload' environment variable are read to their load addresses
+ * during that time, a chunk on each call of a cyclic function. When bootcmd
+ * then loads one of them, do_load() asks autoboot_preload_find() whether the
+ * data is already in place, which is checked with the CRC32 taken when the
+ * read finished.
+ */
+
+#define LOG_CATEGORY LOGC_BOOT
+
+#include <autoboot.h>
+#include <cyclic.h>
+#include <env.h>
+#include <fs.h>
+#include <lmb.h>
+#include <log.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <vsprintf.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <u-boot/crc.h>
+
+#define PRELOAD_VAR		"bootpreload"
+
+enum {
+	PRELOAD_MAX_FILES	= 4,
+};
+
+/**
+ * struct preload_file - a file to read during the countdown
+ *
+ * @ifname: Interface, e.g. "mmc"
+ * @dev_part: Device and partition, e.g. "0:1"
+ * @fname: Filename
+ * @addr: Load address
+ * @size: Size of the file, or -1 if not known yet
+ * @done: Number of bytes read so far
+ * @crc: CRC32 of the data, valid when @done is @size
+ */
+struct preload_file {
+	char *ifname;
+	char *dev_part;
+	char *fname;
+	ulong addr;
+	loff_t size;
+	loff_t done;
+	u32 crc;
+};
+
+/**
+ * struct preload_info - state of the preload
+ *
+ * @cyclic: Cyclic function which reads the next chunk
+ * @str: Copy of the environment variable, which the file strings point into
+ * @count: Number of files in @file
+ * @cur: Index of the file being read; @count once all are done
+ * @file: Files to read
+ */
+static struct preload_info {
+	struct cyclic_info cyclic;
+	char *str;
+	int count;
+	int cur;
+	struct preload_file file[PRELOAD_MAX_FILES];
+} preload_info;
+
+static bool preload_complete(const struct preload_file *pf)
+{
+	return pf->size >= 0 && pf->done == pf->size;
+}
+
+/* Give up on the current file, leaving it out of autoboot_preload_find() */
+static void preload_next(struct preload_info *info, bool failed)
+{
+	struct preload_file *pf = &info->file[info->cur];
+
+	if (failed) {
+		log_debug("Cannot preload '%s'\n", pf->fname);
+		pf->size = -1;
+	}
+	info->cur++;
+}
+
+static void preload_cyclic(struct cyclic_info *c)
+{
+	struct preload_info *info = container_of(c, struct preload_info,
+						 cyclic);
+	struct preload_file *pf;
+	loff_t len, actual;
+	void *buf;
+
+	if (info->cur == info->count) {
+		cyclic_unregister(c);
+		return;
+	}
+	pf = &info->file[info->cur];
+
+	if (fs_set_blk_dev(pf->ifname, pf->dev_part, FS_TYPE_ANY))
+		goto fail;
+	if (pf->size < 0) {
+		if (fs_size(pf->fname, &pf->size))
+			goto fail;
+		if (CONFIG_IS_ENABLED(LMB) &&
+		    lmb_get_free_size(pf->addr) < pf->size)
+			goto fail;
+		if (pf->size)
+			return;
+	} else {
+		len = min_t(loff_t, pf->size - pf->done,
+			    CONFIG_AUTOBOOT_PRELOAD_CHUNK);
+		if (fs_read(pf->fname, pf->addr + pf->done, pf->done, len,
+			    &actual) || actual != len)
+			goto fail;
+		pf->done += len;
+		if (pf->done != pf->size)
+			return;
+	}
+
+	buf = map_sysmem(pf->addr, pf->size);
+	pf->crc = crc32(0, buf, pf->size);
+	unmap_sysmem(buf);
+	log_debug("Preloaded '%s', %llx bytes\n", pf->fname, pf->size);
+	preload_next(info, false);
+	return;
+
+fail:
+	preload_next(info, true);
+}
+
+/* Get the next word from @strp, or NULL if there are no more */
+static char *preload_word(char **strp)
+{
+	char *word;
+
+	do {
+		word = strsep(strp, " ");
+	} while (word && !*word);
+
+	return word;
+}
+
+/* Parse the variable into @info, with the strings pointing into @str */
+static int preload_parse(struct preload_info *info, char *str)
+{
+	char *p, *ent, *ifname, *addr, *end;
+
+	for (p = str; (ent = strsep(&p, ";"));) {
+		struct preload_file *pf;
+
+		ifname = preload_word(&ent);
+		if (!ifname)
+			continue;
+		if (info->count == PRELOAD_MAX_FILES)
+			return -E2BIG;
+		pf = &info->file[info->count];
+		pf->ifname = ifname;
+		pf->dev_part = preload_word(&ent);
+		addr = preload_word(&ent);
+		pf->fname = preload_word(&ent);
+		if (!pf->fname || preload_word(&ent))
+			return -EINVAL;
+
+		pf->addr = hextoul(addr, &end);
+		if (*end)
+			pf->addr = env_get_hex(addr, 0);
+		if (!pf->addr)
+			return -EINVAL;
+		pf->size = -1;
+		info->count++;
+	}
+
+	return 0;
+}
+
+int autoboot_preload_start(void)
+{
+	struct preload_info *info = &preload_info;
+	const char *val;
+	int ret;
+
+	autoboot_preload_discard();
+	val = env_get(PRELOAD_VAR);
+	if (!val)
+		return 0;
+
+	info->str = strdup(val);
+	if (!info->str)
+		return log_msg_ret("pre", -ENOMEM);
+	ret = preload_parse(info, info->str);
+	if (ret) {
+		log_warning("Ignoring invalid '%s'\n", PRELOAD_VAR);
+		autoboot_preload_discard();
+		return log_msg_ret("prp", ret);
+	}
+	if (!info->count)
+		return 0;
+
+	cyclic_register(&info->cyclic, preload_cyclic, 0, "preload");
+
+	/* each call reads a whole chunk, which is expected to be slow */
+	info->cyclic.already_warned = true;
+
+	return info->count;
+}
+
+void autoboot_preload_stop(void)
+{
+	struct preload_info *info = &preload_info;
+
+	if (info->count)
+		cyclic_unregister(&info->cyclic);
+}
+
+void autoboot_preload_discard(void)
+{
+	struct preload_info *info = &preload_info;
+
+	autoboot_preload_stop();
+	free(info->str);
+	memset(info, '\0', sizeof(*info));
+}
+
+int autoboot_preload_find(const char *ifname, const char *dev_part,
+			  const char *fname, ulong addr, loff_t len,
+			  loff_t *sizep)
+{
+	struct preload_info *info = &preload_info;
+	void *buf;
+	u32 crc;
+	int i;
+
+	for (i = 0; i < info->count; i++) {
+		struct preload_file *pf = &info->file[i];
+
+		if (!preload_complete(pf) || pf->addr != addr ||
+		    strcmp(pf->ifname, ifname) ||
+		    strcmp(pf->dev_part, dev_part ? dev_part : "") ||
+		    strcmp(pf->fname, fname))
+			continue;
+		if (len && len != pf->size)
+			break;
+
+		/* check that nothing has written over it since */
+		buf = map_sysmem(addr, pf->size);
+		crc = crc32(0, buf, pf->size);
+		unmap_sysmem(buf);
+		if (crc != pf->crc) {
+			log_debug("Preloaded '%s' changed\n", fname);
+			break;
+		}
+		*sizep = pf->size;
+
+		return 0;
+	}
+
+	return -ENOENT;
+}
@@ -61,6 +61,9 @@ static struct tag_name {
 	{ BLOBLISTT_U_BOOT_SPL_HANDOFF, "SPL hand-off" },
 	{ BLOBLISTT_VBE, "VBE" },
 	{ BLOBLISTT_U_BOOT_VIDEO, "SPL video handoff" },
+	{ BLOBLISTT_U_BOOT_LOG, "Log ring buffer" },
+	{ BLOBLISTT_U_BOOT_MMC_MODE, "MMC bus modes" },
+	{ BLOBLISTT_U_BOOT_MMC_HANDOFF, "MMC card hand-off" },
 
 	/* BLOBLISTT_VENDOR_AREA */
 };
@@ -128,14 +131,126 @@ static struct bloblist_rec *bloblist_next_blob(struct bloblist_hdr *hdr,
 	     _rec; \
 	     _rec = bloblist_next_blob(_hdr, _rec))
 
+#if CONFIG_IS_ENABLED(BLOBLIST_INDEX)
+enum {
+	BLOBLIST_INDEX_MAX	= 32,
+};
+
+/**
+ * struct bloblist_index - offsets of the records in a bloblist, by tag
+ *
+ * @hdr: Bloblist which this indexes, or NULL if none
+ * @used_size: Used size of the bloblist when the index was built
+ * @count: Number of entries in @tag and @ofs
+ * @full: true if the bloblist has more tags than the index can hold, in which
+ *	case tags not in the index must be looked up in the bloblist
+ * @tag: Tag of each record, with just the first record for each tag
+ * @ofs: Offset of each record from the start of the bloblist
+ */
+struct bloblist_index {
+	struct bloblist_hdr *hdr;
+	uint used_size;
+	int count;
+	bool full;
+	u32 tag[BLOBLIST_INDEX_MAX];
+	u32 ofs[BLOBLIST_INDEX_MAX];
+};
+
+static void bloblist_index_build(struct bloblist_index *idx,
+				 struct bloblist_hdr *hdr)
+{
+	struct bloblist_rec *rec;
+	uint tag;
+	int i;
+
+	idx->hdr = hdr;
+	idx->used_size = hdr->used_size;
+	idx->count = 0;
+	idx->full = false;
+	foreach_rec(rec, hdr) {
+		tag = rec_tag(rec);
+		for (i = 0; i < idx->count && idx->tag[i] != tag; i++)
+			;
+		if (i < idx->count)
+			continue;
+		if (idx->count == BLOBLIST_INDEX_MAX) {
+			idx->full = true;
+			break;
+		}
+		idx->tag[idx->count] = tag;
+		idx->ofs[idx->count++] = (void *)rec - (void *)hdr;
+	}
+}
+
+/**
+ * bloblist_index_find() - look up a tag in the index, building it if needed
+ *
+ * Records are only added at the end, which changes the used size, so the
+ * index is rebuilt when that changes. Other changes must call
+ * bloblist_index_invalidate()
+ *
+ * @hdr: Bloblist to search
+ * @tag: Tag to find
+ * @recp: Returns the record, if found
+ * Return: 0 if found, -ENOENT if not in the bloblist, -EAGAIN if the index
+ *	cannot say
+ */
+static int bloblist_index_find(struct bloblist_hdr *hdr, uint tag,
+			       struct bloblist_rec **recp)
+{
+	struct bloblist_index *idx = gd->bloblist_index;
+	int i;
+
+	if (!idx) {
+		idx = malloc(sizeof(*idx));
+		if (!idx)
+			return -EAGAIN;
+		idx->hdr = NULL;
+		gd->bloblist_index = idx;
+	}
+	if (idx->hdr != hdr || idx->used_size != hdr->used_size)
+		bloblist_index_build(idx, hdr);
+
+	for (i = 0; i < idx->count; i++) {
+		if (idx->tag[i] == tag) {
+			*recp = (void *)hdr + idx->ofs[i];
+			return 0;
+		}
+	}
+
+	return idx->full ? -EAGAIN : -ENOENT;
+}
+
+static void bloblist_index_invalidate(void)
+{
+	if (gd->bloblist_index)
+		gd->bloblist_index->hdr = NULL;
+}
+#else
+static int bloblist_index_find(struct bloblist_hdr *hdr, uint tag,
+			       struct bloblist_rec **recp)
+{
+	return -EAGAIN;
+}
+
+static void bloblist_index_invalidate(void)
+{
+}
+#endif /* BLOBLIST_INDEX */
+
 static struct bloblist_rec *bloblist_findrec(uint tag)
 {
 	struct bloblist_hdr *hdr = gd->bloblist;
 	struct bloblist_rec *rec;
+	int ret;
 
 	if (!hdr)
 		return NULL;
 
+	ret = bloblist_index_find(hdr, tag, &rec);
+	if (ret != -EAGAIN)
+		return ret ? NULL : rec;
+
 	foreach_rec(rec, hdr) {
 		if (rec_tag(rec) == tag)
 			return rec;
@@ -322,6 +437,7 @@ static int bloblist_resize_rec(struct bloblist_hdr *hdr,
 	if (next_ofs != hdr->used_size) {
 		memmove((void *)hdr + next_ofs + expand_by,
 			(void *)hdr + next_ofs, new_alloced - next_ofs);
+		bloblist_index_invalidate();
 	}
 	hdr->used_size = new_alloced;
 
@@ -382,6 +498,7 @@ int bloblist_new(ulong addr, uint size, uint flags, uint align_log2)
 	hdr->align_log2 = align_log2 ? align_log2 : BLOBLIST_BLOB_ALIGN_LOG2;
 	hdr->chksum = 0;
 	gd->bloblist = hdr;
+	bloblist_index_invalidate();
 
 	return 0;
 }
@@ -409,6 +526,7 @@ int bloblist_check(ulong addr, uint size)
 		return log_msg_ret("Bad checksum", -EIO);
 	}
 	gd->bloblist = hdr;
+	bloblist_index_invalidate();
 
 	return 0;
 }
@@ -491,7 +609,8 @@ int bloblist_reloc(void *to, uint to_size)
 	if (to_size < gd->bloblist->total_size)
 		return -ENOSPC;
 
-	memcpy(to, gd->bloblist, gd->bloblist->total_size);
+	/* the rest is zeroed as each blob is added */
+	memcpy(to, gd->bloblist, gd->bloblist->used_size);
 	hdr = to;
 	hdr->total_size = to_size;
 	gd->bloblist = to;
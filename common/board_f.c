@@ -490,6 +490,12 @@ static int reserve_uboot(void)
 
 		debug("Reserving %dk for U-Boot at: %08lx\n",
 		      gd->mon_len >> 10, gd->relocaddr);
+	} else if (IS_ENABLED(CONFIG_SKIP_RELOCATE) &&
+		   gd->relocaddr < map_to_sysmem(__bss_end)) {
+		/* the reserved areas would overlap the running image */
+		printf("No room above U-Boot at %08lx (top %08lx)\n",
+		       (ulong)map_to_sysmem(__bss_end), gd->relocaddr);
+		return -ENOSPC;
 	}
 
 	gd->start_addr_sp = gd->relocaddr;
@@ -624,6 +630,10 @@ static int reserve_stacks(void)
 static int reserve_bloblist(void)
 {
 #ifdef CONFIG_BLOBLIST
+	/* a bloblist which is kept in place is reserved in lmb instead */
+	if (IS_ENABLED(CONFIG_BLOBLIST_KEEP_FIXED))
+		return 0;
+
 	/* Align to a 4KB boundary for easier reading of addresses */
 	gd->start_addr_sp = ALIGN_DOWN(gd->start_addr_sp -
 				       CONFIG_BLOBLIST_SIZE_RELOC, 0x1000);
@@ -677,7 +687,9 @@ static int reloc_fdt(void)
 static int reloc_bootstage(void)
 {
 #ifdef CONFIG_BOOTSTAGE
-	if (gd->flags & GD_FLG_SKIP_RELOC)
+	/* SKIP_RELOCATE still leaves the early malloc() area behind */
+	if ((gd->flags & GD_FLG_SKIP_RELOC) &&
+	    !IS_ENABLED(CONFIG_SKIP_RELOCATE))
 		return 0;
 	if (gd->boardf->new_bootstage)
 		bootstage_relocate(gd->boardf->new_bootstage);
@@ -1026,6 +1038,8 @@ void board_init_f(ulong boot_flags)
 
 	gd->flags = boot_flags;
 	gd->flags &= ~GD_FLG_HAVE_CONSOLE;
+	if (IS_ENABLED(CONFIG_SKIP_RELOCATE))
+		gd->flags |= GD_FLG_SKIP_RELOC;
 	gd->boardf = &boardf;
 
 	if (initcall_run_list(init_sequence_f))
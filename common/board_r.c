@@ -161,6 +161,14 @@ static int initr_reloc_global_data(void)
 	if (IS_ENABLED(CONFIG_OF_EMBED))
 		fdtdec_setup_embed();
 
+#if CONFIG_IS_ENABLED(OF_LIBFDT_INDEX)
+	/* Indexes built before relocation are not in the new malloc() area */
+	memset(gd->fdt_index, '\0', sizeof(gd->fdt_index));
+#endif
+#if CONFIG_IS_ENABLED(BLOBLIST_INDEX)
+	gd->bloblist_index = NULL;
+#endif
+
 #ifdef CONFIG_EFI_LOADER
 	/*
 	 * On the ARM architecture gd is mapped to a fixed register (r9 or x18).
@@ -169,7 +177,9 @@ static int initr_reloc_global_data(void)
 	 */
 	efi_save_gd();
 
-	efi_runtime_relocate(gd->relocaddr, NULL);
+	/* the runtime code is already at its link address */
+	if (!(gd->flags & GD_FLG_SKIP_RELOC))
+		efi_runtime_relocate(gd->relocaddr, NULL);
 #endif
 
 	return 0;
@@ -18,6 +18,7 @@
 #include <spl.h>
 #include <asm/global_data.h>
 #include <linux/compiler.h>
+#include <linux/kernel.h>
 #include <linux/libfdt.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -34,10 +35,57 @@ struct bootstage_record {
 	enum bootstage_id id;
 };
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+enum {
+	SPAN_COUNT	= CONFIG_BOOTSTAGE_SPAN_COUNT,
+	SPAN_NAME_LEN	= 20,
+	SPAN_DEPTH	= 8,
+};
+
+/**
+ * struct bootstage_span - accounting of all spans with the same name
+ *
+ * The name is held here rather than pointed to, so that names of drivers
+ * seen before relocation remain valid after it.
+ *
+ * @name: Name of the spans
+ * @count: Number of spans ended
+ * @total_us: Total time of the spans, in microseconds
+ * @self_us: Total time not spent in nested spans, in microseconds
+ * @max_us: Longest span, in microseconds
+ */
+struct bootstage_span {
+	char name[SPAN_NAME_LEN];
+	u32 count;
+	u32 total_us;
+	u32 self_us;
+	u32 max_us;
+};
+
+/**
+ * struct bootstage_span_frame - a span which has not ended yet
+ *
+ * @start_us: Time the span started
+ * @child_us: Time spent in nested spans so far
+ * @span: Index of the span in the span table, or -1 if it is full
+ */
+struct bootstage_span_frame {
+	u32 start_us;
+	u32 child_us;
+	int span;
+};
+#endif
+
 struct bootstage_data {
 	uint rec_count;
 	uint next_id;
 	struct bootstage_record record[RECORD_COUNT];
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	uint span_count;
+	uint span_depth;
+	struct bootstage_span span[SPAN_COUNT];
+	struct bootstage_span_frame frame[SPAN_DEPTH];
+#endif
 };
 
 enum {
@@ -220,6 +268,122 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+uint32_t bootstage_add_accum(const char *name, uint32_t time_us)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_record *rec;
+
+	if (!data)
+		return time_us;
+
+	rec = ensure_id(data, data->next_id++);
+	if (!rec) {
+		log_warning("Bootstage space exhausted\n");
+		return time_us;
+	}
+	/* A start time marks the record as an accumulator */
+	rec->start_us = timer_get_boot_us() ?: 1;
+	rec->name = name;
+	rec->time_us = time_us;
+
+	return time_us;
+}
+
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+/**
+ * find_span() - find or add the span table entry for a name
+ *
+ * @data: Bootstage data
+ * @name: Span name
+ * Return: index of the entry, or -1 if the table is full
+ */
+static int find_span(struct bootstage_data *data, const char *name)
+{
+	struct bootstage_span *span;
+	int i;
+
+	for (i = 0; i < data->span_count; i++) {
+		if (!strncmp(data->span[i].name, name, SPAN_NAME_LEN - 1))
+			return i;
+	}
+	if (data->span_count == SPAN_COUNT)
+		return -1;
+
+	span = &data->span[data->span_count];
+	strlcpy(span->name, name, SPAN_NAME_LEN);
+
+	return data->span_count++;
+}
+
+void bootstage_span_begin(const char *name)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_span_frame *frame;
+
+	if (!data)
+		return;
+
+	/* Spans nested too deeply are only counted for their depth */
+	if (data->span_depth++ >= SPAN_DEPTH)
+		return;
+	frame = &data->frame[data->span_depth - 1];
+	frame->span = find_span(data, name);
+	frame->child_us = 0;
+	frame->start_us = timer_get_boot_us();
+}
+
+void bootstage_span_end(void)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_span_frame *frame;
+	struct bootstage_span *span;
+	u32 duration;
+
+	if (!data || !data->span_depth)
+		return;
+	if (data->span_depth-- > SPAN_DEPTH)
+		return;
+
+	frame = &data->frame[data->span_depth];
+	duration = (u32)timer_get_boot_us() - frame->start_us;
+	if (data->span_depth)
+		frame[-1].child_us += duration;
+	if (frame->span < 0)
+		return;
+
+	span = &data->span[frame->span];
+	span->count++;
+	span->total_us += duration;
+	span->self_us += duration - min(frame->child_us, duration);
+	span->max_us = max(span->max_us, duration);
+}
+
+static void print_spans(struct bootstage_data *data)
+{
+	struct bootstage_span *span;
+	int i;
+
+	if (!data->span_count)
+		return;
+
+	printf("\nSpans:\n%7s%11s%11s%11s  %s\n", "Count", "Total", "Self",
+	       "Max", "Name");
+	for (i = 0, span = data->span; i < data->span_count; i++, span++) {
+		printf("%7u", span->count);
+		print_grouped_ull(span->total_us, BOOTSTAGE_DIGITS);
+		print_grouped_ull(span->self_us, BOOTSTAGE_DIGITS);
+		print_grouped_ull(span->max_us, BOOTSTAGE_DIGITS);
+		printf("  %s\n", span->name);
+	}
+	if (data->span_count == SPAN_COUNT)
+		printf("Span table full, please increase CONFIG_BOOTSTAGE_SPAN_COUNT\n");
+}
+#else
+static void print_spans(struct bootstage_data *data)
+{
+}
+#endif
+
 /**
  * Get a record name as a printable string
  *
@@ -312,6 +476,33 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 			return -EINVAL;
 	}
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	if (data->span_count) {
+		int spans, node;
+
+		spans = fdt_add_subnode(blob, bootstage, "spans");
+		if (spans < 0)
+			return -EINVAL;
+
+		/* As above, add them in reverse to list them in order */
+		for (recnum = data->span_count - 1; recnum >= 0; recnum--) {
+			struct bootstage_span *span = &data->span[recnum];
+
+			node = fdt_add_subnode(blob, spans, simple_itoa(recnum));
+			if (node < 0)
+				break;
+			if (fdt_setprop_string(blob, node, "name", span->name) ||
+			    fdt_setprop_cell(blob, node, "count", span->count) ||
+			    fdt_setprop_cell(blob, node, "total",
+					     span->total_us) ||
+			    fdt_setprop_cell(blob, node, "self",
+					     span->self_us) ||
+			    fdt_setprop_cell(blob, node, "max", span->max_us))
+				return -EINVAL;
+		}
+	}
+#endif
+
 	return 0;
 }
 
@@ -351,6 +542,8 @@ void bootstage_report(void)
 		if (rec->start_us)
 			prev = print_time_record(rec, -1);
 	}
+
+	print_spans(data);
 }
 
 /**
@@ -84,6 +84,7 @@
 #include <cli_hush.h>
 #include <command.h>        /* find_cmd */
 #include <asm/global_data.h>
+#include <u-boot/crc.h>
 #endif
 #ifndef __U_BOOT__
 #include <ctype.h>     /* isalpha, isdigit */
@@ -331,6 +332,8 @@ struct in_str {
 	int promptmode;
 #ifndef __U_BOOT__
 	FILE *file;
+#else
+	struct hush_cache_entry *cache;	/* script being added to the cache */
 #endif
 	int (*get) (struct in_str *);
 	int (*peek) (struct in_str *);
@@ -1155,6 +1158,8 @@ static void setup_file_in_str(struct in_str *i)
 	i->promptmode=1;
 #ifndef __U_BOOT__
 	i->file = f;
+#else
+	i->cache = NULL;
 #endif
 	i->p = NULL;
 }
@@ -1165,6 +1170,9 @@ static void setup_string_in_str(struct in_str *i, const char *s)
 	i->get = static_get;
 	i->__promptme=1;
 	i->promptmode=1;
+#ifdef __U_BOOT__
+	i->cache = NULL;
+#endif
 	i->p = s;
 }
 
@@ -1535,6 +1543,7 @@ static int run_pipe_real(struct pipe *pi)
 	struct child_prog *child;
 	struct built_in_command *x;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1547,6 +1556,7 @@ static int run_pipe_real(struct pipe *pi)
 	int flag = do_repeat ? CMD_FLAG_REPEAT : 0;
 	struct child_prog *child;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1613,6 +1623,11 @@ static int run_pipe_real(struct pipe *pi)
 			}
 			return EXIT_SUCCESS;   /* don't worry about errors in set_local_var() yet */
 		}
+		/*
+		 * Count substitutions locally: the command may be run again,
+		 * in a loop or from the script cache
+		 */
+		sp = child->sp;
 		for (i = 0; is_assignment(child->argv[i]); i++) {
 			p = insert_var_value(child->argv[i]);
 #ifndef __U_BOOT__
@@ -1621,11 +1636,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1757,7 +1772,7 @@ static int run_list_real(struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
-	struct pipe *rpipe;
+	struct pipe *rpipe, *for_pipe = NULL;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
 	int save_num_progs;
@@ -1796,7 +1811,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
-					return 1;
+					rcode = 1;
+					goto out;
 				}
 #endif
 				flag_restore = 0;
@@ -1826,6 +1842,7 @@ static int run_list_real(struct pipe *pi)
 					pi->progs->argv[0]);
 				save_list = list;
 				save_name = pi->progs->argv[0];
+				for_pipe = pi;
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
 			}
@@ -1895,7 +1912,8 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return -2;	/* exit */
+			rcode = -2;	/* exit */
+			goto out;
 		}
 		last_return_code = rcode;
 #endif
@@ -1915,6 +1933,20 @@ static int run_list_real(struct pipe *pi)
 		checkjobs(NULL);
 #endif
 	}
+#ifdef __U_BOOT__
+out:
+	/*
+	 * If a "for" loop was cut short, put back the variable name so that
+	 * the list can be run again
+	 */
+	if (list) {
+		while (*list)
+			free(*list++);
+		free(save_list);
+		free(for_pipe->progs->argv[0]);
+		for_pipe->progs->argv[0] = save_name;
+	}
+#endif
 	return rcode;
 }
 
@@ -3170,6 +3202,220 @@ static void update_ifs_map(void)
 	mapset(ifs, 2);            /* also flow through if quoted */
 }
 
+#ifdef __U_BOOT__
+#ifdef CONFIG_HUSH_CACHE
+/*
+ * Cache of parsed scripts
+ *
+ * Boot scripts run the same text over and over: loops in boot.scr, bootcmd
+ * retries and each step of distro_bootcmd through 'run'. Parsing does not
+ * depend on the environment, since variables are only expanded as each
+ * command runs, so the parsed lines of a script can be kept and run again.
+ *
+ * A script is added to the cache as it runs for the first time, so that
+ * the output and side effects are exactly as without the cache. Scripts with
+ * a syntax error, or which exit before the end, are not kept.
+ */
+struct hush_cache_entry {
+	char *text;		/* copy of the script, NULL if the slot is free */
+	uint hash;		/* CRC32 of @text */
+	int flag;		/* parser flags (FLAG_PARSE_SEMICOLON etc.) */
+	struct pipe **lines;	/* parsed lines, in order */
+	int count;		/* number of lines */
+	uint used;		/* value of hush_cache_clock when last used */
+	int busy;		/* number of runs in progress */
+	int complete;		/* all lines have been added */
+	int bad;		/* must be dropped when the first run finishes */
+};
+
+static struct hush_cache_entry hush_cache[CONFIG_HUSH_CACHE_ENTRIES];
+static uint hush_cache_clock;
+
+static void hush_cache_drop(struct hush_cache_entry *ent)
+{
+	int i;
+
+	for (i = 0; i < ent->count; i++)
+		free_pipe_list(ent->lines[i], 0);
+	free(ent->lines);
+	free(ent->text);
+	memset(ent, '\0', sizeof(*ent));
+}
+
+/*
+ * Find the entry for a script, or NULL if it is not in the cache. If
+ * @victimp is not NULL, it is set to the slot to use for adding it, if any.
+ */
+static struct hush_cache_entry *hush_cache_find(const char *s, int flag,
+						uint hash,
+						struct hush_cache_entry **victimp)
+{
+	struct hush_cache_entry *ent, *victim = NULL;
+
+	for (ent = hush_cache; ent < hush_cache + ARRAY_SIZE(hush_cache);
+	     ent++) {
+		if (ent->text && ent->hash == hash && ent->flag == flag &&
+		    !strcmp(ent->text, s))
+			return ent;
+		if (!ent->busy &&
+		    (!victim || (victim->text &&
+				 (!ent->text || ent->used < victim->used))))
+			victim = ent;
+	}
+	if (victimp)
+		*victimp = victim;
+
+	return NULL;
+}
+
+/* Check whether a script may use the cache at all */
+static int hush_cache_usable(int flag)
+{
+	/*
+	 * Reparsed text comes from variable values, so rarely repeats. A
+	 * non-default IFS is used while parsing and the script may change it.
+	 */
+	return !(flag & FLAG_REPARSING) && !env_get("IFS");
+}
+
+/*
+ * Run a script from the cache, if it is there. Returns 1 if the script was
+ * run, with *rcodep set as parse_stream_outer() would return it.
+ */
+static int hush_cache_run(const char *s, int flag, int *rcodep)
+{
+	struct hush_cache_entry *ent;
+	int code = 1, i;
+
+	if (!hush_cache_usable(flag))
+		return 0;
+	ent = hush_cache_find(s, flag, crc32(0, (const uchar *)s, strlen(s)),
+			      NULL);
+	if (!ent || !ent->complete)
+		return 0;
+
+	ent->used = ++hush_cache_clock;
+	ent->busy++;
+	for (i = 0; i < ent->count; i++) {
+		code = run_list_real(ent->lines[i]);
+		if (code == -2)
+			break;
+		if (code == -1)
+			flag_repeat = 0;
+	}
+	ent->busy--;
+	if (code == -2)
+		*rcodep = -2;
+	else
+		*rcodep = code != 0 ? 1 : 0;
+
+	return 1;
+}
+
+/* Start adding a script to the cache, returning NULL if it cannot be */
+static struct hush_cache_entry *hush_cache_start(const char *s, int flag)
+{
+	struct hush_cache_entry *ent;
+	uint hash;
+
+	if (!hush_cache_usable(flag))
+		return NULL;
+
+	/* the script may be there already, if it is running itself */
+	hash = crc32(0, (const uchar *)s, strlen(s));
+	if (hush_cache_find(s, flag, hash, &ent) || !ent)
+		return NULL;
+	if (ent->text)
+		hush_cache_drop(ent);
+
+	ent->text = strdup(s);
+	if (!ent->text)
+		return NULL;
+	ent->hash = hash;
+	ent->flag = flag;
+	ent->used = ++hush_cache_clock;
+	ent->busy = 1;
+
+	return ent;
+}
+
+/* Keep a line which has just been run, or free it if it cannot be kept */
+static void hush_cache_add(struct hush_cache_entry *ent, struct pipe *pi)
+{
+	struct pipe **lines;
+
+	if (!ent->bad) {
+		lines = realloc(ent->lines, (ent->count + 1) * sizeof(*lines));
+		if (lines) {
+			lines[ent->count++] = pi;
+			ent->lines = lines;
+			return;
+		}
+		ent->bad = 1;
+	}
+	free_pipe_list(pi, 0);
+}
+
+/* Note that the script cannot be kept, e.g. after a syntax error */
+static void hush_cache_abandon(struct hush_cache_entry *ent)
+{
+	if (ent)
+		ent->bad = 1;
+}
+
+/* Finish adding a script, @rcode being from parse_stream_outer() */
+static void hush_cache_finish(struct hush_cache_entry *ent, int rcode)
+{
+	if (!ent)
+		return;
+	ent->busy--;
+	/* after 'exit' the rest of the script has not been parsed */
+	if (ent->bad || rcode == -2)
+		hush_cache_drop(ent);
+	else
+		ent->complete = 1;
+}
+#else
+static inline int hush_cache_run(const char *s, int flag, int *rcodep)
+{
+	return 0;
+}
+
+static inline struct hush_cache_entry *hush_cache_start(const char *s,
+							 int flag)
+{
+	return NULL;
+}
+
+static inline void hush_cache_add(struct hush_cache_entry *ent,
+				  struct pipe *pi)
+{
+}
+
+static inline void hush_cache_abandon(struct hush_cache_entry *ent)
+{
+}
+
+static inline void hush_cache_finish(struct hush_cache_entry *ent, int rcode)
+{
+}
+#endif /* CONFIG_HUSH_CACHE */
+
+/* Run a parsed line, keeping it if the script is being cached */
+static int run_list_outer(struct in_str *inp, struct pipe *pi)
+{
+	int rcode;
+
+	if (!inp->cache)
+		return run_list(pi);
+
+	rcode = run_list_real(pi);
+	hush_cache_add(inp->cache, pi);
+
+	return rcode;
+}
+#endif /* __U_BOOT__ */
+
 /* most recursion does not come through here, the exeception is
  * from builtin_source() */
 static int parse_stream_outer(struct in_str *inp, int flag)
@@ -3204,7 +3450,7 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifndef __U_BOOT__
 			run_list(ctx.list_head);
 #else
-			code = run_list(ctx.list_head);
+			code = run_list_outer(inp, ctx.list_head);
 			if (code == -2) {	/* exit */
 				b_free(&temp);
 				code = 0;
@@ -3234,6 +3480,7 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifdef __U_BOOT__
 			if (inp->__promptme == 0) printf("<INTERRUPT>\n");
 			inp->__promptme = 1;
+			hush_cache_abandon(inp->cache);
 #endif
 			temp.nonnull = 0;
 			temp.quote = 0;
@@ -3260,23 +3507,35 @@ int parse_string_outer(const char *s, int flag)
 	struct in_str input;
 	int rcode;
 #ifdef __U_BOOT__
+	struct hush_cache_entry *ent;
 	char *p = NULL;
 	if (!s)
 		return 1;
 	if (!*s)
 		return 0;
+	if (hush_cache_run(s, flag, &rcode))
+		return rcode == -2 ? last_return_code : rcode;
+	ent = hush_cache_start(s, flag);
 	if (!(p = strchr(s, '\n')) || *++p) {
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
 		strcat(p, "\n");
 		setup_string_in_str(&input, p);
+		input.cache = ent;
 		rcode = parse_stream_outer(&input, flag);
+		hush_cache_finish(ent, rcode);
 		free(p);
 		return rcode == -2 ? last_return_code : rcode;
 	} else {
 #endif
 	setup_string_in_str(&input, s);
+#ifdef __U_BOOT__
+	input.cache = ent;
+#endif
 	rcode = parse_stream_outer(&input, flag);
+#ifdef __U_BOOT__
+	hush_cache_finish(ent, rcode);
+#endif
 	return rcode == -2 ? last_return_code : rcode;
 #ifdef __U_BOOT__
 	}
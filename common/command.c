@@ -15,7 +15,9 @@
 #include <env.h>
 #include <image.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
+#include <sort.h>
 #include <time.h>
 #include <asm/global_data.h>
 #include <linux/ctype.h>
@@ -126,10 +128,81 @@ struct cmd_tbl *find_cmd_tbl(const char *cmd, struct cmd_tbl *table,
 	return NULL;	/* not found or ambiguous command */
 }
 
+#ifdef CONFIG_CMDLINE
+/*
+ * The linker sorts the command table by the names of the linker-list entries,
+ * which are not always the command names (e.g. "?"), so a sorted index is set
+ * up on first use, after relocation
+ */
+static struct cmd_tbl **cmd_index;
+
+static int cmd_index_cmp(const void *a, const void *b)
+{
+	const struct cmd_tbl *const *x = a, *const *y = b;
+
+	return strcmp((*x)->name, (*y)->name);
+}
+
+static struct cmd_tbl **cmd_index_get(struct cmd_tbl *table, int count)
+{
+	int i;
+
+	if (cmd_index || !(gd->flags & GD_FLG_RELOC))
+		return cmd_index;
+
+	cmd_index = malloc(count * sizeof(*cmd_index));
+	if (!cmd_index)
+		return NULL;
+	for (i = 0; i < count; i++)
+		cmd_index[i] = &table[i];
+	qsort(cmd_index, count, sizeof(*cmd_index), cmd_index_cmp);
+
+	return cmd_index;
+}
+
+/* find command table entry for a command, with the same rules as above */
+static struct cmd_tbl *find_cmd_index(const char *cmd, struct cmd_tbl **index,
+				      int count)
+{
+	const char *p;
+	int len, lo, hi, mid;
+
+	if (!cmd)
+		return NULL;
+	len = ((p = strchr(cmd, '.')) == NULL) ? strlen(cmd) : (p - cmd);
+
+	/* find the first command which starts with the name, or comes after */
+	for (lo = 0, hi = count; lo < hi;) {
+		mid = (lo + hi) / 2;
+		if (strncmp(index[mid]->name, cmd, len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == count || strncmp(index[lo]->name, cmd, len))
+		return NULL;
+
+	/* a full match sorts before any longer name it abbreviates */
+	if (strlen(index[lo]->name) == len)
+		return index[lo];
+	if (lo + 1 < count && !strncmp(index[lo + 1]->name, cmd, len))
+		return NULL;	/* ambiguous command */
+
+	return index[lo];
+}
+#endif /* CONFIG_CMDLINE */
+
 struct cmd_tbl *find_cmd(const char *cmd)
 {
 	struct cmd_tbl *start = ll_entry_start(struct cmd_tbl, cmd);
 	const int len = ll_entry_count(struct cmd_tbl, cmd);
+#ifdef CONFIG_CMDLINE
+	struct cmd_tbl **index = cmd_index_get(start, len);
+
+	if (index)
+		return find_cmd_index(cmd, index, len);
+#endif
+
 	return find_cmd_tbl(cmd, start, len);
 }
 
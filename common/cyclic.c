@@ -13,6 +13,7 @@
 #include <malloc.h>
 #include <time.h>
 #include <linux/errno.h>
+#include <linux/kernel.h>
 #include <linux/list.h>
 #include <asm/global_data.h>
 #include <u-boot/schedule.h>
@@ -27,6 +28,22 @@ struct hlist_head *cyclic_get_list(void)
 	return (struct hlist_head *)&gd->cyclic_list;
 }
 
+/* Add a cyclic function to the list, behind those which are due before it */
+static void cyclic_queue(struct cyclic_info *cyclic)
+{
+	struct cyclic_info *pos, *last = NULL;
+
+	hlist_for_each_entry(pos, cyclic_get_list(), list) {
+		if (time_after64(pos->next_call, cyclic->next_call))
+			break;
+		last = pos;
+	}
+	if (last)
+		hlist_add_after(&last->list, &cyclic->list);
+	else
+		hlist_add_head(&cyclic->list, cyclic_get_list());
+}
+
 void cyclic_register(struct cyclic_info *cyclic, cyclic_func_t func,
 		     uint64_t delay_us, const char *name)
 {
@@ -37,54 +54,86 @@ void cyclic_register(struct cyclic_info *cyclic, cyclic_func_t func,
 	cyclic->name = name;
 	cyclic->delay_us = delay_us;
 	cyclic->start_time_us = get_timer_us(0);
-	hlist_add_head(&cyclic->list, cyclic_get_list());
+	/* The first call is due straight away */
+	cyclic->next_call = cyclic->start_time_us;
+	cyclic_queue(cyclic);
 }
 
 void cyclic_unregister(struct cyclic_info *cyclic)
 {
-	hlist_del(&cyclic->list);
+	hlist_del_init(&cyclic->list);
+}
+
+/* Call a cyclic function which is due and account its cpu-time */
+static void cyclic_call(struct cyclic_info *cyclic, uint64_t now)
+{
+	uint64_t cpu_time;
+
+	cyclic->max_late_us = max(cyclic->max_late_us, now - cyclic->next_call);
+	cyclic->next_call = now + cyclic->delay_us;
+	cyclic->func(cyclic);
+	cyclic->run_cnt++;
+	cpu_time = get_timer_us(0) - now;
+	cyclic->cpu_time_us += cpu_time;
+	cyclic->max_cpu_us = max(cyclic->max_cpu_us, cpu_time);
+
+	/* Check if cpu-time exceeds max allowed time */
+	if (cpu_time > CONFIG_CYCLIC_MAX_CPU_TIME_US) {
+		cyclic->overrun_cnt++;
+		if (!cyclic->already_warned) {
+			pr_err("cyclic function %s took too long: %lldus vs %dus max\n",
+			       cyclic->name, cpu_time,
+			       CONFIG_CYCLIC_MAX_CPU_TIME_US);
+
+			/*
+			 * Don't disable this function, just warn once
+			 * about this exceeding CPU time usage
+			 */
+			cyclic->already_warned = true;
+		}
+	}
 }
 
 static void cyclic_run(void)
 {
 	struct cyclic_info *cyclic;
-	struct hlist_node *tmp;
-	uint64_t now, cpu_time;
+	struct hlist_node *first;
+	uint64_t start, now;
 
 	/* Prevent recursion */
 	if (gd->flags & GD_FLG_CYCLIC_RUNNING)
 		return;
 
+	/*
+	 * The list is ordered by deadline, so there is nothing to do unless
+	 * the first function is due. This keeps the cost low in polling loops.
+	 */
+	first = cyclic_get_list()->first;
+	if (!first)
+		return;
+	start = get_timer_us(0);
+	cyclic = hlist_entry(first, struct cyclic_info, list);
+	if (time_before64(start, cyclic->next_call))
+		return;
+
 	gd->flags |= GD_FLG_CYCLIC_RUNNING;
-	hlist_for_each_entry_safe(cyclic, tmp, cyclic_get_list(), list) {
-		/*
-		 * Check if this cyclic function needs to get called, e.g.
-		 * do not call the cyclic func too often
-		 */
-		now = get_timer_us(0);
-		if (time_after_eq64(now, cyclic->next_call)) {
-			/* Call cyclic function and account it's cpu-time */
-			cyclic->next_call = now + cyclic->delay_us;
-			cyclic->func(cyclic);
-			cyclic->run_cnt++;
-			cpu_time = get_timer_us(0) - now;
-			cyclic->cpu_time_us += cpu_time;
-
-			/* Check if cpu-time exceeds max allowed time */
-			if ((cpu_time > CONFIG_CYCLIC_MAX_CPU_TIME_US) &&
-			    (!cyclic->already_warned)) {
-				pr_err("cyclic function %s took too long: %lldus vs %dus max\n",
-				       cyclic->name, cpu_time,
-				       CONFIG_CYCLIC_MAX_CPU_TIME_US);
-
-				/*
-				 * Don't disable this function, just warn once
-				 * about this exceeding CPU time usage
-				 */
-				cyclic->already_warned = true;
-			}
+	now = start;
+	do {
+		cyclic_call(cyclic, now);
+
+		/* Move it back by its new deadline, unless it unregistered */
+		if (!hlist_unhashed(&cyclic->list)) {
+			hlist_del(&cyclic->list);
+			cyclic_queue(cyclic);
 		}
-	}
+
+		/* Only run what was due on entry, even if delay_us is 0 */
+		first = cyclic_get_list()->first;
+		if (!first)
+			break;
+		cyclic = hlist_entry(first, struct cyclic_info, list);
+		now = get_timer_us(0);
+	} while (time_after_eq64(start, cyclic->next_call));
 	gd->flags &= ~GD_FLG_CYCLIC_RUNNING;
 }
 
@@ -14,6 +14,7 @@
 #include <log.h>
 #include <linker_lists.h>
 #include <malloc.h>
+#include <time.h>
 #include <asm/global_data.h>
 #include <linux/errno.h>
 #include <linux/list.h>
@@ -65,14 +66,52 @@ const char *event_type_name(enum event_t type)
 #endif
 }
 
+/*
+ * Find the static spies for each event type. The linker sorts them by name,
+ * which starts with the type, so the spies for each type are next to each
+ * other. If they are not, all spies are checked for each event, as before.
+ */
+static void event_index_static(struct event_state *state,
+			       struct evspy_info *start, int n_ents)
+{
+	int i, type, prev = -1;
+
+	memset(state->static_count, '\0', sizeof(state->static_count));
+	state->static_grouped = n_ents <= U16_MAX;
+	for (i = 0; i < n_ents && state->static_grouped; i++) {
+		type = start[i].type;
+		if (type >= EVT_COUNT ||
+		    (type != prev && state->static_count[type]))
+			state->static_grouped = false;
+		else if (!state->static_count[type]++)
+			state->static_first[type] = i;
+		prev = type;
+	}
+	if (!state->static_grouped)
+		log_debug("Event spies are not grouped by type\n");
+	state->static_ready = true;
+}
+
 static int notify_static(struct event *ev)
 {
 	struct evspy_info *start =
 		ll_entry_start(struct evspy_info, evspy_info);
 	const int n_ents = ll_entry_count(struct evspy_info, evspy_info);
-	struct evspy_info *spy;
+	struct event_state *state = gd_event_state();
+	struct evspy_info *spy, *end;
+
+	spy = start;
+	end = start + n_ents;
+	if (ev->type < EVT_COUNT) {
+		if (!state->static_ready)
+			event_index_static(state, start, n_ents);
+		if (state->static_grouped) {
+			spy = start + state->static_first[ev->type];
+			end = spy + state->static_count[ev->type];
+		}
+	}
 
-	for (spy = start; spy != start + n_ents; spy++) {
+	for (; spy != end; spy++) {
 		if (spy->type == ev->type) {
 			int ret;
 
@@ -103,10 +142,14 @@ static int notify_static(struct event *ev)
 
 static int notify_dynamic(struct event *ev)
 {
+#if CONFIG_IS_ENABLED(EVENT_DYNAMIC)
 	struct event_state *state = gd_event_state();
 	struct event_spy *spy, *next;
 
-	list_for_each_entry_safe(spy, next, &state->spy_head, sibling_node) {
+	if (ev->type >= EVT_COUNT)
+		return 0;
+	list_for_each_entry_safe(spy, next, &state->spy_head[ev->type],
+				 sibling_node) {
 		if (spy->type == ev->type) {
 			int ret;
 
@@ -124,26 +167,37 @@ static int notify_dynamic(struct event *ev)
 				return log_msg_ret("spy", ret);
 		}
 	}
+#endif
 
 	return 0;
 }
 
-int event_notify(enum event_t type, void *data, int size)
+/*
+ * The time is only taken once the timer is running, since starting a driver-
+ * model timer sends events of its own
+ */
+static bool event_can_time(void)
 {
-	struct event event;
-	int ret;
+	if (!(gd->flags & GD_FLG_RELOC))
+		return false;
+#ifdef CONFIG_TIMER
+	if (!gd->timer)
+		return false;
+#endif
 
-	event.type = type;
-	if (size > sizeof(event.data))
-		return log_msg_ret("size", -E2BIG);
-	memcpy(&event.data, data, size);
+	return true;
+}
 
-	ret = notify_static(&event);
+static int event_send(struct event *ev)
+{
+	int ret;
+
+	ret = notify_static(ev);
 	if (ret)
 		return log_msg_ret("sta", ret);
 
 	if (CONFIG_IS_ENABLED(EVENT_DYNAMIC)) {
-		ret = notify_dynamic(&event);
+		ret = notify_dynamic(ev);
 		if (ret)
 			return log_msg_ret("dyn", ret);
 	}
@@ -151,6 +205,36 @@ int event_notify(enum event_t type, void *data, int size)
 	return 0;
 }
 
+int event_notify(enum event_t type, void *data, int size)
+{
+	struct event event;
+	ulong start = 0;
+	bool timed;
+	int ret;
+
+	event.type = type;
+	if (size > sizeof(event.data))
+		return log_msg_ret("size", -E2BIG);
+	memcpy(&event.data, data, size);
+
+	timed = CONFIG_IS_ENABLED(EVENT_STATS) && type < EVT_COUNT &&
+		event_can_time();
+	if (timed)
+		start = timer_get_us();
+	ret = event_send(&event);
+#if CONFIG_IS_ENABLED(EVENT_STATS)
+	if (type < EVT_COUNT) {
+		struct event_stats *stats = &gd_event_state()->stats[type];
+
+		stats->count++;
+		if (timed)
+			stats->time_us += timer_get_us() - start;
+	}
+#endif
+
+	return ret;
+}
+
 int event_notify_null(enum event_t type)
 {
 	return event_notify(type, NULL, 0);
@@ -172,6 +256,31 @@ void event_show_spy_list(void)
 	}
 }
 
+#if CONFIG_IS_ENABLED(EVENT_STATS)
+const struct event_stats *event_get_stats(enum event_t type)
+{
+	if (type >= EVT_COUNT)
+		return NULL;
+
+	return &gd_event_state()->stats[type];
+}
+
+void event_show_stats(void)
+{
+	const struct event_stats *stats;
+	int type;
+
+	printf("Type                     Count   Time (us)\n");
+	for (type = 0; type < EVT_COUNT; type++) {
+		stats = event_get_stats(type);
+		if (stats->count)
+			printf("%-3x %-20s %6u  %10lu\n", type,
+			       event_type_name(type), stats->count,
+			       stats->time_us);
+	}
+}
+#endif /* EVENT_STATS */
+
 #if CONFIG_IS_ENABLED(EVENT_DYNAMIC)
 static void spy_free(struct event_spy *spy)
 {
@@ -183,6 +292,8 @@ int event_register(const char *id, enum event_t type, event_handler_t func, void
 	struct event_state *state = gd_event_state();
 	struct event_spy *spy;
 
+	if (type >= EVT_COUNT)
+		return log_msg_ret("type", -EINVAL);
 	spy = malloc(sizeof(*spy));
 	if (!spy)
 		return log_msg_ret("alloc", -ENOMEM);
@@ -191,7 +302,7 @@ int event_register(const char *id, enum event_t type, event_handler_t func, void
 	spy->type = type;
 	spy->func = func;
 	spy->ctx = ctx;
-	list_add_tail(&spy->sibling_node, &state->spy_head);
+	list_add_tail(&spy->sibling_node, &state->spy_head[type]);
 
 	return 0;
 }
@@ -200,9 +311,13 @@ int event_uninit(void)
 {
 	struct event_state *state = gd_event_state();
 	struct event_spy *spy, *next;
+	int type;
 
-	list_for_each_entry_safe(spy, next, &state->spy_head, sibling_node)
-		spy_free(spy);
+	for (type = 0; type < EVT_COUNT; type++) {
+		list_for_each_entry_safe(spy, next, &state->spy_head[type],
+					 sibling_node)
+			spy_free(spy);
+	}
 
 	return 0;
 }
@@ -210,8 +325,10 @@ int event_uninit(void)
 int event_init(void)
 {
 	struct event_state *state = gd_event_state();
+	int type;
 
-	INIT_LIST_HEAD(&state->spy_head);
+	for (type = 0; type < EVT_COUNT; type++)
+		INIT_LIST_HEAD(&state->spy_head[type]);
 
 	return 0;
 }
@@ -11,6 +11,7 @@
 
 #ifndef USE_HOSTCC
 #include <command.h>
+#include <cpu_func.h>
 #include <env.h>
 #include <log.h>
 #include <malloc.h>
@@ -34,6 +35,7 @@
 #include <u-boot/sha256.h>
 #include <u-boot/sha512.h>
 #include <u-boot/md5.h>
+#include <linux/xxhash.h>
 
 static int __maybe_unused hash_init_sha1(struct hash_algo *algo, void **ctxp)
 {
@@ -200,6 +202,39 @@ static int __maybe_unused hash_finish_crc32(struct hash_algo *algo, void *ctx,
 	return 0;
 }
 
+static int __maybe_unused hash_init_xxh64(struct hash_algo *algo, void **ctxp)
+{
+	struct xxh64_state *ctx = malloc(sizeof(struct xxh64_state));
+
+	if (!ctx)
+		return -ENOMEM;
+	xxh64_reset(ctx, 0);
+	*ctxp = ctx;
+	return 0;
+}
+
+static int __maybe_unused hash_update_xxh64(struct hash_algo *algo, void *ctx,
+					    const void *buf, unsigned int size,
+					    int is_last)
+{
+	xxh64_update((struct xxh64_state *)ctx, buf, size);
+	return 0;
+}
+
+static int __maybe_unused hash_finish_xxh64(struct hash_algo *algo, void *ctx,
+					    void *dest_buf, int size)
+{
+	uint64_t hash;
+
+	if (size < algo->digest_size)
+		return -1;
+
+	hash = cpu_to_be64(xxh64_digest((struct xxh64_state *)ctx));
+	memcpy(dest_buf, &hash, sizeof(hash));
+	free(ctx);
+	return 0;
+}
+
 /*
  * These are the hash algorithms we support.  If we have hardware acceleration
  * is enable we will use that, otherwise a software version of the algorithm.
@@ -328,6 +363,17 @@ static struct hash_algo hash_algo[] = {
 		.hash_finish	= hash_finish_crc32,
 	},
 #endif
+#if CONFIG_IS_ENABLED(XXH64)
+	{
+		.name		= "xxh64",
+		.digest_size	= 8,
+		.chunk_size	= CHUNKSZ,
+		.hash_func_ws	= xxh64_wd_buf,
+		.hash_init	= hash_init_xxh64,
+		.hash_update	= hash_update_xxh64,
+		.hash_finish	= hash_finish_xxh64,
+	},
+#endif
 };
 
 /* Try to minimize code size for boards that don't want much hashing */
@@ -416,6 +462,76 @@ int hash_block(const char *algo_name, const void *data, unsigned int len,
 	return 0;
 }
 
+struct hash_multi {
+	struct hash_algo *algo;
+	struct hash_region *regions;
+	void **ctx;
+};
+
+/* Hash one region, without touching the console, watchdog or malloc() */
+static int hash_multi_job(void *priv, uint cpu, uint job)
+{
+	struct hash_multi *hm = priv;
+	struct hash_region *reg = &hm->regions[job];
+
+	return hm->algo->hash_update(hm->algo, hm->ctx[job], reg->data,
+				     reg->len, 1);
+}
+
+int hash_block_multi(const char *algo_name, struct hash_region *regions,
+		     int count)
+{
+	struct hash_multi hm;
+	int i, ret, err;
+
+	ret = hash_lookup_algo(algo_name, &hm.algo);
+	if (ret)
+		return ret;
+
+	/*
+	 * Hardware engines are drivers, which cannot be used from the other
+	 * CPUs, and the watchdog needs servicing if everything is on this one
+	 */
+	if (count < 2 || cpu_work_cpus() < 2 || !hm.algo->hash_init ||
+	    CONFIG_IS_ENABLED(SHA_PROG_HW_ACCEL) ||
+	    CONFIG_IS_ENABLED(SHA512_HW_ACCEL)) {
+		for (i = 0; i < count; i++)
+			hm.algo->hash_func_ws(regions[i].data, regions[i].len,
+					      regions[i].output,
+					      hm.algo->chunk_size);
+		return 0;
+	}
+
+	hm.regions = regions;
+	hm.ctx = calloc(count, sizeof(void *));
+	if (!hm.ctx)
+		return -ENOMEM;
+	for (i = 0; i < count; i++) {
+		ret = hm.algo->hash_init(hm.algo, &hm.ctx[i]);
+		if (ret)
+			goto err;
+	}
+
+	ret = cpu_work_run(hash_multi_job, &hm, count, count);
+	for (i = 0; i < count; i++) {
+		err = hm.algo->hash_finish(hm.algo, hm.ctx[i],
+					   regions[i].output,
+					   hm.algo->digest_size);
+		if (err && !ret)
+			ret = err;
+	}
+	free(hm.ctx);
+
+	return ret;
+
+err:
+	while (i--)
+		free(hm.ctx[i]);
+	free(hm.ctx);
+
+	return ret;
+}
+
 #if !defined(CONFIG_XPL_BUILD) && (defined(CONFIG_CMD_HASH) || \
 	defined(CONFIG_CMD_SHA1SUM) || defined(CONFIG_CMD_CRC32)) || \
 	defined(CONFIG_CMD_MD5SUM)
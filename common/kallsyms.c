@@ -5,12 +5,16 @@
  * Licensed under the GPL-2 or later.
  */
 
+#include <kallsyms.h>
+#include <vsprintf.h>
+#include <linux/string.h>
+
 /* We need the weak marking as this symbol is provided specially */
 extern const char system_map[] __attribute__((weak));
 
 /* Given an address, return a pointer to the symbol name and store
  * the base address in caddr.  So if the symbol map had an entry:
- *		03fb9b7c_spi_cs_deactivate
+ *		03fb9b7c _spi_cs_deactivate
  * Then the following call:
  *		unsigned long base;
  *		const char *sym = symbol_lookup(0x03fb9b80, &base);
@@ -30,7 +34,8 @@ const char *symbol_lookup(unsigned long addr, unsigned long *caddr)
 
 	while (*sym) {
 		sym_addr = hextoul(sym, &esym);
-		sym = esym;
+		/* skip the space between the address and the name */
+		sym = esym + 1;
 		if (sym_addr > addr)
 			break;
 		*caddr = sym_addr;
@@ -11,6 +11,7 @@
 #include <malloc.h>
 #include <asm/global_data.h>
 #include <dm/uclass.h>
+#include <linux/bitmap.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -205,6 +206,70 @@ static bool log_passes_filters(struct log_device *ldev, struct log_rec *rec)
 	return false;
 }
 
+/**
+ * log_update_summary() - Work out which records a log device may emit
+ *
+ * This sets up the fields in global_data used by log_may_emit(). It must be
+ * called whenever a filter is added or removed, or a device is enabled or
+ * disabled. Deny filters are ignored, since they only drop records.
+ */
+static void log_update_summary(void)
+{
+	struct log_device *ldev;
+	struct log_filter *filt;
+	int level, cat, i;
+
+	gd->log_unfiltered = false;
+	gd->log_filter_level = -1;
+	bitmap_zero(gd->log_filter_cats, LOGC_COUNT);
+	list_for_each_entry(ldev, &gd->log_head, sibling_node) {
+		if (!(ldev->flags & LOGDF_ENABLE))
+			continue;
+		if (list_empty(&ldev->filter_head))
+			gd->log_unfiltered = true;
+
+		list_for_each_entry(filt, &ldev->filter_head, sibling_node) {
+			if (filt->flags & LOGFF_DENY)
+				continue;
+			level = filt->flags & LOGFF_LEVEL_MIN ? LOGL_MAX :
+				filt->level;
+			gd->log_filter_level = max_t(int, gd->log_filter_level,
+						     level);
+			if (!(filt->flags & LOGFF_HAS_CAT)) {
+				bitmap_fill(gd->log_filter_cats, LOGC_COUNT);
+				continue;
+			}
+			for (i = 0; i < LOGF_MAX_CATEGORIES &&
+			     filt->cat_list[i] != LOGC_END; i++) {
+				cat = filt->cat_list[i];
+				gd->log_filter_cats[BIT_WORD(cat)] |=
+					BIT_MASK(cat);
+			}
+		}
+	}
+}
+
+/**
+ * log_may_emit() - Quickly check whether any log device may emit a record
+ *
+ * This is checked before the filters are applied and the message formatted.
+ * It can pass a record which the filters drop, but never drops a record which
+ * they pass.
+ *
+ * @cat: Category of the record
+ * @level: Level of the record, without %LOGL_FORCE_DEBUG
+ * Return: false if no device emits the record, true if one may
+ */
+static bool log_may_emit(enum log_category_t cat, enum log_level_t level)
+{
+	if (gd->log_unfiltered && level <= gd->default_log_level)
+		return true;
+	if (level > gd->log_filter_level || cat >= LOGC_COUNT)
+		return false;
+
+	return gd->log_filter_cats[BIT_WORD(cat)] & BIT_MASK(cat);
+}
+
 /**
  * log_dispatch() - Send a log record to all log devices for processing
  *
@@ -229,6 +294,10 @@ static int log_dispatch(struct log_rec *rec, const char *fmt, va_list args)
 	if (gd->processing_msg)
 		return 1;
 
+	if (!(rec->flags & LOGRECF_FORCE_DEBUG) &&
+	    !log_may_emit(rec->cat, rec->level))
+		return 0;
+
 	/* Emit message */
 	gd->processing_msg = true;
 	list_for_each_entry(ldev, &gd->log_head, sibling_node) {
@@ -308,6 +377,11 @@ int _log_buffer(enum log_category_t cat, enum log_level_t level,
 		const char *file, int line, const char *func, ulong addr,
 		const void *data, uint width, uint count, uint linelen)
 {
+	/* avoid formatting lines which no device emits */
+	if (gd && (gd->flags & GD_FLG_LOG_READY) && cat != LOGC_CONT &&
+	    !(level & LOGL_FORCE_DEBUG) && !log_may_emit(cat, level))
+		return 0;
+
 	if (linelen * width > MAX_LINE_LENGTH_BYTES)
 		linelen = MAX_LINE_LENGTH_BYTES / width;
 	if (linelen < 1)
@@ -381,6 +455,7 @@ int log_add_filter_flags(const char *drv_name, enum log_category_t cat_list[],
 		list_add(&filt->sibling_node, &ldev->filter_head);
 	else
 		list_add_tail(&filt->sibling_node, &ldev->filter_head);
+	log_update_summary();
 
 	return filt->filter_num;
 
@@ -402,6 +477,7 @@ int log_remove_filter(const char *drv_name, int filter_num)
 		if (filt->filter_num == filter_num) {
 			list_del(&filt->sibling_node);
 			free(filt);
+			log_update_summary();
 
 			return 0;
 		}
@@ -444,6 +520,7 @@ int log_device_set_enable(struct log_driver *drv, bool enable)
 		ldev->flags |= LOGDF_ENABLE;
 	else
 		ldev->flags &= ~LOGDF_ENABLE;
+	log_update_summary();
 
 	return 0;
 }
@@ -465,6 +542,9 @@ int log_init(void)
 	 * We only support having a single device for each driver.
 	 */
 	INIT_LIST_HEAD((struct list_head *)&gd->log_head);
+	gd->log_filter_cats = calloc(BITS_TO_LONGS(LOGC_COUNT), sizeof(long));
+	if (!gd->log_filter_cats)
+		return -ENOMEM;
 	while (drv < end) {
 		struct log_device *ldev;
 
@@ -480,6 +560,7 @@ int log_init(void)
 			      (struct list_head *)&gd->log_head);
 		drv++;
 	}
+	log_update_summary();
 	gd->flags |= GD_FLG_LOG_READY;
 	if (!gd->default_log_level)
 		gd->default_log_level = CONFIG_LOG_DEFAULT_LEVEL;
@@ -0,0 +1,231 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Log driver which records messages in a memory ring buffer
+ *
+ * This allows the console to be kept quiet (or slow serial output avoided)
+ * while still having a record of what happened, which can be printed with
+ * 'log dump' or picked up by the OS.
+ *
+ * The ring is kept in a bloblist entry where possible, so that messages
+ * from before relocation are kept and it can be passed on. Otherwise it is
+ * allocated once malloc() is fully available.
+ */
+
+#include <bloblist.h>
+#include <bootstage.h>
+#include <event.h>
+#include <fdtdec.h>
+#include <log.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <asm/global_data.h>
+#include <dm/ofnode.h>
+#include <linux/build_bug.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum {
+	LOG_RINGBUF_MAGIC	= 0x4c4f4752,	/* "LOGR" */
+	LOG_RINGBUF_SIZE	= CONFIG_LOG_RINGBUF_SIZE,
+};
+
+/**
+ * struct log_ringbuf_hdr - header of the ring, followed by the data
+ *
+ * @head and @tail count bytes written to and removed from the ring since it
+ * was set up; the position in the data is the count modulo @size. The
+ * records between @tail and @head each start with a struct log_ringbuf_rec
+ * and may wrap around the end of the data.
+ *
+ * @magic: LOG_RINGBUF_MAGIC
+ * @size: Size of the data, a power of two
+ * @head: Position at which the next record is written
+ * @tail: Position of the oldest record
+ */
+struct log_ringbuf_hdr {
+	u32 magic;
+	u32 size;
+	u32 head;
+	u32 tail;
+};
+
+/**
+ * struct log_ringbuf_rec - header of a record, followed by the message
+ *
+ * @time_us: Time since boot, in microseconds (see timer_get_boot_us())
+ * @len: Length of the message, which is not nul-terminated
+ * @cat: Category (enum log_category_t)
+ * @level: Level (enum log_level_t)
+ */
+struct log_ringbuf_rec {
+	u32 time_us;
+	u16 len;
+	u8 cat;
+	u8 level;
+};
+
+/* Ring allocated after relocation, if it could not go in the bloblist */
+static struct log_ringbuf_hdr *log_ringbuf_alloced;
+
+static struct log_ringbuf_hdr *log_ringbuf_get(void)
+{
+	struct log_ringbuf_hdr *hdr = NULL;
+	uint size = sizeof(*hdr) + LOG_RINGBUF_SIZE;
+
+	BUILD_BUG_ON_NOT_POWER_OF_2(LOG_RINGBUF_SIZE);
+
+	/* the BSS is not available before relocation */
+	if (gd->flags & GD_FLG_RELOC)
+		hdr = log_ringbuf_alloced;
+	if (!hdr && CONFIG_IS_ENABLED(BLOBLIST) && gd_bloblist()) {
+		hdr = bloblist_find(BLOBLISTT_U_BOOT_LOG, size);
+		if (!hdr && !(gd->flags & GD_FLG_RELOC))
+			hdr = bloblist_add(BLOBLISTT_U_BOOT_LOG, size, 3);
+	}
+	if (!hdr && (gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		hdr = malloc(size);
+		log_ringbuf_alloced = hdr;
+	}
+	if (hdr && (hdr->magic != LOG_RINGBUF_MAGIC ||
+		    hdr->size != LOG_RINGBUF_SIZE)) {
+		hdr->magic = LOG_RINGBUF_MAGIC;
+		hdr->size = LOG_RINGBUF_SIZE;
+		hdr->head = 0;
+		hdr->tail = 0;
+	}
+
+	return hdr;
+}
+
+static void log_ringbuf_write(struct log_ringbuf_hdr *hdr, const void *buf,
+			      uint len)
+{
+	char *data = (char *)(hdr + 1);
+	uint pos = hdr->head & (hdr->size - 1);
+	uint first = min(len, hdr->size - pos);
+
+	memcpy(data + pos, buf, first);
+	memcpy(data, buf + first, len - first);
+	hdr->head += len;
+}
+
+static void log_ringbuf_read(struct log_ringbuf_hdr *hdr, uint offset,
+			     void *buf, uint len)
+{
+	const char *data = (const char *)(hdr + 1);
+	uint pos = offset & (hdr->size - 1);
+	uint first = min(len, hdr->size - pos);
+
+	memcpy(buf, data + pos, first);
+	memcpy(buf + first, data, len - first);
+}
+
+static int log_ringbuf_emit(struct log_device *ldev, struct log_rec *rec)
+{
+	struct log_ringbuf_hdr *hdr = log_ringbuf_get();
+	struct log_ringbuf_rec lrec;
+	uint len, need;
+
+	if (!hdr)
+		return -ENOSPC;
+
+	len = min_t(uint, strlen(rec->msg),
+		    min_t(uint, U16_MAX, hdr->size - sizeof(lrec)));
+	need = sizeof(lrec) + len;
+
+	/* drop the oldest records to make room */
+	while (hdr->size - (hdr->head - hdr->tail) < need) {
+		struct log_ringbuf_rec old;
+
+		log_ringbuf_read(hdr, hdr->tail, &old, sizeof(old));
+		hdr->tail += sizeof(old) + old.len;
+	}
+
+	lrec.time_us = timer_get_boot_us();
+	lrec.len = len;
+	lrec.cat = rec->cat;
+	lrec.level = rec->level;
+	log_ringbuf_write(hdr, &lrec, sizeof(lrec));
+	log_ringbuf_write(hdr, rec->msg, len);
+
+	return 0;
+}
+
+int log_ringbuf_dump(bool clear)
+{
+	struct log_ringbuf_hdr *hdr = log_ringbuf_get();
+	bool line_start = true;
+	uint offset;
+
+	if (!hdr)
+		return -ENOENT;
+
+	for (offset = hdr->tail; offset != hdr->head;) {
+		struct log_ringbuf_rec lrec;
+		char buf[80];
+		uint done;
+
+		log_ringbuf_read(hdr, offset, &lrec, sizeof(lrec));
+		offset += sizeof(lrec);
+
+		/* a continuation carries on from the previous message */
+		if (line_start)
+			printf("[%5u.%06u] %s.%s: ", lrec.time_us / 1000000,
+			       lrec.time_us % 1000000,
+			       log_get_level_name(lrec.level),
+			       log_get_cat_name(lrec.cat));
+		for (done = 0; done < lrec.len;) {
+			uint len = min_t(uint, lrec.len - done, sizeof(buf) - 1);
+
+			log_ringbuf_read(hdr, offset + done, buf, len);
+			buf[len] = '\0';
+			puts(buf);
+			done += len;
+		}
+		if (lrec.len) {
+			log_ringbuf_read(hdr, offset + lrec.len - 1, buf, 1);
+			line_start = buf[0] == '\n';
+		}
+		offset += lrec.len;
+	}
+	if (!line_start)
+		putc('\n');
+	if (clear)
+		hdr->tail = hdr->head;
+
+	return 0;
+}
+
+#if CONFIG_IS_ENABLED(OF_LIBFDT)
+/* Keep the ring from being overwritten by the OS, so it can be read */
+static int log_ringbuf_ft_fixup(void *ctx, struct event *event)
+{
+	static const char *const compat[] = { "u-boot,log-ringbuf" };
+	struct log_ringbuf_hdr *hdr = log_ringbuf_get();
+	void *blob = oftree_lookup_fdt(event->data.ft_fixup.tree);
+	struct fdt_memory mem;
+	int ret;
+
+	if (!hdr || !blob)
+		return 0;
+
+	mem.start = map_to_sysmem(hdr);
+	mem.end = mem.start + sizeof(*hdr) + hdr->size - 1;
+	ret = fdtdec_add_reserved_memory(blob, "u-boot-log", &mem,
+					 (const char **)compat,
+					 ARRAY_SIZE(compat), NULL, 0);
+	if (ret)
+		log_debug("Cannot reserve log ring (err=%d)\n", ret);
+
+	return 0;
+}
+EVENT_SPY_FULL(EVT_FT_FIXUP, log_ringbuf_ft_fixup);
+#endif
+
+LOG_DRIVER(ringbuf) = {
+	.name	= "ringbuf",
+	.emit	= log_ringbuf_emit,
+	.flags	= LOGDF_ENABLE,
+};
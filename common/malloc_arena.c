@@ -0,0 +1,594 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Size-class allocator for U-Boot proper
+ *
+ * Small requests are rounded up to one of a fixed set of size classes, each
+ * with its own free list, so that malloc() and free() of the many small
+ * objects allocated by driver model, the filesystems and the EFI loader take
+ * constant time. Blocks of a class are carved from the top of the heap on
+ * demand and are never split or merged.
+ *
+ * Larger requests use an address-ordered free list with first-fit, splitting
+ * and merging of neighbouring free blocks. A free block at the top of the
+ * heap is given back, so that memory used by a large temporary buffer can
+ * later serve any class.
+ *
+ * Each block is preceded by a header holding its usable size and its class,
+ * which is all that free() needs.
+ */
+
+#define LOG_CATEGORY	LOGC_ALLOC
+
+#include <log.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <string.h>
+#include <asm/global_data.h>
+#include <linux/bitops.h>
+#include <linux/kernel.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#ifdef MCHECK_HEAP_PROTECTION
+#error "MCHECK_HEAP_PROTECTION is not supported by CONFIG_SYS_MALLOC_ARENA"
+#endif
+
+enum {
+	/* Classes of 16 to 128 bytes in steps of 16 */
+	ARENA_FINE_CLASSES	= 8,
+	ARENA_FINE_MAX		= 128,
+
+	/* Then four classes per power of two, up to ARENA_SMALL_MAX */
+	ARENA_STEPS		= 4,
+	ARENA_SMALL_MAX		= 4096,
+	ARENA_CLASSES		= ARENA_FINE_CLASSES + 5 * ARENA_STEPS,
+
+	/* Do not split a large block if less than this would be left */
+	ARENA_MIN_SPLIT		= 256,
+};
+
+/* Values of arena_hdr->info, other than a class number */
+#define ARENA_LARGE	0x100
+#define ARENA_FREE	0x200
+#define ARENA_ALIGNED	((size_t)1 << (sizeof(size_t) * 8 - 1))
+
+/**
+ * struct arena_hdr - header placed before each block
+ *
+ * @size: Number of usable bytes following the header
+ * @info: Size class, or ARENA_LARGE, with ARENA_FREE while the block is free.
+ *	For a block returned by memalign() with more alignment than malloc()
+ *	gives, this is ARENA_ALIGNED ORed with the number of bytes between the
+ *	payload of the underlying block and this one
+ */
+struct arena_hdr {
+	size_t size;
+	size_t info;
+};
+
+#define ARENA_ALIGN	sizeof(struct arena_hdr)
+
+/**
+ * struct arena_chunk - a free block
+ *
+ * @hdr: Header of the block
+ * @next: Next free block of the same class, or next large free block by
+ *	address
+ */
+struct arena_chunk {
+	struct arena_hdr hdr;
+	struct arena_chunk *next;
+};
+
+/**
+ * struct arena_class_stats - statistics of one size class
+ *
+ * @allocs: Number of allocations made
+ * @in_use: Number of blocks allocated now
+ * @free: Number of blocks on the free list
+ */
+struct arena_class_stats {
+	ulong allocs;
+	ulong in_use;
+	ulong free;
+};
+
+ulong mem_malloc_start;
+ulong mem_malloc_end;
+ulong mem_malloc_brk;
+
+static struct arena_chunk *arena_small[ARENA_CLASSES];
+static struct arena_chunk *arena_large;
+
+static struct arena_class_stats arena_class_stats[ARENA_CLASSES];
+static ulong arena_large_allocs;	/* Number of large allocations made */
+static ulong arena_large_in_use;	/* Number of large blocks allocated */
+static ulong arena_in_use;		/* Bytes allocated, with headers */
+static ulong arena_peak;		/* Highest value of arena_in_use */
+
+static bool malloc_testing;	/* enable test mode */
+static int malloc_max_allocs;	/* return NULL after this many calls to malloc() */
+
+static size_t arena_class_size(uint cls)
+{
+	size_t base;
+
+	if (cls < ARENA_FINE_CLASSES)
+		return (cls + 1) * (ARENA_FINE_MAX / ARENA_FINE_CLASSES);
+	cls -= ARENA_FINE_CLASSES;
+	base = ARENA_FINE_MAX << (cls / ARENA_STEPS);
+
+	return base + (cls % ARENA_STEPS + 1) * (base / ARENA_STEPS);
+}
+
+/* Size class of a request, which must be at most ARENA_SMALL_MAX bytes */
+static uint arena_class(size_t bytes)
+{
+	size_t base, step;
+	uint group;
+
+	if (bytes <= ARENA_FINE_MAX)
+		return bytes ? (bytes - 1) / (ARENA_FINE_MAX / ARENA_FINE_CLASSES) : 0;
+	group = fls(bytes - 1) - fls(ARENA_FINE_MAX);
+	base = ARENA_FINE_MAX << group;
+	step = base / ARENA_STEPS;
+
+	return ARENA_FINE_CLASSES + group * ARENA_STEPS +
+		(bytes - base + step - 1) / step - 1;
+}
+
+static struct arena_hdr *arena_mem2hdr(void *mem)
+{
+	return (struct arena_hdr *)mem - 1;
+}
+
+static void arena_account(struct arena_hdr *hdr, bool alloc)
+{
+	ulong bytes = sizeof(*hdr) + hdr->size;
+
+	if (alloc) {
+		arena_in_use += bytes;
+		arena_peak = max(arena_peak, arena_in_use);
+	} else {
+		arena_in_use -= bytes;
+	}
+}
+
+/**
+ * arena_bump() - Take a new block from the top of the heap
+ *
+ * @size: Usable size of the block, a multiple of ARENA_ALIGN
+ * Return: header of the block, or NULL if the heap is full
+ */
+static struct arena_hdr *arena_bump(size_t size)
+{
+	struct arena_hdr *hdr = (struct arena_hdr *)mem_malloc_brk;
+
+	if (mem_malloc_end - mem_malloc_brk < sizeof(*hdr) + size)
+		return NULL;
+	mem_malloc_brk += sizeof(*hdr) + size;
+	hdr->size = size;
+
+	return hdr;
+}
+
+/**
+ * arena_take_large() - Take a block from the large free list
+ *
+ * The first block which is big enough is used, and any remainder of at
+ * least ARENA_MIN_SPLIT bytes stays on the list.
+ *
+ * @size: Usable size needed, a multiple of ARENA_ALIGN
+ * Return: header of the block, or NULL if there is none big enough
+ */
+static struct arena_hdr *arena_take_large(size_t size)
+{
+	struct arena_chunk **linkp, *chunk, *rest;
+
+	for (linkp = &arena_large; (chunk = *linkp); linkp = &chunk->next) {
+		if (chunk->hdr.size < size)
+			continue;
+		if (chunk->hdr.size - size >= ARENA_MIN_SPLIT) {
+			rest = (void *)chunk + sizeof(chunk->hdr) + size;
+			rest->hdr.size = chunk->hdr.size - size -
+				sizeof(rest->hdr);
+			rest->hdr.info = ARENA_LARGE | ARENA_FREE;
+			rest->next = chunk->next;
+			chunk->hdr.size = size;
+			*linkp = rest;
+		} else {
+			*linkp = chunk->next;
+		}
+
+		return &chunk->hdr;
+	}
+
+	return NULL;
+}
+
+/**
+ * arena_free_large() - Put a large block on the free list
+ *
+ * The block is merged with free neighbours, and given back to the top of
+ * the heap if it ends there.
+ *
+ * @hdr: Header of the block
+ */
+static void arena_free_large(struct arena_hdr *hdr)
+{
+	struct arena_chunk *chunk = (struct arena_chunk *)hdr, *prev = NULL;
+	struct arena_chunk **linkp, *next;
+
+	for (linkp = &arena_large; (next = *linkp) && next < chunk;
+	     linkp = &next->next)
+		prev = next;
+
+	hdr->info = ARENA_LARGE | ARENA_FREE;
+	chunk->next = next;
+	*linkp = chunk;
+
+	if (next && (void *)chunk + sizeof(*hdr) + hdr->size == (void *)next) {
+		hdr->size += sizeof(next->hdr) + next->hdr.size;
+		chunk->next = next->next;
+	}
+	if (prev && (void *)prev + sizeof(prev->hdr) + prev->hdr.size ==
+	    (void *)chunk) {
+		prev->hdr.size += sizeof(*hdr) + hdr->size;
+		prev->next = chunk->next;
+		chunk = prev;
+	}
+
+	/* the last free block may end at the top of the heap */
+	if (!chunk->next && (ulong)chunk + sizeof(chunk->hdr) +
+	    chunk->hdr.size == mem_malloc_brk) {
+		struct arena_chunk **endp;
+
+		for (endp = &arena_large; *endp != chunk; endp = &(*endp)->next)
+			;
+		*endp = NULL;
+		mem_malloc_brk = (ulong)chunk;
+	}
+}
+
+static void *arena_get(size_t bytes)
+{
+	struct arena_hdr *hdr;
+
+	if (bytes <= ARENA_SMALL_MAX) {
+		uint cls = arena_class(bytes);
+		struct arena_class_stats *stats = &arena_class_stats[cls];
+		struct arena_chunk *chunk = arena_small[cls];
+
+		if (chunk) {
+			arena_small[cls] = chunk->next;
+			stats->free--;
+			hdr = &chunk->hdr;
+		} else {
+			size_t size = arena_class_size(cls);
+
+			hdr = arena_bump(size);
+			if (!hdr)
+				hdr = arena_take_large(size);
+			if (!hdr)
+				return NULL;
+		}
+		hdr->info = cls;
+		stats->allocs++;
+		stats->in_use++;
+	} else {
+		size_t size = ALIGN(bytes, ARENA_ALIGN);
+
+		hdr = arena_take_large(size);
+		if (!hdr)
+			hdr = arena_bump(size);
+		if (!hdr)
+			return NULL;
+		hdr->info = ARENA_LARGE;
+		arena_large_allocs++;
+		arena_large_in_use++;
+	}
+	arena_account(hdr, true);
+
+	return hdr + 1;
+}
+
+/* Check that a pointer is one which needs to be freed */
+static bool arena_owns(void *mem)
+{
+	ulong addr = (ulong)mem;
+
+	return addr > mem_malloc_start && addr < mem_malloc_brk;
+}
+
+static void arena_put(void *mem)
+{
+	struct arena_hdr *hdr = arena_mem2hdr(mem);
+
+	if (hdr->info & ARENA_ALIGNED) {
+		mem -= hdr->info & ~ARENA_ALIGNED;
+		hdr = arena_mem2hdr(mem);
+	}
+	if (hdr->info & ARENA_FREE) {
+		log_err("free() of free block %p\n", mem);
+		return;
+	}
+	arena_account(hdr, false);
+
+	if (hdr->info == ARENA_LARGE) {
+		arena_large_in_use--;
+		arena_free_large(hdr);
+	} else if (hdr->info < ARENA_CLASSES) {
+		struct arena_chunk *chunk = (struct arena_chunk *)hdr;
+		uint cls = hdr->info;
+
+		hdr->info |= ARENA_FREE;
+		chunk->next = arena_small[cls];
+		arena_small[cls] = chunk;
+		arena_class_stats[cls].in_use--;
+		arena_class_stats[cls].free++;
+	} else {
+		log_err("free() of invalid block %p\n", mem);
+	}
+}
+
+void mem_malloc_init(ulong start, ulong size)
+{
+	mem_malloc_start = (ulong)map_sysmem(start, size);
+	mem_malloc_end = mem_malloc_start + size;
+	mem_malloc_brk = ALIGN(mem_malloc_start, ARENA_ALIGN);
+
+	memset(arena_small, '\0', sizeof(arena_small));
+	memset(arena_class_stats, '\0', sizeof(arena_class_stats));
+	arena_large = NULL;
+	arena_large_allocs = 0;
+	arena_large_in_use = 0;
+	arena_in_use = 0;
+	arena_peak = 0;
+
+	debug("using memory %#lx-%#lx for malloc()\n", mem_malloc_start,
+	      mem_malloc_end);
+#if CONFIG_IS_ENABLED(SYS_MALLOC_CLEAR_ON_INIT)
+	memset((void *)mem_malloc_start, 0x0, size);
+#endif
+}
+
+void *sbrk(ptrdiff_t increment)
+{
+	ulong old = mem_malloc_brk;
+	ulong new = old + increment;
+
+	if (new < mem_malloc_start || new > mem_malloc_end)
+		return (void *)MORECORE_FAILURE;
+	mem_malloc_brk = new;
+
+	return (void *)old;
+}
+
+Void_t *mALLOc(size_t bytes)
+{
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F)
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return malloc_simple(bytes);
+#endif
+
+	if (CONFIG_IS_ENABLED(UNIT_TEST) && malloc_testing) {
+		if (--malloc_max_allocs < 0)
+			return NULL;
+	}
+
+	/* check if mem_malloc_init() was run */
+	if (!mem_malloc_start && !mem_malloc_end)
+		return NULL;
+
+	if (bytes > CONFIG_SYS_MALLOC_LEN || (long)bytes < 0)
+		return NULL;
+
+	return arena_get(bytes);
+}
+
+void fREe(Void_t *mem)
+{
+	/* free() is a no-op - all the memory will be freed on relocation */
+	if (CONFIG_IS_ENABLED(SYS_MALLOC_F) &&
+	    !(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return;
+
+	/* also ignore blocks allocated before relocation */
+	if (!mem || !arena_owns(mem))
+		return;
+
+	arena_put(mem);
+}
+
+void cfree(Void_t *mem)
+{
+	fREe(mem);
+}
+
+Void_t *mEMALIGn(size_t alignment, size_t bytes)
+{
+	struct arena_hdr *hdr;
+	void *mem, *aligned;
+
+	if (bytes > CONFIG_SYS_MALLOC_LEN || (long)bytes < 0)
+		return NULL;
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F)
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return memalign_simple(alignment, bytes);
+#endif
+
+	if (alignment <= ARENA_ALIGN)
+		return mALLOc(bytes);
+
+	/* leave room to move the payload up, with a header in front of it */
+	mem = mALLOc(bytes + alignment + sizeof(*hdr));
+	if (!mem || IS_ALIGNED((ulong)mem, alignment))
+		return mem;
+
+	aligned = (void *)ALIGN((ulong)mem + sizeof(*hdr), alignment);
+	hdr = arena_mem2hdr(aligned);
+	hdr->size = arena_mem2hdr(mem)->size - (aligned - mem);
+	hdr->info = ARENA_ALIGNED | (aligned - mem);
+
+	return aligned;
+}
+
+Void_t *rEALLOc(Void_t *oldmem, size_t bytes)
+{
+	struct arena_hdr *hdr;
+	size_t old_size;
+	void *mem;
+
+	if (bytes > CONFIG_SYS_MALLOC_LEN || (long)bytes < 0)
+		return NULL;
+
+	/* realloc of null is supposed to be same as malloc */
+	if (!oldmem)
+		return mALLOc(bytes);
+
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F)
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		/* This is harder to support and should not be needed */
+		panic("pre-reloc realloc() is not supported");
+	}
+#endif
+
+	hdr = arena_mem2hdr(oldmem);
+	old_size = hdr->size;
+	if (bytes <= old_size)
+		return oldmem;
+
+	if (CONFIG_IS_ENABLED(UNIT_TEST) && malloc_testing) {
+		if (--malloc_max_allocs < 0)
+			return NULL;
+	}
+
+	/* a large block at the top of the heap can simply grow */
+	if (hdr->info == ARENA_LARGE &&
+	    (ulong)oldmem + old_size == mem_malloc_brk) {
+		size_t extra = ALIGN(bytes, ARENA_ALIGN) - old_size;
+
+		if (extra <= mem_malloc_end - mem_malloc_brk) {
+			mem_malloc_brk += extra;
+			hdr->size += extra;
+			arena_in_use += extra;
+			arena_peak = max(arena_peak, arena_in_use);
+
+			return oldmem;
+		}
+	}
+
+	mem = arena_get(bytes);
+	if (!mem)
+		return NULL;
+	memcpy(mem, oldmem, old_size);
+	arena_put(oldmem);
+
+	return mem;
+}
+
+Void_t *cALLOc(size_t n, size_t elem_size)
+{
+	size_t bytes;
+	void *mem;
+
+	if (__builtin_mul_overflow(n, elem_size, &bytes))
+		return NULL;
+	mem = mALLOc(bytes);
+	if (mem)
+		memset(mem, '\0', bytes);
+
+	return mem;
+}
+
+Void_t *vALLOc(size_t bytes)
+{
+	return mEMALIGn(malloc_getpagesize, bytes);
+}
+
+Void_t *pvALLOc(size_t bytes)
+{
+	size_t pagesize = malloc_getpagesize;
+
+	return mEMALIGn(pagesize, ALIGN(bytes, pagesize));
+}
+
+int malloc_trim(size_t pad)
+{
+	/* free memory at the top of the heap is given back in free() */
+	return 0;
+}
+
+size_t malloc_usable_size(Void_t *mem)
+{
+	return mem ? arena_mem2hdr(mem)->size : 0;
+}
+
+int mALLOPt(int param_number, int value)
+{
+	return 0;
+}
+
+struct mallinfo mALLINFo(void)
+{
+	struct mallinfo info = {};
+	struct arena_chunk *chunk;
+
+	for (chunk = arena_large; chunk; chunk = chunk->next)
+		info.ordblks++;
+	info.arena = mem_malloc_brk - mem_malloc_start;
+	info.uordblks = arena_in_use;
+	info.fordblks = info.arena - arena_in_use;
+	info.keepcost = mem_malloc_end - mem_malloc_brk;
+
+	return info;
+}
+
+void malloc_stats(void)
+{
+	struct arena_chunk *chunk;
+	ulong free_bytes = 0;
+	int i, free_count = 0;
+
+	printf("heap       %lx-%lx, top %lx\n", mem_malloc_start, mem_malloc_end,
+	       mem_malloc_brk);
+	printf("in use     %lu bytes, peak %lu bytes\n", arena_in_use,
+	       arena_peak);
+	printf("\n%8s %10s %10s %10s\n", "Size", "Allocs", "In use", "Free");
+	for (i = 0; i < ARENA_CLASSES; i++) {
+		struct arena_class_stats *stats = &arena_class_stats[i];
+
+		if (stats->allocs)
+			printf("%8zu %10lu %10lu %10lu\n", arena_class_size(i),
+			       stats->allocs, stats->in_use, stats->free);
+	}
+	for (chunk = arena_large; chunk; chunk = chunk->next) {
+		free_count++;
+		free_bytes += chunk->hdr.size;
+	}
+	printf("%8s %10lu %10lu %10d (%lu bytes)\n", "large",
+	       arena_large_allocs, arena_large_in_use, free_count, free_bytes);
+}
+
+int initf_malloc(void)
+{
+#if CONFIG_IS_ENABLED(SYS_MALLOC_F)
+	assert(gd->malloc_base);	/* Set up by crt0.S */
+	gd->malloc_limit = CONFIG_VAL(SYS_MALLOC_F_LEN);
+	gd->malloc_ptr = 0;
+#endif
+
+	return 0;
+}
+
+void malloc_enable_testing(int max_allocs)
+{
+	malloc_testing = true;
+	malloc_max_allocs = max_allocs;
+}
+
+void malloc_disable_testing(void)
+{
+	malloc_testing = false;
+}
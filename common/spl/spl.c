@@ -9,6 +9,7 @@
 #include <config.h>
 #include <bloblist.h>
 #include <binman_sym.h>
+#include <blk.h>
 #include <bootstage.h>
 #include <dm.h>
 #include <handoff.h>
@@ -392,6 +393,56 @@ int spl_load(struct spl_image_info *spl_image,
 }
 #endif
 
+#if IS_ENABLED(CONFIG_SPL_LOAD_CHUNK)
+int spl_load_chunk_init(struct spl_load_chunk *it, struct spl_load_info *info,
+			ulong offset, ulong size, void *buf, ulong buf_size)
+{
+	ulong bl_len = spl_get_bl_len(info);
+	ulong skip = offset & (bl_len - 1);
+
+	if (buf_size < bl_len)
+		return -ENOBUFS;
+
+	it->info = info;
+	it->read_offset = offset - skip;
+	it->skip = skip;
+	it->left = size;
+	it->buf = buf;
+	it->chunk = spl_get_chunk_size(info);
+	it->reuse = buf_size < ALIGN(skip + size, bl_len);
+	if (it->reuse)
+		it->chunk = min(it->chunk, ALIGN_DOWN(buf_size, bl_len));
+
+	return 0;
+}
+
+int spl_load_chunk_next(struct spl_load_chunk *it, const void **datap,
+			ulong *lenp)
+{
+	ulong want, len;
+
+	if (!it->left)
+		return 0;
+
+	want = min(it->chunk, ALIGN(it->skip + it->left,
+				    spl_get_bl_len(it->info)));
+	len = min(want - it->skip, it->left);
+	if (it->info->read(it->info, it->read_offset, want, it->buf) <
+	    it->skip + len)
+		return -EIO;
+
+	*datap = it->buf + it->skip;
+	*lenp = len;
+	it->read_offset += want;
+	it->left -= len;
+	it->skip = 0;
+	if (!it->reuse)
+		it->buf += want;
+
+	return 1;
+}
+#endif
+
 __weak void __noreturn jump_to_image_no_args(struct spl_image_info *spl_image)
 {
 	typedef void __noreturn (*image_entry_noargs_t)(void);
@@ -806,6 +857,7 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 		      gd_malloc_ptr(), gd_malloc_ptr() / 1024);
 
 	bootstage_mark_name(get_bootstage_id(false), "end phase");
+	blk_stats_bootstage();
 	ret = bootstage_stash_default();
 	if (ret)
 		debug("Failed to stash bootstage: err=%d\n", ret);
@@ -188,8 +188,27 @@ static inline void raw_write_daif(unsigned int daif)
 
 typedef void __noreturn (*atf_entry_t)(struct bl31_params *params, void *plat_params);
 
+/* Linux expects the devicetree address in x0, rather than the CPU MPID */
+static void bl31_params_set_linux(void *bl31_params, ulong fdt_addr)
+{
+	struct bl_params_node *node;
+
+	if (!CONFIG_IS_ENABLED(ATF_LOAD_IMAGE_V2)) {
+		((struct bl31_params *)bl31_params)->bl33_ep_info->args.arg0 =
+			fdt_addr;
+		return;
+	}
+
+	for (node = ((struct bl_params *)bl31_params)->head; node;
+	     node = node->next_params_info) {
+		if (node->image_id == ATF_BL33_IMAGE_ID)
+			node->ep_info->args.arg0 = fdt_addr;
+	}
+}
+
 static void __noreturn bl31_entry(ulong bl31_entry, ulong bl32_entry,
-				  ulong bl33_entry, ulong fdt_addr)
+				  ulong bl33_entry, ulong fdt_addr,
+				  ulong linux_fdt_addr)
 {
 	atf_entry_t  atf_entry = (atf_entry_t)bl31_entry;
 	void *bl31_params;
@@ -201,6 +220,8 @@ static void __noreturn bl31_entry(ulong bl31_entry, ulong bl32_entry,
 	else
 		bl31_params = bl2_plat_get_bl31_params(bl32_entry, bl33_entry,
 						       fdt_addr);
+	if (linux_fdt_addr)
+		bl31_params_set_linux(bl31_params, linux_fdt_addr);
 
 	raw_write_daif(SPSR_EXCEPTION_MASK);
 	if (!CONFIG_IS_ENABLED(SYS_DCACHE_OFF))
@@ -257,6 +278,7 @@ void __noreturn spl_invoke_atf(struct spl_image_info *spl_image)
 	ulong  bl33_entry = CONFIG_TEXT_BASE;
 	void *blob = spl_image->fdt_addr;
 	ulong platform_param = (ulong)blob;
+	ulong linux_fdt_addr = 0;
 	int node;
 
 	/*
@@ -272,12 +294,20 @@ void __noreturn spl_invoke_atf(struct spl_image_info *spl_image)
 	 * Find the U-Boot binary (in /fit-images) load addreess or
 	 * entry point (if different) and pass it as the BL3-3 entry
 	 * point.
-	 * This will need to be extended to support Falcon mode.
+	 *
+	 * In Falcon mode there is no U-Boot, so Linux is the BL3-3 and is
+	 * given the devicetree from the FIT.
 	 */
-
 	node = spl_fit_images_find(blob, IH_OS_U_BOOT);
-	if (node >= 0)
+	if (node >= 0) {
 		bl33_entry = spl_fit_images_get_entry(blob, node);
+	} else if (CONFIG_IS_ENABLED(OS_BOOT)) {
+		node = spl_fit_images_find(blob, IH_OS_LINUX);
+		if (node >= 0) {
+			bl33_entry = spl_fit_images_get_entry(blob, node);
+			linux_fdt_addr = (ulong)blob;
+		}
+	}
 
 	/*
 	 * If ATF_NO_PLATFORM_PARAM is set, we override the platform
@@ -293,5 +323,5 @@ void __noreturn spl_invoke_atf(struct spl_image_info *spl_image)
 	 * using similar logic.
 	 */
 	bl31_entry(spl_image->entry_point, bl32_entry,
-		   bl33_entry, platform_param);
+		   bl33_entry, platform_param, linux_fdt_addr);
 }
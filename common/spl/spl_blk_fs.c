@@ -9,6 +9,7 @@
 #include <spl_load.h>
 #include <image.h>
 #include <fs.h>
+#include <linux/sizes.h>
 #include <asm/cache.h>
 #include <asm/io.h>
 
@@ -83,5 +84,10 @@ int spl_blk_load_image(struct spl_image_info *spl_image,
 	spl_load_init(&load, spl_fit_read, &dev,
 		      IS_ENABLED(CONFIG_SPL_FS_FAT_DMA_ALIGN) ?
 		      ARCH_DMA_MINALIGN : 1);
+	/*
+	 * Every read sets up the block device and looks the file up again,
+	 * so ask for large chunks to keep that overhead down.
+	 */
+	spl_set_chunk_size(&load, SZ_1M);
 	return spl_load(spl_image, bootdev, &load, filesize, 0);
 }
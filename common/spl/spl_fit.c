@@ -7,6 +7,7 @@
 #include <errno.h>
 #include <fpga.h>
 #include <gzip.h>
+#include <hash.h>
 #include <image.h>
 #include <log.h>
 #include <memalign.h>
@@ -18,6 +19,9 @@
 #include <asm/io.h>
 #include <linux/libfdt.h>
 #include <linux/printk.h>
+#include <linux/zstd.h>
+#include <u-boot/lz4.h>
+#include <u-boot/zlib.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -187,6 +191,299 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 	return ALIGN(data_size, spl_get_bl_len(info));
 }
 
+#if CONFIG_IS_ENABLED(LOAD_FIT_STREAM)
+#define SPL_FIT_STREAM_MAX_HASHES	4
+
+/**
+ * struct spl_fit_stream - state of an image being streamed from the device
+ * @algo:	progressive hash algorithm for each hash node
+ * @ctx:	hash context for each hash node
+ * @hash_node:	FIT offset of each hash node
+ * @nhashes:	number of hash nodes being computed
+ * @gzip:	true if the image is inflated while it is read
+ * @zstd:	true if the image is zstd-decompressed while it is read
+ * @lz4:	true if the image is LZ4-decompressed while it is read
+ * @header:	true once the gzip header has been skipped
+ * @done:	true once inflate() reported the end of the stream
+ * @zs:		inflate state
+ * @zst:	zstd stream state
+ * @lz4s:	LZ4 stream state
+ */
+struct spl_fit_stream {
+	struct hash_algo *algo[SPL_FIT_STREAM_MAX_HASHES];
+	void *ctx[SPL_FIT_STREAM_MAX_HASHES];
+	int hash_node[SPL_FIT_STREAM_MAX_HASHES];
+	int nhashes;
+	bool gzip;
+	bool zstd;
+	bool lz4;
+	bool header;
+	bool done;
+	z_stream zs;
+	struct zstd_stream zst;
+	struct ulz4_stream lz4s;
+};
+
+/*
+ * A required "image" key means fit_image_verify_with_data() has to check a
+ * signature over the whole image, which cannot be done chunk by chunk.
+ */
+static bool spl_fit_stream_needs_image_sig(void)
+{
+	const void *blob = gd_fdt_blob();
+	const char *required;
+	int sig_node, noffset;
+
+	if (!CONFIG_IS_ENABLED(FIT_SIGNATURE) || !blob)
+		return false;
+
+	sig_node = fdt_subnode_offset(blob, 0, FIT_SIG_NODENAME);
+	if (sig_node < 0)
+		return false;
+
+	fdt_for_each_subnode(noffset, blob, sig_node) {
+		required = fdt_getprop(blob, noffset, FIT_KEY_REQUIRED, NULL);
+		if (required && !strcmp(required, "image"))
+			return true;
+	}
+
+	return false;
+}
+
+static int spl_fit_stream_init(struct spl_fit_stream *st, const void *fit,
+			       int node, uint8_t image_comp, void *load_ptr)
+{
+	const char *name, *algo_name;
+	int noffset, i;
+
+	memset(st, '\0', sizeof(*st));
+
+	if (CONFIG_IS_ENABLED(FIT_IMAGE_POST_PROCESS) ||
+	    spl_fit_stream_needs_image_sig())
+		return -ENOTSUPP;
+
+	if (spl_decompression_enabled() && image_comp == IH_COMP_GZIP) {
+		if (!IS_ENABLED(CONFIG_SPL_GZIP))
+			return -ENOTSUPP;
+		st->gzip = true;
+	} else if (spl_decompression_enabled() && image_comp == IH_COMP_ZSTD) {
+		if (!IS_ENABLED(CONFIG_SPL_ZSTD))
+			return -ENOTSUPP;
+		st->zstd = true;
+	} else if (spl_decompression_enabled() && image_comp == IH_COMP_LZ4) {
+		if (!IS_ENABLED(CONFIG_SPL_LZ4))
+			return -ENOTSUPP;
+		st->lz4 = true;
+	} else if (spl_decompression_enabled() && image_comp != IH_COMP_NONE) {
+		return -ENOTSUPP;
+	}
+
+	if (CONFIG_IS_ENABLED(FIT_SIGNATURE)) {
+		fdt_for_each_subnode(noffset, fit, node) {
+			name = fit_get_name(fit, noffset, NULL);
+			if (!strncmp(name, FIT_SIG_NODENAME,
+				     strlen(FIT_SIG_NODENAME)))
+				return -ENOTSUPP;
+			if (strncmp(name, FIT_HASH_NODENAME,
+				    strlen(FIT_HASH_NODENAME)))
+				continue;
+			if (st->nhashes == SPL_FIT_STREAM_MAX_HASHES ||
+			    fit_image_hash_get_algo(fit, noffset, &algo_name) ||
+			    hash_progressive_lookup_algo(algo_name,
+							 &st->algo[st->nhashes]))
+				return -ENOTSUPP;
+			st->hash_node[st->nhashes++] = noffset;
+		}
+	}
+
+	for (i = 0; i < st->nhashes; i++)
+		if (st->algo[i]->hash_init(st->algo[i], &st->ctx[i]))
+			return -ENOMEM;
+
+	if (st->gzip) {
+		st->zs.zalloc = gzalloc;
+		st->zs.zfree = gzfree;
+		if (inflateInit2(&st->zs, -MAX_WBITS) != Z_OK)
+			return -ENOMEM;
+		st->zs.next_out = load_ptr;
+		st->zs.avail_out = CONFIG_SYS_BOOTM_LEN;
+	}
+	if (IS_ENABLED(CONFIG_SPL_ZSTD) && st->zstd)
+		zstd_stream_init(&st->zst, load_ptr, CONFIG_SYS_BOOTM_LEN,
+				 IF_ENABLED_INT(CONFIG_SPL_ZSTD,
+						CONFIG_SPL_ZSTD_MAX_WINDOW));
+	if (IS_ENABLED(CONFIG_SPL_LZ4) && st->lz4)
+		ulz4_stream_init(&st->lz4s, load_ptr, CONFIG_SYS_BOOTM_LEN);
+
+	return 0;
+}
+
+static int spl_fit_stream_chunk(struct spl_fit_stream *st, const u8 *data,
+				ulong len, bool is_last)
+{
+	int i, r, offset;
+
+	for (i = 0; i < st->nhashes; i++)
+		if (st->algo[i]->hash_update(st->algo[i], st->ctx[i], data,
+					     len, is_last))
+			return -EIO;
+
+	if (IS_ENABLED(CONFIG_SPL_ZSTD) && st->zstd)
+		return zstd_stream_add(&st->zst, data, len) ? -EIO : 0;
+	if (IS_ENABLED(CONFIG_SPL_LZ4) && st->lz4)
+		return ulz4_stream_add(&st->lz4s, data, len) ? -EIO : 0;
+	if (!st->gzip || st->done || !len)
+		return 0;
+
+	if (!st->header) {
+		offset = gzip_parse_header(data, len);
+		if (offset < 0)
+			return -EIO;
+		data += offset;
+		len -= offset;
+		st->header = true;
+	}
+
+	st->zs.next_in = (u8 *)data;
+	st->zs.avail_in = len;
+	r = inflate(&st->zs, Z_SYNC_FLUSH);
+	if (r == Z_STREAM_END)
+		st->done = true;
+	else if (r != Z_OK)
+		return -EIO;
+
+	return 0;
+}
+
+static int spl_fit_stream_finish(struct spl_fit_stream *st, const void *fit,
+				 int node, size_t *lengthp)
+{
+	u8 value[FIT_MAX_HASH_LEN];
+	u8 *fit_value;
+	int i, fit_value_len, ret = 0;
+
+	if (st->gzip) {
+		if (!st->done) {
+			puts("Uncompressing error\n");
+			ret = -EIO;
+		}
+		*lengthp = st->zs.total_out;
+		inflateEnd(&st->zs);
+	}
+	if (IS_ENABLED(CONFIG_SPL_ZSTD) && st->zstd) {
+		ret = zstd_stream_finish(&st->zst);
+		if (ret < 0) {
+			puts("Uncompressing error\n");
+			ret = -EIO;
+		} else {
+			*lengthp = ret;
+			ret = 0;
+		}
+	}
+	if (IS_ENABLED(CONFIG_SPL_LZ4) && st->lz4) {
+		ret = ulz4_stream_finish(&st->lz4s, lengthp);
+		if (ret) {
+			puts("Uncompressing error\n");
+			ret = -EIO;
+		}
+	}
+
+	if (!CONFIG_IS_ENABLED(FIT_SIGNATURE))
+		return ret;
+
+	printf("## Checking hash(es) for Image %s ... ",
+	       fit_get_name(fit, node, NULL));
+	for (i = 0; i < st->nhashes; i++) {
+		if (st->algo[i]->hash_finish(st->algo[i], st->ctx[i], value,
+					     sizeof(value)) ||
+		    fit_image_hash_get_value(fit, st->hash_node[i], &fit_value,
+					     &fit_value_len) ||
+		    fit_value_len != st->algo[i]->digest_size ||
+		    memcmp(value, fit_value, fit_value_len)) {
+			printf(" error!\nBad hash value for '%s' hash node in '%s' image node\n",
+			       fit_get_name(fit, st->hash_node[i], NULL),
+			       fit_get_name(fit, node, NULL));
+			return -EPERM;
+		}
+		puts("+ ");
+	}
+	puts("OK\n");
+
+	return ret;
+}
+
+/**
+ * spl_fit_stream_load() - read an external image chunk by chunk
+ * @info:	points to information about the device to load data from
+ * @fit:	pointer to the FIT blob
+ * @node:	offset of the image node
+ * @image_comp:	compression of the image
+ * @offset:	device offset of the image data
+ * @lengthp:	size of the image data; updated to the uncompressed size for
+ *		compressed images
+ * @src_ptr:	for uncompressed images, where the block-aligned image is read
+ *		to; for compressed images, a staging area for a single chunk
+ * @load_ptr:	where compressed images are decompressed to
+ *
+ * Each chunk is hashed, and decompressed for gzip and zstd images, straight
+ * after it has been read, so the whole image never needs to be walked a
+ * second time.
+ *
+ * Return:	0 on success, -ENOTSUPP if the image cannot be streamed and the
+ *		caller should load it the regular way, or another negative error
+ *		number on failure
+ */
+static int spl_fit_stream_load(struct spl_load_info *info, const void *fit,
+			       int node, uint8_t image_comp, ulong offset,
+			       size_t *lengthp, void *src_ptr, void *load_ptr)
+{
+	struct spl_fit_stream st;
+	struct spl_load_chunk it;
+	const void *data;
+	ulong len;
+	int ret;
+
+	ret = spl_fit_stream_init(&st, fit, node, image_comp, load_ptr);
+	if (ret)
+		return ret;
+
+	ret = spl_load_chunk_init(&it, info, offset, *lengthp, src_ptr,
+				  st.gzip || st.zstd || st.lz4 ?
+				  spl_get_chunk_size(info) :
+				  get_aligned_image_size(info, *lengthp,
+							 offset));
+	if (ret)
+		return ret;
+
+	while ((ret = spl_load_chunk_next(&it, &data, &len)) > 0) {
+		ret = spl_fit_stream_chunk(&st, data, len, !it.left);
+		if (ret) {
+			if (st.gzip || st.zstd || st.lz4)
+				puts("Uncompressing error\n");
+			break;
+		}
+	}
+	if (ret) {
+		size_t size;
+
+		if (IS_ENABLED(CONFIG_SPL_ZSTD) && st.zstd)
+			zstd_stream_finish(&st.zst);
+		if (IS_ENABLED(CONFIG_SPL_LZ4) && st.lz4)
+			ulz4_stream_finish(&st.lz4s, &size);
+		return ret;
+	}
+
+	return spl_fit_stream_finish(&st, fit, node, lengthp);
+}
+#else
+static int spl_fit_stream_load(struct spl_load_info *info, const void *fit,
+			       int node, uint8_t image_comp, ulong offset,
+			       size_t *lengthp, void *src_ptr, void *load_ptr)
+{
+	return -ENOTSUPP;
+}
+#endif
+
 /**
  * load_simple_fit(): load the image described in a certain FIT node
  * @info:	points to information about the device to load data from
@@ -219,12 +516,13 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 	const void *data;
 	const void *fit = ctx->fit;
 	bool external_data = false;
+	bool streamed = false;
+	int ret;
 
 	log_debug("starting\n");
 	if (CONFIG_IS_ENABLED(BOOTMETH_VBE) &&
 	    xpl_get_phase(info) != IH_PHASE_NONE) {
 		enum image_phase_t phase;
-		int ret;
 
 		ret = fit_image_get_phase(fit, node, &phase);
 		/* if the image is for any phase, let's use it */
@@ -286,7 +584,8 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 		}
 
 		if (spl_decompression_enabled() &&
-		    (image_comp == IH_COMP_GZIP || image_comp == IH_COMP_LZMA))
+		    (image_comp == IH_COMP_GZIP || image_comp == IH_COMP_LZMA ||
+		     image_comp == IH_COMP_ZSTD || image_comp == IH_COMP_LZ4))
 			src_ptr = map_sysmem(ALIGN(CONFIG_SYS_LOAD_ADDR, ARCH_DMA_MINALIGN), len);
 		else
 			src_ptr = map_sysmem(ALIGN(load_addr, ARCH_DMA_MINALIGN), len);
@@ -299,7 +598,14 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 		log_debug("reading from offset %x / %lx size %lx to %p: ",
 			  offset, read_offset, size, src_ptr);
 
-		if (info->read(info, read_offset, size, src_ptr) < length)
+		ret = spl_fit_stream_load(info, fit, node, image_comp,
+					  fit_offset + offset, &length,
+					  src_ptr, map_sysmem(load_addr, 0));
+		if (!ret)
+			streamed = true;
+		else if (ret != -ENOTSUPP)
+			return ret;
+		else if (info->read(info, read_offset, size, src_ptr) < length)
 			return -EIO;
 
 		debug("External data: dst=%p, offset=%x, size=%lx\n",
@@ -316,7 +622,7 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 		src = (void *)data;	/* cast away const */
 	}
 
-	if (CONFIG_IS_ENABLED(FIT_SIGNATURE)) {
+	if (CONFIG_IS_ENABLED(FIT_SIGNATURE) && !streamed) {
 		printf("## Checking hash(es) for Image %s ... ",
 		       fit_get_name(fit, node, NULL));
 		if (!fit_image_verify_with_data(fit, node, gd_fdt_blob(), src,
@@ -329,7 +635,14 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 		board_fit_image_post_process(fit, node, &src, &length);
 
 	load_ptr = map_sysmem(load_addr, length);
-	if (IS_ENABLED(CONFIG_SPL_GZIP) && image_comp == IH_COMP_GZIP) {
+	if (streamed && ((IS_ENABLED(CONFIG_SPL_GZIP) &&
+			  image_comp == IH_COMP_GZIP) ||
+			 (IS_ENABLED(CONFIG_SPL_ZSTD) &&
+			  image_comp == IH_COMP_ZSTD) ||
+			 (IS_ENABLED(CONFIG_SPL_LZ4) &&
+			  image_comp == IH_COMP_LZ4))) {
+		/* already decompressed to load_ptr while it was read */
+	} else if (IS_ENABLED(CONFIG_SPL_GZIP) && image_comp == IH_COMP_GZIP) {
 		size = length;
 		if (gunzip(load_ptr, CONFIG_SYS_BOOTM_LEN, src, &size)) {
 			puts("Uncompressing error\n");
@@ -346,6 +659,17 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 			return -EIO;
 		}
 		length = loadEnd - CONFIG_SYS_LOAD_ADDR;
+	} else if ((IS_ENABLED(CONFIG_SPL_ZSTD) && image_comp == IH_COMP_ZSTD) ||
+		   (IS_ENABLED(CONFIG_SPL_LZ4) && image_comp == IH_COMP_LZ4)) {
+		ulong load_end;
+
+		if (image_decomp(image_comp, CONFIG_SYS_LOAD_ADDR, 0, 0,
+				 load_ptr, src, length, CONFIG_SYS_BOOTM_LEN,
+				 &load_end)) {
+			puts("Uncompressing error\n");
+			return -EIO;
+		}
+		length = load_end - CONFIG_SYS_LOAD_ADDR;
 	} else {
 		memcpy(load_ptr, src, length);
 	}
@@ -47,6 +47,11 @@ int mmc_load_image_raw_sector(struct spl_image_info *spl_image,
 	struct spl_load_info load;
 
 	spl_load_init(&load, h_spl_load_read, bd, bd->blksz);
+	/* Keep each chunk of a chunked read to a single MMC transfer */
+	if (IS_ENABLED(CONFIG_SPL_LOAD_CHUNK) && mmc->cfg->b_max)
+		spl_set_chunk_size(&load,
+				   min_t(ulong, spl_get_chunk_size(&load),
+					 mmc->cfg->b_max << bd->log2blksz));
 	ret = spl_load(spl_image, bootdev, &load, 0, sector << bd->log2blksz);
 	if (ret) {
 		puts("mmc_load_image_raw_sector: mmc block read error\n");
@@ -170,7 +175,10 @@ static int mmc_load_image_raw_os(struct spl_image_info *spl_image,
 	if (ret)
 		return ret;
 
-	if (spl_image->os != IH_OS_LINUX && spl_image->os != IH_OS_TEE) {
+	/* with TF-A, Linux is started as its BL3-3 */
+	if (spl_image->os != IH_OS_LINUX && spl_image->os != IH_OS_TEE &&
+	    !(CONFIG_IS_ENABLED(ATF) &&
+	      spl_image->os == IH_OS_ARM_TRUSTED_FIRMWARE)) {
 		puts("Expected image is not found. Trying to start U-Boot\n");
 		return -ENOENT;
 	}
@@ -431,7 +439,9 @@ int spl_mmc_load(struct spl_image_info *spl_image,
 int spl_mmc_load_image(struct spl_image_info *spl_image,
 		       struct spl_boot_device *bootdev)
 {
-	return spl_mmc_load(spl_image, bootdev,
+	int ret;
+
+	ret = spl_mmc_load(spl_image, bootdev,
 #ifdef CONFIG_SPL_FS_LOAD_PAYLOAD_NAME
 			    CONFIG_SPL_FS_LOAD_PAYLOAD_NAME,
 #else
@@ -447,6 +457,10 @@ int spl_mmc_load_image(struct spl_image_info *spl_image,
 #else
 			    0);
 #endif
+	if (!ret && CONFIG_IS_ENABLED(MMC_HANDOFF))
+		mmc_handoff_save(mmc);
+
+	return ret;
 }
 
 SPL_LOAD_IMAGE_METHOD("MMC1", 0, BOOT_DEVICE_MMC1, spl_mmc_load_image);
@@ -43,6 +43,8 @@
 #define USB_BUFSIZ	512
 
 static int asynch_allowed;
+/* Number of transfers in progress, which schedule() may interrupt */
+static int usb_busy_count;
 bool usb_started; /* flag for the started/stopped USB status */
 
 #if !CONFIG_IS_ENABLED(DM_USB)
@@ -203,8 +205,14 @@ int usb_disable_asynch(int disable)
 int usb_int_msg(struct usb_device *dev, unsigned long pipe,
 		void *buffer, int transfer_len, int interval, bool nonblock)
 {
-	return submit_int_msg(dev, pipe, buffer, transfer_len, interval,
-			      nonblock);
+	int ret;
+
+	usb_busy_count++;
+	ret = submit_int_msg(dev, pipe, buffer, transfer_len, interval,
+			     nonblock);
+	usb_busy_count--;
+
+	return ret;
 }
 
 /*
@@ -217,10 +225,10 @@ int usb_int_msg(struct usb_device *dev, unsigned long pipe,
  * transferred length and the current status are stored in the dev->act_len and
  * dev->status.
  */
-int usb_control_msg(struct usb_device *dev, unsigned int pipe,
-			unsigned char request, unsigned char requesttype,
-			unsigned short value, unsigned short index,
-			void *data, unsigned short size, int timeout)
+static int usb_do_control_msg(struct usb_device *dev, unsigned int pipe,
+			      unsigned char request, unsigned char requesttype,
+			      unsigned short value, unsigned short index,
+			      void *data, unsigned short size, int timeout)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(struct devrequest, setup_packet, 1);
 	int err;
@@ -267,6 +275,21 @@ int usb_control_msg(struct usb_device *dev, unsigned int pipe,
 	return dev->act_len;
 }
 
+int usb_control_msg(struct usb_device *dev, unsigned int pipe,
+			unsigned char request, unsigned char requesttype,
+			unsigned short value, unsigned short index,
+			void *data, unsigned short size, int timeout)
+{
+	int ret;
+
+	usb_busy_count++;
+	ret = usb_do_control_msg(dev, pipe, request, requesttype, value, index,
+				 data, size, timeout);
+	usb_busy_count--;
+
+	return ret;
+}
+
 /*-------------------------------------------------------------------
  * submits bulk message, and waits for completion. returns 0 if Ok or
  * negative if Error.
@@ -275,16 +298,21 @@ int usb_control_msg(struct usb_device *dev, unsigned int pipe,
 int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 			void *data, int len, int *actual_length, int timeout)
 {
+	int ret;
+
 	if (len < 0)
 		return -EINVAL;
+	usb_busy_count++;
 	dev->status = USB_ST_NOT_PROC; /*not yet processed */
-	if (submit_bulk_msg(dev, pipe, data, len) < 0)
-		return -EIO;
-	while (timeout--) {
+	ret = submit_bulk_msg(dev, pipe, data, len);
+	while (ret >= 0 && timeout--) {
 		if (!((volatile unsigned long)dev->status & USB_ST_NOT_PROC))
 			break;
 		mdelay(1);
 	}
+	usb_busy_count--;
+	if (ret < 0)
+		return -EIO;
 	*actual_length = dev->act_len;
 	if (dev->status == 0)
 		return 0;
@@ -292,6 +320,11 @@ int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 		return -EIO;
 }
 
+bool usb_busy(void)
+{
+	return usb_busy_count;
+}
+
 /*-------------------------------------------------------------------
  * Max Packet stuff
  */
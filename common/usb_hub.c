@@ -46,6 +46,7 @@
 
 #define HUB_SHORT_RESET_TIME	20
 #define HUB_LONG_RESET_TIME	200
+#define HUB_RESET_POLL_TIME	2
 
 #define HUB_DEBOUNCE_TIMEOUT	CONFIG_USB_HUB_DEBOUNCE_TIMEOUT
 
@@ -60,6 +61,9 @@ struct usb_device_scan {
 
 static LIST_HEAD(usb_scan_list);
 
+/* Leave the ports on usb_scan_list for usb_hub_scan_deferred() */
+static bool usb_scan_defer;
+
 __weak void usb_hub_reset_devices(struct usb_hub_device *hub, int port)
 {
 	return;
@@ -259,6 +263,53 @@ static inline const char *portspeed(int portstatus)
 	}
 }
 
+static bool usb_hub_is_root(struct usb_device *dev)
+{
+#if CONFIG_IS_ENABLED(DM_USB)
+	return usb_hub_is_root_hub(dev->dev);
+#else
+	return !dev->parent;
+#endif
+}
+
+/**
+ * usb_hub_wait_reset() - wait for a port reset to finish
+ *
+ * A hub times the reset itself and flags when it is done, so poll it, for up
+ * to @delay. A root hub is emulated by the controller driver, which may rely
+ * on the caller waiting before reading the status, e.g. to end the reset, so
+ * always wait the full @delay there.
+ *
+ * @dev:	Hub device
+ * @port:	Port number (from 0)
+ * @delay:	Maximum time to wait, in milliseconds
+ * @portsts:	Returns the port status
+ * Return: 0 if OK, -ve on error
+ */
+static int usb_hub_wait_reset(struct usb_device *dev, int port, int delay,
+			      struct usb_port_status *portsts)
+{
+	ulong start = get_timer(0);
+	int ret;
+
+	if (usb_hub_is_root(dev)) {
+		mdelay(delay);
+		return usb_get_port_status(dev, port + 1, portsts);
+	}
+
+	do {
+		mdelay(HUB_RESET_POLL_TIME);
+		ret = usb_get_port_status(dev, port + 1, portsts);
+		if (ret < 0)
+			return ret;
+		if ((le16_to_cpu(portsts->wPortChange) & USB_PORT_STAT_C_RESET) &&
+		    !(le16_to_cpu(portsts->wPortStatus) & USB_PORT_STAT_RESET))
+			return 0;
+	} while (get_timer(start) < delay);
+
+	return 0;
+}
+
 /**
  * usb_hub_port_reset() - reset a port given its usb_device pointer
  *
@@ -288,9 +339,7 @@ static int usb_hub_port_reset(struct usb_device *dev, int port,
 		if (err < 0)
 			return err;
 
-		mdelay(delay);
-
-		if (usb_get_port_status(dev, port + 1, portsts) < 0) {
+		if (usb_hub_wait_reset(dev, port, delay, portsts) < 0) {
 			debug("get_port_status failed status %lX\n",
 			      dev->status);
 			return -1;
@@ -605,6 +654,29 @@ out:
 	return ret;
 }
 
+void usb_hub_defer_scan(bool defer)
+{
+	usb_scan_defer = defer;
+}
+
+int usb_hub_scan_deferred(void)
+{
+	usb_scan_defer = false;
+
+	return usb_device_list_scan();
+}
+
+void usb_hub_drop_scan(void)
+{
+	struct usb_device_scan *usb_scan, *tmp;
+
+	list_for_each_entry_safe(usb_scan, tmp, &usb_scan_list, list) {
+		list_del(&usb_scan->list);
+		free(usb_scan);
+	}
+	usb_scan_defer = false;
+}
+
 static struct usb_hub_device *usb_get_hub_device(struct usb_device *dev)
 {
 	struct usb_hub_device *hub;
@@ -877,8 +949,11 @@ static int usb_hub_configure(struct usb_device *dev)
 	}
 
 	/*
-	 * And now call the scanning code which loops over the generated list
+	 * And now call the scanning code which loops over the generated list,
+	 * unless that is to happen later, once the ports have settled
 	 */
+	if (usb_scan_defer)
+		return 0;
 	ret = usb_device_list_scan();
 
 	return ret;
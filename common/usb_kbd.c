@@ -7,6 +7,7 @@
  * project.
  */
 #include <console.h>
+#include <cyclic.h>
 #include <dm.h>
 #include <env.h>
 #include <errno.h>
@@ -67,6 +68,9 @@ int overwrite_console(void)
 #define RIGHT_ALT	(1 << 6)
 #define RIGHT_GUI	(1 << 7)
 
+/* Period of the background poll with USB_KEYBOARD_CYCLIC */
+#define USB_KBD_CYCLIC_US	(1000000 / 50)
+
 /* Size of the keyboard buffer */
 #define USB_KBD_BUFFER_LEN	0x20
 
@@ -130,6 +134,9 @@ struct usb_kbd_pdata {
 	uint8_t		old[USB_KBD_BOOT_REPORT_SIZE];
 
 	uint8_t		flags;
+
+	struct usb_device *dev;
+	struct cyclic_info cyclic;
 };
 
 extern int __maybe_unused net_busy_flag;
@@ -409,13 +416,9 @@ static inline void usb_kbd_poll_for_event(struct usb_device *dev)
 #endif
 }
 
-/* test if a character is in the queue */
-static int usb_kbd_testc(struct stdio_dev *sdev)
+/* Poll the keyboard if the last poll was long enough ago */
+static void usb_kbd_poll_limited(struct usb_device *usb_kbd_dev)
 {
-	struct stdio_dev *dev;
-	struct usb_device *usb_kbd_dev;
-	struct usb_kbd_pdata *data;
-
 	/*
 	 * Polling the keyboard for an event can take dozens of milliseconds.
 	 * Add a delay between polls to avoid blocking activity which polls
@@ -441,14 +444,38 @@ static int usb_kbd_testc(struct stdio_dev *sdev)
 		poll_delay = 0;
 #endif
 
-	dev = stdio_get_by_name(sdev->name);
-	usb_kbd_dev = (struct usb_device *)dev->priv;
-	data = usb_kbd_dev->privptr;
-
 	if (get_timer(kbd_testc_tms) >= poll_delay) {
 		usb_kbd_poll_for_event(usb_kbd_dev);
 		kbd_testc_tms = get_timer(0);
 	}
+}
+
+/* Fill the key buffer in the background, so that tstc() need not poll */
+static void usb_kbd_cyclic(struct cyclic_info *c)
+{
+	struct usb_kbd_pdata *data = container_of(c, struct usb_kbd_pdata,
+						  cyclic);
+
+	/* schedule() is called while host drivers wait for a transfer */
+	if (usb_busy())
+		return;
+
+	usb_kbd_poll_limited(data->dev);
+}
+
+/* test if a character is in the queue */
+static int usb_kbd_testc(struct stdio_dev *sdev)
+{
+	struct stdio_dev *dev;
+	struct usb_device *usb_kbd_dev;
+	struct usb_kbd_pdata *data;
+
+	dev = stdio_get_by_name(sdev->name);
+	usb_kbd_dev = (struct usb_device *)dev->priv;
+	data = usb_kbd_dev->privptr;
+
+	if (!IS_ENABLED(CONFIG_USB_KEYBOARD_CYCLIC))
+		usb_kbd_poll_limited(usb_kbd_dev);
 
 	return !(data->usb_in_pointer == data->usb_out_pointer);
 }
@@ -466,7 +493,8 @@ static int usb_kbd_getc(struct stdio_dev *sdev)
 
 	while (data->usb_in_pointer == data->usb_out_pointer) {
 		schedule();
-		usb_kbd_poll_for_event(usb_kbd_dev);
+		if (!IS_ENABLED(CONFIG_USB_KEYBOARD_CYCLIC))
+			usb_kbd_poll_for_event(usb_kbd_dev);
 	}
 
 	if (data->usb_out_pointer == USB_KBD_BUFFER_LEN - 1)
@@ -539,6 +567,7 @@ static int usb_kbd_probe_dev(struct usb_device *dev, unsigned int ifnum)
 		roundup(USB_KBD_BOOT_REPORT_SIZE, USB_DMA_MINALIGN));
 
 	data->ifnum = ifnum;
+	data->dev = dev;
 
 	/* Insert private data into USB device structure */
 	dev->privptr = data;
@@ -625,6 +654,13 @@ static int probe_usb_keyboard(struct usb_device *dev)
 	if (error)
 		return error;
 
+	if (IS_ENABLED(CONFIG_USB_KEYBOARD_CYCLIC)) {
+		struct usb_kbd_pdata *data = dev->privptr;
+
+		cyclic_register(&data->cyclic, usb_kbd_cyclic,
+				USB_KBD_CYCLIC_US, "usb_kbd");
+	}
+
 	stdinname = env_get("stdin");
 #if CONFIG_IS_ENABLED(CONSOLE_MUX)
 	if (strstr(stdinname, DEVNAME) != NULL) {
@@ -678,6 +714,8 @@ static int usb_kbd_remove(struct udevice *dev)
 		ret = -EPERM;
 		goto err;
 	}
+	if (IS_ENABLED(CONFIG_USB_KEYBOARD_CYCLIC))
+		cyclic_unregister(&data->cyclic);
 #ifdef CONFIG_SYS_USB_EVENT_POLL_VIA_INT_QUEUE
 	destroy_int_queue(udev, data->intq);
 #endif
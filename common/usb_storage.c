@@ -965,14 +965,21 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 	 *
 	 * Because we want to make sure we interoperate with as many devices as
 	 * possible, we will maintain a 240 sector transfer size limit for USB
-	 * Mass Storage devices.
+	 * Mass Storage devices by default (see USB_STORAGE_MAX_XFER_BLK).
 	 *
 	 * Tests show that other operating have similar limits with Microsoft
 	 * Windows 7 limiting transfers to 128 sectors for both USB2 and USB3
 	 * and Apple Mac OS X 10.11 limiting transfers to 256 sectors for USB2
 	 * and 2048 for USB3 devices.
+	 *
+	 * Follow the latter for SuperSpeed devices: they are recent enough
+	 * not to have the IDE legacy, and on xHCI the per-command CBW/CSW
+	 * round trip otherwise dominates the time spent on bulk reads.
 	 */
-	unsigned short blk = 240;
+	unsigned short blk = CONFIG_USB_STORAGE_MAX_XFER_BLK;
+
+	if (udev->speed >= USB_SPEED_SUPER && blk < 2048)
+		blk = 2048;
 
 #if CONFIG_IS_ENABLED(DM_USB)
 	size_t size;
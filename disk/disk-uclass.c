@@ -101,6 +101,46 @@ unsigned long disk_blk_write(struct udevice *dev, lbaint_t start,
 			 blkcnt, buffer);
 }
 
+/**
+ * disk_blk_map() - Get a pointer to blocks of a partition held in memory
+ *
+ * @dev: Device to map (partition udevice)
+ * @start: First block to map (from start of partition)
+ * @blkcnt: Number of blocks to map (within the partition)
+ * @return pointer to the data, or NULL if it must be read instead
+ */
+const void *disk_blk_map(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
+{
+	if (disk_blk_part_validate(dev, start, blkcnt))
+		return NULL;
+
+	return blk_map(dev_get_parent(dev), disk_blk_part_offset(dev, start),
+		       blkcnt);
+}
+
+/**
+ * disk_blk_submit() - Queue an asynchronous request on a partition
+ *
+ * @dev: Device (partition udevice)
+ * @req: Request, with @req->start relative to the start of the partition
+ * @return 0 if OK, -ve on error (the request was not queued)
+ *
+ * On success @req->start has been converted to be relative to the start of
+ * the block device, and the request must be completed with blk_wait() on
+ * the parent of @dev.
+ */
+int disk_blk_submit(struct udevice *dev, struct blk_req *req)
+{
+	int ret = disk_blk_part_validate(dev, req->start, req->blkcnt);
+
+	if (ret)
+		return ret;
+
+	req->start = disk_blk_part_offset(dev, req->start);
+
+	return blk_submit(dev_get_parent(dev), req);
+}
+
 /**
  * disk_blk_erase() - Erase part of a block device
  *
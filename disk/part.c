@@ -305,6 +305,22 @@ void part_init(struct blk_desc *desc)
 	}
 }
 
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+void part_cache_invalidate(struct blk_desc *desc, lbaint_t start,
+			   lbaint_t blkcnt)
+{
+	struct part_driver *drv =
+		ll_entry_start(struct part_driver, part_driver);
+	const int n_ents = ll_entry_count(struct part_driver, part_driver);
+	struct part_driver *entry;
+
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		if (entry->invalidate)
+			entry->invalidate(desc, start, blkcnt);
+	}
+}
+#endif
+
 static void print_part_header(const char *type, struct blk_desc *desc)
 {
 #if CONFIG_IS_ENABLED(MAC_PARTITION) || \
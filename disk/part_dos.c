@@ -16,6 +16,7 @@
 #include <blk.h>
 #include <command.h>
 #include <ide.h>
+#include <malloc.h>
 #include <memalign.h>
 #include <vsprintf.h>
 #include <asm/unaligned.h>
@@ -98,13 +99,93 @@ static int test_block_type(unsigned char *buffer)
 	return -1;
 }
 
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+enum {
+	DOS_CACHE_MAX	= 8,
+};
+
+/**
+ * struct dos_cache - an MBR or EBR sector, kept until it is written
+ *
+ * @desc: Block device, or NULL if the entry is not used
+ * @hwpart: Hardware partition the sector was read from
+ * @sector: Sector number
+ * @buf: Contents of the sector, @desc->blksz bytes
+ */
+struct dos_cache {
+	struct blk_desc *desc;
+	int hwpart;
+	lbaint_t sector;
+	void *buf;
+};
+
+static struct dos_cache dos_cache[DOS_CACHE_MAX];
+static int dos_cache_next;
+
+static void dos_cache_drop(struct dos_cache *dc)
+{
+	free(dc->buf);
+	memset(dc, '\0', sizeof(*dc));
+}
+
+static void part_invalidate_dos(struct blk_desc *desc, lbaint_t start,
+				lbaint_t blkcnt)
+{
+	int i;
+
+	for (i = 0; i < DOS_CACHE_MAX; i++) {
+		struct dos_cache *dc = &dos_cache[i];
+
+		if (dc->desc == desc && (!blkcnt || (dc->sector >= start &&
+						     dc->sector - start < blkcnt)))
+			dos_cache_drop(dc);
+	}
+}
+#else
+#define part_invalidate_dos	NULL
+#endif
+
+/* Read a partition-table sector, which is kept for next time */
+static int dos_read_sector(struct blk_desc *desc, lbaint_t sector, void *buf)
+{
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	struct dos_cache *dc;
+	int i;
+
+	for (i = 0; i < DOS_CACHE_MAX; i++) {
+		dc = &dos_cache[i];
+		if (dc->desc == desc && dc->hwpart == desc->hwpart &&
+		    dc->sector == sector) {
+			memcpy(buf, dc->buf, desc->blksz);
+			return 0;
+		}
+	}
+#endif
+	if (blk_dread(desc, sector, 1, buf) != 1)
+		return -EIO;
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	dc = &dos_cache[dos_cache_next];
+	dos_cache_drop(dc);
+	dc->buf = malloc(desc->blksz);
+	if (dc->buf) {
+		memcpy(dc->buf, buf, desc->blksz);
+		dc->desc = desc;
+		dc->hwpart = desc->hwpart;
+		dc->sector = sector;
+		dos_cache_next = (dos_cache_next + 1) % DOS_CACHE_MAX;
+	}
+#endif
+
+	return 0;
+}
+
 static int part_test_dos(struct blk_desc *desc)
 {
 #ifndef CONFIG_XPL_BUILD
 	ALLOC_CACHE_ALIGN_BUFFER(legacy_mbr, mbr,
 			DIV_ROUND_UP(desc->blksz, sizeof(legacy_mbr)));
 
-	if (blk_dread(desc, 0, 1, (ulong *)mbr) != 1)
+	if (dos_read_sector(desc, 0, mbr))
 		return -1;
 
 	if (test_block_type((unsigned char *)mbr) != DOS_MBR)
@@ -117,7 +198,7 @@ static int part_test_dos(struct blk_desc *desc)
 #else
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, buffer, desc->blksz);
 
-	if (blk_dread(desc, 0, 1, (ulong *)buffer) != 1)
+	if (dos_read_sector(desc, 0, buffer))
 		return -1;
 
 	if (test_block_type(buffer) != DOS_MBR)
@@ -145,7 +226,7 @@ static void print_partition_extended(struct blk_desc *desc,
 		return;
     }
 
-	if (blk_dread(desc, ext_part_sector, 1, (ulong *)buffer) != 1) {
+	if (dos_read_sector(desc, ext_part_sector, buffer)) {
 		printf ("** Can't read partition table on %d:" LBAFU " **\n",
 			desc->devnum, ext_part_sector);
 		return;
@@ -217,7 +298,7 @@ static int part_get_info_extended(struct blk_desc *desc,
 		return -1;
     }
 
-	if (blk_dread(desc, ext_part_sector, 1, (ulong *)buffer) != 1) {
+	if (dos_read_sector(desc, ext_part_sector, buffer)) {
 		printf ("** Can't read partition table on %d:" LBAFU " **\n",
 			desc->devnum, ext_part_sector);
 		return -1;
@@ -523,4 +604,5 @@ U_BOOT_PART_TYPE(dos) = {
 	.get_info	= part_get_info_ptr(part_get_info_dos),
 	.print		= part_print_ptr(part_print_dos),
 	.test		= part_test_dos,
+	.invalidate	= part_invalidate_dos,
 };
@@ -1085,6 +1085,131 @@ static int is_gpt_valid(struct blk_desc *desc, u64 lba, gpt_header *pgpt_head,
 	return 1;
 }
 
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+enum {
+	GPT_CACHE_MAX	= 4,
+};
+
+/**
+ * struct gpt_cache - a validated GPT, kept until its blocks are written
+ *
+ * @desc: Block device, or NULL if the entry is not used
+ * @hwpart: Hardware partition the GPT was read from
+ * @lba: Number of blocks on the device when the GPT was read
+ * @head: Copy of the GPT header
+ * @pte: Copy of the partition entries
+ * @pte_size: Size of @pte in bytes
+ */
+struct gpt_cache {
+	struct blk_desc *desc;
+	int hwpart;
+	lbaint_t lba;
+	gpt_header head;
+	gpt_entry *pte;
+	size_t pte_size;
+};
+
+static struct gpt_cache gpt_cache[GPT_CACHE_MAX];
+static int gpt_cache_next;
+
+static struct gpt_cache *gpt_cache_get(struct blk_desc *desc)
+{
+	int i;
+
+	for (i = 0; i < GPT_CACHE_MAX; i++) {
+		struct gpt_cache *gc = &gpt_cache[i];
+
+		if (gc->desc == desc && gc->hwpart == desc->hwpart &&
+		    gc->lba == desc->lba)
+			return gc;
+	}
+
+	return NULL;
+}
+
+static void gpt_cache_drop(struct gpt_cache *gc)
+{
+	free(gc->pte);
+	memset(gc, '\0', sizeof(*gc));
+}
+
+/* Fill in the header and a copy of the PTEs, as is_gpt_valid() does */
+static bool gpt_cache_find(struct blk_desc *desc, gpt_header *gpt_head,
+			   gpt_entry **pgpt_pte)
+{
+	struct gpt_cache *gc = gpt_cache_get(desc);
+	gpt_entry *pte;
+
+	if (!gc)
+		return false;
+	pte = memalign(ARCH_DMA_MINALIGN, PAD_TO_BLOCKSIZE(gc->pte_size, desc));
+	if (!pte)
+		return false;
+	memcpy(pte, gc->pte, gc->pte_size);
+	memcpy(gpt_head, &gc->head, sizeof(gc->head));
+	*pgpt_pte = pte;
+
+	return true;
+}
+
+static void gpt_cache_add(struct blk_desc *desc, gpt_header *gpt_head,
+			  gpt_entry *gpt_pte)
+{
+	struct gpt_cache *gc = gpt_cache_get(desc);
+	size_t size;
+
+	if (!gc) {
+		gc = &gpt_cache[gpt_cache_next];
+		gpt_cache_next = (gpt_cache_next + 1) % GPT_CACHE_MAX;
+	}
+	gpt_cache_drop(gc);
+
+	size = le32_to_cpu(gpt_head->num_partition_entries) *
+		le32_to_cpu(gpt_head->sizeof_partition_entry);
+	gc->pte = malloc(size);
+	if (!gc->pte)
+		return;
+	memcpy(gc->pte, gpt_pte, size);
+	gc->pte_size = size;
+	memcpy(&gc->head, gpt_head, sizeof(gc->head));
+	gc->desc = desc;
+	gc->hwpart = desc->hwpart;
+	gc->lba = desc->lba;
+}
+
+/*
+ * Everything outside the usable area belongs to the protective MBR or to the
+ * primary or backup GPT, so a write there may change the table
+ */
+static void part_invalidate_efi(struct blk_desc *desc, lbaint_t start,
+				lbaint_t blkcnt)
+{
+	int i;
+
+	for (i = 0; i < GPT_CACHE_MAX; i++) {
+		struct gpt_cache *gc = &gpt_cache[i];
+
+		if (gc->desc != desc)
+			continue;
+		if (blkcnt && start >= le64_to_cpu(gc->head.first_usable_lba) &&
+		    start + blkcnt <= le64_to_cpu(gc->head.last_usable_lba) + 1)
+			continue;
+		gpt_cache_drop(gc);
+	}
+}
+#else
+static bool gpt_cache_find(struct blk_desc *desc, gpt_header *gpt_head,
+			   gpt_entry **pgpt_pte)
+{
+	return false;
+}
+
+static void gpt_cache_add(struct blk_desc *desc, gpt_header *gpt_head,
+			  gpt_entry *gpt_pte) {}
+
+#define part_invalidate_efi	NULL
+#endif
+
 /**
  * find_valid_gpt() - finds a valid GPT header and PTEs
  *
@@ -1093,12 +1218,16 @@ static int is_gpt_valid(struct blk_desc *desc, u64 lba, gpt_header *pgpt_head,
  *
  * Description: returns 1 if found a valid gpt,  0 on error.
  * If valid, returns pointers to PTEs.
+ * A GPT validated earlier is used without reading it again.
  */
 static int find_valid_gpt(struct blk_desc *desc, gpt_header *gpt_head,
 			  gpt_entry **pgpt_pte)
 {
 	int r;
 
+	if (gpt_cache_find(desc, gpt_head, pgpt_pte))
+		return 1;
+
 	r = is_gpt_valid(desc, GPT_PRIMARY_PARTITION_TABLE_LBA, gpt_head,
 			 pgpt_pte);
 
@@ -1114,6 +1243,8 @@ static int find_valid_gpt(struct blk_desc *desc, gpt_header *gpt_head,
 		if (r != 2)
 			log_debug("        Using Backup GPT\n");
 	}
+	gpt_cache_add(desc, gpt_head, *pgpt_pte);
+
 	return 1;
 }
 
@@ -1213,4 +1344,5 @@ U_BOOT_PART_TYPE(a_efi) = {
 	.get_info	= part_get_info_ptr(part_get_info_efi),
 	.print		= part_print_ptr(part_print_efi),
 	.test		= part_test_efi,
+	.invalidate	= part_invalidate_efi,
 };
@@ -52,6 +52,17 @@ static int ata_io_flush(struct ahci_uc_priv *uc_priv, u8 port);
 #define WAIT_MS_LINKUP	200
 
 #define AHCI_CAP_S64A BIT(31)
+#define AHCI_CAP_SNCQ BIT(30)
+#define AHCI_CAP_NCS(cap)	((((cap) >> 8) & 0x1f) + 1)
+
+/* Each port has a command table for every slot which may be used for NCQ */
+#ifdef CONFIG_AHCI_NCQ
+#define AHCI_NCQ_SLOTS	CONFIG_AHCI_NCQ_SLOTS
+#else
+#define AHCI_NCQ_SLOTS	1
+#endif
+#define AHCI_PORT_DMA_SZ	(AHCI_PORT_PRIV_DMA_SZ + \
+				 (AHCI_NCQ_SLOTS - 1) * AHCI_CMD_TBL_SZ)
 
 __weak void __iomem *ahci_port_base(void __iomem *base, u32 port)
 {
@@ -90,7 +101,7 @@ static void ahci_dcache_invalidate_range(unsigned long begin, unsigned long len)
 static void ahci_dcache_flush_sata_cmd(struct ahci_ioports *pp)
 {
 	ahci_dcache_flush_range((unsigned long)pp->cmd_slot,
-				AHCI_PORT_PRIV_DMA_SZ);
+				AHCI_PORT_DMA_SZ);
 }
 
 static int waiting_for_cmd_completed(void __iomem *offset,
@@ -384,11 +395,11 @@ static int ahci_init_one(struct ahci_uc_priv *uc_priv, struct udevice *dev)
 
 #define MAX_DATA_BYTE_COUNT  (4*1024*1024)
 
-static int ahci_fill_sg(struct ahci_uc_priv *uc_priv, u8 port,
+static int ahci_fill_sg(struct ahci_uc_priv *uc_priv, u8 port, int slot,
 			unsigned char *buf, int buf_len)
 {
 	struct ahci_ioports *pp = &(uc_priv->port[port]);
-	struct ahci_sg *ahci_sg = pp->cmd_tbl_sg;
+	struct ahci_sg *ahci_sg = (void *)pp->cmd_tbl_sg + slot * AHCI_CMD_TBL_SZ;
 	phys_addr_t pa = virt_to_phys(buf);
 	u32 sg_count;
 	int i;
@@ -418,15 +429,17 @@ static int ahci_fill_sg(struct ahci_uc_priv *uc_priv, u8 port,
 	return sg_count;
 }
 
-static void ahci_fill_cmd_slot(struct ahci_ioports *pp, u32 opts)
+static void ahci_fill_cmd_slot(struct ahci_ioports *pp, int slot, u32 opts)
 {
-	phys_addr_t pa = virt_to_phys((void *)pp->cmd_tbl);
+	struct ahci_cmd_hdr *cmd_hdr = &pp->cmd_slot[slot];
+	phys_addr_t pa = virt_to_phys((void *)pp->cmd_tbl +
+				      slot * AHCI_CMD_TBL_SZ);
 
-	pp->cmd_slot->opts = cpu_to_le32(opts);
-	pp->cmd_slot->status = 0;
-	pp->cmd_slot->tbl_addr = cpu_to_le32(lower_32_bits(pa));
+	cmd_hdr->opts = cpu_to_le32(opts);
+	cmd_hdr->status = 0;
+	cmd_hdr->tbl_addr = cpu_to_le32(lower_32_bits(pa));
 #ifdef CONFIG_PHYS_64BIT
-	pp->cmd_slot->tbl_addr_hi = cpu_to_le32(upper_32_bits(pa));
+	cmd_hdr->tbl_addr_hi = cpu_to_le32(upper_32_bits(pa));
 #endif
 }
 
@@ -461,13 +474,13 @@ static int ahci_port_start(struct ahci_uc_priv *uc_priv, u8 port)
 		return -1;
 	}
 
-	mem = memalign(2048, AHCI_PORT_PRIV_DMA_SZ);
+	mem = memalign(2048, AHCI_PORT_DMA_SZ);
 	if (!mem) {
 		free(pp);
 		printf("%s: No mem for table!\n", __func__);
 		return -ENOMEM;
 	}
-	memset(mem, 0, AHCI_PORT_PRIV_DMA_SZ);
+	memset(mem, 0, AHCI_PORT_DMA_SZ);
 
 	/*
 	 * First item in chunk of DMA memory: 32-slot command table,
@@ -476,7 +489,7 @@ static int ahci_port_start(struct ahci_uc_priv *uc_priv, u8 port)
 	pp->cmd_slot =
 		(struct ahci_cmd_hdr *)(uintptr_t)virt_to_phys((void *)mem);
 	debug("cmd_slot = %p\n", pp->cmd_slot);
-	mem += (AHCI_CMD_SLOT_SZ + 224);
+	mem += AHCI_CMD_SLOT_SZ * AHCI_MAX_CMD_SLOT;
 
 	/*
 	 * Second item: Received-FIS area
@@ -485,8 +498,8 @@ static int ahci_port_start(struct ahci_uc_priv *uc_priv, u8 port)
 	mem += AHCI_RX_FIS_SZ;
 
 	/*
-	 * Third item: data area for storing a single command
-	 * and its scatter-gather table
+	 * Third item: data area for storing a command and its scatter-gather
+	 * table, for each slot that may be used
 	 */
 	pp->cmd_tbl = virt_to_phys((void *)mem);
 	debug("cmd_tbl_dma = %lx\n", pp->cmd_tbl);
@@ -544,9 +557,9 @@ static int ahci_device_data_io(struct ahci_uc_priv *uc_priv, u8 port, u8 *fis,
 
 	memcpy((unsigned char *)pp->cmd_tbl, fis, fis_len);
 
-	sg_count = ahci_fill_sg(uc_priv, port, buf, buf_len);
+	sg_count = ahci_fill_sg(uc_priv, port, 0, buf, buf_len);
 	opts = (fis_len >> 2) | (sg_count << 16) | (is_write << 6);
-	ahci_fill_cmd_slot(pp, opts);
+	ahci_fill_cmd_slot(pp, 0, opts);
 
 	ahci_dcache_flush_sata_cmd(pp);
 	ahci_dcache_flush_range((unsigned long)buf, (unsigned long)buf_len);
@@ -567,6 +580,166 @@ static int ahci_device_data_io(struct ahci_uc_priv *uc_priv, u8 port, u8 *fis,
 	return 0;
 }
 
+/*
+ * Stop and restart the command list engine, dropping any commands which are
+ * still in flight, and clear the errors.
+ */
+static int ahci_port_restart(void __iomem *port_mmio)
+{
+	u32 cmd = readl(port_mmio + PORT_CMD);
+
+	writel_with_flush(cmd & ~PORT_CMD_START, port_mmio + PORT_CMD);
+	if (waiting_for_cmd_completed(port_mmio + PORT_CMD, 500,
+				      PORT_CMD_LIST_ON))
+		return -ETIMEDOUT;
+
+	writel(readl(port_mmio + PORT_SCR_ERR), port_mmio + PORT_SCR_ERR);
+	writel(readl(port_mmio + PORT_IRQ_STAT), port_mmio + PORT_IRQ_STAT);
+	writel_with_flush(cmd | PORT_CMD_START, port_mmio + PORT_CMD);
+
+	return 0;
+}
+
+/*
+ * Use native command queuing on a port if both the controller and the drive
+ * support it. The number of slots is limited by the controller, the drive
+ * and the tables set up in ahci_port_start().
+ */
+static void ahci_ncq_setup(struct ahci_uc_priv *uc_priv, u8 port, u16 *id)
+{
+	struct ahci_ioports *pp = &uc_priv->port[port];
+	u32 slots;
+
+	pp->ncq_slots = 0;
+	if (!IS_ENABLED(CONFIG_AHCI_NCQ) || !(uc_priv->cap & AHCI_CAP_SNCQ) ||
+	    !ata_id_has_ncq(id))
+		return;
+
+	slots = min3(AHCI_CAP_NCS(uc_priv->cap), (u32)ata_id_queue_depth(id),
+		     (u32)AHCI_NCQ_SLOTS);
+	if (slots > 1)
+		pp->ncq_slots = slots;
+	debug("Port %d: NCQ with %u slots\n", port, pp->ncq_slots);
+}
+
+/* Set up a READ FPDMA QUEUED command in a slot, using the slot as the tag */
+static int ahci_ncq_fill(struct ahci_uc_priv *uc_priv, u8 port, int slot,
+			 lbaint_t lba, u16 blocks, u8 *buf)
+{
+	struct ahci_ioports *pp = &uc_priv->port[port];
+	u8 *fis = (u8 *)pp->cmd_tbl + slot * AHCI_CMD_TBL_SZ;
+	int sg_count;
+
+	memset(fis, '\0', 20);
+	fis[0] = 0x27;		/* Host to device FIS. */
+	fis[1] = 1 << 7;	/* Command FIS. */
+	fis[2] = ATA_CMD_FPDMA_READ;
+	fis[3] = blocks & 0xff;	/* features: block count */
+	fis[4] = (lba >> 0) & 0xff;
+	fis[5] = (lba >> 8) & 0xff;
+	fis[6] = (lba >> 16) & 0xff;
+	fis[7] = 1 << 6;	/* device reg: set LBA mode */
+	fis[8] = (lba >> 24) & 0xff;
+#ifdef CONFIG_SYS_64BIT_LBA
+	fis[9] = (lba >> 32) & 0xff;
+	fis[10] = (lba >> 40) & 0xff;
+#endif
+	fis[11] = blocks >> 8;
+	fis[12] = slot << 3;	/* sector count: tag */
+
+	sg_count = ahci_fill_sg(uc_priv, port, slot, buf,
+				blocks * ATA_SECT_SIZE);
+	if (sg_count < 0)
+		return -EINVAL;
+	ahci_fill_cmd_slot(pp, slot, 5 | (sg_count << 16));
+
+	return 0;
+}
+
+/**
+ * ahci_ncq_read() - read blocks using native command queuing
+ *
+ * The read is split into commands of MAX_SATA_BLOCKS_READ_WRITE blocks and
+ * as many as the port allows are kept in flight, so the drive can work on
+ * the next one while the current one is transferred.
+ *
+ * If anything goes wrong, NCQ is turned off for the port, so that the drive
+ * is used one command at a time from then on.
+ *
+ * @uc_priv:	AHCI controller
+ * @port:	Port to read from
+ * @lba:	First block to read
+ * @blocks:	Number of blocks to read
+ * @buf:	Buffer to read into
+ * Return: 0 if OK, -EIO on error, -ETIMEDOUT if the drive stopped responding
+ */
+static int ahci_ncq_read(struct ahci_uc_priv *uc_priv, u8 port, lbaint_t lba,
+			 u16 blocks, u8 *buf)
+{
+	struct ahci_ioports *pp = &uc_priv->port[port];
+	void __iomem *port_mmio = pp->port_mmio;
+	u32 all = GENMASK(pp->ncq_slots - 1, 0);
+	ulong len = blocks * ATA_SECT_SIZE;
+	u32 active = 0, issue;
+	u8 *start = buf;
+	ulong timer;
+	int ret = 0;
+	int slot;
+
+	ahci_dcache_flush_range((unsigned long)buf, len);
+	writel(readl(port_mmio + PORT_IRQ_STAT), port_mmio + PORT_IRQ_STAT);
+	timer = get_timer(0);
+	while (blocks || active) {
+		for (issue = 0; blocks && (active | issue) != all;) {
+			u16 now_blocks = min((u16)MAX_SATA_BLOCKS_READ_WRITE,
+					     blocks);
+
+			slot = ffs(~(active | issue)) - 1;
+			ret = ahci_ncq_fill(uc_priv, port, slot, lba,
+					    now_blocks, buf);
+			if (ret)
+				break;
+			issue |= BIT(slot);
+			buf += now_blocks * ATA_SECT_SIZE;
+			blocks -= now_blocks;
+			lba += now_blocks;
+		}
+		if (issue) {
+			ahci_dcache_flush_sata_cmd(pp);
+			writel(issue, port_mmio + PORT_SCR_ACT);
+			writel_with_flush(issue, port_mmio + PORT_CMD_ISSUE);
+			active |= issue;
+		}
+		if (ret)
+			break;
+
+		if (readl(port_mmio + PORT_IRQ_STAT) & (PORT_IRQ_FATAL)) {
+			ret = -EIO;
+			break;
+		}
+		/* the drive clears the SActive bit when a command is done */
+		issue = active & ~readl(port_mmio + PORT_SCR_ACT);
+		if (issue) {
+			active &= ~issue;
+			timer = get_timer(0);
+		} else if (get_timer(timer) > WAIT_MS_DATAIO) {
+			ret = -ETIMEDOUT;
+			break;
+		}
+	}
+
+	if (ret) {
+		printf("scsi_ahci: NCQ read failed on port %d (err=%d)\n",
+		       port, ret);
+		pp->ncq_slots = 0;
+		ahci_port_restart(port_mmio);
+		return ret;
+	}
+	ahci_dcache_invalidate_range((unsigned long)start, len);
+
+	return 0;
+}
+
 static char *ata_id_strcpy(u16 *target, u16 *src, int len)
 {
 	int i;
@@ -634,6 +807,7 @@ static int ata_scsiop_inquiry(struct ahci_uc_priv *uc_priv,
 
 	memcpy(idbuf, tmpid, ATA_ID_WORDS * 2);
 	ata_swap_buf_le16(idbuf, ATA_ID_WORDS);
+	ahci_ncq_setup(uc_priv, port, idbuf);
 
 	memcpy(&pccb->pdata[8], "ATA     ", 8);
 	ata_id_strcpy((u16 *)&pccb->pdata[16], &idbuf[ATA_ID_PROD], 16);
@@ -686,6 +860,17 @@ static int ata_scsiop_read_write(struct ahci_uc_priv *uc_priv,
 	debug("scsi_ahci: %s %u blocks starting from lba 0x" LBAFU "\n",
 	      is_write ?  "write" : "read", blocks, lba);
 
+	if (!is_write && uc_priv->port[pccb->target].ncq_slots) {
+		if (blocks * ATA_SECT_SIZE > user_buffer_size) {
+			printf("scsi_ahci: Error: buffer too small.\n");
+			return -EIO;
+		}
+		/* on failure, try again one command at a time */
+		if (!ahci_ncq_read(uc_priv, pccb->target, lba, blocks,
+				   user_buffer))
+			return 0;
+	}
+
 	/* Preset the FIS */
 	memset(fis, 0, sizeof(fis));
 	fis[0] = 0x27;		 /* Host to device FIS. */
@@ -915,7 +1100,7 @@ static int ata_io_flush(struct ahci_uc_priv *uc_priv, u8 port)
 	fis[2] = ATA_CMD_FLUSH_EXT;
 
 	memcpy((unsigned char *)pp->cmd_tbl, fis, 20);
-	ahci_fill_cmd_slot(pp, cmd_fis_len);
+	ahci_fill_cmd_slot(pp, 0, cmd_fis_len);
 	ahci_dcache_flush_sata_cmd(pp);
 	writel_with_flush(1, port_mmio + PORT_CMD_ISSUE);
 
@@ -7,17 +7,71 @@
 #define LOG_CATEGORY UCLASS_BLK
 
 #include <blk.h>
+#include <bootstage.h>
+#include <display_options.h>
 #include <dm.h>
+#include <env.h>
+#include <fat.h>
 #include <log.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <part.h>
+#include <time.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
+#include <linux/bitops.h>
 #include <linux/err.h>
 
 #define blk_get_ops(dev)	((struct blk_ops *)(dev)->driver->ops)
 
+/* Number of back-to-back sequential reads which start the read-ahead */
+#define BLK_RA_TRIGGER		2
+
+/**
+ * struct blk_ra - read-ahead state of a block device
+ *
+ * @next: Block following the last read, where a sequential read starts
+ * @seq: Number of sequential reads seen in a row
+ * @hwpart: Hardware partition the window was read from
+ * @start: First block held in @buf
+ * @count: Number of blocks held in @buf, 0 if none
+ * @size: Size of @buf in blocks
+ * @buf: Read-ahead window
+ */
+struct blk_ra {
+	lbaint_t next;
+	uint seq;
+	int hwpart;
+	lbaint_t start;
+	lbaint_t count;
+	lbaint_t size;
+	void *buf;
+};
+
+/**
+ * struct blk_uc_priv - uclass-private data of a block device
+ *
+ * @ra: Read-ahead state
+ * @queue: Asynchronous requests waiting to be started
+ * @active: Asynchronous request the driver is working on, if any
+ * @stats: Transfer statistics
+ * @stats_name: Names of the bootstage records for reads and writes
+ */
+struct blk_uc_priv {
+#if CONFIG_IS_ENABLED(BLK_READAHEAD)
+	struct blk_ra ra;
+#endif
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct list_head queue;
+	struct blk_req *active;
+#endif
+#if CONFIG_IS_ENABLED(BLK_STATS)
+	struct blk_stats stats;
+	char stats_name[2][20];
+#endif
+};
+
 static struct {
 	enum uclass_id id;
 	const char *name;
@@ -319,6 +373,60 @@ int blk_show_device(enum uclass_id uclass_id, int devnum)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+static void blk_req_complete(struct udevice *dev, struct blk_req *req,
+			     long result)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+
+	req->result = result;
+	req->done = true;
+	if (req->op == BLK_REQ_READ && result == req->blkcnt)
+		blkcache_fill(desc->uclass_id, desc->devnum, req->start,
+			      req->blkcnt, desc->blksz, req->buf);
+}
+
+/* Hand the next queued request to the driver if it is idle */
+static void blk_queue_run(struct udevice *dev)
+{
+	struct blk_uc_priv *priv = dev_get_uclass_priv(dev);
+	struct blk_req *req;
+	int ret;
+
+	while (!priv->active && !list_empty(&priv->queue)) {
+		req = list_first_entry(&priv->queue, struct blk_req, sibling);
+		list_del(&req->sibling);
+		ret = blk_get_ops(dev)->submit(dev, req);
+		if (ret)
+			blk_req_complete(dev, req, ret);
+		else
+			priv->active = req;
+	}
+}
+
+/* Wait for the request the driver is working on */
+static void blk_queue_wait(struct udevice *dev)
+{
+	struct blk_uc_priv *priv = dev_get_uclass_priv(dev);
+	struct blk_req *req = priv->active;
+
+	priv->active = NULL;
+	blk_req_complete(dev, req, blk_get_ops(dev)->wait(dev, req));
+	blk_queue_run(dev);
+}
+
+/* Complete all asynchronous requests, before a synchronous access */
+static void blk_drain(struct udevice *dev)
+{
+	struct blk_uc_priv *priv = dev_get_uclass_priv(dev);
+
+	while (priv && priv->active)
+		blk_queue_wait(dev);
+}
+#else
+static inline void blk_drain(struct udevice *dev) {}
+#endif
+
 int blk_select_hwpart(struct udevice *dev, int hwpart)
 {
 	const struct blk_ops *ops = blk_get_ops(dev);
@@ -328,6 +436,8 @@ int blk_select_hwpart(struct udevice *dev, int hwpart)
 	if (!ops->select_hwpart)
 		return 0;
 
+	blk_drain(dev);
+
 	return ops->select_hwpart(dev, hwpart);
 }
 
@@ -429,19 +539,147 @@ static int blk_buffer_aligned(struct bounce_buffer *state)
 	return 1;	/* Default, any buffer is OK */
 }
 
-long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
+#if CONFIG_IS_ENABLED(BLK_STATS)
+/* Histogram bucket for a value, with bucket 0 holding anything below 2^@shift */
+static uint blk_stats_bucket(ulong val, uint shift)
+{
+	int bucket = fls(val >> shift) - 1;
+
+	return clamp(bucket, 0, BLK_STATS_BUCKETS - 1);
+}
+
+/**
+ * blk_stats_add() - Account a transfer which reached the driver
+ *
+ * @dev: Block device
+ * @write: true for a write, false for a read
+ * @blkcnt: Number of blocks requested
+ * @done: Number of blocks transferred, or -ve on error
+ * @start_us: Time the transfer started, from timer_get_us()
+ */
+static void blk_stats_add(struct udevice *dev, bool write, lbaint_t blkcnt,
+			  long done, ulong start_us)
 {
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
-	const struct blk_ops *ops = blk_get_ops(dev);
-	ulong blks_read;
+	struct blk_uc_priv *priv = dev_get_uclass_priv(dev);
+	struct blk_stats *stats = &priv->stats;
+	ulong us = timer_get_us() - start_us;
+	u64 bytes = done > 0 ? (u64)done * desc->blksz : 0;
+
+	if (write) {
+		stats->writes++;
+		stats->write_bytes += bytes;
+		stats->write_us += us;
+	} else {
+		stats->reads++;
+		stats->read_bytes += bytes;
+		stats->read_us += us;
+	}
+	if (done != blkcnt)
+		stats->errors++;
+	stats->max_us = max(stats->max_us, us);
+	stats->size_hist[blk_stats_bucket(blkcnt, 0)]++;
+	stats->lat_hist[blk_stats_bucket(us, 3)]++;
+}
 
-	if (!ops->read)
-		return -ENOSYS;
+const struct blk_stats *blk_get_stats(struct udevice *dev)
+{
+	struct blk_uc_priv *priv = dev_get_uclass_priv(dev);
 
-	if (blkcache_read(desc->uclass_id, desc->devnum,
-			  start, blkcnt, desc->blksz, buf))
-		return blkcnt;
+	return priv ? &priv->stats : NULL;
+}
+
+void blk_stats_reset(struct udevice *dev)
+{
+	struct blk_uc_priv *priv = dev_get_uclass_priv(dev);
+
+	if (priv)
+		memset(&priv->stats, '\0', sizeof(priv->stats));
+}
+
+void blk_stats_show(struct udevice *dev)
+{
+	const struct blk_stats *stats = blk_get_stats(dev);
+	int i;
+
+	if (!stats)
+		return;
+	printf("Reads:  %lu, %lu us, ", stats->reads, stats->read_us);
+	print_size(stats->read_bytes, "\n");
+	printf("Writes: %lu, %lu us, ", stats->writes, stats->write_us);
+	print_size(stats->write_bytes, "\n");
+	printf("Errors: %lu\n", stats->errors);
+	printf("Longest transfer: %lu us\n", stats->max_us);
+
+	printf("\n%12s  %10s\n", "Blocks", "Transfers");
+	for (i = 0; i < BLK_STATS_BUCKETS; i++) {
+		if (stats->size_hist[i])
+			printf("%11lu%s  %10u\n", 1UL << i,
+			       i == BLK_STATS_BUCKETS - 1 ? "+" : " ",
+			       stats->size_hist[i]);
+	}
+	printf("\n%12s  %10s\n", "Latency (us)", "Transfers");
+	for (i = 0; i < BLK_STATS_BUCKETS; i++) {
+		if (stats->lat_hist[i])
+			printf("%10s%lu%s  %10u\n", i ? "" : "<",
+			       i ? 1UL << (i + 3) : 16UL,
+			       i == BLK_STATS_BUCKETS - 1 ? "+" : " ",
+			       stats->lat_hist[i]);
+	}
+}
+
+void blk_stats_bootstage(void)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+
+	uclass_id_foreach_dev(UCLASS_BLK, dev, uc) {
+		struct blk_desc *desc = dev_get_uclass_plat(dev);
+		struct blk_uc_priv *priv;
+		const char *name;
 
+		if (!device_active(dev))
+			continue;
+		priv = dev_get_uclass_priv(dev);
+		name = blk_get_uclass_name(desc->uclass_id);
+		if (priv->stats.reads) {
+			snprintf(priv->stats_name[0], sizeof(priv->stats_name[0]),
+				 "%s%d read", name, desc->devnum);
+			bootstage_add_accum(priv->stats_name[0],
+					    priv->stats.read_us);
+		}
+		if (priv->stats.writes) {
+			snprintf(priv->stats_name[1], sizeof(priv->stats_name[1]),
+				 "%s%d write", name, desc->devnum);
+			bootstage_add_accum(priv->stats_name[1],
+					    priv->stats.write_us);
+		}
+	}
+}
+
+static inline ulong blk_stats_start(void)
+{
+	return timer_get_us();
+}
+#else
+static inline void blk_stats_add(struct udevice *dev, bool write,
+				 lbaint_t blkcnt, long done, ulong start_us) {}
+
+static inline ulong blk_stats_start(void)
+{
+	return 0;
+}
+#endif
+
+static long blk_read_dev(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
+			 void *buf)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong start_us = blk_stats_start();
+	ulong blks_read;
+
+	bootstage_span_begin("blk_read");
 	if (IS_ENABLED(CONFIG_BOUNCE_BUFFER) && desc->bb) {
 		struct blk_bounce_buffer bbstate = { .dev = dev };
 		int ret;
@@ -450,8 +688,10 @@ long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 						   blkcnt * desc->blksz,
 						   GEN_BB_WRITE, desc->blksz,
 						   blk_buffer_aligned);
-		if (ret)
+		if (ret) {
+			bootstage_span_end();
 			return ret;
+		}
 
 		blks_read = ops->read(dev, start, blkcnt, bbstate.state.bounce_buffer);
 
@@ -459,6 +699,157 @@ long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 	} else {
 		blks_read = ops->read(dev, start, blkcnt, buf);
 	}
+	bootstage_span_end();
+	blk_stats_add(dev, false, blkcnt, blks_read, start_us);
+
+	return blks_read;
+}
+
+#if CONFIG_IS_ENABLED(BLK_READAHEAD)
+static void blk_ra_drop(struct udevice *dev)
+{
+	struct blk_uc_priv *priv = dev_get_uclass_priv(dev);
+
+	priv->ra.count = 0;
+	priv->ra.seq = 0;
+}
+
+static void blk_ra_free(struct udevice *dev)
+{
+	struct blk_uc_priv *priv = dev_get_uclass_priv(dev);
+
+	free(priv->ra.buf);
+	memset(&priv->ra, '\0', sizeof(priv->ra));
+}
+
+/* Size of the read-ahead window in blocks, 0 to disable it */
+static lbaint_t blk_ra_size(struct blk_desc *desc)
+{
+	ulong bytes;
+
+	bytes = env_get_hex("blk_readahead", CONFIG_BLK_READAHEAD_SIZE);
+
+	return bytes / desc->blksz;
+}
+
+/**
+ * blk_ra_read() - Read through the read-ahead window
+ *
+ * Once a few reads in a row have continued where the previous one stopped,
+ * the device is read a whole window at a time, so that a stream of small
+ * reads turns into a few large transfers.
+ *
+ * @dev: Device to read from
+ * @start: Start block number to read (0=first)
+ * @blkcnt: Number of blocks to read
+ * @buf: Place to put the data
+ * Return: number of blocks read, or -EAGAIN to read directly from the device
+ */
+static long blk_ra_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
+			void *buf)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	struct blk_uc_priv *priv = dev_get_uclass_priv(dev);
+	struct blk_ra *ra = &priv->ra;
+	lbaint_t done = 0, size, n;
+	long ret;
+
+	if (ra->hwpart != desc->hwpart) {
+		ra->hwpart = desc->hwpart;
+		blk_ra_drop(dev);
+	}
+
+	if (start != ra->next)
+		ra->seq = 0;
+	else if (ra->seq < BLK_RA_TRIGGER)
+		ra->seq++;
+	ra->next = start + blkcnt;
+
+	while (blkcnt) {
+		/* serve what the window already holds */
+		if (ra->count && start >= ra->start &&
+		    start < ra->start + ra->count) {
+			n = min(blkcnt, ra->start + ra->count - start);
+			memcpy(buf + done * desc->blksz,
+			       ra->buf + (start - ra->start) * desc->blksz,
+			       n * desc->blksz);
+			start += n;
+			blkcnt -= n;
+			done += n;
+			continue;
+		}
+
+		size = blk_ra_size(desc);
+		if (ra->seq < BLK_RA_TRIGGER || blkcnt >= size ||
+		    start >= desc->lba)
+			break;
+
+		if (ra->size != size) {
+			free(ra->buf);
+			ra->count = 0;
+			ra->size = 0;
+			ra->buf = memalign(ARCH_DMA_MINALIGN,
+					   size * desc->blksz);
+			if (!ra->buf)
+				break;
+			ra->size = size;
+		}
+
+		size = min(size, desc->lba - start);
+		ret = blk_read_dev(dev, start, size, ra->buf);
+		if (ret < (long)blkcnt) {
+			ra->count = 0;
+			break;
+		}
+		debug("%s: read-ahead " LBAF ", count %ld\n", dev->name, start,
+		      ret);
+		ra->start = start;
+		ra->count = ret;
+	}
+
+	if (!blkcnt)
+		return done;
+
+	/* leave the rest to a direct read */
+	if (done) {
+		ret = blk_read_dev(dev, start, blkcnt,
+				   buf + done * desc->blksz);
+		if (ret < 0)
+			return ret;
+		return done + ret;
+	}
+
+	return -EAGAIN;
+}
+#else
+static inline void blk_ra_drop(struct udevice *dev) {}
+static inline void blk_ra_free(struct udevice *dev) {}
+
+static inline long blk_ra_read(struct udevice *dev, lbaint_t start,
+			       lbaint_t blkcnt, void *buf)
+{
+	return -EAGAIN;
+}
+#endif
+
+long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	long blks_read;
+
+	if (!ops->read)
+		return -ENOSYS;
+
+	blk_drain(dev);
+
+	if (blkcache_read(desc->uclass_id, desc->devnum,
+			  start, blkcnt, desc->blksz, buf))
+		return blkcnt;
+
+	blks_read = blk_ra_read(dev, start, blkcnt, buf);
+	if (blks_read == -EAGAIN)
+		blks_read = blk_read_dev(dev, start, blkcnt, buf);
 
 	if (blks_read == blkcnt)
 		blkcache_fill(desc->uclass_id, desc->devnum, start, blkcnt,
@@ -467,17 +858,19 @@ long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 	return blks_read;
 }
 
-long blk_write(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
-	       const void *buf)
+long blk_write_uncached(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
+			const void *buf)
 {
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
 	const struct blk_ops *ops = blk_get_ops(dev);
 	long blks_written;
+	ulong start_us;
 
 	if (!ops->write)
 		return -ENOSYS;
 
-	blkcache_invalidate(desc->uclass_id, desc->devnum);
+	blk_drain(dev);
+	start_us = blk_stats_start();
 
 	if (IS_ENABLED(CONFIG_BOUNCE_BUFFER) && desc->bb) {
 		struct blk_bounce_buffer bbstate = { .dev = dev };
@@ -497,10 +890,59 @@ long blk_write(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 	} else {
 		blks_written = ops->write(dev, start, blkcnt, buf);
 	}
+	blk_stats_add(dev, true, blkcnt, blks_written, start_us);
 
 	return blks_written;
 }
 
+long blk_write(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
+	       const void *buf)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	long blks_written;
+
+	if (!blk_get_ops(dev)->write)
+		return -ENOSYS;
+
+	blk_ra_drop(dev);
+	part_cache_invalidate(desc, start, blkcnt);
+	fat_cache_invalidate_blk(desc, start, blkcnt);
+
+	if (blkcache_write(desc->uclass_id, desc->devnum, start, blkcnt,
+			   desc->blksz, buf))
+		return blkcnt;
+
+	/* on failure the medium is unknown, so drop the cached copies */
+	blks_written = blk_write_uncached(dev, start, blkcnt, buf);
+	blkcache_update(desc->uclass_id, desc->devnum, start, blkcnt,
+			desc->blksz, blks_written == blkcnt ? buf : NULL);
+
+	return blks_written;
+}
+
+const void *blk_map(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+
+	if (!ops->map || !blkcnt)
+		return NULL;
+
+	/* the memory must hold what has been written so far */
+	blk_drain(dev);
+	if (blkcache_flush(desc->uclass_id, desc->devnum))
+		return NULL;
+
+	return ops->map(dev, start, blkcnt);
+}
+
+int blk_flush(struct udevice *dev)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+
+	return blkcache_flush(desc->uclass_id, desc->devnum);
+}
+
 long blk_erase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
 {
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
@@ -509,11 +951,75 @@ long blk_erase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
 	if (!ops->erase)
 		return -ENOSYS;
 
-	blkcache_invalidate(desc->uclass_id, desc->devnum);
+	blk_drain(dev);
+	blk_ra_drop(dev);
+	part_cache_invalidate(desc, start, blkcnt);
+	fat_cache_invalidate_blk(desc, start, blkcnt);
+	blkcache_update(desc->uclass_id, desc->devnum, start, blkcnt,
+			desc->blksz, NULL);
 
 	return ops->erase(dev, start, blkcnt);
 }
 
+int blk_submit(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	bool read = req->op == BLK_REQ_READ;
+
+	if (read ? !ops->read : !ops->write)
+		return -ENOSYS;
+
+	req->done = false;
+	if (read && blkcache_read(desc->uclass_id, desc->devnum, req->start,
+				  req->blkcnt, desc->blksz, req->buf)) {
+		req->result = req->blkcnt;
+		req->done = true;
+		return 0;
+	}
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/* bounce buffers are set up per transfer, so these stay synchronous */
+	if (ops->submit && !(IS_ENABLED(CONFIG_BOUNCE_BUFFER) && desc->bb)) {
+		struct blk_uc_priv *priv = dev_get_uclass_priv(dev);
+
+		if (!read) {
+			blk_ra_drop(dev);
+			part_cache_invalidate(desc, req->start, req->blkcnt);
+			fat_cache_invalidate_blk(desc, req->start,
+						 req->blkcnt);
+			blkcache_update(desc->uclass_id, desc->devnum,
+					req->start, req->blkcnt, desc->blksz,
+					NULL);
+		}
+		list_add_tail(&req->sibling, &priv->queue);
+		blk_queue_run(dev);
+
+		return 0;
+	}
+#endif
+
+	req->result = read ? blk_read(dev, req->start, req->blkcnt, req->buf) :
+		blk_write(dev, req->start, req->blkcnt, req->buf);
+	req->done = true;
+
+	return 0;
+}
+
+long blk_wait(struct udevice *dev, struct blk_req *req)
+{
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct blk_uc_priv *priv = dev_get_uclass_priv(dev);
+
+	while (!req->done && priv->active)
+		blk_queue_wait(dev);
+#endif
+	if (!req->done)
+		return -EINVAL;
+
+	return req->result;
+}
+
 ulong blk_dread(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt,
 		void *buffer)
 {
@@ -531,6 +1037,11 @@ ulong blk_derase(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt)
 	return blk_erase(desc->bdev, start, blkcnt);
 }
 
+const void *blk_dmap(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt)
+{
+	return blk_map(desc->bdev, start, blkcnt);
+}
+
 int blk_find_from_parent(struct udevice *parent, struct udevice **devp)
 {
 	struct udevice *dev;
@@ -852,6 +1363,12 @@ static int part_create_block_devices(struct udevice *blk_dev)
 
 static int blk_post_probe(struct udevice *dev)
 {
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	struct blk_uc_priv *priv = dev_get_uclass_priv(dev);
+
+	INIT_LIST_HEAD(&priv->queue);
+#endif
+
 	if (CONFIG_IS_ENABLED(PARTITIONS) && blk_enabled()) {
 		struct blk_desc *desc = dev_get_uclass_plat(dev);
 
@@ -865,9 +1382,27 @@ static int blk_post_probe(struct udevice *dev)
 	return 0;
 }
 
+static int blk_pre_remove(struct udevice *dev)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+
+	blk_drain(dev);
+	if (blk_flush(dev))
+		log_err("%s: cannot write back cached blocks\n", dev->name);
+	blkcache_invalidate(desc->uclass_id, desc->devnum);
+	part_cache_invalidate(desc, 0, 0);
+	fat_cache_invalidate_blk(desc, 0, 0);
+
+	blk_ra_free(dev);
+
+	return 0;
+}
+
 UCLASS_DRIVER(blk) = {
 	.id		= UCLASS_BLK,
 	.name		= "blk",
 	.post_probe	= blk_post_probe,
+	.pre_remove	= blk_pre_remove,
 	.per_device_plat_auto	= sizeof(struct blk_desc),
+	.per_device_auto	= sizeof(struct blk_uc_priv),
 };
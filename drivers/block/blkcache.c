@@ -12,42 +12,280 @@
 #include <linux/ctype.h>
 #include <linux/list.h>
 
-struct block_cache_node {
-	struct list_head lh;
+/*
+ * The cache is split into fixed-size lines of max_blocks_per_entry blocks,
+ * each holding an aligned run of blocks of one device. Lines are grouped into
+ * sets of CONFIG_BLOCK_CACHE_WAYS; a block can only live in the set its line
+ * number hashes to, so a lookup only scans one set. A bitmap per line tracks
+ * which blocks are present, so a request is served as long as every block it
+ * covers is cached, whichever requests brought them in.
+ */
+
+/* Largest line size, limited by the block bitmaps */
+#define BLKCACHE_MAX_LINE_BLOCKS	32
+
+/*
+ * Requests spanning more lines than this are file data rather than
+ * filesystem metadata; do not let them evict the metadata
+ */
+#define BLKCACHE_FILL_LINES		4
+
+struct block_cache_line {
 	int iftype;
 	int devnum;
-	lbaint_t start;
-	lbaint_t blkcnt;
 	unsigned long blksz;
-	char *cache;
+	lbaint_t tag;		/* first block / max_blocks_per_entry */
+	u32 valid;		/* blocks present in @data */
+	u32 dirty;		/* blocks newer than the medium */
+	unsigned int age;	/* LRU stamp */
+	char *data;
+};
+
+/* Per-device statistics, shown by 'blkcache show' */
+struct block_cache_dev {
+	struct list_head lh;
+	struct block_cache_dev_stats stats;
 };
 
-static LIST_HEAD(block_cache);
+static struct block_cache_line *lines;
+static unsigned int num_sets;
+static unsigned int clock;
+static LIST_HEAD(block_cache_devs);
 
 static struct block_cache_stats _stats = {
 	.max_blocks_per_entry = 8,
-	.max_entries = 32
+	.max_entries = 32,
+	.ways = CONFIG_BLOCK_CACHE_WAYS,
 };
 
-static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
-{
-	struct block_cache_node *node;
-
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
-			}
-			return node;
+static u32 blk_mask(unsigned int first, unsigned int count)
+{
+	return (count == 32 ? ~0U : (1U << count) - 1) << first;
+}
+
+static void cache_set_dirty(struct block_cache_line *line, u32 dirty)
+{
+	if (!line->dirty && dirty)
+		_stats.dirty++;
+	else if (line->dirty && !dirty)
+		_stats.dirty--;
+	line->dirty = dirty;
+}
+
+static struct block_cache_dev_stats *dev_stats(int iftype, int devnum)
+{
+	struct block_cache_dev *bdev;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh)
+		if (bdev->stats.iftype == iftype &&
+		    bdev->stats.devnum == devnum)
+			return &bdev->stats;
+
+	bdev = calloc(1, sizeof(*bdev));
+	if (!bdev)
+		return NULL;
+	bdev->stats.iftype = iftype;
+	bdev->stats.devnum = devnum;
+	list_add_tail(&bdev->lh, &block_cache_devs);
+
+	return &bdev->stats;
+}
+
+static int cache_setup(void)
+{
+	unsigned int ways = _stats.ways;
+
+	if (lines)
+		return 0;
+	if (!_stats.max_entries || !_stats.max_blocks_per_entry)
+		return -ENOSPC;
+
+	num_sets = max(_stats.max_entries / ways, 1U);
+	lines = calloc(num_sets * ways, sizeof(*lines));
+	if (!lines)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static struct block_cache_line *cache_set(int iftype, int devnum,
+					  lbaint_t tag)
+{
+	u32 hash;
+
+	hash = ((u32)tag ^ (u32)((u64)tag >> 32)) * 0x9e3779b1;
+	hash ^= (devnum << 8) ^ iftype;
+
+	return &lines[(hash % num_sets) * _stats.ways];
+}
+
+static struct block_cache_line *cache_find(int iftype, int devnum,
+					   unsigned long blksz, lbaint_t tag)
+{
+	struct block_cache_line *line = cache_set(iftype, devnum, tag);
+	int i;
+
+	for (i = 0; i < _stats.ways; i++, line++)
+		if (line->valid && line->iftype == iftype &&
+		    line->devnum == devnum && line->blksz == blksz &&
+		    line->tag == tag) {
+			line->age = ++clock;
+			return line;
 		}
+
+	return NULL;
+}
+
+/* Write the dirty blocks of a line back to its device */
+static int cache_writeback(struct block_cache_line *line)
+{
+	unsigned int first, count, lb = _stats.max_blocks_per_entry;
+	struct udevice *dev;
+	lbaint_t start;
+	long ret;
+
+	if (!line->dirty)
+		return 0;
+
+	ret = blk_find_device(line->iftype, line->devnum, &dev);
+	if (ret) {
+		log_err("blkcache: lost writes to device %d:%d (err=%ld)\n",
+			line->iftype, line->devnum, ret);
+		cache_set_dirty(line, 0);
+		return ret;
+	}
+
+	for (first = 0; first < lb; first += count) {
+		for (count = 0; first + count < lb &&
+		     (line->dirty & BIT(first + count)); count++)
+			;
+		if (!count) {
+			count = 1;
+			continue;
+		}
+
+		start = line->tag * lb + first;
+		debug("writeback: start " LBAF ", count %u\n", start, count);
+		ret = blk_write_uncached(dev, start, count,
+					 line->data + first * line->blksz);
+		if (ret != count) {
+			log_err("blkcache: write of block " LBAF " failed\n",
+				start);
+			return -EIO;
+		}
+		cache_set_dirty(line, line->dirty & ~blk_mask(first, count));
+		_stats.writebacks++;
+	}
+
+	return 0;
+}
+
+static void cache_drop(struct block_cache_line *line)
+{
+	if (line->valid)
+		_stats.entries--;
+	line->valid = 0;
+	cache_set_dirty(line, 0);
+}
+
+/* Find the line for @tag, allocating it if needed */
+static struct block_cache_line *cache_alloc(int iftype, int devnum,
+					    unsigned long blksz, lbaint_t tag)
+{
+	struct block_cache_line *line, *victim;
+	unsigned long bytes;
+	int i;
+
+	line = cache_find(iftype, devnum, blksz, tag);
+	if (line)
+		return line;
+
+	victim = cache_set(iftype, devnum, tag);
+	for (i = 0, line = victim; i < _stats.ways; i++, line++) {
+		if (!line->valid) {
+			victim = line;
+			break;
+		}
+		if (line->age < victim->age)
+			victim = line;
+	}
+
+	if (victim->valid) {
+		debug("drop: start " LBAF "\n",
+		      victim->tag * _stats.max_blocks_per_entry);
+		if (cache_writeback(victim))
+			return NULL;
+		cache_drop(victim);
+	}
+
+	bytes = blksz * _stats.max_blocks_per_entry;
+	if (victim->data && victim->blksz != blksz) {
+		free(victim->data);
+		victim->data = NULL;
+	}
+	if (!victim->data) {
+		victim->data = malloc(bytes);
+		if (!victim->data)
+			return NULL;
+	}
+
+	victim->iftype = iftype;
+	victim->devnum = devnum;
+	victim->blksz = blksz;
+	victim->tag = tag;
+	victim->age = ++clock;
+	_stats.entries++;
+
+	return victim;
+}
+
+/*
+ * Call @fn for each line-sized piece of a request. The callback returns 0 to
+ * continue, or non-zero to stop.
+ */
+static int cache_for_each(lbaint_t start, lbaint_t blkcnt,
+			  unsigned long blksz, char *buffer,
+			  int (*fn)(lbaint_t tag, unsigned int first,
+				    unsigned int count, char *buf, void *priv),
+			  void *priv)
+{
+	unsigned int lb = _stats.max_blocks_per_entry;
+	lbaint_t blk = start, end = start + blkcnt;
+	unsigned int first, count;
+	int ret;
+
+	while (blk < end) {
+		first = blk % lb;
+		count = min_t(lbaint_t, lb - first, end - blk);
+		ret = fn(blk / lb, first, count,
+			 buffer ? buffer + (blk - start) * blksz : NULL, priv);
+		if (ret)
+			return ret;
+		blk += count;
+	}
+
+	return 0;
+}
+
+struct cache_req {
+	int iftype;
+	int devnum;
+	unsigned long blksz;
+};
+
+static int read_one(lbaint_t tag, unsigned int first, unsigned int count,
+		    char *buf, void *priv)
+{
+	struct cache_req *req = priv;
+	struct block_cache_line *line;
+	u32 mask = blk_mask(first, count);
+
+	line = cache_find(req->iftype, req->devnum, req->blksz, tag);
+	if (!line || (line->valid & mask) != mask)
+		return 1;
+
+	memcpy(buf, line->data + first * req->blksz, count * req->blksz);
+
 	return 0;
 }
 
@@ -55,102 +293,252 @@ int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
+	struct cache_req req = { iftype, devnum, blksz };
+	struct block_cache_dev_stats *dstats;
+	int ret;
+
+	if (cache_setup())
+		return 0;
+
+	dstats = dev_stats(iftype, devnum);
+	ret = cache_for_each(start, blkcnt, blksz, buffer, read_one, &req);
+	if (!ret) {
 		debug("hit: start " LBAF ", count " LBAFU "\n",
 		      start, blkcnt);
 		++_stats.hits;
+		if (dstats)
+			dstats->hits++;
 		return 1;
 	}
 
 	debug("miss: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 	++_stats.misses;
+	if (dstats)
+		dstats->misses++;
+	return 0;
+}
+
+static int fill_one(lbaint_t tag, unsigned int first, unsigned int count,
+		    char *buf, void *priv)
+{
+	struct cache_req *req = priv;
+	struct block_cache_line *line;
+	unsigned int i;
+	char *data;
+
+	line = cache_alloc(req->iftype, req->devnum, req->blksz, tag);
+	if (!line)
+		return 0;
+
+	for (i = first; i < first + count; i++, buf += req->blksz) {
+		data = line->data + i * req->blksz;
+		/* the medium is stale for dirty blocks, so hand out ours */
+		if (line->dirty & BIT(i))
+			memcpy(buf, data, req->blksz);
+		else
+			memcpy(data, buf, req->blksz);
+	}
+	line->valid |= blk_mask(first, count);
+
+	return 0;
+}
+
+static int overlay_one(lbaint_t tag, unsigned int first, unsigned int count,
+		       char *buf, void *priv)
+{
+	struct cache_req *req = priv;
+	struct block_cache_line *line;
+	unsigned int i;
+
+	line = cache_find(req->iftype, req->devnum, req->blksz, tag);
+	if (!line || !(line->dirty & blk_mask(first, count)))
+		return 0;
+
+	for (i = first; i < first + count; i++, buf += req->blksz)
+		if (line->dirty & BIT(i))
+			memcpy(buf, line->data + i * req->blksz, req->blksz);
+
 	return 0;
 }
 
 void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
-		   unsigned long blksz, void const *buffer)
+		   unsigned long blksz, void *buffer)
 {
-	lbaint_t bytes;
-	struct block_cache_node *node;
+	struct cache_req req = { iftype, devnum, blksz };
 
-	/* don't cache big stuff */
-	if (blkcnt > _stats.max_blocks_per_entry)
+	if (cache_setup())
 		return;
 
-	if (_stats.max_entries == 0)
+	/* don't cache big stuff, but never hide blocks not written back */
+	if (blkcnt > BLKCACHE_FILL_LINES * _stats.max_blocks_per_entry) {
+		if (_stats.dirty)
+			cache_for_each(start, blkcnt, blksz, buffer,
+				       overlay_one, &req);
 		return;
+	}
 
-	bytes = blksz * blkcnt;
-	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
-			free(node->cache);
-			node->cache = 0;
-		}
+	debug("fill: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
+	cache_for_each(start, blkcnt, blksz, buffer, fill_one, &req);
+}
+
+static int write_one(lbaint_t tag, unsigned int first, unsigned int count,
+		     char *buf, void *priv)
+{
+	struct cache_req *req = priv;
+	struct block_cache_line *line;
+	u32 mask = blk_mask(first, count);
+
+	line = cache_alloc(req->iftype, req->devnum, req->blksz, tag);
+	if (!line)
+		return -ENOMEM;
+
+	memcpy(line->data + first * req->blksz, buf, count * req->blksz);
+	line->valid |= mask;
+	cache_set_dirty(line, line->dirty | mask);
+
+	return 0;
+}
+
+static int update_one(lbaint_t tag, unsigned int first, unsigned int count,
+		      char *buf, void *priv)
+{
+	struct cache_req *req = priv;
+	struct block_cache_line *line;
+	u32 mask = blk_mask(first, count);
+
+	line = cache_find(req->iftype, req->devnum, req->blksz, tag);
+	if (!line)
+		return 0;
+
+	if (buf) {
+		memcpy(line->data + first * req->blksz, buf,
+		       count * req->blksz);
+		line->valid |= mask;
 	} else {
-		node = malloc(sizeof(*node));
-		if (!node)
-			return;
-		node->cache = 0;
+		line->valid &= ~mask;
 	}
+	cache_set_dirty(line, line->dirty & ~mask);
+	if (!line->valid)
+		cache_drop(line);
 
-	if (!node->cache) {
-		node->cache = malloc(bytes);
-		if (!node->cache) {
-			free(node);
-			return;
-		}
-	}
+	return 0;
+}
 
-	debug("fill: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
+int blkcache_write(int iftype, int devnum,
+		   lbaint_t start, lbaint_t blkcnt,
+		   unsigned long blksz, const void *buffer)
+{
+	struct cache_req req = { iftype, devnum, blksz };
+	struct block_cache_dev_stats *dstats;
 
-	node->iftype = iftype;
-	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
-	node->blksz = blksz;
-	memcpy(node->cache, buffer, bytes);
-	list_add(&node->lh, &block_cache);
-	_stats.entries++;
+	if (!CONFIG_IS_ENABLED(BLOCK_CACHE_WRITEBACK) ||
+	    blkcnt > BLKCACHE_FILL_LINES * _stats.max_blocks_per_entry ||
+	    cache_setup())
+		return 0;
+
+	/*
+	 * If a line cannot be allocated, part of the request may be cached
+	 * already; the caller then writes all of it through, which brings
+	 * those lines back in sync via blkcache_update().
+	 */
+	if (cache_for_each(start, blkcnt, blksz, (char *)buffer, write_one,
+			   &req))
+		return 0;
+
+	debug("write: start " LBAF ", count " LBAFU "\n", start, blkcnt);
+	dstats = dev_stats(iftype, devnum);
+	if (dstats)
+		dstats->writes++;
+
+	return 1;
+}
+
+void blkcache_update(int iftype, int devnum,
+		     lbaint_t start, lbaint_t blkcnt,
+		     unsigned long blksz, const void *buffer)
+{
+	struct cache_req req = { iftype, devnum, blksz };
+
+	if (!lines)
+		return;
+
+	cache_for_each(start, blkcnt, blksz, (char *)buffer, update_one,
+		       &req);
+}
+
+int blkcache_flush(int iftype, int devnum)
+{
+	struct block_cache_line *line;
+	int i, ret, err = 0;
+
+	if (!lines || !_stats.dirty)
+		return 0;
+
+	for (i = 0, line = lines; i < num_sets * _stats.ways; i++, line++) {
+		if (!line->dirty)
+			continue;
+		if (iftype != -1 &&
+		    (line->iftype != iftype || line->devnum != devnum))
+			continue;
+		ret = cache_writeback(line);
+		if (ret)
+			err = ret;
+	}
+
+	return err;
 }
 
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_line *line;
+	int i;
+
+	if (!lines)
+		return;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
+	for (i = 0, line = lines; i < num_sets * _stats.ways; i++, line++) {
 		if (iftype == -1 ||
-		    (node->iftype == iftype && node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
+		    (line->iftype == iftype && line->devnum == devnum)) {
+			if (line->dirty)
+				log_warning("blkcache: discarding writes to device %d:%d\n",
+					    line->iftype, line->devnum);
+			cache_drop(line);
 		}
 	}
 }
 
+static void cache_release(void)
+{
+	struct block_cache_dev *bdev, *n;
+	int i;
+
+	if (lines) {
+		blkcache_flush(-1, 0);
+		blkcache_invalidate(-1, 0);
+		for (i = 0; i < num_sets * _stats.ways; i++)
+			free(lines[i].data);
+		free(lines);
+		lines = NULL;
+	}
+
+	list_for_each_entry_safe(bdev, n, &block_cache_devs, lh) {
+		list_del(&bdev->lh);
+		free(bdev);
+	}
+}
+
 void blkcache_configure(unsigned blocks, unsigned entries)
 {
 	/* invalidate cache if there is a change */
 	if ((blocks != _stats.max_blocks_per_entry) ||
 	    (entries != _stats.max_entries))
-		blkcache_invalidate(-1, 0);
+		cache_release();
 
-	_stats.max_blocks_per_entry = blocks;
+	_stats.max_blocks_per_entry = min_t(unsigned int, blocks,
+					    BLKCACHE_MAX_LINE_BLOCKS);
 	_stats.max_entries = entries;
 
 	_stats.hits = 0;
@@ -162,9 +550,26 @@ void blkcache_stats(struct block_cache_stats *stats)
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.writebacks = 0;
+}
+
+int blkcache_dev_stats(int seq, struct block_cache_dev_stats *stats)
+{
+	struct block_cache_dev *bdev;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh)
+		if (!seq--) {
+			memcpy(stats, &bdev->stats, sizeof(*stats));
+			bdev->stats.hits = 0;
+			bdev->stats.misses = 0;
+			bdev->stats.writes = 0;
+			return 0;
+		}
+
+	return -ENOENT;
 }
 
 void blkcache_free(void)
 {
-	blkcache_invalidate(-1, 0);
+	cache_release();
 }
@@ -56,6 +56,17 @@ struct blkmap_slice {
 	ulong (*write)(struct blkmap *bm, struct blkmap_slice *bms,
 		       lbaint_t blknr, lbaint_t blkcnt, const void *buffer);
 
+	/**
+	 * @map: - Get a pointer to the data of the slice (optional)
+	 *
+	 * @map.bm: Blkmap to which this slice belongs
+	 * @map.bms: This slice
+	 * @map.blknr: Start block number to map, within the slice
+	 * @map.blkcnt: Number of blocks to map, all within the slice
+	 */
+	const void *(*map)(struct blkmap *bm, struct blkmap_slice *bms,
+			   lbaint_t blknr, lbaint_t blkcnt);
+
 	/**
 	 * @destroy: - Tear down slice
 	 *
@@ -145,6 +156,15 @@ static ulong blkmap_linear_write(struct blkmap *bm, struct blkmap_slice *bms,
 	return blk_write(bml->blk, bml->blknr + blknr, blkcnt, buffer);
 }
 
+static const void *blkmap_linear_map(struct blkmap *bm,
+				     struct blkmap_slice *bms,
+				     lbaint_t blknr, lbaint_t blkcnt)
+{
+	struct blkmap_linear *bml = container_of(bms, struct blkmap_linear, slice);
+
+	return blk_map(bml->blk, bml->blknr + blknr, blkcnt);
+}
+
 int blkmap_map_linear(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 		      struct udevice *lblk, lbaint_t lblknr)
 {
@@ -172,6 +192,7 @@ int blkmap_map_linear(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 
 			.read = blkmap_linear_read,
 			.write = blkmap_linear_write,
+			.map = blkmap_linear_map,
 		},
 
 		.blk = lblk,
@@ -225,6 +246,15 @@ static ulong blkmap_mem_write(struct blkmap *bm, struct blkmap_slice *bms,
 	return blkcnt;
 }
 
+static const void *blkmap_mem_map(struct blkmap *bm, struct blkmap_slice *bms,
+				  lbaint_t blknr, lbaint_t blkcnt)
+{
+	struct blkmap_mem *bmm = container_of(bms, struct blkmap_mem, slice);
+	struct blk_desc *bd = dev_get_uclass_plat(bm->blk);
+
+	return bmm->addr + (blknr << bd->log2blksz);
+}
+
 static void blkmap_mem_destroy(struct blkmap *bm, struct blkmap_slice *bms)
 {
 	struct blkmap_mem *bmm = container_of(bms, struct blkmap_mem, slice);
@@ -251,6 +281,7 @@ int __blkmap_map_mem(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 
 			.read = blkmap_mem_read,
 			.write = blkmap_mem_write,
+			.map = blkmap_mem_map,
 			.destroy = blkmap_mem_destroy,
 		},
 
@@ -356,9 +387,29 @@ static ulong blkmap_blk_write(struct udevice *dev, lbaint_t blknr,
 	return total;
 }
 
+static const void *blkmap_blk_map(struct udevice *dev, lbaint_t blknr,
+				  lbaint_t blkcnt)
+{
+	struct blkmap *bm = dev_get_plat(dev->parent);
+	struct blkmap_slice *bms;
+
+	/* Only a range within a single slice is contiguous */
+	list_for_each_entry(bms, &bm->slices, node) {
+		if (!blkmap_slice_contains(bms, blknr))
+			continue;
+		if (!bms->map || blkcnt > bms->blknr + bms->blkcnt - blknr)
+			return NULL;
+
+		return bms->map(bm, bms, blknr - bms->blknr, blkcnt);
+	}
+
+	return NULL;
+}
+
 static const struct blk_ops blkmap_blk_ops = {
 	.read	= blkmap_blk_read,
 	.write	= blkmap_blk_write,
+	.map	= blkmap_blk_map,
 };
 
 U_BOOT_DRIVER(blkmap_blk) = {
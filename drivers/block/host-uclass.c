@@ -135,6 +135,14 @@ int host_detach_file(struct udevice *dev)
 	return ops->detach_file(dev);
 }
 
+void host_set_timing(struct udevice *dev, uint latency_us, uint bandwidth)
+{
+	struct host_sb_plat *plat = dev_get_plat(dev);
+
+	plat->latency_us = latency_us;
+	plat->bandwidth = bandwidth;
+}
+
 struct udevice *host_find_by_label(const char *label)
 {
 	struct udevice *dev;
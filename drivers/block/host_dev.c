@@ -23,7 +23,8 @@ static int host_sb_attach_file(struct udevice *dev, const char *filename)
 	struct host_sb_plat *plat = dev_get_plat(dev);
 	struct blk_desc *desc;
 	struct udevice *blk;
-	int ret, fd;
+	int ret, fd, flags;
+	void *map = NULL;
 	off_t size;
 	char *fname;
 
@@ -38,11 +39,13 @@ static int host_sb_attach_file(struct udevice *dev, const char *filename)
 	if (ret)
 		return ret;
 
-	fd = os_open(filename, OS_O_RDWR);
+	flags = OS_O_RDWR;
+	fd = os_open(filename, flags);
 	if (fd == -1) {
 		printf("Failed to access host backing file '%s', trying read-only\n",
 		       filename);
-		fd = os_open(filename, OS_O_RDONLY);
+		flags = OS_O_RDONLY;
+		fd = os_open(filename, flags);
 		if (fd == -1) {
 			printf("- still failed\n");
 			return log_msg_ret("open", -ENOENT);
@@ -65,10 +68,18 @@ static int host_sb_attach_file(struct udevice *dev, const char *filename)
 	}
 	desc->lba = size / desc->blksz;
 
+	/* larger files are still read and written through the descriptor */
+	if (IS_ENABLED(CONFIG_SANDBOX_HOST_MMAP) && size && size <= INT_MAX &&
+	    os_map_fd(fd, flags, size, &map))
+		log_debug("Cannot map '%s'\n", filename);
+
 	/* write this in last, when nothing can go wrong */
 	plat = dev_get_plat(dev);
 	plat->fd = fd;
 	plat->filename = fname;
+	plat->read_only = flags == OS_O_RDONLY;
+	plat->map = map;
+	plat->size = size;
 
 	return 0;
 
@@ -95,6 +106,9 @@ static int host_sb_detach_file(struct udevice *dev)
 	if (ret)
 		return log_msg_ret("unb", ret);
 
+	if (plat->map)
+		os_unmap(plat->map, plat->size);
+	plat->map = NULL;
 	os_close(plat->fd);
 	plat->fd = 0;
 	free(plat->filename);
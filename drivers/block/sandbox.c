@@ -14,9 +14,33 @@
 #include <dm/device_compat.h>
 #include <dm/device-internal.h>
 #include <linux/errno.h>
+#include <linux/math64.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Take as long as host_set_timing() says a transfer of @blkcnt blocks does */
+static void host_block_delay(struct blk_desc *desc, struct host_sb_plat *plat,
+			     lbaint_t blkcnt)
+{
+	u64 us = plat->latency_us;
+
+	/* 1MB/s is one byte per microsecond */
+	if (plat->bandwidth)
+		us += div_u64((u64)blkcnt * desc->blksz, plat->bandwidth);
+	if (us)
+		os_usleep(us);
+}
+
+/* Get the number of blocks from @start which are in the mapped file */
+static lbaint_t host_block_map_count(struct blk_desc *desc,
+				     unsigned long start, lbaint_t blkcnt)
+{
+	if (start >= desc->lba)
+		return 0;
+
+	return min(blkcnt, desc->lba - start);
+}
+
 static unsigned long host_block_read(struct udevice *dev,
 				     unsigned long start, lbaint_t blkcnt,
 				     void *buffer)
@@ -25,6 +49,14 @@ static unsigned long host_block_read(struct udevice *dev,
 	struct udevice *host_dev = dev_get_parent(dev);
 	struct host_sb_plat *plat = dev_get_plat(host_dev);
 
+	host_block_delay(desc, plat, blkcnt);
+	if (plat->map) {
+		blkcnt = host_block_map_count(desc, start, blkcnt);
+		memcpy(buffer, plat->map + start * desc->blksz,
+		       blkcnt * desc->blksz);
+		return blkcnt;
+	}
+
 	if (os_lseek(plat->fd, start * desc->blksz, OS_SEEK_SET) < 0) {
 		printf("ERROR: Invalid block %lx\n", start);
 		return -1;
@@ -44,6 +76,16 @@ static unsigned long host_block_write(struct udevice *dev,
 	struct udevice *host_dev = dev_get_parent(dev);
 	struct host_sb_plat *plat = dev_get_plat(host_dev);
 
+	host_block_delay(desc, plat, blkcnt);
+	if (plat->map) {
+		if (plat->read_only)
+			return -EIO;
+		blkcnt = host_block_map_count(desc, start, blkcnt);
+		memcpy(plat->map + start * desc->blksz, buffer,
+		       blkcnt * desc->blksz);
+		return blkcnt;
+	}
+
 	if (os_lseek(plat->fd, start * desc->blksz, OS_SEEK_SET) < 0) {
 		printf("ERROR: Invalid block %lx\n", start);
 		return -1;
@@ -55,9 +97,37 @@ static unsigned long host_block_write(struct udevice *dev,
 	return -EIO;
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/*
+ * Host files are accessed synchronously, so just defer the transfer until
+ * the uclass waits for it. This exercises the request queue in tests.
+ */
+static int host_block_submit(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+
+	if (req->start + req->blkcnt > desc->lba)
+		return -EINVAL;
+
+	return 0;
+}
+
+static long host_block_wait(struct udevice *dev, struct blk_req *req)
+{
+	if (req->op == BLK_REQ_READ)
+		return host_block_read(dev, req->start, req->blkcnt, req->buf);
+
+	return host_block_write(dev, req->start, req->blkcnt, req->buf);
+}
+#endif
+
 static const struct blk_ops sandbox_host_blk_ops = {
 	.read	= host_block_read,
 	.write	= host_block_write,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.submit	= host_block_submit,
+	.wait	= host_block_wait,
+#endif
 };
 
 U_BOOT_DRIVER(sandbox_host_blk) = {
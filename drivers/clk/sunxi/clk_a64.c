@@ -16,6 +16,7 @@ static const struct ccu_clk_gate a64_gates[] = {
 	[CLK_PLL_PERIPH0]	= GATE(0x028, BIT(31)),
 
 	[CLK_BUS_MIPI_DSI]	= GATE(0x060, BIT(1)),
+	[CLK_BUS_DMA]		= GATE(0x060, BIT(6)),
 	[CLK_BUS_MMC0]		= GATE(0x060, BIT(8)),
 	[CLK_BUS_MMC1]		= GATE(0x060, BIT(9)),
 	[CLK_BUS_MMC2]		= GATE(0x060, BIT(10)),
@@ -72,6 +73,7 @@ static const struct ccu_reset a64_resets[] = {
 	[RST_USB_HSIC]          = RESET(0x0cc, BIT(2)),
 
 	[RST_BUS_MIPI_DSI]	= RESET(0x2c0, BIT(1)),
+	[RST_BUS_DMA]		= RESET(0x2c0, BIT(6)),
 	[RST_BUS_MMC0]		= RESET(0x2c0, BIT(8)),
 	[RST_BUS_MMC1]		= RESET(0x2c0, BIT(9)),
 	[RST_BUS_MMC2]		= RESET(0x2c0, BIT(10)),
@@ -116,6 +116,8 @@ int device_unbind(struct udevice *dev)
 	if (dev->parent)
 		list_del(&dev->sibling_node);
 
+	device_node_hash_del(dev);
+	dm_lazy_unbind(dev);
 	devres_release_all(dev);
 
 	if (dev_get_flags(dev) & DM_FLAG_NAME_ALLOCED)
@@ -131,15 +133,29 @@ int device_unbind(struct udevice *dev)
  */
 void device_free(struct udevice *dev)
 {
+	bool freed = false;
 	int size;
 
+	/* A compact block starts with the first part, so free it in one go */
+	if (dev_get_flags(dev) & DM_FLAG_COMPACT_PRIV) {
+		if (dev->driver->priv_auto)
+			free(dev_get_priv(dev));
+		else if (dev->uclass->uc_drv->per_device_auto)
+			free(dev_get_uclass_priv(dev));
+		else
+			free(dev_get_parent_priv(dev));
+		freed = true;
+	}
+
 	if (dev->driver->priv_auto) {
-		free(dev_get_priv(dev));
+		if (!freed)
+			free(dev_get_priv(dev));
 		dev_set_priv(dev, NULL);
 	}
 	size = dev->uclass->uc_drv->per_device_auto;
 	if (size) {
-		free(dev_get_uclass_priv(dev));
+		if (!freed)
+			free(dev_get_uclass_priv(dev));
 		dev_set_uclass_priv(dev, NULL);
 	}
 	if (dev->parent) {
@@ -147,11 +163,12 @@ void device_free(struct udevice *dev)
 		if (!size)
 			size = dev->parent->uclass->uc_drv->per_child_auto;
 		if (size) {
-			free(dev_get_parent_priv(dev));
+			if (!freed)
+				free(dev_get_parent_priv(dev));
 			dev_set_parent_priv(dev, NULL);
 		}
 	}
-	dev_bic_flags(dev, DM_FLAG_PLATDATA_VALID);
+	dev_bic_flags(dev, DM_FLAG_PLATDATA_VALID | DM_FLAG_COMPACT_PRIV);
 
 	devres_release_probe(dev);
 }
@@ -8,6 +8,7 @@
  * Pavel Herrmann <morpheus.ibis@gmail.com>
  */
 
+#include <bootstage.h>
 #include <cpu_func.h>
 #include <errno.h>
 #include <event.h>
@@ -37,6 +38,55 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Alignment of each part of a compact block, the same as malloc() gives */
+#define DM_COMPACT_ALIGN	(2 * sizeof(size_t))
+
+/**
+ * device_bind_extra() - Get the space needed for plat data in a compact block
+ *
+ * This adds up the plat data which device_bind_common() allocates, so that
+ * it can be placed after the device in the same block.
+ *
+ * Return: number of bytes needed after the device, or 0 if none
+ */
+static int device_bind_extra(struct udevice *parent, const struct driver *drv,
+			     struct uclass *uc, void *plat, uint of_plat_size)
+{
+	int size, extra = 0;
+
+	if (drv->plat_auto && (!plat || (CONFIG_IS_ENABLED(OF_PLATDATA) &&
+					 of_plat_size < drv->plat_auto)))
+		extra += ALIGN(drv->plat_auto, DM_COMPACT_ALIGN);
+	extra += ALIGN(uc->uc_drv->per_device_plat_auto, DM_COMPACT_ALIGN);
+	if (parent) {
+		size = parent->driver->per_child_plat_auto;
+		if (!size)
+			size = parent->uclass->uc_drv->per_child_plat_auto;
+		extra += ALIGN(size, DM_COMPACT_ALIGN);
+	}
+
+	return extra;
+}
+
+/**
+ * device_alloc_part() - Allocate some zeroed data for a device
+ *
+ * @nextp: Next free space in the device's compact block, which is updated,
+ *	or points to NULL to allocate the data separately
+ * @size: Number of bytes needed
+ * Return: pointer to the data, or NULL if out of memory
+ */
+static void *device_alloc_part(void **nextp, int size)
+{
+	void *ptr = *nextp;
+
+	if (!ptr)
+		return calloc(1, size);
+	*nextp = ptr + ALIGN(size, DM_COMPACT_ALIGN);
+
+	return ptr;
+}
+
 static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			      const char *name, void *plat,
 			      ulong driver_data, ofnode node,
@@ -46,6 +96,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	struct uclass *uc;
 	int size, ret = 0;
 	bool auto_seq = true;
+	void *next = NULL;
 	void *ptr;
 
 	if (CONFIG_IS_ENABLED(OF_PLATDATA_NO_BIND))
@@ -62,9 +113,22 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		return ret;
 	}
 
-	dev = calloc(1, sizeof(struct udevice));
-	if (!dev)
-		return -ENOMEM;
+	size = 0;
+	if (CONFIG_IS_ENABLED(DM_COMPACT_ALLOC))
+		size = device_bind_extra(parent, drv, uc, plat, of_plat_size);
+	if (size) {
+		dev = calloc(1, ALIGN(sizeof(struct udevice), DM_COMPACT_ALIGN) +
+			     size);
+		if (!dev)
+			return -ENOMEM;
+		next = (void *)dev + ALIGN(sizeof(struct udevice),
+					   DM_COMPACT_ALIGN);
+		dev_or_flags(dev, DM_FLAG_COMPACT_PDATA);
+	} else {
+		dev = calloc(1, sizeof(struct udevice));
+		if (!dev)
+			return -ENOMEM;
+	}
 
 	INIT_LIST_HEAD(&dev->sibling_node);
 	INIT_LIST_HEAD(&dev->child_head);
@@ -115,12 +179,13 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 				alloc = true;
 		}
 		if (alloc) {
-			dev_or_flags(dev, DM_FLAG_ALLOC_PDATA);
-			ptr = calloc(1, drv->plat_auto);
+			ptr = device_alloc_part(&next, drv->plat_auto);
 			if (!ptr) {
 				ret = -ENOMEM;
 				goto fail_alloc1;
 			}
+			if (!next)
+				dev_or_flags(dev, DM_FLAG_ALLOC_PDATA);
 
 			/*
 			 * For of-platdata, copy the old plat into the new
@@ -134,12 +199,13 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 
 	size = uc->uc_drv->per_device_plat_auto;
 	if (size) {
-		dev_or_flags(dev, DM_FLAG_ALLOC_UCLASS_PDATA);
-		ptr = calloc(1, size);
+		ptr = device_alloc_part(&next, size);
 		if (!ptr) {
 			ret = -ENOMEM;
 			goto fail_alloc2;
 		}
+		if (!next)
+			dev_or_flags(dev, DM_FLAG_ALLOC_UCLASS_PDATA);
 		dev_set_uclass_plat(dev, ptr);
 	}
 
@@ -148,12 +214,13 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 		if (!size)
 			size = parent->uclass->uc_drv->per_child_plat_auto;
 		if (size) {
-			dev_or_flags(dev, DM_FLAG_ALLOC_PARENT_PDATA);
-			ptr = calloc(1, size);
+			ptr = device_alloc_part(&next, size);
 			if (!ptr) {
 				ret = -ENOMEM;
 				goto fail_alloc3;
 			}
+			if (!next)
+				dev_or_flags(dev, DM_FLAG_ALLOC_PARENT_PDATA);
 			dev_set_parent_plat(dev, ptr);
 		}
 		/* put dev into parent's successor list */
@@ -186,6 +253,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	if (devp)
 		*devp = dev;
 
+	device_node_hash_add(dev);
 	dev_or_flags(dev, DM_FLAG_BOUND);
 
 	return 0;
@@ -237,6 +305,61 @@ fail_alloc1:
 	return ret;
 }
 
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+static uint device_node_hash(ofnode node)
+{
+	return ((u32)node.of_offset * 0x9e3779b1) >> (32 - DM_NODE_HASH_BITS);
+}
+
+void device_node_hash_add(struct udevice *dev)
+{
+	struct udevice **pos;
+
+	if (!gd->dm_node_hash || !ofnode_valid(dev_ofnode(dev)))
+		return;
+
+	/* Append so that lookups return devices in the order of binding */
+	pos = &gd->dm_node_hash[device_node_hash(dev_ofnode(dev))];
+	while (*pos)
+		pos = &(*pos)->node_hash_next;
+	dev->node_hash_next = NULL;
+	*pos = dev;
+}
+
+void device_node_hash_del(struct udevice *dev)
+{
+	struct udevice **pos;
+
+	if (!gd->dm_node_hash || !ofnode_valid(dev_ofnode(dev)))
+		return;
+
+	pos = &gd->dm_node_hash[device_node_hash(dev_ofnode(dev))];
+	for (; *pos; pos = &(*pos)->node_hash_next) {
+		if (*pos == dev) {
+			*pos = dev->node_hash_next;
+			return;
+		}
+	}
+}
+
+struct udevice *device_node_hash_find(enum uclass_id id, ofnode node)
+{
+	struct udevice *dev;
+
+	if (!gd->dm_node_hash)
+		return NULL;
+
+	dev = gd->dm_node_hash[device_node_hash(node)];
+	for (; dev; dev = dev->node_hash_next) {
+		if (ofnode_equal(dev_ofnode(dev), node) &&
+		    device_get_uclass_id(dev) == id)
+			return dev;
+	}
+
+	return NULL;
+}
+#endif
+
 int device_bind_with_driver_data(struct udevice *parent,
 				 const struct driver *drv, const char *name,
 				 ulong driver_data, ofnode node,
@@ -338,6 +461,62 @@ static void *alloc_priv(int size, uint flags)
 	return priv;
 }
 
+/**
+ * device_alloc_priv_compact() - Allocate all the priv data in one block
+ *
+ * The parts are placed in the order priv, uclass priv, parent priv, so that
+ * device_free() can find the start of the block.
+ *
+ * @dev: Device to process
+ * Return: 0 if OK, -ENOMEM if out of memory, -ENOTSUPP if the data must be
+ *	allocated separately, e.g. because some of it is needed for DMA, or is
+ *	already allocated
+ */
+static int device_alloc_priv_compact(struct udevice *dev)
+{
+	static const enum dm_tag_t tags[] = {
+		DM_TAG_PRIV, DM_TAG_UC_PRIV, DM_TAG_PARENT_PRIV
+	};
+	uint flags[] = {
+		dev->driver->flags, dev->uclass->uc_drv->flags,
+		dev->driver->flags
+	};
+	int i, size, parts = 0, total = 0;
+	void *ptr;
+
+	for (i = 0; i < ARRAY_SIZE(tags); i++) {
+		size = dev_get_attach_size(dev, tags[i]);
+		if (!size)
+			continue;
+		if ((flags[i] & DM_FLAG_ALLOC_PRIV_DMA) ||
+		    dev_get_attach_ptr(dev, tags[i]))
+			return -ENOTSUPP;
+		total += ALIGN(size, DM_COMPACT_ALIGN);
+		parts++;
+	}
+	if (parts < 2)
+		return -ENOTSUPP;
+
+	ptr = calloc(1, total);
+	if (!ptr)
+		return -ENOMEM;
+	for (i = 0; i < ARRAY_SIZE(tags); i++) {
+		size = dev_get_attach_size(dev, tags[i]);
+		if (!size)
+			continue;
+		if (tags[i] == DM_TAG_PRIV)
+			dev_set_priv(dev, ptr);
+		else if (tags[i] == DM_TAG_UC_PRIV)
+			dev_set_uclass_priv(dev, ptr);
+		else
+			dev_set_parent_priv(dev, ptr);
+		ptr += ALIGN(size, DM_COMPACT_ALIGN);
+	}
+	dev_or_flags(dev, DM_FLAG_COMPACT_PRIV);
+
+	return 0;
+}
+
 /**
  * device_alloc_priv() - Allocate priv/plat data required by the device
  *
@@ -349,10 +528,17 @@ static int device_alloc_priv(struct udevice *dev)
 	const struct driver *drv;
 	void *ptr;
 	int size;
+	int ret;
 
 	drv = dev->driver;
 	assert(drv);
 
+	if (CONFIG_IS_ENABLED(DM_COMPACT_ALLOC)) {
+		ret = device_alloc_priv_compact(dev);
+		if (ret != -ENOTSUPP)
+			return ret;
+	}
+
 	/* Allocate private data if requested and not reentered */
 	if (drv->priv_auto && !dev_get_priv(dev)) {
 		ptr = alloc_priv(drv->priv_auto, drv->flags);
@@ -495,6 +681,7 @@ int device_probe(struct udevice *dev)
 
 	drv = dev->driver;
 	assert(drv);
+	bootstage_span_begin(drv->name);
 
 	ret = device_of_to_plat(dev);
 	if (ret)
@@ -512,8 +699,10 @@ int device_probe(struct udevice *dev)
 		 * (e.g. PCI bridge devices). Test the flags again
 		 * so that we don't mess up the device.
 		 */
-		if (dev_get_flags(dev) & DM_FLAG_ACTIVATED)
+		if (dev_get_flags(dev) & DM_FLAG_ACTIVATED) {
+			bootstage_span_end();
 			return 0;
+		}
 	}
 
 	dev_or_flags(dev, DM_FLAG_ACTIVATED);
@@ -600,6 +789,7 @@ int device_probe(struct udevice *dev)
 	ret = device_notify(dev, EVT_DM_POST_PROBE);
 	if (ret)
 		goto fail_event;
+	bootstage_span_end();
 
 	return 0;
 fail_event:
@@ -612,6 +802,7 @@ fail:
 	dev_bic_flags(dev, DM_FLAG_ACTIVATED);
 
 	device_free(dev);
+	bootstage_span_end();
 
 	return ret;
 }
@@ -897,6 +1088,7 @@ static struct udevice *_device_find_global_by_ofnode(struct udevice *parent,
 
 int device_find_global_by_ofnode(ofnode ofnode, struct udevice **devp)
 {
+	dm_lazy_bind_node(ofnode);
 	*devp = _device_find_global_by_ofnode(gd->dm_root, ofnode);
 
 	return *devp ? 0 : -ENOENT;
@@ -906,6 +1098,7 @@ int device_get_global_by_ofnode(ofnode ofnode, struct udevice **devp)
 {
 	struct udevice *dev;
 
+	dm_lazy_bind_node(ofnode);
 	dev = _device_find_global_by_ofnode(gd->dm_root, ofnode);
 	return device_get_device_tail(dev, dev ? 0 : -ENOENT, devp);
 }
@@ -296,6 +296,8 @@ void dm_dump_mem(struct dm_stats *stats)
 	printf("Memory: device %x:%x, device names %x, uclass %x:%x\n",
 	       stats->dev_count, stats->dev_size, stats->dev_name_size,
 	       stats->uc_count, stats->uc_size);
+	printf("Device blocks: %x, compact devices %x\n", stats->alloc_count,
+	       stats->compact_count);
 	printf("\n");
 	printf("%-15s  %5s  %5s  %5s  %5s  %5s\n", "Attached type", "Count",
 	       "Size", "Cur", "Tags", "Save");
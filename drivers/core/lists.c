@@ -288,4 +288,39 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 
 	return result;
 }
+
+int lists_match_fdt(ofnode node, bool pre_reloc_only, struct driver **drvp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id;
+	const char *compat_list, *compat;
+	struct driver *entry;
+	int compat_length, i;
+
+	compat_list = ofnode_get_property(node, "compatible", &compat_length);
+	if (!compat_list)
+		return compat_length == -FDT_ERR_NOTFOUND ? -ENOENT :
+			compat_length;
+
+	for (i = 0; i < compat_length; i += strlen(compat) + 1) {
+		compat = compat_list + i;
+		for (entry = driver; entry != driver + n_ents; entry++) {
+			if (!driver_check_compatible(entry->of_match, &id,
+						     compat))
+				break;
+		}
+		if (entry == driver + n_ents)
+			continue;
+
+		if (pre_reloc_only && !ofnode_pre_reloc(node) &&
+		    !(entry->flags & DM_FLAG_PRE_RELOC))
+			return -EPERM;
+		*drvp = entry;
+
+		return 0;
+	}
+
+	return -ENOENT;
+}
 #endif
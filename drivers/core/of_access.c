@@ -127,11 +127,15 @@ struct property *of_find_property(const struct device_node *np,
 				  const char *name, int *lenp)
 {
 	struct property *pp;
+	u32 hash;
 
 	if (!np)
 		return NULL;
 
+	hash = of_prop_hash(name);
 	for (pp = np->properties; pp; pp = pp->next) {
+		if (pp->hash && pp->hash != hash)
+			continue;
 		if (strcmp(pp->name, name) == 0) {
 			if (lenp)
 				*lenp = pp->length;
@@ -968,12 +972,15 @@ int of_write_prop(struct device_node *np, const char *propname, int len,
 	struct property *pp;
 	struct property *pp_last = NULL;
 	struct property *new;
+	u32 hash;
 
 	if (!np)
 		return -EINVAL;
 
+	hash = of_prop_hash(propname);
 	for (pp = np->properties; pp; pp = pp->next) {
-		if (strcmp(pp->name, propname) == 0) {
+		if ((!pp->hash || pp->hash == hash) &&
+		    strcmp(pp->name, propname) == 0) {
 			/* Property exists -> change value */
 			pp->value = (void *)value;
 			pp->length = len;
@@ -995,6 +1002,7 @@ int of_write_prop(struct device_node *np, const char *propname, int len,
 
 	new->value = (void *)value;
 	new->length = len;
+	new->hash = hash;
 	new->next = NULL;
 
 	if (pp_last)
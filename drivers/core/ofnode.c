@@ -743,15 +743,146 @@ int ofnode_get_path(ofnode node, char *buf, int buflen)
 	}
 }
 
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+/* Larger phandles are not cached, to bound the size of the table */
+#define OF_PHANDLES_MAX		0x10000
+
+/**
+ * ofnode_phandles_tree() - get the control tree the phandle table is for
+ *
+ * Return: root of the live tree or the control FDT
+ */
+static const void *ofnode_phandles_tree(void)
+{
+	return of_live_active() ? (const void *)gd_of_root() : gd->fdt_blob;
+}
+
+/**
+ * ofnode_phandle_of() - read the phandle of a node of the control tree
+ *
+ * @node: Node to check
+ * Return: phandle, or 0 if none
+ */
+static uint ofnode_phandle_of(ofnode node)
+{
+	if (of_live_active())
+		return ofnode_to_np(node)->phandle;
+
+	return fdt_get_phandle(gd->fdt_blob, ofnode_to_offset(node));
+}
+
+/**
+ * ofnode_phandles_next() - get the next node of the control tree
+ *
+ * @node: Current node, or ofnode_null() to start with the root
+ * Return: next node in depth-first order, or ofnode_null() at the end
+ */
+static ofnode ofnode_phandles_next(ofnode node)
+{
+	int offset;
+
+	if (of_live_active())
+		return np_to_ofnode(of_find_all_nodes(ofnode_valid(node) ?
+					(struct device_node *)ofnode_to_np(node) :
+					NULL));
+
+	offset = ofnode_valid(node) ? ofnode_to_offset(node) : -1;
+	offset = fdt_next_node(gd->fdt_blob, offset, NULL);
+
+	return offset < 0 ? ofnode_null() : offset_to_ofnode(offset);
+}
+
+/**
+ * ofnode_phandles_build() - build the phandle table of the control tree
+ *
+ * All nodes are walked once to find the highest phandle and once more to
+ * fill in the table. On error the table is left empty.
+ */
+static void ofnode_phandles_build(void)
+{
+	ofnode *table;
+	uint count = 0;
+	ofnode node;
+
+	free(gd->of_phandles);
+	gd->of_phandles = NULL;
+	gd->of_phandles_count = 0;
+	gd->of_phandles_tree = ofnode_phandles_tree();
+
+	for (node = ofnode_phandles_next(ofnode_null()); ofnode_valid(node);
+	     node = ofnode_phandles_next(node)) {
+		uint phandle = ofnode_phandle_of(node);
+
+		if (phandle < OF_PHANDLES_MAX && phandle >= count)
+			count = phandle + 1;
+	}
+	if (!count)
+		return;
+
+	table = malloc(count * sizeof(*table));
+	if (!table)
+		return;
+	for (uint i = 0; i < count; i++)
+		table[i] = ofnode_null();
+
+	for (node = ofnode_phandles_next(ofnode_null()); ofnode_valid(node);
+	     node = ofnode_phandles_next(node)) {
+		uint phandle = ofnode_phandle_of(node);
+
+		if (phandle && phandle < count)
+			table[phandle] = node;
+	}
+	gd->of_phandles = table;
+	gd->of_phandles_count = count;
+}
+
+/**
+ * ofnode_phandle_lookup() - look up a phandle in the phandle table
+ *
+ * The table is built on first use and again when the control tree moved.
+ * An entry which does not match the tree any more, because nodes were
+ * added or removed, causes a rebuild.
+ *
+ * @phandle: phandle to look up
+ * Return: node, or ofnode_null() if the phandle is not in the table
+ */
+static ofnode ofnode_phandle_lookup(uint phandle)
+{
+	ofnode node;
+
+	if (gd->of_phandles_tree != ofnode_phandles_tree())
+		ofnode_phandles_build();
+	if (phandle >= gd->of_phandles_count)
+		return ofnode_null();
+
+	node = gd->of_phandles[phandle];
+	if (ofnode_valid(node) && ofnode_phandle_of(node) != phandle) {
+		ofnode_phandles_build();
+		if (phandle >= gd->of_phandles_count)
+			return ofnode_null();
+		node = gd->of_phandles[phandle];
+	}
+
+	return node;
+}
+#endif
+
 ofnode ofnode_get_by_phandle(uint phandle)
 {
 	ofnode node;
 
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+	if (phandle) {
+		node = ofnode_phandle_lookup(phandle);
+		if (ofnode_valid(node))
+			return node;
+	}
+#endif
 	if (of_live_active())
 		node = np_to_ofnode(of_find_node_by_phandle(NULL, phandle));
 	else
-		node.of_offset = fdt_node_offset_by_phandle(gd->fdt_blob,
-							    phandle);
+		node.of_offset = fdtdec_node_offset_by_phandle(gd->fdt_blob,
+							       phandle);
 
 	return node;
 }
@@ -764,8 +895,8 @@ ofnode oftree_get_by_phandle(oftree tree, uint phandle)
 		node = np_to_ofnode(of_find_node_by_phandle(tree.np, phandle));
 	else
 		node = ofnode_from_tree_offset(tree,
-			fdt_node_offset_by_phandle(oftree_lookup_fdt(tree),
-						   phandle));
+			fdtdec_node_offset_by_phandle(oftree_lookup_fdt(tree),
+						      phandle));
 
 	return node;
 }
@@ -1087,7 +1218,7 @@ ofnode ofnode_path(const char *path)
 	if (of_live_active())
 		return np_to_ofnode(of_find_node_by_path(path));
 	else
-		return offset_to_ofnode(fdt_path_offset(gd->fdt_blob, path));
+		return offset_to_ofnode(fdtdec_path_offset(gd->fdt_blob, path));
 }
 
 ofnode oftree_root(oftree tree)
@@ -1107,7 +1238,7 @@ ofnode oftree_path(oftree tree, const char *path)
 	} else if (*path != '/' && tree.fdt != gd->fdt_blob) {
 		return ofnode_null();  /* Aliases only on control FDT */
 	} else {
-		int offset = fdt_path_offset(tree.fdt, path);
+		int offset = fdtdec_path_offset(tree.fdt, path);
 
 		return ofnode_from_tree_offset(tree, offset);
 	}
@@ -8,12 +8,14 @@
 
 #define LOG_CATEGORY UCLASS_ROOT
 
+#include <bootstage.h>
 #include <errno.h>
 #include <fdtdec.h>
 #include <log.h>
 #include <malloc.h>
 #include <asm-generic/sections.h>
 #include <asm/global_data.h>
+#include <linux/bitops.h>
 #include <linux/libfdt.h>
 #include <dm/acpi.h>
 #include <dm/device.h>
@@ -99,6 +101,20 @@ int dm_init(bool of_live)
 		dm_warn("Virtual root driver already exists!\n");
 		return -EINVAL;
 	}
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+	/*
+	 * Tables allocated before relocation are left behind. Without a
+	 * hash table the lookups fall back to walking the uclass.
+	 */
+	gd->dm_node_hash = calloc(1 << DM_NODE_HASH_BITS,
+				  sizeof(*gd->dm_node_hash));
+	gd->of_phandles = NULL;
+	gd->of_phandles_count = 0;
+	gd->of_phandles_tree = NULL;
+#endif
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+	gd->dm_lazy = NULL;
+#endif
 	if (CONFIG_IS_ENABLED(OF_PLATDATA_INST)) {
 		gd->uclass_root = &uclass_head;
 	} else {
@@ -117,8 +133,10 @@ int dm_init(bool of_live)
 					  &DM_ROOT_NON_CONST);
 		if (ret)
 			return ret;
-		if (CONFIG_IS_ENABLED(OF_CONTROL))
+		if (CONFIG_IS_ENABLED(OF_CONTROL)) {
 			dev_set_ofnode(DM_ROOT_NON_CONST, ofnode_root());
+			device_node_hash_add(DM_ROOT_NON_CONST);
+		}
 		ret = device_probe(DM_ROOT_NON_CONST);
 		if (ret)
 			return ret;
@@ -136,6 +154,14 @@ int dm_uninit(void)
 	device_remove(dm_root(), DM_REMOVE_NORMAL);
 	device_unbind(dm_root());
 	gd->dm_root = NULL;
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+	free(gd->dm_node_hash);
+	free(gd->of_phandles);
+#endif
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+	free(gd->dm_lazy);
+	gd->dm_lazy = NULL;
+#endif
 
 	return 0;
 }
@@ -181,6 +207,258 @@ int dm_scan_plat(bool pre_reloc_only)
 }
 
 #if CONFIG_IS_ENABLED(OF_REAL)
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+/* Flags for struct dm_lazy_node */
+enum {
+	DM_LAZY_PRE_RELOC	= 1 << 0,	/* recorded before relocation */
+	DM_LAZY_MATCHED		= 1 << 1,	/* @drv has been looked up */
+	DM_LAZY_BUS		= 1 << 2,	/* may have child devices */
+	DM_LAZY_DONE		= 1 << 3,	/* bound, or nothing to bind */
+};
+
+/**
+ * struct dm_lazy_node - a device tree node which is not bound yet
+ *
+ * @parent: Device which scanned the node
+ * @node: Node to bind
+ * @drv: Driver matching @node, valid with DM_LAZY_MATCHED
+ * @flags: DM_LAZY_... flags
+ */
+struct dm_lazy_node {
+	struct udevice *parent;
+	ofnode node;
+	struct driver *drv;
+	uint flags;
+};
+
+/**
+ * struct dm_lazy_index - nodes recorded by dm_scan_fdt_node()
+ *
+ * Entries are only appended, in the order the scan found them, so that
+ * devices of a uclass are bound in the same order as a full scan would.
+ *
+ * @count: Number of entries
+ * @size: Number of entries allocated
+ * @depth: Nesting level of binding on demand
+ * @probe: A device bound on demand needs to be probed after binding
+ * @nodes: Entries
+ */
+struct dm_lazy_index {
+	uint count;
+	uint size;
+	uint depth;
+	bool probe;
+	struct dm_lazy_node nodes[];
+};
+
+static int dm_lazy_record(struct udevice *parent, ofnode node,
+			  bool pre_reloc_only)
+{
+	struct dm_lazy_index *idx = gd->dm_lazy;
+	struct dm_lazy_node *ent;
+
+	if (!idx || idx->count == idx->size) {
+		uint size = idx ? idx->size * 2 : 32;
+		struct dm_lazy_index *new;
+
+		new = malloc(sizeof(*new) + size * sizeof(new->nodes[0]));
+		if (!new)
+			return -ENOMEM;
+		if (idx) {
+			memcpy(new, idx, sizeof(*idx) +
+			       idx->count * sizeof(idx->nodes[0]));
+			free(idx);
+		} else {
+			memset(new, '\0', sizeof(*new));
+		}
+		new->size = size;
+		gd->dm_lazy = new;
+		idx = new;
+	}
+
+	ent = &idx->nodes[idx->count++];
+	ent->parent = parent;
+	ent->node = node;
+	ent->drv = NULL;
+	ent->flags = pre_reloc_only ? DM_LAZY_PRE_RELOC : 0;
+
+	return 0;
+}
+
+/**
+ * dm_lazy_match() - look up the driver of a recorded node
+ *
+ * @ent: Entry to update
+ */
+static void dm_lazy_match(struct dm_lazy_node *ent)
+{
+	ofnode subnode;
+
+	ent->flags |= DM_LAZY_MATCHED;
+	if (lists_match_fdt(ent->node, ent->flags & DM_LAZY_PRE_RELOC,
+			    &ent->drv)) {
+		ent->flags |= DM_LAZY_DONE;
+		return;
+	}
+
+	ofnode_for_each_subnode(subnode, ent->node) {
+		if (ofnode_has_property(subnode, "compatible")) {
+			ent->flags |= DM_LAZY_BUS;
+			break;
+		}
+	}
+}
+
+/**
+ * dm_lazy_bind_entry() - bind a recorded node
+ *
+ * The entry is copied first, since binding may record more nodes and so
+ * move the index.
+ *
+ * @i: Index of the entry
+ * Return: 1 if a device was bound, 0 if not
+ */
+static int dm_lazy_bind_entry(uint i)
+{
+	struct dm_lazy_node ent = gd->dm_lazy->nodes[i];
+	struct udevice *dev;
+	int ret;
+
+	gd->dm_lazy->nodes[i].flags |= DM_LAZY_DONE;
+	ret = lists_bind_fdt(ent.parent, ent.node, &dev, NULL,
+			     ent.flags & DM_LAZY_PRE_RELOC);
+	if (ret) {
+		dm_warn("%s: ret=%d\n", ofnode_get_name(ent.node), ret);
+		return 0;
+	}
+	if (!dev)
+		return 0;
+	if (dev_get_flags(dev) & DM_FLAG_PROBE_AFTER_BIND)
+		gd->dm_lazy->probe = true;
+
+	return 1;
+}
+
+/**
+ * dm_lazy_enter() - start binding on demand
+ *
+ * The outermost call starts the bootstage accumulator.
+ */
+static void dm_lazy_enter(void)
+{
+	if (!gd->dm_lazy->depth++)
+		bootstage_start(BOOTSTAGE_ID_ACCUM_DM_LAZY, "dm_lazy");
+}
+
+/**
+ * dm_lazy_leave() - finish binding on demand
+ *
+ * The outermost call stops the bootstage accumulator. Since dm_autoprobe()
+ * has already run for the devices bound by the scan, it also probes the
+ * devices bound on demand that asked for it.
+ */
+static void dm_lazy_leave(void)
+{
+	struct dm_lazy_index *idx = gd->dm_lazy;
+
+	if (--idx->depth)
+		return;
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DM_LAZY);
+	if (idx->probe) {
+		idx->probe = false;
+		dm_autoprobe();
+	}
+}
+
+void dm_lazy_bind_uclass(struct uclass *uc)
+{
+	enum uclass_id id = uc->uc_drv->id;
+	uint i;
+
+	if (!gd->dm_lazy || uc->lazy_busy ||
+	    uc->lazy_pos == gd->dm_lazy->count)
+		return;
+
+	/* Binding a device of this uclass looks it up again */
+	uc->lazy_busy = true;
+	dm_lazy_enter();
+	for (i = uc->lazy_pos; i < gd->dm_lazy->count; i++) {
+		struct dm_lazy_node *ent = &gd->dm_lazy->nodes[i];
+
+		uc->lazy_pos = i + 1;
+		if (ent->flags & DM_LAZY_DONE)
+			continue;
+		if (!(ent->flags & DM_LAZY_MATCHED))
+			dm_lazy_match(ent);
+		if (ent->flags & DM_LAZY_DONE)
+			continue;
+		if (ent->drv->id == id || (ent->flags & DM_LAZY_BUS))
+			dm_lazy_bind_entry(i);
+	}
+	uc->lazy_busy = false;
+	dm_lazy_leave();
+}
+
+void dm_lazy_bind_node(ofnode node)
+{
+	uint i;
+
+	if (!gd->dm_lazy)
+		return;
+
+	for (i = 0; i < gd->dm_lazy->count; i++) {
+		struct dm_lazy_node *ent = &gd->dm_lazy->nodes[i];
+
+		if (!(ent->flags & DM_LAZY_DONE) &&
+		    ofnode_equal(ent->node, node)) {
+			dm_lazy_enter();
+			dm_lazy_bind_entry(i);
+			dm_lazy_leave();
+			break;
+		}
+	}
+}
+
+void dm_lazy_unbind(struct udevice *parent)
+{
+	uint i;
+
+	if (!gd->dm_lazy)
+		return;
+
+	for (i = 0; i < gd->dm_lazy->count; i++) {
+		struct dm_lazy_node *ent = &gd->dm_lazy->nodes[i];
+
+		if (ent->parent == parent)
+			ent->flags |= DM_LAZY_DONE;
+	}
+}
+
+int dm_lazy_bind_all(void)
+{
+	int count = 0;
+	uint i;
+
+	if (!gd->dm_lazy)
+		return 0;
+
+	dm_lazy_enter();
+	for (i = 0; i < gd->dm_lazy->count; i++) {
+		if (!(gd->dm_lazy->nodes[i].flags & DM_LAZY_DONE))
+			count += dm_lazy_bind_entry(i);
+	}
+	dm_lazy_leave();
+
+	return count;
+}
+#else
+static int dm_lazy_record(struct udevice *parent, ofnode node,
+			  bool pre_reloc_only)
+{
+	return -ENOSYS;
+}
+#endif
+
 /**
  * dm_scan_fdt_node() - Scan the device tree and bind drivers for a node
  *
@@ -211,6 +489,10 @@ static int dm_scan_fdt_node(struct udevice *parent, ofnode parent_node,
 			pr_debug("   - ignoring disabled device\n");
 			continue;
 		}
+		/* Binding happens when something looks the device up */
+		if (CONFIG_IS_ENABLED(DM_LAZY_BIND) &&
+		    !dm_lazy_record(parent, node, pre_reloc_only))
+			continue;
 		err = lists_bind_fdt(parent, node, NULL, NULL, pre_reloc_only);
 		if (err && !ret) {
 			ret = err;
@@ -396,12 +678,33 @@ void dm_get_stats(int *device_countp, int *uclass_countp)
 
 void dev_collect_stats(struct dm_stats *stats, const struct udevice *parent)
 {
+	static const enum dm_tag_t priv_tags[] = {
+		DM_TAG_PRIV, DM_TAG_UC_PRIV, DM_TAG_PARENT_PRIV
+	};
 	const struct udevice *dev;
+	u32 flags = dev_get_flags(parent);
 	int i;
 
 	stats->dev_count++;
 	stats->dev_size += sizeof(struct udevice);
 	stats->dev_name_size += strlen(parent->name) + 1;
+
+	/* The device itself, including any plat data in its block */
+	stats->alloc_count++;
+	stats->alloc_count += hweight32(flags & (DM_FLAG_ALLOC_PDATA |
+						 DM_FLAG_ALLOC_UCLASS_PDATA |
+						 DM_FLAG_ALLOC_PARENT_PDATA));
+	if (flags & DM_FLAG_COMPACT_PRIV) {
+		stats->alloc_count++;
+	} else {
+		for (i = 0; i < ARRAY_SIZE(priv_tags); i++) {
+			if (dev_get_attach_size(parent, priv_tags[i]) &&
+			    dev_get_attach_ptr(parent, priv_tags[i]))
+				stats->alloc_count++;
+		}
+	}
+	if (flags & (DM_FLAG_COMPACT_PDATA | DM_FLAG_COMPACT_PRIV))
+		stats->compact_count++;
 	for (i = 0; i < DM_TAG_ATTACH_COUNT; i++) {
 		int size = dev_get_attach_size(parent, i);
 
@@ -151,11 +151,17 @@ int uclass_get(enum uclass_id id, struct uclass **ucp)
 	*ucp = NULL;
 	uc = uclass_find(id);
 	if (!uc) {
+		int ret;
+
 		if (CONFIG_IS_ENABLED(OF_PLATDATA_INST))
 			return -ENOENT;
-		return uclass_add(id, ucp);
+		ret = uclass_add(id, ucp);
+		if (ret)
+			return ret;
+		uc = *ucp;
 	}
 	*ucp = uc;
+	dm_lazy_bind_uclass(uc);
 
 	return 0;
 }
@@ -404,6 +410,14 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 	if (ret)
 		return ret;
 
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+	if (gd->dm_node_hash) {
+		*devp = device_node_hash_find(id, node);
+		ret = *devp ? 0 : -ENODEV;
+		goto done;
+	}
+#endif
+
 	uclass_foreach_dev(dev, uc) {
 		log(LOGC_DM, LOGL_DEBUG_CONTENT, "      - checking %s\n",
 		    dev->name);
@@ -429,6 +443,15 @@ static int uclass_find_device_by_phandle_id(enum uclass_id id,
 	struct uclass *uc;
 	int ret;
 
+	if (CONFIG_IS_ENABLED(DM_OFNODE_HASH)) {
+		ofnode node = ofnode_get_by_phandle(find_phandle);
+
+		/* Devices bound from other trees still need the walk */
+		if (ofnode_valid(node) &&
+		    !uclass_find_device_by_ofnode(id, node, devp))
+			return 0;
+	}
+
 	ret = uclass_get(id, &uc);
 	if (ret)
 		return ret;
@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Hashing with the Crypto Engine of the Allwinner H616
+ *
+ * The engine runs tasks described in memory. A task reads its input from
+ * a scatter list and hashes all of it in one go, but it does not pad the
+ * message, so the last block and the padding are put in a separate entry.
+ * The whole message is hashed by a single task, which the CPU polls for.
+ *
+ * Algorithms the engine does not handle, and input which is not word
+ * aligned, are passed on to the software implementations.
+ */
+
+#define LOG_CATEGORY UCLASS_HASH
+
+#include <clk.h>
+#include <cpu_func.h>
+#include <dm.h>
+#include <hash.h>
+#include <hw_sha.h>
+#include <log.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <reset.h>
+#include <time.h>
+#include <watchdog.h>
+#include <asm/io.h>
+#include <asm/arch/clock.h>
+#include <u-boot/hash.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+#include <u-boot/sha512.h>
+#include <linux/bitops.h>
+#include <linux/kernel.h>
+
+#define CE_TDQ			0x00	/* task descriptor address */
+#define CE_ICR			0x08
+#define CE_ISR			0x0c
+#define CE_TLR			0x10
+#define CE_ESR			0x18
+
+#define CE_COMM_INT		BIT(31)
+#define CE_ALG_MD5		16
+#define CE_ALG_SHA1		17
+#define CE_ALG_SHA256		19
+#define CE_ALG_SHA384		20
+#define CE_ALG_SHA512		21
+
+#define CE_CLK_SRC_PERIPH0_2X	BIT(24)
+#define CE_CLK_SRC_MASK		GENMASK(26, 24)
+#define CE_CLK_DIV_M_MASK	GENMASK(3, 0)
+#define CE_CLK_DIV_M(m)		((m) - 1)
+
+/* the descriptors use one channel, and the engine limits the list size */
+#define CE_FLOW			0
+#define CE_MAX_SG		8
+
+/* the largest block, of SHA-512, and its internal state */
+#define CE_MAX_BLOCK		128
+#define CE_MAX_STATE		64
+
+struct ce_sginfo {
+	u32 addr;
+	u32 len;		/* in words */
+};
+
+struct ce_task {
+	u32 t_id;
+	u32 t_common_ctl;
+	u32 t_sym_ctl;
+	u32 t_asym_ctl;
+	u32 t_key;
+	u32 t_iv;
+	u32 t_ctr;
+	u32 t_dlen;		/* in bytes */
+	struct ce_sginfo t_src[CE_MAX_SG];
+	struct ce_sginfo t_dst[CE_MAX_SG];
+	u32 next;
+	u32 reserved[3];
+};
+
+/* Memory seen by the engine, each part in its own cache lines */
+struct sun8i_ce_dma {
+	struct ce_task task __aligned(ARCH_DMA_MINALIGN);
+	u8 pad[2 * CE_MAX_BLOCK] __aligned(ARCH_DMA_MINALIGN);
+	u8 state[CE_MAX_STATE] __aligned(ARCH_DMA_MINALIGN);
+};
+
+/**
+ * struct sun8i_ce_priv - private data for the Crypto Engine
+ *
+ * @base: Base address of the registers
+ * @dma: Task, padding and result, as read and written by the engine
+ */
+struct sun8i_ce_priv {
+	void __iomem *base;
+	struct sun8i_ce_dma *dma;
+};
+
+/**
+ * struct sun8i_ce_alg - an algorithm the engine can run
+ *
+ * @id: Algorithm ID for the task
+ * @block_size: Size of a block in bytes
+ * @len_size: Size of the message length in the padding
+ * @state_size: Size of the result written by the engine
+ * @len_le: true if the message length is little-endian (MD5)
+ */
+struct sun8i_ce_alg {
+	u8 id;
+	u8 block_size;
+	u8 len_size;
+	u8 state_size;
+	bool len_le;
+};
+
+static const struct sun8i_ce_alg sun8i_ce_algs[HASH_ALGO_NUM] = {
+	[HASH_ALGO_MD5]		= { CE_ALG_MD5, 64, 8, 16, true },
+	[HASH_ALGO_SHA1]	= { CE_ALG_SHA1, 64, 8, 20 },
+	[HASH_ALGO_SHA256]	= { CE_ALG_SHA256, 64, 8, 32 },
+	[HASH_ALGO_SHA384]	= { CE_ALG_SHA384, 128, 16, 64 },
+	[HASH_ALGO_SHA512]	= { CE_ALG_SHA512, 128, 16, 64 },
+};
+
+/* The engine takes the addresses in words, to reach beyond 4GiB */
+static u32 sun8i_ce_addr(const void *ptr)
+{
+	return (ulong)ptr >> 2;
+}
+
+static void sun8i_ce_flush(const void *ptr, ulong len)
+{
+	ulong start = rounddown((ulong)ptr, ARCH_DMA_MINALIGN);
+	ulong end = roundup((ulong)ptr + len, ARCH_DMA_MINALIGN);
+
+	flush_dcache_range(start, end);
+}
+
+/*
+ * Copy the partial last block of the message to @pad and add the padding,
+ * returning the resulting size in bytes (one or two blocks)
+ */
+static uint sun8i_ce_pad(const struct sun8i_ce_alg *alg, u8 *pad,
+			 const u8 *tail, uint tail_len, u64 len)
+{
+	uint size, i;
+	u64 bits = len << 3;
+
+	size = roundup(tail_len + 1 + alg->len_size, alg->block_size);
+	memcpy(pad, tail, tail_len);
+	memset(pad + tail_len, '\0', size - tail_len);
+	pad[tail_len] = 0x80;
+
+	for (i = 0; i < sizeof(bits); i++) {
+		u8 val = bits >> (8 * i);
+
+		if (alg->len_le)
+			pad[size - alg->len_size + i] = val;
+		else
+			pad[size - 1 - i] = val;
+	}
+
+	return size;
+}
+
+static int sun8i_ce_wait(struct sun8i_ce_priv *priv, uint len)
+{
+	ulong start = get_timer(0);
+	ulong timeout = 100 + (len >> 16);	/* at least 64MB/s */
+	u32 err;
+
+	while (!(readl(priv->base + CE_ISR) & BIT(CE_FLOW))) {
+		if (get_timer(start) > timeout) {
+			log_debug("task timed out\n");
+			return -ETIMEDOUT;
+		}
+		schedule();
+	}
+	writel(BIT(CE_FLOW), priv->base + CE_ISR);
+
+	err = readl(priv->base + CE_ESR) & 0xff;
+	if (err) {
+		log_debug("task failed, err=%x\n", err);
+		writel(err, priv->base + CE_ESR);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/* Hash the whole of @ibuf with one task, if the engine supports it */
+static int sun8i_ce_digest_hw(struct udevice *dev, enum HASH_ALGO algo,
+			      const void *ibuf, uint ilen, void *obuf)
+{
+	struct sun8i_ce_priv *priv = dev_get_priv(dev);
+	struct sun8i_ce_dma *dma = priv->dma;
+	struct ce_task *task = &dma->task;
+	const struct sun8i_ce_alg *alg;
+	uint body, pad_len, sg = 0;
+	int ret;
+
+	if (algo >= HASH_ALGO_NUM || !sun8i_ce_algs[algo].id)
+		return -EOPNOTSUPP;
+	if ((ulong)ibuf & 3)
+		return -EFAULT;
+	alg = &sun8i_ce_algs[algo];
+
+	body = rounddown(ilen, alg->block_size);
+	pad_len = sun8i_ce_pad(alg, dma->pad, ibuf + body, ilen - body, ilen);
+
+	memset(task, '\0', sizeof(*task));
+	task->t_id = CE_FLOW;
+	task->t_common_ctl = alg->id | CE_COMM_INT;
+	task->t_dlen = body + pad_len;
+	if (body) {
+		task->t_src[sg].addr = sun8i_ce_addr(ibuf);
+		task->t_src[sg++].len = body / 4;
+	}
+	task->t_src[sg].addr = sun8i_ce_addr(dma->pad);
+	task->t_src[sg].len = pad_len / 4;
+	task->t_dst[0].addr = sun8i_ce_addr(dma->state);
+	task->t_dst[0].len = alg->state_size / 4;
+
+	sun8i_ce_flush(ibuf, body);
+	sun8i_ce_flush(dma, sizeof(*dma));
+
+	writel(BIT(CE_FLOW), priv->base + CE_ISR);
+	writel(BIT(CE_FLOW), priv->base + CE_ICR);
+	writel(sun8i_ce_addr(task), priv->base + CE_TDQ);
+	writel(1 | (alg->id << 8), priv->base + CE_TLR);
+
+	ret = sun8i_ce_wait(priv, ilen);
+	writel(0, priv->base + CE_ICR);
+	if (ret)
+		return ret;
+
+	invalidate_dcache_range((ulong)dma->state,
+				(ulong)dma->state + sizeof(dma->state));
+	memcpy(obuf, dma->state, hash_algo_digest_size(algo));
+
+	return 0;
+}
+
+static int sun8i_ce_digest_wd(struct udevice *dev, enum HASH_ALGO algo,
+			      const void *ibuf, const uint32_t ilen,
+			      void *obuf, uint32_t chunk_sz)
+{
+	struct hash_algo *sw;
+	int ret;
+
+	ret = sun8i_ce_digest_hw(dev, algo, ibuf, ilen, obuf);
+	if (ret != -EOPNOTSUPP && ret != -EFAULT)
+		return ret;
+
+	ret = hash_lookup_algo(hash_algo_name(algo), &sw);
+	if (ret)
+		return ret;
+	sw->hash_func_ws(ibuf, ilen, obuf, chunk_sz);
+
+	return 0;
+}
+
+static int sun8i_ce_digest(struct udevice *dev, enum HASH_ALGO algo,
+			   const void *ibuf, const uint32_t ilen, void *obuf)
+{
+	return sun8i_ce_digest_wd(dev, algo, ibuf, ilen, obuf, ilen);
+}
+
+#if CONFIG_IS_ENABLED(SHA_HW_ACCEL)
+/*
+ * These are used by the hash API for the SHA algorithms. There is no
+ * fallback through it, as that would lead back here.
+ */
+static int sun8i_ce_hw_sha(enum HASH_ALGO algo, const uchar *in, uint len,
+			   uchar *out)
+{
+	struct udevice *dev;
+	int ret;
+
+	ret = uclass_get_device_by_driver(UCLASS_HASH,
+					  DM_DRIVER_GET(sun8i_ce), &dev);
+	if (ret)
+		return ret;
+
+	return sun8i_ce_digest_hw(dev, algo, in, len, out);
+}
+
+#if CONFIG_IS_ENABLED(SHA1)
+void hw_sha1(const uchar *in_addr, uint buflen, uchar *out_addr,
+	     uint chunk_size)
+{
+	if (sun8i_ce_hw_sha(HASH_ALGO_SHA1, in_addr, buflen, out_addr))
+		sha1_csum_wd(in_addr, buflen, out_addr, chunk_size);
+}
+#endif
+
+#if CONFIG_IS_ENABLED(SHA256)
+void hw_sha256(const uchar *in_addr, uint buflen, uchar *out_addr,
+	       uint chunk_size)
+{
+	if (sun8i_ce_hw_sha(HASH_ALGO_SHA256, in_addr, buflen, out_addr))
+		sha256_csum_wd(in_addr, buflen, out_addr, chunk_size);
+}
+#endif
+
+#if CONFIG_IS_ENABLED(SHA512_HW_ACCEL)
+void hw_sha384(const uchar *in_addr, uint buflen, uchar *out_addr,
+	       uint chunk_size)
+{
+	if (sun8i_ce_hw_sha(HASH_ALGO_SHA384, in_addr, buflen, out_addr))
+		sha384_csum_wd(in_addr, buflen, out_addr, chunk_size);
+}
+
+void hw_sha512(const uchar *in_addr, uint buflen, uchar *out_addr,
+	       uint chunk_size)
+{
+	if (sun8i_ce_hw_sha(HASH_ALGO_SHA512, in_addr, buflen, out_addr))
+		sha512_csum_wd(in_addr, buflen, out_addr, chunk_size);
+}
+#endif
+#endif /* SHA_HW_ACCEL */
+
+static int sun8i_ce_probe(struct udevice *dev)
+{
+	struct sunxi_ccm_reg *const ccm =
+		(struct sunxi_ccm_reg *)SUNXI_CCM_BASE;
+	static const char *const clk_names[] = { "bus", "mod", "ram" };
+	struct sun8i_ce_priv *priv = dev_get_priv(dev);
+	struct reset_ctl_bulk resets;
+	struct clk clk;
+	int ret, i;
+
+	priv->base = dev_read_addr_ptr(dev);
+	if (!priv->base)
+		return -EINVAL;
+
+	priv->dma = memalign(ARCH_DMA_MINALIGN, sizeof(*priv->dma));
+	if (!priv->dma)
+		return -ENOMEM;
+
+	/* the clock driver only has the gates, run from PLL_PERIPH0 / 2 */
+	clrsetbits_le32(&ccm->ce_clk_cfg, CE_CLK_SRC_MASK | CE_CLK_DIV_M_MASK,
+			CE_CLK_SRC_PERIPH0_2X | CE_CLK_DIV_M(4));
+
+	/* the "trng" clock is not needed for hashing */
+	for (i = 0; i < ARRAY_SIZE(clk_names); i++) {
+		ret = clk_get_by_name(dev, clk_names[i], &clk);
+		if (!ret)
+			ret = clk_enable(&clk);
+		if (ret) {
+			log_debug("cannot enable clock %s (err=%d)\n",
+				  clk_names[i], ret);
+			return ret;
+		}
+	}
+
+	ret = reset_get_bulk(dev, &resets);
+	if (!ret)
+		ret = reset_deassert_bulk(&resets);
+	if (ret) {
+		log_debug("cannot deassert reset (err=%d)\n", ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+static const struct hash_ops sun8i_ce_ops = {
+	.hash_digest	= sun8i_ce_digest,
+	.hash_digest_wd	= sun8i_ce_digest_wd,
+};
+
+static const struct udevice_id sun8i_ce_ids[] = {
+	{ .compatible = "allwinner,sun50i-h616-crypto" },
+	{ }
+};
+
+U_BOOT_DRIVER(sun8i_ce) = {
+	.name		= "sun8i_ce",
+	.id		= UCLASS_HASH,
+	.of_match	= sun8i_ce_ids,
+	.ops		= &sun8i_ce_ops,
+	.probe		= sun8i_ce_probe,
+	.priv_auto	= sizeof(struct sun8i_ce_priv),
+};
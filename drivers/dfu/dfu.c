@@ -14,6 +14,7 @@
 #include <fat.h>
 #include <dfu.h>
 #include <hash.h>
+#include <hexdump.h>
 #include <linux/list.h>
 #include <linux/compiler.h>
 #include <linux/printk.h>
@@ -246,16 +247,41 @@ static char *dfu_get_hash_algo(void)
 	char *s;
 
 	s = env_get("dfu_hash_algo");
-	if (!s)
-		return NULL;
-
-	if (!strcmp(s, "crc32")) {
+	if (s)
 		debug("%s: DFU hash method: %s\n", __func__, s);
-		return s;
-	}
 
-	pr_err("DFU hash method: %s not supported!\n", s);
-	return NULL;
+	return s;
+}
+
+/**
+ * dfu_hash_done() - Finish the hash of the current transfer
+ *
+ * @dfu: DFU entity
+ * @show: Print the hash and store it in ${dfu_hash}
+ */
+static void dfu_hash_done(struct dfu_entity *dfu, bool show)
+{
+	u8 digest[HASH_MAX_DIGEST_SIZE];
+	char str[HASH_MAX_DIGEST_SIZE * 2 + 1];
+	int ret;
+
+	if (!dfu->hash_ctx)
+		return;
+
+	ret = dfu_hash_algo->hash_finish(dfu_hash_algo, dfu->hash_ctx, digest,
+					 sizeof(digest));
+	dfu->hash_ctx = NULL;
+	if (ret || !show)
+		return;
+
+	/* crc32 has always been shown as a number */
+	if (dfu_hash_algo->digest_size == sizeof(u32))
+		sprintf(str, "0x%08x", *(u32 *)digest);
+	else
+		*bin2hex(str, digest, dfu_hash_algo->digest_size) = '\0';
+
+	printf("\nDFU complete %s: %s\n", dfu_hash_algo->name, str);
+	env_set("dfu_hash", str);
 }
 
 static int dfu_write_buffer_drain(struct dfu_entity *dfu)
@@ -268,10 +294,6 @@ static int dfu_write_buffer_drain(struct dfu_entity *dfu)
 	if (w_size == 0)
 		return 0;
 
-	if (dfu_hash_algo)
-		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
-					   dfu->i_buf_start, w_size, 0);
-
 	ret = dfu->write_medium(dfu, dfu->offset, dfu->i_buf_start, &w_size);
 	if (ret)
 		debug("%s: Write error!\n", __func__);
@@ -290,7 +312,7 @@ static int dfu_write_buffer_drain(struct dfu_entity *dfu)
 void dfu_transaction_cleanup(struct dfu_entity *dfu)
 {
 	/* clear everything */
-	dfu->crc = 0;
+	dfu_hash_done(dfu, false);
 	dfu->offset = 0;
 	dfu->i_blk_seq_num = 0;
 	dfu->i_buf_start = dfu_get_buf(dfu);
@@ -324,6 +346,13 @@ int dfu_transaction_initiate(struct dfu_entity *dfu, bool read)
 		debug("%s: %s %lld [B]\n", __func__, dfu->name, dfu->r_left);
 	}
 
+	/* the data is hashed as it passes through dfu_buf */
+	if (dfu_hash_algo &&
+	    dfu_hash_algo->hash_init(dfu_hash_algo, &dfu->hash_ctx)) {
+		pr_err("DFU: cannot start %s hash\n", dfu_hash_algo->name);
+		dfu->hash_ctx = NULL;
+	}
+
 	dfu->inited = 1;
 	dfu_initiated_callback(dfu);
 
@@ -341,9 +370,7 @@ int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	if (dfu->flush_medium)
 		ret = dfu->flush_medium(dfu);
 
-	if (dfu_hash_algo)
-		printf("\nDFU complete %s: 0x%08x\n", dfu_hash_algo->name,
-		       dfu->crc);
+	dfu_hash_done(dfu, true);
 
 	dfu_flush_callback(dfu);
 
@@ -408,6 +435,9 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	}
 
 	memcpy(dfu->i_buf, buf, size);
+	if (dfu->hash_ctx)
+		dfu_hash_algo->hash_update(dfu_hash_algo, dfu->hash_ctx,
+					   dfu->i_buf, size, 0);
 	dfu->i_buf += size;
 
 	/* if end or if buffer full flush */
@@ -435,9 +465,9 @@ static int dfu_read_buffer_fill(struct dfu_entity *dfu, void *buf, int size)
 		/* consume */
 		if (chunk > 0) {
 			memcpy(buf, dfu->i_buf, chunk);
-			if (dfu_hash_algo)
+			if (dfu->hash_ctx)
 				dfu_hash_algo->hash_update(dfu_hash_algo,
-							   &dfu->crc, buf,
+							   dfu->hash_ctx, buf,
 							   chunk, 0);
 
 			dfu->i_buf += chunk;
@@ -503,9 +533,7 @@ int dfu_read(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	}
 
 	if (ret < size) {
-		if (dfu_hash_algo)
-			debug("%s: %s %s: 0x%x\n", __func__, dfu->name,
-			      dfu_hash_algo->name, dfu->crc);
+		dfu_hash_done(dfu, true);
 		puts("\nUPLOAD ... done\nCtrl+C to exit ...\n");
 
 		dfu_transaction_cleanup(dfu);
@@ -260,6 +260,25 @@ int dma_memcpy(void *dst, void *src, size_t len)
 	return ret;
 }
 
+int dma_memcpy_offload(void *dst, const void *src, size_t len)
+{
+	ulong d = (ulong)dst, s = (ulong)src;
+	int ret;
+
+	if (!CONFIG_DMA_MEMCPY_THRESHOLD || len < CONFIG_DMA_MEMCPY_THRESHOLD)
+		return -E2BIG;
+	if (d < s + len && s < d + len)
+		return -E2BIG;
+
+	ret = dma_memcpy(dst, (void *)src, len);
+	if (ret < 0) {
+		log_debug("DMA copy failed (err=%d)\n", ret);
+		return ret;
+	}
+
+	return 0;
+}
+
 UCLASS_DRIVER(dma) = {
 	.id		= UCLASS_DMA,
 	.name		= "dma",
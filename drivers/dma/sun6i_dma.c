@@ -0,0 +1,515 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Driver for the DMA controller of the Allwinner A31 and later SoCs
+ *
+ * Based on linux/drivers/dma/sun6i-dma.c:
+ *	Copyright (C) 2013-2014 Allwinner Tech Co., Ltd
+ *	Author: Sugar <shuge@allwinnertech.com>
+ *	Copyright (C) 2014 Maxime Ripard
+ *
+ * Each transfer is a chain of descriptors (LLIs) in memory, which the channel
+ * reads as it goes. Completion is found by polling the queue-end interrupt
+ * status of the channel, since U-Boot does not use interrupts.
+ */
+
+#define LOG_CATEGORY UCLASS_DMA
+
+#include <clk.h>
+#include <dm.h>
+#include <dma-uclass.h>
+#include <log.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <reset.h>
+#include <wait_bit.h>
+#include <asm/cache.h>
+#include <asm/io.h>
+#include <asm/arch/dma_sun6i.h>
+#include <linux/bitops.h>
+#include <linux/dma-mapping.h>
+#include <linux/kernel.h>
+#include <linux/log2.h>
+#include <linux/sizes.h>
+
+/* Global registers */
+#define DMA_IRQ_EN(x)			((x) * 0x04)
+#define DMA_IRQ_STAT(x)			((x) * 0x04 + 0x10)
+#define  DMA_IRQ_QUEUE(ch)		BIT(((ch) & 7) * 4 + 2)
+#define  DMA_IRQ_CHAN_NR		8
+#define DMA_GATE			0x28
+#define  DMA_GATE_AUTO			BIT(2)
+
+/* Channel registers */
+#define DMA_CHAN_BASE(ch)		(0x100 + (ch) * 0x40)
+#define DMA_CHAN_ENABLE			0x00
+#define DMA_CHAN_PAUSE			0x04
+#define DMA_CHAN_LLI_ADDR		0x08
+
+/* Fields of the configuration word in each descriptor */
+#define DMA_CFG_SRC_DRQ(x)		(x)
+#define DMA_CFG_SRC_BURST(x)		(((x) & 3) << 6)
+#define DMA_CFG_SRC_WIDTH(x)		(((x) & 3) << 9)
+#define DMA_CFG_DST(x)			((x) << 16)
+
+#define DMA_DRQ_SDRAM			1
+#define DMA_LLI_LAST_ITEM		0xfffff800
+#define DMA_NORMAL_WAIT			8
+
+#define DMA_CHAN_MAX			16
+#define DMA_LLI_MAX_LEN			SZ_16M
+
+/* Milliseconds to wait, plus one for each 64KiB transferred */
+#define DMA_TIMEOUT_MS			100
+#define DMA_TIMEOUT_SHIFT		16
+
+/**
+ * struct sun6i_dma_lli - descriptor of part of a transfer
+ *
+ * @cfg: DRQ port, addressing mode, burst and width of each side
+ * @src: Physical source address
+ * @dst: Physical destination address
+ * @len: Number of bytes to transfer
+ * @para: Wait between transfers, set to DMA_NORMAL_WAIT
+ * @next: Physical address of the next descriptor, or DMA_LLI_LAST_ITEM
+ */
+struct sun6i_dma_lli {
+	u32 cfg;
+	u32 src;
+	u32 dst;
+	u32 len;
+	u32 para;
+	u32 next;
+};
+
+/**
+ * struct sun6i_dma_variant - differences between the SoCs
+ *
+ * @mode_io: Bit in the configuration word which selects a fixed (device)
+ *	address for the source; the destination bit is this shifted by 16
+ * @max_drq: Highest DRQ port number
+ * @nr_chans: Number of channels, if there is no 'dma-channels' property
+ */
+struct sun6i_dma_variant {
+	u32 mode_io;
+	u32 max_drq;
+	u32 nr_chans;
+};
+
+/**
+ * struct sun6i_dma_chan - state of a channel
+ *
+ * @in_use: true if the channel is requested by a client
+ * @port: DRQ port of the device, for slave transfers
+ * @rx_buf: Buffer for the next dma_receive(), or NULL if none
+ * @rx_len: Size of @rx_buf in bytes
+ */
+struct sun6i_dma_chan {
+	bool in_use;
+	u32 port;
+	void *rx_buf;
+	size_t rx_len;
+};
+
+/**
+ * struct sun6i_dma_priv - controller state
+ *
+ * @base: Register base
+ * @variant: SoC-specific information
+ * @nr_chans: Number of channels
+ * @clks: Bus (and MBUS) clocks
+ * @resets: Bus reset
+ * @chan: State of each channel
+ */
+struct sun6i_dma_priv {
+	void __iomem *base;
+	const struct sun6i_dma_variant *variant;
+	uint nr_chans;
+	struct clk_bulk clks;
+	struct reset_ctl_bulk resets;
+	struct sun6i_dma_chan chan[DMA_CHAN_MAX];
+};
+
+/* Convert a burst length of 1, 4, 8 or 16 to its register value */
+static int sun6i_dma_burst(uint burst)
+{
+	switch (burst) {
+	case 1:
+		return 0;
+	case 4:
+	case 8:
+	case 16:
+		return ilog2(burst) - 1;
+	}
+
+	return -EINVAL;
+}
+
+/* Convert an access width of 1, 2, 4 or 8 bytes to its register value */
+static int sun6i_dma_width(uint width)
+{
+	if (width > 8 || !is_power_of_2(width))
+		return -EINVAL;
+
+	return ilog2(width);
+}
+
+static int sun6i_dma_alloc_chan(struct sun6i_dma_priv *priv)
+{
+	int ch;
+
+	for (ch = 0; ch < priv->nr_chans; ch++) {
+		if (!priv->chan[ch].in_use)
+			return ch;
+	}
+
+	return -EBUSY;
+}
+
+static void sun6i_dma_stop(struct sun6i_dma_priv *priv, int ch)
+{
+	void __iomem *chan = priv->base + DMA_CHAN_BASE(ch);
+
+	writel(0, chan + DMA_CHAN_ENABLE);
+	writel(0, chan + DMA_CHAN_PAUSE);
+}
+
+/**
+ * sun6i_dma_run() - Run a transfer on a channel and wait for it to finish
+ *
+ * @priv: Controller state
+ * @ch: Channel to use
+ * @cfg: Configuration word for each descriptor
+ * @dst: Physical destination address
+ * @src: Physical source address
+ * @len: Number of bytes to transfer
+ * @dst_inc: true to increment the destination address, false for a FIFO
+ * @src_inc: true to increment the source address, false for a FIFO
+ * Return: 0 if OK, -EINVAL if an address is not reachable, -ENOMEM if out
+ *	of memory, -ETIMEDOUT if the transfer did not finish
+ */
+static int sun6i_dma_run(struct sun6i_dma_priv *priv, int ch, u32 cfg,
+			 dma_addr_t dst, dma_addr_t src, size_t len,
+			 bool dst_inc, bool src_inc)
+{
+	void __iomem *chan = priv->base + DMA_CHAN_BASE(ch);
+	void __iomem *stat = priv->base + DMA_IRQ_STAT(ch / DMA_IRQ_CHAN_NR);
+	struct sun6i_dma_lli *lli;
+	uint count, size, timeout, i;
+	int ret;
+
+	/* the descriptors only hold 32-bit addresses */
+	if (upper_32_bits(dst + len - 1) || upper_32_bits(src + len - 1))
+		return -EINVAL;
+
+	count = DIV_ROUND_UP(len, DMA_LLI_MAX_LEN);
+	size = ALIGN(count * sizeof(*lli), ARCH_DMA_MINALIGN);
+	lli = malloc_cache_aligned(size);
+	if (!lli)
+		return -ENOMEM;
+	timeout = DMA_TIMEOUT_MS + (len >> DMA_TIMEOUT_SHIFT);
+
+	for (i = 0; i < count; i++) {
+		size_t part = min_t(size_t, len, DMA_LLI_MAX_LEN);
+
+		lli[i].cfg = cfg;
+		lli[i].src = src;
+		lli[i].dst = dst;
+		lli[i].len = part;
+		lli[i].para = DMA_NORMAL_WAIT;
+		lli[i].next = i == count - 1 ? DMA_LLI_LAST_ITEM :
+			(u32)virt_to_phys(&lli[i + 1]);
+		if (src_inc)
+			src += part;
+		if (dst_inc)
+			dst += part;
+		len -= part;
+	}
+	flush_dcache_range((ulong)lli, (ulong)lli + size);
+
+	writel(DMA_IRQ_QUEUE(ch), stat);
+	writel((u32)virt_to_phys(lli), chan + DMA_CHAN_LLI_ADDR);
+	writel(1, chan + DMA_CHAN_ENABLE);
+
+	ret = wait_for_bit_le32(stat, DMA_IRQ_QUEUE(ch), true, timeout, false);
+	sun6i_dma_stop(priv, ch);
+	writel(DMA_IRQ_QUEUE(ch), stat);
+	free(lli);
+	if (ret)
+		log_err("Channel %d timed out\n", ch);
+
+	return ret;
+}
+
+static int sun6i_dma_transfer(struct udevice *dev, int direction,
+			      dma_addr_t dst, dma_addr_t src, size_t len)
+{
+	struct sun6i_dma_priv *priv = dev_get_priv(dev);
+	u32 cfg;
+	int ch;
+
+	if (direction != DMA_MEM_TO_MEM)
+		return -EINVAL;
+
+	/* the copy is done in 32-bit accesses */
+	if ((dst | src | len) & 3)
+		return -EINVAL;
+
+	ch = sun6i_dma_alloc_chan(priv);
+	if (ch < 0)
+		return ch;
+
+	cfg = DMA_CFG_SRC_DRQ(DMA_DRQ_SDRAM) |
+	      DMA_CFG_SRC_BURST(sun6i_dma_burst(8)) |
+	      DMA_CFG_SRC_WIDTH(sun6i_dma_width(4));
+	cfg |= DMA_CFG_DST(cfg);
+
+	return sun6i_dma_run(priv, ch, cfg, dst, src, len, true, true);
+}
+
+#ifdef CONFIG_DMA_CHANNELS
+static int sun6i_dma_of_xlate(struct dma *dma,
+			      struct ofnode_phandle_args *args)
+{
+	struct sun6i_dma_priv *priv = dev_get_priv(dma->dev);
+
+	if (args->args_count != 1 || args->args[0] > priv->variant->max_drq ||
+	    args->args[0] == DMA_DRQ_SDRAM)
+		return -EINVAL;
+
+	/* this is the DRQ port, until a channel is requested */
+	dma->id = args->args[0];
+
+	return 0;
+}
+
+static int sun6i_dma_request(struct dma *dma)
+{
+	struct sun6i_dma_priv *priv = dev_get_priv(dma->dev);
+	int ch;
+
+	ch = sun6i_dma_alloc_chan(priv);
+	if (ch < 0)
+		return log_msg_ret("req", ch);
+
+	priv->chan[ch].in_use = true;
+	priv->chan[ch].port = dma->id;
+	priv->chan[ch].rx_buf = NULL;
+	dma->id = ch;
+
+	return 0;
+}
+
+static int sun6i_dma_rfree(struct dma *dma)
+{
+	struct sun6i_dma_priv *priv = dev_get_priv(dma->dev);
+
+	sun6i_dma_stop(priv, dma->id);
+	priv->chan[dma->id].in_use = false;
+
+	return 0;
+}
+
+static int sun6i_dma_enable(struct dma *dma)
+{
+	return 0;
+}
+
+static int sun6i_dma_disable(struct dma *dma)
+{
+	struct sun6i_dma_priv *priv = dev_get_priv(dma->dev);
+
+	sun6i_dma_stop(priv, dma->id);
+
+	return 0;
+}
+
+/* Get the configuration word for a slave transfer in the given direction */
+static int sun6i_dma_slave_cfg(struct sun6i_dma_priv *priv,
+			       struct sun6i_dma_chan *uc,
+			       struct sun6i_dma_slave *slave, bool to_dev,
+			       u32 *cfgp)
+{
+	int burst, width;
+	u32 mem, io;
+
+	if (!slave)
+		return -EINVAL;
+	burst = sun6i_dma_burst(slave->burst);
+	width = sun6i_dma_width(slave->width);
+	if (burst < 0 || width < 0)
+		return -EINVAL;
+
+	mem = DMA_CFG_SRC_DRQ(DMA_DRQ_SDRAM) | DMA_CFG_SRC_BURST(burst) |
+	      DMA_CFG_SRC_WIDTH(width);
+	io = DMA_CFG_SRC_DRQ(uc->port) | priv->variant->mode_io |
+	     DMA_CFG_SRC_BURST(burst) | DMA_CFG_SRC_WIDTH(width);
+	*cfgp = to_dev ? mem | DMA_CFG_DST(io) : io | DMA_CFG_DST(mem);
+
+	return 0;
+}
+
+static int sun6i_dma_send(struct dma *dma, void *src, size_t len,
+			  void *metadata)
+{
+	struct sun6i_dma_priv *priv = dev_get_priv(dma->dev);
+	struct sun6i_dma_slave *slave = metadata;
+	dma_addr_t addr;
+	u32 cfg;
+	int ret;
+
+	ret = sun6i_dma_slave_cfg(priv, &priv->chan[dma->id], slave, true,
+				  &cfg);
+	if (ret)
+		return ret;
+
+	addr = dma_map_single(src, len, DMA_TO_DEVICE);
+	ret = sun6i_dma_run(priv, dma->id, cfg, slave->addr, addr, len, false,
+			    true);
+	dma_unmap_single(addr, len, DMA_TO_DEVICE);
+
+	return ret;
+}
+
+static int sun6i_dma_prepare_rcv_buf(struct dma *dma, void *dst, size_t size)
+{
+	struct sun6i_dma_priv *priv = dev_get_priv(dma->dev);
+	struct sun6i_dma_chan *uc = &priv->chan[dma->id];
+
+	uc->rx_buf = dst;
+	uc->rx_len = size;
+
+	return 0;
+}
+
+static int sun6i_dma_receive(struct dma *dma, void **dst, void *metadata)
+{
+	struct sun6i_dma_priv *priv = dev_get_priv(dma->dev);
+	struct sun6i_dma_chan *uc = &priv->chan[dma->id];
+	struct sun6i_dma_slave *slave = metadata;
+	dma_addr_t addr;
+	u32 cfg;
+	int ret;
+
+	if (!uc->rx_buf)
+		return -EINVAL;
+	ret = sun6i_dma_slave_cfg(priv, uc, slave, false, &cfg);
+	if (ret)
+		return ret;
+
+	addr = dma_map_single(uc->rx_buf, uc->rx_len, DMA_FROM_DEVICE);
+	ret = sun6i_dma_run(priv, dma->id, cfg, addr, slave->addr, uc->rx_len,
+			    true, false);
+	dma_unmap_single(addr, uc->rx_len, DMA_FROM_DEVICE);
+	if (ret)
+		return ret;
+
+	*dst = uc->rx_buf;
+	uc->rx_buf = NULL;
+
+	return uc->rx_len;
+}
+#endif /* CONFIG_DMA_CHANNELS */
+
+static int sun6i_dma_probe(struct udevice *dev)
+{
+	struct dma_dev_priv *uc_priv = dev_get_uclass_priv(dev);
+	struct sun6i_dma_priv *priv = dev_get_priv(dev);
+	int ret, i;
+
+	priv->variant = (const struct sun6i_dma_variant *)dev_get_driver_data(dev);
+	priv->base = dev_read_addr_ptr(dev);
+	if (!priv->base)
+		return -EINVAL;
+
+	priv->nr_chans = dev_read_u32_default(dev, "dma-channels",
+					      priv->variant->nr_chans);
+	if (priv->nr_chans > DMA_CHAN_MAX)
+		priv->nr_chans = DMA_CHAN_MAX;
+
+	ret = clk_get_bulk(dev, &priv->clks);
+	if (ret)
+		return log_msg_ret("clk", ret);
+	ret = clk_enable_bulk(&priv->clks);
+	if (ret)
+		return log_msg_ret("ena", ret);
+
+	ret = reset_get_bulk(dev, &priv->resets);
+	if (ret)
+		return log_msg_ret("rst", ret);
+	ret = reset_deassert_bulk(&priv->resets);
+	if (ret)
+		return log_msg_ret("dea", ret);
+
+	writel(DMA_GATE_AUTO, priv->base + DMA_GATE);
+	for (i = 0; i < DIV_ROUND_UP(priv->nr_chans, DMA_IRQ_CHAN_NR); i++) {
+		writel(0, priv->base + DMA_IRQ_EN(i));
+		writel(~0, priv->base + DMA_IRQ_STAT(i));
+	}
+	for (i = 0; i < priv->nr_chans; i++)
+		sun6i_dma_stop(priv, i);
+
+	uc_priv->supported = DMA_SUPPORTS_MEM_TO_MEM;
+	if (IS_ENABLED(CONFIG_DMA_CHANNELS))
+		uc_priv->supported |= DMA_SUPPORTS_MEM_TO_DEV |
+				      DMA_SUPPORTS_DEV_TO_MEM;
+
+	return 0;
+}
+
+static int sun6i_dma_remove(struct udevice *dev)
+{
+	struct sun6i_dma_priv *priv = dev_get_priv(dev);
+	int i;
+
+	for (i = 0; i < priv->nr_chans; i++)
+		sun6i_dma_stop(priv, i);
+
+	return 0;
+}
+
+static const struct dma_ops sun6i_dma_ops = {
+	.transfer	= sun6i_dma_transfer,
+#ifdef CONFIG_DMA_CHANNELS
+	.of_xlate	= sun6i_dma_of_xlate,
+	.request	= sun6i_dma_request,
+	.rfree		= sun6i_dma_rfree,
+	.enable		= sun6i_dma_enable,
+	.disable	= sun6i_dma_disable,
+	.send		= sun6i_dma_send,
+	.prepare_rcv_buf = sun6i_dma_prepare_rcv_buf,
+	.receive	= sun6i_dma_receive,
+#endif
+};
+
+static const struct sun6i_dma_variant sun50i_a64_dma = {
+	.mode_io	= BIT(5),
+	.max_drq	= 27,
+	.nr_chans	= 8,
+};
+
+static const struct sun6i_dma_variant sun50i_h6_dma = {
+	.mode_io	= BIT(8),
+	.max_drq	= 52,
+	.nr_chans	= 16,
+};
+
+static const struct udevice_id sun6i_dma_ids[] = {
+	{ .compatible = "allwinner,sun50i-a64-dma",
+	  .data = (ulong)&sun50i_a64_dma },
+	{ .compatible = "allwinner,sun50i-a100-dma",
+	  .data = (ulong)&sun50i_h6_dma },
+	{ .compatible = "allwinner,sun50i-h6-dma",
+	  .data = (ulong)&sun50i_h6_dma },
+	{ }
+};
+
+U_BOOT_DRIVER(sun6i_dma) = {
+	.name		= "sun6i_dma",
+	.id		= UCLASS_DMA,
+	.of_match	= sun6i_dma_ids,
+	.ops		= &sun6i_dma_ops,
+	.probe		= sun6i_dma_probe,
+	.remove		= sun6i_dma_remove,
+	.priv_auto	= sizeof(struct sun6i_dma_priv),
+	.flags		= DM_FLAG_OS_PREPARE,
+};
@@ -30,6 +30,31 @@ static u32 fastboot_bytes_received;
  */
 static u32 fastboot_bytes_expected;
 
+/**
+ * stream_part - partition selected by "oem stream", empty when not streaming
+ */
+static char stream_part[PART_NAME_LEN];
+
+/**
+ * stream_active - the current or last download was flashed to stream_part
+ */
+static bool stream_active;
+
+/**
+ * stream_fill - bytes collected in fastboot_buf_addr but not yet written
+ */
+static u32 stream_fill;
+
+/**
+ * stream_response - first failure reported while flashing a streamed image
+ */
+static char stream_response[FASTBOOT_RESPONSE_LEN];
+
+static bool fastboot_streaming(void)
+{
+	return IS_ENABLED(CONFIG_FASTBOOT_FLASH_STREAM) && stream_active;
+}
+
 static void okay(char *, char *);
 static void getvar(char *, char *);
 static void download(char *, char *);
@@ -43,6 +68,7 @@ static void oem_partconf(char *, char *);
 static void oem_bootbus(char *, char *);
 static void oem_console(char *, char *);
 static void oem_board(char *, char *);
+static void oem_stream(char *, char *);
 static void run_ucmd(char *, char *);
 static void run_acmd(char *, char *);
 
@@ -118,6 +144,10 @@ static const struct {
 		.command = "oem board",
 		.dispatch = CONFIG_IS_ENABLED(FASTBOOT_OEM_BOARD, (oem_board), (NULL))
 	},
+	[FASTBOOT_COMMAND_OEM_STREAM] = {
+		.command = "oem stream",
+		.dispatch = CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM, (oem_stream), (NULL))
+	},
 	[FASTBOOT_COMMAND_UCMD] = {
 		.command = "UCmd",
 		.dispatch = CONFIG_IS_ENABLED(FASTBOOT_UUU_SUPPORT, (run_ucmd), (NULL))
@@ -238,13 +268,26 @@ static void download(char *cmd_parameter, char *response)
 		fastboot_fail("Expected nonzero image size", response);
 		return;
 	}
+
+	stream_active = IS_ENABLED(CONFIG_FASTBOOT_FLASH_STREAM) &&
+			stream_part[0];
+	if (fastboot_streaming()) {
+		stream_fill = 0;
+		stream_response[0] = '\0';
+		if (fastboot_mmc_stream_start(stream_part, response)) {
+			stream_active = false;
+			return;
+		}
+	}
+
 	/*
 	 * Nothing to download yet. Response is of the form:
 	 * [DATA|FAIL]$cmd_parameter
 	 *
 	 * where cmd_parameter is an 8 digit hexadecimal number
 	 */
-	if (fastboot_bytes_expected > fastboot_buf_size) {
+	if (!fastboot_streaming() &&
+	    fastboot_bytes_expected > fastboot_buf_size) {
 		fastboot_fail(cmd_parameter, response);
 	} else {
 		printf("Starting download of %d bytes\n",
@@ -263,6 +306,43 @@ u32 fastboot_data_remaining(void)
 	return fastboot_bytes_expected - fastboot_bytes_received;
 }
 
+/**
+ * stream_write() - Write out the streamed data collected so far
+ *
+ * @last: No more data will follow
+ *
+ * Whatever the flash backend does not consume yet (a partial block or
+ * header) is moved to the start of fastboot_buf_addr, ahead of the next
+ * data. After a failure, received data is dropped until the download ends.
+ */
+static void stream_write(bool last)
+{
+	long ret;
+
+	if (!stream_response[0]) {
+		ret = fastboot_mmc_stream_write(fastboot_buf_addr, stream_fill,
+						last, stream_response);
+		if (ret >= 0) {
+			stream_fill -= ret;
+			memmove(fastboot_buf_addr, fastboot_buf_addr + ret,
+				stream_fill);
+			return;
+		}
+		if (!stream_response[0])
+			fastboot_fail("streamed write failed", stream_response);
+	}
+
+	stream_fill = 0;
+}
+
+void fastboot_data_flush(void)
+{
+	if (fastboot_streaming() && fastboot_data_remaining() &&
+	    stream_fill >= CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM,
+			(CONFIG_FASTBOOT_FLASH_STREAM_CHUNK), (0)))
+		stream_write(false);
+}
+
 /**
  * fastboot_data_download() - Copy image data to fastboot_buf_addr.
  *
@@ -277,26 +357,20 @@ u32 fastboot_data_remaining(void)
  * On completion sets image_size and ${filesize} to the total size of the
  * downloaded image.
  */
-void fastboot_data_download(const void *fastboot_data,
-			    unsigned int fastboot_data_len,
-			    char *response)
+/**
+ * data_progress() - Account for received image data
+ *
+ * @len: Number of bytes that have been received
+ *
+ * Updates fastboot_bytes_received and prints a dot every BYTES_PER_DOT.
+ */
+static void data_progress(u32 len)
 {
 #define BYTES_PER_DOT	0x20000
 	u32 pre_dot_num, now_dot_num;
 
-	if (fastboot_data_len == 0 ||
-	    (fastboot_bytes_received + fastboot_data_len) >
-	    fastboot_bytes_expected) {
-		fastboot_fail("Received invalid data length",
-			      response);
-		return;
-	}
-	/* Download data to fastboot_buf_addr */
-	memcpy(fastboot_buf_addr + fastboot_bytes_received,
-	       fastboot_data, fastboot_data_len);
-
 	pre_dot_num = fastboot_bytes_received / BYTES_PER_DOT;
-	fastboot_bytes_received += fastboot_data_len;
+	fastboot_bytes_received += len;
 	now_dot_num = fastboot_bytes_received / BYTES_PER_DOT;
 
 	if (pre_dot_num != now_dot_num) {
@@ -304,6 +378,48 @@ void fastboot_data_download(const void *fastboot_data,
 		if (!(now_dot_num % 74))
 			putc('\n');
 	}
+}
+
+void *fastboot_data_buffer(u32 offset, u32 len)
+{
+	if (fastboot_streaming() || offset + len < offset ||
+	    offset + len > fastboot_bytes_expected)
+		return NULL;
+
+	return fastboot_buf_addr + offset;
+}
+
+void fastboot_data_received(u32 len)
+{
+	if (fastboot_bytes_received + len <= fastboot_bytes_expected)
+		data_progress(len);
+}
+
+void fastboot_data_download(const void *fastboot_data,
+			    unsigned int fastboot_data_len,
+			    char *response)
+{
+	if (fastboot_data_len == 0 ||
+	    (fastboot_bytes_received + fastboot_data_len) >
+	    fastboot_bytes_expected) {
+		fastboot_fail("Received invalid data length",
+			      response);
+		return;
+	}
+	if (fastboot_streaming()) {
+		/* Make room if fastboot_data_flush() has not been called */
+		if (stream_fill + fastboot_data_len > fastboot_buf_size)
+			stream_write(false);
+		memcpy(fastboot_buf_addr + stream_fill, fastboot_data,
+		       fastboot_data_len);
+		stream_fill += fastboot_data_len;
+	} else {
+		/* Download data to fastboot_buf_addr */
+		memcpy(fastboot_buf_addr + fastboot_bytes_received,
+		       fastboot_data, fastboot_data_len);
+	}
+
+	data_progress(fastboot_data_len);
 	*response = '\0';
 }
 
@@ -316,6 +432,9 @@ void fastboot_data_download(const void *fastboot_data,
  */
 void fastboot_data_complete(char *response)
 {
+	if (fastboot_streaming())
+		stream_write(true);
+
 	/* Download complete. Respond with "OKAY" */
 	fastboot_okay(NULL, response);
 	printf("\ndownloading of %d bytes finished\n", fastboot_bytes_received);
@@ -336,6 +455,20 @@ void fastboot_data_complete(char *response)
  */
 static void __maybe_unused flash(char *cmd_parameter, char *response)
 {
+	if (fastboot_streaming()) {
+		/* The image has been written while it was downloaded */
+		stream_active = false;
+		if (!cmd_parameter || strcmp(cmd_parameter, stream_part))
+			fastboot_fail("image was streamed to another partition",
+				      response);
+		else if (stream_response[0])
+			strlcpy(response, stream_response,
+				FASTBOOT_RESPONSE_LEN);
+		else
+			fastboot_mmc_stream_finish(cmd_parameter, response);
+		return;
+	}
+
 	if (IS_ENABLED(CONFIG_FASTBOOT_FLASH_MMC))
 		fastboot_mmc_flash_write(cmd_parameter, fastboot_buf_addr,
 					 image_size, response);
@@ -572,3 +705,29 @@ static void __maybe_unused oem_board(char *cmd_parameter, char *response)
 {
 	fastboot_oem_board(cmd_parameter, (void *)fastboot_buf_addr, image_size, response);
 }
+
+/**
+ * oem_stream() - Select a partition to flash while downloading
+ *
+ * @cmd_parameter: Pointer to partition name, or NULL to stop streaming
+ * @response: Pointer to fastboot response buffer
+ */
+static void __maybe_unused oem_stream(char *cmd_parameter, char *response)
+{
+	stream_part[0] = '\0';
+	if (!cmd_parameter || !cmd_parameter[0]) {
+		fastboot_okay(NULL, response);
+		return;
+	}
+
+	if (strlen(cmd_parameter) >= sizeof(stream_part)) {
+		fastboot_fail("partition name too long", response);
+		return;
+	}
+
+	if (fastboot_mmc_stream_start(cmd_parameter, response))
+		return;
+
+	strlcpy(stream_part, cmd_parameter, sizeof(stream_part));
+	fastboot_okay(NULL, response);
+}
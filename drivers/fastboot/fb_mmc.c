@@ -13,6 +13,7 @@
 #include <image.h>
 #include <log.h>
 #include <part.h>
+#include <memalign.h>
 #include <mmc.h>
 #include <div64.h>
 #include <linux/compat.h>
@@ -164,6 +165,33 @@ static lbaint_t fb_mmc_sparse_reserve(struct sparse_storage *info,
 	return blkcnt;
 }
 
+static lbaint_t fb_mmc_sparse_erase(struct sparse_storage *info,
+		lbaint_t blk, lbaint_t blkcnt)
+{
+	struct fb_mmc_sparse *sparse = info->priv;
+	struct blk_desc *dev_desc = sparse->dev_desc;
+
+	return fb_mmc_blk_write(dev_desc, blk, blkcnt, NULL);
+}
+
+/**
+ * fb_mmc_erases_to_zero() - Check if erased blocks read back as zero
+ *
+ * Only eMMC with TRIM support qualifies: TRIM works on write blocks, so
+ * an arbitrary range can be erased without touching its neighbours, and
+ * ERASED_MEM_CONT tells what the trimmed blocks contain afterwards.
+ *
+ * @dev_desc: Pointer to block device
+ * Return: true if blk_derase() can stand in for writing zeroes
+ */
+static bool fb_mmc_erases_to_zero(struct blk_desc *dev_desc)
+{
+	struct mmc *mmc = find_mmc_device(dev_desc->devnum);
+
+	return mmc && IS_MMC(mmc) && mmc->can_trim && mmc->ext_csd &&
+	       !mmc->ext_csd[EXT_CSD_ERASED_MEM_CONT];
+}
+
 static void write_raw_image(struct blk_desc *dev_desc,
 			    struct disk_partition *info, const char *part_name,
 			    void *buffer, u32 download_bytes, char *response)
@@ -620,6 +648,8 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 		sparse.size = info.size;
 		sparse.write = fb_mmc_sparse_write;
 		sparse.reserve = fb_mmc_sparse_reserve;
+		sparse.erase = fb_mmc_erases_to_zero(dev_desc) ?
+			       fb_mmc_sparse_erase : NULL;
 		sparse.mssg = fastboot_fail;
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
@@ -708,3 +738,144 @@ void fastboot_mmc_erase(const char *cmd, char *response)
 	       blks_size * info.blksz, cmd);
 	fastboot_okay(NULL, response);
 }
+
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+/**
+ * struct fb_mmc_stream - state of an image being flashed while it downloads
+ *
+ * @dev_desc: Block device holding the partition
+ * @info: Partition being written
+ * @sparse_priv: Private data for @sparse
+ * @sparse: Storage description handed to the sparse decoder
+ * @ss: Sparse decoder state
+ * @blk: Next block to write, for raw images
+ * @started: First data has been seen and @is_sparse is valid
+ * @is_sparse: The image is an Android sparse image
+ */
+static struct fb_mmc_stream {
+	struct blk_desc *dev_desc;
+	struct disk_partition info;
+	struct fb_mmc_sparse sparse_priv;
+	struct sparse_storage sparse;
+	struct sparse_stream ss;
+	lbaint_t blk;
+	bool started;
+	bool is_sparse;
+} fb_mmc_stream;
+
+int fastboot_mmc_stream_start(const char *cmd, char *response)
+{
+	struct fb_mmc_stream *st = &fb_mmc_stream;
+
+	if (fastboot_mmc_get_part_info(cmd, &st->dev_desc, &st->info,
+				       response) < 0)
+		return -ENOENT;
+
+	st->blk = st->info.start;
+	st->started = false;
+
+	return 0;
+}
+
+static void fb_mmc_stream_begin(struct fb_mmc_stream *st, void *data, u32 len)
+{
+	st->is_sparse = len >= sizeof(sparse_header_t) &&
+			is_sparse_image(data);
+	st->started = true;
+
+	if (!st->is_sparse) {
+		puts("Flashing Raw Image\n");
+		return;
+	}
+
+	st->sparse_priv.dev_desc = st->dev_desc;
+	st->sparse.blksz = st->info.blksz;
+	st->sparse.start = st->info.start;
+	st->sparse.size = st->info.size;
+	st->sparse.priv = &st->sparse_priv;
+	st->sparse.write = fb_mmc_sparse_write;
+	st->sparse.reserve = fb_mmc_sparse_reserve;
+	st->sparse.erase = fb_mmc_erases_to_zero(st->dev_desc) ?
+			   fb_mmc_sparse_erase : NULL;
+	st->sparse.mssg = fastboot_fail;
+	sparse_stream_init(&st->ss, &st->sparse);
+
+	printf("Flashing sparse image at offset " LBAFU "\n", st->sparse.start);
+}
+
+long fastboot_mmc_stream_write(void *data, u32 len, bool last, char *response)
+{
+	struct fb_mmc_stream *st = &fb_mmc_stream;
+	lbaint_t blkcnt, end;
+	long consumed;
+	u32 tail;
+	void *buf;
+
+	if (!st->started) {
+		/* Wait for enough data to tell a sparse image apart */
+		if (len < sizeof(sparse_header_t) && !last)
+			return 0;
+		fb_mmc_stream_begin(st, data, len);
+	}
+
+	if (st->is_sparse)
+		return sparse_stream_write(&st->ss, data, len, response);
+
+	blkcnt = len / st->info.blksz;
+	tail = len % st->info.blksz;
+	if (!last)
+		tail = 0;
+
+	end = st->blk + blkcnt + (tail ? 1 : 0);
+	if (end > st->info.start + st->info.size) {
+		pr_err("too large for partition: '%s'\n", st->info.name);
+		fastboot_fail("too large for partition", response);
+		return -EFBIG;
+	}
+
+	if (blkcnt && fb_mmc_blk_write(st->dev_desc, st->blk, blkcnt,
+				       data) != blkcnt)
+		goto fail;
+	st->blk += blkcnt;
+	consumed = blkcnt * st->info.blksz;
+
+	if (tail) {
+		/* Pad the final partial block with zeroes */
+		buf = malloc_cache_aligned(st->info.blksz);
+		if (!buf) {
+			fastboot_fail("out of memory", response);
+			return -ENOMEM;
+		}
+		memset(buf, '\0', st->info.blksz);
+		memcpy(buf, data + blkcnt * st->info.blksz, tail);
+		blkcnt = fb_mmc_blk_write(st->dev_desc, st->blk, 1, buf);
+		free(buf);
+		if (blkcnt != 1)
+			goto fail;
+		st->blk++;
+		consumed += tail;
+	}
+
+	return consumed;
+
+fail:
+	pr_err("failed writing to device %d\n", st->dev_desc->devnum);
+	fastboot_fail("failed writing to device", response);
+	return -EIO;
+}
+
+void fastboot_mmc_stream_finish(const char *cmd, char *response)
+{
+	struct fb_mmc_stream *st = &fb_mmc_stream;
+
+	if (st->is_sparse) {
+		if (!sparse_stream_finish(&st->ss, cmd, response))
+			fastboot_okay(NULL, response);
+		return;
+	}
+
+	printf("........ wrote " LBAFU " bytes to '%s'\n",
+	       (st->blk - st->info.start) * st->info.blksz, cmd);
+	fastboot_okay(NULL, response);
+}
+#endif
@@ -624,6 +624,7 @@ static int __twsi_i2c_probe_chip(struct mvtwsi_registers *twsi, uchar chip,
 	return status;
 }
 
+#if !CONFIG_IS_ENABLED(DM_I2C)
 /*
  * __twsi_i2c_read() - Read data from a I2C chip.
  *
@@ -728,7 +729,6 @@ static int __twsi_i2c_write(struct mvtwsi_registers *twsi, uchar chip,
 	return status != 0 ? status : stop_status;
 }
 
-#if !CONFIG_IS_ENABLED(DM_I2C)
 static void twsi_i2c_init(struct i2c_adapter *adap, int speed,
 			  int slaveadd)
 {
@@ -899,39 +899,63 @@ static int mvtwsi_i2c_probe(struct udevice *bus)
 	return 0;
 }
 
+/*
+ * mvtwsi_i2c_xfer() - Run a list of messages as a single I2C transaction
+ *
+ * Each message starts with a (repeated) START and its address byte, unless it
+ * is a write with I2C_M_NOSTART, which carries on from the previous one. There
+ * is a single STOP at the end, so a PMIC can be set up with a string of
+ * register writes without releasing the bus between them.
+ *
+ * @bus:	I2C bus device
+ * @msg:	Messages to transfer
+ * @nmsgs:	Number of messages
+ * Return: Zero if the operation succeeded, or a non-zero code if a time out or
+ *	   unexpected I2C status occurred.
+ */
 static int mvtwsi_i2c_xfer(struct udevice *bus, struct i2c_msg *msg, int nmsgs)
 {
 	struct mvtwsi_i2c_dev *dev = dev_get_priv(bus);
-	struct i2c_msg *dmsg, *omsg, dummy;
-	u8 *addr_buf_ptr;
-	u8 addr_buf[4];
+	struct mvtwsi_registers *twsi = dev->base;
+	int expected_start = MVTWSI_STATUS_START;
+	int status = 0, stop_status;
 	int i;
 
-	memset(&dummy, 0, sizeof(struct i2c_msg));
+	if (!nmsgs)
+		return -EINVAL;
 
-	/* We expect either two messages (one with an offset and one with the
-	 * actual data) or one message (just data or offset/data combined) */
-	if (nmsgs > 2 || nmsgs == 0) {
-		debug("%s: Only one or two messages are supported.", __func__);
-		return -1;
-	}
+	/* Check for (and clear) a bus error from a previous failed transaction
+	 * or another master on the same bus */
+	if (readl(&twsi->status) == MVTWSI_BUS_ERROR)
+		__twsi_i2c_reinit(twsi, dev->tick);
+
+	for (; status == 0 && nmsgs--; msg++) {
+		bool read = msg->flags & I2C_M_RD;
 
-	omsg = nmsgs == 1 ? &dummy : msg;
-	dmsg = nmsgs == 1 ? msg : msg + 1;
-
-	/* We need to swap the register address if its size is > 1 */
-	addr_buf_ptr = &addr_buf[0];
-	for (i = omsg->len; i > 0; i--)
-		*addr_buf_ptr++ = omsg->buf[i - 1];
-
-	if (dmsg->flags & I2C_M_RD)
-		return __twsi_i2c_read(dev->base, dmsg->addr, addr_buf,
-				       omsg->len, dmsg->buf, dmsg->len,
-				       dev->tick);
-	else
-		return __twsi_i2c_write(dev->base, dmsg->addr, addr_buf,
-					omsg->len, dmsg->buf, dmsg->len,
-					dev->tick);
+		if (read || !(msg->flags & I2C_M_NOSTART) ||
+		    expected_start == MVTWSI_STATUS_START) {
+			status = i2c_begin(twsi, expected_start,
+					   (msg->addr << 1) | read, dev->tick);
+			/* Send repeated STARTs after the initial START */
+			expected_start = MVTWSI_STATUS_REPEATED_START;
+		}
+		/* NAK the last byte read, to end the message */
+		for (i = 0; status == 0 && i < msg->len; i++) {
+			if (read)
+				status = twsi_recv(twsi, &msg->buf[i],
+						   i < msg->len - 1 ?
+						   MVTWSI_READ_ACK :
+						   MVTWSI_READ_NAK, dev->tick);
+			else
+				status = twsi_send(twsi, msg->buf[i],
+						   MVTWSI_STATUS_DATA_W_ACK,
+						   dev->tick);
+		}
+	}
+	/* Stop transaction */
+	stop_status = twsi_stop(twsi, dev->tick);
+	/* Return 0, or the status of the first failure */
+	return status != 0 ? status : stop_status;
 }
 
 static const struct dm_i2c_ops mvtwsi_i2c_ops = {
@@ -52,7 +52,12 @@ static int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 
 int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 {
-	return dm_mmc_send_cmd(mmc->dev, cmd, data);
+	int ret;
+
+	ret = dm_mmc_send_cmd(mmc->dev, cmd, data);
+	mmc_stats_cmd(mmc, ret);
+
+	return ret;
 }
 
 static int dm_mmc_set_ios(struct udevice *dev)
@@ -9,6 +9,7 @@
 
 #include <config.h>
 #include <blk.h>
+#include <bloblist.h>
 #include <command.h>
 #include <dm.h>
 #include <log.h>
@@ -242,6 +243,7 @@ int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 	mmmc_trace_before_send(mmc, cmd);
 	ret = mmc->cfg->ops->send_cmd(mmc, cmd, data);
 	mmmc_trace_after_send(mmc, cmd, ret);
+	mmc_stats_cmd(mmc, ret);
 
 	return ret;
 }
@@ -262,9 +264,11 @@ static int mmc_send_cmd_retry(struct mmc *mmc, struct mmc_cmd *cmd,
 {
 	int ret;
 
-	do {
+	ret = mmc_send_cmd(mmc, cmd, data);
+	while (ret && retries--) {
+		mmc_stats_retry(mmc);
 		ret = mmc_send_cmd(mmc, cmd, data);
-	} while (ret && retries--);
+	}
 
 	return ret;
 }
@@ -1111,6 +1115,8 @@ int mmc_switch_part(struct mmc *mmc, unsigned int part_num)
 				 EXT_CSD_PART_CONF,
 				 (mmc->part_config & ~PART_ACCESS_MASK)
 				 | (part_num & PART_ACCESS_MASK));
+		if (ret && retry)
+			mmc_stats_retry(mmc);
 	} while (ret && retry--);
 
 	/*
@@ -2304,6 +2310,36 @@ static int mmc_select_mode_and_width(struct mmc *mmc, uint card_caps)
 };
 #endif
 
+#if !CONFIG_IS_ENABLED(MMC_TINY)
+/*
+ * Select the bus mode and width using @select, first trying the ones which
+ * worked before for this card, if any
+ */
+static int mmc_select_known_mode(struct mmc *mmc,
+				 int (*select)(struct mmc *mmc, uint card_caps))
+{
+	uint caps;
+	int err;
+
+	if (!mmc_mode_cache_find(mmc, &caps) &&
+	    (caps & mmc->card_caps) == caps) {
+		err = select(mmc, caps);
+		if (!err)
+			goto done;
+		pr_debug("known mode failed (err=%d), searching\n", err);
+		mmc_mode_cache_drop(mmc);
+	}
+
+	err = select(mmc, mmc->card_caps);
+	if (err)
+		return err;
+done:
+	mmc_mode_cache_add(mmc);
+
+	return 0;
+}
+#endif
+
 #if CONFIG_IS_ENABLED(MMC_TINY)
 DEFINE_CACHE_ALIGN_BUFFER(u8, ext_csd_bkup, MMC_MAX_BLOCK_LEN);
 #endif
@@ -2517,24 +2553,11 @@ error:
 	return err;
 }
 
-static int mmc_startup(struct mmc *mmc)
+/* Read the CID and CSD, giving the card its relative address on the way */
+static int mmc_identify(struct mmc *mmc)
 {
-	int err, i;
-	uint mult, freq;
-	u64 cmult, csize;
 	struct mmc_cmd cmd;
-	struct blk_desc *bdesc;
-
-#ifdef CONFIG_MMC_SPI_CRC_ON
-	if (mmc_host_is_spi(mmc)) { /* enable CRC check for spi */
-		cmd.cmdidx = MMC_CMD_SPI_CRC_ON_OFF;
-		cmd.resp_type = MMC_RSP_R1;
-		cmd.cmdarg = 1;
-		err = mmc_send_cmd(mmc, &cmd, NULL);
-		if (err)
-			return err;
-	}
-#endif
+	int err;
 
 	/* Put the Card in Identify Mode */
 	cmd.cmdidx = mmc_host_is_spi(mmc) ? MMC_CMD_SEND_CID :
@@ -2582,8 +2605,36 @@ static int mmc_startup(struct mmc *mmc)
 	mmc->csd[2] = cmd.response[2];
 	mmc->csd[3] = cmd.response[3];
 
+	return 0;
+}
+
+static int mmc_startup(struct mmc *mmc)
+{
+	int err, i;
+	uint mult, freq;
+	u64 cmult, csize;
+	struct mmc_cmd cmd;
+	struct blk_desc *bdesc;
+
+#ifdef CONFIG_MMC_SPI_CRC_ON
+	if (mmc_host_is_spi(mmc)) { /* enable CRC check for spi */
+		cmd.cmdidx = MMC_CMD_SPI_CRC_ON_OFF;
+		cmd.resp_type = MMC_RSP_R1;
+		cmd.cmdarg = 1;
+		err = mmc_send_cmd(mmc, &cmd, NULL);
+		if (err)
+			return err;
+	}
+#endif
+
+	if (!mmc->handed_off) {
+		err = mmc_identify(mmc);
+		if (err)
+			return err;
+	}
+
 	if (mmc->version == MMC_VERSION_UNKNOWN) {
-		int version = (cmd.response[0] >> 26) & 0xf;
+		int version = (mmc->csd[0] >> 26) & 0xf;
 
 		switch (version) {
 		case 0:
@@ -2608,22 +2659,24 @@ static int mmc_startup(struct mmc *mmc)
 	}
 
 	/* divide frequency by 10, since the mults are 10x bigger */
-	freq = fbase[(cmd.response[0] & 0x7)];
-	mult = multipliers[((cmd.response[0] >> 3) & 0xf)];
+	freq = fbase[(mmc->csd[0] & 0x7)];
+	mult = multipliers[((mmc->csd[0] >> 3) & 0xf)];
 
 	mmc->legacy_speed = freq * mult;
 	if (!mmc->legacy_speed)
 		log_debug("TRAN_SPEED: reserved value");
-	mmc_select_mode(mmc, MMC_LEGACY);
+	/* a card handed over by SPL is already in a faster mode */
+	if (!mmc->handed_off)
+		mmc_select_mode(mmc, MMC_LEGACY);
 
-	mmc->dsr_imp = ((cmd.response[1] >> 12) & 0x1);
-	mmc->read_bl_len = 1 << ((cmd.response[1] >> 16) & 0xf);
+	mmc->dsr_imp = ((mmc->csd[1] >> 12) & 0x1);
+	mmc->read_bl_len = 1 << ((mmc->csd[1] >> 16) & 0xf);
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 
 	if (IS_SD(mmc))
 		mmc->write_bl_len = mmc->read_bl_len;
 	else
-		mmc->write_bl_len = 1 << ((cmd.response[3] >> 22) & 0xf);
+		mmc->write_bl_len = 1 << ((mmc->csd[3] >> 22) & 0xf);
 #endif
 
 	if (mmc->high_capacity) {
@@ -2651,7 +2704,7 @@ static int mmc_startup(struct mmc *mmc)
 		mmc->write_bl_len = MMC_MAX_BLOCK_LEN;
 #endif
 
-	if ((mmc->dsr_imp) && (0xffffffff != mmc->dsr)) {
+	if ((mmc->dsr_imp) && (0xffffffff != mmc->dsr) && !mmc->handed_off) {
 		cmd.cmdidx = MMC_CMD_SET_DSR;
 		cmd.cmdarg = (mmc->dsr & 0xffff) << 16;
 		cmd.resp_type = MMC_RSP_NONE;
@@ -2660,7 +2713,8 @@ static int mmc_startup(struct mmc *mmc)
 	}
 
 	/* Select the card, and put it into Transfer Mode */
-	if (!mmc_host_is_spi(mmc)) { /* cmd not supported in spi */
+	if (!mmc_host_is_spi(mmc) && !mmc->handed_off) {
+		/* cmd not supported in spi */
 		cmd.cmdidx = MMC_CMD_SELECT_CARD;
 		cmd.resp_type = MMC_RSP_R1;
 		cmd.cmdarg = mmc->rca << 16;
@@ -2691,16 +2745,22 @@ static int mmc_startup(struct mmc *mmc)
 	mmc_select_mode(mmc, MMC_LEGACY);
 	mmc_set_bus_width(mmc, 1);
 #else
-	if (IS_SD(mmc)) {
+	if (mmc->handed_off) {
+		/* the bus is already set up as SPL left it */
+#if CONFIG_IS_ENABLED(MMC_WRITE)
+		if (IS_SD(mmc) && sd_read_ssr(mmc))
+			pr_warn("unable to read ssr\n");
+#endif
+	} else if (IS_SD(mmc)) {
 		err = sd_get_capabilities(mmc);
 		if (err)
 			return err;
-		err = sd_select_mode_and_width(mmc, mmc->card_caps);
+		err = mmc_select_known_mode(mmc, sd_select_mode_and_width);
 	} else {
 		err = mmc_get_capabilities(mmc);
 		if (err)
 			return err;
-		err = mmc_select_mode_and_width(mmc, mmc->card_caps);
+		err = mmc_select_known_mode(mmc, mmc_select_mode_and_width);
 	}
 #endif
 	if (err)
@@ -2879,6 +2939,159 @@ static int mmc_power_cycle(struct mmc *mmc)
 	return mmc_power_on(mmc);
 }
 
+#if CONFIG_IS_ENABLED(MMC_HANDOFF)
+/**
+ * struct mmc_handoff - a card left in the transfer state by SPL
+ *
+ * This is passed to U-Boot proper in BLOBLISTT_U_BOOT_MMC_HANDOFF
+ *
+ * @reg: Address of the controller's registers, or 0 once taken over
+ * @cid: Card identification
+ * @csd: Card-specific data
+ * @scr: SD configuration
+ * @ocr: Operating conditions
+ * @version: Card version (SD_VERSION_... or MMC_VERSION_...)
+ * @card_caps: Capabilities of the card
+ * @legacy_speed: Clock rate for the legacy mode
+ * @rca: Relative card address
+ * @high_capacity: true if the card uses block addressing
+ * @mode: Selected bus mode (enum bus_mode)
+ * @bus_width: Bus width in bits
+ * @part: Selected hardware partition
+ * @signal_voltage: Signal voltage (enum mmc_voltage)
+ * @rsvd: Reserved, set to 0
+ */
+struct mmc_handoff {
+	u64 reg;
+	u32 cid[4];
+	u32 csd[4];
+	u32 scr[2];
+	u32 ocr;
+	u32 version;
+	u32 card_caps;
+	u32 legacy_speed;
+	u16 rca;
+	u8 high_capacity;
+	u8 mode;
+	u8 bus_width;
+	u8 part;
+	u8 signal_voltage;
+	u8 rsvd;
+};
+
+static ulong mmc_handoff_reg(struct mmc *mmc)
+{
+#if CONFIG_IS_ENABLED(DM_MMC)
+	return dev_read_addr(mmc->dev);
+#else
+	return mmc->cfg->reg;
+#endif
+}
+
+/*
+ * Only modes which need no tuning and no voltage switch can be taken over,
+ * since the controller state for those cannot be rebuilt from the record
+ */
+static bool mmc_handoff_mode_ok(enum bus_mode mode)
+{
+	return mode == MMC_LEGACY || mode == MMC_HS || mode == SD_HS ||
+	       mode == MMC_HS_52;
+}
+
+void mmc_handoff_save(struct mmc *mmc)
+{
+	struct mmc_handoff *ho;
+	ulong reg = mmc_handoff_reg(mmc);
+
+	if (!reg || mmc_host_is_spi(mmc) ||
+	    !mmc_handoff_mode_ok(mmc->selected_mode))
+		return;
+	ho = bloblist_ensure(BLOBLISTT_U_BOOT_MMC_HANDOFF, sizeof(*ho));
+	if (!ho)
+		return;
+
+	memset(ho, '\0', sizeof(*ho));
+	ho->reg = reg;
+	memcpy(ho->cid, mmc->cid, sizeof(ho->cid));
+	memcpy(ho->csd, mmc->csd, sizeof(ho->csd));
+	memcpy(ho->scr, mmc->scr, sizeof(ho->scr));
+	ho->ocr = mmc->ocr;
+	ho->version = mmc->version;
+	ho->card_caps = mmc->card_caps;
+	ho->legacy_speed = mmc->legacy_speed;
+	ho->rca = mmc->rca;
+	ho->high_capacity = mmc->high_capacity;
+	ho->mode = mmc->selected_mode;
+	ho->bus_width = mmc->bus_width;
+	ho->part = mmc_get_blk_desc(mmc)->hwpart;
+	ho->signal_voltage = mmc->signal_voltage;
+}
+
+/*
+ * Take over the card left in the transfer state by SPL, if it is on this
+ * controller and still answers at its address, in place of power-cycling it
+ * and identifying it again
+ */
+static int mmc_handoff_adopt(struct mmc *mmc)
+{
+	struct mmc_handoff *ho;
+	uint status;
+	int err;
+
+	ho = bloblist_find(BLOBLISTT_U_BOOT_MMC_HANDOFF, sizeof(*ho));
+	if (!ho || !ho->reg || ho->reg != mmc_handoff_reg(mmc))
+		return -ENOENT;
+	/* only once, since the card may be reset later */
+	ho->reg = 0;
+	if (!mmc_handoff_mode_ok(ho->mode) ||
+	    !(mmc->host_caps & MMC_CAP(ho->mode)))
+		return -EINVAL;
+
+	err = mmc_power_on(mmc);
+	if (err)
+		return err;
+#if CONFIG_IS_ENABLED(DM_MMC)
+	err = mmc_reinit(mmc);
+	if (err)
+		return err;
+#endif
+	mmc_set_initial_state(mmc);
+	if (mmc->signal_voltage != ho->signal_voltage)
+		return -EINVAL;
+
+	memcpy(mmc->cid, ho->cid, sizeof(mmc->cid));
+	memcpy(mmc->csd, ho->csd, sizeof(mmc->csd));
+	memcpy(mmc->scr, ho->scr, sizeof(mmc->scr));
+	mmc->ocr = ho->ocr;
+	mmc->version = ho->version;
+	mmc->card_caps = ho->card_caps;
+	mmc->legacy_speed = ho->legacy_speed;
+	mmc->rca = ho->rca;
+	mmc->high_capacity = ho->high_capacity;
+	mmc->op_cond_pending = 0;
+	mmc_get_blk_desc(mmc)->hwpart = ho->part;
+
+	mmc_set_bus_width(mmc, ho->bus_width);
+	mmc_select_mode(mmc, ho->mode);
+	mmc_set_clock(mmc, mmc->tran_speed, MMC_CLK_ENABLE);
+
+	err = mmc_send_status(mmc, &status);
+	if (err)
+		return err;
+	if ((status & MMC_STATUS_CURR_STATE) != MMC_STATE_TRANS)
+		return -ESTALE;
+	mmc->handed_off = true;
+	pr_debug("%s: taken over from SPL\n", mmc->cfg->name);
+
+	return 0;
+}
+#else
+static int mmc_handoff_adopt(struct mmc *mmc)
+{
+	return -ENOENT;
+}
+#endif
+
 int mmc_get_op_cond(struct mmc *mmc, bool quiet)
 {
 	bool uhs_en = supports_uhs(mmc->cfg->host_caps);
@@ -2897,6 +3110,9 @@ int mmc_get_op_cond(struct mmc *mmc, bool quiet)
 		      MMC_QUIRK_RETRY_APP_CMD;
 #endif
 
+	if (!mmc_handoff_adopt(mmc))
+		return 0;
+
 	err = mmc_power_cycle(mmc);
 	if (err) {
 		/*
@@ -3033,6 +3249,16 @@ static int mmc_complete_init(struct mmc *mmc)
 
 	if (!err)
 		err = mmc_startup(mmc);
+	if (err && mmc->handed_off) {
+		/* the card is not as SPL left it, so start again */
+		mmc->handed_off = false;
+		err = mmc_get_op_cond(mmc, false);
+		if (!err && mmc->op_cond_pending)
+			err = mmc_complete_op_cond(mmc);
+		if (!err)
+			err = mmc_startup(mmc);
+	}
+	mmc->handed_off = false;
 	if (err)
 		mmc->has_init = 0;
 	else
@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Recording the bus mode which worked for each card, so that it can be
+ * selected directly the next time the card is initialised
+ *
+ * Without this, the mode is found by trying each one from the fastest, with a
+ * switch, perhaps a tuning and a test transfer for each. The mode which worked
+ * is recorded against the card's CID. SPL passes its records to U-Boot proper
+ * in a bloblist. U-Boot proper keeps them in the 'mmc_modes' environment
+ * variable, which persists only if the user saves the environment, as a list
+ * of:
+ *
+ *	<cid>:<mode>:<width>
+ *
+ * with the CID as 32 hex digits, the mode as a hex number from enum bus_mode
+ * and the bus width in bits, most recently used first.
+ */
+
+#define LOG_CATEGORY UCLASS_MMC
+
+#include <bloblist.h>
+#include <env.h>
+#include <event.h>
+#include <log.h>
+#include <malloc.h>
+#include <mmc.h>
+#include <vsprintf.h>
+#include <asm/global_data.h>
+#include <linux/string.h>
+#include "mmc_private.h"
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define MMC_MODE_CACHE_VAR	"mmc_modes"
+
+enum {
+	MMC_MODE_CACHE_MAX	= 4,
+	MMC_MODE_CACHE_ENT_LEN	= 40,	/* " <cid>:<mode>:<width>" */
+};
+
+/**
+ * struct mmc_mode_rec - the bus mode which worked for a card
+ *
+ * @cid: Card identification, as read by mmc_startup()
+ * @mode: Bus mode (enum bus_mode)
+ * @width: Bus width in bits, or 0 if this record is not used
+ * @rsvd: Reserved, set to 0
+ */
+struct mmc_mode_rec {
+	u32 cid[4];
+	u8 mode;
+	u8 width;
+	u8 rsvd[2];
+};
+
+/**
+ * struct mmc_mode_list - records, most recently used first
+ *
+ * This is also the hand-off from SPL, in BLOBLISTT_U_BOOT_MMC_MODE
+ *
+ * @rec: Records; unused ones are at the end
+ */
+struct mmc_mode_list {
+	struct mmc_mode_rec rec[MMC_MODE_CACHE_MAX];
+};
+
+/* records in U-Boot proper of the modes selected during this boot */
+static struct mmc_mode_list mmc_mode_list;
+
+/*
+ * Get the list to update: the hand-off in SPL, else the one in memory, which
+ * is not used before relocation, when there is no BSS
+ */
+static struct mmc_mode_list *mmc_mode_cache_list(void)
+{
+	if (IS_ENABLED(CONFIG_XPL_BUILD))
+		return bloblist_ensure(BLOBLISTT_U_BOOT_MMC_MODE,
+				       sizeof(struct mmc_mode_list));
+	if (!(gd->flags & GD_FLG_RELOC))
+		return NULL;
+
+	return &mmc_mode_list;
+}
+
+static const struct mmc_mode_rec *mmc_mode_list_find(
+		const struct mmc_mode_list *list, const u32 *cid)
+{
+	int i;
+
+	for (i = 0; i < MMC_MODE_CACHE_MAX && list->rec[i].width; i++) {
+		if (!memcmp(list->rec[i].cid, cid, sizeof(list->rec[i].cid)))
+			return &list->rec[i];
+	}
+
+	return NULL;
+}
+
+/* Put @rec at the front of @list, replacing any record for the same card */
+static void mmc_mode_list_set(struct mmc_mode_list *list,
+			      const struct mmc_mode_rec *rec)
+{
+	struct mmc_mode_rec new = *rec;
+	int i;
+
+	for (i = 0; i < MMC_MODE_CACHE_MAX - 1; i++) {
+		if (!list->rec[i].width ||
+		    !memcmp(list->rec[i].cid, new.cid, sizeof(new.cid)))
+			break;
+	}
+	memmove(&list->rec[1], &list->rec[0], i * sizeof(new));
+	list->rec[0] = new;
+}
+
+static int mmc_mode_list_parse(struct mmc_mode_list *list, const char *str)
+{
+	char hex[9], *end;
+	int i, j;
+
+	memset(list, '\0', sizeof(*list));
+	for (i = 0; *str && i < MMC_MODE_CACHE_MAX; i++) {
+		struct mmc_mode_rec *rec = &list->rec[i];
+
+		for (j = 0; j < ARRAY_SIZE(rec->cid); j++, str += 8) {
+			strlcpy(hex, str, sizeof(hex));
+			if (strlen(hex) != 8)
+				return -EINVAL;
+			rec->cid[j] = hextoul(hex, &end);
+			if (*end)
+				return -EINVAL;
+		}
+		if (*str++ != ':')
+			return -EINVAL;
+		rec->mode = hextoul(str, &end);
+		if (*end++ != ':' || rec->mode >= MMC_MODES_END)
+			return -EINVAL;
+		rec->width = hextoul(end, &end);
+		if (rec->width != 1 && rec->width != 4 && rec->width != 8)
+			return -EINVAL;
+		if (*end && *end++ != ' ')
+			return -EINVAL;
+		str = end;
+	}
+
+	return 0;
+}
+
+int mmc_mode_cache_find(struct mmc *mmc, uint *capsp)
+{
+	const struct mmc_mode_rec *rec = NULL;
+	struct mmc_mode_list *list, env_list;
+	const char *str;
+
+	list = mmc_mode_cache_list();
+	if (list)
+		rec = mmc_mode_list_find(list, mmc->cid);
+
+	/* U-Boot proper looks at what SPL found, then at earlier boots */
+	if (!rec && !IS_ENABLED(CONFIG_XPL_BUILD) &&
+	    CONFIG_IS_ENABLED(BLOBLIST)) {
+		list = bloblist_find(BLOBLISTT_U_BOOT_MMC_MODE, sizeof(*list));
+		if (list)
+			rec = mmc_mode_list_find(list, mmc->cid);
+	}
+	if (!rec && !IS_ENABLED(CONFIG_XPL_BUILD)) {
+		str = env_get(MMC_MODE_CACHE_VAR);
+		if (str && !mmc_mode_list_parse(&env_list, str))
+			rec = mmc_mode_list_find(&env_list, mmc->cid);
+	}
+	if (!rec)
+		return -ENOENT;
+
+	*capsp = MMC_CAP(rec->mode);
+	if (rec->width == 8)
+		*capsp |= MMC_MODE_8BIT;
+	else if (rec->width == 4)
+		*capsp |= MMC_MODE_4BIT;
+	else
+		*capsp |= MMC_MODE_1BIT;
+
+	return 0;
+}
+
+void mmc_mode_cache_add(struct mmc *mmc)
+{
+	struct mmc_mode_list *list = mmc_mode_cache_list();
+	struct mmc_mode_rec rec = {
+		.mode	= mmc->selected_mode,
+		.width	= mmc->bus_width,
+	};
+
+	if (!list)
+		return;
+	memcpy(rec.cid, mmc->cid, sizeof(rec.cid));
+	mmc_mode_list_set(list, &rec);
+}
+
+void mmc_mode_cache_drop(struct mmc *mmc)
+{
+	struct mmc_mode_list *list = mmc_mode_cache_list();
+	struct mmc_mode_rec *rec;
+	int i;
+
+	if (!list)
+		return;
+	rec = (struct mmc_mode_rec *)mmc_mode_list_find(list, mmc->cid);
+	if (!rec)
+		return;
+	i = rec - list->rec;
+	memmove(rec, rec + 1, (MMC_MODE_CACHE_MAX - 1 - i) * sizeof(*rec));
+	memset(&list->rec[MMC_MODE_CACHE_MAX - 1], '\0', sizeof(*rec));
+}
+
+int mmc_mode_cache_save(void)
+{
+	struct mmc_mode_list *list = mmc_mode_cache_list();
+	struct mmc_mode_list new;
+	const char *old;
+	char *buf, *p;
+	int i, ret;
+
+	if (IS_ENABLED(CONFIG_XPL_BUILD) || !list || !list->rec[0].width)
+		return 0;
+
+	/* keep the records of cards which were not seen during this boot */
+	old = env_get(MMC_MODE_CACHE_VAR);
+	if (!old || mmc_mode_list_parse(&new, old))
+		memset(&new, '\0', sizeof(new));
+	for (i = MMC_MODE_CACHE_MAX - 1; i >= 0; i--) {
+		if (list->rec[i].width)
+			mmc_mode_list_set(&new, &list->rec[i]);
+	}
+
+	buf = malloc(MMC_MODE_CACHE_MAX * MMC_MODE_CACHE_ENT_LEN);
+	if (!buf)
+		return log_msg_ret("mmc", -ENOMEM);
+	p = buf;
+	*p = '\0';
+	for (i = 0; i < MMC_MODE_CACHE_MAX && new.rec[i].width; i++) {
+		struct mmc_mode_rec *rec = &new.rec[i];
+
+		p += sprintf(p, "%s%08x%08x%08x%08x:%x:%x", p == buf ? "" : " ",
+			     rec->cid[0], rec->cid[1], rec->cid[2], rec->cid[3],
+			     rec->mode, rec->width);
+	}
+
+	ret = env_set(MMC_MODE_CACHE_VAR, buf);
+	free(buf);
+	if (ret)
+		return log_msg_ret("mms", ret);
+
+	return 0;
+}
+
+#ifndef CONFIG_XPL_BUILD
+static int mmc_mode_cache_main_loop(void)
+{
+	return mmc_mode_cache_save();
+}
+EVENT_SPY_SIMPLE(EVT_MAIN_LOOP, mmc_mode_cache_main_loop);
+#endif
@@ -132,4 +132,68 @@ int mmc_switch_part(struct mmc *mmc, unsigned int part_num);
  */
 int mmc_switch(struct mmc *mmc, u8 set, u8 index, u8 value);
 
+#if CONFIG_IS_ENABLED(MMC_MODE_CACHE)
+/**
+ * mmc_mode_cache_find() - Find the bus mode which worked before for a card
+ *
+ * This looks at the modes selected during this boot, then those passed on by
+ * SPL, then those in the environment.
+ *
+ * @mmc:	MMC device, whose CID has been read
+ * @capsp:	Returns the capabilities for the mode and bus width
+ * Return: 0 if OK, -ENOENT if there is no record for the card
+ */
+int mmc_mode_cache_find(struct mmc *mmc, uint *capsp);
+
+/**
+ * mmc_mode_cache_add() - Record the bus mode which has been selected
+ *
+ * @mmc:	MMC device, whose mode and bus width have been selected
+ */
+void mmc_mode_cache_add(struct mmc *mmc);
+
+/**
+ * mmc_mode_cache_drop() - Drop the record for a card whose mode failed
+ *
+ * @mmc:	MMC device
+ */
+void mmc_mode_cache_drop(struct mmc *mmc);
+
+/**
+ * mmc_mode_cache_save() - Update the environment with the modes selected
+ *
+ * This sets the 'mmc_modes' variable, but does not save the environment. It
+ * is done automatically when the command line starts.
+ *
+ * Return: 0 if OK, -ve on error
+ */
+int mmc_mode_cache_save(void);
+#else
+static inline int mmc_mode_cache_find(struct mmc *mmc, uint *capsp)
+{
+	return -ENOENT;
+}
+
+static inline void mmc_mode_cache_add(struct mmc *mmc) {}
+static inline void mmc_mode_cache_drop(struct mmc *mmc) {}
+static inline int mmc_mode_cache_save(void) { return 0; }
+#endif
+
+#if CONFIG_IS_ENABLED(BLK_STATS)
+static inline void mmc_stats_cmd(struct mmc *mmc, int ret)
+{
+	mmc->stats.cmds++;
+	if (ret)
+		mmc->stats.cmd_errors++;
+}
+
+static inline void mmc_stats_retry(struct mmc *mmc)
+{
+	mmc->stats.retries++;
+}
+#else
+static inline void mmc_stats_cmd(struct mmc *mmc, int ret) {}
+static inline void mmc_stats_retry(struct mmc *mmc) {}
+#endif
+
 #endif /* _MMC_PRIVATE_H_ */
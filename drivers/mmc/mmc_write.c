@@ -138,12 +138,51 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 	return blk;
 }
 
+/**
+ * mmc_can_set_block_count() - Check whether writes can use CMD23
+ *
+ * eMMC from v4 onwards always supports SET_BLOCK_COUNT, SD cards
+ * advertise it through the CMD_SUPPORT field of the SCR.
+ *
+ * @mmc:	MMC device
+ * Return: true if multi-block writes may be pre-defined with CMD23
+ */
+static bool mmc_can_set_block_count(struct mmc *mmc)
+{
+	if (!IS_ENABLED(CONFIG_MMC_WRITE_SET_BLOCK_COUNT) ||
+	    mmc_host_is_spi(mmc))
+		return false;
+
+	if (IS_SD(mmc))
+		return mmc->scr[0] & SD_SCR_CMD23_SUPPORT;
+
+	return mmc->version >= MMC_VERSION_4;
+}
+
+static int mmc_set_block_count(struct mmc *mmc, lbaint_t blkcnt)
+{
+	struct mmc_cmd cmd;
+
+	/* Bit 31 (reliable write) is left clear on purpose */
+	cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+	cmd.cmdarg = blkcnt & 0xffff;
+	cmd.resp_type = MMC_RSP_R1;
+
+	if (mmc_send_cmd(mmc, &cmd, NULL)) {
+		printf("mmc fail to set block count\n");
+		return -EIO;
+	}
+
+	return 0;
+}
+
 static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 		lbaint_t blkcnt, const void *src)
 {
 	struct mmc_cmd cmd;
 	struct mmc_data data;
 	int timeout_ms = 1000;
+	bool sbc;
 
 	if ((start + blkcnt) > mmc_get_blk_desc(mmc)->lba) {
 		printf("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
@@ -170,15 +209,20 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	data.blocksize = mmc->write_bl_len;
 	data.flags = MMC_DATA_WRITE;
 
+	sbc = blkcnt > 1 && mmc_can_set_block_count(mmc);
+	if (sbc && mmc_set_block_count(mmc, blkcnt))
+		return 0;
+
 	if (mmc_send_cmd(mmc, &cmd, &data)) {
 		printf("mmc write failed\n");
 		return 0;
 	}
 
 	/* SPI multiblock writes terminate using a special
-	 * token, not a STOP_TRANSMISSION request.
+	 * token, not a STOP_TRANSMISSION request. Pre-defined
+	 * transfers end by themselves once blkcnt blocks are sent.
 	 */
-	if (!mmc_host_is_spi(mmc) && blkcnt > 1) {
+	if (!mmc_host_is_spi(mmc) && blkcnt > 1 && !sbc) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -207,7 +251,7 @@ ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
 #endif
 	int dev_num = block_dev->devnum;
-	lbaint_t cur, blocks_todo = blkcnt;
+	lbaint_t cur, max, grp, blocks_todo = blkcnt;
 	int err;
 
 	struct mmc *mmc = find_mmc_device(dev_num);
@@ -221,9 +265,21 @@ ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
+	/* CMD23 carries a 16-bit block count */
+	max = mmc->cfg->b_max;
+	if (mmc_can_set_block_count(mmc))
+		max = min_t(lbaint_t, max, 0xffff);
+
 	do {
-		cur = (blocks_todo > mmc->cfg->b_max) ?
-			mmc->cfg->b_max : blocks_todo;
+		cur = (blocks_todo > max) ? max : blocks_todo;
+		/*
+		 * Cut large writes at erase group boundaries so that each
+		 * transfer after the first covers whole groups, which lets
+		 * the card program them without a read-modify-write.
+		 */
+		grp = mmc->erase_grp_size;
+		if (cur == max && grp > 1 && max > grp)
+			cur -= (start + cur) & (grp - 1);
 		if (mmc_write_blocks(mmc, start, cur, src) != cur)
 			return 0;
 		blocks_todo -= cur;
@@ -13,13 +13,17 @@
  * proper DM_MMC implementation at the end.
  */
 
+#include <cpu_func.h>
 #include <dm.h>
+#include <env.h>
 #include <errno.h>
 #include <log.h>
 #include <malloc.h>
 #include <mmc.h>
 #include <clk.h>
 #include <reset.h>
+#include <power/regulator.h>
+#include <asm/cache.h>
 #include <asm/gpio.h>
 #include <asm/io.h>
 #include <asm/arch/clock.h>
@@ -28,6 +32,8 @@
 #include <asm/arch/mmc.h>
 #endif
 #include <linux/delay.h>
+#include <linux/iopoll.h>
+#include <linux/kernel.h>
 #include <sunxi_gpio.h>
 
 #include "sunxi_mmc.h"
@@ -36,6 +42,14 @@
 #define CCM_MMC_CTRL_MODE_SEL_NEW	0
 #endif
 
+/* Number of IDMA descriptors in the ring allocated at probe time */
+#define SUNXI_MMC_IDMA_DES_NUM		128
+
+struct sunxi_mmc_variant {
+	u8 idma_des_size_bits;	/* width of the descriptor buffer size field */
+	u8 idma_des_shift;	/* descriptor addresses are in words */
+};
+
 struct sunxi_mmc_plat {
 	struct mmc_config cfg;
 	struct mmc mmc;
@@ -48,6 +62,12 @@ struct sunxi_mmc_priv {
 	struct gpio_desc cd_gpio;	/* Change Detect GPIO */
 	struct sunxi_mmc *reg;
 	struct mmc_config cfg;
+	struct sunxi_mmc_idma_des *idma_des;	/* IDMA descriptor ring */
+	unsigned int idma_buf_size;	/* max bytes per descriptor */
+	unsigned int idma_des_shift;
+	unsigned int samp_dl;		/* tuned sample delay, 0 if untuned */
+	bool ddr;			/* DDR timing selected */
+	enum mmc_voltage signal_voltage;
 };
 
 /*
@@ -64,16 +84,21 @@ static bool sunxi_mmc_can_calibrate(void)
 	       IS_ENABLED(CONFIG_MACH_SUN8I_R40);
 }
 
+static bool sunxi_mmc_new_mode(struct sunxi_mmc_priv *priv)
+{
+	/* A83T support new mode only on eMMC */
+	if (IS_ENABLED(CONFIG_MACH_SUN8I_A83T) && priv->mmc_no != 2)
+		return false;
+
+	return IS_ENABLED(CONFIG_MMC_SUNXI_HAS_NEW_MODE);
+}
+
 static int mmc_set_mod_clk(struct sunxi_mmc_priv *priv, unsigned int hz)
 {
 	unsigned int pll, pll_hz, div, n, oclk_dly, sclk_dly;
-	bool new_mode = IS_ENABLED(CONFIG_MMC_SUNXI_HAS_NEW_MODE);
+	bool new_mode = sunxi_mmc_new_mode(priv);
 	u32 val = 0;
 
-	/* A83T support new mode only on eMMC */
-	if (IS_ENABLED(CONFIG_MACH_SUN8I_A83T) && priv->mmc_no != 2)
-		new_mode = false;
-
 	if (hz <= 24000000) {
 		pll = CCM_MMC_CTRL_OSCM24;
 		pll_hz = 24000000;
@@ -177,9 +202,40 @@ static int mmc_update_clk(struct sunxi_mmc_priv *priv)
 	return 0;
 }
 
+static void sunxi_mmc_set_samp_dl(struct sunxi_mmc_priv *priv,
+				  unsigned int samp_dl)
+{
+#if defined(CONFIG_SUNXI_GEN_SUN6I) || defined(CONFIG_SUN50I_GEN_H6) || defined(CONFIG_SUNXI_GEN_NCAT2)
+	/* A64 supports calibration of delays on MMC controller and we
+	 * have to set delay of zero before starting calibration.
+	 * Allwinner BSP driver sets a delay only in the case of
+	 * using HS400 which is not supported by mainline U-Boot or
+	 * Linux at the moment. A non-zero value is only used after
+	 * tuning for HS200 or SDR104/SDR50 found a better sample point.
+	 */
+	if (sunxi_mmc_can_calibrate())
+		writel(SUNXI_MMC_CAL_DL_SW_EN |
+		       (samp_dl & SUNXI_MMC_CAL_DL_SW_MASK),
+		       &priv->reg->samp_dl);
+#endif
+}
+
 static int mmc_config_clock(struct sunxi_mmc_priv *priv, struct mmc *mmc)
 {
 	unsigned rval = readl(&priv->reg->clkcr);
+	unsigned int hz = mmc->clock, div = 1;
+
+	/*
+	 * Under the old timing mode, 8 bit DDR requires the module clock to
+	 * be double the card clock. Under the new timing mode, all DDR modes
+	 * require a doubled module clock. The internal divider brings the
+	 * card clock back down.
+	 */
+	if (mmc_is_mode_ddr(mmc->selected_mode) &&
+	    (sunxi_mmc_new_mode(priv) || mmc->bus_width == 8)) {
+		hz <<= 1;
+		div = 2;
+	}
 
 	/* Disable Clock */
 	rval &= ~SUNXI_MMC_CLK_ENABLE;
@@ -188,23 +244,15 @@ static int mmc_config_clock(struct sunxi_mmc_priv *priv, struct mmc *mmc)
 		return -1;
 
 	/* Set mod_clk to new rate */
-	if (mmc_set_mod_clk(priv, mmc->clock))
+	if (mmc_set_mod_clk(priv, hz))
 		return -1;
 
-	/* Clear internal divider */
+	/* Set internal divider */
 	rval &= ~SUNXI_MMC_CLK_DIVIDER_MASK;
+	rval |= div - 1;
 	writel(rval, &priv->reg->clkcr);
 
-#if defined(CONFIG_SUNXI_GEN_SUN6I) || defined(CONFIG_SUN50I_GEN_H6) || defined(CONFIG_SUNXI_GEN_NCAT2)
-	/* A64 supports calibration of delays on MMC controller and we
-	 * have to set delay of zero before starting calibration.
-	 * Allwinner BSP driver sets a delay only in the case of
-	 * using HS400 which is not supported by mainline U-Boot or
-	 * Linux at the moment
-	 */
-	if (sunxi_mmc_can_calibrate())
-		writel(SUNXI_MMC_CAL_DL_SW_EN, &priv->reg->samp_dl);
-#endif
+	sunxi_mmc_set_samp_dl(priv, priv->samp_dl);
 
 	/* Re-enable Clock */
 	rval |= SUNXI_MMC_CLK_ENABLE;
@@ -215,11 +263,20 @@ static int mmc_config_clock(struct sunxi_mmc_priv *priv, struct mmc *mmc)
 	return 0;
 }
 
+static bool sunxi_mmc_mode_needs_tuning(enum bus_mode mode)
+{
+	return mode == MMC_HS_200 || mode == UHS_SDR104 || mode == UHS_SDR50;
+}
+
 static int sunxi_mmc_set_ios_common(struct sunxi_mmc_priv *priv,
 				    struct mmc *mmc)
 {
-	debug("set ios: bus_width: %x, clock: %d\n",
-	      mmc->bus_width, mmc->clock);
+	debug("set ios: bus_width: %x, clock: %d, mode: %s\n",
+	      mmc->bus_width, mmc->clock, mmc_mode_name(mmc->selected_mode));
+
+	/* A tuned sample point is only valid for the mode it was found in */
+	if (!sunxi_mmc_mode_needs_tuning(mmc->selected_mode))
+		priv->samp_dl = 0;
 
 	/* Change clock first */
 	if (mmc->clock && mmc_config_clock(priv, mmc) != 0) {
@@ -235,6 +292,13 @@ static int sunxi_mmc_set_ios_common(struct sunxi_mmc_priv *priv,
 	else
 		writel(0x0, &priv->reg->width);
 
+	/* Select DDR timing for DDR52 (and UHS DDR50) */
+	priv->ddr = mmc_is_mode_ddr(mmc->selected_mode);
+	if (priv->ddr)
+		setbits_le32(&priv->reg->gctrl, SUNXI_MMC_GCTRL_DDR_MODE);
+	else
+		clrbits_le32(&priv->reg->gctrl, SUNXI_MMC_GCTRL_DDR_MODE);
+
 	return 0;
 }
 
@@ -300,6 +364,116 @@ static int mmc_trans_data_by_cpu(struct sunxi_mmc_priv *priv, struct mmc *mmc,
 	return 0;
 }
 
+/*
+ * Use the internal DMA controller only for multi-block transfers into
+ * cache-line aligned buffers that fit into the descriptor ring. Everything
+ * else (small register-like reads such as the SCR or EXT_CSD, and unaligned
+ * buffers) keeps going through the FIFO by CPU.
+ */
+static bool sunxi_mmc_can_use_dma(struct sunxi_mmc_priv *priv,
+				  struct mmc_data *data)
+{
+	const int reading = !!(data->flags & MMC_DATA_READ);
+	ulong buff = (ulong)(reading ? data->dest : data->src);
+	unsigned int bytecnt = data->blocksize * data->blocks;
+	phys_addr_t end;
+
+	if (!CONFIG_IS_ENABLED(MMC_SUNXI_IDMA) || !priv->idma_des)
+		return false;
+
+	if (data->blocks < 2)
+		return false;
+
+	if (!IS_ALIGNED(buff, ARCH_DMA_MINALIGN) ||
+	    !IS_ALIGNED(bytecnt, ARCH_DMA_MINALIGN))
+		return false;
+
+	if (bytecnt > SUNXI_MMC_IDMA_DES_NUM * priv->idma_buf_size)
+		return false;
+
+	end = virt_to_phys((void *)(buff + bytecnt - 1));
+	if (upper_32_bits(end >> priv->idma_des_shift))
+		return false;
+
+	return true;
+}
+
+static void mmc_trans_data_by_dma_start(struct sunxi_mmc_priv *priv,
+					struct mmc_data *data)
+{
+	const int reading = !!(data->flags & MMC_DATA_READ);
+	ulong buff = (ulong)(reading ? data->dest : data->src);
+	unsigned int bytecnt = data->blocksize * data->blocks;
+	struct sunxi_mmc_idma_des *des = priv->idma_des;
+	ulong des_phys = virt_to_phys(des);
+	unsigned int i, len;
+
+	for (i = 0; bytecnt; i++) {
+		len = min(bytecnt, priv->idma_buf_size);
+
+		des[i].config = cpu_to_le32(SUNXI_MMC_IDMA_DES0_CH |
+					    SUNXI_MMC_IDMA_DES0_OWN |
+					    SUNXI_MMC_IDMA_DES0_DIC);
+		des[i].buf_size = cpu_to_le32(len);
+		des[i].buf_addr = cpu_to_le32(virt_to_phys((void *)buff) >>
+					      priv->idma_des_shift);
+		des[i].next_desc = cpu_to_le32((des_phys + (i + 1) *
+						sizeof(*des)) >>
+					       priv->idma_des_shift);
+		buff += len;
+		bytecnt -= len;
+	}
+	des[0].config |= cpu_to_le32(SUNXI_MMC_IDMA_DES0_FD);
+	des[i - 1].config |= cpu_to_le32(SUNXI_MMC_IDMA_DES0_LD |
+					 SUNXI_MMC_IDMA_DES0_ER);
+	des[i - 1].config &= cpu_to_le32(~SUNXI_MMC_IDMA_DES0_DIC);
+	des[i - 1].next_desc = 0;
+
+	flush_dcache_range((ulong)des,
+			   roundup((ulong)&des[i], ARCH_DMA_MINALIGN));
+
+	buff = (ulong)(reading ? data->dest : data->src);
+	bytecnt = data->blocksize * data->blocks;
+	/* Write back dirty lines, so they can't be evicted over DMA data */
+	flush_dcache_range(buff, buff + bytecnt);
+
+	/* Hand the FIFO to the IDMAC and start it */
+	clrbits_le32(&priv->reg->gctrl, SUNXI_MMC_GCTRL_ACCESS_BY_AHB);
+	setbits_le32(&priv->reg->gctrl, SUNXI_MMC_GCTRL_DMA_ENABLE |
+		     SUNXI_MMC_GCTRL_DMA_RESET);
+	writel(SUNXI_MMC_IDMAC_RESET, &priv->reg->dmac);
+	writel(SUNXI_MMC_IDST_ALL, &priv->reg->idst);
+	writel(0, &priv->reg->idie);
+	writel(SUNXI_MMC_FTRGLEVEL_IDMA, &priv->reg->ftrglevel);
+	writel(des_phys >> priv->idma_des_shift, &priv->reg->dlba);
+	writel(SUNXI_MMC_IDMAC_FIXBURST | SUNXI_MMC_IDMAC_ENABLE,
+	       &priv->reg->dmac);
+}
+
+static int mmc_trans_data_by_dma_stop(struct sunxi_mmc_priv *priv,
+				      struct mmc_data *data)
+{
+	u32 idst = readl(&priv->reg->idst);
+
+	writel(SUNXI_MMC_IDMAC_RESET, &priv->reg->dmac);
+	writel(SUNXI_MMC_IDST_ALL, &priv->reg->idst);
+	clrbits_le32(&priv->reg->gctrl, SUNXI_MMC_GCTRL_DMA_ENABLE);
+
+	if (data->flags & MMC_DATA_READ) {
+		ulong buff = (ulong)data->dest;
+
+		invalidate_dcache_range(buff, buff + data->blocksize *
+					data->blocks);
+	}
+
+	if (idst & SUNXI_MMC_IDST_ERROR) {
+		debug("mmc %u idma error %x\n", priv->mmc_no, idst);
+		return -EIO;
+	}
+
+	return 0;
+}
+
 static int mmc_rint_wait(struct sunxi_mmc_priv *priv, struct mmc *mmc,
 			 uint timeout_msecs, uint done_bit, const char *what)
 {
@@ -328,6 +502,7 @@ static int sunxi_mmc_send_cmd_common(struct sunxi_mmc_priv *priv,
 	int error = 0;
 	unsigned int status = 0;
 	unsigned int bytecnt = 0;
+	bool dma = false;
 
 	if (priv->fatal_err)
 		return -1;
@@ -358,6 +533,10 @@ static int sunxi_mmc_send_cmd_common(struct sunxi_mmc_priv *priv,
 			cmdval |= SUNXI_MMC_CMD_AUTO_STOP;
 		writel(data->blocksize, &priv->reg->blksz);
 		writel(data->blocks * data->blocksize, &priv->reg->bytecnt);
+
+		dma = sunxi_mmc_can_use_dma(priv, data);
+		if (dma)
+			mmc_trans_data_by_dma_start(priv, data);
 	}
 
 	debug("mmc %d, cmd %d(0x%08x), arg 0x%08x\n", priv->mmc_no,
@@ -376,9 +555,10 @@ static int sunxi_mmc_send_cmd_common(struct sunxi_mmc_priv *priv,
 		int ret = 0;
 
 		bytecnt = data->blocksize * data->blocks;
-		debug("trans data %d bytes\n", bytecnt);
+		debug("trans data %d bytes%s\n", bytecnt, dma ? " by dma" : "");
 		writel(cmdval | cmd->cmdidx, &priv->reg->cmd);
-		ret = mmc_trans_data_by_cpu(priv, mmc, data);
+		if (!dma)
+			ret = mmc_trans_data_by_cpu(priv, mmc, data);
 		if (ret) {
 			error = readl(&priv->reg->rint) &
 				SUNXI_MMC_RINT_INTERRUPT_ERROR_BIT;
@@ -394,12 +574,22 @@ static int sunxi_mmc_send_cmd_common(struct sunxi_mmc_priv *priv,
 
 	if (data) {
 		timeout_msecs = 120;
+		/* With DMA the whole transfer is still in flight here */
+		if (dma)
+			timeout_msecs = max(2000U, bytecnt >> 8);
 		debug("cacl timeout %x msec\n", timeout_msecs);
 		error = mmc_rint_wait(priv, mmc, timeout_msecs,
 				      data->blocks > 1 ?
 				      SUNXI_MMC_RINT_AUTO_COMMAND_DONE :
 				      SUNXI_MMC_RINT_DATA_OVER,
 				      "data");
+		if (dma) {
+			int ret = mmc_trans_data_by_dma_stop(priv, data);
+
+			dma = false;
+			if (!error)
+				error = ret;
+		}
 		if (error)
 			goto out;
 	}
@@ -431,8 +621,13 @@ static int sunxi_mmc_send_cmd_common(struct sunxi_mmc_priv *priv,
 		debug("mmc resp 0x%08x\n", cmd->response[0]);
 	}
 out:
+	if (dma)
+		mmc_trans_data_by_dma_stop(priv, data);
 	if (error < 0) {
 		writel(SUNXI_MMC_GCTRL_RESET, &priv->reg->gctrl);
+		if (priv->ddr)
+			setbits_le32(&priv->reg->gctrl,
+				     SUNXI_MMC_GCTRL_DDR_MODE);
 		mmc_update_clk(priv);
 	}
 	writel(0xffffffff, &priv->reg->rint);
@@ -545,6 +740,7 @@ struct mmc *sunxi_mmc_init(int sdc_no)
 
 	if (mmc_resource_init(sdc_no) != 0)
 		return NULL;
+	cfg->reg = (ulong)priv->reg;
 
 	/* config ahb clock */
 	debug("init mmc %d clock and io\n", sdc_no);
@@ -574,11 +770,33 @@ struct mmc *sunxi_mmc_init(int sdc_no)
 
 #else /* CONFIG_DM_MMC code below, as used by U-Boot proper */
 
+static void sunxi_mmc_set_signal_voltage(struct sunxi_mmc_priv *priv,
+					 struct mmc *mmc)
+{
+#if CONFIG_IS_ENABLED(DM_REGULATOR)
+	int ret;
+
+	if (!mmc->vqmmc_supply || priv->signal_voltage == mmc->signal_voltage)
+		return;
+
+	/* Fixed supplies cannot be switched, which is fine */
+	ret = regulator_set_value(mmc->vqmmc_supply,
+				  mmc->signal_voltage == MMC_SIGNAL_VOLTAGE_180 ?
+				  1800000 : 3300000);
+	if (ret)
+		debug("mmc %u cannot switch signal voltage (%d)\n",
+		      priv->mmc_no, ret);
+	priv->signal_voltage = mmc->signal_voltage;
+#endif
+}
+
 static int sunxi_mmc_set_ios(struct udevice *dev)
 {
 	struct sunxi_mmc_plat *plat = dev_get_plat(dev);
 	struct sunxi_mmc_priv *priv = dev_get_priv(dev);
 
+	sunxi_mmc_set_signal_voltage(priv, &plat->mmc);
+
 	return sunxi_mmc_set_ios_common(priv, &plat->mmc);
 }
 
@@ -612,10 +830,123 @@ static int sunxi_mmc_getcd(struct udevice *dev)
 	return 1;
 }
 
+static int sunxi_mmc_wait_dat0(struct udevice *dev, int state,
+			       int timeout_us)
+{
+	struct sunxi_mmc_priv *priv = dev_get_priv(dev);
+	u32 status;
+
+	/* DAT0 low is reported as card busy */
+	return readl_poll_timeout(&priv->reg->status, status,
+				  !(status & SUNXI_MMC_STATUS_CARD_DATA_BUSY) ==
+				  !!state, timeout_us);
+}
+
+#if CONFIG_IS_ENABLED(MMC_SUPPORTS_TUNING)
+/*
+ * The tuned sample delay is remembered per controller in the environment,
+ * together with the card identity, mode and clock it was found for, e.g.
+ *   sunxi_mmc2_tuning=<cid>:<mode>:<clock>:<delay>
+ * A later initialisation of the same card only needs to verify it with a
+ * single tuning block. Run saveenv to keep it across boots.
+ */
+static void sunxi_mmc_tuning_key(struct sunxi_mmc_priv *priv, struct mmc *mmc,
+				 char *name, size_t name_len,
+				 char *prefix, size_t prefix_len)
+{
+	snprintf(name, name_len, "sunxi_mmc%u_tuning", priv->mmc_no);
+	snprintf(prefix, prefix_len, "%08x%08x%08x%08x:%u:%u:", mmc->cid[0],
+		 mmc->cid[1], mmc->cid[2], mmc->cid[3], mmc->selected_mode,
+		 mmc->clock);
+}
+
+static int sunxi_mmc_tuning_cache_get(struct sunxi_mmc_priv *priv,
+				      struct mmc *mmc)
+{
+	char name[24], prefix[64];
+	const char *val;
+
+	sunxi_mmc_tuning_key(priv, mmc, name, sizeof(name), prefix,
+			     sizeof(prefix));
+	val = env_get(name);
+	if (!val || strncmp(val, prefix, strlen(prefix)))
+		return -ENOENT;
+
+	return dectoul(val + strlen(prefix), NULL) & SUNXI_MMC_CAL_DL_SW_MASK;
+}
+
+static void sunxi_mmc_tuning_cache_set(struct sunxi_mmc_priv *priv,
+				       struct mmc *mmc, unsigned int samp_dl)
+{
+	char name[24], prefix[64], val[72];
+
+	sunxi_mmc_tuning_key(priv, mmc, name, sizeof(name), prefix,
+			     sizeof(prefix));
+	snprintf(val, sizeof(val), "%s%u", prefix, samp_dl);
+	env_set(name, val);
+}
+
+static int sunxi_mmc_execute_tuning(struct udevice *dev, uint opcode)
+{
+	struct sunxi_mmc_plat *plat = dev_get_plat(dev);
+	struct sunxi_mmc_priv *priv = dev_get_priv(dev);
+	struct mmc *mmc = &plat->mmc;
+	int start = -1, best_start = -1, best_len = 0;
+	int samp_dl;
+
+	if (!sunxi_mmc_can_calibrate())
+		return -ENOTSUPP;
+
+	samp_dl = sunxi_mmc_tuning_cache_get(priv, mmc);
+	if (samp_dl >= 0) {
+		sunxi_mmc_set_samp_dl(priv, samp_dl);
+		if (!mmc_send_tuning(mmc, opcode)) {
+			priv->samp_dl = samp_dl;
+			debug("mmc %u cached sample delay %d\n", priv->mmc_no,
+			      samp_dl);
+			return 0;
+		}
+	}
+
+	/* Find the widest window of passing sample delays */
+	for (samp_dl = 0; samp_dl <= SUNXI_MMC_CAL_DL_SW_MASK; samp_dl++) {
+		sunxi_mmc_set_samp_dl(priv, samp_dl);
+		if (mmc_send_tuning(mmc, opcode)) {
+			start = -1;
+			continue;
+		}
+		if (start < 0)
+			start = samp_dl;
+		if (samp_dl - start + 1 > best_len) {
+			best_start = start;
+			best_len = samp_dl - start + 1;
+		}
+	}
+
+	if (!best_len) {
+		sunxi_mmc_set_samp_dl(priv, priv->samp_dl);
+		debug("mmc %u tuning failed\n", priv->mmc_no);
+		return -EIO;
+	}
+
+	priv->samp_dl = best_start + best_len / 2;
+	sunxi_mmc_set_samp_dl(priv, priv->samp_dl);
+	sunxi_mmc_tuning_cache_set(priv, mmc, priv->samp_dl);
+	debug("mmc %u tuned sample delay %u (window %d..%d)\n", priv->mmc_no,
+	      priv->samp_dl, best_start, best_start + best_len - 1);
+
+	return 0;
+}
+#endif
+
 static const struct dm_mmc_ops sunxi_mmc_ops = {
 	.send_cmd	= sunxi_mmc_send_cmd,
 	.set_ios	= sunxi_mmc_set_ios,
 	.get_cd		= sunxi_mmc_getcd,
+	.wait_dat0	= sunxi_mmc_wait_dat0,
+#if CONFIG_IS_ENABLED(MMC_SUPPORTS_TUNING)
+	.execute_tuning	= sunxi_mmc_execute_tuning,
+#endif
 };
 
 static unsigned get_mclk_offset(void)
@@ -654,6 +985,15 @@ static int sunxi_mmc_probe(struct udevice *dev)
 	if (ret)
 		return ret;
 
+	/* DDR52 at 3.3V signalling is fine on this controller */
+	if (dev_read_bool(dev, "mmc-ddr-3_3v"))
+		cfg->host_caps |= MMC_MODE_DDR_52MHz;
+
+	/* Tuning of the sample point requires the calibration logic */
+	if (!sunxi_mmc_can_calibrate())
+		cfg->host_caps &= ~(MMC_MODE_HS200 | MMC_CAP(UHS_SDR50) |
+				    MMC_CAP(UHS_SDR104));
+
 	priv->reg = dev_read_addr_ptr(dev);
 
 	/* We don't have a sunxi clock driver so find the clock address here */
@@ -678,6 +1018,26 @@ static int sunxi_mmc_probe(struct udevice *dev)
 	if (ret)
 		return ret;
 
+	if (CONFIG_IS_ENABLED(MMC_SUNXI_IDMA)) {
+		const struct sunxi_mmc_variant *variant =
+			(void *)dev_get_driver_data(dev);
+
+		priv->idma_des = memalign(ARCH_DMA_MINALIGN,
+					  SUNXI_MMC_IDMA_DES_NUM *
+					  sizeof(*priv->idma_des));
+		if (!priv->idma_des)
+			return -ENOMEM;
+		/*
+		 * Stay one bit short of the size field width, so a full
+		 * descriptor never needs the "0 means maximum" encoding.
+		 */
+		priv->idma_buf_size = 1U << (variant->idma_des_size_bits - 1);
+		priv->idma_des_shift = variant->idma_des_shift;
+		/* Let the MMC core split requests to fit into the ring */
+		cfg->b_max = min_t(uint, cfg->b_max, SUNXI_MMC_IDMA_DES_NUM *
+				   priv->idma_buf_size / 512);
+	}
+
 	/* This GPIO is optional */
 	gpio_request_by_name(dev, "cd-gpios", 0, &priv->cd_gpio,
 			     GPIOD_IS_IN | GPIOD_PULL_UP);
@@ -698,19 +1058,54 @@ static int sunxi_mmc_bind(struct udevice *dev)
 	return mmc_bind(dev, &plat->mmc, &plat->cfg);
 }
 
+static const struct sunxi_mmc_variant sun4i_a10_variant = {
+	.idma_des_size_bits = 13,
+};
+
+static const struct sunxi_mmc_variant sun5i_a13_variant = {
+	.idma_des_size_bits = 16,
+};
+
+static const struct sunxi_mmc_variant sun20i_d1_variant = {
+	.idma_des_size_bits = 13,
+	.idma_des_shift = 2,
+};
+
+static const struct sunxi_mmc_variant sun50i_a100_variant = {
+	.idma_des_size_bits = 16,
+	.idma_des_shift = 2,
+};
+
+static const struct sunxi_mmc_variant sun50i_a100_emmc_variant = {
+	.idma_des_size_bits = 13,
+	.idma_des_shift = 2,
+};
+
 static const struct udevice_id sunxi_mmc_ids[] = {
-	{ .compatible = "allwinner,sun4i-a10-mmc" },
-	{ .compatible = "allwinner,sun5i-a13-mmc" },
-	{ .compatible = "allwinner,sun7i-a20-mmc" },
-	{ .compatible = "allwinner,sun8i-a83t-emmc" },
-	{ .compatible = "allwinner,sun9i-a80-mmc" },
-	{ .compatible = "allwinner,sun20i-d1-mmc" },
-	{ .compatible = "allwinner,sun50i-a64-mmc" },
-	{ .compatible = "allwinner,sun50i-a64-emmc" },
-	{ .compatible = "allwinner,sun50i-h6-mmc" },
-	{ .compatible = "allwinner,sun50i-h6-emmc" },
-	{ .compatible = "allwinner,sun50i-a100-mmc" },
-	{ .compatible = "allwinner,sun50i-a100-emmc" },
+	{ .compatible = "allwinner,sun4i-a10-mmc",
+	  .data = (ulong)&sun4i_a10_variant },
+	{ .compatible = "allwinner,sun5i-a13-mmc",
+	  .data = (ulong)&sun5i_a13_variant },
+	{ .compatible = "allwinner,sun7i-a20-mmc",
+	  .data = (ulong)&sun5i_a13_variant },
+	{ .compatible = "allwinner,sun8i-a83t-emmc",
+	  .data = (ulong)&sun5i_a13_variant },
+	{ .compatible = "allwinner,sun9i-a80-mmc",
+	  .data = (ulong)&sun5i_a13_variant },
+	{ .compatible = "allwinner,sun20i-d1-mmc",
+	  .data = (ulong)&sun20i_d1_variant },
+	{ .compatible = "allwinner,sun50i-a64-mmc",
+	  .data = (ulong)&sun5i_a13_variant },
+	{ .compatible = "allwinner,sun50i-a64-emmc",
+	  .data = (ulong)&sun4i_a10_variant },
+	{ .compatible = "allwinner,sun50i-h6-mmc",
+	  .data = (ulong)&sun5i_a13_variant },
+	{ .compatible = "allwinner,sun50i-h6-emmc",
+	  .data = (ulong)&sun4i_a10_variant },
+	{ .compatible = "allwinner,sun50i-a100-mmc",
+	  .data = (ulong)&sun50i_a100_variant },
+	{ .compatible = "allwinner,sun50i-a100-emmc",
+	  .data = (ulong)&sun50i_a100_emmc_variant },
 	{ /* sentinel */ }
 };
 
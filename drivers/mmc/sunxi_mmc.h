@@ -64,6 +64,7 @@ struct sunxi_mmc {
 					 SUNXI_MMC_GCTRL_FIFO_RESET|\
 					 SUNXI_MMC_GCTRL_DMA_RESET)
 #define SUNXI_MMC_GCTRL_DMA_ENABLE	(0x1 << 5)
+#define SUNXI_MMC_GCTRL_DDR_MODE	(0x1 << 10)
 #define SUNXI_MMC_GCTRL_ACCESS_BY_AHB   (0x1 << 31)
 
 #define SUNXI_MMC_CMD_RESP_EXPIRE	(0x1 << 6)
@@ -130,9 +131,37 @@ struct sunxi_mmc {
 #define SUNXI_MMC_IDIE_TXIRQ		(0x1 << 0)
 #define SUNXI_MMC_IDIE_RXIRQ		(0x1 << 1)
 
+#define SUNXI_MMC_IDST_FATAL_BUS_ERROR	(0x1 << 2)
+#define SUNXI_MMC_IDST_DES_UNAVAILABLE	(0x1 << 4)
+#define SUNXI_MMC_IDST_CARD_ERR_SUM	(0x1 << 5)
+#define SUNXI_MMC_IDST_ERROR		(SUNXI_MMC_IDST_FATAL_BUS_ERROR |\
+					 SUNXI_MMC_IDST_DES_UNAVAILABLE |\
+					 SUNXI_MMC_IDST_CARD_ERR_SUM)
+#define SUNXI_MMC_IDST_ALL		0x3ff
+
+/* FIFO watermark for IDMA: burst size 8, RX level 7, TX level 8 */
+#define SUNXI_MMC_FTRGLEVEL_IDMA	0x20070008
+
+/* Internal DMA controller descriptor, chain mode */
+struct sunxi_mmc_idma_des {
+	u32 config;
+	u32 buf_size;
+	u32 buf_addr;
+	u32 next_desc;
+};
+
+#define SUNXI_MMC_IDMA_DES0_DIC		(0x1 << 1)  /* no irq on completion */
+#define SUNXI_MMC_IDMA_DES0_LD		(0x1 << 2)  /* last descriptor */
+#define SUNXI_MMC_IDMA_DES0_FD		(0x1 << 3)  /* first descriptor */
+#define SUNXI_MMC_IDMA_DES0_CH		(0x1 << 4)  /* chain mode */
+#define SUNXI_MMC_IDMA_DES0_ER		(0x1 << 5)  /* end of ring */
+#define SUNXI_MMC_IDMA_DES0_CES		(0x1 << 30) /* card error summary */
+#define SUNXI_MMC_IDMA_DES0_OWN		(0x1 << 31) /* owned by the IDMAC */
+
 #define SUNXI_MMC_COMMON_CLK_GATE		(1 << 16)
 #define SUNXI_MMC_COMMON_RESET			(1 << 18)
 
+#define SUNXI_MMC_CAL_DL_SW_MASK	(0x3f)
 #define SUNXI_MMC_CAL_DL_SW_EN		(0x1 << 7)
 
 #endif /* _SUNXI_MMC_H */
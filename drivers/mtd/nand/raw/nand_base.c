@@ -2282,6 +2282,26 @@ static int nand_setup_read_retry(struct mtd_info *mtd, int retry_mode)
 	return chip->setup_read_retry(mtd, retry_mode);
 }
 
+/**
+ * nand_read_retry_mode - [INTERN] Get the READ RETRY mode for a retry
+ * @chip: NAND chip object
+ * @retry: the number of the retry of the page, starting at 1
+ *
+ * Pages in a block tend to need the same threshold, so the mode which last
+ * gave a good read is tried first, followed by the other ones in order.
+ */
+static int nand_read_retry_mode(struct nand_chip *chip, int retry)
+{
+	int last = chip->read_retry_last;
+
+	if (last <= 0 || last >= chip->read_retries)
+		return retry;
+	if (retry == 1)
+		return last;
+
+	return retry <= last ? retry - 1 : retry;
+}
+
 /**
  * nand_do_read_ops - [INTERN] Read data with ECC
  * @mtd: MTD device structure
@@ -2303,7 +2323,7 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 	uint8_t *bufpoi, *oob, *buf;
 	int use_bufpoi;
 	unsigned int max_bitflips = 0;
-	int retry_mode = 0;
+	int retry_mode = 0, retry = 0;
 	bool ecc_fail = false;
 
 	chipnr = (int)(from >> chip->chip_shift);
@@ -2406,8 +2426,10 @@ read_retry:
 			}
 
 			if (mtd->ecc_stats.failed - ecc_failures) {
-				if (retry_mode + 1 < chip->read_retries) {
-					retry_mode++;
+				if (retry + 1 < chip->read_retries) {
+					retry++;
+					retry_mode = nand_read_retry_mode(chip,
+									  retry);
 					ret = nand_setup_read_retry(mtd,
 							retry_mode);
 					if (ret < 0)
@@ -2420,6 +2442,8 @@ read_retry:
 					/* No more retry modes; real failure */
 					ecc_fail = true;
 				}
+			} else if (retry_mode) {
+				chip->read_retry_last = retry_mode;
 			}
 
 			buf += bytes;
@@ -2439,6 +2463,7 @@ read_retry:
 				break;
 			retry_mode = 0;
 		}
+		retry = 0;
 
 		if (!readlen)
 			break;
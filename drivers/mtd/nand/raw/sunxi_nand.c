@@ -25,6 +25,7 @@
  */
 
 #include <clk.h>
+#include <cpu_func.h>
 #include <dm.h>
 #include <malloc.h>
 #include <memalign.h>
@@ -45,6 +46,9 @@
 
 #include <asm/gpio.h>
 #include <asm/arch/clock.h>
+#if IS_ENABLED(CONFIG_NAND_SUNXI_DMA)
+#include <asm/arch/dma.h>
+#endif
 
 #define NFC_REG_CTL		0x0000
 #define NFC_REG_ST		0x0004
@@ -169,6 +173,9 @@
 
 #define NFC_MAX_CS		7
 
+/* dedicated DMA channel used for the batch page reads */
+#define NFC_DDMA_CHAN		0
+
 /*
  * Ready/Busy detection type: describes the Ready/Busy detection modes
  *
@@ -1044,6 +1051,193 @@ static int sunxi_nfc_hw_ecc_read_page(struct mtd_info *mtd,
 	return max_bitflips;
 }
 
+#if IS_ENABLED(CONFIG_NAND_SUNXI_DMA)
+static void sunxi_nfc_dma_start(struct sunxi_nfc *nfc, void *buf, int len)
+{
+	struct sunxi_dma *const dma = (struct sunxi_dma *)SUNXI_DMA_BASE;
+	struct sunxi_dma_cfg *const cfg = &dma->ddma[NFC_DDMA_CHAN];
+
+	/* don't let dirty lines be written back over the DMA data */
+	flush_dcache_range((ulong)buf, (ulong)buf + len);
+
+	writel(SUNXI_DMA_IRQ_DDMA_HALF(NFC_DDMA_CHAN) |
+	       SUNXI_DMA_IRQ_DDMA_END(NFC_DDMA_CHAN), &dma->irq_pend);
+	writel((ulong)nfc->regs + NFC_REG_IO_DATA, &cfg->src_addr);
+	writel((ulong)buf, &cfg->dst_addr);
+	writel(len, &cfg->bc);
+	writel(SUNXI_DDMA_PARA(1, 2, 1, 2), &cfg->ddma_para);
+	writel(SUNXI_DMA_CTL_SRC_DRQ(DDMA_SRC_DRQ_NAND) |
+	       SUNXI_DMA_CTL_MODE_IO | SUNXI_DMA_CTL_SRC_BURST_4 |
+	       SUNXI_DMA_CTL_SRC_DATA_WIDTH_32 |
+	       SUNXI_DMA_CTL_DST_DRQ(DDMA_DST_DRQ_SDRAM) |
+	       SUNXI_DMA_CTL_DST_BURST_4 | SUNXI_DMA_CTL_DST_DATA_WIDTH_32 |
+	       SUNXI_DMA_CTL_TRIGGER, &cfg->ctl);
+}
+
+static int sunxi_nfc_dma_wait(struct sunxi_nfc *nfc, void *buf, int len)
+{
+	struct sunxi_dma *const dma = (struct sunxi_dma *)SUNXI_DMA_BASE;
+	struct sunxi_dma_cfg *const cfg = &dma->ddma[NFC_DDMA_CHAN];
+	u32 end = SUNXI_DMA_IRQ_DDMA_END(NFC_DDMA_CHAN);
+	u32 time_start = get_timer(0);
+	int ret = 0;
+
+	while (!(readl(&dma->irq_pend) & end)) {
+		if (get_timer(time_start) > NFC_DEFAULT_TIMEOUT_MS) {
+			dev_err(nfc->dev, "DMA transfer timedout\n");
+			ret = -ETIMEDOUT;
+			break;
+		}
+	}
+
+	writel(0, &cfg->ctl);
+	writel(SUNXI_DMA_IRQ_DDMA_HALF(NFC_DDMA_CHAN) | end, &dma->irq_pend);
+	invalidate_dcache_range((ulong)buf, (ulong)buf + len);
+
+	return ret;
+}
+
+static void sunxi_nfc_hw_ecc_update_stats(struct mtd_info *mtd,
+					  unsigned int *max_bitflips, int ret)
+{
+	if (ret < 0) {
+		mtd->ecc_stats.failed++;
+	} else {
+		mtd->ecc_stats.corrected += ret;
+		*max_bitflips = max_t(unsigned int, *max_bitflips, ret);
+	}
+}
+
+/*
+ * Read a whole page in one batch operation: the controller walks through all
+ * the ECC chunks itself while the dedicated DMA moves the corrected data to
+ * @buf, and the ECC status of each chunk is left in the controller registers.
+ * The OOB bytes are only read back when asked for, or when a chunk has to be
+ * checked for being an erased one with bitflips.
+ */
+static int sunxi_nfc_hw_ecc_read_page_dma(struct mtd_info *mtd,
+					  struct nand_chip *chip, uint8_t *buf,
+					  int oob_required, int page)
+{
+	struct sunxi_nfc *nfc = to_sunxi_nfc(chip->controller);
+	struct nand_ecc_ctrl *ecc = &chip->ecc;
+	unsigned int max_bitflips = 0;
+	int ret, i, cur_off = 0;
+	bool raw_mode = false;
+	u32 status, err_cnt;
+
+	if (!IS_ALIGNED((ulong)buf, ARCH_DMA_MINALIGN))
+		return sunxi_nfc_hw_ecc_read_page(mtd, chip, buf, oob_required,
+						  page);
+
+	ret = sunxi_nfc_wait_cmd_fifo_empty(nfc);
+	if (ret)
+		return ret;
+
+	sunxi_nfc_dma_start(nfc, buf, mtd->writesize);
+
+	writel(readl(nfc->regs + NFC_REG_CTL) | NFC_RAM_METHOD,
+	       nfc->regs + NFC_REG_CTL);
+	writel(ecc->steps, nfc->regs + NFC_REG_SECTOR_NUM);
+	writel(ecc->size, nfc->regs + NFC_REG_CNT);
+
+	sunxi_nfc_hw_ecc_enable(mtd);
+	sunxi_nfc_randomizer_config(mtd, page, false);
+	sunxi_nfc_randomizer_enable(mtd);
+
+	writel((NAND_CMD_RNDOUTSTART << 16) | (NAND_CMD_RNDOUT << 8) |
+	       NAND_CMD_READSTART, nfc->regs + NFC_REG_RCMD_SET);
+	writel(NFC_PAGE_OP | NFC_DATA_SWAP_METHOD | NFC_DATA_TRANS,
+	       nfc->regs + NFC_REG_CMD);
+
+	ret = sunxi_nfc_wait_int(nfc, NFC_CMD_INT_FLAG, 0);
+	if (ret)
+		sunxi_nfc_dma_wait(nfc, buf, mtd->writesize);
+	else
+		ret = sunxi_nfc_dma_wait(nfc, buf, mtd->writesize);
+
+	sunxi_nfc_randomizer_disable(mtd);
+	writel(readl(nfc->regs + NFC_REG_CTL) & ~NFC_RAM_METHOD,
+	       nfc->regs + NFC_REG_CTL);
+	if (ret)
+		goto out;
+
+	status = readl(nfc->regs + NFC_REG_ECC_ST);
+	for (i = 0; i < ecc->steps; i++) {
+		int data_off = i * ecc->size;
+		int oob_off = i * (ecc->bytes + 4);
+		u8 *data = buf + data_off;
+		u8 *oob = chip->oob_poi + oob_off;
+
+		if (status & NFC_ECC_PAT_FOUND(i)) {
+			u8 pattern = 0xff;
+
+			if (unlikely(!(readl(nfc->regs + NFC_REG_PAT_ID) & 0x1)))
+				pattern = 0x0;
+
+			memset(data, pattern, ecc->size);
+			memset(oob, pattern, ecc->bytes + 4);
+			raw_mode = true;
+			continue;
+		}
+
+		if (status & NFC_ECC_ERR(i)) {
+			/*
+			 * Re-read the chunk with the randomizer disabled to
+			 * identify bitflips in erased pages.
+			 */
+			chip->cmdfunc(mtd, NAND_CMD_RNDOUT, data_off, -1);
+			chip->read_buf(mtd, data, ecc->size);
+			chip->cmdfunc(mtd, NAND_CMD_RNDOUT,
+				      mtd->writesize + oob_off, -1);
+			chip->read_buf(mtd, oob, ecc->bytes + 4);
+
+			ret = nand_check_erased_ecc_chunk(data, ecc->size,
+							  oob, ecc->bytes + 4,
+							  NULL, 0,
+							  ecc->strength);
+			if (ret >= 0)
+				raw_mode = true;
+			sunxi_nfc_hw_ecc_update_stats(mtd, &max_bitflips, ret);
+			continue;
+		}
+
+		err_cnt = readl(nfc->regs + NFC_REG_ECC_ERR_CNT(i));
+		sunxi_nfc_hw_ecc_update_stats(mtd, &max_bitflips,
+					      NFC_ECC_ERR_CNT(i % 4, err_cnt));
+
+		if (!oob_required)
+			continue;
+
+		/*
+		 * The ECC bytes have to come from the chip, but the 4 bytes of
+		 * OOB data protected by the engine are already corrected in
+		 * the user data registers.
+		 */
+		chip->cmdfunc(mtd, NAND_CMD_RNDOUT, mtd->writesize + oob_off,
+			      -1);
+		sunxi_nfc_randomizer_read_buf(mtd, oob, ecc->bytes + 4, true,
+					      page);
+		sunxi_nfc_user_data_to_buf(readl(nfc->regs +
+						 NFC_REG_USER_DATA(i)), oob);
+
+		/* De-randomize the Bad Block Marker. */
+		if (!i && chip->options & NAND_NEED_SCRAMBLING)
+			sunxi_nfc_randomize_bbm(mtd, page, oob);
+	}
+
+	if (oob_required)
+		sunxi_nfc_hw_ecc_read_extra_oob(mtd, chip->oob_poi, &cur_off,
+						!raw_mode, page);
+	ret = max_bitflips;
+
+out:
+	sunxi_nfc_hw_ecc_disable(mtd);
+
+	return ret;
+}
+#endif
+
 static int sunxi_nfc_hw_ecc_read_subpage(struct mtd_info *mtd,
 					 struct nand_chip *chip,
 					 uint32_t data_offs, uint32_t readlen,
@@ -1478,7 +1672,11 @@ static int sunxi_nand_hw_ecc_ctrl_init(struct mtd_info *mtd,
 	if (ret)
 		return ret;
 
+#if IS_ENABLED(CONFIG_NAND_SUNXI_DMA)
+	ecc->read_page = sunxi_nfc_hw_ecc_read_page_dma;
+#else
 	ecc->read_page = sunxi_nfc_hw_ecc_read_page;
+#endif
 	ecc->write_page = sunxi_nfc_hw_ecc_write_page;
 	ecc->read_subpage = sunxi_nfc_hw_ecc_read_subpage;
 	ecc->write_subpage = sunxi_nfc_hw_ecc_write_subpage;
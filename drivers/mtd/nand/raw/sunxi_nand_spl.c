@@ -7,11 +7,16 @@
 #include <asm/arch/clock.h>
 #include <asm/io.h>
 #include <config.h>
+#include <cpu_func.h>
+#include <memalign.h>
 #include <nand.h>
 #include <linux/bitops.h>
 #include <linux/ctype.h>
 #include <linux/delay.h>
 #include <linux/mtd/rawnand.h>
+#if IS_ENABLED(CONFIG_NAND_SUNXI_DMA)
+#include <asm/arch/dma.h>
+#endif
 
 /* registers */
 #define NFC_CTL                    0x00000000
@@ -251,6 +256,82 @@ static int nand_change_column(u16 column)
 
 static const int ecc_bytes[] = {32, 46, 54, 60, 74, 88, 102, 110, 116};
 
+#if IS_ENABLED(CONFIG_NAND_SUNXI_DMA)
+/*
+ * Read a whole page with a single batch operation, the controller going
+ * through the ECC chunks by itself and the dedicated DMA moving the corrected
+ * data straight to @dest.
+ */
+static int nand_read_page_dma(const struct nfc_config *conf, void *dest,
+			      u16 rand_seed)
+{
+	struct sunxi_dma *const dma = (struct sunxi_dma *)SUNXI_DMA_BASE;
+	struct sunxi_dma_cfg *const cfg = &dma->ddma[0];
+	int nsectors = conf->page_size / conf->ecc_size;
+	ulong start = (ulong)dest, end = start + conf->page_size;
+	u32 ecc_st;
+	int ret;
+
+	flush_dcache_range(start, end);
+
+	writel(SUNXI_DMA_IRQ_DDMA_HALF(0) | SUNXI_DMA_IRQ_DDMA_END(0),
+	       &dma->irq_pend);
+	writel(SUNXI_NFC_BASE + NFC_IO_DATA, &cfg->src_addr);
+	writel(start, &cfg->dst_addr);
+	writel(conf->page_size, &cfg->bc);
+	writel(SUNXI_DDMA_PARA(1, 2, 1, 2), &cfg->ddma_para);
+	writel(SUNXI_DMA_CTL_SRC_DRQ(DDMA_SRC_DRQ_NAND) |
+	       SUNXI_DMA_CTL_MODE_IO | SUNXI_DMA_CTL_SRC_BURST_4 |
+	       SUNXI_DMA_CTL_SRC_DATA_WIDTH_32 |
+	       SUNXI_DMA_CTL_DST_DRQ(DDMA_DST_DRQ_SDRAM) |
+	       SUNXI_DMA_CTL_DST_BURST_4 | SUNXI_DMA_CTL_DST_DATA_WIDTH_32 |
+	       SUNXI_DMA_CTL_TRIGGER, &cfg->ctl);
+
+	writel(0, SUNXI_NFC_BASE + NFC_ECC_ST);
+	writel((rand_seed << 16) | (conf->ecc_strength << 12) |
+	       (conf->randomize ? NFC_ECC_RANDOM_EN : 0) |
+	       (conf->ecc_size == 512 ? NFC_ECC_BLOCK_SIZE : 0) |
+	       NFC_ECC_EN | NFC_ECC_EXCEPTION,
+	       SUNXI_NFC_BASE + NFC_ECC_CTL);
+	setbits_le32(SUNXI_NFC_BASE + NFC_CTL, NFC_CTL_RAM_METHOD);
+	writel(nsectors, SUNXI_NFC_BASE + NFC_SECTOR_NUM);
+	writel(conf->ecc_size, SUNXI_NFC_BASE + NFC_CNT);
+	writel((NFC_CMD_RNDOUTSTART << NFC_RANDOM_READ_CMD1_OFFSET) |
+	       (NFC_CMD_RNDOUT << NFC_RANDOM_READ_CMD0_OFFSET) |
+	       (NFC_CMD_READSTART << NFC_READ_CMD_OFFSET),
+	       SUNXI_NFC_BASE + NFC_RCMD_SET);
+
+	ret = nand_exec_cmd(NFC_DATA_TRANS | NFC_DATA_SWAP_METHOD |
+			    NFC_PAGE_CMD);
+	if (!ret && !check_value((ulong)&dma->irq_pend,
+				 SUNXI_DMA_IRQ_DDMA_END(0),
+				 DEFAULT_TIMEOUT_US)) {
+		printf("nand: timeout waiting for DMA\n");
+		ret = -ETIMEDOUT;
+	}
+
+	writel(0, &cfg->ctl);
+	clrbits_le32(SUNXI_NFC_BASE + NFC_CTL, NFC_CTL_RAM_METHOD);
+	writel(readl(SUNXI_NFC_BASE + NFC_ECC_CTL) & ~NFC_ECC_EN,
+	       SUNXI_NFC_BASE + NFC_ECC_CTL);
+	invalidate_dcache_range(start, end);
+	if (ret)
+		return ret;
+
+	ecc_st = readl(SUNXI_NFC_BASE + NFC_ECC_ST);
+
+	/* ECC error detected in any of the chunks. */
+	if (ecc_st & 0xffff)
+		return -EIO;
+
+	/* Return 1 if the first chunk is empty, as nand_read_page() does. */
+	if (ecc_st & 0x10000)
+		return 1;
+
+	return 0;
+}
+#endif
+
 static int nand_read_page(const struct nfc_config *conf, u32 offs,
 			  void *dest, int len)
 {
@@ -269,6 +350,11 @@ static int nand_read_page(const struct nfc_config *conf, u32 offs,
 	if (conf->randomize)
 		rand_seed = random_seed[page % conf->nseeds];
 
+#if IS_ENABLED(CONFIG_NAND_SUNXI_DMA)
+	if (len == conf->page_size && IS_ALIGNED((ulong)dest, ARCH_DMA_MINALIGN))
+		return nand_read_page_dma(conf, dest, rand_seed);
+#endif
+
 	/* Retrieve data from SRAM (PIO) */
 	for (i = 0; i < nsectors; i++) {
 		int data_off = i * conf->ecc_size;
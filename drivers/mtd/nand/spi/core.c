@@ -277,6 +277,28 @@ static int spinand_read_from_cache_op(struct spinand_device *spinand,
 		}
 	}
 
+	if (spinand->dirmaps) {
+		struct spi_mem_dirmap_desc *rdesc;
+		ssize_t nread;
+
+		/* The plane is part of the direct mapping offset */
+		rdesc = spinand->dirmaps[req->pos.plane].rdesc;
+		while (nbytes) {
+			nread = spi_mem_dirmap_read(rdesc, column, nbytes, buf);
+			if (nread < 0)
+				return nread;
+
+			if (!nread || nread > nbytes)
+				return -EIO;
+
+			buf += nread;
+			nbytes -= nread;
+			column += nread;
+		}
+
+		goto copy;
+	}
+
 	spinand_cache_op_adjust_colum(spinand, &adjreq, &column);
 	op.addr.val = column;
 
@@ -301,6 +323,7 @@ static int spinand_read_from_cache_op(struct spinand_device *spinand,
 		op.addr.val += op.data.nbytes;
 	}
 
+copy:
 	if (req->datalen)
 		memcpy(req->databuf.in, spinand->databuf + req->dataoffs,
 		       req->datalen);
@@ -319,6 +342,50 @@ static int spinand_read_from_cache_op(struct spinand_device *spinand,
 	return 0;
 }
 
+static int spinand_cont_read_from_cache_op(struct spinand_device *spinand,
+					   const struct nand_page_io_req *req)
+{
+	struct spi_mem_op op = *spinand->op_templates.read_cache;
+	struct nand_device *nand = spinand_to_nand(spinand);
+	unsigned int pagesize = nanddev_page_size(nand);
+	unsigned int nbytes;
+	void *buf = spinand->databuf;
+	u16 column = 0;
+	int ret;
+
+	nbytes = round_up(req->dataoffs + req->datalen, pagesize);
+	spinand_cache_op_adjust_colum(spinand, req, &column);
+	op.addr.val = column;
+
+	/*
+	 * The chip streams out one page after the other for as long as the
+	 * transfer goes on. Transfers may be split to suit the controller, but
+	 * only on page boundaries, otherwise the data gets out of sequence.
+	 */
+	while (nbytes) {
+		op.data.buf.in = buf;
+		op.data.nbytes = nbytes;
+		ret = spi_mem_adjust_op_size(spinand->slave, &op);
+		if (ret)
+			return ret;
+
+		if (op.data.nbytes < nbytes)
+			op.data.nbytes = round_down(op.data.nbytes, pagesize);
+
+		ret = spi_mem_exec_op(spinand->slave, &op);
+		if (ret)
+			return ret;
+
+		buf += op.data.nbytes;
+		nbytes -= op.data.nbytes;
+	}
+
+	memcpy(req->databuf.in, spinand->databuf + req->dataoffs,
+	       req->datalen);
+
+	return 0;
+}
+
 static int spinand_write_to_cache_op(struct spinand_device *spinand,
 				     const struct nand_page_io_req *req)
 {
@@ -575,24 +642,17 @@ static int spinand_write_page(struct spinand_device *spinand,
 	return ret;
 }
 
-static int spinand_mtd_read(struct mtd_info *mtd, loff_t from,
-			    struct mtd_oob_ops *ops)
+static int spinand_mtd_regular_page_read(struct mtd_info *mtd, loff_t from,
+					 struct mtd_oob_ops *ops,
+					 bool enable_ecc,
+					 unsigned int *max_bitflips)
 {
 	struct spinand_device *spinand = mtd_to_spinand(mtd);
 	struct nand_device *nand = mtd_to_nanddev(mtd);
-	unsigned int max_bitflips = 0;
 	struct nand_io_iter iter;
-	bool enable_ecc = false;
 	bool ecc_failed = false;
 	int ret = 0;
 
-	if (ops->mode != MTD_OPS_RAW && spinand->eccinfo.ooblayout)
-		enable_ecc = true;
-
-#ifndef __UBOOT__
-	mutex_lock(&spinand->lock);
-#endif
-
 	nanddev_io_for_each_page(nand, from, ops, &iter) {
 		schedule();
 		ret = spinand_select_target(spinand, iter.req.pos.target);
@@ -612,7 +672,7 @@ static int spinand_mtd_read(struct mtd_info *mtd, loff_t from,
 			mtd->ecc_stats.failed++;
 		} else {
 			mtd->ecc_stats.corrected += ret;
-			max_bitflips = max_t(unsigned int, max_bitflips, ret);
+			*max_bitflips = max_t(unsigned int, *max_bitflips, ret);
 		}
 
 		ret = 0;
@@ -620,11 +680,142 @@ static int spinand_mtd_read(struct mtd_info *mtd, loff_t from,
 		ops->oobretlen += iter.req.ooblen;
 	}
 
+	if (ecc_failed && !ret)
+		ret = -EBADMSG;
+
+	return ret;
+}
+
+static int spinand_mtd_continuous_page_read(struct mtd_info *mtd, loff_t from,
+					    struct mtd_oob_ops *ops,
+					    bool enable_ecc,
+					    unsigned int *max_bitflips)
+{
+	struct spinand_device *spinand = mtd_to_spinand(mtd);
+	struct nand_device *nand = mtd_to_nanddev(mtd);
+	struct nand_page_io_req req = { };
+	u8 status;
+	int ret, err;
+
+	req.mode = ops->mode;
+	req.dataoffs = nanddev_offs_to_pos(nand, from, &req.pos);
+	req.datalen = ops->len;
+	req.databuf.in = ops->datbuf;
+
+	schedule();
+	ret = spinand_select_target(spinand, req.pos.target);
+	if (ret)
+		return ret;
+
+	ret = spinand_ecc_enable(spinand, enable_ecc);
+	if (ret)
+		return ret;
+
+	ret = spinand->set_cont_read(spinand, true);
+	if (ret)
+		return ret;
+
+	/*
+	 * The cache is split in two halves: while one is read out, the chip
+	 * loads the next page into the other one. Only the first page has to
+	 * be waited for.
+	 */
+	ret = spinand_load_page_op(spinand, &req);
+	if (ret)
+		goto end_cont_read;
+
+	ret = spinand_wait(spinand, NULL);
+	if (ret < 0)
+		goto end_cont_read;
+
+	ret = spinand_cont_read_from_cache_op(spinand, &req);
+	if (ret)
+		goto end_cont_read;
+
+	ret = spinand_read_status(spinand, &status);
+	if (ret)
+		goto end_cont_read;
+
+	ops->retlen += req.datalen;
+
+	if (enable_ecc) {
+		ret = spinand_check_ecc_status(spinand, status);
+		if (ret == -EBADMSG) {
+			mtd->ecc_stats.failed++;
+		} else if (ret >= 0) {
+			mtd->ecc_stats.corrected += ret;
+			*max_bitflips = ret;
+			ret = 0;
+		}
+	}
+
+end_cont_read:
+	/*
+	 * Do not rely on the controller deasserting CS at the right time to
+	 * end the continuous read, clear the configuration bit instead.
+	 */
+	err = spinand->set_cont_read(spinand, false);
+
+	return ret ? ret : err;
+}
+
+static bool spinand_use_cont_read(struct mtd_info *mtd, loff_t from,
+				  struct mtd_oob_ops *ops)
+{
+	struct spinand_device *spinand = mtd_to_spinand(mtd);
+	struct nand_device *nand = mtd_to_nanddev(mtd);
+	struct nand_pos start_pos, end_pos;
+
+	if (!spinand->cont_read_possible)
+		return false;
+
+	/* OOB data cannot be read along */
+	if (!ops->datbuf || !ops->len || ops->ooblen || ops->oobbuf)
+		return false;
+
+	nanddev_offs_to_pos(nand, from, &start_pos);
+	nanddev_offs_to_pos(nand, from + ops->len - 1, &end_pos);
+
+	/*
+	 * Not all chips can stream across plane or eraseblock boundaries, and
+	 * UBI rarely reads more than one eraseblock at a time anyway, so only
+	 * keep reads within a single eraseblock continuous.
+	 */
+	if (start_pos.target != end_pos.target ||
+	    start_pos.lun != end_pos.lun ||
+	    start_pos.plane != end_pos.plane ||
+	    start_pos.eraseblock != end_pos.eraseblock)
+		return false;
+
+	return start_pos.page < end_pos.page;
+}
+
+static int spinand_mtd_read(struct mtd_info *mtd, loff_t from,
+			    struct mtd_oob_ops *ops)
+{
+	struct spinand_device *spinand = mtd_to_spinand(mtd);
+	unsigned int max_bitflips = 0;
+	bool enable_ecc = false;
+	int ret;
+
+	if (ops->mode != MTD_OPS_RAW && spinand->eccinfo.ooblayout)
+		enable_ecc = true;
+
+#ifndef __UBOOT__
+	mutex_lock(&spinand->lock);
+#endif
+
+	if (spinand_use_cont_read(mtd, from, ops))
+		ret = spinand_mtd_continuous_page_read(mtd, from, ops,
+						       enable_ecc,
+						       &max_bitflips);
+	else
+		ret = spinand_mtd_regular_page_read(mtd, from, ops, enable_ecc,
+						    &max_bitflips);
+
 #ifndef __UBOOT__
 	mutex_unlock(&spinand->lock);
 #endif
-	if (ecc_failed && !ret)
-		ret = -EBADMSG;
 
 	return ret ? ret : max_bitflips;
 }
@@ -981,6 +1172,7 @@ int spinand_match_and_init(struct spinand_device *spinand,
 		spinand->flags = table[i].flags;
 		spinand->id.len = 1 + table[i].devid.len;
 		spinand->select_target = table[i].select_target;
+		spinand->set_cont_read = table[i].set_cont_read;
 
 		op = spinand_select_op_variant(spinand,
 					       info->op_variants.read_cache);
@@ -1063,10 +1255,80 @@ static const struct mtd_ooblayout_ops spinand_noecc_ooblayout = {
 	.rfree = spinand_noecc_ooblayout_free,
 };
 
+static void spinand_destroy_dirmaps(struct spinand_device *spinand)
+{
+	struct nand_device *nand = spinand_to_nand(spinand);
+	unsigned int i;
+
+	if (!spinand->dirmaps)
+		return;
+
+	for (i = 0; i < nand->memorg.planes_per_lun; i++) {
+		if (spinand->dirmaps[i].rdesc)
+			spi_mem_dirmap_destroy(spinand->dirmaps[i].rdesc);
+	}
+
+	kfree(spinand->dirmaps);
+	spinand->dirmaps = NULL;
+}
+
+static int spinand_create_dirmaps(struct spinand_device *spinand)
+{
+	struct nand_device *nand = spinand_to_nand(spinand);
+	struct spi_mem_dirmap_info info = {
+		.length = nanddev_page_size(nand) +
+			  nanddev_per_page_oobsize(nand),
+	};
+	struct spi_mem_dirmap_desc *desc;
+	unsigned int i;
+
+	if (!CONFIG_IS_ENABLED(SPI_DIRMAP))
+		return 0;
+
+	spinand->dirmaps = kcalloc(nand->memorg.planes_per_lun,
+				   sizeof(*spinand->dirmaps), GFP_KERNEL);
+	if (!spinand->dirmaps)
+		return -ENOMEM;
+
+	info.op_tmpl = *spinand->op_templates.read_cache;
+	for (i = 0; i < nand->memorg.planes_per_lun; i++) {
+		/* The plane number is passed in MSB just above the column */
+		info.offset = i << fls(nand->memorg.pagesize);
+
+		desc = spi_mem_dirmap_create(spinand->slave, &info);
+		if (IS_ERR(desc)) {
+			spinand_destroy_dirmaps(spinand);
+			return PTR_ERR(desc);
+		}
+
+		spinand->dirmaps[i].rdesc = desc;
+	}
+
+	return 0;
+}
+
+static void spinand_cont_read_init(struct spinand_device *spinand)
+{
+	struct spi_mem_op op = *spinand->op_templates.read_cache;
+	struct nand_device *nand = spinand_to_nand(spinand);
+
+	if (!spinand->set_cont_read)
+		return;
+
+	/* The controller must be able to read at least a page in one go */
+	op.data.nbytes = nanddev_page_size(nand);
+	if (spi_mem_adjust_op_size(spinand->slave, &op) ||
+	    op.data.nbytes < nanddev_page_size(nand))
+		return;
+
+	spinand->cont_read_possible = true;
+}
+
 static int spinand_init(struct spinand_device *spinand)
 {
 	struct mtd_info *mtd = spinand_to_mtd(spinand);
 	struct nand_device *nand = mtd_to_nanddev(mtd);
+	size_t bufsize;
 	int ret, i;
 
 	/*
@@ -1086,9 +1348,12 @@ static int spinand_init(struct spinand_device *spinand)
 	 * may use this buffer for DMA access.
 	 * Memory allocated by devm_ does not guarantee DMA-safe alignment.
 	 */
-	spinand->databuf = kzalloc(nanddev_page_size(nand) +
-			       nanddev_per_page_oobsize(nand),
-			       GFP_KERNEL);
+	spinand_cont_read_init(spinand);
+	bufsize = nanddev_page_size(nand) + nanddev_per_page_oobsize(nand);
+	/* Continuous reads fill the bounce buffer with up to an eraseblock */
+	if (spinand->cont_read_possible)
+		bufsize = max_t(size_t, bufsize, nanddev_eraseblock_size(nand));
+	spinand->databuf = kzalloc(bufsize, GFP_KERNEL);
 	if (!spinand->databuf) {
 		ret = -ENOMEM;
 		goto err_free_bufs;
@@ -1153,6 +1418,14 @@ static int spinand_init(struct spinand_device *spinand)
 
 	mtd->oobavail = ret;
 
+	ret = spinand_create_dirmaps(spinand);
+	if (ret) {
+		dev_err(spinand->slave->dev,
+			"Failed to create direct mappings for read operations (err = %d)\n",
+			ret);
+		goto err_cleanup_nanddev;
+	}
+
 	return 0;
 
 err_cleanup_nanddev:
@@ -1171,6 +1444,7 @@ static void spinand_cleanup(struct spinand_device *spinand)
 {
 	struct nand_device *nand = spinand_to_nand(spinand);
 
+	spinand_destroy_dirmaps(spinand);
 	nanddev_cleanup(nand);
 	spinand_manufacturer_cleanup(spinand);
 	kfree(spinand->databuf);
@@ -738,6 +738,7 @@ static void spi_nor_set_4byte_opcodes(struct spi_nor *nor,
 	nor->read_opcode = spi_nor_convert_3to4_read(nor->read_opcode);
 	nor->program_opcode = spi_nor_convert_3to4_program(nor->program_opcode);
 	nor->erase_opcode = spi_nor_convert_3to4_erase(nor->erase_opcode);
+	nor->flags |= SNOR_F_4B_OPCODES;
 }
 #endif /* !CONFIG_SPI_FLASH_BAR */
 
@@ -1095,6 +1096,50 @@ static int spi_nor_erase_sector(struct spi_nor *nor, u32 addr)
 	return nor->mtd.erasesize;
 }
 
+/*
+ * Check whether a whole block of the flash can be erased at @addr instead of
+ * a small sector, because the range being erased covers it. SST26 flashes have
+ * smaller blocks at the ends, which the standard block erase does not handle.
+ */
+static bool spi_nor_can_erase_block(struct spi_nor *nor, u32 addr, u32 len)
+{
+	u32 size = nor->info->sector_size;
+
+	if (!IS_ENABLED(CONFIG_SPI_FLASH_ERASE_BLOCKS) || nor->erase ||
+	    (nor->flags & (SNOR_F_HAS_PARALLEL | SNOR_F_HAS_STACKED)) ||
+	    JEDEC_MFR(nor->info) == SNOR_MFR_SST)
+		return false;
+	if (nor->erase_opcode != SPINOR_OP_BE_4K &&
+	    nor->erase_opcode != SPINOR_OP_BE_4K_4B)
+		return false;
+
+	return size > nor->mtd.erasesize && len >= size && !(addr % size);
+}
+
+/*
+ * Initiate the erasure of a whole block. Returns the number of bytes erased on
+ * success, a negative error code on error.
+ */
+static int spi_nor_erase_block(struct spi_nor *nor, u32 addr)
+{
+	u8 opcode = nor->erase_opcode == SPINOR_OP_BE_4K_4B ?
+		    SPINOR_OP_SE_4B : SPINOR_OP_SE;
+	struct spi_mem_op op =
+		SPI_MEM_OP(SPI_MEM_OP_CMD(opcode, 0),
+			   SPI_MEM_OP_ADDR(nor->addr_width, addr, 0),
+			   SPI_MEM_OP_NO_DUMMY,
+			   SPI_MEM_OP_NO_DATA);
+	int ret;
+
+	spi_nor_setup_op(nor, &op, nor->write_proto);
+
+	ret = spi_mem_exec_op(nor->spi, &op);
+	if (ret)
+		return ret;
+
+	return nor->info->sector_size;
+}
+
 /*
  * Erase an address range on the nor chip.  The address range may extend
  * one or more erase sectors.  Return an error is there is a problem erasing.
@@ -1153,6 +1198,8 @@ static int spi_nor_erase(struct mtd_info *mtd, struct erase_info *instr)
 		if (len == mtd->size &&
 		    !(nor->flags & SNOR_F_NO_OP_CHIP_ERASE)) {
 			ret = spi_nor_erase_chip(nor);
+		} else if (spi_nor_can_erase_block(nor, offset, len)) {
+			ret = spi_nor_erase_block(nor, offset);
 		} else {
 			ret = spi_nor_erase_sector(nor, offset);
 		}
@@ -3350,7 +3397,7 @@ static int spi_nor_check_readop(struct spi_nor *nor,
 
 	op.dummy.nbytes = (read->num_mode_clocks + read->num_wait_states) *
 			  op.dummy.buswidth / 8;
-	if (spi_nor_protocol_is_dtr(nor->read_proto))
+	if (spi_nor_protocol_is_dtr(read->proto))
 		op.dummy.nbytes *= 2;
 
 	return spi_nor_check_op(nor, &op);
@@ -3492,21 +3539,9 @@ spi_nor_adjust_hwcaps(struct spi_nor *nor,
 }
 #endif /* CONFIG_SPI_FLASH_SMART_HWCAPS */
 
-static int spi_nor_select_read(struct spi_nor *nor,
-			       const struct spi_nor_flash_parameter *params,
-			       u32 shared_hwcaps)
+static void spi_nor_set_read(struct spi_nor *nor,
+			     const struct spi_nor_read_command *read)
 {
-	int cmd, best_match = fls(shared_hwcaps & SNOR_HWCAPS_READ_MASK) - 1;
-	const struct spi_nor_read_command *read;
-
-	if (best_match < 0)
-		return -EINVAL;
-
-	cmd = spi_nor_hwcaps_read2cmd(BIT(best_match));
-	if (cmd < 0)
-		return -EINVAL;
-
-	read = &params->reads[cmd];
 	nor->read_opcode = read->opcode;
 	nor->read_proto = read->proto;
 
@@ -3521,9 +3556,53 @@ static int spi_nor_select_read(struct spi_nor *nor,
 	 * into the so called dummy clock cycles.
 	 */
 	nor->read_dummy = read->num_mode_clocks + read->num_wait_states;
+}
+
+static int spi_nor_select_read(struct spi_nor *nor,
+			       const struct spi_nor_flash_parameter *params,
+			       u32 shared_hwcaps)
+{
+	int cmd, best_match = fls(shared_hwcaps & SNOR_HWCAPS_READ_MASK) - 1;
+
+	if (best_match < 0)
+		return -EINVAL;
+
+	cmd = spi_nor_hwcaps_read2cmd(BIT(best_match));
+	if (cmd < 0)
+		return -EINVAL;
+
+	spi_nor_set_read(nor, &params->reads[cmd]);
+
+#ifdef CONFIG_CMD_SF_BENCH
+	/* Keep the other usable read modes around for 'sf bench' */
+	nor->read_hwcaps = shared_hwcaps & SNOR_HWCAPS_READ_MASK;
+	memcpy(nor->reads, params->reads, sizeof(nor->reads));
+#endif
 	return 0;
 }
 
+#ifdef CONFIG_CMD_SF_BENCH
+int spi_nor_set_read_mode(struct spi_nor *nor, u32 hwcaps)
+{
+	int cmd;
+
+	if (!(nor->read_hwcaps & hwcaps))
+		return -ENOTSUPP;
+
+	cmd = spi_nor_hwcaps_read2cmd(hwcaps);
+	if (cmd < 0)
+		return -ENOTSUPP;
+
+	spi_nor_set_read(nor, &nor->reads[cmd]);
+#ifndef CONFIG_SPI_FLASH_BAR
+	if (nor->flags & SNOR_F_4B_OPCODES)
+		nor->read_opcode = spi_nor_convert_3to4_read(nor->read_opcode);
+#endif
+
+	return 0;
+}
+#endif
+
 static int spi_nor_select_pp(struct spi_nor *nor,
 			     const struct spi_nor_flash_parameter *params,
 			     u32 shared_hwcaps)
@@ -833,6 +833,7 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return 0;
 	}
 
+	ubi_io_prefetch_hdrs(ubi, pnum);
 	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 	if (err < 0)
 		return err;
@@ -1214,6 +1215,26 @@ static void destroy_ai(struct ubi_attach_info *ai)
 	kfree(ai);
 }
 
+/**
+ * hdrs_buf_get - let scan_peb() read both headers of a PEB at once.
+ * @ubi: UBI device description object
+ *
+ * This is only an optimization, so running out of memory is not an error.
+ */
+static void hdrs_buf_get(struct ubi_device *ubi)
+{
+	ubi->hdrs_buf = kmalloc(ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize,
+				GFP_KERNEL);
+	ubi->hdrs_pnum = -1;
+}
+
+static void hdrs_buf_put(struct ubi_device *ubi)
+{
+	kfree(ubi->hdrs_buf);
+	ubi->hdrs_buf = NULL;
+	ubi->hdrs_pnum = -1;
+}
+
 /**
  * scan_all - scan entire MTD device.
  * @ubi: UBI device description object
@@ -1242,6 +1263,7 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	if (!vidh)
 		goto out_ech;
 
+	hdrs_buf_get(ubi);
 	for (pnum = start; pnum < ubi->peb_count; pnum++) {
 		cond_resched();
 
@@ -1250,6 +1272,7 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		if (err < 0)
 			goto out_vidh;
 	}
+	hdrs_buf_put(ubi);
 
 	ubi_msg(ubi, "scanning is finished");
 
@@ -1294,6 +1317,7 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	return 0;
 
 out_vidh:
+	hdrs_buf_put(ubi);
 	ubi_free_vid_hdr(ubi, vidh);
 out_ech:
 	kfree(ech);
@@ -1326,6 +1350,106 @@ static struct ubi_attach_info *alloc_ai(void)
 
 #ifdef CONFIG_MTD_UBI_FASTMAP
 
+/**
+ * fastmap_peb - find what the fastmap says a PEB holds.
+ * @ai: attach info object built from the fastmap
+ * @pnum: physical eraseblock number
+ * @aeb: returns the LEB in the PEB, if it holds one
+ *
+ * Returns 1 if the PEB holds a LEB, 0 if it is free and -1 if it is to be
+ * erased or unknown to the fastmap.
+ */
+static int fastmap_peb(struct ubi_attach_info *ai, int pnum,
+		       struct ubi_ainf_peb **aeb)
+{
+	struct ubi_ainf_volume *av;
+	struct ubi_ainf_peb *tmp;
+	struct rb_node *rb1, *rb2;
+
+	ubi_rb_for_each_entry(rb1, av, &ai->volumes, rb) {
+		ubi_rb_for_each_entry(rb2, tmp, &av->root, u.rb) {
+			if (tmp->pnum == pnum) {
+				*aeb = tmp;
+				return 1;
+			}
+		}
+	}
+
+	list_for_each_entry(tmp, &ai->free, u.list) {
+		if (tmp->pnum == pnum)
+			return 0;
+	}
+
+	return -1;
+}
+
+/**
+ * check_fastmap - check a fastmap against the VID headers of a few PEBs.
+ * @ubi: UBI device description object
+ * @ai: attach info object built from the fastmap
+ *
+ * A fastmap which does not match the flash would make UBI return stale or
+ * wrong data. Check CONFIG_MTD_UBI_FASTMAP_CHECK PEBs spread over the
+ * device: those the fastmap maps to a LEB must hold that LEB, free ones must
+ * have no VID header. This is far from the full check that scanning the
+ * whole device would be, but it catches a fastmap that belongs to an older
+ * image.
+ *
+ * Returns 0 if the PEBs match, %UBI_BAD_FASTMAP if they do not and a
+ * negative error code in case of failure.
+ */
+static int check_fastmap(struct ubi_device *ubi, struct ubi_attach_info *ai)
+{
+	struct ubi_ainf_peb *aeb;
+	struct ubi_vid_hdr *vh;
+	int i, pnum, used, err = 0;
+
+	vh = ubi_zalloc_vid_hdr(ubi, GFP_KERNEL);
+	if (!vh)
+		return -ENOMEM;
+
+	for (i = 0; i < CONFIG_MTD_UBI_FASTMAP_CHECK; i++) {
+		pnum = div_u64((u64)ubi->peb_count * (2 * i + 1),
+			       2 * CONFIG_MTD_UBI_FASTMAP_CHECK);
+		used = fastmap_peb(ai, pnum, &aeb);
+		if (used < 0)
+			continue;
+
+		err = ubi_io_read_vid_hdr(ubi, pnum, vh, 0);
+		if (err < 0 && !mtd_is_eccerr(err))
+			goto out;
+
+		if (used) {
+			if ((err && err != UBI_IO_BITFLIPS) ||
+			    be32_to_cpu(vh->vol_id) != aeb->vol_id ||
+			    be32_to_cpu(vh->lnum) != aeb->lnum)
+				break;
+		} else if (err != UBI_IO_FF && err != UBI_IO_FF_BITFLIPS) {
+			break;
+		}
+		err = 0;
+	}
+
+	if (i < CONFIG_MTD_UBI_FASTMAP_CHECK) {
+		ubi_err(ubi, "fastmap does not match PEB %d", pnum);
+		err = UBI_BAD_FASTMAP;
+	}
+out:
+	ubi_free_vid_hdr(ubi, vh);
+	return err;
+}
+
+/* Forget about a fastmap found not to match the flash */
+static void drop_fastmap(struct ubi_device *ubi)
+{
+	int i;
+
+	for (i = 0; i < ubi->fm->used_blocks; i++)
+		kfree(ubi->fm->e[i]);
+	kfree(ubi->fm);
+	ubi->fm = NULL;
+}
+
 /**
  * scan_fastmap - try to find a fastmap and attach from it.
  * @ubi: UBI device description object
@@ -1351,6 +1475,7 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 	if (!vidh)
 		goto out_ech;
 
+	hdrs_buf_get(ubi);
 	for (pnum = 0; pnum < UBI_FM_MAX_START; pnum++) {
 		int vol_id = -1;
 		unsigned long long sqnum = -1;
@@ -1366,6 +1491,7 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 			fm_anchor = pnum;
 		}
 	}
+	hdrs_buf_put(ubi);
 
 	ubi_free_vid_hdr(ubi, vidh);
 	kfree(ech);
@@ -1378,9 +1504,17 @@ static int scan_fast(struct ubi_device *ubi, struct ubi_attach_info **ai)
 	if (!*ai)
 		return -ENOMEM;
 
-	return ubi_scan_fastmap(ubi, *ai, fm_anchor);
+	err = ubi_scan_fastmap(ubi, *ai, fm_anchor);
+	if (!err && CONFIG_MTD_UBI_FASTMAP_CHECK) {
+		err = check_fastmap(ubi, *ai);
+		if (err)
+			drop_fastmap(ubi);
+	}
+
+	return err;
 
 out_vidh:
+	hdrs_buf_put(ubi);
 	ubi_free_vid_hdr(ubi, vidh);
 out_ech:
 	kfree(ech);
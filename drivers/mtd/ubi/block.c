@@ -7,9 +7,12 @@
 
 #include <blk.h>
 #include <part.h>
+#include <memalign.h>
 #include <ubi_uboot.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
+#include <linux/math64.h>
+#include "ubi.h"
 
 int ubi_bind(struct udevice *dev)
 {
@@ -32,12 +35,31 @@ int ubi_bind(struct udevice *dev)
 	return 0;
 }
 
+/**
+ * struct ubi_blk_priv - private data of a UBI block device
+ *
+ * @buf: Copy of the last LEB read in part, NULL if not allocated yet
+ * @buf_size: Size of @buf
+ * @vol: Volume which @buf holds a LEB of, NULL if @buf is not valid
+ * @lnum: LEB number which @buf holds
+ * @sqnum: Sequence number of the UBI device when @buf was read. Each LEB
+ *	which is written and each change to the volume table increments it,
+ *	making @buf stale.
+ */
+struct ubi_blk_priv {
+	void *buf;
+	int buf_size;
+	struct ubi_volume *vol;
+	int lnum;
+	unsigned long long sqnum;
+};
+
 static struct ubi_device *get_ubi_device(void)
 {
 	return ubi_devices[0];
 }
 
-static char *get_volume_name(int vol_id)
+static struct ubi_volume *get_volume(int vol_id)
 {
 	struct ubi_device *ubi = get_ubi_device();
 	int i;
@@ -52,30 +74,91 @@ static char *get_volume_name(int vol_id)
 			continue;
 
 		if (volume->vol_id == vol_id)
-			return volume->name;
+			return volume;
 	}
 
 	return NULL;
 }
 
+/*
+ * Read part of a LEB through the cache. Filesystems read a few blocks at a
+ * time, so the whole LEB is read once, rather than the same NAND pages again
+ * for each call.
+ */
+static int ubi_blk_read_cached(struct udevice *dev, struct ubi_volume *vol,
+			       int lnum, void *dst, int off, int len)
+{
+	struct ubi_blk_priv *priv = dev_get_priv(dev);
+	struct ubi_device *ubi = vol->ubi;
+	int ret;
+
+	if (priv->vol != vol || priv->lnum != lnum ||
+	    priv->sqnum != ubi->global_sqnum) {
+		if (priv->buf_size < vol->usable_leb_size) {
+			free(priv->buf);
+			priv->buf_size = 0;
+			priv->buf = malloc_cache_aligned(vol->usable_leb_size);
+			if (!priv->buf)
+				return ubi_eba_read_leb(ubi, vol, lnum, dst,
+							off, len, 0);
+			priv->buf_size = vol->usable_leb_size;
+		}
+		priv->vol = NULL;
+		ret = ubi_eba_read_leb(ubi, vol, lnum, priv->buf, 0,
+				       vol->usable_leb_size, 0);
+		if (ret)
+			return ret;
+		priv->vol = vol;
+		priv->lnum = lnum;
+		priv->sqnum = ubi->global_sqnum;
+	}
+	memcpy(dst, priv->buf + off, len);
+
+	return 0;
+}
+
 static ulong ubi_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 		       void *dst)
 {
 	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
-	char *volume_name = get_volume_name(block_dev->hwpart);
-	unsigned int size = blkcnt * block_dev->blksz;
-	loff_t offset = start * block_dev->blksz;
-	int ret;
+	struct ubi_volume *vol = get_volume(block_dev->hwpart);
+	u64 offset = (u64)start * block_dev->blksz;
+	size_t size = blkcnt * block_dev->blksz;
+	int lnum, len, ret;
+	u32 off;
 
-	if (!volume_name) {
-		pr_err("%s: failed to find volume name for blk=" LBAF "\n", __func__, start);
+	if (!vol) {
+		pr_err("%s: failed to find volume for blk=" LBAF "\n", __func__, start);
 		return -EINVAL;
 	}
-
-	ret = ubi_volume_read(volume_name, dst, offset, size);
-	if (ret) {
-		pr_err("%s: failed to read from %s UBI volume\n", __func__, volume_name);
-		return ret;
+	if (vol->updating || vol->upd_marker) {
+		pr_err("%s: %s UBI volume is being updated\n", __func__, vol->name);
+		return -EBUSY;
+	}
+	if (offset >= vol->used_bytes)
+		return blkcnt;
+	size = min_t(u64, size, vol->used_bytes - offset);
+
+	/*
+	 * A read within one LEB goes through the cache. Larger ones are read
+	 * straight into @dst, with one call for each LEB.
+	 */
+	lnum = div_u64_rem(offset, vol->usable_leb_size, &off);
+	while (size) {
+		len = min_t(size_t, size, vol->usable_leb_size - off);
+		if (len == size && len != vol->usable_leb_size)
+			ret = ubi_blk_read_cached(dev, vol, lnum, dst, off, len);
+		else
+			ret = ubi_eba_read_leb(vol->ubi, vol, lnum, dst, off,
+					       len, 0);
+		if (ret) {
+			pr_err("%s: failed to read from %s UBI volume\n", __func__, vol->name);
+			return ret;
+		}
+		dst += len;
+		size -= len;
+		lnum++;
+		off = 0;
 	}
 
 	return blkcnt;
@@ -85,19 +168,21 @@ static ulong ubi_bwrite(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 			const void *src)
 {
 	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
-	char *volume_name = get_volume_name(block_dev->hwpart);
+	struct ubi_blk_priv *priv = dev_get_priv(dev);
+	struct ubi_volume *vol = get_volume(block_dev->hwpart);
 	unsigned int size = blkcnt * block_dev->blksz;
 	loff_t offset = start * block_dev->blksz;
 	int ret;
 
-	if (!volume_name) {
+	if (!vol) {
 		pr_err("%s: failed to find volume for blk=" LBAF "\n", __func__, start);
 		return -EINVAL;
 	}
 
-	ret = ubi_volume_write(volume_name, (void *)src, offset, size);
+	priv->vol = NULL;
+	ret = ubi_volume_write(vol->name, (void *)src, offset, size);
 	if (ret) {
-		pr_err("%s: failed to write from %s UBI volume\n", __func__, volume_name);
+		pr_err("%s: failed to write from %s UBI volume\n", __func__, vol->name);
 		return ret;
 	}
 
@@ -117,6 +202,15 @@ static int ubi_blk_probe(struct udevice *dev)
 	return 0;
 }
 
+static int ubi_blk_remove(struct udevice *dev)
+{
+	struct ubi_blk_priv *priv = dev_get_priv(dev);
+
+	free(priv->buf);
+
+	return 0;
+}
+
 static const struct blk_ops ubi_blk_ops = {
 	.read = ubi_bread,
 	.write = ubi_bwrite,
@@ -127,4 +221,6 @@ U_BOOT_DRIVER(ubi_blk) = {
 	.id = UCLASS_BLK,
 	.ops = &ubi_blk_ops,
 	.probe = ubi_blk_probe,
+	.remove = ubi_blk_remove,
+	.priv_auto = sizeof(struct ubi_blk_priv),
 };
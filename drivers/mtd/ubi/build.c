@@ -35,6 +35,7 @@
 #include <linux/log2.h>
 #include <linux/printk.h>
 #endif
+#include <bootstage.h>
 #include <linux/err.h>
 #include <ubi_uboot.h>
 #include <linux/mtd/partitions.h>
@@ -997,7 +998,9 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 	if (!ubi->fm_buf)
 		goto out_free;
 #endif
+	bootstage_start(BOOTSTAGE_ID_ACCUM_UBI, "ubi_attach");
 	err = ubi_attach(ubi, 0);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_UBI);
 	if (err) {
 		ubi_err(ubi, "failed to attach mtd%d, error %d",
 			mtd->index, err);
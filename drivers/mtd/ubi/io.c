@@ -136,6 +136,12 @@ int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 	if (err)
 		return err;
 
+	if (ubi->hdrs_buf && pnum == ubi->hdrs_pnum &&
+	    offset + len <= ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize) {
+		memcpy(buf, ubi->hdrs_buf + offset, len);
+		return 0;
+	}
+
 	/*
 	 * Deliberately corrupt the buffer to improve robustness. Indeed, if we
 	 * do not do this, the following may happen:
@@ -211,6 +217,36 @@ retry:
 	return err;
 }
 
+/**
+ * ubi_io_prefetch_hdrs - read the EC and VID headers of a PEB at once.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock number, or -1 to drop the headers read before
+ *
+ * Attaching by scanning reads the EC header and then the VID header of
+ * every PEB. This reads both with one MTD request, so that the driver can
+ * read the pages they are in at one go, and makes ubi_io_read() take them
+ * from @ubi->hdrs_buf. Nothing is kept if the read fails or reports
+ * bit-flips: the header reads then go to the flash and see it themselves.
+ *
+ * The caller provides @ubi->hdrs_buf, and must drop the headers before
+ * anything is written to the PEB.
+ */
+void ubi_io_prefetch_hdrs(struct ubi_device *ubi, int pnum)
+{
+	int len = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+	size_t read;
+	int err;
+
+	ubi->hdrs_pnum = -1;
+	if (!ubi->hdrs_buf || pnum < 0)
+		return;
+
+	err = mtd_read(ubi->mtd, (loff_t)pnum * ubi->peb_size, len, &read,
+		       ubi->hdrs_buf);
+	if (!err && read == len)
+		ubi->hdrs_pnum = pnum;
+}
+
 /**
  * ubi_io_write - write data to a physical eraseblock.
  * @ubi: UBI device description object
@@ -251,6 +287,9 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 	if (err)
 		return err;
 
+	if (pnum == ubi->hdrs_pnum)
+		ubi->hdrs_pnum = -1;
+
 	/* The area we are writing to has to contain all 0xFF bytes */
 	err = ubi_self_check_all_ff(ubi, pnum, offset, len);
 	if (err)
@@ -563,6 +602,9 @@ int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture)
 		return -EROFS;
 	}
 
+	if (pnum == ubi->hdrs_pnum)
+		ubi->hdrs_pnum = -1;
+
 	/*
 	 * If the flash is ECC-ed then we have to erase the ECC block before we
 	 * can write to it. But the write is in preparation to an erase in the
@@ -528,6 +528,9 @@ struct ubi_debug_info {
  * @peb_buf: a buffer of PEB size used for different purposes
  * @buf_mutex: protects @peb_buf
  * @ckvol_mutex: serializes static volume checking when opening
+ * @hdrs_buf: the EC and VID headers of PEB @hdrs_pnum while attaching, see
+ *            ubi_io_prefetch_hdrs()
+ * @hdrs_pnum: the PEB whose headers are in @hdrs_buf, -1 if none
  *
  * @dbg: debugging information for this UBI device
  */
@@ -627,6 +630,8 @@ struct ubi_device {
 	void *peb_buf;
 	struct mutex buf_mutex;
 	struct mutex ckvol_mutex;
+	void *hdrs_buf;
+	int hdrs_pnum;
 
 	struct ubi_debug_info dbg;
 };
@@ -886,6 +891,7 @@ int ubi_ensure_anchor_pebs(struct ubi_device *ubi);
 /* io.c */
 int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
 		int len);
+void ubi_io_prefetch_hdrs(struct ubi_device *ubi, int pnum);
 int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 		 int len);
 int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture);
@@ -266,6 +266,56 @@ static void tx_descs_init(struct dw_eth_dev *priv)
 	priv->tx_currdescnum = 0;
 }
 
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+/*
+ * Give a pair of RX descriptors to the GMAC. The first one takes the headers
+ * into our own buffer, the second one the rest of the frame, either where
+ * the payload belongs or behind the headers.
+ */
+static void rx_pair_arm(struct dw_eth_dev *priv, struct dmamacdescr *desc_p)
+{
+	uint size = MAC_MAX_FRAME_SZ - priv->rx_head;
+	ulong data_start = dev_bus_to_phys(priv->dev, desc_p[0].dmamac_addr);
+	ulong addr;
+
+	/* The stack may have written to the buffer, see eth_rx_placed() */
+	flush_dcache_range(data_start, data_start + CFG_ETH_BUFSIZE);
+
+	if (eth_rx_dest_next(priv->dev, priv->rx_head, size, &addr))
+		addr = data_start + priv->rx_head;
+	else
+		flush_dcache_range(ALIGN_DOWN(addr, ARCH_DMA_MINALIGN),
+				   ALIGN(addr + size, ARCH_DMA_MINALIGN));
+
+	/*
+	 * Each descriptor has a cache line of its own, so the second one
+	 * must reach memory before the GMAC can move on to it.
+	 */
+	desc_p[1].dmamac_addr = dev_phys_to_bus(priv->dev, addr);
+	desc_p[1].txrx_status = DESC_RXSTS_OWNBYDMA;
+	flush_dcache_range((ulong)&desc_p[1], (ulong)&desc_p[2]);
+
+	desc_p[0].txrx_status = DESC_RXSTS_OWNBYDMA;
+	flush_dcache_range((ulong)&desc_p[0], (ulong)&desc_p[1]);
+}
+
+static void rx_pairs_init(struct dw_eth_dev *priv)
+{
+	struct dmamacdescr *desc_p = priv->rx_mac_descrtable;
+	u32 idx;
+
+	for (idx = 0; idx < CFG_RX_DESCR_NUM; idx += 2) {
+		desc_p[idx].dmamac_cntl =
+			(priv->rx_head & DESC_RXCTRL_SIZE1MASK) |
+			DESC_RXCTRL_RXCHAIN;
+		desc_p[idx + 1].dmamac_cntl =
+			((MAC_MAX_FRAME_SZ - priv->rx_head) &
+			 DESC_RXCTRL_SIZE1MASK) | DESC_RXCTRL_RXCHAIN;
+		rx_pair_arm(priv, &desc_p[idx]);
+	}
+}
+#endif
+
 static void rx_descs_init(struct dw_eth_dev *priv)
 {
 	struct eth_dma_regs *dma_p = priv->dma_regs_p;
@@ -299,6 +349,11 @@ static void rx_descs_init(struct dw_eth_dev *priv)
 	/* Correcting the last pointer of the chain */
 	desc_p->dmamac_next = dev_phys_to_bus(priv->dev, (ulong)&desc_table_p[0]);
 
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	if (priv->rx_head)
+		rx_pairs_init(priv);
+#endif
+
 	/* Flush all Rx buffer descriptors at once */
 	flush_dcache_range((ulong)priv->rx_mac_descrtable,
 			   (ulong)priv->rx_mac_descrtable +
@@ -404,6 +459,16 @@ int designware_eth_init(struct dw_eth_dev *priv, u8 *enetaddr)
 	 */
 	_dw_write_hwaddr(priv, enetaddr);
 
+	/* Cores older than 3.50a have no feature register and read 0 */
+	priv->rx_csum = CONFIG_IS_ENABLED(ETH_RX_CSUM_OFFLOAD) &&
+			(readl(&dma_p->hwfeature) & RXTYP2COE);
+	if (priv->rx_csum)
+		writel(readl(&mac_p->conf) | CHECKSUMOFFLOAD, &mac_p->conf);
+
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	priv->rx_head = 0;
+	priv->rx_restart = false;
+#endif
 	rx_descs_init(priv);
 	tx_descs_init(priv);
 
@@ -519,6 +584,100 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 	return 0;
 }
 
+/* Tell the stack about IP frames whose checksums the GMAC found good */
+static void _dw_rx_csum(struct dw_eth_dev *priv, u32 status)
+{
+	if (priv->rx_csum &&
+	    (status & (DESC_RXSTS_ERROR | DESC_RXSTS_RXIPC_GIANT |
+		       DESC_RXSTS_RXFRAMEETHER | DESC_RXSTS_RXPAYLOADCSUM)) ==
+	    DESC_RXSTS_RXFRAMEETHER)
+		eth_rx_csum_verified(priv->dev);
+}
+
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+static int _dw_eth_recv_pair(struct dw_eth_dev *priv, uchar **packetp)
+{
+	struct dmamacdescr *desc_p =
+		&priv->rx_mac_descrtable[priv->rx_currdescnum];
+	ulong data_start = dev_bus_to_phys(priv->dev, desc_p[0].dmamac_addr);
+	ulong addr = dev_bus_to_phys(priv->dev, desc_p[1].dmamac_addr);
+	u32 status;
+	int length;
+
+	invalidate_dcache_range((ulong)&desc_p[0], (ulong)&desc_p[2]);
+
+	if ((desc_p[0].txrx_status | desc_p[1].txrx_status) &
+	    DESC_RXSTS_OWNBYDMA)
+		return -EAGAIN;
+
+	/*
+	 * The GMAC drops undersized frames, so every frame is longer than
+	 * the first buffer. Start over if one was not.
+	 */
+	if ((desc_p[0].txrx_status & (DESC_RXSTS_RXFIRST | DESC_RXSTS_RXLAST)) !=
+	    DESC_RXSTS_RXFIRST ||
+	    !(desc_p[1].txrx_status & DESC_RXSTS_RXLAST)) {
+		debug("%s: frame not split across the pair\n", __func__);
+		priv->rx_restart = true;
+		return 0;
+	}
+
+	/* The frame length is in the last descriptor */
+	status = desc_p[1].txrx_status;
+	length = (status & DESC_RXSTS_FRMLENMSK) >> DESC_RXSTS_FRMLENSHFT;
+	if (length <= priv->rx_head || length > MAC_MAX_FRAME_SZ)
+		return 0;
+
+	/* Invalidate received data */
+	if (addr == data_start + priv->rx_head) {
+		invalidate_dcache_range(data_start, data_start +
+					roundup(length, ARCH_DMA_MINALIGN));
+	} else {
+		invalidate_dcache_range(data_start, data_start +
+					roundup(priv->rx_head,
+						ARCH_DMA_MINALIGN));
+		invalidate_dcache_range(ALIGN_DOWN(addr, ARCH_DMA_MINALIGN),
+					ALIGN(addr + length - priv->rx_head,
+					      ARCH_DMA_MINALIGN));
+		eth_rx_placed(priv->dev, (uchar *)data_start, priv->rx_head,
+			      addr);
+	}
+	_dw_rx_csum(priv, status);
+	*packetp = (uchar *)data_start;
+
+	return length;
+}
+
+static void _dw_rx_restart(struct dw_eth_dev *priv)
+{
+	struct eth_dma_regs *dma_p = priv->dma_regs_p;
+
+	writel(readl(&dma_p->opmode) & ~RXSTART, &dma_p->opmode);
+	rx_descs_init(priv);
+	writel(readl(&dma_p->opmode) | RXSTART, &dma_p->opmode);
+}
+
+static int _dw_free_pair(struct dw_eth_dev *priv)
+{
+	u32 desc_num = priv->rx_currdescnum;
+
+	if (priv->rx_restart) {
+		priv->rx_restart = false;
+		_dw_rx_restart(priv);
+		return 0;
+	}
+
+	rx_pair_arm(priv, &priv->rx_mac_descrtable[desc_num]);
+
+	desc_num += 2;
+	if (desc_num >= CFG_RX_DESCR_NUM)
+		desc_num = 0;
+	priv->rx_currdescnum = desc_num;
+
+	return 0;
+}
+#endif
+
 static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
 {
 	u32 status, desc_num = priv->rx_currdescnum;
@@ -530,6 +689,11 @@ static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
 	ulong data_start = dev_bus_to_phys(priv->dev, desc_p->dmamac_addr);
 	ulong data_end;
 
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	if (priv->rx_head)
+		return _dw_eth_recv_pair(priv, packetp);
+#endif
+
 	/* Invalidate entire buffer descriptor */
 	invalidate_dcache_range(desc_start, desc_end);
 
@@ -544,6 +708,7 @@ static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
 		/* Invalidate received data */
 		data_end = data_start + roundup(length, ARCH_DMA_MINALIGN);
 		invalidate_dcache_range(data_start, data_end);
+		_dw_rx_csum(priv, status);
 		*packetp = (uchar *)(ulong)dev_bus_to_phys(priv->dev,
 				desc_p->dmamac_addr);
 	}
@@ -561,6 +726,11 @@ static int _dw_free_pkt(struct dw_eth_dev *priv)
 	ulong data_start = desc_p->dmamac_addr;
 	ulong data_end = data_start + roundup(CFG_ETH_BUFSIZE, ARCH_DMA_MINALIGN);
 
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	if (priv->rx_head)
+		return _dw_free_pair(priv);
+#endif
+
 	/* Invalidate the descriptor buffer data */
 	invalidate_dcache_range(data_start, data_end);
 
@@ -659,6 +829,32 @@ int designware_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
 	return _dw_free_pkt(priv);
 }
 
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+static int designware_eth_set_rx_dest(struct udevice *dev,
+				      const struct eth_rx_dest *dest)
+{
+	struct dw_eth_dev *priv = dev_get_priv(dev);
+	u32 head = 0;
+
+	if (dest) {
+		/*
+		 * Buffer sizes must be a multiple of the bus width, and the
+		 * shortest frame the GMAC passes on must reach the second
+		 * buffer.
+		 */
+		head = ALIGN(dest->hdr_len, 16);
+		if (head >= 60)
+			return -EINVAL;
+	}
+
+	priv->rx_head = head;
+	priv->rx_restart = false;
+	_dw_rx_restart(priv);
+
+	return 0;
+}
+#endif
+
 void designware_eth_stop(struct udevice *dev)
 {
 	struct dw_eth_dev *priv = dev_get_priv(dev);
@@ -872,6 +1068,9 @@ const struct eth_ops designware_eth_ops = {
 	.free_pkt		= designware_eth_free_pkt,
 	.stop			= designware_eth_stop,
 	.write_hwaddr		= designware_eth_write_hwaddr,
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	.set_rx_dest		= designware_eth_set_rx_dest,
+#endif
 };
 
 int designware_eth_of_to_plat(struct udevice *dev)
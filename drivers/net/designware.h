@@ -46,6 +46,7 @@ struct eth_mac_regs {
 #define FES_100			(1 << 14)
 #define DISABLERXOWN		(1 << 13)
 #define FULLDPLXMODE		(1 << 11)
+#define CHECKSUMOFFLOAD		(1 << 10)
 #define RXENABLE		(1 << 2)
 #define TXENABLE		(1 << 3)
 
@@ -80,6 +81,7 @@ struct eth_dma_regs {
 	u32 currhostrxdesc;	/* 0x4c */
 	u32 currhosttxbuffaddr;	/* 0x50 */
 	u32 currhostrxbuffaddr;	/* 0x54 */
+	u32 hwfeature;		/* 0x58 */
 };
 
 #define DW_DMA_BASE_OFFSET	(0x1000)
@@ -107,6 +109,9 @@ struct eth_dma_regs {
 #define TXSECONDFRAME		(1 << 2)
 #define RXSTART			(1 << 1)
 
+/* HW feature register definitions */
+#define RXTYP2COE		(1 << 17)
+
 /* Descriptior related definitions */
 #define MAC_MAX_FRAME_SZ	(1600)
 
@@ -164,6 +169,7 @@ struct dmamacdescr {
 #define DESC_RXSTS_RXMIIERROR		(1 << 3)
 #define DESC_RXSTS_RXDRIBBLING		(1 << 2)
 #define DESC_RXSTS_RXCRC		(1 << 1)
+#define DESC_RXSTS_RXPAYLOADCSUM	(1 << 0)
 
 /*
  * dmamac_cntl definitions
@@ -229,6 +235,15 @@ struct dw_eth_dev {
 	u32 max_speed;
 	u32 tx_currdescnum;
 	u32 rx_currdescnum;
+	bool rx_csum;		/* The GMAC checks receive checksums */
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	/*
+	 * Bytes of each frame in our own buffer when frames are split
+	 * across a pair of descriptors, 0 when they are not
+	 */
+	u32 rx_head;
+	bool rx_restart;
+#endif
 #if IS_ENABLED(CONFIG_BITBANGMII) && IS_ENABLED(CONFIG_DM_GPIO)
 	u32 bb_delay;
 	struct gpio_desc mdc_gpio;
@@ -923,6 +923,14 @@ static int eqos_start(struct udevice *dev)
 			EQOS_MAC_CONFIGURATION_CST |
 			EQOS_MAC_CONFIGURATION_ACS);
 
+	/* Check IPv4, TCP and UDP checksums if the MAC can */
+	eqos->rx_csum = CONFIG_IS_ENABLED(ETH_RX_CSUM_OFFLOAD) &&
+			(readl(&eqos->mac_regs->hw_feature0) &
+			 EQOS_MAC_HW_FEATURE0_RXCOESEL);
+	if (eqos->rx_csum)
+		setbits_le32(&eqos->mac_regs->configuration,
+			     EQOS_MAC_CONFIGURATION_IPC);
+
 	eqos_write_hwaddr(dev);
 
 	/* Configure DMA */
@@ -1131,6 +1139,24 @@ static int eqos_send(struct udevice *dev, void *packet, int length)
 	return -ETIMEDOUT;
 }
 
+/* Tell the stack about TCP and UDP frames whose checksums the MAC checked */
+static void eqos_rx_csum(struct udevice *dev, struct eqos_priv *eqos,
+			 struct eqos_desc *rx_desc)
+{
+	u32 pt = rx_desc->des1 & EQOS_DESC1_PT_MASK;
+
+	if (!eqos->rx_csum ||
+	    (rx_desc->des3 & (EQOS_DESC3_RS1V | EQOS_DESC3_ES)) !=
+	    EQOS_DESC3_RS1V)
+		return;
+	if ((rx_desc->des1 & (EQOS_DESC1_IPCE | EQOS_DESC1_IPCB |
+			      EQOS_DESC1_IPV4 | EQOS_DESC1_IPHE)) !=
+	    EQOS_DESC1_IPV4)
+		return;
+	if (pt == EQOS_DESC1_PT_UDP || pt == EQOS_DESC1_PT_TCP)
+		eth_rx_csum_verified(dev);
+}
+
 static int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
@@ -1150,6 +1176,7 @@ static int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
 	debug("%s: *packetp=%p, length=%d\n", __func__, *packetp, length);
 
 	eqos->config->ops->eqos_inval_buffer(*packetp, length);
+	eqos_rx_csum(dev, eqos, rx_desc);
 
 	return length;
 }
@@ -16,6 +16,7 @@
 #include <miiphy.h>
 #include <phy.h>
 #include <errno.h>
+#include <time.h>
 #include <asm/global_data.h>
 #include <asm-generic/gpio.h>
 #include <dm/device_compat.h>
@@ -167,6 +168,10 @@ int genphy_restart_aneg(struct phy_device *phydev)
 	ctl &= ~(BMCR_ISOLATE);
 
 	ctl = phy_write(phydev, MDIO_DEVAD_NONE, MII_BMCR, ctl);
+	if (!ctl) {
+		phydev->aneg_start = get_timer(0);
+		phydev->aneg_pending = true;
+	}
 
 	return ctl;
 }
@@ -242,17 +247,25 @@ int genphy_update_link(struct phy_device *phydev)
 
 	if ((phydev->autoneg == AUTONEG_ENABLE) &&
 	    !(mii_reg & BMSR_ANEGCOMPLETE)) {
+		ulong start;
 		int i = 0;
 
+		/*
+		 * Autonegotiation normally started when the PHY was configured
+		 * on probe, so only wait for the rest of the timeout
+		 */
+		start = phydev->aneg_pending ? phydev->aneg_start : get_timer(0);
 		printf("%s Waiting for PHY auto negotiation to complete",
 		       phydev->dev->name);
 		while (!(mii_reg & BMSR_ANEGCOMPLETE)) {
 			/*
 			 * Timeout reached ?
 			 */
-			if (i > (CONFIG_PHY_ANEG_TIMEOUT / 50)) {
+			if (get_timer(start) > CONFIG_PHY_ANEG_TIMEOUT) {
 				printf(" TIMEOUT !\n");
 				phydev->link = 0;
+				/* wait for the full time on the next try */
+				phydev->aneg_pending = false;
 				return -ETIMEDOUT;
 			}
 
@@ -270,7 +283,11 @@ int genphy_update_link(struct phy_device *phydev)
 		}
 		printf(" done\n");
 		phydev->link = 1;
+		phydev->aneg_pending = false;
 	} else {
+		/* negotiation is complete, or not used */
+		phydev->aneg_pending = false;
+
 		/* Read the link a second time to clear the latched state */
 		mii_reg = phy_read(phydev, MDIO_DEVAD_NONE, MII_BMSR);
 
@@ -757,6 +774,10 @@ int phy_reset(struct phy_device *phydev)
 		return -1;
 	}
 
+	/* a reset restarts autonegotiation, if it is enabled by default */
+	phydev->aneg_start = get_timer(0);
+	phydev->aneg_pending = true;
+
 	return 0;
 }
 
@@ -43,8 +43,8 @@
 #define MDIO_CMD_MII_CLK_CSR_DIV_128	0x3
 #define MDIO_CMD_MII_CLK_CSR_SHIFT	20
 
-#define CFG_TX_DESCR_NUM	32
-#define CFG_RX_DESCR_NUM	32
+#define CFG_TX_DESCR_NUM	CONFIG_SUN8I_EMAC_TX_DESC_NUM
+#define CFG_RX_DESCR_NUM	CONFIG_SUN8I_EMAC_RX_DESC_NUM
 #define CFG_ETH_BUFSIZE	2048 /* Note must be dma aligned */
 
 /*
@@ -101,6 +101,7 @@
 #define EMAC_TX_DMA_DESC	0x20
 #define EMAC_RX_CTL0		0x24
 #define	EMAC_RX_CTL0_RX_EN		BIT(31)
+#define	EMAC_RX_CTL0_RX_DO_CRC		BIT(27)
 #define EMAC_RX_CTL1		0x28
 #define	EMAC_RX_CTL1_RX_MD		BIT(1)
 #define	EMAC_RX_CTL1_RX_RUNT_FRM	BIT(2)
@@ -123,7 +124,17 @@
 #define EMAC_DESC_FIRST_DESC	BIT(29)
 #define EMAC_DESC_CHAIN_SECOND	BIT(24)
 
+#if CONFIG_IS_ENABLED(ETH_RX_CSUM_OFFLOAD)
+/* Checksum errors only mean that the frame is checked in software */
+#define EMAC_DESC_RX_ERROR_MASK	0x4000685a
+#else
 #define EMAC_DESC_RX_ERROR_MASK	0x400068db
+#endif
+#define EMAC_DESC_RX_HEADER_ERR	BIT(7)
+#define EMAC_DESC_RX_FRM_TYPE	BIT(5)
+#define EMAC_DESC_RX_PAYLOAD_ERR	BIT(0)
+#define EMAC_DESC_RX_FIRST	BIT(9)
+#define EMAC_DESC_RX_LAST	BIT(8)
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -138,11 +149,32 @@ struct emac_dma_desc {
 	u32 ctl_size;
 	u32 buf_addr;
 	u32 next;
+};
+
+/*
+ * Each TX descriptor is handed to the MAC on its own, while the MAC may be
+ * writing back the status of the previous one, so keep it in a cache line
+ * of its own.
+ */
+struct emac_tx_desc {
+	struct emac_dma_desc desc;
 } __aligned(ARCH_DMA_MINALIGN);
 
+/*
+ * RX descriptors are packed and given back to the MAC a whole cache line at
+ * a time, once the CPU owns every descriptor in it. This check makes sure
+ * that the ring is made of whole cache lines.
+ */
+#define RX_DESCS_PER_CL							\
+	((ARCH_DMA_MINALIGN / sizeof(struct emac_dma_desc)) +		\
+	BUILD_BUG_ON_ZERO(ARCH_DMA_MINALIGN % sizeof(struct emac_dma_desc)) + \
+	BUILD_BUG_ON_ZERO(CFG_RX_DESCR_NUM %				\
+			  (ARCH_DMA_MINALIGN / sizeof(struct emac_dma_desc))))
+
 struct emac_eth_dev {
-	struct emac_dma_desc rx_chain[CFG_TX_DESCR_NUM];
-	struct emac_dma_desc tx_chain[CFG_RX_DESCR_NUM];
+	struct emac_dma_desc rx_chain[CFG_RX_DESCR_NUM]
+		__aligned(ARCH_DMA_MINALIGN);
+	struct emac_tx_desc tx_chain[CFG_TX_DESCR_NUM];
 	char rxbuffer[RX_TOTAL_BUFSIZE] __aligned(ARCH_DMA_MINALIGN);
 	char txbuffer[TX_TOTAL_BUFSIZE] __aligned(ARCH_DMA_MINALIGN);
 
@@ -157,6 +189,14 @@ struct emac_eth_dev {
 	u32 addr;
 	u32 tx_slot;
 	bool use_internal_phy;
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	/*
+	 * Bytes of each frame in our own buffer when frames are split
+	 * across a pair of descriptors, 0 when they are not
+	 */
+	uint rx_head;
+	bool rx_restart;
+#endif
 
 	const struct emac_variant *variant;
 	void *mac_reg;
@@ -369,14 +409,64 @@ static int sun8i_phy_init(struct emac_eth_dev *priv, void *dev)
 
 #define cache_clean_descriptor(desc)					\
 	flush_dcache_range((uintptr_t)(desc),				\
-			   (uintptr_t)(desc) + sizeof(struct emac_dma_desc))
+			   (uintptr_t)(desc) + sizeof(struct emac_tx_desc))
 
 #define cache_inv_descriptor(desc)					\
 	invalidate_dcache_range((uintptr_t)(desc),			\
-			       (uintptr_t)(desc) + sizeof(struct emac_dma_desc))
+			       (uintptr_t)(desc) + sizeof(struct emac_tx_desc))
+
+/* Invalidate the whole cache line holding an RX descriptor */
+#define cache_inv_rx_descriptor(desc)					\
+	invalidate_dcache_range(ALIGN_DOWN((uintptr_t)(desc),		\
+					   ARCH_DMA_MINALIGN),		\
+				ALIGN_DOWN((uintptr_t)(desc),		\
+					   ARCH_DMA_MINALIGN) +		\
+				ARCH_DMA_MINALIGN)
 
-static void rx_descs_init(struct emac_eth_dev *priv)
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+/*
+ * Give a pair of RX descriptors to the MAC. The first one takes the headers
+ * into our own buffer, the second one the rest of the frame, either where
+ * the payload belongs or behind the headers.
+ */
+static void rx_pair_arm(struct udevice *dev, struct emac_dma_desc *desc_p)
 {
+	struct emac_eth_dev *priv = dev_get_priv(dev);
+	uint size = CFG_ETH_RXSIZE - priv->rx_head;
+	uintptr_t data_start = desc_p[0].buf_addr;
+	ulong addr;
+
+	/* The stack may have written to the buffer, see eth_rx_placed() */
+	flush_dcache_range(data_start, data_start + CFG_ETH_BUFSIZE);
+
+	if (eth_rx_dest_next(dev, priv->rx_head, size, &addr))
+		addr = data_start + priv->rx_head;
+	else
+		flush_dcache_range(ALIGN_DOWN(addr, ARCH_DMA_MINALIGN),
+				   ALIGN(addr + size, ARCH_DMA_MINALIGN));
+
+	desc_p[1].buf_addr = addr;
+	desc_p[0].status = EMAC_DESC_OWN_DMA;
+	desc_p[1].status = EMAC_DESC_OWN_DMA;
+}
+
+static void rx_pairs_init(struct udevice *dev)
+{
+	struct emac_eth_dev *priv = dev_get_priv(dev);
+	struct emac_dma_desc *desc_p = priv->rx_chain;
+	int i;
+
+	for (i = 0; i < CFG_RX_DESCR_NUM; i += 2) {
+		desc_p[i].ctl_size = priv->rx_head;
+		desc_p[i + 1].ctl_size = CFG_ETH_RXSIZE - priv->rx_head;
+		rx_pair_arm(dev, &desc_p[i]);
+	}
+}
+#endif
+
+static void rx_descs_init(struct udevice *dev)
+{
+	struct emac_eth_dev *priv = dev_get_priv(dev);
 	struct emac_dma_desc *desc_table_p = &priv->rx_chain[0];
 	char *rxbuffs = &priv->rxbuffer[0];
 	struct emac_dma_desc *desc_p;
@@ -402,6 +492,11 @@ static void rx_descs_init(struct emac_eth_dev *priv)
 	/* Correcting the last pointer of the chain */
 	desc_p->next = (uintptr_t)&desc_table_p[0];
 
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	if (priv->rx_head)
+		rx_pairs_init(dev);
+#endif
+
 	flush_dcache_range((uintptr_t)priv->rx_chain,
 			   (uintptr_t)priv->rx_chain +
 			sizeof(priv->rx_chain));
@@ -412,13 +507,13 @@ static void rx_descs_init(struct emac_eth_dev *priv)
 
 static void tx_descs_init(struct emac_eth_dev *priv)
 {
-	struct emac_dma_desc *desc_table_p = &priv->tx_chain[0];
+	struct emac_tx_desc *desc_table_p = &priv->tx_chain[0];
 	char *txbuffs = &priv->txbuffer[0];
 	struct emac_dma_desc *desc_p;
 	int i;
 
 	for (i = 0; i < CFG_TX_DESCR_NUM; i++) {
-		desc_p = &desc_table_p[i];
+		desc_p = &desc_table_p[i].desc;
 		desc_p->buf_addr = (uintptr_t)&txbuffs[i * CFG_ETH_BUFSIZE];
 		desc_p->next = (uintptr_t)&desc_table_p[i + 1];
 		desc_p->ctl_size = 0;
@@ -428,8 +523,8 @@ static void tx_descs_init(struct emac_eth_dev *priv)
 	/* Correcting the last pointer of the chain */
 	desc_p->next =  (uintptr_t)&desc_table_p[0];
 
-	/* Flush the first TX buffer descriptor we will tell the MAC about. */
-	cache_clean_descriptor(desc_table_p);
+	flush_dcache_range((uintptr_t)priv->tx_chain,
+			   (uintptr_t)priv->tx_chain + sizeof(priv->tx_chain));
 
 	writel((uintptr_t)&desc_table_p[0], priv->mac_reg + EMAC_TX_DMA_DESC);
 	priv->tx_currdescnum = 0;
@@ -465,7 +560,11 @@ static int sun8i_emac_eth_start(struct udevice *dev)
 	writel(8 << EMAC_CTL1_BURST_LEN_SHIFT, priv->mac_reg + EMAC_CTL1);
 
 	/* Initialize rx/tx descriptors */
-	rx_descs_init(priv);
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	priv->rx_head = 0;
+	priv->rx_restart = false;
+#endif
+	rx_descs_init(dev);
 	tx_descs_init(priv);
 
 	/* PHY Start Up */
@@ -480,6 +579,11 @@ static int sun8i_emac_eth_start(struct udevice *dev)
 		     EMAC_RX_CTL1_RX_ERR_FRM | EMAC_RX_CTL1_RX_RUNT_FRM);
 	setbits_le32(priv->mac_reg + EMAC_TX_CTL1, EMAC_TX_CTL1_TX_DMA_EN);
 
+	/* Check IP, TCP and UDP checksums */
+	if (CONFIG_IS_ENABLED(ETH_RX_CSUM_OFFLOAD))
+		setbits_le32(priv->mac_reg + EMAC_RX_CTL0,
+			     EMAC_RX_CTL0_RX_DO_CRC);
+
 	/* Enable RX/TX */
 	setbits_le32(priv->mac_reg + EMAC_RX_CTL0, EMAC_RX_CTL0_RX_EN);
 	setbits_le32(priv->mac_reg + EMAC_TX_CTL0, EMAC_TX_CTL0_TX_EN);
@@ -487,6 +591,80 @@ static int sun8i_emac_eth_start(struct udevice *dev)
 	return 0;
 }
 
+/* Tell the stack about IP frames whose checksums the MAC found good */
+static void sun8i_emac_rx_csum(struct udevice *dev, u32 status)
+{
+	if ((status & (EMAC_DESC_RX_HEADER_ERR | EMAC_DESC_RX_FRM_TYPE |
+		       EMAC_DESC_RX_PAYLOAD_ERR)) == EMAC_DESC_RX_FRM_TYPE)
+		eth_rx_csum_verified(dev);
+}
+
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+static int sun8i_emac_recv_pair(struct udevice *dev, uchar **packetp)
+{
+	struct emac_eth_dev *priv = dev_get_priv(dev);
+	struct emac_dma_desc *desc_p = &priv->rx_chain[priv->rx_currdescnum];
+	uintptr_t data_start = desc_p[0].buf_addr;
+	ulong addr = desc_p[1].buf_addr;
+	u32 status;
+	int length;
+
+	/* Both descriptors of the pair are in the same cache line */
+	cache_inv_rx_descriptor(desc_p);
+
+	if ((desc_p[0].status | desc_p[1].status) & EMAC_DESC_OWN_DMA)
+		return -EAGAIN;
+
+	/*
+	 * Runt and error frames are dropped by the MAC, so every frame is
+	 * longer than the first buffer. Start over if one was not.
+	 */
+	if ((desc_p[0].status & (EMAC_DESC_RX_FIRST | EMAC_DESC_RX_LAST)) !=
+	    EMAC_DESC_RX_FIRST || !(desc_p[1].status & EMAC_DESC_RX_LAST)) {
+		debug("RX: frame not split across the pair\n");
+		priv->rx_restart = true;
+		return 0;
+	}
+
+	/* The length and errors are in the last descriptor */
+	status = desc_p[1].status;
+	length = (status >> 16) & 0x3fff;
+
+	if (status & EMAC_DESC_RX_ERROR_MASK) {
+		debug("RX: packet error: 0x%x\n",
+		      status & EMAC_DESC_RX_ERROR_MASK);
+		return 0;
+	}
+	if (length < 0x40) {
+		debug("RX: Bad Packet (runt)\n");
+		return 0;
+	}
+	if (length > CFG_ETH_RXSIZE) {
+		debug("RX: Too large packet (%d bytes)\n", length);
+		return 0;
+	}
+
+	/* make sure we read from DRAM, not our cache */
+	if (addr == data_start + priv->rx_head) {
+		invalidate_dcache_range(data_start, data_start +
+					roundup(length, ARCH_DMA_MINALIGN));
+	} else {
+		invalidate_dcache_range(data_start, data_start +
+					roundup(priv->rx_head,
+						ARCH_DMA_MINALIGN));
+		invalidate_dcache_range(ALIGN_DOWN(addr, ARCH_DMA_MINALIGN),
+					ALIGN(addr + length - priv->rx_head,
+					      ARCH_DMA_MINALIGN));
+		eth_rx_placed(dev, (uchar *)data_start, priv->rx_head, addr);
+	}
+
+	sun8i_emac_rx_csum(dev, status);
+	*packetp = (uchar *)data_start;
+
+	return length;
+}
+#endif
+
 static int sun8i_emac_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 {
 	struct emac_eth_dev *priv = dev_get_priv(dev);
@@ -495,8 +673,16 @@ static int sun8i_emac_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 	uintptr_t data_start = (uintptr_t)desc_p->buf_addr;
 	int length;
 
-	/* Invalidate entire buffer descriptor */
-	cache_inv_descriptor(desc_p);
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	if (priv->rx_head)
+		return sun8i_emac_recv_pair(dev, packetp);
+#endif
+
+	/*
+	 * Invalidate the cache line holding the descriptor. The CPU never
+	 * has it dirty, see sun8i_eth_free_pkt().
+	 */
+	cache_inv_rx_descriptor(desc_p);
 
 	status = desc_p->status;
 
@@ -525,6 +711,7 @@ static int sun8i_emac_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 		return 0;
 	}
 
+	sun8i_emac_rx_csum(dev, status);
 	*packetp = (uchar *)(ulong)desc_p->buf_addr;
 
 	return length;
@@ -534,10 +721,26 @@ static int sun8i_emac_eth_send(struct udevice *dev, void *packet, int length)
 {
 	struct emac_eth_dev *priv = dev_get_priv(dev);
 	u32 desc_num = priv->tx_currdescnum;
-	struct emac_dma_desc *desc_p = &priv->tx_chain[desc_num];
+	struct emac_dma_desc *desc_p = &priv->tx_chain[desc_num].desc;
 	uintptr_t data_start = (uintptr_t)desc_p->buf_addr;
 	uintptr_t data_end = data_start +
 		roundup(length, ARCH_DMA_MINALIGN);
+	ulong start = get_timer(0);
+
+	/*
+	 * If the ring wrapped around, wait for the MAC to be done with the
+	 * descriptor rather than overwriting a frame still being sent.
+	 */
+	for (;;) {
+		cache_inv_descriptor(desc_p);
+		if (!(desc_p->status & EMAC_DESC_OWN_DMA))
+			break;
+		if (get_timer(start) > 100) {
+			debug("TX: descriptor %u still owned by DMA\n",
+			      desc_num);
+			return -ETIMEDOUT;
+		}
+	}
 
 	desc_p->ctl_size = length | EMAC_DESC_CHAIN_SECOND;
 
@@ -662,24 +865,113 @@ static int sun8i_mdio_init(const char *name, struct udevice *priv)
 	return  mdio_register(bus);
 }
 
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+static void sun8i_emac_rx_restart(struct udevice *dev)
+{
+	struct emac_eth_dev *priv = dev_get_priv(dev);
+
+	clrbits_le32(priv->mac_reg + EMAC_RX_CTL1, EMAC_RX_CTL1_RX_DMA_EN);
+	rx_descs_init(dev);
+	setbits_le32(priv->mac_reg + EMAC_RX_CTL1, EMAC_RX_CTL1_RX_DMA_EN |
+		     EMAC_RX_CTL1_RX_DMA_START);
+}
+
+static int sun8i_eth_free_pair(struct udevice *dev)
+{
+	struct emac_eth_dev *priv = dev_get_priv(dev);
+	u32 desc_num = priv->rx_currdescnum;
+	struct emac_dma_desc *desc_p;
+	int i;
+
+	if (priv->rx_restart) {
+		priv->rx_restart = false;
+		sun8i_emac_rx_restart(dev);
+		return 0;
+	}
+
+	desc_num += 2;
+	if (desc_num >= CFG_RX_DESCR_NUM)
+		desc_num = 0;
+	priv->rx_currdescnum = desc_num;
+
+	if (desc_num % RX_DESCS_PER_CL)
+		return 0;
+
+	/* As in sun8i_eth_free_pkt(), a cache line of pairs at a time */
+	desc_p = &priv->rx_chain[(desc_num ? desc_num : CFG_RX_DESCR_NUM) -
+				 RX_DESCS_PER_CL];
+	for (i = 0; i < RX_DESCS_PER_CL; i += 2)
+		rx_pair_arm(dev, &desc_p[i]);
+	flush_dcache_range((uintptr_t)desc_p,
+			   (uintptr_t)desc_p + ARCH_DMA_MINALIGN);
+
+	return 0;
+}
+
+static int sun8i_eth_set_rx_dest(struct udevice *dev,
+				 const struct eth_rx_dest *dest)
+{
+	struct emac_eth_dev *priv = dev_get_priv(dev);
+	uint head = 0;
+
+	if (dest) {
+		/*
+		 * Pairs must not straddle cache lines, and the shortest
+		 * frame the MAC passes on must reach the second buffer.
+		 */
+		head = ALIGN(dest->hdr_len, 4);
+		if (RX_DESCS_PER_CL % 2 || head >= 60)
+			return -EINVAL;
+	}
+
+	priv->rx_head = head;
+	priv->rx_restart = false;
+	if (head)
+		clrbits_le32(priv->mac_reg + EMAC_RX_CTL1,
+			     EMAC_RX_CTL1_RX_ERR_FRM | EMAC_RX_CTL1_RX_RUNT_FRM);
+	else
+		setbits_le32(priv->mac_reg + EMAC_RX_CTL1,
+			     EMAC_RX_CTL1_RX_ERR_FRM | EMAC_RX_CTL1_RX_RUNT_FRM);
+	sun8i_emac_rx_restart(dev);
+
+	return 0;
+}
+#endif
+
 static int sun8i_eth_free_pkt(struct udevice *dev, uchar *packet,
 			      int length)
 {
 	struct emac_eth_dev *priv = dev_get_priv(dev);
 	u32 desc_num = priv->rx_currdescnum;
-	struct emac_dma_desc *desc_p = &priv->rx_chain[desc_num];
-
-	/* give the current descriptor back to the MAC */
-	desc_p->status |= EMAC_DESC_OWN_DMA;
+	struct emac_dma_desc *desc_p;
+	int i;
 
-	/* Flush Status field of descriptor */
-	cache_clean_descriptor(desc_p);
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	if (priv->rx_head)
+		return sun8i_eth_free_pair(dev);
+#endif
 
 	/* Move to next desc and wrap-around condition. */
 	if (++desc_num >= CFG_RX_DESCR_NUM)
 		desc_num = 0;
 	priv->rx_currdescnum = desc_num;
 
+	if (desc_num % RX_DESCS_PER_CL)
+		return 0;
+
+	/*
+	 * The CPU now owns every descriptor in the cache line we just
+	 * finished, and its copy of them is up to date since the line was
+	 * invalidated before the last one was read. Give them all back to
+	 * the MAC with a single clean.
+	 */
+	desc_p = &priv->rx_chain[(desc_num ? desc_num : CFG_RX_DESCR_NUM) -
+				 RX_DESCS_PER_CL];
+	for (i = 0; i < RX_DESCS_PER_CL; i++)
+		desc_p[i].status = EMAC_DESC_OWN_DMA;
+	flush_dcache_range((uintptr_t)desc_p,
+			   (uintptr_t)desc_p + ARCH_DMA_MINALIGN);
+
 	return 0;
 }
 
@@ -729,6 +1021,9 @@ static const struct eth_ops sun8i_emac_eth_ops = {
 	.recv                   = sun8i_emac_eth_recv,
 	.free_pkt               = sun8i_eth_free_pkt,
 	.stop                   = sun8i_emac_eth_stop,
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	.set_rx_dest            = sun8i_eth_set_rx_dest,
+#endif
 };
 
 static int sun8i_handle_internal_phy(struct udevice *dev, struct emac_eth_dev *priv)
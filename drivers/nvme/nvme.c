@@ -15,17 +15,19 @@
 #include <time.h>
 #include <dm/device-internal.h>
 #include <linux/compat.h>
+#include <linux/log2.h>
 #include "nvme.h"
 
-#define NVME_Q_DEPTH		2
+#define NVME_Q_DEPTH		CONFIG_NVME_QUEUE_DEPTH
 #define NVME_AQ_DEPTH		2
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
-#define NVME_CQ_ALLOCATION	ALIGN(NVME_CQ_SIZE(NVME_Q_DEPTH), \
-				      ARCH_DMA_MINALIGN)
+#define NVME_CQ_ALLOCATION(depth)	ALIGN(NVME_CQ_SIZE(depth), \
+					      ARCH_DMA_MINALIGN)
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
-#define MAX_PRP_POOL		512
+/* Largest number of blocks in a read/write, set by the 16-bit length field */
+#define MAX_IO_BLOCKS		0x10000
 
 static int nvme_wait_csts(struct nvme_dev *dev, u32 mask, u32 val)
 {
@@ -44,7 +46,17 @@ static int nvme_wait_csts(struct nvme_dev *dev, u32 mask, u32 val)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
+/**
+ * nvme_setup_prps() - set up the PRP entries for a transfer
+ *
+ * @dev:	NVMe device
+ * @prp_list:	PRP list to fill in, with room for dev->prp_entry_num entries
+ * @prp2:	Returns the value for the PRP2 field of the command
+ * @total_len:	Number of bytes to transfer
+ * @dma_addr:	Address of the buffer
+ * Return: 0 if OK, -EINVAL if the transfer does not fit in the list
+ */
+static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp_list, u64 *prp2,
 			   int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
@@ -73,36 +85,25 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	nprps = DIV_ROUND_UP(length, page_size);
 	num_pages = DIV_ROUND_UP(nprps - 1, prps_per_page - 1);
 
-	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
-		/*
-		 * Always increase in increments of pages.  It doesn't waste
-		 * much memory and reduces the number of allocations.
-		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
-			printf("Error: malloc prp_pool fail\n");
-			return -ENOMEM;
-		}
-		dev->prp_entry_num = num_pages * (prps_per_page - 1) + 1;
-	}
+	if (nprps > dev->prp_entry_num)
+		return -EINVAL;
 
-	prp_pool = dev->prp_pool;
+	prp_pool = prp_list;
 	i = 0;
 	while (nprps) {
 		if ((i == (prps_per_page - 1)) && nprps > 1) {
-			*(prp_pool + i) = cpu_to_le64((ulong)prp_pool +
-					page_size);
+			*(prp_pool + i) = cpu_to_le64((ulong)(prp_pool +
+					prps_per_page));
 			i = 0;
-			prp_pool += page_size;
+			prp_pool += prps_per_page;
 		}
 		*(prp_pool + i++) = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
 		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)prp_list;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
+	flush_dcache_range((ulong)prp_list, (ulong)prp_list +
 			   num_pages * page_size);
 
 	return 0;
@@ -124,7 +125,7 @@ static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
 	 * as the cache line should never become dirty.
 	 */
 	ulong start = (ulong)&nvmeq->cqes[0];
-	ulong stop = start + NVME_CQ_ALLOCATION;
+	ulong stop = start + NVME_CQ_ALLOCATION(nvmeq->q_depth);
 
 	invalidate_dcache_range(start, stop);
 
@@ -233,7 +234,7 @@ static struct nvme_queue *nvme_alloc_queue(struct nvme_dev *dev,
 		return NULL;
 	memset(nvmeq, 0, sizeof(*nvmeq));
 
-	nvmeq->cqes = (void *)memalign(4096, NVME_CQ_ALLOCATION);
+	nvmeq->cqes = (void *)memalign(4096, NVME_CQ_ALLOCATION(depth));
 	if (!nvmeq->cqes)
 		goto free_nvmeq;
 	memset((void *)nvmeq->cqes, 0, NVME_CQ_SIZE(depth));
@@ -344,7 +345,8 @@ static void nvme_init_queue(struct nvme_queue *nvmeq, u16 qid)
 	nvmeq->q_db = &dev->dbs[qid * 2 * dev->db_stride];
 	memset((void *)nvmeq->cqes, 0, NVME_CQ_SIZE(nvmeq->q_depth));
 	flush_dcache_range((ulong)nvmeq->cqes,
-			   (ulong)nvmeq->cqes + NVME_CQ_ALLOCATION);
+			   (ulong)nvmeq->cqes +
+			   NVME_CQ_ALLOCATION(nvmeq->q_depth));
 	dev->online_queues++;
 }
 
@@ -667,6 +669,44 @@ static int nvme_get_info_from_identify(struct nvme_dev *dev)
 	return 0;
 }
 
+/*
+ * Set up a PRP list for each command which can be in flight on the I/O
+ * queue, large enough for the biggest transfer the controller accepts. This
+ * must be called once the maximum transfer size is known.
+ */
+static int nvme_alloc_io_slots(struct nvme_dev *dev)
+{
+	struct nvme_ops *ops = (struct nvme_ops *)dev->udev->driver->ops;
+	u32 page_size = dev->page_size;
+	u32 prps_per_page = page_size >> 3;
+	u32 nprps, num_pages, i;
+
+	/* Controllers with their own submission method take one at a time */
+	if (ops && ops->submit_cmd)
+		dev->nslots = 1;
+	else
+		dev->nslots = dev->queues[NVME_IO_Q]->q_depth - 1;
+
+	/* PRP1 covers the first page, the rest go in the list */
+	nprps = max(1 << dev->max_transfer_shift >> ilog2(page_size), 1);
+	num_pages = max(DIV_ROUND_UP(nprps - 1, prps_per_page - 1), 1U);
+	dev->prp_entry_num = num_pages * (prps_per_page - 1) + 1;
+
+	dev->prp_pool = memalign(page_size,
+				 dev->nslots * num_pages * page_size);
+	dev->slots = calloc(dev->nslots, sizeof(*dev->slots));
+	if (!dev->prp_pool || !dev->slots) {
+		free(dev->prp_pool);
+		free(dev->slots);
+		return -ENOMEM;
+	}
+	for (i = 0; i < dev->nslots; i++)
+		dev->slots[i].prps = dev->prp_pool +
+			i * num_pages * prps_per_page;
+
+	return 0;
+}
+
 int nvme_get_namespace_id(struct udevice *udev, u32 *ns_id, u8 *eui64)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
@@ -741,65 +781,203 @@ static int nvme_blk_probe(struct udevice *udev)
 	return 0;
 }
 
-static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
-			 lbaint_t blkcnt, void *buffer, bool read)
+/* Find a free I/O slot, returning its index, or -ENOSPC if all are busy */
+static int nvme_get_slot(struct nvme_dev *dev)
+{
+	int i;
+
+	for (i = 0; i < dev->nslots; i++) {
+		if (!dev->slots[i].xfer)
+			return i;
+	}
+
+	return -ENOSPC;
+}
+
+/**
+ * nvme_xfer_fill() - submit commands for a transfer while slots are free
+ *
+ * Each command moves as many blocks as the controller allows (MDTS). This
+ * stops early once any command of the transfer has failed.
+ *
+ * @ns:		Namespace to transfer to/from
+ * @xfer:	Transfer to submit commands for
+ */
+static void nvme_xfer_fill(struct nvme_ns *ns, struct nvme_xfer *xfer)
 {
-	struct nvme_ns *ns = dev_get_priv(udev);
 	struct nvme_dev *dev = ns->dev;
-	struct nvme_command c;
-	struct blk_desc *desc = dev_get_uclass_plat(udev);
-	int status;
+	struct nvme_io_slot *slot;
+	struct nvme_command *c;
+	u32 lbas, max_lbas;
 	u64 prp2;
-	u64 total_len = blkcnt << desc->log2blksz;
-	u64 temp_len = total_len;
-	uintptr_t temp_buffer = (uintptr_t)buffer;
+	int cid;
 
-	u64 slba = blknr;
-	u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
-	u64 total_lbas = blkcnt;
+	max_lbas = min(1 << (dev->max_transfer_shift - ns->lba_shift),
+		       MAX_IO_BLOCKS);
+	while (xfer->next < xfer->fail) {
+		cid = nvme_get_slot(dev);
+		if (cid < 0)
+			break;
+		slot = &dev->slots[cid];
 
-	flush_dcache_range((unsigned long)buffer,
-			   (unsigned long)buffer + total_len);
-
-	c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
-	c.rw.flags = 0;
-	c.rw.nsid = cpu_to_le32(ns->ns_id);
-	c.rw.control = 0;
-	c.rw.dsmgmt = 0;
-	c.rw.reftag = 0;
-	c.rw.apptag = 0;
-	c.rw.appmask = 0;
-	c.rw.metadata = 0;
-
-	while (total_lbas) {
-		if (total_lbas < lbas) {
-			lbas = (u16)total_lbas;
-			total_lbas = 0;
-		} else {
-			total_lbas -= lbas;
+		lbas = min_t(u64, max_lbas, xfer->end - xfer->next);
+		if (nvme_setup_prps(dev, slot->prps, &prp2,
+				    lbas << ns->lba_shift, xfer->buf)) {
+			xfer->fail = xfer->next;
+			break;
 		}
 
-		if (nvme_setup_prps(dev, &prp2,
-				    lbas << ns->lba_shift, temp_buffer))
-			return -EIO;
-		c.rw.slba = cpu_to_le64(slba);
-		slba += lbas;
-		c.rw.length = cpu_to_le16(lbas - 1);
-		c.rw.prp1 = cpu_to_le64(temp_buffer);
-		c.rw.prp2 = cpu_to_le64(prp2);
-		status = nvme_submit_sync_cmd(dev->queues[NVME_IO_Q],
-				&c, NULL, IO_TIMEOUT);
-		if (status)
+		c = &slot->cmd;
+		memset(c, '\0', sizeof(*c));
+		c->rw.opcode = xfer->read ? nvme_cmd_read : nvme_cmd_write;
+		c->rw.command_id = cpu_to_le16(cid);
+		c->rw.nsid = cpu_to_le32(ns->ns_id);
+		c->rw.slba = cpu_to_le64(xfer->next);
+		c->rw.length = cpu_to_le16(lbas - 1);
+		c->rw.prp1 = cpu_to_le64(xfer->buf);
+		c->rw.prp2 = cpu_to_le64(prp2);
+
+		slot->xfer = xfer;
+		slot->slba = xfer->next;
+		xfer->pending++;
+		xfer->next += lbas;
+		xfer->buf += (ulong)lbas << ns->lba_shift;
+		nvme_submit_cmd(dev->queues[NVME_IO_Q], c);
+	}
+}
+
+/**
+ * nvme_reap_cmd() - wait for the next I/O completion and free its slot
+ *
+ * Completions may belong to any transfer, not just the one being waited
+ * for, and can arrive in any order.
+ *
+ * @dev:	NVMe device
+ * Return: 0 if OK, -ETIMEDOUT if nothing completed in time
+ */
+static int nvme_reap_cmd(struct nvme_dev *dev)
+{
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
+	struct nvme_ops *ops = (struct nvme_ops *)dev->udev->driver->ops;
+	struct nvme_io_slot *slot = NULL;
+	u16 head = nvmeq->cq_head;
+	ulong start_time;
+	u16 status, cid;
+
+	start_time = timer_get_us();
+	for (;;) {
+		status = nvme_read_completion_status(nvmeq, head);
+		if ((status & 0x01) == nvmeq->cq_phase)
+			break;
+		if (timer_get_us() - start_time >= IO_TIMEOUT * 100000)
+			return -ETIMEDOUT;
+	}
+
+	cid = readw(&nvmeq->cqes[head].command_id);
+	if (cid < dev->nslots && dev->slots[cid].xfer)
+		slot = &dev->slots[cid];
+	if (slot && ops && ops->complete_cmd)
+		ops->complete_cmd(nvmeq, &slot->cmd);
+
+	if (++head == nvmeq->q_depth) {
+		head = 0;
+		nvmeq->cq_phase = !nvmeq->cq_phase;
+	}
+	writel(head, nvmeq->q_db + dev->db_stride);
+	nvmeq->cq_head = head;
+
+	if (!slot) {
+		log_debug("Stray completion for command %u\n", cid);
+		return 0;
+	}
+
+	status >>= 1;
+	if (status) {
+		printf("ERROR: status = %x, command = %u\n", status, cid);
+		slot->xfer->fail = min(slot->xfer->fail, slot->slba);
+	}
+	slot->xfer->pending--;
+	slot->xfer = NULL;
+
+	return 0;
+}
+
+/**
+ * nvme_xfer_start() - start a transfer, submitting as many commands as fit
+ *
+ * @ns:		Namespace to transfer to/from
+ * @xfer:	Transfer to set up; this must stay valid until
+ *		nvme_xfer_finish() returns
+ * @blknr:	First block
+ * @blkcnt:	Number of blocks
+ * @buffer:	Buffer to read into or write from
+ * @read:	true to read, false to write
+ */
+static void nvme_xfer_start(struct nvme_ns *ns, struct nvme_xfer *xfer,
+			    lbaint_t blknr, lbaint_t blkcnt, void *buffer,
+			    bool read)
+{
+	xfer->start = blknr;
+	xfer->next = blknr;
+	xfer->end = blknr + blkcnt;
+	xfer->fail = xfer->end;
+	xfer->data = buffer;
+	xfer->buf = (uintptr_t)buffer;
+	xfer->pending = 0;
+	xfer->read = read;
+
+	flush_dcache_range((unsigned long)buffer,
+			   (unsigned long)buffer + (blkcnt << ns->lba_shift));
+	nvme_xfer_fill(ns, xfer);
+}
+
+/**
+ * nvme_xfer_finish() - wait for a transfer, submitting the rest of it
+ *
+ * @ns:		Namespace the transfer is on
+ * @xfer:	Transfer started by nvme_xfer_start()
+ * Return: number of blocks transferred before the first failure, if any
+ */
+static ulong nvme_xfer_finish(struct nvme_ns *ns, struct nvme_xfer *xfer)
+{
+	struct nvme_dev *dev = ns->dev;
+	int i;
+
+	while (xfer->pending || xfer->next < xfer->fail) {
+		if (nvme_reap_cmd(dev)) {
+			/* late completions for this transfer are ignored */
+			for (i = 0; i < dev->nslots; i++) {
+				if (dev->slots[i].xfer != xfer)
+					continue;
+				xfer->fail = min(xfer->fail,
+						 dev->slots[i].slba);
+				dev->slots[i].xfer = NULL;
+			}
+			xfer->fail = min(xfer->fail, xfer->next);
+			xfer->pending = 0;
 			break;
-		temp_len -= (u32)lbas << ns->lba_shift;
-		temp_buffer += lbas << ns->lba_shift;
+		}
+		nvme_xfer_fill(ns, xfer);
 	}
 
-	if (read)
-		invalidate_dcache_range((unsigned long)buffer,
-					(unsigned long)buffer + total_len);
+	if (xfer->read)
+		invalidate_dcache_range((unsigned long)xfer->data,
+					(unsigned long)xfer->data +
+					((xfer->end - xfer->start) <<
+					 ns->lba_shift));
+
+	return xfer->fail - xfer->start;
+}
+
+static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
+			 lbaint_t blkcnt, void *buffer, bool read)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	struct nvme_xfer xfer;
+
+	nvme_xfer_start(ns, &xfer, blknr, blkcnt, buffer, read);
 
-	return (total_len - temp_len) >> desc->log2blksz;
+	return nvme_xfer_finish(ns, &xfer);
 }
 
 static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
@@ -814,9 +992,39 @@ static ulong nvme_blk_write(struct udevice *udev, lbaint_t blknr,
 	return nvme_blk_rw(udev, blknr, blkcnt, (void *)buffer, false);
 }
 
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+/*
+ * Fill the I/O queue and return, leaving the controller to get on with it.
+ * The rest of the commands are submitted as slots free up in nvme_blk_wait()
+ */
+static int nvme_blk_submit(struct udevice *udev, struct blk_req *req)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(udev);
+	struct nvme_ns *ns = dev_get_priv(udev);
+
+	if (req->start + req->blkcnt > desc->lba)
+		return -EINVAL;
+	nvme_xfer_start(ns, &ns->xfer, req->start, req->blkcnt, req->buf,
+			req->op == BLK_REQ_READ);
+
+	return 0;
+}
+
+static long nvme_blk_wait(struct udevice *udev, struct blk_req *req)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+
+	return nvme_xfer_finish(ns, &ns->xfer);
+}
+#endif
+
 static const struct blk_ops nvme_blk_ops = {
 	.read	= nvme_blk_read,
 	.write	= nvme_blk_write,
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	.submit	= nvme_blk_submit,
+	.wait	= nvme_blk_wait,
+#endif
 };
 
 U_BOOT_DRIVER(nvme_blk) = {
@@ -860,15 +1068,6 @@ int nvme_init(struct udevice *udev)
 		goto free_queue;
 	}
 
-	/* Allocate after the page size is known */
-	ndev->prp_pool = memalign(ndev->page_size, MAX_PRP_POOL);
-	if (!ndev->prp_pool) {
-		ret = -ENOMEM;
-		printf("Error: %s: Out of memory!\n", udev->name);
-		goto free_nvme;
-	}
-	ndev->prp_entry_num = MAX_PRP_POOL >> 3;
-
 	ret = nvme_setup_io_queues(ndev);
 	if (ret) {
 		log_debug("Unable to setup I/O queues(err=%dE)\n", ret);
@@ -877,6 +1076,12 @@ int nvme_init(struct udevice *udev)
 
 	nvme_get_info_from_identify(ndev);
 
+	ret = nvme_alloc_io_slots(ndev);
+	if (ret) {
+		printf("Error: %s: Out of memory!\n", udev->name);
+		goto free_queue;
+	}
+
 	/* Create a blk device for each namespace */
 
 	id = memalign(ndev->page_size, sizeof(struct nvme_id_ns));
@@ -620,6 +620,8 @@ struct nvme_dev {
 	u8 vwc;
 	u64 *prp_pool;
 	u32 prp_entry_num;
+	struct nvme_io_slot *slots;
+	u32 nslots;
 	u32 nn;
 };
 
@@ -630,6 +632,47 @@ enum nvme_queue_id {
 	NVME_Q_NUM,
 };
 
+/**
+ * struct nvme_xfer - a read or write, split into commands of up to MDTS each
+ *
+ * @start: First block to transfer
+ * @next: Next block to submit a command for
+ * @end: Block after the last one
+ * @fail: Lowest block of a command which failed, or @end if none failed
+ * @data: Start of the buffer
+ * @buf: Buffer position for @next
+ * @pending: Number of commands in flight
+ * @read: true to read, false to write
+ */
+struct nvme_xfer {
+	u64 start;
+	u64 next;
+	u64 end;
+	u64 fail;
+	void *data;
+	uintptr_t buf;
+	int pending;
+	bool read;
+};
+
+/**
+ * struct nvme_io_slot - an I/O command which may be in flight
+ *
+ * The index of the slot is used as the command ID, so that completions can
+ * be matched up however the controller orders them.
+ *
+ * @xfer: Transfer the command belongs to, or NULL if the slot is free
+ * @prps: PRP list for the command, from the device's prp_pool
+ * @slba: First block transferred by the command
+ * @cmd: The command, kept for controller-specific completion
+ */
+struct nvme_io_slot {
+	struct nvme_xfer *xfer;
+	u64 *prps;
+	u64 slba;
+	struct nvme_command cmd;
+};
+
 /*
  * An NVM Express queue. Each device has at least two (one for admin
  * commands and one for I/O commands).
@@ -662,6 +705,7 @@ struct nvme_ns {
 	int devnum;
 	int lba_shift;
 	u8 flbas;
+	struct nvme_xfer xfer;
 };
 
 struct nvme_ops {
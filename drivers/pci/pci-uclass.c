@@ -864,10 +864,14 @@ int pci_bind_bus_devices(struct udevice *bus)
 	ulong header_type;
 	pci_dev_t bdf, end;
 	bool found_multi;
+	bool cached, new_dev;
 	int ari_off;
 	int ret;
 
+	/* only try the devices found last time, if they are still there */
+	cached = !pci_scan_cache_check(bus);
 	found_multi = false;
+	new_dev = false;
 	end = PCI_BDF(dev_seq(bus), PCI_MAX_PCI_DEVICES - 1,
 		      PCI_MAX_PCI_FUNCTIONS - 1);
 	for (bdf = PCI_BDF(dev_seq(bus), 0, 0); bdf <= end;
@@ -876,10 +880,15 @@ int pci_bind_bus_devices(struct udevice *bus)
 		struct udevice *dev;
 		ulong class;
 
-		if (!PCI_FUNC(bdf))
+		if (!PCI_FUNC(bdf)) {
 			found_multi = false;
+			/* a device may have been added to an empty slot */
+			new_dev = cached && !pci_scan_cache_listed(bus, bdf);
+		}
 		if (PCI_FUNC(bdf) && !found_multi)
 			continue;
+		if (cached && !new_dev && !pci_scan_cache_listed(bus, bdf))
+			continue;
 
 		/* Check only the first access, we don't expect problems */
 		ret = pci_bus_read_config(bus, bdf, PCI_VENDOR_ID, &vendor,
@@ -900,6 +909,8 @@ int pci_bind_bus_devices(struct udevice *bus)
 		pci_bus_read_config(bus, bdf, PCI_CLASS_REVISION, &class,
 				    PCI_SIZE_32);
 		class >>= 8;
+		if (!cached || new_dev)
+			pci_scan_cache_add(bus, bdf, vendor, device);
 
 		/* Find this device in the device tree */
 		ret = pci_bus_find_devfn(bus, PCI_MASK_BUS(bdf), &dev);
@@ -58,4 +58,78 @@ int dm_pciauto_config_device(struct udevice *dev);
  */
 int pci_get_bus(int busnum, struct udevice **busp);
 
+#if CONFIG_IS_ENABLED(PCI_SCAN_CACHE)
+/**
+ * pci_scan_cache_check() - check whether a bus can use the recorded scan
+ *
+ * This checks that every device recorded for the bus at the last full scan
+ * still has the same vendor and device IDs. If not, or if the bus is not
+ * recorded, it is set up to be recorded again by pci_scan_cache_add().
+ *
+ * @bus:	Bus about to be scanned
+ * Return: 0 if only the devices in the record need to be scanned, -ENOENT
+ * if the bus must be scanned in full
+ */
+int pci_scan_cache_check(struct udevice *bus);
+
+/**
+ * pci_scan_cache_listed() - check if a device is in the recorded scan
+ *
+ * This may only be used once pci_scan_cache_check() has returned 0. Function
+ * 0 of a slot which is not listed must still be probed, since a device may
+ * have been added there.
+ *
+ * @bus:	Bus being scanned
+ * @bdf:	Device to check
+ * Return: true if the device was found at the last full scan
+ */
+bool pci_scan_cache_listed(struct udevice *bus, pci_dev_t bdf);
+
+/**
+ * pci_scan_cache_add() - record a device which was not in the record
+ *
+ * This is used for each device found by a full scan, and for a device found
+ * in a slot which was empty at the last one.
+ *
+ * @bus:	Bus being scanned
+ * @bdf:	Device found
+ * @vendor:	Vendor ID of the device
+ * @device:	Device ID of the device
+ */
+void pci_scan_cache_add(struct udevice *bus, pci_dev_t bdf, uint vendor,
+			uint device);
+
+/**
+ * pci_scan_cache_save() - write the record to the environment
+ *
+ * This is called on entering the main loop, by which time the buses needed
+ * for booting have normally been scanned. The variable is not updated unless
+ * a device has been added since the record was read. The environment is not
+ * saved.
+ *
+ * Return: 0 if OK, -ve on error
+ */
+int pci_scan_cache_save(void);
+#else
+static inline int pci_scan_cache_check(struct udevice *bus)
+{
+	return -ENOENT;
+}
+
+static inline bool pci_scan_cache_listed(struct udevice *bus, pci_dev_t bdf)
+{
+	return true;
+}
+
+static inline void pci_scan_cache_add(struct udevice *bus, pci_dev_t bdf,
+				      uint vendor, uint device)
+{
+}
+
+static inline int pci_scan_cache_save(void)
+{
+	return 0;
+}
+#endif
+
 #endif
@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Recording which devices were found on each PCI bus, so that the next scan
+ * can skip the functions which were not there
+ *
+ * Each config read of a missing function can take a long time behind a PCIe
+ * switch, while a scan tries all eight functions of each multi-function
+ * device. The record is kept in the 'pci_scan' environment variable, as a
+ * list of buses, each followed by its devices:
+ *
+ *	b<bus> <devfn>=<vendor>:<device> ...
+ *
+ * with all numbers in hex. A bus is only scanned in full if it is not in the
+ * record or any of its recorded devices no longer answers with the same IDs.
+ * Function 0 of each empty slot is still probed, so that a device added
+ * there is found and recorded.
+ */
+
+#define LOG_CATEGORY UCLASS_PCI
+
+#include <dm.h>
+#include <env.h>
+#include <event.h>
+#include <log.h>
+#include <malloc.h>
+#include <pci.h>
+#include <vsprintf.h>
+#include <asm/global_data.h>
+#include <linux/bitmap.h>
+#include <linux/string.h>
+#include "pci_internal.h"
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define PCI_SCAN_VAR		"pci_scan"
+
+enum {
+	PCI_SCAN_MAX_DEVS	= 128,
+	PCI_SCAN_MAX_BUSES	= 256,
+	PCI_SCAN_ENT_LEN	= 16,	/* " ff=ffff:ffff" or " bff" */
+};
+
+/**
+ * struct pci_scan_ent - a device found by a full bus scan
+ *
+ * @bus: Bus number
+ * @devfn: Device and function, as PCI_DEVFN()
+ * @vendor: Vendor ID
+ * @device: Device ID
+ */
+struct pci_scan_ent {
+	u8 bus;
+	u8 devfn;
+	u16 vendor;
+	u16 device;
+};
+
+/**
+ * struct pci_scan_cache - the record, as loaded and updated during this boot
+ *
+ * @loaded: true if the environment variable has been read
+ * @dirty: true if a device has been added since then
+ * @full: true if there were too many devices to record
+ * @count: Number of entries in @ent
+ * @buses: Buses which are recorded, even if they have no devices
+ * @ent: Devices found
+ */
+struct pci_scan_cache {
+	bool loaded;
+	bool dirty;
+	bool full;
+	int count;
+	DECLARE_BITMAP(buses, PCI_SCAN_MAX_BUSES);
+	struct pci_scan_ent ent[PCI_SCAN_MAX_DEVS];
+};
+
+static struct pci_scan_cache pci_scan_cache;
+
+static int pci_scan_cache_parse(struct pci_scan_cache *cache, const char *rec)
+{
+	char *str, *p, *tok, *end;
+	int bus = -1;
+
+	str = strdup(rec);
+	if (!str)
+		return -ENOMEM;
+	for (p = str; (tok = strsep(&p, " "));) {
+		struct pci_scan_ent *ent = &cache->ent[cache->count];
+
+		if (!*tok)
+			continue;
+		if (*tok == 'b') {
+			bus = hextoul(tok + 1, &end);
+			if (*end || bus >= PCI_SCAN_MAX_BUSES)
+				break;
+			set_bit(bus, cache->buses);
+			continue;
+		}
+		if (bus < 0 || cache->count == PCI_SCAN_MAX_DEVS)
+			break;
+		ent->bus = bus;
+		ent->devfn = hextoul(tok, &end);
+		if (*end++ != '=')
+			break;
+		ent->vendor = hextoul(end, &end);
+		if (*end++ != ':')
+			break;
+		ent->device = hextoul(end, &end);
+		if (*end)
+			break;
+		cache->count++;
+	}
+	free(str);
+
+	return tok ? -EINVAL : 0;
+}
+
+/*
+ * Get the record, reading it from the environment if needed. This is not
+ * used before relocation, when there is no BSS.
+ */
+static struct pci_scan_cache *pci_scan_cache_get(void)
+{
+	struct pci_scan_cache *cache = &pci_scan_cache;
+	const char *rec;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return NULL;
+	if (cache->loaded)
+		return cache;
+
+	memset(cache, '\0', sizeof(*cache));
+	cache->loaded = true;
+	rec = env_get(PCI_SCAN_VAR);
+	if (rec && pci_scan_cache_parse(cache, rec)) {
+		log_warning("Ignoring invalid '%s'\n", PCI_SCAN_VAR);
+		memset(cache->buses, '\0', sizeof(cache->buses));
+		cache->count = 0;
+		cache->dirty = true;
+	}
+
+	return cache;
+}
+
+/* Drop the record of a bus, ready for it to be scanned again */
+static void pci_scan_cache_drop(struct pci_scan_cache *cache, int busnum)
+{
+	int i, count;
+
+	for (i = 0, count = 0; i < cache->count; i++) {
+		if (cache->ent[i].bus != busnum)
+			cache->ent[count++] = cache->ent[i];
+	}
+	cache->count = count;
+	clear_bit(busnum, cache->buses);
+}
+
+int pci_scan_cache_check(struct udevice *bus)
+{
+	struct pci_scan_cache *cache = pci_scan_cache_get();
+	int busnum = dev_seq(bus);
+	int i;
+
+	if (!cache || busnum >= PCI_SCAN_MAX_BUSES || cache->full)
+		return -ENOENT;
+	if (!test_bit(busnum, cache->buses))
+		goto scan;
+
+	for (i = 0; i < cache->count; i++) {
+		struct pci_scan_ent *ent = &cache->ent[i];
+		ulong val;
+
+		if (ent->bus != busnum)
+			continue;
+		if (pci_bus_read_config(bus, PCI_BDF(busnum, ent->devfn >> 3,
+							     ent->devfn & 7),
+					PCI_VENDOR_ID, &val, PCI_SIZE_32) ||
+		    val != (ent->vendor | ent->device << 16)) {
+			log_debug("Bus %x: device %x changed, rescanning\n",
+				  busnum, ent->devfn);
+			goto scan;
+		}
+	}
+
+	return 0;
+
+scan:
+	pci_scan_cache_drop(cache, busnum);
+	set_bit(busnum, cache->buses);
+	cache->dirty = true;
+
+	return -ENOENT;
+}
+
+bool pci_scan_cache_listed(struct udevice *bus, pci_dev_t bdf)
+{
+	struct pci_scan_cache *cache = &pci_scan_cache;
+	int i;
+
+	for (i = 0; i < cache->count; i++) {
+		if (cache->ent[i].bus == dev_seq(bus) &&
+		    cache->ent[i].devfn == PCI_MASK_BUS(bdf) >> 8)
+			return true;
+	}
+
+	return false;
+}
+
+void pci_scan_cache_add(struct udevice *bus, pci_dev_t bdf, uint vendor,
+			uint device)
+{
+	struct pci_scan_cache *cache = pci_scan_cache_get();
+	struct pci_scan_ent *ent;
+
+	if (!cache || dev_seq(bus) >= PCI_SCAN_MAX_BUSES)
+		return;
+	if (cache->count == PCI_SCAN_MAX_DEVS) {
+		cache->full = true;
+		return;
+	}
+	ent = &cache->ent[cache->count++];
+	cache->dirty = true;
+	ent->bus = dev_seq(bus);
+	ent->devfn = PCI_MASK_BUS(bdf) >> 8;
+	ent->vendor = vendor;
+	ent->device = device;
+}
+
+int pci_scan_cache_save(void)
+{
+	struct pci_scan_cache *cache = pci_scan_cache_get();
+	char *buf, *p;
+	int bus, i, ret;
+
+	if (!cache || !cache->dirty || cache->full)
+		return 0;
+
+	buf = malloc((cache->count + PCI_SCAN_MAX_BUSES) * PCI_SCAN_ENT_LEN);
+	if (!buf)
+		return log_msg_ret("pcs", -ENOMEM);
+	p = buf;
+	*p = '\0';
+	for_each_set_bit(bus, cache->buses, PCI_SCAN_MAX_BUSES) {
+		p += sprintf(p, "%sb%x", p == buf ? "" : " ", bus);
+		for (i = 0; i < cache->count; i++) {
+			struct pci_scan_ent *ent = &cache->ent[i];
+
+			if (ent->bus == bus)
+				p += sprintf(p, " %x=%x:%x", ent->devfn,
+					     ent->vendor, ent->device);
+		}
+	}
+	cache->dirty = false;
+
+	ret = env_set(PCI_SCAN_VAR, buf);
+	free(buf);
+	if (ret)
+		return log_msg_ret("pce", ret);
+
+	return 0;
+}
+
+static int pci_scan_cache_main_loop(void)
+{
+	return pci_scan_cache_save();
+}
+EVENT_SPY_SIMPLE(EVT_MAIN_LOOP, pci_scan_cache_main_loop);
+
+/* Read the record again if it is changed or deleted */
+static int on_pci_scan(const char *name, const char *value, enum env_op op,
+		       int flags)
+{
+	if (gd->flags & GD_FLG_RELOC)
+		pci_scan_cache.loaded = false;
+
+	return 0;
+}
+U_BOOT_ENV_CALLBACK(pci_scan, on_pci_scan);
@@ -12,11 +12,13 @@
 
 #include <clk.h>
 #include <dm.h>
+#include <event.h>
 #include <log.h>
 #include <dm/device.h>
 #include <generic-phy.h>
 #include <phy-sun4i-usb.h>
 #include <reset.h>
+#include <time.h>
 #include <asm/gpio.h>
 #include <asm/io.h>
 #include <dm/device_compat.h>
@@ -131,6 +133,9 @@ struct sun4i_usb_phy_data {
 };
 
 static int initial_usb_scan_delay = CONFIG_INITIAL_USB_SCAN_DELAY;
+/* Time at which Vbus was switched on early, see sun4i_usb_phy_early_vbus() */
+static ulong early_vbus_start;
+static bool early_vbus;
 
 static void sun4i_usb_phy_write(struct phy *phy, u32 addr, u32 data, int len)
 {
@@ -210,7 +215,10 @@ static int sun4i_usb_phy_power_on(struct phy *phy)
 	struct sun4i_usb_phy_plat *usb_phy = &data->usb_phy[phy->id];
 
 	if (initial_usb_scan_delay) {
-		mdelay(initial_usb_scan_delay);
+		ulong elapsed = early_vbus ? get_timer(early_vbus_start) : 0;
+
+		if (elapsed < initial_usb_scan_delay)
+			mdelay(initial_usb_scan_delay - elapsed);
 		initial_usb_scan_delay = 0;
 	}
 
@@ -717,3 +725,35 @@ U_BOOT_DRIVER(sun4i_usb_phy) = {
 	.plat_auto	= sizeof(struct sun4i_usb_phy_plat[MAX_PHYS]),
 	.priv_auto	= sizeof(struct sun4i_usb_phy_data),
 };
+
+#if IS_ENABLED(CONFIG_SUNXI_USB_ON_DEMAND)
+/*
+ * USB is only started when it is needed, so switch on the Vbus of the host
+ * ports now and let devices power up in the meantime. The OTG port is left
+ * alone, since sun4i_usb_phy_power_on() must check for an external Vbus
+ * first.
+ */
+static int sun4i_usb_phy_early_vbus(void)
+{
+	struct sun4i_usb_phy_data *data;
+	struct udevice *dev;
+	int i;
+
+	if (uclass_get_device_by_driver(UCLASS_PHY,
+					DM_DRIVER_GET(sun4i_usb_phy), &dev))
+		return 0;
+
+	data = dev_get_priv(dev);
+	for (i = 1; i < data->cfg->num_phys; i++) {
+		struct sun4i_usb_phy_plat *usb_phy = &data->usb_phy[i];
+
+		if (dm_gpio_is_valid(&usb_phy->gpio_vbus))
+			dm_gpio_set_value(&usb_phy->gpio_vbus, 1);
+	}
+	early_vbus_start = get_timer(0);
+	early_vbus = true;
+
+	return 0;
+}
+EVENT_SPY_SIMPLE(EVT_DM_POST_INIT_R, sun4i_usb_phy_early_vbus);
+#endif
@@ -43,6 +43,7 @@ static struct dm_pmic_ops axp_pmic_ops = {
 	.reg_count	= axp_pmic_reg_count,
 	.read		= dm_i2c_read,
 	.write		= dm_i2c_write,
+	.write_regs	= pmic_i2c_write_regs,
 };
 
 static const struct pmic_child_info axp_pmic_child_info[] = {
@@ -9,6 +9,7 @@
 #include <fdtdec.h>
 #include <errno.h>
 #include <dm.h>
+#include <i2c.h>
 #include <log.h>
 #include <vsprintf.h>
 #include <dm/lists.h>
@@ -16,6 +17,8 @@
 #include <dm/uclass-internal.h>
 #include <power/pmic.h>
 #include <linux/ctype.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
 
 #if CONFIG_IS_ENABLED(PMIC_CHILDREN)
 int pmic_bind_children(struct udevice *pmic, ofnode parent,
@@ -170,6 +173,88 @@ int pmic_reg_write(struct udevice *dev, uint reg, uint value)
 	return ret;
 }
 
+static int pmic_write_regs_single(struct udevice *dev,
+				  const struct pmic_reg_val *regs, int count)
+{
+	int ret, i;
+
+	for (i = 0; i < count; i++) {
+		ret = pmic_reg_write(dev, regs[i].reg, regs[i].val);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int pmic_write_regs(struct udevice *dev, const struct pmic_reg_val *regs,
+		    int count)
+{
+	const struct dm_pmic_ops *ops = dev_get_driver_ops(dev);
+
+	if (!regs)
+		return -EFAULT;
+
+	if (!ops)
+		return -ENOSYS;
+
+	if (ops->write_regs)
+		return ops->write_regs(dev, regs, count);
+
+	return pmic_write_regs_single(dev, regs, count);
+}
+
+#if CONFIG_IS_ENABLED(DM_I2C)
+enum {
+	PMIC_I2C_BATCH		= 16,	/* messages in each transfer */
+	PMIC_I2C_MSG_LEN	= 2 * sizeof(uint),	/* offset and value */
+};
+
+int pmic_i2c_write_regs(struct udevice *dev, const struct pmic_reg_val *regs,
+			int count)
+{
+	struct uc_pmic_priv *priv = dev_get_uclass_priv(dev);
+	struct dm_i2c_chip *chip = dev_get_parent_plat(dev);
+	u8 buf[PMIC_I2C_BATCH][PMIC_I2C_MSG_LEN];
+	struct i2c_msg msg[PMIC_I2C_BATCH];
+	int done = 0, n, i, j, ret;
+
+	if (priv->trans_len < 1 || priv->trans_len > sizeof(uint) ||
+	    chip->offset_len > sizeof(uint) ||
+	    (chip->flags & DM_I2C_CHIP_WR_ADDRESS))
+		return pmic_write_regs_single(dev, regs, count);
+
+	for (; done < count; done += n) {
+		n = min(count - done, (int)PMIC_I2C_BATCH);
+		for (i = 0; i < n; i++) {
+			const struct pmic_reg_val *rv = &regs[done + i];
+			u8 *p = buf[i];
+
+			msg[i].addr = chip->chip_addr;
+			if (chip->chip_addr_offset_mask)
+				msg[i].addr |= chip->chip_addr_offset_mask &
+					(rv->reg >> (8 * chip->offset_len));
+			msg[i].flags = chip->flags & DM_I2C_CHIP_10BIT ?
+				I2C_M_TEN : 0;
+			msg[i].len = chip->offset_len + priv->trans_len;
+			msg[i].buf = p;
+			for (j = chip->offset_len; j--;)
+				*p++ = rv->reg >> (8 * j);
+			/* the same byte order as pmic_reg_write() uses */
+			memcpy(p, &rv->val, priv->trans_len);
+		}
+		ret = dm_i2c_xfer(dev, msg, n);
+		if (ret) {
+			log_debug("Cannot write %d regs at once (err=%d)\n", n,
+				  ret);
+			break;
+		}
+	}
+
+	return pmic_write_regs_single(dev, regs + done, count - done);
+}
+#endif
+
 int pmic_clrsetbits(struct udevice *dev, uint reg, uint clr, uint set)
 {
 	struct uc_pmic_priv *priv = dev_get_uclass_priv(dev);
@@ -62,6 +62,7 @@ static struct dm_pmic_ops sandbox_pmic_ops = {
 	.reg_count = sandbox_pmic_reg_count,
 	.read = sandbox_pmic_read,
 	.write = sandbox_pmic_write,
+	.write_regs = pmic_i2c_write_regs,
 };
 
 static const struct udevice_id sandbox_pmic_ids[] = {
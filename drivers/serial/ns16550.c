@@ -392,6 +392,36 @@ int ns16550_serial_putc(struct udevice *dev, const char ch)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(SERIAL_PUTS)
+/*
+ * With the FIFO enabled, THRE means that the whole FIFO is empty, so up to
+ * its size can be written without checking the status in between. The
+ * 16550A FIFO holds 16 bytes; later parts have at least as much.
+ */
+#define NS16550_TX_BURST	16
+
+static ssize_t ns16550_serial_puts(struct udevice *dev, const char *s,
+				   size_t len)
+{
+	struct ns16550 *const com_port = dev_get_priv(dev);
+	size_t i;
+
+	if (!(serial_in(&com_port->lsr) & UART_LSR_THRE))
+		return 0;
+	if (!(ns16550_getfcr(com_port) & UART_FCR_FIFO_EN))
+		len = 1;
+	len = min_t(size_t, len, NS16550_TX_BURST);
+	for (i = 0; i < len; i++)
+		serial_out(s[i], &com_port->thr);
+
+	/* as in ns16550_serial_putc() */
+	if (memchr(s, '\n', len))
+		schedule();
+
+	return len;
+}
+#endif
+
 int ns16550_serial_pending(struct udevice *dev, bool input)
 {
 	struct ns16550 *const com_port = dev_get_priv(dev);
@@ -586,6 +616,9 @@ int ns16550_serial_of_to_plat(struct udevice *dev)
 
 const struct dm_serial_ops ns16550_serial_ops = {
 	.putc = ns16550_serial_putc,
+#if CONFIG_IS_ENABLED(SERIAL_PUTS)
+	.puts = ns16550_serial_puts,
+#endif
 	.pending = ns16550_serial_pending,
 	.getc = ns16550_serial_getc,
 	.setbrg = ns16550_serial_setbrg,
@@ -6,6 +6,7 @@
 #define LOG_CATEGORY UCLASS_SERIAL
 
 #include <config.h>
+#include <cyclic.h>
 #include <dm.h>
 #include <env_internal.h>
 #include <errno.h>
@@ -232,10 +233,150 @@ int serial_initialize(void)
 	return serial_init();
 }
 
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+/*
+ * Output is queued in a ring buffer and handed to the UART as fast as it will
+ * take it, without waiting for it. The queue is topped up from each putc(),
+ * from cyclic, i.e. whenever schedule() is called, and when waiting for input.
+ * Only when the buffer is full does the caller wait for the UART.
+ */
+
+/* Send as much of the TX buffer as the UART accepts without waiting */
+static void serial_tx_drain(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+
+	/* putc() may call schedule(), which comes back here */
+	if (!upriv->tx_buf || upriv->tx_busy)
+		return;
+
+	upriv->tx_busy = true;
+	while (upriv->tx_rd != upriv->tx_wr) {
+		uint rd = upriv->tx_rd % CONFIG_SERIAL_TX_BUFFER_SIZE;
+		uint len = min(upriv->tx_wr - upriv->tx_rd,
+			       CONFIG_SERIAL_TX_BUFFER_SIZE - rd);
+		ssize_t written;
+
+		if (CONFIG_IS_ENABLED(SERIAL_PUTS) && ops->puts) {
+			written = ops->puts(dev, upriv->tx_buf + rd, len);
+			if (!written)
+				break;
+		} else {
+			written = ops->putc(dev, upriv->tx_buf[rd]);
+			if (written == -EAGAIN)
+				break;
+			written = 1;
+		}
+		/* on error the characters are dropped, as with no buffer */
+		upriv->tx_rd += written < 0 ? len : written;
+	}
+	upriv->tx_busy = false;
+}
+
+static void serial_tx_cyclic(struct cyclic_info *c)
+{
+	struct serial_dev_priv *upriv;
+
+	upriv = container_of(c, struct serial_dev_priv, tx_cyclic);
+	serial_tx_drain(upriv->dev);
+}
+
+/* Wait until the TX buffer has at most @max characters in it */
+static void serial_tx_wait(struct udevice *dev, uint max)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	while (upriv->tx_buf && !upriv->tx_busy &&
+	       upriv->tx_wr - upriv->tx_rd > max)
+		serial_tx_drain(dev);
+}
+
+/* Queue a character, returning false if it must be written directly */
+static bool serial_tx_put(struct udevice *dev, char ch)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	if (!upriv->tx_buf)
+		return false;
+	serial_tx_wait(dev, CONFIG_SERIAL_TX_BUFFER_SIZE - 1);
+	if (upriv->tx_wr - upriv->tx_rd == CONFIG_SERIAL_TX_BUFFER_SIZE)
+		return false;
+	upriv->tx_buf[upriv->tx_wr++ % CONFIG_SERIAL_TX_BUFFER_SIZE] = ch;
+
+	return true;
+}
+
+static void serial_tx_init(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	BUILD_BUG_ON_NOT_POWER_OF_2(CONFIG_SERIAL_TX_BUFFER_SIZE);
+
+	/* memory allocated before relocation is lost afterwards */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+	upriv->tx_buf = malloc(CONFIG_SERIAL_TX_BUFFER_SIZE);
+	if (!upriv->tx_buf)
+		return;
+	upriv->dev = dev;
+	upriv->tx_rd = 0;
+	upriv->tx_wr = 0;
+	cyclic_register(&upriv->tx_cyclic, serial_tx_cyclic,
+			CONFIG_SERIAL_TX_BUFFER_POLL_US, dev->name);
+}
+
+static void serial_tx_uninit(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	if (!upriv->tx_buf)
+		return;
+	serial_tx_wait(dev, 0);
+	cyclic_unregister(&upriv->tx_cyclic);
+	free(upriv->tx_buf);
+	upriv->tx_buf = NULL;
+}
+#else
+static inline void serial_tx_drain(struct udevice *dev)
+{
+}
+
+static inline void serial_tx_wait(struct udevice *dev, uint max)
+{
+}
+
+static inline bool serial_tx_put(struct udevice *dev, char ch)
+{
+	return false;
+}
+
+static inline void serial_tx_init(struct udevice *dev)
+{
+}
+
+static inline void serial_tx_uninit(struct udevice *dev)
+{
+}
+#endif /* CONFIG_IS_ENABLED(SERIAL_TX_BUFFER) */
+
+/* Check whether output is being queued in the TX buffer */
+static bool serial_tx_buffered(struct udevice *dev)
+{
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	return upriv->tx_buf;
+#else
+	return false;
+#endif
+}
+
 static void _serial_flush(struct udevice *dev)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
+	serial_tx_wait(dev, 0);
 	if (!ops->pending)
 		return;
 	while (ops->pending(dev, false) > 0)
@@ -250,9 +391,13 @@ static void _serial_putc(struct udevice *dev, char ch)
 	if (ch == '\n')
 		_serial_putc(dev, '\r');
 
-	do {
-		err = ops->putc(dev, ch);
-	} while (err == -EAGAIN);
+	if (serial_tx_put(dev, ch)) {
+		serial_tx_drain(dev);
+	} else {
+		do {
+			err = ops->putc(dev, ch);
+		} while (err == -EAGAIN);
+	}
 
 	if (IS_ENABLED(CONFIG_CONSOLE_FLUSH_ON_NEWLINE) && ch == '\n')
 		_serial_flush(dev);
@@ -278,7 +423,8 @@ static void _serial_puts(struct udevice *dev, const char *str)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
-	if (!CONFIG_IS_ENABLED(SERIAL_PUTS) || !ops->puts) {
+	if (!CONFIG_IS_ENABLED(SERIAL_PUTS) || !ops->puts ||
+	    serial_tx_buffered(dev)) {
 		while (*str)
 			_serial_putc(dev, *str++);
 		return;
@@ -306,6 +452,8 @@ static int __serial_getc(struct udevice *dev)
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 	int err;
 
+	/* show everything before waiting, e.g. the prompt */
+	serial_tx_wait(dev, 0);
 	do {
 		err = ops->getc(dev);
 		if (err == -EAGAIN)
@@ -319,6 +467,7 @@ static int __serial_tstc(struct udevice *dev)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
+	serial_tx_drain(dev);
 	if (ops->pending)
 		return ops->pending(dev, true);
 
@@ -590,11 +739,14 @@ static int serial_post_probe(struct udevice *dev)
 
 	stdio_register_dev(&sdev, &upriv->sdev);
 #endif
+	serial_tx_init(dev);
+
 	return 0;
 }
 
 static int serial_pre_remove(struct udevice *dev)
 {
+	serial_tx_uninit(dev);
 #if CONFIG_IS_ENABLED(SYS_STDIO_DEREGISTER)
 	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
 
@@ -19,7 +19,9 @@
  */
 
 #include <clk.h>
+#include <cpu_func.h>
 #include <dm.h>
+#include <dma.h>
 #include <log.h>
 #include <spi.h>
 #include <errno.h>
@@ -29,9 +31,12 @@
 #include <asm/global_data.h>
 #include <dm/device_compat.h>
 #include <linux/bitops.h>
+#include <linux/math64.h>
 
 #include <asm/bitops.h>
+#include <asm/cache.h>
 #include <asm/io.h>
+#include <asm/arch/dma_sun6i.h>
 
 #include <linux/iopoll.h>
 
@@ -84,6 +89,9 @@ DECLARE_GLOBAL_DATA_PTR;
 #define SUN4I_SPI_DEFAULT_RATE		1000000
 #define SUN4I_SPI_TIMEOUT_MS		1000
 
+/* Receive-only transfers from this size on are moved by the DMA engine */
+#define SUN4I_SPI_DMA_MIN_LEN		512
+
 #define SPI_REG(priv, reg)		((priv)->base + \
 					(priv)->variant->regs[reg])
 #define SPI_BIT(priv, bit)		((priv)->variant->bits[bit])
@@ -120,6 +128,8 @@ enum sun4i_spi_bits {
 	SPI_TCR_SDM,
 	SPI_FCR_TF_RST,
 	SPI_FCR_RF_RST,
+	SPI_FCR_RF_DRQ_EN,
+	SPI_FCR_RF_TRIG_MASK,
 	SPI_FSR_RF_CNT_MASK,
 };
 
@@ -147,6 +157,12 @@ struct sun4i_spi_priv {
 
 	const u8 *tx_buf;
 	u8 *rx_buf;
+
+#if CONFIG_IS_ENABLED(SPI_SUNXI_DMA)
+	struct dma dma_rx;
+	struct sun6i_dma_slave dma_slave;
+#endif
+	bool has_dma;
 };
 
 static inline void sun4i_spi_drain_fifo(struct sun4i_spi_priv *priv, int len)
@@ -340,6 +356,115 @@ static int sun4i_spi_release_bus(struct udevice *dev)
 	return 0;
 }
 
+static bool sun4i_spi_can_dma(struct sun4i_spi_priv *priv, u32 len)
+{
+	if (!priv->has_dma || priv->tx_buf || !priv->rx_buf)
+		return false;
+
+	return len >= SUN4I_SPI_DMA_MIN_LEN &&
+	       IS_ALIGNED((ulong)priv->rx_buf, ARCH_DMA_MINALIGN) &&
+	       IS_ALIGNED(len, ARCH_DMA_MINALIGN);
+}
+
+#if CONFIG_IS_ENABLED(SPI_SUNXI_DMA)
+/*
+ * Receive a long data phase (e.g. the payload of an SPI-NOR read) through
+ * the DMA engine. Nothing is queued in the TX FIFO, the controller clocks
+ * out dummy bytes for the whole burst.
+ */
+static int sun4i_spi_rx_dma(struct sun4i_spi_priv *priv, u32 len)
+{
+	ulong start, timeout, buf = (ulong)priv->rx_buf;
+	void *dst;
+	u32 nbytes;
+	int ret;
+
+	flush_dcache_range(buf, buf + len);
+
+	/* Request DMA as soon as a single byte has been received */
+	clrsetbits_le32(SPI_REG(priv, SPI_FCR),
+			SPI_BIT(priv, SPI_FCR_RF_TRIG_MASK),
+			SPI_BIT(priv, SPI_FCR_RF_DRQ_EN) | 1);
+
+	while (len) {
+		nbytes = min_t(u32, len, SUN4I_MAX_XFER_SIZE &
+			       ~(ARCH_DMA_MINALIGN - 1));
+
+		/* Long bursts take much longer than the per-FIFO timeout */
+		timeout = SUN4I_SPI_TIMEOUT_MS +
+			  div_u64((u64)nbytes * 8 * 1000, priv->freq);
+
+		writel(SUN4I_BURST_CNT(nbytes), SPI_REG(priv, SPI_BC));
+		writel(SUN4I_XMIT_CNT(0), SPI_REG(priv, SPI_TC));
+		writel(SUN4I_BURST_CNT(0), SPI_REG(priv, SPI_BCTL));
+
+		ret = dma_prepare_rcv_buf(&priv->dma_rx, priv->rx_buf, nbytes);
+		if (ret)
+			break;
+
+		setbits_le32(SPI_REG(priv, SPI_TCR),
+			     SPI_BIT(priv, SPI_TCR_XCH));
+
+		start = get_timer(0);
+		do {
+			ret = dma_receive(&priv->dma_rx, &dst,
+					  &priv->dma_slave);
+			if (get_timer(start) > timeout) {
+				ret = -ETIMEDOUT;
+				break;
+			}
+		} while (!ret);
+		if (ret < 0)
+			break;
+
+		ret = wait_for_bit_le32((const void *)SPI_REG(priv, SPI_TCR),
+					SPI_BIT(priv, SPI_TCR_XCH),
+					false, timeout, false);
+		if (ret < 0)
+			break;
+
+		priv->rx_buf += nbytes;
+		len -= nbytes;
+	}
+
+	clrbits_le32(SPI_REG(priv, SPI_FCR), SPI_BIT(priv, SPI_FCR_RF_DRQ_EN));
+
+	invalidate_dcache_range(buf, (ulong)priv->rx_buf + len);
+
+	return ret < 0 ? ret : 0;
+}
+
+static void sun4i_spi_dma_init(struct udevice *bus)
+{
+	struct sun4i_spi_priv *priv = dev_get_priv(bus);
+
+	/* DMA is optional, use PIO if there is no usable channel */
+	if (!SPI_BIT(priv, SPI_FCR_RF_DRQ_EN) ||
+	    dma_get_by_name(bus, "rx", &priv->dma_rx))
+		return;
+
+	if (dma_enable(&priv->dma_rx)) {
+		dma_free(&priv->dma_rx);
+		return;
+	}
+
+	/* the FIFO is read a byte at a time, as DRQ is raised for each byte */
+	priv->dma_slave.addr = SPI_REG(priv, SPI_RXD);
+	priv->dma_slave.width = 1;
+	priv->dma_slave.burst = 1;
+	priv->has_dma = true;
+}
+#else
+static int sun4i_spi_rx_dma(struct sun4i_spi_priv *priv, u32 len)
+{
+	return -ENOSYS;
+}
+
+static void sun4i_spi_dma_init(struct udevice *bus)
+{
+}
+#endif
+
 static int sun4i_spi_xfer(struct udevice *dev, unsigned int bitlen,
 			  const void *dout, void *din, unsigned long flags)
 {
@@ -366,6 +491,17 @@ static int sun4i_spi_xfer(struct udevice *dev, unsigned int bitlen,
 	setbits_le32(SPI_REG(priv, SPI_FCR), SPI_BIT(priv, SPI_FCR_RF_RST) |
 		     SPI_BIT(priv, SPI_FCR_TF_RST));
 
+	if (sun4i_spi_can_dma(priv, len)) {
+		ret = sun4i_spi_rx_dma(priv, len);
+		if (ret < 0) {
+			printf("ERROR: sun4i_spi: DMA transfer failed (%d)\n",
+			       ret);
+			sun4i_spi_set_cs(bus, slave_plat->cs[0], false);
+			return ret;
+		}
+		len = 0;
+	}
+
 	while (len) {
 		/* Setup the transfer now... */
 		nbytes = min(len, (priv->variant->fifo_depth - 1));
@@ -466,6 +602,8 @@ static int sun4i_spi_probe(struct udevice *bus)
 	priv->variant = plat->variant;
 	priv->base = plat->base;
 
+	sun4i_spi_dma_init(bus);
+
 	return 0;
 }
 
@@ -534,6 +672,8 @@ static const u32 sun6i_spi_bits[] = {
 	[SPI_TCR_XCH]		= BIT(31),
 	[SPI_FCR_RF_RST]	= BIT(15),
 	[SPI_FCR_TF_RST]	= BIT(31),
+	[SPI_FCR_RF_DRQ_EN]	= BIT(8),
+	[SPI_FCR_RF_TRIG_MASK]	= GENMASK(7, 0),
 	[SPI_FSR_RF_CNT_MASK]	= GENMASK(7, 0),
 };
 
@@ -83,8 +83,8 @@ static ulong tpm_tis_i2c_calc_ordinal_duration(struct tpm_chip_priv *priv,
 		return duration;
 }
 
-int tpm_xfer(struct udevice *dev, const uint8_t *sendbuf, size_t send_size,
-	uint8_t *recvbuf, size_t *recv_size)
+static int tpm_do_xfer(struct udevice *dev, const uint8_t *sendbuf,
+		       size_t send_size, uint8_t *recvbuf, size_t *recv_size)
 {
 	struct tpm_chip_priv *priv = dev_get_uclass_priv(dev);
 	struct tpm_ops *ops = tpm_get_ops(dev);
@@ -150,6 +150,20 @@ int tpm_xfer(struct udevice *dev, const uint8_t *sendbuf, size_t send_size,
 	return 0;
 }
 
+int tpm_xfer(struct udevice *dev, const uint8_t *sendbuf, size_t send_size,
+	uint8_t *recvbuf, size_t *recv_size)
+{
+	struct tpm_chip_priv *priv = dev_get_uclass_priv(dev);
+	ulong start = timer_get_us();
+	int ret;
+
+	ret = tpm_do_xfer(dev, sendbuf, send_size, recvbuf, recv_size);
+	priv->xfer_count++;
+	priv->xfer_us += timer_get_us() - start;
+
+	return ret;
+}
+
 static int tpm_uclass_post_probe(struct udevice *dev)
 {
 	int ret;
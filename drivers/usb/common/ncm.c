@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Reading the frames from a received CDC NCM Transfer Block (NTB)
+ *
+ * An NTB starts with a header pointing to a datagram pointer table (NDP),
+ * whose entries give the offset and length of each frame. An NDP may point
+ * to a further one. Every offset is checked against the NTB before use,
+ * since it comes from the other end of the link.
+ */
+
+#include <log.h>
+#include <net.h>
+#include <linux/usb/cdc.h>
+#include <usb/ncm.h>
+
+enum {
+	NCM_NDP_ALIGN	= 4,
+};
+
+/* Get ready to read the datagram pointer table at offset @index of the NTB */
+static int ncm_rx_ndp(struct ncm_rx *rx, uint index)
+{
+	const struct usb_cdc_ncm_ndp16 *ndp;
+	uint len;
+
+	if (index < sizeof(struct usb_cdc_ncm_nth16) || index % NCM_NDP_ALIGN ||
+	    index + sizeof(*ndp) > rx->ntb_len)
+		return -EINVAL;
+	ndp = (void *)rx->ntb + index;
+	len = le16_to_cpu(ndp->wLength);
+	if (le32_to_cpu(ndp->dwSignature) != USB_CDC_NCM_NDP16_NOCRC_SIGN ||
+	    len < sizeof(*ndp) + 2 * sizeof(ndp->dpe16[0]) || len % 4 ||
+	    index + len > rx->ntb_len)
+		return -EINVAL;
+
+	rx->ndp = ndp;
+	rx->dpe = 0;
+	rx->dpe_count = (len - sizeof(*ndp)) / sizeof(ndp->dpe16[0]);
+
+	return 0;
+}
+
+int ncm_rx_start(struct ncm_rx *rx, u8 *ntb, uint len)
+{
+	const struct usb_cdc_ncm_nth16 *nth = (void *)ntb;
+
+	rx->ndp = NULL;
+	if (len < sizeof(*nth) ||
+	    le32_to_cpu(nth->dwSignature) != USB_CDC_NCM_NTH16_SIGN ||
+	    le16_to_cpu(nth->wHeaderLength) != sizeof(*nth) ||
+	    le16_to_cpu(nth->wBlockLength) > len) {
+		debug("%s: Invalid NTB header\n", __func__);
+		return -EINVAL;
+	}
+	rx->ntb = ntb;
+	rx->ntb_len = le16_to_cpu(nth->wBlockLength);
+
+	return ncm_rx_ndp(rx, le16_to_cpu(nth->wNdpIndex));
+}
+
+int ncm_rx_next(struct ncm_rx *rx, uchar **packetp)
+{
+	while (rx->ndp) {
+		const struct usb_cdc_ncm_dpe16 *dpe;
+		uint index, len;
+
+		if (rx->dpe == rx->dpe_count) {
+			/* later tables must not loop back to this one */
+			index = le16_to_cpu(rx->ndp->wNextNdpIndex);
+			if (index <= (u8 *)rx->ndp - rx->ntb ||
+			    ncm_rx_ndp(rx, index))
+				rx->ndp = NULL;
+			continue;
+		}
+
+		dpe = &rx->ndp->dpe16[rx->dpe++];
+		index = le16_to_cpu(dpe->wDatagramIndex);
+		len = le16_to_cpu(dpe->wDatagramLength);
+		if (!index || !len) {
+			/* end of the table */
+			rx->dpe = rx->dpe_count;
+			continue;
+		}
+		if (index < sizeof(struct usb_cdc_ncm_nth16) ||
+		    len < ETHER_HDR_SIZE || len > PKTSIZE ||
+		    index + len > rx->ntb_len) {
+			debug("%s: Dropping datagram at %u, len %u\n", __func__,
+			      index, len);
+			return -EINVAL;
+		}
+		*packetp = rx->ntb + index;
+
+		return len;
+	}
+
+	return 0;
+}
@@ -190,6 +190,11 @@ static int clrset_post_state(struct udevice *hub, int port, int clear, int set)
 			}
 		}
 	}
+	/* a reset completes straight away */
+	if (set & USB_PORT_STAT_RESET) {
+		set &= ~USB_PORT_STAT_RESET;
+		*change |= USB_PORT_STAT_C_RESET;
+	}
 	*change |= *status & clear;
 	*change |= ~*status & set;
 	*change &= 0x1f;
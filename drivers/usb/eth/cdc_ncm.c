@@ -0,0 +1,396 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * USB CDC NCM (Network Control Model) Ethernet driver
+ *
+ * NCM carries Ethernet frames in NCM Transfer Blocks (NTBs), each of which
+ * may hold many frames, so that one bulk transfer from the device brings in
+ * a whole burst of them. Received NTBs are taken apart here, a frame on each
+ * call to recv(). Each frame sent goes in an NTB of its own, since the
+ * network stack sends a frame and then waits for the reply.
+ */
+
+#include <dm.h>
+#include <hexdump.h>
+#include <log.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <net.h>
+#include <usb.h>
+#include <linux/log2.h>
+#include <linux/usb/cdc.h>
+#include <usb/ncm.h>
+#include "usb_ether.h"
+
+#define USB_BULK_SEND_TIMEOUT	5000
+
+enum {
+	NCM_RX_MAX	= 16384,	/* largest NTB asked of the device */
+	NCM_TX_HDR_MAX	= 64,		/* largest offset of a frame sent */
+};
+
+/**
+ * struct cdc_ncm_priv - state of an NCM device
+ *
+ * @ueth: USB Ethernet data; the receive buffer holds the NTB being read
+ * @ctrl_ifnum: Number of the communication interface
+ * @data_ifnum: Number of the data interface
+ * @rx_max: Largest NTB the device sends
+ * @tx_max: Largest NTB the device accepts
+ * @tx_ndp: Offset of the datagram pointer table in each NTB sent
+ * @tx_data: Offset of the frame in each NTB sent
+ * @tx_seq: Sequence number of the next NTB sent
+ * @rx: NTB being read
+ */
+struct cdc_ncm_priv {
+	struct ueth_data ueth;
+	u8 ctrl_ifnum;
+	u8 data_ifnum;
+	u32 rx_max;
+	u32 tx_max;
+	uint tx_ndp;
+	uint tx_data;
+	u16 tx_seq;
+	struct ncm_rx rx;
+};
+
+/*
+ * Find the data interface and the string holding the MAC address from the
+ * class descriptors of the communication interface, which the USB core does
+ * not keep
+ */
+static int cdc_ncm_parse_config(struct cdc_ncm_priv *priv,
+				struct usb_device *udev, int *mac_indexp)
+{
+	bool in_ctrl = false, have_union = false, have_ncm = false;
+	int len, pos, ret;
+	u8 *buf, *desc;
+
+	len = usb_get_configuration_len(udev, 0);
+	if (len < 0)
+		return len;
+	buf = malloc_cache_aligned(len);
+	if (!buf)
+		return -ENOMEM;
+	len = usb_get_configuration_no(udev, 0, buf, len);
+	if (len < 0) {
+		free(buf);
+		return len;
+	}
+
+	*mac_indexp = 0;
+	for (pos = 0; pos + 3 <= len; pos += desc[0]) {
+		desc = buf + pos;
+		if (desc[0] < 3 || pos + desc[0] > len)
+			break;
+		if (desc[1] == USB_DT_INTERFACE) {
+			in_ctrl = ((struct usb_interface_descriptor *)desc)->
+				bInterfaceNumber == priv->ctrl_ifnum;
+			continue;
+		}
+		if (!in_ctrl || desc[1] != USB_DT_CS_INTERFACE)
+			continue;
+
+		switch (desc[2]) {
+		case USB_CDC_UNION_TYPE:
+			if (desc[0] < sizeof(struct usb_cdc_union_desc))
+				break;
+			priv->data_ifnum = ((struct usb_cdc_union_desc *)desc)->
+				bSlaveInterface0;
+			have_union = true;
+			break;
+		case USB_CDC_ETHERNET_TYPE:
+			if (desc[0] < sizeof(struct usb_cdc_ether_desc))
+				break;
+			*mac_indexp = ((struct usb_cdc_ether_desc *)desc)->
+				iMACAddress;
+			break;
+		case USB_CDC_NCM_TYPE:
+			have_ncm = true;
+			break;
+		}
+	}
+	free(buf);
+
+	ret = have_union && have_ncm && *mac_indexp ? 0 : -ENXIO;
+	if (ret)
+		debug("%s: Missing class descriptors\n", __func__);
+
+	return ret;
+}
+
+static int cdc_ncm_find_endpoints(struct cdc_ncm_priv *priv,
+				  struct usb_device *udev)
+{
+	struct ueth_data *ueth = &priv->ueth;
+	int i, j;
+
+	for (i = 0; i < udev->config.no_of_if; i++) {
+		struct usb_interface *iface = &udev->config.if_desc[i];
+		u8 ifnum = iface->desc.bInterfaceNumber;
+
+		if (ifnum != priv->ctrl_ifnum && ifnum != priv->data_ifnum)
+			continue;
+
+		/* this has the endpoints of all the alternate settings */
+		for (j = 0; j < iface->no_of_ep; j++) {
+			struct usb_endpoint_descriptor *ep = &iface->ep_desc[j];
+			u8 addr = ep->bEndpointAddress &
+				USB_ENDPOINT_NUMBER_MASK;
+
+			switch (ep->bmAttributes & USB_ENDPOINT_XFERTYPE_MASK) {
+			case USB_ENDPOINT_XFER_BULK:
+				if (ep->bEndpointAddress & USB_DIR_IN)
+					ueth->ep_in = addr;
+				else
+					ueth->ep_out = addr;
+				break;
+			case USB_ENDPOINT_XFER_INT:
+				ueth->ep_int = addr;
+				ueth->irqinterval = ep->bInterval;
+				break;
+			}
+		}
+	}
+	debug("Endpoints In %d Out %d Int %d\n", ueth->ep_in, ueth->ep_out,
+	      ueth->ep_int);
+	if (!ueth->ep_in || !ueth->ep_out)
+		return -ENXIO;
+
+	return 0;
+}
+
+/* Agree the NTB sizes with the device and work out the layout of an NTB */
+static int cdc_ncm_setup_ntb(struct cdc_ncm_priv *priv)
+{
+	struct usb_device *udev = priv->ueth.pusb_dev;
+	ALLOC_CACHE_ALIGN_BUFFER(struct usb_cdc_ncm_ntb_parameters, params, 1);
+	ALLOC_CACHE_ALIGN_BUFFER(__le32, size, 1);
+	uint align, div, rem;
+	int ret;
+
+	ret = usb_control_msg(udev, usb_rcvctrlpipe(udev, 0),
+			      USB_CDC_GET_NTB_PARAMETERS,
+			      USB_DIR_IN | USB_TYPE_CLASS | USB_RECIP_INTERFACE,
+			      0, priv->ctrl_ifnum, params, sizeof(*params),
+			      USB_CNTL_TIMEOUT * 5);
+	if (ret < (int)sizeof(*params))
+		return ret < 0 ? ret : -EIO;
+	if (!(le16_to_cpu(params->bmNtbFormatsSupported) &
+	      USB_CDC_NCM_NTB16_SUPPORTED))
+		return -EPROTONOSUPPORT;
+
+	priv->rx_max = min_t(u32, le32_to_cpu(params->dwNtbInMaxSize),
+			     NCM_RX_MAX);
+	if (priv->rx_max < USB_CDC_NCM_NTB_MIN_IN_SIZE)
+		return -EINVAL;
+	if (priv->rx_max != le32_to_cpu(params->dwNtbInMaxSize)) {
+		*size = cpu_to_le32(priv->rx_max);
+		ret = usb_control_msg(udev, usb_sndctrlpipe(udev, 0),
+				      USB_CDC_SET_NTB_INPUT_SIZE,
+				      USB_DIR_OUT | USB_TYPE_CLASS |
+				      USB_RECIP_INTERFACE, 0, priv->ctrl_ifnum,
+				      size, sizeof(*size),
+				      USB_CNTL_TIMEOUT * 5);
+		if (ret < 0)
+			return ret;
+	}
+
+	/* place the pointer table and the frame where the device wants them */
+	priv->tx_max = le32_to_cpu(params->dwNtbOutMaxSize);
+	align = le16_to_cpu(params->wNdpOutAlignment);
+	div = le16_to_cpu(params->wNdpOutDivisor);
+	rem = le16_to_cpu(params->wNdpOutPayloadRemainder);
+	if (align < 4 || !is_power_of_2(align))
+		align = 4;
+	if (!div)
+		div = 1;
+	priv->tx_ndp = ALIGN(sizeof(struct usb_cdc_ncm_nth16), align);
+	priv->tx_data = priv->tx_ndp + sizeof(struct usb_cdc_ncm_ndp16) +
+		2 * sizeof(struct usb_cdc_ncm_dpe16);
+	priv->tx_data += (rem % div + div - priv->tx_data % div) % div;
+	if (priv->tx_data > NCM_TX_HDR_MAX ||
+	    priv->tx_data + PKTSIZE > priv->tx_max)
+		return -EINVAL;
+	debug("NTB in %u, out %u, frame at %u\n", priv->rx_max, priv->tx_max,
+	      priv->tx_data);
+
+	return 0;
+}
+
+static int cdc_ncm_eth_start(struct udevice *dev)
+{
+	struct cdc_ncm_priv *priv = dev_get_priv(dev);
+	struct ueth_data *ueth = &priv->ueth;
+
+	priv->tx_seq = 0;
+	priv->rx.ndp = NULL;
+	usb_ether_advance_rxbuf(ueth, -1);
+
+	/* the data interface only carries NTBs in its second setting */
+	return usb_set_interface(ueth->pusb_dev, priv->data_ifnum, 1);
+}
+
+static void cdc_ncm_eth_stop(struct udevice *dev)
+{
+	struct cdc_ncm_priv *priv = dev_get_priv(dev);
+	struct ueth_data *ueth = &priv->ueth;
+
+	usb_set_interface(ueth->pusb_dev, priv->data_ifnum, 0);
+	priv->rx.ndp = NULL;
+	usb_ether_advance_rxbuf(ueth, -1);
+}
+
+static int cdc_ncm_eth_send(struct udevice *dev, void *packet, int length)
+{
+	struct cdc_ncm_priv *priv = dev_get_priv(dev);
+	struct usb_device *udev = priv->ueth.pusb_dev;
+	ALLOC_CACHE_ALIGN_BUFFER(u8, buf, NCM_TX_HDR_MAX + PKTSIZE + 1);
+	struct usb_cdc_ncm_nth16 *nth = (void *)buf;
+	struct usb_cdc_ncm_ndp16 *ndp = (void *)buf + priv->tx_ndp;
+	unsigned int pipe = usb_sndbulkpipe(udev, priv->ueth.ep_out);
+	int len = priv->tx_data + length;
+	int actual;
+
+	if (length > PKTSIZE)
+		return -EMSGSIZE;
+
+	memset(buf, '\0', priv->tx_data);
+	nth->dwSignature = cpu_to_le32(USB_CDC_NCM_NTH16_SIGN);
+	nth->wHeaderLength = cpu_to_le16(sizeof(*nth));
+	nth->wSequence = cpu_to_le16(priv->tx_seq++);
+	nth->wBlockLength = cpu_to_le16(len);
+	nth->wNdpIndex = cpu_to_le16(priv->tx_ndp);
+	ndp->dwSignature = cpu_to_le32(USB_CDC_NCM_NDP16_NOCRC_SIGN);
+	ndp->wLength = cpu_to_le16(sizeof(*ndp) + 2 * sizeof(ndp->dpe16[0]));
+	ndp->dpe16[0].wDatagramIndex = cpu_to_le16(priv->tx_data);
+	ndp->dpe16[0].wDatagramLength = cpu_to_le16(length);
+	memcpy(buf + priv->tx_data, packet, length);
+
+	/* the device needs a short packet to see the end of the NTB */
+	if (!(len % usb_maxpacket(udev, pipe)) && len < priv->tx_max)
+		buf[len++] = 0;
+
+	return usb_bulk_msg(udev, pipe, buf, len, &actual,
+			    USB_BULK_SEND_TIMEOUT);
+}
+
+static int cdc_ncm_eth_recv(struct udevice *dev, int flags, uchar **packetp)
+{
+	struct cdc_ncm_priv *priv = dev_get_priv(dev);
+	struct ueth_data *ueth = &priv->ueth;
+	uint8_t *ptr;
+	int ret, len;
+
+	if (!ncm_rx_active(&priv->rx)) {
+		len = usb_ether_get_rx_bytes(ueth, &ptr);
+		if (!len) {
+			if (!(flags & ETH_RECV_CHECK_DEVICE))
+				return -EAGAIN;
+			ret = usb_ether_receive(ueth, priv->rx_max);
+			if (ret)
+				return ret;
+			len = usb_ether_get_rx_bytes(ueth, &ptr);
+		}
+		ret = ncm_rx_start(&priv->rx, ptr, len);
+		if (ret) {
+			usb_ether_advance_rxbuf(ueth, -1);
+			return ret;
+		}
+	}
+
+	do {
+		len = ncm_rx_next(&priv->rx, packetp);
+	} while (len < 0);
+	if (!len) {
+		/* nothing left in this NTB; the next call reads another */
+		usb_ether_advance_rxbuf(ueth, -1);
+		return -EAGAIN;
+	}
+
+	return len;
+}
+
+static int cdc_ncm_eth_probe(struct udevice *dev)
+{
+	struct eth_pdata *pdata = dev_get_plat(dev);
+	struct cdc_ncm_priv *priv = dev_get_priv(dev);
+	struct usb_device *udev = dev_get_parent_priv(dev);
+	struct ueth_data *ueth = &priv->ueth;
+	char mac[ETH_ALEN * 2 + 1];
+	int mac_index, ret;
+
+	ueth->pusb_dev = udev;
+	priv->ctrl_ifnum = udev->config.if_desc[0].desc.bInterfaceNumber;
+	ueth->ifnum = priv->ctrl_ifnum;
+
+	ret = cdc_ncm_parse_config(priv, udev, &mac_index);
+	if (ret)
+		return ret;
+	ret = cdc_ncm_find_endpoints(priv, udev);
+	if (ret)
+		return ret;
+	ret = cdc_ncm_setup_ntb(priv);
+	if (ret) {
+		debug("%s: Cannot set up NTBs: %d\n", __func__, ret);
+		return ret;
+	}
+
+	ueth->rxsize = priv->rx_max;
+	ueth->rxbuf = memalign(ARCH_DMA_MINALIGN, priv->rx_max);
+	if (!ueth->rxbuf)
+		return -ENOMEM;
+
+	/* the MAC address is given as a string of hex digits */
+	ret = usb_string(udev, mac_index, mac, sizeof(mac));
+	if (ret != ETH_ALEN * 2 || hex2bin(pdata->enetaddr, mac, ETH_ALEN)) {
+		debug("%s: Invalid MAC address '%s'\n", __func__, mac);
+		free(ueth->rxbuf);
+		return -EINVAL;
+	}
+	debug("MAC %pM\n", pdata->enetaddr);
+
+	/* start in the setting without endpoints, which resets the function */
+	usb_set_interface(udev, priv->data_ifnum, 0);
+
+	return 0;
+}
+
+static int cdc_ncm_eth_remove(struct udevice *dev)
+{
+	struct cdc_ncm_priv *priv = dev_get_priv(dev);
+
+	free(priv->ueth.rxbuf);
+
+	return 0;
+}
+
+static const struct eth_ops cdc_ncm_eth_ops = {
+	.start	= cdc_ncm_eth_start,
+	.send	= cdc_ncm_eth_send,
+	.recv	= cdc_ncm_eth_recv,
+	.stop	= cdc_ncm_eth_stop,
+};
+
+U_BOOT_DRIVER(cdc_ncm_eth) = {
+	.name	= "cdc_ncm_eth",
+	.id	= UCLASS_ETH,
+	.probe	= cdc_ncm_eth_probe,
+	.remove	= cdc_ncm_eth_remove,
+	.ops	= &cdc_ncm_eth_ops,
+	.priv_auto	= sizeof(struct cdc_ncm_priv),
+	.plat_auto	= sizeof(struct eth_pdata),
+};
+
+static const struct usb_device_id cdc_ncm_eth_id_table[] = {
+	{
+		.match_flags = USB_DEVICE_ID_MATCH_INT_CLASS |
+			USB_DEVICE_ID_MATCH_INT_SUBCLASS |
+			USB_DEVICE_ID_MATCH_INT_PROTOCOL,
+		.bInterfaceClass = USB_CLASS_COMM,
+		.bInterfaceSubClass = USB_CDC_SUBCLASS_NCM,
+		.bInterfaceProtocol = USB_CDC_PROTO_NONE,
+	},
+	{ }		/* Terminating entry */
+};
+
+U_BOOT_USB_DEVICE(cdc_ncm_eth, cdc_ncm_eth_id_table);
@@ -11,6 +11,7 @@
 #include <env.h>
 #include <log.h>
 #include <part.h>
+#include <asm/unaligned.h>
 #include <linux/errno.h>
 #include <linux/netdevice.h>
 #include <linux/printk.h>
@@ -19,6 +20,7 @@
 #include <linux/usb/gadget.h>
 #include <net.h>
 #include <usb.h>
+#include <usb/ncm.h>
 #include <malloc.h>
 #include <memalign.h>
 #include <linux/ctype.h>
@@ -94,6 +96,27 @@ static const char driver_desc[] = DRIVER_DESC;
 
 #define USB_CONNECT_TIMEOUT (3 * CONFIG_SYS_HZ)
 
+/*
+ * With NCM the CDC function carries frames in NCM Transfer Blocks (NTBs).
+ * The host may put many frames in each NTB it sends; each frame sent to the
+ * host goes in an NTB of its own.
+ */
+#ifdef CONFIG_USB_ETH_NCM
+#define CDC_SUBCLASS		USB_CDC_SUBCLASS_NCM
+#define CDC_DATA_PROTOCOL	USB_CDC_NCM_PROTO_NTB
+#define CDC_NAME		"CDC NCM"
+#else
+#define CDC_SUBCLASS		USB_CDC_SUBCLASS_ETHERNET
+#define CDC_DATA_PROTOCOL	0
+#define CDC_NAME		"CDC Ethernet"
+#endif
+
+#define NCM_NTB_MAX_SIZE	16384	/* largest NTB in either direction */
+#define NCM_NDP_ALIGN		4
+#define NCM_TX_DATA	ALIGN(sizeof(struct usb_cdc_ncm_nth16) + \
+			      sizeof(struct usb_cdc_ncm_ndp16) + \
+			      2 * sizeof(struct usb_cdc_ncm_dpe16), NCM_NDP_ALIGN)
+
 /*-------------------------------------------------------------------------*/
 
 struct eth_dev {
@@ -123,6 +146,11 @@ struct eth_dev {
 #define	WORK_RX_MEMORY		0
 	int			rndis_config;
 	u8			host_mac[ETH_ALEN];
+#ifdef CONFIG_USB_ETH_NCM
+	u32			ntb_in_size;	/* largest NTB the host takes */
+	u16			ntb_seq;	/* sequence of the next NTB sent */
+	struct ncm_rx		ncm_rx;		/* the NTB received */
+#endif
 };
 
 /*
@@ -168,6 +196,8 @@ static inline int rndis_active(struct eth_dev *dev)
 
 #define	subset_active(dev)	(!is_cdc(dev) && !rndis_active(dev))
 #define	cdc_active(dev)		(is_cdc(dev) && !rndis_active(dev))
+#define	ncm_active(dev)		(IS_ENABLED(CONFIG_USB_ETH_NCM) && \
+				 cdc_active(dev))
 
 #define DEFAULT_QLEN	2	/* double buffering by default */
 
@@ -402,7 +432,7 @@ control_intf = {
 	/* status endpoint is optional; this may be patched later */
 	.bNumEndpoints =	1,
 	.bInterfaceClass =	USB_CLASS_COMM,
-	.bInterfaceSubClass =	USB_CDC_SUBCLASS_ETHERNET,
+	.bInterfaceSubClass =	CDC_SUBCLASS,
 	.bInterfaceProtocol =	USB_CDC_PROTO_NONE,
 	.iInterface =		STRING_CONTROL,
 };
@@ -517,6 +547,36 @@ static const struct usb_cdc_ether_desc ether_desc = {
 	.bNumberPowerFilters =	0,
 };
 
+#ifdef CONFIG_USB_ETH_NCM
+static const struct usb_cdc_ncm_desc ncm_desc = {
+	.bLength =		sizeof(ncm_desc),
+	.bDescriptorType =	USB_DT_CS_INTERFACE,
+	.bDescriptorSubType =	USB_CDC_NCM_TYPE,
+
+	.bcdNcmVersion =	__constant_cpu_to_le16(0x0100),
+	/* SET_ETHERNET_PACKET_FILTER is the only optional request */
+	.bmNetworkCapabilities = USB_CDC_NCM_NCAP_ETH_FILTER,
+};
+
+static const struct usb_cdc_ncm_ntb_parameters ntb_parameters = {
+	.wLength =		__constant_cpu_to_le16(sizeof(ntb_parameters)),
+	.bmNtbFormatsSupported = __constant_cpu_to_le16(
+					USB_CDC_NCM_NTB16_SUPPORTED),
+	.dwNtbInMaxSize =	__constant_cpu_to_le32(NCM_NTB_MAX_SIZE),
+	.wNdpInDivisor =	__constant_cpu_to_le16(4),
+	.wNdpInPayloadRemainder = __constant_cpu_to_le16(0),
+	.wNdpInAlignment =	__constant_cpu_to_le16(NCM_NDP_ALIGN),
+	.dwNtbOutMaxSize =	__constant_cpu_to_le32(NCM_NTB_MAX_SIZE),
+	.wNdpOutDivisor =	__constant_cpu_to_le16(4),
+	.wNdpOutPayloadRemainder = __constant_cpu_to_le16(0),
+	.wNdpOutAlignment =	__constant_cpu_to_le16(NCM_NDP_ALIGN),
+	.wNtbOutMaxDatagrams =	__constant_cpu_to_le16(0),	/* no limit */
+};
+
+/* NTBs from the host are too big for net_rx_packets[] */
+DEFINE_CACHE_ALIGN_BUFFER(u8, ncm_rx_buf, NCM_NTB_MAX_SIZE);
+#endif
+
 #if defined(CONFIG_USB_ETH_CDC) || defined(CONFIG_USB_ETH_RNDIS)
 
 /*
@@ -563,7 +623,7 @@ data_nop_intf = {
 	.bNumEndpoints =	0,
 	.bInterfaceClass =	USB_CLASS_CDC_DATA,
 	.bInterfaceSubClass =	0,
-	.bInterfaceProtocol =	0,
+	.bInterfaceProtocol =	CDC_DATA_PROTOCOL,
 };
 
 /* ... but the "real" data interface has two bulk endpoints */
@@ -578,7 +638,7 @@ data_intf = {
 	.bNumEndpoints =	2,
 	.bInterfaceClass =	USB_CLASS_CDC_DATA,
 	.bInterfaceSubClass =	0,
-	.bInterfaceProtocol =	0,
+	.bInterfaceProtocol =	CDC_DATA_PROTOCOL,
 	.iInterface =		STRING_DATA,
 };
 
@@ -650,7 +710,7 @@ fs_sink_desc = {
 	.wMaxPacketSize =	__constant_cpu_to_le16(64),
 };
 
-static const struct usb_descriptor_header *fs_eth_function[11] = {
+static const struct usb_descriptor_header *fs_eth_function[12] = {
 	(struct usb_descriptor_header *) &otg_descriptor,
 #ifdef CONFIG_USB_ETH_CDC
 	/* "cdc" mode descriptors */
@@ -658,6 +718,9 @@ static const struct usb_descriptor_header *fs_eth_function[11] = {
 	(struct usb_descriptor_header *) &header_desc,
 	(struct usb_descriptor_header *) &union_desc,
 	(struct usb_descriptor_header *) &ether_desc,
+#ifdef CONFIG_USB_ETH_NCM
+	(struct usb_descriptor_header *) &ncm_desc,
+#endif
 	/* NOTE: status endpoint may need to be removed */
 	(struct usb_descriptor_header *) &fs_status_desc,
 	/* data interface, with altsetting */
@@ -750,7 +813,7 @@ dev_qualifier = {
 	.bNumConfigurations =	1,
 };
 
-static const struct usb_descriptor_header *hs_eth_function[11] = {
+static const struct usb_descriptor_header *hs_eth_function[12] = {
 	(struct usb_descriptor_header *) &otg_descriptor,
 #ifdef CONFIG_USB_ETH_CDC
 	/* "cdc" mode descriptors */
@@ -758,6 +821,9 @@ static const struct usb_descriptor_header *hs_eth_function[11] = {
 	(struct usb_descriptor_header *) &header_desc,
 	(struct usb_descriptor_header *) &union_desc,
 	(struct usb_descriptor_header *) &ether_desc,
+#ifdef CONFIG_USB_ETH_NCM
+	(struct usb_descriptor_header *) &ncm_desc,
+#endif
 	/* NOTE: status endpoint may need to be removed */
 	(struct usb_descriptor_header *) &hs_status_desc,
 	/* data interface, with altsetting */
@@ -833,7 +899,7 @@ static struct usb_string		strings[] = {
 	{ STRING_DATA,		"Ethernet Data", },
 	{ STRING_ETHADDR,	ethaddr, },
 #ifdef	CONFIG_USB_ETH_CDC
-	{ STRING_CDC,		"CDC Ethernet", },
+	{ STRING_CDC,		CDC_NAME, },
 	{ STRING_CONTROL,	"CDC Communications Control", },
 #endif
 #ifdef	CONFIG_USB_ETH_SUBSET
@@ -1085,7 +1151,7 @@ static int eth_set_config(struct eth_dev *dev, unsigned number,
 				rndis_active(dev)
 					? "RNDIS"
 					: (cdc_active(dev)
-						? "CDC Ethernet"
+						? CDC_NAME
 						: "CDC Ethernet Subset"));
 	}
 	return result;
@@ -1213,6 +1279,26 @@ static void rndis_command_complete(struct usb_ep *ep, struct usb_request *req)
 
 #endif	/* RNDIS */
 
+#ifdef CONFIG_USB_ETH_NCM
+
+static void ncm_input_size_complete(struct usb_ep *ep, struct usb_request *req)
+{
+	struct eth_dev		*dev = ep->driver_data;
+	u32			size;
+
+	/* received the dwNtbInMaxSize from USB_CDC_SET_NTB_INPUT_SIZE */
+	if (req->status || req->actual < sizeof(size))
+		return;
+	size = get_unaligned_le32(req->buf);
+	if (size < USB_CDC_NCM_NTB_MIN_IN_SIZE || size > NCM_NTB_MAX_SIZE) {
+		debug("ntb input size %u rejected\n", size);
+		return;
+	}
+	dev->ntb_in_size = size;
+}
+
+#endif	/* NCM */
+
 /*
  * The setup() callback implements all the ep0 functionality that's not
  * handled lower down.  CDC has a number of less-common features:
@@ -1333,6 +1419,11 @@ eth_setup(struct usb_gadget *gadget, const struct usb_ctrlrequest *ctrl)
 			if (wValue == 1) {
 				if (!cdc_active(dev))
 					break;
+#ifdef CONFIG_USB_ETH_NCM
+				dev->ntb_in_size = NCM_NTB_MAX_SIZE;
+				dev->ntb_seq = 0;
+				dev->ncm_rx.ndp = NULL;
+#endif
 				usb_ep_enable(dev->in_ep, dev->in);
 				usb_ep_enable(dev->out_ep, dev->out);
 				dev->cdc_filter = DEFAULT_FILTER;
@@ -1396,6 +1487,48 @@ eth_setup(struct usb_gadget *gadget, const struct usb_ctrlrequest *ctrl)
 
 #endif /* CONFIG_USB_ETH_CDC */
 
+#ifdef CONFIG_USB_ETH_NCM
+	/*
+	 * NCM requests, see the NCM subclass 6.2: only the 16-bit NTB format
+	 * is offered and there is no CRC, so the format and CRC requests are
+	 * not needed
+	 */
+	case USB_CDC_GET_NTB_PARAMETERS:
+		if (ctrl->bRequestType != (USB_DIR_IN | USB_TYPE_CLASS |
+					   USB_RECIP_INTERFACE)
+				|| !ncm_active(dev)
+				|| wValue
+				|| wIndex != 0)
+			break;
+		value = min(wLength, (u16)sizeof(ntb_parameters));
+		memcpy(req->buf, &ntb_parameters, value);
+		break;
+
+	case USB_CDC_GET_NTB_INPUT_SIZE:
+		if (ctrl->bRequestType != (USB_DIR_IN | USB_TYPE_CLASS |
+					   USB_RECIP_INTERFACE)
+				|| !ncm_active(dev)
+				|| wValue
+				|| wIndex != 0)
+			break;
+		put_unaligned_le32(dev->ntb_in_size, req->buf);
+		value = min(wLength, (u16)sizeof(dev->ntb_in_size));
+		break;
+
+	case USB_CDC_SET_NTB_INPUT_SIZE:
+		if (ctrl->bRequestType != (USB_TYPE_CLASS |
+					   USB_RECIP_INTERFACE)
+				|| !ncm_active(dev)
+				|| (wLength != 4 && wLength != 8)
+				|| wValue
+				|| wIndex != 0)
+			break;
+		/* read the size, then check it */
+		value = wLength;
+		req->complete = ncm_input_size_complete;
+		break;
+#endif /* CONFIG_USB_ETH_NCM */
+
 #ifdef CONFIG_USB_ETH_RNDIS
 	/*
 	 * RNDIS uses the CDC command encapsulation mechanism to implement
@@ -1467,6 +1600,33 @@ eth_setup(struct usb_gadget *gadget, const struct usb_ctrlrequest *ctrl)
 
 static void rx_complete(struct usb_ep *ep, struct usb_request *req);
 
+#ifdef CONFIG_USB_ETH_NCM
+
+/* Put @packet in an NTB of its own at @buf, returning the length of the NTB */
+static int ncm_add_hdr(struct eth_dev *dev, void *buf, const void *packet,
+		       int length)
+{
+	struct usb_cdc_ncm_nth16 *nth = buf;
+	struct usb_cdc_ncm_ndp16 *ndp = buf + sizeof(*nth);
+	int total = NCM_TX_DATA + length;
+
+	memset(buf, '\0', NCM_TX_DATA);
+	nth->dwSignature = cpu_to_le32(USB_CDC_NCM_NTH16_SIGN);
+	nth->wHeaderLength = cpu_to_le16(sizeof(*nth));
+	nth->wSequence = cpu_to_le16(dev->ntb_seq++);
+	nth->wBlockLength = cpu_to_le16(total);
+	nth->wNdpIndex = cpu_to_le16(sizeof(*nth));
+	ndp->dwSignature = cpu_to_le32(USB_CDC_NCM_NDP16_NOCRC_SIGN);
+	ndp->wLength = cpu_to_le16(sizeof(*ndp) + 2 * sizeof(ndp->dpe16[0]));
+	ndp->dpe16[0].wDatagramIndex = cpu_to_le16(NCM_TX_DATA);
+	ndp->dpe16[0].wDatagramLength = cpu_to_le16(length);
+	memcpy(buf + NCM_TX_DATA, packet, length);
+
+	return total;
+}
+
+#endif	/* NCM */
+
 static int rx_submit(struct eth_dev *dev, struct usb_request *req,
 				gfp_t gfp_flags)
 {
@@ -1503,6 +1663,13 @@ static int rx_submit(struct eth_dev *dev, struct usb_request *req,
 	 */
 
 	req->buf = (u8 *)net_rx_packets[0];
+#ifdef CONFIG_USB_ETH_NCM
+	/* a whole NTB, which may hold many frames */
+	if (ncm_active(dev)) {
+		req->buf = ncm_rx_buf;
+		size = NCM_NTB_MAX_SIZE;
+	}
+#endif
 	req->length = size;
 	req->complete = rx_complete;
 
@@ -1522,6 +1689,17 @@ static void rx_complete(struct usb_ep *ep, struct usb_request *req)
 	switch (req->status) {
 	/* normal completion */
 	case 0:
+#ifdef CONFIG_USB_ETH_NCM
+		/* the frames are counted as usb_eth_recv() takes them */
+		if (ncm_active(dev)) {
+			if (ncm_rx_start(&dev->ncm_rx, req->buf,
+					 req->actual)) {
+				dev->stats.rx_errors++;
+				debug("rx bad ntb, len %d\n", req->actual);
+			}
+			break;
+		}
+#endif
 		if (rndis_active(dev)) {
 			/* we know MaxPacketsPerTransfer == 1 here */
 			int length = rndis_rm_hdr(req->buf, req->actual);
@@ -2301,6 +2479,7 @@ static int usb_eth_send(struct udevice *udev, void *packet, int length)
 	struct ether_priv *priv = dev_get_priv(udev);
 	int			retval;
 	void			*rndis_pkt = NULL;
+	void			*ntb = NULL;
 	struct eth_dev		*dev = &priv->ethdev;
 	struct usb_request	*req = dev->tx_req;
 	unsigned long ts;
@@ -2322,6 +2501,18 @@ static int usb_eth_send(struct udevice *udev, void *packet, int length)
 		packet = rndis_pkt;
 		length += sizeof(struct rndis_packet_msg_type);
 	}
+#ifdef CONFIG_USB_ETH_NCM
+	if (ncm_active(dev)) {
+		/* with room for the byte added below */
+		ntb = malloc(NCM_TX_DATA + length + 1);
+		if (!ntb) {
+			pr_err("No memory to alloc NTB");
+			goto drop;
+		}
+		length = ncm_add_hdr(dev, ntb, packet, length);
+		packet = ntb;
+	}
+#endif
 	req->buf = packet;
 	req->context = NULL;
 	req->complete = tx_complete;
@@ -2358,6 +2549,7 @@ static int usb_eth_send(struct udevice *udev, void *packet, int length)
 		dm_usb_gadget_handle_interrupts(udev->parent);
 	}
 	free(rndis_pkt);
+	free(ntb);
 
 	return 0;
 drop:
@@ -2403,6 +2595,28 @@ static int usb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 
 	dm_usb_gadget_handle_interrupts(dev->parent);
 
+#ifdef CONFIG_USB_ETH_NCM
+	if (packet_received && ncm_active(ethdev)) {
+		int len;
+
+		while ((len = ncm_rx_next(&ethdev->ncm_rx, packetp)) < 0) {
+			ethdev->stats.rx_errors++;
+			ethdev->stats.rx_length_errors++;
+		}
+		if (len) {
+			ethdev->stats.rx_packets++;
+			ethdev->stats.rx_bytes += len;
+			return len;
+		}
+
+		/* all the frames in the NTB are done with, so get another */
+		packet_received = 0;
+		rx_submit(ethdev, ethdev->rx_req, 0);
+
+		return -EAGAIN;
+	}
+#endif
+
 	if (packet_received) {
 		if (ethdev->rx_req) {
 			*packetp = (uchar *)net_rx_packets[0];
@@ -2422,6 +2636,10 @@ static int usb_eth_free_pkt(struct udevice *dev, uchar *packet,
 	struct ether_priv *priv = dev_get_priv(dev);
 	struct eth_dev *ethdev = &priv->ethdev;
 
+	/* the NTB may hold more frames; usb_eth_recv() resubmits after them */
+	if (ncm_active(ethdev))
+		return 0;
+
 	packet_received = 0;
 
 	return rx_submit(ethdev, ethdev->rx_req, 0);
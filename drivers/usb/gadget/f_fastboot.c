@@ -31,7 +31,7 @@
 #define RX_ENDPOINT_MAXIMUM_PACKET_SIZE_1_1  (0x0040)
 #define TX_ENDPOINT_MAXIMUM_PACKET_SIZE      (0x0040)
 
-#define EP_BUFFER_SIZE			4096
+#define EP_BUFFER_SIZE			CONFIG_FASTBOOT_USB_EP_BUF_SIZE
 /*
  * EP_BUFFER_SIZE must always be an integral multiple of maxpacket size
  * (64 or 512 or 1024), else we break on certain controllers like DWC3
@@ -483,6 +483,9 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 
 	req->actual = 0;
 	usb_ep_queue(ep, req, 0);
+
+	/* Flash streamed data while the next request is being received */
+	fastboot_data_flush();
 }
 
 static void do_exit_on_complete(struct usb_ep *ep, struct usb_request *req)
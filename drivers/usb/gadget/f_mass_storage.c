@@ -822,7 +822,7 @@ static int do_write(struct fsg_common *common)
 {
 	struct fsg_lun		*curlun = &common->luns[common->lun];
 	u32			lba;
-	struct fsg_buffhd	*bh;
+	struct fsg_buffhd	*bh, *last;
 	int			get_some_more;
 	u32			amount_left_to_req, amount_left_to_write;
 	loff_t			usb_offset, file_offset;
@@ -926,17 +926,34 @@ static int do_write(struct fsg_common *common)
 		if (bh->state == BUF_STATE_EMPTY && !get_some_more)
 			break;			/* We stopped early */
 		if (bh->state == BUF_STATE_FULL) {
-			common->next_buffhd_to_drain = bh->next;
-			bh->state = BUF_STATE_EMPTY;
-
 			/* Did something go wrong with the transfer? */
 			if (bh->outreq->status != 0) {
+				common->next_buffhd_to_drain = bh->next;
+				bh->state = BUF_STATE_EMPTY;
 				curlun->sense_data = SS_COMMUNICATION_FAILURE;
 				curlun->info_valid = 1;
 				break;
 			}
 
+			/*
+			 * Take in the full buffers which follow this one in
+			 * memory, so that they go to the medium in one write
+			 */
 			amount = bh->outreq->actual;
+			last = bh;
+			while (last->outreq->actual == FSG_BUFLEN &&
+			       last->next->state == BUF_STATE_FULL &&
+			       !last->next->outreq->status &&
+			       last->next->buf == last->buf + FSG_BUFLEN) {
+				last = last->next;
+				amount += last->outreq->actual;
+			}
+			common->next_buffhd_to_drain = last->next;
+			for (;; bh = bh->next) {
+				bh->state = BUF_STATE_EMPTY;
+				if (bh == last)
+					break;
+			}
 
 			/* Perform the write */
 			rc = ums[common->lun].write_sector(&ums[common->lun],
@@ -975,7 +992,7 @@ static int do_write(struct fsg_common *common)
 			}
 
 			/* Did the host decide to stop early? */
-			if (bh->outreq->actual != bh->outreq->length) {
+			if (last->outreq->actual != last->outreq->length) {
 				common->short_packet_received = 1;
 				break;
 			}
@@ -2442,6 +2459,7 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 {
 	struct usb_gadget *gadget = cdev->gadget;
 	struct fsg_buffhd *bh;
+	char *buf;
 	struct fsg_lun *curlun;
 	int nluns, i, rc;
 
@@ -2497,8 +2515,17 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 	}
 	common->lun = 0;
 
-	/* Data buffers cyclic list */
+	/*
+	 * Data buffers cyclic list, in one block so that do_write() can
+	 * write neighbouring buffers together
+	 */
 	bh = common->buffhds;
+	buf = memalign(CONFIG_SYS_CACHELINE_SIZE,
+		       FSG_NUM_BUFFERS * FSG_BUFLEN);
+	if (unlikely(!buf)) {
+		rc = -ENOMEM;
+		goto error_release;
+	}
 
 	i = FSG_NUM_BUFFERS;
 	goto buffhds_first_it;
@@ -2508,11 +2535,8 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 buffhds_first_it:
 		bh->inreq_busy = 0;
 		bh->outreq_busy = 0;
-		bh->buf = memalign(CONFIG_SYS_CACHELINE_SIZE, FSG_BUFLEN);
-		if (unlikely(!bh->buf)) {
-			rc = -ENOMEM;
-			goto error_release;
-		}
+		bh->buf = buf;
+		buf += FSG_BUFLEN;
 	} while (--i);
 	bh->next = common->buffhds;
 
@@ -2574,13 +2598,8 @@ static void fsg_common_release(struct kref *ref)
 		kfree(common->luns);
 	}
 
-	{
-		struct fsg_buffhd *bh = common->buffhds;
-		unsigned i = FSG_NUM_BUFFERS;
-		do {
-			kfree(bh->buf);
-		} while (++bh, --i);
-	}
+	/* the first buffer is the start of the block holding them all */
+	kfree(common->buffhds[0].buf);
 
 	if (common->free_storage_on_release)
 		kfree(common);
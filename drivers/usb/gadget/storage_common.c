@@ -307,10 +307,18 @@ static struct fsg_lun *fsg_lun_from_dev(struct device *dev)
 #define DELAYED_STATUS	(EP0_BUFSIZE + 999)	/* An impossibly large value */
 
 /* Number of buffers we will use.  2 is enough for double-buffering */
+#ifdef CONFIG_USB_FUNCTION_MASS_STORAGE_BUFFERS
+#define FSG_NUM_BUFFERS	CONFIG_USB_FUNCTION_MASS_STORAGE_BUFFERS
+#else
 #define FSG_NUM_BUFFERS	2
+#endif
 
 /* Default size of buffer length. */
+#ifdef CONFIG_USB_FUNCTION_MASS_STORAGE_BUFLEN
+#define FSG_BUFLEN	((u32)CONFIG_USB_FUNCTION_MASS_STORAGE_BUFLEN)
+#else
 #define FSG_BUFLEN	((u32)131072)
+#endif
 
 /* Maximal number of LUNs supported in mass storage function */
 #define FSG_MAX_LUNS	8
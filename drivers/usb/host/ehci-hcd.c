@@ -363,6 +363,29 @@ static int ehci_iaa_cycle(struct ehci_ctrl *ctrl)
 	return ret;
 }
 
+/*
+ * Transfers are submitted one at a time, so a single qTD array can back all
+ * of them. It only grows, which saves an allocation per bulk transfer.
+ */
+static struct qTD *ehci_get_qtd_pool(struct ehci_ctrl *ctrl, int count)
+{
+	if (count > ctrl->qtd_pool_count) {
+		free(ctrl->qtd_pool);
+		ctrl->qtd_pool = memalign(USB_DMA_MINALIGN,
+					  count * sizeof(struct qTD));
+		ctrl->qtd_pool_count = ctrl->qtd_pool ? count : 0;
+	}
+
+	return ctrl->qtd_pool;
+}
+
+static void ehci_free_qtd_pool(struct ehci_ctrl *ctrl)
+{
+	free(ctrl->qtd_pool);
+	ctrl->qtd_pool = NULL;
+	ctrl->qtd_pool_count = 0;
+}
+
 static int
 ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		   int length, struct devrequest *req)
@@ -448,7 +471,7 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 #if CONFIG_SYS_MALLOC_LEN <= 64 + 128 * 1024
 #warning CONFIG_SYS_MALLOC_LEN may be too small for EHCI
 #endif
-	qtd = memalign(USB_DMA_MINALIGN, qtd_count * sizeof(struct qTD));
+	qtd = ehci_get_qtd_pool(ctrl, qtd_count);
 	if (qtd == NULL) {
 		printf("unable to allocate TDs\n");
 		return -1;
@@ -710,11 +733,9 @@ ehci_submit_async(struct usb_device *dev, unsigned long pipe, void *buffer,
 		      ehci_readl(&ctrl->hcor->or_portsc[1]));
 	}
 
-	free(qtd);
 	return (dev->status != USB_ST_NOT_PROC) ? 0 : -1;
 
 fail:
-	free(qtd);
 	return -1;
 }
 
@@ -1155,6 +1176,7 @@ static int ehci_common_init(struct ehci_ctrl *ctrl, uint tweaks)
 int usb_lowlevel_stop(int index)
 {
 	ehci_shutdown(&ehcic[index]);
+	ehci_free_qtd_pool(&ehcic[index]);
 	return ehci_hcd_stop(index);
 }
 
@@ -1745,6 +1767,7 @@ int ehci_deregister(struct udevice *dev)
 		return 0;
 
 	ehci_shutdown(ctrl);
+	ehci_free_qtd_pool(ctrl);
 
 	return 0;
 }
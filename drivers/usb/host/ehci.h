@@ -255,6 +255,8 @@ struct ehci_ctrl {
 	uint32_t *periodic_list;
 	int periodic_schedules;
 	int ntds;
+	struct qTD *qtd_pool;	/* qTDs reused across async transfers */
+	int qtd_pool_count;
 	bool has_fsl_erratum_a005275;	/* Freescale HS silicon quirk */
 	bool async_locked;
 	struct ehci_ops ops;
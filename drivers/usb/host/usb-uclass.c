@@ -9,10 +9,12 @@
 #define LOG_CATEGORY UCLASS_USB
 
 #include <bootdev.h>
+#include <bootstage.h>
 #include <dm.h>
 #include <errno.h>
 #include <log.h>
 #include <memalign.h>
+#include <time.h>
 #include <usb.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -20,6 +22,12 @@
 
 static bool asynch_allowed;
 
+/* usb_init_start() has run, leaving the root-hub ports to be scanned */
+static bool usb_init_pending;
+
+/* Time spent scanning ports, for bootstage */
+static ulong usb_scan_us;
+
 struct usb_uclass_priv {
 	int companion_device_count;
 };
@@ -186,6 +194,8 @@ int usb_stop(void)
 		return ret;
 
 	uc_priv = uclass_get_priv(uc);
+	usb_hub_drop_scan();
+	usb_init_pending = false;
 
 	uclass_foreach_dev(bus, uc) {
 		ret = device_remove(bus, DM_REMOVE_NORMAL);
@@ -221,14 +231,21 @@ int usb_stop(void)
 	return err;
 }
 
-static void usb_scan_bus(struct udevice *bus, bool recurse)
+static void usb_show_found(struct udevice *bus)
+{
+	struct usb_bus_priv *priv = dev_get_uclass_priv(bus);
+
+	if (priv->next_addr == 0)
+		printf("No USB Device found\n");
+	else
+		printf("%d USB Device(s) found\n", priv->next_addr);
+}
+
+static void usb_scan_bus(struct udevice *bus, bool recurse, bool defer)
 {
-	struct usb_bus_priv *priv;
 	struct udevice *dev;
 	int ret;
 
-	priv = dev_get_uclass_priv(bus);
-
 	assert(recurse);	/* TODO: Support non-recusive */
 
 	printf("scanning bus %s for devices... ", bus->name);
@@ -236,10 +253,10 @@ static void usb_scan_bus(struct udevice *bus, bool recurse)
 	ret = usb_scan_device(bus, 0, USB_SPEED_FULL, &dev);
 	if (ret)
 		printf("failed, error %d\n", ret);
-	else if (priv->next_addr == 0)
-		printf("No USB Device found\n");
+	else if (defer)
+		printf("powering up ports\n");
 	else
-		printf("%d USB Device(s) found\n", priv->next_addr);
+		usb_show_found(bus);
 }
 
 static void remove_inactive_children(struct uclass *uc, struct udevice *bus)
@@ -287,13 +304,32 @@ static int usb_probe_companion(struct udevice *bus)
 	return 0;
 }
 
-int usb_init(void)
+/**
+ * usb_init_start() - probe the USB controllers and power up their root hubs
+ *
+ * With more than one controller, or with @async, the root-hub ports are left on
+ * the hub scan list, so that usb_init_end() can scan them all together, with
+ * the power-on and connection delays of each controller overlapping. This sets
+ * usb_init_pending.
+ *
+ * Companion controllers can only be scanned after the primary controllers have
+ * handed devices over, so if there are any, everything is scanned here, one
+ * controller at a time.
+ *
+ * @async: true to defer the scan even with a single controller
+ * Return: 0 if OK, -ENOENT if no controller could be started, other -ve on
+ *	error
+ */
+static int usb_init_start(bool async)
 {
 	int controllers_initialized = 0;
 	struct usb_uclass_priv *uc_priv;
 	struct usb_bus_priv *priv;
 	struct udevice *bus;
 	struct uclass *uc;
+	ulong start_us;
+	int found = 0;
+	bool defer;
 	int ret;
 
 	asynch_allowed = 1;
@@ -326,7 +362,9 @@ int usb_init(void)
 			}
 		}
 
+		start_us = timer_get_us();
 		ret = device_probe(bus);
+		bootstage_add_accum(bus->name, timer_get_us() - start_us);
 		if (ret == -ENODEV) {	/* No such device. */
 			puts("Port not available.\n");
 			controllers_initialized++;
@@ -343,21 +381,27 @@ int usb_init(void)
 			continue;
 
 		controllers_initialized++;
-		usb_started = true;
+		found++;
 	}
 
+	/* companions can only be scanned once the primaries are done */
+	defer = !uc_priv->companion_device_count && (async || found > 1);
+
 	/*
 	 * lowlevel init done, now scan the bus for devices i.e. search HUBs
 	 * and configure them, first scan primary controllers.
 	 */
+	start_us = timer_get_us();
+	usb_hub_defer_scan(defer);
 	uclass_foreach_dev(bus, uc) {
 		if (!device_active(bus))
 			continue;
 
 		priv = dev_get_uclass_priv(bus);
 		if (!priv->companion)
-			usb_scan_bus(bus, true);
+			usb_scan_bus(bus, true, defer);
 	}
+	usb_hub_defer_scan(false);
 
 	/*
 	 * Now that the primary controllers have been scanned and have handed
@@ -371,11 +415,51 @@ int usb_init(void)
 
 			priv = dev_get_uclass_priv(bus);
 			if (priv->companion)
-				usb_scan_bus(bus, true);
+				usb_scan_bus(bus, true, false);
 		}
 	}
 
+	usb_scan_us += timer_get_us() - start_us;
+
+	/* if we were not able to find at least one working bus, bail out */
+	if (controllers_initialized == 0)
+		printf("No USB controllers found\n");
+	if (!found)
+		return -ENOENT;
+	usb_init_pending = defer;
+
+	return 0;
+}
+
+/* Scan any ports left by usb_init_start() and tidy up */
+static int usb_init_end(void)
+{
+	struct udevice *bus = NULL;
+	struct uclass *uc;
+	int ret;
+
+	ret = uclass_get(UCLASS_USB, &uc);
+	if (ret)
+		return ret;
+
+	if (usb_init_pending) {
+		ulong start_us = timer_get_us();
+
+		usb_init_pending = false;
+		ret = usb_hub_scan_deferred();
+		if (ret)
+			printf("USB device scan failed, error %d\n", ret);
+		usb_scan_us += timer_get_us() - start_us;
+		uclass_foreach_dev(bus, uc) {
+			if (device_active(bus)) {
+				printf("Bus %s: ", bus->name);
+				usb_show_found(bus);
+			}
+		}
+	}
 	debug("scan end\n");
+	bootstage_add_accum("usb_scan", usb_scan_us);
+	usb_scan_us = 0;
 
 	/* Remove any devices that were not found on this scan */
 	remove_inactive_children(uc, bus);
@@ -385,11 +469,44 @@ int usb_init(void)
 		return ret;
 	remove_inactive_children(uc, bus);
 
-	/* if we were not able to find at least one working bus, bail out */
-	if (controllers_initialized == 0)
-		printf("No USB controllers found\n");
+	return 0;
+}
 
-	return usb_started ? 0 : -ENOENT;
+int usb_init_async(void)
+{
+	int ret;
+
+	if (usb_init_pending)
+		return 0;
+	ret = usb_init_start(true);
+	if (ret)
+		return ret;
+	if (!usb_init_pending) {
+		/* everything was scanned already */
+		usb_started = true;
+		return usb_init_end();
+	}
+
+	return 0;
+}
+
+int usb_init(void)
+{
+	int ret;
+
+	if (!usb_init_pending) {
+		ret = usb_init_start(false);
+		if (ret == -ENOENT)
+			usb_init_end();
+		if (ret)
+			return ret;
+	}
+	ret = usb_init_end();
+	if (ret)
+		return ret;
+	usb_started = true;
+
+	return 0;
 }
 
 int usb_setup_ehci_gadget(struct ehci_ctrl **ctlrp)
@@ -198,8 +198,9 @@ static void inc_deq(struct xhci_ctrl *ctrl, struct xhci_ring *ring)
  * @param trb_fields	pointer to trb field array containing TRB contents
  * Return: pointer to the enqueued trb
  */
-static dma_addr_t queue_trb(struct xhci_ctrl *ctrl, struct xhci_ring *ring,
-			    bool more_trbs_coming, unsigned int *trb_fields)
+static dma_addr_t __queue_trb(struct xhci_ctrl *ctrl, struct xhci_ring *ring,
+			      bool more_trbs_coming, unsigned int *trb_fields,
+			      bool flush)
 {
 	struct xhci_generic_trb *trb;
 	dma_addr_t addr;
@@ -210,7 +211,9 @@ static dma_addr_t queue_trb(struct xhci_ctrl *ctrl, struct xhci_ring *ring,
 	for (i = 0; i < 4; i++)
 		trb->field[i] = cpu_to_le32(trb_fields[i]);
 
-	xhci_flush_cache((uintptr_t)trb, sizeof(struct xhci_generic_trb));
+	if (flush)
+		xhci_flush_cache((uintptr_t)trb,
+				 sizeof(struct xhci_generic_trb));
 
 	addr = xhci_trb_virt_to_dma(ring->enq_seg, (union xhci_trb *)trb);
 
@@ -219,6 +222,43 @@ static dma_addr_t queue_trb(struct xhci_ctrl *ctrl, struct xhci_ring *ring,
 	return addr;
 }
 
+static dma_addr_t queue_trb(struct xhci_ctrl *ctrl, struct xhci_ring *ring,
+			    bool more_trbs_coming, unsigned int *trb_fields)
+{
+	return __queue_trb(ctrl, ring, more_trbs_coming, trb_fields, true);
+}
+
+/**
+ * Flushes all TRBs queued since @trb in @seg, up to the ring's current enqueue
+ * pointer, with one cache operation per ring segment.
+ *
+ * @param ring	pointer to the ring
+ * @param seg	segment holding the first TRB to flush
+ * @param trb	first TRB to flush
+ * Return: none
+ */
+static void flush_queued_trbs(struct xhci_ring *ring,
+			      struct xhci_segment *seg, union xhci_trb *trb)
+{
+	union xhci_trb *end;
+
+	for (;;) {
+		if (seg == ring->enq_seg && ring->enqueue >= trb)
+			end = ring->enqueue;
+		else
+			end = &seg->trbs[TRBS_PER_SEGMENT];
+
+		if (end != trb)
+			xhci_flush_cache((uintptr_t)trb,
+					 (uintptr_t)end - (uintptr_t)trb);
+		if (end == ring->enqueue)
+			break;
+
+		seg = seg->next;
+		trb = seg->trbs;
+	}
+}
+
 /**
  * Does various checks on the endpoint ring, and makes it ready
  * to queue num_trbs.
@@ -648,6 +688,7 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	struct xhci_virt_device *virt_dev;
 	struct xhci_ep_ctx *ep_ctx;
 	struct xhci_ring *ring;		/* EP transfer ring */
+	struct xhci_segment *start_seg;
 	union xhci_trb *event;
 
 	int running_total, trb_buff_len;
@@ -724,6 +765,7 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	 * state may change as we enqueue the other TRBs, so save it too.
 	 */
 	start_trb = &ring->enqueue->generic;
+	start_seg = ring->enq_seg;
 	start_cycle = ring->cycle_state;
 
 	running_total = 0;
@@ -788,7 +830,9 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		trb_fields[2] = length_field;
 		trb_fields[3] = field | TRB_TYPE(TRB_NORMAL);
 
-		last_transfer_trb_addr = queue_trb(ctrl, ring, (num_trbs > 1), trb_fields);
+		/* The whole TD is flushed at once below */
+		last_transfer_trb_addr = __queue_trb(ctrl, ring, (num_trbs > 1),
+						     trb_fields, false);
 
 		--num_trbs;
 
@@ -801,6 +845,7 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 		schedule();
 	} while (running_total < length);
 
+	flush_queued_trbs(ring, start_seg, (union xhci_trb *)start_trb);
 	giveback_first_trb(udev, ep_index, start_cycle, start_trb);
 
 again:
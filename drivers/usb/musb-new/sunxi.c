@@ -382,9 +382,15 @@ static const struct musb_platform_ops sunxi_musb_ops = {
 #define SUNXI_MUSB_MAX_EP_NUM		6
 #define SUNXI_MUSB_RAM_BITS		11
 
+/*
+ * Endpoint 1, which gadgets such as fastboot and UMS bind their bulk
+ * endpoints to, is double buffered so the host can send the next packet
+ * while the previous one is being unloaded by PIO. All FIFOs still fit the
+ * 8 KiB of FIFO RAM.
+ */
 static struct musb_fifo_cfg sunxi_musb_mode_cfg[] = {
-	MUSB_EP_FIFO_SINGLE(1, FIFO_TX, 512),
-	MUSB_EP_FIFO_SINGLE(1, FIFO_RX, 512),
+	MUSB_EP_FIFO_DOUBLE(1, FIFO_TX, 512),
+	MUSB_EP_FIFO_DOUBLE(1, FIFO_RX, 512),
 	MUSB_EP_FIFO_SINGLE(2, FIFO_TX, 512),
 	MUSB_EP_FIFO_SINGLE(2, FIFO_RX, 512),
 	MUSB_EP_FIFO_SINGLE(3, FIFO_TX, 512),
@@ -399,8 +405,8 @@ static struct musb_fifo_cfg sunxi_musb_mode_cfg[] = {
 #define SUNXI_MUSB_MAX_EP_NUM_H3	5
 
 static struct musb_fifo_cfg sunxi_musb_mode_cfg_h3[] = {
-	MUSB_EP_FIFO_SINGLE(1, FIFO_TX, 512),
-	MUSB_EP_FIFO_SINGLE(1, FIFO_RX, 512),
+	MUSB_EP_FIFO_DOUBLE(1, FIFO_TX, 512),
+	MUSB_EP_FIFO_DOUBLE(1, FIFO_RX, 512),
 	MUSB_EP_FIFO_SINGLE(2, FIFO_TX, 512),
 	MUSB_EP_FIFO_SINGLE(2, FIFO_RX, 512),
 	MUSB_EP_FIFO_SINGLE(3, FIFO_TX, 512),
@@ -8,6 +8,7 @@
  * BMP handling routines
  */
 
+#include <abuf.h>
 #include <bmp_layout.h>
 #include <command.h>
 #include <dm.h>
@@ -18,9 +19,34 @@
 #include <splash.h>
 #include <video.h>
 #include <asm/byteorder.h>
+#include <asm/unaligned.h>
+#include <linux/zstd.h>
+
+/* Decompress a zstd frame, returning 0 and updating *lenp if OK */
+static int unzstd_bmp(void *dst, const void *src, unsigned long *lenp)
+{
+	struct abuf in, out;
+	size_t size;
+	int ret;
+
+	/* the image size is not known, so find the end of the frame */
+	size = zstd_find_frame_compressed_size(src, *lenp);
+	if (zstd_is_error(size))
+		return -EINVAL;
+
+	abuf_init_set(&in, (void *)src, size);
+	abuf_init_set(&out, dst, *lenp);
+	ret = zstd_decompress(&in, &out);
+	if (ret < 0)
+		return ret;
+	*lenp = ret;
+
+	return 0;
+}
 
 /*
- * Allocate and decompress a BMP image using gunzip().
+ * Allocate and decompress a BMP image using gunzip(), or zstd if the image
+ * starts with the zstd magic number and CONFIG_VIDEO_BMP_ZSTD is enabled.
  *
  * Returns a pointer to the decompressed image data. This pointer is
  * aligned to 32-bit-aligned-address + 2.
@@ -36,11 +62,15 @@
 struct bmp_image *gunzip_bmp(unsigned long addr, unsigned long *lenp,
 			     void **alloc_addr)
 {
-	void *dst;
+	void *dst, *src = map_sysmem(addr, 0);
 	unsigned long len;
 	struct bmp_image *bmp;
+	bool zstd;
+	int ret;
 
-	if (!CONFIG_IS_ENABLED(VIDEO_BMP_GZIP))
+	zstd = CONFIG_IS_ENABLED(VIDEO_BMP_ZSTD) &&
+		get_unaligned_le32(src) == ZSTD_MAGICNUMBER;
+	if (!zstd && !CONFIG_IS_ENABLED(VIDEO_BMP_GZIP))
 		return NULL;
 
 	/*
@@ -57,8 +87,11 @@ struct bmp_image *gunzip_bmp(unsigned long addr, unsigned long *lenp,
 	/* align to 32-bit-aligned-address + 2 */
 	bmp = dst + 2;
 
-	if (gunzip(bmp, CONFIG_VAL(VIDEO_LOGO_MAX_SIZE), map_sysmem(addr, 0),
-		   &len)) {
+	if (zstd)
+		ret = unzstd_bmp(bmp, src, &len);
+	else
+		ret = gunzip(bmp, CONFIG_VAL(VIDEO_LOGO_MAX_SIZE), src, &len);
+	if (ret) {
 		free(dst);
 		return NULL;
 	}
@@ -74,7 +107,7 @@ struct bmp_image *gunzip_bmp(unsigned long addr, unsigned long *lenp,
 		return NULL;
 	}
 
-	debug("Gzipped BMP image detected!\n");
+	debug("%s BMP image detected!\n", zstd ? "Zstd" : "Gzipped");
 
 	*alloc_addr = dst;
 	return bmp;
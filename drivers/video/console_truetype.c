@@ -155,12 +155,60 @@ struct console_tt_metrics {
 	double scale;
 };
 
+/**
+ * struct console_tt_glyph - A rendered character
+ *
+ * @font_data:	Font which the character is from, or NULL if this is unused
+ * @font_size:	Vertical font size in pixels
+ * @cp:		Unicode code point
+ * @x_shift:	Fractional pixel position the character was rendered at
+ * @width:	Width of the image in pixels
+ * @height:	Height of the image in pixels
+ * @xoff:	X offset of the image from the cursor position
+ * @yoff:	Y offset of the image from the baseline
+ * @ofs:	Offset of the 8bpp image in the cache arena
+ */
+struct console_tt_glyph {
+	const u8 *font_data;
+	int font_size;
+	int cp;
+	double x_shift;
+	int width;
+	int height;
+	int xoff;
+	int yoff;
+	uint ofs;
+};
+
+enum {
+	GLYPH_CACHE_SLOTS	= 256,
+};
+
+/**
+ * struct console_tt_cache - Cache of rendered characters
+ *
+ * Characters are looked up by font, size, code point and sub-pixel position,
+ * so that what is drawn from the cache is exactly what would be rendered. The
+ * images are kept in a fixed arena. When it is full, the whole cache is
+ * emptied and filled again.
+ *
+ * @used:	Number of bytes of @arena in use
+ * @slot:	Characters which are cached, hashed by their key
+ * @arena:	Space for the images
+ */
+struct console_tt_cache {
+	uint used;
+	struct console_tt_glyph slot[GLYPH_CACHE_SLOTS];
+	u8 arena[CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE];
+};
+
 /**
  * struct console_tt_priv - Private data for this driver
  *
  * @cur_met:	Current metrics being used
  * @metrics:	List metrics that can be used
  * @num_metrics:	Number of available metrics
+ * @cache:	Cache of rendered characters, or NULL if none
  * @pos:	List of cursor positions for each character written. This is
  *		used to handle backspace. We clear the frame buffer between
  *		the last position and the current position, thus erasing the
@@ -172,6 +220,7 @@ struct console_tt_priv {
 	struct console_tt_metrics *cur_met;
 	struct console_tt_metrics metrics[CONFIG_CONSOLE_TRUETYPE_MAX_METRICS];
 	int num_metrics;
+	struct console_tt_cache *cache;
 	struct pos_info pos[POS_HISTORY_SIZE];
 	int pos_ptr;
 };
@@ -261,6 +310,79 @@ static int console_truetype_move_rows(struct udevice *dev, uint rowdst,
 	return 0;
 }
 
+static struct console_tt_glyph *glyph_slot(struct console_tt_cache *cache,
+					    struct console_tt_metrics *met,
+					    int cp, double x_shift)
+{
+	uint hash;
+
+	hash = cp * 31 + met->font_size * 7 + (uint)(x_shift * 256) +
+		((ulong)met->font_data >> 4);
+
+	return &cache->slot[hash % GLYPH_CACHE_SLOTS];
+}
+
+/**
+ * get_glyph() - Get the image of a character, rendering it if not cached
+ *
+ * @priv:	Private data
+ * @met:	Metrics of the font to use
+ * @cp:		Unicode code point
+ * @x_shift:	Fractional pixel position to render at
+ * @glyph:	Returns the size and position of the image
+ * @allocp:	Returns true if the image must be freed by the caller
+ * Return: 8bpp image, or NULL if the character has none
+ */
+static const u8 *get_glyph(struct console_tt_priv *priv,
+			   struct console_tt_metrics *met, int cp,
+			   double x_shift, struct console_tt_glyph *glyph,
+			   bool *allocp)
+{
+	struct console_tt_cache *cache = priv->cache;
+	struct console_tt_glyph *slot = NULL;
+	uint size;
+	u8 *data;
+
+	*allocp = false;
+	if (cache) {
+		slot = glyph_slot(cache, met, cp, x_shift);
+		if (slot->font_data == met->font_data &&
+		    slot->font_size == met->font_size && slot->cp == cp &&
+		    slot->x_shift == x_shift) {
+			*glyph = *slot;
+			return cache->arena + slot->ofs;
+		}
+	}
+
+	data = stbtt_GetCodepointBitmapSubpixel(&met->font, met->scale,
+						met->scale, x_shift, 0, cp,
+						&glyph->width, &glyph->height,
+						&glyph->xoff, &glyph->yoff);
+	if (!data)
+		return NULL;
+
+	size = glyph->width * glyph->height;
+	if (!cache || size > sizeof(cache->arena)) {
+		*allocp = true;
+		return data;
+	}
+	if (cache->used + size > sizeof(cache->arena)) {
+		memset(cache->slot, '\0', sizeof(cache->slot));
+		cache->used = 0;
+	}
+	glyph->font_data = met->font_data;
+	glyph->font_size = met->font_size;
+	glyph->cp = cp;
+	glyph->x_shift = x_shift;
+	glyph->ofs = cache->used;
+	memcpy(cache->arena + cache->used, data, size);
+	cache->used += size;
+	*slot = *glyph;
+	free(data);
+
+	return cache->arena + glyph->ofs;
+}
+
 static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 				    int cp)
 {
@@ -270,14 +392,16 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	struct console_tt_priv *priv = dev_get_priv(dev);
 	struct console_tt_metrics *met = priv->cur_met;
 	stbtt_fontinfo *font = &met->font;
+	struct console_tt_glyph glyph;
 	int width, height, xoff, yoff;
 	double xpos, x_shift;
 	int lsb;
 	int width_frac, linenum;
 	struct pos_info *pos;
-	u8 *bits, *data;
+	const u8 *bits, *data;
 	int advance;
 	void *start, *end, *line;
+	bool alloced;
 	int row, ret;
 
 	/* First get some basic metrics about this character */
@@ -319,11 +443,13 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	 * image of the character. For empty characters, like ' ', data will
 	 * return NULL;
 	 */
-	data = stbtt_GetCodepointBitmapSubpixel(font, met->scale, met->scale,
-						x_shift, 0, cp, &width, &height,
-						&xoff, &yoff);
+	data = get_glyph(priv, met, cp, x_shift, &glyph, &alloced);
 	if (!data)
 		return width_frac;
+	width = glyph.width;
+	height = glyph.height;
+	xoff = glyph.xoff;
+	yoff = glyph.yoff;
 
 	/* Figure out where to write the character in the frame buffer */
 	bits = data;
@@ -412,16 +538,18 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 			break;
 		}
 		default:
-			free(data);
+			if (alloced)
+				free((void *)data);
 			return -ENOSYS;
 		}
 
 		line += vid_priv->line_length;
 	}
+	if (alloced)
+		free((void *)data);
 	ret = vidconsole_sync_copy(dev, start, line);
 	if (ret)
 		return ret;
-	free(data);
 
 	return width_frac;
 }
@@ -985,11 +1113,24 @@ static int console_truetype_probe(struct udevice *dev)
 
 	select_metrics(dev, &priv->metrics[ret]);
 
+	/* this is only an optimisation, so carry on without it */
+	if (CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE)
+		priv->cache = calloc(1, sizeof(*priv->cache));
+
 	debug("%s: ready\n", __func__);
 
 	return 0;
 }
 
+static int console_truetype_remove(struct udevice *dev)
+{
+	struct console_tt_priv *priv = dev_get_priv(dev);
+
+	free(priv->cache);
+
+	return 0;
+}
+
 struct vidconsole_ops console_truetype_ops = {
 	.putc_xy	= console_truetype_putc_xy,
 	.move_rows	= console_truetype_move_rows,
@@ -1011,5 +1152,6 @@ U_BOOT_DRIVER(vidconsole_truetype) = {
 	.id	= UCLASS_VIDEO_CONSOLE,
 	.ops	= &console_truetype_ops,
 	.probe	= console_truetype_probe,
+	.remove	= console_truetype_remove,
 	.priv_auto	= sizeof(struct console_tt_priv),
 };
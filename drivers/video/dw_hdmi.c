@@ -936,6 +936,11 @@ int dw_hdmi_phy_wait_for_hpd(struct dw_hdmi *hdmi)
 	return -1;
 }
 
+bool dw_hdmi_phy_hpd(struct dw_hdmi *hdmi)
+{
+	return hdmi_get_plug_in_status(hdmi);
+}
+
 int dw_hdmi_detect_hpd(struct dw_hdmi *hdmi)
 {
 	int ret;
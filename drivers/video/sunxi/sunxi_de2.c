@@ -30,6 +30,15 @@ enum {
 	LCD_MAX_LOG2_BPP	= VIDEO_BPP32,
 };
 
+/**
+ * struct sunxi_de2_priv - Private data for the DE2 driver
+ *
+ * @mux: Mixer driving the display
+ */
+struct sunxi_de2_priv {
+	int mux;
+};
+
 static void sunxi_de2_composer_init(void)
 {
 	struct sunxi_ccm_reg * const ccm =
@@ -182,6 +191,7 @@ static int sunxi_de2_init(struct udevice *dev, ulong fbbase,
 			  struct udevice *disp, int mux, bool is_composite)
 {
 	struct video_priv *uc_priv = dev_get_uclass_priv(dev);
+	struct sunxi_de2_priv *priv = dev_get_priv(dev);
 	struct display_timing timing;
 	struct display_plat *disp_uc_plat;
 	int ret;
@@ -203,6 +213,7 @@ static int sunxi_de2_init(struct udevice *dev, ulong fbbase,
 
 	sunxi_de2_composer_init();
 	sunxi_de2_mode_set(mux, &timing, 1 << l2bpp, fbbase, is_composite);
+	priv->mux = mux;
 
 	ret = display_enable(disp, 1 << l2bpp, &timing);
 	if (ret) {
@@ -284,7 +295,32 @@ static int sunxi_de2_bind(struct udevice *dev)
 	return 0;
 }
 
+static int sunxi_de2_set_scanout(struct udevice *dev, uint yoffset)
+{
+	struct video_uc_plat *plat = dev_get_uclass_plat(dev);
+	struct video_priv *uc_priv = dev_get_uclass_priv(dev);
+	struct sunxi_de2_priv *priv = dev_get_priv(dev);
+	ulong de_mux_base = (priv->mux == 0) ?
+			    SUNXI_DE2_MUX0_BASE : SUNXI_DE2_MUX1_BASE;
+	struct de_glb * const de_glb_regs =
+		(struct de_glb *)(de_mux_base +
+				  SUNXI_DE2_MUX_GLB_REGS);
+	struct de_ui * const de_ui_regs =
+		(struct de_ui *)(de_mux_base +
+				 SUNXI_DE2_MUX_CHAN_REGS +
+				 SUNXI_DE2_MUX_CHAN_SZ * 1);
+
+	writel(plat->base + yoffset * uc_priv->line_length,
+	       &de_ui_regs->cfg[0].top_laddr);
+
+	/* apply the new address at the next frame */
+	writel(1, &de_glb_regs->dbuff);
+
+	return 0;
+}
+
 static const struct video_ops sunxi_de2_ops = {
+	.set_scanout	= sunxi_de2_set_scanout,
 };
 
 U_BOOT_DRIVER(sunxi_de2) = {
@@ -293,6 +329,7 @@ U_BOOT_DRIVER(sunxi_de2) = {
 	.ops	= &sunxi_de2_ops,
 	.bind	= sunxi_de2_bind,
 	.probe	= sunxi_de2_probe,
+	.priv_auto	= sizeof(struct sunxi_de2_priv),
 	.flags	= DM_FLAG_PRE_RELOC,
 };
 
@@ -362,6 +399,11 @@ int sunxi_simplefb_setup(void *blob)
 	de2_priv = dev_get_uclass_priv(de2);
 	de2_plat = dev_get_uclass_plat(de2);
 
+	/* the OS expects the display to start at the frame-buffer base */
+	ret = video_pan_disable(de2);
+	if (ret)
+		return ret;
+
 	offset = sunxi_simplefb_fdt_match(blob, pipeline);
 	if (offset < 0) {
 		eprintf("Cannot setup simplefb: node not found\n");
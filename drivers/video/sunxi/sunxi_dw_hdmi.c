@@ -6,10 +6,12 @@
  */
 
 #include <clk.h>
+#include <cyclic.h>
 #include <display.h>
 #include <dm.h>
 #include <dw_hdmi.h>
 #include <edid.h>
+#include <event.h>
 #include <log.h>
 #include <reset.h>
 #include <time.h>
@@ -20,11 +22,58 @@
 #include <linux/delay.h>
 #include <power/regulator.h>
 
+/**
+ * enum sunxi_dw_hdmi_stage - stage of bringing up the output
+ *
+ * @SUNXI_HDMI_IDLE: Nothing in progress
+ * @SUNXI_HDMI_PLL_START: PHY PLL programmed, waiting to enable it
+ * @SUNXI_HDMI_PLL_CAL: PHY PLL enabled, waiting to read its calibration
+ * @SUNXI_HDMI_PLL_SETTLE: Calibration applied, waiting for it to settle
+ * @SUNXI_HDMI_HPD: Waiting for a display to be plugged in
+ * @SUNXI_HDMI_ENABLE: PHY PLL set for the mode, waiting to enable the PHY
+ */
+enum sunxi_dw_hdmi_stage {
+	SUNXI_HDMI_IDLE,
+	SUNXI_HDMI_PLL_START,
+	SUNXI_HDMI_PLL_CAL,
+	SUNXI_HDMI_PLL_SETTLE,
+	SUNXI_HDMI_HPD,
+	SUNXI_HDMI_ENABLE,
+};
+
+struct sunxi_hdmi_phy_seq;
+
+/**
+ * struct sunxi_dw_hdmi_priv - private data for the HDMI bridge
+ *
+ * @hdmi: DesignWare HDMI controller
+ * @resets: Resets of the controller
+ * @clocks: Clocks of the controller
+ * @hvcc: HDMI supply, or NULL if none
+ * @stage: Current stage of bringing up the output
+ * @deadline: Time in microseconds at which @stage is due
+ * @seq: PLL sequence in progress
+ * @hpd_ret: 0 if a display is plugged in, else -ve error code
+ * @pol: Sync polarity bits for the PHY
+ * @enabled: true once the controller is set up for the mode, so the PHY
+ *	can be enabled as soon as its PLL is ready
+ * @busy: true while a stage is being handled, to avoid re-entry from
+ *	schedule()
+ * @cyclic: Cyclic function handling the stages in the background
+ */
 struct sunxi_dw_hdmi_priv {
 	struct dw_hdmi hdmi;
 	struct reset_ctl_bulk resets;
 	struct clk_bulk clocks;
 	struct udevice *hvcc;
+	enum sunxi_dw_hdmi_stage stage;
+	unsigned long deadline;
+	const struct sunxi_hdmi_phy_seq *seq;
+	int hpd_ret;
+	u32 pol;
+	bool enabled;
+	bool busy;
+	struct cyclic_info cyclic;
 };
 
 struct sunxi_hdmi_phy {
@@ -61,13 +110,206 @@ static int sunxi_dw_hdmi_get_divider(uint clock)
 		return 1;
 }
 
-static void sunxi_dw_hdmi_phy_init(struct dw_hdmi *hdmi)
+/**
+ * struct sunxi_hdmi_phy_seq - sequence for setting up the PHY PLL
+ *
+ * The magic numbers are taken as-is from the Allwinner BSP code, there is
+ * no documentation.
+ *
+ * @pll: Initial value of the PLL register
+ * @clk: Value of the clock register, without the divider
+ * @ctrl: Value of the control register once the PLL is calibrated
+ * @unk1: Value of the unk1 register once the PLL is calibrated
+ * @unk2: Value of the unk2 register once the PLL is calibrated
+ * @cal_ms: Time to wait for the PLL before reading its calibration value
+ * @settle_ms: Time to wait after applying the calibration value
+ * @cal_adjust: Add 2 to the calibration value
+ */
+struct sunxi_hdmi_phy_seq {
+	u32 pll;
+	u32 clk;
+	u32 ctrl;
+	u32 unk1;
+	u32 unk2;
+	u16 cal_ms;
+	u16 settle_ms;
+	bool cal_adjust;
+};
+
+static const struct sunxi_hdmi_phy_seq sunxi_hdmi_phy_init_seq = {
+	0x39dc5040, 0x80084343, 0x01FF0F7F, 0x80639000, 0x0F81C405, 100,
+};
+
+static const struct sunxi_hdmi_phy_seq sunxi_hdmi_phy_div1_seq = {
+	0x30dc5fc0, 0x800863C0, 0x01FFFF7F, 0x8063b000, 0x0F8246B5, 200, 100,
+	true,
+};
+
+static const struct sunxi_hdmi_phy_seq sunxi_hdmi_phy_div2_seq = {
+	0x39dc5040, 0x80084380, 0x01FFFF7F, 0x8063a800, 0x0F81C485, 100,
+};
+
+static const struct sunxi_hdmi_phy_seq sunxi_hdmi_phy_div4_seq = {
+	0x39dc5040, 0x80084340, 0x01FFFF7F, 0x8063b000, 0x0F81C405, 100,
+};
+
+static const struct sunxi_hdmi_phy_seq sunxi_hdmi_phy_div11_seq = {
+	0x39dc5040, 0x80084300, 0x01FFFF7F, 0x8063b000, 0x0F81C405, 100,
+};
+
+static struct sunxi_hdmi_phy *sunxi_dw_hdmi_get_phy(struct dw_hdmi *hdmi)
+{
+	return (struct sunxi_hdmi_phy *)(hdmi->ioaddr + HDMI_PHY_OFFS);
+}
+
+static void sunxi_dw_hdmi_wait(struct sunxi_dw_hdmi_priv *priv,
+			       enum sunxi_dw_hdmi_stage stage, uint ms)
 {
-	struct sunxi_hdmi_phy * const phy =
-		(struct sunxi_hdmi_phy *)(hdmi->ioaddr + HDMI_PHY_OFFS);
-	unsigned long tmo;
+	priv->stage = stage;
+	priv->deadline = timer_get_us() + ms * 1000;
+}
+
+/* Check whether there is a timed stage in progress */
+static bool sunxi_dw_hdmi_pending(struct sunxi_dw_hdmi_priv *priv)
+{
+	if (priv->stage == SUNXI_HDMI_ENABLE)
+		return priv->enabled;
+
+	return priv->stage != SUNXI_HDMI_IDLE;
+}
+
+/* Finish the PHY set-up, which is the last access before boot */
+static void sunxi_dw_hdmi_phy_enable(struct sunxi_dw_hdmi_priv *priv)
+{
+	struct sunxi_hdmi_phy * const phy = sunxi_dw_hdmi_get_phy(&priv->hdmi);
+
+	setbits_le32(&phy->pol, priv->pol);
+	setbits_le32(&phy->ctrl, 0xf << 12);
+
+	/*
+	 * This is last hdmi access before boot, so scramble addresses
+	 * again or othwerwise BSP driver won't work. Dummy read is
+	 * needed or otherwise last write doesn't get written correctly.
+	 */
+	(void)readb(priv->hdmi.ioaddr);
+	writel(0, &phy->unscramble);
+}
+
+/*
+ * Move on to the next stage of bringing up the output, if the current one
+ * is due. This is called from the cyclic function, so it must not wait.
+ */
+static void sunxi_dw_hdmi_step(struct sunxi_dw_hdmi_priv *priv)
+{
+	struct sunxi_hdmi_phy * const phy = sunxi_dw_hdmi_get_phy(&priv->hdmi);
+	const struct sunxi_hdmi_phy_seq *seq = priv->seq;
 	u32 tmp;
 
+	/* the DDC and PHY accesses below may call schedule() */
+	if (priv->busy || !sunxi_dw_hdmi_pending(priv))
+		return;
+	if (priv->stage != SUNXI_HDMI_HPD && timer_get_us() < priv->deadline)
+		return;
+	priv->busy = true;
+
+	switch (priv->stage) {
+	case SUNXI_HDMI_PLL_START:
+		writel(1, &phy->unk3);
+		setbits_le32(&phy->pll, BIT(25));
+		sunxi_dw_hdmi_wait(priv, SUNXI_HDMI_PLL_CAL, seq->cal_ms);
+		break;
+	case SUNXI_HDMI_PLL_CAL:
+		tmp = (readl(&phy->status) & 0x1f800) >> 11;
+		setbits_le32(&phy->pll, BIT(31) | BIT(30));
+		if (seq->cal_adjust)
+			tmp = min(tmp + 2, 0x3fU);
+		setbits_le32(&phy->pll, tmp);
+		if (seq->settle_ms) {
+			sunxi_dw_hdmi_wait(priv, SUNXI_HDMI_PLL_SETTLE,
+					   seq->settle_ms);
+			break;
+		}
+		fallthrough;
+	case SUNXI_HDMI_PLL_SETTLE:
+		writel(seq->ctrl, &phy->ctrl);
+		writel(seq->unk1, &phy->unk1);
+		writel(seq->unk2, &phy->unk2);
+		if (seq != &sunxi_hdmi_phy_init_seq) {
+			priv->stage = SUNXI_HDMI_ENABLE;
+			break;
+		}
+
+		/* enable read access to HDMI controller */
+		writel(0x54524545, &phy->read_en);
+		/* descramble register offsets */
+		writel(0x42494E47, &phy->unscramble);
+
+		sunxi_dw_hdmi_wait(priv, SUNXI_HDMI_HPD, 300);
+		break;
+	case SUNXI_HDMI_HPD:
+		if (!dw_hdmi_phy_hpd(&priv->hdmi)) {
+			if (timer_get_us() < priv->deadline)
+				break;
+			debug("hdmi can not get hpd signal\\n");
+			priv->hpd_ret = -ENODEV;
+			priv->stage = SUNXI_HDMI_IDLE;
+			break;
+		}
+		priv->hpd_ret = dw_hdmi_detect_hpd(&priv->hdmi);
+		if (!priv->hpd_ret)
+			dw_hdmi_init(&priv->hdmi);
+		priv->stage = SUNXI_HDMI_IDLE;
+		break;
+	case SUNXI_HDMI_ENABLE:
+		sunxi_dw_hdmi_phy_enable(priv);
+		priv->stage = SUNXI_HDMI_IDLE;
+		break;
+	case SUNXI_HDMI_IDLE:
+		break;
+	}
+
+	priv->busy = false;
+}
+
+/* Wait for all timed stages to complete */
+static void sunxi_dw_hdmi_finish(struct sunxi_dw_hdmi_priv *priv)
+{
+	sunxi_dw_hdmi_step(priv);
+	while (sunxi_dw_hdmi_pending(priv)) {
+		udelay(100);
+		sunxi_dw_hdmi_step(priv);
+	}
+}
+
+static void sunxi_dw_hdmi_cyclic(struct cyclic_info *c)
+{
+	struct sunxi_dw_hdmi_priv *priv;
+
+	priv = container_of(c, struct sunxi_dw_hdmi_priv, cyclic);
+	sunxi_dw_hdmi_step(priv);
+}
+
+/* Start a PLL sequence, finishing it here unless it runs in the background */
+static void sunxi_dw_hdmi_phy_start(struct sunxi_dw_hdmi_priv *priv,
+				    const struct sunxi_hdmi_phy_seq *seq,
+				    u32 clk)
+{
+	struct sunxi_hdmi_phy * const phy = sunxi_dw_hdmi_get_phy(&priv->hdmi);
+
+	writel(seq->pll, &phy->pll);
+	writel(clk, &phy->clk);
+	priv->seq = seq;
+	sunxi_dw_hdmi_wait(priv, SUNXI_HDMI_PLL_START, 10);
+
+	if (!IS_ENABLED(CONFIG_VIDEO_DE2_ASYNC))
+		sunxi_dw_hdmi_finish(priv);
+}
+
+static void sunxi_dw_hdmi_phy_init(struct sunxi_dw_hdmi_priv *priv)
+{
+	struct sunxi_hdmi_phy * const phy = sunxi_dw_hdmi_get_phy(&priv->hdmi);
+	unsigned long tmo;
+
 	/*
 	 * HDMI PHY settings are taken as-is from Allwinner BSP code.
 	 * There is no documentation.
@@ -91,7 +333,7 @@ static void sunxi_dw_hdmi_phy_init(struct dw_hdmi *hdmi)
 	tmo = timer_get_us() + 2000;
 	while ((readl(&phy->status) & 0x80) == 0) {
 		if (timer_get_us() > tmo) {
-			printf("Warning: HDMI PHY init timeout!\n");
+			printf("Warning: HDMI PHY init timeout!\\n");
 			break;
 		}
 	}
@@ -99,98 +341,31 @@ static void sunxi_dw_hdmi_phy_init(struct dw_hdmi *hdmi)
 	setbits_le32(&phy->ctrl, 0xf << 8);
 	setbits_le32(&phy->ctrl, BIT(7));
 
-	writel(0x39dc5040, &phy->pll);
-	writel(0x80084343, &phy->clk);
-	udelay(10000);
-	writel(1, &phy->unk3);
-	setbits_le32(&phy->pll, BIT(25));
-	udelay(100000);
-	tmp = (readl(&phy->status) & 0x1f800) >> 11;
-	setbits_le32(&phy->pll, BIT(31) | BIT(30));
-	setbits_le32(&phy->pll, tmp);
-	writel(0x01FF0F7F, &phy->ctrl);
-	writel(0x80639000, &phy->unk1);
-	writel(0x0F81C405, &phy->unk2);
-
-	/* enable read access to HDMI controller */
-	writel(0x54524545, &phy->read_en);
-	/* descramble register offsets */
-	writel(0x42494E47, &phy->unscramble);
+	sunxi_dw_hdmi_phy_start(priv, &sunxi_hdmi_phy_init_seq,
+				sunxi_hdmi_phy_init_seq.clk);
 }
 
-static void sunxi_dw_hdmi_phy_set(struct dw_hdmi *hdmi, uint clock, int phy_div)
+static void sunxi_dw_hdmi_phy_set(struct sunxi_dw_hdmi_priv *priv, uint clock,
+				  int phy_div)
 {
-	struct sunxi_hdmi_phy * const phy =
-		(struct sunxi_hdmi_phy *)(hdmi->ioaddr + HDMI_PHY_OFFS);
-	int div = sunxi_dw_hdmi_get_divider(clock);
-	u32 tmp;
+	const struct sunxi_hdmi_phy_seq *seq;
 
-	/*
-	 * Unfortunately, we don't know much about those magic
-	 * numbers. They are taken from Allwinner BSP driver.
-	 */
-	switch (div) {
+	switch (sunxi_dw_hdmi_get_divider(clock)) {
 	case 1:
-		writel(0x30dc5fc0, &phy->pll);
-		writel(0x800863C0 | (phy_div - 1), &phy->clk);
-		mdelay(10);
-		writel(0x00000001, &phy->unk3);
-		setbits_le32(&phy->pll, BIT(25));
-		mdelay(200);
-		tmp = (readl(&phy->status) & 0x1f800) >> 11;
-		setbits_le32(&phy->pll, BIT(31) | BIT(30));
-		if (tmp < 0x3d)
-			setbits_le32(&phy->pll, tmp + 2);
-		else
-			setbits_le32(&phy->pll, 0x3f);
-		mdelay(100);
-		writel(0x01FFFF7F, &phy->ctrl);
-		writel(0x8063b000, &phy->unk1);
-		writel(0x0F8246B5, &phy->unk2);
+		seq = &sunxi_hdmi_phy_div1_seq;
 		break;
 	case 2:
-		writel(0x39dc5040, &phy->pll);
-		writel(0x80084380 | (phy_div - 1), &phy->clk);
-		mdelay(10);
-		writel(0x00000001, &phy->unk3);
-		setbits_le32(&phy->pll, BIT(25));
-		mdelay(100);
-		tmp = (readl(&phy->status) & 0x1f800) >> 11;
-		setbits_le32(&phy->pll, BIT(31) | BIT(30));
-		setbits_le32(&phy->pll, tmp);
-		writel(0x01FFFF7F, &phy->ctrl);
-		writel(0x8063a800, &phy->unk1);
-		writel(0x0F81C485, &phy->unk2);
+		seq = &sunxi_hdmi_phy_div2_seq;
 		break;
 	case 4:
-		writel(0x39dc5040, &phy->pll);
-		writel(0x80084340 | (phy_div - 1), &phy->clk);
-		mdelay(10);
-		writel(0x00000001, &phy->unk3);
-		setbits_le32(&phy->pll, BIT(25));
-		mdelay(100);
-		tmp = (readl(&phy->status) & 0x1f800) >> 11;
-		setbits_le32(&phy->pll, BIT(31) | BIT(30));
-		setbits_le32(&phy->pll, tmp);
-		writel(0x01FFFF7F, &phy->ctrl);
-		writel(0x8063b000, &phy->unk1);
-		writel(0x0F81C405, &phy->unk2);
+		seq = &sunxi_hdmi_phy_div4_seq;
 		break;
-	case 11:
-		writel(0x39dc5040, &phy->pll);
-		writel(0x80084300 | (phy_div - 1), &phy->clk);
-		mdelay(10);
-		writel(0x00000001, &phy->unk3);
-		setbits_le32(&phy->pll, BIT(25));
-		mdelay(100);
-		tmp = (readl(&phy->status) & 0x1f800) >> 11;
-		setbits_le32(&phy->pll, BIT(31) | BIT(30));
-		setbits_le32(&phy->pll, tmp);
-		writel(0x01FFFF7F, &phy->ctrl);
-		writel(0x8063b000, &phy->unk1);
-		writel(0x0F81C405, &phy->unk2);
+	default:
+		seq = &sunxi_hdmi_phy_div11_seq;
 		break;
 	}
+
+	sunxi_dw_hdmi_phy_start(priv, seq, seq->clk | (phy_div - 1));
 }
 
 static void sunxi_dw_hdmi_pll_set(uint clk_khz, int *phy_div)
@@ -272,10 +447,12 @@ static void sunxi_dw_hdmi_lcdc_init(int mux, const struct display_timing *edid,
 
 static int sunxi_dw_hdmi_phy_cfg(struct dw_hdmi *hdmi, uint mpixelclock)
 {
+	struct sunxi_dw_hdmi_priv *priv =
+		container_of(hdmi, struct sunxi_dw_hdmi_priv, hdmi);
 	int phy_div;
 
 	sunxi_dw_hdmi_pll_set(mpixelclock / 1000, &phy_div);
-	sunxi_dw_hdmi_phy_set(hdmi, mpixelclock, phy_div);
+	sunxi_dw_hdmi_phy_set(priv, mpixelclock, phy_div);
 
 	return 0;
 }
@@ -284,6 +461,11 @@ static int sunxi_dw_hdmi_read_edid(struct udevice *dev, u8 *buf, int buf_size)
 {
 	struct sunxi_dw_hdmi_priv *priv = dev_get_priv(dev);
 
+	/* the PHY may still be starting up in the background */
+	sunxi_dw_hdmi_finish(priv);
+	if (priv->hpd_ret)
+		return priv->hpd_ret;
+
 	return dw_hdmi_read_edid(&priv->hdmi, buf, buf_size);
 }
 
@@ -297,8 +479,6 @@ static int sunxi_dw_hdmi_enable(struct udevice *dev, int panel_bpp,
 				const struct display_timing *edid)
 {
 	struct sunxi_dw_hdmi_priv *priv = dev_get_priv(dev);
-	struct sunxi_hdmi_phy * const phy =
-		(struct sunxi_hdmi_phy *)(priv->hdmi.ioaddr + HDMI_PHY_OFFS);
 	struct display_plat *uc_plat = dev_get_uclass_plat(dev);
 	int ret;
 
@@ -309,20 +489,18 @@ static int sunxi_dw_hdmi_enable(struct udevice *dev, int panel_bpp,
 	sunxi_dw_hdmi_lcdc_init(uc_plat->source_id, edid, panel_bpp);
 
 	if (edid->flags & DISPLAY_FLAGS_VSYNC_LOW)
-		setbits_le32(&phy->pol, 0x200);
+		priv->pol |= 0x200;
 
 	if (edid->flags & DISPLAY_FLAGS_HSYNC_LOW)
-		setbits_le32(&phy->pol, 0x100);
-
-	setbits_le32(&phy->ctrl, 0xf << 12);
+		priv->pol |= 0x100;
 
 	/*
-	 * This is last hdmi access before boot, so scramble addresses
-	 * again or othwerwise BSP driver won't work. Dummy read is
-	 * needed or otherwise last write doesn't get written correctly.
+	 * The framebuffer is in DRAM, so nothing needs to wait for the PHY
+	 * PLL to be ready before it is enabled
 	 */
-	(void)readb(priv->hdmi.ioaddr);
-	writel(0, &phy->unscramble);
+	priv->enabled = true;
+	if (!IS_ENABLED(CONFIG_VIDEO_DE2_ASYNC))
+		sunxi_dw_hdmi_finish(priv);
 
 	return 0;
 }
@@ -355,13 +533,30 @@ static int sunxi_dw_hdmi_probe(struct udevice *dev)
 	if (ret)
 		return ret;
 
-	sunxi_dw_hdmi_phy_init(&priv->hdmi);
+	if (IS_ENABLED(CONFIG_VIDEO_DE2_ASYNC)) {
+		cyclic_register(&priv->cyclic, sunxi_dw_hdmi_cyclic, 1000,
+				dev->name);
 
-	ret = dw_hdmi_detect_hpd(&priv->hdmi);
-	if (ret < 0)
-		return ret;
+		/* a missing display is reported when the EDID is read */
+		sunxi_dw_hdmi_phy_init(priv);
+
+		return 0;
+	}
+
+	sunxi_dw_hdmi_phy_init(priv);
+
+	return priv->hpd_ret;
+}
+
+static int sunxi_dw_hdmi_remove(struct udevice *dev)
+{
+	struct sunxi_dw_hdmi_priv *priv = dev_get_priv(dev);
 
-	dw_hdmi_init(&priv->hdmi);
+	if (IS_ENABLED(CONFIG_VIDEO_DE2_ASYNC)) {
+		/* the OS expects the output to be running */
+		sunxi_dw_hdmi_finish(priv);
+		cyclic_unregister(&priv->cyclic);
+	}
 
 	return 0;
 }
@@ -413,7 +608,25 @@ U_BOOT_DRIVER(sunxi_dw_hdmi) = {
 	.id		= UCLASS_DISPLAY,
 	.of_match	= sunxi_dw_hdmi_ids,
 	.probe		= sunxi_dw_hdmi_probe,
+	.remove		= sunxi_dw_hdmi_remove,
 	.of_to_plat	= sunxi_dw_hdmi_of_to_plat,
 	.priv_auto	= sizeof(struct sunxi_dw_hdmi_priv),
 	.ops		= &sunxi_dw_hdmi_ops,
+#if IS_ENABLED(CONFIG_VIDEO_DE2_ASYNC)
+	.flags		= DM_FLAG_OS_PREPARE,
+#endif
 };
+
+#if IS_ENABLED(CONFIG_VIDEO_DE2_ASYNC)
+/* Start the PHY early, so that it comes up while storage is set up */
+static int sunxi_dw_hdmi_early_probe(void)
+{
+	struct udevice *dev;
+
+	uclass_get_device_by_driver(UCLASS_DISPLAY,
+				    DM_DRIVER_GET(sunxi_dw_hdmi), &dev);
+
+	return 0;
+}
+EVENT_SPY_SIMPLE(EVT_DM_POST_INIT_R, sunxi_dw_hdmi_early_probe);
+#endif
@@ -97,7 +97,20 @@ static void vidconsole_newline(struct udevice *dev)
 	if (vid_priv->rot % 2 ?
 	    priv->ycur + priv->x_charsize > vid_priv->xsize :
 	    priv->ycur + priv->y_charsize > vid_priv->ysize) {
-		vidconsole_move_rows(dev, 0, rows, priv->rows - rows);
+		/*
+		 * Move the display start if the device can, rather than
+		 * copying the whole display
+		 */
+		if (vid_priv->rot ||
+		    video_scroll(vid_dev, rows * priv->y_charsize)) {
+			vidconsole_move_rows(dev, 0, rows, priv->rows - rows);
+		} else if (priv->rows * priv->y_charsize < vid_priv->ysize) {
+			/* clear any spare lines below the last row */
+			video_fill_part(vid_dev, 0,
+					priv->rows * priv->y_charsize,
+					vid_priv->xsize, vid_priv->ysize,
+					vid_priv->colour_bg);
+		}
 		for (i = 0; i < rows; i++)
 			vidconsole_set_row(dev, priv->rows - i - 1,
 					   vid_priv->colour_bg);
@@ -761,7 +774,7 @@ UCLASS_DRIVER(vidconsole) = {
 	.per_device_auto	= sizeof(struct vidconsole_priv),
 };
 
-#ifdef CONFIG_VIDEO_COPY
+#if defined(CONFIG_VIDEO_COPY) || defined(CONFIG_VIDEO_DAMAGE)
 int vidconsole_sync_copy(struct udevice *dev, void *from, void *to)
 {
 	struct udevice *vid = dev_get_parent(dev);
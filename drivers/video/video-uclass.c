@@ -367,6 +367,88 @@ void video_set_default_colors(struct udevice *dev, bool invert)
 	priv->colour_bg = video_index_to_colour(priv, back);
 }
 
+#ifdef CONFIG_VIDEO_DAMAGE
+void video_damage(struct udevice *vid, int x, int y, int width, int height)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	struct video_damage *damage = &priv->damage;
+	int xend = min_t(int, x + width, priv->xsize);
+	int yend = min_t(int, y + height, priv->ysize);
+
+	x = max(x, 0);
+	y = max(y, 0);
+	if (x >= xend || y >= yend)
+		return;
+
+	if (!damage->xend) {
+		damage->xstart = x;
+		damage->ystart = y;
+		damage->xend = xend;
+		damage->yend = yend;
+	} else {
+		damage->xstart = min(damage->xstart, x);
+		damage->ystart = min(damage->ystart, y);
+		damage->xend = max(damage->xend, xend);
+		damage->yend = max(damage->yend, yend);
+	}
+}
+
+/* Mark the whole lines covering a region of the frame buffer as damaged */
+static void video_damage_lines(struct udevice *vid, long offset, long size)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	int ystart = offset / priv->line_length;
+	int yend = DIV_ROUND_UP(offset + size, priv->line_length);
+
+	video_damage(vid, 0, ystart, priv->xsize, yend - ystart);
+}
+#endif
+
+#if defined(CONFIG_ARM) && !CONFIG_IS_ENABLED(SYS_DCACHE_OFF)
+static void video_flush_range(void *start, void *end)
+{
+	flush_dcache_range(ALIGN_DOWN((ulong)start, CONFIG_SYS_CACHELINE_SIZE),
+			   ALIGN((ulong)end, CONFIG_SYS_CACHELINE_SIZE));
+}
+
+static void video_flush_dcache(struct video_priv *priv)
+{
+#ifdef CONFIG_VIDEO_DAMAGE
+	struct video_damage *damage = &priv->damage;
+	int pbytes = VNBYTES(priv->bpix);
+	int width = (damage->xend - damage->xstart) * pbytes;
+	void *start;
+	int y;
+
+	/* with less than a byte per pixel, just flush whole lines */
+	if (!pbytes) {
+		video_flush_range(priv->fb + damage->ystart * priv->line_length,
+				  priv->fb + damage->yend * priv->line_length);
+		return;
+	}
+
+	start = priv->fb + damage->ystart * priv->line_length +
+		damage->xstart * pbytes;
+
+	/*
+	 * For a narrow region, flush each line separately rather than
+	 * everything in between
+	 */
+	if (width * 2 < priv->line_length) {
+		for (y = damage->ystart; y < damage->yend; y++) {
+			video_flush_range(start, start + width);
+			start += priv->line_length;
+		}
+	} else {
+		video_flush_range(start, start + (damage->yend - damage->ystart -
+						  1) * priv->line_length + width);
+	}
+#else
+	video_flush_range(priv->fb, priv->fb + priv->fb_size);
+#endif
+}
+#endif
+
 /* Flush video activity to the caches */
 int video_sync(struct udevice *vid, bool force)
 {
@@ -384,25 +466,97 @@ int video_sync(struct udevice *vid, bool force)
 	    get_timer(priv->last_sync) < CONFIG_VIDEO_SYNC_MS)
 		return 0;
 
+#ifdef CONFIG_VIDEO_DAMAGE
+	/* nothing has been drawn since the last sync */
+	if (!priv->damage.xend)
+		return 0;
+#endif
+
 	/*
 	 * flush_dcache_range() is declared in common.h but it seems that some
 	 * architectures do not actually implement it. Is there a way to find
 	 * out whether it exists? For now, ARM is safe.
 	 */
 #if defined(CONFIG_ARM) && !CONFIG_IS_ENABLED(SYS_DCACHE_OFF)
-	if (priv->flush_dcache) {
-		flush_dcache_range((ulong)priv->fb,
-				   ALIGN((ulong)priv->fb + priv->fb_size,
-					 CONFIG_SYS_CACHELINE_SIZE));
-	}
+	if (priv->flush_dcache)
+		video_flush_dcache(priv);
 #elif defined(CONFIG_VIDEO_SANDBOX_SDL)
 	sandbox_sdl_sync(priv->fb);
+#endif
+#ifdef CONFIG_VIDEO_DAMAGE
+	priv->damage.xend = 0;
 #endif
 	priv->last_sync = get_timer(0);
 
 	return 0;
 }
 
+int video_scroll(struct udevice *vid, int lines)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	struct video_ops *ops = video_get_ops(vid);
+	uint yoffset;
+	void *base;
+	int ret;
+
+	if (!priv->pan_max || lines <= 0 || lines >= priv->ysize)
+		return -ENOSYS;
+
+	base = priv->fb - priv->yoffset * priv->line_length;
+	yoffset = priv->yoffset + lines;
+	if (yoffset > priv->pan_max) {
+		/* out of room, so copy what stays visible back to the start */
+		memmove(base, priv->fb + lines * priv->line_length,
+			(priv->ysize - lines) * priv->line_length);
+		yoffset = 0;
+	}
+	priv->fb = base + yoffset * priv->line_length;
+	priv->yoffset = yoffset;
+
+	if (!yoffset) {
+		video_damage(vid, 0, 0, priv->xsize, priv->ysize - lines);
+		video_sync(vid, true);
+	}
+#ifdef CONFIG_VIDEO_DAMAGE
+	else if (priv->damage.xend) {
+		/* anything which scrolled off the top need not be flushed */
+		priv->damage.ystart = max(priv->damage.ystart - lines, 0);
+		priv->damage.yend -= lines;
+		if (priv->damage.yend <= 0)
+			priv->damage.xend = 0;
+	}
+#endif
+
+	ret = ops->set_scanout(vid, yoffset);
+	if (ret) {
+		log_debug("Cannot set scan-out offset (err=%d)\n", ret);
+		priv->pan_max = 0;
+		return ret;
+	}
+
+	return 0;
+}
+
+int video_pan_disable(struct udevice *vid)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	struct video_ops *ops = video_get_ops(vid);
+	void *base;
+
+	priv->pan_max = 0;
+	if (!priv->yoffset)
+		return 0;
+
+	base = priv->fb - priv->yoffset * priv->line_length;
+	memmove(base, priv->fb, priv->fb_size);
+	priv->fb = base;
+	priv->yoffset = 0;
+	video_damage(vid, 0, 0, priv->xsize, priv->ysize);
+	video_sync(vid, true);
+
+	return ops->set_scanout(vid, 0);
+}
+
 void video_sync_all(void)
 {
 	struct udevice *dev;
@@ -451,12 +605,12 @@ int video_get_ysize(struct udevice *dev)
 	return priv->ysize;
 }
 
-#ifdef CONFIG_VIDEO_COPY
+#if defined(CONFIG_VIDEO_COPY) || defined(CONFIG_VIDEO_DAMAGE)
 int video_sync_copy(struct udevice *dev, void *from, void *to)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
 
-	if (priv->copy_fb) {
+	if (priv->copy_fb || IS_ENABLED(CONFIG_VIDEO_DAMAGE)) {
 		long offset, size;
 
 		/* Find the offset of the first byte to copy */
@@ -497,7 +651,11 @@ int video_sync_copy(struct udevice *dev, void *from, void *to)
 			offset = 0;
 		}
 
-		memcpy(priv->copy_fb + offset, priv->fb + offset, size);
+#ifdef CONFIG_VIDEO_DAMAGE
+		video_damage_lines(dev, offset, size);
+#endif
+		if (priv->copy_fb)
+			memcpy(priv->copy_fb + offset, priv->fb + offset, size);
 	}
 
 	return 0;
@@ -559,6 +717,7 @@ static int video_post_probe(struct udevice *dev)
 	struct video_uc_plat *plat = dev_get_uclass_plat(dev);
 	struct video_uc_priv *uc_priv = uclass_get_priv(dev->uclass);
 	struct video_priv *priv = dev_get_uclass_priv(dev);
+	struct video_ops *ops = video_get_ops(dev);
 	char name[30], drv[15], *str;
 	const char *drv_name = drv;
 	struct udevice *cons;
@@ -595,6 +754,11 @@ static int video_post_probe(struct udevice *dev)
 	if (IS_ENABLED(CONFIG_VIDEO_COPY) && plat->copy_base)
 		priv->copy_fb = map_sysmem(plat->copy_base, plat->size);
 
+	/* Use any spare frame-buffer memory for scrolling, if possible */
+	if (ops && ops->set_scanout && !priv->copy_fb &&
+	    plat->size / priv->line_length > priv->ysize)
+		priv->pan_max = plat->size / priv->line_length - priv->ysize;
+
 	/* Set up colors  */
 	video_set_default_colors(dev, false);
 
@@ -53,6 +53,70 @@ static u32 get_bmp_col_rgba8888(struct bmp_color_table_entry *cte)
 		(cte->blue << 16U) | 0xff << 24U);
 }
 
+/**
+ * bmp_palette_to_lut() - Convert a BMP palette into frame-buffer pixel values
+ *
+ * This allows an 8bpp image to be drawn with a single table lookup per pixel
+ * rather than converting the palette entry for every pixel. Entries beyond
+ * the palette are set to zero.
+ *
+ * @lut: Returns the pixel value for each of the 256 possible indices
+ * @bpix: Frame buffer bits-per-pixel, 16 or 32
+ * @eformat: Frame buffer format
+ * @palette: BMP palette table
+ * @colours: Number of entries in @palette
+ */
+static void bmp_palette_to_lut(u32 *lut, uint bpix, enum video_format eformat,
+			       struct bmp_color_table_entry *palette,
+			       uint colours)
+{
+	uint i;
+
+	for (i = 0; i < 256; i++) {
+		struct bmp_color_table_entry *cte = &palette[i];
+
+		if (i >= colours)
+			lut[i] = 0;
+		else if (bpix == 16)
+			lut[i] = get_bmp_col_16bpp(*cte);
+		else if (eformat == VIDEO_X2R10G10B10)
+			lut[i] = get_bmp_col_x2r10g10b10(cte);
+		else if (eformat == VIDEO_RGBA8888)
+			lut[i] = get_bmp_col_rgba8888(cte);
+		else
+			lut[i] = cpu_to_le32(cte->blue | cte->green << 8 |
+					     cte->red << 16);
+	}
+}
+
+/**
+ * bmp_row_24_to_xrgb() - Convert a row of 24bpp BMP pixels to xrgb8888
+ *
+ * This handles four pixels (three words) at a time, to avoid byte writes to
+ * the frame buffer
+ *
+ * @dst: Frame buffer position to write to
+ * @src: BMP pixels, in blue, green, red order
+ * @width: Number of pixels
+ */
+static void bmp_row_24_to_xrgb(u32 *dst, const u8 *src, uint width)
+{
+	uint j;
+
+	for (j = 0; j + 4 <= width; j += 4, src += 12) {
+		u32 a = get_unaligned_le32(src);
+		u32 b = get_unaligned_le32(src + 4);
+		u32 c = get_unaligned_le32(src + 8);
+
+		*dst++ = cpu_to_le32(a & 0xffffff);
+		*dst++ = cpu_to_le32(a >> 24 | (b & 0xffff) << 8);
+		*dst++ = cpu_to_le32(b >> 16 | (c & 0xff) << 16);
+		*dst++ = cpu_to_le32(c >> 8);
+	}
+	for (; j < width; j++, src += 3)
+		*dst++ = cpu_to_le32(src[0] | src[1] << 8 | src[2] << 16);
+}
+
 /**
  * write_pix8() - Write a pixel from a BMP image into the framebuffer
  *
@@ -345,6 +409,29 @@ int video_bmp_display(struct udevice *dev, ulong bmp_image, int x, int y,
 		}
 
 		/* Not compressed */
+		if (bpix == 16 || bpix == 32) {
+			u32 lut[256];
+
+			bmp_palette_to_lut(lut, bpix, eformat, palette,
+					   colours);
+			for (i = 0; i < height; ++i) {
+				u16 *dst16 = (u16 *)fb;
+				u32 *dst32 = (u32 *)fb;
+
+				schedule();
+				if (bpix == 16) {
+					for (j = 0; j < width; j++)
+						dst16[j] = lut[bmap[j]];
+				} else {
+					for (j = 0; j < width; j++)
+						dst32[j] = lut[bmap[j]];
+				}
+				bmap += padded_width;
+				fb -= priv->line_length;
+			}
+			break;
+		}
+
 		byte_width = width * (bpix / 8);
 		if (!byte_width)
 			byte_width = width;
@@ -364,17 +451,21 @@ int video_bmp_display(struct udevice *dev, ulong bmp_image, int x, int y,
 		if (CONFIG_IS_ENABLED(BMP_16BPP)) {
 			for (i = 0; i < height; ++i) {
 				schedule();
-				for (j = 0; j < width; j++) {
-					*fb++ = *bmap++;
-					*fb++ = *bmap++;
-				}
-				bmap += (padded_width - width);
-				fb -= width * 2 + priv->line_length;
+				memcpy(fb, bmap, width * 2);
+				bmap += width * 2 + (padded_width - width);
+				fb -= priv->line_length;
 			}
 		}
 		break;
 	case 24:
-		if (CONFIG_IS_ENABLED(BMP_24BPP)) {
+		if (CONFIG_IS_ENABLED(BMP_24BPP) && bpix == 32 &&
+		    eformat != VIDEO_X2R10G10B10 && eformat != VIDEO_RGBA8888) {
+			for (i = 0; i < height; ++i) {
+				bmp_row_24_to_xrgb((u32 *)fb, bmap, width);
+				bmap += width * 3 + (padded_width - width);
+				fb -= priv->line_length;
+			}
+		} else if (CONFIG_IS_ENABLED(BMP_24BPP)) {
 			for (i = 0; i < height; ++i) {
 				for (j = 0; j < width; j++) {
 					if (bpix == 16) {
@@ -419,7 +510,14 @@ int video_bmp_display(struct udevice *dev, ulong bmp_image, int x, int y,
 		}
 		break;
 	case 32:
-		if (CONFIG_IS_ENABLED(BMP_32BPP)) {
+		if (CONFIG_IS_ENABLED(BMP_32BPP) &&
+		    eformat != VIDEO_X2R10G10B10 && eformat != VIDEO_RGBA8888) {
+			for (i = 0; i < height; ++i) {
+				memcpy(fb, bmap, width * 4);
+				bmap += width * 4;
+				fb -= priv->line_length;
+			}
+		} else if (CONFIG_IS_ENABLED(BMP_32BPP)) {
 			for (i = 0; i < height; ++i) {
 				for (j = 0; j < width; j++) {
 					if (eformat == VIDEO_X2R10G10B10) {
@@ -450,6 +450,18 @@ int env_import(const char *buf, int check, int flags)
 #ifdef CONFIG_SYS_REDUNDAND_ENVIRONMENT
 static unsigned char env_flags;
 
+/* Check whether the first copy has the newer serial, allowing for wrapping */
+static bool env_redund_first_newer(unsigned char flags1, unsigned char flags2)
+{
+	if (flags1 == 255 && flags2 == 0)
+		return false;
+	if (flags2 == 255 && flags1 == 0)
+		return true;
+
+	/* if the flags are equal (almost impossible), use the first */
+	return flags1 >= flags2;
+}
+
 int env_check_redund(const char *buf1, int buf1_read_fail,
 		     const char *buf2, int buf2_read_fail)
 {
@@ -483,16 +495,10 @@ int env_check_redund(const char *buf1, int buf1_read_fail,
 		gd->env_valid = ENV_REDUND;
 	} else {
 		/* both ok - check serial */
-		if (tmp_env1->flags == 255 && tmp_env2->flags == 0)
-			gd->env_valid = ENV_REDUND;
-		else if (tmp_env2->flags == 255 && tmp_env1->flags == 0)
-			gd->env_valid = ENV_VALID;
-		else if (tmp_env1->flags > tmp_env2->flags)
+		if (env_redund_first_newer(tmp_env1->flags, tmp_env2->flags))
 			gd->env_valid = ENV_VALID;
-		else if (tmp_env2->flags > tmp_env1->flags)
+		else
 			gd->env_valid = ENV_REDUND;
-		else /* flags are equal - almost impossible */
-			gd->env_valid = ENV_VALID;
 	}
 
 	return 0;
@@ -524,6 +530,60 @@ int env_import_redund(const char *buf1, int buf1_read_fail,
 
 	return env_import((char *)ep, 0, flags);
 }
+
+int env_load_redund(env_read_copy_t read, void *priv, char *buf1, char *buf2,
+		    int flags)
+{
+	char *bufs[2] = { buf1, buf2 };
+	int state[2];	/* -ve if unreadable, 1 if read in full, else 0 */
+	int i, copy, first;
+
+	for (i = 0; i < 2; i++)
+		state[i] = read(priv, i, true, bufs[i]);
+
+	if (state[0] < 0 && state[1] < 0) {
+		puts("*** Error - No Valid Environment Area found\n");
+		env_set_default("bad env area", 0);
+		return -EIO;
+	} else if (state[0] < 0 || state[1] < 0) {
+		puts("*** Warning - some problems detected ");
+		puts("reading environment; recovered successfully\n");
+	}
+
+	if (state[0] < 0)
+		first = 1;
+	else if (state[1] < 0)
+		first = 0;
+	else
+		first = !env_redund_first_newer(((env_t *)buf1)->flags,
+						((env_t *)buf2)->flags);
+
+	for (i = 0; i < 2; i++) {
+		env_t *ep;
+
+		copy = i ? !first : first;
+		ep = (env_t *)bufs[copy];
+		if (!state[copy] && read(priv, copy, false, ep) < 0) {
+			puts("*** Warning - problem reading environment copy\n");
+			state[copy] = -EIO;
+		}
+		if (state[copy] < 0)
+			continue;
+
+		if (crc32(0, ep->data, ENV_SIZE) == ep->crc) {
+			gd->env_valid = copy ? ENV_REDUND : ENV_VALID;
+			env_flags = ep->flags;
+
+			return env_import((char *)ep, 0, flags);
+		}
+		debug("env: copy %d has a bad CRC\n", copy);
+	}
+
+	gd->env_valid = ENV_INVALID;
+	env_set_default("bad CRC", 0);
+
+	return -ENOMSG;
+}
 #endif /* CONFIG_SYS_REDUNDAND_ENVIRONMENT */
 
 /* Export the environment and generate CRC for it. */
@@ -0,0 +1,403 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Append-only log of environment changes
+ *
+ * Rather than erasing and rewriting the whole environment on every save, the
+ * changes since the last full save are appended to a separate log area as a
+ * series of records, one per variable set or deleted. Loading replays the log
+ * over the stored environment. When the log fills up, the next save writes
+ * the environment in full and starts a new log.
+ *
+ * The log starts with a base record holding the CRC of the environment it
+ * applies to. A log left behind by a full save from elsewhere (e.g. an older
+ * U-Boot or fw_setenv) then no longer matches and is ignored, rather than
+ * being applied to the wrong data.
+ *
+ * To work out what has changed, the environment is exported when it is loaded
+ * and after each save, and the next save compares against that copy.
+ */
+
+#include <env.h>
+#include <env_internal.h>
+#include <errno.h>
+#include <log.h>
+#include <malloc.h>
+#include <search.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <u-boot/crc.h>
+
+enum {
+	ENV_LOG_MAGIC	= 0xe10c,
+	ENV_LOG_ALIGN	= 4,
+	ENV_LOG_MAX_LEN	= 0xffff,
+};
+
+enum env_log_type {
+	ENV_LOG_BASE	= 1,
+	ENV_LOG_SET,
+	ENV_LOG_DELETE,
+};
+
+/**
+ * struct env_log_rec - header of a log record, followed by its payload
+ *
+ * The payload is the name followed by the value, without terminators, and is
+ * padded to ENV_LOG_ALIGN bytes. For a base record it is the CRC of the
+ * environment which the log applies to.
+ *
+ * @magic: ENV_LOG_MAGIC; erased flash (0xffff) marks the end of the log
+ * @type: Record type (enum env_log_type)
+ * @reserved: Zero
+ * @name_len: Length of the name
+ * @value_len: Length of the value
+ * @crc: CRC32 of the header, with this field set to zero, and the payload
+ */
+struct env_log_rec {
+	u16 magic;
+	u8 type;
+	u8 reserved;
+	u16 name_len;
+	u16 value_len;
+	u32 crc;
+};
+
+/* Offset of the end of the log, or -1 if it must be started afresh */
+static int env_log_end = -1;
+
+/* The environment as last loaded or saved, as exported by hexport_r() */
+static char *env_log_snap;
+
+static uint env_log_rec_size(const struct env_log_rec *rec)
+{
+	return ALIGN(sizeof(*rec) + rec->name_len + rec->value_len,
+		     ENV_LOG_ALIGN);
+}
+
+static u32 env_log_rec_crc(const struct env_log_rec *rec, const char *payload)
+{
+	struct env_log_rec hdr = *rec;
+	u32 crc;
+
+	hdr.crc = 0;
+	crc = crc32(0, (void *)&hdr, sizeof(hdr));
+
+	return crc32(crc, (void *)payload, rec->name_len + rec->value_len);
+}
+
+/**
+ * env_log_read() - Read and check the record at a given offset
+ *
+ * @log: Log to read
+ * @offset: Offset of the record
+ * @rec: Returns the record header
+ * @bufp: Returns the payload, allocated with room for two terminators
+ * Return: 0 if OK, -ENOENT at the end of the log, -EBADMSG if the record is
+ *	damaged, other -ve on error
+ */
+static int env_log_read(struct env_log *log, uint offset,
+			struct env_log_rec *rec, char **bufp)
+{
+	uint len;
+	char *buf;
+	int ret;
+
+	if (offset + sizeof(*rec) > log->size)
+		return -ENOENT;
+	ret = log->read(log, offset, sizeof(*rec), rec);
+	if (ret)
+		return ret;
+	if (rec->magic == 0xffff)
+		return -ENOENT;
+	if (rec->magic != ENV_LOG_MAGIC ||
+	    offset + env_log_rec_size(rec) > log->size)
+		return -EBADMSG;
+
+	len = rec->name_len + rec->value_len;
+	buf = malloc(len + 2);
+	if (!buf)
+		return -ENOMEM;
+	ret = log->read(log, offset + sizeof(*rec), len, buf);
+	if (ret) {
+		free(buf);
+		return ret;
+	}
+	if (env_log_rec_crc(rec, buf) != rec->crc) {
+		free(buf);
+		return -EBADMSG;
+	}
+	*bufp = buf;
+
+	return 0;
+}
+
+/* Apply a set or delete record to the environment */
+static void env_log_apply(const struct env_log_rec *rec, char *buf)
+{
+	struct env_entry e, *ep;
+	char *name, *value;
+
+	/* add the terminators, moving the value up to make room */
+	name = buf;
+	value = buf + rec->name_len + 1;
+	memmove(value, buf + rec->name_len, rec->value_len);
+	name[rec->name_len] = '\0';
+	value[rec->value_len] = '\0';
+
+	switch (rec->type) {
+	case ENV_LOG_SET:
+		e.key = name;
+		e.data = value;
+		hsearch_r(e, ENV_ENTER, &ep, &env_htab, H_EXTERNAL);
+		if (!ep)
+			log_warning("Cannot set '%s' from environment log\n",
+				    name);
+		break;
+	case ENV_LOG_DELETE:
+		hdelete_r(name, &env_htab, H_EXTERNAL);
+		break;
+	default:
+		log_debug("Unknown log record type %d\n", rec->type);
+		break;
+	}
+}
+
+/* Record the environment as it is now stored */
+static void env_log_snapshot(const char *data)
+{
+	char *res;
+
+	if (!CONFIG_IS_ENABLED(SAVEENV))
+		return;
+
+	free(env_log_snap);
+	env_log_snap = NULL;
+	res = malloc(ENV_SIZE);
+	if (!res)
+		return;
+	if (data)
+		memcpy(res, data, ENV_SIZE);
+	else if (hexport_r(&env_htab, '\0', 0, &res, ENV_SIZE, 0, NULL) < 0)
+		goto err;
+	env_log_snap = res;
+
+	return;
+err:
+	free(res);
+}
+
+int env_log_replay(struct env_log *log, u32 base_crc)
+{
+	struct env_log_rec rec;
+	char *buf = NULL;
+	int count = 0;
+	uint offset;
+	int ret;
+
+	env_log_end = -1;
+	ret = env_log_read(log, 0, &rec, &buf);
+	if (ret == -ENOENT || ret == -EBADMSG) {
+		log_debug("No environment log\n");
+		goto done;
+	} else if (ret) {
+		return ret;
+	}
+	if (rec.type != ENV_LOG_BASE || rec.value_len != sizeof(base_crc) ||
+	    memcmp(buf, &base_crc, sizeof(base_crc))) {
+		log_debug("Environment log is for a different environment\n");
+		goto done;
+	}
+
+	for (offset = env_log_rec_size(&rec);; offset += env_log_rec_size(&rec)) {
+		free(buf);
+		buf = NULL;
+		ret = env_log_read(log, offset, &rec, &buf);
+		if (ret == -ENOENT) {
+			env_log_end = offset;
+			break;
+		} else if (ret) {
+			log_warning("Environment log damaged at %x (err=%d)\n",
+				    offset, ret);
+			break;
+		}
+		env_log_apply(&rec, buf);
+		count++;
+	}
+	log_debug("Replayed %d records from the environment log\n", count);
+
+done:
+	free(buf);
+	env_log_snapshot(NULL);
+
+	return count;
+}
+
+/**
+ * env_log_add() - Add a record to a buffer of records to be written
+ *
+ * @buf: Buffer to add to
+ * @lenp: Number of bytes used in @buf, updated on success
+ * @space: Size of @buf
+ * @type: Record type (enum env_log_type)
+ * @entry: Exported "name=value" string, with '\\' escapes
+ * Return: 0 if OK, -ENOSPC if there is no room
+ */
+static int env_log_add(char *buf, uint *lenp, uint space,
+		       enum env_log_type type, const char *entry)
+{
+	struct env_log_rec rec = {
+		.magic = ENV_LOG_MAGIC,
+		.type = type,
+	};
+	const char *eq = strchr(entry, '=');
+	const char *s;
+	uint name_len, len;
+	char *p;
+
+	name_len = eq - entry;
+	len = strlen(eq + 1);
+	if (name_len > ENV_LOG_MAX_LEN || len > ENV_LOG_MAX_LEN ||
+	    *lenp + sizeof(rec) + name_len + len > space)
+		return -ENOSPC;
+
+	p = buf + *lenp + sizeof(rec);
+	memcpy(p, entry, name_len);
+	p += name_len;
+	if (type == ENV_LOG_SET) {
+		for (s = eq + 1; *s; s++) {
+			if (*s == '\\' && s[1])
+				s++;
+			*p++ = *s;
+		}
+	}
+	rec.name_len = name_len;
+	rec.value_len = p - (buf + *lenp + sizeof(rec)) - name_len;
+
+	len = env_log_rec_size(&rec);
+	if (*lenp + len > space)
+		return -ENOSPC;
+	memset(p, '\0', buf + *lenp + len - p);
+	rec.crc = env_log_rec_crc(&rec, buf + *lenp + sizeof(rec));
+	memcpy(buf + *lenp, &rec, sizeof(rec));
+	*lenp += len;
+
+	return 0;
+}
+
+/* Compare the names of two exported entries, as strcmp() would the keys */
+static int env_log_cmp(const char *a, const char *b)
+{
+	while (*a != '=' && *a == *b) {
+		a++;
+		b++;
+	}
+
+	return (*a == '=' ? 0 : (uchar)*a) - (*b == '=' ? 0 : (uchar)*b);
+}
+
+int env_log_save(struct env_log *log)
+{
+	char *cur = NULL, *buf = NULL;
+	const char *a, *b;
+	uint len = 0, space;
+	int ret;
+
+	if (env_log_end < 0 || !env_log_snap)
+		return -ENOSPC;
+
+	cur = malloc(ENV_SIZE);
+	space = log->size - env_log_end;
+	buf = malloc(space);
+	if (!cur || !buf) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	if (hexport_r(&env_htab, '\0', 0, &cur, ENV_SIZE, 0, NULL) < 0) {
+		ret = -EIO;
+		goto out;
+	}
+
+	/* both lists are sorted by name, so merge them */
+	for (a = env_log_snap, b = cur, ret = 0; !ret && (*a || *b);) {
+		int cmp;
+
+		if (!*a)
+			cmp = 1;
+		else if (!*b)
+			cmp = -1;
+		else
+			cmp = env_log_cmp(a, b);
+
+		if (cmp < 0) {
+			ret = env_log_add(buf, &len, space, ENV_LOG_DELETE, a);
+			a += strlen(a) + 1;
+		} else if (cmp > 0) {
+			ret = env_log_add(buf, &len, space, ENV_LOG_SET, b);
+			b += strlen(b) + 1;
+		} else {
+			if (strcmp(a, b))
+				ret = env_log_add(buf, &len, space, ENV_LOG_SET,
+						  b);
+			a += strlen(a) + 1;
+			b += strlen(b) + 1;
+		}
+	}
+	if (ret)
+		goto out;
+
+	if (len) {
+		ret = log->write(log, env_log_end, len, buf);
+		if (ret) {
+			/* the log may now be damaged, so start again next time */
+			env_log_end = -1;
+			goto out;
+		}
+		env_log_end += len;
+	}
+	log_debug("Added %u bytes to the environment log\n", len);
+
+	free(env_log_snap);
+	env_log_snap = cur;
+	cur = NULL;
+out:
+	free(cur);
+	free(buf);
+
+	return ret;
+}
+
+int env_log_reset(struct env_log *log, const env_t *env)
+{
+	struct {
+		struct env_log_rec rec;
+		u32 base_crc;
+	} base = {
+		.rec = {
+			.magic = ENV_LOG_MAGIC,
+			.type = ENV_LOG_BASE,
+			.value_len = sizeof(u32),
+		},
+		.base_crc = env->crc,
+	};
+	int ret;
+
+	ret = env_log_erase(log);
+	if (ret)
+		return ret;
+
+	base.rec.crc = env_log_rec_crc(&base.rec, (char *)&base.base_crc);
+	ret = log->write(log, 0, sizeof(base), &base);
+	if (ret)
+		return ret;
+	env_log_end = sizeof(base);
+	env_log_snapshot((char *)env->data);
+
+	return 0;
+}
+
+int env_log_erase(struct env_log *log)
+{
+	env_log_end = -1;
+
+	return log->erase(log);
+}
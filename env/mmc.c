@@ -449,11 +449,36 @@ static int env_mmc_load(void)
 	return 0;
 }
 #elif defined(CONFIG_SYS_REDUNDAND_ENVIRONMENT)
+/**
+ * struct env_mmc_copies - location of the two environment copies
+ *
+ * @mmc: MMC device holding the environment
+ * @offset: Byte offset of each copy
+ */
+struct env_mmc_copies {
+	struct mmc *mmc;
+	u32 offset[2];
+};
+
+static int env_mmc_read_copy(void *priv, int copy, bool hdr_only, void *buf)
+{
+	struct env_mmc_copies *copies = priv;
+	int ret;
+
+	if (IS_ENABLED(ENV_MMC_HWPART_REDUND)) {
+		ret = mmc_set_env_part(copies->mmc, copy + 1);
+		if (ret)
+			return ret;
+	}
+
+	return read_env(copies->mmc, hdr_only ? ENV_HDR_SIZE : CONFIG_ENV_SIZE,
+			copies->offset[copy], buf);
+}
+
 static int env_mmc_load(void)
 {
+	struct env_mmc_copies copies;
 	struct mmc *mmc;
-	u32 offset1, offset2;
-	int read1_fail = 0, read2_fail = 0;
 	int ret;
 	int dev = mmc_get_env_dev();
 	const char *errmsg = NULL;
@@ -471,30 +496,15 @@ static int env_mmc_load(void)
 		goto err;
 	}
 
-	if (mmc_get_env_addr(mmc, 0, &offset1) ||
-	    mmc_get_env_addr(mmc, 1, &offset2)) {
+	copies.mmc = mmc;
+	if (mmc_get_env_addr(mmc, 0, &copies.offset[0]) ||
+	    mmc_get_env_addr(mmc, 1, &copies.offset[1])) {
 		ret = -EIO;
 		goto fini;
 	}
 
-	if (IS_ENABLED(ENV_MMC_HWPART_REDUND)) {
-		ret = mmc_set_env_part(mmc, 1);
-		if (ret)
-			goto fini;
-	}
-
-	read1_fail = read_env(mmc, CONFIG_ENV_SIZE, offset1, tmp_env1);
-
-	if (IS_ENABLED(ENV_MMC_HWPART_REDUND)) {
-		ret = mmc_set_env_part(mmc, 2);
-		if (ret)
-			goto fini;
-	}
-
-	read2_fail = read_env(mmc, CONFIG_ENV_SIZE, offset2, tmp_env2);
-
-	ret = env_import_redund((char *)tmp_env1, read1_fail, (char *)tmp_env2,
-				read2_fail, H_EXTERNAL);
+	ret = env_load_redund(env_mmc_read_copy, &copies, (char *)tmp_env1,
+			      (char *)tmp_env2, H_EXTERNAL);
 	printf("Reading from %sMMC(%d)... ", gd->env_valid == ENV_REDUND ? "redundant " : "", dev);
 
 fini:
@@ -265,6 +265,31 @@ static int readenv(size_t offset, u_char *buf)
 
 	return 0;
 }
+
+/* Read the first page of the environment, which holds its header */
+static int __maybe_unused readenv_hdr(size_t offset, u_char *buf)
+{
+	size_t end = offset + CONFIG_ENV_RANGE;
+	struct mtd_info *mtd;
+	size_t len;
+
+	mtd = get_nand_dev_by_index(0);
+	if (!mtd)
+		return 1;
+
+	len = min((size_t)mtd->writesize, (size_t)CONFIG_ENV_SIZE);
+	for (; offset < end; offset += mtd->erasesize) {
+		if (nand_block_isbad(mtd, offset))
+			continue;
+		if (nand_read_skip_bad(mtd, offset, &len, NULL, mtd->size,
+				       buf))
+			return 1;
+
+		return 0;
+	}
+
+	return 1;
+}
 #endif /* #if defined(CONFIG_XPL_BUILD) */
 
 #ifdef CONFIG_ENV_OFFSET_OOB
@@ -300,12 +325,27 @@ int get_nand_env_oob(struct mtd_info *mtd, unsigned long *result)
 #endif
 
 #ifdef CONFIG_ENV_OFFSET_REDUND
+static int __maybe_unused env_nand_read_copy(void *priv, int copy,
+					     bool hdr_only, void *buf)
+{
+	size_t offset = copy ? CONFIG_ENV_OFFSET_REDUND : CONFIG_ENV_OFFSET;
+
+#if !defined(CONFIG_XPL_BUILD)
+	if (hdr_only)
+		return readenv_hdr(offset, buf) ? -EIO : 0;
+#endif
+	/* the SPL loader works in whole pages, so just read everything */
+	if (readenv(offset, buf))
+		return -EIO;
+
+	return hdr_only;
+}
+
 static int env_nand_load(void)
 {
 #if defined(ENV_IS_EMBEDDED)
 	return 0;
 #else
-	int read1_fail, read2_fail;
 	env_t *tmp_env1, *tmp_env2;
 	int ret = 0;
 
@@ -318,11 +358,8 @@ static int env_nand_load(void)
 		goto done;
 	}
 
-	read1_fail = readenv(CONFIG_ENV_OFFSET, (u_char *) tmp_env1);
-	read2_fail = readenv(CONFIG_ENV_OFFSET_REDUND, (u_char *) tmp_env2);
-
-	ret = env_import_redund((char *)tmp_env1, read1_fail, (char *)tmp_env2,
-				read2_fail, H_EXTERNAL);
+	ret = env_load_redund(env_nand_read_copy, NULL, (char *)tmp_env1,
+			      (char *)tmp_env2, H_EXTERNAL);
 
 done:
 	free(tmp_env1);
@@ -74,6 +74,102 @@ static int setup_flash_device(struct spi_flash **env_flash)
 	return 0;
 }
 
+#if defined(CONFIG_ENV_LOG)
+static int env_sf_log_read(struct env_log *log, uint offset, uint len,
+			   void *buf)
+{
+	return spi_flash_read(log->priv, CONFIG_ENV_LOG_OFFSET + offset, len,
+			      buf);
+}
+
+static int env_sf_log_write(struct env_log *log, uint offset, uint len,
+			    const void *buf)
+{
+	return spi_flash_write(log->priv, CONFIG_ENV_LOG_OFFSET + offset, len,
+			       buf);
+}
+
+static int env_sf_log_erase(struct env_log *log)
+{
+	return spi_flash_erase(log->priv, CONFIG_ENV_LOG_OFFSET,
+			       CONFIG_ENV_LOG_SIZE);
+}
+
+static void env_sf_log_setup(struct env_log *log, struct spi_flash *flash)
+{
+	log->read = env_sf_log_read;
+	log->write = env_sf_log_write;
+	log->erase = env_sf_log_erase;
+	log->priv = flash;
+	log->size = CONFIG_ENV_LOG_SIZE;
+}
+
+static int env_sf_log_load(struct spi_flash *flash, const env_t *env)
+{
+	struct env_log log;
+	int ret;
+
+	env_sf_log_setup(&log, flash);
+	ret = env_log_replay(&log, env->crc);
+
+	return ret < 0 ? ret : 0;
+}
+
+static int env_sf_log_save(struct spi_flash *flash)
+{
+	struct env_log log;
+	int ret;
+
+	env_sf_log_setup(&log, flash);
+	puts("Writing to SPI flash log...");
+	ret = env_log_save(&log);
+	if (ret == -ENOSPC)
+		puts("full\n");
+	else if (!ret)
+		puts("done\n");
+
+	return ret;
+}
+
+static int env_sf_log_reset(struct spi_flash *flash, const env_t *env)
+{
+	struct env_log log;
+
+	env_sf_log_setup(&log, flash);
+
+	return env_log_reset(&log, env);
+}
+
+static int env_sf_log_erase_all(struct spi_flash *flash)
+{
+	struct env_log log;
+
+	env_sf_log_setup(&log, flash);
+
+	return env_log_erase(&log);
+}
+#else
+static inline int env_sf_log_load(struct spi_flash *flash, const env_t *env)
+{
+	return 0;
+}
+
+static inline int env_sf_log_save(struct spi_flash *flash)
+{
+	return -ENOSPC;
+}
+
+static inline int env_sf_log_reset(struct spi_flash *flash, const env_t *env)
+{
+	return 0;
+}
+
+static inline int env_sf_log_erase_all(struct spi_flash *flash)
+{
+	return 0;
+}
+#endif /* CONFIG_ENV_LOG */
+
 #if defined(CONFIG_ENV_OFFSET_REDUND)
 static int env_sf_save(void)
 {
@@ -161,10 +257,18 @@ done:
 	return ret;
 }
 
+static int env_sf_read_copy(void *priv, int copy, bool hdr_only, void *buf)
+{
+	struct spi_flash *flash = priv;
+
+	return spi_flash_read(flash, copy ? CONFIG_ENV_OFFSET_REDUND :
+			      CONFIG_ENV_OFFSET,
+			      hdr_only ? ENV_HDR_SIZE : CONFIG_ENV_SIZE, buf);
+}
+
 static int env_sf_load(void)
 {
 	int ret;
-	int read1_fail, read2_fail;
 	env_t *tmp_env1, *tmp_env2;
 	struct spi_flash *env_flash;
 
@@ -182,13 +286,8 @@ static int env_sf_load(void)
 	if (ret)
 		goto out;
 
-	read1_fail = spi_flash_read(env_flash, CONFIG_ENV_OFFSET,
-				    CONFIG_ENV_SIZE, tmp_env1);
-	read2_fail = spi_flash_read(env_flash, CONFIG_ENV_OFFSET_REDUND,
-				    CONFIG_ENV_SIZE, tmp_env2);
-
-	ret = env_import_redund((char *)tmp_env1, read1_fail, (char *)tmp_env2,
-				read2_fail, H_EXTERNAL);
+	ret = env_load_redund(env_sf_read_copy, env_flash, (char *)tmp_env1,
+			      (char *)tmp_env2, H_EXTERNAL);
 
 	spi_flash_free(env_flash);
 out:
@@ -211,6 +310,11 @@ static int env_sf_save(void)
 	if (ret)
 		return ret;
 
+	/* Append just the changes if possible, else save in full */
+	ret = env_sf_log_save(env_flash);
+	if (ret != -ENOSPC)
+		goto done;
+
 	if (IS_ENABLED(CONFIG_ENV_SECT_SIZE_AUTO))
 		sect_size = env_flash->mtd.erasesize;
 
@@ -255,7 +359,10 @@ static int env_sf_save(void)
 			goto done;
 	}
 
-	ret = 0;
+	ret = env_sf_log_reset(env_flash, &env_new);
+	if (ret)
+		goto done;
+
 	puts("done\n");
 
 done:
@@ -291,8 +398,10 @@ static int env_sf_load(void)
 	}
 
 	ret = env_import(buf, 1, H_EXTERNAL);
-	if (!ret)
+	if (!ret) {
 		gd->env_valid = ENV_VALID;
+		ret = env_sf_log_load(env_flash, (env_t *)buf);
+	}
 
 err_read:
 	spi_flash_free(env_flash);
@@ -320,6 +429,8 @@ static int env_sf_erase(void)
 
 	if (ENV_OFFSET_REDUND != OFFSET_INVALID)
 		ret = spi_flash_write(env_flash, ENV_OFFSET_REDUND, CONFIG_ENV_SIZE, &env);
+	else
+		ret = env_sf_log_erase_all(env_flash);
 
 done:
 	spi_flash_free(env_flash);
@@ -91,9 +91,27 @@ struct btrfs_root {
 	u32 type;
 	u64 last_inode_alloc;
 
+	/* Regular file extents looked up so far, see btrfs_file_read() */
+	struct cache_tree file_extents;
+	unsigned int nr_file_extents;
+
 	struct rb_node rb_node;
 };
 
+/*
+ * Cached copy of a regular/prealloc file extent item. @ce.objectid is the
+ * inode number, @ce.start and @ce.size the file range the extent covers.
+ */
+struct btrfs_file_extent_cache {
+	struct cache_extent ce;
+	u64 disk_bytenr;
+	u64 disk_num_bytes;
+	u64 offset;
+	u64 ram_bytes;
+	u8 type;
+	u8 compression;
+};
+
 struct btrfs_trans_handle;
 struct btrfs_device;
 struct btrfs_fs_devices;
@@ -1234,6 +1252,7 @@ int btrfs_read_extent_inline(struct btrfs_path *path,
 int btrfs_read_extent_reg(struct btrfs_path *path,
 			  struct btrfs_file_extent_item *fi, u64 offset,
 			  int len, char *dest);
+void btrfs_free_file_extent_cache(struct btrfs_root *root);
 
 /* ctree.c */
 int btrfs_comp_cpu_keys(const struct btrfs_key *k1, const struct btrfs_key *k2);
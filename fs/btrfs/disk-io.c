@@ -587,6 +587,8 @@ void btrfs_setup_root(struct btrfs_root *root, struct btrfs_fs_info *fs_info,
 	root->objectid = objectid;
 	root->last_trans = 0;
 	root->last_inode_alloc = 0;
+	cache_tree_init(&root->file_extents);
+	root->nr_file_extents = 0;
 
 	memset(&root->root_key, 0, sizeof(root->root_key));
 	memset(&root->root_item, 0, sizeof(root->root_item));
@@ -619,6 +621,7 @@ int btrfs_free_fs_root(struct btrfs_root *root)
 {
 	if (root->node)
 		free_extent_buffer(root->node);
+	btrfs_free_file_extent_cache(root);
 	kfree(root);
 	return 0;
 }
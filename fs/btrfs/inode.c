@@ -408,8 +408,83 @@ out:
 	return ret;
 }
 
+/* Upper bound of btrfs_root::file_extents entries */
+#define BTRFS_FILE_EXTENT_CACHE_MAX	8192
+
+static void free_file_extent(struct cache_extent *ce)
+{
+	free(container_of(ce, struct btrfs_file_extent_cache, ce));
+}
+
+FREE_EXTENT_CACHE_BASED_TREE(file_extent_cache, free_file_extent);
+
+void btrfs_free_file_extent_cache(struct btrfs_root *root)
+{
+	free_file_extent_cache_tree(&root->file_extents);
+	root->nr_file_extents = 0;
+}
+
+static void fill_file_extent(struct extent_buffer *leaf, int slot,
+			     struct btrfs_file_extent_cache *fe)
+{
+	struct btrfs_file_extent_item *fi;
+	struct btrfs_key key;
+
+	btrfs_item_key_to_cpu(leaf, &key, slot);
+	fi = btrfs_item_ptr(leaf, slot, struct btrfs_file_extent_item);
+
+	fe->ce.objectid = key.objectid;
+	fe->ce.start = key.offset;
+	fe->ce.size = btrfs_file_extent_num_bytes(leaf, fi);
+	fe->disk_bytenr = btrfs_file_extent_disk_bytenr(leaf, fi);
+	fe->disk_num_bytes = btrfs_file_extent_disk_num_bytes(leaf, fi);
+	fe->offset = btrfs_file_extent_offset(leaf, fi);
+	fe->ram_bytes = btrfs_file_extent_ram_bytes(leaf, fi);
+	fe->type = btrfs_file_extent_type(leaf, fi);
+	fe->compression = btrfs_file_extent_compression(leaf, fi);
+}
+
 /*
- * Read out regular extent.
+ * Remember the regular file extents of @ino from the current slot of @path to
+ * the end of its leaf, so reading them does not need another tree search.
+ */
+static void cache_file_extents(struct btrfs_root *root,
+			       struct btrfs_path *path, u64 ino)
+{
+	struct extent_buffer *leaf = path->nodes[0];
+	struct btrfs_file_extent_cache *fe;
+	struct btrfs_file_extent_item *fi;
+	struct btrfs_key key;
+	int slot;
+
+	for (slot = path->slots[0]; slot < btrfs_header_nritems(leaf); slot++) {
+		if (root->nr_file_extents >= BTRFS_FILE_EXTENT_CACHE_MAX)
+			return;
+
+		btrfs_item_key_to_cpu(leaf, &key, slot);
+		if (key.objectid != ino || key.type != BTRFS_EXTENT_DATA_KEY)
+			return;
+
+		fi = btrfs_item_ptr(leaf, slot, struct btrfs_file_extent_item);
+		if (btrfs_file_extent_type(leaf, fi) == BTRFS_FILE_EXTENT_INLINE ||
+		    !btrfs_file_extent_num_bytes(leaf, fi))
+			continue;
+
+		fe = malloc(sizeof(*fe));
+		if (!fe)
+			return;
+
+		fill_file_extent(leaf, slot, fe);
+		if (insert_cache_extent2(&root->file_extents, &fe->ce)) {
+			free(fe);
+			continue;
+		}
+		root->nr_file_extents++;
+	}
+}
+
+/*
+ * Read out regular extent @fe.
  *
  * Truncating should be handled by the caller.
  *
@@ -417,15 +492,10 @@ out:
  * Return the number of bytes read.
  * Return <0 for error.
  */
-int btrfs_read_extent_reg(struct btrfs_path *path,
-			  struct btrfs_file_extent_item *fi, u64 offset,
-			  int len, char *dest)
+static int read_file_extent(struct btrfs_fs_info *fs_info,
+			    struct btrfs_file_extent_cache *fe, u64 offset,
+			    int len, char *dest)
 {
-	struct extent_buffer *leaf = path->nodes[0];
-	struct btrfs_fs_info *fs_info = leaf->fs_info;
-	struct btrfs_key key;
-	u64 extent_num_bytes;
-	u64 disk_bytenr;
 	u64 read;
 	char *cbuf = NULL;
 	char *dbuf = NULL;
@@ -434,29 +504,23 @@ int btrfs_read_extent_reg(struct btrfs_path *path,
 	bool finished = false;
 	int num_copies;
 	int i;
-	int slot = path->slots[0];
 	int ret;
 
-	btrfs_item_key_to_cpu(leaf, &key, slot);
-	extent_num_bytes = btrfs_file_extent_num_bytes(leaf, fi);
 	ASSERT(IS_ALIGNED(offset, fs_info->sectorsize) &&
 	       IS_ALIGNED(len, fs_info->sectorsize));
-	ASSERT(offset >= key.offset &&
-	       offset + len <= key.offset + extent_num_bytes);
+	ASSERT(offset >= fe->ce.start &&
+	       offset + len <= fe->ce.start + fe->ce.size);
 
 	/* Preallocated or hole , fill @dest with zero */
-	if (btrfs_file_extent_type(leaf, fi) == BTRFS_FILE_EXTENT_PREALLOC ||
-	    btrfs_file_extent_disk_bytenr(leaf, fi) == 0) {
+	if (fe->type == BTRFS_FILE_EXTENT_PREALLOC || fe->disk_bytenr == 0) {
 		memset(dest, 0, len);
 		return len;
 	}
 
-	if (btrfs_file_extent_compression(leaf, fi) == BTRFS_COMPRESS_NONE) {
+	if (fe->compression == BTRFS_COMPRESS_NONE) {
 		u64 logical;
 
-		logical = btrfs_file_extent_disk_bytenr(leaf, fi) +
-			  btrfs_file_extent_offset(leaf, fi) +
-			  offset - key.offset;
+		logical = fe->disk_bytenr + fe->offset + offset - fe->ce.start;
 		read = len;
 
 		num_copies = btrfs_num_copies(fs_info, logical, len);
@@ -472,13 +536,16 @@ int btrfs_read_extent_reg(struct btrfs_path *path,
 		return len;
 	}
 
-	csize = btrfs_file_extent_disk_num_bytes(leaf, fi);
-	dsize = btrfs_file_extent_ram_bytes(leaf, fi);
-	disk_bytenr = btrfs_file_extent_disk_bytenr(leaf, fi);
-	num_copies = btrfs_num_copies(fs_info, disk_bytenr, csize);
+	csize = fe->disk_num_bytes;
+	dsize = fe->ram_bytes;
+	num_copies = btrfs_num_copies(fs_info, fe->disk_bytenr, csize);
 
 	cbuf = malloc_cache_aligned(csize);
-	dbuf = malloc_cache_aligned(dsize);
+	/* When the whole extent is wanted, decompress it in place */
+	if (!fe->offset && offset == fe->ce.start && len == dsize)
+		dbuf = dest;
+	else
+		dbuf = malloc_cache_aligned(dsize);
 	if (!cbuf || !dbuf) {
 		ret = -ENOMEM;
 		goto out;
@@ -486,7 +553,7 @@ int btrfs_read_extent_reg(struct btrfs_path *path,
 	/* For compressed extent, we must read the whole on-disk extent */
 	for (i = 1; i <= num_copies; i++) {
 		read = csize;
-		ret = read_extent_data(fs_info, cbuf, disk_bytenr,
+		ret = read_extent_data(fs_info, cbuf, fe->disk_bytenr,
 				       &read, i);
 		if (ret < 0 || read != csize)
 			continue;
@@ -498,8 +565,7 @@ int btrfs_read_extent_reg(struct btrfs_path *path,
 		goto out;
 	}
 
-	ret = btrfs_decompress(btrfs_file_extent_compression(leaf, fi), cbuf,
-			       csize, dbuf, dsize);
+	ret = btrfs_decompress(fe->compression, cbuf, csize, dbuf, dsize);
 	if (ret < 0) {
 		ret = -EIO;
 		goto out;
@@ -511,16 +577,36 @@ int btrfs_read_extent_reg(struct btrfs_path *path,
 	if (ret < dsize)
 		memset(dbuf + ret, 0, dsize - ret);
 	/* Then copy the needed part */
-	memcpy(dest,
-	       dbuf + btrfs_file_extent_offset(leaf, fi) + offset - key.offset,
-	       len);
+	if (dbuf != dest)
+		memcpy(dest, dbuf + fe->offset + offset - fe->ce.start, len);
 	ret = len;
 out:
 	free(cbuf);
-	free(dbuf);
+	if (dbuf != dest)
+		free(dbuf);
 	return ret;
 }
 
+/*
+ * Read out regular extent.
+ *
+ * Truncating should be handled by the caller.
+ *
+ * @offset and @len should not cross the extent boundary.
+ * Return the number of bytes read.
+ * Return <0 for error.
+ */
+int btrfs_read_extent_reg(struct btrfs_path *path,
+			  struct btrfs_file_extent_item *fi, u64 offset,
+			  int len, char *dest)
+{
+	struct extent_buffer *leaf = path->nodes[0];
+	struct btrfs_file_extent_cache fe;
+
+	fill_file_extent(leaf, path->slots[0], &fe);
+	return read_file_extent(leaf->fs_info, &fe, offset, len, dest);
+}
+
 /*
  * Get the first file extent that covers bytenr @file_offset.
  *
@@ -667,7 +753,6 @@ int btrfs_file_read(struct btrfs_root *root, u64 ino, u64 file_offset, u64 len,
 	struct btrfs_fs_info *fs_info = root->fs_info;
 	struct btrfs_file_extent_item *fi;
 	struct btrfs_path path;
-	struct btrfs_key key;
 	u64 aligned_start = round_down(file_offset, fs_info->sectorsize);
 	u64 aligned_end = round_down(file_offset + len, fs_info->sectorsize);
 	u64 next_offset;
@@ -707,9 +792,18 @@ int btrfs_file_read(struct btrfs_root *root, u64 ino, u64 file_offset, u64 len,
 
 	/* Read the aligned part */
 	while (cur < aligned_end) {
-		u64 extent_num_bytes;
+		struct btrfs_file_extent_cache *fe, tmp;
+		struct cache_extent *ce;
+		u64 read_len;
 		u8 type;
 
+		ce = lookup_cache_extent2(&root->file_extents, ino, cur, 1);
+		if (ce) {
+			fe = container_of(ce, struct btrfs_file_extent_cache,
+					  ce);
+			goto read;
+		}
+
 		btrfs_release_path(&path);
 		ret = lookup_data_extent(root, &path, ino, cur, &next_offset);
 		if (ret < 0)
@@ -731,29 +825,32 @@ int btrfs_file_read(struct btrfs_root *root, u64 ino, u64 file_offset, u64 len,
 		}
 		fi = btrfs_item_ptr(path.nodes[0], path.slots[0],
 				    struct btrfs_file_extent_item);
-		btrfs_item_key_to_cpu(path.nodes[0], &key, path.slots[0]);
 		type = btrfs_file_extent_type(path.nodes[0], fi);
 		if (type == BTRFS_FILE_EXTENT_INLINE) {
 			ret = btrfs_read_extent_inline(&path, fi, dest);
 			goto out;
 		}
+
+		/* Following extents in this leaf are then served from cache */
+		cache_file_extents(root, &path, ino);
+		fe = &tmp;
+		fill_file_extent(path.nodes[0], path.slots[0], fe);
+read:
 		/* Skip holes, as we have zeroed the dest */
-		if (type == BTRFS_FILE_EXTENT_PREALLOC ||
-		    btrfs_file_extent_disk_bytenr(path.nodes[0], fi) == 0) {
-			cur = key.offset + btrfs_file_extent_num_bytes(
-					path.nodes[0], fi);
+		if (fe->type == BTRFS_FILE_EXTENT_PREALLOC ||
+		    fe->disk_bytenr == 0) {
+			cur = fe->ce.start + fe->ce.size;
 			continue;
 		}
 
 		/* Read the remaining part of the extent */
-		extent_num_bytes = btrfs_file_extent_num_bytes(path.nodes[0],
-							       fi);
-		ret = btrfs_read_extent_reg(&path, fi, cur,
-				min(extent_num_bytes, aligned_end - cur),
-				dest + cur - file_offset);
+		read_len = min(fe->ce.start + fe->ce.size - cur,
+			       aligned_end - cur);
+		ret = read_file_extent(fs_info, fe, cur, read_len,
+				       dest + cur - file_offset);
 		if (ret < 0)
 			goto out;
-		cur += min(extent_num_bytes, aligned_end - cur);
+		cur += read_len;
 	}
 
 	/* Read the tailing unaligned part*/
@@ -1,7 +1,14 @@
 // SPDX-License-Identifier: GPL-2.0+
+#include <linux/sizes.h>
 #include "internal.h"
 #include "decompress.h"
 
+/* Largest run of compressed data fetched with a single device request */
+#define Z_EROFS_READ_WINDOW		SZ_1M
+/* Decoded extents kept for reads that only need part of one */
+#define Z_EROFS_PCLUSTER_CACHE_SIZE	4
+#define Z_EROFS_PCLUSTER_CACHE_MAX	SZ_256K
+
 static int erofs_map_blocks_flatmode(struct erofs_inode *inode,
 				     struct erofs_map_blocks *map,
 				     int flags)
@@ -55,7 +62,7 @@ int erofs_map_blocks(struct erofs_inode *inode,
 {
 	struct erofs_inode *vi = inode;
 	struct erofs_inode_chunk_index *idx;
-	u8 buf[EROFS_MAX_BLOCK_SIZE];
+	u8 *buf = (u8 *)map->mpage;
 	u64 chunknr;
 	unsigned int unit;
 	erofs_off_t pos;
@@ -81,9 +88,14 @@ int erofs_map_blocks(struct erofs_inode *inode,
 	pos = roundup(iloc(vi->nid) + vi->inode_isize +
 		      vi->xattr_isize, unit) + unit * chunknr;
 
-	err = erofs_blk_read(buf, erofs_blknr(pos), 1);
-	if (err < 0)
-		return -EIO;
+	/* consecutive chunks mostly share their index block */
+	if (map->index != erofs_blknr(pos)) {
+		err = erofs_blk_read(buf, erofs_blknr(pos), 1);
+		if (err < 0)
+			return -EIO;
+		map->index = erofs_blknr(pos);
+	}
+	err = 0;
 
 	map->m_la = chunknr << vi->u.chunkbits;
 	map->m_plen = min_t(erofs_off_t, 1UL << vi->u.chunkbits,
@@ -167,12 +179,36 @@ int erofs_read_one_data(struct erofs_map_blocks *map, char *buffer, u64 offset,
 	return 0;
 }
 
+/* Physically contiguous extents, read into the caller buffer at once */
+struct erofs_read_run {
+	char *buf;
+	erofs_off_t pa;
+	erofs_off_t len;
+	unsigned int deviceid;
+};
+
+static int erofs_flush_run(struct erofs_read_run *run)
+{
+	int ret;
+
+	if (!run->len)
+		return 0;
+
+	ret = erofs_dev_read(run->deviceid, run->buf, run->pa, run->len);
+	run->len = 0;
+	if (ret < 0)
+		return -EIO;
+	return 0;
+}
+
 static int erofs_read_raw_data(struct erofs_inode *inode, char *buffer,
 			       erofs_off_t size, erofs_off_t offset)
 {
 	struct erofs_map_blocks map = {
 		.index = UINT_MAX,
 	};
+	struct erofs_read_run run = { 0 };
+	struct erofs_map_dev mdev;
 	int ret;
 	erofs_off_t ptr = offset;
 
@@ -208,19 +244,134 @@ static int erofs_read_raw_data(struct erofs_inode *inode, char *buffer,
 			map.m_la = ptr;
 		}
 
-		ret = erofs_read_one_data(&map, estart, moff, eend - map.m_la);
+		mdev = (struct erofs_map_dev) {
+			.m_deviceid = map.m_deviceid,
+			.m_pa = map.m_pa + moff,
+		};
+		ret = erofs_map_dev(&mdev);
 		if (ret)
 			return ret;
+
+		/* extend the pending read if this extent directly follows it */
+		if (run.len && run.deviceid == mdev.m_deviceid &&
+		    run.pa + run.len == mdev.m_pa &&
+		    run.buf + run.len == estart) {
+			run.len += eend - map.m_la;
+		} else {
+			ret = erofs_flush_run(&run);
+			if (ret)
+				return ret;
+			run = (struct erofs_read_run) {
+				.buf = estart,
+				.pa = mdev.m_pa,
+				.len = eend - map.m_la,
+				.deviceid = mdev.m_deviceid,
+			};
+		}
 		ptr = eend;
 	}
+	return erofs_flush_run(&run);
+}
+
+/* Compressed data around the pclusters being decoded */
+struct z_erofs_read_window {
+	char *buf;
+	erofs_off_t bufsize;
+	erofs_off_t pa, len;
+};
+
+/*
+ * Return the compressed data of the pcluster at [pa, pa + plen). Extents are
+ * decoded from the end of the request backwards and their pclusters are laid
+ * out in file order, so up to 'ahead' bytes preceding it (capped by
+ * Z_EROFS_READ_WINDOW) are fetched with the same device request.
+ */
+static int z_erofs_read_raw(struct z_erofs_read_window *win, erofs_off_t pa,
+			    erofs_off_t plen, erofs_off_t ahead, char **raw)
+{
+	erofs_off_t len;
+	char *buf;
+	int ret;
+
+	if (win->len && pa >= win->pa && pa + plen <= win->pa + win->len) {
+		*raw = win->buf + (pa - win->pa);
+		return 0;
+	}
+
+	ahead = min3(ahead, pa, plen < Z_EROFS_READ_WINDOW ?
+			      Z_EROFS_READ_WINDOW - plen : 0);
+	ahead = round_down(ahead, erofs_blksiz());
+	len = plen + ahead;
+
+	if (len > win->bufsize) {
+		buf = realloc(win->buf, len);
+		if (!buf)
+			return -ENOMEM;
+		win->buf = buf;
+		win->bufsize = len;
+	}
+
+	win->len = 0;
+	ret = erofs_dev_read(0, win->buf, pa - ahead, len);
+	if (ret < 0)
+		return ret;
+
+	win->pa = pa - ahead;
+	win->len = len;
+	*raw = win->buf + ahead;
 	return 0;
 }
 
-int z_erofs_read_one_data(struct erofs_inode *inode,
-			  struct erofs_map_blocks *map, char *raw, char *buffer,
-			  erofs_off_t skip, erofs_off_t length, bool trimmed)
+static struct z_erofs_pcluster_cache {
+	erofs_nid_t nid;
+	erofs_off_t la;
+	erofs_off_t len;
+	char *data;
+} z_erofs_pcache[Z_EROFS_PCLUSTER_CACHE_SIZE];
+static unsigned int z_erofs_pcache_next;
+
+void z_erofs_drop_pcluster_cache(void)
+{
+	int i;
+
+	for (i = 0; i < Z_EROFS_PCLUSTER_CACHE_SIZE; i++) {
+		free(z_erofs_pcache[i].data);
+		z_erofs_pcache[i] = (struct z_erofs_pcluster_cache) { 0 };
+	}
+	z_erofs_pcache_next = 0;
+}
+
+/*
+ * Reads that only need part of an extent (directory blocks, symlinks, tail
+ * fragments in the packed inode, unaligned offsets) decode the whole extent
+ * once and are then served from here.
+ */
+static struct z_erofs_pcluster_cache *
+z_erofs_pcluster_lookup(struct erofs_inode *inode,
+			struct erofs_map_blocks *map, erofs_off_t length)
 {
+	struct z_erofs_pcluster_cache *pc;
+	int i;
+
+	for (i = 0; i < Z_EROFS_PCLUSTER_CACHE_SIZE; i++) {
+		pc = &z_erofs_pcache[i];
+		if (pc->data && pc->nid == inode->nid && pc->la == map->m_la &&
+		    pc->len >= length)
+			return pc;
+	}
+	return NULL;
+}
+
+static int z_erofs_read_one_data(struct erofs_inode *inode,
+				 struct erofs_map_blocks *map,
+				 struct z_erofs_read_window *win,
+				 erofs_off_t ahead, char *buffer,
+				 erofs_off_t skip, erofs_off_t length,
+				 bool trimmed)
+{
+	struct z_erofs_pcluster_cache *pc = NULL;
 	struct erofs_map_dev mdev;
+	char *raw, *out;
 	int ret = 0;
 
 	if (map->m_flags & EROFS_MAP_FRAGMENT) {
@@ -238,6 +389,34 @@ int z_erofs_read_one_data(struct erofs_inode *inode,
 				   inode->fragmentoff + skip);
 	}
 
+	if ((skip || trimmed) && map->m_llen <= Z_EROFS_PCLUSTER_CACHE_MAX) {
+		pc = z_erofs_pcluster_lookup(inode, map, length);
+		if (pc) {
+			memcpy(buffer, pc->data + skip, length - skip);
+			return 0;
+		}
+
+		pc = &z_erofs_pcache[z_erofs_pcache_next];
+		out = realloc(pc->data, map->m_llen);
+		if (!out) {
+			free(pc->data);
+			*pc = (struct z_erofs_pcluster_cache) { 0 };
+			return -ENOMEM;
+		}
+		*pc = (struct z_erofs_pcluster_cache) {
+			.data = out,
+		};
+		z_erofs_pcache_next = (z_erofs_pcache_next + 1) %
+			Z_EROFS_PCLUSTER_CACHE_SIZE;
+
+		/* decode the whole extent, then hand out the part needed */
+		skip = 0;
+		length = map->m_llen;
+		trimmed = false;
+	} else {
+		out = buffer;
+	}
+
 	/* no device id here, thus it will always succeed */
 	mdev = (struct erofs_map_dev) {
 		.m_pa = map->m_pa,
@@ -248,13 +427,13 @@ int z_erofs_read_one_data(struct erofs_inode *inode,
 		return ret;
 	}
 
-	ret = erofs_dev_read(mdev.m_deviceid, raw, mdev.m_pa, map->m_plen);
+	ret = z_erofs_read_raw(win, mdev.m_pa, map->m_plen, ahead, &raw);
 	if (ret < 0)
 		return ret;
 
 	ret = z_erofs_decompress(&(struct z_erofs_decompress_req) {
 			.in = raw,
-			.out = buffer,
+			.out = out,
 			.decodedskip = skip,
 			.interlaced_offset =
 				map->m_algorithmformat == Z_EROFS_COMPRESSION_INTERLACED ?
@@ -268,19 +447,24 @@ int z_erofs_read_one_data(struct erofs_inode *inode,
 			 });
 	if (ret < 0)
 		return ret;
+
+	if (pc) {
+		pc->nid = inode->nid;
+		pc->la = map->m_la;
+		pc->len = map->m_llen;
+	}
 	return 0;
 }
 
 static int z_erofs_read_data(struct erofs_inode *inode, char *buffer,
 			     erofs_off_t size, erofs_off_t offset)
 {
-	erofs_off_t end, length, skip;
+	erofs_off_t end, length, skip, ahead;
 	struct erofs_map_blocks map = {
 		.index = UINT_MAX,
 	};
+	struct z_erofs_read_window win = { 0 };
 	bool trimmed;
-	unsigned int bufsize = 0;
-	char *raw = NULL;
 	int ret = 0;
 
 	end = offset + size;
@@ -307,9 +491,11 @@ static int z_erofs_read_data(struct erofs_inode *inode, char *buffer,
 		if (map.m_la < offset) {
 			skip = offset - map.m_la;
 			end = offset;
+			ahead = 0;
 		} else {
 			skip = 0;
 			end = map.m_la;
+			ahead = map.m_la - offset;
 		}
 
 		if (!(map.m_flags & EROFS_MAP_MAPPED)) {
@@ -318,23 +504,13 @@ static int z_erofs_read_data(struct erofs_inode *inode, char *buffer,
 			continue;
 		}
 
-		if (map.m_plen > bufsize) {
-			bufsize = map.m_plen;
-			raw = realloc(raw, bufsize);
-			if (!raw) {
-				ret = -ENOMEM;
-				break;
-			}
-		}
-
-		ret = z_erofs_read_one_data(inode, &map, raw,
+		ret = z_erofs_read_one_data(inode, &map, &win, ahead,
 					    buffer + end - offset, skip, length,
 					    trimmed);
 		if (ret < 0)
 			break;
 	}
-	if (raw)
-		free(raw);
+	free(win.buf);
 	return ret < 0 ? ret : 0;
 }
 
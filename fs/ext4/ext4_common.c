@@ -18,6 +18,7 @@
  * ext4write : Based on generic ext4 protocol.
  */
 
+#include <arena.h>
 #include <blk.h>
 #include <ext_common.h>
 #include <ext4fs.h>
@@ -482,7 +483,6 @@ int ext4fs_update_parent_dentry(char *filename, int file_type)
 	int sizeof_void_space = 0;
 	int templength = 0;
 	int inodeno = -1;
-	int status;
 	struct ext_filesystem *fs = get_fs();
 	/* directory entry */
 	struct ext2_dirent *dir;
@@ -517,10 +517,8 @@ restart_read:
 	if (first_block_no_of_root <= 0)
 		goto fail;
 
-	status = ext4fs_devread((lbaint_t)first_block_no_of_root
-				* fs->sect_perblk,
-				0, fs->blksz, root_first_block_buffer);
-	if (status == 0)
+	if (ext4fs_read_metadata(root_first_block_buffer,
+				 first_block_no_of_root))
 		goto fail;
 
 	if (ext4fs_log_journal(root_first_block_buffer, first_block_no_of_root))
@@ -711,23 +709,24 @@ static int find_dir_depth(char *dirname)
 	 */
 }
 
+/* Split a path into its components, which are allocated from the arena */
 static int parse_path(char **arr, char *dirname)
 {
 	char *token = strtok(dirname, "/");
 	int i = 0;
 
 	/* add root */
-	arr[i] = zalloc(strlen("/") + 1);
+	arr[i] = arena_strdup("/");
 	if (!arr[i])
 		return -ENOMEM;
-	memcpy(arr[i++], "/", strlen("/"));
+	i++;
 
 	/* add each path entry after root */
 	while (token != NULL) {
-		arr[i] = zalloc(strlen(token) + 1);
+		arr[i] = arena_strdup(token);
 		if (!arr[i])
 			return -ENOMEM;
-		memcpy(arr[i++], token, strlen(token));
+		i++;
 		token = strtok(NULL, "/");
 	}
 	arr[i] = NULL;
@@ -757,35 +756,37 @@ int ext4fs_get_parent_inode_num(const char *dirname, char *dname, int flags)
 	int depth = 0;
 	int matched_inode_no;
 	int result_inode_no = -1;
-	char **ptr = NULL;
-	char *depth_dirname = NULL;
-	char *parse_dirname = NULL;
-	struct ext2_inode *parent_inode = NULL;
-	struct ext2_inode *first_inode = NULL;
+	char **ptr;
+	char *depth_dirname;
+	char *parse_dirname;
+	struct ext2_inode *parent_inode;
+	struct ext2_inode *first_inode;
 	struct ext2_inode temp_inode;
+	struct arena_mark mark;
 
 	/* TODO: input validation make equivalent to linux */
-	depth_dirname = zalloc(strlen(dirname) + 1);
-	if (!depth_dirname)
+	mark = arena_begin();
+	depth_dirname = arena_strdup(dirname);
+	if (!depth_dirname) {
+		arena_release(mark);
 		return -ENOMEM;
+	}
 
-	memcpy(depth_dirname, dirname, strlen(dirname));
 	depth = find_dir_depth(depth_dirname);
-	parse_dirname = zalloc(strlen(dirname) + 1);
+	parse_dirname = arena_strdup(dirname);
 	if (!parse_dirname)
 		goto fail;
-	memcpy(parse_dirname, dirname, strlen(dirname));
 
 	/* allocate memory for each directory level */
-	ptr = zalloc((depth) * sizeof(char *));
+	ptr = arena_zalloc((depth) * sizeof(char *));
 	if (!ptr)
 		goto fail;
 	if (parse_path(ptr, parse_dirname))
 		goto fail;
-	parent_inode = zalloc(sizeof(struct ext2_inode));
+	parent_inode = arena_alloc(sizeof(struct ext2_inode));
 	if (!parent_inode)
 		goto fail;
-	first_inode = zalloc(sizeof(struct ext2_inode));
+	first_inode = arena_alloc(sizeof(struct ext2_inode));
 	if (!first_inode)
 		goto fail;
 	memcpy(parent_inode, ext4fs_root->inode, sizeof(struct ext2_inode));
@@ -843,28 +844,13 @@ end:
 	memcpy(dname, ptr[i], strlen(ptr[i]));
 
 fail:
-	free(depth_dirname);
-	if (parse_dirname)
-		free(parse_dirname);
-	if (ptr) {
-		for (i = 0; i < depth; i++) {
-			if (!ptr[i])
-				break;
-			free(ptr[i]);
-		}
-		free(ptr);
-	}
-	if (parent_inode)
-		free(parent_inode);
-	if (first_inode)
-		free(first_inode);
+	arena_release(mark);
 
 	return result_inode_no;
 }
 
 static int unlink_filename(char *filename, unsigned int blknr)
 {
-	int status;
 	int inodeno = 0;
 	int offset;
 	char *block_buffer = NULL;
@@ -879,9 +865,7 @@ static int unlink_filename(char *filename, unsigned int blknr)
 		return -ENOMEM;
 
 	/* read the directory block */
-	status = ext4fs_devread((lbaint_t)blknr * fs->sect_perblk, 0,
-				fs->blksz, block_buffer);
-	if (status == 0)
+	if (ext4fs_read_metadata(block_buffer, blknr))
 		goto fail;
 
 	offset = 0;
@@ -957,38 +941,80 @@ int ext4fs_filename_unlink(char *filename)
 	return -1;
 }
 
+static unsigned char *ext4fs_load_bmap(unsigned char **bmaps, uint32_t idx,
+					uint64_t blknr)
+{
+	struct ext_filesystem *fs = get_fs();
+	unsigned char *bmap;
+
+	if (bmaps[idx])
+		return bmaps[idx];
+
+	bmap = zalloc(fs->blksz);
+	if (!bmap)
+		return NULL;
+	if (!ext4fs_devread(blknr * fs->sect_perblk, 0, fs->blksz,
+			    (char *)bmap) ||
+	    ext4fs_log_journal((char *)bmap, blknr)) {
+		free(bmap);
+		return NULL;
+	}
+	bmaps[idx] = bmap;
+
+	return bmap;
+}
+
+unsigned char *ext4fs_get_blk_bmap(uint32_t idx)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext2_block_group *bgd;
+
+	if (idx >= fs->no_blkgrp)
+		return NULL;
+	bgd = ext4fs_get_group_descriptor(fs, idx);
+
+	return ext4fs_load_bmap(fs->blk_bmaps, idx,
+				ext4fs_bg_get_block_id(bgd, fs));
+}
+
+unsigned char *ext4fs_get_inode_bmap(uint32_t idx)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext2_block_group *bgd;
+
+	if (idx >= fs->no_blkgrp)
+		return NULL;
+	bgd = ext4fs_get_group_descriptor(fs, idx);
+
+	return ext4fs_load_bmap(fs->inode_bmaps, idx,
+				ext4fs_bg_get_inode_id(bgd, fs));
+}
+
 uint32_t ext4fs_get_new_blk_no(void)
 {
 	short i;
-	short status;
 	int remainder;
 	unsigned int bg_idx;
-	static int prev_bg_bitmap_index = -1;
 	unsigned int blk_per_grp = le32_to_cpu(ext4fs_root->sblock.blocks_per_group);
 	struct ext_filesystem *fs = get_fs();
-	char *journal_buffer = zalloc(fs->blksz);
-	char *zero_buffer = zalloc(fs->blksz);
-	if (!journal_buffer || !zero_buffer)
-		goto fail;
+	struct ext2_block_group *bgd;
+	unsigned char *bmap;
+	uint16_t bg_flags;
 
 	if (fs->first_pass_bbmap == 0) {
 		for (i = 0; i < fs->no_blkgrp; i++) {
-			struct ext2_block_group *bgd = NULL;
 			bgd = ext4fs_get_group_descriptor(fs, i);
 			if (ext4fs_bg_get_free_blocks(bgd, fs)) {
-				uint16_t bg_flags = ext4fs_bg_get_flags(bgd);
-				uint64_t b_bitmap_blk =
-					ext4fs_bg_get_block_id(bgd, fs);
+				bmap = ext4fs_get_blk_bmap(i);
+				if (!bmap)
+					return -1;
+				bg_flags = ext4fs_bg_get_flags(bgd);
 				if (bg_flags & EXT4_BG_BLOCK_UNINIT) {
-					memcpy(fs->blk_bmaps[i], zero_buffer,
-					       fs->blksz);
-					put_ext4(b_bitmap_blk * fs->blksz,
-						 fs->blk_bmaps[i], fs->blksz);
+					memset(bmap, '\0', fs->blksz);
 					bg_flags &= ~EXT4_BG_BLOCK_UNINIT;
 					ext4fs_bg_set_flags(bgd, bg_flags);
 				}
-				fs->curr_blkno =
-				    _get_new_blk_no(fs->blk_bmaps[i]);
+				fs->curr_blkno = _get_new_blk_no(bmap);
 				if (fs->curr_blkno == -1)
 					/* block bitmap is completely filled */
 					continue;
@@ -997,132 +1023,96 @@ uint32_t ext4fs_get_new_blk_no(void)
 				fs->first_pass_bbmap++;
 				ext4fs_bg_free_blocks_dec(bgd, fs);
 				ext4fs_sb_free_blocks_dec(fs->sb);
-				status = ext4fs_devread(b_bitmap_blk *
-							fs->sect_perblk,
-							0, fs->blksz,
-							journal_buffer);
-				if (status == 0)
-					goto fail;
-				if (ext4fs_log_journal(journal_buffer,
-						       b_bitmap_blk))
-					goto fail;
-				goto success;
+
+				return fs->curr_blkno;
 			} else {
 				debug("no space left on block group %d\n", i);
 			}
 		}
 
-		goto fail;
-	} else {
-		fs->curr_blkno++;
-restart:
-		/* get the blockbitmap index respective to blockno */
-		bg_idx = fs->curr_blkno / blk_per_grp;
-		if (fs->blksz == 1024) {
-			remainder = fs->curr_blkno % blk_per_grp;
-			if (!remainder)
-				bg_idx--;
-		}
-
-		/*
-		 * To skip completely filled block group bitmaps
-		 * Optimize the block allocation
-		 */
-		if (bg_idx >= fs->no_blkgrp)
-			goto fail;
+		return -1;
+	}
 
-		struct ext2_block_group *bgd = NULL;
-		bgd = ext4fs_get_group_descriptor(fs, bg_idx);
-		if (ext4fs_bg_get_free_blocks(bgd, fs) == 0) {
-			debug("block group %u is full. Skipping\n", bg_idx);
-			fs->curr_blkno = (bg_idx + 1) * blk_per_grp;
-			if (fs->blksz == 1024)
-				fs->curr_blkno += 1;
-			goto restart;
-		}
+	fs->curr_blkno++;
+restart:
+	/* get the blockbitmap index respective to blockno */
+	bg_idx = fs->curr_blkno / blk_per_grp;
+	if (fs->blksz == 1024) {
+		remainder = fs->curr_blkno % blk_per_grp;
+		if (!remainder)
+			bg_idx--;
+	}
 
-		uint16_t bg_flags = ext4fs_bg_get_flags(bgd);
-		uint64_t b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
-		if (bg_flags & EXT4_BG_BLOCK_UNINIT) {
-			memcpy(fs->blk_bmaps[bg_idx], zero_buffer, fs->blksz);
-			put_ext4(b_bitmap_blk * fs->blksz,
-				 zero_buffer, fs->blksz);
-			bg_flags &= ~EXT4_BG_BLOCK_UNINIT;
-			ext4fs_bg_set_flags(bgd, bg_flags);
-		}
+	/*
+	 * To skip completely filled block group bitmaps
+	 * Optimize the block allocation
+	 */
+	if (bg_idx >= fs->no_blkgrp)
+		return -1;
 
-		if (ext4fs_set_block_bmap(fs->curr_blkno, fs->blk_bmaps[bg_idx],
-				   bg_idx) != 0) {
-			debug("going for restart for the block no %ld %u\n",
-			      fs->curr_blkno, bg_idx);
-			fs->curr_blkno++;
-			goto restart;
-		}
+	bgd = ext4fs_get_group_descriptor(fs, bg_idx);
+	if (ext4fs_bg_get_free_blocks(bgd, fs) == 0) {
+		debug("block group %u is full. Skipping\n", bg_idx);
+		fs->curr_blkno = (bg_idx + 1) * blk_per_grp;
+		if (fs->blksz == 1024)
+			fs->curr_blkno += 1;
+		goto restart;
+	}
 
-		/* journal backup */
-		if (prev_bg_bitmap_index != bg_idx) {
-			status = ext4fs_devread(b_bitmap_blk * fs->sect_perblk,
-						0, fs->blksz, journal_buffer);
-			if (status == 0)
-				goto fail;
-			if (ext4fs_log_journal(journal_buffer, b_bitmap_blk))
-				goto fail;
+	bmap = ext4fs_get_blk_bmap(bg_idx);
+	if (!bmap)
+		return -1;
+	bg_flags = ext4fs_bg_get_flags(bgd);
+	if (bg_flags & EXT4_BG_BLOCK_UNINIT) {
+		memset(bmap, '\0', fs->blksz);
+		bg_flags &= ~EXT4_BG_BLOCK_UNINIT;
+		ext4fs_bg_set_flags(bgd, bg_flags);
+	}
 
-			prev_bg_bitmap_index = bg_idx;
-		}
-		ext4fs_bg_free_blocks_dec(bgd, fs);
-		ext4fs_sb_free_blocks_dec(fs->sb);
-		goto success;
+	if (ext4fs_set_block_bmap(fs->curr_blkno, bmap, bg_idx) != 0) {
+		debug("going for restart for the block no %ld %u\n",
+		      fs->curr_blkno, bg_idx);
+		fs->curr_blkno++;
+		goto restart;
 	}
-success:
-	free(journal_buffer);
-	free(zero_buffer);
 
-	return fs->curr_blkno;
-fail:
-	free(journal_buffer);
-	free(zero_buffer);
+	ext4fs_bg_free_blocks_dec(bgd, fs);
+	ext4fs_sb_free_blocks_dec(fs->sb);
 
-	return -1;
+	return fs->curr_blkno;
 }
 
 int ext4fs_get_new_inode_no(void)
 {
 	short i;
-	short status;
 	unsigned int ibmap_idx;
-	static int prev_inode_bitmap_index = -1;
 	unsigned int inodes_per_grp = le32_to_cpu(ext4fs_root->sblock.inodes_per_group);
 	struct ext_filesystem *fs = get_fs();
-	char *journal_buffer = zalloc(fs->blksz);
-	char *zero_buffer = zalloc(fs->blksz);
-	if (!journal_buffer || !zero_buffer)
-		goto fail;
+	struct ext2_block_group *bgd;
+	unsigned char *bmap;
+	uint16_t bg_flags;
 	int has_gdt_chksum = le32_to_cpu(fs->sb->feature_ro_compat) &
 		EXT4_FEATURE_RO_COMPAT_GDT_CSUM ? 1 : 0;
 
 	if (fs->first_pass_ibmap == 0) {
 		for (i = 0; i < fs->no_blkgrp; i++) {
 			uint32_t free_inodes;
-			struct ext2_block_group *bgd = NULL;
+
 			bgd = ext4fs_get_group_descriptor(fs, i);
 			free_inodes = ext4fs_bg_get_free_inodes(bgd, fs);
 			if (free_inodes) {
-				uint16_t bg_flags = ext4fs_bg_get_flags(bgd);
-				uint64_t i_bitmap_blk =
-					ext4fs_bg_get_inode_id(bgd, fs);
+				bmap = ext4fs_get_inode_bmap(i);
+				if (!bmap)
+					return -1;
+				bg_flags = ext4fs_bg_get_flags(bgd);
 				if (has_gdt_chksum)
 					bgd->bg_itable_unused = free_inodes;
 				if (bg_flags & EXT4_BG_INODE_UNINIT) {
-					put_ext4(i_bitmap_blk * fs->blksz,
-						 zero_buffer, fs->blksz);
 					bg_flags &= ~EXT4_BG_INODE_UNINIT;
 					ext4fs_bg_set_flags(bgd, bg_flags);
-					memcpy(fs->inode_bmaps[i],
-					       zero_buffer, fs->blksz);
+					memset(bmap, '\0', fs->blksz);
 				}
-				fs->curr_inode_no =
-				    _get_new_inode_no(fs->inode_bmaps[i]);
+				fs->curr_inode_no = _get_new_inode_no(bmap);
 				if (fs->curr_inode_no == -1)
 					/* inode bitmap is completely filled */
 					continue;
@@ -1133,76 +1123,43 @@ int ext4fs_get_new_inode_no(void)
 				if (has_gdt_chksum)
 					ext4fs_bg_itable_unused_dec(bgd, fs);
 				ext4fs_sb_free_inodes_dec(fs->sb);
-				status = ext4fs_devread(i_bitmap_blk *
-							fs->sect_perblk,
-							0, fs->blksz,
-							journal_buffer);
-				if (status == 0)
-					goto fail;
-				if (ext4fs_log_journal(journal_buffer,
-						       i_bitmap_blk))
-					goto fail;
-				goto success;
+
+				return fs->curr_inode_no;
 			} else
 				debug("no inode left on block group %d\n", i);
 		}
-		goto fail;
-	} else {
+
+		return -1;
+	}
+
 restart:
-		fs->curr_inode_no++;
-		/* get the blockbitmap index respective to blockno */
-		ibmap_idx = fs->curr_inode_no / inodes_per_grp;
-		struct ext2_block_group *bgd =
-			ext4fs_get_group_descriptor(fs, ibmap_idx);
-		uint16_t bg_flags = ext4fs_bg_get_flags(bgd);
-		uint64_t i_bitmap_blk = ext4fs_bg_get_inode_id(bgd, fs);
-
-		if (bg_flags & EXT4_BG_INODE_UNINIT) {
-			put_ext4(i_bitmap_blk * fs->blksz,
-				 zero_buffer, fs->blksz);
-			bg_flags &= ~EXT4_BG_INODE_UNINIT;
-			ext4fs_bg_set_flags(bgd, bg_flags);
-			memcpy(fs->inode_bmaps[ibmap_idx], zero_buffer,
-				fs->blksz);
-		}
+	fs->curr_inode_no++;
+	/* get the blockbitmap index respective to blockno */
+	ibmap_idx = fs->curr_inode_no / inodes_per_grp;
+	bmap = ext4fs_get_inode_bmap(ibmap_idx);
+	if (!bmap)
+		return -1;
+	bgd = ext4fs_get_group_descriptor(fs, ibmap_idx);
+	bg_flags = ext4fs_bg_get_flags(bgd);
 
-		if (ext4fs_set_inode_bmap(fs->curr_inode_no,
-					  fs->inode_bmaps[ibmap_idx],
-					  ibmap_idx) != 0) {
-			debug("going for restart for the block no %d %u\n",
-			      fs->curr_inode_no, ibmap_idx);
-			goto restart;
-		}
+	if (bg_flags & EXT4_BG_INODE_UNINIT) {
+		bg_flags &= ~EXT4_BG_INODE_UNINIT;
+		ext4fs_bg_set_flags(bgd, bg_flags);
+		memset(bmap, '\0', fs->blksz);
+	}
 
-		/* journal backup */
-		if (prev_inode_bitmap_index != ibmap_idx) {
-			status = ext4fs_devread(i_bitmap_blk * fs->sect_perblk,
-						0, fs->blksz, journal_buffer);
-			if (status == 0)
-				goto fail;
-			if (ext4fs_log_journal(journal_buffer,
-						le32_to_cpu(bgd->inode_id)))
-				goto fail;
-			prev_inode_bitmap_index = ibmap_idx;
-		}
-		ext4fs_bg_free_inodes_dec(bgd, fs);
-		if (has_gdt_chksum)
-			bgd->bg_itable_unused = bgd->free_inodes;
-		ext4fs_sb_free_inodes_dec(fs->sb);
-		goto success;
+	if (ext4fs_set_inode_bmap(fs->curr_inode_no, bmap, ibmap_idx) != 0) {
+		debug("going for restart for the block no %d %u\n",
+		      fs->curr_inode_no, ibmap_idx);
+		goto restart;
 	}
 
-success:
-	free(journal_buffer);
-	free(zero_buffer);
+	ext4fs_bg_free_inodes_dec(bgd, fs);
+	if (has_gdt_chksum)
+		bgd->bg_itable_unused = bgd->free_inodes;
+	ext4fs_sb_free_inodes_dec(fs->sb);
 
 	return fs->curr_inode_no;
-fail:
-	free(journal_buffer);
-	free(zero_buffer);
-
-	return -1;
-
 }
 
 static void alloc_single_indirect_block(struct ext2_inode *file_inode,
@@ -1993,6 +1950,74 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 	return blknr;
 }
 
+/**
+ * ext4fs_map_extent() - Map a run of file blocks through the extent tree
+ *
+ * Look up @fileblock in the extent tree of @inode and report how many of
+ * the following file blocks are laid out contiguously on disk, so that the
+ * caller can transfer the whole run with a single read.
+ *
+ * @inode:	inode using extents (EXT4_EXTENTS_FL)
+ * @fileblock:	logical block number within the file
+ * @cache:	cache used for the index and leaf blocks of the tree
+ * @blknr:	returns the filesystem block holding @fileblock, or 0 if
+ *		@fileblock is in a hole or an uninitialised extent
+ * Return: number of blocks in the run starting at @fileblock (at least 1),
+ *	or -EINVAL if the extent tree is corrupt
+ */
+long ext4fs_map_extent(struct ext2_inode *inode, uint32_t fileblock,
+		       struct ext_block_cache *cache, lbaint_t *blknr)
+{
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
+	int log2_blksz;
+	int i;
+
+	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root) -
+		get_fs()->dev_desc->log2blksz;
+	ext_block = ext4fs_get_extent_block(ext4fs_root, cache,
+					    (struct ext4_extent_header *)
+					    inode->b.blocks.dir_blocks,
+					    fileblock, log2_blksz);
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		return -EINVAL;
+	}
+
+	*blknr = 0;
+	extent = (struct ext4_extent *)(ext_block + 1);
+	for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
+		uint32_t startblock = le32_to_cpu(extent[i].ee_block);
+		uint32_t len = le16_to_cpu(extent[i].ee_len);
+		bool uninit = false;
+		unsigned long long start;
+
+		if (len > EXT_INIT_MAX_LEN) {
+			len -= EXT_INIT_MAX_LEN;
+			uninit = true;
+		}
+
+		/* Sparse file: the hole runs up to the next extent */
+		if (startblock > fileblock)
+			return startblock - fileblock;
+
+		if (fileblock >= startblock + len)
+			continue;
+
+		if (!uninit) {
+			start = le16_to_cpu(extent[i].ee_start_hi);
+			start = (start << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			*blknr = start + fileblock - startblock;
+		}
+
+		return startblock + len - fileblock;
+	}
+
+	/* Past the last extent in this leaf, treat one block as a hole */
+	return 1;
+}
+
 /**
  * ext4fs_reinit_global() - Reinitialize values of ext4 write implementation's
  *			    global pointers
@@ -2040,24 +2065,15 @@ void ext4fs_close(void)
 	ext4fs_reinit_global();
 }
 
-int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
-				struct ext2fs_node **fnode, int *ftype)
+int ext4fs_iterate_dir_range(struct ext2fs_node *dir, unsigned int fpos,
+			     unsigned int end, char *name,
+			     struct ext2fs_node **fnode, int *ftype)
 {
-	unsigned int fpos = 0;
 	int status;
 	loff_t actread;
 
-#ifdef DEBUG
-	if (name != NULL)
-		printf("Iterate dir %s\n", name);
-#endif /* of DEBUG */
-	if (!dir->inode_read) {
-		status = ext4fs_read_inode(dir->data, dir->ino, &dir->inode);
-		if (status == 0)
-			return 0;
-	}
 	/* Search the file.  */
-	while (fpos < le32_to_cpu(dir->inode.size)) {
+	while (fpos < end) {
 		struct ext2_dirent dirent;
 
 		status = ext4fs_read_file(dir, fpos,
@@ -2145,6 +2161,32 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 	return 0;
 }
 
+int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
+				struct ext2fs_node **fnode, int *ftype)
+{
+	int status;
+
+#ifdef DEBUG
+	if (name != NULL)
+		printf("Iterate dir %s\n", name);
+#endif /* of DEBUG */
+	if (!dir->inode_read) {
+		status = ext4fs_read_inode(dir->data, dir->ino, &dir->inode);
+		if (status == 0)
+			return 0;
+	}
+
+	/* a hashed directory holds the name in one block, found by its hash */
+	if (IS_ENABLED(CONFIG_EXT4_HTREE) && name && fnode && ftype) {
+		status = ext4fs_htree_find(dir, name, fnode, ftype);
+		if (status >= 0)
+			return status;
+	}
+
+	return ext4fs_iterate_dir_range(dir, 0, le32_to_cpu(dir->inode.size),
+					name, fnode, ftype);
+}
+
 static char *ext4fs_read_symlink(struct ext2fs_node *node)
 {
 	char *symlink;
@@ -51,12 +51,32 @@ int ext4fs_read_inode(struct ext2_data *data, int ino,
 		      struct ext2_inode *inode);
 int ext4fs_read_file(struct ext2fs_node *node, loff_t pos, loff_t len,
 		     char *buf, loff_t *actread);
+long ext4fs_map_extent(struct ext2_inode *inode, uint32_t fileblock,
+		       struct ext_block_cache *cache, lbaint_t *blknr);
 int ext4fs_find_file(const char *path, struct ext2fs_node *rootnode,
 			struct ext2fs_node **foundnode, int expecttype);
 int ext4fs_find_file1(const char *currpath, struct ext2fs_node *currroot,
 		      struct ext2fs_node **currfound, int *foundtype);
 int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 			struct ext2fs_node **fnode, int *ftype);
+int ext4fs_iterate_dir_range(struct ext2fs_node *dir, unsigned int fpos,
+			     unsigned int end, char *name,
+			     struct ext2fs_node **fnode, int *ftype);
+
+/**
+ * ext4fs_htree_find() - look up a name in a directory with a hash tree
+ *
+ * Only the directory blocks the hash tree leads to are read.
+ *
+ * @dir: Directory, with its inode read
+ * @name: Name to look up
+ * @fnode: Returns the node found, which the caller must free
+ * @ftype: Returns the type of the node (FILETYPE_...)
+ * Return: 1 if found, 0 if not, -ve if the directory has no hash tree which
+ * can be used, so it must be scanned
+ */
+int ext4fs_htree_find(struct ext2fs_node *dir, char *name,
+		      struct ext2fs_node **fnode, int *ftype);
 
 #if defined(CONFIG_EXT4_WRITE)
 uint32_t ext4fs_div_roundup(uint32_t size, uint32_t n);
@@ -65,6 +85,27 @@ int ext4fs_get_parent_inode_num(const char *dirname, char *dname, int flags);
 int ext4fs_update_parent_dentry(char *filename, int file_type);
 uint32_t ext4fs_get_new_blk_no(void);
 int ext4fs_get_new_inode_no(void);
+
+/**
+ * ext4fs_get_blk_bmap() - get the block bitmap of a block group
+ *
+ * The bitmap is read and logged to the journal the first time it is needed
+ * in a write session. ext4fs_update() writes back those that were read.
+ *
+ * @idx: Block group number
+ * Return: bitmap, or NULL if it cannot be read
+ */
+unsigned char *ext4fs_get_blk_bmap(uint32_t idx);
+
+/**
+ * ext4fs_get_inode_bmap() - get the inode bitmap of a block group
+ *
+ * This works like ext4fs_get_blk_bmap().
+ *
+ * @idx: Block group number
+ * Return: bitmap, or NULL if it cannot be read
+ */
+unsigned char *ext4fs_get_inode_bmap(uint32_t idx);
 void ext4fs_reset_block_bmap(long int blockno, unsigned char *buffer,
 					int index);
 int ext4fs_set_block_bmap(long int blockno, unsigned char *buffer, int index);
@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Looking up names in ext4 directories which have a hash tree (dir_index)
+ *
+ * The first block of such a directory holds, after the '.' and '..' entries,
+ * a sorted table of hashes and the directory block holding the names from
+ * each hash on. With more than one level this leads to further tables. Only
+ * the leaf block for the hash of the name is then searched, instead of every
+ * block of the directory.
+ *
+ * The hash functions are based on fs/ext4/hash.c from Linux:
+ * Copyright (C) 2002 by Theodore Ts'o
+ */
+
+#include <blk.h>
+#include <ext4fs.h>
+#include <log.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include "ext4_common.h"
+
+#define EXT2_FLAGS_UNSIGNED_HASH	0x0002
+
+#define DX_HTREE_EOF			0x7fffffff
+
+enum dx_hash_version {
+	DX_HASH_LEGACY,
+	DX_HASH_HALF_MD4,
+	DX_HASH_TEA,
+	DX_HASH_LEGACY_UNSIGNED,
+	DX_HASH_HALF_MD4_UNSIGNED,
+	DX_HASH_TEA_UNSIGNED,
+};
+
+enum {
+	DX_ROOT_INFO_OFFSET	= 0x18,	/* after the '.' and '..' entries */
+	DX_NODE_OFFSET		= 8,	/* after an empty directory entry */
+	DX_MAX_LEVELS		= 3,
+};
+
+/**
+ * struct dx_root_info - information about the hash tree
+ *
+ * @reserved_zero: Always 0
+ * @hash_version: Hash used (enum dx_hash_version)
+ * @info_length: Size of this struct, 8
+ * @indirect_levels: Number of levels of index blocks below the root
+ * @unused_flags: Not used
+ */
+struct dx_root_info {
+	__le32 reserved_zero;
+	u8 hash_version;
+	u8 info_length;
+	u8 indirect_levels;
+	u8 unused_flags;
+};
+
+/**
+ * struct dx_entry - an entry in a table of hashes
+ *
+ * In the first entry of each table, @hash holds the limit (low 16 bits) and
+ * the number of entries (high 16 bits) instead
+ *
+ * @hash: Lowest hash of the names in @block
+ * @block: Directory block (not filesystem block) to look in
+ */
+struct dx_entry {
+	__le32 hash;
+	__le32 block;
+};
+
+#define DELTA	0x9e3779b9
+
+static void tea_transform(u32 buf[4], const u32 in[])
+{
+	u32 sum = 0;
+	u32 b0 = buf[0], b1 = buf[1];
+	u32 a = in[0], b = in[1], c = in[2], d = in[3];
+	int n = 16;
+
+	do {
+		sum += DELTA;
+		b0 += ((b1 << 4) + a) ^ (b1 + sum) ^ ((b1 >> 5) + b);
+		b1 += ((b0 << 4) + c) ^ (b0 + sum) ^ ((b0 >> 5) + d);
+	} while (--n);
+
+	buf[0] += b0;
+	buf[1] += b1;
+}
+
+/* F, G and H are basic MD4 functions: selection, majority, parity */
+#define F(x, y, z)	((z) ^ ((x) & ((y) ^ (z))))
+#define G(x, y, z)	(((x) & (y)) + (((x) ^ (y)) & (z)))
+#define H(x, y, z)	((x) ^ (y) ^ (z))
+
+#define MD4_ROUND(f, a, b, c, d, x, s)	\
+	(a += f(b, c, d) + (x), a = (a << (s)) | (a >> (32 - (s))))
+#define K1	0
+#define K2	013240474631UL
+#define K3	015666365641UL
+
+static void half_md4_transform(u32 buf[4], const u32 in[8])
+{
+	u32 a = buf[0], b = buf[1], c = buf[2], d = buf[3];
+
+	/* Round 1 */
+	MD4_ROUND(F, a, b, c, d, in[0] + K1,  3);
+	MD4_ROUND(F, d, a, b, c, in[1] + K1,  7);
+	MD4_ROUND(F, c, d, a, b, in[2] + K1, 11);
+	MD4_ROUND(F, b, c, d, a, in[3] + K1, 19);
+	MD4_ROUND(F, a, b, c, d, in[4] + K1,  3);
+	MD4_ROUND(F, d, a, b, c, in[5] + K1,  7);
+	MD4_ROUND(F, c, d, a, b, in[6] + K1, 11);
+	MD4_ROUND(F, b, c, d, a, in[7] + K1, 19);
+
+	/* Round 2 */
+	MD4_ROUND(G, a, b, c, d, in[1] + K2,  3);
+	MD4_ROUND(G, d, a, b, c, in[3] + K2,  5);
+	MD4_ROUND(G, c, d, a, b, in[5] + K2,  9);
+	MD4_ROUND(G, b, c, d, a, in[7] + K2, 13);
+	MD4_ROUND(G, a, b, c, d, in[0] + K2,  3);
+	MD4_ROUND(G, d, a, b, c, in[2] + K2,  5);
+	MD4_ROUND(G, c, d, a, b, in[4] + K2,  9);
+	MD4_ROUND(G, b, c, d, a, in[6] + K2, 13);
+
+	/* Round 3 */
+	MD4_ROUND(H, a, b, c, d, in[3] + K3,  3);
+	MD4_ROUND(H, d, a, b, c, in[7] + K3,  9);
+	MD4_ROUND(H, c, d, a, b, in[2] + K3, 11);
+	MD4_ROUND(H, b, c, d, a, in[6] + K3, 15);
+	MD4_ROUND(H, a, b, c, d, in[1] + K3,  3);
+	MD4_ROUND(H, d, a, b, c, in[5] + K3,  9);
+	MD4_ROUND(H, c, d, a, b, in[0] + K3, 11);
+	MD4_ROUND(H, b, c, d, a, in[4] + K3, 15);
+
+	buf[0] += a;
+	buf[1] += b;
+	buf[2] += c;
+	buf[3] += d;
+}
+
+/* The original hash, which treats the name as signed or unsigned chars */
+static u32 dx_hack_hash(const char *name, int len, bool is_unsigned)
+{
+	u32 hash, hash0 = 0x12a3fe2d, hash1 = 0x37abe8f9;
+	int i, c;
+
+	for (i = 0; i < len; i++) {
+		c = is_unsigned ? (int)(unsigned char)name[i] :
+			(int)(signed char)name[i];
+		hash = hash1 + (hash0 ^ (c * 7152373));
+		if (hash & 0x80000000)
+			hash -= 0x7fffffff;
+		hash1 = hash0;
+		hash0 = hash;
+	}
+
+	return hash0 << 1;
+}
+
+/* Pack up to @num words of the name into @buf, padded with its length */
+static void str2hashbuf(const char *msg, int len, u32 *buf, int num,
+			bool is_unsigned)
+{
+	u32 pad, val;
+	int i, c;
+
+	pad = (u32)len | ((u32)len << 8);
+	pad |= pad << 16;
+
+	val = pad;
+	if (len > num * 4)
+		len = num * 4;
+	for (i = 0; i < len; i++) {
+		c = is_unsigned ? (int)(unsigned char)msg[i] :
+			(int)(signed char)msg[i];
+		val = c + (val << 8);
+		if ((i % 4) == 3) {
+			*buf++ = val;
+			val = pad;
+			num--;
+		}
+	}
+	if (--num >= 0)
+		*buf++ = val;
+	while (--num >= 0)
+		*buf++ = pad;
+}
+
+/**
+ * dx_hash() - get the hash of a name
+ *
+ * @name: Name to hash
+ * @len: Length of @name
+ * @version: Hash to use (enum dx_hash_version)
+ * @seed: Seed from the superblock, all zero to use the default one
+ * Return: hash, with the lowest bit clear, or 0 if @version is not known
+ */
+static u32 dx_hash(const char *name, int len, int version, const u32 seed[4])
+{
+	bool is_unsigned = version >= DX_HASH_LEGACY_UNSIGNED;
+	u32 buf[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+	u32 in[8], hash;
+
+	if (seed[0] || seed[1] || seed[2] || seed[3])
+		memcpy(buf, seed, sizeof(buf));
+
+	switch (version) {
+	case DX_HASH_LEGACY:
+	case DX_HASH_LEGACY_UNSIGNED:
+		hash = dx_hack_hash(name, len, is_unsigned);
+		break;
+	case DX_HASH_HALF_MD4:
+	case DX_HASH_HALF_MD4_UNSIGNED:
+		for (; len > 0; len -= 32, name += 32) {
+			str2hashbuf(name, len, in, 8, is_unsigned);
+			half_md4_transform(buf, in);
+		}
+		hash = buf[1];
+		break;
+	case DX_HASH_TEA:
+	case DX_HASH_TEA_UNSIGNED:
+		for (; len > 0; len -= 16, name += 16) {
+			str2hashbuf(name, len, in, 4, is_unsigned);
+			tea_transform(buf, in);
+		}
+		hash = buf[0];
+		break;
+	default:
+		return 0;
+	}
+
+	hash &= ~1;
+	if (hash == DX_HTREE_EOF << 1)
+		hash = (DX_HTREE_EOF - 1) << 1;
+
+	return hash;
+}
+
+/* Read directory block @blk into @buf */
+static int dx_read_block(struct ext2fs_node *dir, u32 blk, char *buf)
+{
+	int blksz = EXT2_BLOCK_SIZE(dir->data);
+	loff_t pos = (loff_t)blk * blksz;
+	loff_t actread;
+
+	if (pos + blksz > le32_to_cpu(dir->inode.size))
+		return -EINVAL;
+	if (ext4fs_read_file(dir, pos, blksz, buf, &actread) < 0 ||
+	    actread != blksz)
+		return -EIO;
+
+	return 0;
+}
+
+/*
+ * Get the entries of the table at @offset in @buf, checking that they fit.
+ * Return: number of entries, or -EINVAL
+ */
+static int dx_get_entries(char *buf, int blksz, int offset,
+			  struct dx_entry **entriesp)
+{
+	struct dx_entry *entries = (struct dx_entry *)(buf + offset);
+	u32 countlimit = le32_to_cpu(entries->hash);
+	int limit = countlimit & 0xffff;
+	int count = countlimit >> 16;
+
+	if (!count || count > limit ||
+	    limit > (blksz - offset) / (int)sizeof(*entries))
+		return -EINVAL;
+	*entriesp = entries;
+
+	return count;
+}
+
+/* Find the last entry whose hash is not above @hash */
+static int dx_search(const struct dx_entry *entries, int count, u32 hash)
+{
+	int lo = 1, hi = count - 1;
+
+	while (lo <= hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (le32_to_cpu(entries[mid].hash) > hash)
+			hi = mid - 1;
+		else
+			lo = mid + 1;
+	}
+
+	return lo - 1;
+}
+
+int ext4fs_htree_find(struct ext2fs_node *dir, char *name,
+		      struct ext2fs_node **fnode, int *ftype)
+{
+	struct ext2_sblock *sb = &dir->data->sblock;
+	int blksz = EXT2_BLOCK_SIZE(dir->data);
+	u32 flags = le32_to_cpu(dir->inode.flags);
+	struct dx_root_info *info;
+	struct dx_entry *entries;
+	int version, levels, count, at, level, ret;
+	u32 seed[4], hash, blk, next;
+	char *buf;
+	int i;
+
+	if (!(le32_to_cpu(sb->feature_compatibility) &
+	      EXT4_FEATURE_COMPAT_DIR_INDEX) || !(flags & EXT4_INDEX_FL))
+		return -ENOENT;
+
+	/* these hash the name differently */
+	if (flags & (EXT4_ENCRYPT_FL | EXT4_CASEFOLD_FL))
+		return -ENOTSUPP;
+
+	buf = malloc_cache_aligned(blksz);
+	if (!buf)
+		return -ENOMEM;
+	ret = dx_read_block(dir, 0, buf);
+	if (ret)
+		goto out;
+
+	ret = -EINVAL;
+	info = (struct dx_root_info *)(buf + DX_ROOT_INFO_OFFSET);
+	levels = info->indirect_levels;
+	if (info->reserved_zero || levels >= DX_MAX_LEVELS)
+		goto out;
+	version = info->hash_version;
+	if (version <= DX_HASH_TEA &&
+	    (le32_to_cpu(sb->flags) & EXT2_FLAGS_UNSIGNED_HASH))
+		version += DX_HASH_LEGACY_UNSIGNED;
+	for (i = 0; i < ARRAY_SIZE(seed); i++)
+		seed[i] = le32_to_cpu(sb->hash_seed[i]);
+	hash = dx_hash(name, strlen(name), version, seed);
+	if (!hash) {
+		ret = -ENOTSUPP;
+		goto out;
+	}
+
+	count = dx_get_entries(buf, blksz,
+			       DX_ROOT_INFO_OFFSET + info->info_length,
+			       &entries);
+	for (level = 0;; level++) {
+		if (count < 0)
+			goto out;
+		at = dx_search(entries, count, hash);
+		blk = le32_to_cpu(entries[at].block) & 0x0fffffff;
+		if (level == levels)
+			break;
+		ret = dx_read_block(dir, blk, buf);
+		if (ret)
+			goto out;
+		ret = -EINVAL;
+		count = dx_get_entries(buf, blksz, DX_NODE_OFFSET, &entries);
+	}
+
+	/*
+	 * Names with the same hash may carry on into the next blocks, which
+	 * then have the lowest bit of their hash set
+	 */
+	for (;;) {
+		ret = ext4fs_iterate_dir_range(dir, blk * blksz,
+					       (blk + 1) * blksz, name, fnode,
+					       ftype);
+		if (ret || ++at == count)
+			break;
+		next = le32_to_cpu(entries[at].hash);
+		if (!(next & 1) || (next & ~1) != hash)
+			break;
+		blk = le32_to_cpu(entries[at].block) & 0x0fffffff;
+	}
+
+	/*
+	 * The names with this hash may carry on under the next index block.
+	 * That is rare enough to leave to the linear scan.
+	 */
+	if (!ret && at == count && levels) {
+		log_debug("'%s' not found at end of index block\n", name);
+		ret = -EAGAIN;
+	}
+out:
+	free(buf);
+
+	return ret;
+}
@@ -20,6 +20,9 @@
 #include <ext_common.h>
 #include "ext4_common.h"
 
+/* Most journal blocks written to the disk at once */
+#define JOURNAL_WRITE_BLOCKS	16
+
 static struct revoke_blk_list *revk_blk_list;
 static struct revoke_blk_list *prev_node;
 static int first_node = true;
@@ -164,6 +167,10 @@ int ext4fs_log_journal(char *journal_buffer, uint32_t blknr)
 		if (journal_ptr[i]->blknr == blknr)
 			return 0;
 	}
+	if (gindex == MAX_JOURNAL_ENTRIES) {
+		printf("Too many blocks for one journal transaction\n");
+		return -ENOSPC;
+	}
 
 	journal_ptr[gindex]->buf = zalloc(fs->blksz);
 	if (!journal_ptr[gindex]->buf)
@@ -176,26 +183,61 @@ int ext4fs_log_journal(char *journal_buffer, uint32_t blknr)
 }
 
 /*
- * This function stores the modified meta data in RAM
+ * This function stores the modified meta data in RAM, replacing any copy
+ * stored earlier in the same transaction
  * metadata_buffer -- Buffer containing meta data
  * blknr -- Block number on disk of the meta data buffer
  */
 int ext4fs_put_metadata(char *metadata_buffer, uint32_t blknr)
 {
 	struct ext_filesystem *fs = get_fs();
+	int i;
+
 	if (!metadata_buffer) {
 		printf("Invalid input arguments %s\n", __func__);
 		return -EINVAL;
 	}
-	if (dirty_block_ptr[gd_index]->buf)
-		assert(dirty_block_ptr[gd_index]->blknr == blknr);
-	else
-		dirty_block_ptr[gd_index]->buf = zalloc(fs->blksz);
+	for (i = 0; i < gd_index; i++) {
+		if (dirty_block_ptr[i]->blknr == blknr)
+			break;
+	}
+	if (i == gd_index) {
+		if (gd_index == MAX_JOURNAL_ENTRIES) {
+			printf("Too many blocks for one journal transaction\n");
+			return -ENOSPC;
+		}
+		dirty_block_ptr[i]->buf = zalloc(fs->blksz);
+		if (!dirty_block_ptr[i]->buf)
+			return -ENOMEM;
+		dirty_block_ptr[i]->blknr = blknr;
+		gd_index++;
+	}
+	memcpy(dirty_block_ptr[i]->buf, metadata_buffer, fs->blksz);
 
-	if (!dirty_block_ptr[gd_index]->buf)
-		return -ENOMEM;
-	memcpy(dirty_block_ptr[gd_index]->buf, metadata_buffer, fs->blksz);
-	dirty_block_ptr[gd_index++]->blknr = blknr;
+	return 0;
+}
+
+/*
+ * This function reads a meta data block, taking the copy stored by
+ * ext4fs_put_metadata() if the block was changed in this transaction
+ * metadata_buffer -- Buffer of one block to read into
+ * blknr -- Block number on disk of the meta data buffer
+ */
+int ext4fs_read_metadata(char *metadata_buffer, uint32_t blknr)
+{
+	struct ext_filesystem *fs = get_fs();
+	int i;
+
+	for (i = 0; i < gd_index; i++) {
+		if (dirty_block_ptr[i]->blknr == blknr) {
+			memcpy(metadata_buffer, dirty_block_ptr[i]->buf,
+			       fs->blksz);
+			return 0;
+		}
+	}
+	if (!ext4fs_devread((lbaint_t)blknr * fs->sect_perblk, 0, fs->blksz,
+			    metadata_buffer))
+		return -EIO;
 
 	return 0;
 }
@@ -549,37 +591,18 @@ end:
 	return 0;
 }
 
-static void update_descriptor_block(long int blknr)
+static void update_descriptor_block(char *buf, __be32 sequence)
 {
 	int i;
-	long int jsb_blknr;
 	struct journal_header_t jdb;
 	struct ext3_journal_block_tag tag;
-	struct ext2_inode inode_journal;
-	struct journal_superblock_t *jsb = NULL;
-	char *buf = NULL;
-	char *temp = NULL;
 	struct ext_filesystem *fs = get_fs();
-	char *temp_buff = zalloc(fs->blksz);
-	if (!temp_buff)
-		return;
-
-	ext4fs_read_inode(ext4fs_root, EXT2_JOURNAL_INO, &inode_journal);
-	jsb_blknr = read_allocated_block(&inode_journal,
-					 EXT2_JOURNAL_SUPERBLOCK, NULL);
-	ext4fs_devread((lbaint_t)jsb_blknr * fs->sect_perblk, 0, fs->blksz,
-		       temp_buff);
-	jsb = (struct journal_superblock_t *) temp_buff;
+	char *temp = buf;
 
 	jdb.h_blocktype = cpu_to_be32(EXT3_JOURNAL_DESCRIPTOR_BLOCK);
 	jdb.h_magic = cpu_to_be32(EXT3_JOURNAL_MAGIC_NUMBER);
-	jdb.h_sequence = jsb->s_sequence;
-	buf = zalloc(fs->blksz);
-	if (!buf) {
-		free(temp_buff);
-		return;
-	}
-	temp = buf;
+	jdb.h_sequence = sequence;
+	memset(buf, '\0', fs->blksz);
 	memcpy(buf, &jdb, sizeof(struct journal_header_t));
 	temp += sizeof(struct journal_header_t);
 
@@ -597,69 +620,105 @@ static void update_descriptor_block(long int blknr)
 	tag.flags = cpu_to_be32(EXT3_JOURNAL_FLAG_LAST_TAG);
 	memcpy(temp - sizeof(struct ext3_journal_block_tag), &tag,
 	       sizeof(struct ext3_journal_block_tag));
-	put_ext4((uint64_t) ((uint64_t)blknr * (uint64_t)fs->blksz), buf, (uint32_t) fs->blksz);
-
-	free(temp_buff);
-	free(buf);
 }
 
-static void update_commit_block(long int blknr)
+static void update_commit_block(char *buf, __be32 sequence)
 {
 	struct journal_header_t jdb;
 	struct ext_filesystem *fs = get_fs();
-	char *buf = NULL;
-	struct ext2_inode inode_journal;
-	struct journal_superblock_t *jsb;
-	long int jsb_blknr;
-	char *temp_buff = zalloc(fs->blksz);
-	if (!temp_buff)
-		return;
-
-	ext4fs_read_inode(ext4fs_root, EXT2_JOURNAL_INO,
-			  &inode_journal);
-	jsb_blknr = read_allocated_block(&inode_journal,
-					 EXT2_JOURNAL_SUPERBLOCK, NULL);
-	ext4fs_devread((lbaint_t)jsb_blknr * fs->sect_perblk, 0, fs->blksz,
-		       temp_buff);
-	jsb = (struct journal_superblock_t *) temp_buff;
 
 	jdb.h_blocktype = cpu_to_be32(EXT3_JOURNAL_COMMIT_BLOCK);
 	jdb.h_magic = cpu_to_be32(EXT3_JOURNAL_MAGIC_NUMBER);
-	jdb.h_sequence = jsb->s_sequence;
-	buf = zalloc(fs->blksz);
-	if (!buf) {
-		free(temp_buff);
-		return;
-	}
+	jdb.h_sequence = sequence;
+	memset(buf, '\0', fs->blksz);
 	memcpy(buf, &jdb, sizeof(struct journal_header_t));
-	put_ext4((uint64_t) ((uint64_t)blknr * (uint64_t)fs->blksz), buf, (uint32_t) fs->blksz);
+}
 
-	free(temp_buff);
-	free(buf);
+/**
+ * struct journal_writer - journal blocks waiting to be written
+ *
+ * Blocks which follow each other on the disk are collected here, so that
+ * they go out in one write.
+ *
+ * @buf: Contents of the blocks, JOURNAL_WRITE_BLOCKS blocks long
+ * @start: Disk block of the first block in @buf
+ * @count: Number of blocks in @buf
+ */
+struct journal_writer {
+	char *buf;
+	long int start;
+	int count;
+};
+
+static void journal_flush(struct journal_writer *jw)
+{
+	struct ext_filesystem *fs = get_fs();
+
+	if (jw->count)
+		put_ext4((uint64_t)jw->start * fs->blksz, jw->buf,
+			 jw->count * fs->blksz);
+	jw->count = 0;
+}
+
+/* Get the place in @jw->buf for the journal block at disk block @blknr */
+static char *journal_next(struct journal_writer *jw, long int blknr)
+{
+	struct ext_filesystem *fs = get_fs();
+
+	if (jw->count == JOURNAL_WRITE_BLOCKS ||
+	    (jw->count && jw->start + jw->count != blknr))
+		journal_flush(jw);
+	if (!jw->count)
+		jw->start = blknr;
+
+	return jw->buf + jw->count++ * fs->blksz;
 }
 
 void ext4fs_update_journal(void)
 {
 	struct ext2_inode inode_journal;
 	struct ext_filesystem *fs = get_fs();
+	struct journal_superblock_t *jsb;
+	struct ext_block_cache cache;
+	struct journal_writer jw;
+	__be32 sequence;
 	long int blknr;
 	int i;
 
 	if (!(fs->sb->feature_compatibility & EXT4_FEATURE_COMPAT_HAS_JOURNAL))
 		return;
 
+	jw.buf = malloc(JOURNAL_WRITE_BLOCKS * fs->blksz);
+	if (!jw.buf)
+		return;
+	jw.count = 0;
+	ext_cache_init(&cache);
+
 	ext4fs_read_inode(ext4fs_root, EXT2_JOURNAL_INO, &inode_journal);
-	blknr = read_allocated_block(&inode_journal, jrnl_blk_idx++, NULL);
-	update_descriptor_block(blknr);
+	blknr = read_allocated_block(&inode_journal, EXT2_JOURNAL_SUPERBLOCK,
+				     &cache);
+	if (blknr <= 0 ||
+	    !ext4fs_devread((lbaint_t)blknr * fs->sect_perblk, 0, fs->blksz,
+			    jw.buf))
+		goto out;
+	jsb = (struct journal_superblock_t *)jw.buf;
+	sequence = jsb->s_sequence;
+
+	blknr = read_allocated_block(&inode_journal, jrnl_blk_idx++, &cache);
+	update_descriptor_block(journal_next(&jw, blknr), sequence);
 	for (i = 0; i < MAX_JOURNAL_ENTRIES; i++) {
 		if (journal_ptr[i]->blknr == -1)
 			break;
 		blknr = read_allocated_block(&inode_journal, jrnl_blk_idx++,
-					     NULL);
-		put_ext4((uint64_t) ((uint64_t)blknr * (uint64_t)fs->blksz),
-			 journal_ptr[i]->buf, fs->blksz);
+					     &cache);
+		memcpy(journal_next(&jw, blknr), journal_ptr[i]->buf,
+		       fs->blksz);
 	}
-	blknr = read_allocated_block(&inode_journal, jrnl_blk_idx++, NULL);
-	update_commit_block(blknr);
+	blknr = read_allocated_block(&inode_journal, jrnl_blk_idx++, &cache);
+	update_commit_block(journal_next(&jw, blknr), sequence);
+	journal_flush(&jw);
 	printf("update journal finished\n");
+out:
+	ext_cache_fini(&cache);
+	free(jw.buf);
 }
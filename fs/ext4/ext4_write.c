@@ -65,6 +65,30 @@ static inline void ext4fs_bg_free_blocks_inc
 		bg->free_blocks_high = cpu_to_le16(free_blocks >> 16);
 }
 
+/* Release a block, updating its bitmap and the free counts */
+static int ext4fs_free_block(uint32_t blknr)
+{
+	uint32_t blk_per_grp = le32_to_cpu(ext4fs_root->sblock.blocks_per_group);
+	struct ext_filesystem *fs = get_fs();
+	struct ext2_block_group *bgd;
+	unsigned char *bmap;
+	int bg_idx;
+
+	bg_idx = blknr / blk_per_grp;
+	if (fs->blksz == 1024 && !(blknr % blk_per_grp))
+		bg_idx--;
+	bmap = ext4fs_get_blk_bmap(bg_idx);
+	if (!bmap)
+		return -EIO;
+	ext4fs_reset_block_bmap(blknr, bmap, bg_idx);
+
+	bgd = ext4fs_get_group_descriptor(fs, bg_idx);
+	ext4fs_bg_free_blocks_inc(bgd, fs);
+	ext4fs_sb_free_blocks_inc(fs->sb);
+
+	return 0;
+}
+
 static void ext4fs_update(void)
 {
 	short i;
@@ -76,21 +100,16 @@ static void ext4fs_update(void)
 	put_ext4((uint64_t)(SUPERBLOCK_SIZE),
 		 (struct ext2_sblock *)fs->sb, (uint32_t)SUPERBLOCK_SIZE);
 
-	/* update block bitmaps */
+	/* update the bitmaps read in this session */
 	for (i = 0; i < fs->no_blkgrp; i++) {
 		bgd = ext4fs_get_group_descriptor(fs, i);
 		bgd->bg_checksum = cpu_to_le16(ext4fs_checksum_update(i));
-		uint64_t b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
-		put_ext4(b_bitmap_blk * fs->blksz,
-			 fs->blk_bmaps[i], fs->blksz);
-	}
-
-	/* update inode bitmaps */
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		bgd = ext4fs_get_group_descriptor(fs, i);
-		uint64_t i_bitmap_blk = ext4fs_bg_get_inode_id(bgd, fs);
-		put_ext4(i_bitmap_blk * fs->blksz,
-			 fs->inode_bmaps[i], fs->blksz);
+		if (fs->blk_bmaps[i])
+			put_ext4(ext4fs_bg_get_block_id(bgd, fs) * fs->blksz,
+				 fs->blk_bmaps[i], fs->blksz);
+		if (fs->inode_bmaps[i])
+			put_ext4(ext4fs_bg_get_inode_id(bgd, fs) * fs->blksz,
+				 fs->inode_bmaps[i], fs->blksz);
 	}
 
 	/* update the block group descriptor table */
@@ -134,330 +153,142 @@ fail:
 	return -1;
 }
 
-static void delete_single_indirect_block(struct ext2_inode *inode)
+static int delete_single_indirect_block(struct ext2_inode *inode)
 {
-	struct ext2_block_group *bgd = NULL;
-	static int prev_bg_bmap_idx = -1;
 	uint32_t blknr;
-	int remainder;
-	int bg_idx;
-	int status;
-	uint32_t blk_per_grp = le32_to_cpu(ext4fs_root->sblock.blocks_per_group);
-	struct ext_filesystem *fs = get_fs();
-	char *journal_buffer = zalloc(fs->blksz);
-	if (!journal_buffer) {
-		printf("No memory\n");
-		return;
-	}
 
 	/* deleting the single indirect block associated with inode */
-	if (inode->b.blocks.indir_block != 0) {
-		blknr = le32_to_cpu(inode->b.blocks.indir_block);
-		debug("SIPB releasing %u\n", blknr);
-		bg_idx = blknr / blk_per_grp;
-		if (fs->blksz == 1024) {
-			remainder = blknr % blk_per_grp;
-			if (!remainder)
-				bg_idx--;
-		}
-		ext4fs_reset_block_bmap(blknr, fs->blk_bmaps[bg_idx], bg_idx);
-		/* get  block group descriptor table */
-		bgd = ext4fs_get_group_descriptor(fs, bg_idx);
-		ext4fs_bg_free_blocks_inc(bgd, fs);
-		ext4fs_sb_free_blocks_inc(fs->sb);
-		/* journal backup */
-		if (prev_bg_bmap_idx != bg_idx) {
-			uint64_t b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
-			status = ext4fs_devread(
-					   b_bitmap_blk * fs->sect_perblk,
-					   0, fs->blksz, journal_buffer);
-			if (status == 0)
-				goto fail;
-			if (ext4fs_log_journal(journal_buffer, b_bitmap_blk))
-				goto fail;
-			prev_bg_bmap_idx = bg_idx;
-		}
-	}
-fail:
-	free(journal_buffer);
+	if (inode->b.blocks.indir_block == 0)
+		return 0;
+	blknr = le32_to_cpu(inode->b.blocks.indir_block);
+	debug("SIPB releasing %u\n", blknr);
+
+	return ext4fs_free_block(blknr);
 }
 
-static void delete_double_indirect_block(struct ext2_inode *inode)
+static int delete_double_indirect_block(struct ext2_inode *inode)
 {
 	int i;
-	short status;
-	static int prev_bg_bmap_idx = -1;
 	uint32_t blknr;
-	int remainder;
-	int bg_idx;
-	uint32_t blk_per_grp = le32_to_cpu(ext4fs_root->sblock.blocks_per_group);
-	__le32 *di_buffer = NULL;
-	void *dib_start_addr = NULL;
-	struct ext2_block_group *bgd = NULL;
+	__le32 *di_buffer;
 	struct ext_filesystem *fs = get_fs();
-	char *journal_buffer = zalloc(fs->blksz);
-	if (!journal_buffer) {
+	int ret = 0;
+
+	if (inode->b.blocks.double_indir_block == 0)
+		return 0;
+	di_buffer = zalloc(fs->blksz);
+	if (!di_buffer) {
 		printf("No memory\n");
-		return;
+		return -ENOMEM;
 	}
-
-	if (inode->b.blocks.double_indir_block != 0) {
-		di_buffer = zalloc(fs->blksz);
-		if (!di_buffer) {
-			printf("No memory\n");
-			return;
-		}
-		dib_start_addr = di_buffer;
-		blknr = le32_to_cpu(inode->b.blocks.double_indir_block);
-		status = ext4fs_devread((lbaint_t)blknr * fs->sect_perblk, 0,
-					fs->blksz, (char *)di_buffer);
-		for (i = 0; i < fs->blksz / sizeof(int); i++) {
-			if (*di_buffer == 0)
-				break;
-
-			debug("DICB releasing %u\n", *di_buffer);
-			bg_idx = le32_to_cpu(*di_buffer) / blk_per_grp;
-			if (fs->blksz == 1024) {
-				remainder = le32_to_cpu(*di_buffer) % blk_per_grp;
-				if (!remainder)
-					bg_idx--;
-			}
-			/* get  block group descriptor table */
-			bgd = ext4fs_get_group_descriptor(fs, bg_idx);
-			ext4fs_reset_block_bmap(le32_to_cpu(*di_buffer),
-					fs->blk_bmaps[bg_idx], bg_idx);
-			di_buffer++;
-			ext4fs_bg_free_blocks_inc(bgd, fs);
-			ext4fs_sb_free_blocks_inc(fs->sb);
-			/* journal backup */
-			if (prev_bg_bmap_idx != bg_idx) {
-				uint64_t b_bitmap_blk =
-					ext4fs_bg_get_block_id(bgd, fs);
-				status = ext4fs_devread(b_bitmap_blk
-							* fs->sect_perblk, 0,
-							fs->blksz,
-							journal_buffer);
-				if (status == 0)
-					goto fail;
-
-				if (ext4fs_log_journal(journal_buffer,
-						       b_bitmap_blk))
-					goto fail;
-				prev_bg_bmap_idx = bg_idx;
-			}
-		}
-
-		/* removing the parent double indirect block */
-		blknr = le32_to_cpu(inode->b.blocks.double_indir_block);
-		bg_idx = blknr / blk_per_grp;
-		if (fs->blksz == 1024) {
-			remainder = blknr % blk_per_grp;
-			if (!remainder)
-				bg_idx--;
-		}
-		/* get  block group descriptor table */
-		bgd = ext4fs_get_group_descriptor(fs, bg_idx);
-		ext4fs_reset_block_bmap(blknr, fs->blk_bmaps[bg_idx], bg_idx);
-		ext4fs_bg_free_blocks_inc(bgd, fs);
-		ext4fs_sb_free_blocks_inc(fs->sb);
-		/* journal backup */
-		if (prev_bg_bmap_idx != bg_idx) {
-			uint64_t b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
-			status = ext4fs_devread(b_bitmap_blk * fs->sect_perblk,
-						0, fs->blksz, journal_buffer);
-			if (status == 0)
-				goto fail;
-
-			if (ext4fs_log_journal(journal_buffer, b_bitmap_blk))
-				goto fail;
-			prev_bg_bmap_idx = bg_idx;
-		}
-		debug("DIPB releasing %d\n", blknr);
+	blknr = le32_to_cpu(inode->b.blocks.double_indir_block);
+	if (!ext4fs_devread((lbaint_t)blknr * fs->sect_perblk, 0, fs->blksz,
+			    (char *)di_buffer)) {
+		ret = -EIO;
+		goto fail;
 	}
+	for (i = 0; i < fs->blksz / sizeof(int); i++) {
+		if (di_buffer[i] == 0)
+			break;
+		debug("DICB releasing %u\n", le32_to_cpu(di_buffer[i]));
+		ret = ext4fs_free_block(le32_to_cpu(di_buffer[i]));
+		if (ret)
+			goto fail;
+	}
+
+	/* removing the parent double indirect block */
+	debug("DIPB releasing %d\n", blknr);
+	ret = ext4fs_free_block(blknr);
 fail:
-	free(dib_start_addr);
-	free(journal_buffer);
+	free(di_buffer);
+
+	return ret;
 }
 
-static void delete_triple_indirect_block(struct ext2_inode *inode)
+static int delete_triple_indirect_block(struct ext2_inode *inode)
 {
 	int i, j;
-	short status;
-	static int prev_bg_bmap_idx = -1;
 	uint32_t blknr;
-	int remainder;
-	int bg_idx;
-	uint32_t blk_per_grp = le32_to_cpu(ext4fs_root->sblock.blocks_per_group);
-	__le32 *tigp_buffer = NULL;
-	void *tib_start_addr = NULL;
-	__le32 *tip_buffer = NULL;
-	void *tipb_start_addr = NULL;
-	struct ext2_block_group *bgd = NULL;
+	__le32 *tigp_buffer;
+	__le32 *tip_buffer;
 	struct ext_filesystem *fs = get_fs();
-	char *journal_buffer = zalloc(fs->blksz);
-	if (!journal_buffer) {
+	int ret = 0;
+
+	if (inode->b.blocks.triple_indir_block == 0)
+		return 0;
+	tigp_buffer = zalloc(fs->blksz);
+	tip_buffer = zalloc(fs->blksz);
+	if (!tigp_buffer || !tip_buffer) {
 		printf("No memory\n");
-		return;
+		ret = -ENOMEM;
+		goto fail;
 	}
+	blknr = le32_to_cpu(inode->b.blocks.triple_indir_block);
+	if (!ext4fs_devread((lbaint_t)blknr * fs->sect_perblk, 0, fs->blksz,
+			    (char *)tigp_buffer)) {
+		ret = -EIO;
+		goto fail;
+	}
+	for (i = 0; i < fs->blksz / sizeof(int); i++) {
+		if (tigp_buffer[i] == 0)
+			break;
+		debug("tigp buffer releasing %u\n", le32_to_cpu(tigp_buffer[i]));
 
-	if (inode->b.blocks.triple_indir_block != 0) {
-		tigp_buffer = zalloc(fs->blksz);
-		if (!tigp_buffer) {
-			printf("No memory\n");
-			return;
+		if (!ext4fs_devread((lbaint_t)le32_to_cpu(tigp_buffer[i]) *
+				    fs->sect_perblk, 0, fs->blksz,
+				    (char *)tip_buffer)) {
+			ret = -EIO;
+			goto fail;
 		}
-		tib_start_addr = tigp_buffer;
-		blknr = le32_to_cpu(inode->b.blocks.triple_indir_block);
-		status = ext4fs_devread((lbaint_t)blknr * fs->sect_perblk, 0,
-					fs->blksz, (char *)tigp_buffer);
-		for (i = 0; i < fs->blksz / sizeof(int); i++) {
-			if (*tigp_buffer == 0)
+		for (j = 0; j < fs->blksz / sizeof(int); j++) {
+			if (tip_buffer[j] == 0)
 				break;
-			debug("tigp buffer releasing %u\n", *tigp_buffer);
-
-			tip_buffer = zalloc(fs->blksz);
-			if (!tip_buffer)
+			ret = ext4fs_free_block(le32_to_cpu(tip_buffer[j]));
+			if (ret)
 				goto fail;
-			tipb_start_addr = tip_buffer;
-			status = ext4fs_devread((lbaint_t)le32_to_cpu(*tigp_buffer) *
-						fs->sect_perblk, 0, fs->blksz,
-						(char *)tip_buffer);
-			for (j = 0; j < fs->blksz / sizeof(int); j++) {
-				if (le32_to_cpu(*tip_buffer) == 0)
-					break;
-				bg_idx = le32_to_cpu(*tip_buffer) / blk_per_grp;
-				if (fs->blksz == 1024) {
-					remainder = le32_to_cpu(*tip_buffer) % blk_per_grp;
-					if (!remainder)
-						bg_idx--;
-				}
-
-				ext4fs_reset_block_bmap(le32_to_cpu(*tip_buffer),
-							fs->blk_bmaps[bg_idx],
-							bg_idx);
-
-				tip_buffer++;
-				/* get  block group descriptor table */
-				bgd = ext4fs_get_group_descriptor(fs, bg_idx);
-				ext4fs_bg_free_blocks_inc(bgd, fs);
-				ext4fs_sb_free_blocks_inc(fs->sb);
-				/* journal backup */
-				if (prev_bg_bmap_idx != bg_idx) {
-					uint64_t b_bitmap_blk =
-						ext4fs_bg_get_block_id(bgd, fs);
-					status =
-					    ext4fs_devread(
-							b_bitmap_blk *
-							fs->sect_perblk, 0,
-							fs->blksz,
-							journal_buffer);
-					if (status == 0)
-						goto fail;
-
-					if (ext4fs_log_journal(journal_buffer,
-							       b_bitmap_blk))
-						goto fail;
-					prev_bg_bmap_idx = bg_idx;
-				}
-			}
-			free(tipb_start_addr);
-			tipb_start_addr = NULL;
-
-			/*
-			 * removing the grand parent blocks
-			 * which is connected to inode
-			 */
-			bg_idx = le32_to_cpu(*tigp_buffer) / blk_per_grp;
-			if (fs->blksz == 1024) {
-				remainder = le32_to_cpu(*tigp_buffer) % blk_per_grp;
-				if (!remainder)
-					bg_idx--;
-			}
-			ext4fs_reset_block_bmap(le32_to_cpu(*tigp_buffer),
-						fs->blk_bmaps[bg_idx], bg_idx);
-
-			tigp_buffer++;
-			/* get  block group descriptor table */
-			bgd = ext4fs_get_group_descriptor(fs, bg_idx);
-			ext4fs_bg_free_blocks_inc(bgd, fs);
-			ext4fs_sb_free_blocks_inc(fs->sb);
-			/* journal backup */
-			if (prev_bg_bmap_idx != bg_idx) {
-				uint64_t b_bitmap_blk =
-					ext4fs_bg_get_block_id(bgd, fs);
-				memset(journal_buffer, '\0', fs->blksz);
-				status = ext4fs_devread(b_bitmap_blk *
-							fs->sect_perblk, 0,
-							fs->blksz,
-							journal_buffer);
-				if (status == 0)
-					goto fail;
-
-				if (ext4fs_log_journal(journal_buffer,
-						       b_bitmap_blk))
-					goto fail;
-				prev_bg_bmap_idx = bg_idx;
-			}
-		}
-
-		/* removing the grand parent triple indirect block */
-		blknr = le32_to_cpu(inode->b.blocks.triple_indir_block);
-		bg_idx = blknr / blk_per_grp;
-		if (fs->blksz == 1024) {
-			remainder = blknr % blk_per_grp;
-			if (!remainder)
-				bg_idx--;
 		}
-		ext4fs_reset_block_bmap(blknr, fs->blk_bmaps[bg_idx], bg_idx);
-		/* get  block group descriptor table */
-		bgd = ext4fs_get_group_descriptor(fs, bg_idx);
-		ext4fs_bg_free_blocks_inc(bgd, fs);
-		ext4fs_sb_free_blocks_inc(fs->sb);
-		/* journal backup */
-		if (prev_bg_bmap_idx != bg_idx) {
-			uint64_t b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
-			status = ext4fs_devread(b_bitmap_blk * fs->sect_perblk,
-						0, fs->blksz, journal_buffer);
-			if (status == 0)
-				goto fail;
 
-			if (ext4fs_log_journal(journal_buffer, b_bitmap_blk))
-				goto fail;
-			prev_bg_bmap_idx = bg_idx;
-		}
-		debug("tigp buffer itself releasing %d\n", blknr);
+		/*
+		 * removing the grand parent blocks
+		 * which is connected to inode
+		 */
+		ret = ext4fs_free_block(le32_to_cpu(tigp_buffer[i]));
+		if (ret)
+			goto fail;
 	}
+
+	/* removing the grand parent triple indirect block */
+	debug("tigp buffer itself releasing %d\n", blknr);
+	ret = ext4fs_free_block(blknr);
 fail:
-	free(tib_start_addr);
-	free(tipb_start_addr);
-	free(journal_buffer);
+	free(tigp_buffer);
+	free(tip_buffer);
+
+	return ret;
 }
 
 static int ext4fs_delete_file(int inodeno)
 {
 	struct ext2_inode inode;
+	struct ext_block_cache cache;
 	short status;
 	int i;
-	int remainder;
 	long int blknr;
-	int bg_idx;
 	int ibmap_idx;
 	char *read_buffer = NULL;
 	char *start_block_address = NULL;
+	unsigned char *bmap;
 	uint32_t no_blocks;
 
-	static int prev_bg_bmap_idx = -1;
 	unsigned int inodes_per_block;
 	uint32_t blkno;
 	unsigned int blkoff;
-	uint32_t blk_per_grp = le32_to_cpu(ext4fs_root->sblock.blocks_per_group);
 	uint32_t inode_per_grp = le32_to_cpu(ext4fs_root->sblock.inodes_per_group);
 	struct ext2_inode *inode_buffer = NULL;
 	struct ext2_block_group *bgd = NULL;
 	struct ext_filesystem *fs = get_fs();
-	char *journal_buffer = zalloc(fs->blksz);
-	if (!journal_buffer)
-		return -ENOMEM;
+
+	ext_cache_init(&cache);
 	status = ext4fs_read_inode(ext4fs_root, inodeno, &inode);
 	if (status == 0)
 		goto fail;
@@ -477,50 +308,37 @@ static int ext4fs_delete_file(int inodeno)
 	}
 
 	if (le32_to_cpu(inode.flags) & EXT4_EXTENTS_FL) {
-		/* FIXME delete extent index blocks, i.e. eh_depth >= 1 */
 		struct ext4_extent_header *eh =
 			(struct ext4_extent_header *)
 				inode.b.blocks.dir_blocks;
+		struct ext4_extent_idx *idx = (struct ext4_extent_idx *)(eh + 1);
+
 		debug("del: dep=%d entries=%d\n", eh->eh_depth, eh->eh_entries);
+		/* FIXME delete extent index blocks, i.e. eh_depth >= 2 */
+		if (le16_to_cpu(eh->eh_depth) == 1) {
+			for (i = 0; i < le16_to_cpu(eh->eh_entries); i++) {
+				if (ext4fs_free_block(
+					le32_to_cpu(idx[i].ei_leaf_lo)))
+					goto fail;
+			}
+		}
 	} else {
-		delete_single_indirect_block(&inode);
-		delete_double_indirect_block(&inode);
-		delete_triple_indirect_block(&inode);
+		if (delete_single_indirect_block(&inode) ||
+		    delete_double_indirect_block(&inode) ||
+		    delete_triple_indirect_block(&inode))
+			goto fail;
 	}
 
 	/* release data blocks */
 	for (i = 0; i < no_blocks; i++) {
-		blknr = read_allocated_block(&inode, i, NULL);
+		blknr = read_allocated_block(&inode, i, &cache);
 		if (blknr == 0)
 			continue;
 		if (blknr < 0)
 			goto fail;
-		bg_idx = blknr / blk_per_grp;
-		if (fs->blksz == 1024) {
-			remainder = blknr % blk_per_grp;
-			if (!remainder)
-				bg_idx--;
-		}
-		ext4fs_reset_block_bmap(blknr, fs->blk_bmaps[bg_idx],
-					bg_idx);
-		debug("EXT4 Block releasing %ld: %d\n", blknr, bg_idx);
-
-		/* get  block group descriptor table */
-		bgd = ext4fs_get_group_descriptor(fs, bg_idx);
-		ext4fs_bg_free_blocks_inc(bgd, fs);
-		ext4fs_sb_free_blocks_inc(fs->sb);
-		/* journal backup */
-		if (prev_bg_bmap_idx != bg_idx) {
-			uint64_t b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
-			status = ext4fs_devread(b_bitmap_blk * fs->sect_perblk,
-						0, fs->blksz,
-						journal_buffer);
-			if (status == 0)
-				goto fail;
-			if (ext4fs_log_journal(journal_buffer, b_bitmap_blk))
-				goto fail;
-			prev_bg_bmap_idx = bg_idx;
-		}
+		debug("EXT4 Block releasing %ld\n", blknr);
+		if (ext4fs_free_block(blknr))
+			goto fail;
 	}
 
 	/* release inode */
@@ -543,9 +361,7 @@ static int ext4fs_delete_file(int inodeno)
 	if (!read_buffer)
 		goto fail;
 	start_block_address = read_buffer;
-	status = ext4fs_devread((lbaint_t)blkno * fs->sect_perblk,
-				0, fs->blksz, read_buffer);
-	if (status == 0)
+	if (ext4fs_read_metadata(read_buffer, blkno))
 		goto fail;
 
 	if (ext4fs_log_journal(read_buffer, blkno))
@@ -561,41 +377,32 @@ static int ext4fs_delete_file(int inodeno)
 
 	/* update the respective inode bitmaps */
 	inodeno++;
-	ext4fs_reset_inode_bmap(inodeno, fs->inode_bmaps[ibmap_idx], ibmap_idx);
+	bmap = ext4fs_get_inode_bmap(ibmap_idx);
+	if (!bmap)
+		goto fail;
+	ext4fs_reset_inode_bmap(inodeno, bmap, ibmap_idx);
 	ext4fs_bg_free_inodes_inc(bgd, fs);
 	ext4fs_sb_free_inodes_inc(fs->sb);
-	/* journal backup */
-	memset(journal_buffer, '\0', fs->blksz);
-	status = ext4fs_devread(ext4fs_bg_get_inode_id(bgd, fs) *
-				fs->sect_perblk, 0, fs->blksz, journal_buffer);
-	if (status == 0)
-		goto fail;
-	if (ext4fs_log_journal(journal_buffer, ext4fs_bg_get_inode_id(bgd, fs)))
-		goto fail;
 
-	ext4fs_update();
-	ext4fs_deinit();
+	/*
+	 * The new file is written in the same transaction and may get the
+	 * freed blocks, so forget the indirect blocks read from them
+	 */
 	ext4fs_reinit_global();
 
-	if (ext4fs_init() != 0) {
-		printf("error in File System init\n");
-		goto fail;
-	}
-
+	ext_cache_fini(&cache);
 	free(start_block_address);
-	free(journal_buffer);
 
 	return 0;
 fail:
+	ext_cache_fini(&cache);
 	free(start_block_address);
-	free(journal_buffer);
 
 	return -1;
 }
 
 int ext4fs_init(void)
 {
-	short status;
 	int i;
 	uint32_t real_free_blocks = 0;
 	struct ext_filesystem *fs = get_fs();
@@ -628,46 +435,13 @@ int ext4fs_init(void)
 		goto fail;
 	}
 
-	/* load all the available bitmap block of the partition */
+	/* the bitmaps are read as they are needed */
 	fs->blk_bmaps = zalloc(fs->no_blkgrp * sizeof(char *));
 	if (!fs->blk_bmaps)
 		goto fail;
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		fs->blk_bmaps[i] = zalloc(fs->blksz);
-		if (!fs->blk_bmaps[i])
-			goto fail;
-	}
-
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		struct ext2_block_group *bgd =
-			ext4fs_get_group_descriptor(fs, i);
-		status = ext4fs_devread(ext4fs_bg_get_block_id(bgd, fs) *
-				   fs->sect_perblk, 0,
-				   fs->blksz, (char *)fs->blk_bmaps[i]);
-		if (status == 0)
-			goto fail;
-	}
-
-	/* load all the available inode bitmap of the partition */
 	fs->inode_bmaps = zalloc(fs->no_blkgrp * sizeof(unsigned char *));
 	if (!fs->inode_bmaps)
 		goto fail;
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		fs->inode_bmaps[i] = zalloc(fs->blksz);
-		if (!fs->inode_bmaps[i])
-			goto fail;
-	}
-
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		struct ext2_block_group *bgd =
-			ext4fs_get_group_descriptor(fs, i);
-		status = ext4fs_devread(ext4fs_bg_get_inode_id(bgd, fs) *
-					fs->sect_perblk,
-					0, fs->blksz,
-					(char *)fs->inode_bmaps[i]);
-		if (status == 0)
-			goto fail;
-	}
 
 	/*
 	 * check filesystem consistency with free blocks of file system
@@ -775,6 +549,7 @@ static int ext4fs_write_file(struct ext2_inode *file_inode,
 	int delayed_extent = 0;
 	int delayed_next = 0;
 	const char *delayed_buf = NULL;
+	struct ext_block_cache cache;
 
 	/* Adjust len so it we can't read past the end of the file. */
 	if (len > filesize)
@@ -782,13 +557,16 @@ static int ext4fs_write_file(struct ext2_inode *file_inode,
 
 	blockcnt = ((len + pos) + fs->blksz - 1) / fs->blksz;
 
+	ext_cache_init(&cache);
 	for (i = pos / fs->blksz; i < blockcnt; i++) {
 		long int blknr;
 		int blockend = fs->blksz;
 		int skipfirst = 0;
-		blknr = read_allocated_block(file_inode, i, NULL);
-		if (blknr <= 0)
+		blknr = read_allocated_block(file_inode, i, &cache);
+		if (blknr <= 0) {
+			ext_cache_fini(&cache);
 			return -1;
+		}
 
 		blknr = blknr << log2_fs_blocksize;
 
@@ -835,10 +613,101 @@ static int ext4fs_write_file(struct ext2_inode *file_inode,
 			 delayed_buf, (uint32_t) delayed_extent);
 		previous_block_number = -1;
 	}
+	ext_cache_fini(&cache);
 
 	return len;
 }
 
+/*
+ * Allocate the data blocks of a new file and map them with extents. The
+ * blocks are taken in ascending order, so with enough free space the file
+ * ends up in a few long runs. Up to four extents fit in the inode and more
+ * go into one leaf block. A file needing more than that gets -E2BIG, with
+ * the blocks freed again, so that the caller can map it block by block.
+ */
+static int ext4fs_allocate_extents(struct ext2_inode *inode,
+				   unsigned int blocks,
+				   unsigned int *total_no_of_block)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext4_extent_header *eh;
+	struct ext4_extent_idx *idx;
+	struct ext4_extent *ext, *last = NULL;
+	int max_ext = (fs->blksz - sizeof(*eh)) / sizeof(*ext);
+	int in_inode = (sizeof(inode->b.blocks) - sizeof(*eh)) / sizeof(*ext);
+	uint32_t blknr, leaf;
+	char *leaf_buf;
+	unsigned int i, j;
+	int count = 0;
+	int ret;
+
+	leaf_buf = zalloc(fs->blksz);
+	if (!leaf_buf)
+		return -ENOMEM;
+	eh = (struct ext4_extent_header *)leaf_buf;
+	ext = (struct ext4_extent *)(eh + 1);
+
+	for (i = 0; i < blocks; i++) {
+		blknr = ext4fs_get_new_blk_no();
+		if (blknr == -1) {
+			ret = -ENOSPC;
+			goto fail;
+		}
+		if (last && le16_to_cpu(last->ee_len) < EXT_INIT_MAX_LEN &&
+		    le32_to_cpu(last->ee_start_lo) +
+		    le16_to_cpu(last->ee_len) == blknr) {
+			last->ee_len = cpu_to_le16(le16_to_cpu(last->ee_len) + 1);
+			continue;
+		}
+		if (count == max_ext) {
+			ext4fs_free_block(blknr);
+			ret = -E2BIG;
+			goto fail;
+		}
+		last = &ext[count++];
+		last->ee_block = cpu_to_le32(i);
+		last->ee_len = cpu_to_le16(1);
+		last->ee_start_lo = cpu_to_le32(blknr);
+	}
+
+	eh->eh_magic = cpu_to_le16(EXT4_EXT_MAGIC);
+	eh->eh_entries = cpu_to_le16(count);
+	if (count <= in_inode) {
+		eh->eh_max = cpu_to_le16(in_inode);
+		memcpy(inode->b.blocks.dir_blocks, leaf_buf,
+		       sizeof(*eh) + count * sizeof(*ext));
+	} else {
+		leaf = ext4fs_get_new_blk_no();
+		if (leaf == -1) {
+			ret = -ENOSPC;
+			goto fail;
+		}
+		eh->eh_max = cpu_to_le16(max_ext);
+		put_ext4((uint64_t)leaf * fs->blksz, leaf_buf, fs->blksz);
+
+		eh = (struct ext4_extent_header *)inode->b.blocks.dir_blocks;
+		eh->eh_magic = cpu_to_le16(EXT4_EXT_MAGIC);
+		eh->eh_entries = cpu_to_le16(1);
+		eh->eh_max = cpu_to_le16(in_inode);
+		eh->eh_depth = cpu_to_le16(1);
+		idx = (struct ext4_extent_idx *)(eh + 1);
+		idx->ei_leaf_lo = cpu_to_le32(leaf);
+		(*total_no_of_block)++;
+	}
+	inode->flags = cpu_to_le32(le32_to_cpu(inode->flags) | EXT4_EXTENTS_FL);
+	free(leaf_buf);
+
+	return 0;
+fail:
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < le16_to_cpu(ext[i].ee_len); j++)
+			ext4fs_free_block(le32_to_cpu(ext[i].ee_start_lo) + j);
+	}
+	free(leaf_buf);
+
+	return ret;
+}
+
 int ext4fs_write(const char *fname, const char *buffer,
 		 unsigned long sizebytes, int type)
 {
@@ -979,8 +848,23 @@ int ext4fs_write(const char *fname, const char *buffer,
 	file_inode->nlinks = cpu_to_le16(1);
 
 	/* Allocate data blocks */
-	ext4fs_allocate_blocks(file_inode, blocks_remaining,
-			       &blks_reqd_for_file);
+	ret = -E2BIG;
+	if (blocks_remaining && (le32_to_cpu(fs->sb->feature_incompat) &
+				 EXT4_FEATURE_INCOMPAT_EXTENTS)) {
+		ret = ext4fs_allocate_extents(file_inode, blocks_remaining,
+					      &blks_reqd_for_file);
+		if (ret == -E2BIG) {
+			/* too fragmented, so map it from the first free block */
+			fs->first_pass_bbmap = 0;
+			fs->curr_blkno = 0;
+		} else if (ret) {
+			printf("Not enough space on partition !!!\n");
+			goto fail;
+		}
+	}
+	if (ret)
+		ext4fs_allocate_blocks(file_inode, blocks_remaining,
+				       &blks_reqd_for_file);
 	file_inode->blockcnt = cpu_to_le32((blks_reqd_for_file * fs->blksz) >>
 					   LOG2_SECTOR_SIZE);
 
@@ -994,8 +878,8 @@ int ext4fs_write(const char *fname, const char *buffer,
 			(inodeno % le32_to_cpu(sblock->inodes_per_group)) /
 			inodes_per_block;
 	blkoff = (inodeno % inodes_per_block) * fs->inodesz;
-	ext4fs_devread((lbaint_t)itable_blkno * fs->sect_perblk, 0, fs->blksz,
-		       temp_ptr);
+	if (ext4fs_read_metadata(temp_ptr, itable_blkno))
+		goto fail;
 	if (ext4fs_log_journal(temp_ptr, itable_blkno))
 		goto fail;
 
@@ -1015,26 +899,15 @@ int ext4fs_write(const char *fname, const char *buffer,
 	    (parent_inodeno %
 	     le32_to_cpu(sblock->inodes_per_group)) / inodes_per_block;
 	blkoff = (parent_inodeno % inodes_per_block) * fs->inodesz;
-	if (parent_itable_blkno != itable_blkno) {
-		memset(temp_ptr, '\0', fs->blksz);
-		ext4fs_devread((lbaint_t)parent_itable_blkno * fs->sect_perblk,
-			       0, fs->blksz, temp_ptr);
-		if (ext4fs_log_journal(temp_ptr, parent_itable_blkno))
-			goto fail;
+	/* this may be the block just written, which then holds both */
+	if (ext4fs_read_metadata(temp_ptr, parent_itable_blkno))
+		goto fail;
+	if (ext4fs_log_journal(temp_ptr, parent_itable_blkno))
+		goto fail;
 
-		memcpy(temp_ptr + blkoff, g_parent_inode, fs->inodesz);
-		if (ext4fs_put_metadata(temp_ptr, parent_itable_blkno))
-			goto fail;
-	} else {
-		/*
-		 * If parent and child fall in same inode table block
-		 * both should be kept in 1 buffer
-		 */
-		memcpy(temp_ptr + blkoff, g_parent_inode, fs->inodesz);
-		gd_index--;
-		if (ext4fs_put_metadata(temp_ptr, itable_blkno))
-			goto fail;
-	}
+	memcpy(temp_ptr + blkoff, g_parent_inode, fs->inodesz);
+	if (ext4fs_put_metadata(temp_ptr, parent_itable_blkno))
+		goto fail;
 	ext4fs_update();
 	ext4fs_deinit();
 
@@ -27,6 +27,7 @@
 #include <ext4fs.h>
 #include <malloc.h>
 #include <part.h>
+#include <linux/sizes.h>
 #include <u-boot/uuid.h>
 #include "ext4_common.h"
 
@@ -62,6 +63,50 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
 		free(node);
 }
 
+/*
+ * Read a range of an extent-mapped file: look each extent up once and
+ * transfer it with a single device read straight into the buffer.
+ */
+static int ext4fs_read_extents(struct ext2fs_node *node, loff_t pos,
+			       loff_t len, char *buf,
+			       struct ext_block_cache *cache)
+{
+	struct ext_filesystem *fs = get_fs();
+	int log2blksz = fs->dev_desc->log2blksz;
+	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data) - log2blksz;
+	int blocksize = 1 << LOG2_BLOCK_SIZE(node->data);
+	loff_t end = pos + len;
+
+	while (pos < end) {
+		uint32_t fileblock = lldiv(pos, blocksize);
+		int skipfirst = pos - (loff_t)fileblock * blocksize;
+		lbaint_t blknr;
+		loff_t n;
+		long run;
+
+		run = ext4fs_map_extent(&node->inode, fileblock, cache,
+					&blknr);
+		if (run < 0)
+			return -1;
+
+		/* Keep each transfer within the int byte count of devread */
+		n = min((loff_t)run * blocksize - skipfirst, end - pos);
+		n = min_t(loff_t, n, SZ_1G);
+
+		if (blknr) {
+			if (!ext4fs_devread(blknr << log2_fs_blocksize,
+					    skipfirst, n, buf))
+				return -1;
+		} else {
+			memset(buf, 0, n);
+		}
+		buf += n;
+		pos += n;
+	}
+
+	return 0;
+}
+
 /*
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
@@ -98,6 +143,16 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		return -1;
 	}
 
+	if (le32_to_cpu(node->inode.flags) & EXT4_EXTENTS_FL) {
+		if (ext4fs_read_extents(node, pos, len, buf, &cache)) {
+			ext_cache_fini(&cache);
+			return -1;
+		}
+		*actread = len;
+		ext_cache_fini(&cache);
+		return 0;
+	}
+
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
 
 	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
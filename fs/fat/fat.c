@@ -10,6 +10,7 @@
 
 #define LOG_CATEGORY	LOGC_FS
 
+#include <arena.h>
 #include <blk.h>
 #include <config.h>
 #include <exports.h>
@@ -22,6 +23,7 @@
 #include <malloc.h>
 #include <memalign.h>
 #include <asm/cache.h>
+#include <linux/bitops.h>
 #include <linux/compiler.h>
 #include <linux/ctype.h>
 #include <linux/log2.h>
@@ -64,6 +66,280 @@ static int disk_read(__u32 block, __u32 nr_blocks, void *buf)
 	return ret;
 }
 
+/* Get a pointer to sectors of a memory-backed device, or NULL if not */
+static const void *disk_map(__u32 block, __u32 nr_blocks)
+{
+	if (!cur_dev)
+		return NULL;
+
+	return blk_dmap(cur_dev, cur_part_info.start + block, nr_blocks);
+}
+
+#if CONFIG_IS_ENABLED(FAT_CACHE)
+/**
+ * struct fat_cache_dir - cached directory cluster
+ *
+ * @sect:	first sector of the cluster, 0 if the slot is unused
+ * @nsect:	number of sectors held in @buf
+ * @age:	value of fat_cache.age when last used, for LRU replacement
+ * @buf:	cluster contents
+ */
+struct fat_cache_dir {
+	u32 sect;
+	u32 nsect;
+	u32 age;
+	void *buf;
+};
+
+/**
+ * struct fat_cache - FAT metadata kept across filesystem operations
+ *
+ * The cache belongs to the partition selected by fat_set_blk_dev(). It is
+ * checked against the boot sector each time a partition is selected and
+ * dropped by any write to the partition through the block layer, so its
+ * contents always match what is on the medium.
+ *
+ * @dev:	block device the cache belongs to, NULL if none
+ * @part_start:	first sector of the partition on @dev
+ * @part_size:	number of sectors in the partition
+ * @bootsect:	copy of the boot sector, used to detect a changed medium
+ * @info_valid:	true if @info holds the geometry of the filesystem
+ * @info:	filesystem geometry as filled in by get_fs_info()
+ * @fat:	copy of the FAT, loaded one FATBUFSIZE window at a time
+ * @fat_loaded:	bitmap of windows present in @fat
+ * @dir:	cached directory clusters
+ * @age:	counter for LRU replacement of @dir
+ * @cursor:	last cluster read from a file, so that reading on from there
+ *		does not follow the cluster chain from the start again
+ * @cursor.start:	first cluster of the file, 0 if none
+ * @cursor.clust:	cluster reached
+ * @cursor.pos:		offset of @cursor.clust in the file
+ */
+static struct fat_cache {
+	struct blk_desc *dev;
+	lbaint_t part_start;
+	lbaint_t part_size;
+	u8 *bootsect;
+	bool info_valid;
+	fsdata info;
+	u8 *fat;
+	unsigned long *fat_loaded;
+	struct fat_cache_dir dir[CONFIG_FAT_CACHE_DIR_CLUSTERS];
+	u32 age;
+	struct {
+		u32 start;
+		u32 clust;
+		loff_t pos;
+	} cursor;
+} fat_cache;
+
+static void fat_cache_invalidate(void)
+{
+	int i;
+
+	free(fat_cache.bootsect);
+	free(fat_cache.fat);
+	free(fat_cache.fat_loaded);
+	for (i = 0; i < ARRAY_SIZE(fat_cache.dir); i++)
+		free(fat_cache.dir[i].buf);
+	memset(&fat_cache, '\0', sizeof(fat_cache));
+}
+
+/*
+ * Called with the boot sector of a newly selected partition. Keep the cache if
+ * it describes the same filesystem, otherwise start a new one.
+ */
+static void fat_cache_select(const void *bootsect)
+{
+	if (fat_cache.dev == cur_dev &&
+	    fat_cache.part_start == cur_part_info.start &&
+	    !memcmp(fat_cache.bootsect, bootsect, cur_dev->blksz))
+		return;
+
+	fat_cache_invalidate();
+	fat_cache.bootsect = malloc(cur_dev->blksz);
+	if (!fat_cache.bootsect)
+		return;
+	memcpy(fat_cache.bootsect, bootsect, cur_dev->blksz);
+	fat_cache.dev = cur_dev;
+	fat_cache.part_start = cur_part_info.start;
+	fat_cache.part_size = cur_part_info.size;
+}
+
+void fat_cache_invalidate_blk(struct blk_desc *desc, lbaint_t start,
+			      lbaint_t blkcnt)
+{
+	if (desc != fat_cache.dev)
+		return;
+	if (blkcnt && (start >= fat_cache.part_start + fat_cache.part_size ||
+		       start + blkcnt <= fat_cache.part_start))
+		return;
+
+	fat_cache_invalidate();
+}
+
+static bool fat_cache_get_info(fsdata *mydata)
+{
+	if (!fat_cache.info_valid || fat_cache.dev != cur_dev)
+		return false;
+	*mydata = fat_cache.info;
+
+	return true;
+}
+
+static void fat_cache_set_info(fsdata *mydata)
+{
+	if (fat_cache.dev != cur_dev)
+		return;
+	fat_cache.info = *mydata;
+	fat_cache.info_valid = true;
+}
+
+/*
+ * Return FAT window @bufnum of @getsize sectors from the cache, reading it
+ * from the medium on first use. Return NULL if the FAT is not cached.
+ */
+static u8 *fat_cache_fat_window(fsdata *mydata, __u32 bufnum, __u32 getsize)
+{
+	u32 size = mydata->fatlength * mydata->sect_size;
+	u32 nwin = DIV_ROUND_UP(mydata->fatlength, FATBUFBLOCKS);
+	u8 *win;
+
+	if (!mydata->cached || !fat_cache.info_valid ||
+	    size > CONFIG_FAT_CACHE_FAT_SIZE || bufnum >= nwin)
+		return NULL;
+
+	if (!fat_cache.fat) {
+		fat_cache.fat = malloc_cache_aligned(size);
+		fat_cache.fat_loaded = calloc(BITS_TO_LONGS(nwin),
+					      sizeof(unsigned long));
+		if (!fat_cache.fat || !fat_cache.fat_loaded) {
+			free(fat_cache.fat);
+			free(fat_cache.fat_loaded);
+			fat_cache.fat = NULL;
+			fat_cache.fat_loaded = NULL;
+			return NULL;
+		}
+	}
+
+	win = fat_cache.fat + bufnum * FATBUFSIZE;
+	if (!test_bit(bufnum, fat_cache.fat_loaded)) {
+		if (disk_read(mydata->fat_sect + bufnum * FATBUFBLOCKS,
+			      getsize, win) < 0)
+			return NULL;
+		__set_bit(bufnum, fat_cache.fat_loaded);
+	}
+
+	return win;
+}
+
+static bool fat_cache_read_dir(fsdata *mydata, u32 sect, u32 nsect, void *buf)
+{
+	struct fat_cache_dir *dir;
+	int i;
+
+	if (!mydata->cached || !fat_cache.info_valid)
+		return false;
+
+	for (i = 0; i < ARRAY_SIZE(fat_cache.dir); i++) {
+		dir = &fat_cache.dir[i];
+		if (dir->buf && dir->sect == sect && dir->nsect == nsect) {
+			dir->age = ++fat_cache.age;
+			memcpy(buf, dir->buf, nsect * mydata->sect_size);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void fat_cache_add_dir(fsdata *mydata, u32 sect, u32 nsect,
+			      const void *buf)
+{
+	struct fat_cache_dir *dir = &fat_cache.dir[0];
+	u32 size = nsect * mydata->sect_size;
+	int i;
+
+	if (!mydata->cached || !fat_cache.info_valid)
+		return;
+
+	for (i = 1; i < ARRAY_SIZE(fat_cache.dir); i++) {
+		if (fat_cache.dir[i].age < dir->age)
+			dir = &fat_cache.dir[i];
+	}
+
+	if (dir->buf && dir->nsect != nsect) {
+		free(dir->buf);
+		dir->buf = NULL;
+	}
+	if (!dir->buf) {
+		dir->buf = malloc(size);
+		if (!dir->buf)
+			return;
+	}
+	memcpy(dir->buf, buf, size);
+	dir->sect = sect;
+	dir->nsect = nsect;
+	dir->age = ++fat_cache.age;
+}
+
+/*
+ * Look up the cluster that a previous read of the file starting at cluster
+ * @start reached, if it is not beyond @pos.
+ */
+static bool fat_cache_get_cursor(fsdata *mydata, u32 start, loff_t pos,
+				 u32 *clust, loff_t *clust_pos)
+{
+	if (!mydata->cached || !fat_cache.info_valid ||
+	    fat_cache.cursor.start != start || fat_cache.cursor.pos > pos)
+		return false;
+
+	*clust = fat_cache.cursor.clust;
+	*clust_pos = fat_cache.cursor.pos;
+
+	return true;
+}
+
+static void fat_cache_set_cursor(fsdata *mydata, u32 start, u32 clust,
+				 loff_t clust_pos)
+{
+	if (!mydata->cached || !fat_cache.info_valid)
+		return;
+
+	fat_cache.cursor.start = start;
+	fat_cache.cursor.clust = clust;
+	fat_cache.cursor.pos = clust_pos;
+}
+#else
+static inline void fat_cache_invalidate(void) {}
+static inline void fat_cache_select(const void *bootsect) {}
+static inline bool fat_cache_get_info(fsdata *mydata) { return false; }
+static inline void fat_cache_set_info(fsdata *mydata) {}
+static inline u8 *fat_cache_fat_window(fsdata *mydata, __u32 bufnum,
+				       __u32 getsize)
+{
+	return NULL;
+}
+
+static inline bool fat_cache_read_dir(fsdata *mydata, u32 sect, u32 nsect,
+				      void *buf)
+{
+	return false;
+}
+
+static inline void fat_cache_add_dir(fsdata *mydata, u32 sect, u32 nsect,
+				     const void *buf) {}
+
+static inline bool fat_cache_get_cursor(fsdata *mydata, u32 start, loff_t pos,
+					u32 *clust, loff_t *clust_pos)
+{
+	return false;
+}
+
+static inline void fat_cache_set_cursor(fsdata *mydata, u32 start, u32 clust,
+					loff_t clust_pos) {}
+#endif
+
 int fat_set_blk_dev(struct blk_desc *dev_desc, struct disk_partition *info)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, buffer, dev_desc->blksz);
@@ -84,10 +360,11 @@ int fat_set_blk_dev(struct blk_desc *dev_desc, struct disk_partition *info)
 	}
 
 	/* Check for FAT12/FAT16/FAT32 filesystem */
-	if (!memcmp(buffer + DOS_FS_TYPE_OFFSET, "FAT", 3))
-		return 0;
-	if (!memcmp(buffer + DOS_FS32_TYPE_OFFSET, "FAT32", 5))
+	if (!memcmp(buffer + DOS_FS_TYPE_OFFSET, "FAT", 3) ||
+	    !memcmp(buffer + DOS_FS32_TYPE_OFFSET, "FAT32", 5)) {
+		fat_cache_select(buffer);
 		return 0;
+	}
 
 	cur_dev = NULL;
 	return -1;
@@ -151,6 +428,7 @@ static void get_name(dir_entry *dirent, char *s_name)
 }
 
 static int flush_dirty_fat_buffer(fsdata *mydata);
+static __u8 *fat_wtable_window(fsdata *mydata, __u32 bufnum);
 
 #if !CONFIG_IS_ENABLED(FAT_WRITE)
 /* Stub for read only operation */
@@ -159,6 +437,11 @@ int flush_dirty_fat_buffer(fsdata *mydata)
 	(void)(mydata);
 	return 0;
 }
+
+static __u8 *fat_wtable_window(fsdata *mydata, __u32 bufnum)
+{
+	return NULL;
+}
 #endif
 
 /*
@@ -170,6 +453,7 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	__u32 bufnum;
 	__u32 offset, off8;
 	__u32 ret = 0x00;
+	__u8 *fatbuf;
 
 	if (CHECK_CLUST(entry, mydata->fatsize)) {
 		log_err("Invalid FAT entry: %#08x\n", entry);
@@ -209,6 +493,14 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 		if (startblock + getsize > fatlength)
 			getsize = fatlength - startblock;
 
+		fatbuf = fat_wtable_window(mydata, bufnum);
+		if (fatbuf)
+			goto lookup;
+
+		fatbuf = fat_cache_fat_window(mydata, bufnum, getsize);
+		if (fatbuf)
+			goto lookup;
+
 		startblock += mydata->fat_sect;	/* Offset from start of disk */
 
 		/* Write back the fatbuf to the disk */
@@ -221,19 +513,21 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 		}
 		mydata->fatbufnum = bufnum;
 	}
+	fatbuf = mydata->fatbuf;
 
+lookup:
 	/* Get the actual entry from the table */
 	switch (mydata->fatsize) {
 	case 32:
-		ret = FAT2CPU32(((__u32 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU32(((__u32 *)fatbuf)[offset]);
 		break;
 	case 16:
-		ret = FAT2CPU16(((__u16 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU16(((__u16 *)fatbuf)[offset]);
 		break;
 	case 12:
 		off8 = (offset * 3) / 2;
 		/* fatbut + off8 may be unaligned, read in byte granularity */
-		ret = mydata->fatbuf[off8] + (mydata->fatbuf[off8 + 1] << 8);
+		ret = fatbuf[off8] + (fatbuf[off8 + 1] << 8);
 
 		if (offset & 0x1)
 			ret >>= 4;
@@ -246,12 +540,17 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 }
 
 /*
- * Read at most 'size' bytes from the specified cluster into 'buffer'.
+ * Read 'size' bytes starting 'offset' bytes into the specified cluster into
+ * 'buffer'. The range may extend over following clusters as long as they are
+ * contiguous on the disk. Whole sectors are read straight into 'buffer' when
+ * it is cache-aligned; only partial first and last sectors are bounced.
  * Return 0 on success, -1 otherwise.
  */
 static int
-get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
+get_cluster(fsdata *mydata, __u32 clustnum, unsigned long offset,
+	    __u8 *buffer, unsigned long size)
 {
+	const __u8 *src;
 	__u32 startsect;
 	int ret;
 
@@ -260,25 +559,71 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	} else {
 		startsect = mydata->rootdir_sect;
 	}
+	startsect += offset / mydata->sect_size;
+	offset %= mydata->sect_size;
 
-	debug("gc - clustnum: %d, startsect: %d\n", clustnum, startsect);
+	debug("gc - clustnum: %d, startsect: %d, offset: %lu\n", clustnum,
+	      startsect, offset);
 
-	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
+	src = disk_map(startsect, DIV_ROUND_UP(offset + size,
+					       mydata->sect_size));
+	if (src) {
+		memcpy(buffer, src + offset, size);
+		return 0;
+	}
+
+	if (offset) {
 		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
+		unsigned long len = min(size, mydata->sect_size - offset);
+
+		ret = disk_read(startsect++, 1, tmpbuf);
+		if (ret != 1) {
+			debug("Error reading data (got %d)\n", ret);
+			return -1;
+		}
+
+		memcpy(buffer, tmpbuf + offset, len);
+		buffer += len;
+		size -= len;
+	}
+
+	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
+		__u32 max_count = mydata->clust_size;
+		struct arena_mark mark;
+		__u8 *tmpbuf;
 
 		debug("FAT: Misaligned buffer address (%p)\n", buffer);
 
+		if (size < mydata->sect_size)
+			goto tail;
+
+		/* Bounce up to a cluster at a time rather than per sector */
+		mark = arena_begin();
+		tmpbuf = arena_alloc_cache_aligned(max_count * mydata->sect_size);
+		if (!tmpbuf) {
+			debug("Error: allocating buffer\n");
+			arena_release(mark);
+			return -1;
+		}
+
 		while (size >= mydata->sect_size) {
-			ret = disk_read(startsect++, 1, tmpbuf);
-			if (ret != 1) {
+			__u32 sect_count = min_t(unsigned long, max_count,
+						 size / mydata->sect_size);
+			__u32 bytes_read = sect_count * mydata->sect_size;
+
+			ret = disk_read(startsect, sect_count, tmpbuf);
+			if (ret != sect_count) {
 				debug("Error reading data (got %d)\n", ret);
+				arena_release(mark);
 				return -1;
 			}
 
-			memcpy(buffer, tmpbuf, mydata->sect_size);
-			buffer += mydata->sect_size;
-			size -= mydata->sect_size;
+			memcpy(buffer, tmpbuf, bytes_read);
+			startsect += sect_count;
+			buffer += bytes_read;
+			size -= bytes_read;
 		}
+		arena_release(mark);
 	} else if (size >= mydata->sect_size) {
 		__u32 bytes_read;
 		__u32 sect_count = size / mydata->sect_size;
@@ -293,6 +638,7 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 		buffer += bytes_read;
 		size -= bytes_read;
 	}
+tail:
 	if (size) {
 		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
 
@@ -328,9 +674,10 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 {
 	loff_t filesize = FAT2CPU32(dentptr->size);
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
-	__u32 curclust = START(dentptr);
+	__u32 start = START(dentptr);
+	__u32 curclust = start;
 	__u32 endclust, newclust;
-	loff_t actsize;
+	loff_t actsize, base;
 
 	*gotsize = 0;
 	debug("Filesize: %llu bytes\n", filesize);
@@ -346,6 +693,9 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 	debug("%llu bytes\n", filesize);
 
 	actsize = bytesperclust;
+	/* continue from where the last read of this file ended */
+	if (fat_cache_get_cursor(mydata, start, pos, &curclust, &base))
+		actsize += base;
 
 	/* go to cluster at pos */
 	while (actsize <= pos) {
@@ -360,51 +710,24 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 
 	/* actsize > pos */
 	actsize -= bytesperclust;
+	base = actsize;
 	filesize -= actsize;
 	pos -= actsize;
 
-	/* align to beginning of next cluster if any */
-	if (pos) {
-		__u8 *tmp_buffer;
-
-		actsize = min(filesize, (loff_t)bytesperclust);
-		tmp_buffer = malloc_cache_aligned(actsize);
-		if (!tmp_buffer) {
-			debug("Error: allocating buffer\n");
-			return -1;
-		}
-
-		if (get_cluster(mydata, curclust, tmp_buffer, actsize) != 0) {
-			printf("Error reading cluster\n");
-			free(tmp_buffer);
-			return -1;
-		}
-		filesize -= actsize;
-		actsize -= pos;
-		memcpy(buffer, tmp_buffer + pos, actsize);
-		free(tmp_buffer);
-		*gotsize += actsize;
-		if (!filesize)
-			return 0;
-		buffer += actsize;
-
-		curclust = get_fatent(mydata, curclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
-			printf("Invalid FAT entry\n");
-			return -1;
-		}
-	}
-
-	actsize = bytesperclust;
-	endclust = curclust;
-
+	/*
+	 * Read each run of contiguous clusters with a single get_cluster()
+	 * call. pos is only non-zero for the first run, where the read starts
+	 * part way into curclust.
+	 */
 	do {
+		actsize = bytesperclust;
+		endclust = curclust;
+
 		/* search for consecutive clusters */
 		while (actsize < filesize) {
 			newclust = get_fatent(mydata, endclust);
 			if ((newclust - 1) != endclust)
-				goto getit;
+				break;
 			if (CHECK_CLUST(newclust, mydata->fatsize)) {
 				debug("curclust: 0x%x\n", newclust);
 				printf("Invalid FAT entry\n");
@@ -413,23 +736,23 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 			endclust = newclust;
 			actsize += bytesperclust;
 		}
+		fat_cache_set_cursor(mydata, start, endclust,
+				     base + actsize - bytesperclust);
 
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
+		if (actsize > filesize)
+			actsize = filesize;
+		if (get_cluster(mydata, curclust, pos, buffer,
+				actsize - pos) != 0) {
 			printf("Error reading cluster\n");
 			return -1;
 		}
-		*gotsize += actsize;
-		return 0;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		*gotsize += (int)actsize;
+		*gotsize += actsize - pos;
 		filesize -= actsize;
-		buffer += actsize;
+		buffer += actsize - pos;
+		pos = 0;
+		if (!filesize)
+			return 0;
+		base += actsize;
 
 		curclust = get_fatent(mydata, endclust);
 		if (CHECK_CLUST(curclust, mydata->fatsize)) {
@@ -437,8 +760,6 @@ getit:
 			printf("Invalid FAT entry\n");
 			return -1;
 		}
-		actsize = bytesperclust;
-		endclust = curclust;
 	} while (1);
 }
 
@@ -560,6 +881,7 @@ static int is_bootsector_valid(const boot_sector *bs)
 static int
 read_bootsectandvi(boot_sector *bs, volume_info *volinfo, int *fatsize)
 {
+	struct arena_mark mark;
 	__u8 *block;
 	volume_info *vistart;
 	int ret = 0;
@@ -569,10 +891,12 @@ read_bootsectandvi(boot_sector *bs, volume_info *volinfo, int *fatsize)
 		return -1;
 	}
 
-	block = malloc_cache_aligned(cur_dev->blksz);
+	mark = arena_begin();
+	block = arena_alloc_cache_aligned(cur_dev->blksz);
 	if (block == NULL) {
 		debug("Error: allocating block\n");
-		return -1;
+		ret = -1;
+		goto out_free;
 	}
 
 	if (disk_read(0, 1, block) < 0) {
@@ -611,7 +935,7 @@ read_bootsectandvi(boot_sector *bs, volume_info *volinfo, int *fatsize)
 	memcpy(volinfo, vistart, sizeof(volume_info));
 
 out_free:
-	free(block);
+	arena_release(mark);
 	return ret;
 }
 
@@ -621,6 +945,9 @@ static int get_fs_info(fsdata *mydata)
 	volume_info volinfo;
 	int ret;
 
+	if (fat_cache_get_info(mydata))
+		goto alloc;
+
 	ret = read_bootsectandvi(&bs, &volinfo, &mydata->fatsize);
 	if (ret) {
 		debug("Error: reading boot sector\n");
@@ -683,8 +1010,14 @@ static int get_fs_info(fsdata *mydata)
 		mydata->root_cluster = 0;
 	}
 
+	mydata->fatbuf = NULL;
+	mydata->cached = 0;
+	fat_cache_set_info(mydata);
+
+alloc:
 	mydata->fatbufnum = -1;
 	mydata->fat_dirty = 0;
+	mydata->wtable = NULL;
 	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE);
 	if (mydata->fatbuf == NULL) {
 		debug("Error: allocating memory\n");
@@ -906,10 +1239,13 @@ void *fat_next_cluster(fat_itr *itr, unsigned int *nbytes)
 	 * dent at a time and iteratively constructing the vfat long
 	 * name.
 	 */
-	ret = disk_read(sect, read_size, itr->block);
-	if (ret < 0) {
-		debug("Error: reading block\n");
-		return NULL;
+	if (!fat_cache_read_dir(itr->fsdata, sect, read_size, itr->block)) {
+		ret = disk_read(sect, read_size, itr->block);
+		if (ret < 0) {
+			debug("Error: reading block\n");
+			return NULL;
+		}
+		fat_cache_add_dir(itr->fsdata, sect, read_size, itr->block);
 	}
 
 	*nbytes = read_size * itr->fsdata->sect_size;
@@ -1225,21 +1561,26 @@ int file_fat_detectfs(void)
 
 int fat_exists(const char *filename)
 {
+	struct arena_mark mark;
 	fsdata fsdata;
 	fat_itr *itr;
 	int ret;
 
-	itr = malloc_cache_aligned(sizeof(fat_itr));
-	if (!itr)
-		return 0;
+	mark = arena_begin();
+	itr = arena_alloc_cache_aligned(sizeof(fat_itr));
+	if (!itr) {
+		ret = -ENOMEM;
+		goto out;
+	}
 	ret = fat_itr_root(itr, &fsdata);
 	if (ret)
 		goto out;
+	fsdata.cached = 1;
 
 	ret = fat_itr_resolve(itr, filename, TYPE_ANY);
 	free(fsdata.fatbuf);
 out:
-	free(itr);
+	arena_release(mark);
 	return ret == 0;
 }
 
@@ -1267,16 +1608,21 @@ static void __maybe_unused fat2rtc(u16 date, u16 time, struct rtc_time *tm)
 
 int fat_size(const char *filename, loff_t *size)
 {
+	struct arena_mark mark;
 	fsdata fsdata;
 	fat_itr *itr;
 	int ret;
 
-	itr = malloc_cache_aligned(sizeof(fat_itr));
-	if (!itr)
-		return -ENOMEM;
+	mark = arena_begin();
+	itr = arena_alloc_cache_aligned(sizeof(fat_itr));
+	if (!itr) {
+		ret = -ENOMEM;
+		goto out_free_itr;
+	}
 	ret = fat_itr_root(itr, &fsdata);
 	if (ret)
 		goto out_free_itr;
+	fsdata.cached = 1;
 
 	ret = fat_itr_resolve(itr, filename, TYPE_FILE);
 	if (ret) {
@@ -1288,6 +1634,7 @@ int fat_size(const char *filename, loff_t *size)
 		ret = fat_itr_root(itr, &fsdata);
 		if (ret)
 			goto out_free_itr;
+		fsdata.cached = 1;
 		ret = fat_itr_resolve(itr, filename, TYPE_DIR);
 		if (!ret)
 			*size = 0;
@@ -1298,23 +1645,28 @@ int fat_size(const char *filename, loff_t *size)
 out_free_both:
 	free(fsdata.fatbuf);
 out_free_itr:
-	free(itr);
+	arena_release(mark);
 	return ret;
 }
 
 int fat_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
 		  loff_t *actread)
 {
+	struct arena_mark mark;
 	fsdata fsdata;
 	fat_itr *itr;
 	int ret;
 
-	itr = malloc_cache_aligned(sizeof(fat_itr));
-	if (!itr)
-		return -ENOMEM;
+	mark = arena_begin();
+	itr = arena_alloc_cache_aligned(sizeof(fat_itr));
+	if (!itr) {
+		ret = -ENOMEM;
+		goto out_free_itr;
+	}
 	ret = fat_itr_root(itr, &fsdata);
 	if (ret)
 		goto out_free_itr;
+	fsdata.cached = 1;
 
 	ret = fat_itr_resolve(itr, filename, TYPE_FILE);
 	if (ret)
@@ -1330,7 +1682,7 @@ int fat_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
 out_free_both:
 	free(fsdata.fatbuf);
 out_free_itr:
-	free(itr);
+	arena_release(mark);
 	return ret;
 }
 
@@ -1366,6 +1718,7 @@ int fat_opendir(const char *filename, struct fs_dir_stream **dirsp)
 	ret = fat_itr_root(&dir->itr, &dir->fsdata);
 	if (ret)
 		goto fail_free_dir;
+	dir->fsdata.cached = 1;
 
 	ret = fat_itr_resolve(&dir->itr, filename, TYPE_DIR);
 	if (ret)
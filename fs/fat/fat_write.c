@@ -212,6 +212,216 @@ static int disk_write(__u32 block, __u32 nr_blocks, void *buf)
 	return ret;
 }
 
+/**
+ * struct fat_wtable - the whole FAT, held in memory while writing
+ *
+ * @buf:	contents of the FAT
+ * @dirty:	bitmap of the sectors of @buf changed since the last flush
+ * @used:	bitmap of the clusters which are not free
+ * @nclust:	number of clusters, counting the reserved clusters 0 and 1
+ * @hint:	no cluster below this one is free
+ */
+struct fat_wtable {
+	__u8 *buf;
+	unsigned long *dirty;
+	unsigned long *used;
+	__u32 nclust;
+	__u32 hint;
+};
+
+/**
+ * fat_wtable_find() - find the next cluster which is free or in use
+ *
+ * @wt:		FAT table
+ * @from:	first cluster to look at
+ * @used:	true to look for a cluster in use, false for a free one
+ * Return:	cluster number, or @wt->nclust if there is none
+ */
+static __u32 fat_wtable_find(struct fat_wtable *wt, __u32 from, bool used)
+{
+	unsigned long skip = used ? 0 : ~0UL;
+	__u32 i;
+
+	for (i = from; i < wt->nclust; i++) {
+		/* step over whole words without a match */
+		if (!(i % BITS_PER_LONG) && wt->used[BIT_WORD(i)] == skip) {
+			i += BITS_PER_LONG - 1;
+			continue;
+		}
+		if (!!test_bit(i, wt->used) == used)
+			return i;
+	}
+
+	return wt->nclust;
+}
+
+/**
+ * fat_wtable_find_run() - find free clusters for a new file
+ *
+ * @wt:		FAT table
+ * @count:	number of clusters wanted
+ * Return:	first cluster of the lowest run of at least @count free
+ *		clusters, else the lowest free cluster, else @wt->nclust
+ */
+static __u32 fat_wtable_find_run(struct fat_wtable *wt, __u32 count)
+{
+	__u32 first, start, end;
+
+	first = fat_wtable_find(wt, max_t(__u32, wt->hint, 3), false);
+	for (start = first; start < wt->nclust;
+	     start = fat_wtable_find(wt, end, false)) {
+		end = fat_wtable_find(wt, start, true);
+		if (end - start >= count)
+			return start;
+	}
+
+	return first;
+}
+
+/*
+ * Return the part of the whole FAT for window 'bufnum', or NULL if the FAT
+ * is only accessed through mydata->fatbuf
+ */
+static __u8 *fat_wtable_window(fsdata *mydata, __u32 bufnum)
+{
+	if (!mydata->wtable)
+		return NULL;
+
+	return mydata->wtable->buf + bufnum * FATBUFSIZE;
+}
+
+/**
+ * fat_wtable_free() - drop the whole FAT
+ *
+ * Any changes not flushed are lost.
+ *
+ * @mydata:	filesystem data
+ */
+static void fat_wtable_free(fsdata *mydata)
+{
+	struct fat_wtable *wt = mydata->wtable;
+
+	if (!wt)
+		return;
+	free(wt->buf);
+	free(wt->dirty);
+	free(wt->used);
+	free(wt);
+	mydata->wtable = NULL;
+}
+
+/**
+ * fat_wtable_load() - read the whole FAT and build the free-cluster bitmap
+ *
+ * If the FAT is larger than CONFIG_FAT_WRITE_FAT_SIZE or cannot be read,
+ * the FAT window in mydata->fatbuf keeps being used.
+ *
+ * @mydata:	filesystem data
+ */
+static void fat_wtable_load(fsdata *mydata)
+{
+	__u32 size = mydata->fatlength * mydata->sect_size;
+	struct fat_wtable *wt;
+	__u32 i;
+
+	if (size > CONFIG_FAT_WRITE_FAT_SIZE || mydata->fat_dirty)
+		return;
+
+	wt = calloc(1, sizeof(*wt));
+	if (!wt)
+		return;
+	mydata->wtable = wt;
+
+	/* the FAT may have more entries than there are clusters */
+	wt->nclust = (mydata->total_sect - mydata->data_begin) /
+		     mydata->clust_size;
+	wt->nclust = min(wt->nclust, size * 8 / mydata->fatsize);
+
+	wt->buf = malloc_cache_aligned(size);
+	wt->dirty = calloc(BITS_TO_LONGS(mydata->fatlength), sizeof(long));
+	wt->used = calloc(BITS_TO_LONGS(wt->nclust), sizeof(long));
+	if (!wt->buf || !wt->dirty || !wt->used)
+		goto err;
+
+	if (disk_read(mydata->fat_sect, mydata->fatlength, wt->buf) < 0)
+		goto err;
+	/* entries are now looked up in the whole FAT, not the window */
+	mydata->fatbufnum = -1;
+
+	wt->hint = wt->nclust;
+	for (i = 0; i < wt->nclust; i++) {
+		if (i < 2 || get_fatent(mydata, i))
+			__set_bit(i, wt->used);
+		else if (wt->hint == wt->nclust)
+			wt->hint = i;
+	}
+	log_debug("FAT%d: %u clusters, first free %u\n", mydata->fatsize,
+		  wt->nclust, wt->hint);
+
+	return;
+err:
+	log_debug("Using the FAT window\n");
+	fat_wtable_free(mydata);
+}
+
+/*
+ * Note a change to 'len' bytes at 'pos' in the whole FAT, which now says
+ * that 'entry' is 'entry_value'
+ */
+static void fat_wtable_update(fsdata *mydata, __u32 pos, __u32 len,
+			      __u32 entry, __u32 entry_value)
+{
+	struct fat_wtable *wt = mydata->wtable;
+	__u32 sect;
+
+	for (sect = pos / mydata->sect_size;
+	     sect <= (pos + len - 1) / mydata->sect_size; sect++)
+		__set_bit(sect, wt->dirty);
+
+	if (entry >= wt->nclust)
+		return;
+	if (entry_value) {
+		__set_bit(entry, wt->used);
+	} else {
+		__clear_bit(entry, wt->used);
+		wt->hint = min(wt->hint, entry);
+	}
+}
+
+/*
+ * Write each run of changed sectors of the whole FAT to every copy of the
+ * FAT
+ */
+static int fat_wtable_flush(fsdata *mydata)
+{
+	struct fat_wtable *wt = mydata->wtable;
+	__u32 start, end, copy;
+
+	for (start = 0; start < mydata->fatlength; start = end) {
+		if (!test_bit(start, wt->dirty)) {
+			end = start + 1;
+			continue;
+		}
+		for (end = start; end < mydata->fatlength; end++) {
+			if (!test_bit(end, wt->dirty))
+				break;
+			__clear_bit(end, wt->dirty);
+		}
+
+		for (copy = 0; copy < mydata->fats; copy++) {
+			if (disk_write(mydata->fat_sect +
+				       copy * mydata->fatlength + start,
+				       end - start,
+				       wt->buf + start * mydata->sect_size) < 0) {
+				debug("error: writing FAT blocks\n");
+				return -1;
+			}
+		}
+	}
+
+	return 0;
+}
+
 /*
  * Write fat buffer into block device
  */
@@ -222,6 +432,9 @@ static int flush_dirty_fat_buffer(fsdata *mydata)
 	__u8 *bufptr = mydata->fatbuf;
 	__u32 startblock = mydata->fatbufnum * FATBUFBLOCKS;
 
+	if (mydata->wtable)
+		return fat_wtable_flush(mydata);
+
 	debug("debug: evicting %d, dirty: %d\n", mydata->fatbufnum,
 	      (int)mydata->fat_dirty);
 
@@ -442,6 +655,7 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 {
 	__u32 bufnum, offset, off16;
 	__u16 val1, val2;
+	__u8 *fatbuf;
 
 	switch (mydata->fatsize) {
 	case 32:
@@ -461,6 +675,16 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 		return -1;
 	}
 
+	fatbuf = fat_wtable_window(mydata, bufnum);
+	if (fatbuf) {
+		off16 = mydata->fatsize == 12 ? offset * 3 / 2 :
+			offset * mydata->fatsize / 8;
+		fat_wtable_update(mydata, bufnum * FATBUFSIZE + off16,
+				  mydata->fatsize == 32 ? 4 : 2, entry,
+				  entry_value);
+		goto set;
+	}
+
 	/* Read a new block of FAT entries into the cache. */
 	if (bufnum != mydata->fatbufnum) {
 		int getsize = FATBUFBLOCKS;
@@ -486,14 +710,16 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 
 	/* Mark as dirty */
 	mydata->fat_dirty = 1;
+	fatbuf = mydata->fatbuf;
 
+set:
 	/* Set the actual entry */
 	switch (mydata->fatsize) {
 	case 32:
-		((__u32 *) mydata->fatbuf)[offset] = cpu_to_le32(entry_value);
+		((__u32 *) fatbuf)[offset] = cpu_to_le32(entry_value);
 		break;
 	case 16:
-		((__u16 *) mydata->fatbuf)[offset] = cpu_to_le16(entry_value);
+		((__u16 *) fatbuf)[offset] = cpu_to_le16(entry_value);
 		break;
 	case 12:
 		off16 = (offset * 3) / 4;
@@ -501,33 +727,33 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 		switch (offset & 0x3) {
 		case 0:
 			val1 = cpu_to_le16(entry_value) & 0xfff;
-			((__u16 *)mydata->fatbuf)[off16] &= ~0xfff;
-			((__u16 *)mydata->fatbuf)[off16] |= val1;
+			((__u16 *)fatbuf)[off16] &= ~0xfff;
+			((__u16 *)fatbuf)[off16] |= val1;
 			break;
 		case 1:
 			val1 = cpu_to_le16(entry_value) & 0xf;
 			val2 = (cpu_to_le16(entry_value) >> 4) & 0xff;
 
-			((__u16 *)mydata->fatbuf)[off16] &= ~0xf000;
-			((__u16 *)mydata->fatbuf)[off16] |= (val1 << 12);
+			((__u16 *)fatbuf)[off16] &= ~0xf000;
+			((__u16 *)fatbuf)[off16] |= (val1 << 12);
 
-			((__u16 *)mydata->fatbuf)[off16 + 1] &= ~0xff;
-			((__u16 *)mydata->fatbuf)[off16 + 1] |= val2;
+			((__u16 *)fatbuf)[off16 + 1] &= ~0xff;
+			((__u16 *)fatbuf)[off16 + 1] |= val2;
 			break;
 		case 2:
 			val1 = cpu_to_le16(entry_value) & 0xff;
 			val2 = (cpu_to_le16(entry_value) >> 8) & 0xf;
 
-			((__u16 *)mydata->fatbuf)[off16] &= ~0xff00;
-			((__u16 *)mydata->fatbuf)[off16] |= (val1 << 8);
+			((__u16 *)fatbuf)[off16] &= ~0xff00;
+			((__u16 *)fatbuf)[off16] |= (val1 << 8);
 
-			((__u16 *)mydata->fatbuf)[off16 + 1] &= ~0xf;
-			((__u16 *)mydata->fatbuf)[off16 + 1] |= val2;
+			((__u16 *)fatbuf)[off16 + 1] &= ~0xf;
+			((__u16 *)fatbuf)[off16 + 1] |= val2;
 			break;
 		case 3:
 			val1 = cpu_to_le16(entry_value) & 0xfff;
-			((__u16 *)mydata->fatbuf)[off16] &= ~0xfff0;
-			((__u16 *)mydata->fatbuf)[off16] |= (val1 << 4);
+			((__u16 *)fatbuf)[off16] &= ~0xfff0;
+			((__u16 *)fatbuf)[off16] |= (val1 << 4);
 			break;
 		default:
 			break;
@@ -547,8 +773,17 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
  */
 static __u32 determine_fatent(fsdata *mydata, __u32 entry)
 {
+	struct fat_wtable *wt = mydata->wtable;
 	__u32 next_fat, next_entry = entry + 1;
 
+	if (wt) {
+		next_entry = fat_wtable_find(wt, next_entry, false);
+		if (next_entry == wt->nclust)
+			next_entry = fat_wtable_find_run(wt, 1);
+		set_fatent_value(mydata, entry, next_entry);
+		goto out;
+	}
+
 	while (1) {
 		next_fat = get_fatent(mydata, next_entry);
 		if (next_fat == 0) {
@@ -558,6 +793,7 @@ static __u32 determine_fatent(fsdata *mydata, __u32 entry)
 		}
 		next_entry++;
 	}
+out:
 	debug("FAT%d: entry: %08x, entry_value: %04x\n",
 	       mydata->fatsize, entry, next_entry);
 
@@ -800,12 +1036,16 @@ get_set_cluster(fsdata *mydata, __u32 clustnum, loff_t pos, __u8 *buffer,
 }
 
 /*
- * Find the first empty cluster
+ * Find the first empty cluster. With the whole FAT in memory, prefer the
+ * first run of 'count' empty clusters so that a new file is contiguous.
  */
-static int find_empty_cluster(fsdata *mydata)
+static int find_empty_cluster(fsdata *mydata, __u32 count)
 {
 	__u32 fat_val, entry = 3;
 
+	if (mydata->wtable)
+		return fat_wtable_find_run(mydata->wtable, count);
+
 	while (1) {
 		fat_val = get_fatent(mydata, entry);
 		if (fat_val == 0)
@@ -829,7 +1069,7 @@ static int new_dir_table(fat_itr *itr)
 	int dir_oldclust = itr->clust;
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 
-	dir_newclust = find_empty_cluster(mydata);
+	dir_newclust = find_empty_cluster(mydata, 1);
 
 	/*
 	 * Flush before updating FAT to ensure valid directory structure
@@ -1071,7 +1311,9 @@ set_clusters:
 
 	/* Assure that curclust is valid */
 	if (!curclust) {
-		curclust = find_empty_cluster(mydata);
+		curclust = find_empty_cluster(mydata,
+					      div_u64(filesize + bytesperclust - 1,
+						      bytesperclust));
 		set_start_cluster(mydata, dentptr, curclust);
 	} else {
 		newclust = get_fatent(mydata, curclust);
@@ -1390,6 +1632,7 @@ int file_fat_write_at(const char *filename, loff_t pos, void *buffer,
 		goto exit;
 
 	total_sector = datablock.total_sect;
+	fat_wtable_load(mydata);
 
 	ret = fat_itr_resolve(itr, parent, TYPE_DIR);
 	if (ret) {
@@ -1633,6 +1876,7 @@ int fat_unlink(const char *filename)
 		goto exit;
 
 	total_sector = fsdata.total_sect;
+	fat_wtable_load(&fsdata);
 
 	ret = fat_itr_resolve(itr, dirname, TYPE_DIR);
 	if (ret) {
@@ -1664,6 +1908,7 @@ int fat_unlink(const char *filename)
 	ret = delete_dentry_long(itr);
 
 exit:
+	fat_wtable_free(&fsdata);
 	free(fsdata.fatbuf);
 	free(itr);
 	free(filename_copy);
@@ -1711,6 +1956,7 @@ int fat_mkdir(const char *dirname)
 		goto exit;
 
 	total_sector = datablock.total_sect;
+	fat_wtable_load(mydata);
 
 	ret = fat_itr_resolve(itr, parent, TYPE_DIR);
 	if (ret) {
@@ -1808,6 +2054,7 @@ int fat_mkdir(const char *dirname)
 
 exit:
 	free(dirname_copy);
+	fat_wtable_free(mydata);
 	free(mydata->fatbuf);
 	free(itr);
 	free(dotdent);
@@ -5,8 +5,10 @@
 
 #define LOG_CATEGORY LOGC_CORE
 
+#include <bootstage.h>
 #include <command.h>
 #include <config.h>
+#include <autoboot.h>
 #include <display_options.h>
 #include <errno.h>
 #include <env.h>
@@ -14,6 +16,7 @@
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <memalign.h>
 #include <part.h>
 #include <ext4fs.h>
 #include <fat.h>
@@ -480,6 +483,10 @@ void fs_close(void)
 
 	info->close();
 
+	/* write back what the filesystem left in the block cache */
+	if (fs_dev_desc)
+		blkcache_flush(fs_dev_desc->uclass_id, fs_dev_desc->devnum);
+
 	fs_type = FS_TYPE_ANY;
 }
 
@@ -582,7 +589,9 @@ static int _fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	 * means read the whole file.
 	 */
 	buf = map_sysmem(addr, len);
+	bootstage_span_begin("fs_read");
 	ret = info->read(filename, buf, offset, len, actread);
+	bootstage_span_end();
 	unmap_sysmem(buf);
 
 	/* If we requested a specific number of bytes, check we got it */
@@ -599,6 +608,44 @@ int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	return _fs_read(filename, addr, offset, len, 0, actread);
 }
 
+int fs_read_sink(const char *filename, struct fs_sink *sink, ulong chunk,
+		 loff_t *actread)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+	loff_t size, pos, len, actual;
+	void *buf;
+	int ret;
+
+	*actread = 0;
+	ret = info->size(filename, &size);
+	if (ret)
+		goto out;
+	buf = malloc_cache_aligned(chunk);
+	if (!buf) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	bootstage_span_begin("fs_read");
+	for (pos = 0; pos < size; pos += actual) {
+		len = min_t(loff_t, size - pos, chunk);
+		ret = info->read(filename, buf, pos, len, &actual);
+		if (!ret && actual != len)
+			ret = -EIO;
+		if (!ret)
+			ret = sink->write(sink, buf, actual);
+		if (ret)
+			break;
+	}
+	bootstage_span_end();
+	*actread = pos;
+	free(buf);
+out:
+	fs_close();
+
+	return ret;
+}
+
 int fs_write(const char *filename, ulong addr, loff_t offset, loff_t len,
 	     loff_t *actwrite)
 {
@@ -606,6 +653,9 @@ int fs_write(const char *filename, ulong addr, loff_t offset, loff_t len,
 	void *buf;
 	int ret;
 
+	/* the preloaded files might be changed */
+	autoboot_preload_discard();
+
 	buf = map_sysmem(addr, len);
 	ret = info->write(filename, buf, offset, len, actwrite);
 	unmap_sysmem(buf);
@@ -732,6 +782,40 @@ int do_size(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	return 0;
 }
 
+/* Decompress a file to @addr, reserving the space it may take */
+static int fs_load_decomp(const char *filename, ulong addr, loff_t max,
+			  loff_t *sizep)
+{
+	const loff_t def_max = IF_ENABLED_INT(CONFIG_FS_LOAD_DECOMP,
+					      CONFIG_FS_LOAD_DECOMP_MAX);
+	int ret;
+
+	if (!max)
+		max = def_max;
+#if CONFIG_IS_ENABLED(LMB)
+	if (lmb_alloc_addr(addr, max, LMB_NONE) != addr) {
+		if (max == def_max)
+			max = lmb_get_free_size(addr);
+		if (!max || lmb_alloc_addr(addr, max, LMB_NONE) != addr) {
+			fs_close();
+			log_err("** Reading file would overwrite reserved memory **\n");
+			return -ENOSPC;
+		}
+	}
+#endif
+	ret = fs_read_decomp(filename, addr, max, sizep);
+#if CONFIG_IS_ENABLED(LMB)
+	/* keep only the space that was filled */
+	if (*sizep < max)
+		lmb_free(addr + *sizep, max - *sizep);
+#endif
+	if (ret == -ENOSPC)
+		log_err("** Decompressed file is larger than %llx bytes **\n",
+			max);
+
+	return ret;
+}
+
 int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	    int fstype)
 {
@@ -741,10 +825,18 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 	loff_t bytes;
 	loff_t pos;
 	loff_t len_read;
+	bool preloaded;
+	bool decomp = false;
 	int ret;
 	unsigned long time;
 	char *ep;
 
+	if (IS_ENABLED(CONFIG_FS_LOAD_DECOMP) && argc > 1 &&
+	    !strcmp(argv[1], "-z")) {
+		decomp = true;
+		argc--;
+		argv++;
+	}
 	if (argc < 2)
 		return CMD_RET_USAGE;
 	if (argc > 7)
@@ -783,9 +875,21 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 		pos = hextoul(argv[6], NULL);
 	else
 		pos = 0;
+	if (decomp && pos)
+		return CMD_RET_USAGE;
 
+	preloaded = !decomp && !pos && !autoboot_preload_find(argv[1], cmd_arg2(argc, argv),
+						   filename, addr, bytes,
+						   &len_read);
 	time = get_timer(0);
-	ret = _fs_read(filename, addr, pos, bytes, 1, &len_read);
+	if (preloaded) {
+		fs_close();
+		ret = 0;
+	} else if (IS_ENABLED(CONFIG_FS_LOAD_DECOMP) && decomp) {
+		ret = fs_load_decomp(filename, addr, bytes, &len_read);
+	} else {
+		ret = _fs_read(filename, addr, pos, bytes, 1, &len_read);
+	}
 	time = get_timer(time);
 	if (ret < 0) {
 		log_err("Failed to load '%s'\n", filename);
@@ -796,13 +900,17 @@ int do_load(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[],
 			(argc > 4) ? argv[4] : "", map_sysmem(addr, 0),
 			len_read);
 
-	printf("%llu bytes read in %lu ms", len_read, time);
-	if (time > 0) {
-		puts(" (");
-		print_size(div_u64(len_read, time) * 1000, "/s");
-		puts(")");
+	if (preloaded) {
+		printf("%llu bytes already loaded\n", len_read);
+	} else {
+		printf("%llu bytes read in %lu ms", len_read, time);
+		if (time > 0) {
+			puts(" (");
+			print_size(div_u64(len_read, time) * 1000, "/s");
+			puts(")");
+		}
+		puts("\n");
 	}
-	puts("\n");
 
 	env_set_hex("fileaddr", addr);
 	env_set_hex("filesize", len_read);
@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Decompressing a file while it is read from a filesystem
+ *
+ * Each chunk read by fs_read_sink() goes straight into the decompressor, so
+ * only the decompressed data is written to the load address. The compressed
+ * file never needs a buffer of its own and each part of it is decompressed
+ * while it is still in the cache.
+ */
+
+#define LOG_CATEGORY LOGC_FS
+
+#include <fs.h>
+#include <gzip.h>
+#include <image.h>
+#include <log.h>
+#include <mapmem.h>
+#include <linux/errno.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
+#include <linux/string.h>
+#include <linux/zstd.h>
+#include <u-boot/lz4.h>
+#include <u-boot/zlib.h>
+
+/* Largest Zstandard window accepted, the default limit of the zstd tool */
+#define FS_DECOMP_ZSTD_MAX_WINDOW	SZ_128M
+
+/**
+ * struct fs_decomp - state of a file being decompressed as it is read
+ *
+ * @sink: Sink passed to fs_read_sink()
+ * @dst: Output buffer
+ * @dst_size: Size of @dst
+ * @comp: Compression of the file (IH_COMP_...), set from the first data
+ * @started: true once the decompressor has been set up
+ * @done: true once the end of the compressed stream has been seen
+ * @pos: Number of bytes written to @dst, for an uncompressed file
+ * @zs: Inflate state, for gzip
+ * @zst: Zstandard stream state
+ * @lz4s: LZ4 stream state
+ */
+struct fs_decomp {
+	struct fs_sink sink;
+	void *dst;
+	ulong dst_size;
+	int comp;
+	bool started;
+	bool done;
+	ulong pos;
+	z_stream zs;
+	struct zstd_stream zst;
+	struct ulz4_stream lz4s;
+};
+
+static int fs_decomp_start(struct fs_decomp *fd, const u8 *buf, ulong len)
+{
+	fd->comp = image_decomp_type(buf, len);
+	if (fd->comp < 0)
+		fd->comp = IH_COMP_NONE;
+
+	switch (fd->comp) {
+	case IH_COMP_NONE:
+		break;
+	case IH_COMP_GZIP:
+		if (!CONFIG_IS_ENABLED(GZIP))
+			goto unsupported;
+		fd->zs.zalloc = gzalloc;
+		fd->zs.zfree = gzfree;
+		if (inflateInit2(&fd->zs, -MAX_WBITS) != Z_OK)
+			return -ENOMEM;
+		fd->zs.next_out = fd->dst;
+		fd->zs.avail_out = min_t(ulong, fd->dst_size, UINT_MAX);
+		break;
+	case IH_COMP_ZSTD:
+		if (!CONFIG_IS_ENABLED(ZSTD))
+			goto unsupported;
+		zstd_stream_init(&fd->zst, fd->dst, fd->dst_size,
+				 FS_DECOMP_ZSTD_MAX_WINDOW);
+		break;
+	case IH_COMP_LZ4:
+		if (!CONFIG_IS_ENABLED(LZ4))
+			goto unsupported;
+		ulz4_stream_init(&fd->lz4s, fd->dst, fd->dst_size);
+		break;
+	default:
+		goto unsupported;
+	}
+	fd->started = true;
+
+	return 0;
+
+unsupported:
+	log_err("Cannot decompress %s data while loading\n",
+		genimg_get_comp_name(fd->comp));
+
+	return -EPROTONOSUPPORT;
+}
+
+static int fs_decomp_gunzip(struct fs_decomp *fd, const u8 *buf, ulong len)
+{
+	int offset, r;
+
+	if (fd->done)
+		return 0;
+	if (!fd->zs.total_in) {
+		/* the header is expected to be within the first chunk */
+		offset = gzip_parse_header(buf, len);
+		if (offset < 0)
+			return -EINVAL;
+		buf += offset;
+		len -= offset;
+	}
+
+	fd->zs.next_in = (u8 *)buf;
+	fd->zs.avail_in = len;
+	r = inflate(&fd->zs, Z_SYNC_FLUSH);
+	if (r == Z_STREAM_END) {
+		fd->done = true;
+		return 0;
+	}
+	if (r != Z_OK && r != Z_BUF_ERROR)
+		return -EINVAL;
+
+	/* input is left over only if the output buffer is full */
+	return fd->zs.avail_in ? -ENOSPC : 0;
+}
+
+static int fs_decomp_write(struct fs_sink *sink, const void *buf, ulong len)
+{
+	struct fs_decomp *fd = container_of(sink, struct fs_decomp, sink);
+	int ret;
+
+	if (!fd->started) {
+		ret = fs_decomp_start(fd, buf, len);
+		if (ret)
+			return ret;
+	}
+
+	switch (fd->comp) {
+	case IH_COMP_GZIP:
+		return fs_decomp_gunzip(fd, buf, len);
+	case IH_COMP_ZSTD:
+		return zstd_stream_add(&fd->zst, buf, len);
+	case IH_COMP_LZ4:
+		return ulz4_stream_add(&fd->lz4s, buf, len);
+	}
+
+	if (len > fd->dst_size - fd->pos)
+		return -ENOSPC;
+	memcpy(fd->dst + fd->pos, buf, len);
+	fd->pos += len;
+
+	return 0;
+}
+
+/* Tidy up the decompressor, returning the size of the output */
+static int fs_decomp_finish(struct fs_decomp *fd, int ret, loff_t *sizep)
+{
+	size_t size = fd->pos;
+	int err = 0;
+
+	if (!fd->started)
+		goto out;
+
+	switch (fd->comp) {
+	case IH_COMP_GZIP:
+		if (!fd->done)
+			err = -EINVAL;
+		size = fd->zs.total_out;
+		inflateEnd(&fd->zs);
+		break;
+	case IH_COMP_ZSTD:
+		err = zstd_stream_finish(&fd->zst);
+		if (err >= 0) {
+			size = err;
+			err = 0;
+		}
+		break;
+	case IH_COMP_LZ4:
+		err = ulz4_stream_finish(&fd->lz4s, &size);
+		break;
+	}
+out:
+	*sizep = size;
+
+	return ret ? ret : err;
+}
+
+int fs_read_decomp(const char *filename, ulong addr, ulong max_size,
+		   loff_t *sizep)
+{
+	struct fs_decomp fd;
+	loff_t actread;
+	int ret;
+
+	memset(&fd, '\0', sizeof(fd));
+	fd.sink.write = fs_decomp_write;
+	fd.dst = map_sysmem(addr, max_size);
+	fd.dst_size = max_size;
+
+	ret = fs_read_sink(filename, &fd.sink, CONFIG_FS_LOAD_DECOMP_CHUNK,
+			   &actread);
+	ret = fs_decomp_finish(&fd, ret, sizep);
+	unmap_sysmem(fd.dst);
+	if (ret)
+		return log_msg_ret("fdc", ret);
+	log_debug("Read %llx bytes, decompressed to %llx\n", actread, *sizep);
+
+	return 0;
+}
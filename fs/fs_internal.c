@@ -17,6 +17,7 @@ int fs_devread(struct blk_desc *blk, struct disk_partition *partition,
 	       lbaint_t sector, int byte_offset, int byte_len, char *buf)
 {
 	unsigned block_len;
+	const char *src;
 	int log2blksz;
 	ALLOC_CACHE_ALIGN_BUFFER(char, sec_buf, (blk ? blk->blksz : 0));
 	if (blk == NULL) {
@@ -38,6 +39,14 @@ int fs_devread(struct blk_desc *blk, struct disk_partition *partition,
 
 	log_debug(" <" LBAFU ", %d, %d>\n", sector, byte_offset, byte_len);
 
+	/* A device held in memory needs no bounce for partial sectors */
+	src = blk_dmap(blk, partition->start + sector,
+		       (byte_offset + byte_len + blk->blksz - 1) >> log2blksz);
+	if (src) {
+		memcpy(buf, src + byte_offset, byte_len);
+		return 1;
+	}
+
 	if (byte_offset != 0) {
 		int readlen;
 		/* read first part which isn't aligned with start of sector */
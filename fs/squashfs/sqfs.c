@@ -7,6 +7,7 @@
  * sqfs.c: SquashFS filesystem implementation
  */
 
+#include <arena.h>
 #include <asm/unaligned.h>
 #include <div64.h>
 #include <errno.h>
@@ -14,6 +15,7 @@
 #include <linux/types.h>
 #include <asm/byteorder.h>
 #include <linux/compat.h>
+#include <linux/sizes.h>
 #include <memalign.h>
 #include <stdlib.h>
 #include <string.h>
@@ -25,11 +27,15 @@
 #include "sqfs_utils.h"
 
 #define MAX_SYMLINK_NEST 8
+/* Largest run of consecutive data blocks fetched in one device request */
+#define SQFS_READ_RUN_SIZE SZ_1M
 
 static struct squashfs_ctxt ctxt;
 static int symlinknest;
 
 static int sqfs_readdir_nest(struct fs_dir_stream *fs_dirs, struct fs_dirent **dentp);
+static void *sqfs_get_inode(u32 start_block, u16 offset);
+static int sqfs_load_dir(void *dir_i);
 
 static int sqfs_disk_read(__u32 block, __u32 nr_blocks, void *buf)
 {
@@ -47,6 +53,16 @@ static int sqfs_disk_read(__u32 block, __u32 nr_blocks, void *buf)
 	return ret;
 }
 
+/* Get a pointer to blocks of a memory-backed device, or NULL if not */
+static const void *sqfs_disk_map(__u32 block, __u32 nr_blocks)
+{
+	if (!ctxt.cur_dev)
+		return NULL;
+
+	return blk_dmap(ctxt.cur_dev, ctxt.cur_part_info.start + block,
+			nr_blocks);
+}
+
 static int sqfs_read_sblk(struct squashfs_super_block **sblk)
 {
 	*sblk = malloc_cache_aligned(ctxt.cur_dev->blksz);
@@ -100,59 +116,62 @@ static int sqfs_calc_n_blks(__le64 start, __le64 end, u64 *offset)
 
 /*
  * Retrieves fragment block entry and returns true if the fragment block is
- * compressed
+ * compressed. The fragment index table and the last metadata block of entries
+ * are kept until sqfs_close(), as consecutive files mostly share them.
  */
 static int sqfs_frag_lookup(u32 inode_fragment_index,
 			    struct squashfs_fragment_block_entry *e)
 {
 	u64 start, end, exp_tbl, n_blks, src_len, table_offset, start_block;
-	unsigned char *metadata_buffer, *metadata, *table;
-	struct squashfs_fragment_block_entry *entries;
+	unsigned char *metadata_buffer = NULL, *metadata, *table;
 	struct squashfs_super_block *sblk = ctxt.sblk;
 	unsigned long dest_len;
 	int block, offset, ret;
 	u16 header;
 
-	metadata_buffer = NULL;
-	entries = NULL;
-	table = NULL;
-
 	if (inode_fragment_index >= get_unaligned_le32(&sblk->fragments))
 		return -EINVAL;
 
-	start = get_unaligned_le64(&sblk->fragment_table_start);
-	end = get_unaligned_le64(&sblk->id_table_start);
-	exp_tbl = get_unaligned_le64(&sblk->export_table_start);
+	block = SQFS_FRAGMENT_INDEX(inode_fragment_index);
+	offset = SQFS_FRAGMENT_INDEX_OFFSET(inode_fragment_index);
 
-	if (exp_tbl > start && exp_tbl < end)
-		end = exp_tbl;
+	if (ctxt.frag_entries && ctxt.frag_entries_block == block)
+		goto found;
 
-	n_blks = sqfs_calc_n_blks(sblk->fragment_table_start,
-				  cpu_to_le64(end), &table_offset);
+	if (!ctxt.frag_index) {
+		start = get_unaligned_le64(&sblk->fragment_table_start);
+		end = get_unaligned_le64(&sblk->id_table_start);
+		exp_tbl = get_unaligned_le64(&sblk->export_table_start);
 
-	start /= ctxt.cur_dev->blksz;
+		if (exp_tbl > start && exp_tbl < end)
+			end = exp_tbl;
 
-	/* Allocate a proper sized buffer to store the fragment index table */
-	table = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-	if (!table) {
-		ret = -ENOMEM;
-		goto out;
-	}
+		n_blks = sqfs_calc_n_blks(sblk->fragment_table_start,
+					  cpu_to_le64(end), &table_offset);
 
-	if (sqfs_disk_read(start, n_blks, table) < 0) {
-		ret = -EINVAL;
-		goto out;
-	}
+		start /= ctxt.cur_dev->blksz;
 
-	block = SQFS_FRAGMENT_INDEX(inode_fragment_index);
-	offset = SQFS_FRAGMENT_INDEX_OFFSET(inode_fragment_index);
+		/* Allocate a proper sized buffer to store the fragment index table */
+		table = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
+		if (!table)
+			return -ENOMEM;
+
+		if (sqfs_disk_read(start, n_blks, table) < 0) {
+			free(table);
+			return -EINVAL;
+		}
+
+		ctxt.frag_index = table;
+		ctxt.frag_index_offset = table_offset;
+	}
 
 	/*
 	 * Get the start offset of the metadata block that contains the right
 	 * fragment block entry
 	 */
-	start_block = get_unaligned_le64(table + table_offset + block *
-					 sizeof(u64));
+	start_block = get_unaligned_le64(ctxt.frag_index +
+					 ctxt.frag_index_offset +
+					 block * sizeof(u64));
 
 	start = start_block / ctxt.cur_dev->blksz;
 	n_blks = sqfs_calc_n_blks(cpu_to_le64(start_block),
@@ -178,32 +197,100 @@ static int sqfs_frag_lookup(u32 inode_fragment_index,
 		goto out;
 	}
 
-	entries = malloc(SQFS_METADATA_BLOCK_SIZE);
-	if (!entries) {
-		ret = -ENOMEM;
-		goto out;
+	if (!ctxt.frag_entries) {
+		ctxt.frag_entries = malloc(SQFS_METADATA_BLOCK_SIZE);
+		if (!ctxt.frag_entries) {
+			ret = -ENOMEM;
+			goto out;
+		}
 	}
 
+	/* The cached block gets overwritten below */
+	ctxt.frag_entries_block = -1;
+
 	if (SQFS_COMPRESSED_METADATA(header)) {
 		src_len = SQFS_METADATA_SIZE(header);
 		dest_len = SQFS_METADATA_BLOCK_SIZE;
-		ret = sqfs_decompress(&ctxt, entries, &dest_len, metadata,
-				      src_len);
+		ret = sqfs_decompress(&ctxt, ctxt.frag_entries, &dest_len,
+				      metadata, src_len);
 		if (ret) {
 			ret = -EINVAL;
 			goto out;
 		}
 	} else {
-		memcpy(entries, metadata, SQFS_METADATA_SIZE(header));
+		memcpy(ctxt.frag_entries, metadata, SQFS_METADATA_SIZE(header));
 	}
 
-	*e = entries[offset];
+	ctxt.frag_entries_block = block;
+
+found:
+	*e = ctxt.frag_entries[offset];
 	ret = SQFS_COMPRESSED_BLOCK(e->size);
 
 out:
-	free(entries);
 	free(metadata_buffer);
-	free(table);
+
+	return ret;
+}
+
+/*
+ * Read the fragment block described by 'fentry' into ctxt.frag_block. Small
+ * files share fragment blocks, so the last one is kept until sqfs_close().
+ */
+static int sqfs_read_frag_block(struct squashfs_fragment_block_entry *fentry,
+				bool comp)
+{
+	u32 block_size = get_unaligned_le32(&ctxt.sblk->block_size);
+	u64 start, n_blks, table_size, table_offset;
+	unsigned long dest_len;
+	char *fragment;
+	int ret;
+
+	if (ctxt.frag_block_len && ctxt.frag_block_start == fentry->start)
+		return 0;
+
+	start = lldiv(fentry->start, ctxt.cur_dev->blksz);
+	table_size = SQFS_BLOCK_SIZE(fentry->size);
+	table_offset = fentry->start - (start * ctxt.cur_dev->blksz);
+	n_blks = DIV_ROUND_UP(table_size + table_offset, ctxt.cur_dev->blksz);
+
+	if (!comp && table_size > block_size)
+		return -EINVAL;
+
+	if (!ctxt.frag_block) {
+		ctxt.frag_block = malloc(block_size);
+		if (!ctxt.frag_block)
+			return -ENOMEM;
+	}
+
+	/* The cached block gets overwritten below */
+	ctxt.frag_block_len = 0;
+
+	fragment = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
+	if (!fragment)
+		return -ENOMEM;
+
+	ret = sqfs_disk_read(start, n_blks, fragment);
+	if (ret < 0)
+		goto out;
+
+	if (comp) {
+		dest_len = block_size;
+		ret = sqfs_decompress(&ctxt, ctxt.frag_block, &dest_len,
+				      fragment + table_offset, table_size);
+		if (ret)
+			goto out;
+	} else {
+		dest_len = table_size;
+		memcpy(ctxt.frag_block, fragment + table_offset, table_size);
+	}
+
+	ctxt.frag_block_start = fentry->start;
+	ctxt.frag_block_len = dest_len;
+	ret = 0;
+
+out:
+	free(fragment);
 
 	return ret;
 }
@@ -250,7 +337,10 @@ static int sqfs_get_tokens_length(char **tokens, int count)
 	return length;
 }
 
-/* Takes a token list and returns a single string with '/' as separator. */
+/*
+ * Takes a token list and returns a single string with '/' as separator. The
+ * string is allocated from the arena.
+ */
 static char *sqfs_concat_tokens(char **token_list, int token_count)
 {
 	char *result;
@@ -258,7 +348,7 @@ static char *sqfs_concat_tokens(char **token_list, int token_count)
 
 	length = sqfs_get_tokens_length(token_list, token_count);
 
-	result = malloc(length + 1);
+	result = arena_alloc(length + 1);
 	if (!result)
 		return NULL;
 
@@ -293,40 +383,31 @@ static int sqfs_join(char **strings, char *dest, int start, int end,
 }
 
 /*
- * Fills the given token list using its size (count) and a source string (str)
+ * Fills the given token list using its size (count) and a source string (str).
+ * The tokens are allocated from the arena, so this must be called within an
+ * arena scope.
  */
 static int sqfs_tokenize(char **tokens, int count, const char *str)
 {
-	int i, j, ret = 0;
 	char *aux, *strc;
+	int j;
 
-	strc = strdup(str);
+	strc = arena_strdup(str);
 	if (!strc)
 		return -ENOMEM;
 
 	if (!strcmp(strc, "/")) {
-		tokens[0] = strdup(strc);
-		if (!tokens[0]) {
-			ret = -ENOMEM;
-			goto free_strc;
-		}
+		tokens[0] = strc;
 	} else {
 		for (j = 0; j < count; j++) {
 			aux = strtok(!j ? strc : NULL, "/");
-			tokens[j] = strdup(aux);
-			if (!tokens[j]) {
-				for (i = 0; i < j; i++)
-					free(tokens[i]);
-				ret = -ENOMEM;
-				goto free_strc;
-			}
+			if (!aux)
+				return -EINVAL;
+			tokens[j] = aux;
 		}
 	}
 
-free_strc:
-	free(strc);
-
-	return ret;
+	return 0;
 }
 
 /*
@@ -336,11 +417,6 @@ free_strc:
  */
 static int sqfs_clean_base_path(char **base, int count, int updir)
 {
-	int i;
-
-	for (i = count - updir - 1; i < count; i++)
-		free(base[i]);
-
 	return count - updir - 1;
 }
 
@@ -350,11 +426,9 @@ static int sqfs_clean_base_path(char **base, int count, int updir)
  */
 static char *sqfs_get_abs_path(const char *base, const char *rel)
 {
-	char **base_tokens, **rel_tokens, *resolved = NULL;
 	int ret, bc, rc, i, updir = 0, resolved_size = 0, offset = 0;
-
-	base_tokens = NULL;
-	rel_tokens = NULL;
+	char **base_tokens, **rel_tokens, *resolved = NULL;
+	struct arena_mark mark;
 
 	/* Memory allocation for the token lists */
 	bc = sqfs_count_tokens(base);
@@ -362,11 +436,12 @@ static char *sqfs_get_abs_path(const char *base, const char *rel)
 	if (bc < 1 || rc < 1)
 		return NULL;
 
-	base_tokens = calloc(bc, sizeof(char *));
+	mark = arena_begin();
+	base_tokens = arena_zalloc(bc * sizeof(char *));
 	if (!base_tokens)
-		return NULL;
+		goto out;
 
-	rel_tokens = calloc(rc, sizeof(char *));
+	rel_tokens = arena_zalloc(rc * sizeof(char *));
 	if (!rel_tokens)
 		goto out;
 
@@ -408,15 +483,7 @@ static char *sqfs_get_abs_path(const char *base, const char *rel)
 	offset += sqfs_join(rel_tokens, resolved + offset, updir, rc, '/');
 
 out:
-	if (rel_tokens)
-		for (i = 0; i < rc; i++)
-			free(rel_tokens[i]);
-	if (base_tokens)
-		for (i = 0; i < bc; i++)
-			free(base_tokens[i]);
-
-	free(rel_tokens);
-	free(base_tokens);
+	arena_release(mark);
 
 	return resolved;
 }
@@ -424,15 +491,19 @@ out:
 static char *sqfs_resolve_symlink(struct squashfs_symlink_inode *sym,
 				  const char *base_path)
 {
+	struct arena_mark mark;
 	char *resolved, *target;
 	u32 sz;
 
 	if (__builtin_add_overflow(get_unaligned_le32(&sym->symlink_size), 1, &sz))
 		return NULL;
 
-	target = malloc(sz);
-	if (!target)
+	mark = arena_begin();
+	target = arena_alloc(sz);
+	if (!target) {
+		arena_release(mark);
 		return NULL;
+	}
 
 	/*
 	 * There is no trailling null byte in the symlink's target path, so a
@@ -445,40 +516,38 @@ static char *sqfs_resolve_symlink(struct squashfs_symlink_inode *sym,
 	/* Relative -> absolute path conversion */
 	resolved = sqfs_get_abs_path(base_path, target);
 
-	free(target);
+	arena_release(mark);
 
 	return resolved;
 }
 
 /*
- * m_list contains each metadata block's position, and m_count is the number of
- * elements of m_list. Those metadata blocks come from the compressed directory
- * table.
+ * Walk the tokens of a path from the root directory, leaving 'dirs' on the
+ * directory it designates.
  */
 static int sqfs_search_dir(struct squashfs_dir_stream *dirs, char **token_list,
-			   int token_count, u32 *m_list, int m_count)
+			   int token_count)
 {
 	struct squashfs_super_block *sblk = ctxt.sblk;
 	char *path, *target, **sym_tokens, *res, *rem;
-	int j, ret = 0, new_inode_number, offset;
+	int j, ret = 0, offset;
 	struct squashfs_symlink_inode *sym;
 	struct squashfs_ldir_inode *ldir;
 	struct squashfs_dir_inode *dir;
 	struct fs_dir_stream *dirsp;
+	struct arena_mark mark;
 	struct fs_dirent *dent;
 	unsigned char *table;
+	u64 root;
 
-	res = NULL;
-	rem = NULL;
-	path = NULL;
 	target = NULL;
-	sym_tokens = NULL;
+	mark = arena_begin();
 
 	dirsp = (struct fs_dir_stream *)dirs;
 
-	/* Start by root inode */
-	table = sqfs_find_inode(dirs->inode_table, le32_to_cpu(sblk->inodes),
-				sblk->inodes, sblk->block_size);
+	/* Start by root inode, referenced as (metadata block << 16 | offset) */
+	root = get_unaligned_le64(&sblk->root_inode);
+	table = sqfs_get_inode(root >> 16, root & 0xFFFF);
 	if (!table)
 		return -EINVAL;
 
@@ -486,7 +555,9 @@ static int sqfs_search_dir(struct squashfs_dir_stream *dirs, char **token_list,
 	ldir = (struct squashfs_ldir_inode *)table;
 
 	/* get directory offset in directory table */
-	offset = sqfs_dir_offset(table, m_list, m_count);
+	offset = sqfs_load_dir(table);
+	if (offset < 0)
+		return offset;
 	dirs->table = &dirs->dir_table[offset];
 
 	/* Setup directory header */
@@ -529,13 +600,9 @@ static int sqfs_search_dir(struct squashfs_dir_stream *dirs, char **token_list,
 			goto out;
 		}
 
-		/* Redefine inode as the found token */
-		new_inode_number = dirs->entry->inode_offset +
-			dirs->dir_header->inode_number;
-
-		/* Get reference to inode in the inode table */
-		table = sqfs_find_inode(dirs->inode_table, new_inode_number,
-					sblk->inodes, sblk->block_size);
+		/* Get reference to the found token's inode in the inode table */
+		table = sqfs_get_inode(dirs->dir_header->start,
+				       dirs->entry->offset);
 		if (!table)
 			return -EINVAL;
 		dir = (struct squashfs_dir_inode *)table;
@@ -571,7 +638,7 @@ static int sqfs_search_dir(struct squashfs_dir_stream *dirs, char **token_list,
 			 * Concatenate remaining tokens and symlink's target.
 			 * Allocate enough space for rem, target, '/' and '\0'.
 			 */
-			res = malloc(strlen(rem) + strlen(target) + 2);
+			res = arena_alloc(strlen(rem) + strlen(target) + 2);
 			if (!res) {
 				ret = -ENOMEM;
 				goto out;
@@ -586,7 +653,7 @@ static int sqfs_search_dir(struct squashfs_dir_stream *dirs, char **token_list,
 				goto out;
 			}
 
-			sym_tokens = malloc(token_count * sizeof(char *));
+			sym_tokens = arena_alloc(token_count * sizeof(char *));
 			if (!sym_tokens) {
 				ret = -EINVAL;
 				goto out;
@@ -601,8 +668,7 @@ static int sqfs_search_dir(struct squashfs_dir_stream *dirs, char **token_list,
 			free(dirs->entry);
 			dirs->entry = NULL;
 
-			ret = sqfs_search_dir(dirs, sym_tokens, token_count,
-					      m_list, m_count);
+			ret = sqfs_search_dir(dirs, sym_tokens, token_count);
 			goto out;
 		} else if (!sqfs_is_dir(get_unaligned_le16(&dir->inode_type))) {
 			printf("** Cannot find directory. **\n");
@@ -617,7 +683,13 @@ static int sqfs_search_dir(struct squashfs_dir_stream *dirs, char **token_list,
 			ldir = (struct squashfs_ldir_inode *)table;
 
 		/* Get dir. offset into the directory table */
-		offset = sqfs_dir_offset(table, m_list, m_count);
+		offset = sqfs_load_dir(table);
+		if (offset < 0) {
+			free(dirs->entry);
+			dirs->entry = NULL;
+			ret = offset;
+			goto out;
+		}
 		dirs->table = &dirs->dir_table[offset];
 
 		/* Copy directory header */
@@ -641,7 +713,11 @@ static int sqfs_search_dir(struct squashfs_dir_stream *dirs, char **token_list,
 		dirs->entry = NULL;
 	}
 
-	offset = sqfs_dir_offset(table, m_list, m_count);
+	offset = sqfs_load_dir(table);
+	if (offset < 0) {
+		ret = offset;
+		goto out;
+	}
 	dirs->table = &dirs->dir_table[offset];
 
 	if (get_unaligned_le16(&dir->inode_type) == SQFS_DIR_TYPE)
@@ -650,11 +726,8 @@ static int sqfs_search_dir(struct squashfs_dir_stream *dirs, char **token_list,
 		memcpy(&dirs->i_ldir, ldir, sizeof(*ldir));
 
 out:
-	free(res);
-	free(rem);
-	free(path);
 	free(target);
-	free(sym_tokens);
+	arena_release(mark);
 	return ret;
 }
 
@@ -710,224 +783,280 @@ static int sqfs_get_metablk_pos(u32 *pos_list, void *table, u32 offset,
 	return ret;
 }
 
-static int sqfs_read_inode_table(unsigned char **inode_table)
+static void sqfs_metatable_close(struct squashfs_metatable *t)
 {
-	struct squashfs_super_block *sblk = ctxt.sblk;
-	u64 start, n_blks, table_offset, table_size;
-	int j, ret = 0, metablks_count;
-	unsigned char *src_table, *itb;
-	u32 src_len, dest_offset = 0;
-	unsigned long dest_len = 0;
-	bool compressed;
+	free(t->raw);
+	free(t->data);
+	free(t->loaded);
+	free(t->pos_list);
+	memset(t, 0, sizeof(*t));
+}
 
-	table_size = get_unaligned_le64(&sblk->directory_table_start) -
-		get_unaligned_le64(&sblk->inode_table_start);
-	start = get_unaligned_le64(&sblk->inode_table_start) /
-		ctxt.cur_dev->blksz;
-	n_blks = sqfs_calc_n_blks(sblk->inode_table_start,
-				  sblk->directory_table_start, &table_offset);
+/*
+ * Read a whole inode or directory table from the medium and index its
+ * metadata blocks. Nothing is decompressed yet, see sqfs_metatable_load().
+ */
+static int sqfs_metatable_open(struct squashfs_metatable *t, __le64 start,
+			       __le64 end)
+{
+	u64 n_blks, table_offset, table_size;
+	int ret;
 
-	/* Allocate a proper sized buffer (itb) to store the inode table */
-	itb = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-	if (!itb)
-		return -ENOMEM;
+	table_size = le64_to_cpu(end) - le64_to_cpu(start);
+	n_blks = sqfs_calc_n_blks(start, end, &table_offset);
 
-	if (sqfs_disk_read(start, n_blks, itb) < 0) {
-		ret = -EINVAL;
-		goto free_itb;
-	}
+	t->raw = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
+	if (!t->raw)
+		return -ENOMEM;
 
-	/* Parse inode table (metadata block) header */
-	ret = sqfs_read_metablock(itb, table_offset, &compressed, &src_len);
-	if (ret) {
+	if (sqfs_disk_read(le64_to_cpu(start) / ctxt.cur_dev->blksz, n_blks,
+			   t->raw) < 0) {
 		ret = -EINVAL;
-		goto free_itb;
+		goto err;
 	}
 
-	/* Calculate size to store the whole decompressed table */
-	metablks_count = sqfs_count_metablks(itb, table_offset, table_size);
-	if (metablks_count < 1) {
+	t->count = sqfs_count_metablks(t->raw, table_offset, table_size);
+	if (t->count < 1) {
 		ret = -EINVAL;
-		goto free_itb;
+		goto err;
 	}
 
-	*inode_table = kcalloc(metablks_count, SQFS_METADATA_BLOCK_SIZE,
-			       GFP_KERNEL);
-	if (!*inode_table) {
+	t->data = kcalloc(t->count, SQFS_METADATA_BLOCK_SIZE, GFP_KERNEL);
+	t->loaded = calloc(t->count, sizeof(*t->loaded));
+	t->pos_list = malloc(t->count * sizeof(u32));
+	if (!t->data || !t->loaded || !t->pos_list) {
+		printf("Error: failed to allocate squashfs metadata table of size %i, increasing CONFIG_SYS_MALLOC_LEN could help\n",
+		       t->count * SQFS_METADATA_BLOCK_SIZE);
 		ret = -ENOMEM;
-		printf("Error: failed to allocate squashfs inode_table of size %i, increasing CONFIG_SYS_MALLOC_LEN could help\n",
-		       metablks_count * SQFS_METADATA_BLOCK_SIZE);
-		goto free_itb;
+		goto err;
 	}
 
-	src_table = itb + table_offset + SQFS_HEADER_SIZE;
+	ret = sqfs_get_metablk_pos(t->pos_list, t->raw, table_offset,
+				   t->count);
+	if (ret)
+		goto err;
 
-	/* Extract compressed Inode table */
-	for (j = 0; j < metablks_count; j++) {
-		sqfs_read_metablock(itb, table_offset, &compressed, &src_len);
+	t->raw_offset = table_offset;
+
+	return 0;
+
+err:
+	sqfs_metatable_close(t);
+
+	return ret;
+}
+
+/*
+ * Make sure bytes [offset, offset + len) of a decompressed table can be
+ * accessed, decompressing the metadata blocks covering them on first use.
+ */
+static int sqfs_metatable_load(struct squashfs_metatable *t, u32 offset,
+			       u32 len)
+{
+	int j, first, last, ret;
+	unsigned long dest_len;
+	u32 src_len, src_pos;
+	unsigned char *dest;
+	bool compressed;
+
+	first = offset / SQFS_METADATA_BLOCK_SIZE;
+	last = (offset + max(len, 1U) - 1) / SQFS_METADATA_BLOCK_SIZE;
+	if (first >= t->count)
+		return -EINVAL;
+	last = min(last, t->count - 1);
+
+	for (j = first; j <= last; j++) {
+		if (t->loaded[j])
+			continue;
+
+		src_pos = t->raw_offset + (j ? t->pos_list[j - 1] : 0);
+		ret = sqfs_read_metablock(t->raw, src_pos, &compressed,
+					  &src_len);
+		if (ret)
+			return -EINVAL;
+
+		dest = t->data + j * SQFS_METADATA_BLOCK_SIZE;
 		if (compressed) {
 			dest_len = SQFS_METADATA_BLOCK_SIZE;
-			ret = sqfs_decompress(&ctxt, *inode_table +
-					      dest_offset, &dest_len,
-					      src_table, src_len);
-			if (ret) {
-				free(*inode_table);
-				*inode_table = NULL;
-				goto free_itb;
-			}
-
-			dest_offset += dest_len;
+			ret = sqfs_decompress(&ctxt, dest, &dest_len,
+					      t->raw + src_pos + SQFS_HEADER_SIZE,
+					      src_len);
+			if (ret)
+				return -EINVAL;
 		} else {
-			memcpy(*inode_table + (j * SQFS_METADATA_BLOCK_SIZE),
-			       src_table, src_len);
+			memcpy(dest, t->raw + src_pos + SQFS_HEADER_SIZE,
+			       src_len);
 		}
 
-		/*
-		 * Offsets to the decompression destination, to the metadata
-		 * buffer 'itb' and to the decompression source, respectively.
-		 */
-
-		table_offset += src_len + SQFS_HEADER_SIZE;
-		src_table += src_len + SQFS_HEADER_SIZE;
+		t->loaded[j] = true;
 	}
 
-free_itb:
-	free(itb);
-
-	return ret;
+	return 0;
 }
 
-static int sqfs_read_directory_table(unsigned char **dir_table, u32 **pos_list)
+/*
+ * Convert a (metadata block, offset) reference into an offset in the
+ * decompressed table. Metadata blocks are referenced by their compressed
+ * position, which is what t->pos_list records, in ascending order.
+ */
+static int sqfs_metatable_offset(struct squashfs_metatable *t, u32 start_block,
+				 u16 offset)
 {
-	u64 start, n_blks, table_offset, table_size;
-	struct squashfs_super_block *sblk = ctxt.sblk;
-	int j, ret = 0, metablks_count = -1;
-	unsigned char *src_table, *dtb;
-	u32 src_len, dest_offset = 0;
-	unsigned long dest_len = 0;
-	bool compressed;
+	int lo = 0, hi = t->count - 1, mid;
+
+	if (!start_block)
+		return offset;
+
+	while (lo <= hi) {
+		mid = lo + (hi - lo) / 2;
+		if (t->pos_list[mid] == start_block)
+			return (mid + 1) * SQFS_METADATA_BLOCK_SIZE + offset;
+		if (t->pos_list[mid] < start_block)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
 
-	*dir_table = NULL;
-	*pos_list = NULL;
-	/* DIRECTORY TABLE */
-	table_size = get_unaligned_le64(&sblk->fragment_table_start) -
-		get_unaligned_le64(&sblk->directory_table_start);
-	start = get_unaligned_le64(&sblk->directory_table_start) /
-		ctxt.cur_dev->blksz;
-	n_blks = sqfs_calc_n_blks(sblk->directory_table_start,
-				  sblk->fragment_table_start, &table_offset);
+	return -EINVAL;
+}
 
-	/* Allocate a proper sized buffer (dtb) to store the directory table */
-	dtb = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-	if (!dtb)
-		return -ENOMEM;
+/*
+ * Return the inode at (start_block, offset) in the inode table, as found in
+ * directory headers/entries and in the superblock root inode reference.
+ */
+static void *sqfs_get_inode(u32 start_block, u16 offset)
+{
+	struct squashfs_metatable *t = &ctxt.inode_table;
+	u32 blk_size = get_unaligned_le32(&ctxt.sblk->block_size);
+	struct squashfs_base_inode *base;
+	int pos, sz, len = sizeof(*base);
 
-	if (sqfs_disk_read(start, n_blks, dtb) < 0)
-		goto out;
+	pos = sqfs_metatable_offset(t, start_block, offset);
+	if (pos < 0) {
+		printf("Error: invalid inode reference to inode table.\n");
+		return NULL;
+	}
 
-	/* Parse directory table (metadata block) header */
-	ret = sqfs_read_metablock(dtb, table_offset, &compressed, &src_len);
-	if (ret)
-		goto out;
+	base = (void *)t->data + pos;
 
-	/* Calculate total size to store the whole decompressed table */
-	metablks_count = sqfs_count_metablks(dtb, table_offset, table_size);
-	if (metablks_count < 1)
-		goto out;
+	/*
+	 * An inode's size depends on fields past its base (block list, symlink
+	 * target, directory index), so grow the loaded range until it covers
+	 * the whole inode.
+	 */
+	for (;;) {
+		if (sqfs_metatable_load(t, pos, len))
+			return NULL;
 
-	*dir_table = malloc(metablks_count * SQFS_METADATA_BLOCK_SIZE);
-	if (!*dir_table)
-		goto out;
+		sz = sqfs_inode_size(base, blk_size);
+		if (sz < 0 || pos + sz > t->count * SQFS_METADATA_BLOCK_SIZE)
+			return NULL;
 
-	*pos_list = malloc(metablks_count * sizeof(u32));
-	if (!*pos_list)
-		goto out;
+		if (sz <= len)
+			return base;
 
-	ret = sqfs_get_metablk_pos(*pos_list, dtb, table_offset,
-				   metablks_count);
-	if (ret) {
-		metablks_count = -1;
-		goto out;
+		len = sz;
 	}
+}
 
-	src_table = dtb + table_offset + SQFS_HEADER_SIZE;
+/*
+ * Return the offset of a directory's listing in the directory table, once the
+ * metadata blocks holding it are decompressed.
+ */
+static int sqfs_load_dir(void *dir_i)
+{
+	struct squashfs_metatable *t = &ctxt.dir_table;
+	struct squashfs_base_inode *base = dir_i;
+	struct squashfs_ldir_inode *ldir;
+	struct squashfs_dir_inode *dir;
+	int offset, ret;
+	u32 size;
 
-	/* Extract compressed Directory table */
-	dest_offset = 0;
-	for (j = 0; j < metablks_count; j++) {
-		sqfs_read_metablock(dtb, table_offset, &compressed, &src_len);
-		if (compressed) {
-			dest_len = SQFS_METADATA_BLOCK_SIZE;
-			ret = sqfs_decompress(&ctxt, *dir_table +
-					      (j * SQFS_METADATA_BLOCK_SIZE),
-					      &dest_len, src_table, src_len);
-			if (ret) {
-				metablks_count = -1;
-				goto out;
-			}
+	offset = sqfs_dir_offset(dir_i, t->pos_list, t->count);
+	if (offset < 0)
+		return offset;
 
-			if (dest_len < SQFS_METADATA_BLOCK_SIZE) {
-				dest_offset += dest_len;
-				break;
-			}
+	if (get_unaligned_le16(&base->inode_type) == SQFS_DIR_TYPE) {
+		dir = (struct squashfs_dir_inode *)base;
+		size = get_unaligned_le16(&dir->file_size);
+	} else {
+		ldir = (struct squashfs_ldir_inode *)base;
+		size = get_unaligned_le32(&ldir->file_size);
+	}
 
-			dest_offset += dest_len;
-		} else {
-			memcpy(*dir_table + (j * SQFS_METADATA_BLOCK_SIZE),
-			       src_table, src_len);
-		}
+	ret = sqfs_metatable_load(t, offset,
+				  max_t(u32, size, SQFS_DIR_HEADER_SIZE));
+	if (ret)
+		return ret;
 
-		/*
-		 * Offsets to the decompression destination, to the metadata
-		 * buffer 'dtb' and to the decompression source, respectively.
-		 */
-		table_offset += src_len + SQFS_HEADER_SIZE;
-		src_table += src_len + SQFS_HEADER_SIZE;
+	return offset;
+}
+
+/*
+ * The inode and directory tables are read once per mount, then kept until
+ * sqfs_close(). Only the metadata blocks that lookups touch get decompressed.
+ */
+static int sqfs_read_tables(void)
+{
+	struct squashfs_super_block *sblk = ctxt.sblk;
+	int ret;
+
+	if (!ctxt.inode_table.data) {
+		ret = sqfs_metatable_open(&ctxt.inode_table,
+					  sblk->inode_table_start,
+					  sblk->directory_table_start);
+		if (ret)
+			return ret;
 	}
 
-out:
-	if (metablks_count < 1) {
-		free(*dir_table);
-		free(*pos_list);
-		*dir_table = NULL;
-		*pos_list = NULL;
+	if (!ctxt.dir_table.data) {
+		ret = sqfs_metatable_open(&ctxt.dir_table,
+					  sblk->directory_table_start,
+					  sblk->fragment_table_start);
+		if (ret)
+			return ret;
 	}
-	free(dtb);
 
-	return metablks_count;
+	return 0;
+}
+
+static void sqfs_free_caches(void)
+{
+	sqfs_metatable_close(&ctxt.inode_table);
+	sqfs_metatable_close(&ctxt.dir_table);
+	free(ctxt.frag_index);
+	ctxt.frag_index = NULL;
+	free(ctxt.frag_entries);
+	ctxt.frag_entries = NULL;
+	free(ctxt.frag_block);
+	ctxt.frag_block = NULL;
+	ctxt.frag_block_len = 0;
 }
 
 static int sqfs_opendir_nest(const char *filename, struct fs_dir_stream **dirsp)
 {
-	unsigned char *inode_table = NULL, *dir_table = NULL;
-	int j, token_count = 0, ret = 0, metablks_count;
+	int token_count = 0, ret = 0;
 	struct squashfs_dir_stream *dirs;
-	char **token_list = NULL, *path = NULL;
-	u32 *pos_list = NULL;
+	char **token_list;
+	struct arena_mark mark;
 
 	dirs = calloc(1, sizeof(*dirs));
 	if (!dirs)
 		return -EINVAL;
+	mark = arena_begin();
 
 	/* these should be set to NULL to prevent dangling pointers */
 	dirs->dir_header = NULL;
 	dirs->entry = NULL;
 	dirs->table = NULL;
-	dirs->inode_table = NULL;
 	dirs->dir_table = NULL;
 
-	ret = sqfs_read_inode_table(&inode_table);
+	ret = sqfs_read_tables();
 	if (ret) {
 		ret = -EINVAL;
 		goto out;
 	}
 
-	metablks_count = sqfs_read_directory_table(&dir_table, &pos_list);
-	if (metablks_count < 1) {
-		ret = -EINVAL;
-		goto out;
-	}
-
 	/* Tokenize filename */
 	token_count = sqfs_count_tokens(filename);
 	if (token_count < 0) {
@@ -935,30 +1064,22 @@ static int sqfs_opendir_nest(const char *filename, struct fs_dir_stream **dirsp)
 		goto out;
 	}
 
-	path = strdup(filename);
-	if (!path) {
-		ret = -EINVAL;
-		goto out;
-	}
-
-	token_list = malloc(token_count * sizeof(char *));
+	token_list = arena_alloc(token_count * sizeof(char *));
 	if (!token_list) {
 		ret = -EINVAL;
 		goto out;
 	}
 
 	/* Fill tokens list */
-	ret = sqfs_tokenize(token_list, token_count, path);
+	ret = sqfs_tokenize(token_list, token_count, filename);
 	if (ret)
 		goto out;
 	/*
 	 * ldir's (extended directory) size is greater than dir, so it works as
 	 * a general solution for the malloc size, since 'i' is a union.
 	 */
-	dirs->inode_table = inode_table;
-	dirs->dir_table = dir_table;
-	ret = sqfs_search_dir(dirs, token_list, token_count, pos_list,
-			      metablks_count);
+	dirs->dir_table = ctxt.dir_table.data;
+	ret = sqfs_search_dir(dirs, token_list, token_count);
 	if (ret)
 		goto out;
 
@@ -979,15 +1100,9 @@ static int sqfs_opendir_nest(const char *filename, struct fs_dir_stream **dirsp)
 	*dirsp = (struct fs_dir_stream *)dirs;
 
 out:
-	for (j = 0; j < token_count; j++)
-		free(token_list[j]);
-	free(token_list);
-	free(pos_list);
-	free(path);
-	if (ret) {
-		free(inode_table);
+	arena_release(mark);
+	if (ret)
 		free(dirs);
-	}
 
 	return ret;
 }
@@ -1006,12 +1121,11 @@ int sqfs_readdir(struct fs_dir_stream *fs_dirs, struct fs_dirent **dentp)
 
 static int sqfs_readdir_nest(struct fs_dir_stream *fs_dirs, struct fs_dirent **dentp)
 {
-	struct squashfs_super_block *sblk = ctxt.sblk;
 	struct squashfs_dir_stream *dirs;
 	struct squashfs_lreg_inode *lreg;
 	struct squashfs_base_inode *base;
 	struct squashfs_reg_inode *reg;
-	int i_number, offset = 0, ret;
+	int offset = 0, ret;
 	struct fs_dirent *dent;
 	unsigned char *ipos;
 	u16 name_size;
@@ -1051,9 +1165,7 @@ static int sqfs_readdir_nest(struct fs_dir_stream *fs_dirs, struct fs_dirent **d
 			return -SQFS_STOP_READDIR;
 	}
 
-	i_number = dirs->dir_header->inode_number + dirs->entry->inode_offset;
-	ipos = sqfs_find_inode(dirs->inode_table, i_number, sblk->inodes,
-			       sblk->block_size);
+	ipos = sqfs_get_inode(dirs->dir_header->start, dirs->entry->offset);
 	if (!ipos)
 		return -SQFS_STOP_READDIR;
 
@@ -1126,6 +1238,7 @@ int sqfs_probe(struct blk_desc *fs_dev_desc, struct disk_partition *fs_partition
 	struct squashfs_super_block *sblk;
 	int ret;
 
+	sqfs_free_caches();
 	ctxt.cur_dev = fs_dev_desc;
 	ctxt.cur_part_info = *fs_partition;
 
@@ -1353,10 +1466,12 @@ static int sqfs_get_lregfile_info(struct squashfs_lreg_inode *lreg,
 static int sqfs_read_nest(const char *filename, void *buf, loff_t offset,
 			  loff_t len, loff_t *actread)
 {
-	char *dir = NULL, *fragment_block, *datablock = NULL;
-	char *fragment = NULL, *file = NULL, *resolved, *data;
+	char *dir = NULL, *datablock = NULL, *file = NULL, *resolved, *data;
 	u64 start, n_blks, table_size, data_offset, table_offset, sparse_size;
-	int ret, j, i_number, datablk_count = 0;
+	int ret, j, k, run, datablk_count = 0;
+	char *data_buffer = NULL, *dest;
+	const char *mapped;
+	u32 block_size, run_size;
 	struct squashfs_super_block *sblk = ctxt.sblk;
 	struct squashfs_fragment_block_entry frag_entry;
 	struct squashfs_file_info finfo = {0};
@@ -1381,7 +1496,7 @@ static int sqfs_read_nest(const char *filename, void *buf, loff_t offset,
 	}
 
 	/*
-	 * sqfs_opendir_nest will uncompress inode and directory tables, and will
+	 * sqfs_opendir_nest will load inode and directory tables, and will
 	 * return a pointer to the directory that contains the requested file.
 	 */
 	sqfs_split_path(&file, &dir, filename);
@@ -1409,9 +1524,7 @@ static int sqfs_read_nest(const char *filename, void *buf, loff_t offset,
 		goto out;
 	}
 
-	i_number = dirs->dir_header->inode_number + dirs->entry->inode_offset;
-	ipos = sqfs_find_inode(dirs->inode_table, i_number, sblk->inodes,
-			       sblk->block_size);
+	ipos = sqfs_get_inode(dirs->dir_header->start, dirs->entry->offset);
 	if (!ipos) {
 		ret = -EINVAL;
 		goto out;
@@ -1482,44 +1595,67 @@ static int sqfs_read_nest(const char *filename, void *buf, loff_t offset,
 		len = finfo.size;
 	}
 
+	block_size = get_unaligned_le32(&sblk->block_size);
 	if (datablk_count) {
 		data_offset = finfo.start;
-		datablock = malloc(get_unaligned_le32(&sblk->block_size));
-		if (!datablock) {
+		datablock = malloc(block_size);
+		data_buffer = malloc_cache_aligned(max_t(u32, SQFS_READ_RUN_SIZE,
+							 block_size) +
+						   2 * ctxt.cur_dev->blksz);
+		if (!datablock || !data_buffer) {
 			ret = -ENOMEM;
 			goto out;
 		}
 	}
 
-	for (j = 0; j < datablk_count; j++) {
-		char *data_buffer;
-
-		start = lldiv(data_offset, ctxt.cur_dev->blksz);
-		table_size = SQFS_BLOCK_SIZE(finfo.blk_sizes[j]);
-		table_offset = data_offset - (start * ctxt.cur_dev->blksz);
-		n_blks = DIV_ROUND_UP(table_size + table_offset,
-				      ctxt.cur_dev->blksz);
-
+	for (j = 0; j < datablk_count && *actread < len; j += run) {
 		/* Don't load any data for sparse blocks */
 		if (finfo.blk_sizes[j] == 0) {
-			n_blks = 0;
-			table_offset = 0;
-			data_buffer = NULL;
-			data = NULL;
-		} else {
-			data_buffer = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
+			sparse_size = block_size;
+			if ((*actread + sparse_size) > len)
+				sparse_size = len - *actread;
+			memset(buf + *actread, 0, sparse_size);
+			*actread += sparse_size;
+			run = 1;
+			continue;
+		}
 
-			if (!data_buffer) {
-				ret = -ENOMEM;
+		/*
+		 * Data blocks are stored back to back, so fetch the following
+		 * non-sparse blocks that are still needed in the same request.
+		 */
+		run_size = 0;
+		for (run = 0; j + run < datablk_count; run++) {
+			table_size = SQFS_BLOCK_SIZE(finfo.blk_sizes[j + run]);
+			if (table_size > block_size) {
+				ret = -EINVAL;
 				goto out;
 			}
 
+			if (!table_size || (u64)run * block_size >= len - *actread ||
+			    (run && run_size + table_size > SQFS_READ_RUN_SIZE))
+				break;
+
+			run_size += table_size;
+		}
+
+		start = lldiv(data_offset, ctxt.cur_dev->blksz);
+		table_offset = data_offset - (start * ctxt.cur_dev->blksz);
+		n_blks = DIV_ROUND_UP(run_size + table_offset,
+				      ctxt.cur_dev->blksz);
+
+		/* The data is only read, so it can stay where it is in memory */
+		mapped = sqfs_disk_map(start, n_blks);
+		if (mapped) {
+			data = (char *)mapped + table_offset;
+		} else {
 			ret = sqfs_disk_read(start, n_blks, data_buffer);
 			if (ret < 0) {
 				/*
-				 * Possible causes: too many data blocks or too large
-				 * SquashFS block size. Tip: re-compile the SquashFS
-				 * image with mksquashfs's -b <block_size> option.
+				 * Possible causes: too many data blocks or too
+				 * large SquashFS block size. Tip: re-compile
+				 * the SquashFS image with mksquashfs's
+				 * -b <block_size> option.
 				 */
 				printf("Error: too many data blocks to be read.\n");
 				goto out;
@@ -1527,37 +1663,39 @@ static int sqfs_read_nest(const char *filename, void *buf, loff_t offset,
 
 			data = data_buffer + table_offset;
 		}
+		for (k = 0; k < run && *actread < len; k++) {
+			table_size = SQFS_BLOCK_SIZE(finfo.blk_sizes[j + k]);
+
+			if (SQFS_COMPRESSED_BLOCK(finfo.blk_sizes[j + k])) {
+				/* Full blocks are decompressed in place */
+				if (len - *actread >= block_size)
+					dest = buf + *actread;
+				else
+					dest = datablock;
+
+				dest_len = block_size;
+				ret = sqfs_decompress(&ctxt, dest, &dest_len,
+						      data, table_size);
+				if (ret)
+					goto out;
+
+				if ((*actread + dest_len) > len)
+					dest_len = len - *actread;
+				if (dest == datablock)
+					memcpy(buf + *actread, datablock,
+					       dest_len);
+				*actread += dest_len;
+			} else {
+				if ((*actread + table_size) > len)
+					table_size = len - *actread;
+				memcpy(buf + *actread, data, table_size);
+				*actread += table_size;
+			}
 
-		/* Load the data */
-		if (finfo.blk_sizes[j] == 0) {
-			/* This is a sparse block */
-			sparse_size = get_unaligned_le32(&sblk->block_size);
-			if ((*actread + sparse_size) > len)
-				sparse_size = len - *actread;
-			memset(buf + *actread, 0, sparse_size);
-			*actread += sparse_size;
-		} else if (SQFS_COMPRESSED_BLOCK(finfo.blk_sizes[j])) {
-			dest_len = get_unaligned_le32(&sblk->block_size);
-			ret = sqfs_decompress(&ctxt, datablock, &dest_len,
-					      data, table_size);
-			if (ret)
-				goto out;
-
-			if ((*actread + dest_len) > len)
-				dest_len = len - *actread;
-			memcpy(buf + *actread, datablock, dest_len);
-			*actread += dest_len;
-		} else {
-			if ((*actread + table_size) > len)
-				table_size = len - *actread;
-			memcpy(buf + *actread, data, table_size);
-			*actread += table_size;
+			data += SQFS_BLOCK_SIZE(finfo.blk_sizes[j + k]);
 		}
 
-		data_offset += table_size;
-		free(data_buffer);
-		if (*actread >= len)
-			break;
+		data_offset += run_size;
 	}
 
 	/*
@@ -1568,53 +1706,21 @@ static int sqfs_read_nest(const char *filename, void *buf, loff_t offset,
 		goto out;
 	}
 
-	start = lldiv(frag_entry.start, ctxt.cur_dev->blksz);
-	table_size = SQFS_BLOCK_SIZE(frag_entry.size);
-	table_offset = frag_entry.start - (start * ctxt.cur_dev->blksz);
-	n_blks = DIV_ROUND_UP(table_size + table_offset, ctxt.cur_dev->blksz);
-
-	fragment = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-
-	if (!fragment) {
-		ret = -ENOMEM;
+	ret = sqfs_read_frag_block(&frag_entry, finfo.comp);
+	if (ret)
 		goto out;
-	}
 
-	ret = sqfs_disk_read(start, n_blks, fragment);
-	if (ret < 0)
+	if (finfo.offset + finfo.size - *actread > ctxt.frag_block_len) {
+		ret = -EINVAL;
 		goto out;
-
-	/* File compressed and fragmented */
-	if (finfo.frag && finfo.comp) {
-		dest_len = get_unaligned_le32(&sblk->block_size);
-		fragment_block = malloc(dest_len);
-		if (!fragment_block) {
-			ret = -ENOMEM;
-			goto out;
-		}
-
-		ret = sqfs_decompress(&ctxt, fragment_block, &dest_len,
-				      (void *)fragment  + table_offset,
-				      frag_entry.size);
-		if (ret) {
-			free(fragment_block);
-			goto out;
-		}
-
-		memcpy(buf + *actread, &fragment_block[finfo.offset], finfo.size - *actread);
-		*actread = finfo.size;
-
-		free(fragment_block);
-
-	} else if (finfo.frag && !finfo.comp) {
-		fragment_block = (void *)fragment + table_offset;
-
-		memcpy(buf + *actread, &fragment_block[finfo.offset], finfo.size - *actread);
-		*actread = finfo.size;
 	}
 
+	memcpy(buf + *actread, &ctxt.frag_block[finfo.offset],
+	       finfo.size - *actread);
+	*actread = finfo.size;
+
 out:
-	free(fragment);
+	free(data_buffer);
 	free(datablock);
 	free(file);
 	free(dir);
@@ -1633,7 +1739,6 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 
 static int sqfs_size_nest(const char *filename, loff_t *size)
 {
-	struct squashfs_super_block *sblk = ctxt.sblk;
 	struct squashfs_symlink_inode *symlink;
 	struct fs_dir_stream *dirsp = NULL;
 	struct squashfs_base_inode *base;
@@ -1643,11 +1748,11 @@ static int sqfs_size_nest(const char *filename, loff_t *size)
 	char *dir, *file, *resolved;
 	struct fs_dirent *dent;
 	unsigned char *ipos;
-	int ret, i_number;
+	int ret;
 
 	sqfs_split_path(&file, &dir, filename);
 	/*
-	 * sqfs_opendir_nest will uncompress inode and directory tables, and will
+	 * sqfs_opendir_nest will load inode and directory tables, and will
 	 * return a pointer to the directory that contains the requested file.
 	 */
 	ret = sqfs_opendir_nest(dir, &dirsp);
@@ -1673,9 +1778,7 @@ static int sqfs_size_nest(const char *filename, loff_t *size)
 		goto free_strings;
 	}
 
-	i_number = dirs->dir_header->inode_number + dirs->entry->inode_offset;
-	ipos = sqfs_find_inode(dirs->inode_table, i_number, sblk->inodes,
-			       sblk->block_size);
+	ipos = sqfs_get_inode(dirs->dir_header->start, dirs->entry->offset);
 
 	if (!ipos) {
 		*size = 0;
@@ -1742,7 +1845,7 @@ int sqfs_exists(const char *filename)
 
 	sqfs_split_path(&file, &dir, filename);
 	/*
-	 * sqfs_opendir_nest will uncompress inode and directory tables, and will
+	 * sqfs_opendir_nest will load inode and directory tables, and will
 	 * return a pointer to the directory that contains the requested file.
 	 */
 	symlinknest = 0;
@@ -1779,6 +1882,7 @@ int sqfs_size(const char *filename, loff_t *size)
 
 void sqfs_close(void)
 {
+	sqfs_free_caches();
 	sqfs_decompressor_cleanup(&ctxt);
 	free(ctxt.sblk);
 	ctxt.sblk = NULL;
@@ -1793,8 +1897,6 @@ void sqfs_closedir(struct fs_dir_stream *dirs)
 		return;
 
 	sqfs_dirs = (struct squashfs_dir_stream *)dirs;
-	free(sqfs_dirs->inode_table);
-	free(sqfs_dirs->dir_table);
 	free(sqfs_dirs->dir_header);
 	free(sqfs_dirs);
 }
@@ -29,6 +29,11 @@
 #include "sqfs_decompressor.h"
 #include "sqfs_utils.h"
 
+/*
+ * The zlib and zstd states are set up here once per mount, and only reset
+ * between blocks: a large file read otherwise pays for allocating and
+ * initialising them for every single data block.
+ */
 int sqfs_decompressor_init(struct squashfs_ctxt *ctxt)
 {
 	u16 comp_type = get_unaligned_le16(&ctxt->sblk->compression);
@@ -39,19 +44,42 @@ int sqfs_decompressor_init(struct squashfs_ctxt *ctxt)
 		break;
 #endif
 #if IS_ENABLED(CONFIG_ZLIB)
-	case SQFS_COMP_ZLIB:
+	case SQFS_COMP_ZLIB: {
+		z_stream *stream;
+
+		stream = calloc(1, sizeof(*stream));
+		if (!stream)
+			return -ENOMEM;
+
+		if (inflateInit(stream) != Z_OK) {
+			free(stream);
+			return -ENOMEM;
+		}
+
+		ctxt->zlib_stream = stream;
 		break;
+	}
 #endif
 #if IS_ENABLED(CONFIG_LZ4)
 	case SQFS_COMP_LZ4:
 		break;
 #endif
 #if IS_ENABLED(CONFIG_ZSTD)
-	case SQFS_COMP_ZSTD:
-		ctxt->zstd_workspace = malloc(zstd_dctx_workspace_bound());
+	case SQFS_COMP_ZSTD: {
+		size_t wsize = zstd_dctx_workspace_bound();
+
+		ctxt->zstd_workspace = malloc(wsize);
 		if (!ctxt->zstd_workspace)
 			return -ENOMEM;
+
+		ctxt->zstd_dctx = zstd_init_dctx(ctxt->zstd_workspace, wsize);
+		if (!ctxt->zstd_dctx) {
+			free(ctxt->zstd_workspace);
+			ctxt->zstd_workspace = NULL;
+			return -EINVAL;
+		}
 		break;
+	}
 #endif
 	default:
 		printf("Error: unknown compression type.\n");
@@ -72,6 +100,10 @@ void sqfs_decompressor_cleanup(struct squashfs_ctxt *ctxt)
 #endif
 #if IS_ENABLED(CONFIG_ZLIB)
 	case SQFS_COMP_ZLIB:
+		if (ctxt->zlib_stream)
+			inflateEnd(ctxt->zlib_stream);
+		free(ctxt->zlib_stream);
+		ctxt->zlib_stream = NULL;
 		break;
 #endif
 #if IS_ENABLED(CONFIG_LZ4)
@@ -81,6 +113,8 @@ void sqfs_decompressor_cleanup(struct squashfs_ctxt *ctxt)
 #if IS_ENABLED(CONFIG_ZSTD)
 	case SQFS_COMP_ZSTD:
 		free(ctxt->zstd_workspace);
+		ctxt->zstd_workspace = NULL;
+		ctxt->zstd_dctx = NULL;
 		break;
 #endif
 	}
@@ -101,22 +135,46 @@ static void zlib_decompression_status(int ret)
 		break;
 	}
 }
+
+static int sqfs_zlib_decompress(struct squashfs_ctxt *ctxt, void *dest,
+				unsigned long *dest_len, void *source,
+				u32 src_len)
+{
+	z_stream *stream = ctxt->zlib_stream;
+	int ret;
+
+	ret = inflateReset(stream);
+	if (ret != Z_OK)
+		return ret;
+
+	stream->next_in = source;
+	stream->avail_in = src_len;
+	stream->next_out = dest;
+	stream->avail_out = *dest_len;
+
+	ret = inflate(stream, Z_FINISH);
+	if (ret == Z_STREAM_END) {
+		*dest_len = stream->total_out;
+		return Z_OK;
+	}
+
+	/* Z_FINISH leaves Z_OK/Z_BUF_ERROR if output or input ran out */
+	if (ret == Z_OK || ret == Z_BUF_ERROR)
+		return stream->avail_out ? Z_DATA_ERROR : Z_BUF_ERROR;
+
+	return ret == Z_NEED_DICT ? Z_DATA_ERROR : ret;
+}
 #endif
 
 #if IS_ENABLED(CONFIG_ZSTD)
 static int sqfs_zstd_decompress(struct squashfs_ctxt *ctxt, void *dest,
 				unsigned long dest_len, void *source, u32 src_len)
 {
-	ZSTD_DCtx *ctx;
-	size_t wsize;
 	int ret;
 
-	wsize = zstd_dctx_workspace_bound();
-
-	ctx = zstd_init_dctx(ctxt->zstd_workspace, wsize);
-	if (!ctx)
-		return -EINVAL;
-	ret = zstd_decompress_dctx(ctx, dest, dest_len, source, src_len);
+	/* Each block is a complete frame, which resets the context */
+	ret = zstd_decompress_dctx(ctxt->zstd_dctx, dest, dest_len, source,
+				   src_len);
 
 	return zstd_is_error(ret);
 }
@@ -143,7 +201,8 @@ int sqfs_decompress(struct squashfs_ctxt *ctxt, void *dest,
 #endif
 #if IS_ENABLED(CONFIG_ZLIB)
 	case SQFS_COMP_ZLIB:
-		ret = uncompress(dest, dest_len, source, src_len);
+		ret = sqfs_zlib_decompress(ctxt, dest, dest_len, source,
+					   src_len);
 		if (ret) {
 			zlib_decompression_status(ret);
 			return -EINVAL;
@@ -71,12 +71,45 @@ struct squashfs_super_block {
 	__le64 export_table_start;
 };
 
+/*
+ * Inode or directory table, read from the medium once per mount. Metadata
+ * blocks are only decompressed when a lookup first touches them, and stay in
+ * 'data' at SQFS_METADATA_BLOCK_SIZE-aligned offsets until sqfs_close().
+ */
+struct squashfs_metatable {
+	/* Compressed table as read from the medium, and its offset in 'raw' */
+	unsigned char *raw;
+	u64 raw_offset;
+	/* Decompressed metadata blocks, and whether each one is loaded yet */
+	unsigned char *data;
+	bool *loaded;
+	/* End position of each metadata block, relative to the table start */
+	u32 *pos_list;
+	int count;
+};
+
 struct squashfs_ctxt {
 	struct disk_partition cur_part_info;
 	struct blk_desc *cur_dev;
 	struct squashfs_super_block *sblk;
+	struct squashfs_metatable inode_table;
+	struct squashfs_metatable dir_table;
+	/* Fragment index table, and the last fragment entries metadata block */
+	unsigned char *frag_index;
+	u64 frag_index_offset;
+	struct squashfs_fragment_block_entry *frag_entries;
+	int frag_entries_block;
+	/* Last fragment block handed out by sqfs_read_nest(), decompressed */
+	unsigned char *frag_block;
+	u64 frag_block_start;
+	unsigned long frag_block_len;
+	/* Decompressor state, set up once per mount */
+#if IS_ENABLED(CONFIG_ZLIB)
+	void *zlib_stream;
+#endif
 #if IS_ENABLED(CONFIG_ZSTD)
 	void *zstd_workspace;
+	void *zstd_dctx;
 #endif
 };
 
@@ -271,10 +304,9 @@ struct squashfs_dir_stream {
 	struct squashfs_dir_inode i_dir;
 	struct squashfs_ldir_inode i_ldir;
 	/*
-	 * References to the tables' beginnings. They are assigned in
-	 * sqfs_opendir() and freed in sqfs_closedir().
+	 * Reference to the directory table's beginning. It is assigned in
+	 * sqfs_opendir() and belongs to the mount, see struct squashfs_ctxt.
 	 */
-	unsigned char *inode_table;
 	unsigned char *dir_table;
 };
 
@@ -293,8 +325,7 @@ struct squashfs_file_info {
 	bool comp;
 };
 
-void *sqfs_find_inode(void *inode_table, int inode_number, __le32 inode_count,
-		      __le32 block_size);
+int sqfs_inode_size(struct squashfs_base_inode *inode, u32 blk_size);
 
 int sqfs_dir_offset(void *dir_i, u32 *m_list, int m_count);
 
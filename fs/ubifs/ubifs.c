@@ -721,23 +721,13 @@ static inline void *kmap(struct page *page)
 	return page->addr;
 }
 
-static int read_block(struct inode *inode, void *addr, unsigned int block,
-		      struct ubifs_data_node *dn)
+static int decompress_data_node(struct ubifs_info *c, struct inode *inode,
+				void *addr, unsigned int block,
+				struct ubifs_data_node *dn)
 {
-	struct ubifs_info *c = inode->i_sb->s_fs_info;
 	int err, len, out_len;
-	union ubifs_key key;
 	unsigned int dlen;
 
-	data_key_init(c, &key, inode->i_ino, block);
-	err = ubifs_tnc_lookup(c, &key, dn);
-	if (err) {
-		if (err == -ENOENT)
-			/* Not found, so it must be a hole */
-			memset(addr, 0, UBIFS_BLOCK_SIZE);
-		return err;
-	}
-
 	ubifs_assert(le64_to_cpu(dn->ch.sqnum) > ubifs_inode(inode)->creat_sqnum);
 
 	len = le32_to_cpu(dn->size);
@@ -768,6 +758,93 @@ dump:
 	return -EINVAL;
 }
 
+static int read_block(struct inode *inode, void *addr, unsigned int block,
+		      struct ubifs_data_node *dn)
+{
+	struct ubifs_info *c = inode->i_sb->s_fs_info;
+	union ubifs_key key;
+	int err;
+
+	data_key_init(c, &key, inode->i_ino, block);
+	err = ubifs_tnc_lookup(c, &key, dn);
+	if (err) {
+		if (err == -ENOENT)
+			/* Not found, so it must be a hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+		return err;
+	}
+
+	return decompress_data_node(c, inode, addr, block, dn);
+}
+
+/**
+ * bulk_read_pages() - read consecutive pages of a file in one go
+ * @c: UBIFS file-system description object
+ * @inode: inode to read from
+ * @page: first page to read, its buffer gets filled in
+ * @nr_pages: maximum number of pages to read
+ *
+ * Data nodes of a file written in one go usually sit one after another in the
+ * same LEB. Look up as many of them as possible in the TNC, read them with a
+ * single LEB read and decompress them into consecutive pages at @page.
+ *
+ * Return: number of pages read, 0 if bulk-read could not be used (the caller
+ * should then fall back to do_readpage()), or a negative error code
+ */
+static int bulk_read_pages(struct ubifs_info *c, struct inode *inode,
+			   struct page *page, unsigned int nr_pages)
+{
+	struct bu_info *bu = &c->bu;
+	unsigned int block, blk_cnt, i;
+	void *addr = kmap(page);
+	int err, n = 0, offs;
+
+	if (!c->bulk_read || nr_pages < 2)
+		return 0;
+
+	mutex_lock(&c->bu_mutex);
+	bu->buf_len = c->max_bu_buf_len;
+	block = page->index << UBIFS_BLOCKS_PER_PAGE_SHIFT;
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err || !bu->cnt || !bu->blk_cnt)
+		goto out;
+
+	blk_cnt = min_t(unsigned int, bu->blk_cnt,
+			nr_pages << UBIFS_BLOCKS_PER_PAGE_SHIFT);
+	err = ubifs_tnc_bulk_read(c, bu);
+	if (err)
+		goto out;
+
+	offs = 0;
+	for (i = 0; i < blk_cnt; i++, addr += UBIFS_BLOCK_SIZE) {
+		struct ubifs_data_node *dn = bu->buf + offs;
+
+		if (n >= bu->cnt ||
+		    key_block(c, &bu->zbranch[n].key) != block + i) {
+			/* A hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+			continue;
+		}
+
+		err = decompress_data_node(c, inode, addr, block + i, dn);
+		if (err)
+			break;
+		offs += ALIGN(bu->zbranch[n].len, 8);
+		n++;
+	}
+	mutex_unlock(&c->bu_mutex);
+	if (err)
+		return err;
+
+	return blk_cnt >> UBIFS_BLOCKS_PER_PAGE_SHIFT;
+
+out:
+	mutex_unlock(&c->bu_mutex);
+	/* Fall back to reading node by node, which reports errors as well */
+	return 0;
+}
+
 static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		       struct page *page, int last_block_size)
 {
@@ -950,6 +1027,20 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 		if (((i + 1) == count) && (size < inode->i_size))
 			last_block_size = size - (i * PAGE_SIZE);
 
+		/* All pages but the last one are read whole */
+		if (i + 1 < count) {
+			err = bulk_read_pages(c, inode, &page, count - i - 1);
+			if (err < 0)
+				break;
+			if (err > 0) {
+				page.addr += err * PAGE_SIZE;
+				page.index += err;
+				i += err - 1;
+				err = 0;
+				continue;
+			}
+		}
+
 		err = do_readpage(c, inode, &page, last_block_size);
 		if (err)
 			break;
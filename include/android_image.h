@@ -24,6 +24,8 @@
 #define ANDR_VENDOR_BOOT_MAGIC_SIZE 8
 #define ANDR_VENDOR_BOOT_ARGS_SIZE 2048
 #define ANDR_VENDOR_BOOT_NAME_SIZE 16
+#define ANDR_VENDOR_RAMDISK_NAME_SIZE 32
+#define ANDR_VENDOR_RAMDISK_BOARD_ID_SIZE 16
 
 #define BOOTCONFIG_MAGIC "#BOOTCONFIG\n"
 #define BOOTCONFIG_MAGIC_SIZE 12
@@ -75,6 +77,24 @@ struct andr_vnd_boot_img_hdr {
 	u32 bootconfig_size; /* size in bytes for the bootconfig section */
 };
 
+enum andr_vendor_ramdisk_type {
+	VENDOR_RAMDISK_TYPE_NONE = 0,
+	VENDOR_RAMDISK_TYPE_PLATFORM = 1,
+	VENDOR_RAMDISK_TYPE_RECOVERY = 2,
+	VENDOR_RAMDISK_TYPE_DLKM = 3,
+};
+
+/* An entry in the vendor ramdisk table of a v4 vendor boot image */
+struct andr_vendor_ramdisk_table_entry_v4 {
+	u32 ramdisk_size;   /* size in bytes */
+	u32 ramdisk_offset; /* offset in the vendor ramdisk section */
+	u32 ramdisk_type;   /* enum andr_vendor_ramdisk_type */
+	u8 ramdisk_name[ANDR_VENDOR_RAMDISK_NAME_SIZE]; /* asciiz ramdisk name */
+
+	/* hardware identifiers describing the board, soc or platform */
+	u32 board_id[ANDR_VENDOR_RAMDISK_BOARD_ID_SIZE];
+};
+
 /* The bootloader expects the structure of andr_boot_img_hdr_v0 with header
  * version 0 to be as follows: */
 struct andr_boot_img_hdr_v0 {
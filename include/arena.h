@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Scoped scratch allocations which are released together
+ *
+ * Filesystem lookups and similar operations need a number of small temporary
+ * buffers (path tokens, copies of names, bounce buffers) which all die when
+ * the operation returns. Rather than calling malloc() and free() for each
+ * one, they can be taken from the arena:
+ *
+ *	struct arena_mark mark = arena_begin();
+ *
+ *	tokens = arena_alloc(count * sizeof(char *));
+ *	...
+ *	arena_release(mark);
+ *
+ * Allocation is a pointer bump within a chunk, and arena_release() discards
+ * everything allocated since arena_begin() in one step. Scopes nest, so a
+ * function using the arena may be called from within another scope, but they
+ * must be released in the reverse order to which they were begun.
+ *
+ * Memory from the arena must not be passed to free() or realloc(), nor
+ * returned to a caller which expects to free it.
+ */
+
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <linux/types.h>
+
+struct arena_chunk;
+
+/**
+ * struct arena_mark - position in the arena, as returned by arena_begin()
+ *
+ * @chunk: chunk which was in use, or NULL if the arena was empty
+ * @used: number of bytes used in @chunk
+ */
+struct arena_mark {
+	struct arena_chunk *chunk;
+	size_t used;
+};
+
+/**
+ * arena_begin() - Start a scope of arena allocations
+ *
+ * Return: mark to pass to arena_release() at the end of the scope
+ */
+struct arena_mark arena_begin(void);
+
+/**
+ * arena_alloc() - Allocate scratch memory from the arena
+ *
+ * The memory is aligned suitably for any object but is not cleared. It is
+ * valid until the enclosing scope is released.
+ *
+ * @size: Number of bytes required
+ * Return: pointer to the memory, or NULL if out of memory
+ */
+void *arena_alloc(size_t size);
+
+/**
+ * arena_zalloc() - Allocate zeroed scratch memory from the arena
+ *
+ * @size: Number of bytes required
+ * Return: pointer to the memory, or NULL if out of memory
+ */
+void *arena_zalloc(size_t size);
+
+/**
+ * arena_alloc_cache_aligned() - Allocate a DMA-safe buffer from the arena
+ *
+ * This is the arena counterpart of malloc_cache_aligned(): the buffer starts
+ * on an ARCH_DMA_MINALIGN boundary and does not share a cache line with any
+ * other allocation.
+ *
+ * @size: Number of bytes required
+ * Return: pointer to the memory, or NULL if out of memory
+ */
+void *arena_alloc_cache_aligned(size_t size);
+
+/**
+ * arena_strdup() - Copy a string into the arena
+ *
+ * @str: String to copy
+ * Return: pointer to the copy, or NULL if out of memory
+ */
+char *arena_strdup(const char *str);
+
+/**
+ * arena_release() - End a scope, freeing everything allocated within it
+ *
+ * Chunks which become empty are kept for reuse by later scopes, up to a small
+ * limit, so that a sequence of operations settles into not calling malloc()
+ * at all.
+ *
+ * @mark: Mark returned by the corresponding arena_begin()
+ */
+void arena_release(struct arena_mark mark);
+
+#endif
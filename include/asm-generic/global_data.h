@@ -29,7 +29,10 @@
 #include <asm-offsets.h>
 
 struct acpi_ctx;
+struct bloblist_index;
+struct dm_lazy_index;
 struct driver_rt;
+struct fdtdec_index;
 struct upl;
 
 typedef struct global_data gd_t;
@@ -269,6 +272,36 @@ struct global_data {
 	 */
 	struct device_node *of_root;
 #endif
+#if CONFIG_IS_ENABLED(OF_LIBFDT_INDEX)
+	/**
+	 * @fdt_index: path and phandle indexes of recently used FDT blobs
+	 */
+	struct fdtdec_index *fdt_index[2];
+#endif
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+	/**
+	 * @dm_lazy: device tree nodes recorded for binding on demand
+	 */
+	struct dm_lazy_index *dm_lazy;
+#endif
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+	/**
+	 * @dm_node_hash: buckets of bound devices hashed by their node
+	 */
+	struct udevice **dm_node_hash;
+	/**
+	 * @of_phandles: nodes of the control tree indexed by phandle
+	 */
+	ofnode *of_phandles;
+	/**
+	 * @of_phandles_count: number of entries in @of_phandles
+	 */
+	uint of_phandles_count;
+	/**
+	 * @of_phandles_tree: control tree @of_phandles was built from
+	 */
+	const void *of_phandles_tree;
+#endif
 #if CONFIG_IS_ENABLED(MULTI_DTB_FIT)
 	/**
 	 * @multi_dtb_fit: pointer to uncompressed multi-dtb FIT image
@@ -393,6 +426,26 @@ struct global_data {
 	 * while another message is being processed.
 	 */
 	bool processing_msg;
+	/**
+	 * @log_unfiltered: an enabled logging device has no filters
+	 *
+	 * Such a device emits all records up to @default_log_level.
+	 */
+	bool log_unfiltered;
+	/**
+	 * @log_filter_level: highest level which a filter may allow
+	 *
+	 * This covers the filters of all enabled logging devices, -1 if none
+	 * may allow anything.
+	 */
+	signed char log_filter_level;
+	/**
+	 * @log_filter_cats: categories which a filter may allow
+	 *
+	 * Bitmap with one bit for each log category, set if a filter of an
+	 * enabled logging device may allow records of that category.
+	 */
+	unsigned long *log_filter_cats;
 #endif
 #if CONFIG_IS_ENABLED(BLOBLIST)
 	/**
@@ -400,6 +453,12 @@ struct global_data {
 	 */
 	struct bloblist_hdr *bloblist;
 #endif
+#if CONFIG_IS_ENABLED(BLOBLIST_INDEX)
+	/**
+	 * @bloblist_index: offsets of the records in the bloblist, by tag
+	 */
+	struct bloblist_index *bloblist_index;
+#endif
 #if CONFIG_IS_ENABLED(HANDOFF)
 	/**
 	 * @spl_handoff: SPL hand-off information
@@ -521,7 +580,7 @@ static_assert(sizeof(struct global_data) == GD_SIZE);
 #define gd_set_multi_dtb_fit(_dtb)
 #endif
 
-#if CONFIG_IS_ENABLED(EVENT_DYNAMIC)
+#if CONFIG_IS_ENABLED(EVENT)
 #define gd_event_state()	((struct event_state *)&gd->event_state)
 #else
 #define gd_event_state()	NULL
@@ -13,6 +13,8 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <linux/errno.h>
+#include <linux/types.h>
 
 #ifdef CONFIG_SANDBOX
 
@@ -80,4 +82,67 @@ static inline void autoboot_command(const char *s)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(AUTOBOOT_PRELOAD)
+/**
+ * autoboot_preload_start() - start reading the files in 'bootpreload'
+ *
+ * The files are read a chunk at a time from a cyclic function, so this
+ * returns straight away. Any earlier preload is discarded.
+ *
+ * Return: number of files to read, 0 if none, -ve on error
+ */
+int autoboot_preload_start(void);
+
+/**
+ * autoboot_preload_stop() - stop reading files
+ *
+ * Files which were read in full stay available to autoboot_preload_find()
+ */
+void autoboot_preload_stop(void);
+
+/**
+ * autoboot_preload_discard() - stop reading files and forget them all
+ */
+void autoboot_preload_discard(void);
+
+/**
+ * autoboot_preload_find() - check whether a file was read by the preload
+ *
+ * The file must have been read in full to @addr and the memory there must
+ * still have the same CRC32.
+ *
+ * @ifname: Interface, e.g. "mmc"
+ * @dev_part: Device and partition, e.g. "0:1", or NULL if none
+ * @fname: Filename
+ * @addr: Address the file is to be loaded to
+ * @len: Number of bytes wanted, or 0 for the whole file
+ * @sizep: Returns the size of the file
+ * Return: 0 if the file is already at @addr, -ENOENT if not
+ */
+int autoboot_preload_find(const char *ifname, const char *dev_part,
+			  const char *fname, ulong addr, loff_t len,
+			  loff_t *sizep);
+#else
+static inline int autoboot_preload_start(void)
+{
+	return 0;
+}
+
+static inline void autoboot_preload_stop(void)
+{
+}
+
+static inline void autoboot_preload_discard(void)
+{
+}
+
+static inline int autoboot_preload_find(const char *ifname,
+					const char *dev_part,
+					const char *fname, ulong addr,
+					loff_t len, loff_t *sizep)
+{
+	return -ENOENT;
+}
+#endif
+
 #endif
@@ -10,6 +10,7 @@
 #include <bouncebuf.h>
 #include <dm/uclass-id.h>
 #include <efi.h>
+#include <linux/list.h>
 
 #ifdef CONFIG_SYS_64BIT_LBA
 typedef uint64_t lbaint_t;
@@ -128,6 +129,9 @@ int blkcache_read(int iftype, int dev,
  * blkcache_fill() - make data read from a block device available
  * to the block cache
  *
+ * Blocks which were written to the cache but not to the device yet are
+ * copied into @buffer instead, since the data read from the device is stale.
+ *
  * @param iftype - uclass_id_x for type of device
  * @param dev - device index of particular type
  * @param start - starting block number
@@ -138,11 +142,57 @@ int blkcache_read(int iftype, int dev,
  */
 void blkcache_fill(int iftype, int dev,
 		   lbaint_t start, lbaint_t blkcnt,
-		   unsigned long blksz, void const *buffer);
+		   unsigned long blksz, void *buffer);
+
+/**
+ * blkcache_write() - attempt to absorb a write in the block cache
+ *
+ * With CONFIG_BLOCK_CACHE_WRITEBACK, small writes are kept in the cache and
+ * only written to the device by blkcache_flush() or when evicted.
+ *
+ * @param iftype - uclass_id_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number
+ * @param blkcnt - number of blocks to write
+ * @param blksz - size in bytes of each block
+ * @param buffer - data to write
+ *
+ * Return: - 1 if the cache took the write, 0 if it must go to the device
+ */
+int blkcache_write(int iftype, int dev,
+		   lbaint_t start, lbaint_t blkcnt,
+		   unsigned long blksz, const void *buffer);
+
+/**
+ * blkcache_update() - bring the cache in line with a device write or erase
+ *
+ * Cached copies of the blocks are replaced by @buffer, or dropped if @buffer
+ * is NULL.
+ *
+ * @param iftype - uclass_id_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number
+ * @param blkcnt - number of blocks written
+ * @param blksz - size in bytes of each block
+ * @param buffer - data written, or NULL for an erase
+ */
+void blkcache_update(int iftype, int dev,
+		     lbaint_t start, lbaint_t blkcnt,
+		     unsigned long blksz, const void *buffer);
+
+/**
+ * blkcache_flush() - write cached blocks back to their device
+ *
+ * @iftype - UCLASS_ID_ for type of device, or -1 for any
+ * @dev - device index of particular type, if @iftype is not -1
+ * Return: 0 if OK, -ve on error
+ */
+int blkcache_flush(int iftype, int dev);
 
 /**
  * blkcache_invalidate() - discard the cache for a set of blocks
- * because of a write or device (re)initialization.
+ * because of a device (re)initialization. Blocks not written back yet are
+ * lost, use blkcache_flush() first to keep them.
  *
  * @iftype - UCLASS_ID_ for type of device, or -1 for any
  * @dev - device index of particular type, if @iftype is not -1
@@ -152,8 +202,8 @@ void blkcache_invalidate(int iftype, int dev);
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
- * @param entries - maximum entries in cache
+ * @param blocks - blocks per cache line, at most 32
+ * @param entries - number of cache lines
  */
 void blkcache_configure(unsigned blocks, unsigned entries);
 
@@ -166,6 +216,20 @@ struct block_cache_stats {
 	unsigned entries; /* current entry count */
 	unsigned max_blocks_per_entry;
 	unsigned max_entries;
+	unsigned ways;	/* lines per set */
+	unsigned dirty;	/* lines not written back yet */
+	unsigned writebacks;
+};
+
+/*
+ * per-device statistics of the block cache
+ */
+struct block_cache_dev_stats {
+	int iftype;
+	int devnum;
+	unsigned hits;
+	unsigned misses;
+	unsigned writes; /* writes kept in the cache */
 };
 
 /**
@@ -175,6 +239,15 @@ struct block_cache_stats {
  */
 void blkcache_stats(struct block_cache_stats *stats);
 
+/**
+ * blkcache_dev_stats() - return statistics of one device and reset
+ *
+ * @param seq - index of the device, starting from 0
+ * @param stats - statistics are copied here
+ * Return: 0 if OK, -ENOENT if there are fewer devices
+ */
+int blkcache_dev_stats(int seq, struct block_cache_dev_stats *stats);
+
 /** blkcache_free() - free all memory allocated to the block cache */
 void blkcache_free(void);
 
@@ -189,7 +262,23 @@ static inline int blkcache_read(int iftype, int dev,
 
 static inline void blkcache_fill(int iftype, int dev,
 				 lbaint_t start, lbaint_t blkcnt,
-				 unsigned long blksz, void const *buffer) {}
+				 unsigned long blksz, void *buffer) {}
+
+static inline int blkcache_write(int iftype, int dev,
+				 lbaint_t start, lbaint_t blkcnt,
+				 unsigned long blksz, const void *buffer)
+{
+	return 0;
+}
+
+static inline void blkcache_update(int iftype, int dev,
+				   lbaint_t start, lbaint_t blkcnt,
+				   unsigned long blksz, const void *buffer) {}
+
+static inline int blkcache_flush(int iftype, int dev)
+{
+	return 0;
+}
 
 static inline void blkcache_invalidate(int iftype, int dev) {}
 
@@ -199,6 +288,82 @@ static inline void blkcache_free(void) {}
 
 struct udevice;
 
+/**
+ * enum blk_req_op - operation of an asynchronous block request
+ *
+ * @BLK_REQ_READ: Read blocks into @buf
+ * @BLK_REQ_WRITE: Write blocks from @buf
+ */
+enum blk_req_op {
+	BLK_REQ_READ,
+	BLK_REQ_WRITE,
+};
+
+/**
+ * struct blk_req - an asynchronous block request
+ *
+ * The caller fills in @op, @start, @blkcnt and @buf, then passes the request
+ * to blk_submit(). It must stay valid, and @buf untouched, until blk_wait()
+ * returns for it.
+ *
+ * @op: Operation to perform
+ * @start: Start block number (0=first)
+ * @blkcnt: Number of blocks to transfer
+ * @buf: Data buffer
+ * @result: Number of blocks transferred, or -ve error number, once @done
+ * @done: true once the request has completed
+ * @sibling: Node in the device's request queue, for the uclass
+ * @priv: For use by the driver while the request is in flight
+ */
+struct blk_req {
+	enum blk_req_op op;
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *buf;
+	long result;
+	bool done;
+	struct list_head sibling;
+	void *priv;
+};
+
+/* Number of buckets in each histogram of struct blk_stats */
+#define BLK_STATS_BUCKETS	16
+
+/**
+ * struct blk_stats - transfer statistics of a block device
+ *
+ * These count the transfers which reach the driver, so reads served by the
+ * block cache or the read-ahead window are not included.
+ *
+ * Bucket n of @size_hist counts transfers of 2^n to 2^(n+1) - 1 blocks and
+ * bucket n of @lat_hist those taking 2^(n+3) to 2^(n+4) - 1 microseconds,
+ * with bucket 0 also holding anything shorter. The last bucket of each holds
+ * everything above it.
+ *
+ * @reads: Number of read transfers
+ * @writes: Number of write transfers
+ * @errors: Number of transfers which failed or were short
+ * @read_bytes: Number of bytes read
+ * @write_bytes: Number of bytes written
+ * @read_us: Time spent reading, in microseconds
+ * @write_us: Time spent writing, in microseconds
+ * @max_us: Longest transfer, in microseconds
+ * @size_hist: Histogram of transfer sizes
+ * @lat_hist: Histogram of transfer latencies
+ */
+struct blk_stats {
+	ulong reads;
+	ulong writes;
+	ulong errors;
+	u64 read_bytes;
+	u64 write_bytes;
+	ulong read_us;
+	ulong write_us;
+	ulong max_us;
+	uint size_hist[BLK_STATS_BUCKETS];
+	uint lat_hist[BLK_STATS_BUCKETS];
+};
+
 /* Operations on block devices */
 struct blk_ops {
 	/**
@@ -258,6 +423,21 @@ struct blk_ops {
 	 */
 	int (*select_hwpart)(struct udevice *dev, int hwpart);
 
+	/**
+	 * map() - get a pointer to blocks which are held in memory
+	 *
+	 * Devices backed by memory can hand out their data in place, which
+	 * saves copying it to a buffer first. This is optional.
+	 *
+	 * @dev:	Block device to map
+	 * @start:	First block to map
+	 * @blkcnt:	Number of blocks to map
+	 * @return pointer to the data of @start, or NULL if the blocks are not
+	 * all held in one piece of memory
+	 */
+	const void *(*map)(struct udevice *dev, lbaint_t start,
+			   lbaint_t blkcnt);
+
 #if IS_ENABLED(CONFIG_BOUNCE_BUFFER)
 	/**
 	 * buffer_aligned() - test memory alignment of block operation buffer
@@ -275,6 +455,31 @@ struct blk_ops {
 	 */
 	int (*buffer_aligned)(struct udevice *dev, struct bounce_buffer *state);
 #endif	/* CONFIG_BOUNCE_BUFFER */
+
+#if CONFIG_IS_ENABLED(BLK_ASYNC)
+	/**
+	 * submit() - start an asynchronous request
+	 *
+	 * The uclass hands the driver one request at a time and queues the
+	 * others, so the driver only needs to track a single transfer. This
+	 * must not wait for the transfer to finish. Drivers without this
+	 * method have their requests completed synchronously by blk_submit().
+	 *
+	 * @dev:	Block device to start the request on
+	 * @req:	Request to start
+	 * @return 0 if started, -ve on error
+	 */
+	int (*submit)(struct udevice *dev, struct blk_req *req);
+
+	/**
+	 * wait() - wait for the request started by submit() to finish
+	 *
+	 * @dev:	Block device the request is running on
+	 * @req:	Request to wait for
+	 * @return number of blocks transferred, or -ve error number
+	 */
+	long (*wait)(struct udevice *dev, struct blk_req *req);
+#endif
 };
 
 #if CONFIG_IS_ENABLED(BLK)
@@ -292,6 +497,19 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt);
 
+/**
+ * blk_dmap() - Get a pointer to blocks which are held in memory
+ *
+ * See blk_map()
+ *
+ * @block_dev: Block device descriptor
+ * @start: First block to map
+ * @blkcnt: Number of blocks to map
+ * Return: pointer to the data, or NULL if it must be read instead
+ */
+const void *blk_dmap(struct blk_desc *block_dev, lbaint_t start,
+		     lbaint_t blkcnt);
+
 #endif /* BLK */
 
 /**
@@ -320,6 +538,119 @@ long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 long blk_write(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 	       const void *buffer);
 
+/**
+ * blk_map() - Get a pointer to blocks which are held in memory
+ *
+ * For a device backed by memory, such as a blkmap memory slice, this gives
+ * the data of the blocks in place, so that a caller which only looks at
+ * them need not copy them to a buffer. The pointer stays valid until the
+ * mapping of the device changes. Writes to the device show through it.
+ *
+ * @dev: Device to map
+ * @start: First block to map
+ * @blkcnt: Number of blocks to map
+ * Return: pointer to the data of @start, or NULL if the blocks must be read
+ * with blk_read()
+ */
+const void *blk_map(struct udevice *dev, lbaint_t start, lbaint_t blkcnt);
+
+/**
+ * blk_write_uncached() - Write to a block device, bypassing the block cache
+ *
+ * This is used by the block cache to write back its dirty blocks. Cached
+ * copies of the blocks are not updated.
+ *
+ * @dev: Device to write to
+ * @start: Start block for the write
+ * @blkcnt: Number of blocks to write
+ * @buf: Data to write
+ * @return number of blocks written (which may be less than @blkcnt),
+ * or -ve on error. This never returns 0 unless @blkcnt is 0
+ */
+long blk_write_uncached(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
+			const void *buffer);
+
+/**
+ * blk_flush() - Write blocks held in the block cache back to the device
+ *
+ * This is a nop unless CONFIG_BLOCK_CACHE_WRITEBACK is enabled.
+ *
+ * @dev: Device to flush
+ * @return 0 if OK, -ve on error
+ */
+int blk_flush(struct udevice *dev);
+
+/**
+ * blk_submit() - Queue an asynchronous read or write
+ *
+ * The request is started at once if the device is idle and queued behind
+ * any earlier requests otherwise. A read which the block cache can serve
+ * completes immediately, as does any request on a device whose driver does
+ * not support asynchronous requests, or if CONFIG_BLK_ASYNC is disabled.
+ *
+ * Synchronous calls such as blk_read() wait for all queued requests first,
+ * so requests and synchronous calls complete in the order they were made.
+ *
+ * @dev: Device to access
+ * @req: Request to queue, see struct blk_req
+ * @return 0 if OK, -ve on error (the request was not queued)
+ */
+int blk_submit(struct udevice *dev, struct blk_req *req);
+
+/**
+ * blk_wait() - Wait for an asynchronous request to complete
+ *
+ * Requests queued ahead of @req are completed first.
+ *
+ * @dev: Device @req was submitted to
+ * @req: Request to wait for
+ * @return number of blocks transferred (which may be less than @blkcnt),
+ * or -ve on error
+ */
+long blk_wait(struct udevice *dev, struct blk_req *req);
+
+#if CONFIG_IS_ENABLED(BLK_STATS)
+/**
+ * blk_get_stats() - Get the transfer statistics of a block device
+ *
+ * @dev: Block device
+ * Return: statistics, or NULL if CONFIG_BLK_STATS is disabled
+ */
+const struct blk_stats *blk_get_stats(struct udevice *dev);
+
+/**
+ * blk_stats_reset() - Clear the transfer statistics of a block device
+ *
+ * @dev: Block device
+ */
+void blk_stats_reset(struct udevice *dev);
+
+/**
+ * blk_stats_show() - Print the transfer statistics of a block device
+ *
+ * @dev: Block device
+ */
+void blk_stats_show(struct udevice *dev);
+
+/**
+ * blk_stats_bootstage() - Add the time spent on each block device to bootstage
+ *
+ * Each device with transfers gets an accumulated-time record for its reads
+ * and one for its writes, so that they appear in the bootstage report and
+ * are passed on by bootstage_stash().
+ */
+void blk_stats_bootstage(void);
+#else
+static inline const struct blk_stats *blk_get_stats(struct udevice *dev)
+{
+	return NULL;
+}
+
+static inline void blk_stats_reset(struct udevice *dev) {}
+static inline void blk_stats_show(struct udevice *dev) {}
+static inline void blk_stats_bootstage(void) {}
+#endif
+
 /**
  * blk_erase() - Erase part of a block device
  *
@@ -559,6 +890,12 @@ static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
+static inline const void *blk_dmap(struct blk_desc *block_dev, lbaint_t start,
+				   lbaint_t blkcnt)
+{
+	return NULL;
+}
+
 /**
  * struct blk_driver - Driver for block interface types
  *
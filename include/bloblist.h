@@ -153,6 +153,9 @@ enum bloblist_tag_t {
 	BLOBLISTT_U_BOOT_SPL_HANDOFF	= 0xfff000, /* Hand-off info from SPL */
 	BLOBLISTT_VBE			= 0xfff001, /* VBE per-phase state */
 	BLOBLISTT_U_BOOT_VIDEO		= 0xfff002, /* Video info from SPL */
+	BLOBLISTT_U_BOOT_LOG		= 0xfff003, /* Log ring buffer */
+	BLOBLISTT_U_BOOT_MMC_MODE	= 0xfff004, /* MMC bus modes from SPL */
+	BLOBLISTT_U_BOOT_MMC_HANDOFF	= 0xfff005, /* MMC card left by SPL */
 };
 
 /**
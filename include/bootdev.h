@@ -77,6 +77,9 @@ typedef int (*bootdev_hunter_func)(struct bootdev_hunter *info, bool show);
  * @uclass: Uclass ID for the media associated with this bootdev
  * @drv: bootdev driver for the things found by this hunter
  * @hunt: Function to call to hunt for bootdevs of this type (NULL if none)
+ * @start: Function to call to start bringing up the hardware for this type,
+ *	without waiting for it to settle (NULL if none). The @hunt function is
+ *	still called, later, to finish the job. See CONFIG_BOOTDEV_HUNT_ASYNC
  *
  * Some bootdevs are not visible until other devices are enumerated. For
  * example, USB bootdevs only appear when the USB bus is enumerated.
@@ -85,6 +88,10 @@ typedef int (*bootdev_hunter_func)(struct bootdev_hunter *info, bool show);
  * find the first valid bootdev. Ideally we want to work through them in
  * priority order, so that the fastest bootdevs are discovered first.
  *
+ * Slow hunters spend most of their time waiting, e.g. for power to be stable
+ * on USB ports. These can provide @start, so that the waiting happens while
+ * faster bootdevs are being scanned.
+ *
  * This struct holds information about the bootdev so we can determine the probe
  * order and how to hunt for bootdevs of this type
  */
@@ -93,6 +100,7 @@ struct bootdev_hunter {
 	enum uclass_id uclass;
 	struct driver *drv;
 	bootdev_hunter_func hunt;
+	bootdev_hunter_func start;
 };
 
 /* declare a new bootdev hunter */
@@ -294,6 +302,17 @@ int bootdev_hunt(const char *spec, bool show);
  */
 int bootdev_hunt_prio(enum bootdev_prio_t prio, bool show);
 
+/**
+ * bootdev_hunt_start() - Start the hunters which can run in the background
+ *
+ * This calls the @start function of each hunter which has one and has not
+ * been used yet, so that its hardware can come up while other bootdevs are
+ * scanned. Failures are not fatal, since the hunter runs again when needed.
+ *
+ * @show: true to show each hunter as it is started
+ */
+void bootdev_hunt_start(bool show);
+
 /**
  * bootdev_unhunt() - Mark a device as needing to be hunted again
  *
@@ -170,6 +170,9 @@ struct bootflow_img {
  * with things like "mmc1")
  * @BOOTFLOWIF_SINGLE_PARTITION: (internal) Scan one partition in media device
  * (used with things like "mmc1:3")
+ * @BOOTFLOWIF_CACHED: (internal) The bootflow returned by
+ * bootflow_scan_first() is the one recorded on the last boot, and the scan
+ * proper has not started yet (see CONFIG_BOOTFLOW_CACHE)
  */
 enum bootflow_iter_flags_t {
 	BOOTFLOWIF_FIXED		= 1 << 0,
@@ -186,6 +189,7 @@ enum bootflow_iter_flags_t {
 	BOOTFLOWIF_SINGLE_UCLASS	= 1 << 18,
 	BOOTFLOWIF_SINGLE_MEDIA		= 1 << 19,
 	BOOTFLOWIF_SINGLE_PARTITION	= 1 << 20,
+	BOOTFLOWIF_CACHED		= 1 << 21,
 };
 
 /**
@@ -255,6 +259,10 @@ enum bootflow_meth_flags_t {
  *	happens before the normal ones)
  * @method_flags: flags controlling which methods should be used for this @dev
  * (enum bootflow_meth_flags_t)
+ * @cache_dev: Bootdev of the bootflow recorded on the last boot, if it was
+ *	found, else NULL. The scan skips this bootflow since it was tried first
+ * @cache_part: Partition of the recorded bootflow
+ * @cache_method: Bootmeth of the recorded bootflow
  */
 struct bootflow_iter {
 	int flags;
@@ -276,6 +284,9 @@ struct bootflow_iter {
 	struct udevice **method_order;
 	bool doing_global;
 	int method_flags;
+	struct udevice *cache_dev;
+	int cache_part;
+	struct udevice *cache_method;
 };
 
 /**
@@ -424,6 +435,45 @@ int bootflow_run_boot(struct bootflow_iter *iter, struct bootflow *bflow);
  */
 const char *bootflow_state_get_name(enum bootflow_state_t state);
 
+/**
+ * bootflow_cache_save() - Record a bootflow to be tried first on the next boot
+ *
+ * This writes the bootflow's bootdev, partition, bootmeth, filename and size
+ * to the 'bootflow_last' environment variable. The environment is not saved.
+ * Bootflows from global bootmeths are not recorded.
+ *
+ * @bflow: Bootflow which is about to be booted
+ * Return: 0 if OK, -EINVAL if the bootflow cannot be recorded, other -ve on
+ *	error setting the variable
+ */
+int bootflow_cache_save(const struct bootflow *bflow);
+
+/**
+ * bootflow_cache_drop() - Drop the record of a bootflow which failed to boot
+ *
+ * This does nothing unless @bflow is the bootflow which is recorded
+ *
+ * @bflow: Bootflow which failed to boot
+ * Return: 0 if OK, -ve on error setting the variable
+ */
+int bootflow_cache_drop(const struct bootflow *bflow);
+
+/**
+ * bootflow_cache_find() - Obtain the bootflow recorded on the last boot
+ *
+ * This hunts for the bootdev if needed (and @iter allows it), then reads the
+ * bootflow using the recorded partition and bootmeth, which must be in
+ * @iter's bootmeth ordering. The filename and size must match the record.
+ *
+ * On success, the bootflow is recorded in @iter so that the scan can skip it
+ *
+ * @iter: Iterator with the bootmeth ordering set up
+ * @bflow: Returns the bootflow on success
+ * Return: 0 if found, -ENOENT if there is no (usable) record, -ESTALE if the
+ *	bootflow has changed, other -ve on error reading the bootflow
+ */
+int bootflow_cache_find(struct bootflow_iter *iter, struct bootflow *bflow);
+
 /**
  * bootflow_remove() - Remove a bootflow and free its memory
  *
@@ -210,9 +210,14 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_DM_SPL,
 	BOOTSTAGE_ID_ACCUM_DM_F,
 	BOOTSTAGE_ID_ACCUM_DM_R,
+	BOOTSTAGE_ID_ACCUM_DM_LAZY,
 	BOOTSTAGE_ID_ACCUM_FSP_M,
 	BOOTSTAGE_ID_ACCUM_FSP_S,
 	BOOTSTAGE_ID_ACCUM_MMAP_SPI,
+	BOOTSTAGE_ID_ACCUM_DRAM_DETECT,
+	BOOTSTAGE_ID_ACCUM_DRAM_CLK,
+	BOOTSTAGE_ID_ACCUM_UBI,
+	BOOTSTAGE_ID_ACCUM_DCACHE,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -335,6 +340,19 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name);
  */
 uint32_t bootstage_accum(enum bootstage_id id);
 
+/**
+ * bootstage_add_accum() - add an accumulator measured elsewhere
+ *
+ * Add a record which is reported under 'Accumulated time' like those of
+ * bootstage_start() and bootstage_accum(), for activities whose time is
+ * collected by another subsystem.
+ *
+ * @name:	Textual name to display in the report
+ * @time_us:	Accumulated time in microseconds
+ * Return: @time_us
+ */
+uint32_t bootstage_add_accum(const char *name, uint32_t time_us);
+
 /* Print a report about boot time */
 void bootstage_report(void);
 
@@ -435,6 +453,12 @@ static inline uint32_t bootstage_accum(enum bootstage_id id)
 	return 0;
 }
 
+static inline uint32_t bootstage_add_accum(const char *name,
+					   uint32_t time_us)
+{
+	return 0;
+}
+
 static inline int bootstage_stash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
@@ -457,6 +481,32 @@ static inline int bootstage_init(bool first)
 
 #endif /* ENABLE_BOOTSTAGE */
 
+#if defined(ENABLE_BOOTSTAGE) && CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+/**
+ * bootstage_span_begin() - start accounting a span of work
+ *
+ * Spans may nest. Each must be ended with bootstage_span_end(), even on
+ * error paths. The time of the span is added to all spans of the same
+ * name, with the time of nested spans left out of its 'self' time.
+ *
+ * @name: Name of the span, which is copied, possibly truncated
+ */
+void bootstage_span_begin(const char *name);
+
+/**
+ * bootstage_span_end() - end the span last started
+ */
+void bootstage_span_end(void);
+#else
+static inline void bootstage_span_begin(const char *name)
+{
+}
+
+static inline void bootstage_span_end(void)
+{
+}
+#endif
+
 /* helpers for SPL */
 int _bootstage_stash_default(void);
 int _bootstage_unstash_default(void);
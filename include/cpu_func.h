@@ -52,6 +52,114 @@ int checkcpu(void);
 void smp_set_core_boot_addr(unsigned long addr, int corenr);
 void smp_kick_all_cpus(void);
 
+/**
+ * typedef cpu_work_fn - job run by cpu_work_run()
+ *
+ * @priv:	private data passed to cpu_work_run()
+ * @cpu:	index of the CPU running the job, 0 for the boot CPU; this can be
+ *		used to select per-CPU resources allocated by the caller
+ * @job:	number of the job to run
+ * Return: 0 if OK, -ve on error
+ */
+typedef int (*cpu_work_fn)(void *priv, uint cpu, uint job);
+
+#if CONFIG_IS_ENABLED(ARMV8_CPU_WORK)
+/**
+ * cpu_work_cpus() - Get the number of CPUs which can run jobs in parallel
+ *
+ * Return: number of CPUs cpu_work_run() can use, including the boot CPU
+ */
+int cpu_work_cpus(void);
+
+/**
+ * cpu_work_run() - Run independent jobs in parallel on several CPUs
+ *
+ * Run each of the @njobs jobs once, on the boot CPU or one of up to @ncpus - 1
+ * secondary CPUs, and wait for all of them to complete. The secondary CPUs
+ * are started if needed and stay on until cpu_work_stop() is called.
+ *
+ * Jobs run concurrently, so @fn must not use the console, malloc() or drivers;
+ * anything it needs must be set up by the caller beforehand.
+ *
+ * If a secondary CPU does not complete a job in time, this gives up on it and
+ * returns -ETIMEDOUT. The CPU may still be running the job, so the caller
+ * must not free or reuse anything the job writes to.
+ *
+ * @fn:		function to run for each job
+ * @priv:	private data to pass to @fn
+ * @njobs:	number of jobs
+ * @ncpus:	maximum number of CPUs to use, including the boot CPU
+ * Return: 0 if OK, -ETIMEDOUT if a secondary CPU did not complete a job in
+ * time, -ENOMEM if out of memory, else the error returned by a failing job
+ */
+int cpu_work_run(cpu_work_fn fn, void *priv, uint njobs, uint ncpus);
+
+/**
+ * cpu_work_queue() - Queue a job on a secondary CPU
+ *
+ * Queue @fn on the secondary CPU with the fewest pending jobs, starting the
+ * secondary CPUs on first use. If there are no secondary CPUs, or all of their
+ * queues are full, @fn is called directly instead. The same restrictions as
+ * for cpu_work_run() apply to @fn.
+ *
+ * @fn:		function to run
+ * @arg:	argument to pass to @fn
+ */
+void cpu_work_queue(void (*fn)(void *arg), void *arg);
+
+/**
+ * cpu_work_barrier() - Wait for all queued jobs to complete
+ *
+ * A secondary CPU which does not complete a job in time is not used again.
+ *
+ * Return: 0 if OK, -ETIMEDOUT if a secondary CPU did not complete its jobs
+ */
+int cpu_work_barrier(void);
+
+/**
+ * cpu_work_stop() - Power off the secondary CPUs
+ *
+ * Wait for all queued jobs to complete, then switch the secondary CPUs off.
+ * This must be called before handing over to an OS, which expects to find the
+ * secondary CPUs off. They are started again if more work is queued, except
+ * for any CPU which did not power off, which is not used again.
+ */
+void cpu_work_stop(void);
+#else
+static inline int cpu_work_cpus(void)
+{
+	return 1;
+}
+
+static inline int cpu_work_run(cpu_work_fn fn, void *priv, uint njobs,
+			       uint ncpus)
+{
+	int ret = 0;
+	uint job;
+
+	for (job = 0; job < njobs; job++) {
+		int err = fn(priv, 0, job);
+
+		if (err && !ret)
+			ret = err;
+	}
+
+	return ret;
+}
+
+static inline void cpu_work_queue(void (*fn)(void *arg), void *arg)
+{
+	fn(arg);
+}
+
+static inline int cpu_work_barrier(void)
+{
+	return 0;
+}
+
+static inline void cpu_work_stop(void) {}
+#endif
+
 int icache_status(void);
 void icache_enable(void);
 void icache_disable(void);
@@ -23,9 +23,13 @@
  * @delay_us: Delay is us after which this function shall get executed
  * @start_time_us: Start time in us, when this function started its execution
  * @cpu_time_us: Total CPU time of this function
+ * @max_cpu_us: Longest CPU time of a single execution
+ * @max_late_us: Longest time in us that an execution started after it was due
+ * @overrun_cnt: Number of executions which took longer than
+ *	CONFIG_CYCLIC_MAX_CPU_TIME_US
  * @run_cnt: Counter of executions occurances
  * @next_call: Next time in us, when the function shall be executed again
- * @list: List node
+ * @list: List node, in the list of cyclic functions ordered by @next_call
  * @already_warned: Flag that we've warned about exceeding CPU time usage
  *
  * When !CONFIG_CYCLIC, this struct is empty.
@@ -37,6 +41,9 @@ struct cyclic_info {
 	uint64_t delay_us;
 	uint64_t start_time_us;
 	uint64_t cpu_time_us;
+	uint64_t max_cpu_us;
+	uint64_t max_late_us;
+	uint64_t overrun_cnt;
 	uint64_t run_cnt;
 	uint64_t next_call;
 	struct hlist_node list;
@@ -81,7 +88,8 @@ int cyclic_unregister_all(void);
 /**
  * cyclic_get_list() - Get cyclic list pointer
  *
- * Return the cyclic list pointer
+ * Return the cyclic list pointer. The list is kept in order of the time each
+ * function is next due, so the first entry is the next one to run.
  *
  * @return: pointer to cyclic_list
  */
@@ -159,7 +159,7 @@ struct dfu_entity {
 	struct list_head list;
 
 	/* on the fly state */
-	u32 crc;
+	void *hash_ctx;
 	u64 offset;
 	int i_blk_seq_num;
 	u8 *i_buf;
@@ -429,6 +429,74 @@ static inline void devres_release_all(struct udevice *dev)
 
 #endif /* DEVRES */
 
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+/* Number of buckets of gd->dm_node_hash, allocated by dm_init() */
+#define DM_NODE_HASH_BITS	8
+
+/**
+ * device_node_hash_add() - add a bound device to the node hash
+ *
+ * Devices without a valid node are not added.
+ *
+ * @dev: Device to add
+ */
+void device_node_hash_add(struct udevice *dev);
+
+/**
+ * device_node_hash_del() - remove a device from the node hash
+ *
+ * @dev: Device to remove
+ */
+void device_node_hash_del(struct udevice *dev);
+
+/**
+ * device_node_hash_find() - find a device of a uclass by its node
+ *
+ * @id: uclass ID to look in
+ * @node: Device tree node to search for
+ * Return: first device bound to @node in uclass @id, or NULL if none
+ */
+struct udevice *device_node_hash_find(enum uclass_id id, ofnode node);
+#else
+static inline void device_node_hash_add(struct udevice *dev) {}
+static inline void device_node_hash_del(struct udevice *dev) {}
+#endif
+
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+/**
+ * dm_lazy_bind_uclass() - bind the recorded nodes belonging to a uclass
+ *
+ * Nodes recorded since the last call for @uc are matched against the
+ * drivers. Those whose driver is in the uclass of @uc are bound, as are
+ * those which have subnodes with a compatible string, since their
+ * children may be in that uclass.
+ *
+ * @uc: uclass being looked up
+ */
+void dm_lazy_bind_uclass(struct uclass *uc);
+
+/**
+ * dm_lazy_bind_node() - bind a recorded node
+ *
+ * @node: Node to bind, if it was recorded and not bound yet
+ */
+void dm_lazy_bind_node(ofnode node);
+
+/**
+ * dm_lazy_unbind() - forget the nodes recorded for a device
+ *
+ * This is called when @parent is unbound, so that its recorded subnodes are
+ * not bound to it later.
+ *
+ * @parent: Device being unbound
+ */
+void dm_lazy_unbind(struct udevice *parent);
+#else
+static inline void dm_lazy_bind_uclass(struct uclass *uc) {}
+static inline void dm_lazy_bind_node(ofnode node) {}
+static inline void dm_lazy_unbind(struct udevice *parent) {}
+#endif
+
 static inline int device_notify(const struct udevice *dev, enum event_t type)
 {
 #if CONFIG_IS_ENABLED(DM_EVENT)
@@ -84,6 +84,12 @@ struct driver_info;
 /* Device must be probed after it was bound */
 #define DM_FLAG_PROBE_AFTER_BIND	(1 << 15)
 
+/* Device plat data is in the same block as the device (DM_COMPACT_ALLOC) */
+#define DM_FLAG_COMPACT_PDATA		(1 << 16)
+
+/* Device private data is in a single block (DM_COMPACT_ALLOC) */
+#define DM_FLAG_COMPACT_PRIV		(1 << 17)
+
 /*
  * One or multiple of these flags are passed to device_remove() so that
  * a selective device removal as specified by the remove-stage and the
@@ -166,6 +172,8 @@ enum {
  * @dma_offset: Offset between the physical address space (CPU's) and the
  *		device's bus address space
  * @iommu: IOMMU device associated with this device
+ * @node_hash_next: Next device in the same bucket of gd->dm_node_hash (do not
+ *	access outside driver model)
  */
 struct udevice {
 	const struct driver *driver;
@@ -198,6 +206,9 @@ struct udevice {
 #if CONFIG_IS_ENABLED(IOMMU)
 	struct udevice *iommu;
 #endif
+#if CONFIG_IS_ENABLED(DM_OFNODE_HASH)
+	struct udevice *node_hash_next;
+#endif
 };
 
 static inline int dm_udevice_size(void)
@@ -64,6 +64,22 @@ int lists_bind_drivers(struct udevice *parent, bool pre_reloc_only);
 int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 		   struct driver *drv, bool pre_reloc_only);
 
+/**
+ * lists_match_fdt() - find the driver lists_bind_fdt() would try first
+ *
+ * This matches the compatible strings of a node against the drivers in the
+ * same order as lists_bind_fdt(), without binding anything. A driver which
+ * refuses to bind with -ENODEV is not detected.
+ *
+ * @node: device tree node to match
+ * @pre_reloc_only: as for lists_bind_fdt()
+ * @drvp: returns the matching driver
+ * Return: 0 if a driver was found, -ENOENT if no driver matches or the node
+ * has no compatible string, -EPERM if the driver is not bound before
+ * relocation, other -ve value on error
+ */
+int lists_match_fdt(ofnode node, bool pre_reloc_only, struct driver **drvp);
+
 /**
  * device_bind_driver() - bind a device to a driver
  *
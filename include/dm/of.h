@@ -17,16 +17,37 @@ typedef u32 phandle;
  *
  * @name: Property name
  * @length: Length of property in bytes
+ * @hash: of_prop_hash() of @name, or 0 if not known
  * @value: Pointer to property value
  * @next: Pointer to next property, or NULL if none
  */
 struct property {
 	char *name;
 	int length;
+	u32 hash;
 	void *value;
 	struct property *next;
 };
 
+/**
+ * of_prop_hash() - hash a property name
+ *
+ * Lookups compare this before the name, so that most properties of a node
+ * can be skipped without a string compare.
+ *
+ * @name: Property name
+ * Return: hash of @name, never 0
+ */
+static inline u32 of_prop_hash(const char *name)
+{
+	u32 hash = 2166136261U;
+
+	while (*name)
+		hash = (hash ^ (u8)*name++) * 16777619U;
+
+	return hash ?: 1;
+}
+
 /**
  * struct device_node: Device tree node
  *
@@ -34,6 +34,10 @@ extern struct list_head uclass_head;
  * @attach_size_total: Total number of bytes of attached data
  * @attach_count: Number of devices with attached, for each type
  * @attach_size: Total number of bytes of attached data, for each type
+ * @alloc_count: Number of blocks allocated for devices and their attached
+ *	data
+ * @compact_count: Number of devices whose data is in compact blocks (see
+ *	CONFIG_DM_COMPACT_ALLOC)
  */
 struct dm_stats {
 	int total_size;
@@ -50,6 +54,8 @@ struct dm_stats {
 	int attach_size_total;
 	int attach_count[DM_TAG_ATTACH_COUNT];
 	int attach_size[DM_TAG_ATTACH_COUNT];
+	int alloc_count;
+	int compact_count;
 };
 
 /**
@@ -170,6 +176,20 @@ int dm_init(bool of_live);
  */
 int dm_uninit(void);
 
+/**
+ * dm_lazy_bind_all() - bind all nodes recorded for binding on demand
+ *
+ * With CONFIG_DM_LAZY_BIND the device tree scan only records the nodes it
+ * finds. This binds all of them, including nodes recorded while doing so.
+ *
+ * Return: number of devices bound
+ */
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+int dm_lazy_bind_all(void);
+#else
+static inline int dm_lazy_bind_all(void) { return 0; }
+#endif
+
 #if CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)
 /**
  * dm_remove_devices_flags - Call remove function of all drivers with
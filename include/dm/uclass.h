@@ -30,12 +30,18 @@
  * @dev_head: List of devices in this uclass (devices are attached to their
  * uclass when their bind method is called)
  * @sibling_node: Next uclass in the linked list of uclasses
+ * @lazy_pos: Number of entries of gd->dm_lazy already checked for this uclass
+ * @lazy_busy: true while binding the devices of this uclass on demand
  */
 struct uclass {
 	void *priv_;
 	struct uclass_driver *uc_drv;
 	struct list_head dev_head;
 	struct list_head sibling_node;
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+	uint lazy_pos;
+	bool lazy_busy;
+#endif
 };
 
 struct driver;
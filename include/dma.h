@@ -331,6 +331,22 @@ int dma_get_device(u32 transfer_type, struct udevice **devp);
 	     transferred and on failure return error code.
  */
 int dma_memcpy(void *dst, void *src, size_t len);
+
+/**
+ * dma_memcpy_offload() - Copy memory with DMA if it is worth doing
+ *
+ * This is used for large copies where the CPU copy is the fallback. The copy
+ * is done with DMA only if @len is at least CONFIG_DMA_MEMCPY_THRESHOLD and
+ * the regions do not overlap.
+ *
+ * @dst: Destination pointer
+ * @src: Source pointer
+ * @len: Number of bytes to copy
+ * Return: 0 if the data was copied, -E2BIG if the copy is too small or
+ *	overlapping, other -ve error if the DMA transfer failed, in which
+ *	case the caller must copy the data itself
+ */
+int dma_memcpy_offload(void *dst, const void *src, size_t len);
 #else
 static inline int dma_get_device(u32 transfer_type, struct udevice **devp)
 {
@@ -341,5 +357,10 @@ static inline int dma_memcpy(void *dst, void *src, size_t len)
 {
 	return -ENOSYS;
 }
+
+static inline int dma_memcpy_offload(void *dst, const void *src, size_t len)
+{
+	return -ENOSYS;
+}
 #endif /* CONFIG_DMA */
 #endif	/* _DMA_H_ */
@@ -558,6 +558,7 @@ struct dw_hdmi {
 
 int dw_hdmi_phy_cfg(struct dw_hdmi *hdmi, uint mpixelclock);
 int dw_hdmi_phy_wait_for_hpd(struct dw_hdmi *hdmi);
+bool dw_hdmi_phy_hpd(struct dw_hdmi *hdmi);
 void dw_hdmi_phy_init(struct dw_hdmi *hdmi);
 
 int dw_hdmi_enable(struct dw_hdmi *hdmi, const struct display_timing *edid);
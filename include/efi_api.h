@@ -778,6 +778,31 @@ struct efi_block_io {
 	efi_status_t (EFIAPI *flush_blocks)(struct efi_block_io *this);
 };
 
+#define EFI_BLOCK_IO2_PROTOCOL_GUID \
+	EFI_GUID(0xa77b2472, 0xe282, 0x4e9f, \
+		 0xa2, 0x45, 0xc2, 0xc0, 0xe2, 0x7b, 0xbc, 0xc1)
+
+struct efi_block_io2_token {
+	struct efi_event *event;
+	efi_status_t transaction_status;
+};
+
+struct efi_block_io2 {
+	struct efi_block_io_media *media;
+	efi_status_t (EFIAPI *reset)(struct efi_block_io2 *this,
+			bool extended_verification);
+	efi_status_t (EFIAPI *read_blocks_ex)(struct efi_block_io2 *this,
+			u32 media_id, u64 lba,
+			struct efi_block_io2_token *token,
+			efi_uintn_t buffer_size, void *buffer);
+	efi_status_t (EFIAPI *write_blocks_ex)(struct efi_block_io2 *this,
+			u32 media_id, u64 lba,
+			struct efi_block_io2_token *token,
+			efi_uintn_t buffer_size, void *buffer);
+	efi_status_t (EFIAPI *flush_blocks_ex)(struct efi_block_io2 *this,
+			struct efi_block_io2_token *token);
+};
+
 struct simple_text_output_mode {
 	s32 max_mode;
 	s32 mode;
@@ -1503,6 +1528,40 @@ struct efi_simple_network_mode {
 	u8 media_present;
 };
 
+/**
+ * struct efi_network_statistics - statistics of a network interface
+ *
+ * Counters which are not supported are set to all ones.
+ */
+struct efi_network_statistics {
+	u64 rx_total_frames;
+	u64 rx_good_frames;
+	u64 rx_undersize_frames;
+	u64 rx_oversize_frames;
+	u64 rx_dropped_frames;
+	u64 rx_unicast_frames;
+	u64 rx_broadcast_frames;
+	u64 rx_multicast_frames;
+	u64 rx_crc_error_frames;
+	u64 rx_total_bytes;
+	u64 tx_total_frames;
+	u64 tx_good_frames;
+	u64 tx_undersize_frames;
+	u64 tx_oversize_frames;
+	u64 tx_dropped_frames;
+	u64 tx_unicast_frames;
+	u64 tx_broadcast_frames;
+	u64 tx_multicast_frames;
+	u64 tx_crc_error_frames;
+	u64 tx_total_bytes;
+	u64 collisions;
+	u64 unsupported_protocol;
+	u64 rx_duplicated_frames;
+	u64 rx_decrypt_error_frames;
+	u64 tx_error_frames;
+	u64 tx_retry_frames;
+};
+
 /* receive_filters bit mask */
 #define EFI_SIMPLE_NETWORK_RECEIVE_UNICAST               0x01
 #define EFI_SIMPLE_NETWORK_RECEIVE_MULTICAST             0x02
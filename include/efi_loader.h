@@ -150,6 +150,10 @@ struct http_header {
 };
 
 void efi_net_parse_headers(ulong *num_headers, struct http_header *headers);
+/* Print the traffic counted by the simple network protocol */
+void efi_net_show_stats(void);
+/* Clear the simple network protocol statistics */
+void efi_net_reset_stats(void);
 #else
 static inline void efi_net_get_dp(struct efi_device_path **dp) { }
 static inline void efi_net_get_addr(struct efi_ipv4_address *ip,
@@ -158,6 +162,8 @@ static inline void efi_net_get_addr(struct efi_ipv4_address *ip,
 static inline void efi_net_set_addr(struct efi_ipv4_address *ip,
 				     struct efi_ipv4_address *mask,
 				     struct efi_ipv4_address *gw) { }
+static inline void efi_net_show_stats(void) { }
+static inline void efi_net_reset_stats(void) { }
 #endif
 
 /* Maximum number of configuration tables */
@@ -213,11 +219,49 @@ const char *__efi_nesting(void);
 const char *__efi_nesting_inc(void);
 const char *__efi_nesting_dec(void);
 
+/**
+ * struct efi_stat - statistics on the calls of a UEFI service
+ *
+ * @name:	name of the function implementing the service
+ * @calls:	number of calls
+ * @ticks:	timer ticks spent in the service, including nested calls
+ * @next:	next service in the list of called services
+ * @linked:	true once added to the list
+ */
+struct efi_stat {
+	const char *name;
+	ulong calls;
+	u64 ticks;
+	struct efi_stat *next;
+	bool linked;
+};
+
+void efi_stats_enter(struct efi_stat *stat);
+void efi_stats_exit(const char *name);
+/* Print the statistics of all services called so far */
+void efi_stats_show(void);
+/* Clear the statistics */
+void efi_stats_reset(void);
+/* Add an accumulated time record to bootstage for each service */
+void efi_stats_bootstage(void);
+
+#if CONFIG_IS_ENABLED(EFI_STATS)
+#define __EFI_STATS_ENTRY() do { \
+	static struct efi_stat __efi_stat = { .name = __func__ }; \
+	efi_stats_enter(&__efi_stat); \
+	} while (0)
+#define __EFI_STATS_EXIT() efi_stats_exit(__func__)
+#else
+#define __EFI_STATS_ENTRY() do {} while (0)
+#define __EFI_STATS_EXIT() do {} while (0)
+#endif
+
 /*
  * Enter the u-boot world from UEFI:
  */
 #define EFI_ENTRY(format, ...) do { \
 	assert(__efi_entry_check()); \
+	__EFI_STATS_ENTRY(); \
 	debug("%sEFI: Entry %s(" format ")\n", __efi_nesting_inc(), \
 		__func__, ##__VA_ARGS__); \
 	} while(0)
@@ -229,6 +273,7 @@ const char *__efi_nesting_dec(void);
 	typeof(ret) _r = ret; \
 	debug("%sEFI: Exit: %s: %u\n", __efi_nesting_dec(), \
 		__func__, (u32)((uintptr_t) _r & ~EFI_ERROR_MASK)); \
+	__EFI_STATS_EXIT(); \
 	assert(__efi_exit_check()); \
 	_r; \
 	})
@@ -410,12 +455,16 @@ struct efi_open_protocol_info_item {
  * @guid:		GUID of the protocol
  * @protocol_interface:	protocol interface
  * @open_infos:		link to the list of open protocol info items
+ * @guid_link:		link to the list of interfaces of the same protocol
+ * @handle:		handle on which the protocol is installed
  */
 struct efi_handler {
 	struct list_head link;
 	const efi_guid_t guid;
 	void *protocol_interface;
 	struct list_head open_infos;
+	struct list_head guid_link;
+	efi_handle_t handle;
 };
 
 /**
@@ -1034,11 +1083,15 @@ efi_status_t efi_bootmgr_load(efi_handle_t *handle, void **load_options);
  *
  * @max:	Maximum number of regions
  * @num:	Number of regions
+ * @digest_algo:	Algorithm of @digest, NULL if not calculated yet
+ * @digest:	Digest of the regions, see efi_image_regions_hash()
  * @reg:	array of regions
  */
 struct efi_image_regions {
 	int			max;
 	int			num;
+	const char		*digest_algo;
+	u8			digest[64];
 	struct image_region	reg[];
 };
 
@@ -1068,11 +1121,16 @@ struct efi_sig_data {
  * @next:		Pointer to next entry
  * @sig_type:		Signature type
  * @sig_data_list:	Pointer to signature list
+ * @digests:		Sorted SHA-256 digests of all the entries of the
+ *			database, only set in the first entry
+ * @num_digests:	Number of digests in @digests
  */
 struct efi_signature_store {
 	struct efi_signature_store *next;
 	efi_guid_t sig_type;
 	struct efi_sig_data *sig_data_list;
+	u8 *digests;
+	size_t num_digests;
 };
 
 struct x509_certificate;
@@ -1096,6 +1154,8 @@ struct eficonfig_media_boot_option {
 
 bool efi_hash_regions(struct image_region *regs, int count,
 		      void **hash, const char *hash_algo, int *len);
+bool efi_image_regions_hash(struct efi_image_regions *regs,
+			    const char *hash_algo, void **hash, int *len);
 bool efi_signature_lookup_digest(struct efi_image_regions *regs,
 				 struct efi_signature_store *db,
 				 bool dbx);
@@ -102,6 +102,12 @@ efi_status_t efi_query_variable_info_int(u32 attributes,
  */
 #define EFI_VAR_FILE_MAGIC 0x0161566966456255 /* UbEfiVa, version 1 */
 
+/*
+ * This constant identifies a record appended to the file, see
+ * struct efi_var_journal
+ */
+#define EFI_VAR_JOURNAL_MAGIC 0x6c4a5655 /* UVJl */
+
 /**
  * struct efi_var_entry - UEFI variable file entry
  *
@@ -136,6 +142,23 @@ struct efi_var_file {
 	struct efi_var_entry var[];
 };
 
+/**
+ * struct efi_var_journal - header of a record appended to the variables file
+ *
+ * With CONFIG_EFI_VARIABLE_FILE_JOURNAL, changes to variables are appended
+ * to the file after the @length bytes covered by struct efi_var_file. Each
+ * record is this header followed by a struct efi_var_entry with the new value
+ * of the variable. An entry with a zero length records that the variable was
+ * deleted.
+ *
+ * @magic:	identifies the record, takes value %EFI_VAR_JOURNAL_MAGIC
+ * @crc32:	CRC32 of the entry which follows
+ */
+struct efi_var_journal {
+	u32 magic;
+	u32 crc32;
+};
+
 /**
  * efi_var_to_file() - save non-volatile variables as file
  *
@@ -145,6 +168,19 @@ struct efi_var_file {
  */
 efi_status_t efi_var_to_file(void);
 
+/**
+ * efi_var_file_update() - save a change to a non-volatile variable
+ *
+ * With CONFIG_EFI_VARIABLE_FILE_JOURNAL the new value, or the deletion, of
+ * the variable is appended to file ubootefi.var. Otherwise, or if the file
+ * needs compacting, this is the same as efi_var_to_file().
+ *
+ * @name:	name of the variable which has changed
+ * @guid:	vendor GUID of the variable
+ * Return:	status code
+ */
+efi_status_t efi_var_file_update(const u16 *name, const efi_guid_t *guid);
+
 /**
  * efi_var_collect() - collect variables in buffer
  *
@@ -256,6 +292,29 @@ efi_status_t efi_init_secure_state(void);
 enum efi_auth_var_type efi_auth_var_get_type(const u16 *name,
 					     const efi_guid_t *guid);
 
+struct efi_signature_store;
+
+/**
+ * efi_sigstore_get() - get a parsed image signature database
+ *
+ * The database is parsed on first use and kept until the variable is
+ * changed. The caller must not free it.
+ *
+ * @type:	EFI_AUTH_VAR_DB, EFI_AUTH_VAR_DBX or EFI_AUTH_VAR_DBT
+ * Return:	signature store or NULL on error
+ */
+struct efi_signature_store *efi_sigstore_get(enum efi_auth_var_type type);
+
+/**
+ * efi_sigstore_invalidate() - drop a cached image signature database
+ *
+ * Called when a variable is changed. Variables other than db, dbx and dbt
+ * are ignored.
+ *
+ * @type:	identifier of the changed variable
+ */
+void efi_sigstore_invalidate(enum efi_auth_var_type type);
+
 /**
  * efi_auth_var_get_guid() - get the predefined GUID for a variable name
  *
@@ -348,6 +348,38 @@ int env_import_redund(const char *buf1, int buf1_read_fail,
 		      const char *buf2, int buf2_read_fail,
 		      int flags);
 
+/**
+ * typedef env_read_copy_t - Read one copy of a redundant environment
+ *
+ * @priv: Private data passed to env_load_redund()
+ * @copy: Copy to read (0 for the first, 1 for the redundant one)
+ * @hdr_only: true if only the first ENV_HDR_SIZE bytes are needed
+ * @buf: Buffer of CONFIG_ENV_SIZE bytes to read into
+ * Return: 0 if OK, 1 if the whole copy was read even though @hdr_only was
+ *	set, -ve on error
+ */
+typedef int (*env_read_copy_t)(void *priv, int copy, bool hdr_only,
+			       void *buf);
+
+/**
+ * env_load_redund() - Read and import the newer of two redundant environments
+ *
+ * This produces the same result as reading both copies and passing them to
+ * env_import_redund(), while reading much less. Only the header of each copy
+ * is read at first, to find which is newer. Then just that copy is read in
+ * full and checked, with the older one read only if the newer is bad.
+ *
+ * @read: Function to read a copy
+ * @priv: Private data for @read
+ * @buf1: Buffer for the first environment (struct environment_s *)
+ * @buf2: Buffer for the second environment (struct environment_s *)
+ * @flags: Flags controlling matching (H_... - see search.h)
+ * Return: 0 if OK, -EIO if neither copy could be read, -ENOMSG if the CRC
+ *	of each copy that could be read was bad
+ */
+int env_load_redund(env_read_copy_t read, void *priv, char *buf1, char *buf2,
+		    int flags);
+
 /**
  * env_get_default() - Look up a variable from the default environment
  *
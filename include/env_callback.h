@@ -70,6 +70,12 @@
 #define DFU_CALLBACK
 #endif
 
+#ifdef CONFIG_PCI_SCAN_CACHE
+#define PCI_SCAN_CALLBACK "pci_scan:pci_scan,"
+#else
+#define PCI_SCAN_CALLBACK
+#endif
+
 /*
  * This list of callback bindings is static, but may be overridden by defining
  * a new association in the ".callbacks" environment variable.
@@ -81,6 +87,7 @@
 	NET6_CALLBACKS \
 	BOOTSTD_CALLBACK \
 	DFU_CALLBACK \
+	PCI_SCAN_CALLBACK \
 	"loadaddr:loadaddr," \
 	SILENT_CALLBACK \
 	"stdin:console,stdout:console,stderr:console," \
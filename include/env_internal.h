@@ -83,6 +83,9 @@ typedef struct environment_s {
 	unsigned char	data[ENV_SIZE]; /* Environment data		*/
 } env_t;
 
+/* Number of bytes before the data, i.e. the CRC and any flags */
+#define ENV_HDR_SIZE	offsetof(env_t, data)
+
 #ifdef ENV_IS_EMBEDDED
 extern env_t embedded_environment;
 #endif /* ENV_IS_EMBEDDED */
@@ -192,6 +195,67 @@ struct env_driver {
 
 extern struct hsearch_data env_htab;
 
+/**
+ * struct env_log - storage for an append-only log of environment changes
+ *
+ * Offsets are relative to the start of the log area. The area reads as 0xff
+ * when erased and can be programmed in units of single bytes.
+ *
+ * @read: Read @len bytes at @offset into @buf; returns 0 if OK
+ * @write: Program @len bytes at @offset, which must be erased; returns 0 if OK
+ * @erase: Erase the whole area; returns 0 if OK
+ * @priv: Private data for the backend
+ * @size: Size of the log area in bytes
+ */
+struct env_log {
+	int (*read)(struct env_log *log, uint offset, uint len, void *buf);
+	int (*write)(struct env_log *log, uint offset, uint len,
+		     const void *buf);
+	int (*erase)(struct env_log *log);
+	void *priv;
+	uint size;
+};
+
+/**
+ * env_log_replay() - Apply the environment log to the imported environment
+ *
+ * This is called after the stored environment has been imported. The log is
+ * only used if it was started for an environment with CRC @base_crc; a log
+ * left by a full save from elsewhere is ignored. A damaged record ends the
+ * replay.
+ *
+ * @log: Log to read
+ * @base_crc: CRC of the environment which was imported
+ * Return: number of records applied, or -ve on error reading the log
+ */
+int env_log_replay(struct env_log *log, u32 base_crc);
+
+/**
+ * env_log_save() - Append the changes since the last load or save to the log
+ *
+ * @log: Log to write
+ * Return: 0 if OK, -ENOSPC if the environment must be saved in full instead
+ *	(the log is full, damaged or not yet started), other -ve on error
+ */
+int env_log_save(struct env_log *log);
+
+/**
+ * env_log_reset() - Start a new log after the environment was saved in full
+ *
+ * @log: Log to reset
+ * @env: Environment which was saved
+ * Return: 0 if OK, -ve on error
+ */
+int env_log_reset(struct env_log *log, const env_t *env);
+
+/**
+ * env_log_erase() - Erase the log, so that nothing is replayed
+ *
+ * @log: Log to erase
+ * Return: 0 if OK, -ve on error
+ */
+int env_log_erase(struct env_log *log);
+
 /**
  * env_do_env_set() - Perform the actual setting of an environment variable
  *
@@ -337,6 +337,31 @@ int event_register(const char *id, enum event_t type, event_handler_t func,
 /** event_show_spy_list( - Show a list of event spies */
 void event_show_spy_list(void);
 
+/**
+ * struct event_stats - statistics for an event type
+ *
+ * @count: Number of times the event has been sent
+ * @time_us: Total time taken by the spies, in microseconds. This only counts
+ *	events sent after relocation, once the timer is running
+ */
+struct event_stats {
+	uint count;
+	ulong time_us;
+};
+
+/**
+ * event_get_stats() - Get the statistics for an event type
+ *
+ * This needs CONFIG_EVENT_STATS
+ *
+ * @type: Event type
+ * Return: Statistics for that type, or NULL if @type is not valid
+ */
+const struct event_stats *event_get_stats(enum event_t type);
+
+/** event_show_stats() - Show the statistics for each event type */
+void event_show_stats(void);
+
 /**
  * event_type_name() - Get the name of an event type
  *
@@ -28,8 +28,28 @@ struct event_spy {
 	void *ctx;
 };
 
+/**
+ * struct event_state - the spies and statistics for each event type
+ *
+ * @spy_head: List of dynamic spies (struct event_spy) for each type
+ * @static_ready: true once @static_first and @static_count are set up
+ * @static_grouped: true if the static spies are grouped by type, as is normal
+ *	since the linker sorts them by name, which starts with the type
+ * @static_first: Index of the first static spy for each type
+ * @static_count: Number of static spies for each type
+ * @stats: Statistics for each type
+ */
 struct event_state {
-	struct list_head spy_head;
+#if CONFIG_IS_ENABLED(EVENT_DYNAMIC)
+	struct list_head spy_head[EVT_COUNT];
+#endif
+	bool static_ready;
+	bool static_grouped;
+	u16 static_first[EVT_COUNT];
+	u16 static_count[EVT_COUNT];
+#if CONFIG_IS_ENABLED(EVENT_STATS)
+	struct event_stats stats[EVT_COUNT];
+#endif
 };
 
 #endif
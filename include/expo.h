@@ -99,6 +99,9 @@ struct expo_theme {
  * @display: Display to use (`UCLASS_VIDEO`), or NULL to use text mode
  * @cons: Console to use (`UCLASS_VIDEO_CONSOLE`), or NULL to use text mode
  * @scene_id: Current scene ID (0 if none)
+ * @drawn_scene_id: ID of the scene which is drawn on the display, so that only
+ *	the objects which have changed need to be drawn again, or 0 if the whole
+ *	scene must be drawn
  * @next_id: Next ID number to use, for automatic allocation
  * @action: Action selected by user. At present only one is supported, with the
  * type set to EXPOACT_NONE if there is no action
@@ -114,6 +117,7 @@ struct expo {
 	struct udevice *display;
 	struct udevice *cons;
 	uint scene_id;
+	uint drawn_scene_id;
 	uint next_id;
 	struct expo_action action;
 	bool text_mode;
@@ -230,6 +234,9 @@ enum {
  * @flags: Flags for this object
  * @bit_length: Number of bits used for this object in CMOS RAM
  * @start_bit: Start bit to use for this object in CMOS RAM
+ * @drawn: Region covered by the object when it was last drawn, with a width of
+ *	0 if it was not drawn
+ * @drawn_hash: Hash of the state of the object when it was last drawn
  * @sibling: Node to link this object to its siblings
  */
 struct scene_obj {
@@ -241,6 +248,8 @@ struct scene_obj {
 	u8 flags;
 	u8 bit_length;
 	u16 start_bit;
+	struct scene_dim drawn;
+	u32 drawn_hash;
 	struct list_head sibling;
 };
 
@@ -472,6 +481,9 @@ int expo_first_scene_id(struct expo *exp);
 /**
  * expo_render() - render the expo on the display / console
  *
+ * If the current scene is already on the display, only the objects which have
+ * changed since it was drawn are drawn again, along with anything they overlap
+ *
  * @exp: Expo to render
  *
  * Returns: 0 if OK, -ECHILD if there is no current scene, -ENOENT if the
@@ -479,6 +491,19 @@ int expo_first_scene_id(struct expo *exp);
  */
 int expo_render(struct expo *exp);
 
+/**
+ * expo_redraw() - render the whole expo on the display / console
+ *
+ * Use this when something else has drawn on the display since the expo was
+ * last rendered
+ *
+ * @exp: Expo to render
+ *
+ * Returns: 0 if OK, -ECHILD if there is no current scene, -ENOENT if the
+ * current scene is not found, other error if something else goes wrong
+ */
+int expo_redraw(struct expo *exp);
+
 /**
  * expo_set_text_mode() - Controls whether the expo renders in text mode
  *
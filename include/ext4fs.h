@@ -31,11 +31,15 @@
 
 struct disk_partition;
 
+#define EXT4_ENCRYPT_FL		0x00000800 /* Encrypted inode */
 #define EXT4_INDEX_FL		0x00001000 /* Inode uses hash tree index */
 #define EXT4_TOPDIR_FL		0x00020000 /* Top of directory hierarchies*/
 #define EXT4_EXTENTS_FL		0x00080000 /* Inode uses extents */
+#define EXT4_CASEFOLD_FL	0x40000000 /* Casefolded directory */
 #define EXT4_EXT_MAGIC			0xf30a
 
+#define EXT4_FEATURE_COMPAT_DIR_INDEX	     0x0020
+
 #define EXT4_FEATURE_RO_COMPAT_SPARSE_SUPER  0x0001
 #define EXT4_FEATURE_RO_COMPAT_LARGE_FILE    0x0002
 #define EXT4_FEATURE_RO_COMPAT_BTREE_DIR     0x0004
@@ -113,6 +117,12 @@ struct ext4_extent {
 	__le32	ee_start_lo;	/* low 32 bits of physical block */
 };
 
+/*
+ * Extents longer than this are uninitialised (preallocated) and read as
+ * zeroes; their real length is ee_len - EXT_INIT_MAX_LEN.
+ */
+#define EXT_INIT_MAX_LEN	(1 << 15)
+
 /*
  * This is index on-disk structure.
  * It's used at all the levels except the bottom.
@@ -156,12 +166,12 @@ struct ext_filesystem {
 	/* Block group descritpor table */
 	char *gdtable;
 
-	/* Block Bitmap Related */
+	/* Block Bitmap Related, each read when first needed */
 	unsigned char **blk_bmaps;
 	long int curr_blkno;
 	uint16_t first_pass_bbmap;
 
-	/* Inode Bitmap Related */
+	/* Inode Bitmap Related, each read when first needed */
 	unsigned char **inode_bmaps;
 	int curr_inode_no;
 	uint16_t first_pass_ibmap;
@@ -51,6 +51,7 @@ enum {
 	FASTBOOT_COMMAND_OEM_RUN,
 	FASTBOOT_COMMAND_OEM_CONSOLE,
 	FASTBOOT_COMMAND_OEM_BOARD,
+	FASTBOOT_COMMAND_OEM_STREAM,
 	FASTBOOT_COMMAND_ACMD,
 	FASTBOOT_COMMAND_UCMD,
 	FASTBOOT_COMMAND_COUNT
@@ -177,6 +178,40 @@ u32 fastboot_data_remaining(void);
 void fastboot_data_download(const void *fastboot_data,
 			    unsigned int fastboot_data_len, char *response);
 
+/**
+ * fastboot_data_buffer() - Get the place of image data in the download buffer
+ *
+ * @offset: Offset of the data within the current download
+ * @len: Length of the data
+ *
+ * For transports that store data where it belongs as it arrives, possibly
+ * out of order, instead of calling fastboot_data_download(). Such data is
+ * accounted for with fastboot_data_received() once it is complete up to
+ * some point.
+ *
+ * Return: Pointer to where the data goes, or NULL if the range is outside
+ * the current download or the download is flashed as it arrives
+ */
+void *fastboot_data_buffer(u32 offset, u32 len);
+
+/**
+ * fastboot_data_received() - Account for data stored with
+ * fastboot_data_buffer()
+ *
+ * @len: Number of bytes that follow the data accounted for before
+ */
+void fastboot_data_received(u32 len);
+
+/**
+ * fastboot_data_flush() - Write out streamed data that has been collected
+ *
+ * When a download is being flashed as it arrives ("oem stream"), write out
+ * the data received so far once enough of it has been collected. Transports
+ * call this after handing the next receive buffer to the hardware, so that
+ * the write overlaps with receiving more data.
+ */
+void fastboot_data_flush(void);
+
 /**
  * fastboot_data_complete() - Mark current transfer complete
  *
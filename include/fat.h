@@ -9,6 +9,7 @@
 #ifndef _FAT_H_
 #define _FAT_H_
 
+#include <blk.h>
 #include <fs.h>
 #include <asm/byteorder.h>
 #include <asm/cache.h>
@@ -155,6 +156,8 @@ typedef struct dir_slot {
 	__u8	name11_12[4];	/* Last 2 characters in name */
 } dir_slot;
 
+struct fat_wtable;
+
 /*
  * Private filesystem parameters
  *
@@ -176,6 +179,8 @@ typedef struct {
 	__u32	root_cluster;	/* First cluster of root dir for FAT32 */
 	u32	total_sect;	/* Number of sectors */
 	int	fats;		/* Number of FATs */
+	__u8	cached;		/* Set if the mount cache may be used */
+	struct fat_wtable *wtable;	/* Whole FAT while writing, or NULL */
 } fsdata;
 
 struct fat_itr;
@@ -221,4 +226,26 @@ void *fat_next_cluster(fat_itr *itr, unsigned int *nbytes);
  */
 int fat_uuid(char *uuid_str);
 
+#if CONFIG_IS_ENABLED(FAT_CACHE)
+/**
+ * fat_cache_invalidate_blk() - Drop the FAT cache if a write affects it
+ *
+ * The FAT driver keeps metadata of the last filesystem it read. This must be
+ * called when blocks of a device are written or erased, or when the medium
+ * may have changed.
+ *
+ * @desc:	Block-device descriptor
+ * @start:	First block written
+ * @blkcnt:	Number of blocks written, or 0 to drop the cache if it belongs
+ *		to the device
+ */
+void fat_cache_invalidate_blk(struct blk_desc *desc, lbaint_t start,
+			      lbaint_t blkcnt);
+#else
+static inline void fat_cache_invalidate_blk(struct blk_desc *desc,
+					    lbaint_t start, lbaint_t blkcnt)
+{
+}
+#endif
+
 #endif /* _FAT_H_ */
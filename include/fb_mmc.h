@@ -39,4 +39,37 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
  * @response: Pointer to fastboot response buffer
  */
 void fastboot_mmc_erase(const char *cmd, char *response);
+
+/**
+ * fastboot_mmc_stream_start() - Prepare to flash a partition during download
+ *
+ * @cmd: Named partition to write the image to
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 on success, -ve if the partition cannot be found
+ */
+int fastboot_mmc_stream_start(const char *cmd, char *response);
+
+/**
+ * fastboot_mmc_stream_write() - Write the next part of a streamed image
+ *
+ * Raw images are written in whole blocks, and sparse headers are only used
+ * once complete, so fewer than @len bytes may be consumed. The unconsumed
+ * tail must be passed again at the start of the next call. With @last set,
+ * a final partial block of a raw image is padded and written.
+ *
+ * @data: Image data following what has been consumed so far
+ * @len: Number of bytes available at @data
+ * @last: This is the end of the image
+ * @response: Pointer to fastboot response buffer
+ * Return: number of bytes consumed, or -ve on error
+ */
+long fastboot_mmc_stream_write(void *data, u32 len, bool last, char *response);
+
+/**
+ * fastboot_mmc_stream_finish() - Complete flashing of a streamed image
+ *
+ * @cmd: Named partition the image was written to
+ * @response: Pointer to fastboot response buffer
+ */
+void fastboot_mmc_stream_finish(const char *cmd, char *response);
 #endif
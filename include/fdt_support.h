@@ -10,8 +10,10 @@
 #if !defined(USE_HOSTCC)
 
 #include <asm/u-boot.h>
+#include <linux/errno.h>
 #include <linux/libfdt.h>
 #include <abuf.h>
+#include <u-boot/sha256.h>
 
 /**
  * arch_fixup_fdt() - write arch-specific information to fdt
@@ -85,6 +87,59 @@ static inline void do_fixup_by_path_string(void *fdt, const char *path,
 	do_fixup_by_path(fdt, path, prop, status, strlen(status) + 1, 1);
 }
 
+/**
+ * struct fdt_batch - property changes to apply to a tree in one pass
+ *
+ * Each fdt_setprop() moves the rest of the tree to make room, so a fixup
+ * changing many properties moves the tree many times. Changes collected in
+ * a batch are written by fdt_batch_apply() while copying the tree once.
+ * Node offsets stay valid while collecting, since the tree is not changed.
+ *
+ * @props: Changes, in the order they were added
+ * @count: Number of changes
+ * @size: Number of changes allocated
+ */
+struct fdt_batch {
+	struct fdt_batch_prop *props;
+	int count;
+	int size;
+};
+
+/**
+ * fdt_batch_init() - start a batch of property changes
+ *
+ * @batch: Batch to set up
+ */
+void fdt_batch_init(struct fdt_batch *batch);
+
+/**
+ * fdt_batch_setprop() - add a property change to a batch
+ *
+ * A later change to the same property replaces an earlier one.
+ *
+ * @batch: Batch to add to
+ * @nodeoffset: Offset of the node holding the property
+ * @name: Property name
+ * @val: Property value, which is copied
+ * @len: Length of @val in bytes
+ * Return: 0 if OK, -FDT_ERR_NOSPACE if out of memory
+ */
+int fdt_batch_setprop(struct fdt_batch *batch, int nodeoffset,
+		      const char *name, const void *val, int len);
+
+/**
+ * fdt_batch_apply() - apply a batch of property changes and free it
+ *
+ * The tree is rewritten once with all changes. If that is not possible,
+ * for example with an unusual block layout, the changes are made one at a
+ * time with fdt_setprop() instead.
+ *
+ * @fdt: Tree the changes were collected for
+ * @batch: Changes to apply
+ * Return: 0 if OK, -FDT_ERR_... on error
+ */
+int fdt_batch_apply(void *fdt, struct fdt_batch *batch);
+
 void do_fixup_by_prop(void *fdt,
 		      const char *pname, const void *pval, int plen,
 		      const char *prop, const void *val, int len,
@@ -459,6 +514,87 @@ int fdt_add_fb_mem_rsv(void *blob);
 
 int fdt_overlay_apply_verbose(void *fdt, void *fdto);
 
+/**
+ * struct fdt_overlay_cache - state for looking up a merged tree
+ *
+ * @ctx: Digest of the inputs so far
+ * @digest: Final digest, valid once @done is true
+ * @count: Number of overlays added
+ * @done: true once @digest is valid
+ */
+struct fdt_overlay_cache {
+	sha256_context ctx;
+	u8 digest[SHA256_SUM_LEN];
+	int count;
+	bool done;
+};
+
+#if CONFIG_IS_ENABLED(OF_LIBFDT_OVERLAY_CACHE)
+/**
+ * fdt_overlay_cache_start() - start looking up a merged tree
+ *
+ * @cache: Cache context to set up
+ * @base: Base tree, before any overlay is applied
+ */
+void fdt_overlay_cache_start(struct fdt_overlay_cache *cache,
+			     const void *base);
+
+/**
+ * fdt_overlay_cache_add() - add the next overlay to apply
+ *
+ * @cache: Cache context
+ * @overlay: Overlay, in the order it is applied
+ */
+void fdt_overlay_cache_add(struct fdt_overlay_cache *cache,
+			   const void *overlay);
+
+/**
+ * fdt_overlay_cache_load() - load the merged tree if it is cached
+ *
+ * @cache: Cache context, with all overlays added
+ * @base: Base tree, replaced by the merged tree on success
+ * @size: Space available at @base
+ * Return: 0 if the merged tree was loaded, -ENOENT if it is not cached,
+ * other -ve value if reading the cache failed after changing @base
+ */
+int fdt_overlay_cache_load(struct fdt_overlay_cache *cache, void *base,
+			   ulong size);
+
+/**
+ * fdt_overlay_cache_store() - store a merged tree in the cache
+ *
+ * This does nothing if no cache file is set up.
+ *
+ * @cache: Cache context, with all overlays added
+ * @merged: Tree with all overlays applied
+ * Return: 0 if OK, -ve on error
+ */
+int fdt_overlay_cache_store(struct fdt_overlay_cache *cache,
+			    const void *merged);
+#else
+static inline void fdt_overlay_cache_start(struct fdt_overlay_cache *cache,
+					   const void *base)
+{
+}
+
+static inline void fdt_overlay_cache_add(struct fdt_overlay_cache *cache,
+					 const void *overlay)
+{
+}
+
+static inline int fdt_overlay_cache_load(struct fdt_overlay_cache *cache,
+					 void *base, ulong size)
+{
+	return -ENOENT;
+}
+
+static inline int fdt_overlay_cache_store(struct fdt_overlay_cache *cache,
+					  const void *merged)
+{
+	return 0;
+}
+#endif
+
 int fdt_valid(struct fdt_header **blobp);
 
 /**
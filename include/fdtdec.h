@@ -674,6 +674,58 @@ int fdtdec_get_chosen_node(const void *blob, const char *name);
  */
 const char *fdtdec_get_compatible(enum fdt_compat_id id);
 
+#if CONFIG_IS_ENABLED(OF_LIBFDT_INDEX)
+/**
+ * fdtdec_path_offset() - find a node by its full path, using an index
+ *
+ * This gives the same result as fdt_path_offset(). Absolute paths naming
+ * every node in full are looked up in an index of @blob, which is built on
+ * first use. Other paths, such as aliases or names without a unit
+ * address, use fdt_path_offset().
+ *
+ * @blob: FDT blob
+ * @path: Path of the node
+ * Return: node offset if found, -ve FDT_ERR_... on error
+ */
+int fdtdec_path_offset(const void *blob, const char *path);
+
+/**
+ * fdtdec_node_offset_by_phandle() - find a node by phandle, using an index
+ *
+ * This gives the same result as fdt_node_offset_by_phandle(), using an
+ * index of @blob which is built on first use.
+ *
+ * @blob: FDT blob
+ * @phandle: phandle to look up
+ * Return: node offset if found, -ve FDT_ERR_... on error
+ */
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle);
+
+/**
+ * fdtdec_index_invalidate() - drop the index of a blob
+ *
+ * Changes which move nodes are normally detected on the next lookup. Call
+ * this after changes which may not be, such as removing a node and adding
+ * another one of the same size, or before freeing @blob.
+ *
+ * @blob: FDT blob which was changed
+ */
+void fdtdec_index_invalidate(const void *blob);
+#else
+static inline int fdtdec_path_offset(const void *blob, const char *path)
+{
+	return fdt_path_offset(blob, path);
+}
+
+static inline int fdtdec_node_offset_by_phandle(const void *blob,
+						uint32_t phandle)
+{
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+
+static inline void fdtdec_index_invalidate(const void *blob) {}
+#endif
+
 /* Look up a phandle and follow it to its node. Then return the offset
  * of that node.
  *
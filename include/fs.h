@@ -150,6 +150,53 @@ int fs_size(const char *filename, loff_t *size);
 int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	    loff_t *actread);
 
+/**
+ * struct fs_sink - destination for a file which is read piece by piece
+ *
+ * @write: Called with each part of the file in turn, in order. Returns 0 if
+ *	OK, or -ve on error, which stops the read
+ */
+struct fs_sink {
+	int (*write)(struct fs_sink *sink, const void *buf, ulong len);
+};
+
+/**
+ * fs_read_sink() - read a file in chunks, passing each one to a sink
+ *
+ * This reads from the partition previously set by fs_set_blk_dev(), as
+ * fs_read() does. Each chunk is read at an offset into the file, so the
+ * filesystem driver must support offset != 0 if the file is larger than
+ * @chunk.
+ *
+ * @filename:	full path of the file to read from
+ * @sink:	sink to pass the data to
+ * @chunk:	number of bytes to read at once
+ * @actread:	returns the number of bytes passed to @sink
+ * Return:	0 if OK, -ENOMEM if there is no memory for the chunk, other -ve
+ *	on error from the filesystem or @sink
+ */
+int fs_read_sink(const char *filename, struct fs_sink *sink, ulong chunk,
+		 loff_t *actread);
+
+/**
+ * fs_read_decomp() - read a file, decompressing it as it is read
+ *
+ * The compression is detected from the start of the file. A file which is
+ * not compressed is copied as it is. Only the decompressed data is written to
+ * memory, so no buffer is needed for the compressed file. Like fs_read(),
+ * this reads from the partition previously set by fs_set_blk_dev().
+ *
+ * @filename:	full path of the file to read from
+ * @addr:	address to write the decompressed data to
+ * @max_size:	number of bytes available at @addr
+ * @sizep:	returns the number of bytes written to @addr
+ * Return:	0 if OK, -ENOSPC if the data does not fit in @max_size,
+ *	-EPROTONOSUPPORT if the compression is not supported, -EINVAL if the
+ *	data is corrupt, other -ve on error
+ */
+int fs_read_decomp(const char *filename, ulong addr, ulong max_size,
+		   loff_t *sizep);
+
 /**
  * fs_write() - write file to the partition previously set by fs_set_blk_dev()
  *
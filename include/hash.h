@@ -120,6 +120,35 @@ int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 int hash_block(const char *algo_name, const void *data, unsigned int len,
 	       uint8_t *output, int *output_size);
 
+/**
+ * struct hash_region - a region to hash with hash_block_multi()
+ *
+ * @data:	Data to hash
+ * @len:	Length of data to hash in bytes
+ * @output:	Place to put hash value, which must have room for the digest
+ *		of the algorithm
+ */
+struct hash_region {
+	const void *data;
+	unsigned int len;
+	uint8_t *output;
+};
+
+/**
+ * hash_block_multi() - Hash several blocks with the same algorithm
+ *
+ * Where several CPUs are available (CONFIG_ARMV8_CPU_WORK) the blocks are
+ * hashed in parallel, one per CPU, otherwise one after the other.
+ *
+ * @algo_name:		Hash algorithm to use
+ * @regions:		Blocks to hash
+ * @count:		Number of blocks
+ * Return: 0 if ok, -ve on error: -EPROTONOSUPPORT for an unknown algorithm,
+ * -ENOMEM if out of memory
+ */
+int hash_block_multi(const char *algo_name, struct hash_region *regions,
+		     int count);
+
 #endif /* !USE_HOSTCC */
 
 /**
@@ -26,9 +26,50 @@ struct sparse_storage {
 				 lbaint_t blk,
 				 lbaint_t blkcnt);
 
+	/*
+	 * Optional: discard blocks so that they read back as zero. Used
+	 * in place of writing large zero-filled CHUNK_TYPE_FILL chunks.
+	 */
+	lbaint_t	(*erase)(struct sparse_storage *info,
+				 lbaint_t blk,
+				 lbaint_t blkcnt);
+
 	void		(*mssg)(const char *str, char *response);
 };
 
+/**
+ * struct sparse_stream - state of a sparse image written as it arrives
+ *
+ * @info:		storage the image is written to
+ * @header:		sparse image header, valid once @have_header is set
+ * @chunk_header:	header of the chunk being processed
+ * @chunk_data_sz:	size of the current chunk in the output image
+ * @raw_left:		bytes of CHUNK_TYPE_RAW data still to be written
+ * @blk:		next block to write
+ * @chunk:		number of chunks fully processed
+ * @total_blocks:	sparse blocks covered so far
+ * @bytes_written:	bytes written to storage so far
+ * @fill_buf:		buffer for CHUNK_TYPE_FILL, reused across chunks
+ * @fill_buf_val:	value @fill_buf currently holds
+ * @have_header:	the image header has been parsed
+ * @in_chunk:		@chunk_header has been parsed, its data has not
+ */
+struct sparse_stream {
+	struct sparse_storage	*info;
+	sparse_header_t		header;
+	chunk_header_t		chunk_header;
+	u64			chunk_data_sz;
+	u64			raw_left;
+	lbaint_t		blk;
+	unsigned int		chunk;
+	uint32_t		total_blocks;
+	uint64_t		bytes_written;
+	uint32_t		*fill_buf;
+	uint32_t		fill_buf_val;
+	bool			have_header;
+	bool			in_chunk;
+};
+
 static inline int is_sparse_image(void *buf)
 {
 	sparse_header_t *s_header = (sparse_header_t *)buf;
@@ -42,3 +83,38 @@ static inline int is_sparse_image(void *buf)
 
 int write_sparse_image(struct sparse_storage *info, const char *part_name,
 		       void *data, char *response);
+
+/**
+ * sparse_stream_init() - Prepare to write a sparse image piece by piece
+ *
+ * @ss: Stream state to initialise
+ * @info: Storage to write the image to
+ */
+void sparse_stream_init(struct sparse_stream *ss, struct sparse_storage *info);
+
+/**
+ * sparse_stream_write() - Write the next part of a sparse image
+ *
+ * Headers are only consumed once they are complete and RAW data only in
+ * whole storage blocks, so fewer than @len bytes may be used. The caller
+ * must pass the unused tail again, followed by more data, on the next call.
+ *
+ * @ss: Stream state
+ * @data: Image data following what has been consumed so far
+ * @len: Number of bytes available at @data
+ * @response: Pointer to fastboot response buffer
+ * Return: number of bytes consumed, or -ve on error
+ */
+long sparse_stream_write(struct sparse_stream *ss, const void *data,
+			 size_t len, char *response);
+
+/**
+ * sparse_stream_finish() - Check that a streamed sparse image was complete
+ *
+ * @ss: Stream state
+ * @part_name: Name of the partition, for the summary message
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if the whole image was written, -ve on error
+ */
+int sparse_stream_finish(struct sparse_stream *ss, const char *part_name,
+			 char *response);
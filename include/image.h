@@ -1056,6 +1056,23 @@ int bootz_setup(ulong image, ulong *start, ulong *end);
 int booti_setup(ulong image, ulong *relocated_addr, ulong *size,
 		bool force_reloc);
 
+/**
+ * booti_get_dest() - Work out where a Linux aarch64 Image will be run from
+ *
+ * This applies the same placement rules as booti_setup() to an Image header
+ * that is not necessarily at its load address yet, so that callers can copy
+ * or decompress the Image straight to its final location.
+ *
+ * @hdr: Start of the Image, at least the 64-byte header
+ * @load: Address the Image is intended to be loaded at
+ * @dest: Returns the address the Image must be placed at to boot
+ * @size: Returns the effective size of the Image
+ * @force_reloc: Ignore @load, always place the Image at the start of RAM
+ * Return: 0 if OK, -ENOEXEC if @hdr is not an aarch64 Image
+ */
+int booti_get_dest(const void *hdr, ulong load, ulong *dest, ulong *size,
+		   bool force_reloc);
+
 /*******************************************************************/
 /* New uImage format specific code (prefixed with fit_) */
 /*******************************************************************/
@@ -1081,6 +1098,7 @@ int booti_setup(ulong image, ulong *relocated_addr, ulong *size,
 #define FIT_DATA_POSITION_PROP	"data-position"
 #define FIT_DATA_OFFSET_PROP	"data-offset"
 #define FIT_DATA_SIZE_PROP	"data-size"
+#define FIT_DATA_ALIGN_PROP	"data-align"
 #define FIT_TIMESTAMP_PROP	"timestamp"
 #define FIT_DESC_PROP		"description"
 #define FIT_ARCH_PROP		"arch"
@@ -1171,6 +1189,49 @@ int fit_image_get_data_size_unciphered(const void *fit, int noffset,
 int fit_image_get_data(const void *fit, int noffset, const void **data,
 		       size_t *size);
 
+/**
+ * fit_get_data_align() - Get the alignment of the external data of a FIT
+ *
+ * mkimage records this in the 'data-align' property of the images/ node when
+ * the external data is aligned to more than 4 bytes. The FIT header and each
+ * external image then start, and are padded to end, on such a boundary.
+ *
+ * @fit: FIT to check
+ * Return: alignment in bytes, which is a power of two, 4 if not recorded
+ */
+ulong fit_get_data_align(const void *fit);
+
+/**
+ * struct fit_ext_source - where to read external data of a FIT from
+ *
+ * @read: Read @size bytes at byte position @pos of the FIT file to @buf.
+ *	Returns 0 if OK, -ve on error
+ * @priv: Private data for @read
+ */
+struct fit_ext_source {
+	int (*read)(struct fit_ext_source *src, ulong pos, ulong size,
+		    void *buf);
+	void *priv;
+};
+
+/**
+ * fit_ext_set_source() - read external data of a FIT only when it is used
+ *
+ * Only the FIT header, up to fdt_totalsize(), needs to be in memory. The
+ * external data of an image is read from @src when fit_image_get_data() is
+ * first called for it, to where it would be if the whole FIT was in memory.
+ * The source is dropped if the FIT header is changed.
+ *
+ * @fit: FIT header in memory
+ * @src: Source of the rest of the FIT, or NULL to drop it
+ */
+#if CONFIG_IS_ENABLED(FIT_EXTERNAL_READ)
+void fit_ext_set_source(const void *fit, struct fit_ext_source *src);
+#else
+static inline void fit_ext_set_source(const void *fit,
+				      struct fit_ext_source *src) {}
+#endif
+
 /**
  * fit_image_get_phase() - Get the phase from a FIT image
  *
@@ -1308,11 +1369,14 @@ struct image_summary {
  * @engine_id:	Engine to use for signing
  * @cmdname:	Command name used when reporting errors
  * @algo_name:	Algorithm name, or NULL if to be read from FIT
+ * @jobs:	Number of threads to use to calculate the hashes, 0 or 1 for none
  * @summary:	Returns information about what data was written
  *
  * Adds hash values for all component images in the FIT blob.
  * Hashes are calculated for all component images which have hash subnodes
- * with algorithm property set to one of the supported hash algorithms.
+ * with algorithm property set to one of the supported hash algorithms. The
+ * hash of an image whose data is the same as an earlier one is not
+ * calculated again.
  *
  * Also add signatures if signature nodes are present.
  *
@@ -1324,7 +1388,7 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 			      void *keydest, void *fit, const char *comment,
 			      int require_keys, const char *engine_id,
 			      const char *cmdname, const char *algo_name,
-			      struct image_summary *summary);
+			      int jobs, struct image_summary *summary);
 
 /**
  * fit_image_verify_with_data() - Verify an image with given data
@@ -1725,6 +1789,20 @@ int fit_image_check_sig(const void *fit, int noffset, const void *data,
 			size_t size, const void *key_blob, int required_keynode,
 			char **err_msgp);
 
+/**
+ * fit_image_decrypt_data() - Decipher the data of an image
+ *
+ * @fit: FIT to check
+ * @image_noffset: Offset of the image node
+ * @cipher_noffset: Offset of the cipher node in the image node
+ * @data: Ciphered data
+ * @size: Size of the ciphered data
+ * @data_unciphered: On entry, a buffer of at least @size bytes for the
+ *	deciphered data, or NULL to allocate one. On exit, the deciphered
+ *	data.
+ * @size_unciphered: Returns the size of the deciphered data
+ * Return: 0 if OK, -ve on error
+ */
 int fit_image_decrypt_data(const void *fit,
 			   int image_noffset, int cipher_noffset,
 			   const void *data, size_t size,
@@ -1820,6 +1898,7 @@ struct cipher_algo {
 	int (*add_cipher_data)(struct image_cipher_info *info,
 			       void *keydest, void *fit, int node_noffset);
 
+	/* *data is the buffer to decipher to, or NULL to allocate one */
 	int (*decrypt)(struct image_cipher_info *info,
 		       const void *cipher, size_t cipher_len,
 		       void **data, size_t *data_len);
@@ -1904,6 +1983,23 @@ int android_image_get_kernel(const void *hdr,
 int android_image_get_ramdisk(const void *hdr, const void *vendor_boot_img,
 			      ulong *rd_data, ulong *rd_len);
 
+struct andr_vendor_ramdisk_table_entry_v4;
+
+/**
+ * android_vendor_ramdisk_wanted() - Check if a vendor ramdisk is needed
+ *
+ * A v4 vendor boot image can hold several vendor ramdisks, of which only
+ * those which are needed are loaded. By default that is all of them except
+ * recovery ramdisks, which are only loaded when booting into recovery. Boards
+ * can override this to select ramdisks by their board_id, for example.
+ *
+ * @entry:	Vendor ramdisk table entry for the ramdisk
+ * @recovery:	true if booting into recovery
+ * Return: true to load the ramdisk, false to leave it out
+ */
+bool android_vendor_ramdisk_wanted(const struct andr_vendor_ramdisk_table_entry_v4 *entry,
+				   bool recovery);
+
 /**
  * android_image_get_second() - Extracts the secondary bootloader address
  * and its size
@@ -0,0 +1,20 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Helper functions for working with the builtin symbol table
+ */
+
+#ifndef __KALLSYMS_H
+#define __KALLSYMS_H
+
+/**
+ * symbol_lookup() - find the function containing an address
+ *
+ * This needs CONFIG_KALLSYMS
+ *
+ * @addr: Link-time address to look up
+ * @caddr: Returns the start address of the function, or 0 if not found
+ * Return: name of the function, or NULL if not found
+ */
+const char *symbol_lookup(unsigned long addr, unsigned long *caddr);
+
+#endif
@@ -880,6 +880,8 @@ struct nand_manufacturer_ops {
  * @jedec_params:	[INTERN] holds the JEDEC parameter page when JEDEC is
  *			supported, 0 otherwise.
  * @read_retries:	[INTERN] the number of read retry modes supported
+ * @read_retry_last:	[INTERN] the read retry mode which last gave a good
+ *			read, tried first on the next ECC failure
  * @onfi_set_features:	[REPLACEABLE] set the features for ONFI nand
  * @onfi_get_features:	[REPLACEABLE] get the features for ONFI nand
  * @setup_data_interface: [OPTIONAL] setup the data interface and timing. If
@@ -964,6 +966,7 @@ struct nand_chip {
 	struct nand_data_interface *data_interface;
 
 	int read_retries;
+	int read_retry_last;
 
 	flstate_t state;
 
@@ -315,6 +315,7 @@ enum spi_nor_option_flags {
 	SNOR_F_HAS_STACKED	= 0,
 	SNOR_F_HAS_PARALLEL	= 0,
 #endif
+	SNOR_F_4B_OPCODES	= BIT(11),
 };
 
 struct spi_nor;
@@ -552,6 +553,9 @@ struct spi_flash {
  * @octal_dtr_enable:	[FLASH-SPECIFIC] enables SPI NOR octal DTR mode.
  * @ready:		[FLASH-SPECIFIC] check if the flash is ready
  * @dirmap:		pointers to struct spi_mem_dirmap_desc for reads/writes.
+ * @read_hwcaps:	read modes supported by both the flash and the controller,
+ *			as SNOR_HWCAPS_READ_* flags
+ * @reads:		read commands of the flash, indexed by SNOR_CMD_READ_*
  * @priv:		the private data
  */
 struct spi_nor {
@@ -609,6 +613,11 @@ struct spi_nor {
 		struct spi_mem_dirmap_desc *wdesc;
 	} dirmap;
 
+#ifdef CONFIG_CMD_SF_BENCH
+	u32			read_hwcaps;
+	struct spi_nor_read_command reads[SNOR_CMD_READ_MAX];
+#endif
+
 	void *priv;
 	char mtd_name[MTD_NAME_SIZE(MTD_DEV_TYPE_NOR)];
 /* Compatibility for spi_flash, remove once sf layer is merged with mtd */
@@ -643,6 +652,20 @@ void spi_nor_setup_op(const struct spi_nor *nor,
 		      struct spi_mem_op *op,
 		      const enum spi_nor_protocol proto);
 
+/**
+ * spi_nor_set_read_mode() - Switch reads to another supported read mode
+ * @nor:	pointer to a 'struct spi_nor'
+ * @hwcaps:	the read mode to use, one SNOR_HWCAPS_READ_* flag out of
+ *		@nor->read_hwcaps
+ *
+ * This is meant for measuring the read modes against each other. Modes with
+ * a wider instruction phase than the current one need the flash to be
+ * switched to another mode first, which this function does not do.
+ *
+ * Return: 0 for success, -ENOTSUPP if the mode is not supported
+ */
+int spi_nor_set_read_mode(struct spi_nor *nor, u32 hwcaps);
+
 /**
  * spi_nor_scan() - scan the SPI NOR
  * @nor:	the spi_nor structure
@@ -308,6 +308,8 @@ struct spinand_ecc_info {
  * @op_variants.update_cache: variants of the update-cache operation
  * @select_target: function used to select a target/die. Required only for
  *		   multi-die chips
+ * @set_cont_read: enable/disable continuous cached reads. Only for chips
+ *		   that can stream several pages out of the cache
  *
  * Each SPI NAND manufacturer driver should have a spinand_info table
  * describing all the chips supported by the driver.
@@ -326,6 +328,8 @@ struct spinand_info {
 	} op_variants;
 	int (*select_target)(struct spinand_device *spinand,
 			     unsigned int target);
+	int (*set_cont_read)(struct spinand_device *spinand,
+			     bool enable);
 };
 
 #define SPINAND_ID(__method, ...)					\
@@ -351,6 +355,9 @@ struct spinand_info {
 #define SPINAND_SELECT_TARGET(__func)					\
 	.select_target = __func,
 
+#define SPINAND_CONT_READ(__set_cont_read)				\
+	.set_cont_read = __set_cont_read,
+
 #define SPINAND_INFO(__model, __id, __memorg, __eccreq, __op_variants,	\
 		     __flags, ...)					\
 	{								\
@@ -363,6 +370,14 @@ struct spinand_info {
 		__VA_ARGS__						\
 	}
 
+/**
+ * struct spinand_dirmap - SPI NAND direct mapping
+ * @rdesc: direct mapping descriptor for the read-from-cache operation
+ */
+struct spinand_dirmap {
+	struct spi_mem_dirmap_desc *rdesc;
+};
+
 /**
  * struct spinand_device - SPI NAND device instance
  * @base: NAND device instance
@@ -378,6 +393,8 @@ struct spinand_info {
  *		   a command addressing a page or an eraseblock embedded in
  *		   this die. Only required if your chip exposes several dies
  * @cur_target: currently selected target/die
+ * @dirmaps: direct mapping descriptors, one per plane. NULL when the SPI
+ *	     direct mapping API is not used
  * @eccinfo: on-die ECC information
  * @cfg_cache: config register cache. One entry per die
  * @databuf: bounce buffer for data
@@ -388,6 +405,9 @@ struct spinand_info {
  *		the stack
  * @manufacturer: SPI NAND manufacturer information
  * @priv: manufacturer private data
+ * @cont_read_possible: whether reads spanning several pages of an eraseblock
+ *			can be done as one continuous read
+ * @set_cont_read: enable/disable continuous cached reads
  */
 struct spinand_device {
 	struct nand_device base;
@@ -410,6 +430,8 @@ struct spinand_device {
 			     unsigned int target);
 	unsigned int cur_target;
 
+	struct spinand_dirmap *dirmaps;
+
 	struct spinand_ecc_info eccinfo;
 
 	u8 *cfg_cache;
@@ -418,6 +440,10 @@ struct spinand_device {
 	u8 *scratchbuf;
 	const struct spinand_manufacturer *manufacturer;
 	void *priv;
+
+	bool cont_read_possible;
+	int (*set_cont_read)(struct spinand_device *spinand,
+			     bool enable);
 };
 
 /**
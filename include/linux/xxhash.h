@@ -206,6 +206,17 @@ int xxh64_update(struct xxh64_state *state, const void *input, size_t length);
  */
 uint64_t xxh64_digest(const struct xxh64_state *state);
 
+/**
+ * xxh64_wd_buf() - calculate the xxh64 hash of a buffer, for the hash API
+ *
+ * @input:    The data to hash.
+ * @ilen:     The length of the data to hash.
+ * @output:   Returns the hash in its canonical, big-endian form (8 bytes).
+ * @chunk_sz: Trigger the watchdog after hashing this many bytes.
+ */
+void xxh64_wd_buf(const uint8_t *input, unsigned int ilen, uint8_t *output,
+		  unsigned int chunk_sz);
+
 /*-**************************
  * Utils
  ***************************/
@@ -455,4 +455,60 @@ struct abuf;
  */
 int zstd_decompress(struct abuf *in, struct abuf *out);
 
+/**
+ * struct zstd_stream - Zstandard data being decompressed as it arrives
+ *
+ * @ds:		decompression context, set up when the first data arrives
+ * @workspace:	memory holding @ds and its window
+ * @out:	output buffer, with the number of bytes written so far
+ * @max_window:	largest window size accepted, which bounds the memory used
+ * @done:	true if the data added so far ends with a complete frame
+ */
+struct zstd_stream {
+	zstd_dstream *ds;
+	void *workspace;
+	zstd_out_buffer out;
+	size_t max_window;
+	bool done;
+};
+
+/**
+ * zstd_stream_init() - Start decompressing a stream of Zstandard data
+ *
+ * The workspace is allocated when the first data is added, sized for the
+ * window recorded in the frame header. Frames needing a window larger than
+ * @max_window are rejected.
+ *
+ * @st: Stream to set up
+ * @dst: Output buffer to hold the results (must be large enough)
+ * @dst_size: Size of @dst
+ * @max_window: Largest window size to accept
+ */
+void zstd_stream_init(struct zstd_stream *st, void *dst, size_t dst_size,
+		      size_t max_window);
+
+/**
+ * zstd_stream_add() - Decompress the next part of a stream
+ *
+ * @st: Stream to add to
+ * @data: Compressed data, following on from the previous call
+ * @len: Number of bytes at @data
+ * Return: 0 if OK, -E2BIG if the window is too large, -ENOMEM if the
+ * workspace cannot be allocated, -ENOSPC if the output buffer is full,
+ * -EINVAL if the data is corrupt
+ */
+int zstd_stream_add(struct zstd_stream *st, const void *data, size_t len);
+
+/**
+ * zstd_stream_finish() - Finish decompressing a stream and free its memory
+ *
+ * This must be called once zstd_stream_init() has been called, even if
+ * zstd_stream_add() fails.
+ *
+ * @st: Stream to finish
+ * Return: size of the decompressed data, or -EINVAL if the stream ended
+ * part-way through a frame
+ */
+int zstd_stream_finish(struct zstd_stream *st);
+
 #endif  /* LINUX_ZSTD_H */
@@ -13,6 +13,7 @@
 #include <linker_lists.h>
 #include <dm/uclass-id.h>
 #include <linux/bitops.h>
+#include <linux/errno.h>
 #include <linux/list.h>
 
 struct cmd_tbl;
@@ -673,6 +674,23 @@ static inline int log_init(void)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(LOG_RINGBUF)
+/**
+ * log_ringbuf_dump() - Print the messages held in the log ring buffer
+ *
+ * Each line is prefixed with the time since boot, its level and category.
+ *
+ * @clear: true to remove the messages from the ring once printed
+ * Return: 0 if OK, -ENOENT if there is no ring buffer
+ */
+int log_ringbuf_dump(bool clear);
+#else
+static inline int log_ringbuf_dump(bool clear)
+{
+	return -ENOENT;
+}
+#endif
+
 /**
  * log_get_default_format() - get default log format
  *
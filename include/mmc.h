@@ -75,6 +75,7 @@ struct bd_info;
 #define MMC_MODE_SPI		BIT(27)
 
 #define SD_DATA_4BIT	0x00040000
+#define SD_SCR_CMD23_SUPPORT	BIT(1)
 
 #define IS_SD(x)	((x)->version & SD_VERSION_SD)
 #define IS_MMC(x)	((x)->version & MMC_VERSION_MMC)
@@ -221,6 +222,7 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_BOOT_WP			173	/* R/W & R/W/C_P */
 #define EXT_CSD_BOOT_WP_STATUS		174	/* R */
 #define EXT_CSD_ERASE_GROUP_DEF		175	/* R/W */
+#define EXT_CSD_ERASED_MEM_CONT		181	/* RO */
 #define EXT_CSD_BOOT_BUS_WIDTH		177
 #define EXT_CSD_PART_CONF		179	/* R/W */
 #define EXT_CSD_BUS_WIDTH		183	/* R/W */
@@ -601,6 +603,7 @@ struct mmc_config {
 	const char *name;
 #if !CONFIG_IS_ENABLED(DM_MMC)
 	const struct mmc_ops *ops;
+	ulong reg;	/* controller address, to hand the card to U-Boot */
 #endif
 	uint host_caps;
 	uint voltages;
@@ -678,6 +681,19 @@ static inline bool supports_uhs(uint caps)
  *
  * TODO struct mmc should be in mmc_private but it's hard to fix right now
  */
+/**
+ * struct mmc_stats - command statistics of an MMC device
+ *
+ * @cmds: Number of commands sent, including repeated ones
+ * @cmd_errors: Number of commands which failed
+ * @retries: Number of commands repeated after an error
+ */
+struct mmc_stats {
+	ulong cmds;
+	ulong cmd_errors;
+	ulong retries;
+};
+
 struct mmc {
 #if !CONFIG_IS_ENABLED(BLK)
 	struct list_head link;
@@ -756,8 +772,12 @@ struct mmc {
 	u32 quirks;
 	bool tuning:1;
 	bool hs400_tuning:1;
+	bool handed_off:1;	/* card taken over from SPL, not identified */
 
 	enum bus_mode user_speed_mode; /* input speed mode from user */
+#if CONFIG_IS_ENABLED(BLK_STATS)
+	struct mmc_stats stats;
+#endif
 
 	CONFIG_IS_ENABLED(CYCLIC, (struct cyclic_info cyclic));
 };
@@ -820,6 +840,18 @@ int mmc_send_tuning(struct mmc *mmc, u32 opcode);
 int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data);
 int mmc_deinit(struct mmc *mmc);
 
+/**
+ * mmc_handoff_save() - Record a card which is ready for use, for U-Boot proper
+ *
+ * This is called by SPL once it has loaded U-Boot from a card. If U-Boot
+ * proper finds the card still in the transfer state, it uses it as it is
+ * without power-cycling and identifying it again. Only cards in a mode which
+ * needs no tuning or voltage switch are recorded. This needs MMC_HANDOFF.
+ *
+ * @mmc:	MMC device
+ */
+void mmc_handoff_save(struct mmc *mmc);
+
 /**
  * mmc_of_parse() - Parse the device tree to get the capabilities of the host
  *
@@ -97,6 +97,19 @@ void ndisc_request(void);
  * Return: 0 if no timeout, -1 otherwise
  */
 int ndisc_timeout_check(void);
+
+/**
+ * ndisc_cache_lookup() - Look up the Ethernet address to send a packet to
+ *
+ * This finds the address of the next hop to @dest, which is the gateway if
+ * @dest is not on our subnet, if it was found by neighbour discovery in the
+ * last minute.
+ *
+ * @dest:	IPv6 address the packet is for
+ * @ethaddr:	Returns the Ethernet address, if found
+ * Return: true if found, false if neighbour discovery is needed
+ */
+bool ndisc_cache_lookup(struct in6_addr *dest, uchar *ethaddr);
 bool validate_ra(struct ip6_hdr *ip6);
 int process_ra(struct ip6_hdr *ip6, int len);
 #else
@@ -119,6 +132,11 @@ static inline int ndisc_timeout_check(void)
 	return 0;
 }
 
+static inline bool ndisc_cache_lookup(struct in6_addr *dest, uchar *ethaddr)
+{
+	return false;
+}
+
 static inline void ip6_send_rs(void)
 {
 }
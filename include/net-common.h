@@ -9,6 +9,7 @@
 #include <hexdump.h>
 #include <linux/if_ether.h>
 #include <linux/sizes.h>
+#include <linux/string.h>
 #include <linux/types.h>
 #include <rand.h>
 #include <time.h>
@@ -243,6 +244,29 @@ enum eth_recv_flags {
 	ETH_RECV_CHECK_DEVICE		= 1 << 0,
 };
 
+/**
+ * struct eth_rx_dest - Final address of the payload of coming frames
+ *
+ * A protocol that knows where the data of the next frames it expects goes,
+ * such as TFTP, can have a driver receive it there rather than copying it
+ * out of the driver's buffers. Frame n after the one expected next carries
+ * the payload for @addr + n * @len.
+ *
+ * @addr: Address of the payload of the frame expected next
+ * @end: End of the memory the driver may write to
+ * @len: Payload bytes in each frame
+ * @hdr_len: Bytes of headers in front of the payload, from the Ethernet
+ *	header on
+ * @port: UDP destination port of the frames
+ */
+struct eth_rx_dest {
+	ulong addr;
+	ulong end;
+	uint len;
+	uint hdr_len;
+	u16 port;
+};
+
 /**
  * struct eth_ops - functions of Ethernet MAC controllers
  *
@@ -272,6 +296,11 @@ enum eth_recv_flags {
  * get_sset_count: Number of statistics counters
  * get_string: Names of the statistic counters
  * get_stats: The values of the statistic counters
+ * set_rx_dest: Receive the payload of the coming frames straight to the
+ *		memory described by the eth_rx_dest, or go back to the
+ *		driver's own buffers if it is NULL. Only called when the
+ *		receive ring is empty and the stack holds no packet. See
+ *		eth_rx_dest_next() and eth_rx_placed() - optional
  */
 struct eth_ops {
 	int (*start)(struct udevice *dev);
@@ -286,10 +315,119 @@ struct eth_ops {
 	int (*get_sset_count)(struct udevice *dev);
 	void (*get_strings)(struct udevice *dev, u8 *data);
 	void (*get_stats)(struct udevice *dev, u64 *data);
+	int (*set_rx_dest)(struct udevice *dev,
+			   const struct eth_rx_dest *dest);
 };
 
 #define eth_get_ops(dev) ((struct eth_ops *)(dev)->driver->ops)
 
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+/**
+ * eth_set_rx_dest() - Ask for the payload of coming frames to be received
+ *		       in place
+ *
+ * The request replaces any earlier one. It takes effect once the frames
+ * already received have been processed.
+ *
+ * @dest: Where the payload goes, NULL to stop
+ */
+void eth_set_rx_dest(const struct eth_rx_dest *dest);
+
+/**
+ * eth_rx_check() - Check if payload can be stored where it belongs
+ *
+ * While frames are received in place, a frame that did not land where its
+ * payload belongs (because the frames did not come in the expected order)
+ * cannot be copied safely and must be dropped. The caller should then post
+ * a new eth_rx_dest for the frame it expects next.
+ *
+ * @dst: Final address of the payload
+ * @src: Payload in the packet being processed
+ * Return: 0 if eth_rx_store() can store it, -EAGAIN if it must be dropped
+ */
+int eth_rx_check(const void *dst, const void *src);
+
+/**
+ * eth_rx_store() - Store payload of the packet being processed
+ *
+ * This copies the payload, or only the part that is not in place yet when
+ * the driver received it at @dst.
+ *
+ * @dst: Final address of the payload
+ * @src: Payload in the packet being processed
+ * @len: Number of bytes
+ * Return: 0 if OK, -EAGAIN if the packet must be dropped, see eth_rx_check()
+ */
+int eth_rx_store(void *dst, const void *src, uint len);
+
+/**
+ * eth_rx_dest_next() - Get the address for the next frame
+ *
+ * Drivers call this when they give a buffer to the hardware, in the order
+ * the hardware fills them. The first @head bytes of the frame go to the
+ * driver's own buffer, the rest goes to @addr.
+ *
+ * @dev: Ethernet device
+ * @head: Bytes taken by the driver's buffer, at least the header length
+ * @size: Size of the buffer at @addr
+ * @addr: Returns the address for the rest of the frame
+ * Return: 0 if OK, -ENOSPC if the frame must go to the driver's buffer
+ */
+int eth_rx_dest_next(struct udevice *dev, uint head, uint size, ulong *addr);
+
+/**
+ * eth_rx_placed() - Tell that a frame was received in place
+ *
+ * Drivers call this from recv() for a frame split by eth_rx_dest_next().
+ * Frames for another flow are copied back behind the head, so @pkt must
+ * have room for the whole frame.
+ *
+ * @dev: Ethernet device
+ * @pkt: The first @head bytes of the frame
+ * @head: Bytes of the frame in @pkt
+ * @addr: Where the rest of the frame is
+ */
+void eth_rx_placed(struct udevice *dev, uchar *pkt, uint head, ulong addr);
+#else
+static inline void eth_set_rx_dest(const struct eth_rx_dest *dest)
+{
+}
+
+static inline int eth_rx_check(const void *dst, const void *src)
+{
+	return 0;
+}
+
+static inline int eth_rx_store(void *dst, const void *src, uint len)
+{
+	memcpy(dst, src, len);
+
+	return 0;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(ETH_RX_CSUM_OFFLOAD)
+/* true if the controller checked the checksums of the packet being handled */
+extern bool net_rx_csum_ok;
+
+/**
+ * eth_rx_csum_verified() - Tell that the controller checked the checksums
+ *
+ * Drivers call this from recv() when the controller found the IPv4 header
+ * checksum and the TCP or UDP checksum of the frame good, so that they are
+ * not checked again. Frames without the call are checked in software.
+ *
+ * @dev: Ethernet device
+ */
+void eth_rx_csum_verified(struct udevice *dev);
+#else
+#define net_rx_csum_ok	false
+
+static inline void eth_rx_csum_verified(struct udevice *dev)
+{
+}
+#endif
+
 struct udevice *eth_get_dev(void); /* get the current device */
 unsigned char *eth_get_ethaddr(void); /* get the current device MAC */
 int eth_rx(void);                      /* Check for received packets */
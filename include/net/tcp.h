@@ -87,6 +87,7 @@ struct ip_tcp_hdr {
 #define TCP_OPT_LEN_A	0x0a		/* Timestamp Length		*/
 #define TCP_MSS		1460		/* Max segment size		*/
 #define TCP_SCALE	0x01		/* Scale			*/
+#define TCP_SCALE_MAX	14		/* Largest scale, RFC 7323	*/
 
 /**
  * struct tcp_mss - TCP option structure for MSS (Max segment size)
@@ -357,6 +358,7 @@ enum tcp_status {
  * @loc_timestamp:	Local timestamp
  * @rmt_timestamp:	Remote timestamp
  *
+ * @loc_win_scale:	Local window scale factor
  * @rmt_win_scale:	Remote window scale factor
  *
  * @lost:		Used for SACK
@@ -419,6 +421,7 @@ struct tcp_stream {
 	u32		rmt_timestamp;
 
 	/* TCP window scale */
+	u8		loc_win_scale;
 	u8		rmt_win_scale;
 
 	/* TCP sliding window control used to request re-TX */
@@ -495,6 +498,19 @@ void tcp_stream_put(struct tcp_stream *tcp);
  */
 void tcp_stream_restart_rx_timer(struct tcp_stream *tcp);
 
+/*
+ * tcp_stream_set_rcv_wnd -- Set the receive window offered to the remote
+ *                           side, e.g. to the room left at the destination
+ *                           of the data. The size is clamped to
+ *                           CONFIG_PROT_TCP_RCV_WND. Call it from the
+ *                           on_create() handler, before the window scale
+ *                           is agreed at connection setup.
+ *
+ * @tcp:	TCP stream
+ * @size:	receive window in bytes
+ */
+void tcp_stream_set_rcv_wnd(struct tcp_stream *tcp, u32 size);
+
 enum tcp_state  tcp_stream_get_state(struct tcp_stream *tcp);
 enum tcp_status tcp_stream_get_status(struct tcp_stream *tcp);
 
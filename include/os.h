@@ -478,6 +478,19 @@ int os_read_file(const char *name, void **bufp, int *sizep);
  */
 int os_map_file(const char *pathname, int os_flags, void **bufp, int *sizep);
 
+/**
+ * os_map_fd() - Map an open host file into memory
+ *
+ * Changes made through the mapping are written back to the file
+ *
+ * @fd:		File descriptor, open with @os_flags
+ * @os_flags:	Flags the file was opened with: OS_O_RDONLY or OS_O_RDWR
+ * @size:	Number of bytes to map, from the start of the file
+ * @bufp:	Returns the mapped address
+ * Return:	0 if OK, -ve on error
+ */
+int os_map_fd(int fd, int os_flags, int size, void **bufp);
+
 /**
  * os_unmap() - Unmap a file previously mapped
  *
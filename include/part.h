@@ -436,6 +436,30 @@ ulong disk_blk_write(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
  */
 ulong disk_blk_erase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt);
 
+/**
+ * disk_blk_map() - get a pointer to blocks of a partition held in memory
+ *
+ * See blk_map()
+ *
+ * @dev:	Device to map (UCLASS_PARTITION)
+ * @start:	First block to map in the partition (0=first)
+ * @blkcnt:	Number of blocks to map
+ * Return:	pointer to the data, or NULL if it must be read instead
+ */
+const void *disk_blk_map(struct udevice *dev, lbaint_t start, lbaint_t blkcnt);
+
+struct blk_req;
+/**
+ * disk_blk_submit() - queue an asynchronous request on a disk partition
+ *
+ * @dev:	Device to access (UCLASS_PARTITION)
+ * @req:	Request, with @req->start relative to the partition. On
+ *		success it is converted to an absolute block number and the
+ *		request must be completed with blk_wait() on the parent of @dev
+ * Return:	0 if OK, -ve on error (the request was not queued)
+ */
+int disk_blk_submit(struct udevice *dev, struct blk_req *req);
+
 /*
  * We don't support printing partition information in SPL and only support
  * getting partition information in a few cases.
@@ -489,6 +513,19 @@ struct part_driver {
 	 * -ve if not
 	 */
 	int (*test)(struct blk_desc *desc);
+
+	/**
+	 * @invalidate:		Drop cached partition-table data after a write
+	 *
+	 * This is optional, for drivers which keep the table they read
+	 *
+	 * @invalidate.desc:	Block device descriptor
+	 * @invalidate.start:	First block written
+	 * @invalidate.blkcnt:	Number of blocks written, or 0 to drop all
+	 *			data cached for the device
+	 */
+	void (*invalidate)(struct blk_desc *desc, lbaint_t start,
+			   lbaint_t blkcnt);
 };
 
 /* Declare a new U-Boot partition 'driver' */
@@ -707,4 +744,24 @@ static inline bool part_get_bootable(struct blk_desc *desc)
 
 #endif /* CONFIG_PARTITIONS */
 
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+/**
+ * part_cache_invalidate() - Drop cached partition tables affected by a write
+ *
+ * The partition drivers keep the tables they have read and validated. This
+ * must be called when blocks of the device are written or erased, or when
+ * the medium may have changed.
+ *
+ * @desc:	Block-device descriptor
+ * @start:	First block written
+ * @blkcnt:	Number of blocks written, or 0 to drop all tables cached for
+ *		the device
+ */
+void part_cache_invalidate(struct blk_desc *desc, lbaint_t start,
+			   lbaint_t blkcnt);
+#else
+static inline void part_cache_invalidate(struct blk_desc *desc,
+					 lbaint_t start, lbaint_t blkcnt) {}
+#endif
+
 #endif /* _PART_H */
@@ -145,6 +145,10 @@ struct phy_device {
 
 	/* The most recently read link state */
 	int link;
+	/* get_timer() value when autonegotiation was last restarted */
+	ulong aneg_start;
+	/* true if @aneg_start is set and completion has not been seen since */
+	bool aneg_pending;
 	int port;
 	phy_interface_t interface;
 
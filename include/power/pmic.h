@@ -151,6 +151,17 @@ struct pmic {
  * - 'drivers/power/pmic/max77686.c'
  */
 
+/**
+ * struct pmic_reg_val - a register value to write, for pmic_write_regs()
+ *
+ * @reg:	Register to write
+ * @val:	Value to write, of the PMIC's transfer length
+ */
+struct pmic_reg_val {
+	uint reg;
+	uint val;
+};
+
 /**
  * struct dm_pmic_ops - PMIC device I/O interface
  *
@@ -160,12 +171,16 @@ struct pmic {
  * @reg_count: device's register count
  * @read:      read 'len' bytes at "reg" and store it into the 'buffer'
  * @write:     write 'len' bytes from the 'buffer' to the register at 'reg' address
+ * @write_regs: write 'count' registers, in order, in as few bus transactions
+ *		as possible (optional, see pmic_i2c_write_regs())
  */
 struct dm_pmic_ops {
 	int (*reg_count)(struct udevice *dev);
 	int (*read)(struct udevice *dev, uint reg, uint8_t *buffer, int len);
 	int (*write)(struct udevice *dev, uint reg, const uint8_t *buffer,
 		     int len);
+	int (*write_regs)(struct udevice *dev,
+			  const struct pmic_reg_val *regs, int count);
 };
 
 /**
@@ -285,6 +300,36 @@ int pmic_reg_read(struct udevice *dev, uint reg);
  */
 int pmic_reg_write(struct udevice *dev, uint reg, uint value);
 
+/**
+ * pmic_write_regs() - write a list of PMIC register values
+ *
+ * The registers are written in order. If the driver supports it, this is done
+ * in a few bus transactions rather than one for each register, which saves
+ * time when setting up many regulators.
+ *
+ * @dev:	PMIC device to write
+ * @regs:	Registers and values to write
+ * @count:	Number of entries in @regs
+ * Return: 0 on success or negative value of errno.
+ */
+int pmic_write_regs(struct udevice *dev, const struct pmic_reg_val *regs,
+		    int count);
+
+/**
+ * pmic_i2c_write_regs() - write_regs() method for PMICs on an I2C bus
+ *
+ * This sends one message for each register, with repeated starts between
+ * them. If the bus cannot handle that, the registers are written one at a
+ * time instead.
+ *
+ * @dev:	PMIC device to write, whose parent is an I2C bus
+ * @regs:	Registers and values to write
+ * @count:	Number of entries in @regs
+ * Return: 0 on success or negative value of errno.
+ */
+int pmic_i2c_write_regs(struct udevice *dev, const struct pmic_reg_val *regs,
+			int count);
+
 /**
  * pmic_clrsetbits() - clear and set bits in a PMIC register
  *
@@ -110,6 +110,9 @@ typedef int (*pxe_getfile_func)(struct pxe_context *ctx, const char *file_path,
  * @use_ipv6: TRUE : use IPv6 addressing, FALSE : use IPv4 addressing
  * @use_fallback: TRUE : use "fallback" option as default, FALSE : use
  *	"default" option as default
+ * @cache: true to keep the config files which are read, so that they need not
+ *	be fetched again by a later retry with the same network setup (see
+ *	CONFIG_PXE_CACHE)
  */
 struct pxe_context {
 	struct cmd_tbl *cmdtp;
@@ -131,6 +134,7 @@ struct pxe_context {
 	ulong pxe_file_size;
 	bool use_ipv6;
 	bool use_fallback;
+	bool cache;
 };
 
 /**
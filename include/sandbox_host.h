@@ -14,11 +14,21 @@
  * @label: Label for this device (allocated)
  * @filename: Name of file this is attached to, or NULL (allocated)
  * @fd: File descriptor of file, or 0 for none (file is not open)
+ * @read_only: true if the file could only be opened read-only
+ * @map: The file mapped into memory, or NULL if it is accessed through @fd
+ * @size: Size of the file in bytes
+ * @latency_us: Time added to each transfer, in microseconds
+ * @bandwidth: Rate at which transfers are slowed to, in MB/s, or 0 for none
  */
 struct host_sb_plat {
 	char *label;
 	char *filename;
 	int fd;
+	bool read_only;
+	void *map;
+	off_t size;
+	uint latency_us;
+	uint bandwidth;
 };
 
 /**
@@ -96,6 +106,19 @@ int host_create_attach_file(const char *label, const char *filename,
 			    bool removable, unsigned long blksz,
 			    struct udevice **devp);
 
+/**
+ * host_set_timing() - Make transfers take as long as on a real device
+ *
+ * Each transfer takes @latency_us plus the time to move its data at
+ * @bandwidth. For example, an SD card may be modelled with 1000us and
+ * 20MB/s, eMMC with 200us and 150MB/s and NVMe with 20us and 2000MB/s.
+ *
+ * @dev: Host device to update
+ * @latency_us: Time added to each transfer, in microseconds
+ * @bandwidth: Transfer rate in MB/s, or 0 for no limit
+ */
+void host_set_timing(struct udevice *dev, uint latency_us, uint bandwidth);
+
 /**
  * host_find_by_label() - Find a host by label
  *
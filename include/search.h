@@ -47,6 +47,14 @@ struct hsearch_data {
 	struct env_entry_node *table;
 	unsigned int size;
 	unsigned int filled;
+	/* Copy of a bulk-imported environment, which entries may point into */
+	char *bulk;
+	/* Non-zero while entries are in use, so the table must not grow */
+	int busy;
+	/* Statistics: calls to hsearch_r(), slots probed and keys compared */
+	unsigned long lookups;
+	unsigned long probes;
+	unsigned long compares;
 /*
  * Callback function which will check whether the given change for variable
  * "item" to "newval" may be applied or not, and possibly apply such change.
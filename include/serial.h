@@ -1,6 +1,7 @@
 #ifndef __SERIAL_H__
 #define __SERIAL_H__
 
+#include <cyclic.h>
 #include <post.h>
 
 struct serial_device {
@@ -295,6 +296,13 @@ struct dm_serial_ops {
  * @buf:	Pointer to the RX buffer
  * @rd_ptr:	Read pointer in the RX buffer
  * @wr_ptr:	Write pointer in the RX buffer
+ *
+ * @dev:	Device this belongs to, for the cyclic function
+ * @tx_buf:	TX buffer, or NULL if output is not buffered
+ * @tx_rd:	Read pointer in the TX buffer
+ * @tx_wr:	Write pointer in the TX buffer
+ * @tx_busy:	True while the TX buffer is being sent to the UART
+ * @tx_cyclic:	Cyclic function which sends the TX buffer
  */
 struct serial_dev_priv {
 	struct stdio_dev *sdev;
@@ -304,6 +312,14 @@ struct serial_dev_priv {
 	uint rd_ptr;
 	uint wr_ptr;
 #endif
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	struct udevice *dev;
+	char *tx_buf;
+	uint tx_rd;
+	uint tx_wr;
+	bool tx_busy;
+	struct cyclic_info tx_cyclic;
+#endif
 };
 
 /* Access the serial operations for a device */
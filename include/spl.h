@@ -344,6 +344,8 @@ typedef ulong (*spl_load_reader)(struct spl_load_info *load, ulong sector,
  * @read: Function to call to read from the device
  * @priv: Private data for the device
  * @bl_len: Block length for reading in bytes
+ * @chunk_size: Preferred number of bytes per read for chunked reads, 0 for
+ *		CONFIG_SPL_LOAD_CHUNK_SIZE
  * @phase: Image phase to load
  * @no_fdt_update: true to update the FDT with any loadables that are loaded
  */
@@ -353,6 +355,9 @@ struct spl_load_info {
 #if IS_ENABLED(CONFIG_SPL_LOAD_BLOCK)
 	u16 bl_len;
 #endif
+#if IS_ENABLED(CONFIG_SPL_LOAD_CHUNK)
+	u32 chunk_size;
+#endif
 #if CONFIG_IS_ENABLED(BOOTMETH_VBE)
 	u8 phase;
 	u8 fdt_update;
@@ -378,6 +383,30 @@ static inline void spl_set_bl_len(struct spl_load_info *info, int bl_len)
 #endif
 }
 
+static inline void spl_set_chunk_size(struct spl_load_info *info,
+				      ulong chunk_size)
+{
+#if IS_ENABLED(CONFIG_SPL_LOAD_CHUNK)
+	info->chunk_size = chunk_size;
+#endif
+}
+
+/**
+ * spl_get_chunk_size() - Get the number of bytes per read for chunked reads
+ *
+ * @info: Device to read from
+ * Return: chunk size, rounded up to the block length of the device
+ */
+static inline ulong spl_get_chunk_size(struct spl_load_info *info)
+{
+	ulong chunk_size = 0;
+
+#if IS_ENABLED(CONFIG_SPL_LOAD_CHUNK)
+	chunk_size = info->chunk_size ?: CONFIG_SPL_LOAD_CHUNK_SIZE;
+#endif
+	return ALIGN(chunk_size, spl_get_bl_len(info));
+}
+
 static inline void xpl_set_phase(struct spl_load_info *info,
 				 enum image_phase_t phase)
 {
@@ -422,10 +451,64 @@ static inline void spl_load_init(struct spl_load_info *load,
 	load->read = h_read;
 	load->priv = priv;
 	spl_set_bl_len(load, bl_len);
+	spl_set_chunk_size(load, 0);
 	xpl_set_phase(load, IH_PHASE_NONE);
 	xpl_set_fdt_update(load, true);
 }
 
+/**
+ * struct spl_load_chunk - Iterator reading a device range chunk by chunk
+ *
+ * @info: Device to read from
+ * @read_offset: Device offset of the next read, a multiple of the block length
+ * @skip: Bytes at the start of the next read which precede the range
+ * @left: Bytes of the range which have not been returned yet
+ * @buf: Where the next chunk is read to
+ * @chunk: Bytes per read, a multiple of the block length
+ * @reuse: true if every chunk is read to the start of @buf, false if the
+ *	   range is read to @buf contiguously
+ */
+struct spl_load_chunk {
+	struct spl_load_info *info;
+	ulong read_offset;
+	ulong skip;
+	ulong left;
+	void *buf;
+	ulong chunk;
+	bool reuse;
+};
+
+/**
+ * spl_load_chunk_init() - Start reading a range of a device in chunks
+ *
+ * If @buf_size can hold the whole block-aligned range, the range is read to
+ * @buf contiguously and the data ends up at @buf plus the misalignment of
+ * @offset. Otherwise @buf is used as a bounce buffer and each chunk
+ * overwrites the previous one.
+ *
+ * @it: Iterator to set up
+ * @info: Device to read from
+ * @offset: Device offset of the range in bytes, need not be aligned
+ * @size: Size of the range in bytes
+ * @buf: Buffer to read to, must be suitably aligned for the device
+ * @buf_size: Size of @buf in bytes
+ * Return: 0 on success, -ENOBUFS if @buf_size is smaller than a block
+ */
+int spl_load_chunk_init(struct spl_load_chunk *it, struct spl_load_info *info,
+			ulong offset, ulong size, void *buf, ulong buf_size);
+
+/**
+ * spl_load_chunk_next() - Read the next chunk of a range
+ *
+ * @it: Iterator set up by spl_load_chunk_init()
+ * @datap: Returns a pointer to the data of this chunk
+ * @lenp: Returns the number of bytes at @datap
+ * Return: 1 if a chunk was read, 0 once the whole range has been returned,
+ * -EIO on a read error
+ */
+int spl_load_chunk_next(struct spl_load_chunk *it, const void **datap,
+			ulong *lenp);
+
 /*
  * We need to know the position of U-Boot in memory so we can jump to it. We
  * allow any U-Boot binary to be used (u-boot.bin, u-boot-nodtb.bin,
@@ -1165,7 +1248,8 @@ int spl_load_fit_image(struct spl_image_info *spl_image,
  */
 static inline bool spl_decompression_enabled(void)
 {
-	return IS_ENABLED(CONFIG_SPL_GZIP) || IS_ENABLED(CONFIG_SPL_LZMA);
+	return IS_ENABLED(CONFIG_SPL_GZIP) || IS_ENABLED(CONFIG_SPL_LZMA) ||
+		IS_ENABLED(CONFIG_SPL_ZSTD) || IS_ENABLED(CONFIG_SPL_LZ4);
 }
 
 /**
@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Performance benchmarks, run with 'ut bench'
+ */
+
+#ifndef __TEST_BENCH_H__
+#define __TEST_BENCH_H__
+
+#include <test/test.h>
+
+/* Declare a new benchmark */
+#define BENCH_TEST(_name, _flags)	UNIT_TEST(_name, _flags, bench)
+
+/**
+ * bench_report() - Print the result of a benchmark
+ *
+ * The result is printed on a line of its own, so that it can be picked up by
+ * test/py/tests/test_bench.py or a CI system:
+ *
+ *	bench: name=<name> <unit>=<count> us=<time> rate=<count per second>
+ *
+ * @name: Name of what was measured, e.g. "sha256"
+ * @unit: Unit of @count, e.g. "bytes" or "devices"
+ * @count: Amount of work done
+ * @us: Time taken in microseconds
+ */
+void bench_report(const char *name, const char *unit, u64 count, ulong us);
+
+#endif /* __TEST_BENCH_H__ */
@@ -65,8 +65,12 @@ enum tpm_version {
  * @pcr_select_min:	Minimum size in bytes of the pcrSelect array
  * @active_bank_count:	Number of active PCR banks
  * @active_banks:	Array of active PCRs
+ * @banks_checked:	All active PCR banks have been found to be supported,
+ *			so there is no need to check again before an extend
  * @plat_hier_disabled:	Platform hierarchy has been disabled (TPM is locked
  *			down until next reboot)
+ * @xfer_count:		Number of commands sent to the TPM
+ * @xfer_us:		Total time taken by those commands, in microseconds
  */
 struct tpm_chip_priv {
 	enum tpm_version version;
@@ -81,8 +85,11 @@ struct tpm_chip_priv {
 #if IS_ENABLED(CONFIG_TPM_V2)
 	u8 active_bank_count;
 	u32 active_banks[TPM2_NUM_PCR_BANKS];
+	bool banks_checked;
 #endif
 	bool plat_hier_disabled;
+	uint xfer_count;
+	ulong xfer_us;
 };
 
 /**
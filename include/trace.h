@@ -34,6 +34,7 @@ enum {
 enum trace_chunk_type {
 	TRACE_CHUNK_FUNCS,
 	TRACE_CHUNK_CALLS,
+	TRACE_CHUNK_SAMPLES,
 };
 
 /* A trace record for a function, as written to the profile output file */
@@ -89,6 +90,31 @@ struct trace_call {
 
 int trace_list_calls(void *buff, size_t buff_size, size_t *needed);
 
+/*
+ * A node of the tree of sampled call stacks, as written to the profile output
+ * file. Node 0 is the root, which has no function. Every other node is a call
+ * from the function of its parent node.
+ */
+struct trace_output_sample {
+	uint32_t func;		/* Function offset, or ~0 for the root */
+	uint32_t parent;	/* Index of parent node, or ~0 for the root */
+	uint32_t count;		/* Number of samples of exactly this stack */
+	uint32_t time_us;	/* Microseconds those samples stand for */
+};
+
+/**
+ * Dump the tree of sampled call stacks into a buffer
+ *
+ * This is only available with CONFIG_TRACE_SAMPLE. Each record in the buffer
+ * is a struct trace_output_sample, parents before their children.
+ *
+ * @param buff		Buffer in which to place data, or NULL to count size
+ * @param buff_size	Size of buffer
+ * @param needed	Returns number of bytes used / needed
+ * Return: 0 if ok, -ENOSPC if space was exhausted
+ */
+int trace_list_samples(void *buff, size_t buff_size, size_t *needed);
+
 /**
  * Turn function tracing on and off
  *
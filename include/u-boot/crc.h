@@ -88,6 +88,40 @@ uint32_t crc32_wd(uint32_t crc, const unsigned char *buf, uint len,
  */
 uint32_t crc32_no_comp(uint32_t crc, const unsigned char *buf, uint len);
 
+/**
+ * crc32_no_comp_table() - crc32_no_comp() using the lookup table
+ *
+ * This is the portable implementation. It is not built if the CRC32
+ * instructions are used unconditionally (ARM64_CRC32 without
+ * ARM64_CRC32_DETECT).
+ *
+ * @crc: Input crc to chain from a previous calculution
+ * @buf: Bytes to checksum
+ * @len: Number of bytes to checksum
+ * Return: checksum value
+ */
+uint32_t crc32_no_comp_table(uint32_t crc, const unsigned char *buf, uint len);
+
+/**
+ * crc32_no_comp_hw() - crc32_no_comp() using the CPU's CRC32 instructions
+ *
+ * This is only available with ARM64_CRC32 and must only be called if
+ * crc32_hw_available() returns true.
+ *
+ * @crc: Input crc to chain from a previous calculution
+ * @buf: Bytes to checksum
+ * @len: Number of bytes to checksum
+ * Return: checksum value
+ */
+uint32_t crc32_no_comp_hw(uint32_t crc, const unsigned char *buf, uint len);
+
+/**
+ * crc32_hw_available() - Check whether the CPU has CRC32 instructions
+ *
+ * Return: true if crc32_no_comp_hw() and crc32c_cal_hw() can be used
+ */
+bool crc32_hw_available(void);
+
 /**
  * crc32_wd_buf - Perform CRC32 on a buffer and return result in buffer
  *
@@ -126,4 +160,30 @@ void crc32c_init(uint32_t *crc32c_table, uint32_t pol);
 uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 		    uint32_t *crc32c_table);
 
+/**
+ * crc32c_cal_table() - crc32c_cal() without the CRC32C instructions
+ *
+ * @crc: Previous crc (use 0 at start)
+ * @data: Data bytes to checksum
+ * @length: Number of bytes to process
+ * @crc32c_table:: CRC table
+ * Return: checksum value
+ */
+uint32_t crc32c_cal_table(uint32_t crc, const char *data, int length,
+			  uint32_t *crc32c_table);
+
+/**
+ * crc32c_cal_hw() - Perform CRC32C using the CPU's CRC32C instructions
+ *
+ * This is only available with ARM64_CRC32 and must only be called if
+ * crc32_hw_available() returns true. crc32c_cal() uses it automatically for
+ * tables set up with the Castagnoli polynomial.
+ *
+ * @crc: Previous crc (use 0 at start)
+ * @data: Data bytes to checksum
+ * @length: Number of bytes to process
+ * Return: checksum value
+ */
+uint32_t crc32c_cal_hw(uint32_t crc, const char *data, int length);
+
 #endif /* _UBOOT_CRC_H */
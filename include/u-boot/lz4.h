@@ -6,6 +6,8 @@
 #ifndef __LZ4_H
 #define __LZ4_H
 
+#include <linux/types.h>
+
 /**
  * ulz4fn() - Decompress LZ4 data
  *
@@ -21,6 +23,74 @@
  */
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
+/**
+ * struct ulz4_stream - LZ4 frame being decompressed as it arrives
+ *
+ * @start: Start of the output buffer
+ * @out: Where the next block is written
+ * @end: End of the output buffer
+ * @buf: Staging buffer for a block split across calls, or NULL
+ * @hdr: Staging buffer for other items split across calls
+ * @need: Size of the item being read
+ * @have: Number of bytes of it staged so far
+ * @max_block: Maximum block size from the frame header
+ * @block_header: Header of the block being read
+ * @state: Which part of the frame is being read
+ * @block_checksum: true if each block is followed by a checksum
+ */
+struct ulz4_stream {
+	void *start;
+	void *out;
+	void *end;
+	u8 *buf;
+	u8 hdr[9];
+	size_t need;
+	size_t have;
+	size_t max_block;
+	u32 block_header;
+	int state;
+	bool block_checksum;
+};
+
+/**
+ * ulz4_stream_init() - Start decompressing an LZ4 frame piece by piece
+ *
+ * Each block is decompressed as soon as all of it has been added. A block
+ * which is split between calls is staged in a buffer of the maximum block
+ * size given in the frame header, so frames made with a small block size
+ * (e.g. 'lz4 -B4') need less memory.
+ *
+ * @st: Stream to set up
+ * @dst: Destination for uncompressed data
+ * @dstn: Size of @dst
+ */
+void ulz4_stream_init(struct ulz4_stream *st, void *dst, size_t dstn);
+
+/**
+ * ulz4_stream_add() - Decompress the next part of an LZ4 frame
+ *
+ * Any data after the end of the frame is ignored.
+ *
+ * @st: Stream to add to
+ * @data: Compressed data, following on from the previous call
+ * @len: Number of bytes at @data
+ * Return: 0 if OK, -ENOMEM if there is no memory to stage a block, otherwise
+ *	an error as for ulz4fn()
+ */
+int ulz4_stream_add(struct ulz4_stream *st, const void *data, size_t len);
+
+/**
+ * ulz4_stream_finish() - Finish decompressing an LZ4 frame and free its memory
+ *
+ * This must be called once ulz4_stream_init() has been called, even if
+ * ulz4_stream_add() fails.
+ *
+ * @st: Stream to finish
+ * @dstn: Returns length of uncompressed data
+ * Return: 0 if OK, -EINVAL if the stream ended part-way through the frame
+ */
+int ulz4_stream_finish(struct ulz4_stream *st, size_t *dstn);
+
 /**
  * LZ4_decompress_safe() - Decompression protected against buffer overflow
  * @source: source address of the compressed data
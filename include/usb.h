@@ -263,6 +263,20 @@ int usb_host_eth_scan(int mode);
  */
 int usb_init(void);
 
+/**
+ * usb_init_async() - start the USB controllers, without waiting for devices
+ *
+ * This probes the controllers and powers up the ports on their root hubs, but
+ * leaves the ports to be scanned by the next call to usb_init(). This allows
+ * the ports to settle, which takes over 100ms, while other work is done.
+ *
+ * If there are companion controllers this does the full usb_init(), since
+ * they can only be scanned after the primary controllers.
+ *
+ * Return: 0 if OK, -ENOENT if there are no USB controllers
+ */
+int usb_init_async(void);
+
 int usb_stop(void); /* stop the USB Controller */
 int usb_detect_change(void); /* detect if a USB device has been (un)plugged */
 
@@ -277,6 +291,18 @@ int usb_bulk_msg(struct usb_device *dev, unsigned int pipe,
 			void *data, int len, int *actual_length, int timeout);
 int usb_int_msg(struct usb_device *dev, unsigned long pipe,
 		void *buffer, int transfer_len, int interval, bool nonblock);
+
+/**
+ * usb_busy() - check whether a transfer is in progress
+ *
+ * Host drivers call schedule() while they wait for a transfer, so a cyclic
+ * function can run in the middle of one. It must not start another
+ * transfer then.
+ *
+ * Return: true if a transfer started by usb_control_msg(), usb_bulk_msg()
+ * or usb_int_msg() has not finished
+ */
+bool usb_busy(void);
 int usb_lock_async(struct usb_device *dev, int lock);
 int usb_disable_asynch(int disable);
 int usb_maxpacket(struct usb_device *dev, unsigned long pipe);
@@ -941,6 +967,31 @@ bool usb_device_has_child_on_port(struct usb_device *parent, int port);
 int usb_hub_probe(struct usb_device *dev, int ifnum);
 void usb_hub_reset(void);
 
+/**
+ * usb_hub_defer_scan() - select whether hub ports are scanned when configured
+ *
+ * @defer: true to leave the ports of hubs on the scan list when they are
+ *	configured, for usb_hub_scan_deferred(). false to scan them straight
+ *	away, which is the default
+ */
+void usb_hub_defer_scan(bool defer);
+
+/**
+ * usb_hub_scan_deferred() - scan the ports left by usb_hub_defer_scan()
+ *
+ * This also turns off deferral
+ *
+ * Return: 0 if OK, -ve on error
+ */
+int usb_hub_scan_deferred(void);
+
+/**
+ * usb_hub_drop_scan() - drop any ports waiting to be scanned
+ *
+ * This is used when stopping USB. It also turns off deferral
+ */
+void usb_hub_drop_scan(void);
+
 /*
  * usb_find_usb2_hub_address_port() - Get hub address and port for TT setting
  *
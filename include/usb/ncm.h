@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Reading the frames from a received CDC NCM Transfer Block (NTB)
+ *
+ * This is shared by the NCM host driver and the Ethernet gadget. Only the
+ * 16-bit NTB format, without CRCs, is supported.
+ */
+
+#ifndef __USB_NCM_H
+#define __USB_NCM_H
+
+#include <linux/types.h>
+
+struct usb_cdc_ncm_ndp16;
+
+/**
+ * struct ncm_rx - state of the NTB being read
+ *
+ * @ntb: NTB being read
+ * @ntb_len: Length of @ntb, from its header
+ * @ndp: Datagram pointer table being read, or NULL if there are no more
+ *	frames in the NTB
+ * @dpe: Index of the next entry of @ndp
+ * @dpe_count: Number of entries in @ndp
+ */
+struct ncm_rx {
+	u8 *ntb;
+	uint ntb_len;
+	const struct usb_cdc_ncm_ndp16 *ndp;
+	uint dpe;
+	uint dpe_count;
+};
+
+/**
+ * ncm_rx_active() - check if there may be frames left in the NTB
+ *
+ * @rx: NTB state
+ * Return: true if ncm_rx_next() may still return a frame
+ */
+static inline bool ncm_rx_active(const struct ncm_rx *rx)
+{
+	return rx->ndp;
+}
+
+/**
+ * ncm_rx_start() - start reading a received NTB
+ *
+ * This checks the NTB header and the first datagram pointer table against
+ * @len. The frames are then taken with ncm_rx_next().
+ *
+ * @rx: NTB state to set up
+ * @ntb: NTB which was received
+ * @len: Number of bytes received
+ * Return: 0 if OK, -EINVAL if the NTB is not valid, in which case it has no
+ *	frames to read
+ */
+int ncm_rx_start(struct ncm_rx *rx, u8 *ntb, uint len);
+
+/**
+ * ncm_rx_next() - get the next frame from the NTB
+ *
+ * Each frame is checked to lie within the NTB and to be no larger than
+ * PKTSIZE. A frame which fails these checks is skipped, returning -EINVAL, so
+ * that the caller can count it. Call again for the next one.
+ *
+ * @rx: NTB state
+ * @packetp: Returns a pointer to the frame, within the NTB
+ * Return: length of the frame, 0 if there are no frames left, -EINVAL if a
+ *	frame was skipped
+ */
+int ncm_rx_next(struct ncm_rx *rx, uchar **packetp);
+
+#endif /* __USB_NCM_H */
@@ -69,6 +69,24 @@ enum video_format {
 	VIDEO_X2R10G10B10,
 };
 
+/**
+ * struct video_damage - Region of the frame buffer which needs flushing
+ *
+ * The region runs from (@xstart, @ystart) up to but not including
+ * (@xend, @yend). It is empty if @xend is 0.
+ *
+ * @xstart: Left edge, in pixels
+ * @ystart: Top edge, in pixels
+ * @xend: Right edge, in pixels
+ * @yend: Bottom edge, in pixels
+ */
+struct video_damage {
+	int xstart;
+	int ystart;
+	int xend;
+	int yend;
+};
+
 /**
  * struct video_priv - Device information used by the video uclass
  *
@@ -81,7 +99,7 @@ enum video_format {
  * @vidconsole_drv_name:	Driver to use for the text console, NULL to
  *		select automatically
  * @font_size:	Font size in pixels (0 to use a default value)
- * @fb:		Frame buffer
+ * @fb:		Frame buffer, i.e. the part of it which is currently displayed
  * @fb_size:	Frame buffer size
  * @copy_fb:	Copy of the frame buffer to keep up to date; see struct
  *		video_uc_plat
@@ -95,6 +113,11 @@ enum video_format {
  * @fg_col_idx:	Foreground color code (bit 3 = bold, bit 0-2 = color)
  * @bg_col_idx:	Background color code (bit 3 = bold, bit 0-2 = color)
  * @last_sync:	Monotonic time of last video sync
+ * @damage:	Region drawn on since the last video sync
+ * @pan_max:	Maximum scan-out offset in lines, 0 if scrolling by moving
+ *		the scan-out start is not possible; see video_scroll()
+ * @yoffset:	Current scan-out offset in lines from the start of the frame
+ *		buffer memory
  */
 struct video_priv {
 	/* Things set up by the driver: */
@@ -120,6 +143,11 @@ struct video_priv {
 	u8 fg_col_idx;
 	u8 bg_col_idx;
 	ulong last_sync;
+#ifdef CONFIG_VIDEO_DAMAGE
+	struct video_damage damage;
+#endif
+	uint pan_max;
+	uint yoffset;
 };
 
 /**
@@ -129,9 +157,16 @@ struct video_priv {
  *		For these devices implement video_sync hook to call a sync
  *		function. vid is pointer to video device udevice. Function
  *		should return 0 on success video_sync and error code otherwise
+ * @set_scanout: Start scanning out the display @yoffset lines from the
+ *		start of the frame buffer memory (struct video_uc_plat @base).
+ *		If the driver provides this and @size in struct video_uc_plat
+ *		is larger than the display, the uclass scrolls by moving
+ *		the scan-out start through the spare memory instead of
+ *		copying the display contents. Returns 0 if OK, -ve on error
  */
 struct video_ops {
 	int (*video_sync)(struct udevice *vid);
+	int (*set_scanout)(struct udevice *vid, uint yoffset);
 };
 
 #define video_get_ops(dev)        ((struct video_ops *)(dev)->driver->ops)
@@ -343,13 +378,68 @@ void video_set_default_colors(struct udevice *dev, bool invert);
  */
 int video_default_font_height(struct udevice *dev);
 
-#ifdef CONFIG_VIDEO_COPY
+/**
+ * video_scroll() - Scroll the display up by moving the scan-out start
+ *
+ * This moves the displayed part of the frame buffer down by @lines lines in
+ * memory, so that the display contents move up without being copied. When
+ * the end of the frame buffer memory is reached, the lines which remain
+ * visible are copied back to the start.
+ *
+ * The contents of the bottom @lines lines of the display are undefined
+ * afterwards, so the caller must redraw them.
+ *
+ * @vid: Video device
+ * @lines: Number of lines to scroll by
+ * Return: 0 if OK, -ENOSYS if scrolling this way is not possible (the caller
+ *	should copy the contents instead), other -ve on error
+ */
+int video_scroll(struct udevice *vid, int lines);
+
+/**
+ * video_pan_disable() - Return to the start of the frame buffer memory
+ *
+ * This moves the displayed contents back to the start of the frame buffer
+ * memory and stops video_scroll() from moving away from it again. It must be
+ * called before handing the frame buffer address (struct video_uc_plat @base)
+ * to something else, such as an EFI application or the OS.
+ *
+ * @vid: Video device
+ * Return: 0 if OK, -ve on error
+ */
+int video_pan_disable(struct udevice *vid);
+
+#ifdef CONFIG_VIDEO_DAMAGE
+/**
+ * video_damage() - Note that part of the frame buffer has been drawn on
+ *
+ * The region is flushed on the next video_sync(). It is clipped to the
+ * display.
+ *
+ * @vid: Video device
+ * @x: Left edge of the region, in pixels
+ * @y: Top edge of the region, in pixels
+ * @width: Width of the region, in pixels
+ * @height: Height of the region, in pixels
+ */
+void video_damage(struct udevice *vid, int x, int y, int width, int height);
+#else
+static inline void video_damage(struct udevice *vid, int x, int y, int width,
+				int height)
+{
+}
+#endif
+
+#if defined(CONFIG_VIDEO_COPY) || defined(CONFIG_VIDEO_DAMAGE)
 /**
  * vidconsole_sync_copy() - Sync back to the copy framebuffer
  *
  * This ensures that the copy framebuffer has the same data as the framebuffer
  * for a particular region. It should be called after the framebuffer is updated
  *
+ * With CONFIG_VIDEO_DAMAGE the lines covered by the region are also marked for
+ * flushing on the next video_sync().
+ *
  * @from and @to can be in either order. The region between them is synced.
  *
  * @dev: Vidconsole device being updated
@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Scoped scratch allocations which are released together
+ *
+ * The arena is a stack of chunks obtained from malloc(). Allocations bump a
+ * pointer in the top chunk, pushing a new chunk when it is full. Releasing a
+ * scope pops the chunks pushed since it began and rewinds the one it started
+ * in. Popped chunks of the standard size go on a short spare list so that
+ * the next scope can use them without going back to malloc().
+ */
+
+#include <arena.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <asm/global_data.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
+#include <linux/string.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum {
+	ARENA_CHUNK_SIZE	= SZ_16K,
+	ARENA_MAX_SPARE		= 2,
+	ARENA_ALIGN		= 2 * sizeof(size_t),
+};
+
+/**
+ * struct arena_chunk - a block of memory from which allocations are taken
+ *
+ * The data follows this header, in the same block
+ *
+ * @prev: chunk below this one in the stack, or the next spare chunk
+ * @size: total size of the chunk, including this header
+ * @used: number of bytes used, including this header
+ */
+struct arena_chunk {
+	struct arena_chunk *prev;
+	size_t size;
+	size_t used;
+};
+
+/*
+ * These are in the data section so that they can be used before relocation,
+ * when the BSS is not available
+ */
+static struct arena_chunk *arena_top __section(".data");
+static struct arena_chunk *arena_spare __section(".data");
+static int arena_nspare __section(".data");
+
+struct arena_mark arena_begin(void)
+{
+	struct arena_mark mark;
+
+	mark.chunk = arena_top;
+	mark.used = arena_top ? arena_top->used : 0;
+
+	return mark;
+}
+
+static struct arena_chunk *arena_new_chunk(size_t min_size)
+{
+	struct arena_chunk *chunk;
+	size_t size;
+
+	size = ALIGN(sizeof(*chunk), ARCH_DMA_MINALIGN) + min_size;
+	if (size < min_size)
+		return NULL;
+	if (size <= ARENA_CHUNK_SIZE && arena_spare) {
+		chunk = arena_spare;
+		arena_spare = chunk->prev;
+		arena_nspare--;
+	} else {
+		size = max_t(size_t, size, ARENA_CHUNK_SIZE);
+		chunk = memalign(ARCH_DMA_MINALIGN, size);
+		if (!chunk)
+			return NULL;
+		chunk->size = size;
+	}
+	chunk->used = sizeof(*chunk);
+	chunk->prev = arena_top;
+	arena_top = chunk;
+
+	return chunk;
+}
+
+/* Allocate @size bytes on an @align boundary, rounding the size to @align */
+static void *arena_alloc_align(size_t size, size_t align)
+{
+	struct arena_chunk *chunk = arena_top;
+	size_t start;
+
+	size = ALIGN(size, align);
+	if (!size)
+		size = align;
+	if (chunk) {
+		start = ALIGN(chunk->used, align);
+		if (start <= chunk->size && chunk->size - start >= size)
+			goto found;
+	}
+	chunk = arena_new_chunk(size);
+	if (!chunk)
+		return NULL;
+	start = ALIGN(chunk->used, align);
+found:
+	chunk->used = start + size;
+
+	return (char *)chunk + start;
+}
+
+void *arena_alloc(size_t size)
+{
+	return arena_alloc_align(size, ARENA_ALIGN);
+}
+
+void *arena_zalloc(size_t size)
+{
+	void *ptr = arena_alloc(size);
+
+	if (ptr)
+		memset(ptr, '\0', size);
+
+	return ptr;
+}
+
+void *arena_alloc_cache_aligned(size_t size)
+{
+	return arena_alloc_align(size, ARCH_DMA_MINALIGN);
+}
+
+char *arena_strdup(const char *str)
+{
+	size_t len = strlen(str) + 1;
+	char *copy = arena_alloc(len);
+
+	if (copy)
+		memcpy(copy, str, len);
+
+	return copy;
+}
+
+void arena_release(struct arena_mark mark)
+{
+	while (arena_top && arena_top != mark.chunk) {
+		struct arena_chunk *chunk = arena_top;
+
+		arena_top = chunk->prev;
+		/*
+		 * Only keep chunks from the full heap: anything allocated
+		 * before relocation is not valid afterwards
+		 */
+		if (chunk->size == ARENA_CHUNK_SIZE &&
+		    arena_nspare < ARENA_MAX_SPARE &&
+		    (gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+			chunk->prev = arena_spare;
+			arena_spare = chunk;
+			arena_nspare++;
+		} else {
+			free(chunk);
+		}
+	}
+	if (arena_top)
+		arena_top->used = mark.used;
+}
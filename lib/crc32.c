@@ -29,6 +29,10 @@
 
 #define tole(x) cpu_to_le32(x)
 
+#if !defined(CONFIG_ARM64_CRC32) || defined(CONFIG_ARM64_CRC32_DETECT)
+#define CRC32_TABLE
+#endif
+
 #ifdef CONFIG_DYNAMIC_CRC_TABLE
 
 static int __efi_runtime_data crc_table_empty = 1;
@@ -82,7 +86,7 @@ static void __efi_runtime make_crc_table(void)
   }
   crc_table_empty = 0;
 }
-#elif !defined(CONFIG_ARM64_CRC32)
+#elif defined(CRC32_TABLE)
 /* ========================================================================
  * Table of CRC-32's of all single-byte values (made by make_crc_table)
  */
@@ -177,17 +181,10 @@ const uint32_t * ZEXPORT get_crc_table()
 
 /* ========================================================================= */
 
-/* No ones complement version. JFFS2 (and other things ?)
- * don't use ones compliment in their CRC calculations.
- */
-uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+#ifdef CRC32_TABLE
+uint32_t __efi_runtime crc32_no_comp_table(uint32_t crc, const Bytef *buf,
+					  uInt len)
 {
-#ifdef CONFIG_ARM64_CRC32
-    crc = cpu_to_le32(crc);
-    while (len--)
-        crc = __builtin_aarch64_crc32b(crc, *buf++);
-    return le32_to_cpu(crc);
-#else
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
     size_t rem_len;
@@ -225,6 +222,66 @@ uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
     }
 
     return le32_to_cpu(crc);
+}
+#endif
+
+#ifdef CONFIG_ARM64_CRC32
+bool __efi_runtime crc32_hw_available(void)
+{
+	u64 isar0;
+
+	if (!IS_ENABLED(CONFIG_ARM64_CRC32_DETECT))
+		return true;
+
+	/* ID_AA64ISAR0_EL1.CRC32, bits [19:16] */
+	asm volatile("mrs %0, id_aa64isar0_el1" : "=r" (isar0));
+
+	return (isar0 >> 16) & 0xf;
+}
+
+uint32_t __efi_runtime crc32_no_comp_hw(uint32_t crc, const Bytef *buf,
+				       uInt len)
+{
+	crc = cpu_to_le32(crc);
+
+	/*
+	 * Align to 64 bits first, unaligned loads fault while the MMU is
+	 * still off
+	 */
+	while (len && ((ulong)buf & 7)) {
+		crc = __builtin_aarch64_crc32b(crc, *buf++);
+		len--;
+	}
+
+	for (; len >= 8; len -= 8, buf += 8)
+		crc = __builtin_aarch64_crc32x(crc,
+					       le64_to_cpu(*(const u64 *)buf));
+
+	while (len--)
+		crc = __builtin_aarch64_crc32b(crc, *buf++);
+
+	return le32_to_cpu(crc);
+}
+#else
+bool __efi_runtime crc32_hw_available(void)
+{
+	return false;
+}
+#endif
+
+/* No ones complement version. JFFS2 (and other things ?)
+ * don't use ones compliment in their CRC calculations.
+ */
+uint32_t __efi_runtime crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
+{
+#ifndef CRC32_TABLE
+	return crc32_no_comp_hw(crc, buf, len);
+#else
+#ifdef CONFIG_ARM64_CRC32
+	if (crc32_hw_available())
+		return crc32_no_comp_hw(crc, buf, len);
+#endif
+	return crc32_no_comp_table(crc, buf, len);
 #endif
 }
 #undef DO_CRC
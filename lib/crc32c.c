@@ -11,9 +11,13 @@
  */
 
 #include <compiler.h>
+#include <u-boot/crc.h>
 
-uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
-		    uint32_t *crc32c_table)
+/* Bit-reflected Castagnoli polynomial, as computed by the CRC32C instructions */
+#define CRC32C_POLY	0x82f63b78
+
+uint32_t crc32c_cal_table(uint32_t crc, const char *data, int length,
+			  uint32_t *crc32c_table)
 {
 	while (length--)
 		crc = crc32c_table[(u8)(crc ^ *data++)] ^ (crc >> 8);
@@ -21,6 +25,42 @@ uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 	return crc;
 }
 
+#ifdef CONFIG_ARM64_CRC32
+uint32_t crc32c_cal_hw(uint32_t crc, const char *data, int length)
+{
+	const u8 *buf = (const u8 *)data;
+
+	while (length > 0 && ((ulong)buf & 7)) {
+		crc = __builtin_aarch64_crc32cb(crc, *buf++);
+		length--;
+	}
+
+	for (; length >= 8; length -= 8, buf += 8)
+		crc = __builtin_aarch64_crc32cx(crc,
+						le64_to_cpu(*(const u64 *)buf));
+
+	while (length-- > 0)
+		crc = __builtin_aarch64_crc32cb(crc, *buf++);
+
+	return crc;
+}
+#endif
+
+uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
+		    uint32_t *crc32c_table)
+{
+#ifdef CONFIG_ARM64_CRC32
+	/*
+	 * Entry 128 of a reflected table is the polynomial itself, so this
+	 * tells whether the caller asked for the Castagnoli CRC
+	 */
+	if (crc32c_table[128] == CRC32C_POLY && crc32_hw_available())
+		return crc32c_cal_hw(crc, data, length);
+#endif
+
+	return crc32c_cal_table(crc, data, length, crc32c_table);
+}
+
 void crc32c_init(uint32_t *crc32c_table, uint32_t pol)
 {
 	int i, j;
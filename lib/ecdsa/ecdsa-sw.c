@@ -0,0 +1,633 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Software ECDSA verification for the NIST P-256 and P-384 curves
+ *
+ * This is for boards without an ECDSA engine. Numbers are held as arrays of
+ * 32-bit words, least significant first, and field elements are kept in
+ * Montgomery form. The field arithmetic does not branch on the values it
+ * handles. Points use Jacobian coordinates, and u1 * G + u2 * Q is computed
+ * with 4-bit fixed windows on both scalars at once; the table of multiples of
+ * the generator is built once, when the device is probed.
+ */
+
+#include <crypto/ecdsa-uclass.h>
+#include <dm.h>
+#include <log.h>
+#include <u-boot/ecdsa.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+
+#define EC_MAX_WORDS	12		/* P-384 */
+#define EC_WINDOW	4
+#define EC_TABLE_SIZE	(1 << EC_WINDOW)
+
+/**
+ * struct ec_mod - a modulus for Montgomery arithmetic
+ *
+ * @m: Modulus
+ * @m0inv: -1 / m mod 2^32
+ * @one: R mod m, where R is 2^(32 * words), i.e. 1 in Montgomery form
+ * @rr: R^2 mod m, to convert into Montgomery form
+ */
+struct ec_mod {
+	u32 m[EC_MAX_WORDS];
+	u32 m0inv;
+	u32 one[EC_MAX_WORDS];
+	u32 rr[EC_MAX_WORDS];
+};
+
+/**
+ * struct ec_point - a point in Jacobian coordinates, in Montgomery form
+ *
+ * @x, @y, @z: Coordinates; @z is zero for the point at infinity
+ */
+struct ec_point {
+	u32 x[EC_MAX_WORDS];
+	u32 y[EC_MAX_WORDS];
+	u32 z[EC_MAX_WORDS];
+};
+
+/**
+ * struct ec_curve_def - parameters of a curve y^2 = x^3 - 3x + b
+ *
+ * @name: Curve name, as in the 'ecdsa,curve' property of keys
+ * @bytes: Size of the field and of the group order in bytes
+ * @p: Field prime, big endian
+ * @n: Order of the generator, big endian
+ * @b: Curve coefficient b, big endian
+ * @gx: x coordinate of the generator, big endian
+ * @gy: y coordinate of the generator, big endian
+ */
+struct ec_curve_def {
+	const char *name;
+	uint bytes;
+	const u8 *p, *n, *b, *gx, *gy;
+};
+
+/**
+ * struct ec_curve - a curve set up for use
+ *
+ * @def: Parameters of the curve
+ * @words: Size of the numbers in 32-bit words
+ * @p: Field prime
+ * @n: Group order
+ * @b: Curve coefficient b, in Montgomery form
+ * @gtab: 0 to EC_TABLE_SIZE - 1 times the generator
+ */
+struct ec_curve {
+	const struct ec_curve_def *def;
+	uint words;
+	struct ec_mod p;
+	struct ec_mod n;
+	u32 b[EC_MAX_WORDS];
+	struct ec_point gtab[EC_TABLE_SIZE];
+};
+
+static const u8 p256_p[] = {
+	0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+static const u8 p256_n[] = {
+	0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xbc, 0xe6, 0xfa, 0xad, 0xa7, 0x17, 0x9e, 0x84,
+	0xf3, 0xb9, 0xca, 0xc2, 0xfc, 0x63, 0x25, 0x51,
+};
+
+static const u8 p256_b[] = {
+	0x5a, 0xc6, 0x35, 0xd8, 0xaa, 0x3a, 0x93, 0xe7,
+	0xb3, 0xeb, 0xbd, 0x55, 0x76, 0x98, 0x86, 0xbc,
+	0x65, 0x1d, 0x06, 0xb0, 0xcc, 0x53, 0xb0, 0xf6,
+	0x3b, 0xce, 0x3c, 0x3e, 0x27, 0xd2, 0x60, 0x4b,
+};
+
+static const u8 p256_gx[] = {
+	0x6b, 0x17, 0xd1, 0xf2, 0xe1, 0x2c, 0x42, 0x47,
+	0xf8, 0xbc, 0xe6, 0xe5, 0x63, 0xa4, 0x40, 0xf2,
+	0x77, 0x03, 0x7d, 0x81, 0x2d, 0xeb, 0x33, 0xa0,
+	0xf4, 0xa1, 0x39, 0x45, 0xd8, 0x98, 0xc2, 0x96,
+};
+
+static const u8 p256_gy[] = {
+	0x4f, 0xe3, 0x42, 0xe2, 0xfe, 0x1a, 0x7f, 0x9b,
+	0x8e, 0xe7, 0xeb, 0x4a, 0x7c, 0x0f, 0x9e, 0x16,
+	0x2b, 0xce, 0x33, 0x57, 0x6b, 0x31, 0x5e, 0xce,
+	0xcb, 0xb6, 0x40, 0x68, 0x37, 0xbf, 0x51, 0xf5,
+};
+
+static const u8 p384_p[] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe,
+	0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+};
+
+static const u8 p384_n[] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xc7, 0x63, 0x4d, 0x81, 0xf4, 0x37, 0x2d, 0xdf,
+	0x58, 0x1a, 0x0d, 0xb2, 0x48, 0xb0, 0xa7, 0x7a,
+	0xec, 0xec, 0x19, 0x6a, 0xcc, 0xc5, 0x29, 0x73,
+};
+
+static const u8 p384_b[] = {
+	0xb3, 0x31, 0x2f, 0xa7, 0xe2, 0x3e, 0xe7, 0xe4,
+	0x98, 0x8e, 0x05, 0x6b, 0xe3, 0xf8, 0x2d, 0x19,
+	0x18, 0x1d, 0x9c, 0x6e, 0xfe, 0x81, 0x41, 0x12,
+	0x03, 0x14, 0x08, 0x8f, 0x50, 0x13, 0x87, 0x5a,
+	0xc6, 0x56, 0x39, 0x8d, 0x8a, 0x2e, 0xd1, 0x9d,
+	0x2a, 0x85, 0xc8, 0xed, 0xd3, 0xec, 0x2a, 0xef,
+};
+
+static const u8 p384_gx[] = {
+	0xaa, 0x87, 0xca, 0x22, 0xbe, 0x8b, 0x05, 0x37,
+	0x8e, 0xb1, 0xc7, 0x1e, 0xf3, 0x20, 0xad, 0x74,
+	0x6e, 0x1d, 0x3b, 0x62, 0x8b, 0xa7, 0x9b, 0x98,
+	0x59, 0xf7, 0x41, 0xe0, 0x82, 0x54, 0x2a, 0x38,
+	0x55, 0x02, 0xf2, 0x5d, 0xbf, 0x55, 0x29, 0x6c,
+	0x3a, 0x54, 0x5e, 0x38, 0x72, 0x76, 0x0a, 0xb7,
+};
+
+static const u8 p384_gy[] = {
+	0x36, 0x17, 0xde, 0x4a, 0x96, 0x26, 0x2c, 0x6f,
+	0x5d, 0x9e, 0x98, 0xbf, 0x92, 0x92, 0xdc, 0x29,
+	0xf8, 0xf4, 0x1d, 0xbd, 0x28, 0x9a, 0x14, 0x7c,
+	0xe9, 0xda, 0x31, 0x13, 0xb5, 0xf0, 0xb8, 0xc0,
+	0x0a, 0x60, 0xb1, 0xce, 0x1d, 0x7e, 0x81, 0x9d,
+	0x7a, 0x43, 0x1d, 0x7c, 0x90, 0xea, 0x0e, 0x5f,
+};
+
+static const struct ec_curve_def ec_curve_defs[] = {
+	{ "prime256v1", 32, p256_p, p256_n, p256_b, p256_gx, p256_gy },
+	{ "secp384r1", 48, p384_p, p384_n, p384_b, p384_gx, p384_gy },
+};
+
+struct ecdsa_sw_priv {
+	struct ec_curve curve[ARRAY_SIZE(ec_curve_defs)];
+};
+
+static void ec_from_bytes(u32 *r, const u8 *src, uint bytes)
+{
+	uint i;
+
+	for (i = 0; i < bytes / 4; i++) {
+		const u8 *p = src + bytes - 4 * (i + 1);
+
+		r[i] = (u32)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+	}
+}
+
+static u32 ec_add_words(u32 *r, const u32 *a, const u32 *b, uint words)
+{
+	u64 acc = 0;
+	uint i;
+
+	for (i = 0; i < words; i++) {
+		acc += (u64)a[i] + b[i];
+		r[i] = (u32)acc;
+		acc >>= 32;
+	}
+
+	return acc;
+}
+
+static u32 ec_sub_words(u32 *r, const u32 *a, const u32 *b, uint words)
+{
+	u64 borrow = 0;
+	uint i;
+
+	for (i = 0; i < words; i++) {
+		u64 acc = (u64)a[i] - b[i] - borrow;
+
+		r[i] = (u32)acc;
+		borrow = (acc >> 32) & 1;
+	}
+
+	return borrow;
+}
+
+/* Set r to a if cond is 1, else to b, for cond 0 or 1 */
+static void ec_select(u32 *r, const u32 *a, const u32 *b, u32 cond,
+		      uint words)
+{
+	u32 mask = -cond;
+	uint i;
+
+	for (i = 0; i < words; i++)
+		r[i] = (a[i] & mask) | (b[i] & ~mask);
+}
+
+static bool ec_is_zero(const u32 *a, uint words)
+{
+	u32 acc = 0;
+	uint i;
+
+	for (i = 0; i < words; i++)
+		acc |= a[i];
+
+	return !acc;
+}
+
+/* Check 0 < a < m for a value from outside */
+static bool ec_in_range(const u32 *a, const u32 *m, uint words)
+{
+	u32 tmp[EC_MAX_WORDS];
+
+	return !ec_is_zero(a, words) && ec_sub_words(tmp, a, m, words);
+}
+
+/* r = a + b mod m, for a, b < m */
+static void ec_mod_add(const struct ec_mod *mod, u32 *r, const u32 *a,
+		       const u32 *b, uint words)
+{
+	u32 sum[EC_MAX_WORDS], red[EC_MAX_WORDS];
+	u32 carry, borrow;
+
+	carry = ec_add_words(sum, a, b, words);
+	borrow = ec_sub_words(red, sum, mod->m, words);
+	ec_select(r, red, sum, carry | !borrow, words);
+}
+
+/* r = a - b mod m, for a, b < m */
+static void ec_mod_sub(const struct ec_mod *mod, u32 *r, const u32 *a,
+		       const u32 *b, uint words)
+{
+	u32 diff[EC_MAX_WORDS], fix[EC_MAX_WORDS];
+	u32 borrow;
+
+	borrow = ec_sub_words(diff, a, b, words);
+	ec_add_words(fix, diff, mod->m, words);
+	ec_select(r, fix, diff, borrow, words);
+}
+
+/* r = a * b / R mod m, for a, b < m; r may be the same as a or b */
+static void ec_mod_mul(const struct ec_mod *mod, u32 *r, const u32 *a,
+		       const u32 *b, uint words)
+{
+	u32 t[EC_MAX_WORDS + 2], red[EC_MAX_WORDS];
+	uint i, j;
+	u32 borrow;
+
+	memset(t, '\0', sizeof(t));
+	for (i = 0; i < words; i++) {
+		u64 acc = 0;
+		u32 q;
+
+		for (j = 0; j < words; j++) {
+			acc += (u64)a[j] * b[i] + t[j];
+			t[j] = (u32)acc;
+			acc >>= 32;
+		}
+		acc += t[words];
+		t[words] = (u32)acc;
+		t[words + 1] = acc >> 32;
+
+		q = t[0] * mod->m0inv;
+		acc = ((u64)q * mod->m[0] + t[0]) >> 32;
+		for (j = 1; j < words; j++) {
+			acc += (u64)q * mod->m[j] + t[j];
+			t[j - 1] = (u32)acc;
+			acc >>= 32;
+		}
+		acc += t[words];
+		t[words - 1] = (u32)acc;
+		t[words] = t[words + 1] + (acc >> 32);
+	}
+
+	/* t < 2m, so at most one subtraction is needed */
+	borrow = ec_sub_words(red, t, mod->m, words);
+	ec_select(r, red, t, t[words] | !borrow, words);
+}
+
+/* r = a^(m - 2) = 1 / a mod m, in Montgomery form; m is public */
+static void ec_mod_inv(const struct ec_mod *mod, u32 *r, const u32 *a,
+		       uint words)
+{
+	u32 exp[EC_MAX_WORDS], two[EC_MAX_WORDS] = { 2 };
+	u32 acc[EC_MAX_WORDS];
+	int i;
+
+	ec_sub_words(exp, mod->m, two, words);
+	memcpy(acc, mod->one, sizeof(acc));
+	for (i = words * 32 - 1; i >= 0; i--) {
+		ec_mod_mul(mod, acc, acc, acc, words);
+		if (exp[i / 32] & (1U << (i % 32)))
+			ec_mod_mul(mod, acc, acc, a, words);
+	}
+	memcpy(r, acc, words * sizeof(u32));
+}
+
+static void ec_mod_init(struct ec_mod *mod, const u8 *m, uint words)
+{
+	u32 inv = 1;
+	int i;
+
+	memset(mod, '\0', sizeof(*mod));
+	ec_from_bytes(mod->m, m, words * 4);
+
+	/* Newton's method doubles the number of correct low bits each time */
+	for (i = 0; i < 5; i++)
+		inv *= 2 - mod->m[0] * inv;
+	mod->m0inv = -inv;
+
+	/* Double 1 up to R, then on to R^2 */
+	mod->one[0] = 1;
+	for (i = 0; i < words * 32; i++)
+		ec_mod_add(mod, mod->one, mod->one, mod->one, words);
+	memcpy(mod->rr, mod->one, sizeof(mod->rr));
+	for (i = 0; i < words * 32; i++)
+		ec_mod_add(mod, mod->rr, mod->rr, mod->rr, words);
+}
+
+static void ec_point_double(const struct ec_curve *c, struct ec_point *r,
+			    const struct ec_point *pt)
+{
+	const struct ec_mod *p = &c->p;
+	uint w = c->words;
+	u32 delta[EC_MAX_WORDS], gamma[EC_MAX_WORDS], beta[EC_MAX_WORDS];
+	u32 alpha[EC_MAX_WORDS], t1[EC_MAX_WORDS], t2[EC_MAX_WORDS];
+
+	/* dbl-2001-b, for a = -3; the point at infinity maps to itself */
+	ec_mod_mul(p, delta, pt->z, pt->z, w);
+	ec_mod_mul(p, gamma, pt->y, pt->y, w);
+	ec_mod_mul(p, beta, pt->x, gamma, w);
+
+	ec_mod_sub(p, t1, pt->x, delta, w);
+	ec_mod_add(p, t2, pt->x, delta, w);
+	ec_mod_mul(p, alpha, t1, t2, w);
+	ec_mod_add(p, t1, alpha, alpha, w);
+	ec_mod_add(p, alpha, alpha, t1, w);
+
+	/* z3 = (y + z)^2 - gamma - delta */
+	ec_mod_add(p, t1, pt->y, pt->z, w);
+	ec_mod_mul(p, t1, t1, t1, w);
+	ec_mod_sub(p, t1, t1, gamma, w);
+	ec_mod_sub(p, r->z, t1, delta, w);
+
+	/* x3 = alpha^2 - 8 * beta */
+	ec_mod_add(p, beta, beta, beta, w);
+	ec_mod_add(p, beta, beta, beta, w);
+	ec_mod_add(p, t2, beta, beta, w);
+	ec_mod_mul(p, t1, alpha, alpha, w);
+	ec_mod_sub(p, r->x, t1, t2, w);
+
+	/* y3 = alpha * (4 * beta - x3) - 8 * gamma^2 */
+	ec_mod_sub(p, t1, beta, r->x, w);
+	ec_mod_mul(p, t1, alpha, t1, w);
+	ec_mod_mul(p, gamma, gamma, gamma, w);
+	ec_mod_add(p, gamma, gamma, gamma, w);
+	ec_mod_add(p, gamma, gamma, gamma, w);
+	ec_mod_add(p, gamma, gamma, gamma, w);
+	ec_mod_sub(p, r->y, t1, gamma, w);
+}
+
+/*
+ * r = a + b. The special cases only depend on the points, which are all
+ * public during verification.
+ */
+static void ec_point_add(const struct ec_curve *c, struct ec_point *r,
+			 const struct ec_point *a, const struct ec_point *b)
+{
+	const struct ec_mod *p = &c->p;
+	uint w = c->words;
+	u32 z1z1[EC_MAX_WORDS], z2z2[EC_MAX_WORDS], u1[EC_MAX_WORDS];
+	u32 u2[EC_MAX_WORDS], s1[EC_MAX_WORDS], s2[EC_MAX_WORDS];
+	u32 h[EC_MAX_WORDS], i[EC_MAX_WORDS], j[EC_MAX_WORDS];
+	u32 rr[EC_MAX_WORDS], v[EC_MAX_WORDS], t[EC_MAX_WORDS];
+
+	if (ec_is_zero(a->z, w)) {
+		*r = *b;
+		return;
+	}
+	if (ec_is_zero(b->z, w)) {
+		*r = *a;
+		return;
+	}
+
+	/* add-2007-bl */
+	ec_mod_mul(p, z1z1, a->z, a->z, w);
+	ec_mod_mul(p, z2z2, b->z, b->z, w);
+	ec_mod_mul(p, u1, a->x, z2z2, w);
+	ec_mod_mul(p, u2, b->x, z1z1, w);
+	ec_mod_mul(p, s1, a->y, b->z, w);
+	ec_mod_mul(p, s1, s1, z2z2, w);
+	ec_mod_mul(p, s2, b->y, a->z, w);
+	ec_mod_mul(p, s2, s2, z1z1, w);
+	ec_mod_sub(p, h, u2, u1, w);
+	ec_mod_sub(p, rr, s2, s1, w);
+	if (ec_is_zero(h, w)) {
+		if (ec_is_zero(rr, w))
+			ec_point_double(c, r, a);
+		else
+			memset(r, '\0', sizeof(*r));
+		return;
+	}
+
+	ec_mod_add(p, i, h, h, w);
+	ec_mod_mul(p, i, i, i, w);
+	ec_mod_mul(p, j, h, i, w);
+	ec_mod_add(p, rr, rr, rr, w);
+	ec_mod_mul(p, v, u1, i, w);
+
+	/* z3 = ((z1 + z2)^2 - z1z1 - z2z2) * h, before a or b is overwritten */
+	ec_mod_add(p, t, a->z, b->z, w);
+	ec_mod_mul(p, t, t, t, w);
+	ec_mod_sub(p, t, t, z1z1, w);
+	ec_mod_sub(p, t, t, z2z2, w);
+	ec_mod_mul(p, r->z, t, h, w);
+
+	/* x3 = rr^2 - j - 2 * v */
+	ec_mod_mul(p, t, rr, rr, w);
+	ec_mod_sub(p, t, t, j, w);
+	ec_mod_sub(p, t, t, v, w);
+	ec_mod_sub(p, r->x, t, v, w);
+
+	/* y3 = rr * (v - x3) - 2 * s1 * j */
+	ec_mod_sub(p, t, v, r->x, w);
+	ec_mod_mul(p, t, rr, t, w);
+	ec_mod_mul(p, s1, s1, j, w);
+	ec_mod_add(p, s1, s1, s1, w);
+	ec_mod_sub(p, r->y, t, s1, w);
+}
+
+/* Fill tab with 0 to EC_TABLE_SIZE - 1 times pt */
+static void ec_point_table(const struct ec_curve *c, struct ec_point *tab,
+			   const struct ec_point *pt)
+{
+	int i;
+
+	memset(&tab[0], '\0', sizeof(tab[0]));
+	tab[1] = *pt;
+	for (i = 2; i < EC_TABLE_SIZE; i++)
+		ec_point_add(c, &tab[i], &tab[i - 1], pt);
+}
+
+/* r = u1 * G + u2 * Q, with qtab from ec_point_table() for Q */
+static void ec_point_mul2(const struct ec_curve *c, struct ec_point *r,
+			  const u32 *u1, const u32 *u2,
+			  const struct ec_point *qtab)
+{
+	const int per_word = 32 / EC_WINDOW;
+	int i, k;
+
+	memset(r, '\0', sizeof(*r));
+	for (i = c->words * per_word - 1; i >= 0; i--) {
+		int shift = (i % per_word) * EC_WINDOW;
+		uint w1 = (u1[i / per_word] >> shift) & (EC_TABLE_SIZE - 1);
+		uint w2 = (u2[i / per_word] >> shift) & (EC_TABLE_SIZE - 1);
+
+		for (k = 0; k < EC_WINDOW; k++)
+			ec_point_double(c, r, r);
+		ec_point_add(c, r, r, &c->gtab[w1]);
+		ec_point_add(c, r, r, &qtab[w2]);
+	}
+}
+
+/* Check y^2 = x^3 - 3x + b for a point in Montgomery form with z = 1 */
+static bool ec_point_on_curve(const struct ec_curve *c,
+			      const struct ec_point *pt)
+{
+	const struct ec_mod *p = &c->p;
+	uint w = c->words;
+	u32 lhs[EC_MAX_WORDS], rhs[EC_MAX_WORDS], t[EC_MAX_WORDS];
+
+	ec_mod_mul(p, lhs, pt->y, pt->y, w);
+	ec_mod_mul(p, rhs, pt->x, pt->x, w);
+	ec_mod_mul(p, rhs, rhs, pt->x, w);
+	ec_mod_add(p, t, pt->x, pt->x, w);
+	ec_mod_add(p, t, t, pt->x, w);
+	ec_mod_sub(p, rhs, rhs, t, w);
+	ec_mod_add(p, rhs, rhs, c->b, w);
+
+	return !memcmp(lhs, rhs, w * sizeof(u32));
+}
+
+static int ecdsa_sw_verify(struct udevice *dev,
+			   const struct ecdsa_public_key *pubkey,
+			   const void *hash, size_t hash_len,
+			   const void *signature, size_t sig_len)
+{
+	struct ecdsa_sw_priv *priv = dev_get_priv(dev);
+	u32 r[EC_MAX_WORDS], s[EC_MAX_WORDS], e[EC_MAX_WORDS];
+	u32 u1[EC_MAX_WORDS], u2[EC_MAX_WORDS], t[EC_MAX_WORDS];
+	struct ec_point q, sum, qtab[EC_TABLE_SIZE];
+	const struct ec_curve *c = NULL;
+	u8 buf[EC_MAX_WORDS * 4];
+	uint i, w, bytes;
+
+	for (i = 0; i < ARRAY_SIZE(priv->curve); i++) {
+		if (!strcmp(pubkey->curve_name, priv->curve[i].def->name))
+			c = &priv->curve[i];
+	}
+	if (!c)
+		return -EOPNOTSUPP;
+	bytes = c->def->bytes;
+	w = c->words;
+	if (sig_len != 2 * bytes)
+		return -EINVAL;
+
+	memset(r, '\0', sizeof(r));
+	memset(s, '\0', sizeof(s));
+	ec_from_bytes(r, signature, bytes);
+	ec_from_bytes(s, signature + bytes, bytes);
+	if (!ec_in_range(r, c->n.m, w) || !ec_in_range(s, c->n.m, w))
+		return -EPERM;
+
+	/* Use the leftmost bits of the hash, then reduce it once */
+	memset(buf, '\0', sizeof(buf));
+	if (hash_len >= bytes)
+		memcpy(buf, hash, bytes);
+	else
+		memcpy(buf + bytes - hash_len, hash, hash_len);
+	memset(e, '\0', sizeof(e));
+	ec_from_bytes(e, buf, bytes);
+	if (!ec_sub_words(t, e, c->n.m, w))
+		memcpy(e, t, sizeof(e));
+
+	memset(&q, '\0', sizeof(q));
+	ec_from_bytes(q.x, pubkey->x, bytes);
+	ec_from_bytes(q.y, pubkey->y, bytes);
+	if (!ec_sub_words(t, q.x, c->p.m, w) ||
+	    !ec_sub_words(t, q.y, c->p.m, w))
+		return -EINVAL;
+	ec_mod_mul(&c->p, q.x, q.x, c->p.rr, w);
+	ec_mod_mul(&c->p, q.y, q.y, c->p.rr, w);
+	memcpy(q.z, c->p.one, sizeof(q.z));
+	if (!ec_point_on_curve(c, &q))
+		return -EINVAL;
+
+	/* w = 1 / s in Montgomery form, so u1 = e * w and u2 = r * w */
+	ec_mod_mul(&c->n, t, s, c->n.rr, w);
+	ec_mod_inv(&c->n, t, t, w);
+	ec_mod_mul(&c->n, u1, e, t, w);
+	ec_mod_mul(&c->n, u2, r, t, w);
+
+	ec_point_table(c, qtab, &q);
+	ec_point_mul2(c, &sum, u1, u2, qtab);
+	if (ec_is_zero(sum.z, w))
+		return -EPERM;
+
+	/* Affine x = X / Z^2, out of Montgomery form, then mod n */
+	ec_mod_inv(&c->p, t, sum.z, w);
+	ec_mod_mul(&c->p, t, t, t, w);
+	ec_mod_mul(&c->p, t, sum.x, t, w);
+	memset(u1, '\0', sizeof(u1));
+	u1[0] = 1;
+	ec_mod_mul(&c->p, t, t, u1, w);
+	if (!ec_sub_words(u1, t, c->n.m, w))
+		memcpy(t, u1, sizeof(t));
+
+	return memcmp(t, r, w * sizeof(u32)) ? -EPERM : 0;
+}
+
+static int ecdsa_sw_probe(struct udevice *dev)
+{
+	struct ecdsa_sw_priv *priv = dev_get_priv(dev);
+	struct ec_point g;
+	uint i, w;
+
+	for (i = 0; i < ARRAY_SIZE(priv->curve); i++) {
+		struct ec_curve *c = &priv->curve[i];
+
+		c->def = &ec_curve_defs[i];
+		c->words = w = c->def->bytes / 4;
+		ec_mod_init(&c->p, c->def->p, w);
+		ec_mod_init(&c->n, c->def->n, w);
+
+		ec_from_bytes(c->b, c->def->b, c->def->bytes);
+		ec_mod_mul(&c->p, c->b, c->b, c->p.rr, w);
+
+		memset(&g, '\0', sizeof(g));
+		ec_from_bytes(g.x, c->def->gx, c->def->bytes);
+		ec_from_bytes(g.y, c->def->gy, c->def->bytes);
+		ec_mod_mul(&c->p, g.x, g.x, c->p.rr, w);
+		ec_mod_mul(&c->p, g.y, g.y, c->p.rr, w);
+		memcpy(g.z, c->p.one, sizeof(g.z));
+		ec_point_table(c, c->gtab, &g);
+	}
+
+	return 0;
+}
+
+static const struct ecdsa_ops ecdsa_sw_ops = {
+	.verify	= ecdsa_sw_verify,
+};
+
+U_BOOT_DRIVER(ecdsa_sw) = {
+	.name		= "ecdsa_sw",
+	.id		= UCLASS_ECDSA,
+	.ops		= &ecdsa_sw_ops,
+	.probe		= ecdsa_sw_probe,
+	.priv_auto	= sizeof(struct ecdsa_sw_priv),
+	.flags		= DM_FLAG_PRE_RELOC,
+};
+
+U_BOOT_DRVINFO(ecdsa_sw) = {
+	.name = "ecdsa_sw",
+};
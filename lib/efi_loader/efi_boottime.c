@@ -7,7 +7,9 @@
 
 #define LOG_CATEGORY LOGC_EFI
 
+#include <blk.h>
 #include <bootm.h>
+#include <cpu_func.h>
 #include <div64.h>
 #include <dm/device.h>
 #include <dm/root.h>
@@ -47,6 +49,26 @@ bool efi_st_keep_devices;
 /* List of all events registered by RegisterProtocolNotify() */
 static LIST_HEAD(efi_register_notify_events);
 
+/**
+ * struct efi_protocol_index - interfaces installed for a protocol
+ *
+ * @link:	link to efi_protocol_indices
+ * @guid:	GUID of the protocol
+ * @handlers:	interfaces of the protocol in the order of installation,
+ *		linked via &struct efi_handler.guid_link
+ */
+struct efi_protocol_index {
+	struct list_head link;
+	efi_guid_t guid;
+	struct list_head handlers;
+};
+
+/*
+ * Index of the installed protocols, most recently searched first. Entries are
+ * kept when the last interface is uninstalled as the set of GUIDs is small.
+ */
+static LIST_HEAD(efi_protocol_indices);
+
 /* Handle of the currently executing image */
 static efi_handle_t current_image;
 
@@ -572,6 +594,41 @@ efi_status_t efi_create_handle(efi_handle_t *handle)
 	return EFI_SUCCESS;
 }
 
+/**
+ * efi_protocol_index_find() - find the index of a protocol
+ *
+ * A found entry is moved to the head of efi_protocol_indices so that the
+ * protocols searched for repeatedly (block IO, device path, simple file
+ * system, ...) are found after a few comparisons.
+ *
+ * @protocol:	GUID of the protocol
+ * @create:	create the entry if it does not exist
+ * Return:	index entry or NULL
+ */
+static struct efi_protocol_index *
+efi_protocol_index_find(const efi_guid_t *protocol, bool create)
+{
+	struct efi_protocol_index *idx;
+
+	list_for_each_entry(idx, &efi_protocol_indices, link) {
+		if (!guidcmp(&idx->guid, protocol)) {
+			list_move(&idx->link, &efi_protocol_indices);
+			return idx;
+		}
+	}
+	if (!create)
+		return NULL;
+
+	idx = calloc(1, sizeof(*idx));
+	if (!idx)
+		return NULL;
+	guidcpy(&idx->guid, protocol);
+	INIT_LIST_HEAD(&idx->handlers);
+	list_add(&idx->link, &efi_protocol_indices);
+
+	return idx;
+}
+
 /**
  * efi_search_protocol() - find a protocol on a handle.
  * @handle:        handle
@@ -626,6 +683,7 @@ static efi_status_t efi_remove_protocol(const efi_handle_t handle,
 	if (handler->protocol_interface != protocol_interface)
 		return EFI_NOT_FOUND;
 	list_del(&handler->link);
+	list_del(&handler->guid_link);
 	free(handler);
 	return EFI_SUCCESS;
 }
@@ -1171,6 +1229,7 @@ efi_status_t efi_add_protocol(const efi_handle_t handle,
 {
 	struct efi_object *efiobj;
 	struct efi_handler *handler;
+	struct efi_protocol_index *idx;
 	efi_status_t ret;
 	struct efi_register_notify_event *event;
 
@@ -1180,13 +1239,18 @@ efi_status_t efi_add_protocol(const efi_handle_t handle,
 	ret = efi_search_protocol(handle, protocol, NULL);
 	if (ret != EFI_NOT_FOUND)
 		return EFI_INVALID_PARAMETER;
+	idx = efi_protocol_index_find(protocol, true);
+	if (!idx)
+		return EFI_OUT_OF_RESOURCES;
 	handler = calloc(1, sizeof(struct efi_handler));
 	if (!handler)
 		return EFI_OUT_OF_RESOURCES;
 	memcpy((void *)&handler->guid, protocol, sizeof(efi_guid_t));
 	handler->protocol_interface = protocol_interface;
+	handler->handle = efiobj;
 	INIT_LIST_HEAD(&handler->open_infos);
 	list_add_tail(&handler->link, &efiobj->protocols);
+	list_add_tail(&handler->guid_link, &idx->handlers);
 
 	/* Notify registered events */
 	list_for_each_entry(event, &efi_register_notify_events, link) {
@@ -1196,6 +1260,7 @@ efi_status_t efi_add_protocol(const efi_handle_t handle,
 			notif = calloc(1, sizeof(*notif));
 			if (!notif) {
 				list_del(&handler->link);
+				list_del(&handler->guid_link);
 				free(handler);
 				return EFI_OUT_OF_RESOURCES;
 			}
@@ -1508,34 +1573,6 @@ out:
 	return EFI_EXIT(ret);
 }
 
-/**
- * efi_search() - determine if an EFI handle implements a protocol
- *
- * @search_type: selection criterion
- * @protocol:    GUID of the protocol
- * @handle:      handle
- *
- * See the documentation of the LocateHandle service in the UEFI specification.
- *
- * Return: 0 if the handle implements the protocol
- */
-static int efi_search(enum efi_locate_search_type search_type,
-		      const efi_guid_t *protocol, efi_handle_t handle)
-{
-	efi_status_t ret;
-
-	switch (search_type) {
-	case ALL_HANDLES:
-		return 0;
-	case BY_PROTOCOL:
-		ret = efi_search_protocol(handle, protocol, NULL);
-		return (ret != EFI_SUCCESS);
-	default:
-		/* Invalid search type */
-		return -1;
-	}
-}
-
 /**
  * efi_check_register_notify_event() - check if registration key is valid
  *
@@ -1580,6 +1617,8 @@ static efi_status_t efi_locate_handle(
 	efi_uintn_t size = 0;
 	struct efi_register_notify_event *event;
 	struct efi_protocol_notification *handle = NULL;
+	struct efi_protocol_index *idx = NULL;
+	struct efi_handler *handler;
 
 	/* Check parameters */
 	switch (search_type) {
@@ -1610,13 +1649,19 @@ static efi_status_t efi_locate_handle(
 					  link);
 		efiobj = handle->handle;
 		size += sizeof(void *);
-	} else {
-		list_for_each_entry(efiobj, &efi_obj_list, link) {
-			if (!efi_search(search_type, protocol, efiobj))
+	} else if (search_type == BY_PROTOCOL) {
+		idx = efi_protocol_index_find(protocol, false);
+		if (idx) {
+			list_for_each_entry(handler, &idx->handlers, guid_link)
 				size += sizeof(void *);
 		}
 		if (size == 0)
 			return EFI_NOT_FOUND;
+	} else {
+		list_for_each_entry(efiobj, &efi_obj_list, link)
+			size += sizeof(void *);
+		if (size == 0)
+			return EFI_NOT_FOUND;
 	}
 
 	if (!buffer_size)
@@ -1637,11 +1682,12 @@ static efi_status_t efi_locate_handle(
 	if (search_type == BY_REGISTER_NOTIFY) {
 		*buffer = efiobj;
 		list_del(&handle->link);
+	} else if (search_type == BY_PROTOCOL) {
+		list_for_each_entry(handler, &idx->handlers, guid_link)
+			*buffer++ = handler->handle;
 	} else {
-		list_for_each_entry(efiobj, &efi_obj_list, link) {
-			if (!efi_search(search_type, protocol, efiobj))
-				*buffer++ = efiobj;
-		}
+		list_for_each_entry(efiobj, &efi_obj_list, link)
+			*buffer++ = efiobj;
 	}
 
 	return EFI_SUCCESS;
@@ -2191,6 +2237,9 @@ static efi_status_t EFIAPI efi_exit_boot_services(efi_handle_t image_handle,
 	if (!systab.boottime)
 		goto out;
 
+	if (IS_ENABLED(CONFIG_EFI_STATS_BOOTSTAGE))
+		efi_stats_bootstage();
+
 	/* Notify EFI_EVENT_GROUP_BEFORE_EXIT_BOOT_SERVICES event group. */
 	list_for_each_entry(evt, &efi_events, link) {
 		if (evt->group &&
@@ -2231,10 +2280,14 @@ static efi_status_t EFIAPI efi_exit_boot_services(efi_handle_t image_handle,
 			list_del(&evt->link);
 	}
 
+	/* The OS expects to find the secondary CPUs off */
+	cpu_work_stop();
+
 	if (!efi_st_keep_devices) {
 		bootm_disable_interrupts();
 		if (IS_ENABLED(CONFIG_USB_DEVICE))
 			udc_disconnect();
+		blkcache_flush(-1, 0);
 		board_quiesce_devices();
 		dm_remove_devices_active();
 	}
@@ -2657,10 +2710,14 @@ static efi_status_t EFIAPI efi_locate_protocol(const efi_guid_t *protocol,
 		if (ret == EFI_SUCCESS)
 			goto found;
 	} else {
-		list_for_each_entry(efiobj, &efi_obj_list, link) {
-			ret = efi_search_protocol(efiobj, protocol, &handler);
-			if (ret == EFI_SUCCESS)
-				goto found;
+		struct efi_protocol_index *idx;
+
+		idx = efi_protocol_index_find(protocol, false);
+		if (idx && !list_empty(&idx->handlers)) {
+			handler = list_first_entry(&idx->handlers,
+						   struct efi_handler,
+						   guid_link);
+			goto found;
 		}
 	}
 not_found:
@@ -18,12 +18,14 @@
 #include <log.h>
 #include <part.h>
 #include <malloc.h>
+#include <asm/cache.h>
 
 struct efi_system_partition efi_system_partition = {
 	.uclass_id = UCLASS_INVALID,
 };
 
 const efi_guid_t efi_block_io_guid = EFI_BLOCK_IO_PROTOCOL_GUID;
+static const efi_guid_t efi_block_io2_guid = EFI_BLOCK_IO2_PROTOCOL_GUID;
 const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
 
 /**
@@ -31,6 +33,7 @@ const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
  *
  * @header:	EFI object header
  * @ops:	EFI disk I/O protocol interface
+ * @ops2:	EFI disk I/O 2 protocol interface
  * @media:	block I/O media information
  * @dp:		device path to the block device
  * @volume:	simple file system protocol of the partition
@@ -38,6 +41,7 @@ const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
 struct efi_disk_obj {
 	struct efi_object header;
 	struct efi_block_io ops;
+	struct efi_block_io2 ops2;
 	struct efi_block_io_media media;
 	struct efi_device_path *dp;
 	struct efi_simple_file_system_protocol *volume;
@@ -147,6 +151,66 @@ static efi_status_t efi_disk_rw_blocks(struct efi_block_io *this,
 	return EFI_SUCCESS;
 }
 
+/**
+ * efi_disk_map() - get a pointer to the blocks of a disk held in memory
+ *
+ * @this:		pointer to the BLOCK_IO_PROTOCOL
+ * @lba:		starting logical block
+ * @buffer_size:	number of bytes to map
+ * Return:		pointer to the data, or NULL if it must be read
+ */
+static const void *efi_disk_map(struct efi_block_io *this, u64 lba,
+				efi_uintn_t buffer_size)
+{
+	struct efi_disk_obj *diskobj;
+	int blksz;
+
+	diskobj = container_of(this, struct efi_disk_obj, ops);
+	blksz = diskobj->media.block_size;
+	if (buffer_size & (blksz - 1))
+		return NULL;
+
+	if (CONFIG_IS_ENABLED(PARTITIONS) &&
+	    device_get_uclass_id(diskobj->header.dev) == UCLASS_PARTITION)
+		return disk_blk_map(diskobj->header.dev, lba,
+				    buffer_size / blksz);
+
+	return blk_map(diskobj->header.dev, lba, buffer_size / blksz);
+}
+
+/**
+ * efi_disk_check_rw() - check the parameters of a block transfer
+ *
+ * @media:		media of the disk
+ * @media_id:		id of the medium to be accessed
+ * @lba:		starting logical block
+ * @buffer_size:	size of the buffer
+ * @buffer:		pointer to the buffer
+ * @direction:		whether the transfer reads or writes
+ * Return:		status code
+ */
+static efi_status_t efi_disk_check_rw(struct efi_block_io_media *media,
+				      u32 media_id, u64 lba,
+				      efi_uintn_t buffer_size, void *buffer,
+				      enum efi_disk_direction direction)
+{
+	if (direction == EFI_DISK_WRITE && media->read_only)
+		return EFI_WRITE_PROTECTED;
+	/* TODO: check for media changes */
+	if (media_id != media->media_id)
+		return EFI_MEDIA_CHANGED;
+	if (!media->media_present)
+		return EFI_NO_MEDIA;
+	/* media->io_align is a power of 2 or 0 */
+	if (media->io_align && (uintptr_t)buffer & (media->io_align - 1))
+		return EFI_INVALID_PARAMETER;
+	if (lba * media->block_size + buffer_size >
+	    (media->last_block + 1) * media->block_size)
+		return EFI_INVALID_PARAMETER;
+
+	return EFI_SUCCESS;
+}
+
 /**
  * efi_disk_read_blocks() - reads blocks from device
  *
@@ -167,22 +231,24 @@ static efi_status_t EFIAPI efi_disk_read_blocks(struct efi_block_io *this,
 			void *buffer)
 {
 	void *real_buffer = buffer;
+	const void *src;
 	efi_status_t r;
 
 	if (!this)
 		return EFI_INVALID_PARAMETER;
-	/* TODO: check for media changes */
-	if (media_id != this->media->media_id)
-		return EFI_MEDIA_CHANGED;
-	if (!this->media->media_present)
-		return EFI_NO_MEDIA;
-	/* media->io_align is a power of 2 or 0 */
-	if (this->media->io_align &&
-	    (uintptr_t)buffer & (this->media->io_align - 1))
-		return EFI_INVALID_PARAMETER;
-	if (lba * this->media->block_size + buffer_size >
-	    (this->media->last_block + 1) * this->media->block_size)
-		return EFI_INVALID_PARAMETER;
+	r = efi_disk_check_rw(this->media, media_id, lba, buffer_size, buffer,
+			      EFI_DISK_READ);
+	if (r != EFI_SUCCESS)
+		return r;
+
+	/* A disk held in memory is copied out directly, without a bounce */
+	src = efi_disk_map(this, lba, buffer_size);
+	if (src) {
+		EFI_ENTRY("%p, %x, %llx, %zx, %p", this, media_id, lba,
+			  buffer_size, buffer);
+		memcpy(buffer, src, buffer_size);
+		return EFI_EXIT(EFI_SUCCESS);
+	}
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
@@ -237,20 +303,10 @@ static efi_status_t EFIAPI efi_disk_write_blocks(struct efi_block_io *this,
 
 	if (!this)
 		return EFI_INVALID_PARAMETER;
-	if (this->media->read_only)
-		return EFI_WRITE_PROTECTED;
-	/* TODO: check for media changes */
-	if (media_id != this->media->media_id)
-		return EFI_MEDIA_CHANGED;
-	if (!this->media->media_present)
-		return EFI_NO_MEDIA;
-	/* media->io_align is a power of 2 or 0 */
-	if (this->media->io_align &&
-	    (uintptr_t)buffer & (this->media->io_align - 1))
-		return EFI_INVALID_PARAMETER;
-	if (lba * this->media->block_size + buffer_size >
-	    (this->media->last_block + 1) * this->media->block_size)
-		return EFI_INVALID_PARAMETER;
+	r = efi_disk_check_rw(this->media, media_id, lba, buffer_size, buffer,
+			      EFI_DISK_WRITE);
+	if (r != EFI_SUCCESS)
+		return r;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
@@ -307,6 +363,356 @@ static const struct efi_block_io block_io_disk_template = {
 	.flush_blocks = &efi_disk_flush_blocks,
 };
 
+/**
+ * struct efi_disk_io - pending request of the EFI_BLOCK_IO2_PROTOCOL
+ *
+ * @link:	entry in efi_disk_io_list
+ * @disk:	disk object the request was made on
+ * @blk:	block device the request was submitted to
+ * @token:	token to complete once the request is done
+ * @req:	block request
+ */
+struct efi_disk_io {
+	struct list_head link;
+	struct efi_disk_obj *disk;
+	struct udevice *blk;
+	struct efi_block_io2_token *token;
+	struct blk_req req;
+};
+
+/* Requests submitted by ReadBlocksEx() and WriteBlocksEx() */
+static LIST_HEAD(efi_disk_io_list);
+/* Timer event polling for completed requests */
+static struct efi_event *efi_disk_io_event;
+/* Event completing all requests on ExitBootServices() */
+static struct efi_event *efi_disk_io_exit_event;
+
+/**
+ * efi_disk_io_signal() - complete a token of the EFI_BLOCK_IO2_PROTOCOL
+ *
+ * @token:	token, may be NULL
+ * @status:	transaction status
+ */
+static void efi_disk_io_signal(struct efi_block_io2_token *token,
+			       efi_status_t status)
+{
+	if (!token)
+		return;
+	token->transaction_status = status;
+	if (token->event)
+		efi_signal_event(token->event);
+}
+
+/**
+ * efi_disk_io_complete() - complete pending requests
+ *
+ * Wait for the pending requests of @diskobj, or of all disks if @diskobj is
+ * NULL, and signal their tokens. Each request is removed from the list before
+ * its event is signalled, as a notification function may submit a new one.
+ *
+ * @diskobj:	disk object or NULL
+ */
+static void efi_disk_io_complete(struct efi_disk_obj *diskobj)
+{
+	struct efi_disk_io *io;
+	long n;
+
+	for (;;) {
+		bool found = false;
+
+		list_for_each_entry(io, &efi_disk_io_list, link) {
+			if (!diskobj || io->disk == diskobj) {
+				found = true;
+				break;
+			}
+		}
+		if (!found)
+			break;
+
+		n = blk_wait(io->blk, &io->req);
+		EFI_PRINT("n=%lx blocks=%lx\n", n, (ulong)io->req.blkcnt);
+		list_del(&io->link);
+		efi_disk_io_signal(io->token, n == io->req.blkcnt ?
+				   EFI_SUCCESS : EFI_DEVICE_ERROR);
+		free(io);
+	}
+
+	if (efi_disk_io_event && list_empty(&efi_disk_io_list))
+		efi_set_timer(efi_disk_io_event, EFI_TIMER_STOP, 0);
+}
+
+/**
+ * efi_disk_io_notify() - notification function of the polling timer
+ *
+ * U-Boot's block drivers do not raise interrupts. Requests are therefore
+ * completed when the timer fires, i.e. whenever the application checks
+ * events, or when ExitBootServices() is called.
+ *
+ * @event:	timer or exit boot services event
+ * @context:	not used
+ */
+static void EFIAPI efi_disk_io_notify(struct efi_event *event, void *context)
+{
+	EFI_ENTRY("%p, %p", event, context);
+	efi_disk_io_complete(NULL);
+	EFI_EXIT(EFI_SUCCESS);
+}
+
+/**
+ * efi_disk_io_submit() - submit a request of the EFI_BLOCK_IO2_PROTOCOL
+ *
+ * @diskobj:		disk object
+ * @lba:		starting logical block
+ * @token:		token to signal on completion
+ * @buffer_size:	size of the buffer
+ * @buffer:		pointer to the buffer
+ * @direction:		whether the transfer reads or writes
+ * Return:		status code
+ */
+static efi_status_t efi_disk_io_submit(struct efi_disk_obj *diskobj, u64 lba,
+				       struct efi_block_io2_token *token,
+				       efi_uintn_t buffer_size, void *buffer,
+				       enum efi_disk_direction direction)
+{
+	struct udevice *dev = diskobj->header.dev;
+	u32 blksz = diskobj->media.block_size;
+	struct efi_disk_io *io;
+	efi_status_t r;
+	int ret;
+
+	/* We only support full block access */
+	if (buffer_size & (blksz - 1))
+		return EFI_BAD_BUFFER_SIZE;
+	if (!buffer_size) {
+		efi_disk_io_signal(token, EFI_SUCCESS);
+		return EFI_SUCCESS;
+	}
+
+	/* Nothing may stay in flight once the OS owns the memory */
+	if (!efi_disk_io_exit_event) {
+		r = efi_create_event(EVT_SIGNAL_EXIT_BOOT_SERVICES,
+				     TPL_CALLBACK, efi_disk_io_notify, NULL,
+				     NULL, &efi_disk_io_exit_event);
+		if (r != EFI_SUCCESS)
+			return EFI_OUT_OF_RESOURCES;
+	}
+	if (!efi_disk_io_event) {
+		r = efi_create_event(EVT_TIMER | EVT_NOTIFY_SIGNAL,
+				     TPL_CALLBACK, efi_disk_io_notify, NULL,
+				     NULL, &efi_disk_io_event);
+		if (r != EFI_SUCCESS)
+			return EFI_OUT_OF_RESOURCES;
+	}
+
+	io = calloc(1, sizeof(*io));
+	if (!io)
+		return EFI_OUT_OF_RESOURCES;
+	io->disk = diskobj;
+	io->token = token;
+	io->req.op = direction == EFI_DISK_READ ? BLK_REQ_READ : BLK_REQ_WRITE;
+	io->req.start = lba;
+	io->req.blkcnt = buffer_size / blksz;
+	io->req.buf = buffer;
+
+	EFI_PRINT("blocks=%lx lba=%llx blksz=%x dir=%d\n",
+		  (ulong)io->req.blkcnt, lba, blksz, direction);
+
+	if (CONFIG_IS_ENABLED(PARTITIONS) &&
+	    device_get_uclass_id(dev) == UCLASS_PARTITION) {
+		io->blk = dev_get_parent(dev);
+		ret = disk_blk_submit(dev, &io->req);
+	} else {
+		/* dev is a block device (UCLASS_BLK) */
+		io->blk = dev;
+		ret = blk_submit(dev, &io->req);
+	}
+	if (ret) {
+		free(io);
+		return EFI_DEVICE_ERROR;
+	}
+
+	list_add_tail(&io->link, &efi_disk_io_list);
+	efi_set_timer(efi_disk_io_event, EFI_TIMER_PERIODIC, 0);
+
+	return EFI_SUCCESS;
+}
+
+/**
+ * efi_disk_reset_ex() - reset block device
+ *
+ * This function implements the Reset service of the EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * Pending requests are completed as U-Boot cannot abort them.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @extended_verification:	extended verification
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_reset_ex(struct efi_block_io2 *this,
+					     bool extended_verification)
+{
+	EFI_ENTRY("%p, %x", this, extended_verification);
+
+	if (!this)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+	efi_disk_io_complete(container_of(this, struct efi_disk_obj, ops2));
+
+	return EFI_EXIT(EFI_SUCCESS);
+}
+
+/**
+ * efi_disk_rw_blocks_ex() - read or write blocks asynchronously
+ *
+ * Without a token event, or when a bounce buffer is needed, the transfer is
+ * done synchronously by the EFI_BLOCK_IO_PROTOCOL.
+ *
+ * @this:		pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:		id of the medium to be accessed
+ * @lba:		starting logical block
+ * @token:		token to signal on completion
+ * @buffer_size:	size of the buffer
+ * @buffer:		pointer to the buffer
+ * @direction:		whether the transfer reads or writes
+ * Return:		status code
+ */
+static efi_status_t efi_disk_rw_blocks_ex(struct efi_block_io2 *this,
+			u32 media_id, u64 lba,
+			struct efi_block_io2_token *token,
+			efi_uintn_t buffer_size, void *buffer,
+			enum efi_disk_direction direction)
+{
+	struct efi_disk_obj *diskobj;
+	efi_status_t r;
+
+	if (!this)
+		return EFI_INVALID_PARAMETER;
+	diskobj = container_of(this, struct efi_disk_obj, ops2);
+
+	if (!token || !token->event ||
+	    IS_ENABLED(CONFIG_EFI_LOADER_BOUNCE_BUFFER)) {
+		if (direction == EFI_DISK_READ)
+			r = EFI_CALL(efi_disk_read_blocks(&diskobj->ops,
+							  media_id, lba,
+							  buffer_size,
+							  buffer));
+		else
+			r = EFI_CALL(efi_disk_write_blocks(&diskobj->ops,
+							   media_id, lba,
+							   buffer_size,
+							   buffer));
+		if (r == EFI_SUCCESS)
+			efi_disk_io_signal(token, EFI_SUCCESS);
+		return r;
+	}
+
+	r = efi_disk_check_rw(this->media, media_id, lba, buffer_size, buffer,
+			      direction);
+	if (r != EFI_SUCCESS)
+		return r;
+
+	return efi_disk_io_submit(diskobj, lba, token, buffer_size, buffer,
+				  direction);
+}
+
+/**
+ * efi_disk_read_blocks_ex() - reads blocks from device
+ *
+ * This function implements the ReadBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:			id of the medium to be read from
+ * @lba:			starting logical block for reading
+ * @token:			token to signal on completion
+ * @buffer_size:		size of the read buffer
+ * @buffer:			pointer to the destination buffer
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_read_blocks_ex(struct efi_block_io2 *this,
+			u32 media_id, u64 lba,
+			struct efi_block_io2_token *token,
+			efi_uintn_t buffer_size, void *buffer)
+{
+	EFI_ENTRY("%p, %x, %llx, %p, %zx, %p", this, media_id, lba, token,
+		  buffer_size, buffer);
+
+	return EFI_EXIT(efi_disk_rw_blocks_ex(this, media_id, lba, token,
+					      buffer_size, buffer,
+					      EFI_DISK_READ));
+}
+
+/**
+ * efi_disk_write_blocks_ex() - writes blocks to device
+ *
+ * This function implements the WriteBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:			id of the medium to be written to
+ * @lba:			starting logical block for writing
+ * @token:			token to signal on completion
+ * @buffer_size:		size of the write buffer
+ * @buffer:			pointer to the source buffer
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_write_blocks_ex(struct efi_block_io2 *this,
+			u32 media_id, u64 lba,
+			struct efi_block_io2_token *token,
+			efi_uintn_t buffer_size, void *buffer)
+{
+	EFI_ENTRY("%p, %x, %llx, %p, %zx, %p", this, media_id, lba, token,
+		  buffer_size, buffer);
+
+	return EFI_EXIT(efi_disk_rw_blocks_ex(this, media_id, lba, token,
+					      buffer_size, buffer,
+					      EFI_DISK_WRITE));
+}
+
+/**
+ * efi_disk_flush_blocks_ex() - flushes modified data to the device
+ *
+ * This function implements the FlushBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL.
+ *
+ * Pending requests of the disk are completed before @token is signalled.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @token:			token to signal on completion
+ * Return:			status code
+ */
+static efi_status_t EFIAPI
+efi_disk_flush_blocks_ex(struct efi_block_io2 *this,
+			 struct efi_block_io2_token *token)
+{
+	EFI_ENTRY("%p, %p", this, token);
+
+	if (!this)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+	efi_disk_io_complete(container_of(this, struct efi_disk_obj, ops2));
+	efi_disk_io_signal(token, EFI_SUCCESS);
+
+	return EFI_EXIT(EFI_SUCCESS);
+}
+
+static const struct efi_block_io2 block_io2_disk_template = {
+	.reset = &efi_disk_reset_ex,
+	.read_blocks_ex = &efi_disk_read_blocks_ex,
+	.write_blocks_ex = &efi_disk_write_blocks_ex,
+	.flush_blocks_ex = &efi_disk_flush_blocks_ex,
+};
+
 /**
  * efi_fs_from_path() - retrieve simple file system protocol
  *
@@ -380,6 +786,7 @@ static void efi_disk_free_diskobj(struct efi_disk_obj *diskobj)
 	 * ignore error of efi_delete_handle() since this function
 	 * is expected to be called in error path.
 	 */
+	efi_disk_io_complete(diskobj);
 	efi_delete_handle(&diskobj->header);
 	efi_free_pool(dp);
 	free(volume);
@@ -464,7 +871,7 @@ static efi_status_t efi_disk_add_dev(
 	}
 
 	/*
-	 * Install the device path and the block IO protocol.
+	 * Install the device path and the block IO protocols.
 	 *
 	 * InstallMultipleProtocolInterfaces() checks if the device path is
 	 * already installed on an other handle and returns EFI_ALREADY_STARTED
@@ -475,6 +882,7 @@ static efi_status_t efi_disk_add_dev(
 					&handle,
 					&efi_guid_device_path, diskobj->dp,
 					&efi_block_io_guid, &diskobj->ops,
+					&efi_block_io2_guid, &diskobj->ops2,
 					/*
 					 * esp_guid must be last entry as it
 					 * can be NULL. Its interface is NULL.
@@ -504,6 +912,7 @@ static efi_status_t efi_disk_add_dev(
 			goto error;
 	}
 	diskobj->ops = block_io_disk_template;
+	diskobj->ops2 = block_io2_disk_template;
 
 	/* Fill in EFI IO Media info (for read/write callbacks) */
 	diskobj->media.removable_media = desc->removable;
@@ -514,10 +923,15 @@ static efi_status_t efi_disk_add_dev(
 	 */
 	diskobj->media.media_id = 1;
 	diskobj->media.block_size = desc->blksz;
-	diskobj->media.io_align = desc->blksz;
+	/*
+	 * Buffers need to meet the DMA alignment of the controllers, not the
+	 * block size.
+	 */
+	diskobj->media.io_align = ARCH_DMA_MINALIGN;
 	if (part)
 		diskobj->media.logical_partition = 1;
 	diskobj->ops.media = &diskobj->media;
+	diskobj->ops2.media = &diskobj->media;
 	if (disk)
 		*disk = diskobj;
 
@@ -750,6 +1164,7 @@ int efi_disk_remove(void *ctx, struct event *event)
 	dp = diskobj->dp;
 	volume = diskobj->volume;
 
+	efi_disk_io_complete(diskobj);
 	ret = efi_delete_handle(handle);
 	/* Do not delete DM device if there are still EFI drivers attached. */
 	if (ret != EFI_SUCCESS)
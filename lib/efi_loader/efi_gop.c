@@ -28,6 +28,7 @@ static const efi_guid_t efi_gop_guid = EFI_GRAPHICS_OUTPUT_PROTOCOL_GUID;
  * @mode:	graphical output mode
  * @bpix:	bits per pixel
  * @fb:		frame buffer
+ * @vdev:	video device
  */
 struct efi_gop_obj {
 	struct efi_object header;
@@ -37,6 +38,7 @@ struct efi_gop_obj {
 	/* Fields we only have access to during init */
 	u32 bpix;
 	void *fb;
+	struct udevice *vdev;
 };
 
 static efi_status_t EFIAPI gop_query_mode(struct efi_gop *this, u32 mode_number,
@@ -119,8 +121,12 @@ static __always_inline efi_status_t gop_blt_int(struct efi_gop *this,
 {
 	struct efi_gop_obj *gopobj = container_of(this, struct efi_gop_obj, ops);
 	efi_uintn_t i, j, linelen, slineoff = 0, dlineoff, swidth, dwidth;
+	efi_uintn_t pbytes;
+	u8 *fb = gopobj->fb, *src, *dst;
 	u32 *fb32 = gopobj->fb;
 	u16 *fb16 = gopobj->fb;
+	long stride;
+	u32 col;
 	struct efi_gop_pixel *buffer = __builtin_assume_aligned(bufferp, 4);
 
 	if (delta) {
@@ -194,55 +200,90 @@ static __always_inline efi_status_t gop_blt_int(struct efi_gop *this,
 		break;
 	}
 
-	slineoff = swidth * sy;
-	dlineoff = dwidth * dy;
-	for (i = 0; i < height; i++) {
+	if (!width || !height)
+		return EFI_SUCCESS;
+
+	pbytes = vid_bpp == 16 ? 2 : 4;
+	slineoff = swidth * sy + sx;
+	dlineoff = dwidth * dy + dx;
+
+	switch (operation) {
+	case EFI_BLT_VIDEO_FILL:
+		/* Convert the colour once, fill one row and copy it to the others */
+		if (vid_bpp == 32)
+			col = *(u32 *)buffer;
+		else if (vid_bpp == 30)
+			col = efi_blt_col_to_vid30(buffer);
+		else
+			col = efi_blt_col_to_vid16(buffer);
 		for (j = 0; j < width; j++) {
-			struct efi_gop_pixel pix;
-
-			/* Read source pixel */
-			switch (operation) {
-			case EFI_BLT_VIDEO_FILL:
-				pix = *buffer;
-				break;
-			case EFI_BLT_BUFFER_TO_VIDEO:
-				pix = buffer[slineoff + j + sx];
-				break;
-			case EFI_BLT_VIDEO_TO_BLT_BUFFER:
-			case EFI_BLT_VIDEO_TO_VIDEO:
-				if (vid_bpp == 32)
-					pix = *(struct efi_gop_pixel *)&fb32[
-						slineoff + j + sx];
-				else if (vid_bpp == 30)
-					pix = efi_vid30_to_blt_col(fb32[
-						slineoff + j + sx]);
-				else
-					pix = efi_vid16_to_blt_col(fb16[
-						slineoff + j + sx]);
-				break;
+			if (vid_bpp == 16)
+				fb16[dlineoff + j] = col;
+			else
+				fb32[dlineoff + j] = col;
+		}
+		src = fb + dlineoff * pbytes;
+		for (i = 1; i < height; i++)
+			memcpy(src + i * dwidth * pbytes, src, width * pbytes);
+		break;
+	case EFI_BLT_VIDEO_TO_VIDEO:
+		/*
+		 * Both rectangles are in the frame-buffer format, so move whole
+		 * rows. Go upwards when the destination is lower down, so that
+		 * overlapping rows are read before they are overwritten.
+		 */
+		src = fb + slineoff * pbytes;
+		dst = fb + dlineoff * pbytes;
+		stride = dwidth * pbytes;
+		if (dy > sy) {
+			src += (height - 1) * stride;
+			dst += (height - 1) * stride;
+			stride = -stride;
+		}
+		for (i = 0; i < height; i++) {
+			memmove(dst, src, width * pbytes);
+			src += stride;
+			dst += stride;
+		}
+		break;
+	case EFI_BLT_BUFFER_TO_VIDEO:
+		for (i = 0; i < height; i++) {
+			struct efi_gop_pixel *pix = &buffer[slineoff];
+
+			if (vid_bpp == 32) {
+				memcpy(&fb32[dlineoff], pix, width * 4);
+			} else if (vid_bpp == 30) {
+				for (j = 0; j < width; j++)
+					fb32[dlineoff + j] =
+						efi_blt_col_to_vid30(&pix[j]);
+			} else {
+				for (j = 0; j < width; j++)
+					fb16[dlineoff + j] =
+						efi_blt_col_to_vid16(&pix[j]);
 			}
-
-			/* Write destination pixel */
-			switch (operation) {
-			case EFI_BLT_VIDEO_TO_BLT_BUFFER:
-				buffer[dlineoff + j + dx] = pix;
-				break;
-			case EFI_BLT_BUFFER_TO_VIDEO:
-			case EFI_BLT_VIDEO_FILL:
-			case EFI_BLT_VIDEO_TO_VIDEO:
-				if (vid_bpp == 32)
-					fb32[dlineoff + j + dx] = *(u32 *)&pix;
-				else if (vid_bpp == 30)
-					fb32[dlineoff + j + dx] =
-						efi_blt_col_to_vid30(&pix);
-				else
-					fb16[dlineoff + j + dx] =
-						efi_blt_col_to_vid16(&pix);
-				break;
+			slineoff += swidth;
+			dlineoff += dwidth;
+		}
+		break;
+	case EFI_BLT_VIDEO_TO_BLT_BUFFER:
+		for (i = 0; i < height; i++) {
+			struct efi_gop_pixel *pix = &buffer[dlineoff];
+
+			if (vid_bpp == 32) {
+				memcpy(pix, &fb32[slineoff], width * 4);
+			} else if (vid_bpp == 30) {
+				for (j = 0; j < width; j++)
+					pix[j] = efi_vid30_to_blt_col(
+						fb32[slineoff + j]);
+			} else {
+				for (j = 0; j < width; j++)
+					pix[j] = efi_vid16_to_blt_col(
+						fb16[slineoff + j]);
 			}
+			slineoff += swidth;
+			dlineoff += dwidth;
 		}
-		slineoff += swidth;
-		dlineoff += dwidth;
+		break;
 	}
 
 	return EFI_SUCCESS;
@@ -409,6 +450,7 @@ static efi_status_t EFIAPI gop_blt(struct efi_gop *this,
 				   efi_uintn_t dy, efi_uintn_t width,
 				   efi_uintn_t height, efi_uintn_t delta)
 {
+	struct efi_gop_obj *gopobj = container_of(this, struct efi_gop_obj, ops);
 	efi_status_t ret = EFI_INVALID_PARAMETER;
 	efi_uintn_t vid_bpp;
 
@@ -453,7 +495,11 @@ static efi_status_t EFIAPI gop_blt(struct efi_gop *this,
 	if (ret != EFI_SUCCESS)
 		return EFI_EXIT(ret);
 
-	video_sync_all();
+	/* only the rectangle drawn is flushed, and only on this device */
+	if (operation != EFI_BLT_VIDEO_TO_BLT_BUFFER) {
+		video_damage(gopobj->vdev, dx, dy, width, height);
+		video_sync(gopobj->vdev, true);
+	}
 
 	return EFI_EXIT(EFI_SUCCESS);
 }
@@ -487,6 +533,9 @@ efi_status_t efi_gop_register(void)
 	row = video_get_ysize(vdev);
 
 	plat = dev_get_uclass_plat(vdev);
+	/* EFI applications write to the frame buffer directly */
+	if (video_pan_disable(vdev))
+		debug("WARNING: Cannot reset display start\n");
 	fb_base = IS_ENABLED(CONFIG_VIDEO_COPY) ? plat->copy_base : plat->base;
 	fb_size = plat->size;
 
@@ -551,6 +600,7 @@ efi_status_t efi_gop_register(void)
 	gopobj->info.pixels_per_scanline = col;
 	gopobj->bpix = bpix;
 	gopobj->fb = map_sysmem(fb_base, fb_size);
+	gopobj->vdev = vdev;
 
 	return EFI_SUCCESS;
 }
@@ -11,6 +11,7 @@
 
 #include <cpu_func.h>
 #include <efi_loader.h>
+#include <efi_variable.h>
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
@@ -121,17 +122,28 @@ static efi_status_t efi_loader_relocate(const IMAGE_BASE_RELOCATION *rel,
 	if (delta == 0)
 		return EFI_SUCCESS;
 
+	/*
+	 * Each block covers one page of the image, so all fixups of a block
+	 * hit the same few cache lines.
+	 */
 	end = (const IMAGE_BASE_RELOCATION *)((const char *)rel + rel_size);
 	while (rel + 1 < end && rel->SizeOfBlock) {
 		const uint16_t *relocs = (const uint16_t *)(rel + 1);
+		void *page = efi_reloc + rel->VirtualAddress;
+
+		if (rel->SizeOfBlock < sizeof(*rel) ||
+		    rel->SizeOfBlock > (const char *)end - (const char *)rel) {
+			log_err("Invalid relocation block size %x\n",
+				rel->SizeOfBlock);
+			return EFI_LOAD_ERROR;
+		}
 		i = (rel->SizeOfBlock - sizeof(*rel)) / sizeof(uint16_t);
 		while (i--) {
-			uint32_t offset = (uint32_t)(*relocs & 0xfff) +
-					  rel->VirtualAddress;
+			uint32_t offset = (uint32_t)(*relocs & 0xfff);
 			int type = *relocs >> EFI_PAGE_SHIFT;
-			uint64_t *x64 = efi_reloc + offset;
-			uint32_t *x32 = efi_reloc + offset;
-			uint16_t *x16 = efi_reloc + offset;
+			uint64_t *x64 = page + offset;
+			uint32_t *x32 = page + offset;
+			uint16_t *x16 = page + offset;
 
 			switch (type) {
 			case IMAGE_REL_BASED_ABSOLUTE:
@@ -164,7 +176,7 @@ static efi_status_t efi_loader_relocate(const IMAGE_BASE_RELOCATION *rel,
 #endif
 			default:
 				log_err("Unknown Relocation off %x type %x\n",
-					offset, type);
+					offset + rel->VirtualAddress, type);
 				return EFI_LOAD_ERROR;
 			}
 			relocs++;
@@ -241,6 +253,9 @@ efi_status_t efi_image_region_add(struct efi_image_regions *regs,
 	if (end < start)
 		return EFI_INVALID_PARAMETER;
 
+	/* the cached digest no longer covers all regions */
+	regs->digest_algo = NULL;
+
 	for (i = 0; i < regs->num; i++) {
 		reg = &regs->reg[i];
 		if (nocheck)
@@ -546,15 +561,14 @@ static bool efi_image_verify_digest(struct efi_image_regions *regs,
 
 	/* calculate a hash value of PE image */
 	hash = NULL;
-	if (!efi_hash_regions(regs->reg, regs->num, &hash, ctx.digest_algo,
-			      &hash_len))
+	if (!efi_image_regions_hash(regs, ctx.digest_algo, &hash, &hash_len))
 		return false;
 
 	/* match the digest */
-	if (ctx.digest_len != hash_len || memcmp(ctx.digest, hash, hash_len))
-		return false;
+	ret = ctx.digest_len == hash_len && !memcmp(ctx.digest, hash, hash_len);
+	free(hash);
 
-	return true;
+	return ret;
 }
 
 /**
@@ -609,13 +623,13 @@ static bool efi_image_authenticate(void *efi, size_t efi_size)
 	/*
 	 * verify signature using db and dbx
 	 */
-	db = efi_sigstore_parse_sigdb(u"db");
+	db = efi_sigstore_get(EFI_AUTH_VAR_DB);
 	if (!db) {
 		log_err("Getting signature database(db) failed\n");
 		goto out;
 	}
 
-	dbx = efi_sigstore_parse_sigdb(u"dbx");
+	dbx = efi_sigstore_get(EFI_AUTH_VAR_DBX);
 	if (!dbx) {
 		log_err("Getting signature database(dbx) failed\n");
 		goto out;
@@ -744,8 +758,6 @@ static bool efi_image_authenticate(void *efi, size_t efi_size)
 		ret = true;
 
 out:
-	efi_sigstore_free(db);
-	efi_sigstore_free(dbx);
 	pkcs7_free_message(msg);
 	free(regs);
 	if (new_efi != efi)
@@ -958,10 +970,12 @@ efi_status_t efi_load_pe(struct efi_loaded_image_obj *handle,
 		IMAGE_SECTION_HEADER *sec = &sections[i];
 		u32 copy_size = section_size(sec);
 
+		/* Only zero the part beyond the raw data */
 		if (copy_size > sec->SizeOfRawData) {
+			memset(efi_reloc + sec->VirtualAddress +
+			       sec->SizeOfRawData, 0,
+			       copy_size - sec->SizeOfRawData);
 			copy_size = sec->SizeOfRawData;
-			memset(efi_reloc + sec->VirtualAddress, 0,
-			       sec->Misc.VirtualSize);
 		}
 		memcpy(efi_reloc + sec->VirtualAddress,
 		       efi + sec->PointerToRawData,
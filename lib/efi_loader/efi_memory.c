@@ -7,6 +7,7 @@
 
 #define LOG_CATEGORY LOGC_EFI
 
+#include <alist.h>
 #include <efi_loader.h>
 #include <init.h>
 #include <lmb.h>
@@ -17,7 +18,9 @@
 #include <asm/cache.h>
 #include <asm/global_data.h>
 #include <asm/sections.h>
-#include <linux/list_sort.h>
+#include <linux/bitops.h>
+#include <linux/list.h>
+#include <linux/log2.h>
 #include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -27,19 +30,11 @@ DECLARE_GLOBAL_DATA_PTR;
 
 efi_uintn_t efi_memory_map_key;
 
-struct efi_mem_list {
-	struct list_head link;
-	struct efi_mem_desc desc;
+/* This array contains all memory map items, in ascending address order */
+static struct alist efi_mem = {
+	.obj_size = sizeof(struct efi_mem_desc),
 };
 
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
-#define EFI_CARVE_OUT_OF_RESOURCES	-4
-
-/* This list contains all memory map items */
-static LIST_HEAD(efi_mem);
-
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
 #endif
@@ -51,9 +46,9 @@ void *efi_bounce_buffer;
  * @checksum:	checksum
  * @data:	allocated pool memory
  *
- * U-Boot services each UEFI AllocatePool() request as a separate
- * (multiple) page allocation. We have to track the number of pages
- * to be able to free the correct amount later.
+ * U-Boot services each UEFI AllocatePool() request larger than
+ * EFI_POOL_SLAB_MAX as a separate (multiple) page allocation. We have to
+ * track the number of pages to be able to free the correct amount later.
  *
  * The checksum calculated in function checksum() is used in FreePool() to avoid
  * freeing memory not allocated by AllocatePool() and duplicate freeing.
@@ -83,31 +78,139 @@ static u64 checksum(struct efi_pool_allocation *alloc)
 	return ret;
 }
 
+/* Smallest and largest object served from a slab */
+#define EFI_POOL_SLAB_MIN	(ARCH_DMA_MINALIGN > 64 ? ARCH_DMA_MINALIGN : 64)
+#define EFI_POOL_SLAB_MAX	1024
+
 /**
- * efi_mem_cmp() - comparator function for sorting memory map
- *
- * Sorts the memory list from highest address to lowest address
+ * struct efi_pool_slab - page shared by small pool allocations
+ *
+ * @num_pages:		always 0, tells a slab from a struct efi_pool_allocation
+ * @checksum:		checksum, calculated as for struct efi_pool_allocation
+ * @link:		entry in efi_pool_slabs
+ * @used:		bitmap of the allocated objects
+ * @memory_type:	memory type of the page and all objects in it
+ * @obj_size:		size of each object, a power of two
+ * @obj_count:		number of objects in the page
+ * @data:		objects
+ *
+ * Pool requests of up to EFI_POOL_SLAB_MAX bytes are rounded up to a power
+ * of two and served from a page holding objects of that size and of the same
+ * memory type, so they need neither a page of their own nor an update of the
+ * memory map. The page is only in the memory map as a whole, with the memory
+ * type of the objects.
+ */
+struct efi_pool_slab {
+	u64 num_pages;
+	u64 checksum;
+	struct list_head link;
+	u64 used;
+	u32 memory_type;
+	u16 obj_size;
+	u16 obj_count;
+	char data[] __aligned(EFI_POOL_SLAB_MIN);
+};
+
+/* All slabs, the ones with free objects first */
+static LIST_HEAD(efi_pool_slabs);
+/* Empty slab kept for the next allocation */
+static struct efi_pool_slab *efi_pool_spare;
+
+static bool efi_pool_slab_full(struct efi_pool_slab *slab)
+{
+	return slab->used == GENMASK_ULL(slab->obj_count - 1, 0);
+}
+
+/**
+ * efi_pool_slab_alloc() - allocate small memory from a slab
  *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
+ * @pool_type:	type of the pool from which memory is to be allocated
+ * @size:	number of bytes to be allocated, at most EFI_POOL_SLAB_MAX
+ * @buffer:	allocated memory
+ * Return:	status code
+ */
+static efi_status_t efi_pool_slab_alloc(enum efi_memory_type pool_type,
+					efi_uintn_t size, void **buffer)
+{
+	struct efi_pool_slab *slab;
+	efi_status_t r;
+	uint i;
+	u64 addr;
+
+	size = roundup_pow_of_two(max_t(efi_uintn_t, size, EFI_POOL_SLAB_MIN));
+
+	list_for_each_entry(slab, &efi_pool_slabs, link) {
+		/* only full slabs follow */
+		if (efi_pool_slab_full(slab))
+			break;
+		if (slab->memory_type == pool_type && slab->obj_size == size)
+			goto found;
+	}
+
+	r = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, pool_type, 1, &addr);
+	if (r != EFI_SUCCESS)
+		return r;
+
+	slab = (struct efi_pool_slab *)(uintptr_t)addr;
+	slab->num_pages = 0;
+	slab->checksum = checksum((struct efi_pool_allocation *)slab);
+	slab->used = 0;
+	slab->memory_type = pool_type;
+	slab->obj_size = size;
+	slab->obj_count = (EFI_PAGE_SIZE - offsetof(struct efi_pool_slab, data)) /
+			  size;
+	list_add(&slab->link, &efi_pool_slabs);
+
+found:
+	if (slab == efi_pool_spare)
+		efi_pool_spare = NULL;
+
+	i = __ffs64(~slab->used);
+	slab->used |= BIT_ULL(i);
+	if (efi_pool_slab_full(slab))
+		list_move_tail(&slab->link, &efi_pool_slabs);
+
+	*buffer = slab->data + i * size;
+
+	return EFI_SUCCESS;
+}
+
+/**
+ * efi_pool_slab_free() - free memory allocated from a slab
  *
- * @priv:	unused
- * @a:		first memory area
- * @b:		second memory area
- * Return:	1 if @a is before @b, -1 if @b is before @a, 0 if equal
+ * @slab:	slab containing @buffer
+ * @buffer:	start of memory to be freed
+ * Return:	status code
  */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
+static efi_status_t efi_pool_slab_free(struct efi_pool_slab *slab,
+				       void *buffer)
 {
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
-
-	if (mema->desc.physical_start == memb->desc.physical_start)
-		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
+	uintptr_t offs = (uintptr_t)buffer - (uintptr_t)slab->data;
+	uint i = offs / slab->obj_size;
+
+	if ((uintptr_t)buffer < (uintptr_t)slab->data ||
+	    offs % slab->obj_size || i >= slab->obj_count ||
+	    !(slab->used & BIT_ULL(i))) {
+		printf("%s: illegal free 0x%p\n", __func__, buffer);
+		return EFI_INVALID_PARAMETER;
+	}
+
+	if (efi_pool_slab_full(slab))
+		list_move(&slab->link, &efi_pool_slabs);
+	slab->used &= ~BIT_ULL(i);
+	if (slab->used)
+		return EFI_SUCCESS;
+
+	/* Keep one empty slab, so that alloc/free pairs stay cheap */
+	if (!efi_pool_spare) {
+		efi_pool_spare = slab;
+		return EFI_SUCCESS;
+	}
+
+	list_del(&slab->link);
+	slab->checksum = 0;
+
+	return efi_free_pages((uintptr_t)slab, 1);
 }
 
 /**
@@ -122,139 +225,72 @@ static uint64_t desc_get_end(struct efi_mem_desc *desc)
 }
 
 /**
- * efi_mem_sort() - sort memory map
+ * efi_mem_find() - find the first memory map entry ending after an address
+ *
+ * The entries do not overlap, so their end addresses are in ascending order
+ * as well and can be bisected.
  *
- * Sort the memory map and then try to merge adjacent memory areas.
+ * @addr:	address
+ * Return:	index of the entry, the number of entries if there is none
  */
-static void efi_mem_sort(void)
+static uint efi_mem_find(u64 addr)
 {
-	struct efi_mem_list *lmem;
-	struct efi_mem_list *prevmem = NULL;
-	bool merge_again = true;
-
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
-
-	/* Now merge entries that can be merged */
-	while (merge_again) {
-		merge_again = false;
-		list_for_each_entry(lmem, &efi_mem, link) {
-			struct efi_mem_desc *prev;
-			struct efi_mem_desc *cur;
-			uint64_t pages;
-
-			if (!prevmem) {
-				prevmem = lmem;
-				continue;
-			}
-
-			cur = &lmem->desc;
-			prev = &prevmem->desc;
-
-			if ((desc_get_end(cur) == prev->physical_start) &&
-			    (prev->type == cur->type) &&
-			    (prev->attribute == cur->attribute)) {
-				/* There is an existing map before, reuse it */
-				pages = cur->num_pages;
-				prev->num_pages += pages;
-				prev->physical_start -= pages << EFI_PAGE_SHIFT;
-				prev->virtual_start -= pages << EFI_PAGE_SHIFT;
-				list_del(&lmem->link);
-				free(lmem);
-
-				merge_again = true;
-				break;
-			}
-
-			prevmem = lmem;
-		}
+	struct efi_mem_desc *map = efi_mem.data;
+	uint lo = 0, hi = efi_mem.count;
+
+	while (lo < hi) {
+		uint mid = lo + (hi - lo) / 2;
+
+		if (desc_get_end(&map[mid]) <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+
+	return lo;
 }
 
 /**
- * efi_mem_carve_out() - unmap memory region
- *
- * @map:			memory map
- * @carve_desc:			memory region to unmap
- * @overlap_conventional:	the carved out region may only overlap free,
- *				or conventional memory
- * Return:			the number of overlapping pages which have been
- *				removed from the map,
- *				EFI_CARVE_NO_OVERLAP, if the regions don't
- *				overlap, EFI_CARVE_OVERLAPS_NONRAM, if the carve
- *				and map overlap, and the map contains anything
- *				but free ram(only when overlap_conventional is
- *				true),
- *				EFI_CARVE_LOOP_AGAIN, if the mapping list should
- *				be traversed again, as it has been altered.
- *
- * Unmaps all memory occupied by the carve_desc region from the list entry
- * pointed to by map.
- *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to re-add the already carved out pages to the mapping.
+ * efi_mem_can_merge() - check whether two memory areas can be merged
+ *
+ * @a:		memory area
+ * @b:		memory area following @a
+ * Return:	true if @b directly follows @a and both are of the same kind
  */
-static s64 efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_conventional)
+static bool efi_mem_can_merge(struct efi_mem_desc *a, struct efi_mem_desc *b)
 {
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_conventional && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
-		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.virtual_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
-		}
+	return desc_get_end(a) == b->physical_start && a->type == b->type &&
+	       a->attribute == b->attribute;
+}
 
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
-	}
+/**
+ * efi_mem_replace() - replace a range of memory map entries
+ *
+ * @first:	index of the first entry to replace
+ * @count:	number of entries to replace
+ * @desc:	entries to put in their place
+ * @num:	number of entries in @desc
+ * Return:	0 if OK, -ENOMEM if the map cannot grow
+ */
+static int efi_mem_replace(uint first, uint count,
+			   const struct efi_mem_desc *desc, uint num)
+{
+	struct efi_mem_desc *map;
+	uint new_count = efi_mem.count - count + num;
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
+	if (new_count > efi_mem.alloc &&
+	    !alist_expand_by(&efi_mem, max_t(uint, efi_mem.alloc,
+					     new_count - efi_mem.alloc)))
+		return -ENOMEM;
 
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	if (!newmap)
-		return EFI_CARVE_OUT_OF_RESOURCES;
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.virtual_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
-
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
-
-	return EFI_CARVE_LOOP_AGAIN;
+	map = efi_mem.data;
+	memmove(&map[first + num], &map[first + count],
+		(efi_mem.count - first - count) * sizeof(*map));
+	if (num)
+		memcpy(&map[first], desc, num * sizeof(*map));
+	efi_mem.count = new_count;
+
+	return 0;
 }
 
 /**
@@ -272,11 +308,10 @@ efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 				   int memory_type,
 				   bool overlap_conventional)
 {
-	struct efi_mem_list *lmem;
-	struct efi_mem_list *newlist;
-	bool carve_again;
-	uint64_t carved_pages = 0;
+	struct efi_mem_desc *map, parts[3];
 	struct efi_event *evt;
+	uint first, last, idx, num = 0;
+	u64 end, covered = 0;
 
 	EFI_PRINT("%s: 0x%llx 0x%llx %d %s\n", __func__,
 		  start, pages, memory_type, overlap_conventional ?
@@ -288,85 +323,89 @@ efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 	if (!pages)
 		return EFI_SUCCESS;
 
-	++efi_memory_map_key;
-	newlist = calloc(1, sizeof(*newlist));
-	if (!newlist)
-		return EFI_OUT_OF_RESOURCES;
-	newlist->desc.type = memory_type;
-	newlist->desc.physical_start = start;
-	newlist->desc.virtual_start = start;
-	newlist->desc.num_pages = pages;
+	end = start + (pages << EFI_PAGE_SHIFT);
 
+	/* Find the entries overlapping the new one */
+	map = efi_mem.data;
+	first = efi_mem_find(start);
+	for (last = first; last < efi_mem.count; last++) {
+		if (map[last].physical_start >= end)
+			break;
+		if (!overlap_conventional)
+			continue;
+		/*
+		 * The user requested to only have RAM overlaps, but we hit a
+		 * non-RAM region. Error out.
+		 */
+		if (map[last].type != EFI_CONVENTIONAL_MEMORY)
+			return EFI_NO_MAPPING;
+		covered += min(desc_get_end(&map[last]), end) -
+			   max(map[last].physical_start, start);
+	}
+
+	if (overlap_conventional && covered != end - start) {
+		/*
+		 * The payload wanted to have RAM overlaps, but we overlapped
+		 * with an unallocated region. Error out.
+		 */
+		return EFI_NO_MAPPING;
+	}
+
+	/* Keep what lies outside the new map of the first and last entry */
+	if (first < last && map[first].physical_start < start) {
+		parts[num] = map[first];
+		parts[num].num_pages = (start - map[first].physical_start)
+				       >> EFI_PAGE_SHIFT;
+		num++;
+	}
+	idx = first + num;
+
+	parts[num].type = memory_type;
+	parts[num].physical_start = start;
+	parts[num].virtual_start = start;
+	parts[num].num_pages = pages;
 	switch (memory_type) {
 	case EFI_RUNTIME_SERVICES_CODE:
 	case EFI_RUNTIME_SERVICES_DATA:
-		newlist->desc.attribute = EFI_MEMORY_WB | EFI_MEMORY_RUNTIME;
+		parts[num].attribute = EFI_MEMORY_WB | EFI_MEMORY_RUNTIME;
 		break;
 	case EFI_MMAP_IO:
-		newlist->desc.attribute = EFI_MEMORY_RUNTIME;
+		parts[num].attribute = EFI_MEMORY_RUNTIME;
 		break;
 	default:
-		newlist->desc.attribute = EFI_MEMORY_WB;
+		parts[num].attribute = EFI_MEMORY_WB;
 		break;
 	}
-
-	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each_entry(lmem, &efi_mem, link) {
-			s64 r;
-
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_conventional);
-			switch (r) {
-			case EFI_CARVE_OUT_OF_RESOURCES:
-				free(newlist);
-				return EFI_OUT_OF_RESOURCES;
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				free(newlist);
-				return EFI_NO_MAPPING;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
-		}
-	} while (carve_again);
-
-	if (overlap_conventional && (carved_pages != pages)) {
-		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
-		 */
-		free(newlist);
-		return EFI_NO_MAPPING;
+	num++;
+
+	if (first < last && desc_get_end(&map[last - 1]) > end) {
+		parts[num] = map[last - 1];
+		parts[num].physical_start = end;
+		parts[num].virtual_start = end;
+		parts[num].num_pages = (desc_get_end(&map[last - 1]) - end)
+				       >> EFI_PAGE_SHIFT;
+		num++;
 	}
 
 	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
+	if (efi_mem_replace(first, last - first, parts, num))
+		return EFI_OUT_OF_RESOURCES;
+	++efi_memory_map_key;
 
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	/*
+	 * All other entries have been merged before, only the new one may be
+	 * merged with its neighbours.
+	 */
+	map = efi_mem.data;
+	if (idx + 1 < efi_mem.count &&
+	    efi_mem_can_merge(&map[idx], &map[idx + 1])) {
+		map[idx].num_pages += map[idx + 1].num_pages;
+		efi_mem_replace(idx + 1, 1, NULL, 0);
+	}
+	if (idx && efi_mem_can_merge(&map[idx - 1], &map[idx])) {
+		map[idx - 1].num_pages += map[idx].num_pages;
+		efi_mem_replace(idx, 1, NULL, 0);
+	}
 
 	/* Notify that the memory map was changed */
 	list_for_each_entry(evt, &efi_events, link) {
@@ -420,19 +459,15 @@ efi_status_t efi_add_memory_map(u64 start, u64 size, int memory_type)
  */
 static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
 {
-	struct efi_mem_list *item;
-
-	list_for_each_entry(item, &efi_mem, link) {
-		u64 start = item->desc.physical_start;
-		u64 end = start + (item->desc.num_pages << EFI_PAGE_SHIFT);
-
-		if (addr >= start && addr < end) {
-			if (must_be_allocated ^
-			    (item->desc.type == EFI_CONVENTIONAL_MEMORY))
-				return EFI_SUCCESS;
-			else
-				return EFI_NOT_FOUND;
-		}
+	struct efi_mem_desc *map = efi_mem.data;
+	uint i = efi_mem_find(addr);
+
+	if (i < efi_mem.count && map[i].physical_start <= addr) {
+		if (must_be_allocated ^
+		    (map[i].type == EFI_CONVENTIONAL_MEMORY))
+			return EFI_SUCCESS;
+		else
+			return EFI_NOT_FOUND;
 	}
 
 	return EFI_NOT_FOUND;
@@ -630,6 +665,9 @@ efi_status_t efi_allocate_pool(enum efi_memory_type pool_type, efi_uintn_t size,
 		return EFI_SUCCESS;
 	}
 
+	if (size <= EFI_POOL_SLAB_MAX)
+		return efi_pool_slab_alloc(pool_type, size, buffer);
+
 	r = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, pool_type, num_pages,
 			       &addr);
 	if (r == EFI_SUCCESS) {
@@ -674,6 +712,7 @@ efi_status_t efi_free_pool(void *buffer)
 {
 	efi_status_t ret;
 	struct efi_pool_allocation *alloc;
+	struct efi_pool_slab *slab;
 
 	if (!buffer)
 		return EFI_INVALID_PARAMETER;
@@ -682,6 +721,11 @@ efi_status_t efi_free_pool(void *buffer)
 	if (ret != EFI_SUCCESS)
 		return ret;
 
+	slab = (struct efi_pool_slab *)((uintptr_t)buffer & ~EFI_PAGE_MASK);
+	if (!slab->num_pages &&
+	    slab->checksum == checksum((struct efi_pool_allocation *)slab))
+		return efi_pool_slab_free(slab, buffer);
+
 	alloc = container_of(buffer, struct efi_pool_allocation, data);
 
 	/* Check that this memory was allocated by efi_allocate_pool() */
@@ -715,9 +759,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 				efi_uintn_t *descriptor_size,
 				uint32_t *descriptor_version)
 {
-	size_t map_entries;
 	efi_uintn_t map_size = 0;
-	struct efi_mem_list *lmem;
 	efi_uintn_t provided_map_size;
 
 	if (!memory_map_size)
@@ -725,9 +767,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 
 	provided_map_size = *memory_map_size;
 
-	map_entries = list_count_nodes(&efi_mem);
-
-	map_size = map_entries * sizeof(struct efi_mem_desc);
+	map_size = efi_mem.count * sizeof(struct efi_mem_desc);
 
 	*memory_map_size = map_size;
 
@@ -743,13 +783,8 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 	if (!memory_map)
 		return EFI_INVALID_PARAMETER;
 
-	/* Copy list into array */
-	/* Return the list in ascending order */
-	memory_map = &memory_map[map_entries - 1];
-	list_for_each_entry(lmem, &efi_mem, link) {
-		*memory_map = lmem->desc;
-		memory_map--;
-	}
+	/* The map is kept in ascending order as it is returned */
+	memcpy(memory_map, efi_mem.data, map_size);
 
 	if (map_key)
 		*map_key = efi_memory_map_key;
@@ -23,17 +23,30 @@
 #include <malloc.h>
 #include <vsprintf.h>
 #include <net.h>
+#include <time.h>
+#include <div64.h>
+
+/* Number of buffers in the receive ring */
+#define EFI_NET_RX_PACKETS	CONFIG_EFI_NET_RX_PACKETS
+/* Number of sent buffers which GetStatus() can hand back */
+#define EFI_NET_TX_DONE		32
 
 static const efi_guid_t efi_net_guid = EFI_SIMPLE_NETWORK_PROTOCOL_GUID;
 static const efi_guid_t efi_pxe_base_code_protocol_guid =
 					EFI_PXE_BASE_CODE_PROTOCOL_GUID;
 static struct efi_pxe_packet *dhcp_ack;
-static void *new_tx_packet;
 static void *transmit_buffer;
 static uchar **receive_buffer;
 static size_t *receive_lengths;
 static int rx_packet_idx;
 static int rx_packet_num;
+/* Sent buffers which the application has not got back yet */
+static void *tx_done[EFI_NET_TX_DONE];
+static int tx_done_idx;
+static int tx_done_num;
+static struct efi_network_statistics net_stats;
+/* Time of the last reset of net_stats, in milliseconds */
+static ulong net_stats_start;
 static struct efi_net_obj *netobj;
 
 /*
@@ -84,6 +97,64 @@ struct efi_net_obj {
 #endif
 };
 
+/**
+ * efi_net_count_dest() - count a frame by the type of its destination
+ *
+ * @hdr:	Ethernet header of the frame
+ * @unicast:	counter of unicast frames
+ * @broadcast:	counter of broadcast frames
+ * @multicast:	counter of multicast frames
+ */
+static void efi_net_count_dest(const struct ethernet_hdr *hdr, u64 *unicast,
+			       u64 *broadcast, u64 *multicast)
+{
+	if (!is_multicast_ethaddr(hdr->et_dest))
+		(*unicast)++;
+	else if (is_broadcast_ethaddr(hdr->et_dest))
+		(*broadcast)++;
+	else
+		(*multicast)++;
+}
+
+void efi_net_reset_stats(void)
+{
+	memset(&net_stats, '\0', sizeof(net_stats));
+
+	/* U-Boot's drivers do not report these */
+	net_stats.rx_crc_error_frames = ~0ULL;
+	net_stats.tx_dropped_frames = ~0ULL;
+	net_stats.tx_crc_error_frames = ~0ULL;
+	net_stats.collisions = ~0ULL;
+	net_stats.unsupported_protocol = ~0ULL;
+	net_stats.rx_duplicated_frames = ~0ULL;
+	net_stats.rx_decrypt_error_frames = ~0ULL;
+	net_stats.tx_error_frames = ~0ULL;
+	net_stats.tx_retry_frames = ~0ULL;
+	net_stats_start = get_timer(0);
+}
+
+/* Get the rate in KiB/s of @bytes transferred in @msecs */
+static u64 efi_net_rate(u64 bytes, ulong msecs)
+{
+	return msecs ? lldiv(bytes * 1000 / 1024, msecs) : 0;
+}
+
+void efi_net_show_stats(void)
+{
+	ulong msecs = get_timer(net_stats_start);
+
+	printf("Received %llu frames, %llu bytes, %llu KiB/s\n",
+	       net_stats.rx_good_frames, net_stats.rx_total_bytes,
+	       efi_net_rate(net_stats.rx_total_bytes, msecs));
+	printf("  dropped %llu (ring of %d full), %llu undersize, %llu oversize\n",
+	       net_stats.rx_dropped_frames, EFI_NET_RX_PACKETS,
+	       net_stats.rx_undersize_frames, net_stats.rx_oversize_frames);
+	printf("Sent     %llu frames, %llu bytes, %llu KiB/s\n",
+	       net_stats.tx_good_frames, net_stats.tx_total_bytes,
+	       efi_net_rate(net_stats.tx_total_bytes, msecs));
+	printf("Over %lu ms since the last reset\n", msecs);
+}
+
 /*
  * efi_net_start() - start the network interface
  *
@@ -146,6 +217,7 @@ static efi_status_t EFIAPI efi_net_stop(struct efi_simple_network *this)
 		eth_halt();
 		/* Clear cache of packets */
 		rx_packet_num = 0;
+		tx_done_num = 0;
 		this->mode->state = EFI_NETWORK_STOPPED;
 	}
 out:
@@ -193,6 +265,7 @@ static efi_status_t EFIAPI efi_net_initialize(struct efi_simple_network *this,
 	eth_halt();
 	/* Clear cache of packets */
 	rx_packet_num = 0;
+	tx_done_num = 0;
 	/* Set current device according to environment variables */
 	eth_set_current();
 	/* Get hardware ready for send and receive operations */
@@ -358,9 +431,39 @@ static efi_status_t EFIAPI efi_net_statistics(struct efi_simple_network *this,
 					      int reset, ulong *stat_size,
 					      void *stat_table)
 {
+	efi_status_t ret = EFI_SUCCESS;
+
 	EFI_ENTRY("%p, %x, %p, %p", this, reset, stat_size, stat_table);
 
-	return EFI_EXIT(EFI_UNSUPPORTED);
+	/* Check parameters */
+	if (!this || (stat_table && !stat_size)) {
+		ret = EFI_INVALID_PARAMETER;
+		goto out;
+	}
+
+	switch (this->mode->state) {
+	case EFI_NETWORK_STOPPED:
+		ret = EFI_NOT_STARTED;
+		goto out;
+	case EFI_NETWORK_STARTED:
+		ret = EFI_DEVICE_ERROR;
+		goto out;
+	default:
+		break;
+	}
+
+	if (stat_size) {
+		if (stat_table)
+			memcpy(stat_table, &net_stats,
+			       min_t(ulong, *stat_size, sizeof(net_stats)));
+		if (!stat_table || *stat_size < sizeof(net_stats))
+			ret = EFI_BUFFER_TOO_SMALL;
+		*stat_size = sizeof(net_stats);
+	}
+	if (reset)
+		efi_net_reset_stats();
+out:
+	return EFI_EXIT(ret);
 }
 
 /*
@@ -489,10 +592,14 @@ static efi_status_t EFIAPI efi_net_get_status(struct efi_simple_network *this,
 		*int_status = this->int_status;
 		this->int_status = 0;
 	}
-	if (txbuf)
-		*txbuf = new_tx_packet;
-
-	new_tx_packet = NULL;
+	if (txbuf) {
+		*txbuf = NULL;
+		if (tx_done_num) {
+			*txbuf = tx_done[tx_done_idx];
+			tx_done_idx = (tx_done_idx + 1) % EFI_NET_TX_DONE;
+			tx_done_num--;
+		}
+	}
 out:
 	return EFI_EXIT(ret);
 }
@@ -534,12 +641,14 @@ static efi_status_t EFIAPI efi_net_transmit
 
 	/* We do not support jumbo packets */
 	if (buffer_size > PKTSIZE_ALIGN) {
+		net_stats.tx_oversize_frames++;
 		ret = EFI_INVALID_PARAMETER;
 		goto out;
 	}
 
 	/* At least the IP header has to fit into the buffer */
 	if (buffer_size < this->mode->media_header_size) {
+		net_stats.tx_undersize_frames++;
 		ret = EFI_BUFFER_TOO_SMALL;
 		goto out;
 	}
@@ -579,8 +688,24 @@ static efi_status_t EFIAPI efi_net_transmit
 	/* Ethernet packets always fit, just bounce */
 	memcpy(transmit_buffer, buffer, buffer_size);
 	net_send_packet(transmit_buffer, buffer_size);
+	net_stats.tx_total_frames++;
+	net_stats.tx_good_frames++;
+	net_stats.tx_total_bytes += buffer_size;
+	efi_net_count_dest(buffer, &net_stats.tx_unicast_frames,
+			   &net_stats.tx_broadcast_frames,
+			   &net_stats.tx_multicast_frames);
 
-	new_tx_packet = buffer;
+	/*
+	 * The packet has been sent once net_send_packet() returns. Queue the
+	 * buffer for GetStatus(), dropping the oldest one if the application
+	 * does not collect them.
+	 */
+	if (tx_done_num == EFI_NET_TX_DONE) {
+		tx_done_idx = (tx_done_idx + 1) % EFI_NET_TX_DONE;
+		tx_done_num--;
+	}
+	tx_done[(tx_done_idx + tx_done_num) % EFI_NET_TX_DONE] = buffer;
+	tx_done_num++;
 	this->int_status |= EFI_SIMPLE_NETWORK_TRANSMIT_INTERRUPT;
 out:
 	return EFI_EXIT(ret);
@@ -664,7 +789,7 @@ static efi_status_t EFIAPI efi_net_receive
 	memcpy(buffer, receive_buffer[rx_packet_idx],
 	       receive_lengths[rx_packet_idx]);
 	*buffer_size = receive_lengths[rx_packet_idx];
-	rx_packet_idx = (rx_packet_idx + 1) % ETH_PACKETS_BATCH_RECV;
+	rx_packet_idx = (rx_packet_idx + 1) % EFI_NET_RX_PACKETS;
 	rx_packet_num--;
 	if (rx_packet_num)
 		wait_for_packet->is_signaled = true;
@@ -710,24 +835,37 @@ static void efi_net_push(void *pkt, int len)
 {
 	int rx_packet_next;
 
+	net_stats.rx_total_frames++;
+
 	/* Check that we at least received an Ethernet header */
-	if (len < sizeof(struct ethernet_hdr))
+	if (len < sizeof(struct ethernet_hdr)) {
+		net_stats.rx_undersize_frames++;
 		return;
+	}
 
 	/* Check that the buffer won't overflow */
-	if (len > PKTSIZE_ALIGN)
+	if (len > PKTSIZE_ALIGN) {
+		net_stats.rx_oversize_frames++;
 		return;
+	}
 
 	/* Can't store more than pre-alloced buffer */
-	if (rx_packet_num >= ETH_PACKETS_BATCH_RECV)
+	if (rx_packet_num >= EFI_NET_RX_PACKETS) {
+		net_stats.rx_dropped_frames++;
 		return;
+	}
 
 	rx_packet_next = (rx_packet_idx + rx_packet_num) %
-	    ETH_PACKETS_BATCH_RECV;
+	    EFI_NET_RX_PACKETS;
 	memcpy(receive_buffer[rx_packet_next], pkt, len);
 	receive_lengths[rx_packet_next] = len;
 
 	rx_packet_num++;
+	net_stats.rx_good_frames++;
+	net_stats.rx_total_bytes += len;
+	efi_net_count_dest(pkt, &net_stats.rx_unicast_frames,
+			   &net_stats.rx_broadcast_frames,
+			   &net_stats.rx_multicast_frames);
 }
 
 /**
@@ -752,15 +890,23 @@ static void EFIAPI efi_network_timer_notify(struct efi_event *event,
 	if (!this || this->mode->state != EFI_NETWORK_INITIALIZED)
 		goto out;
 
-	if (!rx_packet_num) {
-		push_packet = efi_net_push;
+	/*
+	 * Drain the driver while a whole batch of eth_rx() still fits into
+	 * the ring, so that packets wait here rather than being dropped by
+	 * the hardware while the application is busy
+	 */
+	push_packet = efi_net_push;
+	while (EFI_NET_RX_PACKETS - rx_packet_num >= ETH_PACKETS_BATCH_RECV) {
+		int num = rx_packet_num;
+
 		eth_rx();
-		push_packet = NULL;
-		if (rx_packet_num) {
-			this->int_status |=
-				EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT;
-			wait_for_packet->is_signaled = true;
-		}
+		if (rx_packet_num == num)
+			break;
+	}
+	push_packet = NULL;
+	if (rx_packet_num) {
+		this->int_status |= EFI_SIMPLE_NETWORK_RECEIVE_INTERRUPT;
+		wait_for_packet->is_signaled = true;
 	}
 out:
 	EFI_EXIT(EFI_SUCCESS);
@@ -905,19 +1051,20 @@ efi_status_t efi_net_register(void)
 	transmit_buffer = (void *)ALIGN((uintptr_t)transmit_buffer, PKTALIGN);
 
 	/* Allocate a number of receive buffers */
-	receive_buffer = calloc(ETH_PACKETS_BATCH_RECV,
+	receive_buffer = calloc(EFI_NET_RX_PACKETS,
 				sizeof(*receive_buffer));
 	if (!receive_buffer)
 		goto out_of_resources;
-	for (i = 0; i < ETH_PACKETS_BATCH_RECV; i++) {
+	for (i = 0; i < EFI_NET_RX_PACKETS; i++) {
 		receive_buffer[i] = malloc(PKTSIZE_ALIGN);
 		if (!receive_buffer[i])
 			goto out_of_resources;
 	}
-	receive_lengths = calloc(ETH_PACKETS_BATCH_RECV,
+	receive_lengths = calloc(EFI_NET_RX_PACKETS,
 				 sizeof(*receive_lengths));
 	if (!receive_lengths)
 		goto out_of_resources;
+	efi_net_reset_stats();
 
 	/* Hook net up to the device list */
 	efi_add_handle(&netobj->header);
@@ -1037,7 +1184,7 @@ out_of_resources:
 	netobj = NULL;
 	free(transmit_buffer);
 	if (receive_buffer)
-		for (i = 0; i < ETH_PACKETS_BATCH_RECV; i++)
+		for (i = 0; i < EFI_NET_RX_PACKETS; i++)
 			free(receive_buffer[i]);
 	free(receive_buffer);
 	free(receive_lengths);
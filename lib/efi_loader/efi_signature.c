@@ -12,6 +12,7 @@
 #include <image.h>
 #include <hexdump.h>
 #include <malloc.h>
+#include <sort.h>
 #include <crypto/pkcs7.h>
 #include <crypto/pkcs7_parser.h>
 #include <crypto/public_key.h>
@@ -19,6 +20,7 @@
 #include <linux/oid_registry.h>
 #include <u-boot/hash-checksum.h>
 #include <u-boot/rsa.h>
+#include <u-boot/sha256.h>
 
 const efi_guid_t efi_guid_sha256 = EFI_CERT_SHA256_GUID;
 const efi_guid_t efi_guid_cert_rsa2048 = EFI_CERT_RSA2048_GUID;
@@ -28,6 +30,9 @@ const efi_guid_t efi_guid_cert_x509_sha384 = EFI_CERT_X509_SHA384_GUID;
 const efi_guid_t efi_guid_cert_x509_sha512 = EFI_CERT_X509_SHA512_GUID;
 const efi_guid_t efi_guid_cert_type_pkcs7 = EFI_CERT_TYPE_PKCS7_GUID;
 
+/* Parsed image signature databases, indexed from EFI_AUTH_VAR_DB */
+static struct efi_signature_store *efi_sigstore_cache[3];
+
 static u8 pkcs7_hdr[] = {
 	/* SEQUENCE */
 	0x30, 0x82, 0x05, 0xc7,
@@ -160,6 +165,56 @@ bool efi_hash_regions(struct image_region *regs, int count,
 	return true;
 }
 
+/**
+ * efi_image_regions_hash - calculate the digest of an image
+ * @regs:	List of regions of the image
+ * @hash_algo:	Hash algorithm
+ * @hash:	Pointer to a pointer to buffer holding a hash value
+ * @len:	Size of the hash value
+ *
+ * Like efi_hash_regions() but the last digest is kept in @regs. The checks
+ * against dbx, against the digest in the signature and against db all use
+ * the same algorithm, so a large image is read only once.
+ *
+ * Return:	true on success, false on error
+ */
+bool efi_image_regions_hash(struct efi_image_regions *regs,
+			    const char *hash_algo, void **hash, int *len)
+{
+	int hash_len;
+
+	if (!hash_algo)
+		return false;
+
+	if (regs->digest_algo && !strcmp(regs->digest_algo, hash_algo)) {
+		hash_len = algo_to_len(hash_algo);
+		if (!*hash) {
+			*hash = malloc(hash_len);
+			if (!*hash) {
+				EFI_PRINT("Out of memory\n");
+				return false;
+			}
+		}
+		memcpy(*hash, regs->digest, hash_len);
+		if (len)
+			*len = hash_len;
+		return true;
+	}
+
+	if (!efi_hash_regions(regs->reg, regs->num, hash, hash_algo,
+			      &hash_len))
+		return false;
+
+	if (hash_len <= sizeof(regs->digest)) {
+		memcpy(regs->digest, *hash, hash_len);
+		regs->digest_algo = hash_algo;
+	}
+	if (len)
+		*len = hash_len;
+
+	return true;
+}
+
 /**
  * hash_algo_supported - check if the requested hash algorithm is supported
  * @guid: guid of the algorithm
@@ -184,6 +239,89 @@ static bool hash_algo_supported(const efi_guid_t guid)
 	return true;
 }
 
+static int efi_digest_cmp(const void *a, const void *b)
+{
+	return memcmp(a, b, SHA256_SUM_LEN);
+}
+
+/**
+ * efi_sigstore_index_digests - build the sorted digest set of a database
+ * @sigstore:	Pointer to the first entry of the signature store
+ *
+ * Collect the SHA-256 digests of all signature lists into a sorted array so
+ * that efi_signature_lookup_digest() can bisect instead of comparing the
+ * image's digest against every entry. On error the array is omitted and the
+ * lists are searched.
+ */
+static void efi_sigstore_index_digests(struct efi_signature_store *sigstore)
+{
+	struct efi_signature_store *siglist;
+	struct efi_sig_data *sig_data;
+	size_t count = 0;
+	u8 *digests;
+
+	for (siglist = sigstore; siglist; siglist = siglist->next) {
+		if (guidcmp(&siglist->sig_type, &efi_guid_sha256))
+			continue;
+		for (sig_data = siglist->sig_data_list; sig_data;
+		     sig_data = sig_data->next) {
+			if (sig_data->size == SHA256_SUM_LEN)
+				count++;
+		}
+	}
+	if (!count)
+		return;
+
+	digests = malloc(count * SHA256_SUM_LEN);
+	if (!digests)
+		return;
+
+	count = 0;
+	for (siglist = sigstore; siglist; siglist = siglist->next) {
+		if (guidcmp(&siglist->sig_type, &efi_guid_sha256))
+			continue;
+		for (sig_data = siglist->sig_data_list; sig_data;
+		     sig_data = sig_data->next) {
+			if (sig_data->size != SHA256_SUM_LEN)
+				continue;
+			memcpy(digests + count * SHA256_SUM_LEN, sig_data->data,
+			       SHA256_SUM_LEN);
+			count++;
+		}
+	}
+	qsort(digests, count, SHA256_SUM_LEN, efi_digest_cmp);
+
+	sigstore->digests = digests;
+	sigstore->num_digests = count;
+}
+
+/**
+ * efi_digest_find - bisect the sorted digest set of a database
+ * @db:		Signature database with digests indexed
+ * @hash:	SHA-256 digest to search for
+ *
+ * Return:	true if found, false if not
+ */
+static bool efi_digest_find(struct efi_signature_store *db, const u8 *hash)
+{
+	size_t lo = 0, hi = db->num_digests;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		int cmp = efi_digest_cmp(hash, db->digests +
+					 mid * SHA256_SUM_LEN);
+
+		if (!cmp)
+			return true;
+		if (cmp < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return false;
+}
+
 /**
  * efi_signature_lookup_digest - search for an image's digest in sigdb
  * @regs:	List of regions to be authenticated
@@ -212,6 +350,31 @@ bool efi_signature_lookup_digest(struct efi_image_regions *regs,
 	if (!regs || !db || !db->sig_data_list)
 		goto out;
 
+	if (db->digests) {
+		int len = 0;
+
+		/*
+		 * if the hash algorithm is unsupported and we get an entry in
+		 * dbx reject the image
+		 */
+		for (siglist = db; dbx && siglist; siglist = siglist->next) {
+			if (!hash_algo_supported(siglist->sig_type)) {
+				found = true;
+				goto out;
+			}
+		}
+
+		if (!efi_image_regions_hash(regs,
+					    guid_to_sha_str(&efi_guid_sha256),
+					    &hash, &len)) {
+			EFI_PRINT("Digesting an image failed\n");
+			goto out;
+		}
+		found = len == SHA256_SUM_LEN && efi_digest_find(db, hash);
+		free(hash);
+		goto out;
+	}
+
 	for (siglist = db; siglist; siglist = siglist->next) {
 		int len = 0;
 		const char *hash_algo = NULL;
@@ -236,8 +399,7 @@ bool efi_signature_lookup_digest(struct efi_image_regions *regs,
 		 * will do that for us
 		 */
 		if (!hash_done &&
-		    !efi_hash_regions(regs->reg, regs->num, &hash, hash_algo,
-				      &len)) {
+		    !efi_image_regions_hash(regs, hash_algo, &hash, &len)) {
 			EFI_PRINT("Digesting an image failed\n");
 			break;
 		}
@@ -628,6 +790,7 @@ void efi_sigstore_free(struct efi_signature_store *sigstore)
 			sig_data = sig_data_next;
 		}
 
+		free(sigstore->digests);
 		free(sigstore);
 		sigstore = sigstore_next;
 	}
@@ -787,6 +950,7 @@ struct efi_signature_store *efi_build_signature_store(void *sig_list,
 		esl = (void *)esl + esl->signature_list_size;
 	}
 	free(sig_list);
+	efi_sigstore_index_digests(sigstore);
 
 	return sigstore;
 
@@ -821,3 +985,28 @@ struct efi_signature_store *efi_sigstore_parse_sigdb(u16 *name)
 
 	return efi_build_signature_store(db, db_size);
 }
+
+struct efi_signature_store *efi_sigstore_get(enum efi_auth_var_type type)
+{
+	static u16 * const names[] = {u"db", u"dbx", u"dbt"};
+	int i = type - EFI_AUTH_VAR_DB;
+
+	if (i < 0 || i >= ARRAY_SIZE(efi_sigstore_cache))
+		return NULL;
+
+	if (!efi_sigstore_cache[i])
+		efi_sigstore_cache[i] = efi_sigstore_parse_sigdb(names[i]);
+
+	return efi_sigstore_cache[i];
+}
+
+void efi_sigstore_invalidate(enum efi_auth_var_type type)
+{
+	int i = type - EFI_AUTH_VAR_DB;
+
+	if (i < 0 || i >= ARRAY_SIZE(efi_sigstore_cache))
+		return;
+
+	efi_sigstore_free(efi_sigstore_cache[i]);
+	efi_sigstore_cache[i] = NULL;
+}
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Statistics on calls of UEFI services
+ *
+ * Every function using EFI_ENTRY() owns a struct efi_stat which is linked
+ * into efi_stats on its first call. EFI_EXIT() adds the time spent since the
+ * matching EFI_ENTRY(), including nested calls of other services.
+ */
+
+#define LOG_CATEGORY LOGC_EFI
+
+#include <bootstage.h>
+#include <efi_loader.h>
+#include <time.h>
+#include <div64.h>
+
+#define EFI_STATS_DEPTH 16
+
+/* List of all services which have been called */
+static struct efi_stat *efi_stats;
+
+/**
+ * struct efi_stats_frame - service call in progress
+ *
+ * @stat:	statistics of the called service
+ * @start:	timer ticks at the entry of the service
+ */
+static struct efi_stats_frame {
+	struct efi_stat *stat;
+	u64 start;
+} efi_stats_stack[EFI_STATS_DEPTH];
+
+static int efi_stats_depth;
+
+void efi_stats_enter(struct efi_stat *stat)
+{
+	if (!stat->linked) {
+		stat->next = efi_stats;
+		efi_stats = stat;
+		stat->linked = true;
+	}
+	stat->calls++;
+
+	if (efi_stats_depth < EFI_STATS_DEPTH) {
+		efi_stats_stack[efi_stats_depth].stat = stat;
+		efi_stats_stack[efi_stats_depth].start = get_ticks();
+	}
+	efi_stats_depth++;
+}
+
+void efi_stats_exit(const char *name)
+{
+	int i;
+
+	/*
+	 * Exit() returns to StartImage() with longjmp(), skipping the
+	 * EFI_EXIT() of the services in between. Drop their frames.
+	 */
+	for (i = min(efi_stats_depth, EFI_STATS_DEPTH) - 1; i >= 0; i--) {
+		if (efi_stats_stack[i].stat->name == name)
+			break;
+	}
+	if (i < 0) {
+		if (efi_stats_depth > EFI_STATS_DEPTH)
+			efi_stats_depth--;
+		return;
+	}
+
+	efi_stats_stack[i].stat->ticks += get_ticks() -
+					  efi_stats_stack[i].start;
+	efi_stats_depth = i;
+}
+
+/**
+ * efi_stats_us() - convert timer ticks to microseconds
+ *
+ * @ticks:	timer ticks
+ * Return:	microseconds
+ */
+static u64 efi_stats_us(u64 ticks)
+{
+	return lldiv(ticks * 1000000, get_tbclk());
+}
+
+void efi_stats_show(void)
+{
+	struct efi_stat *stat;
+
+	printf("%10s %12s %10s  %s\n", "Calls", "Total us", "Avg us",
+	       "Service");
+	for (stat = efi_stats; stat; stat = stat->next) {
+		u64 us = efi_stats_us(stat->ticks);
+
+		if (!stat->calls)
+			continue;
+		printf("%10lu %12llu %10llu  %s\n", stat->calls, us,
+		       lldiv(us, stat->calls), stat->name);
+	}
+}
+
+void efi_stats_reset(void)
+{
+	struct efi_stat *stat;
+
+	for (stat = efi_stats; stat; stat = stat->next) {
+		stat->calls = 0;
+		stat->ticks = 0;
+	}
+}
+
+void efi_stats_bootstage(void)
+{
+	struct efi_stat *stat;
+
+	for (stat = efi_stats; stat; stat = stat->next) {
+		if (stat->calls)
+			bootstage_add_accum(stat->name,
+					    efi_stats_us(stat->ticks));
+	}
+}
@@ -25,6 +25,19 @@
 
 static const efi_guid_t shim_lock_guid = SHIM_LOCK_GUID;
 
+#ifdef CONFIG_EFI_VARIABLE_FILE_JOURNAL
+#define EFI_VAR_JOURNAL_SIZE	CONFIG_EFI_VARIABLE_FILE_JOURNAL_SIZE
+#else
+#define EFI_VAR_JOURNAL_SIZE	0
+#endif
+
+/*
+ * Length of the variables file as last read or written, or 0 if it is not
+ * known to match the variables in memory, and of the part before the journal
+ */
+static loff_t efi_var_file_len;
+static loff_t efi_var_file_base_len;
+
 /**
  * efi_set_blk_dev_to_system_partition() - select EFI system partition
  *
@@ -84,6 +97,8 @@ efi_status_t efi_var_to_file(void)
 	r = fs_write(EFI_VAR_FILE_NAME, map_to_sysmem(buf), 0, len, &actlen);
 	if (r || len != actlen)
 		ret = EFI_DEVICE_ERROR;
+	efi_var_file_len = ret == EFI_SUCCESS ? len : 0;
+	efi_var_file_base_len = efi_var_file_len;
 
 error:
 	if (ret != EFI_SUCCESS)
@@ -96,6 +111,154 @@ out:
 #endif
 }
 
+/**
+ * efi_var_journal_write() - append a record of a change to the variables file
+ *
+ * @name:	name of the variable which has changed
+ * @guid:	vendor GUID of the variable
+ * Return:	status code
+ */
+static efi_status_t __maybe_unused efi_var_journal_write(const u16 *name,
+							 const efi_guid_t *guid)
+{
+	struct efi_var_journal *rec;
+	struct efi_var_entry *var, *entry;
+	loff_t len, actlen;
+	efi_status_t ret;
+	u32 entry_len;
+	int r;
+
+	var = efi_var_mem_find(guid, name, NULL);
+	if (var) {
+		entry_len = efi_var_entry_len(var);
+	} else {
+		entry_len = ALIGN(sizeof(*var) +
+				  sizeof(u16) * (u16_strlen(name) + 1), 8);
+	}
+	len = sizeof(*rec) + entry_len;
+
+	/* rewrite the file once the journal is full */
+	if (efi_var_file_len + len >
+	    efi_var_file_base_len + EFI_VAR_JOURNAL_SIZE)
+		return EFI_BUFFER_TOO_SMALL;
+
+	rec = calloc(1, len);
+	if (!rec)
+		return EFI_OUT_OF_RESOURCES;
+	entry = (struct efi_var_entry *)(rec + 1);
+	if (var) {
+		memcpy(entry, var, entry_len);
+	} else {
+		/* a deletion is the variable with no data */
+		guidcpy(&entry->guid, guid);
+		u16_strcpy(entry->name, name);
+	}
+	rec->magic = EFI_VAR_JOURNAL_MAGIC;
+	rec->crc32 = crc32(0, (u8 *)entry, entry_len);
+
+	ret = efi_set_blk_dev_to_system_partition();
+	if (ret == EFI_SUCCESS) {
+		r = fs_write(EFI_VAR_FILE_NAME, map_to_sysmem(rec),
+			     efi_var_file_len, len, &actlen);
+		if (r || len != actlen)
+			ret = EFI_DEVICE_ERROR;
+	}
+	free(rec);
+	if (ret != EFI_SUCCESS)
+		return ret;
+	efi_var_file_len += len;
+
+	return EFI_SUCCESS;
+}
+
+efi_status_t efi_var_file_update(const u16 *name, const efi_guid_t *guid)
+{
+	if (IS_ENABLED(CONFIG_EFI_VARIABLE_FILE_JOURNAL) && efi_var_file_len &&
+	    efi_var_journal_write(name, guid) == EFI_SUCCESS)
+		return EFI_SUCCESS;
+
+	/* a failed append may have left part of a record, which is dropped */
+	return efi_var_to_file();
+}
+
+/**
+ * efi_var_file_allowed() - check whether a variable may come from the file
+ *
+ * Secure boot related and volatile variables shall only be restored from
+ * U-Boot's preseed.
+ *
+ * @var:	variable entry
+ * @safe:	true if the entries come from the preseed
+ * Return:	true if the variable may be restored
+ */
+static bool efi_var_file_allowed(struct efi_var_entry *var, bool safe)
+{
+	return safe ||
+		(efi_auth_var_get_type(var->name, &var->guid) ==
+		 EFI_AUTH_VAR_NONE &&
+		 guidcmp(&var->guid, &shim_lock_guid) &&
+		 (var->attr & EFI_VARIABLE_NON_VOLATILE));
+}
+
+/**
+ * efi_var_journal_restore() - apply the records appended to the file
+ *
+ * The records are applied in order. A record which is cut short or has a bad
+ * CRC32 ends the journal, since a power failure may have interrupted the
+ * write.
+ *
+ * @buf:	the file read, with the part before the journal restored
+ * @len:	length of the file
+ * Return:	true if all the records are valid
+ */
+static bool __maybe_unused efi_var_journal_restore(struct efi_var_file *buf,
+						   loff_t len)
+{
+	struct efi_var_entry *var, *old;
+	struct efi_var_journal *rec;
+	loff_t pos, avail, name_max;
+	u32 entry_len;
+	u16 *data;
+
+	for (pos = buf->length; pos < len; pos += sizeof(*rec) + entry_len) {
+		/* space for the name and data, which must be in the file */
+		avail = len - pos - sizeof(*rec) - sizeof(*var);
+		if (avail < (loff_t)sizeof(u16))
+			return false;
+		rec = (void *)buf + pos;
+		var = (struct efi_var_entry *)(rec + 1);
+		if (rec->magic != EFI_VAR_JOURNAL_MAGIC ||
+		    var->length > avail - sizeof(u16))
+			return false;
+		name_max = (avail - var->length) / sizeof(u16);
+		if (u16_strnlen(var->name, name_max) >= name_max)
+			return false;
+		entry_len = efi_var_entry_len(var);
+		if (entry_len > len - pos - sizeof(*rec) ||
+		    rec->crc32 != crc32(0, (u8 *)var, entry_len))
+			return false;
+
+		old = efi_var_mem_find(&var->guid, var->name, NULL);
+		if (!var->length) {
+			/* a deletion has no attributes, so check what it deletes */
+			if (old && efi_var_file_allowed(old, false))
+				efi_var_mem_del(old);
+			continue;
+		}
+		if (!efi_var_file_allowed(var, false))
+			continue;
+		if (old)
+			efi_var_mem_del(old);
+		data = var->name + u16_strlen(var->name) + 1;
+		if (efi_var_mem_ins(var->name, &var->guid, var->attr,
+				    var->length, data, 0, NULL,
+				    var->time) != EFI_SUCCESS)
+			log_err("Failed to set EFI variable %ls\n", var->name);
+	}
+
+	return true;
+}
+
 efi_status_t efi_var_restore(struct efi_var_file *buf, bool safe)
 {
 	struct efi_var_entry *var, *last_var;
@@ -116,15 +279,7 @@ efi_status_t efi_var_restore(struct efi_var_file *buf, bool safe)
 
 		data = var->name + u16_strlen(var->name) + 1;
 
-		/*
-		 * Secure boot related and volatile variables shall only be
-		 * restored from U-Boot's preseed.
-		 */
-		if (!safe &&
-		    (efi_auth_var_get_type(var->name, &var->guid) !=
-		     EFI_AUTH_VAR_NONE ||
-		     !guidcmp(&var->guid, &shim_lock_guid) ||
-		     !(var->attr & EFI_VARIABLE_NON_VOLATILE)))
+		if (!efi_var_file_allowed(var, safe))
 			continue;
 		if (!var->length)
 			continue;
@@ -161,7 +316,8 @@ efi_status_t efi_var_from_file(void)
 	efi_status_t ret;
 	int r;
 
-	buf = calloc(1, EFI_VAR_BUF_SIZE);
+	efi_var_file_len = 0;
+	buf = calloc(1, EFI_VAR_BUF_SIZE + EFI_VAR_JOURNAL_SIZE);
 	if (!buf) {
 		log_err("Out of memory\n");
 		return EFI_OUT_OF_RESOURCES;
@@ -170,14 +326,25 @@ efi_status_t efi_var_from_file(void)
 	ret = efi_set_blk_dev_to_system_partition();
 	if (ret != EFI_SUCCESS)
 		goto error;
-	r = fs_read(EFI_VAR_FILE_NAME, map_to_sysmem(buf), 0, EFI_VAR_BUF_SIZE,
-		    &len);
+	r = fs_read(EFI_VAR_FILE_NAME, map_to_sysmem(buf), 0,
+		    EFI_VAR_BUF_SIZE + EFI_VAR_JOURNAL_SIZE, &len);
 	if (r || len < sizeof(struct efi_var_file)) {
 		log_err("Failed to load EFI variables\n");
 		goto error;
 	}
-	if (buf->length != len || efi_var_restore(buf, false) != EFI_SUCCESS)
+	if ((IS_ENABLED(CONFIG_EFI_VARIABLE_FILE_JOURNAL) ?
+	     buf->length > len : buf->length != len) ||
+	    efi_var_restore(buf, false) != EFI_SUCCESS) {
 		log_err("Invalid EFI variables file\n");
+		goto error;
+	}
+
+	/* if the journal is damaged, the next change rewrites the file */
+	if (IS_ENABLED(CONFIG_EFI_VARIABLE_FILE_JOURNAL) &&
+	    efi_var_journal_restore(buf, len)) {
+		efi_var_file_len = len;
+		efi_var_file_base_len = buf->length;
+	}
 error:
 	free(buf);
 #endif
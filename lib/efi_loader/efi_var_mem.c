@@ -20,6 +20,81 @@
 static struct efi_var_file __efi_runtime_data *efi_var_buf;
 static struct efi_var_entry __efi_runtime_data *efi_current_var;
 
+/* Number of slots in efi_var_hash, a power of two */
+#define EFI_VAR_HASH_SIZE	1024
+
+/*
+ * Index of efi_var_buf: the offsets of the variables in the buffer, hashed
+ * by GUID and name with linear probing, 0 marking a free slot. Offsets do
+ * not need to be converted in SetVirtualAddressMap(). If more than 3/4 of
+ * the slots would be used, efi_var_hash_count is set to EFI_VAR_HASH_SIZE
+ * and lookups scan efi_var_buf instead.
+ */
+static u32 __efi_runtime_data efi_var_hash[EFI_VAR_HASH_SIZE];
+static u32 __efi_runtime_data efi_var_hash_count;
+
+/**
+ * efi_var_hash_key() - hash GUID and name of a variable
+ *
+ * @guid:	GUID
+ * @name:	variable name
+ * Return:	FNV-1a hash
+ */
+static u32 __efi_runtime efi_var_hash_key(const efi_guid_t *guid,
+					  const u16 *name)
+{
+	const u8 *data = (const u8 *)guid;
+	u32 hash = 2166136261U;
+	int i;
+
+	for (i = 0; i < sizeof(efi_guid_t); ++i)
+		hash = (hash ^ data[i]) * 16777619U;
+	for (; *name; ++name)
+		hash = (hash ^ *name) * 16777619U;
+
+	return hash;
+}
+
+/**
+ * efi_var_hash_add() - add a variable to the index
+ *
+ * @var:	variable in efi_var_buf
+ */
+static void __efi_runtime efi_var_hash_add(struct efi_var_entry *var)
+{
+	u32 i;
+
+	if (efi_var_hash_count >= EFI_VAR_HASH_SIZE / 4 * 3) {
+		efi_var_hash_count = EFI_VAR_HASH_SIZE;
+		return;
+	}
+
+	i = efi_var_hash_key(&var->guid, var->name) & (EFI_VAR_HASH_SIZE - 1);
+	while (efi_var_hash[i])
+		i = (i + 1) & (EFI_VAR_HASH_SIZE - 1);
+	efi_var_hash[i] = (uintptr_t)var - (uintptr_t)efi_var_buf;
+	++efi_var_hash_count;
+}
+
+/**
+ * efi_var_hash_rebuild() - index all variables in efi_var_buf
+ */
+static void __efi_runtime efi_var_hash_rebuild(void)
+{
+	struct efi_var_entry *var, *last;
+	u32 i;
+
+	for (i = 0; i < EFI_VAR_HASH_SIZE; ++i)
+		efi_var_hash[i] = 0;
+	efi_var_hash_count = 0;
+
+	last = (struct efi_var_entry *)
+	       ((uintptr_t)efi_var_buf + efi_var_buf->length);
+	for (var = efi_var_buf->var; var < last;
+	     var = (void *)var + efi_var_entry_len(var))
+		efi_var_hash_add(var);
+}
+
 /**
  * efi_var_mem_compare() - compare GUID and name with a variable
  *
@@ -85,6 +160,7 @@ struct efi_var_entry __efi_runtime
 		  struct efi_var_entry **next)
 {
 	struct efi_var_entry *var, *last;
+	u32 i;
 
 	last = (struct efi_var_entry *)
 	       ((uintptr_t)efi_var_buf + efi_var_buf->length);
@@ -104,6 +180,24 @@ struct efi_var_entry __efi_runtime
 		return efi_current_var;
 	}
 
+	if (efi_var_hash_count < EFI_VAR_HASH_SIZE) {
+		i = efi_var_hash_key(guid, name) & (EFI_VAR_HASH_SIZE - 1);
+		for (; efi_var_hash[i]; i = (i + 1) & (EFI_VAR_HASH_SIZE - 1)) {
+			struct efi_var_entry *pos;
+
+			var = (struct efi_var_entry *)
+			      ((uintptr_t)efi_var_buf + efi_var_hash[i]);
+			if (efi_var_mem_compare(var, guid, name, &pos)) {
+				if (next)
+					*next = pos < last ? pos : NULL;
+				return var;
+			}
+		}
+		if (next)
+			*next = NULL;
+		return NULL;
+	}
+
 	var = efi_var_buf->var;
 	if (var < last) {
 		for (; var;) {
@@ -151,6 +245,9 @@ void __efi_runtime efi_var_mem_del(struct efi_var_entry *var)
 	efi_var_buf->crc32 = crc32(0, (u8 *)efi_var_buf->var,
 				   efi_var_buf->length -
 				   sizeof(struct efi_var_file));
+
+	/* the variables after @var have moved */
+	efi_var_hash_rebuild();
 }
 
 efi_status_t __efi_runtime efi_var_mem_ins(
@@ -182,6 +279,7 @@ efi_status_t __efi_runtime efi_var_mem_ins(
 			   sizeof(u16) * var_name_len);
 	efi_memcpy_runtime(data, data1, size1);
 	efi_memcpy_runtime((u8 *)data + size1, data2, size2);
+	efi_var_hash_add(var);
 
 	var = (struct efi_var_entry *)
 	      ALIGN((uintptr_t)data + var->length, 8);
@@ -233,6 +331,7 @@ efi_status_t efi_var_mem_init(void)
 	efi_var_buf->magic = EFI_VAR_FILE_MAGIC;
 	efi_var_buf->length = (uintptr_t)efi_var_buf->var -
 			      (uintptr_t)efi_var_buf;
+	efi_var_hash_rebuild();
 
 	ret = efi_create_event(EVT_SIGNAL_VIRTUAL_ADDRESS_CHANGE, TPL_CALLBACK,
 			       efi_var_mem_notify_virtual_address_map, NULL,
@@ -398,4 +497,6 @@ skip:
 void efi_var_buf_update(struct efi_var_file *var_buf)
 {
 	memcpy(efi_var_buf, var_buf, EFI_VAR_BUF_SIZE);
+	efi_current_var = NULL;
+	efi_var_hash_rebuild();
 }
@@ -391,6 +391,9 @@ efi_status_t efi_set_variable_int(const u16 *variable_name,
 
 	efi_var_mem_del(var);
 
+	if (IS_ENABLED(CONFIG_EFI_SECURE_BOOT))
+		efi_sigstore_invalidate(var_type);
+
 	if (var_type == EFI_AUTH_VAR_PK)
 		ret = efi_init_secure_state();
 	else
@@ -401,7 +404,7 @@ efi_status_t efi_set_variable_int(const u16 *variable_name,
 	 * TODO: check if a value change has occured to avoid superfluous writes
 	 */
 	if (attributes & EFI_VARIABLE_NON_VOLATILE)
-		efi_var_to_file();
+		efi_var_file_update(variable_name, vendor);
 
 	return EFI_SUCCESS;
 }
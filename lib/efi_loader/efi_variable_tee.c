@@ -846,6 +846,10 @@ efi_status_t efi_set_variable_int(const u16 *variable_name,
 	if (ret != EFI_SUCCESS)
 		alt_ret = ret;
 
+	if (IS_ENABLED(CONFIG_EFI_SECURE_BOOT))
+		efi_sigstore_invalidate(efi_auth_var_get_type(variable_name,
+							      vendor));
+
 	if (ro && !(var_property.property & VAR_CHECK_VARIABLE_PROPERTY_READ_ONLY)) {
 		var_property.revision = VAR_CHECK_VARIABLE_PROPERTY_REVISION;
 		var_property.property |= VAR_CHECK_VARIABLE_PROPERTY_READ_ONLY;
@@ -28,6 +28,7 @@
 #include <mapmem.h>
 #include <linux/libfdt.h>
 #include <serial.h>
+#include <sort.h>
 #include <asm/global_data.h>
 #include <asm/sections.h>
 #include <dm/ofnode.h>
@@ -436,7 +437,7 @@ int fdtdec_add_aliases_for_id(const void *blob, const char *name,
 		prop = fdt_get_property_by_offset(blob, offset, NULL);
 		path = fdt_string(blob, fdt32_to_cpu(prop->nameoff));
 		if (prop->len && 0 == strncmp(path, name, name_len))
-			node = fdt_path_offset(blob, prop->data);
+			node = fdtdec_path_offset(blob, prop->data);
 		if (node <= 0)
 			continue;
 
@@ -599,7 +600,7 @@ const char *fdtdec_get_chosen_prop(const void *blob, const char *name)
 
 	if (!blob)
 		return NULL;
-	chosen_node = fdt_path_offset(blob, "/chosen");
+	chosen_node = fdtdec_path_offset(blob, "/chosen");
 	return fdt_getprop(blob, chosen_node, name, NULL);
 }
 
@@ -610,7 +611,7 @@ int fdtdec_get_chosen_node(const void *blob, const char *name)
 	prop = fdtdec_get_chosen_prop(blob, name);
 	if (!prop)
 		return -FDT_ERR_NOTFOUND;
-	return fdt_path_offset(blob, prop);
+	return fdtdec_path_offset(blob, prop);
 }
 
 /**
@@ -653,6 +654,276 @@ int fdtdec_check_fdt(void)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(OF_LIBFDT_INDEX)
+enum {
+	FDT_INDEX_MAX_DEPTH	= 32,
+	/* Larger phandles are not indexed, to bound the size of the index */
+	FDT_INDEX_MAX_PHANDLE	= 0x10000,
+};
+
+/**
+ * struct fdtdec_index_node - a node of the path index
+ *
+ * @hash: fdtdec_index_hash() of the full path of the node
+ * @offset: Offset of the node
+ */
+struct fdtdec_index_node {
+	u32 hash;
+	int offset;
+};
+
+/**
+ * struct fdtdec_index - path and phandle index of a blob
+ *
+ * @blob: Blob which was indexed
+ * @size_dt_struct: Size of the structure block when indexed
+ * @num_nodes: Number of entries in @nodes
+ * @nodes: Nodes sorted by @hash
+ * @num_phandles: Number of entries in @phandles
+ * @phandles: Node offset for each phandle, or -1 if none
+ */
+struct fdtdec_index {
+	const void *blob;
+	u32 size_dt_struct;
+	int num_nodes;
+	struct fdtdec_index_node *nodes;
+	u32 num_phandles;
+	int *phandles;
+};
+
+static u32 fdtdec_index_hash(u32 hash, const char *str, int len)
+{
+	while (len--)
+		hash = (hash ^ (u8)*str++) * 16777619U;
+
+	return hash;
+}
+
+static int fdtdec_index_cmp(const void *a, const void *b)
+{
+	const struct fdtdec_index_node *na = a, *nb = b;
+
+	return na->hash < nb->hash ? -1 : na->hash > nb->hash;
+}
+
+/**
+ * fdtdec_index_build() - index the nodes of a blob
+ *
+ * Nodes deeper than FDT_INDEX_MAX_DEPTH are left out, as are nodes whose
+ * path libfdt may resolve differently, so lookups of them fall back to
+ * libfdt.
+ *
+ * @blob: FDT blob
+ * Return: new index, or NULL if out of memory or the blob is invalid
+ */
+static struct fdtdec_index *fdtdec_index_build(const void *blob)
+{
+	u32 hashes[FDT_INDEX_MAX_DEPTH];
+	int offsets[FDT_INDEX_MAX_DEPTH];
+	int skip = FDT_INDEX_MAX_DEPTH;
+	struct fdtdec_index *idx;
+	int num_nodes = 0, depth = 0;
+	u32 max_phandle = 0;
+	int offset, i;
+
+	for (offset = 0; offset >= 0;
+	     offset = fdt_next_node(blob, offset, &depth)) {
+		u32 phandle = fdt_get_phandle(blob, offset);
+
+		if (depth < FDT_INDEX_MAX_DEPTH)
+			num_nodes++;
+		if (phandle < FDT_INDEX_MAX_PHANDLE && phandle > max_phandle)
+			max_phandle = phandle;
+	}
+	if (offset != -FDT_ERR_NOTFOUND)
+		return NULL;
+
+	idx = malloc(sizeof(*idx) + num_nodes * sizeof(idx->nodes[0]) +
+		     (max_phandle + 1) * sizeof(idx->phandles[0]));
+	if (!idx)
+		return NULL;
+	idx->blob = blob;
+	idx->size_dt_struct = fdt_size_dt_struct(blob);
+	idx->num_nodes = 0;
+	idx->nodes = (struct fdtdec_index_node *)(idx + 1);
+	idx->num_phandles = max_phandle + 1;
+	idx->phandles = (int *)(idx->nodes + num_nodes);
+	for (i = 0; i < idx->num_phandles; i++)
+		idx->phandles[i] = -1;
+
+	/* The root node is "/", so its children start from an empty path */
+	depth = 0;
+	hashes[0] = 2166136261U;
+	for (offset = 0; offset >= 0;
+	     offset = fdt_next_node(blob, offset, &depth)) {
+		u32 phandle = fdt_get_phandle(blob, offset);
+		const char *name;
+		int len;
+
+		if (phandle && phandle < idx->num_phandles)
+			idx->phandles[phandle] = offset;
+		if (depth <= skip)
+			skip = FDT_INDEX_MAX_DEPTH;
+		if (!depth || depth >= skip)
+			continue;
+		offsets[depth] = offset;
+		name = fdt_get_name(blob, offset, &len);
+		if (!name) {
+			skip = depth;
+			continue;
+		}
+
+		/*
+		 * A name without a unit address also matches an earlier
+		 * sibling with one, so libfdt may find another node for this
+		 * path. Leave such nodes and their children out.
+		 */
+		if (!memchr(name, '@', len) &&
+		    fdt_subnode_offset_namelen(blob, offsets[depth - 1], name,
+					       len) != offset) {
+			skip = depth;
+			continue;
+		}
+		hashes[depth] = fdtdec_index_hash(hashes[depth - 1], "/", 1);
+		hashes[depth] = fdtdec_index_hash(hashes[depth], name, len);
+		idx->nodes[idx->num_nodes].hash = hashes[depth];
+		idx->nodes[idx->num_nodes++].offset = offset;
+	}
+	qsort(idx->nodes, idx->num_nodes, sizeof(idx->nodes[0]),
+	      fdtdec_index_cmp);
+
+	return idx;
+}
+
+/**
+ * fdtdec_index_get() - get an up-to-date index of a blob
+ *
+ * The most recently used index is kept in slot 0. An index whose blob no
+ * longer has the same structure-block size is rebuilt.
+ *
+ * @blob: FDT blob
+ * @rebuild: true to rebuild the index even if it looks up to date
+ * Return: index, or NULL if it cannot be built
+ */
+static struct fdtdec_index *fdtdec_index_get(const void *blob, bool rebuild)
+{
+	struct fdtdec_index **slot = gd->fdt_index;
+	struct fdtdec_index *idx;
+
+	if (slot[1] && slot[1]->blob == blob) {
+		idx = slot[1];
+		slot[1] = slot[0];
+		slot[0] = idx;
+	}
+	idx = slot[0];
+	if (idx && idx->blob == blob && !rebuild &&
+	    idx->size_dt_struct == fdt_size_dt_struct(blob))
+		return idx;
+
+	if (idx && idx->blob == blob) {
+		free(idx);
+	} else {
+		free(slot[1]);
+		slot[1] = idx;
+	}
+	slot[0] = fdtdec_index_build(blob);
+
+	return slot[0];
+}
+
+void fdtdec_index_invalidate(const void *blob)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(gd->fdt_index); i++) {
+		if (gd->fdt_index[i] && gd->fdt_index[i]->blob == blob) {
+			free(gd->fdt_index[i]);
+			gd->fdt_index[i] = NULL;
+		}
+	}
+}
+
+/**
+ * fdtdec_index_find_path() - look up a path in an index
+ *
+ * Entries with the same hash are checked against the last component of
+ * @path, which also catches nodes moved by changes not yet detected.
+ *
+ * @idx: Index to search
+ * @path: Absolute path, not "/"
+ * Return: node offset, or -FDT_ERR_NOTFOUND
+ */
+static int fdtdec_index_find_path(struct fdtdec_index *idx, const char *path)
+{
+	u32 hash = fdtdec_index_hash(2166136261U, path, strlen(path));
+	const char *last = strrchr(path, '/') + 1;
+	int lo = 0, hi = idx->num_nodes;
+
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (idx->nodes[mid].hash < hash)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	for (; lo < idx->num_nodes && idx->nodes[lo].hash == hash; lo++) {
+		const char *name;
+		int len;
+
+		name = fdt_get_name(idx->blob, idx->nodes[lo].offset, &len);
+		if (name && len == strlen(last) && !memcmp(name, last, len))
+			return idx->nodes[lo].offset;
+	}
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+int fdtdec_path_offset(const void *blob, const char *path)
+{
+	struct fdtdec_index *idx;
+	int offset;
+
+	/* Aliases, "/" and untidy paths are left to libfdt */
+	if (*path != '/' || !path[1] || path[strlen(path) - 1] == '/')
+		return fdt_path_offset(blob, path);
+
+	idx = fdtdec_index_get(blob, false);
+	if (idx) {
+		offset = fdtdec_index_find_path(idx, path);
+		if (offset >= 0)
+			return offset;
+	}
+
+	/* Not indexed, or only found with a partial name */
+	return fdt_path_offset(blob, path);
+}
+
+int fdtdec_node_offset_by_phandle(const void *blob, uint32_t phandle)
+{
+	struct fdtdec_index *idx;
+	int offset;
+
+	if (!phandle || phandle == (uint32_t)-1)
+		return -FDT_ERR_BADPHANDLE;
+
+	idx = fdtdec_index_get(blob, false);
+	if (idx && phandle < idx->num_phandles) {
+		offset = idx->phandles[phandle];
+		if (offset >= 0 && fdt_get_phandle(blob, offset) != phandle) {
+			/* The tree changed without moving the end of it */
+			idx = fdtdec_index_get(blob, true);
+			offset = idx && phandle < idx->num_phandles ?
+				idx->phandles[phandle] : -1;
+		}
+		if (offset >= 0)
+			return offset;
+	}
+
+	return fdt_node_offset_by_phandle(blob, phandle);
+}
+#endif
+
 int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 {
 	const u32 *phandle;
@@ -663,7 +934,7 @@ int fdtdec_lookup_phandle(const void *blob, int node, const char *prop_name)
 	if (!phandle)
 		return -FDT_ERR_NOTFOUND;
 
-	lookup = fdt_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
+	lookup = fdtdec_node_offset_by_phandle(blob, fdt32_to_cpu(*phandle));
 	return lookup;
 }
 
@@ -794,8 +1065,8 @@ int fdtdec_parse_phandle_with_args(const void *blob, int src_node,
 			 * below.
 			 */
 			if (cells_name || cur_index == index) {
-				node = fdt_node_offset_by_phandle(blob,
-								  phandle);
+				node = fdtdec_node_offset_by_phandle(blob,
+								     phandle);
 				if (node < 0) {
 					debug("%s: could not find phandle\n",
 					      fdt_get_name(blob, src_node,
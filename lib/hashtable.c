@@ -53,11 +53,26 @@
  * which describes the current status.
  */
 
+/*
+ * Each node records the full hash of its key, so that a probe only needs to
+ * call strcmp() when the hashes match. Entries created by a bulk import of
+ * the default environment point into a single copy of it (htab->bulk) rather
+ * than owning their key and data; the shared flags record which of the two
+ * must not be freed.
+ */
 struct env_entry_node {
 	int used;
+	unsigned int hash;
+	int shared;
 	struct env_entry entry;
 };
 
+#define NODE_SHARED_KEY		(1 << 0)
+#define NODE_SHARED_DATA	(1 << 1)
+
+/* Grow the table when it becomes more than this full (in quarters) */
+#define HTAB_MAX_LOAD		3
+
 static void _hdelete(const char *key, struct hsearch_data *htab,
 		     struct env_entry *ep, int idx);
 
@@ -83,6 +98,88 @@ static int isprime(unsigned int number)
 	return number % div != 0;
 }
 
+static unsigned int next_prime(unsigned int nel)
+{
+	nel |= 1;		/* make odd */
+	while (!isprime(nel))
+		nel += 2;
+
+	return nel;
+}
+
+/* FNV-1a, which spreads the common prefixes of variable names well */
+static unsigned int hhash(const char *key)
+{
+	unsigned int hash = 2166136261U;
+
+	while (*key) {
+		hash ^= (unsigned char)*key++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+/* First hash function: simply take the modulus but prevent zero */
+static unsigned int hfirst(unsigned int hash, unsigned int size)
+{
+	unsigned int hval = hash % size;
+
+	return hval ? hval : 1;
+}
+
+/* Second hash function, used to step between probes, as suggested in [Knuth] */
+static unsigned int hstep(unsigned int hval, unsigned int size)
+{
+	return 1 + hval % (size - 2);
+}
+
+/*
+ * Move all entries into a table of about twice the size, dropping any deleted
+ * slots along the way. This is only done between operations, never while a
+ * callback or hwalk_r() may hold a pointer into the table.
+ *
+ * Returns 0 on success, -ENOMEM if there is no memory for the new table, in
+ * which case the old one is left as it was
+ */
+static int hgrow(struct hsearch_data *htab)
+{
+	struct env_entry_node *old = htab->table;
+	unsigned int old_size = htab->size;
+	unsigned int size, i;
+
+	size = next_prime(old_size * 2);
+	htab->table = calloc(size + 1, sizeof(struct env_entry_node));
+	if (!htab->table) {
+		htab->table = old;
+		return -ENOMEM;
+	}
+	htab->size = size;
+
+	for (i = 1; i <= old_size; i++) {
+		struct env_entry_node *node = &old[i];
+		unsigned int hval, idx;
+
+		if (node->used <= 0)
+			continue;
+		hval = hfirst(node->hash, size);
+		for (idx = hval; htab->table[idx].used != USED_FREE;) {
+			unsigned int hval2 = hstep(hval, size);
+
+			if (idx <= hval2)
+				idx = size + idx - hval2;
+			else
+				idx -= hval2;
+		}
+		htab->table[idx] = *node;
+		htab->table[idx].used = hval;
+	}
+	free(old);
+	debug("hgrow: table %p now %u entries\n", htab, size);
+
+	return 0;
+}
+
 /*
  * Before using the hash table we must allocate memory for it.
  * Test for an existing table are done. We allocate one element
@@ -107,11 +204,7 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	}
 
 	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
-
-	htab->size = nel;
+	htab->size = next_prime(nel);
 	htab->filled = 0;
 
 	/* allocate memory and zero out */
@@ -149,12 +242,17 @@ void hdestroy_r(struct hsearch_data *htab)
 	for (i = 1; i <= htab->size; ++i) {
 		if (htab->table[i].used > 0) {
 			struct env_entry *ep = &htab->table[i].entry;
+			int shared = htab->table[i].shared;
 
-			free((void *)ep->key);
-			free(ep->data);
+			if (!(shared & NODE_SHARED_KEY))
+				free((void *)ep->key);
+			if (!(shared & NODE_SHARED_DATA))
+				free(ep->data);
 		}
 	}
 	free(htab->table);
+	free(htab->bulk);
+	htab->bulk = NULL;
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
@@ -218,8 +316,8 @@ int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
 }
 
 static int
-do_callback(const struct env_entry *e, const char *name, const char *value,
-	    enum env_op op, int flags)
+do_callback(struct hsearch_data *htab, const struct env_entry *e,
+	    const char *name, const char *value, enum env_op op, int flags)
 {
 	int ret = 0;
 
@@ -242,7 +340,10 @@ do_callback(const struct env_entry *e, const char *name, const char *value,
 	 * U_BOOT_ENV_CALLBACK(bar, on_bar);
 	 */
 	in_callback = true;
+	/* the caller holds an index into the table, so it must not move */
+	htab->busy++;
 	ret = e->callback(name, value, op, flags);
+	htab->busy--;
 	in_callback = false;
 #endif
 
@@ -256,10 +357,15 @@ do_callback(const struct env_entry *e, const char *name, const char *value,
 static inline int _compare_and_overwrite_entry(struct env_entry item,
 		enum env_action action, struct env_entry **retval,
 		struct hsearch_data *htab, int flag, unsigned int hval,
-		unsigned int idx)
+		unsigned int hash, unsigned int idx, bool shared)
 {
-	if (htab->table[idx].used == hval
-	    && strcmp(item.key, htab->table[idx].entry.key) == 0) {
+	struct env_entry_node *node = &htab->table[idx];
+
+	htab->probes++;
+	if (node->used != hval || node->hash != hash)
+		return -1;
+	htab->compares++;
+	if (strcmp(item.key, node->entry.key) == 0) {
 		/* Overwrite existing value? */
 		if (action == ENV_ENTER && item.data) {
 			/* check for permission */
@@ -274,7 +380,7 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 			}
 
 			/* If there is a callback, call it */
-			if (do_callback(&htab->table[idx].entry, item.key,
+			if (do_callback(htab, &htab->table[idx].entry, item.key,
 					item.data, env_op_overwrite, flag)) {
 				debug("callback() rejected setting variable "
 					"%s, skipping it!\n", item.key);
@@ -283,9 +389,16 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 				return 0;
 			}
 
-			free(htab->table[idx].entry.data);
-			htab->table[idx].entry.data = strdup(item.data);
-			if (!htab->table[idx].entry.data) {
+			if (!(node->shared & NODE_SHARED_DATA))
+				free(node->entry.data);
+			if (shared) {
+				node->entry.data = item.data;
+				node->shared |= NODE_SHARED_DATA;
+			} else {
+				node->entry.data = strdup(item.data);
+				node->shared &= ~NODE_SHARED_DATA;
+			}
+			if (!node->entry.data) {
 				__set_errno(ENOMEM);
 				*retval = NULL;
 				return 0;
@@ -299,31 +412,32 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 	return -1;
 }
 
-int hsearch_r(struct env_entry item, enum env_action action,
-	      struct env_entry **retval, struct hsearch_data *htab, int flag)
+/*
+ * Search for, and possibly enter, an entry. With @shared the key and data of
+ * a new entry are taken as they are rather than copied; see himport_r()
+ */
+static int _hsearch(struct env_entry item, enum env_action action,
+		    struct env_entry **retval, struct hsearch_data *htab,
+		    int flag, bool shared)
 {
+	unsigned int hash;
 	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
 	unsigned int idx;
 	unsigned int first_deleted = 0;
 	int ret;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
-
 	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
+	 * Keep the load low enough that probe chains stay short. If the table
+	 * cannot move just now, or there is no memory, carry on until it is
+	 * actually full
 	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
+	if (action == ENV_ENTER && !htab->busy &&
+	    (htab->filled + 1) * 4 > htab->size * HTAB_MAX_LOAD)
+		hgrow(htab);
+
+	htab->lookups++;
+	hash = hhash(item.key);
+	hval = hfirst(hash, htab->size);
 
 	/* The first index tried. */
 	idx = hval;
@@ -339,15 +453,12 @@ int hsearch_r(struct env_entry item, enum env_action action,
 			first_deleted = idx;
 
 		ret = _compare_and_overwrite_entry(item, action, retval, htab,
-			flag, hval, idx);
+			flag, hval, hash, idx, shared);
 		if (ret != -1)
 			return ret;
 
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
-		hval2 = 1 + hval % (htab->size - 2);
+		/* Second hash function */
+		hval2 = hstep(hval, htab->size);
 
 		do {
 			/*
@@ -372,7 +483,7 @@ int hsearch_r(struct env_entry item, enum env_action action,
 
 			/* If entry is found use it. */
 			ret = _compare_and_overwrite_entry(item, action, retval,
-				htab, flag, hval, idx);
+				htab, flag, hval, hash, idx, shared);
 			if (ret != -1)
 				return ret;
 		}
@@ -399,8 +510,17 @@ int hsearch_r(struct env_entry item, enum env_action action,
 			idx = first_deleted;
 
 		htab->table[idx].used = hval;
-		htab->table[idx].entry.key = strdup(item.key);
-		htab->table[idx].entry.data = strdup(item.data);
+		htab->table[idx].hash = hash;
+		if (shared) {
+			htab->table[idx].shared = NODE_SHARED_KEY |
+				NODE_SHARED_DATA;
+			htab->table[idx].entry.key = item.key;
+			htab->table[idx].entry.data = item.data;
+		} else {
+			htab->table[idx].shared = 0;
+			htab->table[idx].entry.key = strdup(item.key);
+			htab->table[idx].entry.data = strdup(item.data);
+		}
 		if (!htab->table[idx].entry.key ||
 		    !htab->table[idx].entry.data) {
 			__set_errno(ENOMEM);
@@ -427,8 +547,8 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		}
 
 		/* If there is a callback, call it */
-		if (do_callback(&htab->table[idx].entry, item.key, item.data,
-				env_op_create, flag)) {
+		if (do_callback(htab, &htab->table[idx].entry, item.key,
+				item.data, env_op_create, flag)) {
 			debug("callback() rejected setting variable "
 				"%s, skipping it!\n", item.key);
 			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
@@ -447,6 +567,12 @@ int hsearch_r(struct env_entry item, enum env_action action,
 	return 0;
 }
 
+int hsearch_r(struct env_entry item, enum env_action action,
+	      struct env_entry **retval, struct hsearch_data *htab, int flag)
+{
+	return _hsearch(item, action, retval, htab, flag, false);
+}
+
 /*
  * hdelete()
  */
@@ -462,8 +588,11 @@ static void _hdelete(const char *key, struct hsearch_data *htab,
 {
 	/* free used entry */
 	debug("hdelete: DELETING key \"%s\"\n", key);
-	free((void *)ep->key);
-	free(ep->data);
+	if (!(htab->table[idx].shared & NODE_SHARED_KEY))
+		free((void *)ep->key);
+	if (!(htab->table[idx].shared & NODE_SHARED_DATA))
+		free(ep->data);
+	htab->table[idx].shared = 0;
 	ep->flags = 0;
 	htab->table[idx].used = USED_DELETED;
 
@@ -495,7 +624,7 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 	}
 
 	/* If there is a callback, call it */
-	if (do_callback(&htab->table[idx].entry, key, NULL,
+	if (do_callback(htab, &htab->table[idx].entry, key, NULL,
 			env_op_delete, flag)) {
 		debug("callback() rejected deleting variable "
 			"%s, skipping it!\n", key);
@@ -804,6 +933,12 @@ static int drop_var_from_set(const char *name, int nvars, char * vars[])
  *
  * In theory, arbitrary separator characters can be used, but only
  * '\0' and '\n' have really been tested.
+ *
+ * When the default environment (H_DEFAULT) replaces the whole table, the
+ * table is sized for the number of entries up front and the entries point
+ * straight into the local copy of the data, which is then kept for the
+ * life of the table. This saves two allocations per variable on the common
+ * path of booting without a stored environment.
  */
 
 int himport_r(struct hsearch_data *htab,
@@ -812,6 +947,7 @@ int himport_r(struct hsearch_data *htab,
 {
 	char *data, *sp, *dp, *name, *value;
 	char *localvars[nvars];
+	bool bulk = false;
 	int i;
 
 	/* Test for correct arguments.  */
@@ -844,6 +980,7 @@ int himport_r(struct hsearch_data *htab,
 		       htab->table);
 		if (htab->table)
 			hdestroy_r(htab);
+		bulk = flag & H_DEFAULT;
 	}
 
 	/*
@@ -870,6 +1007,17 @@ int himport_r(struct hsearch_data *htab,
 		if (nent > CONFIG_ENV_MAX_ENTRIES)
 			nent = CONFIG_ENV_MAX_ENTRIES;
 
+		/* Make room for all of the entries without needing to grow */
+		if (bulk) {
+			int count = 0;
+
+			for (i = 0; i < size; i++)
+				count += !data[i] || data[i] == sep;
+			count = count * 4 / HTAB_MAX_LOAD + 1;
+			if (nent < count)
+				nent = count;
+		}
+
 		debug("Create Hash Table: N=%d\n", nent);
 
 		if (hcreate_r(nent, htab) == 0) {
@@ -945,7 +1093,11 @@ int himport_r(struct hsearch_data *htab,
 		if (*name == 0) {
 			debug("INSERT: unable to use an empty key\n");
 			__set_errno(EINVAL);
-			free(data);
+			/* entries imported so far may point into the data */
+			if (bulk)
+				htab->bulk = data;
+			else
+				free(data);
 			return 0;
 		}
 
@@ -957,7 +1109,7 @@ int himport_r(struct hsearch_data *htab,
 		e.key = name;
 		e.data = value;
 
-		hsearch_r(e, ENV_ENTER, &rv, htab, flag);
+		_hsearch(e, ENV_ENTER, &rv, htab, flag, bulk);
 #if !IS_ENABLED(CONFIG_ENV_WRITEABLE_LIST)
 		if (rv == NULL) {
 			printf("himport_r: can't insert \"%s=%s\" into hash table\n",
@@ -970,8 +1122,12 @@ int himport_r(struct hsearch_data *htab,
 			rv, name, value);
 	} while ((dp < data + size) && *dp);	/* size check needed for text */
 						/* without '\0' termination */
-	debug("INSERT: free(data = %p)\n", data);
-	free(data);
+	if (bulk) {
+		htab->bulk = data;
+	} else {
+		debug("INSERT: free(data = %p)\n", data);
+		free(data);
+	}
 
 	if (flag & H_NOCLEAR)
 		goto end;
@@ -1010,15 +1166,18 @@ end:
 int hwalk_r(struct hsearch_data *htab, int (*callback)(struct env_entry *entry))
 {
 	int i;
-	int retval;
+	int retval = 0;
 
+	/* the callback may add variables, but the table must not move */
+	htab->busy++;
 	for (i = 1; i <= htab->size; ++i) {
 		if (htab->table[i].used > 0) {
 			retval = callback(&htab->table[i].entry);
 			if (retval)
-				return retval;
+				break;
 		}
 	}
+	htab->busy--;
 
-	return 0;
+	return retval;
 }
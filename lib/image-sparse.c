@@ -58,7 +58,9 @@ static lbaint_t write_sparse_chunk_raw(struct sparse_storage *info,
 	lbaint_t aligned_buf_blks = FASTBOOT_MAX_BLK_WRITE;
 	uint32_t *aligned_buf = NULL;
 
-	if (CONFIG_IS_ENABLED(SYS_DCACHE_OFF)) {
+	/* Only bounce chunks whose data is not suitably aligned for DMA */
+	if (CONFIG_IS_ENABLED(SYS_DCACHE_OFF) ||
+	    IS_ALIGNED((ulong)data, ARCH_DMA_MINALIGN)) {
 		write_blks = info->write(info, blk, n, data);
 		if (write_blks < n)
 			goto write_fail;
@@ -106,41 +108,94 @@ write_fail:
 	return -1;
 }
 
-int write_sparse_image(struct sparse_storage *info,
-		       const char *part_name, void *data, char *response)
+static int write_sparse_chunk_fill(struct sparse_stream *ss, lbaint_t blkcnt,
+				   uint32_t fill_val, char *response)
 {
-	lbaint_t blk;
-	lbaint_t blkcnt;
-	lbaint_t blks;
-	uint64_t bytes_written = 0;
-	unsigned int chunk;
-	unsigned int offset;
-	uint64_t chunk_data_sz;
-	uint32_t *fill_buf = NULL;
-	uint32_t fill_val;
-	sparse_header_t *sparse_header;
-	chunk_header_t *chunk_header;
-	uint32_t total_blocks = 0;
+	struct sparse_storage *info = ss->info;
 	int fill_buf_num_blks;
+	lbaint_t blks;
 	int i;
 	int j;
 
 	fill_buf_num_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE / info->blksz;
 
-	/* Read and skip over sparse image header */
-	sparse_header = (sparse_header_t *)data;
+	/* Large zero fills are cheaper to discard than write */
+	if (!fill_val && info->erase && blkcnt >= fill_buf_num_blks) {
+		blks = info->erase(info, ss->blk, blkcnt);
+		if (blks < blkcnt) {
+			printf("%s: %s " LBAFU " [" LBAFU "]\n", __func__,
+			       "Erase failed, block #", ss->blk, blkcnt);
+			info->mssg("flash erase failure", response);
+			return -1;
+		}
+		ss->blk += blks;
+		return 0;
+	}
+
+	/* The fill buffer is kept across chunks of the image */
+	if (!ss->fill_buf) {
+		ss->fill_buf = (uint32_t *)
+			       memalign(ARCH_DMA_MINALIGN,
+					ROUNDUP(info->blksz * fill_buf_num_blks,
+						ARCH_DMA_MINALIGN));
+		if (!ss->fill_buf) {
+			info->mssg("Malloc failed for: CHUNK_TYPE_FILL",
+				   response);
+			return -1;
+		}
+		ss->fill_buf_val = ~fill_val;
+	}
+
+	if (ss->fill_buf_val != fill_val) {
+		for (i = 0;
+		     i < (info->blksz * fill_buf_num_blks / sizeof(fill_val));
+		     i++)
+			ss->fill_buf[i] = fill_val;
+		ss->fill_buf_val = fill_val;
+	}
 
-	data += sparse_header->file_hdr_sz;
-	if (sparse_header->file_hdr_sz > sizeof(sparse_header_t)) {
-		/*
-		 * Skip the remaining bytes in a header that is longer than
-		 * we expected.
-		 */
-		data += (sparse_header->file_hdr_sz - sizeof(sparse_header_t));
+	for (i = 0; i < blkcnt;) {
+		j = blkcnt - i;
+		if (j > fill_buf_num_blks)
+			j = fill_buf_num_blks;
+		blks = info->write(info, ss->blk, j, ss->fill_buf);
+		/* blks might be > j (eg. NAND bad-blocks) */
+		if (blks < j) {
+			printf("%s: %s " LBAFU " [%d]\n", __func__,
+			       "Write failed, block #", ss->blk, j);
+			info->mssg("flash write failure", response);
+			return -1;
+		}
+		ss->blk += blks;
+		i += j;
 	}
 
+	return 0;
+}
+
+void sparse_stream_init(struct sparse_stream *ss, struct sparse_storage *info)
+{
+	memset(ss, 0, sizeof(*ss));
+	ss->info = info;
+	ss->blk = info->start;
+
 	if (!info->mssg)
 		info->mssg = default_log;
+}
+
+static long sparse_stream_header(struct sparse_stream *ss, const void *data,
+				 size_t len, char *response)
+{
+	sparse_header_t *sparse_header = &ss->header;
+	unsigned int offset;
+
+	if (len < sizeof(sparse_header_t))
+		return 0;
+
+	memcpy(sparse_header, data, sizeof(sparse_header_t));
+	/* Wait for the remaining bytes of a longer header as well */
+	if (len < sparse_header->file_hdr_sz)
+		return 0;
 
 	debug("=== Sparse Image Header ===\n");
 	debug("magic: 0x%x\n", sparse_header->magic);
@@ -152,167 +207,248 @@ int write_sparse_image(struct sparse_storage *info,
 	debug("total_blks: %d\n", sparse_header->total_blks);
 	debug("total_chunks: %d\n", sparse_header->total_chunks);
 
+	if (sparse_header->file_hdr_sz < sizeof(sparse_header_t) ||
+	    sparse_header->chunk_hdr_sz < sizeof(chunk_header_t)) {
+		printf("%s: Sparse image header size issue\n", __func__);
+		ss->info->mssg("sparse image header size issue", response);
+		return -1;
+	}
+
 	/*
 	 * Verify that the sparse block size is a multiple of our
 	 * storage backend block size
 	 */
-	div_u64_rem(sparse_header->blk_sz, info->blksz, &offset);
+	div_u64_rem(sparse_header->blk_sz, ss->info->blksz, &offset);
 	if (offset) {
 		printf("%s: Sparse image block size issue [%u]\n",
 		       __func__, sparse_header->blk_sz);
-		info->mssg("sparse image block size issue", response);
+		ss->info->mssg("sparse image block size issue", response);
 		return -1;
 	}
 
 	puts("Flashing Sparse Image\n");
+	ss->have_header = true;
 
-	/* Start processing chunks */
-	blk = info->start;
-	for (chunk = 0; chunk < sparse_header->total_chunks; chunk++) {
-		/* Read and skip over chunk header */
-		chunk_header = (chunk_header_t *)data;
-		data += sizeof(chunk_header_t);
-
-		if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
-			debug("=== Chunk Header ===\n");
-			debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
-			debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
-			debug("total_size: 0x%x\n", chunk_header->total_sz);
-		}
+	return sparse_header->file_hdr_sz;
+}
+
+static void sparse_stream_end_chunk(struct sparse_stream *ss)
+{
+	ss->in_chunk = false;
+	ss->chunk++;
+}
+
+static long sparse_stream_chunk_header(struct sparse_stream *ss,
+				       const void *data, size_t len,
+				       char *response)
+{
+	struct sparse_storage *info = ss->info;
+	sparse_header_t *sparse_header = &ss->header;
+	chunk_header_t *chunk_header = &ss->chunk_header;
+	lbaint_t blkcnt;
 
-		if (sparse_header->chunk_hdr_sz > sizeof(chunk_header_t)) {
-			/*
-			 * Skip the remaining bytes in a header that is longer
-			 * than we expected.
-			 */
-			data += (sparse_header->chunk_hdr_sz -
-				 sizeof(chunk_header_t));
+	if (len < sparse_header->chunk_hdr_sz)
+		return 0;
+
+	/* Any bytes of a longer header past the known fields are skipped */
+	memcpy(chunk_header, data, sizeof(chunk_header_t));
+
+	if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
+		debug("=== Chunk Header ===\n");
+		debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
+		debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
+		debug("total_size: 0x%x\n", chunk_header->total_sz);
+	}
+
+	ss->chunk_data_sz = ((u64)sparse_header->blk_sz) * chunk_header->chunk_sz;
+	blkcnt = DIV_ROUND_UP_ULL(ss->chunk_data_sz, info->blksz);
+	switch (chunk_header->chunk_type) {
+	case CHUNK_TYPE_RAW:
+		if (chunk_header->total_sz !=
+		    (sparse_header->chunk_hdr_sz + ss->chunk_data_sz)) {
+			info->mssg("Bogus chunk size for chunk type Raw",
+				   response);
+			return -1;
+		}
+		ss->raw_left = ss->chunk_data_sz;
+		break;
+
+	case CHUNK_TYPE_FILL:
+		if (chunk_header->total_sz !=
+		    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
+			info->mssg("Bogus chunk size for chunk type FILL",
+				   response);
+			return -1;
+		}
+		break;
+
+	case CHUNK_TYPE_DONT_CARE:
+		ss->blk += info->reserve(info, ss->blk, blkcnt);
+		ss->total_blocks += chunk_header->chunk_sz;
+		sparse_stream_end_chunk(ss);
+		return sparse_header->chunk_hdr_sz;
+
+	case CHUNK_TYPE_CRC32:
+		if (chunk_header->total_sz !=
+		    sparse_header->chunk_hdr_sz + sizeof(uint32_t)) {
+			info->mssg("Bogus chunk size for chunk type CRC32",
+				   response);
+			return -1;
 		}
+		break;
 
-		chunk_data_sz = ((u64)sparse_header->blk_sz) * chunk_header->chunk_sz;
-		blkcnt = DIV_ROUND_UP_ULL(chunk_data_sz, info->blksz);
-		switch (chunk_header->chunk_type) {
-		case CHUNK_TYPE_RAW:
-			if (chunk_header->total_sz !=
-			    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
-				info->mssg("Bogus chunk size for chunk type Raw",
-					   response);
-				return -1;
-			}
-
-			if (blk + blkcnt > info->start + info->size) {
-				printf(
-				    "%s: Request would exceed partition size!\n",
-				    __func__);
-				info->mssg("Request would exceed partition size!",
-					   response);
-				return -1;
-			}
-
-			blks = write_sparse_chunk_raw(info, blk, blkcnt,
-						      data, response);
-			if (IS_ERR_VALUE(blks))
-				return -1;
-
-			blk += blks;
-			bytes_written += ((u64)blkcnt) * info->blksz;
-			total_blocks += chunk_header->chunk_sz;
-			data += chunk_data_sz;
-			break;
+	default:
+		printf("%s: Unknown chunk type: %x\n", __func__,
+		       chunk_header->chunk_type);
+		info->mssg("Unknown chunk type", response);
+		return -1;
+	}
 
-		case CHUNK_TYPE_FILL:
-			if (chunk_header->total_sz !=
-			    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
-				info->mssg("Bogus chunk size for chunk type FILL", response);
-				return -1;
-			}
-
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
-						info->blksz * fill_buf_num_blks,
-						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				info->mssg("Malloc failed for: CHUNK_TYPE_FILL",
-					   response);
-				return -1;
-			}
-
-			fill_val = *(uint32_t *)data;
-			data = (char *)data + sizeof(uint32_t);
-
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
-
-			if (blk + blkcnt > info->start + info->size) {
-				printf(
-				    "%s: Request would exceed partition size!\n",
-				    __func__);
-				info->mssg("Request would exceed partition size!",
-					   response);
-				return -1;
-			}
-
-			for (i = 0; i < blkcnt;) {
-				j = blkcnt - i;
-				if (j > fill_buf_num_blks)
-					j = fill_buf_num_blks;
-				blks = info->write(info, blk, j, fill_buf);
-				/* blks might be > j (eg. NAND bad-blocks) */
-				if (blks < j) {
-					printf("%s: %s " LBAFU " [%d]\n",
-					       __func__,
-					       "Write failed, block #",
-					       blk, j);
-					info->mssg("flash write failure",
-						   response);
-					free(fill_buf);
-					return -1;
-				}
-				blk += blks;
-				i += j;
-			}
-			bytes_written += ((u64)blkcnt) * info->blksz;
-			total_blocks += DIV_ROUND_UP_ULL(chunk_data_sz,
-							 sparse_header->blk_sz);
-			free(fill_buf);
-			break;
+	if (ss->blk + blkcnt > info->start + info->size) {
+		printf("%s: Request would exceed partition size!\n", __func__);
+		info->mssg("Request would exceed partition size!", response);
+		return -1;
+	}
 
-		case CHUNK_TYPE_DONT_CARE:
-			blk += info->reserve(info, blk, blkcnt);
-			total_blocks += chunk_header->chunk_sz;
-			break;
+	ss->in_chunk = true;
+	if (chunk_header->chunk_type == CHUNK_TYPE_RAW && !ss->raw_left)
+		sparse_stream_end_chunk(ss);
 
-		case CHUNK_TYPE_CRC32:
-			if (chunk_header->total_sz !=
-			    sparse_header->chunk_hdr_sz + sizeof(uint32_t)) {
-				info->mssg("Bogus chunk size for chunk type CRC32",
-					   response);
-				return -1;
-			}
-			total_blocks += chunk_header->chunk_sz;
-			data += chunk_data_sz;
-			break;
+	return sparse_header->chunk_hdr_sz;
+}
+
+static long sparse_stream_chunk_data(struct sparse_stream *ss,
+				     const void *data, size_t len,
+				     char *response)
+{
+	struct sparse_storage *info = ss->info;
+	chunk_header_t *chunk_header = &ss->chunk_header;
+	lbaint_t blkcnt, blks;
+	uint32_t fill_val;
+	size_t n;
+
+	switch (chunk_header->chunk_type) {
+	case CHUNK_TYPE_RAW:
+		/* RAW data is consumed a whole number of blocks at a time */
+		n = min_t(u64, ss->raw_left, len);
+		blkcnt = lldiv(n, info->blksz);
+		if (!blkcnt)
+			return 0;
+
+		blks = write_sparse_chunk_raw(info, ss->blk, blkcnt,
+					      (void *)data, response);
+		if (IS_ERR_VALUE(blks))
+			return -1;
+
+		n = blkcnt * info->blksz;
+		ss->blk += blks;
+		ss->raw_left -= n;
+		ss->bytes_written += n;
+		if (ss->raw_left)
+			return n;
 
-		default:
-			printf("%s: Unknown chunk type: %x\n", __func__,
-			       chunk_header->chunk_type);
-			info->mssg("Unknown chunk type", response);
+		ss->total_blocks += chunk_header->chunk_sz;
+		break;
+
+	case CHUNK_TYPE_FILL:
+		if (len < sizeof(fill_val))
+			return 0;
+
+		memcpy(&fill_val, data, sizeof(fill_val));
+		blkcnt = DIV_ROUND_UP_ULL(ss->chunk_data_sz, info->blksz);
+		if (write_sparse_chunk_fill(ss, blkcnt, fill_val, response))
 			return -1;
+
+		ss->bytes_written += ((u64)blkcnt) * info->blksz;
+		ss->total_blocks += DIV_ROUND_UP_ULL(ss->chunk_data_sz,
+						     ss->header.blk_sz);
+		n = sizeof(fill_val);
+		break;
+
+	case CHUNK_TYPE_CRC32:
+	default:
+		if (len < sizeof(uint32_t))
+			return 0;
+
+		ss->total_blocks += chunk_header->chunk_sz;
+		n = sizeof(uint32_t);
+		break;
+	}
+
+	sparse_stream_end_chunk(ss);
+
+	return n;
+}
+
+long sparse_stream_write(struct sparse_stream *ss, const void *data,
+			 size_t len, char *response)
+{
+	size_t done = 0;
+	long ret;
+
+	while (done < len) {
+		if (!ss->have_header)
+			ret = sparse_stream_header(ss, data + done,
+						   len - done, response);
+		else if (ss->chunk == ss->header.total_chunks)
+			break;
+		else if (!ss->in_chunk)
+			ret = sparse_stream_chunk_header(ss, data + done,
+							 len - done, response);
+		else
+			ret = sparse_stream_chunk_data(ss, data + done,
+						       len - done, response);
+		if (ret < 0) {
+			free(ss->fill_buf);
+			ss->fill_buf = NULL;
+			return ret;
 		}
+		if (!ret)
+			break;
+
+		done += ret;
+	}
+
+	return done;
+}
+
+int sparse_stream_finish(struct sparse_stream *ss, const char *part_name,
+			 char *response)
+{
+	int ret = -1;
+
+	if (!ss->have_header || ss->chunk != ss->header.total_chunks) {
+		printf("%s: Sparse image is truncated\n", __func__);
+		ss->info->mssg("sparse image truncated", response);
+		goto out;
 	}
 
 	debug("Wrote %d blocks, expected to write %d blocks\n",
-	      total_blocks, sparse_header->total_blks);
-	printf("........ wrote %llu bytes to '%s'\n", bytes_written, part_name);
+	      ss->total_blocks, ss->header.total_blks);
+	printf("........ wrote %llu bytes to '%s'\n", ss->bytes_written,
+	       part_name);
 
-	if (total_blocks != sparse_header->total_blks) {
-		info->mssg("sparse image write failure", response);
-		return -1;
+	if (ss->total_blocks != ss->header.total_blks) {
+		ss->info->mssg("sparse image write failure", response);
+		goto out;
 	}
 
-	return 0;
+	ret = 0;
+out:
+	free(ss->fill_buf);
+	ss->fill_buf = NULL;
+	return ret;
+}
+
+int write_sparse_image(struct sparse_storage *info,
+		       const char *part_name, void *data, char *response)
+{
+	struct sparse_stream ss;
+
+	/* The whole image is in memory, so let the headers bound it */
+	sparse_stream_init(&ss, info);
+	if (sparse_stream_write(&ss, data, SIZE_MAX, response) < 0)
+		return -1;
+
+	return sparse_stream_finish(&ss, part_name, response);
 }
@@ -3,11 +3,17 @@
  * Copyright (c) 2013 The Chromium OS Authors.
  */
 
+#include <board_f.h>
+#include <bootstage.h>
 #include <efi.h>
 #include <initcall.h>
+#include <kallsyms.h>
 #include <log.h>
+#include <malloc.h>
 #include <relocate.h>
+#include <vsprintf.h>
 #include <asm/global_data.h>
+#include <linux/string.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -42,6 +48,55 @@ static int initcall_is_event(init_fnc_t func)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_INITCALLS)
+/**
+ * initcall_record() - report an initcall which took a long time
+ *
+ * @func: Function which was called (relocated)
+ * @type: Event number, if this was an event, else 0
+ * @reloc_ofs: Relocation offset of @func
+ * @time_us: Time the initcall took, in microseconds
+ */
+static void initcall_record(init_fnc_t func, enum event_t type,
+			    ulong reloc_ofs, ulong time_us)
+{
+	const char *name = NULL;
+	ulong base;
+	char buf[30];
+
+	if (time_us < CONFIG_BOOTSTAGE_INITCALL_THRESHOLD_US)
+		return;
+
+	if (type)
+		name = event_type_name(type);
+	else if (IS_ENABLED(CONFIG_KALLSYMS))
+		name = symbol_lookup((ulong)func - reloc_ofs, &base);
+	if (!name) {
+		snprintf(buf, sizeof(buf), "initcall %p",
+			 (char *)func - reloc_ofs);
+		name = buf;
+	}
+	printf("initcall: %s took %lu us\n", name, time_us);
+
+	/*
+	 * The space for the record names is fixed when bootstage is reserved
+	 * for relocation, so anything later must wait for relocation
+	 */
+	if (!(gd->flags & GD_FLG_RELOC) && gd->boardf &&
+	    gd->boardf->new_bootstage)
+		return;
+	if (name == buf)
+		name = strdup(buf);
+	if (name)
+		bootstage_add_accum(name, time_us);
+}
+#else
+static inline void initcall_record(init_fnc_t func, enum event_t type,
+				   ulong reloc_ofs, ulong time_us)
+{
+}
+#endif
+
 /*
  * To enable debugging. add #define DEBUG at the top of the including file.
  *
@@ -53,6 +108,7 @@ int initcall_run_list(const init_fnc_t init_sequence[])
 	const init_fnc_t *ptr;
 	enum event_t type;
 	init_fnc_t func;
+	ulong start = 0;
 	int ret = 0;
 
 	for (ptr = init_sequence; func = *ptr, func; ptr++) {
@@ -71,9 +127,17 @@ int initcall_run_list(const init_fnc_t init_sequence[])
 			debug("initcall: %p\n", (char *)func - reloc_ofs);
 		}
 
+		/* the timer may not be usable before bootstage is set up */
+		if (CONFIG_IS_ENABLED(BOOTSTAGE_INITCALLS) && gd_bootstage())
+			start = timer_get_boot_us();
 		ret = type ? event_notify_null(type) : func();
 		if (ret)
 			break;
+		if (CONFIG_IS_ENABLED(BOOTSTAGE_INITCALLS) && start) {
+			initcall_record(func, type, reloc_ofs,
+					timer_get_boot_us() - start);
+			start = 0;
+		}
 	}
 
 	if (ret) {
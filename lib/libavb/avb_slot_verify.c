@@ -26,6 +26,29 @@
 /* Maximum size of a vbmeta image - 64 KiB. */
 #define VBMETA_MAX_SIZE (64 * 1024)
 
+/* Size of the pieces a partition is read in while it is hashed - 1 MiB. */
+#define HASH_CHUNK_SIZE (1024 * 1024)
+
+/* A piece of a partition to add to the hash of the partition. Exactly one of
+ * |sha256_ctx| and |sha512_ctx| is set.
+ */
+typedef struct {
+  AvbSHA256Ctx* sha256_ctx;
+  AvbSHA512Ctx* sha512_ctx;
+  const uint8_t* data;
+  size_t len;
+} HashChunk;
+
+static void hash_chunk(void* arg) {
+  HashChunk* chunk = arg;
+
+  if (chunk->sha256_ctx != NULL) {
+    avb_sha256_update(chunk->sha256_ctx, chunk->data, chunk->len);
+  } else {
+    avb_sha512_update(chunk->sha512_ctx, chunk->data, chunk->len);
+  }
+}
+
 static AvbSlotVerifyResult initialize_persistent_digest(
     AvbOps* ops,
     const char* part_name,
@@ -57,13 +80,21 @@ static inline bool result_should_continue(AvbSlotVerifyResult result) {
   return false;
 }
 
+/* Loads the first |image_size| bytes of |part_name|. If |hash| is not NULL,
+ * the first |hash_size| bytes are also added to the hash context in |hash|.
+ * The partition is then read in pieces, each of which is hashed while the
+ * next one is read.
+ */
 static AvbSlotVerifyResult load_full_partition(AvbOps* ops,
                                                const char* part_name,
                                                uint64_t image_size,
+                                               HashChunk* hash,
+                                               size_t hash_size,
                                                uint8_t** out_image_buf,
                                                bool* out_image_preloaded) {
   size_t part_num_read;
   AvbIOResult io_ret;
+  size_t offset, len;
 
   /* Make sure that we do not overwrite existing data. */
   avb_assert(*out_image_buf == NULL);
@@ -93,33 +124,56 @@ static AvbSlotVerifyResult load_full_partition(AvbOps* ops,
         return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
       }
       *out_image_preloaded = true;
+      if (hash != NULL) {
+        hash->data = *out_image_buf;
+        hash->len = hash_size;
+        hash_chunk(hash);
+      }
+      return AVB_SLOT_VERIFY_RESULT_OK;
     }
   }
 
   /* Allocate and copy the partition. */
-  if (!*out_image_preloaded) {
-    *out_image_buf = avb_malloc(image_size);
-    if (*out_image_buf == NULL) {
-      return AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
-    }
+  *out_image_buf = avb_malloc(image_size);
+  if (*out_image_buf == NULL) {
+    return AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
+  }
 
+  for (offset = 0; offset < image_size; offset += len) {
+    len = image_size - offset;
+    if (hash != NULL && len > HASH_CHUNK_SIZE) {
+      len = HASH_CHUNK_SIZE;
+    }
     io_ret = ops->read_from_partition(ops,
                                       part_name,
-                                      0 /* offset */,
-                                      image_size,
-                                      *out_image_buf,
+                                      offset,
+                                      len,
+                                      *out_image_buf + offset,
                                       &part_num_read);
+    if (io_ret == AVB_IO_RESULT_OK && part_num_read != len) {
+      avb_errorv(part_name, ": Read incorrect number of bytes.\n", NULL);
+      io_ret = AVB_IO_RESULT_ERROR_IO;
+    }
+
+    /* Wait for the previous piece to be hashed before using |hash|. */
+    if (hash != NULL) {
+      avb_async_wait();
+    }
     if (io_ret == AVB_IO_RESULT_ERROR_OOM) {
       return AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
     } else if (io_ret != AVB_IO_RESULT_OK) {
       avb_errorv(part_name, ": Error loading data from partition.\n", NULL);
       return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
     }
-    if (part_num_read != image_size) {
-      avb_errorv(part_name, ": Read incorrect number of bytes.\n", NULL);
-      return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
+    if (hash != NULL && offset < hash_size) {
+      hash->data = *out_image_buf + offset;
+      hash->len = hash_size - offset < len ? hash_size - offset : len;
+      avb_async_run(hash_chunk, hash);
     }
   }
+  if (hash != NULL) {
+    avb_async_wait();
+  }
 
   return AVB_SLOT_VERIFY_RESULT_OK;
 }
@@ -363,16 +417,12 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
     avb_debugv(part_name, ": Loading entire partition.\n", NULL);
   }
 
-  ret = load_full_partition(
-      ops, part_name, image_size, &image_buf, &image_preloaded);
-  if (ret != AVB_SLOT_VERIFY_RESULT_OK) {
-    goto out;
-  }
   // Although only one of the type might be used, we have to defined the
   // structure here so that they would live outside the 'if/else' scope to be
   // used later.
   AvbSHA256Ctx sha256_ctx;
   AvbSHA512Ctx sha512_ctx;
+  HashChunk hash = {NULL, NULL, NULL, 0};
   size_t image_size_to_hash = hash_desc.image_size;
   // If we allow verification error and the whole partition is smaller than
   // image size in hash descriptor, we just hash the whole partition.
@@ -382,21 +432,36 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
   if (avb_strcmp((const char*)hash_desc.hash_algorithm, "sha256") == 0) {
     avb_sha256_init(&sha256_ctx);
     avb_sha256_update(&sha256_ctx, desc_salt, hash_desc.salt_len);
-    avb_sha256_update(&sha256_ctx, image_buf, image_size_to_hash);
-    digest = avb_sha256_final(&sha256_ctx);
-    digest_len = AVB_SHA256_DIGEST_SIZE;
+    hash.sha256_ctx = &sha256_ctx;
   } else if (avb_strcmp((const char*)hash_desc.hash_algorithm, "sha512") == 0) {
     avb_sha512_init(&sha512_ctx);
     avb_sha512_update(&sha512_ctx, desc_salt, hash_desc.salt_len);
-    avb_sha512_update(&sha512_ctx, image_buf, image_size_to_hash);
-    digest = avb_sha512_final(&sha512_ctx);
-    digest_len = AVB_SHA512_DIGEST_SIZE;
+    hash.sha512_ctx = &sha512_ctx;
   } else {
     avb_errorv(part_name, ": Unsupported hash algorithm.\n", NULL);
     ret = AVB_SLOT_VERIFY_RESULT_ERROR_INVALID_METADATA;
     goto out;
   }
 
+  /* The partition is hashed as it is read. */
+  ret = load_full_partition(ops,
+                            part_name,
+                            image_size,
+                            &hash,
+                            image_size_to_hash,
+                            &image_buf,
+                            &image_preloaded);
+  if (ret != AVB_SLOT_VERIFY_RESULT_OK) {
+    goto out;
+  }
+  if (hash.sha256_ctx != NULL) {
+    digest = avb_sha256_final(&sha256_ctx);
+    digest_len = AVB_SHA256_DIGEST_SIZE;
+  } else {
+    digest = avb_sha512_final(&sha512_ctx);
+    digest_len = AVB_SHA512_DIGEST_SIZE;
+  }
+
   if (hash_desc.digest_len == 0) {
     /* Expect a match to a persistent digest. */
     avb_debugv(part_name, ": No digest, using persistent digest.\n", NULL);
@@ -500,7 +565,7 @@ static AvbSlotVerifyResult load_requested_partitions(
     avb_debugv(part_name, ": Loading entire partition.\n", NULL);
 
     ret = load_full_partition(
-        ops, part_name, image_size, &image_buf, &image_preloaded);
+        ops, part_name, image_size, NULL, 0, &image_buf, &image_preloaded);
     if (ret != AVB_SLOT_VERIFY_RESULT_OK) {
       goto out;
     }
@@ -103,6 +103,19 @@ size_t avb_strlen(const char* str) AVB_ATTR_WARN_UNUSED_RESULT;
  * remainder. */
 uint32_t avb_div_by_10(uint64_t* dividend);
 
+/* Calls |func| with |arg|, possibly on another CPU so that the caller can
+ * carry on with something else, e.g. reading the next part of an image while
+ * the previous one is hashed. Only one call can be outstanding: the caller
+ * must use avb_async_wait() before the next one, and before using anything
+ * |func| touches.
+ *
+ * |func| must not call any avb_ functions other than the hash functions.
+ */
+void avb_async_run(void (*func)(void* arg), void* arg);
+
+/* Waits for the function passed to avb_async_run() to complete. */
+void avb_async_wait(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,6 +3,7 @@
  * Copyright (C) 2016 The Android Open Source Project
  */
 
+#include <cpu_func.h>
 #include <hang.h>
 #include <malloc.h>
 #include <stdarg.h>
@@ -66,3 +67,11 @@ uint32_t avb_div_by_10(uint64_t* dividend) {
   *dividend /= 10;
   return rem;
 }
+
+void avb_async_run(void (*func)(void* arg), void* arg) {
+  cpu_work_queue(func, arg);
+}
+
+void avb_async_wait(void) {
+  cpu_work_barrier();
+}
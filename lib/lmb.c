@@ -7,6 +7,7 @@
  */
 
 #include <alist.h>
+#include <bloblist.h>
 #include <efi_loader.h>
 #include <event.h>
 #include <image.h>
@@ -53,6 +54,29 @@ static long lmb_addrs_adjacent(phys_addr_t base1, phys_size_t size1,
 	return 0;
 }
 
+/*
+ * The regions in a list are kept sorted by base address and do not overlap,
+ * so their ends are sorted too. Find the first region which ends at or above
+ * @addr, returning the number of regions if there is none.
+ */
+static unsigned long lmb_region_search(struct alist *lmb_rgn_lst,
+				       phys_addr_t addr)
+{
+	struct lmb_region *rgn = lmb_rgn_lst->data;
+	unsigned long low = 0, high = lmb_rgn_lst->count;
+
+	while (low < high) {
+		unsigned long mid = low + (high - low) / 2;
+
+		if (rgn[mid].base + rgn[mid].size - 1 < addr)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
 static long lmb_regions_overlap(struct alist *lmb_rgn_lst, unsigned long r1,
 				unsigned long r2)
 {
@@ -79,14 +103,10 @@ static long lmb_regions_adjacent(struct alist *lmb_rgn_lst, unsigned long r1,
 
 static void lmb_remove_region(struct alist *lmb_rgn_lst, unsigned long r)
 {
-	unsigned long i;
 	struct lmb_region *rgn = lmb_rgn_lst->data;
 
-	for (i = r; i < lmb_rgn_lst->count - 1; i++) {
-		rgn[i].base = rgn[i + 1].base;
-		rgn[i].size = rgn[i + 1].size;
-		rgn[i].flags = rgn[i + 1].flags;
-	}
+	memmove(&rgn[r], &rgn[r + 1],
+		(lmb_rgn_lst->count - r - 1) * sizeof(*rgn));
 	lmb_rgn_lst->count--;
 }
 
@@ -150,6 +170,9 @@ static long lmb_resize_regions(struct alist *lmb_rgn_lst,
 				return -1;
 			rgn_cnt++;
 			idx_end = idx;
+		} else if (rgnbase > base) {
+			/* the list is sorted, so nothing further overlaps */
+			break;
 		}
 		idx++;
 	}
@@ -197,8 +220,13 @@ static long lmb_add_region_flags(struct alist *lmb_rgn_lst, phys_addr_t base,
 	if (alist_err(lmb_rgn_lst))
 		return -1;
 
-	/* First try and coalesce this LMB with another. */
-	for (i = 0; i < lmb_rgn_lst->count; i++) {
+	/*
+	 * First try and coalesce this LMB with another. Only the first region
+	 * ending next to or above the new one can be adjacent or overlapping
+	 * with it before any later one.
+	 */
+	i = lmb_region_search(lmb_rgn_lst, base ? base - 1 : 0);
+	for (; i < lmb_rgn_lst->count; i++) {
 		phys_addr_t rgnbase = rgn[i].base;
 		phys_size_t rgnsize = rgn[i].size;
 		u32 rgnflags = rgn[i].flags;
@@ -227,9 +255,11 @@ static long lmb_add_region_flags(struct alist *lmb_rgn_lst, phys_addr_t base,
 
 			coalesced++;
 			break;
-
-			return -1;
 		}
+
+		/* nothing further up can be adjacent or overlapping either */
+		i = lmb_rgn_lst->count;
+		break;
 	}
 
 	if (lmb_rgn_lst->count && i < lmb_rgn_lst->count - 1) {
@@ -255,16 +285,12 @@ static long lmb_add_region_flags(struct alist *lmb_rgn_lst, phys_addr_t base,
 	rgn = lmb_rgn_lst->data;
 
 	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = lmb_rgn_lst->count; i >= 0; i--) {
-		if (i && base < rgn[i - 1].base) {
-			rgn[i] = rgn[i - 1];
-		} else {
-			rgn[i].base = base;
-			rgn[i].size = size;
-			rgn[i].flags = flags;
-			break;
-		}
-	}
+	i = lmb_region_search(lmb_rgn_lst, base);
+	memmove(&rgn[i + 1], &rgn[i],
+		(lmb_rgn_lst->count - i) * sizeof(*rgn));
+	rgn[i].base = base;
+	rgn[i].size = size;
+	rgn[i].flags = flags;
 
 	lmb_rgn_lst->count++;
 
@@ -285,16 +311,14 @@ static long _lmb_free(struct alist *lmb_rgn_lst, phys_addr_t base,
 
 	rgn = lmb_rgn_lst->data;
 	/* Find the region where (base, size) belongs to */
-	for (i = 0; i < lmb_rgn_lst->count; i++) {
+	i = lmb_region_search(lmb_rgn_lst, base);
+	if (i < lmb_rgn_lst->count) {
 		rgnbegin = rgn[i].base;
 		rgnend = rgnbegin + rgn[i].size - 1;
-
-		if (rgnbegin <= base && end <= rgnend)
-			break;
 	}
 
 	/* Didn't find the region */
-	if (i == lmb_rgn_lst->count)
+	if (i == lmb_rgn_lst->count || rgnbegin > base || end > rgnend)
 		return -1;
 
 	/* Check to see if we are removing entire region */
@@ -325,21 +349,19 @@ static long _lmb_free(struct alist *lmb_rgn_lst, phys_addr_t base,
 				    rgn[i].flags);
 }
 
+/* Get the index of the lowest region overlapping (base, size), or -1 */
 static long lmb_overlaps_region(struct alist *lmb_rgn_lst, phys_addr_t base,
 				phys_size_t size)
 {
 	unsigned long i;
 	struct lmb_region *rgn = lmb_rgn_lst->data;
 
-	for (i = 0; i < lmb_rgn_lst->count; i++) {
-		phys_addr_t rgnbase = rgn[i].base;
-		phys_size_t rgnsize = rgn[i].size;
+	i = lmb_region_search(lmb_rgn_lst, base);
+	if (i < lmb_rgn_lst->count &&
+	    lmb_addrs_overlap(base, size, rgn[i].base, rgn[i].size))
+		return i;
 
-		if (lmb_addrs_overlap(base, size, rgnbase, rgnsize))
-			break;
-	}
-
-	return (i < lmb_rgn_lst->count) ? i : -1;
+	return -1;
 }
 
 /*
@@ -561,6 +583,13 @@ static void lmb_reserve_uboot_region(void)
 
 		break;
 	}
+
+#if CONFIG_IS_ENABLED(BLOBLIST_KEEP_FIXED)
+	/* the bloblist was not moved into the region above */
+	if (gd->bloblist)
+		lmb_reserve(map_to_sysmem(gd->bloblist),
+			    gd->bloblist->total_size, LMB_NOOVERWRITE);
+#endif
 }
 
 static void lmb_reserve_common(void *fdt_blob)
@@ -783,16 +812,15 @@ phys_size_t lmb_get_free_size(phys_addr_t addr)
 	/* check if the requested address is in the memory regions */
 	rgn = lmb_overlaps_region(&lmb.available_mem, addr, 1);
 	if (rgn >= 0) {
-		for (i = 0; i < lmb.used_mem.count; i++) {
+		/* the first reserved range ending at or above addr */
+		i = lmb_region_search(&lmb.used_mem, addr);
+		if (i < lmb.used_mem.count) {
 			if (addr < lmb_used[i].base) {
 				/* first reserved range > requested address */
 				return lmb_used[i].base - addr;
 			}
-			if (lmb_used[i].base +
-			    lmb_used[i].size > addr) {
-				/* requested addr is in this reserved range */
-				return 0;
-			}
+			/* requested addr is in this reserved range */
+			return 0;
 		}
 		/* if we come here: no reserved ranges above requested addr */
 		return lmb_memory[lmb.available_mem.count - 1].base +
@@ -803,15 +831,13 @@ phys_size_t lmb_get_free_size(phys_addr_t addr)
 
 int lmb_is_reserved_flags(phys_addr_t addr, int flags)
 {
-	int i;
+	long i;
 	struct lmb_region *lmb_used = lmb.used_mem.data;
 
-	for (i = 0; i < lmb.used_mem.count; i++) {
-		phys_addr_t upper = lmb_used[i].base +
-			lmb_used[i].size - 1;
-		if (addr >= lmb_used[i].base && addr <= upper)
-			return (lmb_used[i].flags & flags) == flags;
-	}
+	i = lmb_overlaps_region(&lmb.used_mem, addr, 1);
+	if (i >= 0)
+		return (lmb_used[i].flags & flags) == flags;
+
 	return 0;
 }
 
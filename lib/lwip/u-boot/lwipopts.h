@@ -66,6 +66,13 @@
 #define MEMP_NUM_TCP_SEG                16
 #define PBUF_POOL_SIZE                  8
 
+#if defined(CONFIG_LWIP_RX_ZERO_COPY)
+#define LWIP_SUPPORT_CUSTOM_PBUF        1
+#endif
+
+/* 32-bit at a time, which is the fastest generic one */
+#define LWIP_CHKSUM_ALGORITHM           3
+
 #define LWIP_ARP                        1
 #define ARP_TABLE_SIZE                  4
 #define ARP_QUEUEING                    1
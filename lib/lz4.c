@@ -47,6 +47,22 @@ __rcode static FORCE_INLINE void LZ4_copy8(void *dst, const void *src)
 	put_unaligned(get_unaligned((const u64 *)src), (u64 *)dst);
 }
 
+/*
+ * U-Boot is built with -fno-builtin, so a fixed-size memcpy() is a function
+ * call rather than a couple of loads and stores. Use these in the hot paths.
+ */
+__rcode static FORCE_INLINE void LZ4_copy4(void *dst, const void *src)
+{
+	put_unaligned(get_unaligned((const u32 *)src), (u32 *)dst);
+}
+
+/* Copies in order, so a match may overlap the second half of its output */
+__rcode static FORCE_INLINE void LZ4_copy16(void *dst, const void *src)
+{
+	LZ4_copy8(dst, src);
+	LZ4_copy8(dst + 8, src + 8);
+}
+
 typedef  uint8_t BYTE;
 typedef uint16_t U16;
 typedef uint32_t U32;
@@ -226,7 +242,10 @@ __rcode static FORCE_INLINE int LZ4_decompress_generic(
 		   && likely((endOnInput ? ip < shortiend : 1) &
 			     (op <= shortoend))) {
 			/* Copy the literals */
-			memcpy(op, ip, endOnInput ? 16 : 8);
+			if (endOnInput)
+				LZ4_copy16(op, ip);
+			else
+				LZ4_copy8(op, ip);
 			op += length; ip += length;
 
 			/*
@@ -245,9 +264,9 @@ __rcode static FORCE_INLINE int LZ4_decompress_generic(
 			    (offset >= 8) &&
 			    (dict == withPrefix64k || match >= lowPrefix)) {
 				/* Copy the match. */
-				memcpy(op + 0, match + 0, 8);
-				memcpy(op + 8, match + 8, 8);
-				memcpy(op + 16, match + 16, 2);
+				LZ4_copy16(op, match);
+				put_unaligned(get_unaligned((const U16 *)(match + 16)),
+					      (U16 *)(op + 16));
 				op += length + MINMATCH;
 				/* Both stages worked, load the next token. */
 				continue;
@@ -477,7 +496,7 @@ _copy_match:
 			op[2] = match[2];
 			op[3] = match[3];
 			match += inc32table[offset];
-			memcpy(op + 4, match, 4);
+			LZ4_copy4(op + 4, match);
 			match -= dec64table[offset];
 		} else {
 			LZ4_copy8(op, match);
@@ -5,7 +5,9 @@
 
 #include <compiler.h>
 #include <image.h>
+#include <malloc.h>
 #include <linux/kernel.h>
+#include <linux/sizes.h>
 #include <linux/types.h>
 #include <asm/unaligned.h>
 #include <u-boot/lz4.h>
@@ -15,6 +17,36 @@
 
 #define LZ4F_BLOCKUNCOMPRESSED_FLAG 0x80000000U
 
+/*
+ * Decompress (or copy) one block to @out, without going past @end. Returns the
+ * number of bytes written, -ENOBUFS if the output is overrun or -EPROTO if the
+ * data is corrupt.
+ */
+__rcode static int ulz4_block(const void *in, u32 block_header, void *out,
+			      const void *end)
+{
+	u32 block_size = block_header & ~LZ4F_BLOCKUNCOMPRESSED_FLAG;
+	int ret;
+
+	if (block_header & LZ4F_BLOCKUNCOMPRESSED_FLAG) {
+		size_t size = min((ptrdiff_t)block_size, (ptrdiff_t)(end - out));
+
+		memcpy(out, in, size);
+		if (size < block_size)
+			return -ENOBUFS;	/* output overrun */
+		return size;
+	}
+
+	/* constant folding essential, do not touch params! */
+	ret = LZ4_decompress_generic(in, out, block_size, end - out,
+				     endOnInputSize, decode_full_block, noDict,
+				     out, NULL, 0);
+	if (ret < 0)
+		return -EPROTO;		/* decompression error */
+
+	return ret;
+}
+
 __rcode int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 {
 	const void *end = dst + *dstn;
@@ -78,25 +110,12 @@ __rcode int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 			break;
 		}
 
-		if (block_header & LZ4F_BLOCKUNCOMPRESSED_FLAG) {
-			size_t size = min((ptrdiff_t)block_size, (ptrdiff_t)(end - out));
-			memcpy(out, in, size);
-			out += size;
-			if (size < block_size) {
-				ret = -ENOBUFS;	/* output overrun */
-				break;
-			}
-		} else {
-			/* constant folding essential, do not touch params! */
-			ret = LZ4_decompress_generic(in, out, block_size,
-					end - out, endOnInputSize,
-					decode_full_block, noDict, out, NULL, 0);
-			if (ret < 0) {
-				ret = -EPROTO;	/* decompression error */
-				break;
-			}
-			out += ret;
-		}
+		ret = ulz4_block(in, block_header, out, end);
+		if (ret == -ENOBUFS)
+			out = (void *)end;
+		if (ret < 0)
+			break;
+		out += ret;
 
 		in += block_size;
 		if (has_block_checksum)
@@ -106,3 +125,128 @@ __rcode int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 	*dstn = out - dst;
 	return ret;
 }
+
+enum {
+	ULZ4_HEADER,		/* fixed part of the frame header */
+	ULZ4_HEADER_REST,	/* content size and header checksum */
+	ULZ4_BLOCK_SIZE,
+	ULZ4_BLOCK,
+	ULZ4_CHECKSUM,		/* block checksum */
+	ULZ4_DONE,
+};
+
+void ulz4_stream_init(struct ulz4_stream *st, void *dst, size_t dstn)
+{
+	memset(st, '\0', sizeof(*st));
+	st->start = dst;
+	st->out = dst;
+	st->end = dst + dstn;
+	st->state = ULZ4_HEADER;
+	st->need = 6;
+}
+
+/* Handle the next item of the frame, which is st->need bytes at @in */
+static int ulz4_stream_item(struct ulz4_stream *st, const u8 *in)
+{
+	u32 size;
+	int ret;
+
+	switch (st->state) {
+	case ULZ4_HEADER: {
+		u8 flags = in[4], block_desc = in[5];
+		uint max_id = (block_desc >> 4) & 7;
+
+		if (get_unaligned_le32(in) != LZ4F_MAGIC ||
+		    ((flags >> 6) & 3) != 1)
+			return -EPROTONOSUPPORT;	/* unknown format */
+		if ((flags & 0x03) || (block_desc & 0x8f) || max_id < 4)
+			return -EINVAL;	/* reserved bits must be zero */
+		if (!(flags & 0x20))
+			return -EPROTONOSUPPORT; /* linked blocks */
+		st->block_checksum = flags & 0x10;
+		st->max_block = SZ_64K << (2 * (max_id - 4));
+		st->state = ULZ4_HEADER_REST;
+		st->need = (flags & 0x08) ? sizeof(u64) + 1 : 1;
+		break;
+	}
+	case ULZ4_CHECKSUM:
+	case ULZ4_HEADER_REST:
+		st->state = ULZ4_BLOCK_SIZE;
+		st->need = sizeof(u32);
+		break;
+	case ULZ4_BLOCK_SIZE:
+		st->block_header = get_unaligned_le32(in);
+		size = st->block_header & ~LZ4F_BLOCKUNCOMPRESSED_FLAG;
+		if (!size) {
+			st->state = ULZ4_DONE;
+			break;
+		}
+		if (size > st->max_block)
+			return -EINVAL;
+		st->state = ULZ4_BLOCK;
+		st->need = size;
+		break;
+	case ULZ4_BLOCK:
+		ret = ulz4_block(in, st->block_header, st->out, st->end);
+		if (ret < 0)
+			return ret;
+		st->out += ret;
+		st->state = st->block_checksum ? ULZ4_CHECKSUM : ULZ4_BLOCK_SIZE;
+		st->need = sizeof(u32);
+		break;
+	}
+
+	return 0;
+}
+
+int ulz4_stream_add(struct ulz4_stream *st, const void *data, size_t len)
+{
+	const u8 *in = data;
+	size_t take, need;
+	u8 *stage;
+	int ret;
+
+	while (len && st->state != ULZ4_DONE) {
+		/* use the input directly where the whole item is there */
+		if (!st->have && len >= st->need) {
+			need = st->need;
+			ret = ulz4_stream_item(st, in);
+			in += need;
+			len -= need;
+		} else {
+			stage = st->hdr;
+			if (st->state == ULZ4_BLOCK) {
+				if (!st->buf) {
+					st->buf = malloc(st->max_block);
+					if (!st->buf)
+						return -ENOMEM;
+				}
+				stage = st->buf;
+			}
+			take = min(st->need - st->have, len);
+			memcpy(stage + st->have, in, take);
+			st->have += take;
+			in += take;
+			len -= take;
+			if (st->have < st->need)
+				break;
+			st->have = 0;
+			ret = ulz4_stream_item(st, stage);
+		}
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int ulz4_stream_finish(struct ulz4_stream *st, size_t *dstn)
+{
+	free(st->buf);
+	st->buf = NULL;
+	if (st->state != ULZ4_DONE)
+		return -EINVAL;
+	*dstn = st->out - st->start;
+
+	return 0;
+}
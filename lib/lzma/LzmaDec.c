@@ -6,6 +6,7 @@
 #include "LzmaDec.h"
 
 #include <linux/string.h>
+#include <asm/unaligned.h>
 
 #define kNumTopBits 24
 #define kTopValue ((UInt32)1 << kNumTopBits)
@@ -400,9 +401,21 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
           const Byte *lim = dest + curLen;
           dicPos += curLen;
 
-          do
-            *(dest) = (Byte)*(dest + src);
-          while (++dest != lim);
+          /*
+           * Copy a word at a time where the source does not overlap it,
+           * since matches are often long. A distance of one is a run of
+           * the same byte.
+           */
+          if (src == -1)
+            memset(dest, dest[-1], curLen);
+          else
+          {
+            if (src <= -(ptrdiff_t)sizeof(ulong))
+              for (; lim - dest >= (ptrdiff_t)sizeof(ulong); dest += sizeof(ulong))
+                put_unaligned(get_unaligned((ulong *)(dest + src)), (ulong *)dest);
+            for (; dest != lim; dest++)
+              *(dest) = (Byte)*(dest + src);
+          }
         }
         else
         {
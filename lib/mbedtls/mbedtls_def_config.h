@@ -38,6 +38,9 @@
 #if CONFIG_IS_ENABLED(SHA256_SMALLER)
 #define MBEDTLS_SHA256_SMALLER
 #endif
+#if defined CONFIG_MBEDTLS_LIB_ARMV8_CE && CONFIG_IS_ENABLED(ARMV8_CE_SHA256)
+#define MBEDTLS_SHA256_PROCESS_ALT
+#endif
 #endif
 
 #if CONFIG_IS_ENABLED(SHA384)
@@ -109,6 +112,15 @@
 #define MBEDTLS_SSL_SERVER_NAME_INDICATION
 #define MBEDTLS_KEY_EXCHANGE_PSK_ENABLED
 
+#if defined CONFIG_MBEDTLS_LIB_TLS_SESSION_TICKETS
+#define MBEDTLS_SSL_SESSION_TICKETS
+#endif
+
+#if defined CONFIG_MBEDTLS_LIB_ARMV8_CE && CONFIG_IS_ENABLED(ARMV8_CE_AES)
+#define MBEDTLS_AES_ENCRYPT_ALT
+#define MBEDTLS_AES_DECRYPT_ALT
+#endif
+
 /* RSA */
 #define MBEDTLS_KEY_EXCHANGE_RSA_ENABLED
 #define MBEDTLS_KEY_EXCHANGE_ECDHE_RSA_ENABLED
@@ -21,8 +21,54 @@
 
 enum {
 	BUF_STEP	= SZ_64K,
+	NAME_CACHE_SIZE	= 64,
 };
 
+/**
+ * struct unflatten_names - property names seen while unflattening
+ *
+ * Property names point into the strings block of the FDT, where each name
+ * is normally stored once. Caching the hash by name pointer avoids hashing
+ * the same few names again for every node.
+ *
+ * @name: Cached name pointers, indexed by a hash of the pointer
+ * @hash: of_prop_hash() of each entry in @name
+ * @name_hash: Hash of "name"
+ * @phandle_hash: Hash of "phandle"
+ * @linux_phandle_hash: Hash of "linux,phandle"
+ * @ibm_phandle_hash: Hash of "ibm,phandle"
+ */
+struct unflatten_names {
+	const char *name[NAME_CACHE_SIZE];
+	u32 hash[NAME_CACHE_SIZE];
+	u32 name_hash;
+	u32 phandle_hash;
+	u32 linux_phandle_hash;
+	u32 ibm_phandle_hash;
+};
+
+static void unflatten_names_init(struct unflatten_names *names)
+{
+	memset(names, '\0', sizeof(*names));
+	names->name_hash = of_prop_hash("name");
+	names->phandle_hash = of_prop_hash("phandle");
+	names->linux_phandle_hash = of_prop_hash("linux,phandle");
+	names->ibm_phandle_hash = of_prop_hash("ibm,phandle");
+}
+
+static u32 unflatten_name_hash(struct unflatten_names *names,
+			       const char *pname)
+{
+	uint slot = ((ulong)pname >> 2) % NAME_CACHE_SIZE;
+
+	if (names->name[slot] != pname) {
+		names->name[slot] = pname;
+		names->hash[slot] = of_prop_hash(pname);
+	}
+
+	return names->hash[slot];
+}
+
 static void *unflatten_dt_alloc(void **mem, unsigned long size,
 				unsigned long align)
 {
@@ -43,13 +89,15 @@ static void *unflatten_dt_alloc(void **mem, unsigned long size,
  * @dad: Parent struct device_node
  * @nodepp: The device_node tree created by the call
  * @fpsize: Size of the node path up at t05he current depth.
+ * @names: Cache of property-name hashes
  * @dryrun: If true, do not allocate device nodes but still calculate needed
  * memory size
  */
 static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 			       struct device_node *dad,
 			       struct device_node **nodepp,
-			       unsigned long fpsize, bool dryrun)
+			       unsigned long fpsize,
+			       struct unflatten_names *names, bool dryrun)
 {
 	const __be32 *p;
 	struct device_node *np;
@@ -138,6 +186,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 	     (offset >= 0);
 	     (offset = fdt_next_property_offset(blob, offset))) {
 		const char *pname;
+		u32 hash;
 		int sz;
 
 		p = fdt_getprop_by_offset(blob, offset, &pname, &sz);
@@ -150,7 +199,8 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 			debug("Can't find property name in list !\n");
 			break;
 		}
-		if (strcmp(pname, "name") == 0)
+		hash = unflatten_name_hash(names, pname);
+		if (hash == names->name_hash && strcmp(pname, "name") == 0)
 			has_name = 1;
 		pp = unflatten_dt_alloc(&mem, sizeof(struct property),
 					__alignof__(struct property));
@@ -161,8 +211,10 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 			 * legacy "linux,phandle" properties.  If both
 			 * appear and have different values, things
 			 * will get weird.  Don't do that. */
-			if ((strcmp(pname, "phandle") == 0) ||
-			    (strcmp(pname, "linux,phandle") == 0)) {
+			if ((hash == names->phandle_hash &&
+			     strcmp(pname, "phandle") == 0) ||
+			    (hash == names->linux_phandle_hash &&
+			     strcmp(pname, "linux,phandle") == 0)) {
 				if (np->phandle == 0)
 					np->phandle = be32_to_cpup(p);
 			}
@@ -170,10 +222,12 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 			 * And we process the "ibm,phandle" property
 			 * used in pSeries dynamic device tree
 			 * stuff */
-			if (strcmp(pname, "ibm,phandle") == 0)
+			if (hash == names->ibm_phandle_hash &&
+			    strcmp(pname, "ibm,phandle") == 0)
 				np->phandle = be32_to_cpup(p);
 			pp->name = (char *)pname;
 			pp->length = sz;
+			pp->hash = hash;
 			pp->value = (__be32 *)p;
 			*prev_pp = pp;
 			prev_pp = &pp->next;
@@ -202,6 +256,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 		if (!dryrun) {
 			pp->name = "name";
 			pp->length = sz;
+			pp->hash = names->name_hash;
 			pp->value = pp + 1;
 			*prev_pp = pp;
 			prev_pp = &pp->next;
@@ -228,7 +283,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 		depth = 0;
 	while (*poffset > 0 && depth > old_depth) {
 		mem = unflatten_dt_node(blob, mem, poffset, np, NULL,
-					fpsize, dryrun);
+					fpsize, names, dryrun);
 		if (!mem)
 			return NULL;
 	}
@@ -262,6 +317,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 
 int unflatten_device_tree(const void *blob, struct device_node **mynodes)
 {
+	struct unflatten_names names;
 	unsigned long size;
 	int start;
 	void *mem;
@@ -283,10 +339,12 @@ int unflatten_device_tree(const void *blob, struct device_node **mynodes)
 		return -EINVAL;
 	}
 
+	unflatten_names_init(&names);
+
 	/* First pass, scan for size */
 	start = 0;
 	size = (unsigned long)unflatten_dt_node(blob, NULL, &start, NULL, NULL,
-						0, true);
+						0, &names, true);
 	if (!size)
 		return -EFAULT;
 	size = ALIGN(size, 4);
@@ -295,6 +353,8 @@ int unflatten_device_tree(const void *blob, struct device_node **mynodes)
 
 	/* Allocate memory for the expanded device tree */
 	mem = memalign(__alignof__(struct device_node), size + 4);
+	if (!mem)
+		return -ENOMEM;
 	memset(mem, '\0', size);
 
 	/* Set up value for dm_test_livetree_align() */
@@ -306,7 +366,7 @@ int unflatten_device_tree(const void *blob, struct device_node **mynodes)
 
 	/* Second pass, do actual unflattening */
 	start = 0;
-	unflatten_dt_node(blob, mem, &start, NULL, mynodes, 0, false);
+	unflatten_dt_node(blob, mem, &start, NULL, mynodes, 0, &names, false);
 	if (be32_to_cpup(mem + size) != 0xdeadbeef) {
 		debug("End of tree marker overwritten: %08x\n",
 		      be32_to_cpup(mem + size));
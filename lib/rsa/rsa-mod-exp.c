@@ -246,6 +246,186 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 	return 0;
 }
 
+/*
+ * Where the compiler has a 128-bit type, use 64-bit words, which quarters the
+ * number of multiplies. This relies on the words being stored least
+ * significant first, as for the 32-bit words.
+ */
+#if !defined(USE_HOSTCC) && defined(__SIZEOF_INT128__) && \
+	__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define RSA_MOD_EXP_64
+
+/**
+ * struct rsa_key64 - RSA public key in 64-bit words
+ *
+ * @len:	Length of modulus in 64-bit words
+ * @n0inv:	-1 / modulus[0] mod 2^64
+ * @modulus:	Modulus as little endian array
+ * @rr:		R^2 as little endian array
+ * @exponent:	Public exponent
+ */
+struct rsa_key64 {
+	uint len;
+	uint64_t n0inv;
+	uint64_t *modulus;
+	uint64_t *rr;
+	uint64_t exponent;
+};
+
+static void subtract_modulus64(const struct rsa_key64 *key, uint64_t num[])
+{
+	uint64_t borrow = 0;
+	uint i;
+
+	for (i = 0; i < key->len; i++) {
+		unsigned __int128 acc;
+
+		acc = (unsigned __int128)num[i] - key->modulus[i] - borrow;
+		num[i] = (uint64_t)acc;
+		borrow = (uint64_t)(acc >> 64) & 1;
+	}
+}
+
+static int greater_equal_modulus64(const struct rsa_key64 *key,
+				   uint64_t num[])
+{
+	int i;
+
+	for (i = (int)key->len - 1; i >= 0; i--) {
+		if (num[i] < key->modulus[i])
+			return 0;
+		if (num[i] > key->modulus[i])
+			return 1;
+	}
+
+	return 1;  /* equal */
+}
+
+/**
+ * montgomery_mul64() - Perform montgomery multiply with 64-bit words
+ *
+ * Operation: montgomery result[] = a[] * b[] / R % modulus, as for
+ * montgomery_mul()
+ *
+ * @key:	RSA key
+ * @result:	Place to put result, as little endian word array
+ * @a:		Multiplier, as little endian word array
+ * @b:		Multiplicand, as little endian word array
+ */
+static void montgomery_mul64(const struct rsa_key64 *key, uint64_t result[],
+			     const uint64_t a[], const uint64_t b[])
+{
+	unsigned __int128 acc_a, acc_b;
+	uint64_t d0;
+	uint i, j;
+
+	for (i = 0; i < key->len; i++)
+		result[i] = 0;
+	for (i = 0; i < key->len; i++) {
+		acc_a = (unsigned __int128)a[i] * b[0] + result[0];
+		d0 = (uint64_t)acc_a * key->n0inv;
+		acc_b = (unsigned __int128)d0 * key->modulus[0] +
+			(uint64_t)acc_a;
+		for (j = 1; j < key->len; j++) {
+			acc_a = (acc_a >> 64) +
+				(unsigned __int128)a[i] * b[j] + result[j];
+			acc_b = (acc_b >> 64) +
+				(unsigned __int128)d0 * key->modulus[j] +
+				(uint64_t)acc_a;
+			result[j - 1] = (uint64_t)acc_b;
+		}
+		acc_a = (acc_a >> 64) + (acc_b >> 64);
+		result[j - 1] = (uint64_t)acc_a;
+
+		if (acc_a >> 64)
+			subtract_modulus64(key, result);
+	}
+}
+
+/* Convert a big endian byte array to little endian 64-bit words */
+static void rsa_convert_be64(uint64_t *dst, const void *src, uint len)
+{
+	uint i;
+
+	for (i = 0; i < len; i++)
+		dst[i] = fdt64_to_cpup(src + (len - 1 - i) * sizeof(*dst));
+}
+
+/**
+ * pow_mod64() - in-place public exponentiation with 64-bit words
+ *
+ * This follows pow_mod(). The exponent has already been checked.
+ *
+ * @key:	RSA key
+ * @inout:	Big-endian byte array containing value and result
+ * @k:		Number of bits in the exponent
+ */
+static void pow_mod64(const struct rsa_key64 *key, void *inout, int k)
+{
+	uint64_t val[key->len], acc[key->len], tmp[key->len];
+	uint64_t a_scaled[key->len];
+	uint i;
+	int j;
+
+	rsa_convert_be64(val, inout, key->len);
+
+	montgomery_mul64(key, acc, val, key->rr);
+	memcpy(a_scaled, acc, key->len * sizeof(a_scaled[0]));
+
+	for (j = k - 2; j > 0; --j) {
+		montgomery_mul64(key, tmp, acc, acc);
+		if (key->exponent & (1ULL << j))
+			montgomery_mul64(key, acc, tmp, a_scaled);
+		else
+			memcpy(acc, tmp, key->len * sizeof(acc[0]));
+	}
+
+	montgomery_mul64(key, tmp, acc, acc);
+	montgomery_mul64(key, acc, tmp, val);
+
+	if (greater_equal_modulus64(key, acc))
+		subtract_modulus64(key, acc);
+
+	for (i = 0; i < key->len; i++) {
+		fdt64_t w = cpu_to_fdt64(acc[key->len - 1 - i]);
+
+		memcpy(inout + i * sizeof(w), &w, sizeof(w));
+	}
+}
+
+static int rsa_mod_exp64(const struct rsa_public_key *key32,
+			 struct key_prop *prop, uint64_t *buf)
+{
+	struct rsa_key64 key;
+	uint64_t x;
+	int k;
+
+	if (num_public_exponent_bits(key32, &k) || k < 2 ||
+	    !is_public_exponent_bit_set(key32, 0)) {
+		debug("Invalid RSA public exponent\n");
+		return -EINVAL;
+	}
+
+	key.len = key32->len / 2;
+	key.exponent = key32->exponent;
+
+	/* Extend -1 / n mod 2^32 to 2^64 with a Newton step */
+	x = -(uint64_t)prop->n0inv & 0xffffffff;
+	x *= 2 - fdt64_to_cpup(prop->modulus + (key.len - 1) * 8) * x;
+	key.n0inv = -x;
+
+	uint64_t mod[key.len], rr[key.len];
+
+	key.modulus = mod;
+	key.rr = rr;
+	rsa_convert_be64(mod, prop->modulus, key.len);
+	rsa_convert_be64(rr, prop->rr, key.len);
+	pow_mod64(&key, buf, k);
+
+	return 0;
+}
+#endif
+
 static void rsa_convert_big_endian(uint32_t *dst, const uint32_t *src, int len)
 {
 	int i;
@@ -284,6 +464,21 @@ int rsa_mod_exp_sw(const uint8_t *sig, uint32_t sig_len,
 		return -EFAULT;
 	}
 	key.len /= sizeof(uint32_t) * 8;
+
+#ifdef RSA_MOD_EXP_64
+	if (!(key.len & 1) && sig_len == key.len * sizeof(uint32_t)) {
+		uint64_t buf64[key.len / 2];
+
+		memcpy(buf64, sig, sig_len);
+		ret = rsa_mod_exp64(&key, prop, buf64);
+		if (ret)
+			return ret;
+		memcpy(out, buf64, sig_len);
+
+		return 0;
+	}
+#endif
+
 	uint32_t key1[key.len], key2[key.len];
 
 	key.modulus = key1;
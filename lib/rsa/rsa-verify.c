@@ -11,6 +11,7 @@
 #include <asm/byteorder.h>
 #include <linux/errno.h>
 #include <asm/types.h>
+#include <asm/global_data.h>
 #include <asm/unaligned.h>
 #include <dm.h>
 #else
@@ -22,6 +23,10 @@
 #include <u-boot/rsa-mod-exp.h>
 #include <u-boot/rsa.h>
 
+#ifndef USE_HOSTCC
+DECLARE_GLOBAL_DATA_PTR;
+#endif
+
 /* Default public exponent for backward compatibility */
 #define RSA_DEFAULT_PUBEXP	65537
 
@@ -393,6 +398,80 @@ static int rsa_verify_key(struct image_sign_info *info,
  *
  * Return	0 if verified, -ve on error
  */
+#ifndef USE_HOSTCC
+/*
+ * Key properties generated for the last public key, which is often used to
+ * check several signatures in a row, e.g. a chain of signed images
+ */
+static struct {
+	void *key;
+	uint32_t keylen;
+	struct key_prop *prop;
+} rsa_pkey_cache;
+
+/**
+ * rsa_gen_key_prop_cached() - Get the key properties of a public key
+ *
+ * This is rsa_gen_key_prop(), reusing the result of the previous call if it
+ * was for the same key. The cache needs the BSS and full malloc(), so it is
+ * not used before relocation.
+ *
+ * @key:	Specifies key data in DER format
+ * @keylen:	Length of @key
+ * @propp:	Returns key properties, which must be freed with
+ *		rsa_put_key_prop()
+ * Return: 0 if OK, -ve on error
+ */
+static int rsa_gen_key_prop_cached(const void *key, uint32_t keylen,
+				   struct key_prop **propp)
+{
+	int ret;
+
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return rsa_gen_key_prop(key, keylen, propp);
+
+	if (rsa_pkey_cache.prop && rsa_pkey_cache.keylen == keylen &&
+	    !memcmp(rsa_pkey_cache.key, key, keylen)) {
+		*propp = rsa_pkey_cache.prop;
+		return 0;
+	}
+
+	ret = rsa_gen_key_prop(key, keylen, propp);
+	if (ret)
+		return ret;
+
+	free(rsa_pkey_cache.key);
+	if (rsa_pkey_cache.prop)
+		rsa_free_key_prop(rsa_pkey_cache.prop);
+	rsa_pkey_cache.prop = NULL;
+	rsa_pkey_cache.key = malloc(keylen);
+	if (rsa_pkey_cache.key) {
+		memcpy(rsa_pkey_cache.key, key, keylen);
+		rsa_pkey_cache.keylen = keylen;
+		rsa_pkey_cache.prop = *propp;
+	}
+
+	return 0;
+}
+
+static void rsa_put_key_prop(struct key_prop *prop)
+{
+	if (prop != rsa_pkey_cache.prop)
+		rsa_free_key_prop(prop);
+}
+#else
+static int rsa_gen_key_prop_cached(const void *key, uint32_t keylen,
+				   struct key_prop **propp)
+{
+	return rsa_gen_key_prop(key, keylen, propp);
+}
+
+static void rsa_put_key_prop(struct key_prop *prop)
+{
+	rsa_free_key_prop(prop);
+}
+#endif
+
 int rsa_verify_with_pkey(struct image_sign_info *info,
 			 const void *hash, uint8_t *sig, uint sig_len)
 {
@@ -403,7 +482,7 @@ int rsa_verify_with_pkey(struct image_sign_info *info,
 		return -EACCES;
 
 	/* Public key is self-described to fill key_prop */
-	ret = rsa_gen_key_prop(info->key, info->keylen, &prop);
+	ret = rsa_gen_key_prop_cached(info->key, info->keylen, &prop);
 	if (ret) {
 		debug("Generating necessary parameter for decoding failed\n");
 		return ret;
@@ -412,7 +491,7 @@ int rsa_verify_with_pkey(struct image_sign_info *info,
 	ret = rsa_verify_key(info, prop, sig, sig_len, hash,
 			     info->crypto->key_len);
 
-	rsa_free_key_prop(prop);
+	rsa_put_key_prop(prop);
 
 	return ret;
 }
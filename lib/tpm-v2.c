@@ -310,6 +310,28 @@ u32 tpm2_nv_define_space(struct udevice *dev, u32 space_index,
 	return tpm_sendrecv_command(dev, command_v2, NULL, NULL);
 }
 
+/* Make sure the active banks can be extended, asking the TPM only once */
+static int tpm2_pcr_extend_check(struct udevice *dev)
+{
+	struct tpm_chip_priv *priv = dev_get_uclass_priv(dev);
+	int ret;
+
+	if (priv->banks_checked)
+		return 0;
+
+	if (!tpm2_check_active_banks(dev)) {
+		log_err("Cannot extend PCRs if all the TPM enabled algorithms are not supported\n");
+
+		ret = tpm2_pcr_allocate(dev, 0);
+		if (ret)
+			return -EINVAL;
+		return 0;
+	}
+	priv->banks_checked = true;
+
+	return 0;
+}
+
 u32 tpm2_pcr_extend(struct udevice *dev, u32 index, u32 algorithm,
 		    const u8 *digest, u32 digest_len)
 {
@@ -342,13 +364,9 @@ u32 tpm2_pcr_extend(struct udevice *dev, u32 index, u32 algorithm,
 	if (!digest)
 		return -EINVAL;
 
-	if (!tpm2_check_active_banks(dev)) {
-		log_err("Cannot extend PCRs if all the TPM enabled algorithms are not supported\n");
-
-		ret = tpm2_pcr_allocate(dev, 0);
-		if (ret)
-			return -EINVAL;
-	}
+	ret = tpm2_pcr_extend_check(dev);
+	if (ret)
+		return ret;
 	/*
 	 * Fill the command structure starting from the first buffer:
 	 *     - the digest
@@ -361,6 +379,58 @@ u32 tpm2_pcr_extend(struct udevice *dev, u32 index, u32 algorithm,
 	return tpm_sendrecv_command(dev, command_v2, NULL, NULL);
 }
 
+u32 tpm2_pcr_extend_digests(struct udevice *dev, u32 index,
+			    const struct tpml_digest_values *digest_list)
+{
+	/* Length of the message header, up to the first digest */
+	uint offset = 31;
+	u8 command_v2[COMMAND_BUFFER_SIZE] = {
+		tpm_u16(TPM2_ST_SESSIONS),	/* TAG */
+		tpm_u32(0),			/* Length, filled in below */
+		tpm_u32(TPM2_CC_PCR_EXTEND),	/* Command code */
+
+		/* HANDLE */
+		tpm_u32(index),			/* Handle (PCR Index) */
+
+		/* AUTH_SESSION */
+		tpm_u32(9),			/* Authorization size */
+		tpm_u32(TPM2_RS_PW),		/* Session handle */
+		tpm_u16(0),			/* Size of <nonce> */
+						/* <nonce> (if any) */
+		0,				/* Attributes: Cont/Excl/Rst */
+		tpm_u16(0),			/* Size of <hmac/password> */
+						/* <hmac/password> (if any) */
+
+		/* hashes */
+		tpm_u32(digest_list->count),	/* Count (number of hashes) */
+		/* TPMT_HA		   Algorithm and digest, for each */
+	};
+	u32 i;
+	int ret;
+
+	ret = tpm2_pcr_extend_check(dev);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < digest_list->count; i++) {
+		u16 alg = digest_list->digests[i].hash_alg;
+		u32 len = tpm2_algorithm_to_len(alg);
+
+		if (!len)
+			return -EINVAL;
+		if (pack_byte_string(command_v2, sizeof(command_v2), "ws",
+				     offset, alg, offset + sizeof(u16),
+				     (u8 *)&digest_list->digests[i].digest,
+				     len))
+			return TPM_LIB_ERROR;
+		offset += sizeof(u16) + len;
+	}
+	if (pack_byte_string(command_v2, sizeof(command_v2), "d", 2, offset))
+		return TPM_LIB_ERROR;
+
+	return tpm_sendrecv_command(dev, command_v2, NULL, NULL);
+}
+
 u32 tpm2_nv_read_value(struct udevice *dev, u32 index, void *data, u32 count)
 {
 	u8 command_v2[COMMAND_BUFFER_SIZE] = {
@@ -594,11 +664,15 @@ u32 tpm2_send_pcr_allocate(struct udevice *dev, const char *pw,
 
 		/* TPML_PCR_SELECTION */
 	};
+	struct tpm_chip_priv *priv = dev_get_uclass_priv(dev);
 	u8 response[COMMAND_BUFFER_SIZE];
 	size_t response_len = COMMAND_BUFFER_SIZE;
 	u32 i;
 	int ret;
 
+	/* the banks must be checked again before the next extend */
+	priv->banks_checked = false;
+
 	/*
 	 * Fill the command structure starting from the first buffer:
 	 * the password (if any)
@@ -13,6 +13,31 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+enum {
+	/* Deeper frames are charged to the frame at this depth */
+	TRACE_SAMPLE_DEPTH	= 64,
+
+	/* Number of function hooks between reads of the timer */
+	TRACE_SAMPLE_CHECK	= 16,
+
+	TRACE_SAMPLE_ROOT	= 0,
+};
+
+/**
+ * struct trace_sample - a node in the tree of sampled call stacks
+ *
+ * @func: Function number (see func_ptr_to_num()), unused for the root
+ * @parent: Index of the parent node
+ * @count: Number of samples taken with exactly this call stack
+ * @time_us: Total time charged to those samples, in microseconds
+ */
+struct trace_sample {
+	u32 func;
+	u32 parent;
+	u32 count;
+	u32 time_us;
+};
+
 static char trace_enabled __section(".data");
 static char trace_inited __section(".data");
 
@@ -40,6 +65,18 @@ struct trace_hdr {
 	int max_depth;		/* Maximum depth seen so far */
 	int min_depth;		/* Minimum depth seen so far */
 	bool trace_locked;	/* Used to detect recursive tracing */
+
+	/* Call-stack sampling, with CONFIG_TRACE_SAMPLE */
+	u32 sample_stack[TRACE_SAMPLE_DEPTH];	/* Function numbers */
+	int sample_depth;	/* Depth of calls since tracing started */
+	int sample_countdown;	/* Hooks left until the timer is checked */
+	ulong sample_last_us;	/* Time of the last sample */
+	struct trace_sample *samples;	/* Tree nodes, the root first */
+	u32 *sample_hash;	/* Node index for each (parent, function) */
+	ulong sample_size;	/* Num. of nodes we have space for */
+	ulong sample_nodes;	/* Num. of nodes used */
+	ulong sample_count;	/* Num. of samples taken */
+	ulong sample_dropped;	/* Samples lost as the tree was full */
 };
 
 /* Pointer to start of trace buffer */
@@ -120,6 +157,71 @@ static void notrace add_ftrace(void *func_ptr, void *caller, ulong flags)
 	hdr->ftrace_count++;
 }
 
+/**
+ * trace_sample_child() - find or add the node for a call
+ *
+ * @parent: Index of the node of the calling stack
+ * @func: Function number of the call
+ * Return: index of the node, or -1 if the tree is full
+ */
+static int notrace trace_sample_child(u32 parent, u32 func)
+{
+	ulong mask = hdr->sample_size * 2 - 1;
+	ulong pos = ((parent * 0x9e3779b1U) ^ func) * 0x85ebca6bU;
+	struct trace_sample *node;
+	u32 idx;
+
+	for (pos &= mask; (idx = hdr->sample_hash[pos]); pos = (pos + 1) & mask) {
+		node = &hdr->samples[idx];
+		if (node->parent == parent && node->func == func)
+			return idx;
+	}
+	if (hdr->sample_nodes == hdr->sample_size)
+		return -1;
+
+	idx = hdr->sample_nodes++;
+	node = &hdr->samples[idx];
+	node->func = func;
+	node->parent = parent;
+	node->count = 0;
+	node->time_us = 0;
+	hdr->sample_hash[pos] = idx;
+
+	return idx;
+}
+
+/**
+ * trace_sample() - add the current call stack to the tree, if it is time
+ *
+ * The time since the last sample is charged to the current call stack.
+ */
+static void notrace trace_sample(void)
+{
+	ulong now, elapsed;
+	int i, depth, node;
+
+	if (--hdr->sample_countdown > 0)
+		return;
+	hdr->sample_countdown = TRACE_SAMPLE_CHECK;
+	now = timer_get_us();
+	elapsed = now - hdr->sample_last_us;
+	if (elapsed < CONFIG_TRACE_SAMPLE_PERIOD_US)
+		return;
+	hdr->sample_last_us = now;
+
+	depth = min(hdr->sample_depth, (int)TRACE_SAMPLE_DEPTH);
+	for (i = 0, node = TRACE_SAMPLE_ROOT; i < depth; i++) {
+		node = trace_sample_child(node, hdr->sample_stack[i]);
+		if (node < 0) {
+			hdr->sample_dropped++;
+			return;
+		}
+	}
+	hdr->samples[node].count++;
+	hdr->samples[node].time_us += elapsed;
+	hdr->sample_count++;
+}
+
 /**
  * __cyg_profile_func_enter() - record function entry
  *
@@ -143,8 +245,16 @@ void notrace __cyg_profile_func_enter(void *func_ptr, void *caller)
 
 		hdr->trace_locked = true;
 		trace_swap_gd();
-		add_ftrace(func_ptr, caller, FUNCF_ENTRY);
 		func = func_ptr_to_num(func_ptr);
+		if (IS_ENABLED(CONFIG_TRACE_SAMPLE)) {
+			/* the time so far was spent in the caller */
+			trace_sample();
+			if (hdr->sample_depth < TRACE_SAMPLE_DEPTH)
+				hdr->sample_stack[hdr->sample_depth] = func;
+			hdr->sample_depth++;
+		} else {
+			add_ftrace(func_ptr, caller, FUNCF_ENTRY);
+		}
 		if (func < hdr->func_count) {
 			hdr->call_accum[func]++;
 			hdr->call_count++;
@@ -170,7 +280,14 @@ void notrace __cyg_profile_func_exit(void *func_ptr, void *caller)
 	if (trace_enabled) {
 		trace_swap_gd();
 		hdr->depth--;
-		add_ftrace(func_ptr, caller, FUNCF_EXIT);
+		if (IS_ENABLED(CONFIG_TRACE_SAMPLE)) {
+			/* Charge the time so far to the function returning */
+			trace_sample();
+			if (hdr->sample_depth)
+				hdr->sample_depth--;
+		} else {
+			add_ftrace(func_ptr, caller, FUNCF_EXIT);
+		}
 		if (hdr->depth < hdr->min_depth)
 			hdr->min_depth = hdr->depth;
 		trace_swap_gd();
@@ -294,6 +411,58 @@ int trace_list_calls(void *buff, size_t buff_size, size_t *needed)
 	return 0;
 }
 
+int trace_list_samples(void *buff, size_t buff_size, size_t *needed)
+{
+	struct trace_output_hdr *output_hdr = NULL;
+	void *end, *ptr = buff;
+	size_t rec, upto;
+
+	if (!IS_ENABLED(CONFIG_TRACE_SAMPLE) || !trace_inited)
+		return -ENOSYS;
+	end = buff ? buff + buff_size : NULL;
+
+	/* Place some header information */
+	if (ptr + sizeof(struct trace_output_hdr) < end)
+		output_hdr = ptr;
+	ptr += sizeof(struct trace_output_hdr);
+
+	/* Nodes are only added after their parents, so keep the order */
+	for (rec = upto = 0; rec < hdr->sample_nodes; rec++) {
+		if (ptr + sizeof(struct trace_output_sample) < end) {
+			struct trace_sample *node = &hdr->samples[rec];
+			struct trace_output_sample *out = ptr;
+
+			if (rec == TRACE_SAMPLE_ROOT) {
+				out->func = ~0U;
+				out->parent = ~0U;
+			} else {
+				out->func = node->func * FUNC_SITE_SIZE;
+				out->parent = node->parent;
+			}
+			out->count = node->count;
+			out->time_us = node->time_us;
+			upto++;
+		}
+		ptr += sizeof(struct trace_output_sample);
+	}
+
+	/* Update the header */
+	if (output_hdr) {
+		memset(output_hdr, '\0', sizeof(*output_hdr));
+		output_hdr->rec_count = upto;
+		output_hdr->type = TRACE_CHUNK_SAMPLES;
+		output_hdr->version = TRACE_VERSION;
+		output_hdr->text_base = CONFIG_TEXT_BASE;
+	}
+
+	/* Work out how must of the buffer we used */
+	*needed = ptr - buff;
+	if (ptr > end)
+		return -ENOSPC;
+
+	return 0;
+}
+
 /**
  * trace_print_stats() - print basic information about tracing
  */
@@ -315,6 +484,22 @@ void trace_print_stats(void)
 	puts(" function calls\n");
 	print_grouped_ull(hdr->untracked_count, 10);
 	puts(" untracked function calls\n");
+	if (IS_ENABLED(CONFIG_TRACE_SAMPLE)) {
+		print_grouped_ull(hdr->sample_count, 10);
+		printf(" samples every %d us", CONFIG_TRACE_SAMPLE_PERIOD_US);
+		if (hdr->sample_dropped)
+			printf(" (%lu dropped as the tree was full)",
+			       hdr->sample_dropped);
+		puts("\n");
+		print_grouped_ull(hdr->sample_nodes, 10);
+		puts(" call stacks\n");
+		print_grouped_ull(hdr->sample_size, 10);
+		puts(" max call stacks\n");
+		printf("\ntrace buffer %lx sample tree %lx\n",
+		       (ulong)map_to_sysmem(hdr),
+		       (ulong)map_to_sysmem(hdr->samples));
+		return;
+	}
 	count = min(hdr->ftrace_count, hdr->ftrace_size);
 	print_grouped_ull(count, 10);
 	puts(" traced function calls");
@@ -351,6 +536,35 @@ static int get_func_count(void)
 	return gd->mon_len / FUNC_SITE_SIZE;
 }
 
+/**
+ * trace_sample_init() - set up the tree of sampled call stacks
+ *
+ * The space is split between the nodes and a hash table of twice as many
+ * entries, a power of two, so that lookups stay short.
+ *
+ * @buff: Space to use
+ * @size: Size of @buff in bytes
+ */
+static void notrace trace_sample_init(void *buff, size_t size)
+{
+	const size_t per_node = sizeof(struct trace_sample) + 2 * sizeof(u32);
+	ulong nodes = 1;
+
+	while (nodes * 2 * per_node <= size)
+		nodes *= 2;
+	hdr->samples = buff;
+	hdr->sample_size = nodes;
+	hdr->sample_hash = (u32 *)(hdr->samples + nodes);
+	memset(hdr->sample_hash, '\0', nodes * 2 * sizeof(u32));
+	memset(hdr->samples, '\0', sizeof(*hdr->samples));
+	hdr->sample_nodes = 1;
+	hdr->sample_count = 0;
+	hdr->sample_dropped = 0;
+	hdr->sample_depth = 0;
+	hdr->sample_countdown = TRACE_SAMPLE_CHECK;
+	hdr->sample_last_us = timer_get_us();
+}
+
 static int notrace trace_init_(void *buff, size_t buff_size, bool copy_early,
 			       bool enable)
 {
@@ -409,6 +623,8 @@ static int notrace trace_init_(void *buff, size_t buff_size, bool copy_early,
 	hdr->ftrace = (struct trace_call *)(buff + needed);
 	hdr->ftrace_size = (buff_size - needed) / sizeof(*hdr->ftrace);
 	hdr->depth_limit = CONFIG_TRACE_CALL_DEPTH_LIMIT;
+	if (IS_ENABLED(CONFIG_TRACE_SAMPLE))
+		trace_sample_init(buff + needed, buff_size - needed);
 
 	printf("trace: initialized, %senabled\n", enable ? "" : "not ");
 	trace_enabled = enable;
@@ -8,6 +8,28 @@
  * - xxHash source repository: https://github.com/Cyan4973/xxHash
  */
 
+#ifdef USE_HOSTCC
+#include <compiler.h>
+#include <linux/xxhash.h>
+
+#define EXPORT_SYMBOL(sym)
+
+static inline uint32_t get_unaligned_le32(const void *p)
+{
+	uint32_t val;
+
+	memcpy(&val, p, sizeof(val));
+	return le32_to_cpu(val);
+}
+
+static inline uint64_t get_unaligned_le64(const void *p)
+{
+	uint64_t val;
+
+	memcpy(&val, p, sizeof(val));
+	return le64_to_cpu(val);
+}
+#else
 #include <asm/unaligned.h>
 #include <linux/errno.h>
 #include <linux/compiler.h>
@@ -15,6 +37,8 @@
 #include <linux/compat.h>
 #include <linux/string.h>
 #include <linux/xxhash.h>
+#include <u-boot/schedule.h>
+#endif
 
 /*-*************************************
  * Macros
@@ -465,3 +489,26 @@ uint64_t xxh64_digest(const struct xxh64_state *state)
 	return h64;
 }
 EXPORT_SYMBOL(xxh64_digest);
+
+void xxh64_wd_buf(const uint8_t *input, unsigned int ilen, uint8_t *output,
+		  unsigned int chunk_sz)
+{
+	struct xxh64_state state;
+	unsigned int chunk;
+	uint64_t hash;
+
+	xxh64_reset(&state, 0);
+	while (ilen) {
+		chunk = ilen < chunk_sz ? ilen : chunk_sz;
+		xxh64_update(&state, input, chunk);
+		input += chunk;
+		ilen -= chunk;
+#ifndef USE_HOSTCC
+		schedule();
+#endif
+	}
+
+	/* the canonical form of the hash is big-endian */
+	hash = cpu_to_be64(xxh64_digest(&state));
+	memcpy(output, &hash, sizeof(hash));
+}
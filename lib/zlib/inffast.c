@@ -12,6 +12,28 @@
 
 #ifndef ASMINF
 
+/*
+   U-Boot: with a 64-bit bit buffer, top it up to at least 56 bits with one
+   little-endian load at the start of each code, which is enough for a whole
+   length/distance pair, so the refills for the later parts of the pair are
+   never needed. Bits above 'bits' in 'hold' are then left over from the
+   load, but the next load puts the same bytes in the same place.
+ */
+#define FAST_REFILL() \
+    do { \
+        if (INFLATE_FAST_WIDE) { \
+            hold |= (unsigned long)get_unaligned_le64(in) << bits; \
+            in += (63 - bits) >> 3; \
+            bits |= 56; \
+        } \
+        else if (bits < 15) { \
+            hold += (unsigned long)(*in++) << bits; \
+            bits += 8; \
+            hold += (unsigned long)(*in++) << bits; \
+            bits += 8; \
+        } \
+    } while (0)
+
 /*
    Decode literal, length, and distance codes and write out the resulting
    literal and match bytes until either not enough input or output is
@@ -23,7 +45,7 @@
    Entry assumptions:
 
         state->mode == LEN
-        strm->avail_in >= 6
+        strm->avail_in >= INFLATE_FAST_MIN_INPUT
         strm->avail_out >= 258
         start >= strm->avail_out
         state->bits < 8
@@ -80,14 +102,14 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     /* copy state to local variables */
     state = (struct inflate_state FAR *)strm->state;
     in = strm->next_in;
-    last = in + (strm->avail_in - 5);
-    if (in > last && strm->avail_in > 5) {
+    last = in + (strm->avail_in - INFLATE_FAST_SLOP);
+    if (in > last && strm->avail_in > INFLATE_FAST_SLOP) {
         /*
          * overflow detected, limit strm->avail_in to the
          * max. possible size and recalculate last
          */
 	strm->avail_in = 0xffffffff - (uintptr_t)in;
-        last = in + (strm->avail_in - 5);
+        last = in + (strm->avail_in - INFLATE_FAST_SLOP);
     }
     out = strm->next_out;
     beg = out - (start - strm->avail_out);
@@ -109,12 +131,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     /* decode literals and length/distances until end-of-block or not enough
        input data or output space */
     do {
-        if (bits < 15) {
-            hold += (unsigned long)(*in++) << bits;
-            bits += 8;
-            hold += (unsigned long)(*in++) << bits;
-            bits += 8;
-        }
+        FAST_REFILL();
         here = lcode[hold & lmask];
       dolen:
         op = (unsigned)(here.bits);
@@ -131,7 +148,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
             len = (unsigned)(here.val);
             op &= 15;                           /* number of extra bits */
             if (op) {
-                if (bits < op) {
+                if (!INFLATE_FAST_WIDE && bits < op) {
                     hold += (unsigned long)(*in++) << bits;
                     bits += 8;
                 }
@@ -140,12 +157,8 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                 bits -= op;
             }
             Tracevv((stderr, "inflate:         length %u\n", len));
-            if (bits < 15) {
-                hold += (unsigned long)(*in++) << bits;
-                bits += 8;
-                hold += (unsigned long)(*in++) << bits;
-                bits += 8;
-            }
+            if (!INFLATE_FAST_WIDE)
+                FAST_REFILL();
             here = dcode[hold & dmask];
           dodist:
             op = (unsigned)(here.bits);
@@ -155,7 +168,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
             if (op & 16) {                      /* distance base */
                 dist = (unsigned)(here.val);
                 op &= 15;                       /* number of extra bits */
-                if (bits < op) {
+                if (!INFLATE_FAST_WIDE && bits < op) {
                     hold += (unsigned long)(*in++) << bits;
                     bits += 8;
                     if (bits < op) {
@@ -240,6 +253,22 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
 		    unsigned long loops;
 
                     from = out - dist;          /* copy direct from output */
+                    /*
+                     * U-Boot: if the match does not overlap a word, copy
+                     * a word at a time
+                     */
+                    if (dist >= sizeof(unsigned long)) {
+                        while (len >= sizeof(unsigned long)) {
+                            put_unaligned(get_unaligned((unsigned long *)from),
+                                          (unsigned long *)out);
+                            out += sizeof(unsigned long);
+                            from += sizeof(unsigned long);
+                            len -= sizeof(unsigned long);
+                        }
+                        while (len--)
+                            *out++ = *from++;
+                        continue;
+                    }
                     /* minimum length is three */
 		    /* Align out addr */
 		    if (!((long)(out - 1) & 1)) {
@@ -309,12 +338,14 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     len = bits >> 3;
     in -= len;
     bits -= len << 3;
-    hold &= (1U << bits) - 1;
+    hold &= (1UL << bits) - 1;
 
     /* update state and return */
     strm->next_in = in;
     strm->next_out = out;
-    strm->avail_in = (unsigned)(in < last ? 5 + (last - in) : 5 - (in - last));
+    strm->avail_in = (unsigned)(in < last ?
+                                INFLATE_FAST_SLOP + (last - in) :
+                                INFLATE_FAST_SLOP - (in - last));
     strm->avail_out = (unsigned)(out < end ?
                                  257 + (end - out) : 257 - (out - end));
     state->hold = hold;
@@ -8,4 +8,14 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/*
+ * U-Boot: with a 64-bit bit buffer, inflate_fast() refills it with a single
+ * unaligned load, which may read up to eight bytes ahead of the input it
+ * actually uses. INFLATE_FAST_SLOP is how many bytes before the end of the
+ * input the loop stops, INFLATE_FAST_MIN_INPUT the input needed to call it.
+ */
+#define INFLATE_FAST_WIDE	(sizeof(unsigned long) == 8)
+#define INFLATE_FAST_SLOP	(INFLATE_FAST_WIDE ? 7 : 5)
+#define INFLATE_FAST_MIN_INPUT	(INFLATE_FAST_SLOP + 1)
+
 void inflate_fast OF((z_streamp strm, unsigned start));
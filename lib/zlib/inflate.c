@@ -722,7 +722,7 @@ __rcode int ZEXPORT inflate(z_streamp strm, int flush)
             state->mode = LEN;
         case LEN:
 	    schedule();
-            if (have >= 6 && left >= 258) {
+            if (have >= INFLATE_FAST_MIN_INPUT && left >= 258) {
                 RESTORE();
                 inflate_fast(strm, out);
                 LOAD();
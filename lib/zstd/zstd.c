@@ -6,17 +6,207 @@
 #define LOG_CATEGORY	LOGC_BOOT
 
 #include <abuf.h>
+#include <cpu_func.h>
 #include <log.h>
 #include <malloc.h>
 #include <linux/errno.h>
+#include <linux/string.h>
 #include <linux/zstd.h>
 
+/**
+ * struct zstd_frame - one frame of a multi-frame stream
+ *
+ * @src:	start of the compressed frame
+ * @src_size:	size of the compressed frame
+ * @dst:	where to write the decompressed frame
+ * @dst_size:	decompressed size, from the frame header
+ * @result:	return value of zstd_decompress_dctx()
+ */
+struct zstd_frame {
+	const void *src;
+	size_t src_size;
+	void *dst;
+	size_t dst_size;
+	size_t result;
+};
+
+/**
+ * struct zstd_frame_work - frames decompressed in parallel
+ *
+ * @frames:	frames to decompress
+ * @ctx:	one decompression context for each CPU
+ */
+struct zstd_frame_work {
+	struct zstd_frame *frames;
+	zstd_dctx **ctx;
+};
+
+static int zstd_decompress_frame(void *priv, uint cpu, uint job)
+{
+	struct zstd_frame_work *work = priv;
+	struct zstd_frame *frame = &work->frames[job];
+
+	frame->result = zstd_decompress_dctx(work->ctx[cpu], frame->dst,
+					     frame->dst_size, frame->src,
+					     frame->src_size);
+	if (zstd_is_error(frame->result) || frame->result != frame->dst_size)
+		return -EINVAL;
+
+	return 0;
+}
+
+/*
+ * Find the frames in @in, filling in @frames if not NULL. Return the number of
+ * frames found, or -EINVAL if there are none. *@total is set to the total decompressed size, or to
+ * ZSTD_CONTENTSIZE_UNKNOWN if a frame does not record its size.
+ */
+static int zstd_find_frames(struct abuf *in, struct abuf *out,
+			    struct zstd_frame *frames, u64 *total)
+{
+	const u8 *src = abuf_data(in);
+	size_t left = abuf_size(in);
+	u8 *dst = abuf_data(out);
+	int count = 0;
+
+	*total = 0;
+	while (left) {
+		zstd_frame_header hdr;
+		size_t len;
+		u64 size;
+
+		/*
+		 * Stop at the first thing that is not a frame, there may be
+		 * junk at the end that zstd_decompress_dctx() can't handle.
+		 */
+		len = zstd_find_frame_compressed_size(src, left);
+		if (zstd_is_error(len)) {
+			if (count)
+				break;
+			log_err("%s: failed to detect compressed size: %d\n",
+				__func__, zstd_get_error_code(len));
+			return -EINVAL;
+		}
+
+		size = ZSTD_CONTENTSIZE_UNKNOWN;
+		if (!zstd_get_frame_header(&hdr, src, len))
+			size = hdr.frameType == ZSTD_skippableFrame ? 0 :
+				hdr.frameContentSize;
+		if (size == ZSTD_CONTENTSIZE_UNKNOWN ||
+		    size == ZSTD_CONTENTSIZE_ERROR)
+			*total = ZSTD_CONTENTSIZE_UNKNOWN;
+		else if (*total != ZSTD_CONTENTSIZE_UNKNOWN)
+			*total += size;
+
+		if (frames) {
+			frames[count].src = src;
+			frames[count].src_size = len;
+			frames[count].dst = dst;
+			frames[count].dst_size = size;
+			dst += size;
+		}
+		src += len;
+		left -= len;
+		count++;
+	}
+
+	return count;
+}
+
+/*
+ * Decompress @count frames of known size, spreading them over the available
+ * CPUs. Return the decompressed size, or -ENOSYS if this is not possible, in
+ * which case the frames should be decompressed in sequence instead.
+ */
+static int zstd_decompress_parallel(struct abuf *in, struct abuf *out,
+				    int count)
+{
+	struct zstd_frame_work work;
+	int ncpus, nws, ret, i;
+	size_t wsize, len;
+	void **workspace;
+	u64 total;
+
+	nws = min(cpu_work_cpus(), count);
+	if (nws <= 1)
+		return -ENOSYS;
+
+	work.frames = calloc(count, sizeof(*work.frames));
+	work.ctx = calloc(nws, sizeof(*work.ctx));
+	workspace = calloc(nws, sizeof(*workspace));
+	if (!work.frames || !work.ctx || !workspace) {
+		ret = -ENOSYS;
+		goto do_free;
+	}
+	zstd_find_frames(in, out, work.frames, &total);
+
+	wsize = zstd_dctx_workspace_bound();
+	for (i = 0; i < nws; i++) {
+		workspace[i] = malloc(wsize);
+		if (!workspace[i])
+			break;
+		work.ctx[i] = zstd_init_dctx(workspace[i], wsize);
+		if (!work.ctx[i])
+			break;
+	}
+	/* Use as many CPUs as there is memory for */
+	ncpus = i;
+	if (ncpus <= 1) {
+		ret = -ENOSYS;
+		goto do_free;
+	}
+
+	ret = cpu_work_run(zstd_decompress_frame, &work, count, ncpus);
+	/* a CPU which timed out may still be using the buffers */
+	if (ret == -ETIMEDOUT)
+		return log_msg_ret("zsp", ret);
+	if (ret) {
+		for (i = 0; i < count; i++) {
+			len = work.frames[i].result;
+			if (zstd_is_error(len))
+				log_err("%s: failed to decompress frame %d: %d\n",
+					__func__, i, zstd_get_error_code(len));
+			else if (len != work.frames[i].dst_size)
+				log_err("%s: frame %d size mismatch\n",
+					__func__, i);
+		}
+		goto do_free;
+	}
+	ret = total;
+
+do_free:
+	if (workspace) {
+		for (i = 0; i < nws; i++)
+			free(workspace[i]);
+	}
+	free(workspace);
+	free(work.ctx);
+	free(work.frames);
+	return ret;
+}
+
 int zstd_decompress(struct abuf *in, struct abuf *out)
 {
+	size_t wsize, len, res, done;
 	zstd_dctx *ctx;
-	size_t wsize, len;
 	void *workspace;
-	int ret;
+	const u8 *src;
+	int count, ret, i;
+	u64 total;
+
+	count = zstd_find_frames(in, out, NULL, &total);
+	if (count < 0)
+		return count;
+
+	/*
+	 * Frames which record their decompressed size can be placed in the
+	 * output buffer up front and decompressed independently
+	 */
+	if (count > 1 && total != ZSTD_CONTENTSIZE_UNKNOWN &&
+	    total <= abuf_size(out)) {
+		ret = zstd_decompress_parallel(in, out, count);
+		if (ret != -ENOSYS)
+			return ret;
+	}
 
 	wsize = zstd_dctx_workspace_bound();
 	workspace = malloc(wsize);
@@ -33,29 +223,109 @@ int zstd_decompress(struct abuf *in, struct abuf *out)
 		goto do_free;
 	}
 
-	/*
-	 * Find out how large the frame actually is, there may be junk at
-	 * the end of the frame that zstd_decompress_dctx() can't handle.
-	 */
-	len = zstd_find_frame_compressed_size(abuf_data(in), abuf_size(in));
-	if (zstd_is_error(len)) {
-		log_err("%s: failed to detect compressed size: %d\n", __func__,
-			zstd_get_error_code(len));
-		ret = -EINVAL;
-		goto do_free;
+	src = abuf_data(in);
+	done = 0;
+	for (i = 0; i < count; i++) {
+		len = zstd_find_frame_compressed_size(src, abuf_size(in) -
+						      (src - (u8 *)abuf_data(in)));
+		res = zstd_decompress_dctx(ctx, abuf_data(out) + done,
+					   abuf_size(out) - done, src, len);
+		if (zstd_is_error(res)) {
+			log_err("%s: failed to decompress: %d\n", __func__,
+				zstd_get_error_code(res));
+			ret = -EINVAL;
+			goto do_free;
+		}
+		src += len;
+		done += res;
 	}
 
-	len = zstd_decompress_dctx(ctx, abuf_data(out), abuf_size(out),
-				   abuf_data(in), len);
-	if (zstd_is_error(len)) {
-		log_err("%s: failed to decompress: %d\n", __func__,
-			zstd_get_error_code(len));
-		ret = -EINVAL;
-		goto do_free;
-	}
-
-	ret = len;
+	ret = done;
 do_free:
 	free(workspace);
 	return ret;
 }
+
+void zstd_stream_init(struct zstd_stream *st, void *dst, size_t dst_size,
+		      size_t max_window)
+{
+	memset(st, '\0', sizeof(*st));
+	st->out.dst = dst;
+	st->out.size = dst_size;
+	st->max_window = max_window;
+}
+
+static int zstd_stream_setup(struct zstd_stream *st, const void *data,
+			     size_t len)
+{
+	size_t window = st->max_window;
+	zstd_frame_header hdr;
+	size_t wsize;
+
+	/* Use a smaller window if the frame says that is enough */
+	if (!zstd_get_frame_header(&hdr, data, len) && hdr.windowSize) {
+		if (hdr.windowSize > st->max_window) {
+			log_err("%s: window size %llx exceeds limit %zx\n",
+				__func__, hdr.windowSize, st->max_window);
+			return -E2BIG;
+		}
+		window = hdr.windowSize;
+	}
+
+	wsize = zstd_dstream_workspace_bound(window);
+	st->workspace = malloc(wsize);
+	if (!st->workspace) {
+		debug("%s: cannot allocate workspace of size %zu\n", __func__,
+		      wsize);
+		return -ENOMEM;
+	}
+	st->ds = zstd_init_dstream(window, st->workspace, wsize);
+	if (!st->ds) {
+		log_err("%s: zstd_init_dstream() failed\n", __func__);
+		return -EPERM;
+	}
+
+	return 0;
+}
+
+int zstd_stream_add(struct zstd_stream *st, const void *data, size_t len)
+{
+	zstd_in_buffer in = { .src = data, .size = len };
+	size_t in_pos, out_pos, res;
+	int ret;
+
+	if (!len)
+		return 0;
+	if (!st->ds) {
+		ret = zstd_stream_setup(st, data, len);
+		if (ret)
+			return ret;
+	}
+
+	while (in.pos < in.size) {
+		in_pos = in.pos;
+		out_pos = st->out.pos;
+		res = zstd_decompress_stream(st->ds, &st->out, &in);
+		if (zstd_is_error(res)) {
+			log_err("%s: failed to decompress: %d\n", __func__,
+				zstd_get_error_code(res));
+			return -EINVAL;
+		}
+		st->done = !res;
+		if (in.pos == in_pos && st->out.pos == out_pos)
+			return -ENOSPC;
+	}
+
+	return 0;
+}
+
+int zstd_stream_finish(struct zstd_stream *st)
+{
+	int ret = st->done ? st->out.pos : -EINVAL;
+
+	free(st->workspace);
+	st->workspace = NULL;
+	st->ds = NULL;
+
+	return ret;
+}
@@ -12,6 +12,7 @@
 #include <env.h>
 #include <log.h>
 #include <net.h>
+#include <time.h>
 #include <vsprintf.h>
 #include <linux/delay.h>
 
@@ -27,6 +28,107 @@ int		arp_wait_try;
 uchar	       *arp_tx_packet; /* THE ARP transmit packet */
 static uchar	arp_tx_packet_buf[PKTSIZE_ALIGN + PKTALIGN];
 
+enum {
+	ARP_CACHE_SIZE		= 8,
+	ARP_CACHE_TIMEOUT	= 60 * 1000,	/* ms */
+};
+
+/**
+ * struct arp_cache_ent - an address found by ARP
+ *
+ * @ip: IP address, or 0 if this entry is not used
+ * @ethaddr: Ethernet address of @ip
+ * @time: get_timer() value when the entry was added
+ */
+struct arp_cache_ent {
+	struct in_addr ip;
+	uchar ethaddr[ARP_HLEN];
+	ulong time;
+};
+
+static struct arp_cache_ent arp_cache[ARP_CACHE_SIZE];
+/* our addresses when the cache was filled */
+static struct in_addr arp_cache_our_ip;
+static uchar arp_cache_our_ethaddr[ARP_HLEN];
+
+/* Drop the cache if it was filled on another interface or subnet */
+static void arp_cache_check(void)
+{
+	if (arp_cache_our_ip.s_addr == net_ip.s_addr &&
+	    !memcmp(arp_cache_our_ethaddr, net_ethaddr, ARP_HLEN))
+		return;
+
+	memset(arp_cache, '\0', sizeof(arp_cache));
+	arp_cache_our_ip = net_ip;
+	memcpy(arp_cache_our_ethaddr, net_ethaddr, ARP_HLEN);
+}
+
+static void arp_cache_add(struct in_addr ip, const uchar *ethaddr)
+{
+	struct arp_cache_ent *ent, *oldest = arp_cache;
+	int i;
+
+	if (!IS_ENABLED(CONFIG_NET_ARP_CACHE) || !ip.s_addr)
+		return;
+
+	arp_cache_check();
+	for (i = 0; i < ARP_CACHE_SIZE; i++) {
+		ent = &arp_cache[i];
+		if (ent->ip.s_addr == ip.s_addr || !ent->ip.s_addr) {
+			oldest = ent;
+			break;
+		}
+		if (time_before(ent->time, oldest->time))
+			oldest = ent;
+	}
+	oldest->ip = ip;
+	memcpy(oldest->ethaddr, ethaddr, ARP_HLEN);
+	oldest->time = get_timer(0);
+}
+
+/* Get the address which must be resolved to send a packet to @dest */
+static struct in_addr arp_next_hop(struct in_addr dest)
+{
+	if ((dest.s_addr & net_netmask.s_addr) !=
+	    (net_ip.s_addr & net_netmask.s_addr) && net_gateway.s_addr)
+		return net_gateway;
+
+	return dest;
+}
+
+void arp_cache_flush(void)
+{
+	memset(arp_cache, '\0', sizeof(arp_cache));
+}
+
+bool arp_cache_lookup(struct in_addr dest, uchar *ethaddr)
+{
+	struct in_addr ip = arp_next_hop(dest);
+	int i;
+
+	if (!IS_ENABLED(CONFIG_NET_ARP_CACHE))
+		return false;
+
+	arp_cache_check();
+	for (i = 0; i < ARP_CACHE_SIZE; i++) {
+		struct arp_cache_ent *ent = &arp_cache[i];
+
+		if (!ent->ip.s_addr || ent->ip.s_addr != ip.s_addr)
+			continue;
+		if (get_timer(ent->time) > ARP_CACHE_TIMEOUT) {
+			ent->ip.s_addr = 0;
+			return false;
+		}
+		memcpy(ethaddr, ent->ethaddr, ARP_HLEN);
+		debug_cond(DEBUG_DEV_PKT, "ARP cache: %pI4 is at %pM\n", &ip,
+			   ethaddr);
+
+		return true;
+	}
+
+	return false;
+}
+
 void arp_init(void)
 {
 	/* XXX problem with bss workaround */
@@ -71,16 +173,9 @@ void arp_raw_request(struct in_addr source_ip, const uchar *target_ethaddr,
 void arp_request(void)
 {
 	if ((net_arp_wait_packet_ip.s_addr & net_netmask.s_addr) !=
-	    (net_ip.s_addr & net_netmask.s_addr)) {
-		if (net_gateway.s_addr == 0) {
-			puts("## Warning: gatewayip needed but not set\n");
-			net_arp_wait_reply_ip = net_arp_wait_packet_ip;
-		} else {
-			net_arp_wait_reply_ip = net_gateway;
-		}
-	} else {
-		net_arp_wait_reply_ip = net_arp_wait_packet_ip;
-	}
+	    (net_ip.s_addr & net_netmask.s_addr) && !net_gateway.s_addr)
+		puts("## Warning: gatewayip needed but not set\n");
+	net_arp_wait_reply_ip = arp_next_hop(net_arp_wait_packet_ip);
 
 	arp_raw_request(net_ip, net_null_ethaddr, net_arp_wait_reply_ip);
 }
@@ -150,6 +245,9 @@ void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 
 	switch (ntohs(arp->ar_op)) {
 	case ARPOP_REQUEST:
+		/* the sender is likely to be the next host we talk to */
+		arp_cache_add(net_read_ip(&arp->ar_spa), &arp->ar_sha);
+
 		/* reply with our IP address */
 		debug_cond(DEBUG_DEV_PKT, "Got ARP REQUEST, return our IP\n");
 		eth_hdr_size = net_update_ether(et, et->et_src, PROT_ARP);
@@ -190,6 +288,7 @@ void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 		}
 
 		reply_ip_addr = net_read_ip(&arp->ar_spa);
+		arp_cache_add(reply_ip_addr, &arp->ar_sha);
 
 		/* matched waiting packet's address */
 		if (reply_ip_addr.s_addr == net_arp_wait_reply_ip.s_addr) {
@@ -21,6 +21,18 @@ extern int arp_wait_try;
 extern uchar *arp_tx_packet;
 
 void arp_init(void);
+
+/**
+ * arp_cache_lookup() - Look up the Ethernet address to send a packet to
+ *
+ * This finds the address of the next hop to @dest, which is the gateway if
+ * @dest is not on our subnet, if it was found by ARP in the last minute.
+ *
+ * @dest: IP address the packet is for
+ * @ethaddr: Returns the Ethernet address, if found
+ * Return: true if found, false if ARP is needed
+ */
+bool arp_cache_lookup(struct in_addr dest, uchar *ethaddr);
 void arp_request(void);
 void arp_raw_request(struct in_addr source_ip, const uchar *targetEther,
 	struct in_addr target_ip);
@@ -45,6 +45,8 @@
 #define CFG_DHCP_MIN_EXT_LEN 64
 #endif
 
+#define DHCP_LEASE_VAR	"dhcp_lease"
+
 #ifndef CFG_BOOTP_ID_CACHE_SIZE
 #define CFG_BOOTP_ID_CACHE_SIZE 4
 #endif
@@ -505,6 +507,12 @@ static int dhcp_extended(u8 *e, int message_type, struct in_addr server_ip,
 		*e++ = tmp >> 8;
 		*e++ = tmp & 0xff;
 	}
+
+	if (IS_ENABLED(CONFIG_DHCP_RAPID_COMMIT) &&
+	    message_type == DHCP_DISCOVER) {
+		*e++ = 80;	/* Rapid Commit */
+		*e++ = 0;
+	}
 #if defined(CONFIG_BOOTP_SEND_HOSTNAME)
 	hostname = env_get("hostname");
 	if (hostname) {
@@ -714,6 +722,26 @@ void bootp_reset(void)
 	bootp_try = 0;
 	bootp_start = get_timer(0);
 	bootp_timeout = 250;
+	time_taken_max = env_get_ulong("bootpretryperiod", 10, TIMEOUT_MS);
+}
+
+/*
+ *	Bootp ID is the lower 4 bytes of our ethernet address
+ *	plus the current time in ms.
+ */
+static u32 bootp_new_id(void)
+{
+	u32 bootp_id;
+
+	bootp_id = ((u32)net_ethaddr[2] << 24)
+		| ((u32)net_ethaddr[3] << 16)
+		| ((u32)net_ethaddr[4] << 8)
+		| (u32)net_ethaddr[5];
+	bootp_id += get_timer(0);
+	bootp_id = htonl(bootp_id);
+	bootp_add_id(bootp_id);
+
+	return bootp_id;
 }
 
 void bootp_request(void)
@@ -728,19 +756,12 @@ void bootp_request(void)
 	u32 bootp_id;
 	struct in_addr zero_ip;
 	struct in_addr bcast_ip;
-	char *ep;  /* Environment pointer */
 
 	bootstage_mark_name(BOOTSTAGE_ID_BOOTP_START, "bootp_start");
 #if defined(CONFIG_CMD_DHCP)
 	dhcp_state = INIT;
 #endif
 
-	ep = env_get("bootpretryperiod");
-	if (ep != NULL)
-		time_taken_max = dectoul(ep, NULL);
-	else
-		time_taken_max = TIMEOUT_MS;
-
 #ifdef CONFIG_BOOTP_RANDOM_DELAY		/* Random BOOTP delay */
 	if (bootp_try == 0)
 		srand_mac();
@@ -800,17 +821,7 @@ void bootp_request(void)
 	extlen = bootp_extended((u8 *)bp->bp_vend);
 #endif
 
-	/*
-	 *	Bootp ID is the lower 4 bytes of our ethernet address
-	 *	plus the current time in ms.
-	 */
-	bootp_id = ((u32)net_ethaddr[2] << 24)
-		| ((u32)net_ethaddr[3] << 16)
-		| ((u32)net_ethaddr[4] << 8)
-		| (u32)net_ethaddr[5];
-	bootp_id += get_timer(0);
-	bootp_id = htonl(bootp_id);
-	bootp_add_id(bootp_id);
+	bootp_id = bootp_new_id();
 	net_copy_u32(&bp->bp_id, &bootp_id);
 
 	/*
@@ -921,6 +932,8 @@ static void dhcp_process_options(uchar *popt, uchar *end)
 				net_boot_file_name[size] = 0;
 			}
 			break;
+		case 80:	/* Ignore Rapid Commit Option */
+			break;
 		case 209:	/* PXELINUX Config File */
 			if (IS_ENABLED(CONFIG_BOOTP_PXE_DHCP_OPTION)) {
 				/* In case it has already been allocated when get DHCP Offer packet,
@@ -999,13 +1012,20 @@ static int dhcp_message_type(unsigned char *popt)
 	return -1;
 }
 
-static void dhcp_send_request_packet(struct bootp_hdr *bp_offer)
+/**
+ * dhcp_send_request() - send a DHCPREQUEST
+ *
+ * @id: Transaction ID, in network order
+ * @server_ip: Server to send the server identifier of, or 0 for none
+ * @requested_ip: Address to ask for
+ */
+static void dhcp_send_request(u32 id, struct in_addr server_ip,
+			      struct in_addr requested_ip)
 {
 	uchar *pkt, *iphdr;
 	struct bootp_hdr *bp;
 	int pktlen, iplen, extlen;
 	int eth_hdr_size;
-	struct in_addr offered_ip;
 	struct in_addr zero_ip;
 	struct in_addr bcast_ip;
 
@@ -1038,20 +1058,9 @@ static void dhcp_send_request_packet(struct bootp_hdr *bp_offer)
 	memcpy(bp->bp_chaddr, net_ethaddr, 6);
 	copy_filename(bp->bp_file, net_boot_file_name, sizeof(bp->bp_file));
 
-	/*
-	 * ID is the id of the OFFER packet
-	 */
-
-	net_copy_u32(&bp->bp_id, &bp_offer->bp_id);
-
-	/*
-	 * Copy options from OFFER packet if present
-	 */
-
-	/* Copy offered IP into the parameters request list */
-	net_copy_ip(&offered_ip, &bp_offer->bp_yiaddr);
+	net_copy_u32(&bp->bp_id, &id);
 	extlen = dhcp_extended((u8 *)bp->bp_vend, DHCP_REQUEST,
-		dhcp_server_ip, offered_ip);
+		server_ip, requested_ip);
 
 	iplen = BOOTP_HDR_SIZE - OPT_FIELD_SIZE + extlen;
 	pktlen = eth_hdr_size + IP_UDP_HDR_SIZE + iplen;
@@ -1062,6 +1071,80 @@ static void dhcp_send_request_packet(struct bootp_hdr *bp_offer)
 	net_send_packet(net_tx_packet, pktlen);
 }
 
+static void dhcp_send_request_packet(struct bootp_hdr *bp_offer)
+{
+	struct in_addr offered_ip;
+	u32 id;
+
+	/*
+	 * ID is the id of the OFFER packet
+	 */
+	net_copy_u32(&id, &bp_offer->bp_id);
+
+	/* Copy offered IP into the parameters request list */
+	net_copy_ip(&offered_ip, &bp_offer->bp_yiaddr);
+	dhcp_send_request(id, dhcp_server_ip, offered_ip);
+}
+
+/*
+ * Record the lease, so that it can be asked for again. It lasts across a
+ * reset only if the user saves the environment.
+ */
+static void dhcp_lease_save(void)
+{
+	char buf[40];
+
+	if (!IS_ENABLED(CONFIG_DHCP_INIT_REBOOT))
+		return;
+
+	snprintf(buf, sizeof(buf), "%pM %pI4", net_ethaddr, &net_ip);
+	env_set(DHCP_LEASE_VAR, buf);
+}
+
+/*
+ * Get the address recorded by dhcp_lease_save() for this Ethernet address,
+ * or 0 if there is none
+ */
+static struct in_addr dhcp_lease_get(void)
+{
+	struct in_addr ip = { .s_addr = 0 };
+	uchar ethaddr[ARP_HLEN];
+	const char *val;
+
+	val = env_get(DHCP_LEASE_VAR);
+	if (!val || strlen(val) <= ARP_HLEN * 3 || val[ARP_HLEN * 3 - 1] != ' ')
+		return ip;
+	string_to_enetaddr(val, ethaddr);
+	if (memcmp(ethaddr, net_ethaddr, ARP_HLEN))
+		return ip;
+
+	return string_to_ip(val + ARP_HLEN * 3);
+}
+
+/*
+ * Ask for the recorded lease with a DHCPREQUEST in the INIT-REBOOT state,
+ * returning -ENOENT if there is none
+ */
+static int dhcp_reboot_request(void)
+{
+	struct in_addr ip, zero_ip = { .s_addr = 0 };
+
+	ip = dhcp_lease_get();
+	if (!ip.s_addr)
+		return -ENOENT;
+
+	bootstage_mark_name(BOOTSTAGE_ID_BOOTP_START, "bootp_start");
+	printf("DHCP request for %pI4\n", &ip);
+	dhcp_state = REBOOTING;
+
+	/* the timeout falls back to a DHCPDISCOVER */
+	net_set_timeout_handler(bootp_timeout, bootp_timeout_handler);
+	net_set_udp_handler(dhcp_handler);
+	dhcp_send_request(bootp_new_id(), zero_ip, ip);
+
+	return 0;
+}
+
 /*
  *	Handle DHCP received packets.
  */
@@ -1080,6 +1163,14 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 	debug("DHCPHandler: got DHCP packet: (src=%d, dst=%d, len=%d) state: "
 	      "%d\n", src, dest, len, dhcp_state);
 
+	if (dhcp_state == REBOOTING &&
+	    dhcp_message_type((u8 *)bp->bp_vend) == DHCP_NAK) {
+		puts("DHCP lease refused\n");
+		env_set(DHCP_LEASE_VAR, NULL);
+		bootp_request();
+		return;
+	}
+
 	if (net_read_ip(&bp->bp_yiaddr).s_addr == 0) {
 #if defined(CONFIG_SERVERIP_FROM_PROXYDHCP)
 		store_bootp_params(bp);
@@ -1110,6 +1201,11 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			if (CONFIG_IS_ENABLED(EFI_LOADER) &&
 			    IS_ENABLED(CONFIG_NETDEVICES))
 				efi_net_set_dhcp_ack(pkt, len);
+			if (IS_ENABLED(CONFIG_DHCP_RAPID_COMMIT) &&
+			    dhcp_message_type((u8 *)bp->bp_vend) == DHCP_ACK) {
+				debug("got rapid-commit ACK; transitioning to BOUND\n");
+				goto dhcp_got_bootp;
+			}
 
 #if defined(CONFIG_SERVERIP_FROM_PROXYDHCP)
 			if (!net_server_ip.s_addr)
@@ -1128,10 +1224,16 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 		return;
 		break;
+	case REBOOTING:
 	case REQUESTING:
-		debug("DHCP State: REQUESTING\n");
+		debug("DHCP State: %s\n",
+		      dhcp_state == REBOOTING ? "REBOOTING" : "REQUESTING");
 
 		if (dhcp_message_type((u8 *)bp->bp_vend) == DHCP_ACK) {
+			if (CONFIG_IS_ENABLED(EFI_LOADER) &&
+			    IS_ENABLED(CONFIG_NETDEVICES) &&
+			    dhcp_state == REBOOTING)
+				efi_net_set_dhcp_ack(pkt, len);
 dhcp_got_bootp:
 			dhcp_packet_process_options(bp);
 			/* Store net params from reply */
@@ -1142,6 +1244,7 @@ dhcp_got_bootp:
 			net_set_timeout_handler(0, (thand_f *)0);
 			bootstage_mark_name(BOOTSTAGE_ID_BOOTP_STOP,
 					    "bootp_stop");
+			dhcp_lease_save();
 
 			net_auto_load();
 			return;
@@ -1158,6 +1261,10 @@ dhcp_got_bootp:
 
 void dhcp_request(void)
 {
+	if (IS_ENABLED(CONFIG_DHCP_INIT_REBOOT) && !bootp_try &&
+	    !dhcp_reboot_request())
+		return;
+
 	bootp_request();
 }
 #endif	/* CONFIG_CMD_DHCP */
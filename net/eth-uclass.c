@@ -12,6 +12,7 @@
 #include <dm.h>
 #include <env.h>
 #include <log.h>
+#include <mapmem.h>
 #include <net.h>
 #include <nvmem.h>
 #include <asm/global_data.h>
@@ -23,14 +24,45 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/**
+ * struct eth_rx_place - state of receiving frames in place
+ *
+ * @dest: Where the driver puts payload, @dest.len is 0 when not in use
+ * @next: Request waiting for the receive ring to run empty
+ * @pending: @next is waiting
+ * @seq: Number of frames given to the driver so far
+ * @placed: Number of frames at the start that go in place
+ * @full: No more frames go in place, @placed is final
+ * @rx_seq: Number of frames received so far
+ * @pkt: Packet being processed, if it was received in place
+ * @head: Bytes of @pkt in the driver's buffer
+ * @addr: Where the rest of @pkt is
+ */
+struct eth_rx_place {
+	struct eth_rx_dest dest;
+	struct eth_rx_dest next;
+	bool pending;
+	uint seq;
+	uint placed;
+	bool full;
+	uint rx_seq;
+	uchar *pkt;
+	uint head;
+	ulong addr;
+};
+
 /**
  * struct eth_device_priv - private structure for each Ethernet device
  *
  * @state: The state of the Ethernet MAC driver (defined by enum eth_state_t)
+ * @place: Receiving payload in place, see eth_set_rx_dest()
  */
 struct eth_device_priv {
 	enum eth_state_t state;
 	bool running;
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	struct eth_rx_place place;
+#endif
 };
 
 /**
@@ -395,6 +427,10 @@ void eth_halt(void)
 	eth_get_ops(current)->stop(current);
 	priv->state = ETH_STATE_PASSIVE;
 	priv->running = false;
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+	/* the driver is back to its own buffers when it starts again */
+	memset(&priv->place, 0, sizeof(priv->place));
+#endif
 
 end:
 	in_init_halt = false;
@@ -435,6 +471,200 @@ int eth_send(void *packet, int length)
 	return ret;
 }
 
+#if CONFIG_IS_ENABLED(ETH_RX_CSUM_OFFLOAD)
+bool net_rx_csum_ok;
+
+void eth_rx_csum_verified(struct udevice *dev)
+{
+	net_rx_csum_ok = true;
+}
+#endif
+
+#ifdef CONFIG_CMD_MTFTPBOOT
+int eth_mcast_join(struct in_addr mcast_addr, int join)
+{
+	struct udevice *current = eth_get_dev();
+	u32 ip = ntohl(mcast_addr.s_addr);
+	u8 mcast_mac[ARP_HLEN];
+
+	if (!current || !eth_get_ops(current)->mcast)
+		return -ENOSYS;
+
+	/* 01:00:5e followed by the low 23 bits of the group, RFC 1112 */
+	mcast_mac[0] = 0x01;
+	mcast_mac[1] = 0x00;
+	mcast_mac[2] = 0x5e;
+	mcast_mac[3] = (ip >> 16) & 0x7f;
+	mcast_mac[4] = ip >> 8;
+	mcast_mac[5] = ip;
+
+	return eth_get_ops(current)->mcast(current, mcast_mac, join);
+}
+#endif
+
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+static struct eth_rx_place *eth_rx_get_place(struct udevice *dev)
+{
+	struct eth_device_priv *priv;
+
+	if (!dev)
+		return NULL;
+	priv = dev_get_uclass_priv(dev);
+
+	return &priv->place;
+}
+
+void eth_set_rx_dest(const struct eth_rx_dest *dest)
+{
+	struct eth_rx_place *place = eth_rx_get_place(eth_get_dev());
+
+	if (!place || !eth_get_ops(eth_get_dev())->set_rx_dest)
+		return;
+
+	if (!dest && !place->dest.len) {
+		place->pending = false;
+		return;
+	}
+
+	if (dest)
+		place->next = *dest;
+	else
+		memset(&place->next, 0, sizeof(place->next));
+	place->pending = true;
+}
+
+/* Hand a waiting request to the driver, once nothing is in flight */
+static void eth_rx_apply_dest(struct udevice *dev, struct eth_rx_place *place)
+{
+	int ret;
+
+	place->pending = false;
+	place->dest = place->next;
+	place->seq = 0;
+	place->placed = 0;
+	place->full = false;
+	place->rx_seq = 0;
+
+	ret = eth_get_ops(dev)->set_rx_dest(dev, place->dest.len ?
+					    &place->dest : NULL);
+	if (ret) {
+		debug("%s: set_rx_dest() returned error %d\n", __func__, ret);
+		memset(&place->dest, 0, sizeof(place->dest));
+		eth_get_ops(dev)->set_rx_dest(dev, NULL);
+	}
+}
+
+int eth_rx_dest_next(struct udevice *dev, uint head, uint size, ulong *addr)
+{
+	struct eth_rx_place *place = eth_rx_get_place(dev);
+	struct eth_rx_dest *dest = &place->dest;
+	ulong start;
+
+	if (!dest->len || place->full || head < dest->hdr_len)
+		goto full;
+
+	/*
+	 * The cache lines around the buffer are invalidated once the frame
+	 * is in, so they must not hold anything outside the destination.
+	 */
+	start = dest->addr + (ulong)place->seq * dest->len + head -
+		dest->hdr_len;
+	if (ALIGN_DOWN(start, ARCH_DMA_MINALIGN) < dest->addr ||
+	    ALIGN(start + size, ARCH_DMA_MINALIGN) > dest->end)
+		goto full;
+
+	place->seq++;
+	place->placed = place->seq;
+	*addr = start;
+
+	return 0;
+
+full:
+	/* Frames after the first one that does not fit are not placed */
+	place->full = true;
+	place->seq++;
+
+	return -ENOSPC;
+}
+
+void eth_rx_placed(struct udevice *dev, uchar *pkt, uint head, ulong addr)
+{
+	struct eth_rx_place *place = eth_rx_get_place(dev);
+
+	place->pkt = pkt;
+	place->head = head;
+	place->addr = addr;
+}
+
+/* Check that a frame received in place is one the protocol asked for */
+static bool eth_rx_in_flow(struct eth_rx_place *place, int len)
+{
+	struct ethernet_hdr *et = (struct ethernet_hdr *)place->pkt;
+	struct ip_udp_hdr *ip = (struct ip_udp_hdr *)(et + 1);
+
+	if (len < place->dest.hdr_len)
+		return false;
+
+	return et->et_protlen == htons(PROT_IP) &&
+	       ip->ip_hl_v == 0x45 && ip->ip_p == IPPROTO_UDP &&
+	       !(ntohs(ip->ip_off) & (IP_OFFS | IP_FLAGS_MFRAG)) &&
+	       ntohs(ip->udp_dst) == place->dest.port;
+}
+
+/*
+ * Give the network stack a frame in one piece, unless it is one that the
+ * protocol will store with eth_rx_store()
+ */
+static void eth_rx_gather(struct eth_rx_place *place, int len)
+{
+	void *rest;
+
+	if (eth_rx_in_flow(place, len))
+		return;
+
+	rest = map_sysmem(place->addr, len - place->head);
+	memcpy(place->pkt + place->head, rest, len - place->head);
+	unmap_sysmem(rest);
+	place->pkt = NULL;
+}
+
+int eth_rx_check(const void *dst, const void *src)
+{
+	struct eth_rx_place *place = eth_rx_get_place(eth_get_dev());
+	uint skip;
+
+	/* Frames after the placed ones find no DMA going on around them */
+	if (!place || !place->dest.len || place->rx_seq > place->placed)
+		return 0;
+
+	if (!place->pkt || src != place->pkt + place->dest.hdr_len)
+		return -EAGAIN;
+
+	skip = place->head - place->dest.hdr_len;
+	if (place->addr != map_to_sysmem(dst) + skip)
+		return -EAGAIN;
+
+	return 0;
+}
+
+int eth_rx_store(void *dst, const void *src, uint len)
+{
+	struct eth_rx_place *place = eth_rx_get_place(eth_get_dev());
+	int ret;
+
+	ret = eth_rx_check(dst, src);
+	if (ret)
+		return ret;
+
+	/* The driver's buffer holds the headers and the start of the data */
+	if (place && place->dest.len && place->pkt)
+		len = min(len, place->head - place->dest.hdr_len);
+	memcpy(dst, src, len);
+
+	return 0;
+}
+#endif
+
 int eth_rx(void)
 {
 	struct udevice *current;
@@ -453,17 +683,39 @@ int eth_rx(void)
 	/* Process up to 32 packets at one time */
 	flags = ETH_RECV_CHECK_DEVICE;
 	for (i = 0; i < ETH_PACKETS_BATCH_RECV; i++) {
+#if CONFIG_IS_ENABLED(ETH_RX_CSUM_OFFLOAD)
+		net_rx_csum_ok = false;
+#endif
 		ret = eth_get_ops(current)->recv(current, flags, &packet);
 		flags = 0;
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+		if (ret >= 0) {
+			struct eth_rx_place *place = eth_rx_get_place(current);
+
+			place->rx_seq++;
+			if (ret > 0 && place->pkt)
+				eth_rx_gather(place, ret);
+		}
+#endif
 		if (ret > 0)
 			net_process_received_packet(packet, ret);
 		if (ret >= 0 && eth_get_ops(current)->free_pkt)
 			eth_get_ops(current)->free_pkt(current, packet, ret);
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+		eth_rx_get_place(current)->pkt = NULL;
+#endif
 		if (ret <= 0)
 			break;
 	}
-	if (ret == -EAGAIN)
+	if (ret == -EAGAIN) {
+#if CONFIG_IS_ENABLED(ETH_RX_IN_PLACE)
+		struct eth_rx_place *place = eth_rx_get_place(current);
+
+		if (place->pending)
+			eth_rx_apply_dest(current, place);
+#endif
 		ret = 0;
+	}
 	if (ret < 0) {
 		/* We cannot completely return the error at present */
 		debug("%s: recv() returned error %d\n", __func__, ret);
@@ -99,6 +99,16 @@ static int eth_bootdev_hunt(struct bootdev_hunter *info, bool show)
 	return ret;
 }
 
+/*
+ * Probing the network devices generally configures their PHYs, which starts
+ * autonegotiation. This takes a few seconds, so let it happen in the
+ * background, while other bootdevs are scanned.
+ */
+static int eth_bootdev_start(struct bootdev_hunter *info, bool show)
+{
+	return eth_bootdev_hunt(info, show);
+}
+
 struct bootdev_ops eth_bootdev_ops = {
 	.get_bootflow	= eth_get_bootflow,
 };
@@ -120,5 +130,6 @@ BOOTDEV_HUNTER(eth_bootdev_hunt) = {
 	.prio		= BOOTDEVP_6_NET_BASE,
 	.uclass		= UCLASS_ETH,
 	.hunt		= eth_bootdev_hunt,
+	.start		= eth_bootdev_start,
 	.drv		= DM_DRIVER_REF(eth_bootdev),
 };
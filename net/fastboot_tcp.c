@@ -3,10 +3,15 @@
  * Copyright (C) 2023 The Android Open Source Project
  */
 
+#include <display_options.h>
+#include <errno.h>
 #include <fastboot.h>
 #include <net.h>
+#include <time.h>
 #include <net/fastboot_tcp.h>
 #include <net/tcp.h>
+#include <linux/kernel.h>
+#include <linux/math64.h>
 
 #define FASTBOOT_TCP_PORT	5554
 
@@ -19,12 +24,236 @@ static char txbuf[sizeof(u64) + FASTBOOT_RESPONSE_LEN + 1];
 static u32 data_read;
 static u32 tx_last_offs, tx_last_len;
 
+/**
+ * struct fb_tcp_frame - Frame of download data
+ *
+ * The host sends the image of a download as one or more frames, each of
+ * them a big-endian u64 length followed by that much data.
+ *
+ * @offs: Stream offset of the data
+ * @len: Length of the data
+ * @pos: Offset of the data within the download
+ */
+struct fb_tcp_frame {
+	u32 offs;
+	u32 len;
+	u32 pos;
+};
+
+/*
+ * Download state. Segments are stored where they belong in the download
+ * buffer as they arrive, in any order, so that the receive window is not
+ * limited by a bounce buffer. The current frame and the one before it are
+ * tracked, a frame is only entered once everything up to its header has
+ * been received. A download that is flashed as it arrives is taken in
+ * order only.
+ */
+static bool dl_active;
+static bool dl_direct;
+static u32 dl_size, dl_done;
+static u32 dl_end;		/* stream offset after the download, or 0 */
+static ulong dl_time;
+static struct fb_tcp_frame dl_frame, dl_prev;
+static u8 dl_hdr[sizeof(u64)];
+static u8 dl_hdr_mask;
+static char dl_response[FASTBOOT_RESPONSE_LEN];
+
+static void tx_response(void)
+{
+	__be64	len_be;
+	int	len;
+
+	len = strlen(txbuf + sizeof(u64));
+	len_be = __cpu_to_be64(len);
+	memcpy(txbuf, &len_be, sizeof(u64));
+
+	tx_last_offs += tx_last_len;
+	tx_last_len = len + sizeof(u64);
+}
+
+static void dl_start(u32 offs)
+{
+	dl_active = true;
+	dl_size = fastboot_data_remaining();
+	dl_direct = fastboot_data_buffer(0, dl_size);
+	dl_done = 0;
+	dl_end = 0;
+	/* an empty frame ending where the first header starts */
+	dl_frame.offs = offs;
+	dl_frame.len = 0;
+	dl_frame.pos = 0;
+	dl_prev = dl_frame;
+	dl_hdr_mask = 0;
+	dl_time = get_timer(0);
+}
+
+static void dl_store(struct fb_tcp_frame *f, u32 offs, const u8 *buf, u32 len)
+{
+	u32 pos = f->pos + offs - f->offs;
+
+	if (dl_direct)
+		memcpy(fastboot_data_buffer(pos, len), buf, len);
+	else
+		fastboot_data_download(buf, len, dl_response);
+}
+
+/**
+ * dl_header() - Store bytes of the header of the next frame
+ *
+ * @idx: Index of the first byte in the header
+ * @buf: Header bytes
+ * @len: Number of bytes
+ *
+ * Once the header is complete, the next frame becomes the current one.
+ *
+ * Return: 0 if OK, -EINVAL if the frame does not fit the download
+ */
+static int dl_header(u32 idx, const u8 *buf, u32 len)
+{
+	u64 frame_len;
+	u32 pos;
+
+	memcpy(dl_hdr + idx, buf, len);
+	dl_hdr_mask |= GENMASK(idx + len - 1, idx);
+	if (dl_hdr_mask != GENMASK(sizeof(u64) - 1, 0))
+		return 0;
+
+	memcpy(&frame_len, dl_hdr, sizeof(u64));
+	frame_len = __be64_to_cpu(frame_len);
+	pos = dl_frame.pos + dl_frame.len;
+	if (!frame_len || frame_len > dl_size - pos) {
+		printf("fastboot: bad download frame\n");
+		return -EINVAL;
+	}
+
+	dl_prev = dl_frame;
+	dl_frame.offs += dl_frame.len + sizeof(u64);
+	dl_frame.len = frame_len;
+	dl_frame.pos = pos;
+	dl_hdr_mask = 0;
+	if (pos + frame_len == dl_size) {
+		/* the next command is stored in rxbuf again */
+		dl_end = dl_frame.offs + frame_len;
+		data_read = dl_end;
+	}
+
+	return 0;
+}
+
+static u32 cmd_rx(u32 offs, const u8 *buf, u32 len)
+{
+	u32 skip = 0, pos;
+
+	if (offs < data_read) {
+		skip = min(len, data_read - offs);
+		offs += skip;
+		buf += skip;
+		len -= skip;
+	}
+
+	pos = offs - data_read;
+	if (pos >= sizeof(rxbuf))
+		return skip;
+
+	len = min_t(u32, len, sizeof(rxbuf) - pos);
+	memcpy(rxbuf + pos, buf, len);
+
+	return skip + len;
+}
+
+static int dl_rx(struct tcp_stream *tcp, u32 offs, const u8 *buf, u32 len)
+{
+	u32 rcv_nxt = tcp_stream_rx_offs(tcp);
+	u32 done = 0, prev_end, end, o, n;
+
+	if (!dl_direct && offs > rcv_nxt)
+		return 0;
+
+	/* already received */
+	if (offs < rcv_nxt)
+		done = min(len, rcv_nxt - offs);
+
+	while (done < len) {
+		o = offs + done;
+		n = len - done;
+		prev_end = dl_prev.offs + dl_prev.len;
+		end = dl_frame.offs + dl_frame.len;
+
+		if (dl_end && o >= dl_end) {
+			done += cmd_rx(o, buf + done, n);
+			break;
+		} else if (o >= end + sizeof(u64)) {
+			/* the header before it is not complete */
+			break;
+		} else if (o >= end) {
+			/* the frame before the current one has holes */
+			if (rcv_nxt < prev_end)
+				break;
+			n = min_t(u32, n, end + sizeof(u64) - o);
+			if (dl_header(o - end, buf + done, n))
+				return -EINVAL;
+		} else if (o >= dl_frame.offs) {
+			n = min(n, end - o);
+			dl_store(&dl_frame, o, buf + done, n);
+		} else if (o >= prev_end) {
+			/* header of the current frame, it is complete */
+			n = min(n, dl_frame.offs - o);
+		} else if (o >= dl_prev.offs) {
+			n = min(n, prev_end - o);
+			dl_store(&dl_prev, o, buf + done, n);
+		} else {
+			break;
+		}
+		done += n;
+	}
+
+	return done;
+}
+
+static void dl_update(struct tcp_stream *tcp, u32 rx_bytes)
+{
+	ulong time;
+	u32 pos;
+
+	if (rx_bytes >= dl_frame.offs)
+		pos = dl_frame.pos + min(rx_bytes - dl_frame.offs, dl_frame.len);
+	else if (rx_bytes >= dl_prev.offs)
+		pos = dl_prev.pos + min(rx_bytes - dl_prev.offs, dl_prev.len);
+	else
+		pos = dl_prev.pos;
+	if (dl_direct && pos > dl_done)
+		fastboot_data_received(pos - dl_done);
+	dl_done = max(dl_done, pos);
+
+	if (!dl_end || rx_bytes < dl_end)
+		return;
+
+	dl_active = false;
+	fastboot_data_complete(txbuf + sizeof(u64));
+	tx_response();
+
+	time = get_timer(dl_time);
+	printf("%u bytes in %lu ms", dl_size, time);
+	if (time) {
+		puts(", ");
+		print_size(div_u64((u64)dl_size * 1000, time), "/s");
+	}
+	putc('\n');
+}
+
 static void tcp_stream_on_rcv_nxt_update(struct tcp_stream *tcp, u32 rx_bytes)
 {
 	u64	cmd_size;
-	__be64	len_be;
 	char	saved;
-	int	fastboot_command_id, len;
+	int	fastboot_command_id;
+	bool	download;
+
+	if (dl_active) {
+		dl_update(tcp, rx_bytes);
+		if (dl_active)
+			return;
+	}
+	rx_bytes -= data_read;
 
 	if (!data_read && rx_bytes >= handshake_length) {
 		if (memcmp(rxbuf, handshake, handshake_length)) {
@@ -49,6 +278,11 @@ static void tcp_stream_on_rcv_nxt_update(struct tcp_stream *tcp, u32 rx_bytes)
 
 	memcpy(&cmd_size, rxbuf, sizeof(u64));
 	cmd_size = __be64_to_cpu(cmd_size);
+	if (cmd_size > FASTBOOT_COMMAND_LEN) {
+		printf("fastboot: command too long\n");
+		tcp_stream_close(tcp);
+		return;
+	}
 	if (rx_bytes < sizeof(u64) + cmd_size)
 		return;
 
@@ -59,25 +293,33 @@ static void tcp_stream_on_rcv_nxt_update(struct tcp_stream *tcp, u32 rx_bytes)
 	fastboot_handle_boot(fastboot_command_id,
 			     strncmp("OKAY", txbuf + sizeof(u64), 4) != 0);
 	rxbuf[sizeof(u64) + cmd_size] = saved;
+	download = fastboot_command_id == FASTBOOT_COMMAND_DOWNLOAD &&
+		   !strncmp("DATA", txbuf + sizeof(u64), 4);
 
-	len = strlen(txbuf + sizeof(u64));
-	len_be = __cpu_to_be64(len);
-	memcpy(txbuf, &len_be, sizeof(u64));
-
-	tx_last_offs += tx_last_len;
-	tx_last_len = len + sizeof(u64);
+	tx_response();
 
 	data_read += sizeof(u64) + cmd_size;
 	rx_bytes -= sizeof(u64) + cmd_size;
 	if (rx_bytes > 0)
 		memmove(rxbuf, rxbuf + sizeof(u64) + cmd_size, rx_bytes);
+
+	if (download) {
+		/* the host waits for the DATA response before sending data */
+		if (rx_bytes > 0) {
+			printf("fastboot: data before DATA response\n");
+			tcp_stream_close(tcp);
+			return;
+		}
+		dl_start(data_read);
+	}
 }
 
 static int tcp_stream_rx(struct tcp_stream *tcp, u32 rx_offs, void *buf, int len)
 {
-	memcpy(rxbuf + rx_offs - data_read, buf, len);
+	if (dl_active)
+		return dl_rx(tcp, rx_offs, buf, len);
 
-	return len;
+	return cmd_rx(rx_offs, buf, len);
 }
 
 static int tcp_stream_tx(struct tcp_stream *tcp, u32 tx_offs, void *buf, int maxlen)
@@ -100,6 +342,7 @@ static int tcp_stream_on_create(struct tcp_stream *tcp)
 	data_read = 0;
 	tx_last_offs = 0;
 	tx_last_len = 0;
+	dl_active = false;
 
 	tcp->on_rcv_nxt_update = tcp_stream_on_rcv_nxt_update;
 	tcp->rx = tcp_stream_rx;
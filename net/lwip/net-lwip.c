@@ -12,6 +12,8 @@
 #include <lwip/etharp.h>
 #include <lwip/init.h>
 #include <lwip/prot/etharp.h>
+#include <lwip/priv/tcp_priv.h>
+#include <malloc.h>
 #include <net.h>
 
 /* xx:xx:xx:xx:xx:xx\0 */
@@ -243,6 +245,85 @@ static struct pbuf *alloc_pbuf_and_copy(uchar *data, int len)
 	return p;
 }
 
+#ifdef CONFIG_LWIP_RX_ZERO_COPY
+/**
+ * struct rx_pbuf - pbuf lent to lwIP on top of a driver receive buffer
+ *
+ * @pc: The pbuf, whose payload is the driver buffer while lwIP handles it
+ * @frame: Room for a copy of the frame, used only if lwIP keeps the pbuf
+ */
+struct rx_pbuf {
+	struct pbuf_custom pc;
+	u8 frame[];
+};
+
+static void rx_pbuf_free(struct pbuf *p)
+{
+	free(p);
+}
+
+/*
+ * lwIP kept the pbuf (an out-of-order TCP segment, data not taken yet by
+ * the application...), but the driver will reuse its buffer once we give
+ * it back. Move the frame to the copy and let everything that points into
+ * it follow: the payload and the TCP header of out-of-order segments.
+ */
+static void rx_pbuf_keep(struct rx_pbuf *rp, uchar *packet, int len)
+{
+	struct pbuf *p = &rp->pc.pbuf;
+	ptrdiff_t off = (u8 *)rp->frame - packet;
+#if LWIP_TCP && TCP_QUEUE_OOSEQ
+	struct tcp_pcb *pcb;
+	struct tcp_seg *seg;
+#endif
+
+	memcpy(rp->frame, packet, len);
+	p->payload = (u8 *)p->payload + off;
+#if LWIP_TCP && TCP_QUEUE_OOSEQ
+	for (pcb = tcp_active_pcbs; pcb; pcb = pcb->next) {
+		for (seg = pcb->ooseq; seg; seg = seg->next) {
+			if (seg->p == p)
+				seg->tcphdr = (void *)((u8 *)seg->tcphdr + off);
+		}
+	}
+#endif
+}
+
+/*
+ * Hand a frame to lwIP without copying it. Most frames are done with when
+ * the input function returns, as the TCP data is passed on to the
+ * application which copies it where it belongs. Only the others are
+ * copied.
+ */
+static bool rx_input(struct netif *netif, uchar *packet, int len)
+{
+	struct rx_pbuf *rp;
+	struct pbuf *p;
+
+	rp = malloc(sizeof(*rp) + len);
+	if (!rp)
+		return false;
+
+	rp->pc.custom_free_function = rx_pbuf_free;
+	p = pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &rp->pc, packet, len);
+	LINK_STATS_INC(link.recv);
+
+	/* Hold a reference so that we can tell whether lwIP kept one */
+	pbuf_ref(p);
+	netif->input(p, netif);
+	if (p->ref > 1)
+		rx_pbuf_keep(rp, packet, len);
+	pbuf_free(p);
+
+	return true;
+}
+#else
+static bool rx_input(struct netif *netif, uchar *packet, int len)
+{
+	return false;
+}
+#endif
+
 int net_lwip_rx(struct udevice *udev, struct netif *netif)
 {
 	struct pbuf *pbuf;
@@ -259,7 +340,7 @@ int net_lwip_rx(struct udevice *udev, struct netif *netif)
 		len = eth_get_ops(udev)->recv(udev, flags, &packet);
 		flags = 0;
 
-		if (len > 0) {
+		if (len > 0 && !rx_input(netif, packet, len)) {
 			pbuf = alloc_pbuf_and_copy(packet, len);
 			if (pbuf)
 				netif->input(pbuf, netif);
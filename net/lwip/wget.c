@@ -36,8 +36,73 @@ struct wget_ctx {
 	ulong prevsize;
 	ulong start_time;
 	enum done_state done;
+	bool is_https;
 };
 
+#if defined CONFIG_WGET_HTTPS
+/**
+ * struct wget_tls - TLS state kept from one request to the next
+ *
+ * Fetching a kernel, initrd and device tree makes several requests to the
+ * same server. The first one saves its session, so that the others can
+ * resume it with an abbreviated handshake, without the key exchange and
+ * certificate checks. The configuration is reused as well, which avoids
+ * setting it up and seeding the random-number generator each time.
+ *
+ * @conf: TLS configuration for @server_name
+ * @server_name: Server which @conf and @session are for
+ * @session: Session to resume, if @have_session
+ * @have_session: true if @session holds a session from @server_name
+ */
+static struct wget_tls {
+	struct altcp_tls_config *conf;
+	char server_name[SERVER_NAME_SIZE];
+	struct altcp_tls_session session;
+	bool have_session;
+} wget_tls;
+
+static struct altcp_tls_config *wget_tls_get_config(const char *server_name)
+{
+	if (wget_tls.conf && !strcmp(wget_tls.server_name, server_name))
+		return wget_tls.conf;
+
+	/*
+	 * The old configuration is not freed, since a connection which was
+	 * interrupted with Ctrl-C may still refer to it
+	 */
+	if (wget_tls.have_session)
+		altcp_tls_free_session(&wget_tls.session);
+	wget_tls.have_session = false;
+	altcp_tls_init_session(&wget_tls.session);
+	strlcpy(wget_tls.server_name, server_name,
+		sizeof(wget_tls.server_name));
+	wget_tls.conf = altcp_tls_create_config_client(NULL, 0,
+						       wget_tls.server_name);
+
+	return wget_tls.conf;
+}
+
+/* Create a TLS connection, resuming the last session if there is one */
+static struct altcp_pcb *wget_tls_alloc(void *arg, u8_t ip_type)
+{
+	struct altcp_pcb *pcb;
+
+	pcb = altcp_tls_alloc(arg, ip_type);
+	if (pcb && wget_tls.have_session &&
+	    altcp_tls_set_session(pcb, &wget_tls.session) != ERR_OK)
+		log_debug("Cannot resume TLS session\n");
+
+	return pcb;
+}
+
+/* Save the session once the handshake is done, i.e. data has arrived */
+static void wget_tls_save_session(struct altcp_pcb *pcb)
+{
+	wget_tls.have_session =
+		altcp_tls_get_session(pcb, &wget_tls.session) == ERR_OK;
+}
+#endif
+
 static void wget_lwip_fill_info(struct pbuf *hdr, u16_t hdr_len, u32_t hdr_cont_len)
 {
 	if (wget_info->headers) {
@@ -210,8 +275,13 @@ static err_t httpc_recv_cb(void *arg, struct altcp_pcb *pcb, struct pbuf *pbuf,
 	if (!pbuf)
 		return ERR_BUF;
 
-	if (!ctx->start_time)
+	if (!ctx->start_time) {
 		ctx->start_time = get_timer(0);
+#if defined CONFIG_WGET_HTTPS
+		if (ctx->is_https)
+			wget_tls_save_session(pcb);
+#endif
+	}
 
 	for (buf = pbuf; buf; buf = buf->next) {
 		memcpy((void *)ctx->daddr, buf->payload, buf->len);
@@ -295,7 +365,6 @@ static int wget_loop(struct udevice *udev, ulong dst_addr, char *uri)
 	struct netif *netif;
 	struct wget_ctx ctx;
 	char *path;
-	bool is_https;
 
 	ctx.daddr = dst_addr;
 	ctx.saved_daddr = dst_addr;
@@ -304,7 +373,7 @@ static int wget_loop(struct udevice *udev, ulong dst_addr, char *uri)
 	ctx.prevsize = 0;
 	ctx.start_time = 0;
 
-	if (parse_url(uri, ctx.server_name, &ctx.port, &path, &is_https))
+	if (parse_url(uri, ctx.server_name, &ctx.port, &path, &ctx.is_https))
 		return CMD_RET_USAGE;
 
 	netif = net_lwip_new_netif(udev);
@@ -313,10 +382,9 @@ static int wget_loop(struct udevice *udev, ulong dst_addr, char *uri)
 
 	memset(&conn, 0, sizeof(conn));
 #if defined CONFIG_WGET_HTTPS
-	if (is_https) {
-		tls_allocator.alloc = &altcp_tls_alloc;
-		tls_allocator.arg =
-			altcp_tls_create_config_client(NULL, 0, ctx.server_name);
+	if (ctx.is_https) {
+		tls_allocator.alloc = &wget_tls_alloc;
+		tls_allocator.arg = wget_tls_get_config(ctx.server_name);
 
 		if (!tls_allocator.arg) {
 			log_err("error: Cannot create a TLS connection\n");
@@ -13,6 +13,7 @@
 #include <net6.h>
 #include <ndisc.h>
 #include <stdlib.h>
+#include <time.h>
 #include <linux/delay.h>
 
 /* IPv6 destination address of packet waiting for ND */
@@ -40,6 +41,102 @@ struct in6_addr all_routers = ALL_ROUTERS_MULT_ADDR;
 
 #define IP6_NDISC_OPT_SPACE(len) (((len) + 2 + 7) & ~7)
 
+enum {
+	NDISC_CACHE_SIZE	= 8,
+	NDISC_CACHE_TIMEOUT	= 60 * 1000,	/* ms */
+};
+
+/**
+ * struct ndisc_cache_ent - an address found by neighbour discovery
+ *
+ * @ip6: IPv6 address, or unspecified if this entry is not used
+ * @ethaddr: Ethernet address of @ip6
+ * @time: get_timer() value when the entry was added
+ */
+struct ndisc_cache_ent {
+	struct in6_addr ip6;
+	uchar ethaddr[6];
+	ulong time;
+};
+
+static struct ndisc_cache_ent ndisc_cache[NDISC_CACHE_SIZE];
+/* our addresses when the cache was filled */
+static struct in6_addr ndisc_cache_our_ip6;
+static uchar ndisc_cache_our_ethaddr[6];
+
+/* Drop the cache if it was filled on another interface or subnet */
+static void ndisc_cache_check(void)
+{
+	if (!memcmp(&ndisc_cache_our_ip6, &net_ip6, sizeof(net_ip6)) &&
+	    !memcmp(ndisc_cache_our_ethaddr, net_ethaddr, 6))
+		return;
+
+	memset(ndisc_cache, '\0', sizeof(ndisc_cache));
+	net_copy_ip6(&ndisc_cache_our_ip6, &net_ip6);
+	memcpy(ndisc_cache_our_ethaddr, net_ethaddr, 6);
+}
+
+static void ndisc_cache_add(struct in6_addr *ip6, const uchar *ethaddr)
+{
+	struct ndisc_cache_ent *ent, *oldest = ndisc_cache;
+	int i;
+
+	if (!IS_ENABLED(CONFIG_NET_ARP_CACHE) || ip6_is_unspecified_addr(ip6))
+		return;
+
+	ndisc_cache_check();
+	for (i = 0; i < NDISC_CACHE_SIZE; i++) {
+		ent = &ndisc_cache[i];
+		if (!memcmp(&ent->ip6, ip6, sizeof(*ip6)) ||
+		    ip6_is_unspecified_addr(&ent->ip6)) {
+			oldest = ent;
+			break;
+		}
+		if (time_before(ent->time, oldest->time))
+			oldest = ent;
+	}
+	net_copy_ip6(&oldest->ip6, ip6);
+	memcpy(oldest->ethaddr, ethaddr, 6);
+	oldest->time = get_timer(0);
+}
+
+/* Get the address which must be resolved to send a packet to @dest */
+static struct in6_addr *ndisc_next_hop(struct in6_addr *dest)
+{
+	if (!ip6_addr_in_subnet(&net_ip6, dest, net_prefix_length) &&
+	    !ip6_is_unspecified_addr(&net_gateway6))
+		return &net_gateway6;
+
+	return dest;
+}
+
+bool ndisc_cache_lookup(struct in6_addr *dest, uchar *ethaddr)
+{
+	struct in6_addr *ip6 = ndisc_next_hop(dest);
+	int i;
+
+	if (!IS_ENABLED(CONFIG_NET_ARP_CACHE))
+		return false;
+
+	ndisc_cache_check();
+	for (i = 0; i < NDISC_CACHE_SIZE; i++) {
+		struct ndisc_cache_ent *ent = &ndisc_cache[i];
+
+		if (ip6_is_unspecified_addr(&ent->ip6) ||
+		    memcmp(&ent->ip6, ip6, sizeof(*ip6)))
+			continue;
+		if (get_timer(ent->time) > NDISC_CACHE_TIMEOUT) {
+			ent->ip6 = net_null_addr_ip6;
+			return false;
+		}
+		memcpy(ethaddr, ent->ethaddr, 6);
+
+		return true;
+	}
+
+	return false;
+}
+
 /**
  * ndisc_insert_option() - Insert an option into a neighbor discovery packet
  *
@@ -261,16 +358,11 @@ ip6_send_na(uchar *eth_dst_addr, struct in6_addr *neigh_addr,
 void ndisc_request(void)
 {
 	if (!ip6_addr_in_subnet(&net_ip6, &net_nd_sol_packet_ip6,
-				net_prefix_length)) {
-		if (ip6_is_unspecified_addr(&net_gateway6)) {
-			puts("## Warning: gatewayip6 is needed but not set\n");
-			net_nd_rep_packet_ip6 = net_nd_sol_packet_ip6;
-		} else {
-			net_nd_rep_packet_ip6 = net_gateway6;
-		}
-	} else {
-		net_nd_rep_packet_ip6 = net_nd_sol_packet_ip6;
-	}
+				net_prefix_length) &&
+	    ip6_is_unspecified_addr(&net_gateway6))
+		puts("## Warning: gatewayip6 is needed but not set\n");
+	net_copy_ip6(&net_nd_rep_packet_ip6,
+		     ndisc_next_hop(&net_nd_sol_packet_ip6));
 
 	ip6_send_ns(&net_nd_rep_packet_ip6);
 }
@@ -444,6 +536,7 @@ int ndisc_receive(struct ethernet_hdr *et, struct ip6_hdr *ip6, int len)
 		if (ip6_is_our_addr(&ndisc->target) &&
 		    ndisc_has_option(ip6, ND_OPT_SOURCE_LL_ADDR)) {
 			ndisc_extract_enetaddr(ndisc, neigh_eth_addr);
+			ndisc_cache_add(&ip6->saddr, neigh_eth_addr);
 			ip6_send_na(neigh_eth_addr, &ip6->saddr,
 				    &ndisc->target);
 		}
@@ -458,6 +551,7 @@ int ndisc_receive(struct ethernet_hdr *et, struct ip6_hdr *ip6, int len)
 			    sizeof(struct in6_addr)) == 0) &&
 		    ndisc_has_option(ip6, ND_OPT_TARGET_LL_ADDR)) {
 			ndisc_extract_enetaddr(ndisc, neigh_eth_addr);
+			ndisc_cache_add(&ndisc->target, neigh_eth_addr);
 
 			/* save address for later use */
 			if (net_nd_packet_mac)
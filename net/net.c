@@ -152,6 +152,10 @@ u8 net_server_ethaddr[6];
 struct in_addr	net_ip;
 /* Server IP addr (0 = unknown) */
 struct in_addr	net_server_ip;
+#ifdef CONFIG_CMD_MTFTPBOOT
+/* Multicast group we have joined (0 = none) */
+struct in_addr	net_mcast_addr;
+#endif
 /* Current receive packet */
 uchar *net_rx_packet;
 /* Current rx packet length */
@@ -507,6 +511,9 @@ restart:
 		case TFTPGET:
 #ifdef CONFIG_CMD_TFTPPUT
 		case TFTPPUT:
+#endif
+#ifdef CONFIG_CMD_MTFTPBOOT
+		case MTFTPGET:
 #endif
 			/* always use ARP to get server ethernet address */
 			tftp_start(protocol);
@@ -946,6 +953,10 @@ int net_send_ip_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 	if (dest.s_addr == 0xFFFFFFFF)
 		ether = (uchar *)net_bcast_ethaddr;
 
+	/* an earlier command may have found the address already */
+	if (!memcmp(ether, net_null_ethaddr, ARP_HLEN))
+		arp_cache_lookup(dest, ether);
+
 	pkt = (uchar *)net_tx_packet;
 
 	eth_hdr_size = net_set_ether(pkt, ether, PROT_IP);
@@ -1358,14 +1369,24 @@ void net_process_received_packet(uchar *in_packet, int len)
 		if ((ip->ip_hl_v & 0x0f) != 0x05)
 			return;
 		/* Check the Checksum of the header */
-		if (!ip_checksum_ok((uchar *)ip, IP_HDR_SIZE)) {
+		if (!net_rx_csum_ok &&
+		    !ip_checksum_ok((uchar *)ip, IP_HDR_SIZE)) {
 			debug("checksum bad\n");
 			return;
 		}
+#if CONFIG_IS_ENABLED(ETH_RX_CSUM_OFFLOAD)
+		/* The controller checks fragments, not the datagram */
+		if (ip->ip_off & htons(IP_OFFS | IP_FLAGS_MFRAG))
+			net_rx_csum_ok = false;
+#endif
 		/* If it is not for us, ignore it */
 		dst_ip = net_read_ip(&ip->ip_dst);
 		if (net_ip.s_addr && dst_ip.s_addr != net_ip.s_addr &&
 		    dst_ip.s_addr != 0xFFFFFFFF) {
+#ifdef CONFIG_CMD_MTFTPBOOT
+			if (!net_mcast_addr.s_addr ||
+			    dst_ip.s_addr != net_mcast_addr.s_addr)
+#endif
 				return;
 		}
 		/* Read source IP address for later use */
@@ -1422,7 +1443,8 @@ void net_process_received_packet(uchar *in_packet, int len)
 			   "received UDP (to=%pI4, from=%pI4, len=%d)\n",
 			   &dst_ip, &src_ip, len);
 
-		if (IS_ENABLED(CONFIG_UDP_CHECKSUM) && ip->udp_xsum != 0) {
+		if (IS_ENABLED(CONFIG_UDP_CHECKSUM) && ip->udp_xsum != 0 &&
+		    !net_rx_csum_ok) {
 			ulong   xsum;
 			u8 *sumptr;
 			ushort  sumlen;
@@ -1528,6 +1550,9 @@ static int net_check_prereq(enum proto_t protocol)
 		/* Fall through */
 	case TFTPGET:
 	case TFTPPUT:
+#ifdef CONFIG_CMD_MTFTPBOOT
+	case MTFTPGET:
+#endif
 		if (IS_ENABLED(CONFIG_IPV6) && use_ip6) {
 			if (!memcmp(&net_server_ip6, &net_null_addr_ip6,
 				    sizeof(struct in6_addr)) &&
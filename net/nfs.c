@@ -52,10 +52,29 @@
 
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
 static const ulong nfs_timeout = CONFIG_NFS_TIMEOUT;
 
+/**
+ * struct nfs_read - READ request in flight
+ *
+ * @id: RPC transaction ID of the request
+ * @offset: Offset of the data asked for
+ * @len: Number of bytes asked for, 0 if the slot is free
+ * @sent: Time the request was sent, see get_timer()
+ */
+struct nfs_read {
+	ulong id;
+	uint offset;
+	uint len;
+	ulong sent;
+};
+
+static struct nfs_read nfs_reads[CONFIG_NFS_READ_WINDOW];
+/* Offset of the next READ to send */
+static uint nfs_offset;
+/* End of the file, UINT_MAX until a READ reached it */
+static uint nfs_read_end;
+
 static char dirfh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle of directory */
 static unsigned int dirfh3_length; /* (variable) length of dirfh when NFSv3 */
 static char filefh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle */
@@ -425,6 +444,52 @@ static void nfs_read_req(int offset, int readlen)
 	rpc_req(PROG_NFS, NFS_READ, data, len);
 }
 
+static void nfs_read_send(struct nfs_read *rd)
+{
+	nfs_read_req(rd->offset, rd->len);
+	rd->id = rpc_id;
+	rd->sent = get_timer(0);
+}
+
+static void nfs_read_start(void)
+{
+	memset(nfs_reads, '\0', sizeof(nfs_reads));
+	nfs_offset = 0;
+	nfs_read_end = UINT_MAX;
+}
+
+/**
+ * nfs_read_fill() - Keep the READ window full
+ *
+ * This sends a new request for every free slot, until the end of the file,
+ * and sends again the requests that have not been answered in time.
+ *
+ * @resend_all: Send again every request in flight, as the timer ran out
+ * Return: number of requests in flight
+ */
+static int nfs_read_fill(bool resend_all)
+{
+	struct nfs_read *rd;
+	int count = 0;
+
+	for (rd = nfs_reads; rd < nfs_reads + ARRAY_SIZE(nfs_reads); rd++) {
+		if (rd->len) {
+			if (resend_all || get_timer(rd->sent) >= nfs_timeout)
+				nfs_read_send(rd);
+		} else if (nfs_offset < nfs_read_end) {
+			rd->offset = nfs_offset;
+			rd->len = NFS_READ_SIZE;
+			nfs_offset += NFS_READ_SIZE;
+			nfs_read_send(rd);
+		} else {
+			continue;
+		}
+		count++;
+	}
+
+	return count;
+}
+
 /**************************************************************************
 RPC request dispatcher
 **************************************************************************/
@@ -455,7 +520,7 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_fill(true);
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -714,6 +779,8 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 static int nfs_read_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
+	struct nfs_read *rd;
+	bool eof = false;
 	int rlen;
 	uchar *data_ptr;
 
@@ -721,9 +788,12 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 
 	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
-		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+	/* Replies to requests sent again or already answered are dropped */
+	for (rd = nfs_reads; rd < nfs_reads + ARRAY_SIZE(nfs_reads); rd++) {
+		if (rd->len && rd->id == ntohl(rpc_pkt.u.reply.id))
+			break;
+	}
+	if (rd == nfs_reads + ARRAY_SIZE(nfs_reads))
 		return -NFS_RPC_DROP;
 
 	if (rpc_pkt.u.reply.rstatus  ||
@@ -737,10 +807,10 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
+	if ((rd->offset != 0) && !((rd->offset) %
 			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
 		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
+	if (!(rd->offset % ((NFS_READ_SIZE / 2) * 10)))
 		putc('#');
 
 	if (choosen_nfs_version != NFS_V3) {
@@ -752,6 +822,7 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 
 		/* count value */
 		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
+		eof = !!rpc_pkt.u.reply.data[2 + nfsv3_data_offset];
 		/* Skip unused values :
 			EOF:		32 bits value,
 			data_size:	32 bits value,
@@ -763,9 +834,24 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 	if (((uchar *)&(rpc_pkt.u.reply.data[0]) - (uchar *)(&rpc_pkt) + rlen) > len)
 			return -9999;
 
-	if (store_block(data_ptr, nfs_offset, rlen))
+	if (rlen > rd->len)
+		return -9999;
+
+	if (store_block(data_ptr, rd->offset, rlen))
 			return -9999;
 
+	if (!rlen || eof) {
+		nfs_read_end = min(nfs_read_end, rd->offset + rlen);
+		rd->len = 0;
+	} else if (rlen < rd->len) {
+		/* A short read without EOF, ask for the rest */
+		rd->offset += rlen;
+		rd->len -= rlen;
+		nfs_read_send(rd);
+	} else {
+		rd->len = 0;
+	}
+
 	return rlen;
 }
 
@@ -865,8 +951,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			nfs_send();
 		} else {
 			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
+			nfs_read_start();
 			nfs_send();
 		}
 		break;
@@ -894,15 +979,15 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (rlen == -NFS_RPC_DROP)
 			break;
 		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
-			nfs_send();
-		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
+		/* Carry on until nothing is left in flight past the end */
+		if (rlen >= 0 && nfs_read_fill(false))
+			break;
+		if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
 			nfs_state = STATE_READLINK_REQ;
 			nfs_send();
 		} else {
-			if (!rlen)
+			if (rlen >= 0)
 				nfs_download_state = NETLOOP_SUCCESS;
 			if (rlen < 0)
 				debug("NFS READ error (%d)\n", rlen);
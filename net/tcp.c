@@ -36,16 +36,14 @@
 #define TCP_SEND_RETRY		3
 #define TCP_SEND_TIMEOUT	2000UL
 #define TCP_RX_INACTIVE_TIMEOUT	30000UL
-#if PKTBUFSRX != 0
-  #define TCP_RCV_WND_SIZE	(PKTBUFSRX * TCP_MSS)
-#else
-  #define TCP_RCV_WND_SIZE	(4 * TCP_MSS)
-#endif
+#define TCP_RCV_WND_SIZE	CONFIG_PROT_TCP_RCV_WND
+#define TCP_RCV_WND_MIN		(4 * TCP_MSS)
+#define TCP_WND_UNSCALED	0xffff
 
 #define TCP_PACKET_OK		0
 #define TCP_PACKET_DROP		1
 
-static struct tcp_stream tcp_stream;
+static struct tcp_stream tcp_streams[CONFIG_PROT_TCP_STREAMS];
 
 static int (*tcp_stream_on_create)(struct tcp_stream *tcp);
 
@@ -146,6 +144,37 @@ void tcp_stream_restart_rx_timer(struct tcp_stream *tcp)
 	tcp->time_last_rx = get_timer(0);
 }
 
+void tcp_stream_set_rcv_wnd(struct tcp_stream *tcp, u32 size)
+{
+	tcp->rcv_wnd = clamp_t(u32, size, TCP_RCV_WND_MIN, TCP_RCV_WND_SIZE);
+	if (tcp->state != TCP_CLOSED) {
+		/* too late to change the scale the peer was told */
+		tcp->rcv_wnd = min(tcp->rcv_wnd,
+				   (u32)TCP_WND_UNSCALED << tcp->loc_win_scale);
+		return;
+	}
+
+	tcp->loc_win_scale = 0;
+	while ((tcp->rcv_wnd >> tcp->loc_win_scale) > TCP_WND_UNSCALED)
+		tcp->loc_win_scale++;
+}
+
+/*
+ * Windows are only scaled when both sides sent the window scale option in
+ * their SYN, @rmt_scale is the one of the peer or -1 if it sent none.
+ */
+static void tcp_stream_set_win_scale(struct tcp_stream *tcp, int rmt_scale)
+{
+	if (rmt_scale < 0) {
+		tcp->loc_win_scale = 0;
+		tcp->rmt_win_scale = 0;
+		tcp->rcv_wnd = min_t(u32, tcp->rcv_wnd, TCP_WND_UNSCALED);
+		return;
+	}
+
+	tcp->rmt_win_scale = min(rmt_scale, TCP_SCALE_MAX);
+}
+
 static void tcp_stream_init(struct tcp_stream *tcp,
 			    struct in_addr rhost, u16 rport, u16 lport)
 {
@@ -155,34 +184,43 @@ static void tcp_stream_init(struct tcp_stream *tcp,
 	tcp->lport = lport;
 	tcp->state = TCP_CLOSED;
 	tcp->lost.len = TCP_OPT_LEN_2;
-	tcp->rcv_wnd = TCP_RCV_WND_SIZE;
+	tcp_stream_set_rcv_wnd(tcp, TCP_RCV_WND_SIZE);
 	tcp->max_retry_count = TCP_SEND_RETRY;
 	tcp->initial_timeout = TCP_SEND_TIMEOUT;
 	tcp->rx_inactiv_timeout = TCP_RX_INACTIVE_TIMEOUT;
 	tcp_stream_restart_rx_timer(tcp);
 }
 
+/*
+ * The stream slot is released before on_closed() runs, on a copy of the
+ * stream, so that the callback is free to open a new stream
+ */
 static void tcp_stream_destroy(struct tcp_stream *tcp)
 {
-	if (tcp->on_closed)
-		tcp->on_closed(tcp);
+	struct tcp_stream old = *tcp;
+
 	memset(tcp, 0, sizeof(struct tcp_stream));
+	if (old.on_closed)
+		old.on_closed(&old);
 }
 
 void tcp_init(void)
 {
 	static int initialized;
-	struct tcp_stream *tcp = &tcp_stream;
+	struct tcp_stream *tcp;
 
 	tcp_stream_on_create = NULL;
 	if (!initialized) {
 		initialized = 1;
-		memset(tcp, 0, sizeof(struct tcp_stream));
+		memset(tcp_streams, 0, sizeof(tcp_streams));
 	}
 
-	tcp_stream_set_state(tcp, TCP_CLOSED);
-	tcp_stream_set_status(tcp, TCP_ERR_RST);
-	tcp_stream_destroy(tcp);
+	for (tcp = tcp_streams; tcp < tcp_streams + CONFIG_PROT_TCP_STREAMS;
+	     tcp++) {
+		tcp_stream_set_state(tcp, TCP_CLOSED);
+		tcp_stream_set_status(tcp, TCP_ERR_RST);
+		tcp_stream_destroy(tcp);
+	}
 }
 
 void tcp_stream_set_on_create_handler(int (*on_create)(struct tcp_stream *))
@@ -193,27 +231,51 @@ void tcp_stream_set_on_create_handler(int (*on_create)(struct tcp_stream *))
 static struct tcp_stream *tcp_stream_add(struct in_addr rhost,
 					 u16 rport, u16 lport)
 {
-	struct tcp_stream *tcp = &tcp_stream;
+	struct tcp_stream *tcp;
 
-	if (!tcp_stream_on_create ||
-	    tcp->state != TCP_CLOSED)
+	if (!tcp_stream_on_create)
 		return NULL;
 
-	tcp_stream_init(tcp, rhost, rport, lport);
-	if (!tcp_stream_on_create(tcp))
-		return NULL;
+	for (tcp = tcp_streams; tcp < tcp_streams + CONFIG_PROT_TCP_STREAMS;
+	     tcp++) {
+		if (tcp->state != TCP_CLOSED)
+			continue;
 
-	return tcp;
+		tcp_stream_init(tcp, rhost, rport, lport);
+		if (!tcp_stream_on_create(tcp)) {
+			memset(tcp, 0, sizeof(struct tcp_stream));
+			return NULL;
+		}
+
+		return tcp;
+	}
+
+	return NULL;
+}
+
+static struct tcp_stream *tcp_stream_find(struct in_addr rhost, u16 rport,
+					  u16 lport)
+{
+	struct tcp_stream *tcp;
+
+	for (tcp = tcp_streams; tcp < tcp_streams + CONFIG_PROT_TCP_STREAMS;
+	     tcp++) {
+		if (tcp->rhost.s_addr == rhost.s_addr &&
+		    tcp->rport == rport &&
+		    tcp->lport == lport)
+			return tcp;
+	}
+
+	return NULL;
 }
 
 struct tcp_stream *tcp_stream_get(int is_new, struct in_addr rhost,
 				  u16 rport, u16 lport)
 {
-	struct tcp_stream *tcp = &tcp_stream;
+	struct tcp_stream *tcp;
 
-	if (tcp->rhost.s_addr == rhost.s_addr &&
-	    tcp->rport == rport &&
-	    tcp->lport == lport)
+	tcp = tcp_stream_find(rhost, rport, lport);
+	if (tcp)
 		return tcp;
 
 	return is_new ? tcp_stream_add(rhost, rport, lport) : NULL;
@@ -434,8 +496,9 @@ void tcp_streams_poll(void)
 	struct tcp_stream	*tcp;
 
 	time = get_timer(0);
-	tcp = &tcp_stream;
-	tcp_stream_poll(tcp, time);
+	for (tcp = tcp_streams; tcp < tcp_streams + CONFIG_PROT_TCP_STREAMS;
+	     tcp++)
+		tcp_stream_poll(tcp, time);
 }
 
 /**
@@ -549,7 +612,7 @@ void net_set_syn_options(struct tcp_stream *tcp, union tcp_build_pkt *b)
 	b->ip.mss.len = TCP_OPT_LEN_4;
 	b->ip.mss.mss = htons(TCP_MSS);
 	b->ip.scale.kind = TCP_O_SCL;
-	b->ip.scale.scale = TCP_SCALE;
+	b->ip.scale.scale = tcp->loc_win_scale;
 	b->ip.scale.len = TCP_OPT_LEN_3;
 	if (IS_ENABLED(CONFIG_PROT_TCP_SACK)) {
 		b->ip.sack_p.kind = TCP_P_SACK;
@@ -655,8 +718,13 @@ int tcp_set_tcp_header(struct tcp_stream *tcp, uchar *pkt, int payload_len,
 	 * SOCs is may not be considered a constraint to buffer space, if
 	 * it is, then the u-boot tftp or nfs kernel netboot should be
 	 * considered.
+	 * The window in a SYN segment is never scaled (RFC 7323).
 	 */
-	b->ip.hdr.tcp_win = htons(tcp->rcv_wnd >> TCP_SCALE);
+	if (action & TCP_SYN)
+		b->ip.hdr.tcp_win = htons(min_t(u32, tcp->rcv_wnd,
+						TCP_WND_UNSCALED));
+	else
+		b->ip.hdr.tcp_win = htons(tcp->rcv_wnd >> tcp->loc_win_scale);
 
 	b->ip.hdr.tcp_xsum = 0;
 	b->ip.hdr.tcp_ugr = 0;
@@ -771,11 +839,14 @@ void tcp_hole(struct tcp_stream *tcp, u32 tcp_seq_num, u32 len)
  * @tcp: tcp stream
  * @o: pointer to the option field.
  * @o_len: length of the option field.
+ *
+ * Return: window scale sent by the peer, or -1 if there was none
  */
-void tcp_parse_options(struct tcp_stream *tcp, uchar *o, int o_len)
+int tcp_parse_options(struct tcp_stream *tcp, uchar *o, int o_len)
 {
 	struct tcp_t_opt  *tsopt;
 	struct tcp_scale  *wsopt;
+	int scale = -1;
 	uchar *p = o;
 
 	/*
@@ -784,18 +855,18 @@ void tcp_parse_options(struct tcp_stream *tcp, uchar *o, int o_len)
 	 */
 	for (p = o; p < (o + o_len); ) {
 		if (!p[1])
-			return; /* Finished processing options */
+			return scale; /* Finished processing options */
 
 		switch (p[0]) {
 		case TCP_O_END:
-			return;
+			return scale;
 		case TCP_O_MSS:
 		case TCP_P_SACK:
 		case TCP_V_SACK:
 			break;
 		case TCP_O_SCL:
 			wsopt = (struct tcp_scale *)p;
-			tcp->rmt_win_scale = wsopt->scale;
+			scale = wsopt->scale;
 			break;
 		case TCP_O_TS:
 			tsopt = (struct tcp_t_opt *)p;
@@ -809,6 +880,8 @@ void tcp_parse_options(struct tcp_stream *tcp, uchar *o, int o_len)
 		else
 			p += p[1];
 	}
+
+	return scale;
 }
 
 static int tcp_seg_in_wnd(struct tcp_stream *tcp,
@@ -970,24 +1043,28 @@ void tcp_rx_state_machine(struct tcp_stream *tcp,
 	int tcp_len = pkt_len - IP_HDR_SIZE;
 	u32 tcp_seq_num, tcp_ack_num, tcp_win_size;
 	int tcp_hdr_len, payload_len;
+	int rmt_win_scale = -1;
 	u8  tcp_flags, action;
 
 	tcp_hdr_len = GET_TCP_HDR_LEN_IN_BYTES(b->ip.hdr.tcp_hlen);
 	payload_len = tcp_len - tcp_hdr_len;
 
 	if (tcp_hdr_len > TCP_HDR_SIZE)
-		tcp_parse_options(tcp, (uchar *)b + IP_TCP_HDR_SIZE,
-				  tcp_hdr_len - TCP_HDR_SIZE);
+		rmt_win_scale = tcp_parse_options(tcp,
+						  (uchar *)b + IP_TCP_HDR_SIZE,
+						  tcp_hdr_len - TCP_HDR_SIZE);
 	/*
 	 * Incoming sequence and ack numbers are server's view of the numbers.
 	 * The app must swap the numbers when responding.
 	 */
 	tcp_seq_num = ntohl(b->ip.hdr.tcp_seq);
 	tcp_ack_num = ntohl(b->ip.hdr.tcp_ack);
-	tcp_win_size = ntohs(b->ip.hdr.tcp_win) << tcp->rmt_win_scale;
-
 	tcp_flags = b->ip.hdr.tcp_flags;
 
+	tcp_win_size = ntohs(b->ip.hdr.tcp_win);
+	if (!(tcp_flags & TCP_SYN))
+		tcp_win_size <<= tcp->rmt_win_scale;
+
 //	printf("pkt: seq=%d, ack=%d, flags=%x, len=%d\n",
 //		tcp_seq_num - tcp->irs, tcp_ack_num - tcp->iss, tcp_flags, pkt_len);
 //	printf("tcp: rcv_nxt=%d, snd_una=%d, snd_nxt=%d\n\n",
@@ -1014,6 +1091,9 @@ void tcp_rx_state_machine(struct tcp_stream *tcp,
 		tcp->snd_nxt = tcp->iss + 1;
 		tcp->snd_wnd = tcp_win_size;
 
+		/* our SYN-ACK carries no window scale option */
+		tcp_stream_set_win_scale(tcp, -1);
+
 		tcp_stream_restart_rx_timer(tcp);
 
 		tcp_stream_set_state(tcp, TCP_SYN_RECEIVED);
@@ -1047,6 +1127,10 @@ void tcp_rx_state_machine(struct tcp_stream *tcp,
 		tcp->irs = tcp_seq_num;
 		tcp->rcv_nxt = tcp->irs + 1;
 		tcp->snd_una = tcp_ack_num;
+		tcp->snd_wnd = tcp_win_size;
+		tcp->snd_wl1 = tcp_seq_num;
+		tcp->snd_wl2 = tcp_ack_num;
+		tcp_stream_set_win_scale(tcp, rmt_win_scale);
 
 		tcp_stream_restart_rx_timer(tcp);
 
@@ -1177,7 +1261,8 @@ void rxhand_tcp_f(union tcp_build_pkt *b, unsigned int pkt_len)
 
 	b->ip.hdr.ip_dst = net_ip;
 	b->ip.hdr.ip_sum = 0;
-	if (tcp_rx_xsum != compute_ip_checksum(b, IP_HDR_SIZE)) {
+	if (!net_rx_csum_ok &&
+	    tcp_rx_xsum != compute_ip_checksum(b, IP_HDR_SIZE)) {
 		debug_cond(DEBUG_DEV_PKT,
 			   "TCP RX IP xSum Error (%pI4, =%pI4, len=%d)\n",
 			   &net_ip, &src, pkt_len);
@@ -1187,7 +1272,8 @@ void rxhand_tcp_f(union tcp_build_pkt *b, unsigned int pkt_len)
 	/* Build pseudo header and verify TCP header */
 	tcp_rx_xsum = b->ip.hdr.tcp_xsum;
 	b->ip.hdr.tcp_xsum = 0;
-	if (tcp_rx_xsum != tcp_set_pseudo_header((uchar *)b, b->ip.hdr.ip_src,
+	if (!net_rx_csum_ok &&
+	    tcp_rx_xsum != tcp_set_pseudo_header((uchar *)b, b->ip.hdr.ip_src,
 						 b->ip.hdr.ip_dst, tcp_len,
 						 pkt_len)) {
 		debug_cond(DEBUG_DEV_PKT,
@@ -1211,8 +1297,14 @@ void rxhand_tcp_f(union tcp_build_pkt *b, unsigned int pkt_len)
 struct tcp_stream *tcp_stream_connect(struct in_addr rhost, u16 rport)
 {
 	struct tcp_stream *tcp;
+	u16 lport = random_port();
+
+	/* Several streams may be opened to the same server in a row */
+	while (tcp_stream_find(rhost, rport, lport))
+		lport = RANDOM_PORT_START +
+			(lport + 1 - RANDOM_PORT_START) % RANDOM_PORT_RANGE;
 
-	tcp = tcp_stream_add(rhost, rport, random_port());
+	tcp = tcp_stream_add(rhost, rport, lport);
 	if (!tcp)
 		return NULL;
 
@@ -95,6 +95,10 @@ static ushort	tftp_windowsize;
 static ushort	tftp_next_ack;
 /* Last nack block we send */
 static ushort	tftp_last_nack;
+/* Window size to request, adapted to the losses seen in earlier transfers */
+static ushort	tftp_window_size_adapted;
+/* Number of times the server had to resend from an earlier block */
+static uint	tftp_resend_count;
 #ifdef CONFIG_CMD_TFTPPUT
 /* 1 if writing, else 0 */
 static int	tftp_put_active;
@@ -103,6 +107,32 @@ static int	tftp_put_final_block_sent;
 #else
 #define tftp_put_active	0
 #endif
+/* sequence number is 16 bit */
+#define TFTP_SEQUENCE_SIZE	((ulong)(1<<16))
+
+#ifdef CONFIG_CMD_MTFTPBOOT
+/* true if the file was asked for by multicast (RFC 2090) */
+static bool	tftp_mcast_wanted;
+/* true while data comes to the multicast group */
+static bool	tftp_mcast_active;
+/* true if we are the client that acknowledges data for the group */
+static bool	tftp_mcast_master;
+/* true once the multicast transfer stalled and unicast took over */
+static bool	tftp_mcast_repair;
+/* The UDP port of the multicast group */
+static int	tftp_mcast_port;
+/* The UDP port the first request went to */
+static int	tftp_mcast_server_port;
+/* The first block we do not have yet */
+static ulong	tftp_mcast_missing;
+/* The last block of the file, 0 until we got it */
+static ulong	tftp_mcast_end;
+/* One bit for each block we have */
+static u8	tftp_mcast_bitmap[TFTP_SEQUENCE_SIZE / 8];
+#else
+#define tftp_mcast_active	false
+#define tftp_mcast_master	false
+#endif
 
 #define STATE_SEND_RRQ	1
 #define STATE_DATA	2
@@ -116,8 +146,6 @@ static int	tftp_put_final_block_sent;
 /* default TFTP block size */
 #define TFTP_BLOCK_SIZE		512
 #define TFTP_MTU_BLOCKSIZE6 (CONFIG_TFTP_BLOCKSIZE - 20)
-/* sequence number is 16 bit */
-#define TFTP_SEQUENCE_SIZE	((ulong)(1<<16))
 
 #define DEFAULT_NAME_LEN	(8 + 4 + 1)
 static char default_filename[DEFAULT_NAME_LEN];
@@ -150,6 +178,74 @@ static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = CONFIG_TFTP_BLOCKSIZE;
 static unsigned short tftp_window_size_option = TFTP_WINDOWSIZE;
 
+/* Window size to ask the server for in the next read request */
+static unsigned short tftp_window_size_request(void)
+{
+	if (!IS_ENABLED(CONFIG_TFTP_WINDOWSIZE_ADAPTIVE))
+		return tftp_window_size_option;
+
+	if (!tftp_window_size_adapted ||
+	    tftp_window_size_adapted > tftp_window_size_option)
+		tftp_window_size_adapted = tftp_window_size_option;
+
+	return tftp_window_size_adapted;
+}
+
+/*
+ * RFC 7440 fixes the window size for the whole transfer once it has been
+ * negotiated, so adapt the size requested for the next one instead: halve it
+ * after a transfer that lost blocks, since every loss makes the server resend
+ * the rest of the window, and double it again after a clean one.
+ */
+static void tftp_window_size_update(bool ok)
+{
+	if (!IS_ENABLED(CONFIG_TFTP_WINDOWSIZE_ADAPTIVE) ||
+	    !tftp_window_size_adapted)
+		return;
+
+	if (ok && !tftp_resend_count)
+		tftp_window_size_adapted = min_t(uint,
+						 tftp_window_size_adapted * 2,
+						 tftp_window_size_option);
+	else if (tftp_window_size_adapted > 1)
+		tftp_window_size_adapted /= 2;
+	debug("TFTP windowsize for next transfer = %d\n",
+	      tftp_window_size_adapted);
+}
+
+#ifdef CONFIG_CMD_MTFTPBOOT
+static bool tftp_mcast_have(ulong block)
+{
+	return tftp_mcast_bitmap[block / 8] & BIT(block % 8);
+}
+
+/* Note that we have a block, and move on past the ones we have */
+static void tftp_mcast_mark(ulong block)
+{
+	if (!tftp_mcast_wanted || tftp_block_wrap)
+		return;
+
+	tftp_mcast_bitmap[block / 8] |= BIT(block % 8);
+	while (tftp_mcast_missing < TFTP_SEQUENCE_SIZE &&
+	       tftp_mcast_have(tftp_mcast_missing))
+		tftp_mcast_missing++;
+}
+
+static bool tftp_mcast_done(void)
+{
+	return tftp_mcast_end && tftp_mcast_missing > tftp_mcast_end;
+}
+
+static void tftp_mcast_leave(void)
+{
+	if (net_mcast_addr.s_addr)
+		eth_mcast_join(net_mcast_addr, 0);
+	net_mcast_addr.s_addr = 0;
+	tftp_mcast_active = false;
+	tftp_mcast_master = false;
+}
+#endif
+
 static inline int store_block(int block, uchar *src, unsigned int len)
 {
 	ulong offset = block * tftp_block_size + tftp_block_wrap_offset -
@@ -168,8 +264,14 @@ static inline int store_block(int block, uchar *src, unsigned int len)
 	}
 
 	ptr = map_sysmem(store_addr, len);
-	memcpy(ptr, src, len);
+	if (eth_rx_store(ptr, src, len)) {
+		unmap_sysmem(ptr);
+		return -1;
+	}
 	unmap_sysmem(ptr);
+#ifdef CONFIG_CMD_MTFTPBOOT
+	tftp_mcast_mark(block);
+#endif
 
 	if (net_boot_file_size < newsize)
 		net_boot_file_size = newsize;
@@ -177,6 +279,50 @@ static inline int store_block(int block, uchar *src, unsigned int len)
 	return 0;
 }
 
+/*
+ * Ask the Ethernet driver to receive the data of the blocks from the next
+ * one on straight to where they are stored
+ */
+static void tftp_rx_dest_update(void)
+{
+	struct eth_rx_dest dest;
+
+	if (!IS_ENABLED(CONFIG_ETH_RX_IN_PLACE) || tftp_put_active ||
+	    tftp_mcast_active)
+		return;
+
+	dest.addr = tftp_load_addr + tftp_cur_block * tftp_block_size +
+		    tftp_block_wrap_offset;
+#ifdef CONFIG_TFTP_TSIZE
+	if (tftp_tsize)
+		dest.end = tftp_load_addr + tftp_tsize;
+	else
+#endif
+	if (CONFIG_IS_ENABLED(LMB))
+		dest.end = tftp_load_addr + lmb_get_free_size(tftp_load_addr);
+	else
+		return;
+	dest.len = tftp_block_size;
+	dest.hdr_len = net_eth_hdr_size() + IP_UDP_HDR_SIZE + 4;
+	dest.port = tftp_our_port;
+	eth_set_rx_dest(&dest);
+}
+
+/* Check that the data of the next block can be stored where it belongs */
+static int tftp_rx_check(uchar *src, unsigned int len)
+{
+	ulong offset = tftp_cur_block * tftp_block_size +
+		       tftp_block_wrap_offset;
+	void *ptr;
+	int ret;
+
+	ptr = map_sysmem(tftp_load_addr + offset, len);
+	ret = eth_rx_check(ptr, src);
+	unmap_sysmem(ptr);
+
+	return ret;
+}
+
 /* Clear our state ready for a new transfer */
 static void new_transfer(void)
 {
@@ -253,6 +399,7 @@ static void show_block_marker(void)
 static void restart(const char *msg)
 {
 	printf("\n%s; starting again\n", msg);
+	tftp_window_size_update(false);
 	net_start_again();
 }
 
@@ -280,6 +427,11 @@ static void update_block_number(void)
 /* The TFTP get or put is complete */
 static void tftp_complete(void)
 {
+	/* Give the Ethernet driver its own buffers back */
+	eth_set_rx_dest(NULL);
+#ifdef CONFIG_CMD_MTFTPBOOT
+	tftp_mcast_leave();
+#endif
 #ifdef CONFIG_TFTP_TSIZE
 	/* Print hash marks for the last packet received */
 	while (tftp_tsize && tftp_tsize_num_hash < 49) {
@@ -294,7 +446,13 @@ static void tftp_complete(void)
 		puts("\n\t ");	/* Line up with "Loading: " */
 		print_size(net_boot_file_size /
 			time_start * 1000, "/s");
+		if (IS_ENABLED(CONFIG_TFTP_WINDOWSIZE_ADAPTIVE) &&
+		    tftp_windowsize > 1)
+			printf(" (windowsize %d, %u resends)", tftp_windowsize,
+			       tftp_resend_count);
 	}
+	if (!tftp_put_active)
+		tftp_window_size_update(true);
 	puts("\ndone\n");
 
 	led_activity_off();
@@ -357,9 +515,15 @@ static void tftp_send(void)
 		 * Implemented only for tftp get.
 		 * Don't bother sending if it's 1
 		 */
-		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_option > 1)
+		if (tftp_state == STATE_SEND_RRQ &&
+		    tftp_window_size_request() > 1)
 			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
-					0, tftp_window_size_option, 0);
+					0, tftp_window_size_request(), 0);
+#ifdef CONFIG_CMD_MTFTPBOOT
+		/* the server picks the group, see tftp_mcast_oack() */
+		if (tftp_mcast_wanted && !tftp_mcast_repair)
+			pkt += sprintf((char *)pkt, "multicast%c%c", 0, 0);
+#endif
 		len = pkt - xp;
 		break;
 
@@ -437,6 +601,145 @@ static void tftp_send(void)
 		net_set_state(NETLOOP_FAIL);
 }
 
+#ifdef CONFIG_CMD_MTFTPBOOT
+static void tftp_mcast_reset(enum proto_t protocol)
+{
+	tftp_mcast_leave();
+	tftp_mcast_wanted = protocol == MTFTPGET &&
+			    !(IS_ENABLED(CONFIG_IPV6) && use_ip6);
+	tftp_mcast_repair = false;
+	tftp_mcast_missing = 1;
+	tftp_mcast_end = 0;
+	memset(tftp_mcast_bitmap, '\0', sizeof(tftp_mcast_bitmap));
+}
+
+/*
+ * Handle the value of the multicast option, "addr,port,mc". The server may
+ * leave out the address and port once the transfer is going, when it only
+ * changes which client is the master.
+ */
+static int tftp_mcast_oack(char *val)
+{
+	struct in_addr addr;
+	char *port, *mc;
+	int ret;
+
+	port = strchr(val, ',');
+	mc = port ? strchr(port + 1, ',') : NULL;
+	if (!mc)
+		return -EINVAL;
+	*port++ = '\0';
+	*mc++ = '\0';
+
+	if (!tftp_mcast_active) {
+		if (!*val || !*port)
+			return -EINVAL;
+		addr = string_to_ip(val);
+		if ((ntohl(addr.s_addr) & 0xf0000000) != 0xe0000000)
+			return -EINVAL;
+		ret = eth_mcast_join(addr, 1);
+		if (ret)
+			return ret;
+
+		net_mcast_addr = addr;
+		tftp_mcast_port = dectoul(port, NULL);
+		tftp_mcast_active = true;
+		new_transfer();
+	}
+	tftp_mcast_master = dectoul(mc, NULL) != 0;
+	debug("Multicast group %pI4:%d, %smaster\n", &net_mcast_addr,
+	      tftp_mcast_port, tftp_mcast_master ? "" : "not ");
+
+	return 0;
+}
+
+/*
+ * Fetch the file again by unicast, keeping the blocks we have. This is
+ * for when we cannot join the group, or when the server stops sending to
+ * it before we have every block.
+ */
+static void tftp_mcast_unicast(const char *msg)
+{
+	printf("\n%s; continuing by unicast\n", msg);
+	tftp_mcast_leave();
+	tftp_mcast_repair = true;
+
+	tftp_state = STATE_SEND_RRQ;
+	tftp_remote_port = tftp_mcast_server_port;
+	/* a new port, so the server does not take us for the old client */
+	tftp_our_port = 1024 + (tftp_our_port - 1024 + 1) % 3072;
+	tftp_cur_block = 0;
+	tftp_windowsize = 1;
+	tftp_last_nack = 0;
+	tftp_block_size = TFTP_BLOCK_SIZE;
+	timeout_count = 0;
+	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+	tftp_send();
+}
+
+/* Tell the server that we have the whole file and do not need the rest */
+static void tftp_mcast_abort(void)
+{
+	uchar *pkt = net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
+	__be16 *s = (__be16 *)pkt;
+	int len;
+
+	*s++ = htons(TFTP_ERROR);
+	*s++ = htons(TFTP_ERR_UNDEFINED);
+	strcpy((char *)s, "Got the file by multicast");
+	len = (uchar *)s - pkt + strlen((char *)s) + 1;
+
+	net_send_udp_packet(net_server_ethaddr, tftp_remote_ip,
+			    tftp_remote_port, tftp_our_port, len);
+}
+
+/*
+ * Blocks sent to the group come in any order, as the server starts over
+ * from the first block the current master client is missing. Only the
+ * master acknowledges them.
+ */
+static void tftp_mcast_data(uchar *pkt, unsigned int len)
+{
+	ulong block = ntohs(*(__be16 *)pkt);
+	ulong missing = tftp_mcast_missing;
+
+	if (!block)
+		return;
+
+	tftp_state = STATE_DATA;
+	timeout_count = 0;
+	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+
+	if (!tftp_mcast_have(block)) {
+		if (store_block(block, pkt + 2, len)) {
+			tftp_mcast_leave();
+			eth_halt();
+			net_set_state(NETLOOP_FAIL);
+			return;
+		}
+		if (len < tftp_block_size)
+			tftp_mcast_end = block;
+	}
+
+	tftp_cur_block = tftp_mcast_missing - 1;
+	if (tftp_mcast_missing != missing)
+		show_block_marker();
+
+	if (tftp_mcast_done()) {
+		/* Let the server move on to the next master client */
+		if (tftp_mcast_master) {
+			tftp_cur_block = tftp_mcast_end;
+			tftp_send();
+		}
+		tftp_complete();
+		return;
+	}
+
+	if (tftp_mcast_master)
+		tftp_send();
+}
+#endif
+
 #ifdef CONFIG_CMD_TFTPPUT
 static void icmp_handler(unsigned type, unsigned code, unsigned dest,
 			 struct in_addr sip, unsigned src, uchar *pkt,
@@ -456,8 +759,14 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 	__be16 *s;
 	int i;
 	u16 timeout_val_rcvd;
+#ifdef CONFIG_CMD_MTFTPBOOT
+	int mcast_ret = 0;
+#endif
 
 	if (dest != tftp_our_port) {
+#ifdef CONFIG_CMD_MTFTPBOOT
+		if (!tftp_mcast_active || dest != tftp_mcast_port)
+#endif
 			return;
 	}
 	if (tftp_state != STATE_SEND_RRQ && src != tftp_remote_port &&
@@ -574,6 +883,11 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("windowsize = %s, %d\n",
 				      (char *)pkt + i + 11, tftp_windowsize);
 			}
+#ifdef CONFIG_CMD_MTFTPBOOT
+			if (strcasecmp((char *)pkt + i, "multicast") == 0 &&
+			    i + 10 < len)
+				mcast_ret = tftp_mcast_oack((char *)pkt + i + 10);
+#endif
 		}
 
 		tftp_next_ack = tftp_windowsize;
@@ -585,12 +899,34 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			tftp_cur_block++;
 		}
 #endif
+#ifdef CONFIG_CMD_MTFTPBOOT
+		if (mcast_ret) {
+			tftp_mcast_unicast("Cannot join the multicast group");
+			break;
+		}
+		if (tftp_mcast_active) {
+			/* The master asks for the first block it is missing */
+			if (tftp_mcast_master) {
+				tftp_cur_block = tftp_mcast_missing - 1;
+				tftp_send();
+			}
+			break;
+		}
+#endif
+		if (tftp_state == STATE_OACK)
+			tftp_rx_dest_update();
 		tftp_send(); /* Send ACK or first data block */
 		break;
 	case TFTP_DATA:
 		if (len < 2)
 			return;
 		len -= 2;
+#ifdef CONFIG_CMD_MTFTPBOOT
+		if (tftp_mcast_active) {
+			tftp_mcast_data(pkt, len);
+			break;
+		}
+#endif
 
 		if (ntohs(*(__be16 *)pkt) != (ushort)(tftp_cur_block + 1)) {
 			debug("Received unexpected block: %d, expected: %d\n",
@@ -611,10 +947,28 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			 * This just overwellms the server, let's just send one.
 			 */
 			if (tftp_last_nack != tftp_cur_block) {
+				tftp_resend_count++;
+				tftp_send();
+				tftp_last_nack = tftp_cur_block;
+				tftp_next_ack = (ushort)(tftp_cur_block +
+							 tftp_windowsize);
+			}
+			break;
+		}
+
+		if (tftp_rx_check(pkt + 2, len)) {
+			/*
+			 * The block did not land where it belongs, so ask for
+			 * the window again and receive it from the top.
+			 */
+			debug("Block %d not in place\n", ntohs(*(__be16 *)pkt));
+			if (tftp_last_nack != tftp_cur_block) {
+				tftp_resend_count++;
 				tftp_send();
 				tftp_last_nack = tftp_cur_block;
 				tftp_next_ack = (ushort)(tftp_cur_block +
 							 tftp_windowsize);
+				tftp_rx_dest_update();
 			}
 			break;
 		}
@@ -661,6 +1015,15 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		}
 		timeout_count = 0;
 
+#ifdef CONFIG_CMD_MTFTPBOOT
+		/* The blocks missed from the group are in, skip the rest */
+		if (tftp_mcast_repair && tftp_mcast_done()) {
+			tftp_mcast_abort();
+			tftp_complete();
+			break;
+		}
+#endif
+
 		if (len < tftp_block_size) {
 			tftp_send();
 			tftp_complete();
@@ -705,11 +1068,20 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 static void tftp_timeout_handler(void)
 {
 	if (++timeout_count > timeout_count_max) {
+#ifdef CONFIG_CMD_MTFTPBOOT
+		if (tftp_mcast_active) {
+			tftp_mcast_unicast("Multicast transfer stalled");
+			return;
+		}
+#endif
 		restart("Retry count exceeded");
 	} else {
 		puts("T ");
+		tftp_resend_count++;
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
-		if (tftp_state != STATE_RECV_WRQ)
+		/* Only the master client of a multicast group sends ACKs */
+		if (tftp_state != STATE_RECV_WRQ &&
+		    (!tftp_mcast_active || tftp_mcast_master))
 			tftp_send();
 	}
 }
@@ -727,6 +1099,9 @@ static void sanitize_tftp_block_size_option(enum proto_t protocol)
 
 	switch (protocol) {
 	case TFTPGET:
+#ifdef CONFIG_CMD_MTFTPBOOT
+	case MTFTPGET:
+#endif
 		max_defrag = config_opt_enabled(CONFIG_IP_DEFRAG, CONFIG_NET_MAXDEFRAG, 0);
 		if (max_defrag) {
 			/* Account for IP, UDP and TFTP headers. */
@@ -937,6 +1312,7 @@ void tftp_start(enum proto_t protocol)
 	tftp_cur_block = 0;
 	tftp_windowsize = 1;
 	tftp_last_nack = 0;
+	tftp_resend_count = 0;
 	/* zero out server ether in case the server ip has changed */
 	memset(net_server_ethaddr, 0, 6);
 	/* Revert tftp_block_size to dflt */
@@ -945,6 +1321,10 @@ void tftp_start(enum proto_t protocol)
 	tftp_tsize = 0;
 	tftp_tsize_num_hash = 0;
 #endif
+#ifdef CONFIG_CMD_MTFTPBOOT
+	tftp_mcast_reset(protocol);
+	tftp_mcast_server_port = tftp_remote_port;
+#endif
 
 	tftp_send();
 }
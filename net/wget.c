@@ -16,6 +16,8 @@
 #include <net/tcp.h>
 #include <net/wget.h>
 #include <stdlib.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -28,6 +30,16 @@ DECLARE_GLOBAL_DATA_PTR;
 
 #define HTTP_STATUS_BAD		0
 #define HTTP_STATUS_OK		200
+#define HTTP_STATUS_PARTIAL	206
+
+/* Reuse a kept-alive connection only if the server was heard from lately */
+#define WGET_KEEPALIVE_IDLE_MS	5000
+
+/* Objects smaller than this are fetched over a single connection */
+#define WGET_RANGE_MIN		SZ_4M
+
+#define WGET_MAX_CONNS \
+	(IS_ENABLED(CONFIG_WGET_RANGE) ? CONFIG_PROT_TCP_STREAMS : 1)
 
 static const char http_proto[] = "HTTP/1.0";
 static const char http_eom[] = "\r\n\r\n";
@@ -36,21 +48,138 @@ static const char linefeed[] = "\r\n";
 static struct in_addr web_server_ip;
 static unsigned int server_port;
 static unsigned long content_length;
-static u32 http_hdr_size, max_rx_pos;
 static int wget_tsize_num_hash;
 
 static char *image_url;
 static enum net_loop_state wget_loop_state;
 
+/**
+ * struct wget_conn - one HTTP request and its response
+ *
+ * @tcp:	TCP stream carrying the request, NULL when there is none
+ * @start:	offset in the object of the first body byte of the response
+ * @len:	number of body bytes wanted, ULONG_MAX to read until the server
+ *		closes the connection
+ * @rx_base:	offset in the TCP receive stream where the response starts
+ * @tx_base:	offset in the TCP send stream where the request starts
+ * @hdr_size:	size of the response header, 0 until it has been received
+ * @max_rx_pos:	highest response offset stored so far, (u32)-1 if none
+ * @received:	number of body bytes received in sequence
+ * @packets:	number of packets received for the response
+ * @packets_base: rx_packets of the stream when the request was made
+ * @active:	this connection is part of the current transfer
+ * @range:	ask for @len bytes from @start with a Range header
+ * @required:	all @len bytes must arrive, a close before that is an error
+ * @reused:	the request went out on a connection kept open from before
+ * @keep:	the server agreed to keep the connection open afterwards
+ * @done:	the response is complete
+ */
+struct wget_conn {
+	struct tcp_stream *tcp;
+	ulong start;
+	ulong len;
+	u32 rx_base;
+	u32 tx_base;
+	u32 hdr_size;
+	u32 max_rx_pos;
+	ulong received;
+	u32 packets;
+	u32 packets_base;
+	bool active;
+	bool range;
+	bool required;
+	bool reused;
+	bool keep;
+	bool done;
+};
+
+static struct wget_conn wget_conns[WGET_MAX_CONNS];
+/* Connection kept open after the last transfer, no callbacks attached */
+static struct tcp_stream *wget_idle_tcp;
+static char wget_req_buf[sizeof(net_boot_file_name) + 128];
+
+static void tcp_stream_on_closed(struct tcp_stream *tcp);
+static void tcp_stream_on_rcv_nxt_update(struct tcp_stream *tcp, u32 rx_bytes);
+static int tcp_stream_rx(struct tcp_stream *tcp, u32 rx_offs, void *buf,
+			 int len);
+static int tcp_stream_tx(struct tcp_stream *tcp, u32 tx_offs, void *buf,
+			 int maxlen);
+
+static void wget_conn_init(struct wget_conn *conn, ulong start, ulong len,
+			   bool range)
+{
+	memset(conn, 0, sizeof(*conn));
+	conn->start = start;
+	conn->len = len;
+	conn->max_rx_pos = (u32)(-1);
+	conn->active = true;
+	conn->range = range;
+	conn->required = range;
+}
+
+static void wget_attach(struct tcp_stream *tcp, struct wget_conn *conn)
+{
+	tcp->priv = conn;
+	tcp->on_closed = tcp_stream_on_closed;
+	tcp->on_rcv_nxt_update = tcp_stream_on_rcv_nxt_update;
+	tcp->rx = tcp_stream_rx;
+	tcp->tx = tcp_stream_tx;
+
+	conn->tcp = tcp;
+	conn->tx_base = tcp_stream_tx_offs(tcp);
+	conn->rx_base = tcp_stream_rx_offs(tcp);
+	conn->packets_base = tcp->rx_packets;
+}
+
+static void wget_idle_closed(struct tcp_stream *tcp)
+{
+	wget_idle_tcp = NULL;
+}
+
+/*
+ * Disconnect a stream from its request. Incoming data is then dropped by the
+ * TCP layer and the stream can be left to close, or kept for the next request.
+ */
+static void wget_detach(struct wget_conn *conn, bool keep)
+{
+	struct tcp_stream *tcp = conn->tcp;
+
+	tcp->priv = NULL;
+	tcp->on_closed = keep ? wget_idle_closed : NULL;
+	tcp->on_rcv_nxt_update = NULL;
+	tcp->rx = NULL;
+	tcp->tx = NULL;
+	if (keep)
+		wget_idle_tcp = tcp;
+
+	conn->tcp = NULL;
+}
+
+static int wget_connect(struct wget_conn *conn)
+{
+	struct tcp_stream *tcp;
+
+	tcp = tcp_stream_connect(web_server_ip, server_port);
+	if (!tcp)
+		return -ENOSPC;
+
+	wget_attach(tcp, conn);
+	tcp_stream_put(tcp);
+
+	return 0;
+}
+
 /**
  * store_block() - store block in memory
+ * @conn: connection the data arrived on
  * @src: source of data
- * @offset: offset
+ * @offset: offset in the response body
  * @len: length
  */
-static inline int store_block(uchar *src, unsigned int offset, unsigned int len)
+static inline int store_block(struct wget_conn *conn, uchar *src,
+			      unsigned int offset, unsigned int len)
 {
-	ulong store_addr = image_load_addr + offset;
+	ulong store_addr = image_load_addr + conn->start + offset;
 	uchar *ptr;
 
 	if (CONFIG_IS_ENABLED(LMB) && wget_info->set_bootdev) {
@@ -90,25 +219,37 @@ static void show_block_marker(u32 packets)
 	}
 }
 
-static void tcp_stream_on_closed(struct tcp_stream *tcp)
+static u32 wget_packets(void)
 {
-	if (tcp->status != TCP_ERR_OK)
-		wget_loop_state = NETLOOP_FAIL;
+	u32 packets = 0;
+	int i;
 
-	net_set_state(wget_loop_state);
-	if (wget_loop_state != NETLOOP_SUCCESS) {
-		net_boot_file_size = 0;
-		if (wget_info->status_code == HTTP_STATUS_OK) {
-			wget_info->status_code = HTTP_STATUS_BAD;
-			wget_info->hdr_cont_len = 0;
-			if (wget_info->headers)
-				wget_info->headers[0] = 0;
-		}
-		printf("\nwget: Transfer Fail, TCP status - %d\n", tcp->status);
-		return;
+	for (i = 0; i < WGET_MAX_CONNS; i++)
+		packets += wget_conns[i].packets;
+
+	return packets;
+}
+
+static void wget_update_size(void)
+{
+	int i;
+
+	net_boot_file_size = 0;
+	for (i = 0; i < WGET_MAX_CONNS; i++)
+		net_boot_file_size += wget_conns[i].received;
+}
+
+static void wget_success(void)
+{
+	int i;
+
+	for (i = 0; i < WGET_MAX_CONNS; i++) {
+		if (wget_conns[i].active && !wget_conns[i].done)
+			return;
 	}
 
-	printf("\nPackets received %d, Transfer Successful\n", tcp->rx_packets);
+	net_set_state(NETLOOP_SUCCESS);
+	printf("\nPackets received %d, Transfer Successful\n", wget_packets());
 	wget_info->file_size = net_boot_file_size;
 	if (wget_info->method == WGET_HTTP_METHOD_GET && wget_info->set_bootdev) {
 		efi_set_bootdev("Http", NULL, image_url,
@@ -118,19 +259,135 @@ static void tcp_stream_on_closed(struct tcp_stream *tcp)
 	}
 }
 
-static void tcp_stream_on_rcv_nxt_update(struct tcp_stream *tcp, u32 rx_bytes)
+static void wget_fail(enum tcp_status status)
 {
-	char	*pos, *tail;
-	uchar	saved, *ptr;
-	int	reply_len;
+	struct wget_conn *conn;
+
+	/* Drop the streams of the other parts of the transfer */
+	for (conn = wget_conns; conn < wget_conns + WGET_MAX_CONNS; conn++) {
+		struct tcp_stream *tcp = conn->tcp;
+
+		if (!tcp)
+			continue;
+		wget_detach(conn, false);
+		tcp_stream_reset(tcp);
+		tcp_stream_put(tcp);
+	}
 
-	if (http_hdr_size) {
-		net_boot_file_size = rx_bytes - http_hdr_size;
-		show_block_marker(tcp->rx_packets);
+	net_set_state(NETLOOP_FAIL);
+	net_boot_file_size = 0;
+	if (wget_info->status_code == HTTP_STATUS_OK) {
+		wget_info->status_code = HTTP_STATUS_BAD;
+		wget_info->hdr_cont_len = 0;
+		if (wget_info->headers)
+			wget_info->headers[0] = 0;
+	}
+	printf("\nwget: Transfer Fail, TCP status - %d\n", status);
+}
+
+static void tcp_stream_on_closed(struct tcp_stream *tcp)
+{
+	struct wget_conn *conn = tcp->priv;
+
+	conn->tcp = NULL;
+	conn->packets = tcp->rx_packets - conn->packets_base;
+
+	/* The server dropped a kept-alive connection, try a fresh one */
+	if (conn->reused && !conn->hdr_size) {
+		debug_cond(DEBUG_WGET, "wget: kept connection lost, reconnecting\n");
+		wget_conn_init(conn, 0, ULONG_MAX, false);
+		if (!wget_connect(conn))
+			return;
+	}
+
+	if (tcp->status == TCP_ERR_OK && conn->hdr_size && !conn->required)
+		conn->done = true;
+
+	if (!conn->done || wget_loop_state != NETLOOP_SUCCESS) {
+		wget_fail(tcp->status);
 		return;
 	}
 
-	ptr = map_sysmem(image_load_addr, rx_bytes + 1);
+	wget_success();
+}
+
+/* Find the value of header @name in the NUL-terminated header block @hdr */
+static const char *wget_find_header(const char *hdr, const char *name)
+{
+	size_t len = strlen(name);
+	const char *line;
+
+	for (line = strstr(hdr, linefeed); line; line = strstr(line, linefeed)) {
+		line += strlen(linefeed);
+		if (!strncasecmp(line, name, len) && line[len] == ':') {
+			line += len + 1;
+			while (*line == ' ')
+				line++;
+			return line;
+		}
+	}
+
+	return NULL;
+}
+
+static bool wget_header_is(const char *hdr, const char *name,
+			   const char *value)
+{
+	const char *pos = wget_find_header(hdr, name);
+
+	return pos && !strncasecmp(pos, value, strlen(value));
+}
+
+/*
+ * Split the rest of a large object into Range requests over further
+ * connections, leaving the first part to the connection already receiving it
+ */
+static void wget_split(struct wget_conn *first)
+{
+	struct tcp_stream *tcp;
+	ulong part;
+	int i, n;
+
+	part = ALIGN(DIV_ROUND_UP(content_length, WGET_MAX_CONNS), SZ_64K);
+	n = DIV_ROUND_UP(content_length, part);
+
+	for (i = 1; i < n; i++) {
+		wget_conn_init(&wget_conns[i], i * part,
+			       min(part, content_length - i * part), true);
+		if (wget_connect(&wget_conns[i]))
+			break;
+	}
+
+	if (i < n) {
+		/* Not enough free streams, stay with the one we have */
+		while (--i > 0) {
+			tcp = wget_conns[i].tcp;
+			wget_detach(&wget_conns[i], false);
+			tcp_stream_reset(tcp);
+			tcp_stream_put(tcp);
+		}
+		memset(wget_conns + 1, 0, sizeof(wget_conns) - sizeof(*first));
+		return;
+	}
+
+	first->len = part;
+	first->required = true;
+	first->keep = false;
+	debug_cond(DEBUG_WGET, "wget: split %lu bytes into %d parts\n",
+		   content_length, n);
+}
+
+/* Parse the header of a response once it has been received in full */
+static void wget_parse_header(struct tcp_stream *tcp, struct wget_conn *conn,
+			      u32 rx_bytes)
+{
+	char	*pos, *tail;
+	uchar	saved, *ptr;
+	int	reply_len;
+	u32	status_code;
+	bool	first = conn == &wget_conns[0];
+
+	ptr = map_sysmem(image_load_addr + conn->start, rx_bytes + 1);
 
 	saved = ptr[rx_bytes];
 	ptr[rx_bytes] = '\0';
@@ -147,10 +404,13 @@ static void tcp_stream_on_rcv_nxt_update(struct tcp_stream *tcp, u32 rx_bytes)
 		goto end;
 	}
 
-	http_hdr_size = pos - (char *)ptr + strlen(http_eom);
+	conn->hdr_size = pos - (char *)ptr + strlen(http_eom);
 	*pos = '\0';
+	if (!first)
+		wget_loop_state = NETLOOP_FAIL;
 
-	if (wget_info->headers && http_hdr_size < MAX_HTTP_HEADERS_SIZE)
+	if (first && wget_info->headers &&
+	    conn->hdr_size < MAX_HTTP_HEADERS_SIZE)
 		strcpy(wget_info->headers, ptr);
 
 	/* check for HTTP proto */
@@ -166,7 +426,7 @@ static void tcp_stream_on_rcv_nxt_update(struct tcp_stream *tcp, u32 rx_bytes)
 	if (pos)
 		reply_len = pos - (char *)ptr;
 	else
-		reply_len = http_hdr_size - strlen(http_eom);
+		reply_len = conn->hdr_size - strlen(http_eom);
 
 	pos = strchr((char *)ptr, ' ');
 	if (!pos || pos - (char *)ptr > reply_len) {
@@ -176,7 +436,7 @@ static void tcp_stream_on_rcv_nxt_update(struct tcp_stream *tcp, u32 rx_bytes)
 		goto end;
 	}
 
-	wget_info->status_code = (u32)simple_strtoul(pos + 1, &tail, 10);
+	status_code = (u32)simple_strtoul(pos + 1, &tail, 10);
 	if (tail == pos + 1 || *tail != ' ') {
 		debug_cond(DEBUG_WGET, "wget: Connected Bad Xfer "
 				       "(bad HTTP Status Code)\n");
@@ -185,8 +445,23 @@ static void tcp_stream_on_rcv_nxt_update(struct tcp_stream *tcp, u32 rx_bytes)
 	}
 
 	debug_cond(DEBUG_WGET,
-		   "wget: HTTP Status Code %d\n", wget_info->status_code);
+		   "wget: HTTP Status Code %d\n", status_code);
+
+	if (!first) {
+		/* A part of the object, check that it is the part we asked */
+		pos = (char *)wget_find_header((char *)ptr, "Content-Range");
+		if (status_code != HTTP_STATUS_PARTIAL || !pos ||
+		    strncasecmp(pos, "bytes ", 6) ||
+		    simple_strtoul(pos + 6, NULL, 10) != conn->start) {
+			debug_cond(DEBUG_WGET, "wget: Bad range reply\n");
+			tcp_stream_close(tcp);
+			goto end;
+		}
+		wget_loop_state = NETLOOP_SUCCESS;
+		goto body;
+	}
 
+	wget_info->status_code = status_code;
 	if (wget_info->status_code != HTTP_STATUS_OK) {
 		debug_cond(DEBUG_WGET, "wget: Connected Bad Xfer\n");
 		tcp_stream_close(tcp);
@@ -194,7 +469,7 @@ static void tcp_stream_on_rcv_nxt_update(struct tcp_stream *tcp, u32 rx_bytes)
 	}
 
 	debug_cond(DEBUG_WGET, "wget: Connctd pkt %p  hlen %x\n",
-		   ptr, http_hdr_size);
+		   ptr, conn->hdr_size);
 
 	content_length = -1;
 	pos = strstr((char *)ptr, content_len);
@@ -207,38 +482,113 @@ static void tcp_stream_on_rcv_nxt_update(struct tcp_stream *tcp, u32 rx_bytes)
 			content_length = -1;
 	}
 
-	if (content_length >= 0) {
+	if (content_length != -1) {
 		debug_cond(DEBUG_WGET,
 			   "wget: Connected Len %lu\n",
 			   content_length);
 		wget_info->hdr_cont_len = content_length;
+		conn->len = wget_info->method == WGET_HTTP_METHOD_HEAD ?
+			    0 : content_length;
+
+		/*
+		 * An HTTP/1.1 server keeps the connection open unless told
+		 * otherwise, an HTTP/1.0 one only if it says so
+		 */
+		if (IS_ENABLED(CONFIG_WGET_KEEPALIVE))
+			conn->keep = strncasecmp((char *)ptr, "HTTP/1.0", 8) ?
+				!wget_header_is((char *)ptr, "Connection",
+						"close") :
+				wget_header_is((char *)ptr, "Connection",
+					       "keep-alive");
+
+		if (IS_ENABLED(CONFIG_WGET_RANGE) && WGET_MAX_CONNS > 1 &&
+		    conn->len >= WGET_RANGE_MIN &&
+		    wget_header_is((char *)ptr, "Accept-Ranges", "bytes"))
+			wget_split(conn);
 	}
 
-	net_boot_file_size = rx_bytes - http_hdr_size;
-	memmove(ptr, ptr + http_hdr_size, max_rx_pos + 1 - http_hdr_size);
 	wget_loop_state = NETLOOP_SUCCESS;
 
+body:
+	memmove(ptr, ptr + conn->hdr_size,
+		min_t(ulong, conn->max_rx_pos + 1 - conn->hdr_size, conn->len));
+
 end:
 	unmap_sysmem(ptr);
 }
 
+static void tcp_stream_on_rcv_nxt_update(struct tcp_stream *tcp, u32 rx_bytes)
+{
+	struct wget_conn *conn = tcp->priv;
+	bool hdr_done = conn->hdr_size;
+
+	rx_bytes -= conn->rx_base;
+	conn->packets = tcp->rx_packets - conn->packets_base;
+
+	if (!hdr_done) {
+		wget_parse_header(tcp, conn, rx_bytes);
+		if (!conn->hdr_size || wget_loop_state != NETLOOP_SUCCESS)
+			return;
+	}
+
+	conn->received = min_t(ulong, rx_bytes - conn->hdr_size, conn->len);
+	wget_update_size();
+	if (hdr_done)
+		show_block_marker(wget_packets());
+
+	if (conn->received < conn->len)
+		return;
+
+	/*
+	 * All of the response is in. Keep the connection for the next request
+	 * if the server agreed to it, otherwise close it if the server is
+	 * still sending data we did not ask for.
+	 */
+	if (conn->keep || conn->required) {
+		wget_detach(conn, conn->keep);
+		if (!conn->keep)
+			tcp_stream_close(tcp);
+		conn->done = true;
+		wget_success();
+	}
+}
+
 static int tcp_stream_rx(struct tcp_stream *tcp, u32 rx_offs, void *buf, int len)
 {
-	if ((max_rx_pos == (u32)(-1)) || (max_rx_pos < rx_offs + len - 1))
-		max_rx_pos = rx_offs + len - 1;
+	struct wget_conn *conn = tcp->priv;
+	u32 pos = rx_offs - conn->rx_base;
+	u32 skip;
+
+	if ((conn->max_rx_pos == (u32)(-1)) || (conn->max_rx_pos < pos + len - 1))
+		conn->max_rx_pos = pos + len - 1;
+
+	if (conn->hdr_size) {
+		/* Drop what is left of the header, and any data past @len */
+		if (pos < conn->hdr_size) {
+			skip = conn->hdr_size - pos;
+			if (skip >= len)
+				return len;
+			store_block(conn, buf + skip, 0, len - skip);
+			return len;
+		}
+		if (pos - conn->hdr_size >= conn->len)
+			return len;
+		store_block(conn, buf, pos - conn->hdr_size,
+			    min_t(ulong, len,
+				  conn->len - (pos - conn->hdr_size)));
+		return len;
+	}
 
-	store_block(buf, rx_offs - http_hdr_size, len);
+	store_block(conn, buf, pos, len);
 
 	return len;
 }
 
 static int tcp_stream_tx(struct tcp_stream *tcp, u32 tx_offs, void *buf, int maxlen)
 {
-	int ret;
+	struct wget_conn *conn = tcp->priv;
 	const char *method;
-
-	if (tx_offs)
-		return 0;
+	int len, offs;
 
 	switch (wget_info->method) {
 	case WGET_HTTP_METHOD_HEAD:
@@ -250,10 +600,27 @@ static int tcp_stream_tx(struct tcp_stream *tcp, u32 tx_offs, void *buf, int max
 		break;
 	}
 
-	ret = snprintf(buf, maxlen, "%s %s %s\r\n\r\n",
+	len = snprintf(wget_req_buf, sizeof(wget_req_buf), "%s %s %s\r\n",
 		       method, image_url, http_proto);
+	if (conn->range)
+		len += snprintf(wget_req_buf + len, sizeof(wget_req_buf) - len,
+				"Range: bytes=%lu-%lu\r\n", conn->start,
+				conn->start + conn->len - 1);
+	else if (IS_ENABLED(CONFIG_WGET_KEEPALIVE))
+		len += snprintf(wget_req_buf + len, sizeof(wget_req_buf) - len,
+				"Connection: keep-alive\r\n");
+	len += snprintf(wget_req_buf + len, sizeof(wget_req_buf) - len,
+			"\r\n");
+	len = min_t(int, len, sizeof(wget_req_buf) - 1);
+
+	offs = tx_offs - conn->tx_base;
+	if (offs >= len)
+		return 0;
 
-	return ret;
+	len = min(len - offs, maxlen);
+	memcpy(buf, wget_req_buf + offs, len);
+
+	return len;
 }
 
 static int tcp_stream_on_create(struct tcp_stream *tcp)
@@ -264,20 +631,46 @@ static int tcp_stream_on_create(struct tcp_stream *tcp)
 
 	tcp->max_retry_count = WGET_RETRY_COUNT;
 	tcp->initial_timeout = WGET_TIMEOUT;
-	tcp->on_closed = tcp_stream_on_closed;
-	tcp->on_rcv_nxt_update = tcp_stream_on_rcv_nxt_update;
-	tcp->rx = tcp_stream_rx;
-	tcp->tx = tcp_stream_tx;
+
+	/* Do not let the server send more than fits at the load address */
+	if (CONFIG_IS_ENABLED(LMB) && wget_info->set_bootdev) {
+		phys_size_t room = lmb_get_free_size(image_load_addr);
+
+		tcp_stream_set_rcv_wnd(tcp, min_t(phys_size_t, room, U32_MAX));
+	}
 
 	return 1;
 }
 
+/* Hand the connection kept from the last transfer to @conn, if it is usable */
+static bool wget_reuse(struct wget_conn *conn)
+{
+	struct tcp_stream *tcp = wget_idle_tcp;
+
+	if (!IS_ENABLED(CONFIG_WGET_KEEPALIVE) || !tcp)
+		return false;
+
+	if (tcp->rhost.s_addr != web_server_ip.s_addr ||
+	    tcp->rport != server_port || tcp->state != TCP_ESTABLISHED ||
+	    get_timer(tcp->time_last_rx) >= WGET_KEEPALIVE_IDLE_MS) {
+		tcp_stream_reset(tcp);
+		tcp_stream_put(tcp);
+		return false;
+	}
+
+	wget_idle_tcp = NULL;
+	wget_attach(tcp, conn);
+	conn->reused = true;
+	tcp_stream_restart_rx_timer(tcp);
+	debug_cond(DEBUG_WGET, "wget: reusing connection\n");
+
+	return true;
+}
+
 #define BLOCKSIZE 512
 
 void wget_start(void)
 {
-	struct tcp_stream *tcp;
-
 	if (!wget_info)
 		wget_info = &default_wget_info;
 
@@ -326,11 +719,10 @@ void wget_start(void)
 
 	memset(net_server_ethaddr, 0, 6);
 
-	max_rx_pos = (u32)(-1);
 	net_boot_file_size = 0;
-	http_hdr_size = 0;
 	wget_tsize_num_hash = 0;
 	wget_loop_state = NETLOOP_FAIL;
+	content_length = -1;
 
 	wget_info->status_code = HTTP_STATUS_BAD;
 	wget_info->file_size = 0;
@@ -338,15 +730,16 @@ void wget_start(void)
 	if (wget_info->headers)
 		wget_info->headers[0] = 0;
 
+	memset(wget_conns, 0, sizeof(wget_conns));
+	wget_conn_init(&wget_conns[0], 0, ULONG_MAX, false);
+
 	server_port = env_get_ulong("httpdstp", 10, SERVER_PORT) & 0xffff;
 	tcp_stream_set_on_create_handler(tcp_stream_on_create);
-	tcp = tcp_stream_connect(web_server_ip, server_port);
-	if (!tcp) {
+	if (!wget_reuse(&wget_conns[0]) && wget_connect(&wget_conns[0])) {
 		printf("No free tcp streams\n");
 		net_set_state(NETLOOP_FAIL);
 		return;
 	}
-	tcp_stream_put(tcp);
 }
 
 int wget_do_request(ulong dst_addr, char *uri)
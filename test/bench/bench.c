@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Benchmarks for hashing and the environment, which need no test files
+ */
+
+#include <div64.h>
+#include <env.h>
+#include <hash.h>
+#include <malloc.h>
+#include <search.h>
+#include <time.h>
+#include <vsprintf.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
+#include <test/bench.h>
+#include <test/ut.h>
+
+enum {
+	BENCH_HASH_SIZE		= SZ_4M,
+	BENCH_ENV_VARS		= 1000,
+	BENCH_ENV_VAR_LEN	= 48,
+	BENCH_ENV_LOOPS		= 10,
+};
+
+void bench_report(const char *name, const char *unit, u64 count, ulong us)
+{
+	printf("bench: name=%s %s=%llu us=%lu rate=%llu\n", name, unit, count,
+	       us, lldiv(count * 1000000, max(us, 1UL)));
+}
+
+static int bench_hash(struct unit_test_state *uts, const char *algo)
+{
+	u8 output[HASH_MAX_DIGEST_SIZE];
+	int size = sizeof(output);
+	ulong start, us;
+	void *buf;
+
+	buf = malloc(BENCH_HASH_SIZE);
+	ut_assertnonnull(buf);
+	memset(buf, 0xa5, BENCH_HASH_SIZE);
+
+	start = timer_get_us();
+	ut_assertok(hash_block(algo, buf, BENCH_HASH_SIZE, output, &size));
+	us = timer_get_us() - start;
+	free(buf);
+	bench_report(algo, "bytes", BENCH_HASH_SIZE, us);
+
+	return 0;
+}
+
+static int bench_test_sha256(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_SHA256))
+		return -EAGAIN;
+
+	return bench_hash(uts, "sha256");
+}
+BENCH_TEST(bench_test_sha256, 0);
+
+static int bench_test_crc32(struct unit_test_state *uts)
+{
+	return bench_hash(uts, "crc32");
+}
+BENCH_TEST(bench_test_crc32, 0);
+
+/* Import an environment with many variables into a private hash table */
+static int bench_test_env_import(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+	ulong start, us = 0;
+	char *buf, *p;
+	int i;
+
+	buf = malloc(BENCH_ENV_VARS * BENCH_ENV_VAR_LEN + 1);
+	ut_assertnonnull(buf);
+	for (p = buf, i = 0; i < BENCH_ENV_VARS; i++)
+		p += sprintf(p, "bench_var%d=value of variable %d", i, i) + 1;
+	*p++ = '\0';
+
+	for (i = 0; i < BENCH_ENV_LOOPS; i++) {
+		memset(&htab, '\0', sizeof(htab));
+		start = timer_get_us();
+		ut_asserteq(1, himport_r(&htab, buf, p - buf, '\0', H_DEFAULT,
+					 0, 0, NULL));
+		us += timer_get_us() - start;
+		ut_asserteq(BENCH_ENV_VARS, htab.filled);
+		hdestroy_r(&htab);
+	}
+	free(buf);
+	bench_report("env_import", "vars", BENCH_ENV_VARS * BENCH_ENV_LOOPS,
+		     us);
+
+	return 0;
+}
+BENCH_TEST(bench_test_env_import, 0);
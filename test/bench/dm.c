@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Benchmark for binding and probing the devices in the sandbox test tree
+ */
+
+#include <dm.h>
+#include <time.h>
+#include <dm/device-internal.h>
+#include <dm/root.h>
+#include <dm/uclass-internal.h>
+#include <asm/global_data.h>
+#include <test/bench.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static int bench_test_dm(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+	int bound = 0, probed = 0;
+	ulong start, us;
+
+	start = timer_get_us();
+	ut_assertok(dm_extended_scan(false));
+	us = timer_get_us() - start;
+	list_for_each_entry(uc, gd->uclass_root, sibling_node) {
+		list_for_each_entry(dev, &uc->dev_head, uclass_node)
+			bound++;
+	}
+	bench_report("dm_bind", "devices", bound, us);
+
+	/* some test devices fail to probe on purpose, so just count them */
+	start = timer_get_us();
+	list_for_each_entry(uc, gd->uclass_root, sibling_node) {
+		list_for_each_entry(dev, &uc->dev_head, uclass_node) {
+			if (!device_probe(dev))
+				probed++;
+		}
+	}
+	us = timer_get_us() - start;
+	bench_report("dm_probe", "devices", probed, us);
+
+	return 0;
+}
+BENCH_TEST(bench_test_dm, UTF_DM);
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Benchmarks for decompression and FIT verification, using files set up by
+ * test/py/tests/test_bench.py
+ */
+
+#include <image.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <os.h>
+#include <time.h>
+#include <linux/sizes.h>
+#include <test/bench.h>
+#include <test/ut.h>
+
+/* Read a file set up for the benchmarks, or return -EAGAIN if it is missing */
+static int bench_read_file(struct unit_test_state *uts, const char *leaf,
+			   void **bufp, int *sizep)
+{
+	char fname[256];
+
+	if (os_persistent_file(fname, sizeof(fname), leaf))
+		return -EAGAIN;
+	ut_assertok(os_read_file(fname, bufp, sizep));
+
+	return 0;
+}
+
+static int bench_decomp(struct unit_test_state *uts, int comp,
+			const char *leaf)
+{
+	void *in, *out, *expect;
+	int in_size, size, ret;
+	ulong load, load_end;
+	ulong start, us;
+
+	ret = bench_read_file(uts, "bench.bin", &expect, &size);
+	if (ret)
+		return ret;
+	ret = bench_read_file(uts, leaf, &in, &in_size);
+	if (ret)
+		return ret;
+	out = malloc(size + SZ_64K);
+	ut_assertnonnull(out);
+
+	load = map_to_sysmem(out);
+	start = timer_get_us();
+	ut_assertok(image_decomp(comp, load, map_to_sysmem(in), IH_TYPE_KERNEL,
+				 out, in, in_size, size + SZ_64K, &load_end));
+	us = timer_get_us() - start;
+	ut_asserteq(size, load_end - load);
+	ut_asserteq_mem(expect, out, size);
+
+	free(out);
+	os_free(in);
+	os_free(expect);
+	bench_report(genimg_get_comp_short_name(comp), "bytes", size, us);
+
+	return 0;
+}
+
+static int bench_test_gzip(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_GZIP))
+		return -EAGAIN;
+
+	return bench_decomp(uts, IH_COMP_GZIP, "bench.bin.gz");
+}
+BENCH_TEST(bench_test_gzip, 0);
+
+static int bench_test_lz4(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_LZ4))
+		return -EAGAIN;
+
+	return bench_decomp(uts, IH_COMP_LZ4, "bench.bin.lz4");
+}
+BENCH_TEST(bench_test_lz4, 0);
+
+static int bench_test_zstd(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_ZSTD))
+		return -EAGAIN;
+
+	return bench_decomp(uts, IH_COMP_ZSTD, "bench.bin.zst");
+}
+BENCH_TEST(bench_test_zstd, 0);
+
+static int bench_test_lzma(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_LZMA))
+		return -EAGAIN;
+
+	return bench_decomp(uts, IH_COMP_LZMA, "bench.bin.lzma");
+}
+BENCH_TEST(bench_test_lzma, 0);
+
+/* Check the format of a FIT and verify the hashes of all its images */
+static int bench_test_fit(struct unit_test_state *uts)
+{
+	ulong start, us;
+	void *fit;
+	int size, ret;
+
+	if (!IS_ENABLED(CONFIG_FIT))
+		return -EAGAIN;
+	ret = bench_read_file(uts, "bench.itb", &fit, &size);
+	if (ret)
+		return ret;
+
+	start = timer_get_us();
+	ut_assertok(fit_check_format(fit, size));
+	ut_asserteq(1, fit_all_image_verify(fit));
+	us = timer_get_us() - start;
+	os_free(fit);
+	bench_report("fit_verify", "bytes", size, us);
+
+	return 0;
+}
+BENCH_TEST(bench_test_fit, 0);
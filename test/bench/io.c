@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Benchmarks for block-device reads and file loads
+ *
+ * On sandbox these use images set up by test/py/tests/test_bench.py, attached
+ * to a host device. On other boards, set an environment variable to say what
+ * to read:
+ *
+ *	bench_blk=<interface> <dev>			e.g. "mmc 0"
+ *	bench_fs_<fs>=<interface> <dev:part> <file>	e.g. "mmc 0:1 /Image"
+ *
+ * where <fs> is fat, ext4 or squashfs.
+ */
+
+#include <blk.h>
+#include <dm.h>
+#include <env.h>
+#include <fs.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <os.h>
+#include <part.h>
+#include <sandbox_host.h>
+#include <time.h>
+#include <vsprintf.h>
+#include <dm/device-internal.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
+#include <linux/string.h>
+#include <test/bench.h>
+#include <test/ut.h>
+
+enum {
+	BENCH_BLK_CHUNK		= SZ_1M,
+	BENCH_BLK_MAX		= SZ_64M,	/* most to read from a device */
+	BENCH_BLK_PASSES	= 4,
+};
+
+/**
+ * struct bench_dev - a device to read from
+ *
+ * @host: Host device attached to a test image, or NULL if not used
+ * @desc: Block device, or NULL if @ifname and @dev_part are used
+ * @ifname: Interface name, from the environment
+ * @dev_part: Device and partition, from the environment
+ * @fname: File to load, for the filesystem benchmarks
+ * @spec: Copy of the environment variable, which the strings point into
+ */
+struct bench_dev {
+	struct udevice *host;
+	struct blk_desc *desc;
+	const char *ifname;
+	const char *dev_part;
+	const char *fname;
+	char *spec;
+};
+
+/*
+ * Find the device to use, from environment variable @var, or on sandbox by
+ * attaching the test image @img. Returns -EAGAIN if neither is available.
+ */
+static int bench_dev_get(struct unit_test_state *uts, const char *var,
+			 const char *img, struct bench_dev *bd)
+{
+	const char *val = env_get(var);
+	struct udevice *blk;
+	char fname[256];
+	char *p;
+
+	memset(bd, '\0', sizeof(*bd));
+	if (val) {
+		bd->spec = strdup(val);
+		ut_assertnonnull(bd->spec);
+		p = bd->spec;
+		bd->ifname = strsep(&p, " ");
+		bd->dev_part = strsep(&p, " ");
+		bd->fname = p;
+		ut_assertnonnull(bd->dev_part);
+		return 0;
+	}
+
+	if (!IS_ENABLED(CONFIG_SANDBOX) ||
+	    os_persistent_file(fname, sizeof(fname), img))
+		return -EAGAIN;
+	ut_assertok(host_create_attach_file("bench", fname, false,
+					    DEFAULT_BLKSZ, &bd->host));
+	ut_assertok(blk_get_from_parent(bd->host, &blk));
+	ut_assertok(device_probe(blk));
+	bd->desc = dev_get_uclass_plat(blk);
+	bd->fname = "/bench.bin";
+
+	return 0;
+}
+
+static int bench_dev_put(struct unit_test_state *uts, struct bench_dev *bd)
+{
+	free(bd->spec);
+	if (bd->host) {
+		ut_assertok(host_detach_file(bd->host));
+		ut_assertok(device_unbind(bd->host));
+	}
+
+	return 0;
+}
+
+static int bench_test_blk(struct unit_test_state *uts)
+{
+	struct blk_desc *desc;
+	struct bench_dev bd;
+	lbaint_t blk, count, chunk, n;
+	ulong start, us = 0;
+	void *buf;
+	int ret, i;
+
+	ret = bench_dev_get(uts, "bench_blk", "bench.ext4.img", &bd);
+	if (ret)
+		return ret;
+	desc = bd.desc;
+	if (!desc)
+		ut_assert(blk_get_device_by_str(bd.ifname, bd.dev_part,
+						&desc) >= 0);
+
+	chunk = BENCH_BLK_CHUNK / desc->blksz;
+	count = min_t(lbaint_t, desc->lba, BENCH_BLK_MAX / desc->blksz);
+	buf = malloc(BENCH_BLK_CHUNK);
+	ut_assertnonnull(buf);
+	for (i = 0; i < BENCH_BLK_PASSES; i++) {
+		start = timer_get_us();
+		for (blk = 0; blk < count; blk += n) {
+			n = min(chunk, count - blk);
+			ut_asserteq(n, blk_dread(desc, blk, n, buf));
+		}
+		us += timer_get_us() - start;
+	}
+	free(buf);
+	bench_report("blk_read", "bytes",
+		     (u64)count * desc->blksz * BENCH_BLK_PASSES, us);
+
+	return bench_dev_put(uts, &bd);
+}
+BENCH_TEST(bench_test_blk, 0);
+
+/* Select the filesystem again, since each operation closes it */
+static int bench_fs_set(struct bench_dev *bd)
+{
+	if (bd->desc)
+		return fs_set_blk_dev_with_part(bd->desc, 0);
+
+	return fs_set_blk_dev(bd->ifname, bd->dev_part, FS_TYPE_ANY);
+}
+
+static int bench_fs_load(struct unit_test_state *uts, const char *name,
+			 const char *img)
+{
+	struct bench_dev bd;
+	loff_t size, actread;
+	char var[20];
+	ulong start, us;
+	void *buf;
+	int ret;
+
+	snprintf(var, sizeof(var), "bench_%s", name);
+	ret = bench_dev_get(uts, var, img, &bd);
+	if (ret)
+		return ret;
+	ut_assertnonnull(bd.fname);
+
+	ut_assertok(bench_fs_set(&bd));
+	ut_assertok(fs_size(bd.fname, &size));
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+
+	ut_assertok(bench_fs_set(&bd));
+	start = timer_get_us();
+	ut_assertok(fs_read(bd.fname, map_to_sysmem(buf), 0, 0, &actread));
+	us = timer_get_us() - start;
+	ut_asserteq(size, actread);
+	free(buf);
+	bench_report(name, "bytes", actread, us);
+
+	return bench_dev_put(uts, &bd);
+}
+
+static int bench_test_fs_fat(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_FS_FAT))
+		return -EAGAIN;
+
+	return bench_fs_load(uts, "fs_fat", "bench.fat32.img");
+}
+BENCH_TEST(bench_test_fs_fat, 0);
+
+static int bench_test_fs_ext4(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_FS_EXT4))
+		return -EAGAIN;
+
+	return bench_fs_load(uts, "fs_ext4", "bench.ext4.img");
+}
+BENCH_TEST(bench_test_fs_ext4, 0);
+
+static int bench_test_fs_squashfs(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_FS_SQUASHFS))
+		return -EAGAIN;
+
+	return bench_fs_load(uts, "fs_squashfs", "bench.squashfs.img");
+}
+BENCH_TEST(bench_test_fs_squashfs, 0);
@@ -14,6 +14,7 @@
 #include <dm.h>
 #include <efi.h>
 #include <efi_loader.h>
+#include <env.h>
 #include <expo.h>
 #include <mapmem.h>
 #ifdef CONFIG_SANDBOX
@@ -454,6 +455,63 @@ static int bootflow_iter_disable(struct unit_test_state *uts)
 }
 BOOTSTD_TEST(bootflow_iter_disable, UTF_DM | UTF_SCAN_FDT | UTF_CONSOLE);
 
+/* Check that the bootflow recorded on the last boot is tried first */
+static int bootflow_cache(struct unit_test_state *uts)
+{
+	struct bootflow_iter iter;
+	struct bootflow bflow;
+	int ret, found;
+
+	if (!IS_ENABLED(CONFIG_BOOTFLOW_CACHE))
+		return -EAGAIN;
+
+	/* Record the first bootflow */
+	ut_assertok(env_set("bootflow_last", NULL));
+	bootstd_clear_glob();
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter,
+					BOOTFLOWIF_SKIP_GLOBAL, &bflow));
+	ut_asserteq_str("mmc1.bootdev.part_1", bflow.name);
+	ut_assertok(bootflow_cache_save(&bflow));
+	ut_asserteq_strn("mmc1.bootdev 1 extlinux mmc ", env_get("bootflow_last"));
+	bootflow_free(&bflow);
+	bootflow_iter_uninit(&iter);
+
+	/* It should come first, then not be found again by the scan */
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter,
+					BOOTFLOWIF_SKIP_GLOBAL, &bflow));
+	ut_assert(iter.flags & BOOTFLOWIF_CACHED);
+	ut_asserteq_str("mmc1.bootdev.part_1", bflow.name);
+	ut_asserteq_str("extlinux", bflow.method->name);
+	ut_asserteq(BOOTFLOWST_READY, bflow.state);
+	for (found = 0; !(ret = bootflow_scan_next(&iter, &bflow));) {
+		if (!strcmp("mmc1.bootdev.part_1", bflow.name) &&
+		    bflow.method == iter.cache_method)
+			found++;
+		bootflow_free(&bflow);
+	}
+	ut_asserteq(-ENODEV, ret);
+	ut_asserteq(0, found);
+	bootflow_iter_uninit(&iter);
+
+	/* A file with a different size is not used */
+	ut_assertok(env_set("bootflow_last",
+			    "mmc1.bootdev 1 extlinux mmc 1 /extlinux/extlinux.conf"));
+	ut_assertok(bootflow_scan_first(NULL, NULL, &iter,
+					BOOTFLOWIF_SKIP_GLOBAL, &bflow));
+	ut_assert(!(iter.flags & BOOTFLOWIF_CACHED));
+	ut_asserteq_str("mmc1.bootdev.part_1", bflow.name);
+
+	/* Dropping does nothing unless this is the recorded bootflow */
+	ut_assertok(bootflow_cache_drop(&bflow));
+	ut_assertnonnull(env_get("bootflow_last"));
+	bootflow_free(&bflow);
+	bootflow_iter_uninit(&iter);
+	ut_assertok(env_set("bootflow_last", NULL));
+
+	return 0;
+}
+BOOTSTD_TEST(bootflow_cache, UTF_DM | UTF_SCAN_FDT);
+
 /* Check 'bootflow scan' with a bootmeth ordering including a global bootmeth */
 static int bootflow_scan_glob_bootmeth(struct unit_test_state *uts)
 {
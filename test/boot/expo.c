@@ -7,6 +7,7 @@
 #include <command.h>
 #include <dm.h>
 #include <expo.h>
+#include <malloc.h>
 #include <menu.h>
 #include <video.h>
 #include <linux/input.h>
@@ -457,11 +458,13 @@ BOOTSTD_TEST(expo_object_menu, UTF_DM | UTF_SCAN_FDT);
 static int expo_render_image(struct unit_test_state *uts)
 {
 	struct scene_obj_menu *menu;
+	struct video_priv *vid_priv;
 	struct scene *scn, *scn2;
 	struct expo_action act;
 	struct scene_obj *obj;
 	struct udevice *dev;
 	struct expo *exp;
+	void *fb;
 	int id;
 
 	ut_assertok(uclass_first_device_err(UCLASS_VIDEO, &dev));
@@ -598,6 +601,15 @@ static int expo_render_image(struct unit_test_state *uts)
 	ut_asserteq(ITEM2, act.select.id);
 	ut_assertok(expo_render(exp));
 
+	/* drawing just the changes should give the same as a full redraw */
+	vid_priv = dev_get_uclass_priv(dev);
+	fb = malloc(vid_priv->fb_size);
+	ut_assertnonnull(fb);
+	memcpy(fb, vid_priv->fb, vid_priv->fb_size);
+	ut_assertok(expo_redraw(exp));
+	ut_asserteq_mem(fb, vid_priv->fb, vid_priv->fb_size);
+	free(fb);
+
 	/* make sure only the preview for the second item is shown */
 	obj = scene_obj_find(scn, ITEM1_PREVIEW, SCENEOBJT_NONE);
 	ut_asserteq(true, obj->flags & SCENEOF_HIDE);
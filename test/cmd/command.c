@@ -106,3 +106,31 @@ static int command_test(struct unit_test_state *uts)
 	return 0;
 }
 CMD_TEST(command_test, 0);
+
+/* Test that command lookup finds the same commands as a search of the table */
+static int command_test_find(struct unit_test_state *uts)
+{
+	struct cmd_tbl *start = ll_entry_start(struct cmd_tbl, cmd);
+	const int count = ll_entry_count(struct cmd_tbl, cmd);
+	char name[64];
+	int i, len;
+
+	for (i = 0; i < count; i++) {
+		strlcpy(name, start[i].name, sizeof(name));
+		for (len = strlen(name); len; len--) {
+			name[len] = '\0';
+			ut_asserteq_ptr(find_cmd_tbl(name, start, count),
+					find_cmd(name));
+		}
+	}
+
+	ut_asserteq_str("?", find_cmd("?")->name);
+	ut_asserteq_str("echo", find_cmd("echo")->name);
+	ut_asserteq_str("md", find_cmd("md.b")->name);
+	ut_assertnull(find_cmd("no-such-command"));
+	ut_assertnull(find_cmd(""));
+	ut_assertnull(find_cmd(NULL));
+
+	return 0;
+}
+CMD_TEST(command_test_find, 0);
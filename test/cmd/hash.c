@@ -102,3 +102,59 @@ static int dm_test_cmd_hash_sha256(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_cmd_hash_sha256, UTF_CONSOLE);
+
+static int dm_test_cmd_hash_xxh64(struct unit_test_state *uts)
+{
+	if (!CONFIG_IS_ENABLED(XXH64)) {
+		ut_assert(run_command("hash xxh64 $loadaddr 0", 0));
+
+		return 0;
+	}
+
+	ut_assertok(run_command("hash xxh64 $loadaddr 0", 0));
+	console_record_readline(uts->actual_str, sizeof(uts->actual_str));
+	ut_asserteq_ptr(uts->actual_str,
+			strstr(uts->actual_str, "xxh64 for "));
+	ut_assert(strstr(uts->actual_str, "ef46db3751d8e999"));
+	ut_assert_console_end();
+
+	/* "abc" */
+	ut_assertok(run_command("mw.b 1000 61; mw.b 1001 62; mw.b 1002 63",
+				0));
+	ut_assertok(run_command("hash xxh64 1000 3", 0));
+	console_record_readline(uts->actual_str, sizeof(uts->actual_str));
+	ut_assert(strstr(uts->actual_str, "44bc2cf5ad770999"));
+	ut_assert_console_end();
+
+	return 0;
+}
+DM_TEST(dm_test_cmd_hash_xxh64, UTF_CONSOLE);
+
+static int dm_test_cmd_hash_multi(struct unit_test_state *uts)
+{
+	if (!CONFIG_IS_ENABLED(SHA256)) {
+		ut_assert(run_command("hash -m sha256 $loadaddr 0 $loadaddr 0",
+				      0));
+
+		return 0;
+	}
+
+	ut_assertok(run_command("hash -m sha256 $loadaddr 0 $loadaddr 0", 0));
+	console_record_readline(uts->actual_str, sizeof(uts->actual_str));
+	ut_asserteq_ptr(uts->actual_str,
+			strstr(uts->actual_str, "sha256 for "));
+	ut_assert(strstr(uts->actual_str,
+			 "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+	console_record_readline(uts->actual_str, sizeof(uts->actual_str));
+	ut_assert(strstr(uts->actual_str,
+			 "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+	ut_assert_console_end();
+
+	/* the areas must come in pairs */
+	ut_assert(run_command("hash -m sha256 $loadaddr", 0));
+	ut_assertok(ut_check_console_line(uts,
+					  "hash - compute hash message digest"));
+
+	return 0;
+}
+DM_TEST(dm_test_cmd_hash_multi, UTF_CONSOLE);
@@ -96,6 +96,7 @@ int cmd_ut_category(struct unit_test_state *uts, const char *name,
 
 SUITE_DECL(addrmap);
 SUITE_DECL(bdinfo);
+SUITE_DECL(bench);
 SUITE_DECL(bloblist);
 SUITE_DECL(bootm);
 SUITE_DECL(bootstd);
@@ -123,6 +124,7 @@ SUITE_DECL(upl);
 static struct suite suites[] = {
 	SUITE(addrmap, "very basic test of addrmap command"),
 	SUITE(bdinfo, "bdinfo (board info) command"),
+	SUITE(bench, "performance benchmarks"),
 	SUITE(bloblist, "bloblist implementation"),
 	SUITE(bootm, "bootm command"),
 #ifdef CONFIG_UT_BOOTSTD
@@ -606,3 +606,38 @@ static int bloblist_test_blob_maxsize(struct unit_test_state *uts)
 	return 0;
 }
 BLOBLIST_TEST(bloblist_test_blob_maxsize, UFT_BLOBLIST);
+
+/* Test looking up more tags than the index holds, before and after a resize */
+static int bloblist_test_many_tags(struct unit_test_state *uts)
+{
+	const int count = 40;
+	u32 *data;
+	int i;
+
+	clear_bloblist();
+	ut_assertok(bloblist_new(TEST_ADDR, TEST_BLOBLIST_SIZE, 0, 0));
+	for (i = 0; i < count; i++) {
+		/* look up a missing tag each time, to build the index */
+		ut_assertnull(bloblist_find(TEST_TAG_MISSING, 0));
+		data = bloblist_add(TEST_TAG_MISSING + 1 + i, sizeof(*data), 0);
+		ut_assertnonnull(data);
+		*data = i;
+	}
+	for (i = 0; i < count; i++) {
+		data = bloblist_find(TEST_TAG_MISSING + 1 + i, sizeof(*data));
+		ut_assertnonnull(data);
+		ut_asserteq(i, *data);
+	}
+	ut_assertnull(bloblist_find(TEST_TAG_MISSING, 0));
+
+	/* grow the first blob, so that all the others move */
+	ut_assertok(bloblist_resize(TEST_TAG_MISSING + 1, 0x20));
+	for (i = 1; i < count; i++) {
+		data = bloblist_find(TEST_TAG_MISSING + 1 + i, sizeof(*data));
+		ut_assertnonnull(data);
+		ut_asserteq(i, *data);
+	}
+
+	return 0;
+}
+BLOBLIST_TEST(bloblist_test_many_tags, UFT_BLOBLIST);
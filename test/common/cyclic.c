@@ -37,3 +37,55 @@ static int dm_test_cyclic_running(struct unit_test_state *uts)
 	return 0;
 }
 COMMON_TEST(dm_test_cyclic_running, 0);
+
+static struct cyclic_test cyclic_test_late;
+
+/* Test that functions are run in deadline order, and only when due */
+static int dm_test_cyclic_order(struct unit_test_state *uts)
+{
+	struct cyclic_info *cyclic;
+	bool seen_late = false;
+
+	cyclic_register(&cyclic_test.cyclic, test_cb, 1000 * 1000,
+			"cyclic_test");
+	cyclic_register(&cyclic_test_late.cyclic, test_cb, 10 * 1000,
+			"cyclic_test_late");
+
+	/* both are due straight away */
+	cyclic_test.called = false;
+	cyclic_test_late.called = false;
+	schedule();
+	ut_asserteq(true, cyclic_test.called);
+	ut_asserteq(true, cyclic_test_late.called);
+	ut_asserteq(1, cyclic_test.cyclic.run_cnt);
+
+	/* the one with the shorter delay is now ahead in the list */
+	hlist_for_each_entry(cyclic, cyclic_get_list(), list) {
+		if (cyclic == &cyclic_test_late.cyclic)
+			seen_late = true;
+		if (cyclic == &cyclic_test.cyclic)
+			break;
+	}
+	ut_asserteq(true, seen_late);
+
+	/* neither is due yet */
+	cyclic_test.called = false;
+	cyclic_test_late.called = false;
+	schedule();
+	ut_asserteq(false, cyclic_test.called);
+	ut_asserteq(false, cyclic_test_late.called);
+
+	/* only the short one becomes due */
+	mdelay(20);
+	schedule();
+	ut_asserteq(false, cyclic_test.called);
+	ut_asserteq(true, cyclic_test_late.called);
+	ut_assert(cyclic_test_late.cyclic.run_cnt >= 2);
+	ut_asserteq(1, cyclic_test.cyclic.run_cnt);
+
+	cyclic_unregister(&cyclic_test_late.cyclic);
+	cyclic_unregister(&cyclic_test.cyclic);
+
+	return 0;
+}
+COMMON_TEST(dm_test_cyclic_order, 0);
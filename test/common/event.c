@@ -6,6 +6,7 @@
  * Written by Simon Glass <sjg@chromium.org>
  */
 
+#include <command.h>
 #include <dm.h>
 #include <event.h>
 #include <test/common.h>
@@ -51,6 +52,9 @@ static int test_event_base(struct unit_test_state *uts)
 	ut_assertok(event_notify(EVT_TEST, &signal, sizeof(signal)));
 	ut_asserteq(12 + 17, state.val);
 
+	/* Check that an invalid type is rejected */
+	ut_asserteq(-EINVAL, event_register("bad", EVT_COUNT, h_adder, &state));
+
 	return 0;
 }
 COMMON_TEST(test_event_base, 0);
@@ -67,6 +71,31 @@ static int test_event_simple(struct unit_test_state *uts)
 }
 COMMON_TEST(test_event_simple, 0);
 
+static int test_event_stats(struct unit_test_state *uts)
+{
+	const struct event_stats *stats;
+	uint count;
+
+	if (!CONFIG_IS_ENABLED(EVENT_STATS))
+		return -EAGAIN;
+
+	stats = event_get_stats(EVT_TEST);
+	ut_assertnonnull(stats);
+	count = stats->count;
+	ut_assertok(event_notify_null(EVT_TEST));
+	ut_assertok(event_notify_null(EVT_TEST));
+	ut_asserteq(count + 2, stats->count);
+	ut_assertnull(event_get_stats(EVT_COUNT));
+
+	/* Check the output of the command */
+	ut_assertok(run_command("event stats", 0));
+	ut_assert_nextline("Type                     Count   Time (us)");
+	ut_assert_skip_to_linen("1   test                 %6u", count + 2);
+
+	return 0;
+}
+COMMON_TEST(test_event_stats, UTF_CONSOLE);
+
 static int h_probe(void *ctx, struct event *event)
 {
 	struct test_state *test_state = ctx;
@@ -0,0 +1,109 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for malloc(), which apply to either allocator
+ */
+
+#include <malloc.h>
+#include <time.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
+
+enum {
+	BENCH_OBJS	= 2000,
+	BENCH_ROUNDS	= 20,
+};
+
+/* Test the basic operations and that they do not leak */
+static int malloc_test_basic(struct unit_test_state *uts)
+{
+	struct mallinfo start = mallinfo();
+	char *ptr, *ptr2;
+	int i;
+
+	ptr = malloc(100);
+	ut_assertnonnull(ptr);
+	ut_assert(malloc_usable_size(ptr) >= 100);
+	for (i = 0; i < 100; i++)
+		ptr[i] = i;
+
+	ptr = realloc(ptr, 10000);
+	ut_assertnonnull(ptr);
+	for (i = 0; i < 100; i++)
+		ut_asserteq((char)i, ptr[i]);
+	free(ptr);
+
+	ptr = memalign(4096, 200);
+	ut_assertnonnull(ptr);
+	ut_assert(IS_ALIGNED((ulong)ptr, 4096));
+	ut_assert(malloc_usable_size(ptr) >= 200);
+
+	ptr2 = calloc(50, 20);
+	ut_assertnonnull(ptr2);
+	for (i = 0; i < 1000; i++)
+		ut_asserteq(0, ptr2[i]);
+	free(ptr);
+	free(ptr2);
+
+	ut_asserteq(start.uordblks, mallinfo().uordblks);
+
+	return 0;
+}
+COMMON_TEST(malloc_test_basic, 0);
+
+/*
+ * Time an allocation pattern like that of boot: many small objects of mixed
+ * sizes, with some freed and reallocated along the way, and a few large
+ * buffers. Run this with each allocator to compare them.
+ */
+static int malloc_test_bench(struct unit_test_state *uts)
+{
+	static const ushort sizes[] = {
+		16, 24, 40, 64, 72, 96, 128, 200, 256, 400, 512, 1024,
+	};
+	struct mallinfo start = mallinfo();
+	void **objs;
+	ulong start_us, duration;
+	int round, i;
+
+	objs = calloc(BENCH_OBJS, sizeof(*objs));
+	ut_assertnonnull(objs);
+
+	start_us = timer_get_us();
+	for (round = 0; round < BENCH_ROUNDS; round++) {
+		void *big;
+
+		for (i = 0; i < BENCH_OBJS; i++) {
+			objs[i] = malloc(sizes[(i * 7 + round) % ARRAY_SIZE(sizes)]);
+			ut_assertnonnull(objs[i]);
+		}
+		big = malloc(SZ_64K << (round % 4));
+		ut_assertnonnull(big);
+
+		/* free every third object and allocate others in their place */
+		for (i = 0; i < BENCH_OBJS; i += 3) {
+			free(objs[i]);
+			objs[i] = malloc(sizes[(i + round) % ARRAY_SIZE(sizes)]);
+			ut_assertnonnull(objs[i]);
+		}
+		for (i = 1; i < BENCH_OBJS; i += 5) {
+			objs[i] = realloc(objs[i], 2048);
+			ut_assertnonnull(objs[i]);
+		}
+		free(big);
+		for (i = 0; i < BENCH_OBJS; i++)
+			free(objs[i]);
+	}
+	duration = timer_get_us() - start_us;
+	free(objs);
+
+	printf("%s: %d rounds of %d objects in %lu us\n",
+	       IS_ENABLED(CONFIG_SYS_MALLOC_ARENA) ? "arena" : "dlmalloc",
+	       BENCH_ROUNDS, BENCH_OBJS, duration);
+	ut_asserteq(start.uordblks, mallinfo().uordblks);
+
+	return 0;
+}
+COMMON_TEST(malloc_test_bench, 0);
@@ -6,6 +6,12 @@
  */
 
 #include <autoboot.h>
+#include <command.h>
+#include <cyclic.h>
+#include <env.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <os.h>
 #include <test/common.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -91,3 +97,83 @@ static int test_autoboot(struct unit_test_state *uts)
 	return CMD_RET_SUCCESS;
 }
 COMMON_TEST(test_autoboot, UTF_CONSOLE);
+
+#ifdef CONFIG_AUTOBOOT_PRELOAD
+/* Test reading a file in the background and then loading it from memory */
+static int test_autoboot_preload(struct unit_test_state *uts)
+{
+	const int size = CONFIG_AUTOBOOT_PRELOAD_CHUNK * 2 + 0x100;
+	const char *cmd = "load hostfs - 1000000 preload.bin";
+	u8 *buf;
+	int i;
+
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+	for (i = 0; i < size; i++)
+		buf[i] = i;
+	ut_assertok(os_write_file("preload.bin", buf, size));
+	free(buf);
+
+	ut_assertok(env_set("bootpreload", "hostfs - 1000000 preload.bin"));
+	ut_asserteq(1, autoboot_preload_start());
+
+	/* one call for the size, then one for each chunk */
+	for (i = 0; i < 4; i++)
+		schedule();
+	autoboot_preload_stop();
+
+	ut_assertok(run_command(cmd, 0));
+	ut_assert_nextline("%d bytes already loaded", size);
+	ut_assert_console_end();
+
+	/* once the data is changed, it must be read again */
+	buf = map_sysmem(0x1000000, size);
+	buf[size - 1] ^= 0xff;
+	unmap_sysmem(buf);
+	ut_assertok(run_command(cmd, 0));
+	ut_assert_nextlinen("%d bytes read in", size);
+	ut_assert_console_end();
+
+	/* a discarded preload is not used */
+	ut_asserteq(1, autoboot_preload_start());
+	for (i = 0; i < 4; i++)
+		schedule();
+	autoboot_preload_discard();
+	ut_assertok(run_command(cmd, 0));
+	ut_assert_nextlinen("%d bytes read in", size);
+	ut_assert_console_end();
+
+	/* a missing file is skipped */
+	ut_assertok(env_set("bootpreload", "hostfs - 1000000 missing.bin"));
+	ut_asserteq(1, autoboot_preload_start());
+	schedule();
+	autoboot_preload_stop();
+	ut_asserteq(-ENOENT, autoboot_preload_find("hostfs", "-", "missing.bin",
+						   0x1000000, 0, NULL));
+
+	autoboot_preload_discard();
+	ut_assertok(env_set("bootpreload", NULL));
+	os_unlink("preload.bin");
+
+	return 0;
+}
+COMMON_TEST(test_autoboot_preload, UTF_CONSOLE);
+
+/* Test that a list with too many files is rejected */
+static int test_autoboot_preload_max(struct unit_test_state *uts)
+{
+	ut_assertok(env_set("bootpreload",
+			    "hostfs - 1000000 a; hostfs - 2000000 b; "
+			    "hostfs - 3000000 c; hostfs - 4000000 d; "
+			    "hostfs - 5000000 e"));
+	ut_asserteq(-E2BIG, autoboot_preload_start());
+	ut_asserteq(-ENOENT, autoboot_preload_find("hostfs", "-", "a",
+						   0x1000000, 0, NULL));
+
+	autoboot_preload_discard();
+	ut_assertok(env_set("bootpreload", NULL));
+
+	return 0;
+}
+COMMON_TEST(test_autoboot_preload_max, 0);
+#endif
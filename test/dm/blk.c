@@ -5,6 +5,7 @@
 
 #include <blk.h>
 #include <dm.h>
+#include <os.h>
 #include <part.h>
 #include <sandbox_host.h>
 #include <usb.h>
@@ -334,3 +335,157 @@ static int dm_test_blk_foreach(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_foreach, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLOCK_CACHE)
+/* Test that the block cache serves reads spanning several cache lines */
+static int dm_test_blk_cache(struct unit_test_state *uts)
+{
+	struct block_cache_dev_stats dstats;
+	struct block_cache_stats stats;
+	char buf[16 * 16], out[8 * 16];
+	int i;
+
+	blkcache_free();
+	blkcache_configure(8, 32);
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i;
+
+	/* two separate reads, each filling one line of 8 blocks */
+	blkcache_fill(UCLASS_HOST, 7, 0, 8, 16, buf);
+	blkcache_fill(UCLASS_HOST, 7, 8, 8, 16, buf + 8 * 16);
+
+	/* blocks 4..11 straddle both lines */
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 7, 4, 8, 16, out));
+	ut_asserteq_mem(buf + 4 * 16, out, sizeof(out));
+
+	/* other devices and block sizes do not match */
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 6, 4, 8, 16, out));
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 7, 2, 4, 32, out));
+
+	/* one block past the cached range */
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 7, 9, 8, 16, out));
+
+	/* an erase drops just the blocks it covers */
+	blkcache_update(UCLASS_HOST, 7, 6, 1, 16, NULL);
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 7, 4, 8, 16, out));
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 7, 7, 8, 16, out));
+	ut_asserteq_mem(buf + 7 * 16, out, sizeof(out));
+
+	blkcache_stats(&stats);
+	ut_asserteq(2, stats.hits);
+	ut_asserteq(4, stats.misses);
+	ut_asserteq(2, stats.entries);
+	ut_asserteq(0, stats.dirty);
+
+	/* per-device counters, in order of first use */
+	ut_assertok(blkcache_dev_stats(0, &dstats));
+	ut_asserteq(UCLASS_HOST, dstats.iftype);
+	ut_asserteq(7, dstats.devnum);
+	ut_asserteq(2, dstats.hits);
+	ut_asserteq(3, dstats.misses);
+	ut_assertok(blkcache_dev_stats(1, &dstats));
+	ut_asserteq(6, dstats.devnum);
+	ut_asserteq(1, dstats.misses);
+	ut_asserteq(-ENOENT, blkcache_dev_stats(2, &dstats));
+
+	blkcache_invalidate(UCLASS_HOST, 7);
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 7, 7, 8, 16, out));
+	blkcache_free();
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache, 0);
+#endif
+
+/* Test queued asynchronous requests */
+static int dm_test_blk_async(struct unit_test_state *uts)
+{
+	char buf0[4 * DEFAULT_BLKSZ], buf1[4 * DEFAULT_BLKSZ];
+	char cmp[8 * DEFAULT_BLKSZ];
+	struct blk_req req0 = {
+		.op = BLK_REQ_READ, .start = 0, .blkcnt = 4, .buf = buf0,
+	};
+	struct blk_req req1 = {
+		.op = BLK_REQ_READ, .start = 4, .blkcnt = 4, .buf = buf1,
+	};
+	struct blk_req bad = {
+		.op = BLK_REQ_READ, .start = 1 << 30, .blkcnt = 1, .buf = buf1,
+	};
+	struct udevice *dev, *blk;
+	char fname[256];
+
+	ut_assertok(host_create_device("test", true, DEFAULT_BLKSZ, &dev));
+	ut_assertok(os_persistent_file(fname, sizeof(fname), "2MB.ext2.img"));
+	ut_assertok(host_attach_file(dev, fname));
+	ut_assertok(blk_get_from_parent(dev, &blk));
+
+	/* nothing happens until the requests are waited for */
+	ut_assertok(blk_submit(blk, &req0));
+	ut_assertok(blk_submit(blk, &req1));
+	ut_assertok(blk_submit(blk, &bad));
+	ut_assert(!req1.done);
+
+	/* waiting for the second request completes the first one too */
+	ut_asserteq(4, blk_wait(blk, &req1));
+	ut_assert(req0.done);
+	ut_asserteq(4, blk_wait(blk, &req0));
+	ut_asserteq(-EINVAL, blk_wait(blk, &bad));
+
+	ut_asserteq(8, blk_read(blk, 0, 8, cmp));
+	ut_asserteq_mem(cmp, buf0, sizeof(buf0));
+	ut_asserteq_mem(cmp + sizeof(buf0), buf1, sizeof(buf1));
+
+	/* a synchronous read completes earlier requests first */
+	ut_assertok(blk_submit(blk, &req1));
+	ut_asserteq(8, blk_read(blk, 0, 8, cmp));
+	ut_assert(req1.done);
+	ut_asserteq(4, blk_wait(blk, &req1));
+
+	return 0;
+}
+DM_TEST(dm_test_blk_async, UTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(BLK_STATS)
+/* Test the transfer statistics */
+static int dm_test_blk_stats(struct unit_test_state *uts)
+{
+	char buf[4 * DEFAULT_BLKSZ];
+	const struct blk_stats *stats;
+	struct udevice *dev, *blk;
+	char fname[256];
+
+	ut_assertok(host_create_device("test", true, DEFAULT_BLKSZ, &dev));
+	ut_assertok(os_persistent_file(fname, sizeof(fname), "2MB.ext2.img"));
+	ut_assertok(host_attach_file(dev, fname));
+	ut_assertok(blk_get_from_parent(dev, &blk));
+
+	stats = blk_get_stats(blk);
+	ut_assertnonnull(stats);
+	ut_asserteq(0, stats->reads);
+
+	ut_asserteq(4, blk_read(blk, 0, 4, buf));
+	ut_asserteq(1, stats->reads);
+	ut_asserteq(4 * DEFAULT_BLKSZ, stats->read_bytes);
+	ut_asserteq(1, stats->size_hist[2]);
+	ut_asserteq(0, stats->errors);
+
+	/* a read served by the block cache does not reach the driver */
+	if (CONFIG_IS_ENABLED(BLOCK_CACHE)) {
+		ut_asserteq(4, blk_read(blk, 0, 4, buf));
+		ut_asserteq(1, stats->reads);
+	}
+
+	/* a failed read is counted as an error */
+	ut_assert(blk_read(blk, 1 << 30, 1, buf) != 1);
+	ut_asserteq(2, stats->reads);
+	ut_asserteq(1, stats->errors);
+	ut_asserteq(1, stats->size_hist[0]);
+
+	blk_stats_reset(blk);
+	ut_asserteq(0, stats->reads);
+	ut_asserteq(0, stats->errors);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_stats, UTF_SCAN_FDT);
+#endif
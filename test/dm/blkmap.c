@@ -110,6 +110,43 @@ static int dm_test_blkmap_write(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_blkmap_write, 0);
 
+static int dm_test_blkmap_map(struct unit_test_state *uts)
+{
+	struct udevice *dev, *blk, *ldev, *lblk;
+	const struct mapping *m;
+
+	ut_assertok(blkmap_create("maptest", &dev));
+	ut_assertok(blk_get_from_parent(dev, &blk));
+
+	for (m = unordered_mapping; m->cnt; m++) {
+		ut_assertok(blkmap_map_mem(dev, m->src, m->cnt,
+					   unordered + m->dst * BLKSZ));
+	}
+
+	/* Blocks within a memory slice are used in place */
+	ut_asserteq_ptr(unordered, blk_map(blk, 1, 3));
+	ut_asserteq_ptr(unordered + BLKSZ, blk_map(blk, 2, 2));
+	ut_asserteq_ptr(unordered + 6 * BLKSZ, blk_map(blk, 4, 1));
+
+	/* But not across slices, or outside the map */
+	ut_assertnull(blk_map(blk, 0, 2));
+	ut_assertnull(blk_map(blk, 3, 2));
+	ut_assertnull(blk_map(blk, 8, 1));
+	ut_assertnull(blk_map(blk, 1, 0));
+
+	/* A linear slice passes the request on to its target */
+	ut_assertok(blkmap_create("maplinear", &ldev));
+	ut_assertok(blk_get_from_parent(ldev, &lblk));
+	ut_assertok(blkmap_map_linear(ldev, 0, 4, blk, 1));
+	ut_asserteq_ptr(unordered + BLKSZ, blk_map(lblk, 1, 2));
+	ut_assertnull(blk_map(lblk, 3, 2));
+
+	ut_assertok(blkmap_destroy(ldev));
+	ut_assertok(blkmap_destroy(dev));
+	return 0;
+}
+DM_TEST(dm_test_blkmap_map, 0);
+
 static int dm_test_blkmap_slicing(struct unit_test_state *uts)
 {
 	struct udevice *dev;
@@ -64,6 +64,11 @@ static struct driver_info driver_info_manual = {
 	.plat = &test_pdata_manual,
 };
 
+static struct driver_info driver_info_compact = {
+	.name = "test_drv",
+	.plat = &test_pdata_manual,
+};
+
 static struct driver_info driver_info_pre_reloc = {
 	.name = "test_pre_reloc_drv",
 	.plat = &test_pdata_pre_reloc,
@@ -1422,6 +1427,47 @@ static int dm_test_dev_get_mem(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_dev_get_mem, UTF_SCAN_FDT);
 
+/* Test that a device's data is allocated in as few blocks as possible */
+static int dm_test_dev_compact_alloc(struct unit_test_state *uts)
+{
+	const int align = 2 * sizeof(size_t);
+	struct dm_stats before, after;
+	struct udevice *dev;
+
+	if (!CONFIG_IS_ENABLED(DM_COMPACT_ALLOC))
+		return -EAGAIN;
+
+	dm_get_mem(&before);
+	ut_assertok(device_bind_by_name(uts->root, false, &driver_info_compact,
+					&dev));
+
+	/* the uclass plat follows the device in the same block */
+	ut_assert(dev_get_flags(dev) & DM_FLAG_COMPACT_PDATA);
+	ut_asserteq_ptr((void *)dev + ALIGN(sizeof(struct udevice), align),
+			dev_get_uclass_plat(dev));
+
+	/* the priv data and uclass priv data share a block */
+	ut_assertok(device_probe(dev));
+	ut_assert(dev_get_flags(dev) & DM_FLAG_COMPACT_PRIV);
+	ut_asserteq_ptr(dev_get_priv(dev) +
+			ALIGN(sizeof(struct dm_test_priv), align),
+			dev_get_uclass_priv(dev));
+
+	/* two blocks instead of four */
+	dm_get_mem(&after);
+	ut_asserteq(before.alloc_count + 2, after.alloc_count);
+	ut_asserteq(before.compact_count + 1, after.compact_count);
+
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assert(!(dev_get_flags(dev) & DM_FLAG_COMPACT_PRIV));
+	ut_assertnull(dev_get_priv(dev));
+	ut_assertnull(dev_get_uclass_priv(dev));
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_dev_compact_alloc, 0);
+
 /* Test uclass_try_first_device() */
 static int dm_test_try_first_device(struct unit_test_state *uts)
 {
@@ -122,3 +122,36 @@ static int dm_test_dma_rx(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_dma_rx, UTF_SCAN_FDT);
+
+/* Test that only large, separate copies are done with DMA */
+static int dm_test_dma_offload(struct unit_test_state *uts)
+{
+	size_t len = CONFIG_DMA_MEMCPY_THRESHOLD;
+	u8 *src, *dst;
+	int i;
+
+	src = malloc(len * 2);
+	ut_assertnonnull(src);
+	dst = malloc(len);
+	ut_assertnonnull(dst);
+	for (i = 0; i < len; i++)
+		src[i] = i;
+
+	memset(dst, '\0', len);
+	ut_assertok(dma_memcpy_offload(dst, src, len));
+	ut_asserteq_mem(src, dst, len);
+
+	/* too small, so left for the CPU */
+	memset(dst, '\0', len);
+	ut_asserteq(-E2BIG, dma_memcpy_offload(dst, src, len - 1));
+	ut_asserteq(0, dst[0]);
+
+	/* overlapping */
+	ut_asserteq(-E2BIG, dma_memcpy_offload(src + 1, src, len));
+
+	free(dst);
+	free(src);
+
+	return 0;
+}
+DM_TEST(dm_test_dma_offload, UTF_SCAN_FDT);
@@ -9,9 +9,8 @@
 /*
  * Basic test of the ECDSA uclass and ecdsa_verify()
  *
- * ECDSA implementations in u-boot are hardware-dependent. Until we have a
- * software implementation that can be compiled into the sandbox, all we can
- * test is the uclass support.
+ * Without the software verifier there is no ECDSA implementation in the
+ * sandbox, so all we can test is the uclass support.
  *
  * The uclass_get() test is redundant since ecdsa_verify() would also fail. We
  * run both functions in order to isolate the cause more clearly. i.e. is
@@ -31,8 +30,151 @@ static int dm_test_ecdsa_verify(struct unit_test_state *uts)
 
 	ut_assertok(uclass_get(UCLASS_ECDSA, &ucp));
 	ut_assertnonnull(ucp);
-	ut_asserteq(-ENODEV, ecdsa_verify(&info, NULL, 0, NULL, 0));
+	if (!IS_ENABLED(CONFIG_ECDSA_SW))
+		ut_asserteq(-ENODEV, ecdsa_verify(&info, NULL, 0, NULL, 0));
 
 	return 0;
 }
 DM_TEST(dm_test_ecdsa_verify, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/* Key, hash and signature of "U-Boot ECDSA test message\n", from openssl */
+static const u8 p256_x[] = {
+	0xd6, 0xea, 0xfe, 0x40, 0x32, 0xcd, 0x20, 0xf9,
+	0x86, 0x34, 0x14, 0x01, 0x6a, 0x36, 0x34, 0x50,
+	0xe6, 0x5c, 0x48, 0x0b, 0x32, 0xeb, 0xb9, 0x74,
+	0xd5, 0xdf, 0xdb, 0x05, 0xe1, 0x31, 0xb3, 0x20,
+};
+
+static const u8 p256_y[] = {
+	0x87, 0xc1, 0x29, 0x5a, 0xe1, 0x66, 0x3d, 0x3e,
+	0x1c, 0x2d, 0x76, 0x7d, 0x13, 0xec, 0x51, 0xd5,
+	0xc3, 0x86, 0x50, 0x56, 0xb1, 0x5c, 0xa6, 0x13,
+	0x88, 0x93, 0xbe, 0x7e, 0xc3, 0xc2, 0xed, 0x46,
+};
+
+static const u8 p256_hash[] = {
+	0x9c, 0x41, 0xbe, 0xbc, 0x16, 0x1e, 0x1e, 0x9b,
+	0x50, 0x7e, 0x5f, 0xb6, 0x09, 0x07, 0xf5, 0x80,
+	0x7b, 0x39, 0x44, 0xb3, 0x7d, 0x0c, 0x82, 0x36,
+	0x24, 0x67, 0xeb, 0x8b, 0x0b, 0x26, 0x3c, 0xd3,
+};
+
+static const u8 p256_sig[] = {
+	0xf4, 0xc2, 0xac, 0xfc, 0xa4, 0xf0, 0x57, 0xf3,
+	0x6c, 0xca, 0xcc, 0x38, 0x27, 0x0d, 0xc2, 0x13,
+	0xe1, 0xc6, 0x4f, 0x09, 0x79, 0xd5, 0x53, 0xbb,
+	0x6a, 0x77, 0x75, 0x46, 0xae, 0xeb, 0xbe, 0x6c,
+	0x40, 0x67, 0x90, 0x00, 0xb5, 0x01, 0xa8, 0x06,
+	0x57, 0x5f, 0x3d, 0x83, 0x67, 0xee, 0xe1, 0x81,
+	0x22, 0xda, 0xd0, 0x3a, 0xab, 0xe2, 0x19, 0x86,
+	0xa2, 0xf9, 0xb7, 0x98, 0x08, 0x01, 0xf0, 0x71,
+};
+
+static const u8 p384_x[] = {
+	0xa2, 0xf9, 0x2d, 0xd1, 0xb4, 0xc1, 0x89, 0xdd,
+	0x93, 0x88, 0xd4, 0x58, 0x2f, 0x52, 0x9d, 0x00,
+	0x70, 0xc0, 0x2b, 0x95, 0x4a, 0x2d, 0x2f, 0x64,
+	0x9d, 0x99, 0x69, 0x5d, 0x81, 0x14, 0x52, 0xce,
+	0x35, 0x30, 0x15, 0x87, 0xad, 0xc3, 0x8f, 0x2e,
+	0xa3, 0x3e, 0x81, 0x5e, 0xcd, 0xb7, 0x23, 0xaf,
+};
+
+static const u8 p384_y[] = {
+	0xa3, 0x5f, 0x71, 0xd8, 0xf6, 0x8d, 0x06, 0x94,
+	0x00, 0x42, 0xd3, 0x96, 0x12, 0x67, 0xc3, 0x21,
+	0x93, 0x64, 0xf2, 0x20, 0x79, 0x59, 0xfd, 0xf7,
+	0xcb, 0xd2, 0xeb, 0x81, 0xd5, 0x7f, 0x9f, 0x4c,
+	0xed, 0x11, 0x03, 0x7a, 0xcd, 0x5e, 0x41, 0x9e,
+	0x9a, 0xb2, 0xed, 0x27, 0x76, 0x05, 0x7a, 0x0a,
+};
+
+static const u8 p384_hash[] = {
+	0xf6, 0x37, 0x4d, 0xf3, 0x66, 0x83, 0x02, 0x38,
+	0x9e, 0x8c, 0x68, 0x9e, 0x2e, 0xf1, 0x19, 0x1b,
+	0xbc, 0xcb, 0x02, 0x33, 0xb3, 0xb3, 0x06, 0x65,
+	0x33, 0x15, 0xbe, 0x09, 0x4d, 0x07, 0x92, 0x5d,
+	0xc1, 0xee, 0x15, 0x99, 0x15, 0x4d, 0xaa, 0x07,
+	0xf0, 0x29, 0xcc, 0xc8, 0xe3, 0x66, 0x0b, 0xa9,
+};
+
+static const u8 p384_sig[] = {
+	0xd8, 0x09, 0x86, 0xaf, 0x91, 0xd1, 0x96, 0x0d,
+	0x1f, 0x9a, 0x9e, 0xd4, 0xb4, 0xfd, 0x22, 0x65,
+	0xcc, 0xa9, 0x83, 0xf7, 0x2f, 0xf3, 0xc7, 0x87,
+	0xb5, 0x4e, 0x95, 0xd2, 0xdd, 0xdf, 0x0f, 0x87,
+	0xcb, 0x8c, 0x12, 0xa7, 0x7f, 0xbe, 0x1b, 0xc1,
+	0x2f, 0xf1, 0x8e, 0xe6, 0xe1, 0x9f, 0x1b, 0x6f,
+	0x00, 0xd1, 0x01, 0xee, 0xc4, 0x38, 0x76, 0xf2,
+	0x1a, 0x9f, 0xaa, 0x61, 0x6e, 0x45, 0xb5, 0x4a,
+	0x7b, 0xca, 0xe4, 0x79, 0x0e, 0xd1, 0xab, 0x3d,
+	0x9e, 0x90, 0x6b, 0x31, 0x2f, 0xec, 0x79, 0x09,
+	0x34, 0x4b, 0x49, 0x9d, 0xac, 0x6b, 0xab, 0x26,
+	0x86, 0xd9, 0x78, 0xa4, 0x34, 0xe0, 0xa8, 0x28,
+};
+
+/* Check one signature, then that changing the hash or signature breaks it */
+static int ecdsa_check_sw(struct unit_test_state *uts, struct udevice *dev,
+			  const struct ecdsa_public_key *key, const u8 *hash,
+			  uint hash_len, const u8 *sig, uint sig_len)
+{
+	const struct ecdsa_ops *ops = device_get_ops(dev);
+	u8 buf[96];
+
+	ut_assertok(ops->verify(dev, key, hash, hash_len, sig, sig_len));
+
+	memcpy(buf, hash, hash_len);
+	buf[hash_len - 1] ^= 1;
+	ut_asserteq(-EPERM, ops->verify(dev, key, buf, hash_len, sig, sig_len));
+
+	memcpy(buf, sig, sig_len);
+	buf[sig_len - 1] ^= 1;
+	ut_asserteq(-EPERM, ops->verify(dev, key, hash, hash_len, buf, sig_len));
+	ut_asserteq(-EINVAL, ops->verify(dev, key, hash, hash_len, sig,
+					 sig_len - 1));
+
+	return 0;
+}
+
+/* Test the software ECDSA verifier */
+static int dm_test_ecdsa_sw(struct unit_test_state *uts)
+{
+	const struct ecdsa_ops *ops;
+	struct ecdsa_public_key key;
+	struct udevice *dev;
+	u8 bad_y[48];
+
+	if (!IS_ENABLED(CONFIG_ECDSA_SW))
+		return -EAGAIN;
+
+	ut_assertok(uclass_get_device_by_driver(UCLASS_ECDSA,
+						DM_DRIVER_GET(ecdsa_sw),
+						&dev));
+
+	key.curve_name = "prime256v1";
+	key.x = p256_x;
+	key.y = p256_y;
+	key.size_bits = 256;
+	ut_assertok(ecdsa_check_sw(uts, dev, &key, p256_hash,
+				   sizeof(p256_hash), p256_sig,
+				   sizeof(p256_sig)));
+
+	/* a point which is not on the curve must be rejected */
+	memcpy(bad_y, p256_y, sizeof(p256_y));
+	bad_y[0] ^= 1;
+	key.y = bad_y;
+	ops = device_get_ops(dev);
+	ut_asserteq(-EINVAL, ops->verify(dev, &key, p256_hash,
+					 sizeof(p256_hash), p256_sig,
+					 sizeof(p256_sig)));
+
+	key.curve_name = "secp384r1";
+	key.x = p384_x;
+	key.y = p384_y;
+	key.size_bits = 384;
+	ut_assertok(ecdsa_check_sw(uts, dev, &key, p384_hash,
+				   sizeof(p384_hash), p384_sig,
+				   sizeof(p384_sig)));
+
+	return 0;
+}
+DM_TEST(dm_test_ecdsa_sw, UTF_SCAN_PDATA | UTF_SCAN_FDT);
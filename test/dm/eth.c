@@ -515,6 +515,7 @@ static int sb_with_async_arp_handler(struct udevice *dev, void *packet,
 static int dm_test_eth_async_arp_reply(struct unit_test_state *uts)
 {
 	net_ping_ip = string_to_ip("1.1.2.2");
+	arp_cache_flush();
 
 	sandbox_eth_set_tx_handler(0, sb_with_async_arp_handler);
 	/* Used by all of the ut_assert macros in the tx_handler */
@@ -599,6 +600,7 @@ static int sb_with_async_ping_handler(struct udevice *dev, void *packet,
 static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 {
 	net_ping_ip = string_to_ip("1.1.2.2");
+	arp_cache_flush();
 
 	sandbox_eth_set_tx_handler(0, sb_with_async_ping_handler);
 	/* Used by all of the ut_assert macros in the tx_handler */
@@ -614,6 +616,49 @@ static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_eth_async_ping_reply, UTF_SCAN_FDT);
 
+static int sb_arp_count;
+
+static int sb_count_arp_handler(struct udevice *dev, void *packet,
+				unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+
+	if (ntohs(eth->et_protlen) == PROT_ARP)
+		sb_arp_count++;
+
+	sandbox_eth_arp_req_to_reply(dev, packet, len);
+	sandbox_eth_ping_req_to_reply(dev, packet, len);
+
+	return 0;
+}
+
+/* Check that a second ping to the same host does not need ARP */
+static int dm_test_eth_arp_cache(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_NET_ARP_CACHE))
+		return -EAGAIN;
+
+	net_ping_ip = string_to_ip("1.1.2.2");
+	arp_cache_flush();
+	sb_arp_count = 0;
+	sandbox_eth_set_tx_handler(0, sb_count_arp_handler);
+
+	env_set("ethact", "eth@10002000");
+	ut_assertok(net_loop(PING));
+	ut_asserteq(1, sb_arp_count);
+	ut_assertok(net_loop(PING));
+	ut_asserteq(1, sb_arp_count);
+
+	arp_cache_flush();
+	ut_assertok(net_loop(PING));
+	ut_asserteq(2, sb_arp_count);
+
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	return 0;
+}
+DM_TEST(dm_test_eth_arp_cache, UTF_SCAN_FDT);
+
 #if IS_ENABLED(CONFIG_IPV6_ROUTER_DISCOVERY)
 
 static u8 ip6_ra_buf[] = {0x60, 0xf, 0xc5, 0x4a, 0x0, 0x38, 0x3a, 0xff, 0xfe,
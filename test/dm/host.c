@@ -108,6 +108,51 @@ static int dm_test_host_dup(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_host_dup, UTF_SCAN_FDT);
 
+/* Test reading from a mapped file and the timing model */
+static int dm_test_host_mmap(struct unit_test_state *uts)
+{
+	char fname[256], buf[0x1000], expect[0x1000];
+	struct host_sb_plat *plat;
+	struct udevice *dev, *blk;
+	struct blk_desc *desc;
+	ulong start;
+	int fd;
+
+	ut_assertok(os_persistent_file(fname, sizeof(fname), "2MB.ext2.img"));
+	ut_assertok(host_create_attach_file("test", fname, false,
+					    DEFAULT_BLKSZ, &dev));
+	plat = dev_get_plat(dev);
+	ut_asserteq(IS_ENABLED(CONFIG_SANDBOX_HOST_MMAP), !!plat->map);
+	ut_assertok(blk_get_from_parent(dev, &blk));
+	desc = dev_get_uclass_plat(blk);
+
+	/* the superblock is in the second block */
+	fd = os_open(fname, OS_O_RDONLY);
+	ut_assert(fd >= 0);
+	ut_asserteq(sizeof(expect), os_read(fd, expect, sizeof(expect)));
+	os_close(fd);
+	ut_asserteq(8, blk_read(blk, 0, 8, buf));
+	ut_asserteq_mem(expect, buf, sizeof(buf));
+
+	/* reading past the end stops at the end */
+	ut_asserteq(1, blk_read(blk, desc->lba - 1, 8, buf));
+	ut_asserteq(0, blk_read(blk, desc->lba, 1, buf));
+
+	/* 1MB/s takes 4ms for 4KB, on top of the latency; avoid the cache */
+	host_set_timing(dev, 5000, 1);
+	start = timer_get_us();
+	ut_asserteq(8, blk_read(blk, 16, 8, buf));
+	ut_assert(timer_get_us() - start >= 5000 + sizeof(buf));
+	host_set_timing(dev, 0, 0);
+
+	ut_assertok(host_detach_file(dev));
+	ut_assertnull(plat->map);
+	ut_assertok(device_unbind(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_host_mmap, UTF_SCAN_FDT);
+
 /* Basic test of 'host' command */
 static int dm_test_cmd_host(struct unit_test_state *uts)
 {
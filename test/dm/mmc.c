@@ -4,11 +4,13 @@
  */
 
 #include <dm.h>
+#include <env.h>
 #include <mmc.h>
 #include <part.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
+#include "../../drivers/mmc/mmc_private.h"
 
 /*
  * Basic test of the mmc uclass. We could expand this by implementing an MMC
@@ -51,3 +53,46 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/* Test that the bus mode selected for a card is recorded and used again */
+static int dm_test_mmc_mode_cache(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	enum bus_mode mode;
+	struct mmc *mmc;
+	char expect[40];
+	uint caps;
+
+	if (!CONFIG_IS_ENABLED(MMC_MODE_CACHE))
+		return -EAGAIN;
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	mmc = find_mmc_device(0);
+	ut_assertnonnull(mmc);
+	mode = mmc->selected_mode;
+	ut_asserteq(1, mmc->bus_width);
+
+	ut_assertok(mmc_mode_cache_find(mmc, &caps));
+	ut_asserteq(MMC_CAP(mode) | MMC_MODE_1BIT, caps);
+
+	ut_assertok(env_set("mmc_modes", NULL));
+	ut_assertok(mmc_mode_cache_save());
+	snprintf(expect, sizeof(expect), "%08x%08x%08x%08x:%x:1", mmc->cid[0],
+		 mmc->cid[1], mmc->cid[2], mmc->cid[3], mode);
+	ut_asserteq_str(expect, env_get("mmc_modes"));
+
+	/* the card comes up in the same mode again */
+	mmc->has_init = 0;
+	ut_assertok(mmc_init(mmc));
+	ut_asserteq(mode, mmc->selected_mode);
+
+	/* a different card is not found */
+	mmc->cid[3] ^= 1;
+	ut_asserteq(-ENOENT, mmc_mode_cache_find(mmc, &caps));
+	mmc->cid[3] ^= 1;
+
+	ut_assertok(env_set("mmc_modes", NULL));
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_mode_cache, UTF_SCAN_PDATA | UTF_SCAN_FDT);
@@ -194,3 +194,53 @@ static int dm_test_part_get_info_by_type(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_part_get_info_by_type, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/* Check that a GPT is not read again until its blocks are written */
+static int dm_test_part_cache(struct unit_test_state *uts)
+{
+	char str_disk_guid[UUID_STR_LEN + 1];
+	struct disk_partition info;
+	struct blk_desc *desc;
+	void *buf;
+	struct disk_partition parts[] = {
+		{
+			.start = 48,
+			.size = 1,
+			.name = "test1",
+		},
+	};
+
+	if (!CONFIG_IS_ENABLED(PARTITION_CACHE))
+		return -EAGAIN;
+
+	ut_asserteq(2, blk_get_device_by_str("mmc", "2", &desc));
+	if (CONFIG_IS_ENABLED(RANDOM_UUID)) {
+		gen_rand_uuid_str(parts[0].uuid, UUID_STR_FORMAT_STD);
+		gen_rand_uuid_str(str_disk_guid, UUID_STR_FORMAT_STD);
+	}
+	ut_assertok(gpt_restore(desc, str_disk_guid, parts,
+				ARRAY_SIZE(parts)));
+	ut_assertok(part_get_info(desc, 1, &info));
+	ut_asserteq_str("test1", (char *)info.name);
+
+	/* wipe both headers behind the back of the cache */
+	buf = calloc(1, desc->blksz);
+	ut_assertnonnull(buf);
+	ut_asserteq(1, blk_write_uncached(desc->bdev, 1, 1, buf));
+	ut_asserteq(1, blk_write_uncached(desc->bdev, desc->lba - 1, 1, buf));
+	blkcache_invalidate(desc->uclass_id, desc->devnum);
+	ut_assertok(part_get_info(desc, 1, &info));
+	ut_asserteq_str("test1", (char *)info.name);
+
+	/* a write to the partition itself leaves the GPT alone */
+	ut_asserteq(1, blk_dwrite(desc, 48, 1, buf));
+	ut_assertok(part_get_info(desc, 1, &info));
+
+	/* a write to the GPT blocks drops it */
+	ut_asserteq(1, blk_dwrite(desc, 1, 1, buf));
+	ut_asserteq(-ENOENT, part_get_info(desc, 1, &info));
+	free(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_part_cache, UTF_SCAN_PDATA | UTF_SCAN_FDT);
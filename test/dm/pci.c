@@ -4,11 +4,14 @@
  */
 
 #include <dm.h>
+#include <env.h>
 #include <asm/io.h>
 #include <asm/test.h>
+#include <dm/device-internal.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
+#include "../../drivers/pci/pci_internal.h"
 
 /* Test that sandbox PCI works correctly */
 static int dm_test_pci_base(struct unit_test_state *uts)
@@ -486,3 +489,35 @@ static int dm_test_pci_phys_to_bus(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_pci_phys_to_bus, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/* Test that a bus scan only looks at the devices recorded last time */
+static int dm_test_pci_scan_cache(struct unit_test_state *uts)
+{
+	struct udevice *bus, *dev;
+
+	if (!IS_ENABLED(CONFIG_PCI_SCAN_CACHE))
+		return -EAGAIN;
+
+	/* devices in slots which were empty last time are found too */
+	ut_assertok(env_set("pci_scan", "b1 40=1234:5678"));
+	ut_assertok(uclass_get_device_by_seq(UCLASS_PCI, 1, &bus));
+	ut_assertok(dm_pci_bus_find_bdf(PCI_BDF(1, 0x08, 0), &dev));
+	ut_assertok(dm_pci_bus_find_bdf(PCI_BDF(1, 0x0c, 0), &dev));
+	ut_assertok(pci_scan_cache_save());
+	ut_asserteq_str("b1 40=1234:5678 60=1234:5678 80=1234:5678",
+			env_get("pci_scan"));
+
+	/* a device with different IDs makes the bus be scanned in full */
+	ut_assertok(env_set("pci_scan", "b1 40=1234:1111"));
+	ut_assertok(device_remove(bus, DM_REMOVE_NORMAL));
+	ut_assertok(device_probe(bus));
+	ut_assertok(dm_pci_bus_find_bdf(PCI_BDF(1, 0x0c, 0), &dev));
+
+	ut_assertok(pci_scan_cache_save());
+	ut_asserteq_str("b1 40=1234:5678 60=1234:5678 80=1234:5678",
+			env_get("pci_scan"));
+	ut_assertok(env_set("pci_scan", NULL));
+
+	return 0;
+}
+DM_TEST(dm_test_pci_scan_cache, UTF_SCAN_PDATA | UTF_SCAN_FDT);
@@ -125,3 +125,36 @@ static int dm_test_power_pmic_mc34708_rw_val(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_power_pmic_mc34708_rw_val, UTF_SCAN_FDT);
+
+/* Test writing a list of registers, in more than one transfer */
+static int dm_test_power_pmic_write_regs(struct unit_test_state *uts)
+{
+	struct pmic_reg_val regs[SANDBOX_PMIC_REG_COUNT + 8];
+	struct udevice *dev;
+	int i;
+
+	ut_assertok(pmic_get("sandbox_pmic", &dev));
+
+	/* the first eight registers are written twice; the later write wins */
+	for (i = 0; i < ARRAY_SIZE(regs); i++) {
+		regs[i].reg = i % SANDBOX_PMIC_REG_COUNT;
+		regs[i].val = 0xa0 ^ i;
+	}
+	ut_assertok(pmic_write_regs(dev, regs, ARRAY_SIZE(regs)));
+	for (i = 0; i < SANDBOX_PMIC_REG_COUNT; i++)
+		ut_asserteq(0xa0 ^ (i < 8 ? i + SANDBOX_PMIC_REG_COUNT : i),
+			    pmic_reg_read(dev, i));
+
+	/* a PMIC without write_regs() is written one register at a time */
+	ut_assertok(pmic_get("pmic@41", &dev));
+	regs[0].reg = REG_RTC_TIME;
+	regs[0].val = MC34708_PMIC_TEST_VAL;
+	regs[1].reg = REG_POWER_CTL2;
+	regs[1].val = 0x422300;
+	ut_assertok(pmic_write_regs(dev, regs, 2));
+	ut_asserteq(MC34708_PMIC_TEST_VAL, pmic_reg_read(dev, REG_RTC_TIME));
+	ut_asserteq(0x422300, pmic_reg_read(dev, REG_POWER_CTL2));
+
+	return 0;
+}
+DM_TEST(dm_test_power_pmic_write_regs, UTF_SCAN_FDT);
@@ -6,6 +6,7 @@
 
 #include <dm.h>
 #include <tpm_api.h>
+#include <tpm-v2.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -124,3 +125,32 @@ static int dm_test_tpm_autostart_reinit(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_tpm_autostart_reinit, UTF_SCAN_FDT);
+
+/* Test that extending a PCR in all banks takes a single TPM command */
+static int dm_test_tpm_pcr_extend_digests(struct unit_test_state *uts)
+{
+	struct tpml_digest_values digest_list;
+	struct tpm_chip_priv *priv;
+	struct udevice *dev;
+	uint count;
+
+	ut_assertok(get_tpm_version(TPM_V2, &dev));
+	ut_assertok(tpm_auto_start(dev));
+	priv = dev_get_uclass_priv(dev);
+
+	memset(&digest_list, '\0', sizeof(digest_list));
+	digest_list.count = 1;
+	digest_list.digests[0].hash_alg = TPM2_ALG_SHA256;
+	memset(&digest_list.digests[0].digest, 0xaa, TPM2_SHA256_DIGEST_SIZE);
+
+	/* the first extend checks the active banks */
+	ut_assertok(tpm2_pcr_extend_digests(dev, 0, &digest_list));
+	ut_assert(priv->banks_checked);
+
+	count = priv->xfer_count;
+	ut_assertok(tpm2_pcr_extend_digests(dev, 0, &digest_list));
+	ut_asserteq(count + 1, priv->xfer_count);
+
+	return 0;
+}
+DM_TEST(dm_test_tpm_pcr_extend_digests, UTF_SCAN_FDT);
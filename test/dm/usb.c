@@ -100,6 +100,33 @@ static int dm_test_usb_multi(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_usb_multi, UTF_SCAN_PDATA | UTF_SCAN_FDT);
 
+/* test that the ports are only scanned when usb_init() follows usb_init_async() */
+static int dm_test_usb_init_async(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+
+	state_set_skip_delays(true);
+	ut_assertok(usb_init_async());
+	ut_assert(!usb_started);
+	ut_asserteq(-ENODEV, uclass_get_device(UCLASS_MASS_STORAGE, 0, &dev));
+
+	ut_assertok(usb_init());
+	ut_assert(usb_started);
+	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 0, &dev));
+	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 2, &dev));
+	ut_assertok(usb_stop());
+
+	/* stopping drops the ports which were waiting to be scanned */
+	ut_assertok(usb_init_async());
+	ut_assertok(usb_stop());
+	ut_assertok(usb_init());
+	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 2, &dev));
+	ut_assertok(usb_stop());
+
+	return 0;
+}
+DM_TEST(dm_test_usb_init_async, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
 /* test that we have an associated ofnode with the usb device */
 static int dm_test_usb_fdt_node(struct unit_test_state *uts)
 {
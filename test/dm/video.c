@@ -475,6 +475,25 @@ static int dm_test_video_bmp24_32(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_video_bmp24_32, UTF_SCAN_PDATA | UTF_SCAN_FDT);
 
+/* Test drawing a zstd-compressed bitmap file */
+static int dm_test_video_bmp_zstd(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	ulong addr;
+
+	ut_assertok(uclass_find_first_device(UCLASS_VIDEO, &dev));
+	ut_assertnonnull(dev);
+	ut_assertok(sandbox_sdl_set_bpp(dev, VIDEO_BPP32));
+
+	/* this should look the same as the uncompressed image */
+	ut_assertok(read_file(uts, "tools/logos/denx-24bpp.bmp.zst", &addr));
+	ut_assertok(bmp_display(addr, 0, 0));
+	ut_asserteq(6827, compress_frame_buffer(uts, dev));
+
+	return 0;
+}
+DM_TEST(dm_test_video_bmp_zstd, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
 /* Test drawing a bitmap file on a 32bpp display */
 static int dm_test_video_bmp32(struct unit_test_state *uts)
 {
@@ -603,3 +622,73 @@ static int dm_test_video_truetype_bs(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_video_truetype_bs, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/* Test that redrawn TrueType text is the same, whether cached or not */
+static int dm_test_video_truetype_redraw(struct unit_test_state *uts)
+{
+	struct udevice *dev, *con;
+	const char *test_string = "Criticism may not be agreeable, but it is necessary.\nIt fulfils the same function as pain in the human body.\n";
+	int size;
+
+	ut_assertok(video_get_nologo(uts, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	vidconsole_put_string(con, test_string);
+	size = compress_frame_buffer(uts, dev);
+
+	ut_assertok(video_clear(dev));
+	vidconsole_position_cursor(con, 0, 0);
+	vidconsole_put_string(con, test_string);
+	ut_asserteq(size, compress_frame_buffer(uts, dev));
+
+	return 0;
+}
+DM_TEST(dm_test_video_truetype_redraw, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/* Test that drawing records the damaged region, which a sync clears */
+static int dm_test_video_damage(struct unit_test_state *uts)
+{
+	struct video_damage *damage;
+	struct video_priv *priv;
+	struct udevice *dev, *con;
+
+	ut_assertok(select_vidconsole(uts, "vidconsole0"));
+	ut_assertok(video_get_nologo(uts, &dev));
+	ut_assertok(uclass_get_device(UCLASS_VIDEO_CONSOLE, 0, &con));
+	ut_assertok(vidconsole_select_font(con, "8x16", 0));
+	priv = dev_get_uclass_priv(dev);
+	damage = &priv->damage;
+
+	ut_assertok(video_sync(dev, true));
+	ut_asserteq(0, damage->xend);
+
+	/* a character damages the whole of the lines it covers */
+	vidconsole_putc_xy(con, VID_TO_POS(40), 16, 'a');
+	ut_asserteq(0, damage->xstart);
+	ut_asserteq(16, damage->ystart);
+	ut_asserteq(priv->xsize, damage->xend);
+	ut_asserteq(32, damage->yend);
+
+	/* regions are merged and clipped to the display */
+	video_damage(dev, -5, priv->ysize - 2, 10, 10);
+	ut_asserteq(0, damage->xstart);
+	ut_asserteq(16, damage->ystart);
+	ut_asserteq(priv->xsize, damage->xend);
+	ut_asserteq(priv->ysize, damage->yend);
+
+	ut_assertok(video_sync(dev, true));
+	ut_asserteq(0, damage->xend);
+
+	video_damage(dev, 10, 20, 30, 40);
+	ut_asserteq(10, damage->xstart);
+	ut_asserteq(20, damage->ystart);
+	ut_asserteq(40, damage->xend);
+	ut_asserteq(60, damage->yend);
+
+	/* a region entirely off the display is ignored */
+	ut_assertok(video_sync(dev, true));
+	video_damage(dev, priv->xsize, 0, 10, 10);
+	ut_asserteq(0, damage->xend);
+
+	return 0;
+}
+DM_TEST(dm_test_video_damage, UTF_SCAN_PDATA | UTF_SCAN_FDT);
@@ -122,3 +122,62 @@ static int env_test_htab_deletes(struct unit_test_state *uts)
 	return 0;
 }
 ENV_TEST(env_test_htab_deletes, 0);
+
+/* Fill the hashtable well beyond its initial size, so that it has to grow */
+static int env_test_htab_grow(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	ut_assertok(htab_fill(uts, &htab, SIZE * 20));
+	ut_asserteq(SIZE * 20, htab.filled);
+	ut_assert(htab.size > SIZE * 20);
+	ut_assertok(htab_check_fill(uts, &htab, SIZE * 20));
+
+	/* a hit should need very few string compares */
+	ut_assert(htab.compares < htab.lookups);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+ENV_TEST(env_test_htab_grow, 0);
+
+/* Import a default environment in bulk, then change it */
+static int env_test_htab_bulk(struct unit_test_state *uts)
+{
+	static const char env[] = "a=1\0bb=2\0c=3\0a=4\0";
+	struct hsearch_data htab;
+	struct env_entry item, *ritem;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, himport_r(&htab, env, sizeof(env), '\0', H_DEFAULT, 0,
+				 0, NULL));
+	ut_assertnonnull(htab.bulk);
+	ut_asserteq(3, htab.filled);
+
+	item.key = "a";
+	item.data = NULL;
+	hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+	ut_assertnonnull(ritem);
+	ut_asserteq_str("4", ritem->data);
+
+	/* replacing and deleting must not free the shared strings */
+	item.data = "new";
+	ut_assert(hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	ut_asserteq_str("new", ritem->data);
+	ut_asserteq(0, hdelete_r("bb", &htab, 0));
+
+	item.key = "c";
+	item.data = NULL;
+	hsearch_r(item, ENV_FIND, &ritem, &htab, 0);
+	ut_assertnonnull(ritem);
+	ut_asserteq_str("3", ritem->data);
+
+	hdestroy_r(&htab);
+	ut_assertnull(htab.bulk);
+
+	return 0;
+}
+ENV_TEST(env_test_htab_bulk, 0);
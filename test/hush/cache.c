@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Tests for the cache of parsed hush scripts
+ */
+
+#include <command.h>
+#include <env.h>
+#include <test/hush.h>
+#include <test/ut.h>
+#include <asm/global_data.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Test that a cached script still expands variables each time it runs */
+static int hush_test_cache_expand(struct unit_test_state *uts)
+{
+	const char *script = "for cache_i in one two; do echo $cache_i $cache_var; done";
+	int i;
+
+	if (!(gd->flags & GD_FLG_HUSH_OLD_PARSER))
+		return -EAGAIN;
+
+	for (i = 0; i < 3; i++) {
+		ut_assertok(env_set_ulong("cache_var", i));
+		ut_assertok(run_command_list(script, -1, 0));
+		ut_assert_nextline("one %d", i);
+		ut_assert_nextline("two %d", i);
+		ut_assert_console_end();
+	}
+	ut_assertok(env_set("cache_var", NULL));
+
+	puts("Beware: this test set local variable cache_i and it cannot be unset!\n");
+
+	return 0;
+}
+HUSH_TEST(hush_test_cache_expand, UTF_CONSOLE);
+
+/* Test scripts which stop part-way through, or cannot be parsed */
+static int hush_test_cache_partial(struct unit_test_state *uts)
+{
+	int i;
+
+	if (!(gd->flags & GD_FLG_HUSH_OLD_PARSER))
+		return -EAGAIN;
+
+	for (i = 0; i < 3; i++) {
+		/* the loop must be intact after 'exit' cuts it short */
+		ut_assertok(run_command_list("for cache_j in a b; do echo $cache_j; exit; done", -1, 0));
+		ut_assert_nextline("a");
+		ut_assert_console_end();
+
+		/* a syntax error is reported each time, not only the first */
+		ut_assertok(run_command_list("echo first\nfi\necho last\n", -1, 0));
+		ut_assert_nextline("first");
+		ut_assert_nextline("syntax error");
+		ut_assert_nextline("last");
+		ut_assert_console_end();
+	}
+
+	puts("Beware: this test set local variable cache_j and it cannot be unset!\n");
+
+	return 0;
+}
+HUSH_TEST(hush_test_cache_partial, UTF_CONSOLE);
@@ -367,6 +367,60 @@ SPL_IMG_TEST(spl_test_image, IMX8, 0);
 SPL_IMG_TEST(spl_test_image, FIT_INTERNAL, 0);
 SPL_IMG_TEST(spl_test_image, FIT_EXTERNAL, 0);
 
+#if IS_ENABLED(CONFIG_SPL_LOAD_CHUNK)
+static int spl_test_load_chunk(struct unit_test_state *uts)
+{
+	const ulong img_size = 4096, offset = 100, size = 3000, bounce = 1024;
+	ulong bl_len = IS_ENABLED(CONFIG_SPL_LOAD_BLOCK) ? 512 : 1;
+	struct spl_load_info load;
+	struct spl_load_chunk it;
+	const void *data, *first = NULL;
+	char *img, *buf;
+	ulong len, pos;
+	int ret;
+
+	img = malloc(img_size);
+	ut_assertnonnull(img);
+	generate_data(img, img_size, "spl_test_load_chunk");
+	buf = malloc_cache_aligned(img_size);
+	ut_assertnonnull(buf);
+
+	spl_load_init(&load, spl_test_read, img, bl_len);
+	spl_set_chunk_size(&load, bounce);
+
+	/* Too small to hold the range, so every chunk reuses the buffer */
+	ut_assertok(spl_load_chunk_init(&it, &load, offset, size, buf, bounce));
+	for (pos = 0; (ret = spl_load_chunk_next(&it, &data, &len)) > 0;
+	     pos += len) {
+		ut_assert(len <= bounce);
+		ut_asserteq_mem(img + offset + pos, data, len);
+	}
+	ut_asserteq(0, ret);
+	ut_asserteq(size, pos);
+
+	/* Large enough, so the range ends up contiguous in the buffer */
+	ut_assertok(spl_load_chunk_init(&it, &load, offset, size, buf,
+					img_size));
+	for (pos = 0; (ret = spl_load_chunk_next(&it, &data, &len)) > 0;
+	     pos += len) {
+		if (!first)
+			first = data;
+		ut_asserteq_ptr(first + pos, data);
+	}
+	ut_asserteq(0, ret);
+	ut_asserteq(size, pos);
+	ut_asserteq_mem(img + offset, first, size);
+
+	ut_asserteq(-ENOBUFS, spl_load_chunk_init(&it, &load, offset, size,
+						  buf, 0));
+
+	free(buf);
+	free(img);
+	return 0;
+}
+SPL_TEST(spl_test_load_chunk, 0);
+#endif
+
 /*
  * LZMA is too complex to generate on the fly, so let's use some data I put in
  * the oven^H^H^H^H compressed earlier
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the scratch arena
+ */
+
+#include <arena.h>
+#include <memalign.h>
+#include <string.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <linux/sizes.h>
+
+/* Test basic allocation and that release rewinds the arena */
+static int lib_test_arena_basic(struct unit_test_state *uts)
+{
+	struct arena_mark mark, inner;
+	char *ptr, *ptr2, *str;
+	ulong start;
+
+	start = ut_check_free();
+
+	mark = arena_begin();
+	ptr = arena_alloc(10);
+	ut_assertnonnull(ptr);
+	ut_assert(IS_ALIGNED((ulong)ptr, sizeof(size_t)));
+	memset(ptr, 'a', 10);
+
+	ptr2 = arena_zalloc(100);
+	ut_assertnonnull(ptr2);
+	ut_assert(ptr2 >= ptr + 10);
+	ut_asserteq(0, ptr2[0]);
+	ut_asserteq(0, ptr2[99]);
+
+	str = arena_strdup("squashfs");
+	ut_assertnonnull(str);
+	ut_asserteq_str("squashfs", str);
+
+	ptr2 = arena_alloc_cache_aligned(1);
+	ut_assertnonnull(ptr2);
+	ut_assert(IS_ALIGNED((ulong)ptr2, ARCH_DMA_MINALIGN));
+
+	/* an inner scope must not disturb the outer one */
+	inner = arena_begin();
+	ptr2 = arena_alloc(20);
+	ut_assertnonnull(ptr2);
+	memset(ptr2, 'b', 20);
+	arena_release(inner);
+	ut_asserteq_ptr(ptr2, arena_alloc(20));
+	ut_asserteq('a', ptr[9]);
+	ut_asserteq_str("squashfs", str);
+
+	arena_release(mark);
+
+	/* the same memory is handed out again */
+	mark = arena_begin();
+	ut_asserteq_ptr(ptr, arena_alloc(10));
+	arena_release(mark);
+
+	/* nothing is left allocated apart from spare chunks */
+	ut_assert(ut_check_delta(start) <= 2 * SZ_16K + 2 * ARCH_DMA_MINALIGN);
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_basic, 0);
+
+/* Test allocations which need more than one chunk */
+static int lib_test_arena_large(struct unit_test_state *uts)
+{
+	struct arena_mark mark;
+	char *ptr, *big;
+	ulong start;
+	int i;
+
+	/* the first scope fills the spare list */
+	mark = arena_begin();
+	for (i = 0; i < 4; i++)
+		ut_assertnonnull(arena_alloc(SZ_8K));
+	arena_release(mark);
+
+	start = ut_check_free();
+	mark = arena_begin();
+	ptr = arena_alloc(100);
+	ut_assertnonnull(ptr);
+
+	/* an oversized request gets a chunk of its own */
+	big = arena_alloc(SZ_64K);
+	ut_assertnonnull(big);
+	memset(big, '\xff', SZ_64K);
+
+	/* small allocations still work afterwards */
+	for (i = 0; i < 100; i++)
+		ut_assertnonnull(arena_alloc(SZ_1K));
+
+	/* an impossible size fails cleanly */
+	ut_assertnull(arena_alloc(CONFIG_SYS_MALLOC_LEN));
+	arena_release(mark);
+
+	/* the oversized chunk is freed and the spares are back */
+	ut_asserteq(0, ut_check_delta(start));
+
+	return 0;
+}
+LIB_TEST(lib_test_arena_large, 0);
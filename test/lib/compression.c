@@ -22,6 +22,7 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <linux/sizes.h>
 #include <linux/zstd.h>
 #include <test/lib.h>
 #include <test/ut.h>
@@ -505,6 +506,99 @@ static int compression_test_zstd(struct unit_test_state *uts)
 }
 LIB_TEST(compression_test_zstd, 0);
 
+/* Concatenated zstd frames are all decompressed, in order */
+static int compression_test_zstd_frames(struct unit_test_state *uts)
+{
+	char in[2 * sizeof(zstd_compressed)], out[2 * sizeof(plain)];
+	struct abuf in_buf, out_buf;
+	int len = strlen(plain);
+
+	memcpy(in, zstd_compressed, zstd_compressed_size);
+	memcpy(in + zstd_compressed_size, zstd_compressed,
+	       zstd_compressed_size);
+	abuf_init_set(&in_buf, in, 2 * zstd_compressed_size);
+	abuf_init_set(&out_buf, out, sizeof(out));
+
+	ut_asserteq(2 * len, zstd_decompress(&in_buf, &out_buf));
+	ut_asserteq_mem(plain, out, len);
+	ut_asserteq_mem(plain, out + len, len);
+
+	return 0;
+}
+LIB_TEST(compression_test_zstd_frames, 0);
+
+/* zstd data can be decompressed a little at a time, within a window limit */
+static int compression_test_zstd_stream(struct unit_test_state *uts)
+{
+	struct zstd_stream st;
+	char out[sizeof(plain)];
+	int len = strlen(plain);
+	uint pos, chunk;
+
+	zstd_stream_init(&st, out, sizeof(out), SZ_1M);
+	for (pos = 0; pos < zstd_compressed_size; pos += chunk) {
+		chunk = min_t(uint, 7, zstd_compressed_size - pos);
+		ut_assertok(zstd_stream_add(&st, zstd_compressed + pos, chunk));
+	}
+	ut_asserteq(len, zstd_stream_finish(&st));
+	ut_asserteq_mem(plain, out, len);
+
+	/* stopping part-way through is an error */
+	zstd_stream_init(&st, out, sizeof(out), SZ_1M);
+	ut_assertok(zstd_stream_add(&st, zstd_compressed,
+				    zstd_compressed_size - 1));
+	ut_asserteq(-EINVAL, zstd_stream_finish(&st));
+
+	/* a frame needing a larger window is rejected */
+	zstd_stream_init(&st, out, sizeof(out), 16);
+	ut_asserteq(-E2BIG, zstd_stream_add(&st, zstd_compressed,
+					    zstd_compressed_size));
+	ut_asserteq(-EINVAL, zstd_stream_finish(&st));
+
+	/* running out of output space is reported */
+	zstd_stream_init(&st, out, len / 2, SZ_1M);
+	ut_asserteq(-ENOSPC, zstd_stream_add(&st, zstd_compressed,
+					     zstd_compressed_size));
+	zstd_stream_finish(&st);
+
+	return 0;
+}
+LIB_TEST(compression_test_zstd_stream, 0);
+
+/* An LZ4 frame can be decompressed a little at a time */
+static int compression_test_lz4_stream(struct unit_test_state *uts)
+{
+	struct ulz4_stream st;
+	char out[sizeof(plain)];
+	int len = strlen(plain);
+	uint pos, chunk;
+	size_t size;
+
+	ulz4_stream_init(&st, out, sizeof(out));
+	for (pos = 0; pos < lz4_compressed_size; pos += chunk) {
+		chunk = min_t(uint, 5, lz4_compressed_size - pos);
+		ut_assertok(ulz4_stream_add(&st, lz4_compressed + pos, chunk));
+	}
+	ut_assertok(ulz4_stream_finish(&st, &size));
+	ut_asserteq(len, size);
+	ut_asserteq_mem(plain, out, len);
+
+	/* stopping part-way through is an error */
+	ulz4_stream_init(&st, out, sizeof(out));
+	ut_assertok(ulz4_stream_add(&st, lz4_compressed,
+				    lz4_compressed_size - 8));
+	ut_asserteq(-EINVAL, ulz4_stream_finish(&st, &size));
+
+	/* running out of output space is reported */
+	ulz4_stream_init(&st, out, len / 2);
+	ut_asserteq(-EPROTO, ulz4_stream_add(&st, lz4_compressed,
+					     lz4_compressed_size));
+	ulz4_stream_finish(&st, &size);
+
+	return 0;
+}
+LIB_TEST(compression_test_lz4_stream, 0);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
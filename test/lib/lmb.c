@@ -8,7 +8,9 @@
 #include <lmb.h>
 #include <log.h>
 #include <malloc.h>
+#include <time.h>
 #include <dm/test.h>
+#include <linux/sizes.h>
 #include <test/lib.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -822,3 +824,56 @@ static int lib_test_lmb_flags(struct unit_test_state *uts)
 	return 0;
 }
 LIB_TEST(lib_test_lmb_flags, 0);
+
+/* Test allocating around a large number of reserved regions */
+static int lib_test_lmb_many_regions(struct unit_test_state *uts)
+{
+	const phys_addr_t ram = 0x40000000;
+	const phys_size_t ram_size = 0x20000000;
+	const phys_addr_t ram_end = ram + ram_size;
+	const int nregions = 1000;
+	const phys_addr_t first = ram_end - nregions * SZ_64K;
+	struct alist *mem_lst, *used_lst;
+	struct lmb store;
+	ulong start_us;
+	int i;
+
+	ut_assertok(setup_lmb_test(uts, &store, &mem_lst, &used_lst));
+	ut_assertok(lmb_add(ram, ram_size));
+
+	/* leave a 4KiB hole at the top of each 64KiB block of the top part */
+	for (i = 0; i < nregions; i++)
+		ut_assertok(lmb_reserve(first + i * SZ_64K, SZ_64K - SZ_4K,
+					LMB_NONE));
+	ut_asserteq(nregions, used_lst->count);
+
+	/* this does not fit in any of the holes, so goes below them all */
+	start_us = timer_get_us();
+	ut_asserteq(first - SZ_8K, lmb_alloc(SZ_8K, SZ_4K));
+
+	/* fill the holes from the top down, merging the regions as we go */
+	for (i = 0; i < nregions; i++)
+		ut_asserteq(ram_end - SZ_4K - i * SZ_64K,
+			    lmb_alloc(SZ_4K, SZ_4K));
+	printf("%d allocations with %d regions took %lu us\n", nregions + 1,
+	       nregions, timer_get_us() - start_us);
+
+	ASSERT_LMB(mem_lst, used_lst, ram, ram_size, 1, first - SZ_8K,
+		   ram_end - first + SZ_8K, 0, 0, 0, 0);
+
+	/* free every other hole again and check lookups still work */
+	for (i = 0; i < nregions; i += 2)
+		ut_assertok(lmb_free(first + i * SZ_64K + SZ_64K - SZ_4K,
+				     SZ_4K));
+	ut_asserteq(nregions / 2 + 1, used_lst->count);
+	ut_asserteq(SZ_4K, lmb_get_free_size(first + SZ_64K - SZ_4K));
+	ut_asserteq(0, lmb_get_free_size(first + SZ_64K));
+	ut_asserteq(1, lmb_is_reserved_flags(first, LMB_NONE));
+	ut_asserteq(0, lmb_is_reserved_flags(first + SZ_64K - SZ_4K,
+					     LMB_NONE));
+
+	lmb_pop(&store);
+
+	return 0;
+}
+LIB_TEST(lib_test_lmb_many_regions, 0);
@@ -8,6 +8,7 @@
 
 #include <command.h>
 #include <image.h>
+#include <time.h>
 #include <test/lib.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -200,4 +201,47 @@ static int lib_rsa_verify_invalid(struct unit_test_state *uts)
 	return CMD_RET_SUCCESS;
 }
 LIB_TEST(lib_rsa_verify_invalid, 0);
+
+/**
+ * lib_rsa_verify_speed() - time rsa_verify() with a series of signatures
+ *
+ * The key properties are only generated for the first verification, as
+ * happens with a chain of images signed with the same key.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_rsa_verify_speed(struct unit_test_state *uts)
+{
+	struct image_sign_info info;
+	struct image_region reg;
+	ulong start, first;
+	int i, ret;
+
+	memset(&info, '\0', sizeof(info));
+	info.name = "sha256,rsa2048";
+	info.padding = image_get_padding_algo("pkcs-1.5");
+	info.checksum = image_get_checksum_algo("sha256,rsa2048");
+	info.crypto = image_get_crypto_algo(info.name);
+
+	info.key = public_key;
+	info.keylen = public_key_len;
+
+	reg.data = data_raw;
+	reg.size = data_raw_len;
+	start = timer_get_us();
+	ut_assertok(rsa_verify(&info, &reg, 1, data_enc, data_enc_len));
+	first = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < 20; i++) {
+		ret = rsa_verify(&info, &reg, 1, data_enc, data_enc_len);
+		ut_assertf(ret == 0, "verification %d failed (%d)\n", i, ret);
+	}
+	printf("RSA-2048 verify: first %lu us, then %lu us each\n", first,
+	       (timer_get_us() - start) / 20);
+
+	return CMD_RET_SUCCESS;
+}
+LIB_TEST(lib_rsa_verify_speed, 0);
 #endif /* RSA_VERIFY_WITH_PKEY */
@@ -11,6 +11,8 @@
 
 #include <command.h>
 #include <log.h>
+#include <malloc.h>
+#include <time.h>
 #include <test/lib.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -221,3 +223,209 @@ static int lib_memdup(struct unit_test_state *uts)
 	return 0;
 }
 LIB_TEST(lib_memdup, 0);
+
+/**
+ * lib_strlen() - unit test for strlen() and strnlen()
+ *
+ * Test with varied alignment and length of the string, with the bytes after
+ * the terminator left non-zero.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_strlen(struct unit_test_state *uts)
+{
+	char buf[BUFLEN];
+	int offset, len;
+
+	for (offset = 0; offset <= SWEEP; ++offset) {
+		for (len = 0; len < BUFLEN - SWEEP; ++len) {
+			init_buffer((u8 *)buf, 0x80);
+			buf[offset + len] = '\0';
+			ut_asserteq(len, strlen(buf + offset));
+			ut_asserteq(len, strnlen(buf + offset, len));
+			ut_asserteq(len, strnlen(buf + offset, len + 1));
+			ut_asserteq(len, strnlen(buf + offset, SIZE_MAX));
+			if (len)
+				ut_asserteq(len - 1,
+					    strnlen(buf + offset, len - 1));
+		}
+	}
+	return 0;
+}
+LIB_TEST(lib_strlen, 0);
+
+/* Reduce the result of a comparison to -1, 0 or 1 */
+static int cmp_sign(int val)
+{
+	return (val > 0) - (val < 0);
+}
+
+/**
+ * lib_strcmp() - unit test for strcmp() and strncmp()
+ *
+ * Test with varied alignment of both strings and position of the first
+ * difference, which may also be the end of one of the strings.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_strcmp(struct unit_test_state *uts)
+{
+	char buf1[BUFLEN], buf2[BUFLEN];
+	int offset1, offset2, pos, i;
+	const int len = BUFLEN - SWEEP - 1;
+
+	for (offset1 = 0; offset1 <= SWEEP; ++offset1) {
+		for (offset2 = 0; offset2 <= SWEEP; ++offset2) {
+			char *s1 = buf1 + offset1, *s2 = buf2 + offset2;
+
+			init_buffer((u8 *)buf1, 0x80);
+			init_buffer((u8 *)buf2, 0x80);
+			for (i = 0; i < len; ++i)
+				s1[i] = s2[i] = i ^ 0x80;
+			s1[len] = '\0';
+			s2[len] = '\0';
+			ut_asserteq(0, strcmp(s1, s2));
+			ut_asserteq(0, strncmp(s1, s2, SIZE_MAX));
+
+			for (pos = 0; pos < len; ++pos) {
+				/* bytes above 0x7f must compare as unsigned */
+				s2[pos] ^= 0x7f;
+				ut_asserteq(cmp_sign((u8)s1[pos] - (u8)s2[pos]),
+					    cmp_sign(strcmp(s1, s2)));
+				ut_asserteq(0, strncmp(s1, s2, pos));
+				ut_assert(strncmp(s1, s2, pos + 1) != 0);
+				s2[pos] ^= 0x7f;
+
+				/* s2 ends first */
+				s2[pos] = '\0';
+				ut_assert(strcmp(s1, s2) > 0);
+				ut_assert(strncmp(s2, s1, len) < 0);
+				s2[pos] = s1[pos];
+			}
+		}
+	}
+	return 0;
+}
+LIB_TEST(lib_strcmp, 0);
+
+/**
+ * lib_memchr() - unit test for memchr()
+ *
+ * Test with varied alignment and length of the buffer and position of the
+ * character searched for.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_memchr(struct unit_test_state *uts)
+{
+	u8 buf[BUFLEN];
+	int offset, len, pos;
+
+	for (offset = 0; offset <= SWEEP; ++offset) {
+		for (len = 0; len < BUFLEN - SWEEP; ++len) {
+			init_buffer(buf, 0);
+			ut_assertnull(memchr(buf + offset, 0xff, len));
+			for (pos = 0; pos < len; ++pos) {
+				buf[offset + pos] = 0xff;
+				ut_asserteq_ptr(buf + offset + pos,
+						memchr(buf + offset, 0xff,
+						       len));
+				/* only the low byte of the character counts */
+				ut_asserteq_ptr(buf + offset + pos,
+						memchr(buf + offset, 0x1ff,
+						       len));
+				ut_assertnull(memchr(buf + offset, 0xff, pos));
+				buf[offset + pos] = offset + pos;
+			}
+		}
+	}
+	return 0;
+}
+LIB_TEST(lib_memchr, 0);
+
+/**
+ * lib_memcmp() - unit test for memcmp()
+ *
+ * Test with varied alignment of both buffers and position of the first
+ * difference.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_memcmp(struct unit_test_state *uts)
+{
+	u8 buf1[BUFLEN], buf2[BUFLEN];
+	int offset1, offset2, pos;
+	const int len = BUFLEN - SWEEP;
+
+	for (offset1 = 0; offset1 <= SWEEP; ++offset1) {
+		for (offset2 = 0; offset2 <= SWEEP; ++offset2) {
+			u8 *p1 = buf1 + offset1, *p2 = buf2 + offset2;
+
+			init_buffer(buf1, 0);
+			memcpy(p2, p1, len);
+			ut_asserteq(0, memcmp(p1, p2, len));
+
+			for (pos = 0; pos < len; ++pos) {
+				p2[pos] = p1[pos] ^ 0x80;
+				ut_asserteq(cmp_sign(p1[pos] - p2[pos]),
+					    cmp_sign(memcmp(p1, p2, len)));
+				ut_asserteq(0, memcmp(p1, p2, pos));
+				p2[pos] = p1[pos];
+			}
+		}
+	}
+	return 0;
+}
+LIB_TEST(lib_memcmp, 0);
+
+/**
+ * lib_string_speed() - report the speed of the string routines
+ *
+ * This measures strlen(), strcmp() and memcmp() on a 4 KiB buffer. It fails
+ * only if the results are wrong, the times are for comparison between builds.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_string_speed(struct unit_test_state *uts)
+{
+	const int size = 4096, loops = 100;
+	ulong start, len_us, cmp_us, mem_us;
+	char *buf1, *buf2;
+	int i;
+
+	buf1 = malloc(size);
+	buf2 = malloc(size);
+	ut_assertnonnull(buf1);
+	ut_assertnonnull(buf2);
+	memset(buf1, 'a', size - 1);
+	buf1[size - 1] = '\0';
+	memcpy(buf2, buf1, size);
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		ut_asserteq(size - 1, strlen(buf1));
+	len_us = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		ut_asserteq(0, strcmp(buf1, buf2));
+	cmp_us = timer_get_us() - start;
+
+	start = timer_get_us();
+	for (i = 0; i < loops; i++)
+		ut_asserteq(0, memcmp(buf1, buf2, size));
+	mem_us = timer_get_us() - start;
+
+	printf("4 KiB x %d: strlen %lu us, strcmp %lu us, memcmp %lu us\n",
+	       loops, len_us, cmp_us, mem_us);
+	free(buf2);
+	free(buf1);
+
+	return 0;
+}
+LIB_TEST(lib_string_speed, 0);
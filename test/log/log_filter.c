@@ -102,3 +102,46 @@ static int log_test_filter(struct unit_test_state *uts)
 	return 0;
 }
 LOG_TEST_FLAGS(log_test_filter, UTF_CONSOLE);
+
+/* Test the summary of the filters used to drop records early */
+static int log_test_filter_summary(struct unit_test_state *uts)
+{
+	enum log_category_t cat_list[] = {
+		log_uc_cat(UCLASS_MMC), LOGC_END
+	};
+	int mmc = log_uc_cat(UCLASS_MMC), spi = log_uc_cat(UCLASS_SPI);
+	int filt1, filt2;
+
+#define cat_allowed(cat) \
+	!!(gd->log_filter_cats[BIT_WORD(cat)] & BIT_MASK(cat))
+
+	filt1 = log_add_filter("console", cat_list, LOGL_INFO, NULL);
+	ut_assert(filt1 >= 0);
+	ut_asserteq(LOGL_INFO, gd->log_filter_level);
+	ut_asserteq(true, cat_allowed(mmc));
+	ut_asserteq(false, cat_allowed(spi));
+
+	/* deny filters do not let anything more through */
+	filt2 = log_add_filter_flags("console", NULL, LOGL_MAX, NULL, NULL,
+				     LOGFF_DENY);
+	ut_assert(filt2 >= 0);
+	ut_asserteq(LOGL_INFO, gd->log_filter_level);
+	ut_asserteq(false, cat_allowed(spi));
+	ut_assertok(log_remove_filter("console", filt2));
+
+	/* a minimum level allows everything above it */
+	filt2 = log_add_filter_flags("console", NULL, LOGL_WARNING, NULL, NULL,
+				     LOGFF_LEVEL_MIN);
+	ut_assert(filt2 >= 0);
+	ut_asserteq(LOGL_MAX, gd->log_filter_level);
+	ut_asserteq(true, cat_allowed(spi));
+
+	ut_assertok(log_remove_filter("console", filt2));
+	ut_asserteq(LOGL_INFO, gd->log_filter_level);
+	ut_asserteq(false, cat_allowed(spi));
+	ut_assertok(log_remove_filter("console", filt1));
+	ut_asserteq(false, cat_allowed(mmc));
+
+	return 0;
+}
+LOG_TEST(log_test_filter_summary);
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Test of the log ring-buffer driver
+ */
+
+#include <command.h>
+#include <console.h>
+#include <log.h>
+#include <vsprintf.h>
+#include <asm/global_data.h>
+#include <test/log.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Check that the next console line contains the given text */
+static int check_dump_line(struct unit_test_state *uts, const char *expect)
+{
+	ut_assert(console_record_readline(uts->actual_str,
+					  sizeof(uts->actual_str)) >= 0);
+	ut_asserteq('[', uts->actual_str[0]);
+	ut_assertnonnull(strstr(uts->actual_str, expect));
+
+	return 0;
+}
+
+/* Test that messages are recorded silently and shown by 'log dump' */
+static int log_test_ringbuf(struct unit_test_state *uts)
+{
+	int log_level = gd->default_log_level;
+
+	ut_assertok(log_ringbuf_dump(true));
+	console_record_reset_enable();
+
+	/* with the console driver off, nothing should be printed */
+	ut_assertok(log_device_set_enable(LOG_GET_DRIVER(console), false));
+	gd->default_log_level = LOGL_INFO;
+	log(LOGC_ARCH, LOGL_ERR, "ring%d\n", 1);
+	log(LOGC_EFI, LOGL_INFO, "ring%d ", 2);
+	log(LOGC_CONT, LOGL_CONT, "cont\n");
+	log(LOGC_EFI, LOGL_DEBUG, "not recorded\n");
+	gd->default_log_level = log_level;
+	ut_assertok(log_device_set_enable(LOG_GET_DRIVER(console), true));
+	ut_assert_console_end();
+
+	ut_assertok(run_command("log dump -c", 0));
+	ut_assertok(check_dump_line(uts, "ERR.arch: ring1"));
+	ut_assertok(check_dump_line(uts, "INFO.efi: ring2 cont"));
+	ut_assert_console_end();
+
+	/* the buffer was cleared */
+	ut_assertok(run_command("log dump", 0));
+	ut_assert_console_end();
+
+	return 0;
+}
+LOG_TEST(log_test_ringbuf);
+
+/* Test that the oldest messages are dropped when the buffer fills */
+static int log_test_ringbuf_wrap(struct unit_test_state *uts)
+{
+	int log_level = gd->default_log_level;
+	int i, count, first = -1, last = -1;
+	char pad[300], *p;
+
+	/* use long messages so the dump fits in the console-record buffer */
+	memset(pad, 'x', sizeof(pad) - 1);
+	pad[sizeof(pad) - 1] = '\0';
+	ut_assertok(log_ringbuf_dump(true));
+	ut_assertok(log_device_set_enable(LOG_GET_DRIVER(console), false));
+	gd->default_log_level = LOGL_INFO;
+	for (i = 0; i < CONFIG_LOG_RINGBUF_SIZE / 128; i++)
+		log(LOGC_ARCH, LOGL_INFO, "wrap %d %s\n", i, pad);
+	gd->default_log_level = log_level;
+	ut_assertok(log_device_set_enable(LOG_GET_DRIVER(console), true));
+	console_record_reset_enable();
+
+	/* the oldest messages must be gone and the rest kept in order */
+	ut_assertok(log_ringbuf_dump(true));
+	for (count = 0; console_record_readline(uts->actual_str,
+						sizeof(uts->actual_str)) >= 0;
+	     count++) {
+		p = strstr(uts->actual_str, "INFO.arch: wrap ");
+		ut_assertnonnull(p);
+		last = dectoul(p + 16, NULL);
+		if (first == -1)
+			first = last;
+		ut_asserteq(first + count, last);
+	}
+	ut_assert(first > 0);
+	ut_asserteq(i - 1, last);
+
+	return 0;
+}
+LOG_TEST(log_test_ringbuf_wrap);
@@ -385,6 +385,10 @@ def generate_ut_subtest(metafunc, fixture_name, sym_path):
         if name.endswith('_norun'):
             continue
 
+        # Benchmarks are run together by test_bench.py, which sets them up
+        if suite == 'bench':
+            continue
+
         vals.append(f'{suite} {name}')
 
     ids = ['ut_' + s.replace(' ', '_') for s in vals]
@@ -0,0 +1,133 @@
+# SPDX-License-Identifier: GPL-2.0+
+"""
+Benchmark runner
+
+Sets up the files used by the 'ut bench' suite on sandbox, runs it and
+writes the results to bench.json in the result directory, so that CI can
+track them from one build to the next.
+"""
+
+import gzip
+import json
+import lzma
+import os
+import re
+import shutil
+
+import pytest
+
+import u_boot_utils
+# pylint: disable=E0611
+from tests import fs_helper
+
+# Matches the lines printed by bench_report()
+RE_BENCH = re.compile(
+    r'^bench: name=(\S+) (\S+)=(\d+) us=(\d+) rate=(\d+)', re.MULTILINE)
+
+BENCH_SIZE = 4 << 20
+
+BENCH_ITS = '''
+/dts-v1/;
+
+/ {
+    description = "Benchmark FIT";
+    #address-cells = <1>;
+
+    images {
+        kernel {
+            data = /incbin/("%s");
+            type = "kernel";
+            arch = "sandbox";
+            os = "linux";
+            compression = "none";
+            hash-1 {
+                algo = "sha256";
+            };
+        };
+    };
+    configurations {
+        default = "conf-1";
+        conf-1 {
+            kernel = "kernel";
+        };
+    };
+};
+'''
+
+def make_bench_data():
+    """Create some data which compresses about as well as a kernel does
+
+    Returns:
+        bytes: Data to use
+    """
+    lines = []
+    size = 0
+    i = 0
+    while size < BENCH_SIZE:
+        line = f'{i:08x} {(i * 2654435761) & 0xffffffff:08x} bench data\n'
+        lines.append(line)
+        size += len(line)
+        i += 1
+    return ''.join(lines).encode('utf-8')[:BENCH_SIZE]
+
+def setup_bench_files(cons):
+    """Set up the files used by the benchmarks, in the persistent-data dir
+
+    Args:
+        cons (ConsoleBase): Console to use
+    """
+    pdir = cons.config.persistent_data_dir
+    src = os.path.join(pdir, 'bench')
+    os.makedirs(src, exist_ok=True)
+    data = make_bench_data()
+    fname = os.path.join(pdir, 'bench.bin')
+    with open(fname, 'wb') as outf:
+        outf.write(data)
+    shutil.copy(fname, os.path.join(src, 'bench.bin'))
+
+    with open(fname + '.gz', 'wb') as outf:
+        outf.write(gzip.compress(data))
+    with open(fname + '.lzma', 'wb') as outf:
+        outf.write(lzma.compress(data, format=lzma.FORMAT_ALONE))
+    if shutil.which('lz4'):
+        u_boot_utils.run_and_log(cons, f'lz4 -f -q {fname} {fname}.lz4')
+    if shutil.which('zstd'):
+        u_boot_utils.run_and_log(cons, f'zstd -f -q {fname} -o {fname}.zst')
+
+    its = os.path.join(pdir, 'bench.its')
+    with open(its, 'w', encoding='utf-8') as outf:
+        outf.write(BENCH_ITS % fname)
+    mkimage = cons.config.build_dir + '/tools/mkimage'
+    u_boot_utils.run_and_log(
+        cons, f'{mkimage} -f {its} {os.path.join(pdir, "bench.itb")}')
+
+    size = 2 * BENCH_SIZE
+    fs_helper.mk_fs(cons.config, 'fat32', size, 'bench', src)
+    fs_helper.mk_fs(cons.config, 'ext4', size, 'bench', src)
+    if shutil.which('mksquashfs'):
+        img = os.path.join(pdir, 'bench.squashfs.img')
+        u_boot_utils.run_and_log(
+            cons, f'mksquashfs {src} {img} -noappend -quiet')
+
+@pytest.mark.buildconfigspec('ut_bench')
+def test_bench(u_boot_console):
+    """Run the benchmarks and record the results"""
+    cons = u_boot_console
+    if cons.config.board_type.startswith('sandbox'):
+        setup_bench_files(cons)
+
+    with cons.temporary_timeout(120 * 1000):
+        output = cons.run_command('ut bench')
+    assert output.endswith('failures: 0')
+
+    results = {}
+    for name, unit, count, usecs, rate in RE_BENCH.findall(output):
+        results[name] = {
+            'unit': unit,
+            'count': int(count),
+            'us': int(usecs),
+            'rate': int(rate),
+        }
+    fname = os.path.join(cons.config.result_dir, 'bench.json')
+    with open(fname, 'w', encoding='utf-8') as outf:
+        json.dump(results, outf, indent=2, sort_keys=True)
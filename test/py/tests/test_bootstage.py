@@ -30,6 +30,13 @@ def test_bootstage_report(u_boot_console):
     assert 'Accumulated time:' in output
     assert 'dm_r' in output
 
+@pytest.mark.buildconfigspec('bootstage_spans')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+def test_bootstage_spans(u_boot_console):
+    output = u_boot_console.run_command('bootstage report')
+    assert 'Spans:' in output
+    assert 'root_driver' in output
+
 @pytest.mark.buildconfigspec('bootstage')
 @pytest.mark.buildconfigspec('cmd_bootstage')
 @pytest.mark.buildconfigspec('bootstage_stash')
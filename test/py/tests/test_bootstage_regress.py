@@ -0,0 +1,259 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Boot-time regression checks
+
+Reads the bootstage report from a board over the console and compares the
+time taken by each phase of the boot with a stored baseline for that board.
+A phase which has become slower by more than the tolerance fails the test,
+as does storage which has become slower to read from.
+
+The report only covers this boot from reset, so the test should run on a
+freshly started board. For the SPL phases to be included, SPL must stash its
+records (CONFIG_SPL_BOOTSTAGE and CONFIG_BOOTSTAGE_STASH) so that U-Boot
+proper can pick them up.
+
+Note: This test relies on boardenv_* containing the configuration below.
+Without it, the test is skipped. All keys are optional; the example shows
+the defaults, except for the commands.
+
+env__bootstage_regress = {
+    # Baseline to compare against. If it does not exist, the results are
+    # written to it and the test is skipped, so the first run records it.
+    # Set 'update' to True to record a new baseline after a deliberate
+    # change.
+    'baseline': '<persistent_data_dir>/bootstage-<board_type>-<identity>.json',
+    'update': False,
+
+    # A phase fails if it takes this many percent longer than the baseline,
+    # and at least 'min_delta_us' longer, so that short phases do not fail
+    # on jitter. Storage fails if it reads this many percent slower.
+    'tolerance': 10,
+    'min_delta_us': 5000,
+
+    # Accumulated bootstage records which count as DRAM init, by prefix
+    'dram_records': ['dram'],
+
+    # Commands to time storage with. Each must print the usual
+    # 'N bytes read in M ms' line, as load, fatload and ext4load do.
+    'load_cmds': ['load mmc 0:1 ${kernel_addr_r} Image'],
+
+    # Command to start the kernel without jumping to it, which gives the
+    # time from bootm_start to start_kernel
+    'boot_cmd': 'bootm start ${kernel_addr_r} - ${fdt_addr_r}; '
+                'bootm loados; bootm prep; bootm fake',
+}
+
+The results are also written to bootstage-regress.json in the result
+directory, so that CI can track them. Besides the phases above, they
+include the total time of each bootstage span (CONFIG_BOOTSTAGE_SPANS), which
+helps to find which part of a slower phase has regressed.
+"""
+
+import json
+import os
+import re
+
+import pytest
+
+# Matches a line of the bootstage report with one or two numbers
+RE_RECORD = re.compile(r'^\s*([\d,]+)(?:\s+([\d,]+))?\s\s(\S.*?)\s*$')
+
+# Matches a line of the span table
+RE_SPAN = re.compile(r'^\s*(\d+)\s+([\d,]+)\s+([\d,]+)\s+([\d,]+)\s\s(\S.*?)\s*$')
+
+# Matches the line printed by 'load' and its filesystem-specific variants
+RE_LOAD = re.compile(r'(\d+) bytes read in (\d+) ms')
+
+def to_int(text):
+    """Convert a number as printed by bootstage, with commas, to an int"""
+    return int(text.replace(',', ''))
+
+def parse_report(output):
+    """Parse the output of 'bootstage report'
+
+    Args:
+        output (str): Output of the command
+
+    Returns:
+        tuple:
+            list of (str, int): Name and time of each mark, in order
+            dict: Accumulated time in microseconds, keyed by name
+            dict: Total span time in microseconds, keyed by name
+    """
+    marks = []
+    accum = {}
+    spans = {}
+    section = None
+    for line in output.splitlines():
+        if line.startswith('Timer summary'):
+            section = 'marks'
+        elif line.startswith('Accumulated time'):
+            section = 'accum'
+        elif line.startswith('Spans'):
+            section = 'spans'
+        elif section == 'spans':
+            match = RE_SPAN.match(line)
+            if match:
+                spans[match.group(5)] = to_int(match.group(2))
+        elif section:
+            match = RE_RECORD.match(line)
+            if not match:
+                continue
+            if section == 'marks' and match.group(2):
+                marks.append((match.group(3), to_int(match.group(1))))
+            elif section == 'accum' and not match.group(2):
+                accum[match.group(3)] = to_int(match.group(1))
+    return marks, accum, spans
+
+def mark_after(marks, name, start=None):
+    """Find the time of a mark, optionally the first one after another
+
+    Args:
+        marks (list of (str, int)): Marks as returned by parse_report()
+        name (str): Name of the mark to find
+        start (str): Only look after the first mark with this name, or None
+
+    Returns:
+        int: Time of the mark in microseconds, or None if not found
+    """
+    names = [mark[0] for mark in marks]
+    pos = 0
+    if start:
+        if start not in names:
+            return None
+        pos = names.index(start) + 1
+    for mname, usecs in marks[pos:]:
+        if mname == name:
+            return usecs
+    return None
+
+def collect_boot(cons, cfg):
+    """Collect the metrics for the boot up to the prompt
+
+    Returns:
+        dict: Metrics, keyed by name
+    """
+    output = cons.run_command('bootstage report')
+    assert 'Timer summary in microseconds' in output
+    marks, accum, _ = parse_report(output)
+
+    metrics = {}
+    for phase in ['TPL', 'VPL', 'SPL']:
+        start = mark_after(marks, phase)
+        end = mark_after(marks, 'end phase', phase)
+        if start is not None and end is not None:
+            metrics[f'{phase.lower()}_us'] = end - start
+
+    prefixes = tuple(cfg.get('dram_records', ['dram']))
+    dram = [usecs for name, usecs in accum.items() if name.startswith(prefixes)]
+    if dram:
+        metrics['dram_us'] = sum(dram)
+
+    prompt = mark_after(marks, 'main_loop')
+    if prompt is not None:
+        metrics['prompt_us'] = prompt
+    return metrics
+
+def collect_load(cons, cfg, metrics):
+    """Run the load commands, adding their throughput to the metrics
+
+    Returns:
+        int: Total time taken by the load commands, in microseconds
+    """
+    total_us = 0
+    for seq, cmd in enumerate(cfg.get('load_cmds', [])):
+        with cons.temporary_timeout(60 * 1000):
+            output = cons.run_command(cmd)
+        match = RE_LOAD.search(output)
+        assert match, f"No read time from '{cmd}': {output}"
+        size, msecs = int(match.group(1)), int(match.group(2))
+        # KiB/s, with a floor of 1 ms so that tiny files do not divide by 0
+        metrics[f'load{seq}_kbps'] = size * 1000 // 1024 // max(msecs, 1)
+        total_us += msecs * 1000
+    return total_us
+
+def collect_kernel(cons, cfg, metrics, load_us):
+    """Run the boot command and add the time to the kernel to the metrics
+
+    The host takes time to type each command, so time-to-kernel is made up
+    from the parts measured on the board: the time to the prompt, the load
+    commands and the time from bootm_start to start_kernel.
+    """
+    cmd = cfg.get('boot_cmd')
+    if not cmd:
+        return
+    with cons.temporary_timeout(60 * 1000):
+        cons.run_command(cmd)
+    marks, _, _ = parse_report(cons.run_command('bootstage report'))
+    start = mark_after(marks, 'bootm_start')
+    end = mark_after(marks, 'start_kernel', 'bootm_start')
+    assert start is not None and end is not None, \
+        f"No bootm_start/start_kernel records after '{cmd}'"
+    metrics['handoff_us'] = end - start
+    if 'prompt_us' in metrics:
+        metrics['kernel_us'] = metrics['prompt_us'] + load_us + end - start
+
+def collect_spans(cons, metrics):
+    """Add the total time of each span to the metrics
+
+    This is done last, so that the spans include the work done by the load
+    and boot commands, e.g. fs_read.
+    """
+    _, _, spans = parse_report(cons.run_command('bootstage report'))
+    for name, usecs in spans.items():
+        key = re.sub(r'\W', '_', name)
+        metrics[f'span_{key}_us'] = usecs
+
+def check_regressions(metrics, baseline, cfg):
+    """Compare the metrics with the baseline
+
+    Returns:
+        list of str: Description of each regression
+    """
+    tolerance = cfg.get('tolerance', 10)
+    min_delta = cfg.get('min_delta_us', 5000)
+    problems = []
+    for name, base in sorted(baseline.items()):
+        if name not in metrics:
+            problems.append(f'{name}: missing (baseline {base})')
+            continue
+        value = metrics[name]
+        if name.endswith('_kbps'):
+            if value * 100 < base * (100 - tolerance):
+                problems.append(f'{name}: {value} KiB/s, baseline {base}')
+        elif (value * 100 > base * (100 + tolerance) and
+              value - base >= min_delta):
+            problems.append(f'{name}: {value} us, baseline {base}')
+    return problems
+
+@pytest.mark.buildconfigspec('bootstage')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+def test_bootstage_regress(u_boot_console):
+    """Check boot times against the baseline for this board"""
+    cons = u_boot_console
+    cfg = cons.config.env.get('env__bootstage_regress', None)
+    if cfg is None:
+        pytest.skip('No bootstage regression config is defined')
+
+    metrics = collect_boot(cons, cfg)
+    load_us = collect_load(cons, cfg, metrics)
+    collect_kernel(cons, cfg, metrics, load_us)
+    collect_spans(cons, metrics)
+
+    fname = os.path.join(cons.config.result_dir, 'bootstage-regress.json')
+    with open(fname, 'w', encoding='utf-8') as outf:
+        json.dump(metrics, outf, indent=2, sort_keys=True)
+
+    baseline_fname = cfg.get('baseline', os.path.join(
+        cons.config.persistent_data_dir,
+        f'bootstage-{cons.config.board_type}-{cons.config.board_identity}.json'))
+    if cfg.get('update') or not os.path.exists(baseline_fname):
+        with open(baseline_fname, 'w', encoding='utf-8') as outf:
+            json.dump(metrics, outf, indent=2, sort_keys=True)
+        pytest.skip(f'Recorded baseline {baseline_fname}')
+
+    with open(baseline_fname, encoding='utf-8') as inf:
+        baseline = json.load(inf)
+    problems = check_regressions(metrics, baseline, cfg)
+    assert not problems, 'Boot-time regressions:\n' + '\n'.join(problems)
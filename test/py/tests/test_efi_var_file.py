@@ -0,0 +1,84 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Test that changes to UEFI variables survive a reload of ubootefi.var
+"""
+
+import os
+import pytest
+import subprocess
+
+VAR_IMAGE_NAME = 'efi_var_file.img'
+ESP_GUID = 'C12A7328-F81F-11D2-BA4B-00A0C93EC93B'
+ESP_START = 2048
+ESP_SECTORS = 32768
+
+def make_esp_image(build_dir):
+    """
+    Makes a disk image with an empty EFI system partition.
+
+    Returns:
+        The path to the image
+    """
+    image_path = os.path.join(build_dir, VAR_IMAGE_NAME)
+    fat_path = image_path + '.fat'
+    subprocess.run(['dd if=/dev/zero of={} bs=1M count=20'.format(image_path)],
+                   shell=True, check=True, stderr=subprocess.DEVNULL)
+    subprocess.run(['sgdisk', '-n', '1:{}:+{}'.format(ESP_START,
+                                                      ESP_SECTORS - 1),
+                    '-t', '1:' + ESP_GUID, image_path],
+                   check=True, capture_output=True)
+    subprocess.run(['mkfs.vfat', '-C', fat_path, str(ESP_SECTORS // 2)],
+                   check=True, capture_output=True)
+    subprocess.run(['dd if={} of={} bs=512 seek={} conv=notrunc'
+                    .format(fat_path, image_path, ESP_START)],
+                   shell=True, check=True, stderr=subprocess.DEVNULL)
+    os.remove(fat_path)
+
+    return image_path
+
+def get_var(u_boot_console, image_path, name):
+    """
+    Restarts U-Boot, so that the variables are read from the file again,
+    and prints a variable.
+    """
+    u_boot_console.restart_uboot()
+    u_boot_console.run_command('host bind 0 {}'.format(image_path))
+
+    return u_boot_console.run_command('printenv -e {}'.format(name))
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('efi_variable_file_journal')
+@pytest.mark.buildconfigspec('cmd_nvedit_efi')
+@pytest.mark.requiredtool('sgdisk')
+@pytest.mark.requiredtool('mkfs.vfat')
+def test_efi_var_file_delete(u_boot_console):
+    """
+    Sets and deletes variables, which appends records to the file, then
+    checks the result once the file is read again.
+    """
+    build_dir = u_boot_console.config.build_dir
+    image_path = make_esp_image(build_dir)
+
+    try:
+        u_boot_console.run_command('host bind 0 {}'.format(image_path))
+        # the first change writes the file, the others are appended
+        u_boot_console.run_command_list([
+            'setenv -e -nv -bs -rt JournalKeep =0x1234',
+            'setenv -e -nv -bs -rt JournalDel =0x5678',
+            'setenv -e -nv -bs -rt JournalKeep =0x4321'])
+
+        out = get_var(u_boot_console, image_path, 'JournalDel')
+        assert '78 56' in out
+        out = u_boot_console.run_command('printenv -e JournalKeep')
+        assert '21 43' in out
+
+        # the deletion must not bring back the value written before it
+        u_boot_console.run_command('setenv -e JournalDel')
+        out = get_var(u_boot_console, image_path, 'JournalDel')
+        assert 'not defined' in out
+        out = u_boot_console.run_command('printenv -e JournalKeep')
+        assert '21 43' in out
+    finally:
+        u_boot_console.restart_uboot()
+        os.remove(image_path)
@@ -0,0 +1,107 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Test looking up names in ext4 directories which have a hash tree
+"""
+
+import os
+import pytest
+import shutil
+import subprocess
+
+HTREE_SRC_DIR = 'ext4_htree_src_dir'
+HTREE_IMAGE_NAME = 'ext4_htree.img'
+HTREE_FILES = 3000
+ADDR = 0x01000000
+
+def file_name(num):
+    """
+    Gets the name of a file in the large directory.
+    """
+    return 'module-with-a-long-name-{}.ko'.format(num)
+
+def make_htree_image(build_dir, hash_alg):
+    """
+    Makes an ext4 image with one large directory, indexed with hash_alg.
+
+    The image is generated at build_dir with the following structure:
+    ext4_htree_src_dir/
+    └── big/
+        ├── module-with-a-long-name-1.ko
+        ├── ...
+        └── module-with-a-long-name-3000.ko
+
+    Each file holds its own name. e2fsck -D builds the hash tree, since
+    mkfs.ext4 -d does not, using the hash set by tune2fs.
+    """
+    root = os.path.join(build_dir, HTREE_SRC_DIR)
+    big = os.path.join(root, 'big')
+    os.makedirs(big)
+    for num in range(1, HTREE_FILES + 1):
+        with open(os.path.join(big, file_name(num)), 'w') as file:
+            file.write(file_name(num))
+
+    image_path = os.path.join(build_dir, HTREE_IMAGE_NAME)
+    subprocess.run(['dd if=/dev/zero of={} bs=1M count=32'.format(image_path)],
+                   shell=True, check=True, stderr=subprocess.DEVNULL)
+    subprocess.run(['mkfs.ext4 -q -b 1024 -d {} {}'.format(root, image_path)],
+                   shell=True, check=True)
+    subprocess.run(['tune2fs -E hash_alg={} {}'.format(hash_alg, image_path)],
+                   shell=True, check=True, stdout=subprocess.DEVNULL)
+    subprocess.run(['e2fsck -fyD {}'.format(image_path)], shell=True,
+                   stdout=subprocess.DEVNULL)
+    out = subprocess.run(['debugfs -R "htree_dump /big" {}'.format(image_path)],
+                         shell=True, check=True, capture_output=True,
+                         text=True)
+    assert 'Root node dump' in out.stdout
+
+def clean_htree_image(build_dir):
+    """
+    Deletes the image and src_dir at build_dir.
+    """
+    shutil.rmtree(os.path.join(build_dir, HTREE_SRC_DIR))
+    os.remove(os.path.join(build_dir, HTREE_IMAGE_NAME))
+
+def htree_load_files(u_boot_console):
+    """
+    Loads files from across the directory and a file which is not there.
+    """
+    for num in (1, 2, 1000, 1999, HTREE_FILES):
+        name = file_name(num)
+        u_boot_console.run_command('mw.b {:x} 0 0x40'.format(ADDR))
+        out = u_boot_console.run_command(
+            'ext4load host 0:0 {:x} /big/{}'.format(ADDR, name))
+        assert '{} bytes read'.format(len(name)) in out
+        out = u_boot_console.run_command(
+            'md5sum {:x} {:x}'.format(ADDR, len(name)))
+        expected = subprocess.run(['printf %s {} | md5sum'.format(name)],
+                                  shell=True, check=True,
+                                  capture_output=True, text=True)
+        assert expected.stdout.split()[0] in out
+
+    name = file_name(HTREE_FILES + 1)
+    out = u_boot_console.run_command(
+        'ext4load host 0:0 {:x} /big/{}'.format(ADDR, name))
+    assert 'Failed to load' in out
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_ext4')
+@pytest.mark.buildconfigspec('ext4_htree')
+@pytest.mark.requiredtool('mkfs.ext4')
+@pytest.mark.requiredtool('tune2fs')
+@pytest.mark.requiredtool('e2fsck')
+@pytest.mark.requiredtool('debugfs')
+@pytest.mark.parametrize('hash_alg', ['legacy', 'half_md4', 'tea'])
+def test_ext4_htree(u_boot_console, hash_alg):
+    """
+    Executes the ext4 hash tree test suite.
+    """
+    build_dir = u_boot_console.config.build_dir
+
+    try:
+        make_htree_image(build_dir, hash_alg)
+        image_path = os.path.join(build_dir, HTREE_IMAGE_NAME)
+        u_boot_console.run_command('host bind 0 {}'.format(image_path))
+        htree_load_files(u_boot_console)
+    finally:
+        clean_htree_image(build_dir)
@@ -0,0 +1,127 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Test writing files to ext4, with extents and in one journal transaction
+"""
+
+import hashlib
+import os
+import pytest
+import shutil
+import subprocess
+
+WRITE_SRC_DIR = 'ext4_write_src_dir'
+WRITE_IMAGE_NAME = 'ext4_write.img'
+FRAG_FILES = 200
+SRC_SIZE = 0x100000
+ADDR = 0x01000000
+
+def make_write_image(build_dir, holes):
+    """
+    Makes an ext4 image whose lowest free blocks are split into holes.
+
+    The image is generated at build_dir with the following structure:
+    ext4_write_src_dir/
+    ├── src.bin
+    └── frag/
+        ├── f000
+        ├── ...
+        └── f199
+
+    The 1 KiB files in frag/ take consecutive blocks. Removing every other
+    one of the first ones leaves single free blocks, which are allocated
+    first. U-Boot cannot write with metadata checksums, so they are off.
+
+    Returns:
+        The contents of src.bin
+    """
+    root = os.path.join(build_dir, WRITE_SRC_DIR)
+    frag = os.path.join(root, 'frag')
+    os.makedirs(frag)
+    for num in range(FRAG_FILES):
+        with open(os.path.join(frag, 'f{:03d}'.format(num)), 'wb') as file:
+            file.write(os.urandom(1024))
+    data = os.urandom(SRC_SIZE)
+    with open(os.path.join(root, 'src.bin'), 'wb') as file:
+        file.write(data)
+
+    image_path = os.path.join(build_dir, WRITE_IMAGE_NAME)
+    subprocess.run(['dd if=/dev/zero of={} bs=1M count=16'.format(image_path)],
+                   shell=True, check=True, stderr=subprocess.DEVNULL)
+    subprocess.run(['mkfs.ext4 -q -b 1024 -O ^metadata_csum -d {} {}'
+                    .format(root, image_path)], shell=True, check=True)
+    cmds = ''.join('rm /frag/f{:03d}\n'.format(num)
+                   for num in range(0, holes * 2, 2))
+    subprocess.run(['debugfs', '-w', '-f', '-', image_path], input=cmds,
+                   check=True, capture_output=True, text=True)
+
+    return data
+
+def clean_write_image(build_dir):
+    """
+    Deletes the image and src_dir at build_dir.
+    """
+    shutil.rmtree(os.path.join(build_dir, WRITE_SRC_DIR))
+    os.remove(os.path.join(build_dir, WRITE_IMAGE_NAME))
+
+def check_file(u_boot_console, fname, data):
+    """
+    Reads a file back and checks that it holds data.
+    """
+    u_boot_console.run_command('mw.b {:x} 0 {:x}'.format(ADDR, len(data)))
+    out = u_boot_console.run_command(
+        'ext4load host 0:0 {:x} {}'.format(ADDR, fname))
+    assert '{} bytes read'.format(len(data)) in out
+    out = u_boot_console.run_command(
+        'md5sum {:x} {:x}'.format(ADDR, len(data)))
+    assert hashlib.md5(data).hexdigest() in out
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_ext4_write')
+@pytest.mark.requiredtool('mkfs.ext4')
+@pytest.mark.requiredtool('debugfs')
+@pytest.mark.requiredtool('fsck.ext4')
+@pytest.mark.parametrize('holes,level', [(2, ' 0/ 0'), (20, ' 1/ 1'),
+                                         (100, None)])
+def test_ext4_write(u_boot_console, holes, level):
+    """
+    Writes a file over the holes, then replaces it with a shorter one.
+
+    With few holes the extents fit in the inode, with more they need a leaf
+    block and with too many the file is mapped block by block.
+    """
+    build_dir = u_boot_console.config.build_dir
+    image_path = os.path.join(build_dir, WRITE_IMAGE_NAME)
+
+    try:
+        data = make_write_image(build_dir, holes)
+        u_boot_console.run_command('host bind 0 {}'.format(image_path))
+        out = u_boot_console.run_command(
+            'ext4load host 0:0 {:x} /src.bin'.format(ADDR))
+        assert '{} bytes read'.format(SRC_SIZE) in out
+
+        out = u_boot_console.run_command(
+            'ext4write host 0:0 {:x} /copy.bin {:x}'.format(ADDR, SRC_SIZE))
+        assert '{} bytes written'.format(SRC_SIZE) in out
+        check_file(u_boot_console, '/copy.bin', data)
+
+        out = subprocess.run(['debugfs', '-R', 'ex /copy.bin', image_path],
+                             check=True, capture_output=True, text=True)
+        if level:
+            assert level in out.stdout
+        else:
+            assert 'does not uses extent block maps' in out.stderr
+
+        # the old blocks are freed and reused in the same transaction
+        half = data[:SRC_SIZE // 2]
+        u_boot_console.run_command(
+            'ext4load host 0:0 {:x} /src.bin'.format(ADDR))
+        out = u_boot_console.run_command(
+            'ext4write host 0:0 {:x} /copy.bin {:x}'.format(ADDR, len(half)))
+        assert '{} bytes written'.format(len(half)) in out
+        check_file(u_boot_console, '/copy.bin', half)
+
+        subprocess.run(['fsck.ext4', '-n', '-f', image_path], check=True)
+    finally:
+        u_boot_console.run_command('host unbind 0')
+        clean_write_image(build_dir)
@@ -0,0 +1,104 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Test decompressing files while they are loaded, with 'load -z'
+"""
+
+import gzip
+import hashlib
+import os
+import pytest
+import shutil
+import subprocess
+
+DECOMP_SRC_DIR = 'load_decomp_src_dir'
+DECOMP_IMAGE_NAME = 'load_decomp.img'
+SRC_SIZE = 0x280000
+ADDR = 0x01000000
+
+def make_decomp_image(build_dir):
+    """
+    Makes an ext4 image holding a file and compressed copies of it.
+
+    The file is larger than CONFIG_FS_LOAD_DECOMP_CHUNK, so it is read in
+    several pieces. The zstd and LZ4 copies are only made if the tools are
+    available.
+
+    Returns:
+        The contents of src.bin and the names of the compressed copies
+    """
+    root = os.path.join(build_dir, DECOMP_SRC_DIR)
+    os.makedirs(root)
+    # half random, half repeated so that the data does compress
+    data = os.urandom(SRC_SIZE // 2) + bytes(range(256)) * (SRC_SIZE // 512)
+    src = os.path.join(root, 'src.bin')
+    with open(src, 'wb') as file:
+        file.write(data)
+    with open(src + '.gz', 'wb') as file:
+        file.write(gzip.compress(data))
+    names = ['/src.bin.gz']
+    if shutil.which('zstd'):
+        subprocess.run(['zstd', '-q', src, '-o', src + '.zst'], check=True)
+        names.append('/src.bin.zst')
+    if shutil.which('lz4'):
+        subprocess.run(['lz4', '-q', src, src + '.lz4'], check=True)
+        names.append('/src.bin.lz4')
+
+    image_path = os.path.join(build_dir, DECOMP_IMAGE_NAME)
+    subprocess.run(['dd if=/dev/zero of={} bs=1M count=16'.format(image_path)],
+                   shell=True, check=True, stderr=subprocess.DEVNULL)
+    subprocess.run(['mkfs.ext4 -q -O ^metadata_csum -d {} {}'
+                    .format(root, image_path)], shell=True, check=True)
+
+    return data, names
+
+def clean_decomp_image(build_dir):
+    """
+    Deletes the image and src_dir at build_dir.
+    """
+    shutil.rmtree(os.path.join(build_dir, DECOMP_SRC_DIR))
+    os.remove(os.path.join(build_dir, DECOMP_IMAGE_NAME))
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('fs_load_decomp')
+@pytest.mark.requiredtool('mkfs.ext4')
+def test_load_decomp(u_boot_console):
+    """
+    Loads each compressed file with -z and checks the result.
+    """
+    build_dir = u_boot_console.config.build_dir
+    image_path = os.path.join(build_dir, DECOMP_IMAGE_NAME)
+    want = '{} bytes read'.format(SRC_SIZE)
+
+    try:
+        data, names = make_decomp_image(build_dir)
+        md5 = hashlib.md5(data).hexdigest()
+        u_boot_console.run_command('host bind 0 {}'.format(image_path))
+
+        # an uncompressed file is loaded as it is
+        for fname in ['/src.bin'] + names:
+            u_boot_console.run_command(
+                'mw.b {:x} 0 {:x}'.format(ADDR, SRC_SIZE))
+            out = u_boot_console.run_command(
+                'load -z host 0:0 {:x} {}'.format(ADDR, fname))
+            assert want in out, fname
+            out = u_boot_console.run_command('printenv filesize')
+            assert 'filesize={:x}'.format(SRC_SIZE) in out
+            out = u_boot_console.run_command(
+                'md5sum {:x} {:x}'.format(ADDR, SRC_SIZE))
+            assert md5 in out, fname
+
+        # the decompressed data must fit in the given size
+        out = u_boot_console.run_command(
+            'load -z host 0:0 {:x} /src.bin.gz {:x}'.format(ADDR,
+                                                            SRC_SIZE // 2))
+        assert 'larger than' in out
+        assert 'Failed to load' in out
+
+        # an offset cannot be given
+        out = u_boot_console.run_command(
+            'load -z host 0:0 {:x} /src.bin.gz 0 10'.format(ADDR))
+        assert 'Usage' in out
+    finally:
+        u_boot_console.run_command('host unbind 0')
+        clean_decomp_image(build_dir)
@@ -116,6 +116,9 @@ controlled by a description in the board device tree.'''
             help='Set argument value arg=value')
     build_parser.add_argument('-b', '--board', type=str,
             help='Board name to build')
+    build_parser.add_argument('--comp-report', action='store_true',
+        default=False,
+        help='Output a report of the load time of compressed entries')
     build_parser.add_argument('-d', '--dt', type=str,
             help='Configuration file (.dtb) to use')
     build_parser.add_argument('--fake-dtb', action='store_true',
@@ -132,6 +135,8 @@ controlled by a description in the board device tree.'''
         default=False, help='Output a map file for each image')
     build_parser.add_argument('-M', '--allow-missing', action='store_true',
         default=False, help='Allow external blobs and bintools to be missing')
+    build_parser.add_argument('--rate', type=str, action='append',
+        help='Set a throughput for the report, e.g. read=20 or lz4=150 (MB/s)')
     build_parser.add_argument('-n', '--no-expanded', action='store_true',
             help="Don't use 'expanded' versions of entries where available; "
                  "normally 'u-boot' becomes 'u-boot-expanded', for example")
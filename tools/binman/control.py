@@ -667,7 +667,7 @@ def CheckForProblems(image):
 
 def ProcessImage(image, update_fdt, write_map, get_contents=True,
                  allow_resize=True, allow_missing=False,
-                 allow_fake_blobs=False):
+                 allow_fake_blobs=False, write_comp_report=False):
     """Perform all steps for this image, including checking and # writing it.
 
     This means that errors found with a later image will be reported after
@@ -684,6 +684,7 @@ def ProcessImage(image, update_fdt, write_map, get_contents=True,
             of the entries), False to raise an exception
         allow_missing: Allow blob_ext objects to be missing
         allow_fake_blobs: Allow blob_ext objects to be faked with dummy files
+        write_comp_report: True to write a report of compressed entries
 
     Returns:
         True if one or more external blobs are missing or faked,
@@ -735,6 +736,8 @@ def ProcessImage(image, update_fdt, write_map, get_contents=True,
     image.BuildImage()
     if write_map:
         image.WriteMap()
+    if write_comp_report:
+        image.WriteCompReport()
 
     has_problems = CheckForProblems(image)
 
@@ -847,6 +850,7 @@ def Binman(args):
             tools.prepare_output_dir(args.outdir, args.preserve)
             state.SetEntryArgs(args.entry_arg)
             state.SetThreads(args.threads)
+            state.SetCompRates(args.rate)
 
             images = PrepareImagesAndDtbs(dtb_fname, args.image,
                                           args.update_fdt, use_expanded, args.indir)
@@ -864,11 +868,13 @@ def Binman(args):
             # may race to create the directory
             if args.fake_ext_blobs:
                 entry.Entry.create_fake_dir()
+            entry.Entry.clear_comp_cache()
 
             for image in images.values():
                 invalid |= ProcessImage(image, args.update_fdt, args.map,
                                        allow_missing=args.allow_missing,
-                                       allow_fake_blobs=args.fake_ext_blobs)
+                                       allow_fake_blobs=args.fake_ext_blobs,
+                                       write_comp_report=args.comp_report)
 
             # Write the updated FDTs to our output files
             for dtb_item in state.GetAllFdts():
@@ -5,10 +5,12 @@
 #
 
 from collections import namedtuple
+import hashlib
 import importlib
 import os
 import pathlib
 import sys
+import threading
 import time
 
 from binman import bintool
@@ -114,6 +116,12 @@ class Entry(object):
     """
     fake_dir = None
 
+    # Compressed data, keyed by (algorithm, SHA256 digest of the input). Sections
+    # are compressed again each time they are built, which happens at least once
+    # for each packing pass, usually with the same contents.
+    comp_cache = {}
+    comp_lock = threading.Lock()
+
     def __init__(self, section, etype, node, name_prefix='',
                  auto_write_symbols=False):
         # Put this here to allow entry-docs and help to work without libfdt
@@ -1219,7 +1227,13 @@ features to produce new behaviours.
         if self.compress != 'none':
             self.uncomp_size = len(indata)
             if self.comp_bintool.is_present():
-                data = self.comp_bintool.compress(indata)
+                key = (self.compress, hashlib.sha256(indata).digest())
+                with self.comp_lock:
+                    data = self.comp_cache.get(key)
+                if data is None:
+                    data = self.comp_bintool.compress(indata)
+                    with self.comp_lock:
+                        self.comp_cache[key] = data
                 uniq = self.GetUniqueName()
                 fname = tools.get_output_filename(f'comp.{uniq}')
                 tools.write_file(fname, data)
@@ -1345,6 +1359,12 @@ features to produce new behaviours.
         tools.write_file(fname, data)
         return data, fname, uniq
 
+    @classmethod
+    def clear_comp_cache(cls):
+        """Drop all compressed data kept by CompressData()"""
+        with cls.comp_lock:
+            cls.comp_cache.clear()
+
     @classmethod
     def create_fake_dir(cls):
         """Create the directory for fake files"""
@@ -306,6 +306,30 @@ class Entry_section(Entry):
 
         return data
 
+    def _CompressSubsections(self, required):
+        """Build and compress the compressed subsections in parallel
+
+        Each compressed subsection is independent of the others, so they can be
+        compressed at the same time. The results are kept by CompressData(), so
+        building the subsections again in BuildSectionData() is quick.
+
+        Args:
+            required: True if the data must be present, False if it is OK to
+                return None
+        """
+        threads = state.GetThreads()
+        todo = [entry for entry in self._entries.values()
+                if isinstance(entry, Entry_section) and
+                entry.compress != 'none']
+        if threads == 0 or len(todo) < 2:
+            return
+        with concurrent.futures.ThreadPoolExecutor(
+                max_workers=threads) as executor:
+            # Check the results in entry order, so errors are reported in order
+            for job in [executor.submit(entry.GetData, required)
+                        for entry in todo]:
+                job.result()
+
     def BuildSectionData(self, required):
         """Build the contents of a section
 
@@ -329,6 +353,7 @@ class Entry_section(Entry):
         """
         section_data = bytearray()
 
+        self._CompressSubsections(required)
         for entry in self._entries.values():
             entry_data = entry.GetData(required)
 
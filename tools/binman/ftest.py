@@ -2169,6 +2169,58 @@ class TestFunctional(unittest.TestCase):
             }
         self.assertEqual(expected, props)
 
+    def testCompReport(self):
+        """Test the report of the load time of compressed entries"""
+        self._CheckLz4()
+        self._DoBinman('build', '-p', '-I', self._indir, '--fake-dtb',
+                       '-d', self.TestFile('083_compress.dts'),
+                       '--comp-report', '--rate', 'read=0.001',
+                       '--rate', 'lz4=0.01')
+        with open(tools.get_output_filename('image.comp')) as fd:
+            lines = fd.read().splitlines()
+        self.assertEqual(3, len(lines))
+
+        entry = control.images['image'].GetEntries()['blob']
+        size = len(COMPRESS_DATA)
+        comp_size = len(entry.data)
+        read = comp_size
+        decomp = size / 10
+        self.assertEqual(
+            '%08x  %08x  lz4     %10.2f  %10.2f  %10.2f  %10.2f  /binman/blob' %
+            (size, comp_size, read, decomp, read + decomp, size), lines[1])
+        self.assertEqual('%-50s  %10.2f  %10.2f' %
+                         ('Total', read + decomp, size), lines[2])
+
+        with self.assertRaises(ValueError) as e:
+            state.SetCompRates(['lz4'])
+        self.assertIn("Invalid rate 'lz4'", str(e.exception))
+
+    def testCompressSections(self):
+        """Test compressing several sections in parallel"""
+        self._CheckLz4()
+        data = self._DoReadFileDtb('346_compress_sections.dts')[0]
+        entries = control.images['image'].GetEntries()
+        section0 = entries['section0']
+        section1 = entries['section1']
+        self.assertEqual(COMPRESS_DATA, self._decompress(section0.data))
+        self.assertEqual(COMPRESS_DATA + U_BOOT_DATA,
+                         self._decompress(section1.data))
+        self.assertEqual(section0.data + section1.data, data)
+
+        # An algorithm without a rate is shown without a time
+        with unittest.mock.patch.dict(state.DEFAULT_COMP_RATES, {'read': 1},
+                                      clear=True):
+            self._DoBinman('-T0', 'build', '-p', '-I', self._indir,
+                           '--fake-dtb', '-d',
+                           self.TestFile('346_compress_sections.dts'),
+                           '--comp-report')
+        with open(tools.get_output_filename('image.comp')) as fd:
+            lines = fd.read().splitlines()
+        self.assertEqual(4, len(lines))
+        self.assertRegex(lines[1],
+                         'lz4 {5} *[0-9.]+ {11}- {11}- +[0-9.]+  /binman/section0$')
+        self.assertEqual('%-50s  %10.2f  %10.2f' % ('Total', 0, 0), lines[3])
+
     def testFiles(self):
         """Test bringing in multiple files"""
         data = self._DoReadFile('084_files.dts')
@@ -13,6 +13,7 @@ import re
 import sys
 
 from binman.entry import Entry
+from binman import state
 from binman.etype import fdtmap
 from binman.etype import image_header
 from binman.etype import section
@@ -220,6 +221,60 @@ class Image(section.Entry_section):
             super().WriteMap(fd, 0)
         return fname
 
+    def WriteCompReport(self):
+        """Write a report of the compressed entries to a .comp file
+
+        This shows the size of each compressed entry with the time it is
+        expected to take to read it from the boot device and decompress it,
+        using the rates from state.GetCompRate(). The time taken to read it
+        without compression is shown for comparison. Since this only depends
+        on the sizes, the report is the same on every build.
+
+        Returns:
+            Filename of report file written
+        """
+        def _AddEntries(entry):
+            for subentry in (entry.GetEntries() or {}).values():
+                if subentry.compress != 'none' and subentry.uncomp_size:
+                    comp_entries.append(subentry)
+                _AddEntries(subentry)
+
+        def _Time(size, rate):
+            return size / (rate * 1000) if rate else None
+
+        def _Str(msecs):
+            return '%10.2f' % msecs if msecs is not None else '%10s' % '-'
+
+        comp_entries = []
+        _AddEntries(self)
+        read_rate = state.GetCompRate('read')
+        filename = '%s.comp' % self.image_name
+        fname = tools.get_output_filename(filename)
+        total = 0
+        total_raw = 0
+        with open(fname, 'w') as fd:
+            print('%8s  %8s  %-6s  %10s  %10s  %10s  %10s  %s' %
+                  ('Size', 'CompSize', 'Algo', 'Read ms', 'Decomp ms',
+                   'Total ms', 'Raw ms', 'Path'), file=fd)
+            for entry in comp_entries:
+                size = len(entry.data)
+                read = _Time(size, read_rate)
+                decomp = _Time(entry.uncomp_size,
+                               state.GetCompRate(entry.compress))
+                raw = _Time(entry.uncomp_size, read_rate)
+                msecs = (read + decomp if read is not None and
+                         decomp is not None else None)
+                print('%s  %s  %-6s  %s  %s  %s  %s  %s' %
+                      (Entry.GetStr(entry.uncomp_size), Entry.GetStr(size),
+                       entry.compress, _Str(read), _Str(decomp), _Str(msecs),
+                       _Str(raw), entry.GetPath()), file=fd)
+                if msecs is not None and raw is not None:
+                    total += msecs
+                    total_raw += raw
+            print('%-50s  %s  %s' % ('Total', _Str(total), _Str(total_raw)),
+                  file=fd)
+        return fname
+
     def BuildEntryList(self):
         """List the files in an image
 
@@ -64,6 +64,24 @@ allow_entry_contraction = False
 # Number of threads to use for binman (None means machine-dependent)
 num_threads = None
 
+# Default throughput in MB/s used to estimate the time taken to load an
+# entry. 'read' is the rate at which the boot device is read and the others are
+# the rates at which each algorithm decompresses, as output bytes. These are
+# rough figures for SPL on a Cortex-A53 at 1GHz, reading from an SD card.
+DEFAULT_COMP_RATES = {
+    'read': 20,
+    'bzip2': 5,
+    'gzip': 40,
+    'lz4': 200,
+    'lzma': 12,
+    'lzo': 120,
+    'xz': 12,
+    'zstd': 80,
+}
+
+# Throughput table used for the compression report, see SetCompRates()
+comp_rates = dict(DEFAULT_COMP_RATES)
+
 
 class Timing:
     """Holds information about an operation that is being timed
@@ -470,6 +488,36 @@ def GetThreads():
     """
     return num_threads
 
+def SetCompRates(rates):
+    """Set the throughput table used for the compression report
+
+    Args:
+        rates (list of str): Rates to change from DEFAULT_COMP_RATES, each in
+            the format "name=MB/s", or None to use the defaults
+
+    Raises:
+        ValueError: a rate is not valid
+    """
+    global comp_rates
+
+    comp_rates = dict(DEFAULT_COMP_RATES)
+    for rate in rates or []:
+        m = re.match('([^=]+)=([0-9.]+)$', rate)
+        if not m or not float(m.group(2)):
+            raise ValueError("Invalid rate '%s'" % rate)
+        comp_rates[m.group(1)] = float(m.group(2))
+
+def GetCompRate(name):
+    """Get a throughput from the table used for the compression report
+
+    Args:
+        name (str): 'read' or the name of a compression algorithm
+
+    Returns:
+        float: Throughput in MB/s, or None if not known
+    """
+    return comp_rates.get(name)
+
 def GetTiming(name):
     """Get the timing info for a particular operation
 
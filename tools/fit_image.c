@@ -80,6 +80,7 @@ static int fit_add_file_data(struct image_tool_params *params, size_t size_inc,
 						params->engine_id,
 						params->cmdname,
 						params->algo_name,
+						params->jobs,
 						&params->summary);
 	}
 
@@ -561,6 +562,16 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 		buf_ptr += ALIGN(len, align_size);
 	}
 
+	/* Let the loader know that it can read whole blocks */
+	if (align_size > 4) {
+		ret = fdt_setprop_u32(fdt, images, FIT_DATA_ALIGN_PROP,
+				      align_size);
+		if (ret) {
+			ret = -EPERM;
+			goto err_munmap;
+		}
+	}
+
 	/* Pack the FDT and place the data after it */
 	fdt_pack(fdt);
 
@@ -591,6 +602,13 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 			ret = -EINVAL;
 			goto err;
 		}
+		if (params->external_offset & (align_size - 1)) {
+			fprintf(stderr,
+				"External offset %x is not aligned to %x\n",
+				params->external_offset, align_size);
+			ret = -EINVAL;
+			goto err;
+		}
 		new_size = params->external_offset;
 	}
 	if (lseek(fd, new_size, SEEK_SET) < 0) {
@@ -13,12 +13,53 @@
 #include <fdt_region.h>
 #include <image.h>
 #include <version.h>
+#include <pthread.h>
 
 #if CONFIG_IS_ENABLED(FIT_SIGNATURE)
 #include <openssl/pem.h>
 #include <openssl/evp.h>
 #endif
 
+/**
+ * struct fit_hash_job - hash to calculate for a hash node of an image
+ *
+ * @data:	Image data
+ * @size:	Size of image data in bytes
+ * @algo:	Hash algorithm, or NULL if the node does not have one
+ * @same:	Earlier job with the same algorithm and data, or NULL if none
+ * @value:	Hash value
+ * @value_len:	Length of @value in bytes
+ * @ret:	0 if @value is valid, else -ve error code
+ *
+ * @data and @algo point into the FIT, so are only valid until it is changed
+ */
+struct fit_hash_job {
+	const void *data;
+	size_t size;
+	const char *algo;
+	struct fit_hash_job *same;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+	int ret;
+};
+
+/**
+ * struct fit_hash_set - hashes of all images, calculated before they are set
+ *
+ * @job:	Jobs, in the same order as the hash nodes in the images/ node
+ * @count:	Number of jobs
+ * @pos:	Next job to be written into the FIT
+ * @next:	Next job to be taken by a thread
+ * @lock:	Protects @next
+ */
+struct fit_hash_set {
+	struct fit_hash_job *job;
+	int count;
+	int pos;
+	int next;
+	pthread_mutex_t lock;
+};
+
 /**
  * fit_set_hash_value - set hash value in requested has node
  * @fit: pointer to the FIT format image header
@@ -60,10 +101,12 @@ static int fit_set_hash_value(void *fit, int noffset, uint8_t *value,
  * @noffset:	subnode offset
  * @data:	data to process
  * @size:	size of data in bytes
+ * @job:	hash already calculated for this node, or NULL if none
  * Return: 0 if ok, -1 on error
  */
 static int fit_image_process_hash(void *fit, const char *image_name,
-		int noffset, const void *data, size_t size)
+		int noffset, const void *data, size_t size,
+		const struct fit_hash_job *job)
 {
 	uint8_t value[FIT_MAX_HASH_LEN];
 	const char *node_name;
@@ -80,7 +123,10 @@ static int fit_image_process_hash(void *fit, const char *image_name,
 		return -ENOENT;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	if (job && !job->ret) {
+		memcpy(value, job->value, job->value_len);
+		value_len = job->value_len;
+	} else if (calculate_hash(data, size, algo, value, &value_len)) {
 		fprintf(stderr,
 			"Unsupported hash algorithm (%s) for '%s' hash node in '%s' image node\n",
 			algo, node_name, image_name);
@@ -641,12 +687,14 @@ int fit_image_cipher_data(const char *keydir, void *keydest,
  * @comment:	Comment to add to signature nodes
  * @require_keys: Mark all keys as 'required'
  * @engine_id:	Engine to use for signing
+ * @hashes:	Hashes already calculated, or NULL if none
  * @return: 0 on success, <0 on failure
  */
 int fit_image_add_verification_data(const char *keydir, const char *keyfile,
 		void *keydest, void *fit, int image_noffset,
 		const char *comment, int require_keys, const char *engine_id,
-		const char *cmdname, const char* algo_name)
+		const char *cmdname, const char* algo_name,
+		struct fit_hash_set *hashes)
 {
 	const char *image_name;
 	const void *data;
@@ -676,8 +724,12 @@ int fit_image_add_verification_data(const char *keydir, const char *keyfile,
 		node_name = fit_get_name(fit, noffset, NULL);
 		if (!strncmp(node_name, FIT_HASH_NODENAME,
 			     strlen(FIT_HASH_NODENAME))) {
+			const struct fit_hash_job *job = NULL;
+
+			if (hashes && hashes->pos < hashes->count)
+				job = &hashes->job[hashes->pos++];
 			ret = fit_image_process_hash(fit, image_name, noffset,
-						data, size);
+						data, size, job);
 		} else if (IMAGE_ENABLE_SIGN && (keydir || keyfile) &&
 			   !strncmp(node_name, FIT_SIG_NODENAME,
 				strlen(FIT_SIG_NODENAME))) {
@@ -1301,12 +1353,159 @@ int fit_cipher_data(const char *keydir, void *keydest, void *fit,
 	return 0;
 }
 
+static int fit_hash_add(struct fit_hash_set *set, const void *data,
+			size_t size, const char *algo)
+{
+	struct fit_hash_job *job;
+	int i;
+
+	job = realloc(set->job, (set->count + 1) * sizeof(*job));
+	if (!job)
+		return -ENOMEM;
+	set->job = job;
+	job = &set->job[set->count];
+	memset(job, '\0', sizeof(*job));
+	job->data = data;
+	job->size = size;
+	job->algo = algo;
+	job->ret = -ENOENT;
+
+	/* the same devicetree is often used by several configurations */
+	for (i = 0; algo && i < set->count; i++) {
+		struct fit_hash_job *other = &set->job[i];
+
+		if (!other->same && other->algo && other->size == size &&
+		    !strcmp(other->algo, algo) &&
+		    (other->data == data || !memcmp(other->data, data, size))) {
+			job->same = other;
+			break;
+		}
+	}
+	set->count++;
+
+	return 0;
+}
+
+/**
+ * fit_hash_prepare() - collect the hashes to calculate for all images
+ *
+ * This must not change the FIT, since the jobs point into it
+ *
+ * @fit:	Pointer to the FIT format image header
+ * @images_noffset: Offset of the images/ node
+ * @set:	Returns the jobs, in the order of the hash nodes
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+static int fit_hash_prepare(const void *fit, int images_noffset,
+			    struct fit_hash_set *set)
+{
+	int image_noffset, noffset;
+	int ret;
+
+	fdt_for_each_subnode(image_noffset, fit, images_noffset) {
+		const void *data;
+		size_t size;
+
+		/* this image is reported when adding its verification data */
+		if (fit_image_get_emb_data(fit, image_noffset, &data, &size))
+			break;
+
+		fdt_for_each_subnode(noffset, fit, image_noffset) {
+			const char *node_name, *algo;
+
+			node_name = fit_get_name(fit, noffset, NULL);
+			if (strncmp(node_name, FIT_HASH_NODENAME,
+				    strlen(FIT_HASH_NODENAME)))
+				continue;
+			if (fit_image_hash_get_algo(fit, noffset, &algo))
+				algo = NULL;
+			ret = fit_hash_add(set, data, size, algo);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+static void fit_hash_job_calc(struct fit_hash_job *job)
+{
+	if (!job->algo || job->same)
+		return;
+	if (calculate_hash(job->data, job->size, job->algo, job->value,
+			   &job->value_len))
+		job->ret = -EPROTONOSUPPORT;
+	else
+		job->ret = 0;
+}
+
+static void *fit_hash_thread(void *arg)
+{
+	struct fit_hash_set *set = arg;
+	struct fit_hash_job *job;
+
+	do {
+		pthread_mutex_lock(&set->lock);
+		job = set->next < set->count ? &set->job[set->next++] : NULL;
+		pthread_mutex_unlock(&set->lock);
+		if (job)
+			fit_hash_job_calc(job);
+	} while (job);
+
+	return NULL;
+}
+
+/**
+ * fit_hash_calc() - calculate the hashes collected by fit_hash_prepare()
+ *
+ * Only the first job for each data blob is calculated, the others take its
+ * hash.
+ *
+ * @set:	Jobs to calculate
+ * @jobs:	Number of threads to use, 0 or 1 to calculate them in this one
+ */
+static void fit_hash_calc(struct fit_hash_set *set, int jobs)
+{
+	pthread_t *threads = NULL;
+	int i, started = 0;
+
+	pthread_mutex_init(&set->lock, NULL);
+	if (jobs > set->count)
+		jobs = set->count;
+	if (jobs > 1)
+		threads = calloc(jobs, sizeof(*threads));
+	for (i = 0; threads && i < jobs; i++) {
+		if (pthread_create(&threads[i], NULL, fit_hash_thread, set))
+			break;
+		started++;
+	}
+
+	/* do any jobs which are left, e.g. if threads are not available */
+	fit_hash_thread(set);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	free(threads);
+	pthread_mutex_destroy(&set->lock);
+
+	for (i = 0; i < set->count; i++) {
+		struct fit_hash_job *job = &set->job[i];
+
+		if (job->same) {
+			memcpy(job->value, job->same->value,
+			       job->same->value_len);
+			job->value_len = job->same->value_len;
+			job->ret = job->same->ret;
+		}
+	}
+}
+
 int fit_add_verification_data(const char *keydir, const char *keyfile,
 			      void *keydest, void *fit, const char *comment,
 			      int require_keys, const char *engine_id,
 			      const char *cmdname, const char *algo_name,
-			      struct image_summary *summary)
+			      int jobs, struct image_summary *summary)
 {
+	struct fit_hash_set hashes;
 	int images_noffset, confs_noffset;
 	int noffset;
 	int ret;
@@ -1319,6 +1518,17 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 		return images_noffset;
 	}
 
+	/* Calculate all the hashes before any of them are written */
+	memset(&hashes, '\0', sizeof(hashes));
+	ret = fit_hash_prepare(fit, images_noffset, &hashes);
+	if (ret) {
+		fprintf(stderr, "Can't prepare image hashes (%s)\n",
+			strerror(-ret));
+		free(hashes.job);
+		return ret;
+	}
+	fit_hash_calc(&hashes, jobs);
+
 	/* Process its subnodes, print out component images details */
 	for (noffset = fdt_first_subnode(fit, images_noffset);
 	     noffset >= 0;
@@ -1329,14 +1539,16 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 		 */
 		ret = fit_image_add_verification_data(keydir, keyfile, keydest,
 				fit, noffset, comment, require_keys, engine_id,
-				cmdname, algo_name);
+				cmdname, algo_name, &hashes);
 		if (ret) {
 			fprintf(stderr, "Can't add verification data for node '%s' (%s)\n",
 				fdt_get_name(fit, noffset, NULL),
 				strerror(-ret));
+			free(hashes.job);
 			return ret;
 		}
 	}
+	free(hashes.job);
 
 	/* If there are no keys, we can't sign configurations */
 	if (!IMAGE_ENABLE_SIGN || !(keydir || keyfile))
@@ -104,7 +104,7 @@ static void usage(const char *msg)
 		"          -v ==> verbose\n",
 		params.cmdname);
 	fprintf(stderr,
-		"       %s [-D dtc_options] [-f fit-image.its|-f auto|-f auto-conf|-F] [-b <dtb> [-b <dtb>]] [-E] [-B size] [-i <ramdisk.cpio.gz>] fit-image\n"
+		"       %s [-D dtc_options] [-f fit-image.its|-f auto|-f auto-conf|-F] [-b <dtb> [-b <dtb>]] [-E] [-B size] [-i <ramdisk.cpio.gz>] [-j jobs] fit-image\n"
 		"           <dtb> file is used with -f auto, it may occur multiple times.\n",
 		params.cmdname);
 	fprintf(stderr,
@@ -112,9 +112,10 @@ static void usage(const char *msg)
 		"          -f => input filename for FIT source\n"
 		"          -i => input filename for ramdisk file\n"
 		"          -E => place data outside of the FIT structure\n"
-		"          -B => align size in hex for FIT structure and header\n"
+		"          -B => align size in hex for FIT structure, header and external data\n"
 		"          -b => append the device tree binary to the FIT\n"
-		"          -t => update the timestamp in the FIT\n");
+		"          -t => update the timestamp in the FIT\n"
+		"          -j => number of threads to use for hashing images\n");
 #if CONFIG_IS_ENABLED(FIT_SIGNATURE)
 	fprintf(stderr,
 		"Signing / verified boot options: [-k keydir] [-K dtb] [ -c <comment>] [-p addr] [-r] [-N engine]\n"
@@ -160,7 +161,7 @@ static int add_content(int type, const char *fname)
 }
 
 static const char optstring[] =
-	"a:A:b:B:c:C:d:D:e:Ef:Fg:G:i:k:K:ln:N:o:O:p:qrR:stT:vVx";
+	"a:A:b:B:c:C:d:D:e:Ef:Fg:G:i:j:k:K:ln:N:o:O:p:qrR:stT:vVx";
 
 static const struct option longopts[] = {
 	{ "load-address", required_argument, NULL, 'a' },
@@ -179,6 +180,7 @@ static const struct option longopts[] = {
 	{ "key-file", required_argument, NULL, 'G' },
 	{ "help", no_argument, NULL, 'h' },
 	{ "initramfs", required_argument, NULL, 'i' },
+	{ "jobs", required_argument, NULL, 'j' },
 	{ "key-dir", required_argument, NULL, 'k' },
 	{ "key-dest", required_argument, NULL, 'K' },
 	{ "list", no_argument, NULL, 'l' },
@@ -234,7 +236,7 @@ static void process_args(int argc, char **argv)
 			break;
 		case 'B':
 			params.bl_len = strtoull(optarg, &ptr, 16);
-			if (*ptr) {
+			if (*ptr || params.bl_len & (params.bl_len - 1)) {
 				fprintf(stderr, "%s: invalid block length %s\n",
 					params.cmdname, optarg);
 				exit(EXIT_FAILURE);
@@ -294,6 +296,14 @@ static void process_args(int argc, char **argv)
 		case 'i':
 			params.fit_ramdisk = optarg;
 			break;
+		case 'j':
+			params.jobs = strtoul(optarg, &ptr, 10);
+			if (*ptr || params.jobs < 1) {
+				fprintf(stderr, "%s: invalid number of jobs %s\n",
+					params.cmdname, optarg);
+				exit(EXIT_FAILURE);
+			}
+			break;
 		case 'k':
 			params.keydir = optarg;
 			break;
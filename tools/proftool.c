@@ -254,6 +254,8 @@ struct func_info *func_list;
 int func_count;			/* number of functions */
 struct trace_call *call_list;	/* list of all calls in the input trace file */
 int call_count;			/* number of calls */
+struct trace_output_sample *sample_list; /* sampled call stacks, if any */
+int sample_count;		/* number of sample nodes */
 int verbose;	/* Verbosity level 0=none, 1=warn, 2=notice, 3=info, 4=debug */
 ulong text_offset;		/* text address of first function */
 ulong text_base;		/* CONFIG_TEXT_BASE from trace file */
@@ -483,6 +485,29 @@ static int read_calls(FILE *fin, size_t count)
 	return 0;
 }
 
+/**
+ * read_samples() - Read the tree of sampled call stacks from the trace file
+ *
+ * @fin: File to read from
+ * @count: Number of nodes to read
+ * Returns: 0 if OK, -1 on error
+ */
+static int read_samples(FILE *fin, size_t count)
+{
+	notice("sample node count: %zu\n", count);
+	sample_list = calloc(count, sizeof(*sample_list));
+	if (!sample_list) {
+		error("Cannot allocate sample_list\n");
+		return -1;
+	}
+	sample_count = count;
+
+	if (count && read_data(fin, sample_list, count * sizeof(*sample_list)))
+		return -1;
+
+	return 0;
+}
+
 /**
  * read_trace() - Read the U-Boot trace file
  *
@@ -515,6 +540,11 @@ static int read_trace(FILE *fin)
 			if (read_calls(fin, hdr.rec_count))
 				return 1;
 			break;
+
+		case TRACE_CHUNK_SAMPLES:
+			if (read_samples(fin, hdr.rec_count))
+				return 1;
+			break;
 		}
 	}
 	return 0;
@@ -1774,6 +1804,67 @@ static int make_flame_tree(enum out_format_t out_format,
 	return 0;
 }
 
+/**
+ * make_sample_tree() - Create a tree of stack traces from sampled stacks
+ *
+ * This is used when U-Boot was built with CONFIG_TRACE_SAMPLE, so the trace
+ * holds a tree of call stacks rather than a list of calls. The tree is
+ * already in the right shape, so this just resolves the functions. The
+ * count is the number of samples and the duration is the time they stand for
+ *
+ * @treep: Returns the resulting flamegraph tree
+ * Returns: 0 on success, -ve on error
+ */
+static int make_sample_tree(struct flame_node **treep)
+{
+	struct flame_node **nodes;
+	int i, count = 0;
+
+	nodes = calloc(sample_count, sizeof(*nodes));
+	if (!nodes) {
+		error("Cannot allocate sample nodes\n");
+		return -1;
+	}
+	for (i = 0; i < sample_count; i++) {
+		struct trace_output_sample *sample = &sample_list[i];
+		struct flame_node *node, *parent;
+		struct func_info *func = NULL;
+
+		if (i) {
+			/* parents always come before their children */
+			if (sample->parent >= i || !nodes[sample->parent]) {
+				warn("Bad parent %u for sample node %d\n",
+				     sample->parent, i);
+				continue;
+			}
+			func = find_func_by_offset(sample->func);
+			if (!func) {
+				warn("Cannot find function at %lx\n",
+				     text_offset + sample->func);
+				continue;
+			}
+		}
+		node = create_node("sample");
+		if (!node)
+			return -1;
+		node->func = func;
+		node->count = sample->count;
+		node->duration = sample->time_us;
+		if (i) {
+			parent = nodes[sample->parent];
+			node->parent = parent;
+			list_add_tail(&node->sibling_node, &parent->child_head);
+			count++;
+		}
+		nodes[i] = node;
+	}
+	fprintf(stderr, "%d nodes from samples\n", count);
+	*treep = sample_count ? nodes[0] : create_node("tree");
+	free(nodes);
+
+	return *treep ? 0 : -1;
+}
+
 /**
  * output_tree() - Output a flamegraph tree
  *
@@ -1875,8 +1966,12 @@ static int make_flamegraph(FILE *fout, enum out_format_t out_format)
 	char *str;
 	int ret = 0;
 
-	if (make_flame_tree(out_format, &tree))
+	if (sample_list) {
+		if (make_sample_tree(&tree))
+			return -1;
+	} else if (make_flame_tree(out_format, &tree)) {
 		return -1;
+	}
 
 	abuf_init(&str_buf);
 	if (!abuf_realloc(&str_buf, 500))